@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <soc/gm20b/gmmu.h>
+#include "benchmark.h"
+
+/**
+ * @brief Compares translating GPU VA ranges with TranslateRange and ForEachMapping against TranslateRange with the single span of inline capacity it previously had
+ * @note Every layout is a run of adjacent 128 KiB big page mappings which are either backed by contiguous host memory, as is the case for an nvmap handle mapped in one go, or by scattered host memory, as is the case for separately allocated handles
+ */
+namespace skyline::bench {
+    using GMMU = soc::gm20b::GMMU;
+    using PreviousTranslatedAddressRange = boost::container::small_vector<span<u8>, 1>; //!< TranslatedAddressRange prior to it having inline capacity for more than a single span
+
+    constexpr u64 BigPageSize{soc::gm20b::GmmuMinBigPageSize};
+    constexpr u64 BaseVa{0x100000000}; //!< The VA that all layouts are mapped at, this is past the start of the AS in the same way as allocations by nvhost-as-gpu
+
+    struct Layout {
+        std::string_view name;
+        size_t mappingCount; //!< The amount of adjacent mappings that the translated range spans
+        bool contiguousHost; //!< If the mappings are backed by contiguous host memory, in which case they're merged into a single range
+    };
+
+    constexpr std::array<Layout, 6> Layouts{{
+        {"SingleMapping", 1, true},
+        {"Contiguous4", 4, true},
+        {"Scattered2", 2, false},
+        {"Scattered4", 4, false},
+        {"Scattered8", 8, false},
+        {"Scattered32", 32, false},
+    }};
+
+    /**
+     * @brief Translates a range into a TranslatedAddressRange with the previous inline capacity, this yields the same merged ranges as TranslateRange
+     * @note This walks the blocks with ForEachMapping so it doesn't include the std::function that TranslateRangeImpl is called with, only the inline capacity differs from the previous TranslateRange
+     */
+    static PreviousTranslatedAddressRange PreviousTranslateRange(GMMU &gmmu, u64 virt, u64 size) {
+        PreviousTranslatedAddressRange ranges;
+        gmmu.ForEachMapping(virt, size, [&](span<u8> range) {
+            ranges.push_back(range);
+        });
+        return ranges;
+    }
+
+    /**
+     * @return A checksum of the ranges which depends on all of their addresses and sizes, this is what's consumed by every variant
+     */
+    static u64 ChecksumRange(u64 checksum, span<u8> range) {
+        return (checksum * 31) + reinterpret_cast<uintptr_t>(range.data()) + range.size();
+    }
+
+    SKYLINE_BENCHMARK(AddressSpace) {
+        constexpr size_t MaximumMappingCount{32};
+        std::vector<u8> backing(MaximumMappingCount * BigPageSize * 2);
+        auto backingBase{util::AlignUp(backing.data(), BigPageSize)};
+
+        for (const auto &layout : Layouts) {
+            GMMU gmmu;
+            for (size_t index{}; index < layout.mappingCount; index++) {
+                // Scattered mappings are backed by every other big page in reverse order so neighbouring mappings are never contiguous in host memory
+                size_t hostPage{layout.contiguousHost ? index : ((layout.mappingCount - index - 1) * 2)};
+                gmmu.Map(BaseVa + (index * BigPageSize), backingBase + (hostPage * BigPageSize), BigPageSize);
+            }
+
+            // The range starts and ends partway into the first and last mappings, as a buffer or texture rarely lines up with mappings exactly
+            u64 virt{BaseVa + 0x100}, size{(layout.mappingCount * BigPageSize) - 0x200};
+
+            auto ranges{gmmu.TranslateRange(virt, size)};
+            auto previousRanges{PreviousTranslateRange(gmmu, virt, size)};
+            std::vector<span<u8>> mappings;
+            gmmu.ForEachMapping(virt, size, [&](span<u8> range) { mappings.push_back(range); });
+
+            auto sameRanges{[](const auto &a, const auto &b) {
+                return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](span<u8> x, span<u8> y) { return x.data() == y.data() && x.size() == y.size(); });
+            }};
+            context.Check(ranges.size() == (layout.contiguousHost ? 1 : layout.mappingCount), fmt::format("{}: TranslateRange yields the expected amount of ranges", layout.name));
+            context.Check(sameRanges(ranges, previousRanges) && sameRanges(ranges, mappings), fmt::format("{}: all variants yield the same ranges", layout.name));
+            context.Report(fmt::format("{}/Ranges", layout.name), static_cast<double>(ranges.size()), "ranges");
+
+            context.Measure(fmt::format("{}/PreviousTranslateRange", layout.name), [&] {
+                u64 checksum{};
+                for (auto range : PreviousTranslateRange(gmmu, virt, size))
+                    checksum = ChecksumRange(checksum, range);
+                DoNotOptimize(checksum);
+            });
+            context.Measure(fmt::format("{}/TranslateRange", layout.name), [&] {
+                u64 checksum{};
+                for (auto range : gmmu.TranslateRange(virt, size))
+                    checksum = ChecksumRange(checksum, range);
+                DoNotOptimize(checksum);
+            });
+            context.Measure(fmt::format("{}/ForEachMapping", layout.name), [&] {
+                u64 checksum{};
+                gmmu.ForEachMapping(virt, size, [&](span<u8> range) { checksum = ChecksumRange(checksum, range); });
+                DoNotOptimize(checksum);
+            });
+        }
+    }
+}
@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <random>
+#include <common.h>
+#include <crypto/aes_cipher.h>
+#include <crypto/aes_ctr_cipher.h>
+#include <crypto/aes_xts_cipher.h>
+#include <crypto/aes_hardware.h>
+#include "benchmark.h"
+
+/**
+ * @brief Compares the AES-CTR and AES-XTS ciphers that use the ARMv8 AES instructions with the mbedtls cipher contexts that were used for all NCA decryption prior to them
+ * @note The ciphers fall back to mbedtls when the CPU doesn't support the AES instructions, if that's the case then both variants measure mbedtls and this is reported prior to the measurements
+ */
+namespace skyline::bench {
+    constexpr size_t BufferSize{1024 * 1024}; //!< The amount of data decrypted per call, this is the size of a typical sequential read from a RomFS
+    constexpr size_t NcaSectorSize{0x4000}; //!< The sector size of AES-XTS encrypted NCA sections
+    constexpr size_t NcaHeaderSectorSize{0x200}; //!< The sector size of the AES-XTS encrypted NCA header
+
+    SKYLINE_BENCHMARK(Aes) {
+        context.Report("HasHardwareAes", crypto::hardware::HasHardwareAes() ? 1.0 : 0.0, "(1 if the ciphers use the AES instructions)");
+
+        std::mt19937_64 random{0};
+        std::vector<u8> ciphertext(BufferSize), data(BufferSize), reference(BufferSize);
+        for (auto &byte : ciphertext)
+            byte = static_cast<u8>(random());
+
+        crypto::AesCtrCipher::Block ctrKey, ctr{};
+        for (auto &byte : ctrKey)
+            byte = static_cast<u8>(random());
+        for (size_t i{}; i < ctr.size() / 2; i++)
+            ctr[i] = static_cast<u8>(random()); // The lower half of the counter is the block index which starts at zero for the start of a section
+
+        crypto::AesCtrCipher ctrCipher{ctrKey};
+        crypto::AesCipher ctrMbedtls{ctrKey, MBEDTLS_CIPHER_AES_128_CTR};
+
+        // The counter is set prior to every read in the same way as CtrEncryptedBacking, this doesn't matter for the throughput at this size
+        auto ctrMbedtlsDecrypt{[&](span<u8> buffer) {
+            ctrMbedtls.SetIV(ctr);
+            ctrMbedtls.Decrypt(buffer);
+        }};
+
+        std::copy(ciphertext.begin(), ciphertext.end(), data.begin());
+        ctrCipher.Decrypt(data, ctr, 0);
+        std::copy(ciphertext.begin(), ciphertext.end(), reference.begin());
+        ctrMbedtlsDecrypt(reference);
+        context.Check(data == reference, "AES-CTR decryption is identical to mbedtls");
+
+        context.Measure("Ctr/Cipher", [&] { ctrCipher.Decrypt(data, ctr, 0); }, 1, BufferSize);
+        context.Measure("Ctr/Mbedtls", [&] { ctrMbedtlsDecrypt(data); }, 1, BufferSize);
+
+        crypto::AesXtsCipher::Key xtsKey;
+        for (auto &byte : xtsKey)
+            byte = static_cast<u8>(random());
+
+        crypto::AesXtsCipher xtsCipher{xtsKey};
+        crypto::AesCipher xtsMbedtls{xtsKey, MBEDTLS_CIPHER_AES_128_XTS};
+
+        for (auto [sectorSize, name] : {std::pair<size_t, std::string_view>{NcaSectorSize, "Section"}, {NcaHeaderSectorSize, "Header"}}) {
+            constexpr size_t FirstSector{0x10}; //!< An arbitrary starting sector so the tweak isn't zero
+
+            std::copy(ciphertext.begin(), ciphertext.end(), data.begin());
+            xtsCipher.Decrypt(data, FirstSector, sectorSize);
+            std::copy(ciphertext.begin(), ciphertext.end(), reference.begin());
+            xtsMbedtls.XtsDecrypt(reference, FirstSector, sectorSize);
+            context.Check(data == reference, fmt::format("AES-XTS decryption with 0x{:X} byte sectors is identical to mbedtls", sectorSize));
+
+            context.Measure(fmt::format("Xts{}/Cipher", name), [&] { xtsCipher.Decrypt(data, FirstSector, sectorSize); }, 1, BufferSize);
+            context.Measure(fmt::format("Xts{}/Mbedtls", name), [&] { xtsMbedtls.XtsDecrypt(data, FirstSector, sectorSize); }, 1, BufferSize);
+        }
+    }
+}
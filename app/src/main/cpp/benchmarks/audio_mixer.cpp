@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <random>
+#include <audio/mixer.h>
+#include <audio/downmixer.h>
+#include "benchmark.h"
+
+/**
+ * @brief Compares the NEON audio kernels with the per-sample scalar loops that they replaced in the audio output, the renderer's final mix and voice processing
+ * @note The scalar loops are the same expressions as before and are compiled with the same flags, any auto-vectorisation the compiler does for them is part of the baseline
+ */
+namespace skyline::bench {
+    constexpr size_t StereoSampleCount{constant::MixBufferSize * constant::StereoChannelCount}; //!< The amount of samples in a stereo mix buffer, this is the amount that's mixed per renderer update
+    constexpr size_t TailSampleCount{StereoSampleCount + 7}; //!< A sample count that isn't a multiple of the vector size so the scalar tails of the kernels are checked as well
+
+    namespace scalar {
+        [[gnu::noinline]] static void MixSaturate(span<i16> destination, span<const i16> source) {
+            for (size_t i{}; i < source.size(); i++)
+                destination[i] = audio::Saturate<i16, i32>(static_cast<i32>(destination[i]) + static_cast<i32>(source[i]));
+        }
+
+        [[gnu::noinline]] static void MixVolume(span<i16> destination, span<const i16> source, float volume, bool accumulate) {
+            for (size_t i{}; i < source.size(); i++) {
+                if (accumulate)
+                    destination[i] = audio::Saturate<i16, i32>(destination[i] + (source[i] * volume));
+                else
+                    destination[i] = audio::Saturate<i16, i32>(source[i] * volume);
+            }
+        }
+
+        [[gnu::noinline]] static void ExpandMonoToStereo(span<i16> destination, span<const i16> source) {
+            for (size_t i{}; i < source.size(); i++)
+                for (u8 channel{}; channel < constant::StereoChannelCount; channel++)
+                    destination[(i * constant::StereoChannelCount) + channel] = source[i];
+        }
+
+        /**
+         * @brief The downmix with the same Q15 coefficients and rounding as the NEON path, this is the scalar tail of audio::DownMix applied to every sample
+         */
+        [[gnu::noinline]] static std::vector<audio::StereoSample> DownMix(span<audio::Surround51Sample> surroundSamples) {
+            constexpr u8 FixedPointShift{15};
+            constexpr i16 Attenuation3Db{23170};
+            constexpr i16 Attenuation6Db{16423};
+            constexpr i16 Attenuation12Db{8231};
+
+            auto downmixChannel{[](i32 front, i32 centre, i32 lowFrequency, i32 back) {
+                i32 sum{centre * Attenuation3Db + lowFrequency * Attenuation12Db + back * Attenuation6Db};
+                return audio::Saturate<i16, i32>(front + ((sum + (1 << (FixedPointShift - 1))) >> FixedPointShift));
+            }};
+
+            std::vector<audio::StereoSample> stereoSamples(surroundSamples.size());
+            for (size_t i{}; i < surroundSamples.size(); i++) {
+                auto &surroundSample{surroundSamples[i]};
+                stereoSamples[i].left = downmixChannel(surroundSample.frontLeft, surroundSample.centre, surroundSample.lowFrequency, surroundSample.backLeft);
+                stereoSamples[i].right = downmixChannel(surroundSample.frontRight, surroundSample.centre, surroundSample.lowFrequency, surroundSample.backRight);
+            }
+            return stereoSamples;
+        }
+
+        /**
+         * @brief The downmix prior to the NEON path with decimal fixed point coefficients and a division for every channel
+         */
+        [[gnu::noinline]] static std::vector<audio::StereoSample> PreviousDownMix(span<audio::Surround51Sample> surroundSamples) {
+            constexpr i16 FixedPointMultiplier{1000};
+            constexpr i16 Attenuation3Db{707};
+            constexpr i16 Attenuation6Db{501};
+            constexpr i16 Attenuation12Db{251};
+
+            auto downmixChannel{[](i32 front, i32 centre, i32 lowFrequency, i32 back) {
+                return static_cast<i16>(front + (centre * Attenuation3Db + lowFrequency * Attenuation12Db + back * Attenuation6Db) / FixedPointMultiplier);
+            }};
+
+            std::vector<audio::StereoSample> stereoSamples(surroundSamples.size());
+            for (size_t i{}; i < surroundSamples.size(); i++) {
+                auto &surroundSample{surroundSamples[i]};
+                stereoSamples[i].left = downmixChannel(surroundSample.frontLeft, surroundSample.centre, surroundSample.lowFrequency, surroundSample.backLeft);
+                stereoSamples[i].right = downmixChannel(surroundSample.frontRight, surroundSample.centre, surroundSample.lowFrequency, surroundSample.backRight);
+            }
+            return stereoSamples;
+        }
+    }
+
+    /**
+     * @return Random samples across the entire range of a 16-bit sample so saturation is frequently hit
+     */
+    static std::vector<i16> RandomSamples(size_t count, std::mt19937 &random) {
+        std::uniform_int_distribution<i32> distribution{std::numeric_limits<i16>::min(), std::numeric_limits<i16>::max()};
+        std::vector<i16> samples(count);
+        for (auto &sample : samples)
+            sample = static_cast<i16>(distribution(random));
+        return samples;
+    }
+
+    SKYLINE_BENCHMARK(AudioMixer) {
+        std::mt19937 random{0};
+        auto source{RandomSamples(TailSampleCount, random)}, existing{RandomSamples(TailSampleCount, random)};
+        std::vector<i16> destination(TailSampleCount), reference(TailSampleCount);
+        constexpr float Volume{0.7f}; //!< A voice volume below one, volumes above one are also valid but the result is saturated in either case
+
+        destination = existing;
+        reference = existing;
+        audio::MixSaturate(destination, source);
+        scalar::MixSaturate(reference, source);
+        context.Check(destination == reference, "MixSaturate is identical to the scalar loop");
+
+        for (bool accumulate : {false, true}) {
+            destination = existing;
+            reference = existing;
+            audio::MixVolume(destination, source, Volume, accumulate);
+            scalar::MixVolume(reference, source, Volume, accumulate);
+            context.Check(destination == reference, fmt::format("MixVolume is identical to the scalar loop {} accumulation", accumulate ? "with" : "without"));
+        }
+
+        std::vector<i16> stereo(TailSampleCount * constant::StereoChannelCount), stereoReference(TailSampleCount * constant::StereoChannelCount);
+        audio::ExpandMonoToStereo(stereo, source);
+        scalar::ExpandMonoToStereo(stereoReference, source);
+        context.Check(stereo == stereoReference, "ExpandMonoToStereo is identical to the scalar loop");
+
+        auto surroundSamples{RandomSamples((TailSampleCount / 2) * constant::SurroundChannelCount, random)};
+        span<audio::Surround51Sample> surround{reinterpret_cast<audio::Surround51Sample *>(surroundSamples.data()), surroundSamples.size() / constant::SurroundChannelCount};
+        auto downmixed{audio::DownMix(surround)}, downmixedReference{scalar::DownMix(surround)};
+        context.Check(std::equal(downmixed.begin(), downmixed.end(), downmixedReference.begin(), downmixedReference.end(), [](const audio::StereoSample &a, const audio::StereoSample &b) { return a.left == b.left && a.right == b.right; }),
+                      "DownMix is identical to the scalar Q15 loop");
+
+        span<const i16> measuredSource{span(source).first(StereoSampleCount)};
+        span<i16> measuredDestination{span(destination).first(StereoSampleCount)};
+        context.Measure("MixSaturate/Neon", [&] { audio::MixSaturate(measuredDestination, measuredSource); }, StereoSampleCount, StereoSampleCount * sizeof(i16));
+        context.Measure("MixSaturate/Scalar", [&] { scalar::MixSaturate(measuredDestination, measuredSource); }, StereoSampleCount, StereoSampleCount * sizeof(i16));
+
+        for (bool accumulate : {false, true}) {
+            auto variant{accumulate ? "Accumulate" : "Overwrite"};
+            context.Measure(fmt::format("MixVolume/{}/Neon", variant), [&] { audio::MixVolume(measuredDestination, measuredSource, Volume, accumulate); }, StereoSampleCount, StereoSampleCount * sizeof(i16));
+            context.Measure(fmt::format("MixVolume/{}/Scalar", variant), [&] { scalar::MixVolume(measuredDestination, measuredSource, Volume, accumulate); }, StereoSampleCount, StereoSampleCount * sizeof(i16));
+        }
+
+        // Mono voices are expanded after resampling, the amount of mono samples is the amount of stereo frames in a mix buffer
+        span<const i16> monoSource{span(source).first(constant::MixBufferSize)};
+        span<i16> stereoDestination{span(stereo).first(StereoSampleCount)};
+        context.Measure("ExpandMonoToStereo/Neon", [&] { audio::ExpandMonoToStereo(stereoDestination, monoSource); }, constant::MixBufferSize, constant::MixBufferSize * sizeof(i16));
+        context.Measure("ExpandMonoToStereo/Scalar", [&] { scalar::ExpandMonoToStereo(stereoDestination, monoSource); }, constant::MixBufferSize, constant::MixBufferSize * sizeof(i16));
+
+        // Every downmixed frame is a single 5.1 sample, this includes the allocation of the output as that's part of audio::DownMix
+        auto measuredSurround{surround.first(constant::MixBufferSize)};
+        context.Measure("DownMix/Neon", [&] { DoNotOptimize(audio::DownMix(measuredSurround)); }, measuredSurround.size(), measuredSurround.size_bytes());
+        context.Measure("DownMix/Scalar", [&] { DoNotOptimize(scalar::DownMix(measuredSurround)); }, measuredSurround.size(), measuredSurround.size_bytes());
+        context.Measure("DownMix/PreviousScalar", [&] { DoNotOptimize(scalar::PreviousDownMix(measuredSurround)); }, measuredSurround.size(), measuredSurround.size_bytes());
+    }
+}
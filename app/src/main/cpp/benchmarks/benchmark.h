@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <string_view>
+#include <common/utils.h>
+
+namespace skyline::bench {
+    /**
+     * @brief Prevents the compiler from optimizing out the computation of a value or any stores to the memory it refers to
+     */
+    template<typename Type>
+    inline void DoNotOptimize(const Type &value) {
+        asm volatile("" : : "r"(&value) : "memory");
+    }
+
+    class Context;
+
+    using Function = void (*)(Context &context);
+
+    /**
+     * @brief Registers a benchmark with the runner during static initialization, this is done through SKYLINE_BENCHMARK
+     */
+    struct Registration {
+        Registration(std::string_view name, Function function);
+    };
+
+    /**
+     * @brief The state of the benchmark that's currently running, this is used to time variants of an operation and to verify their results
+     */
+    class Context {
+      private:
+        std::string_view benchmark; //!< The name of the running benchmark
+        bool failed{}; //!< If any check made by the benchmark has failed
+
+        void PrintMeasurement(std::string_view variant, double nsPerCall, u64 itemsPerCall, u64 bytesPerCall);
+
+      public:
+        static constexpr i64 MinimumSampleTime{50 * constant::NsInMillisecond}; //!< The minimum duration of a single sample, the amount of calls in a sample is calibrated to reach this
+        static constexpr size_t SampleCount{5}; //!< The amount of samples taken of every variant, the median of these is reported
+
+        Context(std::string_view benchmark);
+
+        /**
+         * @brief Times calls to the supplied function and prints the median duration of a call across all samples
+         * @param itemsPerCall The amount of items processed by a single call, this is used to report the throughput in items per microsecond
+         * @param bytesPerCall The amount of bytes processed by a single call, this is used to report the throughput in MB/s if it's non-zero
+         * @return The median duration of a call in nanoseconds
+         */
+        template<typename Function>
+        double Measure(std::string_view variant, Function &&function, u64 itemsPerCall = 1, u64 bytesPerCall = 0) {
+            auto runCalls{[&function](size_t calls) {
+                i64 start{util::GetTimeNs()};
+                for (size_t call{}; call < calls; call++)
+                    function();
+                return util::GetTimeNs() - start;
+            }};
+
+            size_t calls{1};
+            while (runCalls(calls) < MinimumSampleTime)
+                calls *= 2;
+
+            std::array<double, SampleCount> samples{};
+            for (auto &sample : samples)
+                sample = static_cast<double>(runCalls(calls)) / static_cast<double>(calls);
+            std::sort(samples.begin(), samples.end());
+
+            double nsPerCall{samples[SampleCount / 2]};
+            PrintMeasurement(variant, nsPerCall, itemsPerCall, bytesPerCall);
+            return nsPerCall;
+        }
+
+        /**
+         * @brief Prints an arbitrary metric of the benchmark, this is used for measurements that can't be expressed as the duration of a call
+         */
+        void Report(std::string_view metric, double value, std::string_view unit);
+
+        /**
+         * @brief Verifies a result of the benchmark, a failed check is printed and causes the runner to exit with a failure
+         */
+        void Check(bool condition, std::string_view description);
+
+        bool Failed() const {
+            return failed;
+        }
+    };
+}
+
+/**
+ * @brief Defines a benchmark and registers it with the runner, the body has access to a `skyline::bench::Context &context`
+ */
+#define SKYLINE_BENCHMARK(name)                                                   \
+    static void name(skyline::bench::Context &context);                          \
+    static skyline::bench::Registration name##Registration{#name, name};         \
+    static void name(skyline::bench::Context &context)
@@ -0,0 +1,218 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <random>
+#include <common/segment_table.h>
+#include "benchmark.h"
+
+/**
+ * @brief Compares BufferManager::FindOrCreate lookups through the page table alone with the lookup cache of recent mappings in front of it
+ * @note The buffers and views are reduced to the state that's accessed on the lookup path, creation of buffers is replaced by invalidation of the cache as that's the only effect it has on later lookups
+ */
+namespace skyline::bench {
+    struct BufferDelegate {
+        u32 id;
+    };
+
+    struct BufferView {
+        BufferDelegate *delegate{};
+        u64 offset{};
+        u64 size{};
+
+        operator bool() const {
+            return delegate != nullptr;
+        }
+    };
+
+    struct Buffer {
+        span<u8> guest;
+        BufferDelegate delegate;
+
+        /**
+         * @note This is out-of-line in the same way as Buffer::TryGetView in buffer.cpp
+         */
+        [[gnu::noinline]] BufferView TryGetView(span<u8> mapping) {
+            if (guest.contains(mapping))
+                return BufferView{&delegate, static_cast<u64>(std::distance(guest.begin(), mapping.begin())), mapping.size()};
+            else
+                return {};
+        }
+    };
+
+    using BufferTable = SegmentTable<Buffer *, constant::AddressSpaceSize, constant::PageSizeBits, 19>;
+
+    /**
+     * @brief The lookup path of FindOrCreate prior to the lookup cache, every lookup walks the page table and constructs a view
+     */
+    class PageTableLookup {
+      private:
+        BufferTable &bufferTable;
+
+      public:
+        PageTableLookup(BufferTable &bufferTable) : bufferTable{bufferTable} {}
+
+        void Invalidate() {}
+
+        BufferView Find(span<u8> guestMapping) {
+            if (auto lookupBuffer{bufferTable[guestMapping.data()]}; lookupBuffer)
+                return lookupBuffer->TryGetView(guestMapping);
+            return {};
+        }
+    };
+
+    /**
+     * @brief The lookup path of FindOrCreate now, the lookup cache is checked prior to the page table
+     */
+    class CachedLookup {
+      private:
+        BufferTable &bufferTable;
+
+        struct LookupCacheEntry {
+            u8 *base{};
+            size_t size{};
+            BufferView view;
+        };
+
+        static constexpr size_t LookupCacheSize{8};
+        std::array<LookupCacheEntry, LookupCacheSize> lookupCache{};
+
+        void InsertLookupCache(span<u8> guestMapping, const BufferView &view) {
+            std::move_backward(lookupCache.begin(), std::prev(lookupCache.end()), lookupCache.end());
+            lookupCache.front() = {guestMapping.data(), guestMapping.size(), view};
+        }
+
+      public:
+        size_t hits{}; //!< The amount of lookups that were served from the lookup cache
+
+        CachedLookup(BufferTable &bufferTable) : bufferTable{bufferTable} {}
+
+        void Invalidate() {
+            lookupCache.fill({});
+        }
+
+        BufferView Find(span<u8> guestMapping) {
+            for (const auto &entry : lookupCache)
+                if (entry.base == guestMapping.data() && entry.size == guestMapping.size()) {
+                    hits++;
+                    return entry.view;
+                }
+
+            if (auto lookupBuffer{bufferTable[guestMapping.data()]}; lookupBuffer) {
+                if (auto view{lookupBuffer->TryGetView(guestMapping)}; view) {
+                    InsertLookupCache(guestMapping, view);
+                    return view;
+                }
+            }
+            return {};
+        }
+    };
+
+    /**
+     * @brief A single operation in the recorded workload, a lookup of a mapping or an invalidation of the lookup cache
+     */
+    struct BufferOperation {
+        span<u8> mapping; //!< The mapping that's looked up, this'll be empty for an invalidation
+    };
+
+    struct BufferWorkload {
+        std::vector<std::unique_ptr<Buffer>> buffers;
+        std::vector<BufferOperation> operations;
+        size_t lookupCount{};
+        size_t invalidationCount{};
+    };
+
+    /**
+     * @brief Records a deterministic workload of lookups from draws, the buffers aren't backed by memory as only their addresses are used
+     * @param scattered If draws look up a random selection of the mappings of their material rather than all of them in the same order every draw
+     * @param drawsPerBufferChange The amount of draws between buffers being created or deleted which invalidates the lookup cache
+     */
+    static BufferWorkload RecordBufferWorkload(BufferTable &bufferTable, bool scattered, size_t drawsPerBufferChange) {
+        constexpr size_t BufferCount{1024}, MinimumBufferSize{4 * 1024}, MaximumBufferSize{1024 * 1024};
+        constexpr size_t MaterialCount{64}, MappingsPerMaterial{12}, DrawsPerMaterial{16}, DrawCount{16384};
+        constexpr size_t BoundMappingsPerDraw{6}; //!< The amount of mappings of a material that are looked up every draw when it isn't scattered, this is a vertex buffer, an index buffer and 4 constant buffers
+        constexpr size_t ScatteredLookupsPerDraw{8};
+        auto base{reinterpret_cast<u8 *>(1ULL << 35)};
+
+        BufferWorkload workload;
+        std::mt19937_64 random{0};
+
+        u8 *cursor{base};
+        for (size_t index{}; index < BufferCount; index++) {
+            size_t size{util::AlignUp(std::uniform_int_distribution<size_t>{MinimumBufferSize, MaximumBufferSize}(random), constant::PageSize)};
+            auto &buffer{workload.buffers.emplace_back(std::make_unique<Buffer>(Buffer{span<u8>{cursor, size}, BufferDelegate{static_cast<u32>(index)}}))};
+            bufferTable.Set(buffer->guest, buffer.get());
+            cursor += size;
+        }
+
+        // Every material binds a fixed set of vertex, index and constant buffer ranges which are subranges of the buffers, these are 256-byte aligned like guest constant buffers
+        std::vector<std::array<span<u8>, MappingsPerMaterial>> materials(MaterialCount);
+        std::uniform_int_distribution<size_t> bufferDistribution{0, BufferCount - 1};
+        for (auto &material : materials) {
+            for (auto &mapping : material) {
+                auto guest{workload.buffers[bufferDistribution(random)]->guest};
+                size_t offset{util::AlignDown(std::uniform_int_distribution<size_t>{0, guest.size() / 2}(random), 0x100)};
+                size_t size{std::uniform_int_distribution<size_t>{0x100, guest.size() - offset}(random)};
+                mapping = guest.subspan(offset, size);
+            }
+        }
+
+        // Draws either look up the same mappings of the current material every time or a random selection of them, the material changes every few draws
+        std::uniform_int_distribution<size_t> materialDistribution{0, MaterialCount - 1}, mappingDistribution{0, MappingsPerMaterial - 1};
+        size_t material{};
+        for (size_t draw{}; draw < DrawCount; draw++) {
+            if (draw % DrawsPerMaterial == 0)
+                material = materialDistribution(random);
+            if (drawsPerBufferChange && draw % drawsPerBufferChange == 0)
+                workload.operations.push_back(BufferOperation{});
+
+            if (scattered)
+                for (size_t index{}; index < ScatteredLookupsPerDraw; index++)
+                    workload.operations.push_back(BufferOperation{materials[material][mappingDistribution(random)]});
+            else
+                for (size_t index{}; index < BoundMappingsPerDraw; index++)
+                    workload.operations.push_back(BufferOperation{materials[material][index]});
+        }
+
+        workload.invalidationCount = static_cast<size_t>(std::count_if(workload.operations.begin(), workload.operations.end(), [](const BufferOperation &operation) { return operation.mapping.empty(); }));
+        workload.lookupCount = workload.operations.size() - workload.invalidationCount;
+        return workload;
+    }
+
+    /**
+     * @return A checksum of the views returned by every lookup, this verifies that both lookup paths return the same views
+     */
+    template<typename Lookup>
+    static u64 ReplayBufferWorkload(Lookup &lookup, const BufferWorkload &workload) {
+        u64 checksum{};
+        for (const auto &operation : workload.operations) {
+            if (operation.mapping.empty()) {
+                lookup.Invalidate();
+            } else {
+                auto view{lookup.Find(operation.mapping)};
+                checksum = (checksum * 31) + (view ? (view.delegate->id ^ view.offset ^ view.size) : 0);
+            }
+        }
+        return checksum;
+    }
+
+    SKYLINE_BENCHMARK(BufferLookups) {
+        // Buffers are created or deleted at a variety of rates as guests stream in data, the cache is only beneficial if it isn't invalidated too frequently
+        for (bool scattered : {false, true}) {
+            for (size_t drawsPerBufferChange : {0, 64, 8, 1}) {
+                BufferTable bufferTable;
+                auto workload{RecordBufferWorkload(bufferTable, scattered, drawsPerBufferChange)};
+                auto variant{fmt::format("{}/{}", scattered ? "Scattered" : "Bound", drawsPerBufferChange ? fmt::format("ChangeEvery{}Draws", drawsPerBufferChange) : std::string{"NoChanges"})};
+                context.Report(fmt::format("{}/lookups", variant), static_cast<double>(workload.lookupCount), "per replay");
+                context.Report(fmt::format("{}/invalidations", variant), static_cast<double>(workload.invalidationCount), "per replay");
+
+                PageTableLookup pageTable{bufferTable};
+                CachedLookup cached{bufferTable};
+                context.Check(ReplayBufferWorkload(pageTable, workload) == ReplayBufferWorkload(cached, workload), fmt::format("{}: both lookup paths return the same views", variant));
+                context.Report(fmt::format("{}/hitRate", variant), static_cast<double>(cached.hits) * 100.0 / static_cast<double>(workload.lookupCount), "%");
+
+                context.Measure(fmt::format("{}/PageTable", variant), [&] { DoNotOptimize(ReplayBufferWorkload(pageTable, workload)); }, workload.lookupCount);
+                context.Measure(fmt::format("{}/LookupCache", variant), [&] { DoNotOptimize(ReplayBufferWorkload(cached, workload)); }, workload.lookupCount);
+            }
+        }
+    }
+}
@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <fstream>
+#include <asm-generic/unistd.h>
+#include <linux/memfd.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <common.h>
+#include "benchmark.h"
+
+/**
+ * @brief Compares random accesses to memfd-backed memory with and without MADV_HUGEPAGE, in the same way that the guest heap is backed when huge pages are enabled in the settings
+ * @note Transparent huge pages are only used for shared memory when the host kernel's shmem_enabled policy allows it, the policy and the amount of memory that was mapped with huge pages are reported so results can be interpreted
+ */
+namespace skyline::bench {
+    constexpr size_t HugePageSize{2 * 1024 * 1024}; //!< The size of a PMD-level huge page with a 4 KiB granule
+
+    /**
+     * @brief A memfd mapping that's aligned to the size of a huge page, this is the same as the guest address space which is created with a memfd and mapped with MAP_SHARED
+     */
+    class MemfdMapping {
+      private:
+        int fd;
+        u8 *reservation;
+        size_t reservationSize;
+
+      public:
+        span<u8> mapping;
+
+        MemfdMapping(size_t size, bool hugePages) : reservationSize{size + HugePageSize} {
+            fd = static_cast<int>(syscall(__NR_memfd_create, "Bench-AS", MFD_CLOEXEC));
+            if (fd < 0)
+                throw exception("Failed to create memfd: {}", strerror(errno));
+            if (ftruncate(fd, static_cast<off_t>(size)) < 0)
+                throw exception("Failed to resize memfd: {}", strerror(errno));
+
+            // The mapping is placed at a huge page aligned address inside a larger reservation as huge pages can only be used for aligned virtual addresses
+            reservation = static_cast<u8 *>(mmap(nullptr, reservationSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0));
+            if (reservation == MAP_FAILED)
+                throw exception("Failed to reserve 0x{:X} bytes: {}", reservationSize, strerror(errno));
+
+            auto base{mmap(util::AlignUp(reservation, HugePageSize), size, PROT_READ | PROT_WRITE, MAP_FIXED | MAP_SHARED, fd, 0)};
+            if (base == MAP_FAILED)
+                throw exception("Failed to map memfd: {}", strerror(errno));
+            mapping = span<u8>{static_cast<u8 *>(base), size};
+
+            if (hugePages && madvise(mapping.data(), mapping.size(), MADV_HUGEPAGE) == -1)
+                throw exception("Failed to advise huge pages: {}", strerror(errno));
+        }
+
+        ~MemfdMapping() {
+            munmap(reservation, reservationSize);
+            close(fd);
+        }
+    };
+
+    /**
+     * @return The value of a field in /proc/self/smaps_rollup in KiB, or zero if it isn't present
+     */
+    static size_t GetSmapsRollupField(std::string_view field) {
+        std::ifstream smaps{"/proc/self/smaps_rollup"};
+        std::string line;
+        while (std::getline(smaps, line))
+            if (line.starts_with(field) && line.size() > field.size() && line[field.size()] == ':')
+                return std::stoull(line.substr(field.size() + 1));
+        return 0;
+    }
+
+    /**
+     * @brief Performs random reads across the entire mapping, every read is to a different cache line and almost always a different 4 KiB page
+     * @return The sum of all values that were read
+     */
+    static u64 RandomReads(span<u8> mapping, size_t count, u64 &seed) {
+        u64 sum{}, mask{(mapping.size() - 1) & ~u64{0x3F}};
+        for (size_t index{}; index < count; index++) {
+            seed = (seed * 6364136223846793005ULL) + 1442695040888963407ULL;
+            sum += *reinterpret_cast<u64 *>(mapping.data() + ((seed >> 16) & mask));
+        }
+        return sum;
+    }
+
+    SKYLINE_BENCHMARK(GuestMemoryHugePages) {
+        constexpr size_t MappingSize{256 * 1024 * 1024}; //!< The size of the mapping, this is a power of two and much larger than the reach of the TLB with 4 KiB pages
+        constexpr size_t ReadsPerCall{1 << 16};
+
+        std::ifstream policyFile{"/sys/kernel/mm/transparent_hugepage/shmem_enabled"};
+        std::string policy;
+        std::getline(policyFile, policy);
+        bool policyAllowsHugePages{!policy.empty() && policy.find("[never]") == std::string::npos && policy.find("[deny]") == std::string::npos}; // This is the same check as MemoryManager::AdviseHugePages
+        context.Report("ShmemPolicyAllowsHugePages", policyAllowsHugePages ? 1.0 : 0.0, "(1 if allowed)");
+
+        for (bool hugePages : {false, true}) {
+            auto variant{hugePages ? "HugePage" : "Regular"};
+            size_t pmdMappedBefore{GetSmapsRollupField("ShmemPmdMapped")};
+            auto begin{std::chrono::steady_clock::now()};
+            MemfdMapping memfd{MappingSize, hugePages};
+            for (size_t offset{}; offset < memfd.mapping.size(); offset += PAGE_SIZE)
+                memfd.mapping[offset] = static_cast<u8>(offset >> 12); // Every page is faulted in prior to measuring, this is the same for the guest heap where games touch their heap shortly after allocating it
+            auto faultTime{std::chrono::steady_clock::now() - begin};
+
+            context.Report(fmt::format("{}/FaultIn", variant), static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(faultTime).count()) / 1000.0, "ms");
+            context.Report(fmt::format("{}/ShmemPmdMapped", variant), static_cast<double>(GetSmapsRollupField("ShmemPmdMapped") - pmdMappedBefore) / 1024.0, "MiB");
+
+            u64 seed{0};
+            context.Measure(fmt::format("{}/RandomRead", variant), [&] { DoNotOptimize(RandomReads(memfd.mapping, ReadsPerCall, seed)); }, ReadsPerCall);
+        }
+    }
+}
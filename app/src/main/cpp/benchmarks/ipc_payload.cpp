@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <boost/container/small_vector.hpp>
+#include <common.h>
+#include "benchmark.h"
+
+/**
+ * @brief Compares building the payload of an IpcResponse in a std::vector with the inline small_vector that replaced it
+ * @note Every response is constructed with an empty payload in the same way as an IpcResponse is constructed for every request, the payload is then pushed and written out to a command buffer
+ */
+namespace skyline::bench {
+    constexpr u16 TlsIpcSize{0x100}; //!< The size of the IPC command buffer in a TLS slot, this is the same as constant::TlsIpcSize
+
+    /**
+     * @brief The payload of an IpcResponse with the supplied container
+     */
+    template<typename Container>
+    struct ResponsePayload {
+        Container payload;
+
+        template<typename ValueType>
+        void Push(const ValueType &value) {
+            auto size{payload.size()};
+            payload.resize(size + sizeof(ValueType));
+            std::memcpy(payload.data() + size, reinterpret_cast<const u8 *>(&value), sizeof(ValueType));
+        }
+
+        void Push(std::string_view string) {
+            auto size{payload.size()};
+            payload.resize(size + string.size());
+            std::memcpy(payload.data() + size, string.data(), string.size());
+        }
+
+        /**
+         * @brief Copies the payload into the command buffer in the same way as IpcResponse::WriteResponse
+         */
+        void WriteResponse(span<u8> commandBuffer) {
+            if (!payload.empty())
+                std::memcpy(commandBuffer.data(), payload.data(), payload.size());
+        }
+    };
+
+    /**
+     * @brief The shape of a response, this determines what's pushed to the payload
+     */
+    enum class ResponseShape {
+        Empty, //!< Only a result code, this is what the majority of commands respond with
+        Scalar, //!< A single u32 or u64 value such as a handle index, a size or an event
+        Mixed, //!< A few scalars of different sizes such as a timestamp alongside a count and flags
+        Struct, //!< A 0x40 byte structure such as an account profile or a network interface configuration
+        String, //!< A short string such as a device or locale name
+    };
+
+    constexpr std::array<std::pair<ResponseShape, std::string_view>, 5> ResponseShapes{{
+        {ResponseShape::Empty, "Empty"},
+        {ResponseShape::Scalar, "Scalar"},
+        {ResponseShape::Mixed, "Mixed"},
+        {ResponseShape::Struct, "Struct"},
+        {ResponseShape::String, "String"},
+    }};
+
+    /**
+     * @brief Builds and writes a single response of the supplied shape
+     * @return The size of the payload that was written
+     */
+    template<typename Container>
+    [[gnu::noinline]] static size_t WriteResponse(ResponseShape shape, span<u8> commandBuffer, u64 value) {
+        ResponsePayload<Container> response;
+        switch (shape) {
+            case ResponseShape::Empty:
+                break;
+
+            case ResponseShape::Scalar:
+                response.Push(static_cast<u32>(value));
+                break;
+
+            case ResponseShape::Mixed:
+                response.Push(value);
+                response.Push(static_cast<u32>(value >> 7));
+                response.Push(static_cast<u16>(value >> 3));
+                response.Push(static_cast<u8>(value));
+                break;
+
+            case ResponseShape::Struct: {
+                std::array<u64, 8> structure{};
+                structure.fill(value);
+                response.Push(structure);
+                break;
+            }
+
+            case ResponseShape::String:
+                response.Push(std::string_view{"Skyline Nintendo Switch Emulator"});
+                response.Push(u8{});
+                break;
+        }
+        response.WriteResponse(commandBuffer);
+        return response.payload.size();
+    }
+
+    SKYLINE_BENCHMARK(IpcResponsePayload) {
+        using Vector = std::vector<u8>;
+        using SmallVector = boost::container::small_vector<u8, TlsIpcSize>;
+
+        std::array<u8, TlsIpcSize> commandBuffer{}, otherCommandBuffer{};
+        for (auto [shape, name] : ResponseShapes) {
+            commandBuffer.fill(0);
+            otherCommandBuffer.fill(0);
+            size_t vectorSize{WriteResponse<Vector>(shape, commandBuffer, 0x1234567890ABCDEF)};
+            size_t smallVectorSize{WriteResponse<SmallVector>(shape, otherCommandBuffer, 0x1234567890ABCDEF)};
+            context.Check(vectorSize == smallVectorSize && commandBuffer == otherCommandBuffer, fmt::format("{} responses are written identically", name));
+
+            u64 value{};
+            context.Measure(fmt::format("{}/Vector", name), [&] { DoNotOptimize(WriteResponse<Vector>(shape, commandBuffer, value++)); }, 1, vectorSize);
+            context.Measure(fmt::format("{}/SmallVector", name), [&] { DoNotOptimize(WriteResponse<SmallVector>(shape, commandBuffer, value++)); }, 1, smallVectorSize);
+        }
+    }
+}
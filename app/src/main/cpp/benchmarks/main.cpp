@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <cstdio>
+#include <vector>
+#include "benchmark.h"
+
+namespace skyline::bench {
+    /**
+     * @return All registered benchmarks, this is a function-local static as registrations happen during static initialization in an unspecified order
+     */
+    static std::vector<std::pair<std::string_view, Function>> &GetBenchmarks() {
+        static std::vector<std::pair<std::string_view, Function>> benchmarks;
+        return benchmarks;
+    }
+
+    Registration::Registration(std::string_view name, Function function) {
+        GetBenchmarks().emplace_back(name, function);
+    }
+
+    Context::Context(std::string_view benchmark) : benchmark{benchmark} {}
+
+    void Context::PrintMeasurement(std::string_view variant, double nsPerCall, u64 itemsPerCall, u64 bytesPerCall) {
+        std::string line{fmt::format("{}/{}: {:.1f} ns/call, {:.3f} items/us", benchmark, variant, nsPerCall, static_cast<double>(itemsPerCall) * constant::NsInMicrosecond / nsPerCall)};
+        if (bytesPerCall)
+            line += fmt::format(", {:.1f} MB/s", static_cast<double>(bytesPerCall) * constant::NsInSecond / nsPerCall / (1024 * 1024));
+        std::puts(line.c_str());
+    }
+
+    void Context::Report(std::string_view metric, double value, std::string_view unit) {
+        std::puts(fmt::format("{}/{}: {:.3f} {}", benchmark, metric, value, unit).c_str());
+    }
+
+    void Context::Check(bool condition, std::string_view description) {
+        if (!condition) {
+            std::puts(fmt::format("{}: check failed: {}", benchmark, description).c_str());
+            failed = true;
+        }
+    }
+}
+
+/**
+ * @brief Runs all registered benchmarks with a name containing any of the supplied filters, or all of them if none are supplied
+ * @note `--list` prints the names of all registered benchmarks instead of running them
+ */
+int main(int argc, char **argv) {
+    using namespace skyline::bench;
+    std::vector<std::string_view> filters(argv + 1, argv + argc);
+    if (filters.size() == 1 && filters.front() == "--list") {
+        for (const auto &[name, function] : GetBenchmarks())
+            std::puts(std::string{name}.c_str());
+        return 0;
+    }
+
+    bool failed{};
+    for (const auto &[name, function] : GetBenchmarks()) {
+        if (!filters.empty() && std::none_of(filters.begin(), filters.end(), [name = name](std::string_view filter) { return name.find(filter) != std::string_view::npos; }))
+            continue;
+
+        Context context{name};
+        function(context);
+        failed |= context.Failed();
+        std::fflush(stdout);
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,216 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <csignal>
+#include <ctime>
+#include <unistd.h>
+#include <common.h>
+#include "benchmark.h"
+
+/**
+ * @brief Compares arming preemption with a CPU-time POSIX timer per thread to the preemption slots polled by the scheduler's preemption thread
+ * @note Arming and disarming are measured as that's done on every context switch of a preemptive thread, the lateness of the preemption signal is reported as the polling trades accuracy for not needing any syscalls to arm
+ */
+namespace skyline::bench {
+    constexpr size_t CoreCount{4}; //!< The amount of cores that threads can be scheduled onto, this is the amount of preemption slots
+    static int PreemptionSignal{SIGRTMIN + 1};
+    static volatile sig_atomic_t preempted{}; //!< Set by the signal handler once the thread has been preempted
+
+    /**
+     * @brief The preemption timer of KThread prior to polling, a kernel timer on the CPU-time clock of the thread that's armed with timer_settime
+     */
+    class TimerPreemption {
+      private:
+        timer_t preemptionTimer{};
+
+      public:
+        TimerPreemption() {
+            struct sigevent event{
+                .sigev_signo = PreemptionSignal,
+                .sigev_notify = SIGEV_THREAD_ID,
+            };
+            event.sigev_notify_thread_id = gettid();
+            if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &preemptionTimer))
+                throw exception("timer_create has failed with '{}'", strerror(errno));
+        }
+
+        ~TimerPreemption() {
+            timer_delete(preemptionTimer);
+        }
+
+        void Arm(std::chrono::nanoseconds timeToFire) {
+            struct itimerspec spec{.it_value = {
+                .tv_sec = std::max<i64>(std::chrono::duration_cast<std::chrono::seconds>(timeToFire).count() - 1, 0),
+                .tv_nsec = std::min(static_cast<i64>(timeToFire.count()), constant::NsInSecond),
+            }};
+            timer_settime(preemptionTimer, 0, &spec, nullptr);
+        }
+
+        void Disarm() {
+            struct itimerspec spec{};
+            timer_settime(preemptionTimer, 0, &spec, nullptr);
+        }
+    };
+
+    /**
+     * @brief The preemption slots of the scheduler now, a single thread polls the CPU time of every thread with an armed slot and signals them once they've overrun
+     */
+    class PollPreemption {
+      private:
+        struct PreemptionSlot {
+            const void *thread{};
+            pthread_t pthread{};
+            clockid_t cpuClock{};
+            std::chrono::nanoseconds timeslice{};
+            i64 cpuTimeBaseline{-1};
+        };
+
+        static constexpr std::chrono::microseconds PreemptionPollInterval{2500};
+
+        std::mutex preemptionMutex;
+        std::condition_variable preemptionCondition;
+        std::array<PreemptionSlot, CoreCount> preemptionSlots{};
+        bool preemptionIdle{};
+        bool preemptionExit{};
+        std::thread preemptionThread;
+
+        void PreemptionThread() {
+            std::unique_lock lock{preemptionMutex};
+            while (!preemptionExit) {
+                bool anyArmed{};
+                for (auto &slot : preemptionSlots) {
+                    if (!slot.thread)
+                        continue;
+
+                    timespec cpuTime{};
+                    if (clock_gettime(slot.cpuClock, &cpuTime)) [[unlikely]] {
+                        slot.thread = nullptr;
+                        continue;
+                    }
+
+                    i64 cpuTimeNs{cpuTime.tv_sec * constant::NsInSecond + cpuTime.tv_nsec};
+                    if (slot.cpuTimeBaseline < 0) {
+                        slot.cpuTimeBaseline = cpuTimeNs;
+                        anyArmed = true;
+                    } else if (cpuTimeNs - slot.cpuTimeBaseline >= slot.timeslice.count()) {
+                        pthread_kill(slot.pthread, PreemptionSignal);
+                        slot.thread = nullptr;
+                    } else {
+                        anyArmed = true;
+                    }
+                }
+
+                if (anyArmed) {
+                    preemptionCondition.wait_for(lock, PreemptionPollInterval, [this]() { return preemptionExit; });
+                } else {
+                    preemptionIdle = true;
+                    preemptionCondition.wait(lock, [this]() { return preemptionExit || !preemptionIdle; });
+                }
+            }
+        }
+
+      public:
+        PollPreemption() : preemptionThread{&PollPreemption::PreemptionThread, this} {}
+
+        ~PollPreemption() {
+            {
+                std::scoped_lock lock{preemptionMutex};
+                preemptionExit = true;
+            }
+            preemptionCondition.notify_all();
+            preemptionThread.join();
+        }
+
+        void Arm(u8 coreId, const void *thread, pthread_t pthread, clockid_t cpuClock, std::chrono::nanoseconds timeslice) {
+            std::scoped_lock lock{preemptionMutex};
+            preemptionSlots[coreId] = PreemptionSlot{
+                .thread = thread,
+                .pthread = pthread,
+                .cpuClock = cpuClock,
+                .timeslice = timeslice,
+            };
+
+            if (preemptionIdle) {
+                preemptionIdle = false;
+                preemptionCondition.notify_one();
+            }
+        }
+
+        void Disarm(const void *thread) {
+            std::scoped_lock lock{preemptionMutex};
+            for (auto &slot : preemptionSlots)
+                if (slot.thread == thread)
+                    slot.thread = nullptr;
+        }
+    };
+
+    static i64 GetThreadCpuTime() {
+        timespec cpuTime{};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpuTime);
+        return cpuTime.tv_sec * constant::NsInSecond + cpuTime.tv_nsec;
+    }
+
+    /**
+     * @brief Arms preemption with the supplied function and spins on this thread till it's preempted
+     * @return The amount of CPU time that the thread ran for past its timeslice in nanoseconds, or a negative value if it wasn't preempted within a second of CPU time
+     */
+    template<typename ArmFunction>
+    static i64 MeasurePreemptionOverrun(std::chrono::nanoseconds timeslice, ArmFunction arm) {
+        preempted = false;
+        i64 start{GetThreadCpuTime()}, now{start};
+        arm();
+        while (!preempted && now - start < constant::NsInSecond)
+            now = GetThreadCpuTime();
+        return preempted ? (now - start) - timeslice.count() : -1;
+    }
+
+    SKYLINE_BENCHMARK(Preemption) {
+        struct sigaction action{};
+        action.sa_handler = [](int) { preempted = true; };
+        sigaction(PreemptionSignal, &action, nullptr);
+
+        TimerPreemption timer;
+        PollPreemption poll;
+        pthread_t pthread{pthread_self()};
+        clockid_t cpuClock{};
+        pthread_getcpuclockid(pthread, &cpuClock);
+        int threadToken{}; //!< A stand-in for the KThread which identifies the armed slot
+
+        // Guest timeslices are generally a few milliseconds, the timeslice is armed when a preemptive thread is scheduled in and disarmed when it yields or waits
+        constexpr std::chrono::milliseconds Timeslice{10};
+        context.Measure("ArmDisarm/Timer", [&] {
+            timer.Arm(Timeslice);
+            timer.Disarm();
+        });
+        context.Measure("ArmDisarm/Poll", [&] {
+            poll.Arm(0, &threadToken, pthread, cpuClock, Timeslice);
+            poll.Disarm(&threadToken);
+        });
+
+        // The lateness of preemption is only reported, a late preemption doesn't affect the emulator's throughput but lets a thread overrun its timeslice
+        constexpr size_t OverrunSamples{16};
+        constexpr std::chrono::milliseconds OverrunTimeslice{2};
+        for (bool polled : {false, true}) {
+            i64 totalOverrun{}, maximumOverrun{};
+            bool allPreempted{true};
+            for (size_t sample{}; sample < OverrunSamples; sample++) {
+                i64 overrun{polled ? MeasurePreemptionOverrun(OverrunTimeslice, [&] { poll.Arm(0, &threadToken, pthread, cpuClock, OverrunTimeslice); })
+                                   : MeasurePreemptionOverrun(OverrunTimeslice, [&] { timer.Arm(OverrunTimeslice); })};
+                if (overrun < 0) {
+                    allPreempted = false;
+                    break;
+                }
+                totalOverrun += overrun;
+                maximumOverrun = std::max(maximumOverrun, overrun);
+            }
+
+            auto variant{polled ? "Poll" : "Timer"};
+            context.Check(allPreempted, fmt::format("{}: a spinning thread is preempted", variant));
+            context.Report(fmt::format("Overrun/{}/mean", variant), static_cast<double>(totalOverrun) / OverrunSamples / constant::NsInMillisecond, "ms");
+            context.Report(fmt::format("Overrun/{}/max", variant), static_cast<double>(maximumOverrun) / constant::NsInMillisecond, "ms");
+        }
+
+        action.sa_handler = SIG_DFL;
+        sigaction(PreemptionSignal, &action, nullptr);
+    }
+}
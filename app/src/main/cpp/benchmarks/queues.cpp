@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <common/circular_queue.h>
+#include <common/spsc_queue.h>
+#include "benchmark.h"
+
+/**
+ * @brief Compares handing off items between a producer and a consumer thread with SpscQueue and with CircularQueue which it replaced for single producer queues
+ * @note The consumer side uses Process() for both queues as that's how they're consumed in the codebase
+ * @note Items are produced in bursts that fit in the queue and the producer waits for each burst to be processed before the next one, CircularQueue can miss waking a producer that's waiting for space so it can't be filled up
+ */
+namespace skyline::bench {
+    constexpr size_t QueueSize{1024}; //!< The capacity of the queues, this matches the size of the queues of input events
+    constexpr size_t BurstSize{512}; //!< The amount of items that are produced before waiting for the consumer to process them
+    constexpr u64 StopItem{0}; //!< An item that stops the consumer, all other items are non-zero
+
+    /**
+     * @brief Thrown by the consumer to return out of Process() once the stop item has been processed
+     */
+    struct ProcessStopped {};
+
+    /**
+     * @brief Hands off the supplied amount of items from this thread to a consumer thread in bursts
+     * @param count The amount of items to hand off, this must be a multiple of the burst size
+     * @param batchSize The amount of items that are appended to the queue at once, a single item is pushed at a time if this is 1
+     * @return The sum of all items that the consumer processed
+     */
+    template<typename Queue>
+    static u64 RunHandoff(size_t count, size_t batchSize) {
+        Queue queue{QueueSize};
+        u64 sum{};
+        std::atomic<size_t> processed{};
+        std::thread consumer{[&] {
+            try {
+                queue.Process([&](u64 &item) {
+                    if (item == StopItem)
+                        throw ProcessStopped{};
+                    sum += item;
+                    processed.store(processed.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+                }, [] {});
+            } catch (ProcessStopped) {}
+        }};
+
+        std::vector<u64> batch(batchSize);
+        for (u64 item{1}; item <= count;) {
+            if (batchSize == 1) {
+                queue.Push(item++);
+            } else {
+                for (auto &batchItem : batch)
+                    batchItem = item++;
+                queue.Append(span<u64>{batch});
+            }
+
+            if ((item - 1) % BurstSize == 0)
+                while (processed.load(std::memory_order_acquire) != item - 1)
+                    std::this_thread::yield();
+        }
+        queue.Push(StopItem);
+
+        consumer.join();
+        return sum;
+    }
+
+    /**
+     * @brief Sends the supplied amount of items to an echo thread one at a time and waits for each to be returned, this measures the latency of waking up a waiting consumer
+     * @return The sum of all items that were returned
+     */
+    template<typename Queue>
+    static u64 RunPingPong(size_t count) {
+        Queue requests{QueueSize}, responses{QueueSize};
+        std::thread echo{[&] {
+            try {
+                requests.Process([&](u64 &item) {
+                    responses.Push(item);
+                    if (item == StopItem)
+                        throw ProcessStopped{};
+                }, [] {});
+            } catch (ProcessStopped) {}
+        }};
+
+        u64 sum{};
+        for (u64 item{1}; item <= count; item++) {
+            requests.Push(item);
+            sum += responses.Pop();
+        }
+        requests.Push(StopItem);
+        responses.Pop();
+
+        echo.join();
+        return sum;
+    }
+
+    SKYLINE_BENCHMARK(QueueHandoff) {
+        constexpr size_t HandoffCount{1 << 18}, PingPongCount{1 << 12};
+        constexpr u64 HandoffSum{(HandoffCount * (HandoffCount + 1)) / 2}, PingPongSum{(PingPongCount * (PingPongCount + 1)) / 2};
+
+        // Items are handed off one at a time like input events and in batches like GpEntries from a GPFIFO submission
+        for (size_t batchSize : {1, 64}) {
+            context.Check(RunHandoff<SpscQueue<u64>>(HandoffCount, batchSize) == HandoffSum, fmt::format("SpscQueue processes every item with batches of {}", batchSize));
+            context.Check(RunHandoff<CircularQueue<u64>>(HandoffCount, batchSize) == HandoffSum, fmt::format("CircularQueue processes every item with batches of {}", batchSize));
+
+            context.Measure(fmt::format("Batch{}/SpscQueue", batchSize), [&] { DoNotOptimize(RunHandoff<SpscQueue<u64>>(HandoffCount, batchSize)); }, HandoffCount, HandoffCount * sizeof(u64));
+            context.Measure(fmt::format("Batch{}/CircularQueue", batchSize), [&] { DoNotOptimize(RunHandoff<CircularQueue<u64>>(HandoffCount, batchSize)); }, HandoffCount, HandoffCount * sizeof(u64));
+        }
+
+        // Items are round trips, the consumer has to be woken up for every one of them
+        context.Check(RunPingPong<SpscQueue<u64>>(PingPongCount) == PingPongSum, "SpscQueue returns every item in a ping-pong");
+        context.Check(RunPingPong<CircularQueue<u64>>(PingPongCount) == PingPongSum, "CircularQueue returns every item in a ping-pong");
+        context.Measure("PingPong/SpscQueue", [&] { DoNotOptimize(RunPingPong<SpscQueue<u64>>(PingPongCount)); }, PingPongCount);
+        context.Measure("PingPong/CircularQueue", [&] { DoNotOptimize(RunPingPong<CircularQueue<u64>>(PingPongCount)); }, PingPongCount);
+    }
+}
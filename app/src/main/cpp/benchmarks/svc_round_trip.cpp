@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <nce/guest.h>
+#include "benchmark.h"
+
+/**
+ * @brief Compares the round trip of svcGetSystemTick emitted inline as a counter read with the round trip through the per-SVC and main SVC trampolines that every other SVC takes
+ * @note The full path uses SaveCtx and LoadCtx from guest.S with the main SVC trampoline that NCE::PatchCode emits, only the handler is reduced to the SVC table lookup without any tracing or perf counters
+ */
+#if defined(__aarch64__)
+
+namespace skyline::bench {
+    static_assert(offsetof(nce::ThreadContext, hostTpidrEl0) == 0x2A0 && offsetof(nce::ThreadContext, hostSp) == 0x2A8, "The main SVC trampoline depends on the offsets of the host TLS and stack");
+
+    constexpr u16 GetSystemTickSvc{0x1E};
+
+    static void GetSystemTick(nce::ThreadContext &ctx) {
+        u64 tick;
+        asm volatile("MRS %0, CNTVCT_EL0" : "=r"(tick));
+        ctx.gpr.x0 = tick;
+    }
+
+    static constexpr std::array<void (*)(nce::ThreadContext &), 0x80> SvcTable{[] {
+        std::array<void (*)(nce::ThreadContext &), 0x80> table{};
+        table[GetSystemTickSvc] = GetSystemTick;
+        return table;
+    }()};
+
+    /**
+     * @brief The equivalent of NCE::SvcHandler, this is called by the main SVC trampoline on the host stack with the host TLS
+     */
+    extern "C" [[gnu::used]] void SkylineBenchSvcHandler(u16 svcId, nce::ThreadContext *ctx) {
+        auto svc{svcId < SvcTable.size() ? SvcTable[svcId] : nullptr};
+        if (svc) [[likely]]
+            svc(*ctx);
+    }
+
+    /* The main SVC trampoline as emitted by NCE::PatchCode except for the handler being called directly rather than through a register */
+    asm(R"(
+    .text
+    .balign 4
+    .global SkylineBenchMainSvcTrampoline
+    SkylineBenchMainSvcTrampoline:
+        STR LR, [SP, #8]
+        MRS X1, TPIDR_EL0
+        LDR X2, [X1, #0x2A0]
+        MSR TPIDR_EL0, X2
+        MOV X2, SP
+        LDR X3, [X1, #0x2A8]
+        MOV SP, X3
+        STP X1, X2, [SP, #-16]!
+        BL SkylineBenchSvcHandler
+        LDP X1, X2, [SP], #16
+        MSR TPIDR_EL0, X1
+        MOV SP, X2
+        LDR LR, [SP, #8]
+        RET
+    )");
+
+    /**
+     * @brief Calls svcGetSystemTick through the same sequence as a patched SVC instruction that isn't inlined
+     * @note TPIDR_EL0 is swapped to the ThreadContext and back around the call since no C++ code can run with it, this isn't done on a guest thread where it's always the ThreadContext
+     */
+    static u64 GetSystemTickFullPath(nce::ThreadContext &ctx) {
+        register u64 x0 asm("x0");
+        asm volatile(R"(
+            MSR TPIDR_EL0, %[context]
+            STR LR, [SP, #-16]!
+            BL SaveCtx
+            MOV W0, #0x1E
+            BL SkylineBenchMainSvcTrampoline
+            BL LoadCtx
+            LDR LR, [SP], #16
+            MSR TPIDR_EL0, %[hostTls]
+        )" : "=&r"(x0) : [context]"r"(&ctx), [hostTls]"r"(ctx.hostTpidrEl0) : "x1", "x2", "x3", "x4", "x5", "x6", "x7", "x8", "x9", "x10", "x11", "x12", "x13", "x14", "x15", "x16", "x17", "x30", "cc", "memory");
+        return x0;
+    }
+
+    /**
+     * @brief Reads the counter in the same way as the inline emission of svcGetSystemTick without rescaling
+     */
+    static u64 GetSystemTickInline() {
+        u64 tick;
+        asm volatile("MRS %0, CNTVCT_EL0" : "=r"(tick));
+        return tick;
+    }
+
+    SKYLINE_BENCHMARK(SvcRoundTrip) {
+        std::vector<u8> hostStack(64 * 1024);
+        nce::ThreadContext threadContext{};
+        asm volatile("MRS %0, TPIDR_EL0" : "=r"(threadContext.hostTpidrEl0));
+        threadContext.hostSp = util::AlignDown(hostStack.data() + hostStack.size(), 16);
+
+        u64 before{GetSystemTickInline()};
+        u64 fullPath{GetSystemTickFullPath(threadContext)};
+        context.Check(fullPath >= before && GetSystemTickInline() >= fullPath, "svcGetSystemTick through the full path returns the current tick");
+
+        context.Measure("GetSystemTick/Inline", [&] { DoNotOptimize(GetSystemTickInline()); });
+        context.Measure("GetSystemTick/FullPath", [&] { DoNotOptimize(GetSystemTickFullPath(threadContext)); });
+    }
+}
+
+#endif
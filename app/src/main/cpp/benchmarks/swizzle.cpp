@@ -0,0 +1,187 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <random>
+#include <gpu/texture/layout.h>
+#include "benchmark.h"
+
+/**
+ * @brief Compares the block-linear swizzling in gpu/texture/layout.cpp with the sector-by-sector implementation it replaced, the output of both is verified to be identical in both directions
+ */
+namespace skyline::bench {
+    using gpu::texture::Dimensions;
+
+    constexpr size_t SectorWidth{16}; //!< The width of a sector in bytes
+    constexpr size_t SectorHeight{2}; //!< The height of a sector in lines
+    constexpr size_t GobWidth{64}; //!< The width of a GOB in bytes
+    constexpr size_t GobHeight{8}; //!< The height of a GOB in lines
+    constexpr size_t SectorLinesInGob{(GobWidth / SectorWidth) * GobHeight}; //!< The number of lines of sectors inside a GOB
+
+    /**
+     * @brief The implementation of CopyBlockLinearInternal prior to whole GOBs being copied with specialized kernels, this copies every sector individually
+     */
+    template<bool BlockLinearToLinear>
+    void PreviousCopyBlockLinear(Dimensions dimensions,
+                                 size_t formatBlockWidth, size_t formatBlockHeight, size_t formatBpb,
+                                 size_t gobBlockHeight, size_t gobBlockDepth,
+                                 u8 *blockLinear, u8 *linear) {
+        size_t robWidthUnalignedBytes{util::DivideCeil<size_t>(dimensions.width, formatBlockWidth) * formatBpb};
+        size_t robWidthBytes{util::AlignUp(robWidthUnalignedBytes, GobWidth)};
+        size_t robWidthBlocks{robWidthUnalignedBytes / GobWidth};
+
+        size_t blockHeight{gobBlockHeight};
+        size_t robHeight{GobHeight * blockHeight};
+        size_t surfaceHeightLines{util::DivideCeil<size_t>(dimensions.height, formatBlockHeight)};
+        size_t surfaceHeightRobs{surfaceHeightLines / robHeight}; //!< The height of the surface in ROBs excluding padding ROBs
+
+        size_t blockDepth{std::min<size_t>(dimensions.depth, gobBlockDepth)};
+        size_t blockPaddingZ{SectorWidth * SectorHeight * blockHeight * (gobBlockDepth - blockDepth)};
+
+        bool hasPaddingBlock{robWidthUnalignedBytes != robWidthBytes};
+        size_t blockPaddingOffset{hasPaddingBlock ? (GobWidth - (robWidthBytes - robWidthUnalignedBytes)) : 0};
+
+        size_t robBytes{robWidthUnalignedBytes * robHeight};
+        size_t gobYOffset{robWidthUnalignedBytes * GobHeight};
+        size_t gobZOffset{robWidthUnalignedBytes * surfaceHeightLines};
+
+        u8 *sector{blockLinear};
+
+        auto deswizzleRob{[&](u8 *linearRob, auto isLastRob, size_t blockPaddingY = 0, size_t blockExtentY = 0) {
+            auto deswizzleBlock{[&](u8 *linearBlock, auto copySector) __attribute__((always_inline)) {
+                for (size_t gobZ{}; gobZ < blockDepth; gobZ++) { // Every Block contains `blockDepth` Z-axis GOBs (Slices)
+                    u8 *linearGob{linearBlock};
+                    for (size_t gobY{}; gobY < blockHeight; gobY++) { // Every Block contains `blockHeight` Y-axis GOBs
+                        #pragma clang loop unroll_count(SectorLinesInGob)
+                        for (size_t index{}; index < SectorLinesInGob; index++) {
+                            size_t xT{((index << 3) & 0b10000) | ((index << 1) & 0b100000)}; // Morton-Swizzle on the X-axis
+                            size_t yT{((index >> 1) & 0b110) | (index & 0b1)}; // Morton-Swizzle on the Y-axis
+
+                            if constexpr (!isLastRob) {
+                                copySector(linearGob + (yT * robWidthUnalignedBytes) + xT, xT);
+                            } else {
+                                if (gobY != blockHeight - 1 || yT < blockExtentY)
+                                    copySector(linearGob + (yT * robWidthUnalignedBytes) + xT, xT);
+                                else
+                                    sector += SectorWidth;
+                            }
+                        }
+
+                        linearGob += gobYOffset; // Increment the linear GOB to the next Y-axis GOB
+                    }
+
+                    linearBlock += gobZOffset; // Increment the linear block to the next Z-axis GOB
+                }
+
+                sector += blockPaddingZ; // Skip over any padding Z-axis GOBs
+            }};
+
+            for (size_t block{}; block < robWidthBlocks; block++) { // Every ROB contains `surfaceWidthBlocks` blocks (excl. padding block)
+                deswizzleBlock(linearRob, [&](u8 *linearSector, size_t) __attribute__((always_inline)) {
+                    if constexpr (BlockLinearToLinear)
+                        std::memcpy(linearSector, sector, SectorWidth);
+                    else
+                        std::memcpy(sector, linearSector, SectorWidth);
+                    sector += SectorWidth; // `sectorWidth` bytes are of sequential image data
+                });
+
+                if constexpr (isLastRob)
+                    sector += blockPaddingY; // Skip over any padding at the end of this block
+                linearRob += GobWidth; // Increment the linear block to the next block (As Block Width = 1 GOB Width)
+            }
+
+            if (hasPaddingBlock)
+                deswizzleBlock(linearRob, [&](u8 *linearSector, size_t xT) __attribute__((always_inline)) {
+                    #pragma clang loop unroll_count(4)
+                    for (size_t pixelOffset{}; pixelOffset < SectorWidth; pixelOffset += formatBpb) {
+                        if (xT < blockPaddingOffset)
+                            if constexpr (BlockLinearToLinear)
+                                std::memcpy(linearSector + pixelOffset, sector, formatBpb);
+                            else
+                                std::memcpy(sector, linearSector + pixelOffset, formatBpb);
+
+                        sector += formatBpb;
+                        xT += formatBpb;
+                    }
+                });
+        }};
+
+        u8 *linearRob{linear};
+        for (size_t rob{}; rob < surfaceHeightRobs; rob++) { // Every Surface contains `surfaceHeightRobs` ROBs (excl. padding ROB)
+            deswizzleRob(linearRob, std::false_type{});
+            linearRob += robBytes; // Increment the linear ROB to the next ROB
+        }
+
+        if (surfaceHeightLines % robHeight != 0) {
+            blockHeight = (util::AlignUp(surfaceHeightLines, GobHeight) - (surfaceHeightRobs * robHeight)) / GobHeight; // Calculate the amount of Y GOBs which aren't padding
+
+            size_t alignedSurfaceLines{util::DivideCeil<size_t>(dimensions.height, formatBlockHeight)};
+            deswizzleRob(
+                linearRob,
+                std::true_type{},
+                (gobBlockHeight - blockHeight) * (SectorWidth * SectorWidth * SectorHeight), // Calculate padding at the end of a block to skip
+                util::IsAligned(alignedSurfaceLines, GobHeight) ? GobHeight : alignedSurfaceLines - util::AlignDown(alignedSurfaceLines, GobHeight) // Calculate the line relative to the start of the last GOB that is the cut-off point for the image
+            );
+        }
+    }
+
+    /**
+     * @brief A surface configuration that's swizzled by the benchmark
+     */
+    struct SwizzleSurface {
+        std::string_view name;
+        Dimensions dimensions;
+        size_t formatBlockWidth, formatBlockHeight, formatBpb;
+        size_t gobBlockHeight, gobBlockDepth;
+    };
+
+    SKYLINE_BENCHMARK(BlockLinearSwizzle) {
+        // These cover common streamed textures and render targets alongside surfaces with padding blocks, partial ROBs and depth
+        constexpr std::array<SwizzleSurface, 6> surfaces{{
+            {"RGBA8_1024x1024", Dimensions{1024, 1024}, 1, 1, 4, 16, 1},
+            {"RGBA8_1920x1080", Dimensions{1920, 1080}, 1, 1, 4, 16, 1},
+            {"RGBA16F_1280x720", Dimensions{1280, 720}, 1, 1, 8, 8, 1},
+            {"R8_1000x600", Dimensions{1000, 600}, 1, 1, 1, 8, 1},
+            {"BC1_2048x2048", Dimensions{2048, 2048}, 4, 4, 8, 16, 1},
+            {"RGBA8_64x64x32", Dimensions{64, 64, 32}, 1, 1, 4, 2, 4},
+        }};
+
+        std::mt19937_64 random{0};
+        for (const auto &surface : surfaces) {
+            auto &dimensions{surface.dimensions};
+            size_t blockLinearSize{gpu::texture::GetBlockLinearLayerSize(dimensions, surface.formatBlockWidth, surface.formatBlockHeight, surface.formatBpb, surface.gobBlockHeight, surface.gobBlockDepth)};
+            size_t linearSize{util::DivideCeil<size_t>(dimensions.width, surface.formatBlockWidth) * surface.formatBpb * util::DivideCeil<size_t>(dimensions.height, surface.formatBlockHeight) * dimensions.depth};
+
+            std::vector<u8> blockLinear(blockLinearSize), linear(linearSize), previousBlockLinear(blockLinearSize), previousLinear(linearSize);
+            std::generate(blockLinear.begin(), blockLinear.end(), [&] { return static_cast<u8>(random()); });
+
+            auto copyToLinear{[&](u8 *output) {
+                gpu::texture::CopyBlockLinearToLinear(dimensions, surface.formatBlockWidth, surface.formatBlockHeight, surface.formatBpb, surface.gobBlockHeight, surface.gobBlockDepth, blockLinear.data(), output);
+            }};
+            auto previousCopyToLinear{[&](u8 *output) {
+                PreviousCopyBlockLinear<true>(dimensions, surface.formatBlockWidth, surface.formatBlockHeight, surface.formatBpb, surface.gobBlockHeight, surface.gobBlockDepth, blockLinear.data(), output);
+            }};
+            copyToLinear(linear.data());
+            previousCopyToLinear(previousLinear.data());
+            context.Check(linear == previousLinear, fmt::format("{} is deswizzled identically to the previous implementation", surface.name));
+
+            // Any padding in the block-linear surface isn't written when swizzling, both outputs start out zeroed so they should match exactly
+            auto copyToBlockLinear{[&](u8 *output) {
+                gpu::texture::CopyLinearToBlockLinear(dimensions, surface.formatBlockWidth, surface.formatBlockHeight, surface.formatBpb, surface.gobBlockHeight, surface.gobBlockDepth, linear.data(), output);
+            }};
+            auto previousCopyToBlockLinear{[&](u8 *output) {
+                PreviousCopyBlockLinear<false>(dimensions, surface.formatBlockWidth, surface.formatBlockHeight, surface.formatBpb, surface.gobBlockHeight, surface.gobBlockDepth, output, linear.data());
+            }};
+            std::fill(blockLinear.begin(), blockLinear.end(), 0);
+            copyToBlockLinear(blockLinear.data());
+            previousCopyToBlockLinear(previousBlockLinear.data());
+            context.Check(blockLinear == previousBlockLinear, fmt::format("{} is swizzled identically to the previous implementation", surface.name));
+
+            // Throughput is reported in terms of the unpadded linear data which is what's uploaded to or read back from the host
+            size_t pixels{static_cast<size_t>(dimensions.width) * dimensions.height * dimensions.depth};
+            context.Measure(fmt::format("{}/Deswizzle", surface.name), [&] { copyToLinear(linear.data()); DoNotOptimize(linear); }, pixels, linearSize);
+            context.Measure(fmt::format("{}/PreviousDeswizzle", surface.name), [&] { previousCopyToLinear(linear.data()); DoNotOptimize(linear); }, pixels, linearSize);
+            context.Measure(fmt::format("{}/Swizzle", surface.name), [&] { copyToBlockLinear(blockLinear.data()); DoNotOptimize(blockLinear); }, pixels, linearSize);
+            context.Measure(fmt::format("{}/PreviousSwizzle", surface.name), [&] { previousCopyToBlockLinear(blockLinear.data()); DoNotOptimize(blockLinear); }, pixels, linearSize);
+        }
+    }
+}
@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <map>
+#include <random>
+#include <common.h>
+#include "benchmark.h"
+
+/**
+ * @brief Compares the single multimap of KProcess sync waiters behind a process-wide mutex with the sharded table of wait buckets that replaced it
+ * @note Threads are reduced to their priority, every operation is a wait on a key followed by a signal of a single waiter on it which is the pattern of a contended guest mutex or condition variable without any of the scheduling
+ */
+namespace skyline::bench {
+    struct WaiterThread : std::enable_shared_from_this<WaiterThread> {
+        i8 priority;
+        std::atomic<u64> wakeCount{}; //!< The amount of times the thread was woken, a signal on a shared key can wake a waiter of another host thread which may be waiting on another key at the same time
+
+        WaiterThread(i8 priority) : priority{priority} {}
+    };
+
+    /**
+     * @brief The sync waiters of KProcess prior to sharding, all waiters are in a multimap ordered by key then priority behind a single mutex
+     */
+    class MultimapSyncWaiters {
+      private:
+        using SyncWaiters = std::multimap<void *, std::shared_ptr<WaiterThread>>;
+        std::mutex syncWaiterMutex;
+        SyncWaiters syncWaiters;
+
+      public:
+        void Wait(void *key, const std::shared_ptr<WaiterThread> &thread) {
+            std::scoped_lock lock{syncWaiterMutex};
+            auto queue{syncWaiters.equal_range(key)};
+            syncWaiters.insert(std::upper_bound(queue.first, queue.second, thread->priority, [](const i8 priority, const SyncWaiters::value_type &it) { return it.second->priority > priority; }), {key, thread});
+        }
+
+        void Signal(void *key, i32 amount) {
+            std::scoped_lock lock{syncWaiterMutex};
+            auto queue{syncWaiters.equal_range(key)};
+
+            i32 waiterCount{amount};
+            for (auto it{queue.first}; it != queue.second && (amount <= 0 || waiterCount); it = syncWaiters.erase(it), waiterCount--) {
+                std::shared_ptr<WaiterThread> thread{it->second}; // A reference to the thread was passed to the scheduler
+                thread->wakeCount.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    /**
+     * @brief The sync waiters of KProcess now, waiters are sharded across buckets by their key with every bucket having its own mutex
+     */
+    class ShardedSyncWaiters {
+      private:
+        struct SyncWaiter {
+            void *key;
+            WaiterThread *thread;
+        };
+
+        struct SyncWaiterBucket {
+            std::mutex mutex;
+            std::vector<SyncWaiter> waiters;
+
+            void Insert(void *key, WaiterThread *thread) {
+                i8 priority{thread->priority};
+                auto it{std::find_if(waiters.begin(), waiters.end(), [&](const SyncWaiter &waiter) { return waiter.key == key && waiter.thread->priority > priority; })};
+                waiters.insert(it, SyncWaiter{key, thread});
+            }
+
+            bool Signal(void *key, i32 amount, const std::function<void(WaiterThread *)> &function) {
+                i32 waiterCount{amount};
+                bool remaining{};
+                std::erase_if(waiters, [&](const SyncWaiter &waiter) {
+                    if (waiter.key != key)
+                        return false;
+
+                    if (amount > 0 && !waiterCount) {
+                        remaining = true;
+                        return false;
+                    }
+
+                    function(waiter.thread);
+                    waiterCount--;
+                    return true;
+                });
+                return !remaining;
+            }
+        };
+
+        static constexpr size_t SyncWaiterBucketCount{64};
+        std::array<SyncWaiterBucket, SyncWaiterBucketCount> syncWaiters;
+
+        SyncWaiterBucket &GetSyncWaiterBucket(void *key) {
+            auto address{reinterpret_cast<uintptr_t>(key) >> 2};
+            return syncWaiters[(address ^ (address >> 6) ^ (address >> 12)) & (SyncWaiterBucketCount - 1)];
+        }
+
+      public:
+        void Wait(void *key, const std::shared_ptr<WaiterThread> &thread) {
+            auto &bucket{GetSyncWaiterBucket(key)};
+            std::scoped_lock lock{bucket.mutex};
+            bucket.Insert(key, thread.get());
+        }
+
+        void Signal(void *key, i32 amount) {
+            auto &bucket{GetSyncWaiterBucket(key)};
+            std::scoped_lock lock{bucket.mutex};
+            bucket.Signal(key, amount, [](WaiterThread *thread) {
+                std::shared_ptr<WaiterThread> reference{thread->shared_from_this()}; // A reference to the thread is only taken when it's passed to the scheduler
+                reference->wakeCount.fetch_add(1, std::memory_order_relaxed);
+            });
+        }
+    };
+
+    /**
+     * @brief Runs wait and signal pairs on the supplied amount of host threads concurrently
+     * @param keys The keys that are waited on, threads pick them at random
+     * @param sharedKeys If all threads use all keys, otherwise the keys are partitioned between the threads so there's no contention on the same key
+     * @return The total amount of times threads were woken, this should match the amount of operations
+     */
+    template<typename SyncWaiters>
+    static u64 RunSyncWaiters(SyncWaiters &syncWaiters, span<u32> keys, size_t threadCount, size_t operationsPerThread, bool sharedKeys) {
+        std::vector<std::shared_ptr<WaiterThread>> waiters;
+        for (size_t index{}; index < threadCount; index++)
+            waiters.push_back(std::make_shared<WaiterThread>(static_cast<i8>(0x2C + (index % 4)))); // Guest threads are commonly spread across a handful of priorities around the default one
+
+        std::vector<std::thread> threads;
+        for (size_t index{}; index < threadCount; index++) {
+            threads.emplace_back([&, index] {
+                auto threadKeys{sharedKeys ? keys : keys.subspan(index * (keys.size() / threadCount), keys.size() / threadCount)};
+                std::mt19937 random{static_cast<u32>(index)};
+                std::uniform_int_distribution<size_t> keyDistribution{0, threadKeys.size() - 1};
+                for (size_t operation{}; operation < operationsPerThread; operation++) {
+                    auto key{&threadKeys[keyDistribution(random)]};
+                    syncWaiters.Wait(key, waiters[index]);
+                    syncWaiters.Signal(key, 1);
+                }
+            });
+        }
+        for (auto &thread : threads)
+            thread.join();
+
+        u64 wakeCount{};
+        for (const auto &waiter : waiters)
+            wakeCount += waiter->wakeCount;
+        return wakeCount;
+    }
+
+    SKYLINE_BENCHMARK(SyncWaiters) {
+        constexpr size_t KeyCount{64}, OperationsPerThread{1 << 14};
+        std::vector<u32> keys(KeyCount); // Keys are adjacent words as guest mutexes and condition variables are commonly packed together in structures
+
+        for (size_t threadCount : {1, 2, 4, 8}) {
+            for (bool sharedKeys : {true, false}) {
+                auto variant{fmt::format("{}Threads/{}", threadCount, sharedKeys ? "SharedKeys" : "DisjointKeys")};
+                size_t operations{threadCount * OperationsPerThread};
+
+                MultimapSyncWaiters multimap;
+                ShardedSyncWaiters sharded;
+                context.Check(RunSyncWaiters(multimap, keys, threadCount, OperationsPerThread, sharedKeys) == operations, fmt::format("{}: every wait on the multimap is signalled", variant));
+                context.Check(RunSyncWaiters(sharded, keys, threadCount, OperationsPerThread, sharedKeys) == operations, fmt::format("{}: every wait on the sharded table is signalled", variant));
+
+                context.Measure(fmt::format("{}/Multimap", variant), [&] { DoNotOptimize(RunSyncWaiters(multimap, keys, threadCount, OperationsPerThread, sharedKeys)); }, operations);
+                context.Measure(fmt::format("{}/Sharded", variant), [&] { DoNotOptimize(RunSyncWaiters(sharded, keys, threadCount, OperationsPerThread, sharedKeys)); }, operations);
+            }
+        }
+    }
+}
@@ -0,0 +1,217 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <map>
+#include <random>
+#include <common/segment_table.h>
+#include "benchmark.h"
+
+/**
+ * @brief Compares the sorted vector that TextureManager used to index texture mappings with the ordered map and page table that it uses now
+ * @note Both indices replay the same recorded workload: a fixed set of render targets that are looked up every frame alongside streaming textures which are created, sampled and evicted in FIFO order
+ */
+namespace skyline::bench {
+    struct Texture {
+        u32 id;
+        span<u8> mapping; //!< Textures in the workload only have a single mapping, this is the common case and all lookups start at the first mapping regardless
+    };
+
+    struct TextureMapping : span<u8> {
+        Texture *texture;
+
+        TextureMapping(Texture *texture) : span<u8>{texture->mapping}, texture{texture} {}
+    };
+
+    /**
+     * @brief The index TextureManager used prior to the page table, a vector of mappings sorted by their base address
+     */
+    class SortedVectorIndex {
+      private:
+        std::vector<TextureMapping> textures;
+
+      public:
+        void Insert(Texture *texture) {
+            auto mapping{texture->mapping};
+            textures.emplace(std::upper_bound(textures.begin(), textures.end(), mapping.data(), [](u8 *address, const TextureMapping &it) { return address < it.data(); }), texture);
+        }
+
+        void Remove(Texture *texture) {
+            auto mapping{texture->mapping};
+            auto it{std::lower_bound(textures.begin(), textures.end(), mapping.data(), [](const TextureMapping &it, u8 *address) { return it.data() < address; })};
+            while (it->texture != texture)
+                it++;
+            textures.erase(it);
+        }
+
+        Texture *Find(span<u8> guestMapping) {
+            auto mappingEnd{std::upper_bound(textures.begin(), textures.end(), guestMapping.data(), [](u8 *address, const TextureMapping &it) { return address < it.data(); })}, hostMapping{mappingEnd};
+            while (hostMapping != textures.begin() && (--hostMapping)->end() > guestMapping.begin())
+                if (hostMapping->contains(guestMapping) && hostMapping->data() == guestMapping.data())
+                    return hostMapping->texture;
+            return nullptr;
+        }
+    };
+
+    /**
+     * @brief The index TextureManager uses now, an ordered map of mappings with a page table of the most recently created texture starting in each page
+     */
+    class PageTableIndex {
+      private:
+        std::multimap<u8 *, TextureMapping> textures;
+        size_t largestMappingSize{};
+        SegmentTable<Texture *, constant::AddressSpaceSize, constant::PageSizeBits, 19> textureTable;
+
+      public:
+        void Insert(Texture *texture) {
+            auto mapping{texture->mapping};
+            textures.emplace(mapping.data(), texture);
+            largestMappingSize = std::max(largestMappingSize, mapping.size());
+
+            auto firstPage{util::AlignDown(mapping.data(), constant::PageSize)};
+            textureTable.Set(firstPage, firstPage + constant::PageSize, texture);
+        }
+
+        void Remove(Texture *texture) {
+            auto mapping{texture->mapping};
+            auto [begin, end]{textures.equal_range(mapping.data())};
+            for (auto it{begin}; it != end; it++) {
+                if (it->second.texture == texture) {
+                    textures.erase(it);
+                    break;
+                }
+            }
+
+            auto firstPage{util::AlignDown(mapping.data(), constant::PageSize)};
+            if (textureTable[firstPage] == texture)
+                textureTable.Set(firstPage, firstPage + constant::PageSize, nullptr);
+        }
+
+        Texture *Find(span<u8> guestMapping) {
+            if (auto lookupTexture{textureTable[guestMapping.data()]}; lookupTexture && lookupTexture->mapping.data() == guestMapping.data() && lookupTexture->mapping.size() >= guestMapping.size())
+                return lookupTexture;
+
+            for (auto hostMapping{textures.upper_bound(guestMapping.data())}; hostMapping != textures.begin() && static_cast<size_t>(guestMapping.data() - (--hostMapping)->first) < largestMappingSize;)
+                if (hostMapping->second.contains(guestMapping) && hostMapping->first == guestMapping.data())
+                    return hostMapping->second.texture;
+            return nullptr;
+        }
+    };
+
+    /**
+     * @brief A single operation on the texture index in the recorded workload
+     */
+    struct TextureOperation {
+        enum class Type : u8 {
+            Insert,
+            Remove,
+            Find,
+        } type;
+        u32 texture; //!< The index of the texture that's inserted or removed, this is unused for lookups
+        span<u8> mapping; //!< The mapping that's looked up, this is unused for insertions and removals
+    };
+
+    struct TextureWorkload {
+        std::vector<Texture> textures;
+        std::vector<TextureOperation> operations;
+        size_t lookupCount{};
+    };
+
+    /**
+     * @brief Records a deterministic workload of texture index operations, the textures aren't backed by memory as only their addresses are used
+     */
+    static TextureWorkload RecordTextureWorkload() {
+        constexpr size_t RenderTargetCount{64}, RenderTargetSize{8 * 1024 * 1024};
+        constexpr size_t FrameCount{256}, StreamedPerFrame{32}, ResidentStreamedCount{4096}, SampledPerFrame{512}, SubresourceLookupsPerFrame{64};
+        constexpr size_t MinimumStreamedSize{64 * 1024}, MaximumStreamedSize{2 * 1024 * 1024};
+        auto base{reinterpret_cast<u8 *>(1ULL << 36)}; //!< The base of the guest address range that textures are placed in, this is within the address space covered by the page table
+
+        TextureWorkload workload;
+        workload.textures.reserve(RenderTargetCount + FrameCount * StreamedPerFrame);
+        std::mt19937_64 random{0};
+
+        for (size_t index{}; index < RenderTargetCount; index++) {
+            workload.textures.push_back(Texture{static_cast<u32>(index), span<u8>{base + (index * RenderTargetSize), RenderTargetSize}});
+            workload.operations.push_back(TextureOperation{TextureOperation::Type::Insert, static_cast<u32>(index)});
+        }
+
+        // Streamed textures are bump allocated after the render targets in page-aligned increments, in the same way as a guest's texture heap
+        u8 *streamedCursor{base + (RenderTargetCount * RenderTargetSize)};
+        size_t firstResident{RenderTargetCount};
+        for (size_t frame{}; frame < FrameCount; frame++) {
+            for (size_t index{}; index < StreamedPerFrame; index++) {
+                size_t size{util::AlignUp(std::uniform_int_distribution<size_t>{MinimumStreamedSize, MaximumStreamedSize}(random), constant::PageSize)};
+                auto id{static_cast<u32>(workload.textures.size())};
+                workload.textures.push_back(Texture{id, span<u8>{streamedCursor, size}});
+                workload.operations.push_back(TextureOperation{TextureOperation::Type::Insert, id});
+                streamedCursor += size;
+
+                if (workload.textures.size() - firstResident > ResidentStreamedCount)
+                    workload.operations.push_back(TextureOperation{TextureOperation::Type::Remove, static_cast<u32>(firstResident++)});
+            }
+
+            // Render targets are bound several times a frame while streamed textures are sampled at random, a few lookups are of subresources inside a texture which can't be perfect matches
+            for (size_t pass{}; pass < 4; pass++)
+                for (size_t index{}; index < RenderTargetCount; index++)
+                    workload.operations.push_back(TextureOperation{TextureOperation::Type::Find, 0, workload.textures[index].mapping});
+
+            std::uniform_int_distribution<size_t> residentDistribution{firstResident, workload.textures.size() - 1};
+            for (size_t index{}; index < SampledPerFrame; index++)
+                workload.operations.push_back(TextureOperation{TextureOperation::Type::Find, 0, workload.textures[residentDistribution(random)].mapping});
+
+            for (size_t index{}; index < SubresourceLookupsPerFrame; index++) {
+                auto mapping{workload.textures[residentDistribution(random)].mapping};
+                workload.operations.push_back(TextureOperation{TextureOperation::Type::Find, 0, mapping.subspan(mapping.size() / 2)});
+            }
+        }
+
+        // All textures are removed at the end so the index is empty again for the next replay of the workload
+        for (size_t index{}; index < RenderTargetCount; index++)
+            workload.operations.push_back(TextureOperation{TextureOperation::Type::Remove, static_cast<u32>(index)});
+        for (size_t index{firstResident}; index < workload.textures.size(); index++)
+            workload.operations.push_back(TextureOperation{TextureOperation::Type::Remove, static_cast<u32>(index)});
+
+        workload.lookupCount = static_cast<size_t>(std::count_if(workload.operations.begin(), workload.operations.end(), [](const TextureOperation &operation) { return operation.type == TextureOperation::Type::Find; }));
+        return workload;
+    }
+
+    /**
+     * @brief Replays the workload on an empty index, the index is left empty afterwards
+     * @return A checksum of the IDs of the textures found by every lookup, this verifies that the indices return the same results
+     */
+    template<typename Index>
+    static u64 ReplayTextureWorkload(Index &index, TextureWorkload &workload) {
+        u64 checksum{};
+        for (const auto &operation : workload.operations) {
+            switch (operation.type) {
+                case TextureOperation::Type::Insert:
+                    index.Insert(&workload.textures[operation.texture]);
+                    break;
+
+                case TextureOperation::Type::Remove:
+                    index.Remove(&workload.textures[operation.texture]);
+                    break;
+
+                case TextureOperation::Type::Find: {
+                    auto texture{index.Find(operation.mapping)};
+                    checksum = (checksum * 31) + (texture ? texture->id + 1 : 0);
+                    break;
+                }
+            }
+        }
+        return checksum;
+    }
+
+    SKYLINE_BENCHMARK(TextureMappings) {
+        auto workload{RecordTextureWorkload()};
+        context.Report("operations", static_cast<double>(workload.operations.size()), "per replay");
+        context.Report("lookups", static_cast<double>(workload.lookupCount), "per replay");
+        // The indices are reused across replays so the page table is already populated in later ones, as it would be in TextureManager after the first few frames
+        SortedVectorIndex sortedVector;
+        auto pageTable{std::make_unique<PageTableIndex>()};
+        context.Check(ReplayTextureWorkload(sortedVector, workload) == ReplayTextureWorkload(*pageTable, workload), "Both indices find the same textures");
+
+        // Items are operations on the index, the throughput of both can be compared directly as they replay the same workload
+        context.Measure("SortedVector", [&] { DoNotOptimize(ReplayTextureWorkload(sortedVector, workload)); }, workload.operations.size());
+        context.Measure("PageTable", [&] { DoNotOptimize(ReplayTextureWorkload(*pageTable, workload)); }, workload.operations.size());
+    }
+}
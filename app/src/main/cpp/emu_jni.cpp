@@ -2,6 +2,7 @@
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
 #include <csignal>
+#include <future>
 #include <pthread.h>
 #include <android/asset_manager_jni.h>
 #include <sys/system_properties.h>
@@ -9,7 +10,11 @@
 #include "skyline/common/language.h"
 #include "skyline/common/signal.h"
 #include "skyline/common/android_settings.h"
+#include "skyline/common/perf_stats.h"
+#include "skyline/common/benchmark.h"
 #include "skyline/common/trace.h"
+#include "skyline/common/thread_role.h"
+#include "skyline/common/emulation_speed.h"
 #include "skyline/loader/loader.h"
 #include "skyline/vfs/android_asset_filesystem.h"
 #include "skyline/os.h"
@@ -22,6 +27,8 @@
 jint Fps; //!< An approximation of the amount of frames being submitted every second
 jfloat AverageFrametimeMs; //!< The average time it takes for a frame to be rendered and presented in milliseconds
 jfloat AverageFrametimeDeviationMs; //!< The average deviation of the average frametimes in milliseconds
+jint ExecutorSlotCount; //!< The amount of slots the GPU command executor is currently using
+std::shared_ptr<skyline::BenchmarkRunner> Benchmark; //!< The benchmark that's being run, this only exists when emulation was started in benchmark mode
 
 std::weak_ptr<skyline::kernel::OS> OsWeak;
 std::weak_ptr<skyline::gpu::GPU> GpuWeak;
@@ -29,6 +36,9 @@ std::weak_ptr<skyline::audio::Audio> AudioWeak;
 std::weak_ptr<skyline::input::Input> InputWeak;
 std::weak_ptr<skyline::Settings> SettingsWeak;
 
+std::mutex PendingSurfaceMutex; //!< Synchronizes accesses to PendingSurface and the assignment of GpuWeak
+jobject PendingSurface{}; //!< A global reference to a surface that was supplied while the GPU was still being created, it's applied once the GPU is available
+
 // https://cs.android.com/android/platform/superproject/+/master:bionic/libc/tzcode/bionic.cpp;l=43;drc=master;bpv=1;bpt=1
 static std::string GetTimeZoneName() {
     const char *nameEnv = getenv("TZ");
@@ -75,13 +85,17 @@ extern "C" JNIEXPORT void Java_emu_skyline_EmulationActivity_executeApplication(
     jstring publicAppFilesPathJstring,
     jstring privateAppFilesPathJstring,
     jstring nativeLibraryPathJstring,
-    jobject assetManager
+    jobject assetManager,
+    jint benchmarkFrames
 ) {
     skyline::signal::ScopedStackBlocker stackBlocker; // We do not want anything to unwind past JNI code as there are invalid stack frames which can lead to a segmentation fault
     Fps = 0;
     AverageFrametimeMs = AverageFrametimeDeviationMs = 0.0f;
+    ExecutorSlotCount = 0;
+    skyline::PerfStats::Reset();
 
     pthread_setname_np(pthread_self(), "EmuMain");
+    skyline::Logger::SetContext(&skyline::Logger::EmulationContext); // The ROM may have been parsed on this thread beforehand to look up its title profile
 
     auto jvmManager{std::make_shared<skyline::JvmManager>(env, instance)};
 
@@ -90,6 +104,16 @@ extern "C" JNIEXPORT void Java_emu_skyline_EmulationActivity_executeApplication(
     skyline::JniString publicAppFilesPath(env, publicAppFilesPathJstring);
     skyline::Logger::EmulationContext.Initialize(publicAppFilesPath + "logs/emulation.sklog");
 
+    skyline::thread_role::Configure(*settings->hostThreadPlacement, *settings->bigCoreOverride);
+    skyline::emulation_speed::Configure(*settings->emulationSpeed, *settings->fastForwardSpeed);
+
+    if (benchmarkFrames > 0)
+        Benchmark = std::make_shared<skyline::BenchmarkRunner>(publicAppFilesPath + "benchmarks/", static_cast<skyline::u32>(benchmarkFrames), [] {
+            // The process is killed in the same way as stopEmulation, which makes executeApplication return and the activity finish
+            if (auto os{OsWeak.lock()}; os && os->state.process)
+                os->state.process->Kill(false, false, true);
+        });
+
     auto start{std::chrono::steady_clock::now()};
 
     // Initialize tracing
@@ -102,6 +126,12 @@ extern "C" JNIEXPORT void Java_emu_skyline_EmulationActivity_executeApplication(
         skyline::JniString nativeLibraryPath(env, nativeLibraryPathJstring);
         skyline::JniString privateAppFilesPath{env, privateAppFilesPathJstring};
 
+        // The ROM is parsed while the OS is being constructed as neither depends on the other
+        auto loader{std::async(std::launch::async, [romFd, romType, keysPath{privateAppFilesPath + "keys/"}, verifyRomIntegrity{*settings->verifyRomIntegrity}] {
+            pthread_setname_np(pthread_self(), "Sky-RomLoad");
+            return skyline::kernel::OS::CreateLoader(romFd, static_cast<skyline::loader::RomFormat>(romType), keysPath, verifyRomIntegrity);
+        })};
+
         auto os{std::make_shared<skyline::kernel::OS>(
             jvmManager,
             settings,
@@ -112,7 +142,8 @@ extern "C" JNIEXPORT void Java_emu_skyline_EmulationActivity_executeApplication(
             std::make_shared<skyline::vfs::AndroidAssetFileSystem>(AAssetManager_fromJava(env, assetManager))
         )};
         OsWeak = os;
-        GpuWeak = os->state.gpu;
+        if (Benchmark)
+            Benchmark->MarkPhase("os_created");
         AudioWeak = os->state.audio;
         InputWeak = os->state.input;
         SettingsWeak = settings;
@@ -120,7 +151,26 @@ extern "C" JNIEXPORT void Java_emu_skyline_EmulationActivity_executeApplication(
 
         skyline::Logger::DebugNoPrefix("Launching ROM {}", skyline::JniString(env, romUriJstring));
 
-        os->Execute(romFd, static_cast<skyline::loader::RomFormat>(romType));
+        os->Load(loader.get());
+        if (Benchmark) {
+            Benchmark->MarkPhase("process_loaded");
+
+            auto &nacp{os->state.loader->nacp};
+            Benchmark->SetTitle(os->state.process->npdm.aci0.programId,
+                                nacp ? nacp->GetApplicationName(skyline::language::ApplicationLanguage::AmericanEnglish) : std::string{},
+                                nacp ? nacp->GetApplicationVersion() : std::string{});
+        }
+
+        {
+            std::scoped_lock lock{PendingSurfaceMutex};
+            GpuWeak = os->state.gpu;
+            if (PendingSurface) {
+                os->state.gpu->presentation.UpdateSurface(PendingSurface);
+                env->DeleteGlobalRef(std::exchange(PendingSurface, nullptr));
+            }
+        }
+
+        os->Execute();
     } catch (std::exception &e) {
         skyline::Logger::ErrorNoPrefix("An uncaught exception has occurred: {}", e.what());
     } catch (const skyline::signal::SignalException &e) {
@@ -131,8 +181,15 @@ extern "C" JNIEXPORT void Java_emu_skyline_EmulationActivity_executeApplication(
 
     perfetto::TrackEvent::Flush();
 
+    Benchmark.reset();
     InputWeak.reset();
 
+    {
+        std::scoped_lock lock{PendingSurfaceMutex};
+        if (PendingSurface)
+            env->DeleteGlobalRef(std::exchange(PendingSurface, nullptr));
+    }
+
     auto end{std::chrono::steady_clock::now()};
     skyline::Logger::Write(skyline::Logger::LogLevel::Info, fmt::format("Emulation has ended in {}ms", std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()));
 
@@ -147,14 +204,112 @@ extern "C" JNIEXPORT jboolean Java_emu_skyline_EmulationActivity_stopEmulation(J
     auto process{os->state.process};
     if (!process)
         return false;
+    process->ResumeThreads(); // Any threads parked by suspendEmulation must be runnable for them to exit
     process->Kill(join, false, true);
     return true;
 }
 
-extern "C" JNIEXPORT jboolean Java_emu_skyline_EmulationActivity_setSurface(JNIEnv *, jobject, jobject surface) {
-    auto gpu{GpuWeak.lock()};
+extern "C" JNIEXPORT void Java_emu_skyline_EmulationActivity_suspendEmulation(JNIEnv *, jobject) {
+    auto os{OsWeak.lock()};
+    if (!os || !os->state.process)
+        return;
+
+    std::shared_ptr<skyline::gpu::GPU> gpu;
+    {
+        std::scoped_lock lock{PendingSurfaceMutex};
+        gpu = GpuWeak.lock();
+    }
     if (!gpu)
-        return false;
+        return; // The process is still being loaded
+
+    // The guest is parked first so it can't recreate any resources while they're being trimmed
+    os->state.process->SuspendThreads();
+    gpu->Trim();
+}
+
+extern "C" JNIEXPORT jlong Java_emu_skyline_EmulationActivity_trimMemory(JNIEnv *, jobject, jboolean complete) {
+    std::shared_ptr<skyline::gpu::GPU> gpu;
+    {
+        std::scoped_lock lock{PendingSurfaceMutex};
+        gpu = GpuWeak.lock();
+    }
+    if (!gpu)
+        return 0; // The process is still being loaded, nothing has been cached yet
+
+    return static_cast<jlong>(gpu->Trim(complete ? skyline::gpu::GPU::TrimLevel::Complete : skyline::gpu::GPU::TrimLevel::Reclaim));
+}
+
+extern "C" JNIEXPORT void Java_emu_skyline_EmulationActivity_resumeEmulation(JNIEnv *, jobject) {
+    auto os{OsWeak.lock()};
+    if (!os || !os->state.process)
+        return;
+
+    // Trimmed resources are recreated on demand, the ones used by the current frame are recreated first as they're the first to be used
+    os->state.process->ResumeThreads();
+}
+
+/**
+ * @return The OS if the process has been loaded and can be snapshotted, nullptr otherwise
+ */
+static std::shared_ptr<skyline::kernel::OS> GetLoadedOs() {
+    auto os{OsWeak.lock()};
+    std::scoped_lock lock{PendingSurfaceMutex};
+    if (!os || GpuWeak.expired())
+        return nullptr; // The process is still being loaded, GpuWeak is only assigned after it has been
+    return os;
+}
+
+extern "C" JNIEXPORT jint Java_emu_skyline_EmulationActivity_saveState(JNIEnv *, jobject, jint slot) {
+    using Result = skyline::kernel::SaveStateManager::Result;
+    auto os{GetLoadedOs()};
+    if (!os)
+        return static_cast<jint>(Result::NotLoaded);
+
+    try {
+        return static_cast<jint>(os->saveStates->Save(static_cast<skyline::u32>(slot)));
+    } catch (const std::exception &e) {
+        skyline::Logger::Error("Failed to save state to slot {}: {}", slot, e.what());
+        return static_cast<jint>(Result::Error);
+    }
+}
+
+extern "C" JNIEXPORT jint Java_emu_skyline_EmulationActivity_loadState(JNIEnv *, jobject, jint slot) {
+    using Result = skyline::kernel::SaveStateManager::Result;
+    auto os{GetLoadedOs()};
+    if (!os)
+        return static_cast<jint>(Result::NotLoaded);
+
+    try {
+        return static_cast<jint>(os->saveStates->Load(static_cast<skyline::u32>(slot)));
+    } catch (const std::exception &e) {
+        skyline::Logger::Error("Failed to load state from slot {}: {}", slot, e.what());
+        return static_cast<jint>(Result::Error);
+    }
+}
+
+extern "C" JNIEXPORT jlong Java_emu_skyline_EmulationActivity_getSaveStatePauseTime(JNIEnv *, jobject) {
+    auto os{GetLoadedOs()};
+    return os ? os->saveStates->GetLastPauseTime() / skyline::constant::NsInMillisecond : 0;
+}
+
+extern "C" JNIEXPORT void Java_emu_skyline_EmulationActivity_setFastForward(JNIEnv *, jobject, jboolean enable) {
+    skyline::emulation_speed::SetFastForward(enable);
+}
+
+extern "C" JNIEXPORT jboolean Java_emu_skyline_EmulationActivity_setSurface(JNIEnv *env, jobject, jobject surface) {
+    std::scoped_lock lock{PendingSurfaceMutex};
+    auto gpu{GpuWeak.lock()};
+    if (!gpu) {
+        if (OsWeak.expired())
+            return false;
+
+        // The GPU is still being created, the surface is retained till it's available rather than blocking the UI thread
+        if (PendingSurface)
+            env->DeleteGlobalRef(std::exchange(PendingSurface, nullptr));
+        if (surface)
+            PendingSurface = env->NewGlobalRef(surface);
+        return true;
+    }
     gpu->presentation.UpdateSurface(surface);
     return true;
 }
@@ -187,6 +342,75 @@ extern "C" JNIEXPORT void Java_emu_skyline_EmulationActivity_updatePerformanceSt
     if (!averageFrametimeDeviationField)
         averageFrametimeDeviationField = env->GetFieldID(clazz, "averageFrametimeDeviation", "F");
     env->SetFloatField(thiz, averageFrametimeDeviationField, AverageFrametimeDeviationMs);
+
+    static jfieldID executorSlotCountField{};
+    if (!executorSlotCountField)
+        executorSlotCountField = env->GetFieldID(clazz, "executorSlotCount", "I");
+    env->SetIntField(thiz, executorSlotCountField, ExecutorSlotCount);
+
+    using PerfStats = skyline::PerfStats;
+    static jfieldID perfCountersField{};
+    if (!perfCountersField)
+        perfCountersField = env->GetFieldID(clazz, "perfCounters", "[J");
+    auto perfCounters{reinterpret_cast<jlongArray>(env->GetObjectField(thiz, perfCountersField))};
+    std::array<jlong, PerfStats::CounterCount> counterValues{};
+    for (size_t i{}; i < PerfStats::CounterCount; i++)
+        counterValues[i] = static_cast<jlong>(PerfStats::GetFrameValue(static_cast<PerfStats::Counter>(i)));
+    env->SetLongArrayRegion(perfCounters, 0, static_cast<jsize>(std::min<size_t>(counterValues.size(), static_cast<size_t>(env->GetArrayLength(perfCounters)))), counterValues.data());
+    env->DeleteLocalRef(perfCounters);
+
+    constexpr std::array<const char *, PerfStats::HistogramCount> histogramFieldNames{"fenceWaitHistogram", "audioFillHistogram", "audioCallbackHistogram", "inputLatencyHistogram", "drawCpuHistogram", "oversleepHistogram"}; // The order matches PerfStats::Histogram
+    static std::array<jfieldID, PerfStats::HistogramCount> histogramFields{};
+    for (size_t histogramIndex{}; histogramIndex < PerfStats::HistogramCount; histogramIndex++) {
+        auto &field{histogramFields[histogramIndex]};
+        if (!field)
+            field = env->GetFieldID(clazz, histogramFieldNames[histogramIndex], "[J");
+        auto histogram{reinterpret_cast<jlongArray>(env->GetObjectField(thiz, field))};
+        std::array<jlong, PerfStats::HistogramBucketCount> bucketValues{};
+        for (size_t i{}; i < PerfStats::HistogramBucketCount; i++)
+            bucketValues[i] = static_cast<jlong>(PerfStats::GetHistogramBucket(static_cast<PerfStats::Histogram>(histogramIndex), i));
+        env->SetLongArrayRegion(histogram, 0, static_cast<jsize>(std::min<size_t>(bucketValues.size(), static_cast<size_t>(env->GetArrayLength(histogram)))), bucketValues.data());
+        env->DeleteLocalRef(histogram);
+    }
+
+    std::shared_ptr<skyline::gpu::GPU> gpu;
+    {
+        std::scoped_lock lock{PendingSurfaceMutex};
+        gpu = GpuWeak.lock();
+    }
+    if (!gpu)
+        return;
+
+    static jfieldID memoryPoolStatsField{};
+    if (!memoryPoolStatsField)
+        memoryPoolStatsField = env->GetFieldID(clazz, "memoryPoolStats", "[J");
+    auto memoryPoolStats{reinterpret_cast<jlongArray>(env->GetObjectField(thiz, memoryPoolStatsField))};
+    std::array<jlong, skyline::gpu::memory::ResourceClassCount * 2> poolValues{};
+    auto poolStatistics{gpu->memory.GetPoolStatistics()};
+    for (size_t i{}; i < poolStatistics.size(); i++) {
+        poolValues[i * 2] = static_cast<jlong>(poolStatistics[i].blockBytes);
+        poolValues[(i * 2) + 1] = static_cast<jlong>(poolStatistics[i].allocationBytes);
+    }
+    env->SetLongArrayRegion(memoryPoolStats, 0, static_cast<jsize>(std::min<size_t>(poolValues.size(), static_cast<size_t>(env->GetArrayLength(memoryPoolStats)))), poolValues.data());
+    env->DeleteLocalRef(memoryPoolStats);
+}
+
+extern "C" JNIEXPORT jstring Java_emu_skyline_EmulationActivity_getThreadStatistics(JNIEnv *env, jobject) {
+    auto os{OsWeak.lock()};
+    if (!os || !os->state.process)
+        return env->NewStringUTF("");
+
+    auto statistics{os->state.process->GetThreadStatistics()};
+    skyline::Logger::InfoNoPrefix("Guest thread statistics:\n{}", statistics);
+    return env->NewStringUTF(statistics.c_str());
+}
+
+extern "C" JNIEXPORT jstring Java_emu_skyline_EmulationActivity_getGuestProfile(JNIEnv *env, jobject) {
+    auto os{OsWeak.lock()};
+    if (!os || !os->state.process || !os->state.process->profiler)
+        return env->NewStringUTF("");
+
+    return env->NewStringUTF(os->state.process->profiler->GetReport().c_str());
 }
 
 extern "C" JNIEXPORT void JNICALL Java_emu_skyline_EmulationActivity_setController(JNIEnv *, jobject, jint index, jint type, jint partnerIndex) {
@@ -203,18 +427,14 @@ extern "C" JNIEXPORT void JNICALL Java_emu_skyline_EmulationActivity_setButtonSt
     auto input{InputWeak.lock()};
     if (!input)
         return; // We don't mind if we miss button updates while input hasn't been initialized
-    auto device{input->npad.controllers[static_cast<size_t>(index)].device};
-    if (device)
-        device->SetButtonState(skyline::input::NpadButton{.raw = static_cast<skyline::u64>(mask)}, pressed);
+    input->npad.QueueButtonState(static_cast<size_t>(index), skyline::input::NpadButton{.raw = static_cast<skyline::u64>(mask)}, pressed);
 }
 
 extern "C" JNIEXPORT void JNICALL Java_emu_skyline_EmulationActivity_setAxisValue(JNIEnv *, jobject, jint index, jint axis, jint value) {
     auto input{InputWeak.lock()};
     if (!input)
         return; // We don't mind if we miss axis updates while input hasn't been initialized
-    auto device{input->npad.controllers[static_cast<size_t>(index)].device};
-    if (device)
-        device->SetAxisValue(static_cast<skyline::input::NpadAxisId>(axis), value);
+    input->npad.QueueAxisValue(static_cast<size_t>(index), static_cast<skyline::input::NpadAxisId>(axis), value);
 }
 
 extern "C" JNIEXPORT void JNICALL Java_emu_skyline_EmulationActivity_setTouchState(JNIEnv *env, jobject, jintArray pointsJni) {
@@ -227,7 +447,7 @@ extern "C" JNIEXPORT void JNICALL Java_emu_skyline_EmulationActivity_setTouchSta
 
     skyline::span<Point> points(reinterpret_cast<Point *>(env->GetIntArrayElements(pointsJni, &isCopy)),
                                 static_cast<size_t>(env->GetArrayLength(pointsJni)) / (sizeof(Point) / sizeof(jint)));
-    input->touch.SetState(points);
+    input->touch.QueueState(points);
     env->ReleaseIntArrayElements(pointsJni, reinterpret_cast<jint *>(points.data()), JNI_ABORT);
 }
 
@@ -1,10 +1,18 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <common/perf_stats.h>
+#include <common/settings.h>
+#include <common/thread_role.h>
+#include <common/emulation_speed.h>
+#include <audio/mixer.h>
 #include "audio.h"
 
 namespace skyline::audio {
-    Audio::Audio(const DeviceState &state) : oboe::AudioStreamCallback() {
+    Audio::Audio(const DeviceState &state) : oboe::AudioStreamCallback(), publishedTracks{new TrackList{}}, timeStretch{*state.settings->audioTimeStretch || emulation_speed::IsEnabled()} {
         builder.setChannelCount(constant::StereoChannelCount);
         builder.setSampleRate(constant::SampleRate);
         builder.setFormat(constant::PcmFormat);
@@ -13,12 +21,62 @@ namespace skyline::audio {
         builder.setSharingMode(oboe::SharingMode::Exclusive);
         builder.setPerformanceMode(oboe::PerformanceMode::LowLatency);
 
+        releaseThread = std::thread(&Audio::ReleaseThread, this);
+
         builder.openManagedStream(outputStream);
         outputStream->requestStart();
     }
 
     Audio::~Audio() {
         outputStream->requestStop();
+
+        releaseRunning.store(false, std::memory_order_seq_cst);
+        releaseSequence.fetch_add(1, std::memory_order_seq_cst);
+        syscall(SYS_futex, reinterpret_cast<u32 *>(&releaseSequence), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+        releaseThread.join();
+
+        delete publishedTracks.load(std::memory_order_relaxed);
+    }
+
+    void Audio::PublishTracks() {
+        auto retired{publishedTracks.exchange(new TrackList{audioTracks}, std::memory_order_seq_cst)};
+
+        // The callback either observes the new snapshot or has already set the flag prior to loading the retired one, it only reads snapshots for a single callback so this is a short wait
+        while (callbackActive.load(std::memory_order_seq_cst))
+            std::this_thread::yield();
+
+        delete retired;
+    }
+
+    void Audio::ReleaseThread() {
+        if (int result{pthread_setname_np(pthread_self(), "Sky-AudioRelease")})
+            Logger::Warn("Failed to set the thread name: {}", strerror(result));
+        thread_role::Apply(thread_role::Role::Audio);
+
+        u32 sequence{releaseSequence.load(std::memory_order_acquire)};
+        while (releaseRunning.load(std::memory_order_acquire)) {
+            TrackList tracks;
+            {
+                std::scoped_lock trackGuard{trackLock};
+                tracks = audioTracks;
+            }
+
+            for (auto &track : tracks) {
+                try {
+                    std::scoped_lock bufferGuard{track->bufferLock};
+                    track->CheckReleasedBuffers();
+                } catch (const std::exception &e) {
+                    Logger::Error("Failed to release audio buffers: {}", e.what());
+                }
+            }
+            tracks.clear(); // Tracks may be closed while the thread is waiting, they shouldn't be kept alive till the next wakeup
+
+            releaseWaiting.store(true, std::memory_order_seq_cst);
+            while (releaseSequence.load(std::memory_order_seq_cst) == sequence)
+                syscall(SYS_futex, reinterpret_cast<u32 *>(&releaseSequence), FUTEX_WAIT_PRIVATE, sequence, nullptr, nullptr, 0); // Spurious wakeups (EINTR) and value mismatches (EAGAIN) are handled by rechecking the sequence
+            releaseWaiting.store(false, std::memory_order_relaxed);
+            sequence = releaseSequence.load(std::memory_order_acquire);
+        }
     }
 
     std::shared_ptr<AudioTrack> Audio::OpenTrack(u8 channelCount, u32 sampleRate, const std::function<void()> &releaseCallback) {
@@ -26,6 +84,7 @@ namespace skyline::audio {
 
         auto track{std::make_shared<AudioTrack>(channelCount, sampleRate, releaseCallback)};
         audioTracks.push_back(track);
+        PublishTracks();
 
         return track;
     }
@@ -34,40 +93,111 @@ namespace skyline::audio {
         std::scoped_lock trackGuard{trackLock};
 
         audioTracks.erase(std::remove(audioTracks.begin(), audioTracks.end(), track), audioTracks.end());
+        PublishTracks();
     }
 
-    oboe::DataCallbackResult Audio::onAudioReady(oboe::AudioStream *audioStream, void *audioData, int32_t numFrames) {
-        auto destBuffer{static_cast<i16 *>(audioData)};
-        auto streamSamples{static_cast<size_t>(numFrames) * static_cast<size_t>(audioStream->getChannelCount())};
-        size_t writtenSamples{};
+    void Audio::TuneBufferSize(oboe::AudioStream *audioStream, bool underrun) {
+        auto now{util::GetTimeNs()};
+        auto xRunCount{audioStream->getXRunCount()}; // This is unimplemented on OpenSL ES, only track underruns are used in that case
 
-        {
-            std::scoped_lock trackGuard{trackLock};
+        if (audioStream != tunedStream) {
+            tunedStream = audioStream;
+            lastXRunCount = xRunCount ? xRunCount.value() : 0;
+            lastBufferResizeTime = lastUnderrunTime = now;
+        }
+
+        if (xRunCount) {
+            if (i32 xRuns{xRunCount.value() - lastXRunCount}; xRuns > 0) {
+                PerfStats::Increment(PerfStats::Counter::AudioXRuns, static_cast<u64>(xRuns));
+                underrun = true;
+            }
+            lastXRunCount = xRunCount.value();
+        }
 
-            for (auto &track : audioTracks) {
-                if (track->playbackState == AudioOutState::Stopped)
-                    continue;
+        i32 burstSize{audioStream->getFramesPerBurst()}, bufferSize{audioStream->getBufferSizeInFrames()};
+        if (underrun) {
+            lastUnderrunTime = now;
+            if (now - lastBufferResizeTime >= BufferGrowIntervalNs && bufferSize + burstSize <= audioStream->getBufferCapacityInFrames()) {
+                audioStream->setBufferSizeInFrames(bufferSize + burstSize);
+                lastBufferResizeTime = now;
+            }
+        } else if (now - lastUnderrunTime >= BufferShrinkIntervalNs && now - lastBufferResizeTime >= BufferShrinkIntervalNs && bufferSize - burstSize >= burstSize * MinBufferBursts) {
+            audioStream->setBufferSizeInFrames(bufferSize - burstSize);
+            lastBufferResizeTime = now;
+        }
+    }
 
-                std::scoped_lock bufferGuard{track->bufferLock};
+    oboe::DataCallbackResult Audio::onAudioReady(oboe::AudioStream *audioStream, void *audioData, int32_t numFrames) {
+        auto callbackStart{util::GetTimeNs()};
+        auto destBuffer{static_cast<i16 *>(audioData)};
+        auto channelCount{static_cast<size_t>(audioStream->getChannelCount())};
+        auto streamSamples{static_cast<size_t>(numFrames) * channelCount};
+        size_t writtenSamples{};
+        bool anyPlayed{}, underrun{};
+
+        callbackActive.store(true, std::memory_order_seq_cst);
+        for (auto &track : *publishedTracks.load(std::memory_order_seq_cst)) {
+            if (track->playbackState.load(std::memory_order_relaxed) == AudioOutState::Stopped)
+                continue;
+
+            auto bufferedSamples{track->samples.Size()};
+            PerfStats::Record(PerfStats::Histogram::AudioFill, bufferedSamples / channelCount);
+
+            // Samples are mixed into the destination up to the amount written by prior tracks and are copied beyond that
+            auto mixSamples{[&](span<i16> source, size_t offset) {
+                auto destination{destBuffer + offset};
+                size_t mixSize{std::min(source.size(), writtenSamples > offset ? writtenSamples - offset : 0)};
+                MixSaturate(span(destination, mixSize), source.first(mixSize));
+                std::memcpy(destination + mixSize, source.data() + mixSize, (source.size() - mixSize) * sizeof(i16));
+            }};
+
+            size_t trackSamples, consumedSamples;
+            if (timeStretch) {
+                track->stretcher.UpdateTempo(bufferedSamples, callbackStart);
+                std::tie(trackSamples, consumedSamples) = track->stretcher.Read(track->samples, streamSamples, mixSamples);
+            } else {
+                trackSamples = consumedSamples = track->samples.Read(streamSamples, mixSamples);
+            }
 
-                auto trackSamples{track->samples.Read(span(destBuffer, streamSamples), [](i16 *source, i16 *destination) {
-                    *destination = Saturate<i16, i32>(static_cast<u32>(*destination) + static_cast<u32>(*source));
-                }, static_cast<ssize_t>(writtenSamples))};
+            writtenSamples = std::max(trackSamples, writtenSamples);
 
-                writtenSamples = std::max(trackSamples, writtenSamples);
+            if (consumedSamples) {
+                track->sampleCounter.fetch_add(consumedSamples, std::memory_order_release);
+                anyPlayed = true;
+            }
 
-                track->sampleCounter += trackSamples;
-                track->CheckReleasedBuffers();
+            if (trackSamples) {
+                // A track that has no samples at all is idle rather than starved, only running out partway through is counted as an underrun
+                if (trackSamples < streamSamples) {
+                    PerfStats::Increment(PerfStats::Counter::AudioUnderruns);
+                    underrun = true;
+                }
             }
         }
+        callbackActive.store(false, std::memory_order_seq_cst);
 
         if (streamSamples > writtenSamples)
             memset(destBuffer + writtenSamples, 0, (streamSamples - writtenSamples) * sizeof(i16));
 
+        // The release thread is only woken when it's waiting, the wake itself never blocks
+        if (anyPlayed) {
+            releaseSequence.fetch_add(1, std::memory_order_seq_cst);
+            if (releaseWaiting.load(std::memory_order_seq_cst))
+                syscall(SYS_futex, reinterpret_cast<u32 *>(&releaseSequence), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+        }
+
+        TuneBufferSize(audioStream, underrun);
+
+        auto callbackDuration{util::GetTimeNs() - callbackStart};
+        PerfStats::Increment(PerfStats::Counter::AudioCallbacks);
+        PerfStats::Increment(PerfStats::Counter::AudioCallbackNs, static_cast<u64>(callbackDuration));
+        PerfStats::Record(PerfStats::Histogram::AudioCallback, static_cast<u64>(callbackDuration) / 1000);
+
         return oboe::DataCallbackResult::Continue;
     }
 
     void Audio::onErrorAfterClose(oboe::AudioStream *audioStream, oboe::Result error) {
+        tunedStream = nullptr; // The reopened stream may be allocated at the same address, the tuning state must be reset regardless
         builder.openManagedStream(outputStream);
         outputStream->requestStart();
     }
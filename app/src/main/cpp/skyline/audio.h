@@ -4,23 +4,65 @@
 #pragma once
 
 #include <audio/track.h>
+#include <audio/adpcm_decoder.h>
 
 namespace skyline::audio {
     /**
      * @brief The Audio class is used to mix audio from all tracks
+     * @note The Oboe callback runs on a real-time thread and never blocks, it reads from an immutable snapshot of the tracks and only notifies the release thread of any played samples
      */
     class Audio : public oboe::AudioStreamCallback {
       private:
+        using TrackList = std::vector<std::shared_ptr<AudioTrack>>;
+
         oboe::AudioStreamBuilder builder;
         oboe::ManagedStream outputStream;
-        std::vector<std::shared_ptr<AudioTrack>> audioTracks;
-        std::mutex trackLock; //!< Synchronizes modifications to the audio tracks
+        std::mutex trackLock; //!< Synchronizes modifications to the audio tracks, this is never locked by the audio callback
+        TrackList audioTracks; //!< All open audio tracks, this is only accessed with trackLock held
+        std::atomic<TrackList *> publishedTracks; //!< An immutable snapshot of audioTracks which is read by the audio callback, it's replaced with a new snapshot on every modification
+        std::atomic<bool> callbackActive{}; //!< If the audio callback is currently reading publishedTracks, a retired snapshot can only be freed while this is false
+
+        std::atomic<u32> releaseSequence{}; //!< Incremented by the audio callback whenever samples were played, this is the futex word of the release thread
+        std::atomic<bool> releaseWaiting{}; //!< If the release thread is waiting (or about to wait) on releaseSequence
+        std::atomic<bool> releaseRunning{true};
+        std::thread releaseThread; //!< A thread which releases played buffers and calls the release callbacks of tracks outside of the audio callback
+        bool timeStretch; //!< If tracks should be time-stretched to the rate at which the guest produces samples, this keeps audio continuous when emulation runs below full speed and is always enabled with speed control
+
+        static constexpr i32 MinBufferBursts{2}; //!< The minimum size of the stream buffer in bursts, this is double buffering
+        static constexpr i64 BufferGrowIntervalNs{100 * constant::NsInMillisecond}; //!< The minimum interval between growing the buffer, a single glitch often causes several consecutive underruns which shouldn't grow it repeatedly
+        static constexpr i64 BufferShrinkIntervalNs{10 * constant::NsInSecond}; //!< The amount of time without any underruns after which the buffer is shrunk by a burst
+
+        oboe::AudioStream *tunedStream{}; //!< The stream that the buffer size tuning state corresponds to, this is only accessed by the audio callback
+        i32 lastXRunCount{}; //!< The XRun count of the stream at the last audio callback
+        i64 lastBufferResizeTime{}; //!< The time at which the buffer size was last changed
+        i64 lastUnderrunTime{}; //!< The time at which an underrun last occurred
+
+        /**
+         * @brief Adjusts the size of the stream buffer to trade latency against underruns, it's grown by a burst on underruns and shrunk again after a period without any
+         * @param underrun If a playing track ran out of samples during this callback
+         * @note This must only be called from the audio callback
+         */
+        void TuneBufferSize(oboe::AudioStream *audioStream, bool underrun);
+
+        /**
+         * @brief Publishes a new snapshot of audioTracks to the audio callback and frees the previous one once the callback can no longer be reading it
+         * @note trackLock MUST be locked when calling this
+         */
+        void PublishTracks();
+
+        void ReleaseThread();
 
       public:
+        AdpcmCache adpcmCache; //!< A cache of decoded ADPCM buffers shared by all voices
+
         Audio(const DeviceState &state);
 
         ~Audio();
 
+        Audio(const Audio &) = delete;
+
+        Audio &operator=(const Audio &) = delete;
+
         void Pause() {
             outputStream->requestPause();
         }
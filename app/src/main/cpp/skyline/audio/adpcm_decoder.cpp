@@ -1,52 +1,101 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <common/trace.h>
 #include "common.h"
 #include "adpcm_decoder.h"
 
 namespace skyline::audio {
-    AdpcmDecoder::AdpcmDecoder(std::vector<std::array<i16, 2>> coefficients) : coefficients(std::move(coefficients)) {}
+    constexpr size_t BytesPerFrame{0x8};
+    constexpr size_t SamplesPerFrame{0xE};
 
-    std::vector<i16> AdpcmDecoder::Decode(span<u8> adpcmData) {
-        constexpr size_t BytesPerFrame{0x8};
-        constexpr size_t SamplesPerFrame{0xE};
+    /**
+     * @brief A table of every 4-bit nibble sign-extended to 32 bits, this avoids shifting every nibble into place twice
+     */
+    constexpr std::array<i32, 16> NibbleTable{0, 1, 2, 3, 4, 5, 6, 7, -8, -7, -6, -5, -4, -3, -2, -1};
 
-        size_t remainingSamples{(adpcmData.size() / BytesPerFrame) * SamplesPerFrame};
-
-        std::vector<i16> output;
-        output.reserve(remainingSamples);
-
-        size_t inputOffset{};
+    AdpcmDecoder::AdpcmDecoder(span<const std::array<i16, 2>> pCoefficients) {
+        std::copy_n(pCoefficients.begin(), std::min(pCoefficients.size(), CoefficientCount), coefficients.begin());
+    }
 
-        while (inputOffset < adpcmData.size()) {
-            FrameHeader header{adpcmData[inputOffset++]};
+    size_t AdpcmDecoder::GetDecodedSize(size_t adpcmSize) {
+        // Every frame has a header byte followed by up to 7 bytes of packed nibbles, a trailing partial frame only decodes the samples it contains
+        size_t size{(adpcmSize / BytesPerFrame) * SamplesPerFrame};
+        if (size_t remainder{adpcmSize % BytesPerFrame})
+            size += (remainder - 1) * 2;
+        return size;
+    }
 
-            size_t frameSamples{std::min(SamplesPerFrame, remainingSamples)};
+    void AdpcmDecoder::Decode(span<const u8> adpcmData, span<i16> output) {
+        size_t outputOffset{};
+        for (size_t inputOffset{}; inputOffset < adpcmData.size(); inputOffset += BytesPerFrame) {
+            FrameHeader header{adpcmData[inputOffset]};
+            auto frame{adpcmData.subspan(inputOffset + 1, std::min(BytesPerFrame, adpcmData.size() - inputOffset) - 1)};
 
-            i32 ctx{};
+            // The scaled residuals of the whole frame are unpacked upfront as only the prediction depends on prior samples
+            i32 scale{0x800 << header.scale};
+            std::array<i32, SamplesPerFrame> residuals;
+            for (size_t index{}; index < frame.size(); index++) {
+                residuals[index * 2] = NibbleTable[frame[index] >> 4] * scale;
+                residuals[(index * 2) + 1] = NibbleTable[frame[index] & 0xF] * scale;
+            }
 
+            auto [coefficient0, coefficient1]{coefficients[header.coefficientIndex]};
+            size_t frameSamples{frame.size() * 2};
             for (size_t index{}; index < frameSamples; index++) {
-                i32 sample{};
-
-                if (index & 1) {
-                    sample = (ctx << 28) >> 28;
-                } else {
-                    ctx = adpcmData[inputOffset++];
-                    sample = (ctx << 24) >> 28;
-                }
-
-                i32 prediction{history[0] * coefficients[header.coefficientIndex][0] + history[1] * coefficients[header.coefficientIndex][1]};
-                sample = (sample * (0x800 << header.scale) + prediction + 0x400) >> 11;
-
-                auto saturated{audio::Saturate<i16, i32>(sample)};
-                output.push_back(saturated);
+                i32 prediction{history[0] * coefficient0 + history[1] * coefficient1};
+                auto saturated{audio::Saturate<i16, i32>((residuals[index] + prediction + 0x400) >> 11)};
+                output[outputOffset++] = saturated;
                 history[1] = history[0];
                 history[0] = saturated;
             }
+        }
+    }
 
-            remainingSamples -= frameSamples;
+    u64 AdpcmDecoder::GetStateHash() const {
+        return XXH64(&history, sizeof(history), XXH64(&coefficients, sizeof(coefficients), 0));
+    }
+
+    void AdpcmCache::Decode(AdpcmDecoder &decoder, span<const u8> adpcmData, std::vector<i16> &output) {
+        Key key{
+            .address = adpcmData.data(),
+            .size = adpcmData.size(),
+            .contentHash = XXH64(adpcmData.data(), adpcmData.size(), 0),
+            .stateHash = decoder.GetStateHash(),
+        };
+
+        {
+            std::scoped_lock lock{mutex};
+            auto it{map.find(key)};
+            if (it != map.end()) {
+                entries.splice(entries.begin(), entries, it->second);
+                output.assign(it->second->samples.begin(), it->second->samples.end());
+                decoder.SetHistory(it->second->finalHistory);
+                return;
+            }
         }
 
-        return output;
+        TRACE_EVENT("host", "AdpcmCache::Decode", "size", adpcmData.size());
+        output.resize(AdpcmDecoder::GetDecodedSize(adpcmData.size()));
+        decoder.Decode(adpcmData, output);
+
+        size_t entrySize{output.size() * sizeof(i16)};
+        if (entrySize > MaxCacheSize / 4)
+            return; // Large buffers are likely to be streamed music which is rarely replayed, they would evict many sound effects
+
+        std::scoped_lock lock{mutex};
+        if (map.contains(key))
+            return; // Another thread may have decoded the same data in the meantime
+
+        entries.push_front(Entry{key, output, decoder.GetHistory()});
+        map.emplace(key, entries.begin());
+        cacheSize += entrySize;
+
+        while (cacheSize > MaxCacheSize) {
+            auto &entry{entries.back()};
+            cacheSize -= entry.samples.size() * sizeof(i16);
+            map.erase(entry.key);
+            entries.pop_back();
+        }
     }
 }
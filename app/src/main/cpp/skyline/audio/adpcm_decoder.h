@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <list>
 #include <common.h>
 
 namespace skyline::audio {
@@ -10,6 +11,11 @@ namespace skyline::audio {
      * @brief The AdpcmDecoder class handles decoding single channel ADPCM (Adaptive Differential Pulse-Code Modulation) data
      */
     class AdpcmDecoder {
+      public:
+        static constexpr size_t CoefficientCount{8}; //!< The amount of coefficient pairs that can be indexed by a frame header
+        using Coefficients = std::array<std::array<i16, 2>, CoefficientCount>;
+        using History = std::array<i32, 2>;
+
       private:
         union FrameHeader {
             u8 raw;
@@ -22,15 +28,74 @@ namespace skyline::audio {
         };
         static_assert(sizeof(FrameHeader) == 0x1);
 
-        std::array<i32, 2> history{}; //!< The previous samples for decoding the ADPCM stream
-        std::vector<std::array<i16, 2>> coefficients; //!< The coefficients for decoding the ADPCM stream
+        History history{}; //!< The previous samples for decoding the ADPCM stream
+        Coefficients coefficients{}; //!< The coefficients for decoding the ADPCM stream, any coefficients that weren't supplied are zero
 
       public:
-        AdpcmDecoder(std::vector<std::array<i16, 2>> coefficients);
+        /**
+         * @param coefficients The coefficients supplied by the guest, any beyond CoefficientCount are ignored
+         */
+        AdpcmDecoder(span<const std::array<i16, 2>> coefficients);
+
+        /**
+         * @return The amount of samples that decoding ADPCM data of the supplied size results in
+         */
+        static size_t GetDecodedSize(size_t adpcmSize);
 
         /**
          * @brief Decodes a buffer of ADPCM data into I16 PCM
+         * @param output The buffer to write the samples into, this must be exactly GetDecodedSize(adpcmData.size()) samples large
+         */
+        void Decode(span<const u8> adpcmData, span<i16> output);
+
+        const History &GetHistory() const {
+            return history;
+        }
+
+        void SetHistory(const History &pHistory) {
+            history = pHistory;
+        }
+
+        /**
+         * @return A hash of the decoder's state which fully determines the output for a given input
+         */
+        u64 GetStateHash() const;
+    };
+
+    /**
+     * @brief A cache of decoded ADPCM buffers, sound effects are commonly replayed and looped without their data changing so they don't need to be redecoded each time
+     * @note Entries are keyed on the address and size of the data alongside a hash of its contents and the decoder state, it's validated on every lookup so modified data is never returned
+     * @note The cache is bounded by the total size of decoded samples, the least recently used entries are evicted first
+     */
+    class AdpcmCache {
+      private:
+        static constexpr size_t MaxCacheSize{16 * 1024 * 1024}; //!< The maximum size of all cached samples in bytes
+
+        struct Key {
+            const u8 *address;
+            u64 size;
+            u64 contentHash; //!< A hash of the ADPCM data
+            u64 stateHash; //!< A hash of the decoder state prior to decoding
+
+            bool operator==(const Key &) const = default;
+        };
+
+        struct Entry {
+            Key key;
+            std::vector<i16> samples;
+            AdpcmDecoder::History finalHistory; //!< The history of the decoder after decoding the data
+        };
+
+        std::mutex mutex;
+        std::list<Entry> entries; //!< All cached entries ordered from the most to the least recently used
+        std::unordered_map<Key, std::list<Entry>::iterator, util::ObjectHash<Key>> map;
+        size_t cacheSize{}; //!< The total size of all cached samples in bytes
+
+      public:
+        /**
+         * @brief Decodes the ADPCM data into the output or copies it from the cache if identical data has already been decoded with an identical decoder state
+         * @note The decoder's state is updated in the same way as it would be by decoding the data
          */
-        std::vector<i16> Decode(span <u8> adpcmData);
+        void Decode(AdpcmDecoder &decoder, span<const u8> adpcmData, std::vector<i16> &output);
     };
 }
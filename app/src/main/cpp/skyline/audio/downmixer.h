@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <arm_neon.h>
 #include <common.h>
 #include "common.h"
 
@@ -29,22 +30,42 @@ namespace skyline::audio {
 
     /**
      * @brief Downmixes a buffer of 5.1 surround audio to stereo
+     * @note The coefficients are in Q15 fixed point which allows the NEON path to use widening multiply-accumulates and a rounding shift, both paths produce identical results
      */
     inline std::vector<StereoSample> DownMix(span<Surround51Sample> surroundSamples) {
-        constexpr i16 FixedPointMultiplier{1000}; //!< Avoids using floating point maths
-        constexpr i16 Attenuation3Db{707}; //! 10^(-3/20)
-        constexpr i16 Attenuation6Db{501}; //! 10^(-6/20)
-        constexpr i16 Attenuation12Db{251}; //! 10^(-6/20)
+        constexpr u8 FixedPointShift{15};
+        constexpr i16 Attenuation3Db{23170}; //!< 10^(-3/20) in Q15
+        constexpr i16 Attenuation6Db{16423}; //!< 10^(-6/20) in Q15
+        constexpr i16 Attenuation12Db{8231}; //!< 10^(-12/20) in Q15
+
+        std::vector<StereoSample> stereoSamples(surroundSamples.size());
+
+        // Every 5.1 sample is loaded as three 32-bit pairs of (FL, FR), (C, LFE) and (BL, BR), the downmixed pairs are then already in interleaved stereo order
+        constexpr size_t VectorSampleCount{4};
+        size_t vectorSize{surroundSamples.size() & ~(VectorSampleCount - 1)};
+        for (size_t i{}; i < vectorSize; i += VectorSampleCount) {
+            int32x4x3_t pairs{vld3q_s32(reinterpret_cast<const i32 *>(surroundSamples.data() + i))};
+            int16x8_t front{vreinterpretq_s16_s32(pairs.val[0])}, centreLfe{vreinterpretq_s16_s32(pairs.val[1])}, back{vreinterpretq_s16_s32(pairs.val[2])};
+            int16x8_t centre{vtrn1q_s16(centreLfe, centreLfe)}, lowFrequency{vtrn2q_s16(centreLfe, centreLfe)};
+
+            auto downmixHalf{[](int16x4_t front, int16x4_t centre, int16x4_t lowFrequency, int16x4_t back) {
+                int32x4_t sum{vmull_n_s16(centre, Attenuation3Db)};
+                sum = vmlal_n_s16(sum, lowFrequency, Attenuation12Db);
+                sum = vmlal_n_s16(sum, back, Attenuation6Db);
+                return vqmovn_s32(vaddw_s16(vrshrq_n_s32(sum, FixedPointShift), front));
+            }};
+
+            int16x8_t stereo{vcombine_s16(downmixHalf(vget_low_s16(front), vget_low_s16(centre), vget_low_s16(lowFrequency), vget_low_s16(back)),
+                                          downmixHalf(vget_high_s16(front), vget_high_s16(centre), vget_high_s16(lowFrequency), vget_high_s16(back)))};
+            vst1q_s16(reinterpret_cast<i16 *>(stereoSamples.data() + i), stereo);
+        }
 
         auto downmixChannel{[](i32 front, i32 centre, i32 lowFrequency, i32 back) {
-            return static_cast<i16>(front +
-                                    (centre * Attenuation3Db +
-                                     lowFrequency * Attenuation12Db +
-                                     back * Attenuation6Db) / FixedPointMultiplier);
+            i32 sum{centre * Attenuation3Db + lowFrequency * Attenuation12Db + back * Attenuation6Db};
+            return Saturate<i16, i32>(front + ((sum + (1 << (FixedPointShift - 1))) >> FixedPointShift));
         }};
 
-        std::vector<StereoSample> stereoSamples(surroundSamples.size());
-        for (size_t i{}; i < surroundSamples.size(); i++) {
+        for (size_t i{vectorSize}; i < surroundSamples.size(); i++) {
             auto &surroundSample = surroundSamples[i];
             auto &stereoSample = stereoSamples[i];
 
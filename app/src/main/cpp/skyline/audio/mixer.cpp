@@ -0,0 +1,49 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <arm_neon.h>
+#include "mixer.h"
+
+namespace skyline::audio {
+    constexpr size_t VectorSampleCount{8}; //!< The amount of 16-bit samples in a single NEON vector
+
+    void MixSaturate(span<i16> destination, span<const i16> source) {
+        size_t vectorSize{source.size() & ~(VectorSampleCount - 1)};
+        for (size_t i{}; i < vectorSize; i += VectorSampleCount)
+            vst1q_s16(destination.data() + i, vqaddq_s16(vld1q_s16(destination.data() + i), vld1q_s16(source.data() + i)));
+
+        for (size_t i{vectorSize}; i < source.size(); i++)
+            destination[i] = Saturate<i16, i32>(static_cast<i32>(destination[i]) + static_cast<i32>(source[i]));
+    }
+
+    void MixVolume(span<i16> destination, span<const i16> source, float volume, bool accumulate) {
+        // Samples are scaled in floating point and truncated towards zero to match the scalar path, the final narrowing saturates
+        auto scale{[volume = vdupq_n_f32(volume), accumulate](int16x4_t sample, int16x4_t existing) {
+            float32x4_t result{vmulq_f32(vcvtq_f32_s32(vmovl_s16(sample)), volume)};
+            if (accumulate)
+                result = vaddq_f32(result, vcvtq_f32_s32(vmovl_s16(existing)));
+            return vqmovn_s32(vcvtq_s32_f32(result));
+        }};
+
+        size_t vectorSize{source.size() & ~(VectorSampleCount - 1)};
+        for (size_t i{}; i < vectorSize; i += VectorSampleCount) {
+            int16x8_t sample{vld1q_s16(source.data() + i)};
+            int16x8_t existing{accumulate ? vld1q_s16(destination.data() + i) : vdupq_n_s16(0)};
+            vst1q_s16(destination.data() + i, vcombine_s16(scale(vget_low_s16(sample), vget_low_s16(existing)), scale(vget_high_s16(sample), vget_high_s16(existing))));
+        }
+
+        for (size_t i{vectorSize}; i < source.size(); i++)
+            destination[i] = Saturate<i16, i32>((accumulate ? destination[i] : 0) + (source[i] * volume));
+    }
+
+    void ExpandMonoToStereo(span<i16> destination, span<const i16> source) {
+        size_t vectorSize{source.size() & ~(VectorSampleCount - 1)};
+        for (size_t i{}; i < vectorSize; i += VectorSampleCount) {
+            int16x8_t sample{vld1q_s16(source.data() + i)};
+            vst2q_s16(destination.data() + (i * 2), int16x8x2_t{sample, sample});
+        }
+
+        for (size_t i{vectorSize}; i < source.size(); i++)
+            destination[i * 2] = destination[(i * 2) + 1] = source[i];
+    }
+}
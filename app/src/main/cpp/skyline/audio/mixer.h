@@ -0,0 +1,27 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include "common.h"
+
+namespace skyline::audio {
+    /**
+     * @brief Mixes the source samples into the destination samples with a saturating add
+     * @note The destination must be at least as large as the source
+     */
+    void MixSaturate(span<i16> destination, span<const i16> source);
+
+    /**
+     * @brief Scales the source samples by the volume and either writes or mixes them into the destination, the result is saturated
+     * @param accumulate If the scaled samples should be added to the destination rather than overwriting it
+     * @note The destination must be at least as large as the source
+     */
+    void MixVolume(span<i16> destination, span<const i16> source, float volume, bool accumulate);
+
+    /**
+     * @brief Expands mono samples into interleaved stereo samples by duplicating every sample into both channels
+     * @note The destination must be exactly twice as large as the source and must not overlap it
+     */
+    void ExpandMonoToStereo(span<i16> destination, span<const i16> source);
+}
@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <arm_neon.h>
 #include "common.h"
 #include "resampler.h"
 
@@ -119,40 +120,106 @@ namespace skyline::audio {
         {-42, 3751, 26253, 2811},   {-38, 3608, 26270, 2936},   {-34, 3467, 26281, 3064},   {-32, 3329, 26287, 3195}}};
     // @fmt:on
 
-    std::vector<i16> Resampler::ResampleBuffer(span<i16> inputBuffer, double ratio, u8 channelCount) {
+    u32 Resampler::GetStep(double ratio) {
         auto step{static_cast<u32>(ratio * 0x8000)};
-        auto outputSize{static_cast<size_t>(inputBuffer.size() / ratio)};
-        std::vector<i16> outputBuffer(outputSize);
+        if (!step)
+            throw exception("Invalid resampling ratio: {}", ratio);
+        return step;
+    }
+
+    void Resampler::Reset() {
+        position = HistoryFrameCount << 15;
+        history = {};
+    }
+
+    size_t Resampler::GetOutputSize(size_t inputSize, double ratio, u8 channelCount) const {
+        u64 end{static_cast<u64>(inputSize / channelCount) << 15}; // An output frame can be produced as long as all of its taps are within the history and the input
+        return (position < end) ? util::DivideCeil<u64>(end - position, GetStep(ratio)) * channelCount : 0;
+    }
+
+    /**
+     * @brief Applies the interpolation filter to four consecutive samples of a single channel
+     */
+    static i16 Interpolate(int16x4_t samples, int32x4_t coefficients) {
+        return Saturate<i16, i32>(vaddvq_s32(vmulq_s32(vmovl_s16(samples), coefficients)) >> 15);
+    }
+
+    /**
+     * @tparam ChannelCount The amount of channels if it's specialized for, mono and stereo frames are loaded with a single (deinterleaving) load while other channel counts are gathered per-channel
+     * @param edge The history followed by the first input frames, this is used for output frames with taps in the history
+     */
+    template<u8 ChannelCount>
+    static void ResampleFrames(span<const i16> input, span<const i16> edge, span<i16> output, u64 &position, u32 step, u8 channelCount, const std::array<LutEntry, 128> &lut, size_t historyFrameCount) {
+        for (size_t outIndex{}; outIndex < output.size(); outIndex += channelCount) {
+            size_t frame{static_cast<size_t>(position >> 15)};
+            int32x4_t coefficients{vld1q_s32(&lut[(position & 0x7FFF) >> 8].a)};
+            const i16 *taps{(frame < historyFrameCount) ? edge.data() + frame * channelCount : input.data() + (frame - historyFrameCount) * channelCount};
 
-        const std::array<LutEntry, 128> &lut = [step] {
+            if constexpr (ChannelCount == 1) {
+                output[outIndex] = Interpolate(vld1_s16(taps), coefficients);
+            } else if constexpr (ChannelCount == 2) {
+                int16x4x2_t samples{vld2_s16(taps)};
+                output[outIndex] = Interpolate(samples.val[0], coefficients);
+                output[outIndex + 1] = Interpolate(samples.val[1], coefficients);
+            } else {
+                for (u8 channel{}; channel < channelCount; channel++) {
+                    std::array<i16, 4> samples{taps[channel], taps[channelCount + channel], taps[(channelCount * 2) + channel], taps[(channelCount * 3) + channel]};
+                    output[outIndex + channel] = Interpolate(vld1_s16(samples.data()), coefficients);
+                }
+            }
+
+            position += step;
+        }
+    }
+
+    span<i16> Resampler::Resample(span<const i16> input, span<i16> output, double ratio, u8 channelCount) {
+        if (!channelCount || channelCount > MaxChannelCount)
+            throw exception("Unsupported resampling channel count: {}", channelCount);
+
+        auto step{GetStep(ratio)};
+        size_t inputFrames{input.size() / channelCount};
+        size_t outputSize{GetOutputSize(input.size(), ratio, channelCount)};
+        if (output.size() < outputSize)
+            throw exception("Resampler output buffer is too small: {} < {}", output.size(), outputSize);
+        output = output.first(outputSize);
+
+        const std::array<LutEntry, 128> &lut{[step]() -> const std::array<LutEntry, 128> & {
             if (step > 0xAAAA)
                 return CurveLut0;
             else if (step <= 0x8000)
                 return CurveLut1;
             else
                 return CurveLut2;
-        }();
-
-        for (size_t outIndex{}, inIndex{}; outIndex < outputSize; outIndex += channelCount) {
-            u32 lutIndex{fraction >> 8};
-
-            for (u8 channel{}; channel < channelCount; channel++) {
-                if (((inIndex + 3) * channelCount + channel) >= inputBuffer.size())
-                    continue;
+        }()};
 
-                i32 data{inputBuffer[(inIndex + 0) * channelCount + channel] * lut[lutIndex].a +
-                         inputBuffer[(inIndex + 1) * channelCount + channel] * lut[lutIndex].b +
-                         inputBuffer[(inIndex + 2) * channelCount + channel] * lut[lutIndex].c +
-                         inputBuffer[(inIndex + 3) * channelCount + channel] * lut[lutIndex].d};
+        size_t historySize{HistoryFrameCount * channelCount};
+        std::array<i16, HistoryFrameCount * MaxChannelCount * 2> edge{};
+        std::copy_n(history.begin(), historySize, edge.begin());
+        size_t edgeInputSize{std::min(historySize, inputFrames * channelCount)};
+        std::copy_n(input.begin(), edgeInputSize, edge.begin() + historySize);
 
-                outputBuffer[outIndex + channel] = Saturate<i16, i32>(data >> 15);
-            }
+        span<const i16> edgeSpan{edge.data(), historySize + edgeInputSize};
+        switch (channelCount) {
+            case 1:
+                ResampleFrames<1>(input, edgeSpan, output, position, step, channelCount, lut, HistoryFrameCount);
+                break;
+            case 2:
+                ResampleFrames<2>(input, edgeSpan, output, position, step, channelCount, lut, HistoryFrameCount);
+                break;
+            default:
+                ResampleFrames<0>(input, edgeSpan, output, position, step, channelCount, lut, HistoryFrameCount);
+                break;
+        }
 
-            u32 newOffset{fraction + step};
-            inIndex += newOffset >> 15;
-            fraction = newOffset & 0x7FFF;
+        // The last frames of the history followed by the input are retained for the next buffer
+        position -= static_cast<u64>(inputFrames) << 15;
+        if (inputFrames >= HistoryFrameCount) {
+            std::copy_n(input.begin() + (inputFrames - HistoryFrameCount) * channelCount, historySize, history.begin());
+        } else {
+            size_t combinedSize{historySize + inputFrames * channelCount};
+            std::copy_n(edge.begin() + (combinedSize - historySize), historySize, history.begin());
         }
 
-        return outputBuffer;
+        return output;
     }
 }
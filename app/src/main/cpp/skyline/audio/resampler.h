@@ -7,19 +7,44 @@
 
 namespace skyline::audio {
     /**
-     * @brief The Resampler class handles resampling audio PCM data
+     * @brief The Resampler class handles resampling a stream of audio PCM data
+     * @note The fractional position and the last input frames are kept between calls, consecutive buffers are resampled as a single continuous stream without any discontinuities at their boundaries
      */
     class Resampler {
+      public:
+        static constexpr u8 MaxChannelCount{6};
+
       private:
-        u32 fraction{}; //!< The fractional value used for storing the resamplers last frame
+        static constexpr size_t TapCount{4}; //!< The amount of input frames used to interpolate a single output frame
+        static constexpr size_t HistoryFrameCount{TapCount - 1}; //!< The amount of trailing input frames retained from the previous buffer
+
+        u64 position{HistoryFrameCount << 15}; //!< The Q15 position of the next output frame's first tap, relative to the first retained frame in history
+        std::array<i16, HistoryFrameCount * MaxChannelCount> history{}; //!< The last input frames of the previous buffer
+
+        /**
+         * @return The Q15 step between output frames for the supplied ratio
+         */
+        static u32 GetStep(double ratio);
 
       public:
         /**
-         * @brief Resamples the given sample buffer by the given ratio
-         * @param inputBuffer A buffer containing PCM sample data
+         * @brief Resets the stream state, this should be done when the input doesn't directly follow the previously resampled buffer
+         */
+        void Reset();
+
+        /**
+         * @return The exact amount of samples that will be written by Resample for an input buffer of the supplied size
+         */
+        size_t GetOutputSize(size_t inputSize, double ratio, u8 channelCount) const;
+
+        /**
+         * @brief Resamples the given sample buffer by the given ratio into the output buffer
+         * @param input A buffer containing interleaved PCM sample data, this must directly follow the previously resampled buffer
+         * @param output A buffer to write the resampled samples into, this must be at least as large as the size returned by GetOutputSize
          * @param ratio The conversion ratio needed
          * @param channelCount The amount of channels the buffer contains
+         * @return A span of the written samples in the output buffer
          */
-        std::vector<i16> ResampleBuffer(span <i16> inputBuffer, double ratio, u8 channelCount);
+        span<i16> Resample(span<const i16> input, span<i16> output, double ratio, u8 channelCount);
     };
 }
@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <arm_neon.h>
+#include <common/emulation_speed.h>
+#include "time_stretcher.h"
+
+namespace skyline::audio {
+    size_t TimeStretcher::FindBestOffset() {
+        constexpr size_t WindowSamples{OverlapFrames * ChannelCount};
+        static_assert(WindowSamples % 8 == 0);
+
+        for (size_t i{}; i < searchWindow.size(); i++)
+            searchWindow[i] = static_cast<float>(input[i]);
+
+        // The energy of each candidate is maintained incrementally as the window slides, it normalizes the correlation so louder regions aren't favoured
+        double energy{};
+        for (size_t i{}; i < WindowSamples; i++)
+            energy += static_cast<double>(searchWindow[i]) * searchWindow[i];
+
+        size_t bestOffset{};
+        double bestScore{-std::numeric_limits<double>::infinity()};
+        for (size_t offset{}; offset < SeekFrames; offset++) {
+            const float *candidate{searchWindow.data() + (offset * ChannelCount)};
+            float32x4_t sum0{vdupq_n_f32(0)}, sum1{vdupq_n_f32(0)};
+            for (size_t i{}; i < WindowSamples; i += 8) {
+                sum0 = vfmaq_f32(sum0, vld1q_f32(candidate + i), vld1q_f32(overlap.data() + i));
+                sum1 = vfmaq_f32(sum1, vld1q_f32(candidate + i + 4), vld1q_f32(overlap.data() + i + 4));
+            }
+            double correlation{vaddvq_f32(vaddq_f32(sum0, sum1))};
+
+            double score{correlation / std::sqrt(std::max(energy, 1.0))};
+            if (score > bestScore) {
+                bestScore = score;
+                bestOffset = offset;
+            }
+
+            for (size_t channel{}; channel < ChannelCount; channel++) {
+                double outgoing{candidate[channel]}, incoming{candidate[WindowSamples + channel]};
+                energy += (incoming * incoming) - (outgoing * outgoing);
+            }
+        }
+
+        return bestOffset;
+    }
+
+    void TimeStretcher::ProcessSequence() {
+        size_t offset{hasOverlap ? FindBestOffset() : 0};
+        const i16 *sequence{input.data() + (offset * ChannelCount)};
+
+        // The start of the sequence is crossfaded with the tail of the previous one, the rest is copied as-is
+        size_t outputIndex{};
+        if (hasOverlap) {
+            constexpr float Step{1.0f / OverlapFrames};
+            for (size_t frame{}; frame < OverlapFrames; frame++) {
+                float weight{static_cast<float>(frame) * Step};
+                for (size_t channel{}; channel < ChannelCount; channel++, outputIndex++) {
+                    float mixed{overlap[outputIndex] + ((static_cast<float>(sequence[outputIndex]) - overlap[outputIndex]) * weight)};
+                    output[outputIndex] = static_cast<i16>(std::clamp(mixed, static_cast<float>(std::numeric_limits<i16>::min()), static_cast<float>(std::numeric_limits<i16>::max())));
+                }
+            }
+        }
+        std::memcpy(output.data() + outputIndex, sequence + outputIndex, (output.size() - outputIndex) * sizeof(i16));
+
+        const i16 *tail{sequence + (StrideFrames * ChannelCount)};
+        for (size_t i{}; i < overlap.size(); i++)
+            overlap[i] = static_cast<float>(tail[i]);
+        hasOverlap = true;
+
+        outputOffset = 0;
+        outputSize = output.size();
+
+        // The nominal position advances by the stride scaled by the tempo, the tail of the input is moved to the start of the buffer
+        double skip{(tempo * StrideFrames) + skipFraction};
+        auto skipFrames{static_cast<size_t>(skip)};
+        skipFraction = skip - static_cast<double>(skipFrames);
+        skipFrames = std::min(skipFrames, inputFrames);
+
+        inputFrames -= skipFrames;
+        std::memmove(input.data(), input.data() + (skipFrames * ChannelCount), inputFrames * ChannelCount * sizeof(i16));
+    }
+
+    void TimeStretcher::UpdateTempo(size_t bufferedSamples, i64 timeNs) {
+        if (!windowStart) {
+            windowStart = timeNs;
+            windowBufferedSamples = bufferedSamples;
+            windowConsumedSamples = consumedSamples;
+            return;
+        }
+
+        i64 elapsed{timeNs - windowStart};
+        if (elapsed < TempoWindowNs)
+            return;
+
+        // The amount of produced samples is the change in buffered samples plus the amount that were consumed in the meantime
+        auto produced{static_cast<double>(bufferedSamples) - static_cast<double>(windowBufferedSamples) + static_cast<double>(consumedSamples - windowConsumedSamples)};
+        if (produced <= 0) {
+            measuredSpeed = 1.0; // The guest isn't producing any audio, this is silence rather than slowdown and shouldn't affect the tempo once audio resumes
+        } else {
+            double expected{static_cast<double>(elapsed) * constant::SampleRate * ChannelCount / constant::NsInSecond};
+            measuredSpeed += ((produced / expected) - measuredSpeed) * 0.25;
+        }
+
+        // A backlog of samples means that the guest has caught up, they're drained at the full tempo of the emulation speed rather than adding latency
+        double maxTempo{std::clamp(emulation_speed::GetFactor(), 1.0, MaxTempo)};
+        tempo = bufferedSamples > HighWaterSamples ? maxTempo : std::clamp(measuredSpeed, MinTempo, maxTempo);
+
+        windowStart = timeNs;
+        windowBufferedSamples = bufferedSamples;
+        windowConsumedSamples = consumedSamples;
+    }
+}
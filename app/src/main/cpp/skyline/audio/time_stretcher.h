@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common/circular_buffer.h>
+#include "common.h"
+
+namespace skyline::audio {
+    /**
+     * @brief A WSOLA (Waveform Similarity Overlap-Add) time stretcher for stereo audio, it changes the tempo of a stream without affecting its pitch
+     * @note This is used to keep audio continuous when emulation runs below full speed and to keep up with the guest when it's sped up, the tempo is derived from the rate at which the guest produces samples
+     * @note All state is in fixed-size arrays so this can be used from the real-time audio callback, it must only be used by a single thread
+     */
+    class TimeStretcher {
+      public:
+        static constexpr size_t SequenceFrames{960}; //!< The length of a single output sequence in frames including the overlapping region (20ms)
+        static constexpr size_t OverlapFrames{240}; //!< The length of the crossfade between consecutive sequences in frames (5ms)
+        static constexpr size_t SeekFrames{240}; //!< The range past the nominal position that's searched for the best matching sequence in frames (5ms)
+        static constexpr size_t StrideFrames{SequenceFrames - OverlapFrames}; //!< The amount of frames that are output for every sequence
+        static constexpr double MinTempo{0.5}; //!< The lowest tempo that audio will be slowed down to
+        static constexpr double MaxTempo{4.0}; //!< The highest tempo that audio will be sped up to, this corresponds to the highest emulation speed
+
+      private:
+        static constexpr size_t ChannelCount{constant::StereoChannelCount};
+        static constexpr size_t InputCapacityFrames{SeekFrames + SequenceFrames + (StrideFrames * static_cast<size_t>(MaxTempo))}; //!< The maximum amount of frames that are buffered as input, this covers a full sequence past the largest skip
+        static constexpr i64 TempoWindowNs{250 * constant::NsInMillisecond}; //!< The duration over which the rate of produced samples is measured
+        static constexpr size_t HighWaterSamples{constant::SampleRate * ChannelCount / 10}; //!< The amount of buffered samples (100ms) past which the track is considered to be caught up and audio is played at the full tempo of the emulation speed
+
+        std::array<i16, InputCapacityFrames * ChannelCount> input{}; //!< The input samples starting at the nominal position of the next sequence
+        size_t inputFrames{}; //!< The amount of valid frames in the input buffer
+        std::array<float, (SeekFrames + OverlapFrames) * ChannelCount> searchWindow{}; //!< The region of the input covered by the similarity search converted to floating point
+        std::array<float, OverlapFrames * ChannelCount> overlap{}; //!< The tail of the last sequence which the next sequence is crossfaded with
+        bool hasOverlap{}; //!< If the overlap buffer is valid, this is false for the first sequence
+        std::array<i16, StrideFrames * ChannelCount> output{}; //!< The output of the last sequence which hasn't been read yet
+        size_t outputOffset{}, outputSize{}; //!< The offset and size of the unread output in samples
+        double skipFraction{}; //!< The fractional part of the input position which is carried between sequences
+
+        double tempo{1.0}; //!< The rate at which input is consumed relative to output
+        double measuredSpeed{1.0}; //!< A smoothed measurement of the rate at which samples are produced relative to real-time
+        i64 windowStart{}; //!< The time at which the current measurement window started
+        size_t windowBufferedSamples{}; //!< The amount of samples buffered in the source at the start of the current measurement window
+        u64 windowConsumedSamples{}; //!< The value of consumedSamples at the start of the current measurement window
+        u64 consumedSamples{}; //!< The total amount of samples consumed from the source
+
+        /**
+         * @return The offset in frames from the nominal position at which the input is most similar to the overlap buffer
+         */
+        size_t FindBestOffset();
+
+        /**
+         * @brief Produces a single sequence of output from the input buffer and advances the input according to the tempo
+         */
+        void ProcessSequence();
+
+      public:
+        /**
+         * @brief Updates the tempo based on the rate at which samples were produced into the source since the last measurement
+         * @param bufferedSamples The amount of samples currently buffered in the source
+         * @param timeNs The current monotonic time in nanoseconds
+         */
+        void UpdateTempo(size_t bufferedSamples, i64 timeNs);
+
+        double GetTempo() const {
+            return tempo;
+        }
+
+        /**
+         * @brief Reads time-stretched samples into the supplied function
+         * @param source The buffer to consume input samples from
+         * @param maxSize The maximum amount of samples to output
+         * @param function A function that's called with a span of contiguous output samples and the offset of the span in the read data, this may be called multiple times
+         * @return The amount of samples that were output and the amount of samples that were consumed from the source
+         */
+        template<typename Function, size_t Size>
+        std::pair<size_t, size_t> Read(CircularBuffer<i16, Size> &source, size_t maxSize, Function function) {
+            size_t written{}, consumed{};
+            while (written < maxSize) {
+                if (outputOffset == outputSize) {
+                    // Sequences past 1x tempo skip more input than they cover, all of it must be buffered so the skip isn't truncated
+                    size_t requiredFrames{std::max(SeekFrames + SequenceFrames, static_cast<size_t>(tempo * StrideFrames) + 1)};
+                    if (inputFrames < requiredFrames) {
+                        size_t read{source.Read((InputCapacityFrames - inputFrames) * ChannelCount, [&](span<i16> samples, size_t offset) {
+                            std::memcpy(input.data() + (inputFrames * ChannelCount) + offset, samples.data(), samples.size_bytes());
+                        })};
+                        inputFrames += read / ChannelCount;
+                        consumed += read;
+
+                        if (inputFrames < requiredFrames)
+                            break;
+                    }
+
+                    ProcessSequence();
+                }
+
+                size_t size{std::min(outputSize - outputOffset, maxSize - written)};
+                function(span(output.data() + outputOffset, size), written);
+                outputOffset += size;
+                written += size;
+            }
+
+            consumedSamples += consumed;
+            return {written, consumed};
+        }
+    };
+}
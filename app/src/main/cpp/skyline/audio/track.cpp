@@ -59,27 +59,32 @@ namespace skyline::audio {
         std::scoped_lock lock(bufferLock);
 
         size_t size{(channelCount == constant::SurroundChannelCount) ? (buffer.size() / sizeof(Surround51Sample)) * sizeof(StereoSample) : buffer.size()};
-        BufferIdentifier identifier{
-            .released = false,
-            .tag = tag,
-            .finalSample = identifiers.empty() ? size : (size + identifiers.front().finalSample)
-        };
-
-        identifiers.push_front(identifier);
-
+        size_t appended;
         if (channelCount == constant::SurroundChannelCount) {
             auto stereoBuffer{DownMix(buffer.cast<Surround51Sample>())};
-            samples.Append(span(stereoBuffer).cast<i16>());
+            appended = samples.Append(span(stereoBuffer).cast<i16>());
         } else {
-            samples.Append(buffer);
+            appended = samples.Append(buffer);
         }
+
+        if (appended != size)
+            Logger::Warn("Dropped {} audio samples as the track buffer is full", size - appended);
+
+        // The final sample is based on the samples that were actually appended so buffers are still released if any samples were dropped
+        appendedSamples += appended;
+        identifiers.push_front(BufferIdentifier{
+            .tag = tag,
+            .finalSample = appendedSamples,
+            .released = false,
+        });
     }
 
     void AudioTrack::CheckReleasedBuffers() {
         bool anyReleased{};
+        u64 playedSamples{sampleCounter.load(std::memory_order_acquire)};
 
         for (auto &identifier : identifiers) {
-            if (identifier.finalSample <= sampleCounter && !identifier.released) {
+            if (identifier.finalSample <= playedSamples && !identifier.released) {
                 anyReleased = true;
                 identifier.released = true;
             }
@@ -7,6 +7,7 @@
 #include <kernel/types/KEvent.h>
 #include <common/circular_buffer.h>
 #include "common.h"
+#include "time_stretcher.h"
 
 namespace skyline::audio {
     /**
@@ -16,16 +17,18 @@ namespace skyline::audio {
       private:
         std::function<void()> releaseCallback; //!< Callback called when a buffer has been played
         std::deque<BufferIdentifier> identifiers; //!< Queue of all appended buffer identifiers
+        u64 appendedSamples{}; //!< The total amount of samples appended to the track, this is used to determine the final sample of every buffer
 
         u8 channelCount;
         u32 sampleRate;
 
       public:
-        CircularBuffer<i16, constant::SampleRate * constant::StereoChannelCount * 10> samples; //!< A circular buffer with all appended audio samples
-        std::mutex bufferLock; //!< Synchronizes appending to audio buffers
+        CircularBuffer<i16, constant::SampleRate * constant::StereoChannelCount * 10> samples; //!< A circular buffer with all appended audio samples, this is only read from by the audio callback
+        std::mutex bufferLock; //!< Synchronizes appending to audio buffers and all accesses to the buffer identifiers, this is never locked by the audio callback
 
-        AudioOutState playbackState{AudioOutState::Stopped}; //!< The current state of playback
-        u64 sampleCounter{}; //!< A counter used for tracking when buffers have been played and can be released
+        std::atomic<AudioOutState> playbackState{AudioOutState::Stopped}; //!< The current state of playback
+        std::atomic<u64> sampleCounter{}; //!< A counter of samples played by the audio callback used for tracking when buffers have been played and can be released
+        TimeStretcher stretcher; //!< The time stretcher used for this track when time stretching is enabled, this is only accessed by the audio callback
 
         /**
          * @param channelCount The amount channels that will be present in the track
@@ -70,6 +73,7 @@ namespace skyline::audio {
         /**
          * @brief Checks if any buffers have been released and calls the appropriate callback for them
          * @note bufferLock MUST be locked when calling this
+         * @note This must not be called from the audio callback as the release callback can block on guest kernel objects
          */
         void CheckReleasedBuffers();
     };
@@ -12,8 +12,13 @@
 namespace skyline {
     DeviceState::DeviceState(kernel::OS *os, std::shared_ptr<JvmManager> jvmManager, std::shared_ptr<Settings> settings)
         : os(os), jvm(std::move(jvmManager)), settings(std::move(settings)) {
+        // The GPU is created on a separate thread as creating the Vulkan instance and device is expensive and nothing depends on the GPU till the process is loaded
+        gpuCreation = std::async(std::launch::async, [this] {
+            pthread_setname_np(pthread_self(), "Sky-GpuInit");
+            return std::make_shared<gpu::GPU>(*this);
+        });
+
         // We assign these later as they use the state in their constructor and we don't want null pointers
-        gpu = std::make_shared<gpu::GPU>(*this);
         soc = std::make_shared<soc::SOC>(*this);
         audio = std::make_shared<audio::Audio>(*this);
         nce = std::make_shared<nce::NCE>(*this);
@@ -21,6 +26,11 @@ namespace skyline {
         input = std::make_shared<input::Input>(*this);
     }
 
+    void DeviceState::AwaitGpu() {
+        if (gpuCreation.valid())
+            gpu = gpuCreation.get();
+    }
+
     DeviceState::~DeviceState() {
         if (process)
             process->ClearHandleTable();
@@ -12,6 +12,7 @@
 #include <shared_mutex>
 #include <functional>
 #include <thread>
+#include <future>
 #include <string>
 #include <memory>
 #include <compare>
@@ -60,6 +61,12 @@ namespace skyline {
 
         ~DeviceState();
 
+        /**
+         * @brief Waits for the GPU to be created on its own thread and assigns it to `gpu`, this is a no-op if that has already been done
+         * @note This must be called prior to any accesses to `gpu`
+         */
+        void AwaitGpu();
+
         kernel::OS *os;
         std::shared_ptr<JvmManager> jvm;
         std::shared_ptr<Settings> settings;
@@ -73,5 +80,6 @@ namespace skyline {
         std::shared_ptr<audio::Audio> audio;
         std::shared_ptr<kernel::Scheduler> scheduler;
         std::shared_ptr<input::Input> input;
+        std::future<std::shared_ptr<gpu::GPU>> gpuCreation; //!< The GPU which is being created concurrently with the rest of the state, this is declared last so an unjoined GPU is destroyed first
     };
 }
@@ -13,7 +13,7 @@ namespace skyline {
     template<typename VaType, size_t AddressSpaceBits>
     concept AddressSpaceValid = std::is_unsigned_v<VaType> && sizeof(VaType) * 8 >= AddressSpaceBits;
 
-    using TranslatedAddressRange = boost::container::small_vector<span<u8>, 1>;
+    using TranslatedAddressRange = boost::container::small_vector<span<u8>, 4>; //!< Ranges are rarely split across more than a few mappings, this avoids a heap allocation in the common cases
 
     struct EmptyStruct {};
 
@@ -108,20 +108,102 @@ namespace skyline {
 
         static constexpr size_t AddressSpaceSize{1ULL << AddressSpaceBits};
         SegmentTable<SegmentTableEntry, AddressSpaceSize, VaGranularityBits, VaL2GranularityBits> blockSegmentTable; //!< A page table of all buffer mappings for O(1) lookups on full matches
+        std::atomic<u32> tableSequence{}; //!< A seqlock sequence for blockSegmentTable, it's odd while the table is being modified and lookups retry if it changed while they were reading
 
         TranslatedAddressRange TranslateRangeImpl(VaType virt, VaType size, std::function<void(span<u8>)> cpuAccessCallback = {});
 
-        std::pair<span<u8>, size_t> LookupBlockLocked(VaType virt, std::function<void(span<u8>)> cpuAccessCallback = {}) {
-            const auto &blockEntry{this->blockSegmentTable[virt]};
-            if (blockEntry.phys == nullptr)
-                return {span<u8>{}, 0};
+        /**
+         * @brief Walks the blocks covering a VA range and calls the function with every corresponding range of host memory, ranges which are contiguous in host memory are merged and unmapped ranges have a null data pointer
+         * @note blockMutex MUST be locked when calling this
+         */
+        template<typename Function, typename CpuAccessCallback>
+        void ForEachMappingLocked(VaType virt, VaType size, Function &function, CpuAccessCallback &cpuAccessCallback) {
+            auto successor{std::upper_bound(this->blocks.begin(), this->blocks.end(), virt, [](auto virt, const auto &block) {
+                return virt < block.virt;
+            })};
 
-            VaType segmentOffset{virt - blockEntry.virt};
-            span<u8> blockSpan{blockEntry.phys, blockEntry.extent};
-            if (cpuAccessCallback)
-                cpuAccessCallback(blockSpan);
+            auto predecessor{std::prev(successor)};
+
+            u8 *blockPhys{predecessor->phys + (virt - predecessor->virt)};
+            VaType blockSize{std::min(successor->virt - virt, size)};
+
+            span<u8> pending{};
+            while (size) {
+                // Return a zeroed out map to emulate sparse mappings
+                if (predecessor->extraInfo.sparseMapped) {
+                    if (blockSize > SparseMapSize)
+                        throw exception("Size of the sparse map is too small to fit block of size: 0x{:X}", blockSize);
 
-            return {blockSpan, segmentOffset};
+                    blockPhys = sparseMap;
+                }
+
+                span<u8> block{predecessor->phys ? blockPhys : nullptr, blockSize};
+                if (block.data())
+                    InvokeCpuAccessCallback(cpuAccessCallback, block);
+
+                if (pending.valid() && block.data() && pending.data() + pending.size() == block.data()) {
+                    pending = {pending.data(), pending.size() + block.size()};
+                } else {
+                    if (pending.size())
+                        function(pending);
+                    pending = block;
+                }
+
+                size -= blockSize;
+
+                if (size) {
+                    predecessor = successor++;
+                    blockPhys = predecessor->phys;
+                    blockSize = std::min(successor->virt - predecessor->virt, size);
+                }
+            }
+
+            if (pending.size())
+                function(pending);
+        }
+
+        /**
+         * @brief Calls the supplied CPU access callback on a block, this is a no-op for the default nullptr callback so it can be elided entirely
+         */
+        template<typename CpuAccessCallback>
+        static void InvokeCpuAccessCallback(CpuAccessCallback &cpuAccessCallback, span<u8> block) {
+            if constexpr (!std::is_null_pointer_v<CpuAccessCallback>) {
+                if constexpr (std::is_constructible_v<bool, CpuAccessCallback &>)
+                    if (!cpuAccessCallback)
+                        return;
+                cpuAccessCallback(block);
+            }
+        }
+
+        /**
+         * @return A consistent copy of the segment table entry for the given VA, this doesn't require blockMutex to be locked
+         * @note The entry is read optimistically and the read is retried if a modification of the table overlapped with it
+         */
+        SegmentTableEntry ReadSegmentTableEntry(VaType virt) const {
+            while (true) {
+                u32 sequence{tableSequence.load(std::memory_order_acquire)};
+                if (sequence & 1) [[unlikely]] {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                SegmentTableEntry entry{blockSegmentTable[virt]};
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (tableSequence.load(std::memory_order_relaxed) == sequence) [[likely]]
+                    return entry;
+            }
+        }
+
+        /**
+         * @brief Modifies the segment table for the given range while bumping the seqlock sequence around the modification
+         * @note blockMutex MUST be locked when calling this
+         */
+        void SetSegmentTableEntries(VaType virt, VaType size, SegmentTableEntry entry) {
+            u32 sequence{tableSequence.load(std::memory_order_relaxed)};
+            tableSequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            blockSegmentTable.Set(virt, virt + size, entry);
+            tableSequence.store(sequence + 2, std::memory_order_release);
         }
 
       public:
@@ -136,30 +218,73 @@ namespace skyline {
             return reinterpret_cast<u8 *>(0xCAFEBABE);
         }
 
+        /**
+         * @return If the supplied host mapping lies within the zero filled map that's returned for sparse mapped regions
+         */
+        bool IsSparseMapping(span<u8> mapping) const {
+            return mapping.data() >= sparseMap && mapping.data() < sparseMap + SparseMapSize;
+        }
+
         /**
          * @brief Looks up the mapped region that contains the given VA
          * @return A span of the mapped region and the offset of the input VA in the region
+         * @note This is lock-free, it can run concurrently with mapping and unmapping without blocking on them
          */
-        __attribute__((always_inline)) std::pair<span<u8>, VaType> LookupBlock(VaType virt, std::function<void(span<u8>)> cpuAccessCallback = {}) {
-            std::scoped_lock lock{this->blockMutex};
-            return LookupBlockLocked(virt, cpuAccessCallback);
+        template<typename CpuAccessCallback = std::nullptr_t>
+        __attribute__((always_inline)) std::pair<span<u8>, VaType> LookupBlock(VaType virt, CpuAccessCallback &&cpuAccessCallback = {}) {
+            auto blockEntry{ReadSegmentTableEntry(virt)};
+            if (blockEntry.phys == nullptr)
+                return {span<u8>{}, 0};
+
+            span<u8> blockSpan{blockEntry.phys, blockEntry.extent};
+            if (blockEntry.extraInfo.sparseMapped) {
+                // Sparse blocks are stored with a placeholder address, return the zero filled map in its place
+                if (blockEntry.extent > SparseMapSize)
+                    throw exception("Size of the sparse map is too small to fit block of size: 0x{:X}", blockEntry.extent);
+
+                blockSpan = span<u8>{sparseMap, blockEntry.extent};
+            }
+
+            InvokeCpuAccessCallback(cpuAccessCallback, blockSpan);
+            return {blockSpan, virt - blockEntry.virt};
         }
 
         /**
          * @brief Translates a region in the VA space to a corresponding set of regions in the PA space
+         * @note The common case of a range within a single block is lock-free, ranges spanning multiple blocks lock blockMutex to walk the block list
          */
-        TranslatedAddressRange TranslateRange(VaType virt, VaType size, std::function<void(span<u8>)> cpuAccessCallback = {}) {
-            std::scoped_lock lock{this->blockMutex};
-
+        template<typename CpuAccessCallback = std::nullptr_t>
+        TranslatedAddressRange TranslateRange(VaType virt, VaType size, CpuAccessCallback &&cpuAccessCallback = {}) {
             // Fast path for when the range is mapped in a single block
-            auto [blockSpan, rangeOffset]{LookupBlockLocked(virt, cpuAccessCallback)};
+            auto [blockSpan, rangeOffset]{LookupBlock(virt, cpuAccessCallback)};
             if (blockSpan.size() - rangeOffset >= size) {
                 TranslatedAddressRange ranges;
                 ranges.push_back(blockSpan.subspan(rangeOffset, size));
                 return ranges;
             }
 
-            return TranslateRangeImpl(virt, size, cpuAccessCallback);
+            std::scoped_lock lock{this->blockMutex};
+            if constexpr (std::is_null_pointer_v<std::remove_cvref_t<CpuAccessCallback>>)
+                return TranslateRangeImpl(virt, size);
+            else
+                return TranslateRangeImpl(virt, size, std::forward<CpuAccessCallback>(cpuAccessCallback));
+        }
+
+        /**
+         * @brief Calls the function with every range of host memory that a region in the VA space translates to without materializing them into a TranslatedAddressRange
+         * @param function A function that's called with a span of host memory for each range in order, unmapped ranges have a null data pointer
+         * @note This yields the same ranges as TranslateRange and has the same lock-free fast path, blockMutex is held while the function is called for split ranges so it must not call into this memory manager
+         */
+        template<typename Function, typename CpuAccessCallback = std::nullptr_t>
+        void ForEachMapping(VaType virt, VaType size, Function function, CpuAccessCallback &&cpuAccessCallback = {}) {
+            auto [blockSpan, rangeOffset]{LookupBlock(virt, cpuAccessCallback)};
+            if (blockSpan.size() - rangeOffset >= size) {
+                function(blockSpan.subspan(rangeOffset, size));
+                return;
+            }
+
+            std::scoped_lock lock{this->blockMutex};
+            ForEachMappingLocked(virt, size, function, cpuAccessCallback);
         }
 
 
@@ -248,13 +373,13 @@ namespace skyline {
 
         void Map(VaType virt, u8 *phys, VaType size, MemoryManagerBlockInfo extraInfo = {}) {
             std::scoped_lock lock(this->blockMutex);
-            blockSegmentTable.Set(virt, virt + size, {virt, phys, size, extraInfo});
+            SetSegmentTableEntries(virt, size, {virt, phys, size, extraInfo});
             this->MapLocked(virt, phys, size, extraInfo);
         }
 
         void Unmap(VaType virt, VaType size) {
             std::scoped_lock lock(this->blockMutex);
-            blockSegmentTable.Set(virt, virt + size, {});
+            SetSegmentTableEntries(virt, size, {});
             this->UnmapLocked(virt, size);
         }
     };
@@ -35,13 +35,48 @@ namespace skyline {
             usernameValue = std::move(ktSettings.GetString("usernameValue"));
             systemLanguage = ktSettings.GetInt<skyline::language::SystemLanguage>("systemLanguage");
             systemRegion = ktSettings.GetInt<skyline::region::RegionCode>("systemRegion");
+            schedulerWorkStealing = ktSettings.GetBool("schedulerWorkStealing");
+            hugePageGuestMemory = ktSettings.GetBool("hugePageGuestMemory");
+            executableCache = ktSettings.GetBool("executableCache");
+            verifyRomIntegrity = ktSettings.GetBool("verifyRomIntegrity");
+            audioTimeStretch = ktSettings.GetBool("audioTimeStretch");
+            lowLatencyInput = ktSettings.GetBool("lowLatencyInput");
+            hostThreadPlacement = ktSettings.GetBool("hostThreadPlacement");
+            bigCoreOverride = ktSettings.GetString("bigCoreOverride");
+            idleLoopSkipping = ktSettings.GetBool("idleLoopSkipping");
+            idleLoopSkippingExclusions = ktSettings.GetString("idleLoopSkippingExclusions");
+            hostMemoryFunctions = ktSettings.GetBool("hostMemoryFunctions");
+            localWireless = ktSettings.GetBool("localWireless");
             forceTripleBuffering = ktSettings.GetBool("forceTripleBuffering");
             disableFrameThrottling = ktSettings.GetBool("disableFrameThrottling");
+            framePacingMode = ktSettings.GetInt<u32>("framePacingMode");
+            emulationSpeed = ktSettings.GetInt<u32>("emulationSpeed");
+            fastForwardSpeed = ktSettings.GetInt<u32>("fastForwardSpeed");
             gpuDriver = ktSettings.GetString("gpuDriver");
             gpuDriverLibraryName = ktSettings.GetString("gpuDriverLibraryName");
             executorSlotCount = ktSettings.GetInt<u32>("executorSlotCount");
+            dynamicExecutorSlots = ktSettings.GetBool("dynamicExecutorSlots");
             enableTextureReadbackHack = ktSettings.GetBool("enableTextureReadbackHack");
+            discardTransientAttachments = ktSettings.GetBool("discardTransientAttachments");
+            asyncPipelineCompilation = ktSettings.GetBool("asyncPipelineCompilation");
+            skipAsyncPipelineDraws = ktSettings.GetBool("skipAsyncPipelineDraws");
+            shaderOptimization = ktSettings.GetBool("shaderOptimization");
+            textureMemoryBudget = ktSettings.GetInt<u32>("textureMemoryBudget");
+            gpuTextureDeswizzle = ktSettings.GetBool("gpuTextureDeswizzle");
+            memoryDefragmentation = ktSettings.GetBool("memoryDefragmentation");
+            transcodeCacheSize = ktSettings.GetInt<u32>("transcodeCacheSize");
+            bufferMemoryBudget = ktSettings.GetInt<u32>("bufferMemoryBudget");
+            importGuestBuffers = ktSettings.GetBool("importGuestBuffers");
+            megaBufferRingSize = ktSettings.GetInt<u32>("megaBufferRingSize");
+            transferQueue = ktSettings.GetBool("transferQueue");
+            recordWorkerCount = ktSettings.GetInt<u32>("recordWorkerCount");
+            resolutionScale = ktSettings.GetInt<u32>("resolutionScale");
+            performanceGovernor = ktSettings.GetBool("performanceGovernor");
+            thermalResolutionScaling = ktSettings.GetBool("thermalResolutionScaling");
             validationLayer = ktSettings.GetBool("validationLayer");
+            gpuTimestampProfiling = ktSettings.GetBool("gpuTimestampProfiling");
+            gpfifoCapture = ktSettings.GetBool("gpfifoCapture");
+            guestProfiler = ktSettings.GetBool("guestProfiler");
         };
     };
 }
@@ -0,0 +1,161 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <fstream>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/system_properties.h>
+#include <common/logger.h>
+#include <common/perf_stats.h>
+#include "utils.h"
+#include "benchmark.h"
+
+namespace skyline {
+    BenchmarkRunner::BenchmarkRunner(std::string directory, u32 frameCount, CompletionCallback onComplete)
+        : directory{std::move(directory)},
+          frameCount{frameCount},
+          onComplete{std::move(onComplete)},
+          startTime{util::GetTimeNs()} {
+        frametimes.reserve(frameCount);
+    }
+
+    void BenchmarkRunner::MarkPhase(std::string_view name) {
+        std::scoped_lock lock{mutex};
+        phases.emplace_back(name, util::GetTimeNs() - startTime);
+    }
+
+    void BenchmarkRunner::SetTitle(u64 id, std::string name, std::string version) {
+        std::scoped_lock lock{mutex};
+        titleId = id;
+        titleName = std::move(name);
+        titleVersion = std::move(version);
+    }
+
+    void BenchmarkRunner::OnPresent(i64 timestamp) {
+        std::unique_lock lock{mutex};
+        if (completed)
+            return;
+
+        if (lastPresentTime)
+            frametimes.push_back(timestamp - lastPresentTime);
+        else
+            phases.emplace_back("first_frame", util::GetTimeNs() - startTime);
+        lastPresentTime = timestamp;
+
+        if (frametimes.size() >= frameCount) {
+            completed = true;
+            WriteReport();
+            lock.unlock();
+            onComplete();
+        }
+    }
+
+    void BenchmarkRunner::WriteReport() {
+        auto escape{[](std::string_view value) {
+            std::string escaped;
+            for (char character : value) {
+                if (character == '"' || character == '\\')
+                    escaped += '\\';
+                if (static_cast<u8>(character) < 0x20)
+                    escaped += fmt::format("\\u{:04X}", static_cast<u8>(character));
+                else
+                    escaped += character;
+            }
+            return escaped;
+        }};
+
+        auto getProperty{[](const char *name) {
+            std::array<char, PROP_VALUE_MAX> value{};
+            __system_property_get(name, value.data());
+            return std::string{value.data()};
+        }};
+
+        auto toMs{[](auto ns) { return static_cast<double>(ns) / constant::NsInMillisecond; }};
+
+        std::vector<i64> sortedFrametimes{frametimes};
+        std::sort(sortedFrametimes.begin(), sortedFrametimes.end());
+        auto percentile{[&](double fraction) {
+            if (sortedFrametimes.empty())
+                return 0.0;
+            auto index{std::min(static_cast<size_t>(fraction * static_cast<double>(sortedFrametimes.size())), sortedFrametimes.size() - 1)};
+            return toMs(sortedFrametimes[index]);
+        }};
+
+        i64 totalFrametime{};
+        for (i64 frametime : frametimes)
+            totalFrametime += frametime;
+        double meanFrametime{frametimes.empty() ? 0.0 : toMs(totalFrametime) / static_cast<double>(frametimes.size())};
+
+        std::string phasesJson;
+        for (const auto &[name, time] : phases)
+            phasesJson += fmt::format("{}\n    \"{}\": {:.3f}", phasesJson.empty() ? "" : ",", name, toMs(time));
+
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+
+        auto counter{[](PerfStats::Counter value) { return PerfStats::GetTotal(value); }};
+        auto report{fmt::format(R"({{
+  "title": {{
+    "id": "{:016X}",
+    "name": "{}",
+    "version": "{}"
+  }},
+  "device": {{
+    "model": "{}",
+    "hardware": "{}",
+    "android": "{}"
+  }},
+  "frames": {},
+  "phases_ms": {{{}
+  }},
+  "frametime_ms": {{
+    "mean": {:.3f},
+    "p50": {:.3f},
+    "p90": {:.3f},
+    "p99": {:.3f},
+    "p99_9": {:.3f},
+    "max": {:.3f}
+  }},
+  "fps": {:.2f},
+  "pipeline_compiles": {},
+  "texture_creations": {},
+  "texture_uploads": {},
+  "texture_upload_bytes": {},
+  "texture_host_copies": {},
+  "defragmentation_moves": {},
+  "defragmentation_bytes": {},
+  "nvdrv_ioctls": {},
+  "nvdrv_ioctl_ns": {},
+  "live_mirrors": {},
+  "draws": {},
+  "svc_calls": {},
+  "gpu_wait_ms": {:.3f},
+  "peak_rss_bytes": {}
+}}
+)",
+                                titleId, escape(titleName), escape(titleVersion),
+                                escape(getProperty("ro.product.model")), escape(getProperty("ro.hardware")), escape(getProperty("ro.build.version.release")),
+                                frametimes.size(), phasesJson,
+                                meanFrametime, percentile(0.5), percentile(0.9), percentile(0.99), percentile(0.999), sortedFrametimes.empty() ? 0.0 : toMs(sortedFrametimes.back()),
+                                meanFrametime > 0.0 ? 1000.0 / meanFrametime : 0.0,
+                                counter(PerfStats::Counter::PipelineCompiles), counter(PerfStats::Counter::TextureCreations),
+                                counter(PerfStats::Counter::TextureUploads), counter(PerfStats::Counter::TextureUploadBytes),
+                                counter(PerfStats::Counter::TextureHostCopies),
+                                counter(PerfStats::Counter::DefragmentationMoves), counter(PerfStats::Counter::DefragmentationBytes),
+                                counter(PerfStats::Counter::NvdrvIoctls), counter(PerfStats::Counter::NvdrvIoctlNs),
+                                counter(PerfStats::Counter::MirrorCreations) - counter(PerfStats::Counter::MirrorUnmaps),
+                                counter(PerfStats::Counter::Draws), counter(PerfStats::Counter::SvcCalls),
+                                toMs(counter(PerfStats::Counter::FenceWaitNs)),
+                                static_cast<u64>(usage.ru_maxrss) * 1024)}; // ru_maxrss is in KiB
+
+        mkdir(directory.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+        auto path{fmt::format("{}{:016X}_{}.json", directory, titleId, util::GetTimeNs())};
+        std::ofstream file{path, std::ios::trunc};
+        if (!file) {
+            Logger::Warn("Failed to write the benchmark report to {}", path);
+            return;
+        }
+        file << report;
+        Logger::Info("Benchmark of {} frames has completed, the report was written to {}", frametimes.size(), path);
+    }
+}
@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <vector>
+#include "base.h"
+
+namespace skyline {
+    /**
+     * @brief Runs emulation for a fixed amount of presented frames and writes the performance statistics of the run to a JSON file, this provides reproducible numbers across builds and devices
+     * @note The counters are the totals since emulation was started as PerfStats is reset at that point, frame times are only collected after the first frame has been presented
+     */
+    class BenchmarkRunner {
+      public:
+        using CompletionCallback = std::function<void()>; //!< A callback that's invoked on the presentation thread once all frames have been presented, this is expected to stop emulation
+
+      private:
+        std::string directory; //!< The directory that the report is written to
+        u32 frameCount; //!< The amount of frames to present after the first frame
+        CompletionCallback onComplete;
+        i64 startTime; //!< The time at which the benchmark was started in nanoseconds
+
+        std::mutex mutex; //!< Synchronizes all members below
+        std::vector<std::pair<std::string, i64>> phases; //!< The startup phases with the time since the start at which they were completed in nanoseconds
+        u64 titleId{};
+        std::string titleName;
+        std::string titleVersion;
+        i64 lastPresentTime{}; //!< The time at which the last frame was presented in nanoseconds, 0 if no frame has been presented yet
+        std::vector<i64> frametimes; //!< The durations between every presented frame in nanoseconds
+        bool completed{};
+
+        /**
+         * @brief Writes the report of the benchmark to a file in the output directory
+         * @note `mutex` must be locked when calling this
+         */
+        void WriteReport();
+
+      public:
+        BenchmarkRunner(std::string directory, u32 frameCount, CompletionCallback onComplete);
+
+        /**
+         * @brief Records the completion of a startup phase at the current time
+         */
+        void MarkPhase(std::string_view name);
+
+        void SetTitle(u64 id, std::string name, std::string version);
+
+        /**
+         * @brief Records the presentation of a frame, the report is written and the completion callback is invoked once enough frames have been presented
+         * @param timestamp The CLOCK_MONOTONIC timestamp the frame was presented at in nanoseconds
+         */
+        void OnPresent(i64 timestamp);
+    };
+}
@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include "spin_lock.h"
+
+namespace skyline {
+    /**
+     * @brief An append-only list which stores items contiguously in fixed-size chunks, this avoids an allocation per item and keeps items close together in memory for when they're destroyed
+     * @note The first chunk is stored inline with the list so short lists don't require any allocations at all
+     */
+    template<typename Type, size_t ChunkSize = 32>
+    class ChunkedList {
+      private:
+        struct Chunk {
+            std::array<Type, ChunkSize> items{};
+            size_t count{}; //!< The amount of items in the chunk that are populated
+            std::unique_ptr<Chunk> next{}; //!< The chunk after this one, this is only non-null when the current chunk is full
+        };
+
+        SpinLock mutex; //!< Synchronizes all accesses to the chunks
+        Chunk head; //!< The inline first chunk of the list
+        Chunk *tail{&head}; //!< The last chunk of the list, which is where new items are appended
+
+        /**
+         * @return A reference to a new slot at the end of the list
+         * @note The mutex **must** be locked prior to calling this
+         */
+        Type &AllocateSlot() {
+            if (tail->count == ChunkSize) {
+                tail->next = std::make_unique<Chunk>();
+                tail = tail->next.get();
+            }
+
+            return tail->items[tail->count++];
+        }
+
+      public:
+        ChunkedList() = default;
+
+        ChunkedList(const ChunkedList &) = delete;
+
+        ~ChunkedList() {
+            Clear();
+        }
+
+        /**
+         * @brief Clears all the items from the list while deallocating all chunks aside from the inline one
+         * @note Items are destroyed after the lock is released, so it's safe for their destructors to append to the list
+         */
+        void Clear() {
+            std::unique_lock lock{mutex};
+            std::array<Type, ChunkSize> headItems{std::move(head.items)};
+            std::unique_ptr<Chunk> chunks{std::move(head.next)};
+            head.count = 0;
+            tail = &head;
+            lock.unlock();
+
+            // Destroy the chain of chunks iteratively rather than recursively through the destructor of each unique_ptr
+            while (chunks)
+                chunks = std::move(chunks->next);
+        }
+
+        /**
+         * @brief Appends an item to the end of the list
+         */
+        void Append(Type item) {
+            std::scoped_lock lock{mutex};
+            AllocateSlot() = std::move(item);
+        }
+
+        /**
+         * @brief Appends multiple items to the end of the list
+         */
+        void Append(std::initializer_list<Type> items) {
+            std::scoped_lock lock{mutex};
+            for (auto &item : items)
+                AllocateSlot() = item;
+        }
+
+        template<typename... Items>
+        void Append(Items &&... items) {
+            Append(std::initializer_list<Type>{std::forward<Items>(items)...});
+        }
+
+        /**
+         * @brief Appends an item to the end of the list if it isn't equal to any of the most recently appended items
+         * @param window The amount of items prior to the end of the list in the current chunk that are checked, this is bounded to keep the check cheap
+         * @param equal A predicate that determines if two items are equal
+         * @return If the item was appended to the list
+         */
+        template<typename Predicate = std::equal_to<>>
+        bool AppendUnique(Type item, size_t window = 8, Predicate equal = {}) {
+            std::scoped_lock lock{mutex};
+            auto end{tail->items.begin() + static_cast<ssize_t>(tail->count)};
+            if (std::any_of(end - static_cast<ssize_t>(std::min(window, tail->count)), end, [&](const Type &existing) { return equal(existing, item); }))
+                return false;
+
+            AllocateSlot() = std::move(item);
+            return true;
+        }
+    };
+}
@@ -76,6 +76,15 @@ namespace skyline {
             }
         }
 
+        /**
+         * @return The amount of items in the queue, this includes the item currently being processed by Process()
+         * @note This is only accurate on the consumer thread as more items may be pushed concurrently
+         */
+        size_t Size() {
+            auto capacity{vector.size() / sizeof(Type)};
+            return static_cast<size_t>((end - start + static_cast<ptrdiff_t>(capacity)) % static_cast<ptrdiff_t>(capacity));
+        }
+
         Type Pop() {
             std::unique_lock lock(productionMutex);
             produceCondition.wait(lock, [this]() { return start != end; });
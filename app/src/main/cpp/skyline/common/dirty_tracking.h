@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <bit>
 #include "base.h"
 #include "exception.h"
 #include "logger.h"
@@ -13,65 +14,85 @@ namespace skyline::dirty {
     class Manager;
 
     /**
-     * @brief An opaque handle to a dirty subresource
+     * @brief An opaque handle to a dirty subresource, this refers to a single bit in the dirty bitset of a manager
      */
     struct Handle {
       private:
         template<size_t, size_t, size_t>
         friend class Manager;
 
-        bool *dirtyPtr; //!< Underlying target ptr
+        u64 *bits; //!< The dirty bitset of the manager that the handle was allocated from
+        u32 index; //!< The index of the bit for the handle in `bits`
 
       public:
-        explicit Handle(bool *dirtyPtr) : dirtyPtr{dirtyPtr} {}
+        Handle(u64 *bits, u32 index) : bits{bits}, index{index} {}
+
+        u32 GetIndex() const {
+            return index;
+        }
+
+        u64 *GetBits() const {
+            return bits;
+        }
+
+        bool IsDirty() const {
+            return (bits[index / 64] >> (index % 64)) & 1;
+        }
+
+        void SetDirty() const {
+            bits[index / 64] |= 1ULL << (index % 64);
+        }
+
+        void ClearDirty() const {
+            bits[index / 64] &= ~(1ULL << (index % 64));
+        }
     };
 
     /**
      * @brief Implements a way to track dirty subresources within a region of memory
+     * @details The dirtiness of all subresources is packed into a single bitset, every subresource granule has a mask of the handles bound to it which is ORed into the bitset on a write so marking a granule as dirty is branchless and doesn't chase any pointers
      * @tparam ManagedResourceSize Size of the managed resource in bytes
      * @tparam Granularity Minimum granularity of a subresource in bytes
-     * @tparam OverlapPoolSize Size of the pool used to store handles when there are multiple bound to the same subresource
+     * @tparam HandleCount The maximum amount of handles that can be allocated from the manager, this determines the width of the masks of every granule
      * @note This class is *NOT* thread-safe
      */
-    template<size_t ManagedResourceSize, size_t Granularity, size_t OverlapPoolSize = 0x1000>
+    template<size_t ManagedResourceSize, size_t Granularity, size_t HandleCount = 128>
     class Manager {
       private:
-        struct BindingState {
-            enum class Type : u32 {
-                None, //!< No handles are bound
-                Inline, //!< `inlineDirtyPtr` contains a pointer to the single bound handle for the entry
-                OverlapSpan, //!< `overlapSpanDirtyPtrs` contains an array of pointers to handles bound to the entry
-            } type{Type::None};
-            u32 overlapSpanSize{}; //!< Size of the array that overlapSpanDirtyPtrs points to
-
-            union {
-                bool *inlineDirtyPtr;
-                bool **overlapSpanDirtyPtrs;
-            };
-
-            /**
-             * @return An array of pointers to handles bound to the entry
-             */
-            span<bool *> GetOverlapSpan() {
-                return {overlapSpanDirtyPtrs, overlapSpanSize};
-            }
-        };
+        static constexpr size_t WordCount{(HandleCount + 63) / 64};
+        using Mask = std::array<u64, WordCount>; //!< A mask of handles with a bit for each handle
+
+        Mask dirtyBits{}; //!< The dirty state of every allocated handle
+        u32 handleCount{}; //!< The amount of handles that have been allocated, new handles are allocated consecutively
 
-        std::array<bool *, OverlapPoolSize> overlapPool{}; //!< Backing pool for `overlapSpanDirtyPtrs` in entry
-        bool **freeOverlapPtr{}; //!< Pointer to the next free entry in `overlapPool`
-        
-        std::array<BindingState, ManagedResourceSize / Granularity> states{}; //!< The dirty binding states for the entire managed resource
+        std::array<Mask, ManagedResourceSize / Granularity> bindings{}; //!< The handles bound to every granule of the managed resource
 
         uintptr_t managedResourceBaseAddress; //!< The base address of the managed resource
 
       public:
         template<typename ManagedResourceType> requires (std::is_standard_layout_v<ManagedResourceType> && sizeof(ManagedResourceType) == ManagedResourceSize)
-        Manager(ManagedResourceType &managedResource) : managedResourceBaseAddress{reinterpret_cast<uintptr_t>(&managedResource)}, freeOverlapPtr{overlapPool.data()} {}
+        Manager(ManagedResourceType &managedResource) : managedResourceBaseAddress{reinterpret_cast<uintptr_t>(&managedResource)} {}
+
+        /**
+         * @brief Allocates a new handle which is initially dirty
+         * @note Handles allocated in succession have consecutive indices, this allows arrays of states to be scanned for dirtiness at once
+         */
+        Handle AllocateHandle() {
+            if (handleCount == HandleCount)
+                throw exception("Dirty handle bitset is full");
+
+            Handle handle{dirtyBits.data(), handleCount++};
+            handle.SetDirty();
+            return handle;
+        }
 
         /**
-         * @brief Binds a handle to a subresource, automatically handling overlaps
+         * @brief Binds a handle to a subresource, any overlaps with other handles are handled implicitly as they're all a part of the same mask
          */
         void Bind(Handle handle, uintptr_t subresourceAddress, size_t subresourceSizeBytes) {
+            if (handle.bits != dirtyBits.data())
+                throw exception("Dirty handle wasn't allocated from this manager");
+
             if (managedResourceBaseAddress > subresourceAddress)
                 throw exception("Dirty subresource address is below the managed resource base address");
 
@@ -91,47 +112,8 @@ namespace skyline::dirty {
             size_t subresourceIndex{static_cast<size_t>(subresourceAddressOffset / Granularity)};
             size_t subresourceSize{subresourceSizeBytes / Granularity};
 
-            for (size_t i{subresourceIndex}; i < subresourceIndex + subresourceSize; i++) {
-                auto &state{states[i]};
-                
-                if (state.type == BindingState::Type::None) {
-                    state.type = BindingState::Type::Inline;
-                    state.inlineDirtyPtr = handle.dirtyPtr;
-                } else if (state.type == BindingState::Type::Inline) {
-                    state.type = BindingState::Type::OverlapSpan;
-
-                    // Save the old inline dirty pointer since we'll need to insert it into the new overlap span and setting the overlap span ptr will overwrite it
-                    bool *origDirtyPtr{state.inlineDirtyPtr};
-
-                    // Point to a new pool allocation that can hold the overlap
-                    state.overlapSpanDirtyPtrs = freeOverlapPtr;
-                    state.overlapSpanSize = 2; // Existing inline handle + our new handle
-
-                    // Check if the pool allocation is valid
-                    if (freeOverlapPtr + state.overlapSpanSize >= overlapPool.end())
-                        throw exception("Dirty overlap pool is full");
-
-                    // Write overlap to our new pool allocation
-                    *freeOverlapPtr++ = origDirtyPtr;
-                    *freeOverlapPtr++ = handle.dirtyPtr;
-                } else if (state.type == BindingState::Type::OverlapSpan) {
-                    auto originalOverlapSpan{state.GetOverlapSpan()};
-
-                    // Point to a new pool allocation that can hold all the old overlaps + our new overlap
-                    state.overlapSpanSize++;
-                    state.overlapSpanDirtyPtrs = freeOverlapPtr;
-
-                    // Check if the pool allocation is valid
-                    if (freeOverlapPtr + state.overlapSpanSize >= overlapPool.end())
-                        throw exception("Dirty overlap pool is full");
-
-                    // Write all overlaps to our new pool allocation
-                    auto newOverlapSpan{state.GetOverlapSpan()};
-                    newOverlapSpan.copy_from(originalOverlapSpan); // Copy old overlaps
-                    *newOverlapSpan.last(1).data() = handle.dirtyPtr; // Write new overlap
-                    freeOverlapPtr += state.overlapSpanSize;
-                }
-            }
+            for (size_t i{subresourceIndex}; i < subresourceIndex + subresourceSize; i++)
+                bindings[i][handle.index / 64] |= 1ULL << (handle.index % 64);
         }
 
         template<typename SubresourceType> requires std::is_standard_layout_v<SubresourceType>
@@ -149,15 +131,9 @@ namespace skyline::dirty {
          * @note This *MUST NOT* be called after any bound handles have been destroyed
          */
         void MarkDirty(size_t index) {
-            auto &state{states[index]};
-            if (state.type == BindingState::Type::None) [[likely]] {
-                return;
-            } else if (state.type == BindingState::Type::Inline) {
-                *state.inlineDirtyPtr = true;
-            } else if (state.type == BindingState::Type::OverlapSpan) [[unlikely]] {
-                for (auto &dirtyPtr : state.GetOverlapSpan())
-                    *dirtyPtr = true;
-            }
+            const auto &mask{bindings[index]};
+            for (size_t word{}; word < WordCount; word++)
+                dirtyBits[word] |= mask[word];
         }
     };
 
@@ -198,23 +174,20 @@ namespace skyline::dirty {
 
     /**
      * @brief Wrapper around an object that holds dirty state and provides convinient functionality for dirty tracking
+     * @note The dirty state is a bit in the dirty bitset of the manager that's supplied on construction
      */
     template<typename T> requires (std::is_base_of_v<ManualDirty, T>)
     class ManualDirtyState {
       private:
+        Handle handle; //!< The handle to the dirty bit of the object
         T value; //!< The underlying object
-        bool dirty{true}; //!< Whether the value is dirty
 
-        /**
-         * @return An opaque handle that can be used to modify dirty state
-         */
-        Handle GetDirtyHandle() {
-            return Handle{&dirty};
-        }
+        template<typename U, size_t Size, typename... Args>
+        friend void UpdateAll(std::array<ManualDirtyState<U>, Size> &states, Args &&... args);
 
       public:
-        template<typename... Args>
-        ManualDirtyState(Args &&... args) : value{GetDirtyHandle(), std::forward<Args>(args)...} {}
+        template<typename ManagerT, typename... Args>
+        ManualDirtyState(ManagerT &manager, Args &&... args) : handle{manager.AllocateHandle()}, value{handle, manager, std::forward<Args>(args)...} {}
 
         /**
          * @brief Cleans the object of its dirty state and refreshes it if necessary
@@ -222,8 +195,8 @@ namespace skyline::dirty {
          */
         template<typename... Args>
         void Update(Args &&... args) {
-            if (dirty) {
-                dirty = false;
+            if (handle.IsDirty()) {
+                handle.ClearDirty();
                 value.Flush(std::forward<Args>(args)...);
             } else if constexpr (std::is_base_of_v<RefreshableManualDirty, T>) {
                 if (value.Refresh(std::forward<Args>(args)...))
@@ -236,7 +209,7 @@ namespace skyline::dirty {
          * @param purgeCaches Whether to purge caches of the object that would usually be kept even after being marked dirty
          */
         void MarkDirty(bool purgeCaches) {
-            dirty = true;
+            handle.SetDirty();
 
             if constexpr (std::is_base_of_v<CachedManualDirty, T>)
                 if (purgeCaches)
@@ -258,4 +231,33 @@ namespace skyline::dirty {
             return value;
         }
     };
+
+    /**
+     * @brief Updates an array of states by scanning their dirty bits a word at a time and only flushing the dirty ones, this is equivalent to calling `Update()` on every state in order
+     * @note The states must have been constructed consecutively from the same manager so their dirty bits are contiguous, this is the case for any array that's constructed in-place
+     */
+    template<typename T, size_t Size, typename... Args>
+    void UpdateAll(std::array<ManualDirtyState<T>, Size> &states, Args &&... args) {
+        static_assert(!std::is_base_of_v<RefreshableManualDirty, T>, "Refreshable states must be refreshed individually");
+
+        u64 *bits{states.front().handle.GetBits()};
+        size_t first{states.front().handle.GetIndex()};
+        if (states.back().handle.GetIndex() != first + Size - 1)
+            throw exception("Dirty handles of the state array aren't contiguous");
+
+        for (size_t offset{}; offset < Size;) {
+            size_t bit{(first + offset) % 64};
+            size_t count{std::min(64 - bit, Size - offset)};
+            u64 &word{bits[(first + offset) / 64]};
+
+            u64 dirty{word & ((count == 64 ? ~0ULL : ((1ULL << count) - 1)) << bit)};
+            word &= ~dirty;
+            while (dirty) {
+                states[offset + static_cast<size_t>(std::countr_zero(dirty)) - bit].value.Flush(args...);
+                dirty &= dirty - 1;
+            }
+
+            offset += count;
+        }
+    }
 }
@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <mutex>
+#include <common.h>
+#include "emulation_speed.h"
+
+namespace skyline::emulation_speed {
+    static constexpr u64 TegraX1Frequency{19200000}; //!< The clock frequency of the Tegra X1 (19.2 MHz)
+    static constexpr size_t ClockScaleCount{64}; //!< The amount of ClockScale slots, trampolines can read a slot shortly after it has been replaced so slots are only reused after this many changes
+
+    static bool Enabled{}; //!< If speed control is enabled
+    static u32 NormalSpeed{100}; //!< The configured speed in percent
+    static u32 FastForwardSpeed{}; //!< The fast-forward speed in percent, 0 if fast-forwarding is disabled
+    static std::atomic<u32> CurrentSpeed{100}; //!< The current speed in percent
+
+    static std::mutex ScaleMutex; //!< Synchronizes all changes of speed
+    static std::array<ClockScale, ClockScaleCount> ClockScales{};
+    static size_t ClockScaleIndex{}; //!< The index of the slot in ClockScales that CurrentScale points to
+    static std::atomic<const ClockScale *> CurrentScale{&ClockScales[0]};
+    static_assert(std::atomic<const ClockScale *>::is_always_lock_free && sizeof(CurrentScale) == sizeof(uintptr_t));
+
+    static u64 GetHostTicks() {
+        u64 ticks;
+        asm volatile("MRS %0, CNTVCT_EL0" : "=r"(ticks));
+        return ticks;
+    }
+
+    static u64 ApplyScale(const ClockScale &scale, u64 hostTicks) {
+        return static_cast<u64>((static_cast<__uint128_t>(hostTicks) * scale.multiplier) >> 32) + scale.offset;
+    }
+
+    /**
+     * @brief Publishes a new ClockScale for the supplied speed, it's offset so that the guest counter continues from its current value
+     * @note 'ScaleMutex' **must** be locked by the calling thread
+     */
+    static void UpdateClockScale(u32 speed, bool continuous) {
+        u64 frequency;
+        asm("MRS %0, CNTFRQ_EL0" : "=r"(frequency));
+        auto multiplier{static_cast<u64>(((static_cast<__uint128_t>(TegraX1Frequency) * speed) << 32) / (static_cast<__uint128_t>(frequency) * 100))};
+
+        u64 hostTicks{GetHostTicks()};
+        auto &scale{ClockScales[ClockScaleIndex = (ClockScaleIndex + 1) % ClockScaleCount]};
+        scale.multiplier = multiplier;
+        scale.offset = continuous ? ApplyScale(*CurrentScale.load(std::memory_order_relaxed), hostTicks) - ApplyScale(ClockScale{multiplier, 0}, hostTicks) : 0;
+        CurrentScale.store(&scale, std::memory_order_release);
+        CurrentSpeed.store(speed, std::memory_order_relaxed);
+    }
+
+    void Configure(u32 speed, u32 fastForwardSpeed) {
+        std::scoped_lock lock{ScaleMutex};
+        NormalSpeed = speed ? speed : 100;
+        FastForwardSpeed = fastForwardSpeed;
+        Enabled = NormalSpeed != 100 || FastForwardSpeed;
+
+        UpdateClockScale(NormalSpeed, false);
+        if (Enabled)
+            Logger::Info("Emulation speed control is enabled: {}% (Fast-forward: {}%)", NormalSpeed, FastForwardSpeed);
+    }
+
+    bool IsEnabled() {
+        return Enabled;
+    }
+
+    void SetFastForward(bool enable) {
+        std::scoped_lock lock{ScaleMutex};
+        if (!FastForwardSpeed)
+            return;
+
+        u32 speed{enable ? FastForwardSpeed : NormalSpeed};
+        if (speed == CurrentSpeed.load(std::memory_order_relaxed))
+            return;
+
+        UpdateClockScale(speed, true);
+        Logger::Info("Emulation speed: {}%", speed);
+    }
+
+    double GetFactor() {
+        return static_cast<double>(CurrentSpeed.load(std::memory_order_relaxed)) / 100.0;
+    }
+
+    double GetMaxFactor() {
+        return static_cast<double>(std::max(NormalSpeed, FastForwardSpeed)) / 100.0;
+    }
+
+    i64 ScaleDuration(i64 duration) {
+        u32 speed{CurrentSpeed.load(std::memory_order_relaxed)};
+        if (!Enabled || duration <= 0 || speed == 100)
+            return duration;
+
+        auto scaled{static_cast<double>(duration) * 100.0 / speed};
+        return scaled >= static_cast<double>(std::numeric_limits<i64>::max()) ? std::numeric_limits<i64>::max() : static_cast<i64>(scaled);
+    }
+
+    u64 GetGuestTicks() {
+        return ApplyScale(*CurrentScale.load(std::memory_order_acquire), GetHostTicks());
+    }
+
+    uintptr_t GetClockScaleAddress() {
+        return reinterpret_cast<uintptr_t>(&CurrentScale);
+    }
+}
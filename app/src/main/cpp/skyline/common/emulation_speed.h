@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <cstddef>
+#include "base.h"
+
+/**
+ * @brief Control over the speed of emulation relative to real-time, this scales the guest counter, guest timeouts, the V-Sync rate and audio playback
+ */
+namespace skyline::emulation_speed {
+    /**
+     * @brief The parameters which convert the host counter into the guest counter: ((host ticks * multiplier) >> 32) + offset
+     * @note The layout of this is depended on by the counter read trampolines emitted by the NCE, it must not be changed without updating them
+     */
+    struct ClockScale {
+        u64 multiplier; //!< A 32.32 fixed-point multiplier from host ticks to Tegra X1 ticks at the current speed
+        u64 offset; //!< The offset that's added to the scaled counter, this keeps the guest counter continuous across speed changes
+    };
+    static_assert(offsetof(ClockScale, multiplier) == 0 && offsetof(ClockScale, offset) == sizeof(u64));
+
+    /**
+     * @param speed The speed of emulation as a percentage of real-time
+     * @param fastForwardSpeed The speed used while fast-forwarding as a percentage of real-time, 0 if fast-forwarding is disabled
+     * @note This must be called prior to any guest code being patched, speed control is only enabled if either speed isn't 100% so there's no overhead otherwise
+     */
+    void Configure(u32 speed, u32 fastForwardSpeed);
+
+    /**
+     * @return If speed control is enabled, all guest counter reads must go through the current ClockScale if so
+     */
+    bool IsEnabled();
+
+    /**
+     * @brief Switches between the configured speed and the fast-forward speed, this is a no-op if fast-forwarding is disabled
+     */
+    void SetFastForward(bool enable);
+
+    /**
+     * @return The current speed of emulation as a multiple of real-time
+     */
+    double GetFactor();
+
+    /**
+     * @return The highest speed of emulation that can be reached as a multiple of real-time, this is the fast-forward speed if it's faster than the configured speed
+     */
+    double GetMaxFactor();
+
+    /**
+     * @return The host duration corresponding to a guest duration in nanoseconds, non-positive durations (polls/infinite waits) are returned as-is
+     */
+    i64 ScaleDuration(i64 duration);
+
+    /**
+     * @return The value of the guest counter in Tegra X1 ticks, this is identical to the values read by guest code
+     */
+    u64 GetGuestTicks();
+
+    /**
+     * @return The address of a pointer to the current ClockScale, the pointer is atomically replaced on every change of speed while the pointed-to parameters are immutable
+     */
+    uintptr_t GetClockScaleAddress();
+}
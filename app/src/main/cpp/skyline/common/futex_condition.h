@@ -0,0 +1,136 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "utils.h"
+
+namespace skyline {
+    /**
+     * @brief A condition variable built directly on a futex which spins for an adaptive amount of iterations prior to sleeping
+     * @note Notifying only requires an atomic increment when nobody is sleeping on the futex, it doesn't have an internal mutex like std::condition_variable which is contended between the notifier and the waiter
+     * @note The amount of spin iterations adapts to if spinning has been successful previously, this makes short handoffs avoid the futex entirely while long waits quickly stop wasting CPU time
+     */
+    class FutexCondition {
+      private:
+        static constexpr u32 MinSpinIterations{16};
+        static constexpr u32 MaxSpinIterations{4096};
+
+        std::atomic<u32> sequence{}; //!< Incremented on every notification, this is the futex word
+        std::atomic<u32> sleepers{}; //!< The amount of threads sleeping (or about to sleep) on the futex, this avoids a futex wake when nobody is sleeping
+        std::atomic<u32> spinIterations{MinSpinIterations * 8}; //!< The amount of iterations to spin for prior to sleeping on the futex
+
+        static_assert(sizeof(std::atomic<u32>) == sizeof(u32) && std::atomic<u32>::is_always_lock_free);
+
+        /**
+         * @brief Waits for a single notification or till the timeout expires, spurious wakeups are possible and must be handled by the caller
+         * @note The lock **must** be locked prior to calling this and will be locked after it returns
+         */
+        template<typename Lock>
+        void WaitOnce(Lock &lock, std::optional<std::chrono::nanoseconds> timeout) {
+            // The sequence is read while the lock is held, any change to the predicate after it was checked will be followed by a notification that increments it
+            u32 value{sequence.load(std::memory_order_seq_cst)};
+            lock.unlock();
+
+            u32 iterations{spinIterations.load(std::memory_order_relaxed)};
+            bool notified{};
+            for (u32 i{}; i < iterations; i++) {
+                if (sequence.load(std::memory_order_acquire) != value) {
+                    notified = true;
+                    break;
+                }
+                asm volatile("YIELD");
+            }
+
+            if (notified) {
+                spinIterations.store(std::min(iterations * 2, MaxSpinIterations), std::memory_order_relaxed);
+            } else {
+                spinIterations.store(std::max(iterations / 2, MinSpinIterations), std::memory_order_relaxed);
+
+                sleepers.fetch_add(1, std::memory_order_seq_cst);
+                if (sequence.load(std::memory_order_seq_cst) == value) {
+                    std::optional<timespec> time;
+                    if (timeout)
+                        time = timespec{
+                            .tv_sec = static_cast<time_t>(timeout->count() / constant::NsInSecond),
+                            .tv_nsec = static_cast<long>(timeout->count() % constant::NsInSecond),
+                        };
+                    syscall(SYS_futex, reinterpret_cast<u32 *>(&sequence), FUTEX_WAIT_PRIVATE, value, time ? &*time : nullptr, nullptr, 0); // Spurious wakeups (EINTR), timeouts and value mismatches (EAGAIN) are handled by the caller rechecking the predicate
+                }
+                sleepers.fetch_sub(1, std::memory_order_relaxed);
+            }
+
+            lock.lock();
+        }
+
+      public:
+        void notify_one() {
+            sequence.fetch_add(1, std::memory_order_seq_cst);
+            if (sleepers.load(std::memory_order_seq_cst))
+                syscall(SYS_futex, reinterpret_cast<u32 *>(&sequence), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+        }
+
+        void notify_all() {
+            sequence.fetch_add(1, std::memory_order_seq_cst);
+            if (sleepers.load(std::memory_order_seq_cst))
+                syscall(SYS_futex, reinterpret_cast<u32 *>(&sequence), FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr, nullptr, 0);
+        }
+
+        /**
+         * @brief Waits till the predicate is satisfied, the predicate is always evaluated with the lock held
+         */
+        template<typename Lock, typename Predicate>
+        void wait(Lock &lock, Predicate predicate) {
+            while (!predicate())
+                WaitOnce(lock, std::nullopt);
+        }
+
+        /**
+         * @brief Waits till the predicate is satisfied or the timeout expires, the predicate is always evaluated with the lock held
+         * @return The result of the predicate after waiting
+         */
+        template<typename Lock, typename Rep, typename Period, typename Predicate>
+        bool wait_for(Lock &lock, std::chrono::duration<Rep, Period> timeout, Predicate predicate) {
+            auto deadline{std::chrono::steady_clock::now() + timeout};
+            while (!predicate()) {
+                auto remaining{deadline - std::chrono::steady_clock::now()};
+                if (remaining <= std::chrono::steady_clock::duration::zero())
+                    return predicate();
+                WaitOnce(lock, std::chrono::duration_cast<std::chrono::nanoseconds>(remaining));
+            }
+            return true;
+        }
+
+        /**
+         * @brief Identical to wait_for but spins on the notifications for the last PreciseSleepSpinNs of the timeout rather than sleeping, this avoids overshooting short timeouts
+         * @note This should only be used for timeouts that are guest-visible as the spin wastes CPU time
+         */
+        template<typename Lock, typename Rep, typename Period, typename Predicate>
+        bool wait_for_precise(Lock &lock, std::chrono::duration<Rep, Period> timeout, Predicate predicate) {
+            constexpr std::chrono::nanoseconds SpinDuration{util::PreciseSleepSpinNs};
+            auto deadline{std::chrono::steady_clock::now() + timeout};
+            while (!predicate()) {
+                auto remaining{deadline - std::chrono::steady_clock::now()};
+                if (remaining <= std::chrono::steady_clock::duration::zero())
+                    return predicate();
+
+                if (remaining > SpinDuration) {
+                    WaitOnce(lock, std::chrono::duration_cast<std::chrono::nanoseconds>(remaining - SpinDuration));
+                } else {
+                    u32 value{sequence.load(std::memory_order_seq_cst)};
+                    lock.unlock();
+                    while (sequence.load(std::memory_order_acquire) == value && std::chrono::steady_clock::now() < deadline)
+                        asm volatile("YIELD");
+                    lock.lock();
+                }
+            }
+            return true;
+        }
+    };
+}
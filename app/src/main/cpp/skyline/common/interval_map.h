@@ -9,6 +9,7 @@
 namespace skyline {
     /**
      * @brief An associative map with groups of overlapping intervals associated with a value with support for range-based lookups
+     * @note Intervals are stored in an augmented treap, so insertions, removals and lookups of the intervals overlapping an address are O(log n) on average
      * @tparam AddressType The type of address used for lookups and insertions
      * @tparam EntryType The type of entry that is stored for a collection of intervals
      */
@@ -42,10 +43,11 @@ namespace skyline {
         struct EntryGroup {
             std::vector<Interval> intervals;
             EntryType value;
+            std::vector<u32> entries; //!< The indices of the entries of all intervals in the group
 
             EntryGroup(Interval interval, EntryType value) : intervals(1, interval), value(std::move(value)) {}
 
-            EntryGroup(span<Interval> intervals, EntryType value) : intervals(intervals), value(std::move(value)) {}
+            EntryGroup(span<Interval> intervals, EntryType value) : intervals(intervals.begin(), intervals.end()), value(std::move(value)) {}
 
             template<typename T>
             EntryGroup(span<span<T>> lIntervals, EntryType value) : value(std::move(value)) {
@@ -61,14 +63,19 @@ namespace skyline {
         using GroupHandle = typename std::list<EntryGroup>::iterator;
 
       private:
+        static constexpr u32 NullEntry{std::numeric_limits<u32>::max()};
+
+        /**
+         * @brief A node of a treap of all intervals ordered by their start, every node is augmented with the maximum end inside its subtree so lookups can skip any subtrees that end before the queried interval
+         */
         struct Entry : public Interval {
             GroupHandle group;
+            AddressType maxEnd; //!< The maximum end of all entries in the subtree rooted at this entry
+            u32 priority; //!< The heap priority of the entry, this is never lower than that of its children
+            u32 left{NullEntry};
+            u32 right{NullEntry};
 
-            Entry(AddressType start, AddressType end, GroupHandle group) : Interval{start, end}, group{group} {}
-
-            bool operator==(const GroupHandle &pGroup) const {
-                return group == pGroup;
-            }
+            Entry(AddressType start, AddressType end, GroupHandle group, u32 priority) : Interval{start, end}, group{group}, maxEnd{end}, priority{priority} {}
         };
 
         /**
@@ -85,7 +92,169 @@ namespace skyline {
             return false;
         }
 
-        std::vector<Entry> entries;
+        std::vector<Entry> entries; //!< A pool of all entries, these are linked by their index so the pool can grow without invalidating the tree
+        std::vector<u32> freeEntries; //!< The indices of entries in the pool which aren't part of the tree
+        u32 root{NullEntry};
+        u32 priorityState{0x9E3779B9}; //!< The state of the xorshift generator used for the priorities of entries
+
+        u32 NextPriority() {
+            priorityState ^= priorityState << 13;
+            priorityState ^= priorityState >> 17;
+            priorityState ^= priorityState << 5;
+            return priorityState;
+        }
+
+        /**
+         * @return If entry `a` is ordered before entry `b` in the tree, entries with the same start are ordered by their index
+         */
+        bool IsOrderedBefore(u32 a, u32 b) const {
+            return entries[a].start < entries[b].start || (entries[a].start == entries[b].start && a < b);
+        }
+
+        void UpdateMaxEnd(u32 index) {
+            auto &entry{entries[index]};
+            entry.maxEnd = entry.end;
+            if (entry.left != NullEntry)
+                entry.maxEnd = std::max(entry.maxEnd, entries[entry.left].maxEnd);
+            if (entry.right != NullEntry)
+                entry.maxEnd = std::max(entry.maxEnd, entries[entry.right].maxEnd);
+        }
+
+        /**
+         * @return The subtrees of all entries ordered before the key entry and of all other entries
+         */
+        std::pair<u32, u32> Split(u32 index, u32 key) {
+            if (index == NullEntry)
+                return {NullEntry, NullEntry};
+
+            if (IsOrderedBefore(index, key)) {
+                auto [lower, upper]{Split(entries[index].right, key)};
+                entries[index].right = lower;
+                UpdateMaxEnd(index);
+                return {index, upper};
+            } else {
+                auto [lower, upper]{Split(entries[index].left, key)};
+                entries[index].left = upper;
+                UpdateMaxEnd(index);
+                return {lower, index};
+            }
+        }
+
+        /**
+         * @brief Merges two subtrees where all entries in the lower one are ordered before those in the upper one
+         */
+        u32 Merge(u32 lower, u32 upper) {
+            if (lower == NullEntry)
+                return upper;
+            if (upper == NullEntry)
+                return lower;
+
+            if (entries[lower].priority > entries[upper].priority) {
+                u32 right{Merge(entries[lower].right, upper)};
+                entries[lower].right = right;
+                UpdateMaxEnd(lower);
+                return lower;
+            } else {
+                u32 left{Merge(lower, entries[upper].left)};
+                entries[upper].left = left;
+                UpdateMaxEnd(upper);
+                return upper;
+            }
+        }
+
+        /**
+         * @return The root of the subtree after inserting the entry into it
+         */
+        u32 InsertEntry(u32 index, u32 entry) {
+            if (index == NullEntry)
+                return entry;
+
+            if (entries[entry].priority > entries[index].priority) {
+                auto [lower, upper]{Split(index, entry)};
+                entries[entry].left = lower;
+                entries[entry].right = upper;
+                UpdateMaxEnd(entry);
+                return entry;
+            }
+
+            if (IsOrderedBefore(entry, index)) {
+                u32 left{InsertEntry(entries[index].left, entry)};
+                entries[index].left = left;
+            } else {
+                u32 right{InsertEntry(entries[index].right, entry)};
+                entries[index].right = right;
+            }
+            UpdateMaxEnd(index);
+            return index;
+        }
+
+        /**
+         * @return The root of the subtree after removing the entry from it
+         */
+        u32 EraseEntry(u32 index, u32 entry) {
+            if (index == entry)
+                return Merge(entries[index].left, entries[index].right);
+
+            if (IsOrderedBefore(entry, index)) {
+                u32 left{EraseEntry(entries[index].left, entry)};
+                entries[index].left = left;
+            } else {
+                u32 right{EraseEntry(entries[index].right, entry)};
+                entries[index].right = right;
+            }
+            UpdateMaxEnd(index);
+            return index;
+        }
+
+        void AddEntry(Interval interval, GroupHandle group) {
+            u32 index;
+            if (!freeEntries.empty()) {
+                index = freeEntries.back();
+                freeEntries.pop_back();
+                entries[index] = Entry{interval.start, interval.end, group, NextPriority()};
+            } else {
+                index = static_cast<u32>(entries.size());
+                entries.emplace_back(interval.start, interval.end, group, NextPriority());
+            }
+
+            root = InsertEntry(root, index);
+            group->entries.push_back(index);
+        }
+
+        /**
+         * @brief Visits all entries overlapping with the interval in order of their start
+         * @param visitor A callable taking an Entry reference that returns false to stop visiting
+         * @return If all overlapping entries were visited without the visitor stopping
+         */
+        template<typename Visitor>
+        bool VisitOverlapping(u32 index, Interval interval, Visitor &visitor) {
+            if (index == NullEntry || entries[index].maxEnd <= interval.start)
+                return true; // No entry in this subtree ends after the start of the interval
+
+            if (!VisitOverlapping(entries[index].left, interval, visitor))
+                return false;
+
+            auto &entry{entries[index]};
+            if (entry.start >= interval.end)
+                return true; // This entry and all entries in the right subtree start after the end of the interval
+
+            if (entry.end > interval.start && !visitor(entry))
+                return false;
+
+            return VisitOverlapping(entry.right, interval, visitor);
+        }
+
+        template<typename Visitor>
+        bool VisitOverlapping(Interval interval, Visitor &&visitor) {
+            return VisitOverlapping(root, interval, visitor);
+        }
+
+        /**
+         * @brief Inserts the interval into a vector of intervals sorted by their start
+         */
+        static void InsertSorted(std::vector<Interval> &intervals, Interval interval) {
+            intervals.emplace(std::lower_bound(intervals.begin(), intervals.end(), interval.start), interval);
+        }
 
       public:
         IntervalMap() = default;
@@ -100,14 +269,14 @@ namespace skyline {
 
         GroupHandle Insert(AddressType start, AddressType end, EntryType value) {
             GroupHandle group{groups.emplace(groups.begin(), Interval{start, end}, value)};
-            entries.emplace(std::lower_bound(entries.begin(), entries.end(), end), start, end, group);
+            AddEntry(Interval{start, end}, group);
             return group;
         }
 
         GroupHandle Insert(span<Interval> intervals, EntryType value) {
             GroupHandle group{groups.emplace(groups.begin(), intervals, value)};
             for (const auto &interval : intervals)
-                entries.emplace(std::lower_bound(entries.begin(), entries.end(), interval.end), interval.start, interval.end, group);
+                AddEntry(interval, group);
             return group;
         }
 
@@ -115,16 +284,14 @@ namespace skyline {
         GroupHandle Insert(span<span<T>> intervals, EntryType value) requires std::is_pointer_v<AddressType> {
             GroupHandle group{groups.emplace(groups.begin(), intervals, std::move(value))};
             for (const auto &interval : intervals)
-                entries.emplace(std::lower_bound(entries.begin(), entries.end(), interval.data()), interval.data(), interval.data() + interval.size(), group);
+                AddEntry(Interval{interval.data(), interval.data() + interval.size()}, group);
             return group;
         }
 
         void Remove(GroupHandle group) {
-            for (auto it{entries.begin()}; it != entries.end();) {
-                if (it->group == group)
-                    it = entries.erase(it);
-                else
-                    it++;
+            for (u32 index : group->entries) {
+                root = EraseEntry(root, index);
+                freeEntries.push_back(index);
             }
             groups.erase(group);
         }
@@ -133,95 +300,95 @@ namespace skyline {
          * @return A nullable pointer to any entry overlapping with the given address
          */
         EntryType *Get(AddressType address) {
-            for (auto entryIt{std::lower_bound(entries.begin(), entries.end(), address)}; entryIt != entries.begin() && (--entryIt)->start <= address;)
-                if (entryIt->end > address)
-                    return &entryIt->group->value;
-
-            return nullptr;
+            EntryType *result{};
+            VisitOverlapping(Interval{address, address + 1}, [&](Entry &entry) {
+                result = &entry.group->value;
+                return false;
+            });
+            return result;
         }
 
         /**
-         * @return A vector of non-nullable pointers to entries overlapping with the given interval
+         * @param result A vector that's cleared and filled with non-nullable pointers to entries overlapping with the given interval, this is supplied by the caller so its allocation can be reused
          */
-        std::vector<std::reference_wrapper<EntryType>> GetRange(Interval interval) {
-            std::vector<std::reference_wrapper<EntryType>> result;
-            for (auto entry{std::lower_bound(entries.begin(), entries.end(), interval.end)}; entry != entries.begin() && (--entry)->start < interval.end;)
-                if (entry->end > interval.start && !IsGroupInEntries(entry->group, result))
-                    result.emplace_back(entry->group->value);
-
-            return result;
+        void GetRange(Interval interval, std::vector<std::reference_wrapper<EntryType>> &result) {
+            result.clear();
+            VisitOverlapping(interval, [&](Entry &entry) {
+                if (!IsGroupInEntries(entry.group, result))
+                    result.emplace_back(entry.group->value);
+                return true;
+            });
         }
 
         /**
-         * @return All entries overlapping with the given interval and a list of intervals they recursively cover with alignment for page-based lookup semantics
+         * @brief Finds all entries overlapping with the given interval and a list of intervals they recursively cover with alignment for page-based lookup semantics
+         * @param queryEntries A vector that's cleared and filled with the entries, this is supplied by the caller so its allocation can be reused
+         * @param intervals A vector that's cleared and filled with the coalesced intervals sorted by their start
          * @note This function is specifically designed for memory faulting lookups and has design-decisions that correspond to that which might not work for other uses
          */
         template<size_t Alignment>
-        std::pair<std::vector<std::reference_wrapper<EntryType>>, std::vector<Interval>> GetAlignedRecursiveRange(Interval interval) {
-            std::vector<std::reference_wrapper<EntryType>> queryEntries;
-            std::vector<Interval> intervals;
+        void GetAlignedRecursiveRange(Interval interval, std::vector<std::reference_wrapper<EntryType>> &queryEntries, std::vector<Interval> &intervals) {
+            queryEntries.clear();
+            intervals.clear();
 
             interval = interval.Align(Alignment);
 
-            auto entry{std::lower_bound(entries.begin(), entries.end(), interval.end)};
-            bool exclusiveEntry{entry == entries.begin() || std::prev(entry) == entries.begin() || std::prev(entry, 2)->start >= interval.end}; //!< If this entry exclusively occupies an aligned region
-            while (entry != entries.begin() && (--entry)->start < interval.end) {
-                if (entry->end > interval.start && !IsGroupInEntries(entry->group, queryEntries)) {
-                    // We found a unique and overlapping entry in the supplied interval
-                    queryEntries.emplace_back(entry->group->value);
-
-                    for (const auto &entryInterval : entry->group->intervals) {
-                        /* We need to find intervals that are covered by this entry and adding which will minimize future calls to this function, these are designed with memory faulting in mind. There's a few cases to consider:
-                         * 1. The entry exclusively occupies the lookup region - Entries are assumed to be rarely accessed in a partial manner, so we want to get add all intervals covered by the entry which includes all entries on those intervals and all exclusive intervals covered by those entries recursively
-                         * 2. The entry doesn't exclusively occupy the lookup region - We want to get all exclusive intervals covered by the entry where the entry is the only entry on those intervals, this is as we don't know what entry will be read in its entirety
-                         * 3. The entry doesn't exclusively occupy the lookup region, but the interval matches the entry's interval - This case is implicitly the same as (1) as we want to add all entries overlapping with the current interval
-                         */
-
-                        auto alignedEntryInterval{entryInterval.Align(Alignment)};
-
-                        if (exclusiveEntry || entryInterval == *entry) {
-                            // Case (1)/(3) - We want to add all entries overlapping with the current interval and their exclusive intervals recursively
-                            for (auto recursedEntry{std::lower_bound(entries.begin(), entries.end(), alignedEntryInterval.end)}; recursedEntry != entries.begin() && (--recursedEntry)->start < alignedEntryInterval.end;) {
-                                if (recursedEntry->end > alignedEntryInterval.start && recursedEntry->group != entry->group && !IsGroupInEntries(recursedEntry->group, queryEntries)) {
-                                    queryEntries.emplace_back(recursedEntry->group->value);
-
-                                    for (const auto &entryInterval2 : recursedEntry->group->intervals) {
-                                        // Similar to case (2) below but for the recursed entry
-                                        bool exclusiveIntervalEntry{true};
-                                        auto alignedEntryInterval2{entryInterval2.Align(Alignment)};
-
-                                        auto recursedEntry2{std::lower_bound(entries.begin(), entries.end(), alignedEntryInterval2.end)};
-                                        for (; recursedEntry2 != entries.begin() && (--recursedEntry2)->start < alignedEntryInterval2.end;) {
-                                            if (recursedEntry2->end > alignedEntryInterval2.start && recursedEntry2->group != recursedEntry->group && recursedEntry2->group != entry->group) {
-                                                exclusiveIntervalEntry = false;
-                                                break;
-                                            }
-                                        }
-
-                                        if (exclusiveIntervalEntry)
-                                            intervals.emplace(std::lower_bound(intervals.begin(), intervals.end(), alignedEntryInterval2.end), alignedEntryInterval2);
-                                    }
-                                }
-                            }
+            size_t overlappingCount{};
+            VisitOverlapping(interval, [&](Entry &) {
+                return ++overlappingCount < 2;
+            });
+            bool exclusiveEntry{overlappingCount < 2}; //!< If a single entry exclusively occupies the aligned region
 
-                            intervals.emplace(std::lower_bound(intervals.begin(), intervals.end(), alignedEntryInterval.start), alignedEntryInterval);
-                        } else {
-                            // Case (2) - We only want to add this interval if it only contains the entry
-                            bool exclusiveIntervalEntry{true};
+            VisitOverlapping(interval, [&](Entry &entry) {
+                if (IsGroupInEntries(entry.group, queryEntries))
+                    return true;
 
-                            for (auto recursedEntry{std::lower_bound(entries.begin(), entries.end(), alignedEntryInterval.end)}; recursedEntry != entries.begin() && (--recursedEntry)->start < alignedEntryInterval.end;) {
-                                if (recursedEntry->end > alignedEntryInterval.start && recursedEntry->group != entry->group) {
-                                    exclusiveIntervalEntry = false;
-                                    break;
-                                }
-                            }
+                // We found a unique and overlapping entry in the supplied interval
+                queryEntries.emplace_back(entry.group->value);
 
-                            if (exclusiveIntervalEntry)
-                                intervals.emplace(std::lower_bound(intervals.begin(), intervals.end(), alignedEntryInterval.start), alignedEntryInterval);
-                        }
+                for (const auto &entryInterval : entry.group->intervals) {
+                    /* We need to find intervals that are covered by this entry and adding which will minimize future calls to this function, these are designed with memory faulting in mind. There's a few cases to consider:
+                     * 1. The entry exclusively occupies the lookup region - Entries are assumed to be rarely accessed in a partial manner, so we want to get add all intervals covered by the entry which includes all entries on those intervals and all exclusive intervals covered by those entries recursively
+                     * 2. The entry doesn't exclusively occupy the lookup region - We want to get all exclusive intervals covered by the entry where the entry is the only entry on those intervals, this is as we don't know what entry will be read in its entirety
+                     * 3. The entry doesn't exclusively occupy the lookup region, but the interval matches the entry's interval - This case is implicitly the same as (1) as we want to add all entries overlapping with the current interval
+                     */
+
+                    auto alignedEntryInterval{entryInterval.Align(Alignment)};
+
+                    if (exclusiveEntry || entryInterval == entry) {
+                        // Case (1)/(3) - We want to add all entries overlapping with the current interval and their exclusive intervals recursively
+                        VisitOverlapping(alignedEntryInterval, [&](Entry &recursedEntry) {
+                            if (recursedEntry.group == entry.group || IsGroupInEntries(recursedEntry.group, queryEntries))
+                                return true;
+
+                            queryEntries.emplace_back(recursedEntry.group->value);
+
+                            for (const auto &entryInterval2 : recursedEntry.group->intervals) {
+                                // Similar to case (2) below but for the recursed entry
+                                auto alignedEntryInterval2{entryInterval2.Align(Alignment)};
+                                bool exclusiveIntervalEntry{VisitOverlapping(alignedEntryInterval2, [&](Entry &otherEntry) {
+                                    return otherEntry.group == recursedEntry.group || otherEntry.group == entry.group;
+                                })};
+
+                                if (exclusiveIntervalEntry)
+                                    InsertSorted(intervals, alignedEntryInterval2);
+                            }
+                            return true;
+                        });
+
+                        InsertSorted(intervals, alignedEntryInterval);
+                    } else {
+                        // Case (2) - We only want to add this interval if it only contains the entry
+                        bool exclusiveIntervalEntry{VisitOverlapping(alignedEntryInterval, [&](Entry &otherEntry) {
+                            return otherEntry.group == entry.group;
+                        })};
+
+                        if (exclusiveIntervalEntry)
+                            InsertSorted(intervals, alignedEntryInterval);
                     }
                 }
-            }
+                return true;
+            });
 
             // Coalescing pass for combining all intervals that are adjacent to each other
             for (auto it{intervals.begin()}; it != intervals.end();) {
@@ -236,13 +403,11 @@ namespace skyline {
                     it++;
                 }
             }
-
-            return std::pair{queryEntries, intervals};
         }
 
         template<size_t Alignment>
-        std::pair<std::vector<std::reference_wrapper<EntryType>>, std::vector<Interval>> GetAlignedRecursiveRange(AddressType address) {
-            return GetAlignedRecursiveRange<Alignment>(Interval{address, address + 1});
+        void GetAlignedRecursiveRange(AddressType address, std::vector<std::reference_wrapper<EntryType>> &queryEntries, std::vector<Interval> &intervals) {
+            GetAlignedRecursiveRange<Alignment>(Interval{address, address + 1}, queryEntries, intervals);
         }
     };
 }
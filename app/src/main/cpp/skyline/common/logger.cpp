@@ -2,41 +2,189 @@
 // Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
 #include <android/log.h>
+#include <cstring>
+#include <thread>
+#include "spsc_queue.h"
 #include "utils.h"
 #include "logger.h"
 
 namespace skyline {
+    namespace {
+        /**
+         * @brief A single fixed-size log record, messages that don't fit into a single record are split across several consecutive records
+         */
+        struct LogRecord {
+            static constexpr size_t MessageSize{200};
+
+            Logger::LoggerContext *context; //!< The context the message should be written to, this is nullptr if it should only be written to logcat
+            i64 timestamp; //!< The time at which the message was logged in milliseconds
+            Logger::LogLevel level;
+            bool continued; //!< If the message is continued in the following record
+            u16 length; //!< The amount of characters of the message in this record
+            std::array<char, 16> threadName;
+            std::array<char, MessageSize> message;
+        };
+        static_assert(sizeof(LogRecord) <= 256);
+
+        /**
+         * @brief The queue of log records produced by a single thread, it's kept alive by the logger thread after its thread has exited till it's drained
+         */
+        struct ThreadLogQueue {
+            static constexpr size_t RecordCount{256}; //!< The amount of records that can be queued by a thread before it blocks on the logger thread
+
+            SpscQueue<LogRecord> records{RecordCount};
+            std::atomic<bool> exited{}; //!< If the thread has exited and no more records will be produced
+        };
+
+        /**
+         * @brief The state of the logger thread which writes out the records from all thread queues
+         */
+        struct LogWriter {
+            std::mutex queueMutex; //!< Synchronizes access to the vector of queues
+            std::vector<std::shared_ptr<ThreadLogQueue>> queues;
+            std::mutex drainMutex; //!< Only a single thread may consume records at a time, this is held by the logger thread while draining and by any thread which flushes
+            std::string message; //!< A buffer used to reassemble messages from their records, this is only accessed with the drain mutex held
+            std::atomic<u32> sequence{}; //!< Incremented after every queued record, this is the futex word the logger thread waits on
+            std::atomic<bool> waiting{}; //!< If the logger thread is waiting (or about to wait) on the futex
+            std::once_flag threadFlag;
+        };
+
+        LogWriter writer;
+
+        /**
+         * @brief Writes out all queued records from every thread
+         * @note The drain mutex **must** be locked by the calling thread
+         */
+        void DrainRecords() {
+            constexpr std::array<char, 5> levelCharacter{'E', 'W', 'I', 'D', 'V'}; // The LogLevel as written out to a file
+            constexpr std::array<int, 5> levelAlog{ANDROID_LOG_ERROR, ANDROID_LOG_WARN, ANDROID_LOG_INFO, ANDROID_LOG_DEBUG, ANDROID_LOG_VERBOSE}; // This corresponds to LogLevel and provides its equivalent for NDK Logging
+
+            std::scoped_lock lock{writer.queueMutex};
+            for (auto it{writer.queues.begin()}; it != writer.queues.end();) {
+                auto &queue{**it};
+                bool exited{queue.exited.load(std::memory_order_acquire)}; // This must be read prior to draining so no records can be queued after the queue is removed
+
+                LogRecord record;
+                while (queue.records.TryPop(record)) {
+                    writer.message.append(record.message.data(), record.length);
+                    if (record.continued)
+                        continue;
+
+                    std::array<char, 25> tag{};
+                    std::snprintf(tag.data(), tag.size(), "emu-cpp-%s", record.threadName.data());
+                    __android_log_write(levelAlog[static_cast<u8>(record.level)], tag.data(), writer.message.c_str());
+
+                    if (record.context)
+                        // We use RS (\036) and GS (\035) as our delimiters
+                        record.context->Write(fmt::format("\036{}\035{}\035{}\035{}\n", levelCharacter[static_cast<u8>(record.level)], record.timestamp - record.context->start, record.threadName.data(), writer.message));
+
+                    writer.message.clear();
+                }
+
+                if (exited)
+                    it = writer.queues.erase(it);
+                else
+                    ++it;
+            }
+        }
+
+        [[noreturn]] void LoggerThread() {
+            pthread_setname_np(pthread_self(), "Sky-Logger");
+
+            while (true) {
+                u32 sequence{writer.sequence.load(std::memory_order_seq_cst)};
+                {
+                    std::scoped_lock lock{writer.drainMutex};
+                    DrainRecords();
+                }
+
+                writer.waiting.store(true, std::memory_order_seq_cst);
+                if (writer.sequence.load(std::memory_order_seq_cst) == sequence)
+                    syscall(SYS_futex, reinterpret_cast<u32 *>(&writer.sequence), FUTEX_WAIT_PRIVATE, sequence, nullptr, nullptr, 0); // Spurious wakeups (EINTR) and value mismatches (EAGAIN) are handled by draining again
+                writer.waiting.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * @brief A holder for the log queue of the current thread which marks it as exited when the thread exits
+         */
+        struct ThreadLogQueueHolder {
+            std::shared_ptr<ThreadLogQueue> queue;
+
+            ~ThreadLogQueueHolder() {
+                if (queue)
+                    queue->exited.store(true, std::memory_order_release);
+            }
+        };
+
+        thread_local ThreadLogQueueHolder threadQueue;
+
+        /**
+         * @brief Wakes the logger thread if it's waiting for records
+         */
+        void NotifyLoggerThread() {
+            writer.sequence.fetch_add(1, std::memory_order_seq_cst);
+            if (writer.waiting.load(std::memory_order_seq_cst))
+                syscall(SYS_futex, reinterpret_cast<u32 *>(&writer.sequence), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+        }
+
+        ThreadLogQueue &GetThreadLogQueue() {
+            if (!threadQueue.queue) [[unlikely]] {
+                std::call_once(writer.threadFlag, [] {
+                    std::thread(LoggerThread).detach();
+                });
+
+                threadQueue.queue = std::make_shared<ThreadLogQueue>();
+                std::scoped_lock lock{writer.queueMutex};
+                writer.queues.push_back(threadQueue.queue);
+            }
+            return *threadQueue.queue;
+        }
+    }
+
     void Logger::LoggerContext::Initialize(const std::string &path) {
         start = util::GetTimeNs() / constant::NsInMillisecond;
         logFile.open(path, std::ios::trunc);
     }
 
     void Logger::LoggerContext::Finalize() {
+        {
+            std::scoped_lock lock{writer.drainMutex};
+            DrainRecords();
+        }
+
         std::scoped_lock lock{mutex};
         logFile.close();
     }
 
     void Logger::LoggerContext::TryFlush() {
+        {
+            std::unique_lock lock(writer.drainMutex, std::try_to_lock);
+            if (lock)
+                DrainRecords();
+        }
+
         std::unique_lock lock(mutex, std::try_to_lock);
         if (lock)
             logFile.flush();
     }
 
     void Logger::LoggerContext::Flush() {
+        {
+            std::scoped_lock lock{writer.drainMutex};
+            DrainRecords();
+        }
+
         std::scoped_lock lock{mutex};
         logFile.flush();
     }
 
-    thread_local static std::string logTag, threadName;
+    thread_local static std::array<char, 16> threadName{};
     thread_local static Logger::LoggerContext *context{&Logger::EmulationContext};
 
     void Logger::UpdateTag() {
-        std::array<char, 16> name;
-        if (!pthread_getname_np(pthread_self(), name.data(), name.size()))
-            threadName = name.data();
-        else
-            threadName = "unk";
-        logTag = std::string("emu-cpp-") + threadName;
+        if (pthread_getname_np(pthread_self(), threadName.data(), threadName.size()))
+            std::strcpy(threadName.data(), "unk");
     }
 
     Logger::LoggerContext *Logger::GetContext() {
@@ -47,24 +195,29 @@ namespace skyline {
         context = pContext;
     }
 
-    void Logger::WriteAndroid(LogLevel level, const std::string &str) {
-        constexpr std::array<int, 5> levelAlog{ANDROID_LOG_ERROR, ANDROID_LOG_WARN, ANDROID_LOG_INFO, ANDROID_LOG_DEBUG, ANDROID_LOG_VERBOSE}; // This corresponds to LogLevel and provides its equivalent for NDK Logging
-        if (logTag.empty())
+    void Logger::Write(LogLevel level, std::string_view str) {
+        auto &queue{GetThreadLogQueue()};
+        if (!threadName[0])
             UpdateTag();
 
-        __android_log_write(levelAlog[static_cast<u8>(level)], logTag.c_str(), str.c_str());
-    }
-
-    void Logger::Write(LogLevel level, const std::string &str) {
-        constexpr std::array<char, 5> levelCharacter{'E', 'W', 'I', 'D', 'V'}; // The LogLevel as written out to a file
-        WriteAndroid(level, str);
+        LogRecord record{
+            .context = context,
+            .timestamp = util::GetTimeNs() / constant::NsInMillisecond,
+            .level = level,
+            .threadName = threadName,
+        };
 
-        if (context)
-            // We use RS (\036) and GS (\035) as our delimiters
-            context->Write(fmt::format("\036{}\035{}\035{}\035{}\n", levelCharacter[static_cast<u8>(level)], (util::GetTimeNs() / constant::NsInMillisecond) - context->start, threadName, str));
+        do {
+            record.length = static_cast<u16>(std::min(str.size(), LogRecord::MessageSize));
+            std::memcpy(record.message.data(), str.data(), record.length);
+            str.remove_prefix(record.length);
+            record.continued = !str.empty();
+            queue.records.Push(record);
+            NotifyLoggerThread(); // The logger thread is notified after every record as the queue might fill up prior to the message being completely queued
+        } while (!str.empty());
     }
 
-    void Logger::LoggerContext::Write(const std::string &str) {
+    void Logger::LoggerContext::Write(std::string_view str) {
         std::scoped_lock guard{mutex};
         logFile << str;
     }
@@ -10,6 +10,7 @@
 namespace skyline {
     /**
      * @brief A wrapper around writing logs into a log file and logcat using Android Log APIs
+     * @note Messages are formatted on the calling thread into fixed-size binary records in a per-thread queue, these are written out by a dedicated logger thread so the calling thread never blocks on I/O
      */
     class Logger {
       private:
@@ -24,13 +25,19 @@ namespace skyline {
             Verbose,
         };
 
+        #ifdef NDEBUG
+        static constexpr LogLevel CompiledLevel{LogLevel::Info}; //!< The maximum level of logs that are compiled in, calls for any levels above this are stripped entirely
+        #else
+        static constexpr LogLevel CompiledLevel{LogLevel::Verbose};
+        #endif
+
         static inline LogLevel configLevel{LogLevel::Verbose}; //!< The minimum level of logs to write
 
         /**
          * @brief Holds logger variables that cannot be static
          */
         struct LoggerContext {
-            std::mutex mutex; //!< Synchronizes all output I/O to ensure there are no races
+            std::mutex mutex; //!< Synchronizes all output I/O to ensure there are no races, writes are only done by the logger thread but flushing can be done from any thread
             std::ofstream logFile; //!< An output stream to the log file
             i64 start; //!< A timestamp in milliseconds for when the logger was started, this is used as the base for all log timestamps
 
@@ -40,11 +47,18 @@ namespace skyline {
 
             void Finalize();
 
+            /**
+             * @brief Writes out all queued logs and flushes the log file if it can be done without blocking
+             * @note This is safe to call from a signal handler that might've interrupted the logger
+             */
             void TryFlush();
 
+            /**
+             * @brief Writes out all queued logs and flushes the log file
+             */
             void Flush();
 
-            void Write(const std::string &str);
+            void Write(std::string_view str);
         };
         static inline LoggerContext EmulationContext, LoaderContext;
 
@@ -57,9 +71,11 @@ namespace skyline {
 
         static void SetContext(LoggerContext *context);
 
-        static void WriteAndroid(LogLevel level, const std::string &str);
-
-        static void Write(LogLevel level, const std::string &str);
+        /**
+         * @brief Queues a log message to be written out to logcat and the log file of the current context by the logger thread
+         * @note This doesn't allocate or take any locks unless the thread hasn't logged before, it only blocks if the thread's log queue is full
+         */
+        static void Write(LogLevel level, std::string_view str);
 
         /**
          * @brief A wrapper around a string which captures the calling function using Clang source location builtins
@@ -72,112 +88,98 @@ namespace skyline {
             const char *function;
 
             FunctionString(S string, const char *function = __builtin_FUNCTION()) : string(std::move(string)), function(function) {}
+        };
 
-            std::string operator*() {
-                return std::string(function) + ": " + std::string(string);
+        /**
+         * @brief Formats a log message into a stack buffer and queues it, if the level is enabled
+         * @param function The name of the function to prefix the message with, nullptr if there should be no prefix
+         */
+        template<LogLevel Level, typename S, typename... Args>
+        static void Log(const char *function, const S &formatString, Args &&... args) {
+            if constexpr (Level <= CompiledLevel) {
+                if (Level <= configLevel) {
+                    fmt::memory_buffer buffer;
+                    if (function)
+                        fmt::format_to(std::back_inserter(buffer), "{}: ", function);
+                    fmt::format_to(std::back_inserter(buffer), fmt::runtime(formatString), util::FmtCast(args)...);
+                    Write(Level, std::string_view{buffer.data(), buffer.size()});
+                }
             }
-        };
+        }
 
         template<typename... Args>
         static void Error(FunctionString<const char *> formatString, Args &&... args) {
-            if (LogLevel::Error <= configLevel)
-                Write(LogLevel::Error, util::Format(*formatString, args...));
+            Log<LogLevel::Error>(formatString.function, formatString.string, args...);
         }
 
         template<typename... Args>
         static void Error(FunctionString<std::string> formatString, Args &&... args) {
-            if (LogLevel::Error <= configLevel)
-                Write(LogLevel::Error, util::Format(*formatString, args...));
+            Log<LogLevel::Error>(formatString.function, formatString.string, args...);
         }
 
         template<typename S, typename... Args>
         static void ErrorNoPrefix(S formatString, Args &&... args) {
-            if (LogLevel::Error <= configLevel)
-                Write(LogLevel::Error, util::Format(formatString, args...));
+            Log<LogLevel::Error>(nullptr, formatString, args...);
         }
 
         template<typename... Args>
         static void Warn(FunctionString<const char *> formatString, Args &&... args) {
-            if (LogLevel::Warn <= configLevel)
-                Write(LogLevel::Warn, util::Format(*formatString, args...));
+            Log<LogLevel::Warn>(formatString.function, formatString.string, args...);
         }
 
         template<typename... Args>
         static void Warn(FunctionString<std::string> formatString, Args &&... args) {
-            if (LogLevel::Warn <= configLevel)
-                Write(LogLevel::Warn, util::Format(*formatString, args...));
+            Log<LogLevel::Warn>(formatString.function, formatString.string, args...);
         }
 
         template<typename S, typename... Args>
         static void WarnNoPrefix(S formatString, Args &&... args) {
-            if (LogLevel::Warn <= configLevel)
-                Write(LogLevel::Warn, util::Format(formatString, args...));
+            Log<LogLevel::Warn>(nullptr, formatString, args...);
         }
 
         template<typename... Args>
         static void Info(FunctionString<const char *> formatString, Args &&... args) {
-            if (LogLevel::Info <= configLevel)
-                Write(LogLevel::Info, util::Format(*formatString, args...));
+            Log<LogLevel::Info>(formatString.function, formatString.string, args...);
         }
 
         template<typename... Args>
         static void Info(FunctionString<std::string> formatString, Args &&... args) {
-            if (LogLevel::Info <= configLevel)
-                Write(LogLevel::Info, util::Format(*formatString, args...));
+            Log<LogLevel::Info>(formatString.function, formatString.string, args...);
         }
 
         template<typename S, typename... Args>
         static void InfoNoPrefix(S formatString, Args &&... args) {
-            if (LogLevel::Info <= configLevel)
-                Write(LogLevel::Info, util::Format(formatString, args...));
+            Log<LogLevel::Info>(nullptr, formatString, args...);
         }
 
         template<typename... Args>
         static void Debug(FunctionString<const char *> formatString, Args &&... args) {
-            #ifndef NDEBUG
-            if (LogLevel::Debug <= configLevel)
-                Write(LogLevel::Debug, util::Format(*formatString, args...));
-            #endif
+            Log<LogLevel::Debug>(formatString.function, formatString.string, args...);
         }
 
         template<typename... Args>
         static void Debug(FunctionString<std::string> formatString, Args &&... args) {
-            #ifndef NDEBUG
-            if (LogLevel::Debug <= configLevel)
-                Write(LogLevel::Debug, util::Format(*formatString, args...));
-            #endif
+            Log<LogLevel::Debug>(formatString.function, formatString.string, args...);
         }
 
         template<typename S, typename... Args>
         static void DebugNoPrefix(S formatString, Args &&... args) {
-            #ifndef NDEBUG
-            if (LogLevel::Debug <= configLevel)
-                Write(LogLevel::Debug, util::Format(formatString, args...));
-            #endif
+            Log<LogLevel::Debug>(nullptr, formatString, args...);
         }
 
         template<typename... Args>
         static void Verbose(FunctionString<const char *> formatString, Args &&... args) {
-            #ifndef NDEBUG
-            if (LogLevel::Verbose <= configLevel)
-                Write(LogLevel::Verbose, util::Format(*formatString, args...));
-            #endif
+            Log<LogLevel::Verbose>(formatString.function, formatString.string, args...);
         }
 
         template<typename... Args>
         static void Verbose(FunctionString<std::string> formatString, Args &&... args) {
-            #ifndef NDEBUG
-            if (LogLevel::Verbose <= configLevel)
-                Write(LogLevel::Verbose, util::Format(*formatString, args...));
-            #endif
+            Log<LogLevel::Verbose>(formatString.function, formatString.string, args...);
         }
 
         template<typename S, typename... Args>
         static void VerboseNoPrefix(S formatString, Args &&... args) {
-            #ifndef NDEBUG
-            if (LogLevel::Verbose <= configLevel)
-                Write(LogLevel::Verbose, util::Format(formatString, args...));
-            #endif
+            Log<LogLevel::Verbose>(nullptr, formatString, args...);
         }
     };
 }
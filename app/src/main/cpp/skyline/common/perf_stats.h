@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <utility>
+#include <common/base.h>
+
+namespace skyline {
+    /**
+     * @brief A registry of performance counters which are accumulated across the emulator and sampled into per-frame values on every present
+     * @note All recording functions are lock-free and can be called from any thread, sampling must only be done from a single thread
+     */
+    class PerfStats {
+      public:
+        enum class Counter : u8 {
+            Draws, //!< The amount of draws performed by the 3D engine, including indirect draws
+            BatchedDraws, //!< The amount of draws that were merged into the command of a prior draw with identical state
+            DrawCpuNs, //!< The amount of CPU time spent by the 3D engine interconnect building draws in nanoseconds, divided by `Draws` this is the per-draw CPU cost
+            PipelineCompiles, //!< The amount of graphics and compute pipelines that were compiled
+            TextureCreations, //!< The amount of host textures created by the texture manager
+            TextureLinearMigrations, //!< The amount of textures which were migrated to a linear backing after being repeatedly written by the CPU
+            TextureMutableFormatPromotions, //!< The amount of textures whose backing was recreated with a mutable format as a view with a different format was required
+            TextureUploads, //!< The amount of guest texture contents that were copied into their host texture from a staging buffer or directly from the CPU
+            TextureUploadBytes, //!< The amount of bytes of guest texture contents copied into host textures
+            BufferCreations, //!< The amount of host buffers created by the buffer manager
+            MegaBufferBytes, //!< The amount of bytes allocated from megabuffers
+            StagingBufferAllocations, //!< The amount of staging buffers which required a new VkBuffer and allocation
+            StagingBufferReuses, //!< The amount of staging buffers which were recycled from the staging buffer pool
+            RedundantVertexBufferBinds, //!< The amount of vertex buffer binds that were skipped as the binding was already recorded into the command buffer
+            RedundantIndexBufferBinds, //!< The amount of index buffer binds that were skipped as the binding was already recorded into the command buffer
+            FenceWaitNs, //!< The amount of time spent blocking on the host GPU in FenceCycle::Wait in nanoseconds
+            GpfifoIdleNs, //!< The amount of time GPFIFO threads spent waiting on more GpEntries in nanoseconds
+            SvcCalls, //!< The amount of SVCs called by the guest
+            HostThreadCreations, //!< The amount of host threads that were created to run guest threads
+            HostThreadReuses, //!< The amount of guest threads which were started on an idle pooled host thread
+            Mprotects, //!< The amount of mprotect calls made to update NCE traps
+            BackingCacheHits, //!< The amount of blocks read from the decrypted block cache of CachedBacking
+            BackingCacheMisses, //!< The amount of reads on CachedBacking that had to read from the underlying backing
+            AudioCallbacks, //!< The amount of times the audio callback was called
+            AudioCallbackNs, //!< The amount of time spent in the audio callback in nanoseconds
+            AudioUnderruns, //!< The amount of times a playing audio track ran out of samples partway through an audio callback
+            AudioXRuns, //!< The amount of underruns reported by the audio device itself
+            MirrorCreations, //!< The amount of guest memory mirrors that were mapped for textures and buffers
+            MirrorReuses, //!< The amount of textures and buffers that reused an existing mirror containing their pages
+            MirrorUnmaps, //!< The amount of guest memory mirrors that were unmapped, subtracted from `MirrorCreations` this is the amount of live mirrors
+            TextureHostCopies, //!< The amount of texture uploads that were written into the image directly from the CPU with VK_EXT_host_image_copy, these are included in `TextureUploads`
+            DefragmentationMoves, //!< The amount of images that were moved into other allocations by defragmentation passes
+            DefragmentationBytes, //!< The amount of bytes that were moved by defragmentation passes
+            NvdrvIoctls, //!< The amount of nvdrv ioctls that were handled
+            NvdrvIoctlNs, //!< The amount of time spent handling nvdrv ioctls in nanoseconds, divided by `NvdrvIoctls` this is the per-ioctl overhead
+
+            Count, //!< The amount of counters, this isn't a counter itself
+        };
+
+        static constexpr size_t CounterCount{static_cast<size_t>(Counter::Count)};
+
+        enum class Histogram : u8 {
+            FenceWait, //!< The durations of FenceCycle::Wait calls that blocked in microseconds
+            AudioFill, //!< The amount of frames buffered in playing audio tracks at the start of every audio callback
+            AudioCallback, //!< The durations of the audio callback in microseconds
+            InputLatency, //!< The durations between the oldest input event that a frame was rendered with and the frame being presented in microseconds
+            DrawCpu, //!< The durations of building individual draws in the 3D engine interconnect in nanoseconds, this is in nanoseconds rather than microseconds as most draws take under a microsecond
+            Oversleep, //!< The amount of time guest sleeps and timed waits overshot their deadline by in microseconds
+
+            Count, //!< The amount of histograms, this isn't a histogram itself
+        };
+
+        static constexpr size_t HistogramCount{static_cast<size_t>(Histogram::Count)};
+        static constexpr size_t HistogramBucketCount{16}; //!< The amount of log2 buckets in each histogram, the last bucket also holds all samples larger than it
+
+      private:
+        inline static std::array<std::atomic<u64>, CounterCount> totals{}; //!< The running totals of all counters since the last reset
+        inline static std::array<u64, CounterCount> sampledTotals{}; //!< The totals at the time of the last sample, only accessed by the sampling thread
+        inline static std::array<std::atomic<u64>, CounterCount> frameValues{}; //!< The values of all counters over the last sampled frame
+        inline static std::array<std::array<std::atomic<u64>, HistogramBucketCount>, HistogramCount> histograms{}; //!< All histograms since the last reset, the values are bucketed by their log2
+
+        PerfStats() {}
+
+      public:
+        static void Increment(Counter counter, u64 value = 1) {
+            totals[static_cast<size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Records a value into the bucket of the histogram corresponding to its log2
+         */
+        static void Record(Histogram histogram, u64 value) {
+            auto bucket{std::min<size_t>(static_cast<size_t>(std::bit_width(value)), HistogramBucketCount - 1)};
+            histograms[static_cast<size_t>(histogram)][bucket].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Records the duration of a blocking wait on the host GPU into the fence wait counter and histogram
+         */
+        static void RecordFenceWait(i64 durationNs) {
+            Increment(Counter::FenceWaitNs, static_cast<u64>(durationNs));
+            Record(Histogram::FenceWait, static_cast<u64>(durationNs) / 1000);
+        }
+
+        /**
+         * @brief Samples the counters into their per-frame values, this should be called once per presented frame
+         */
+        static void Sample() {
+            for (size_t i{}; i < CounterCount; i++) {
+                u64 total{totals[i].load(std::memory_order_relaxed)};
+                frameValues[i].store(total - std::exchange(sampledTotals[i], total), std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * @return The value of the counter over the last sampled frame
+         */
+        static u64 GetFrameValue(Counter counter) {
+            return frameValues[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @return The total value of the counter since the last reset
+         */
+        static u64 GetTotal(Counter counter) {
+            return totals[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @return The amount of samples in the supplied bucket of the histogram since the last reset
+         */
+        static u64 GetHistogramBucket(Histogram histogram, size_t bucket) {
+            return histograms[static_cast<size_t>(histogram)][bucket].load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Resets all counters and histograms, this should be done when emulation is started
+         */
+        static void Reset() {
+            for (size_t i{}; i < CounterCount; i++) {
+                totals[i].store(0, std::memory_order_relaxed);
+                sampledTotals[i] = 0;
+                frameValues[i].store(0, std::memory_order_relaxed);
+            }
+
+            for (auto &histogram : histograms)
+                for (auto &bucket : histogram)
+                    bucket.store(0, std::memory_order_relaxed);
+        }
+    };
+}
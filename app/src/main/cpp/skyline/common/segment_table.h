@@ -30,7 +30,7 @@ namespace skyline {
             SegmentType segment; //!< The segment associated with the entry, this is 0'd out if the entry is unset
         };
 
-        static constexpr size_t L2Size{1 << L2Bits}, L2Entries{util::DivideCeil(Size, L2Size)}, L1inL2Count{L1Size / L2Size};
+        static constexpr size_t L2Size{1 << L2Bits}, L2Entries{util::DivideCeil(Size, L2Size)}, L1inL2Count{L2Size / L1Size};
         span<RangeEntry, L2Entries> level2Table; //!< The second level of the segment table, this is the lowest granularity of the table
 
         template<typename Type, size_t Amount>
@@ -85,62 +85,51 @@ namespace skyline {
         }
 
         /**
-         * @brief Sets a segment of segments between the start and end to the supplied value
+         * @brief Sets the L1 entries within a single L2 entry to the supplied value, the L2 entry is split into L1 entries if it was valid
+         * @param l1Start The index of the first L1 entry to set, this must be within the L2 entry
+         * @param l1End The index of the L1 entry after the last one to set, this must be within or at the end of the L2 entry
          */
-        void Set(size_t start, size_t end, SegmentType segment) {
-            size_t l2AlignedAddress{util::AlignUp(start, L2Size)};
-
-            size_t l1StartPaddingStart{start >> L1Bits};
-            size_t l1StartPaddingEnd{l2AlignedAddress < end ? (l2AlignedAddress >> L1Bits) : (end >> L1Bits)};
-            if (l1StartPaddingStart != l1StartPaddingEnd) {
-                auto &l2Entry{level2Table[start >> L2Bits]};
-                if (l2Entry.valid) {
-                    l2Entry.valid = false;
-
-                    size_t l1L2Start{(start >> L2Bits) << (L2Bits - L1Bits)};
-                    for (size_t i{l1L2Start}; i < l1StartPaddingStart; i++)
-                        level1Table[i] = l2Entry.segment;
-
-                    for (size_t i{l1StartPaddingStart}; i < l1StartPaddingEnd; i++)
-                        level1Table[i] = segment;
-
-                    size_t l1L2End{l2AlignedAddress >> L1Bits};
-                    for (size_t i{l1StartPaddingEnd}; i < l1L2End; i++)
-                        level1Table[i] = l2Entry.segment;
-                } else {
-                    for (size_t i{l1StartPaddingStart}; i < l1StartPaddingEnd; i++)
-                        level1Table[i] = segment;
-                }
+        void SetPartial(size_t l2Index, size_t l1Start, size_t l1End, SegmentType segment) {
+            if (l1Start == l1End)
+                return;
+
+            auto &l2Entry{level2Table[l2Index]};
+            if (l2Entry.valid) {
+                // The L1 entries beneath a valid L2 entry are stale, the ones outside of the range need to inherit the segment of the L2 entry
+                l2Entry.valid = false;
+
+                size_t l1L2Start{l2Index << (L2Bits - L1Bits)};
+                std::fill(level1Table.data() + l1L2Start, level1Table.data() + l1Start, l2Entry.segment);
+                std::fill(level1Table.data() + l1End, level1Table.data() + l1L2Start + L1inL2Count, l2Entry.segment);
             }
 
-            if (end <= l2AlignedAddress)
+            std::fill(level1Table.data() + l1Start, level1Table.data() + l1End, segment);
+        }
+
+        /**
+         * @brief Sets a segment of segments between the start and end to the supplied value
+         * @note Any L2-aligned spans within the range are set with a single L2 entry each, only the unaligned edges are set at L1 granularity
+         */
+        void Set(size_t start, size_t end, SegmentType segment) {
+            if (start >= end)
                 return;
 
-            size_t l2IndexStart{l2AlignedAddress >> L2Bits};
-            size_t l2IndexEnd{end >> L2Bits};
-            for (size_t i{l2IndexStart}; i < l2IndexEnd; i++) {
+            size_t l2AlignedStart{util::AlignUp(start, L2Size)};
+            size_t l2AlignedEnd{util::AlignDown(end, L2Size)};
+
+            // The head of the range up to the first L2 boundary, this covers the entire range if it doesn't cross one
+            if (start < l2AlignedStart)
+                SetPartial(start >> L2Bits, start >> L1Bits, std::min(l2AlignedStart, end) >> L1Bits, segment);
+
+            for (size_t i{l2AlignedStart >> L2Bits}; i < (l2AlignedEnd >> L2Bits); i++) {
                 auto &l2Entry{level2Table[i]};
                 l2Entry.segment = segment;
                 l2Entry.valid = true;
             }
 
-            size_t l1EndPaddingStart{l2IndexEnd << (L2Bits - L1Bits)};
-            size_t l1EndPaddingEnd{end >> L1Bits};
-            if (l1EndPaddingStart != l1EndPaddingEnd) {
-                auto &l2Entry{level2Table[l2IndexEnd]};
-                if (l2Entry.valid) {
-                    l2Entry.valid = false;
-
-                    for (size_t i{l1EndPaddingStart}; i < l1EndPaddingEnd; i++)
-                        level1Table[i] = segment;
-
-                    for (size_t i{l1EndPaddingEnd}; i < l1EndPaddingStart + L1inL2Count; i++)
-                        level1Table[i] = l2Entry.segment;
-                } else {
-                    for (size_t i{l1EndPaddingStart}; i < l1EndPaddingEnd; i++)
-                        level1Table[i] = segment;
-                }
-            }
+            // The tail of the range after the last L2 boundary, this must not overlap with the head
+            if (l2AlignedEnd < end && l2AlignedEnd >= l2AlignedStart)
+                SetPartial(end >> L2Bits, l2AlignedEnd >> L1Bits, end >> L1Bits, segment);
         }
 
         /* Helpers for pointer-based access */
@@ -164,7 +153,7 @@ namespace skyline {
         }
 
         void Set(span<u8> span, SegmentType segment) {
-            Set(reinterpret_cast<size_t>(span.begin().base()), reinterpret_cast<size_t>(span.end().base()));
+            Set(reinterpret_cast<size_t>(span.begin().base()), reinterpret_cast<size_t>(span.end().base()), segment);
         }
     };
 }
@@ -63,19 +63,54 @@ namespace skyline {
         Setting<std::string> usernameValue; //!< The user name to be supplied to the guest
         Setting<language::SystemLanguage> systemLanguage; //!< The system language
         Setting<region::RegionCode> systemRegion; //!< The system region
+        Setting<bool> schedulerWorkStealing; //!< If threads can be stolen from the queues of busy cores by cores that become idle, this only applies to threads which have the idle core in their affinity mask
+        Setting<bool> hugePageGuestMemory; //!< If the heap and alias regions of the guest address space should be backed by transparent huge pages when the host kernel allows it
+        Setting<bool> executableCache; //!< If the decompressed segments of NSOs should be cached on disk so they don't need to be read and decompressed on later launches
+        Setting<bool> verifyRomIntegrity; //!< If the hash trees of NCA sections should be used to verify all data read from them
+        Setting<bool> audioTimeStretch; //!< If audio should be time-stretched to keep it continuous when emulation runs below full speed
+        Setting<bool> lowLatencyInput; //!< If input should additionally be sampled right before the guest is expected to read it
+        Setting<bool> hostThreadPlacement; //!< If host threads should be placed on big or little CPU cores based on their role and have their priorities adjusted accordingly
+        Setting<std::string> bigCoreOverride; //!< A list of CPUs in the kernel's CPU list format that should be treated as big cores, an empty string uses the CPU topology reported by the kernel
+        Setting<bool> idleLoopSkipping; //!< If guest threads polling the counter in a tight loop without making any SVCs should be detected and put to sleep to save power
+        Setting<std::string> idleLoopSkippingExclusions; //!< A comma-separated list of hexadecimal title IDs which idle loop skipping is disabled for
+        Setting<bool> hostMemoryFunctions; //!< If exported guest memcpy/memmove/memset/strlen functions should be replaced with branches to their host counterparts
+        Setting<bool> localWireless; //!< If local wireless networks should be emulated over the LAN the device is connected to
 
         // Display
         Setting<bool> forceTripleBuffering; //!< If the presentation engine should always triple buffer even if the swapchain supports double buffering
         Setting<bool> disableFrameThrottling; //!< Allow the guest to submit frames without any blocking calls
+        Setting<u32> framePacingMode; //!< How presented frames are paced, 0 favours smoothness while 1 favours input latency by presenting sooner and dropping stale frames
+        Setting<u32> emulationSpeed; //!< The speed of emulation as a percentage of real-time
+        Setting<u32> fastForwardSpeed; //!< The speed of emulation while fast-forwarding as a percentage of real-time, 0 if fast-forwarding is disabled
 
         // GPU
         Setting<std::string> gpuDriver; //!< The label of the GPU driver to use
         Setting<std::string> gpuDriverLibraryName; //!< The name of the GPU driver library to use
         Setting<u32> executorSlotCount; //!< Number of GPU executor slots that can be used concurrently
+        Setting<bool> dynamicExecutorSlots; //!< If the amount of executor slots in use should be tuned at runtime based on how long slots are waited on, the executor slot count is used as the upper bound in this case
         Setting<bool> enableTextureReadbackHack; //!< If the CPU texture readback skipping hack should be used
+        Setting<bool> discardTransientAttachments; //!< If the stores of depth/stencil attachments which are always entirely cleared and never used outside of render passes should be discarded
+        Setting<bool> asyncPipelineCompilation; //!< If pipelines should be compiled asynchronously on a pool of worker threads
+        Setting<bool> skipAsyncPipelineDraws; //!< If draws using a pipeline that is still being asynchronously compiled should be skipped rather than waiting on the compilation
+        Setting<bool> shaderOptimization; //!< If the SPIR-V of shaders that aren't in the shader cache should be optimized prior to being cached, this benefits drivers with weak shader compilers
+        Setting<u32> textureMemoryBudget; //!< The amount of memory in GiB that guest textures may use before unused textures are evicted, 0 derives it from the memory budget of the device
+        Setting<bool> gpuTextureDeswizzle; //!< If large block-linear textures should be deswizzled on upload and swizzled on readback on the GPU with compute shaders rather than on the CPU
+        Setting<bool> memoryDefragmentation; //!< If the texture memory pools should be incrementally defragmented while the GPU is idle
+        Setting<u32> transcodeCacheSize; //!< The maximum size of the on-disk cache of transcoded texture data in MiB, 0 disables the cache
+        Setting<u32> bufferMemoryBudget; //!< The amount of memory in MiB that guest buffers may use before the backings of idle buffers are freed, 0 derives it from the memory budget of the device
+        Setting<bool> importGuestBuffers; //!< If guest memory should be imported directly as the backing of guest buffers when the device supports VK_EXT_external_memory_host, this avoids copying buffer contents between the guest and the host
+        Setting<u32> megaBufferRingSize; //!< The size in MiB of the ring buffer that megabuffer allocations are streamed into, 0 disables the ring buffer
+        Setting<bool> transferQueue; //!< If texture uploads and readbacks should be submitted on a separate queue when the device exposes more than one queue in the graphics queue family
+        Setting<u32> recordWorkerCount; //!< The amount of worker threads that render passes are recorded on in parallel, 0 records all commands on the command record thread
+        Setting<u32> resolutionScale; //!< The percentage that the resolution of render targets is scaled by relative to the guest resolution, 100 renders at the native resolution
+        Setting<bool> performanceGovernor; //!< If the emulator should adapt to the thermal status of the device and supply performance hints for the latency-critical threads
+        Setting<bool> thermalResolutionScaling; //!< If the performance governor may render new render targets at the native resolution rather than the resolution scale under severe thermal pressure
 
         // Debug
         Setting<bool> validationLayer; //!< If the vulkan validation layer is enabled
+        Setting<bool> gpuTimestampProfiling; //!< If GPU timestamps should be recorded around the commands of every execution and emitted to the trace as a GPU track
+        Setting<bool> gpfifoCapture; //!< If all GPFIFO entries and the pushbuffers they reference should be written to a capture file for every channel
+        Setting<bool> guestProfiler; //!< If guest threads should be sampled to produce a report of the most executed guest functions
 
         Settings() = default;
 
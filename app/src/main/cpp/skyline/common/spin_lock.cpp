@@ -1,28 +1,63 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
-#include <chrono>
-#include <thread>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#ifdef SKYLINE_LOCK_PROFILING
+#include <common/trace.h>
+#endif
 #include "spin_lock.h"
 
 namespace skyline {
-    static constexpr size_t LockAttemptsPerYield{256};
-    static constexpr size_t LockAttemptsPerSleep{1024};
-    static constexpr size_t SleepDurationUs{1000};
-
-    void  __attribute__ ((noinline)) SpinLock::LockSlow() {
-        // We need to start with attempt = 1, otherwise
-        // attempt % LockAttemptsPerSleep is zero for the first iteration.
-        size_t attempt{1};
-        while (true) {
-            if (!locked.test_and_set(std::memory_order_acquire))
-                return;
+    static constexpr u32 MinSpinIterations{64};
+    static constexpr u32 MaxSpinIterations{16384};
+    static constexpr u32 MaxBackoff{64}; //!< The maximum amount of YIELDs between attempts to acquire the lock, once this is reached WFE is used instead
+
+    /**
+     * @brief Waits for the supplied futex word to potentially change from a locked value using WFE, this is woken by the exclusive monitor being cleared when any other core writes to it
+     * @note The wait is bounded by the kernel's event stream (typically ~100us) if no write occurs, so this is always safe to use in a loop polling the value
+     */
+    static void WaitForEvent(std::atomic<u32> &value) {
+        u32 current;
+        asm volatile("LDAXR %w0, [%1]" : "=&r"(current) : "r"(&value) : "memory");
+        if (current != 0)
+            asm volatile("WFE" ::: "memory");
+    }
+
+    void __attribute__((noinline)) SpinLock::LockSlow() {
+        #ifdef SKYLINE_LOCK_PROFILING
+        // The return address identifies the site that the lock was taken at as lock() is always inlined into it
+        TRACE_EVENT("containers", "SpinLock::LockSlow", "site", reinterpret_cast<u64>(__builtin_return_address(0)));
+        #endif
+
+        // The lock is only attempted once it's observed to be unlocked, failed attempts would otherwise bounce the cache line between cores
+        u32 iterations{spinIterations.load(std::memory_order_relaxed)};
+        u32 backoff{1};
+        for (u32 spun{}; spun < iterations; spun += backoff) {
+            if (backoff < MaxBackoff) {
+                for (u32 i{}; i < backoff && state.load(std::memory_order_relaxed) != Unlocked; i++)
+                    asm volatile("YIELD");
+                backoff *= 2;
+            } else {
+                WaitForEvent(state);
+            }
 
-            if (attempt % LockAttemptsPerSleep == 0)
-                std::this_thread::sleep_for(std::chrono::microseconds(100));
-            else if (attempt % LockAttemptsPerYield == 0)
-                std::this_thread::yield();
+            u32 expected{Unlocked};
+            if (state.load(std::memory_order_relaxed) == Unlocked && state.compare_exchange_weak(expected, Locked, std::memory_order_acquire, std::memory_order_relaxed)) {
+                spinIterations.store(std::min(iterations * 2, MaxSpinIterations), std::memory_order_relaxed);
+                return;
+            }
         }
+
+        spinIterations.store(std::max(iterations / 2, MinSpinIterations), std::memory_order_relaxed);
+
+        // The lock is acquired in the contended state after sleeping as there may be other sleepers that the unlock needs to wake
+        while (state.exchange(LockedWithSleepers, std::memory_order_acquire) != Unlocked)
+            syscall(SYS_futex, reinterpret_cast<u32 *>(&state), FUTEX_WAIT_PRIVATE, LockedWithSleepers, nullptr, nullptr, 0);
     }
 
+    void __attribute__((noinline)) SpinLock::WakeSleeper() {
+        syscall(SYS_futex, reinterpret_cast<u32 *>(&state), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+    }
 }
@@ -9,29 +9,43 @@
 
 namespace skyline {
     /**
-     * @brief A simple spin lock implementation with a yield and sleep fallback
+     * @brief A spin lock which adaptively spins with exponential backoff prior to sleeping on a futex
+     * @note The amount of spin iterations adapts to if spinning has been successful previously, locks that are held briefly avoid the futex entirely while long holds quickly stop wasting CPU time
      * @note This should *ONLY* be used in situations where it is provably better than an std::mutex due to spinlocks having worse perfomance under heavy contention
      */
     class SpinLock {
       private:
-        std::atomic_flag locked{};
+        static constexpr u32 Unlocked{0};
+        static constexpr u32 Locked{1}; //!< The lock is held and no threads are sleeping on it, unlocking doesn't need to wake anyone
+        static constexpr u32 LockedWithSleepers{2}; //!< The lock is held and threads may be sleeping on the futex, unlocking must wake one of them
+        static constexpr u32 InitialSpinIterations{1024};
+
+        std::atomic<u32> state{Unlocked}; //!< The futex word
+        std::atomic<u32> spinIterations{InitialSpinIterations}; //!< The amount of iterations to spin for prior to sleeping on the futex
+
+        static_assert(sizeof(std::atomic<u32>) == sizeof(u32) && std::atomic<u32>::is_always_lock_free);
 
         void LockSlow();
 
+        void WakeSleeper();
+
       public:
         void lock() {
-            if (!locked.test_and_set(std::memory_order_acquire)) [[likely]]
+            u32 expected{Unlocked};
+            if (state.compare_exchange_strong(expected, Locked, std::memory_order_acquire, std::memory_order_relaxed)) [[likely]]
                 return;
 
             LockSlow();
         }
 
         bool try_lock() {
-            return !locked.test_and_set(std::memory_order_acquire);
+            u32 expected{Unlocked};
+            return state.compare_exchange_strong(expected, Locked, std::memory_order_acquire, std::memory_order_relaxed);
         }
 
         void unlock() {
-            locked.clear(std::memory_order_release);
+            if (state.exchange(Unlocked, std::memory_order_release) == LockedWithSleepers) [[unlikely]]
+                WakeSleeper();
         }
     };
 
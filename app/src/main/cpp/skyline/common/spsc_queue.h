@@ -0,0 +1,207 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <bit>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <common/trace.h>
+#include <common.h>
+
+namespace skyline {
+    /**
+     * @brief A lock-free bounded queue for a single producer thread and a single consumer thread
+     * @note Handing off an item only requires atomic operations on the indices, a thread only waits on a futex when the queue is empty (consumer) or full (producer) and is only woken by the other side if it's actually waiting
+     * @note This **must not** be used with more than one producer or consumer thread at a time, CircularQueue should be used in that case
+     */
+    template<typename Type>
+    class SpscQueue {
+      private:
+        static constexpr size_t CacheLineSize{64}; //!< The indices are kept in separate cache lines to avoid false sharing between the producer and the consumer
+
+        std::vector<Type> items;
+        u32 mask; //!< The mask applied to the indices to get the index of an item, the capacity is always a power of two so the indices can freely wrap around
+        alignas(CacheLineSize) std::atomic<u32> readIndex{}; //!< The amount of items that have been consumed, this is only written to by the consumer
+        std::atomic<bool> producerWaiting{}; //!< If the producer is waiting (or about to wait) on the futex of the read index for space in the queue
+        alignas(CacheLineSize) std::atomic<u32> writeIndex{}; //!< The amount of items that have been produced, this is only written to by the producer
+        std::atomic<bool> consumerWaiting{}; //!< If the consumer is waiting (or about to wait) on the futex of the write index for items in the queue
+
+        static_assert(sizeof(std::atomic<u32>) == sizeof(u32) && std::atomic<u32>::is_always_lock_free);
+
+        static void FutexWait(std::atomic<u32> &word, u32 value) {
+            syscall(SYS_futex, reinterpret_cast<u32 *>(&word), FUTEX_WAIT_PRIVATE, value, nullptr, nullptr, 0); // Spurious wakeups (EINTR) and value mismatches (EAGAIN) are handled by the caller rechecking the index
+        }
+
+        static void FutexWake(std::atomic<u32> &word) {
+            syscall(SYS_futex, reinterpret_cast<u32 *>(&word), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+        }
+
+        /**
+         * @brief Blocks till the supplied index differs from the supplied value
+         * @param waiting The flag that's set while waiting, this is checked by the other side to determine if it needs to wake this thread
+         * @return The new value of the index
+         * @note The flag and the index are accessed with sequential consistency to ensure that the other side either observes the flag or this side observes the updated index
+         */
+        static u32 WaitForChange(std::atomic<u32> &index, std::atomic<bool> &waiting, u32 value) {
+            waiting.store(true, std::memory_order_seq_cst);
+            u32 current;
+            while ((current = index.load(std::memory_order_seq_cst)) == value)
+                FutexWait(index, value);
+            waiting.store(false, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return current;
+        }
+
+        /**
+         * @brief Publishes a new value of an index and wakes the other side if it's waiting on it
+         */
+        static void Publish(std::atomic<u32> &index, std::atomic<bool> &waiting, u32 value) {
+            index.store(value, std::memory_order_seq_cst);
+            if (waiting.load(std::memory_order_seq_cst))
+                FutexWake(index);
+        }
+
+        /**
+         * @brief Waits till there's space for at least a single item in the queue
+         * @return The write index of the producer
+         */
+        u32 WaitForSpace() {
+            u32 write{writeIndex.load(std::memory_order_relaxed)};
+            u32 read{readIndex.load(std::memory_order_acquire)};
+            while (write - read > mask)
+                read = WaitForChange(readIndex, producerWaiting, read);
+            return write;
+        }
+
+      public:
+        /**
+         * @param size The minimum amount of items the queue can hold, this is rounded up to a power of two
+         */
+        SpscQueue(size_t size) : items(std::bit_ceil(std::max<size_t>(size, 1))), mask{static_cast<u32>(items.size() - 1)} {}
+
+        SpscQueue(const SpscQueue &) = delete;
+
+        SpscQueue &operator=(const SpscQueue &) = delete;
+
+        /**
+         * @brief A blocking for-each that runs on every item and waits till new items to run on them as well
+         * @param function A function that is called for each item (with the only parameter as a reference to that item)
+         * @param preWait An optional function that's called prior to waiting on more items to be queued
+         */
+        template<typename F1, typename F2>
+        [[noreturn]] void Process(F1 function, F2 preWait) {
+            TRACE_EVENT_BEGIN("containers", "SpscQueue::Process");
+
+            u32 read{readIndex.load(std::memory_order_relaxed)};
+            while (true) {
+                u32 write{writeIndex.load(std::memory_order_acquire)};
+                if (read == write) {
+                    TRACE_EVENT_END("containers");
+                    preWait();
+                    write = WaitForChange(writeIndex, consumerWaiting, read);
+                    TRACE_EVENT_BEGIN("containers", "SpscQueue::Process");
+                }
+
+                while (read != write) {
+                    function(items[read & mask]);
+                    Publish(readIndex, producerWaiting, ++read);
+                }
+            }
+        }
+
+        Type Pop() {
+            u32 read{readIndex.load(std::memory_order_relaxed)};
+            if (read == writeIndex.load(std::memory_order_acquire))
+                WaitForChange(writeIndex, consumerWaiting, read);
+
+            Type item{std::move(items[read & mask])};
+            Publish(readIndex, producerWaiting, read + 1);
+            return item;
+        }
+
+        /**
+         * @brief Pops an item from the queue without blocking if there are any
+         * @return If an item was popped into the supplied reference
+         */
+        bool TryPop(Type &item) {
+            u32 read{readIndex.load(std::memory_order_relaxed)};
+            if (read == writeIndex.load(std::memory_order_acquire))
+                return false;
+
+            item = std::move(items[read & mask]);
+            Publish(readIndex, producerWaiting, read + 1);
+            return true;
+        }
+
+        /**
+         * @brief Pushes an item that's filled in-place by the supplied function, this allows items to reuse any storage held by the item they replace
+         * @param function A function that's called with a reference to the slot of the item once there's space for it
+         */
+        template<typename Function>
+        void Emplace(Function function) {
+            u32 write{WaitForSpace()};
+            function(items[write & mask]);
+            Publish(writeIndex, consumerWaiting, write + 1);
+        }
+
+        /**
+         * @brief Blocks till the consumer has finished processing all items in the queue, this must only be called by the producer
+         */
+        void WaitForEmpty() {
+            u32 write{writeIndex.load(std::memory_order_relaxed)};
+            u32 read{readIndex.load(std::memory_order_acquire)};
+            while (read != write)
+                read = WaitForChange(readIndex, producerWaiting, read);
+        }
+
+        void Push(const Type &item) {
+            u32 write{WaitForSpace()};
+            items[write & mask] = item;
+            Publish(writeIndex, consumerWaiting, write + 1);
+        }
+
+        /**
+         * @brief Pushes an item into the queue without blocking if there's space for it
+         * @return If the item was pushed, this is false if the queue was full
+         */
+        bool TryPush(const Type &item) {
+            u32 write{writeIndex.load(std::memory_order_relaxed)};
+            if (write - readIndex.load(std::memory_order_acquire) > mask)
+                return false;
+
+            items[write & mask] = item;
+            Publish(writeIndex, consumerWaiting, write + 1);
+            return true;
+        }
+
+        /**
+         * @brief Pushes all items in the buffer into the queue, the items are published in bulk so the consumer is only woken once for every run of items that fit in the queue
+         */
+        void Append(span<Type> buffer) {
+            while (!buffer.empty()) {
+                u32 write{WaitForSpace()};
+                u32 space{mask + 1 - (write - readIndex.load(std::memory_order_acquire))};
+                u32 count{static_cast<u32>(std::min<size_t>(space, buffer.size()))};
+                for (u32 i{}; i < count; i++)
+                    items[(write + i) & mask] = buffer[i];
+                Publish(writeIndex, consumerWaiting, write + count);
+                buffer = buffer.subspan(count);
+            }
+        }
+
+        /**
+         * @brief Appends a buffer with an alternative input type while supplied transformation function
+         * @param tranformation A function that takes in an item of TransformedType as input and returns an item of Type
+         */
+        template<typename TransformedType, typename Transformation>
+        void AppendTranform(span <TransformedType> buffer, Transformation transformation) {
+            for (auto &item : buffer) {
+                u32 write{WaitForSpace()};
+                items[write & mask] = transformation(item);
+                Publish(writeIndex, consumerWaiting, write + 1);
+            }
+        }
+    };
+}
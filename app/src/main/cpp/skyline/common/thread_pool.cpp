@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <common/signal.h>
+#include "thread_pool.h"
+
+namespace skyline {
+    ThreadPool::ThreadPool(std::string name, size_t threadCount, thread_role::Role role) : name{std::move(name)}, threadCount{std::max<size_t>(threadCount, 1)}, role{role} {}
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::scoped_lock lock{mutex};
+            exiting = true;
+        }
+        condition.notify_all();
+
+        for (auto &thread : threads)
+            if (thread.joinable())
+                thread.join();
+    }
+
+    void ThreadPool::Run(size_t index) {
+        auto threadName{fmt::format("{}-{}", name, index)};
+        if (int result{pthread_setname_np(pthread_self(), threadName.c_str())})
+            Logger::Warn("Failed to set the thread name: {}", strerror(result));
+        thread_role::Apply(role);
+
+        // Signals are converted into exceptions which are then propagated to the submitter through the task's future
+        signal::SetSignalHandler({SIGINT, SIGILL, SIGTRAP, SIGBUS, SIGFPE, SIGSEGV}, signal::ExceptionalSignalHandler);
+
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock lock{mutex};
+                condition.wait(lock, [this] { return !tasks.empty() || exiting; });
+                if (exiting)
+                    return;
+
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+
+            task();
+        }
+    }
+
+    void ThreadPool::Enqueue(std::function<void()> &&task) {
+        {
+            std::scoped_lock lock{mutex};
+            if (threads.empty())
+                for (size_t index{}; index < threadCount; index++)
+                    threads.emplace_back(&ThreadPool::Run, this, index);
+
+            tasks.emplace(std::move(task));
+        }
+        condition.notify_one();
+    }
+}
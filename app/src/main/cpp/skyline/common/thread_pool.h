@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <queue>
+#include <thread>
+#include "base.h"
+#include "thread_role.h"
+
+namespace skyline {
+    /**
+     * @brief A fixed-size pool of worker threads which run submitted tasks in FIFO order
+     * @note The worker threads are spawned lazily on the first submission so that an unused pool doesn't consume any resources
+     */
+    class ThreadPool {
+      private:
+        std::string name; //!< The name of the worker threads, this is suffixed with the index of the worker
+        size_t threadCount;
+        thread_role::Role role; //!< The role the worker threads are placed with
+        std::mutex mutex; //!< Synchronizes all accesses to the task queue and the worker threads
+        std::condition_variable condition; //!< Signalled when a task is submitted or the pool is being destroyed
+        std::queue<std::function<void()>> tasks;
+        std::vector<std::thread> threads;
+        bool exiting{}; //!< If the worker threads should exit, any pending tasks are discarded
+
+        void Run(size_t index);
+
+        /**
+         * @brief Enqueues a task and spawns the worker threads if they haven't been spawned yet
+         */
+        void Enqueue(std::function<void()> &&task);
+
+      public:
+        /**
+         * @param name The name of the worker threads, this should be at most 12 characters long due to the thread name length limit
+         * @param threadCount The amount of worker threads in the pool, this must be at least 1
+         * @param role The role of the worker threads, this determines the cores they run on and their priority
+         */
+        ThreadPool(std::string name, size_t threadCount, thread_role::Role role = thread_role::Role::Helper);
+
+        /**
+         * @note Any tasks that are already running are run to completion while pending tasks are discarded, the futures of discarded tasks are signalled with a broken promise error
+         */
+        ~ThreadPool();
+
+        /**
+         * @brief Submits a function to be run on one of the worker threads
+         * @return A future which is signalled with the return value of the function or any exception thrown by it
+         */
+        template<typename Function>
+        std::future<std::invoke_result_t<Function>> Submit(Function &&function) {
+            auto task{std::make_shared<std::packaged_task<std::invoke_result_t<Function>()>>(std::forward<Function>(function))};
+            auto future{task->get_future()};
+            Enqueue([task = std::move(task)] { (*task)(); });
+            return future;
+        }
+
+        size_t GetThreadCount() const {
+            return threadCount;
+        }
+    };
+}
@@ -0,0 +1,226 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <charconv>
+#include <fstream>
+#include <mutex>
+#include <signal.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <common.h>
+#include "thread_role.h"
+
+namespace skyline::thread_role {
+    static bool Enabled{}; //!< If the placement of threads is enabled
+    static cpu_set_t BigCores{}; //!< The set of big/prime cores that latency-critical roles are placed on
+    static cpu_set_t LittleCores{}; //!< The set of little cores that helper roles are placed on, this is the same as BigCores on homogeneous CPUs
+    static cpu_set_t ThrottledBigCores{}; //!< The set of big cores excluding the prime cores, latency-critical roles are placed on these while throttled
+    static thread_local Role CurrentRole{Role::None}; //!< The role that was last applied to the calling thread
+
+    static std::mutex RegistryMutex; //!< Synchronizes all accesses to the registry and the throttling state
+    static std::vector<std::pair<pid_t, Role>> Registry; //!< The TIDs of all threads that have been placed alongside their current role
+    static bool Throttled{}; //!< If latency-critical roles are restricted to ThrottledBigCores
+
+    /**
+     * @return The set of cores that a role should be placed on
+     * @note The registry mutex **must** be locked prior to calling this
+     */
+    static const cpu_set_t &GetCores(Role role) {
+        if (IsLatencyCritical(role))
+            return Throttled ? ThrottledBigCores : BigCores;
+        return LittleCores;
+    }
+
+    /**
+     * @return The value in the supplied sysfs file or 0 if it couldn't be read
+     */
+    static u64 ReadSysfsValue(const std::string &path) {
+        std::ifstream file{path};
+        u64 value{};
+        if (!(file >> value))
+            return 0;
+        return value;
+    }
+
+    /**
+     * @brief Parses a CPU list in the kernel's format (E.g. "0-3,6") into a CPU set
+     * @return The amount of CPUs in the list, 0 if the list is malformed
+     */
+    static size_t ParseCpuList(std::string_view list, cpu_set_t &set) {
+        CPU_ZERO(&set);
+        while (!list.empty()) {
+            auto separator{list.find(',')};
+            auto range{list.substr(0, separator)};
+            list = separator == std::string_view::npos ? std::string_view{} : list.substr(separator + 1);
+
+            auto dash{range.find('-')};
+            auto firstString{range.substr(0, dash)};
+            auto lastString{dash == std::string_view::npos ? firstString : range.substr(dash + 1)};
+            u32 first{}, last{};
+            if (std::from_chars(firstString.data(), firstString.data() + firstString.size(), first).ec != std::errc{} || std::from_chars(lastString.data(), lastString.data() + lastString.size(), last).ec != std::errc{})
+                return 0;
+
+            if (last < first || last >= CPU_SETSIZE)
+                return 0;
+
+            for (u32 cpu{first}; cpu <= last; cpu++)
+                CPU_SET(cpu, &set);
+        }
+        return static_cast<size_t>(CPU_COUNT(&set));
+    }
+
+    void Configure(bool enable, std::string_view bigCoreOverride) {
+        Enabled = enable;
+        if (!enable)
+            return;
+
+        auto cpuCount{static_cast<u32>(sysconf(_SC_NPROCESSORS_CONF))};
+        cpu_set_t allCores;
+        CPU_ZERO(&allCores);
+        for (u32 cpu{}; cpu < cpuCount && cpu < CPU_SETSIZE; cpu++)
+            CPU_SET(cpu, &allCores);
+
+        if (!bigCoreOverride.empty()) {
+            if (ParseCpuList(bigCoreOverride, BigCores)) {
+                CPU_AND(&BigCores, &BigCores, &allCores);
+                CPU_XOR(&LittleCores, &allCores, &BigCores);
+                ThrottledBigCores = BigCores; // The override doesn't distinguish prime cores
+                if (CPU_COUNT(&BigCores) && CPU_COUNT(&LittleCores)) {
+                    Logger::Info("Using big core override: {} big cores, {} little cores", CPU_COUNT(&BigCores), CPU_COUNT(&LittleCores));
+                    return;
+                }
+            }
+            Logger::Warn("Invalid big core override '{}', falling back to the CPU topology", bigCoreOverride);
+        }
+
+        // The capacity of a core is the best indicator of its performance, if it isn't exposed then the maximum frequency is used instead
+        std::vector<u64> capacities(cpuCount);
+        for (u32 cpu{}; cpu < cpuCount; cpu++) {
+            auto cpuPath{fmt::format("/sys/devices/system/cpu/cpu{}/", cpu)};
+            capacities[cpu] = ReadSysfsValue(cpuPath + "cpu_capacity");
+            if (!capacities[cpu])
+                capacities[cpu] = ReadSysfsValue(cpuPath + "cpufreq/cpuinfo_max_freq");
+        }
+
+        u64 minCapacity{std::numeric_limits<u64>::max()}, maxCapacity{};
+        for (auto capacity : capacities) {
+            if (capacity) {
+                minCapacity = std::min(minCapacity, capacity);
+                maxCapacity = std::max(maxCapacity, capacity);
+            }
+        }
+
+        CPU_ZERO(&BigCores);
+        CPU_ZERO(&LittleCores);
+        CPU_ZERO(&ThrottledBigCores);
+        if (!maxCapacity || minCapacity == maxCapacity) {
+            // The CPU is homogeneous or the topology couldn't be read, every role can run on any core
+            BigCores = LittleCores = ThrottledBigCores = allCores;
+            Logger::Info("CPU topology is homogeneous, only thread priorities will be applied");
+            return;
+        }
+
+        for (u32 cpu{}; cpu < cpuCount && cpu < CPU_SETSIZE; cpu++) {
+            // Cores with an unknown capacity are offline, they're treated as little cores so nothing latency-critical is placed on them
+            if (capacities[cpu] > minCapacity) {
+                CPU_SET(cpu, &BigCores);
+                if (capacities[cpu] < maxCapacity)
+                    CPU_SET(cpu, &ThrottledBigCores);
+            } else {
+                CPU_SET(cpu, &LittleCores);
+            }
+        }
+
+        // Only CPUs with three or more clusters have prime cores which are distinct from the big cores, the big cores are retained while throttled otherwise
+        if (!CPU_COUNT(&ThrottledBigCores))
+            ThrottledBigCores = BigCores;
+
+        Logger::Info("CPU topology: {} big cores ({} prime), {} little cores", CPU_COUNT(&BigCores), CPU_COUNT(&BigCores) - CPU_COUNT(&ThrottledBigCores), CPU_COUNT(&LittleCores));
+    }
+
+    /**
+     * @return The nice value of a role, these correspond to the THREAD_PRIORITY_* constants of android.os.Process
+     */
+    static int GetNiceValue(Role role) {
+        switch (role) {
+            case Role::GuestCore:
+            case Role::Gpfifo:
+                return -4; // THREAD_PRIORITY_DISPLAY
+
+            case Role::CommandRecord:
+            case Role::Presentation:
+                return -8; // THREAD_PRIORITY_URGENT_DISPLAY
+
+            case Role::Audio:
+                return -16; // THREAD_PRIORITY_AUDIO
+
+            case Role::Helper:
+                return 10; // THREAD_PRIORITY_BACKGROUND
+
+            default:
+                return 0; // THREAD_PRIORITY_DEFAULT
+        }
+    }
+
+    void Apply(Role role) {
+        if (role == Role::None || role == CurrentRole)
+            return;
+
+        // Threads are registered even when placement is disabled as the registry is also used to find the threads that performance hints are supplied for
+        pid_t tid{gettid()};
+        {
+            std::scoped_lock lock{RegistryMutex};
+            if (Enabled && sched_setaffinity(0, sizeof(cpu_set_t), &GetCores(role)))
+                Logger::Debug("Failed to set the CPU affinity of the thread: {}", strerror(errno));
+
+            auto it{std::find_if(Registry.begin(), Registry.end(), [tid](const auto &entry) { return entry.first == tid; })};
+            if (it != Registry.end())
+                it->second = role;
+            else
+                Registry.emplace_back(tid, role);
+        }
+
+        if (int niceValue{GetNiceValue(role)}; Enabled && setpriority(PRIO_PROCESS, static_cast<id_t>(tid), niceValue))
+            Logger::Debug("Failed to set the priority of the thread to {}: {}", niceValue, strerror(errno));
+
+        CurrentRole = role;
+    }
+
+    /**
+     * @brief Removes all threads that have exited from the registry
+     * @note The registry mutex **must** be locked prior to calling this
+     */
+    static void PruneRegistry() {
+        pid_t pid{getpid()};
+        std::erase_if(Registry, [pid](const auto &entry) {
+            return tgkill(pid, entry.first, 0) && errno == ESRCH;
+        });
+    }
+
+    void SetThrottled(bool throttled) {
+        if (!Enabled)
+            return;
+
+        std::scoped_lock lock{RegistryMutex};
+        if (Throttled == throttled)
+            return;
+        Throttled = throttled;
+
+        PruneRegistry();
+        for (const auto &[tid, role] : Registry)
+            if (IsLatencyCritical(role) && sched_setaffinity(tid, sizeof(cpu_set_t), &GetCores(role)))
+                Logger::Debug("Failed to set the CPU affinity of thread {}: {}", tid, strerror(errno));
+    }
+
+    std::vector<pid_t> GetThreads(std::initializer_list<Role> roles) {
+        std::scoped_lock lock{RegistryMutex};
+        PruneRegistry();
+
+        std::vector<pid_t> tids;
+        for (const auto &[tid, role] : Registry)
+            if (std::find(roles.begin(), roles.end(), role) != roles.end())
+                tids.push_back(tid);
+        return tids;
+    }
+}
@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <string_view>
+#include <vector>
+#include <sys/types.h>
+#include "base.h"
+
+/**
+ * @brief Placement of host threads on the clusters of heterogeneous (big.LITTLE) CPUs alongside their scheduling priorities
+ */
+namespace skyline::thread_role {
+    /**
+     * @brief The role of a host thread which determines the cluster it should run on and its priority
+     */
+    enum class Role : u8 {
+        None, //!< The thread hasn't been assigned a role, this is never applied
+        GuestCore, //!< A guest thread running on one of the application cores (0-2)
+        SystemCore, //!< A guest thread running on the system core (3)
+        Gpfifo, //!< A GPFIFO thread processing pushbuffers of a channel
+        CommandRecord, //!< The thread that records and submits GPU executions
+        Presentation, //!< A thread that presents frames or paces them with the Choreographer
+        Audio, //!< A thread that renders or releases audio buffers
+        CycleWaiter, //!< The thread that waits on fence cycles to destroy their dependencies
+        Helper, //!< Any background helper thread (Thread pools, logging, etc.)
+    };
+
+    /**
+     * @brief Reads the CPU topology and configures the clusters roles are placed on
+     * @param enable If thread placement should be performed at all, Apply() will only register roles otherwise
+     * @param bigCoreOverride A list of CPUs in the kernel's CPU list format (E.g. "4-7" or "4,5,6,7") that should be considered big cores, this overrides the topology read from sysfs if non-empty
+     * @note This must be called prior to any thread calling Apply()
+     */
+    void Configure(bool enable, std::string_view bigCoreOverride);
+
+    /**
+     * @brief Registers the role of the calling thread, placing it on the cluster of the role and applying the priority of the role if placement is enabled
+     * @note This is a no-op if the calling thread already has the same role, so it may be called frequently
+     */
+    void Apply(Role role);
+
+    /**
+     * @return If the supplied role is latency-critical and placed on the big cores
+     */
+    constexpr bool IsLatencyCritical(Role role) {
+        return role == Role::GuestCore || role == Role::Gpfifo || role == Role::CommandRecord || role == Role::Presentation;
+    }
+
+    /**
+     * @brief Sets if the CPU is thermally throttled, the prime cores are excluded from the big cores while throttled as they throttle the hardest and consume the most power
+     * @note All latency-critical threads that have been placed are moved immediately, this is a no-op on CPUs without a separate prime cluster
+     */
+    void SetThrottled(bool throttled);
+
+    /**
+     * @return The TIDs of all live threads which had one of the supplied roles applied last
+     */
+    std::vector<pid_t> GetThreads(std::initializer_list<Role> roles);
+
+    /**
+     * @return The role for a guest thread scheduled on the supplied guest core
+     */
+    constexpr Role GuestCoreRole(u8 coreId) {
+        return coreId < 3 ? Role::GuestCore : Role::SystemCore;
+    }
+}
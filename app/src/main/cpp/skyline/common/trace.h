@@ -24,5 +24,6 @@ namespace skyline::trace {
      */
     enum class TrackIds : u64 {
         Presentation = std::numeric_limits<u64>::max(),
+        Gpu = std::numeric_limits<u64>::max() - 1, //!< GPU-side execution of command executor slots, derived from timestamp queries
     };
 }
@@ -4,6 +4,8 @@
 #pragma once
 
 #include <algorithm>
+#include <cerrno>
+#include <ctime>
 #include <random>
 #include <span>
 #include <frozen/unordered_map.h>
@@ -42,6 +44,36 @@ namespace skyline::util {
         return ticks;
     }
 
+    constexpr i64 PreciseSleepSpinNs{100'000}; //!< The remainder of a precise sleep that is spun for rather than slept, this covers the typical wakeup latency of an hrtimer sleep
+
+    /**
+     * @brief Sleeps for the supplied duration with an absolute hrtimer sleep up to shortly before the deadline followed by a spin for the remainder
+     * @note A plain sleep frequently oversleeps by a millisecond or more on Android, which is noticeable for guest code that paces its frames with sleeps
+     * @return The amount of nanoseconds the deadline was overslept by
+     */
+    inline i64 PreciseSleep(i64 durationNs) {
+        auto getMonotonicNs{[]() {
+            timespec time{};
+            clock_gettime(CLOCK_MONOTONIC, &time);
+            return static_cast<i64>(time.tv_sec) * constant::NsInSecond + time.tv_nsec;
+        }};
+
+        i64 deadline{getMonotonicNs() + durationNs};
+        if (durationNs > PreciseSleepSpinNs) {
+            i64 wakeup{deadline - PreciseSleepSpinNs};
+            timespec spec{
+                .tv_sec = static_cast<time_t>(wakeup / constant::NsInSecond),
+                .tv_nsec = static_cast<long>(wakeup % constant::NsInSecond),
+            };
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &spec, nullptr) == EINTR); // The deadline is absolute so signals interrupting the sleep don't cause any drift
+        }
+
+        i64 now;
+        while ((now = getMonotonicNs()) < deadline)
+            asm volatile("YIELD");
+        return now - deadline;
+    }
+
     /**
      * @brief A way to implicitly convert a pointer to uintptr_t and leave it unaffected if it isn't a pointer
      */
@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include "aes_hardware.h"
+#include "aes_ctr_cipher.h"
+
+namespace skyline::crypto {
+    using Block = AesCtrCipher::Block;
+
+    /**
+     * @return The counter block for the block at the supplied index of the keystream
+     */
+    static Block GetCounterBlock(const Block &ctr, u64 blockIndex) {
+        Block counter{ctr};
+        u64 be{util::SwapEndianness(blockIndex)};
+        std::memcpy(counter.data() + 8, &be, sizeof(be));
+        return counter;
+    }
+
+    __attribute__((target("aes"))) static void DecryptHardware(span<u8> data, const hardware::RoundKeys &roundKeys, const Block &ctr, u64 offset) {
+        uint8x16_t keys[hardware::RoundKeyCount];
+        hardware::LoadRoundKeys(roundKeys, keys);
+
+        u64 blockIndex{offset / sizeof(Block)};
+        size_t blockOffset{offset % sizeof(Block)};
+        u8 *pointer{data.data()}, *end{data.data() + data.size()};
+
+        if (blockOffset) {
+            // The leading partial block is decrypted with the tail of its keystream block
+            Block keystream;
+            vst1q_u8(keystream.data(), hardware::EncryptBlock(vld1q_u8(GetCounterBlock(ctr, blockIndex++).data()), keys));
+            for (size_t i{blockOffset}; i < keystream.size() && pointer != end; i++)
+                *pointer++ ^= keystream[i];
+        }
+
+        for (; static_cast<size_t>(end - pointer) >= sizeof(Block); pointer += sizeof(Block))
+            vst1q_u8(pointer, veorq_u8(vld1q_u8(pointer), hardware::EncryptBlock(vld1q_u8(GetCounterBlock(ctr, blockIndex++).data()), keys)));
+
+        if (pointer != end) {
+            Block keystream;
+            vst1q_u8(keystream.data(), hardware::EncryptBlock(vld1q_u8(GetCounterBlock(ctr, blockIndex).data()), keys));
+            for (size_t i{}; pointer != end; i++)
+                *pointer++ ^= keystream[i];
+        }
+    }
+
+    AesCtrCipher::AesCtrCipher(const Block &key) : hardwareAes{hardware::HasHardwareAes()} {
+        mbedtls_aes_init(&context);
+        if (mbedtls_aes_setkey_enc(&context, key.data(), static_cast<unsigned int>(key.size() * 8)) != 0)
+            throw exception("Failed to set key for AES-CTR context");
+
+        if (hardwareAes)
+            roundKeys = hardware::ExpandKey(key);
+    }
+
+    AesCtrCipher::~AesCtrCipher() {
+        mbedtls_aes_free(&context);
+    }
+
+    void AesCtrCipher::Decrypt(span<u8> data, const Block &ctr, u64 offset) const {
+        if (data.empty())
+            return;
+
+        if (hardwareAes) {
+            DecryptHardware(data, roundKeys, ctr, offset);
+            return;
+        }
+
+        // Encryption with an mbedtls context only reads the key schedule, so the context can be shared between threads
+        auto aesContext{const_cast<mbedtls_aes_context *>(&context)};
+        u64 blockIndex{offset / sizeof(Block)};
+        size_t blockOffset{offset % sizeof(Block)};
+        for (size_t position{}; position < data.size(); blockIndex++) {
+            Block counter{GetCounterBlock(ctr, blockIndex)}, keystream;
+            mbedtls_aes_crypt_ecb(aesContext, MBEDTLS_AES_ENCRYPT, counter.data(), keystream.data());
+            for (size_t i{blockOffset}; i < keystream.size() && position < data.size(); i++)
+                data[position++] ^= keystream[i];
+            blockOffset = 0;
+        }
+    }
+}
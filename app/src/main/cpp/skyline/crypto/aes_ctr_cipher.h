@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <mbedtls/aes.h>
+#include <common.h>
+
+namespace skyline::crypto {
+    /**
+     * @brief A stateless AES-128-CTR cipher, the counter is derived from the offset of the data on every call
+     * @note As no state is modified after construction, this can be used concurrently from any amount of threads without any locking
+     * @note The ARMv8 Crypto Extensions are used when the host supports them, otherwise this falls back to the mbedtls software implementation
+     */
+    class AesCtrCipher {
+      public:
+        using Block = std::array<u8, 0x10>;
+
+      private:
+        static constexpr size_t RoundKeyCount{11}; //!< The amount of round keys for AES-128
+
+        bool hardwareAes; //!< If the host supports the ARMv8 AES instructions
+        std::array<Block, RoundKeyCount> roundKeys{}; //!< The expanded key schedule for the hardware implementation
+        mbedtls_aes_context context; //!< The context for the software implementation, it's only used to encrypt counter blocks which doesn't modify it
+
+      public:
+        explicit AesCtrCipher(const Block &key);
+
+        ~AesCtrCipher();
+
+        AesCtrCipher(const AesCtrCipher &) = delete;
+
+        AesCtrCipher &operator=(const AesCtrCipher &) = delete;
+
+        /**
+         * @brief Decrypts (or equivalently encrypts) the supplied data in-place
+         * @param ctr The counter block, the lower 8 bytes are replaced with the big-endian index of the AES block at the offset
+         * @param offset The offset of the data in bytes from the start of the counter's keystream, this doesn't need to be block-aligned
+         */
+        void Decrypt(span<u8> data, const Block &ctr, u64 offset) const;
+    };
+}
@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#include <arm_neon.h>
+#include <common.h>
+
+/**
+ * @brief Primitives for AES-128 using the ARMv8 Crypto Extensions, these must only be called when HasHardwareAes() is true
+ */
+namespace skyline::crypto::hardware {
+    using Block = std::array<u8, 0x10>;
+    constexpr size_t RoundKeyCount{11}; //!< The amount of round keys for AES-128
+    using RoundKeys = std::array<Block, RoundKeyCount>;
+
+    inline bool HasHardwareAes() {
+        return (getauxval(AT_HWCAP) & HWCAP_AES) != 0;
+    }
+
+    /**
+     * @brief Expands an AES-128 key into its round keys, SubWord is done with AESE on a vector of the same word in every column as ShiftRows is a no-op on it
+     */
+    __attribute__((target("aes"))) inline RoundKeys ExpandKey(const Block &key) {
+        constexpr std::array<u8, 10> RoundConstants{0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1B, 0x36};
+
+        std::array<u32, 44> words;
+        std::memcpy(words.data(), key.data(), key.size());
+        for (size_t i{4}; i < words.size(); i++) {
+            u32 word{words[i - 1]};
+            if (i % 4 == 0) {
+                uint8x16_t column{vaeseq_u8(vreinterpretq_u8_u32(vdupq_n_u32(word)), vdupq_n_u8(0))};
+                word = vgetq_lane_u32(vreinterpretq_u32_u8(column), 0);
+                word = ((word >> 8) | (word << 24)) ^ RoundConstants[(i / 4) - 1]; // RotWord and SubWord are commutative so they can be applied in any order
+            }
+            words[i] = words[i - 4] ^ word;
+        }
+
+        RoundKeys roundKeys;
+        std::memcpy(roundKeys.data(), words.data(), sizeof(words));
+        return roundKeys;
+    }
+
+    /**
+     * @brief Converts encryption round keys into the round keys for the equivalent inverse cipher, which is what AESD and AESIMC implement
+     */
+    __attribute__((target("aes"))) inline RoundKeys InvertRoundKeys(const RoundKeys &encryptionKeys) {
+        RoundKeys decryptionKeys;
+        decryptionKeys.front() = encryptionKeys.back();
+        for (size_t i{1}; i < RoundKeyCount - 1; i++)
+            vst1q_u8(decryptionKeys[i].data(), vaesimcq_u8(vld1q_u8(encryptionKeys[RoundKeyCount - 1 - i].data())));
+        decryptionKeys.back() = encryptionKeys.front();
+        return decryptionKeys;
+    }
+
+    __attribute__((target("aes"))) inline void LoadRoundKeys(const RoundKeys &roundKeys, uint8x16_t (&keys)[RoundKeyCount]) {
+        for (size_t i{}; i < RoundKeyCount; i++)
+            keys[i] = vld1q_u8(roundKeys[i].data());
+    }
+
+    __attribute__((target("aes"))) inline uint8x16_t EncryptBlock(uint8x16_t block, const uint8x16_t (&keys)[RoundKeyCount]) {
+        for (size_t round{}; round < RoundKeyCount - 2; round++)
+            block = vaesmcq_u8(vaeseq_u8(block, keys[round]));
+        return veorq_u8(vaeseq_u8(block, keys[RoundKeyCount - 2]), keys[RoundKeyCount - 1]);
+    }
+
+    /**
+     * @param keys The round keys for the inverse cipher from InvertRoundKeys
+     */
+    __attribute__((target("aes"))) inline uint8x16_t DecryptBlock(uint8x16_t block, const uint8x16_t (&keys)[RoundKeyCount]) {
+        for (size_t round{}; round < RoundKeyCount - 2; round++)
+            block = vaesimcq_u8(vaesdq_u8(block, keys[round]));
+        return veorq_u8(vaesdq_u8(block, keys[RoundKeyCount - 2]), keys[RoundKeyCount - 1]);
+    }
+}
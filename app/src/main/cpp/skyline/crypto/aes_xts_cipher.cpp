@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include "aes_hardware.h"
+#include "aes_xts_cipher.h"
+
+namespace skyline::crypto {
+    using Block = AesXtsCipher::Block;
+
+    /**
+     * @return The unencrypted tweak of a sector, this is the sector index as a big-endian 128-bit integer
+     */
+    static Block GetSectorTweak(size_t sector) {
+        Block tweak{};
+        u64 be{util::SwapEndianness(static_cast<u64>(sector))};
+        std::memcpy(tweak.data() + 8, &be, sizeof(be));
+        return tweak;
+    }
+
+    /**
+     * @brief Multiplies a tweak by the primitive element of GF(2^128), this is done for every block in a sector
+     */
+    static inline uint64x2_t MultiplyTweak(uint64x2_t tweak) {
+        u64 low{vgetq_lane_u64(tweak, 0)}, high{vgetq_lane_u64(tweak, 1)};
+        u64 carry{high >> 63};
+        high = (high << 1) | (low >> 63);
+        low = (low << 1) ^ (carry * 0x87);
+        return vcombine_u64(vcreate_u64(low), vcreate_u64(high));
+    }
+
+    __attribute__((target("aes"))) static void DecryptHardware(span<u8> data, const hardware::RoundKeys &dataRoundKeys, const hardware::RoundKeys &tweakRoundKeys, size_t sector, size_t sectorSize) {
+        uint8x16_t dataKeys[hardware::RoundKeyCount], tweakKeys[hardware::RoundKeyCount];
+        hardware::LoadRoundKeys(dataRoundKeys, dataKeys);
+        hardware::LoadRoundKeys(tweakRoundKeys, tweakKeys);
+
+        constexpr size_t Interleave{4}; //!< The amount of blocks that are decrypted together, they're independent so this hides the latency of the AES instructions
+        for (u8 *sectorPointer{data.data()}, *end{data.data() + data.size()}; sectorPointer != end; sectorPointer += sectorSize) {
+            uint64x2_t tweak{vreinterpretq_u64_u8(hardware::EncryptBlock(vld1q_u8(GetSectorTweak(sector++).data()), tweakKeys))};
+
+            u8 *pointer{sectorPointer}, *sectorEnd{sectorPointer + sectorSize};
+            for (; static_cast<size_t>(sectorEnd - pointer) >= Interleave * sizeof(Block); pointer += Interleave * sizeof(Block)) {
+                uint8x16_t tweaks[Interleave], blocks[Interleave];
+                for (size_t i{}; i < Interleave; i++) {
+                    tweaks[i] = vreinterpretq_u8_u64(tweak);
+                    tweak = MultiplyTweak(tweak);
+                    blocks[i] = veorq_u8(vld1q_u8(pointer + i * sizeof(Block)), tweaks[i]);
+                }
+
+                for (size_t i{}; i < Interleave; i++)
+                    blocks[i] = hardware::DecryptBlock(blocks[i], dataKeys);
+
+                for (size_t i{}; i < Interleave; i++)
+                    vst1q_u8(pointer + i * sizeof(Block), veorq_u8(blocks[i], tweaks[i]));
+            }
+
+            for (; pointer != sectorEnd; pointer += sizeof(Block)) {
+                uint8x16_t blockTweak{vreinterpretq_u8_u64(tweak)};
+                tweak = MultiplyTweak(tweak);
+                vst1q_u8(pointer, veorq_u8(hardware::DecryptBlock(veorq_u8(vld1q_u8(pointer), blockTweak), dataKeys), blockTweak));
+            }
+        }
+    }
+
+    AesXtsCipher::AesXtsCipher(const Key &key) : hardwareAes{hardware::HasHardwareAes()} {
+        mbedtls_aes_xts_init(&context);
+        if (mbedtls_aes_xts_setkey_dec(&context, key.data(), static_cast<unsigned int>(key.size() * 8)) != 0)
+            throw exception("Failed to set key for AES-XTS context");
+
+        if (hardwareAes) {
+            Block dataKey, tweakKey;
+            std::memcpy(dataKey.data(), key.data(), dataKey.size());
+            std::memcpy(tweakKey.data(), key.data() + dataKey.size(), tweakKey.size());
+            dataRoundKeys = hardware::InvertRoundKeys(hardware::ExpandKey(dataKey));
+            tweakRoundKeys = hardware::ExpandKey(tweakKey);
+        }
+    }
+
+    AesXtsCipher::~AesXtsCipher() {
+        mbedtls_aes_xts_free(&context);
+    }
+
+    void AesXtsCipher::Decrypt(span<u8> data, size_t sector, size_t sectorSize) const {
+        if (!sectorSize || sectorSize % sizeof(Block) || data.size() % sectorSize)
+            throw exception("Size must be a multiple of the sector size which must be a multiple of the AES block size: 0x{:X}/0x{:X}", data.size(), sectorSize);
+
+        if (hardwareAes) {
+            DecryptHardware(data, dataRoundKeys, tweakRoundKeys, sector, sectorSize);
+            return;
+        }
+
+        // Decryption with an mbedtls XTS context only reads the key schedules, so the context can be shared between threads
+        auto xtsContext{const_cast<mbedtls_aes_xts_context *>(&context)};
+        for (size_t offset{}; offset < data.size(); offset += sectorSize) {
+            auto tweak{GetSectorTweak(sector++)};
+            if (mbedtls_aes_crypt_xts(xtsContext, MBEDTLS_AES_DECRYPT, sectorSize, tweak.data(), data.data() + offset, data.data() + offset) != 0)
+                throw exception("Failed to decrypt AES-XTS sector");
+        }
+    }
+}
@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <mbedtls/aes.h>
+#include <common.h>
+
+namespace skyline::crypto {
+    /**
+     * @brief A stateless AES-128-XTS cipher which decrypts any amount of sectors in a single call, the tweak of each sector is derived from its index in the same big-endian format used by the Nintendo Switch
+     * @note As no state is modified after construction, this can be used concurrently from any amount of threads without any locking
+     * @note The ARMv8 Crypto Extensions are used when the host supports them, otherwise this falls back to the mbedtls software implementation
+     */
+    class AesXtsCipher {
+      public:
+        using Block = std::array<u8, 0x10>;
+        using Key = std::array<u8, 0x20>; //!< The data key followed by the tweak key
+
+      private:
+        static constexpr size_t RoundKeyCount{11}; //!< The amount of round keys for AES-128
+
+        bool hardwareAes; //!< If the host supports the ARMv8 AES instructions
+        std::array<Block, RoundKeyCount> dataRoundKeys{}; //!< The key schedule of the data key for the inverse cipher in the hardware implementation
+        std::array<Block, RoundKeyCount> tweakRoundKeys{}; //!< The key schedule of the tweak key for the hardware implementation
+        mbedtls_aes_xts_context context; //!< The context for the software implementation, decryption with it only reads the key schedules
+
+      public:
+        explicit AesXtsCipher(const Key &key);
+
+        ~AesXtsCipher();
+
+        AesXtsCipher(const AesXtsCipher &) = delete;
+
+        AesXtsCipher &operator=(const AesXtsCipher &) = delete;
+
+        /**
+         * @brief Decrypts the supplied sectors in-place
+         * @param sector The index of the first sector in the data
+         * @param sectorSize The size of a single sector, the size of the data must be a multiple of this and it must be a multiple of the AES block size
+         */
+        void Decrypt(span<u8> data, size_t sector, size_t sectorSize) const;
+    };
+}
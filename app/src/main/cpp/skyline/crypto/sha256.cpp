@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#include <arm_neon.h>
+#include <mbedtls/sha256.h>
+#include "sha256.h"
+
+namespace skyline::crypto {
+    constexpr size_t Sha256BlockSize{0x40}; //!< The size of a single block of the SHA-256 compression function
+
+    alignas(16) constexpr std::array<u32, 64> RoundConstants{
+        0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+        0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+        0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+        0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+        0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+        0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+        0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+        0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2,
+    };
+
+    static bool HasHardwareSha256() {
+        static const bool supported{(getauxval(AT_HWCAP) & HWCAP_SHA2) != 0};
+        return supported;
+    }
+
+    /**
+     * @brief Runs the SHA-256 compression function over the supplied 64-byte blocks
+     * @param state The ABCD and EFGH words of the hash state
+     */
+    __attribute__((target("sha2"))) static void CompressHardware(uint32x4_t (&state)[2], const u8 *data, size_t blockCount) {
+        for (size_t block{}; block < blockCount; block++, data += Sha256BlockSize) {
+            uint32x4_t abcd{state[0]}, efgh{state[1]};
+
+            uint32x4_t schedule[4];
+            for (size_t i{}; i < 4; i++)
+                schedule[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + i * sizeof(uint32x4_t))));
+
+            // Each iteration does four rounds, the message schedule for the iteration 4 after this is computed in-place as it's no longer needed
+            for (size_t i{}; i < 16; i++) {
+                uint32x4_t &words{schedule[i % 4]};
+                uint32x4_t roundInput{vaddq_u32(words, vld1q_u32(RoundConstants.data() + i * 4))};
+                if (i < 12)
+                    words = vsha256su1q_u32(vsha256su0q_u32(words, schedule[(i + 1) % 4]), schedule[(i + 2) % 4], schedule[(i + 3) % 4]);
+
+                uint32x4_t previousAbcd{abcd};
+                abcd = vsha256hq_u32(abcd, efgh, roundInput);
+                efgh = vsha256h2q_u32(efgh, previousAbcd, roundInput);
+            }
+
+            state[0] = vaddq_u32(state[0], abcd);
+            state[1] = vaddq_u32(state[1], efgh);
+        }
+    }
+
+    __attribute__((target("sha2"))) static Sha256Digest Sha256Hardware(span<const u8> data) {
+        constexpr std::array<u32, 8> InitialState{0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19};
+        uint32x4_t state[2]{vld1q_u32(InitialState.data()), vld1q_u32(InitialState.data() + 4)};
+
+        size_t fullBlocks{data.size() / Sha256BlockSize};
+        CompressHardware(state, data.data(), fullBlocks);
+
+        // The remaining data is followed by a set bit, zero padding and the big-endian length in bits, this spans two blocks if the length doesn't fit after the data
+        std::array<u8, Sha256BlockSize * 2> tail{};
+        size_t remaining{data.size() % Sha256BlockSize};
+        std::memcpy(tail.data(), data.data() + fullBlocks * Sha256BlockSize, remaining);
+        tail[remaining] = 0x80;
+        size_t tailSize{remaining + 1 + sizeof(u64) > Sha256BlockSize ? Sha256BlockSize * 2 : Sha256BlockSize};
+        u64 bitLength{util::SwapEndianness(static_cast<u64>(data.size()) * 8)};
+        std::memcpy(tail.data() + tailSize - sizeof(u64), &bitLength, sizeof(u64));
+        CompressHardware(state, tail.data(), tailSize / Sha256BlockSize);
+
+        Sha256Digest digest;
+        vst1q_u8(digest.data(), vrev32q_u8(vreinterpretq_u8_u32(state[0])));
+        vst1q_u8(digest.data() + sizeof(uint32x4_t), vrev32q_u8(vreinterpretq_u8_u32(state[1])));
+        return digest;
+    }
+
+    Sha256Digest Sha256(span<const u8> data) {
+        if (HasHardwareSha256())
+            return Sha256Hardware(data);
+
+        Sha256Digest digest;
+        if (mbedtls_sha256_ret(data.data(), data.size(), digest.data(), 0) != 0)
+            throw exception("Failed to calculate SHA-256 digest");
+        return digest;
+    }
+
+    void Sha256Blocks(span<const u8> data, size_t blockSize, span<Sha256Digest> digests) {
+        if (util::DivideCeil(data.size(), blockSize) != digests.size())
+            throw exception("Digest count doesn't match the block count: {} (Size: 0x{:X}, Block Size: 0x{:X})", digests.size(), data.size(), blockSize);
+
+        for (size_t block{}; block < digests.size(); block++)
+            digests[block] = Sha256(data.subspan(block * blockSize, std::min(blockSize, data.size() - block * blockSize)));
+    }
+}
@@ -0,0 +1,22 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common.h>
+
+namespace skyline::crypto {
+    using Sha256Digest = std::array<u8, 0x20>;
+
+    /**
+     * @return The SHA-256 digest of the supplied data
+     * @note The ARMv8 SHA-256 instructions are used when the host supports them, otherwise this falls back to mbedtls
+     */
+    Sha256Digest Sha256(span<const u8> data);
+
+    /**
+     * @brief Hashes consecutive fixed-size blocks of the supplied data in a single call, the last block may be smaller than the block size
+     * @param digests The output digests, there must be exactly one for every block in the data
+     */
+    void Sha256Blocks(span<const u8> data, size_t blockSize, span<Sha256Digest> digests);
+}
@@ -6,6 +6,9 @@
 #include <os.h>
 #include <jvm.h>
 #include <common/settings.h>
+#include <common/trace.h>
+#include <kernel/types/KProcess.h>
+#include <gpu/interconnect/maxwell_3d/pipeline_manager.h>
 #include "gpu.h"
 
 namespace skyline::gpu {
@@ -216,9 +219,11 @@ namespace skyline::gpu {
         return std::move(vk::raii::PhysicalDevices(instance).front()); // We just select the first device as we aren't expecting multiple GPUs
     }
 
-    static vk::raii::Device CreateDevice(const vk::raii::Context &context,
+    static vk::raii::Device CreateDevice(const DeviceState &state,
+                                         const vk::raii::Context &context,
                                          const vk::raii::PhysicalDevice &physicalDevice,
                                          decltype(vk::DeviceQueueCreateInfo::queueCount) &vkQueueFamilyIndex,
+                                         decltype(vk::DeviceQueueCreateInfo::queueCount) &vkQueueCount,
                                          TraitManager &traits) {
         auto deviceFeatures2{physicalDevice.getFeatures2<
             vk::PhysicalDeviceFeatures2,
@@ -232,8 +237,15 @@ namespace skyline::gpu {
             vk::PhysicalDeviceProvokingVertexFeaturesEXT,
             vk::PhysicalDevicePrimitiveTopologyListRestartFeaturesEXT,
             vk::PhysicalDeviceImagelessFramebufferFeatures,
+            vk::PhysicalDeviceTimelineSemaphoreFeatures,
             vk::PhysicalDeviceTransformFeedbackFeaturesEXT,
-            vk::PhysicalDeviceIndexTypeUint8FeaturesEXT>()};
+            vk::PhysicalDeviceIndexTypeUint8FeaturesEXT,
+            vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT,
+            vk::PhysicalDeviceExtendedDynamicState2FeaturesEXT,
+            vk::PhysicalDeviceGraphicsPipelineLibraryFeaturesEXT,
+            vk::PhysicalDeviceMultiDrawFeaturesEXT,
+            vk::PhysicalDeviceDynamicRenderingFeatures,
+            vk::PhysicalDeviceHostImageCopyFeaturesEXT>()};
         decltype(deviceFeatures2) enabledFeatures2{}; // We only want to enable features we required due to potential overhead from unused features
 
         #define FEAT_REQ(structName, feature)                                            \
@@ -269,7 +281,10 @@ namespace skyline::gpu {
             vk::PhysicalDeviceDriverProperties,
             vk::PhysicalDeviceFloatControlsProperties,
             vk::PhysicalDeviceTransformFeedbackPropertiesEXT,
-            vk::PhysicalDeviceSubgroupProperties>()};
+            vk::PhysicalDeviceGraphicsPipelineLibraryPropertiesEXT,
+            vk::PhysicalDeviceMultiDrawPropertiesEXT,
+            vk::PhysicalDeviceSubgroupProperties,
+            vk::PhysicalDeviceExternalMemoryHostPropertiesEXT>()};
 
         traits = TraitManager{deviceFeatures2, enabledFeatures2, deviceExtensions, enabledExtensions, deviceProperties2, physicalDevice};
         traits.ApplyDriverPatches(context);
@@ -280,17 +295,19 @@ namespace skyline::gpu {
             pEnabledExtensions.push_back(extension.data());
 
         auto queueFamilies{physicalDevice.getQueueFamilyProperties()};
-        float queuePriority{1.0f}; //!< The priority of the only queue we use, it's set to the maximum of 1.0
+        std::array<float, 2> queuePriorities{1.0f, 1.0f}; //!< The priorities of the main queue and the optional transfer queue, they're both set to the maximum of 1.0 as uploads on the transfer queue are usually blocking rendering
         vk::StructureChain<vk::DeviceQueueCreateInfo, vk::DeviceQueueGlobalPriorityCreateInfoEXT> queueCreateInfo{
             [&]() -> vk::DeviceQueueCreateInfo {
                 decltype(vk::DeviceQueueCreateInfo::queueFamilyIndex) index{};
                 for (const auto &queueFamily : queueFamilies) {
                     if (queueFamily.queueFlags & vk::QueueFlagBits::eGraphics && queueFamily.queueFlags & vk::QueueFlagBits::eCompute) {
                         vkQueueFamilyIndex = index;
+                        // The transfer queue is from the same family as the main queue, this avoids any queue family ownership transfers of resources shared between them
+                        vkQueueCount = (*state.settings->transferQueue && queueFamily.queueCount > 1) ? 2 : 1;
                         return vk::DeviceQueueCreateInfo{
                             .queueFamilyIndex = index,
-                            .queueCount = 1,
-                            .pQueuePriorities = &queuePriority,
+                            .queueCount = vkQueueCount,
+                            .pQueuePriorities = queuePriorities.data(),
                         };
                     }
                     index++;
@@ -366,18 +383,86 @@ namespace skyline::gpu {
           vkInstance(CreateInstance(state, vkContext)),
           vkDebugReportCallback(CreateDebugReportCallback(this, vkInstance)),
           vkPhysicalDevice(CreatePhysicalDevice(vkInstance)),
-          vkDevice(CreateDevice(vkContext, vkPhysicalDevice, vkQueueFamilyIndex, traits)),
+          vkDevice(CreateDevice(state, vkContext, vkPhysicalDevice, vkQueueFamilyIndex, vkQueueCount, traits)),
           vkQueue(vkDevice, vkQueueFamilyIndex, 0),
           memory(*this),
           scheduler(state, *this),
+          governor(state),
           presentation(state, *this),
+          mirror(state),
           texture(*this),
           buffer(*this),
           megaBufferAllocator(*this),
           descriptor(*this),
           shader(state, *this),
-          helperShaders(*this, state.os->assetFileSystem),
-          graphicsPipelineCache(*this),
+          helperShaders(*this),
+          graphicsPipelineCache(state, *this),
           renderPassCache(*this),
-          framebufferCache(*this) {}
+          framebufferCache(*this),
+          pipelineStateCache(state, *this),
+          transcodeCache(state, *this),
+          pipelineCompilerPool("Sky-PipeComp", std::clamp(std::thread::hardware_concurrency() / 4, 1U, 4U)),
+          textureDecodePool("Sky-TexDec", std::clamp(std::thread::hardware_concurrency() / 2, 1U, 4U)) {
+        if (vkQueueCount > 1) {
+            vkTransferQueue.emplace(vkDevice, vkQueueFamilyIndex, 1);
+            Logger::Info("Using a dedicated transfer queue");
+        }
+    }
+
+    std::string GPU::GetTitleCacheDirectory() const {
+        u64 titleId{state.process->npdm.aci0.programId}; // NPDM structures are packed so the member can't be bound to a reference directly
+        return fmt::format("{}gpu_cache/{:016X}/", state.os->publicAppFilesPath, titleId);
+    }
+
+    void GPU::ReplayRecordedPipelines() {
+        pipelineStateCache.Replay([this](span<const u8> record) {
+            interconnect::maxwell3d::PipelineManager::CompileRecordedPipeline(*this, record);
+        });
+    }
+
+    size_t GPU::Trim(TrimLevel level) {
+        TRACE_EVENT("gpu", "GPU::Trim", "level", static_cast<u32>(level));
+
+        // Holding the channel lock ensures that no executions are in progress and all recorded work has been submitted
+        std::scoped_lock lock{channelLock};
+        {
+            std::scoped_lock queueLock{queueMutex};
+            vkQueue.waitIdle(); // Any resources that are still referenced by submitted work can't be evicted
+        }
+        if (vkTransferQueue) {
+            std::scoped_lock queueLock{transferQueueMutex};
+            vkTransferQueue->waitIdle();
+        }
+
+        // Resources are freed in order of how cheap they are to recreate relative to how much memory they're likely to free
+        auto textureBytes{texture.GetResidentBytes()}, bufferBytes{buffer.GetResidentBytes()};
+        size_t cleanTextureBytes{texture.Trim(true)};
+        auto megaBufferBytes{megaBufferAllocator.Trim()};
+        shader.TrimPools(); // No shaders can be translated while the channel lock is held
+        u32 descriptorSetCount{descriptor.Trim()};
+        auto stagingBytes{memory.TrimStagingPool()};
+
+        size_t dirtyTextureBytes{}, evictedBufferBytes{};
+        if (level == TrimLevel::Complete) {
+            dirtyTextureBytes = texture.Trim();
+            buffer.Trim();
+            evictedBufferBytes = bufferBytes - buffer.GetResidentBytes();
+
+            // The process may be killed while it's in the background, so the pipeline cache is persisted now rather than on exit
+            graphicsPipelineCache.SaveVkPipelineCache();
+        }
+
+        size_t freedBytes{cleanTextureBytes + dirtyTextureBytes + evictedBufferBytes + megaBufferBytes + stagingBytes};
+        constexpr size_t MiB{1024 * 1024};
+        Logger::Info("Trimmed GPU resources ({}): Textures {} -> {} MiB, Buffers {} -> {} MiB, Megabuffer {} MiB, Staging {} MiB, {} descriptor sets, {} MiB freed", level == TrimLevel::Complete ? "Complete" : "Reclaim", textureBytes / MiB, texture.GetResidentBytes() / MiB, bufferBytes / MiB, buffer.GetResidentBytes() / MiB, megaBufferBytes / MiB, stagingBytes / MiB, descriptorSetCount, freedBytes / MiB);
+        return freedBytes;
+    }
+
+    void GPU::SynchronizeGuest() {
+        TRACE_EVENT("gpu", "GPU::SynchronizeGuest");
+
+        std::scoped_lock lock{channelLock}; // No executions can be in progress while resources are being written back as they could modify them again
+        texture.SynchronizeGuest();
+        buffer.SynchronizeGuest();
+    }
 }
@@ -3,10 +3,13 @@
 
 #pragma once
 
+#include <common/thread_pool.h>
 #include "gpu/trait_manager.h"
 #include "gpu/memory_manager.h"
 #include "gpu/command_scheduler.h"
+#include "gpu/performance_governor.h"
 #include "gpu/presentation_engine.h"
+#include "gpu/mirror_cache.h"
 #include "gpu/texture_manager.h"
 #include "gpu/buffer_manager.h"
 #include "gpu/megabuffer.h"
@@ -16,6 +19,8 @@
 #include "gpu/cache/graphics_pipeline_cache.h"
 #include "gpu/cache/renderpass_cache.h"
 #include "gpu/cache/framebuffer_cache.h"
+#include "gpu/cache/pipeline_state_cache.h"
+#include "gpu/cache/transcode_cache.h"
 
 namespace skyline::gpu {
     static constexpr u32 VkApiVersion{VK_API_VERSION_1_1}; //!< The version of core Vulkan that we require
@@ -27,6 +32,7 @@ namespace skyline::gpu {
       private:
         const DeviceState &state; // We access the device state inside Texture (and Buffers) for setting up NCE memory tracking
         friend Texture;
+        friend TextureManager;
         friend Buffer;
 
       public:
@@ -35,15 +41,20 @@ namespace skyline::gpu {
         vk::raii::DebugReportCallbackEXT vkDebugReportCallback; //!< An RAII Vulkan debug report manager which calls into 'GPU::DebugCallback'
         vk::raii::PhysicalDevice vkPhysicalDevice;
         u32 vkQueueFamilyIndex{};
+        u32 vkQueueCount{}; //!< The amount of queues created from the queue family, a dedicated transfer queue is only available if this is more than 1
         TraitManager traits;
         vk::raii::Device vkDevice;
         std::mutex queueMutex; //!< Synchronizes access to the queue as it is externally synchronized
         vk::raii::Queue vkQueue; //!< A Vulkan Queue supporting graphics and compute operations
+        std::mutex transferQueueMutex; //!< Synchronizes access to the transfer queue as it is externally synchronized
+        std::optional<vk::raii::Queue> vkTransferQueue; //!< An optional second queue from the same family as `vkQueue` that uploads and readbacks are submitted on to overlap them with rendering
 
         memory::MemoryManager memory;
         CommandScheduler scheduler;
+        PerformanceGovernor governor;
         PresentationEngine presentation;
 
+        MirrorCache mirror; //!< The mirrors of guest memory used by textures and buffers, this must outlive both managers
         TextureManager texture;
         BufferManager buffer;
         MegaBufferAllocator megaBufferAllocator;
@@ -56,9 +67,48 @@ namespace skyline::gpu {
         cache::GraphicsPipelineCache graphicsPipelineCache;
         cache::RenderPassCache renderPassCache;
         cache::FramebufferCache framebufferCache;
+        cache::PipelineStateCache pipelineStateCache;
+        cache::TranscodeCache transcodeCache;
 
-        std::mutex channelLock;
+        ThreadPool pipelineCompilerPool; //!< A bounded pool of threads which pipelines are compiled on when asynchronous pipeline compilation is enabled
+        ThreadPool textureDecodePool; //!< A pool of threads which large BCn textures are decoded on in parallel for hosts without BCn support
+
+        std::mutex channelLock; //!< Serializes executions across channels, the texture manager and the megabuffer allocator have their own locks but executions hold tagged locks on textures and buffers till they are submitted which could deadlock between concurrent channels
 
         GPU(const DeviceState &state);
+
+        /**
+         * @return The path to the directory where persistent GPU caches for the running title should be stored
+         * @note This must only be called after the process has been created as it depends on the title ID
+         */
+        std::string GetTitleCacheDirectory() const;
+
+        /**
+         * @brief Starts compiling all pipelines that were recorded during previous runs of the title in the background
+         * @note This must only be called after the process has been created as it depends on the title ID
+         */
+        void ReplayRecordedPipelines();
+
+        /**
+         * @brief How aggressively host memory should be freed by Trim, this corresponds to the severity of the memory pressure
+         */
+        enum class TrimLevel {
+            Reclaim, //!< Only resources that are cheap to recreate are freed: clean textures, idle megabuffer chunks, shader compilation pools, an idle descriptor pool and idle staging buffers
+            Complete, //!< All resources that aren't in use are freed, this additionally writes back and evicts GPU-modified textures and evicts all buffers
+        };
+
+        /**
+         * @brief Frees host memory while retaining the resources that are still in use, this is done under memory pressure and when the app is backgrounded
+         * @return An estimate of the amount of bytes that were freed, descriptor pools aren't included as their size is driver-defined
+         * @note Any GPU modifications to evicted resources are written back to the guest, they're lazily recreated from the guest on their next use
+         * @note The guest should be paused prior to a complete trim, otherwise freed resources may be immediately recreated
+         */
+        size_t Trim(TrimLevel level = TrimLevel::Complete);
+
+        /**
+         * @brief Writes back all GPU modifications to textures and buffers into guest memory without evicting them, this is required for the guest memory to be a complete copy of its contents
+         * @note The guest should be paused prior to calling this, otherwise the GPU may modify resources again immediately after they're written back
+         */
+        void SynchronizeGuest();
     };
 }
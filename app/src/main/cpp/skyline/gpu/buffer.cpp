@@ -2,6 +2,7 @@
 // Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
 #include <gpu.h>
+#include <common/settings.h>
 #include <kernel/memory.h>
 #include <kernel/types/KProcess.h>
 #include <common/trace.h>
@@ -21,9 +22,24 @@ namespace skyline::gpu {
         u8 *alignedData{util::AlignDown(guest->data(), constant::PageSize)};
         size_t alignedSize{static_cast<size_t>(util::AlignUp(guest->data() + guest->size(), constant::PageSize) - alignedData)};
 
-        alignedMirror = gpu.state.process->memory.CreateMirror(span<u8>{alignedData, alignedSize});
+        auto guestMirror{gpu.mirror.Acquire(span<u8>{alignedData, alignedSize})};
+        alignedMirror = guestMirror.mirror;
+        mirrorMapping = std::move(guestMirror.mapping);
         mirror = alignedMirror.subspan(static_cast<size_t>(guest->data() - alignedData), guest->size());
 
+        // The backing can only alias the mirror when the guest buffer starts on a page boundary as buffer offsets are relative to the start of the guest buffer, this is always the case for buffers from the buffer manager
+        if (*gpu.state.settings->importGuestBuffers && mirror.data() == alignedMirror.data()) {
+            if (auto importedBuffer{gpu.memory.ImportBuffer(alignedMirror)}) {
+                backing = std::move(*importedBuffer);
+                importedBacking = true;
+            }
+        }
+
+        if (!importedBacking) {
+            backing = gpu.memory.AllocateBuffer(guest->size());
+            gpu.buffer.residentBytes += backing.size(); // Imported backings are guest memory so they don't count towards the budget
+        }
+
         // We can't just capture this in the lambda since the lambda could exceed the lifetime of the buffer
         std::weak_ptr<Buffer> weakThis{shared_from_this()};
         trapHandle = gpu.state.nce->CreateTrap(*guest, [weakThis] {
@@ -32,7 +48,7 @@ namespace skyline::gpu {
                 return;
 
             std::unique_lock stateLock{buffer->stateMutex};
-            if (buffer->AllCpuBackingWritesBlocked() || buffer->dirtyState == DirtyState::GpuDirty) {
+            if (buffer->AllCpuBackingWritesBlocked() || buffer->dirtyState == DirtyState::GpuDirty || buffer->importedBacking) { // Guest writes to an imported backing would be visible to the GPU, so they must wait on any GPU usage
                 stateLock.unlock(); // If the lock isn't unlocked, a deadlock from threads waiting on the other lock can occur
 
                 // If this mutex would cause other callbacks to be blocked then we should block on this mutex in advance
@@ -71,6 +87,7 @@ namespace skyline::gpu {
             if (buffer->cycle)
                 return false;
 
+            buffer->readbackCount++;
             buffer->SynchronizeGuest(true); // We can skip trapping since the caller will do it
             return true;
         }, [weakThis] {
@@ -84,7 +101,7 @@ namespace skyline::gpu {
             if (!stateLock)
                 return false;
 
-            if (!buffer->AllCpuBackingWritesBlocked() && buffer->dirtyState != DirtyState::GpuDirty) {
+            if (!buffer->importedBacking && !buffer->AllCpuBackingWritesBlocked() && buffer->dirtyState != DirtyState::GpuDirty) {
                 buffer->dirtyState = DirtyState::CpuDirty;
                 return true;
             }
@@ -105,7 +122,7 @@ namespace skyline::gpu {
 
     Buffer::Buffer(LinearAllocatorState<> &delegateAllocator, GPU &gpu, GuestBuffer guest, size_t id)
         : gpu{gpu},
-          backing{gpu.memory.AllocateBuffer(guest.size())},
+          backing{nullptr, 0, nullptr, {}, nullptr},
           guest{guest},
           delegate{delegateAllocator.EmplaceUntracked<BufferDelegate>(this)},
           id{id},
@@ -125,9 +142,43 @@ namespace skyline::gpu {
         if (trapHandle)
             gpu.state.nce->DeleteTrap(*trapHandle);
         SynchronizeGuest(true);
-        if (alignedMirror.valid())
-            munmap(alignedMirror.data(), alignedMirror.size());
         WaitOnFence();
+        if (guest && IsResident() && !importedBacking)
+            gpu.buffer.residentBytes -= backing.size();
+        backing = memory::Buffer{nullptr, 0, nullptr, {}, nullptr}; // An imported backing aliases the mirror so it must be destroyed prior to the mirror being unmapped
+        mirrorMapping.reset();
+    }
+
+    bool Buffer::EvictBacking() {
+        if (!guest || !IsResident() || importedBacking || tag.load() || AllCpuBackingWritesBlocked() || !PollFence())
+            return false;
+
+        {
+            std::scoped_lock lock{stateMutex};
+            if (dirtyState == DirtyState::GpuDirty)
+                SynchronizeGuest(true); // Any GPU writes need to be written back to the guest as the mirror is the only copy of the data once the backing is freed
+
+            // The buffer is left CPU dirty without any traps as the guest can freely write to the mirror while there's no backing to keep in sync with it
+            dirtyState = DirtyState::CpuDirty;
+            gpu.state.nce->RemoveTrap(*trapHandle);
+        }
+
+        ResetMegabufferState();
+        AdvanceSequence(); // Views may have cached copies of the backing contents which won't match the contents after it's refilled
+
+        gpu.buffer.residentBytes -= backing.size();
+        backing = memory::Buffer{nullptr, 0, nullptr, {}, nullptr};
+        return true;
+    }
+
+    void Buffer::EnsureResident() {
+        if (IsResident() || !guest || !mirror.valid()) [[likely]]
+            return; // The initial backing is created by SetupGuestMappings() rather than here
+
+        TRACE_EVENT("gpu", "Buffer::EnsureResident");
+
+        backing = gpu.memory.AllocateBuffer(guest->size());
+        gpu.buffer.residentBytes += backing.size();
     }
 
     void Buffer::MarkGpuDirty() {
@@ -145,7 +196,8 @@ namespace skyline::gpu {
             SynchronizeHost(true); // Will transition the Buffer to Clean
 
         dirtyState = DirtyState::GpuDirty;
-        gpu.state.nce->PageOutRegions(*trapHandle); // All data can be paged out from the guest as the guest mirror won't be used
+        if (!importedBacking)
+            gpu.state.nce->PageOutRegions(*trapHandle); // All data can be paged out from the guest as the guest mirror won't be used, this isn't the case for imported backings as the guest memory is the backing
 
         BlockAllCpuBackingWrites();
         AdvanceSequence(); // The GPU will modify buffer contents so advance to the next sequence
@@ -178,6 +230,10 @@ namespace skyline::gpu {
             trapHandle = {};
         }
 
+        // The buffer is no longer tracked by the buffer manager, so its backing doesn't count towards the budget anymore
+        if (guest && IsResident() && !importedBacking)
+            gpu.buffer.residentBytes -= backing.size();
+
         // Will prevent any sync operations so even if the trap handler is partway through running and hasn't yet acquired the lock it won't do anything
         guest = {};
     }
@@ -202,7 +258,8 @@ namespace skyline::gpu {
                 gpu.state.nce->TrapRegions(*trapHandle, true); // Trap any future CPU writes to this buffer, must be done before the memcpy so that any modifications during the copy are tracked
         }
 
-        std::memcpy(backing.data(), mirror.data(), mirror.size());
+        if (!importedBacking)
+            std::memcpy(backing.data(), mirror.data(), mirror.size());
     }
 
     bool Buffer::SynchronizeGuest(bool skipTrap, bool nonBlocking) {
@@ -221,7 +278,15 @@ namespace skyline::gpu {
                 return false; // If the fence is not signalled and non-blocking behaviour is requested then bail out
 
             WaitOnFence();
-            std::memcpy(mirror.data(), backing.data(), mirror.size());
+
+            if (readbackCycle && readbackSequenceNumber == sequenceNumber) {
+                // The contents were already copied into host cached memory at the end of the last execution that modified them, this avoids reading the uncached backing
+                readbackCycle->Wait();
+                std::memcpy(mirror.data(), readbackStaging[readbackStagingIndex]->data(), mirror.size());
+            } else if (!importedBacking) { // The GPU writes directly to the mirror with an imported backing, so waiting on the fence is sufficient
+                std::memcpy(mirror.data(), backing.data(), mirror.size());
+            }
+            readbackCycle = {};
 
             dirtyState = DirtyState::Clean;
         }
@@ -232,6 +297,25 @@ namespace skyline::gpu {
         return true;
     }
 
+    std::shared_ptr<memory::StagingBuffer> Buffer::PrepareAsyncReadback(const std::shared_ptr<FenceCycle> &pCycle) {
+        if (!guest || !IsResident() || importedBacking || readbackCount < FrequentReadbackThreshold || backing.size() > AsyncReadbackMaxSize)
+            return nullptr;
+
+        std::scoped_lock lock{stateMutex};
+        if (dirtyState != DirtyState::GpuDirty || (readbackCycle && readbackSequenceNumber == sequenceNumber))
+            return nullptr; // There's either nothing to read back or the contents haven't changed since the last readback
+
+        // The other staging buffer is used so a copy from a prior execution that might still be read by the CPU is never overwritten by the GPU
+        readbackStagingIndex ^= 1;
+        auto &stagingBuffer{readbackStaging[readbackStagingIndex]};
+        if (!stagingBuffer || stagingBuffer->size() != backing.size())
+            stagingBuffer = gpu.memory.AllocateReadbackBuffer(backing.size());
+
+        readbackCycle = pCycle;
+        readbackSequenceNumber = sequenceNumber;
+        return stagingBuffer;
+    }
+
     void Buffer::SynchronizeGuestImmediate(bool isFirstUsage, const std::function<void()> &flushHostCallback) {
         // If this buffer was attached to the current cycle, flush all pending host GPU work and wait to ensure that we read valid data
         if (!isFirstUsage)
@@ -241,8 +325,10 @@ namespace skyline::gpu {
     }
 
     void Buffer::Read(bool isFirstUsage, const std::function<void()> &flushHostCallback, span<u8> data, vk::DeviceSize offset) {
-        if (dirtyState == DirtyState::GpuDirty)
+        if (dirtyState == DirtyState::GpuDirty) {
+            readbackCount++;
             SynchronizeGuestImmediate(isFirstUsage, flushHostCallback);
+        }
 
         std::memcpy(data.data(), mirror.data() + offset, data.size());
     }
@@ -254,6 +340,21 @@ namespace skyline::gpu {
         // We cannot have *ANY* state changes for the duration of this function, if the buffer became CPU dirty partway through the GPU writes would mismatch the CPU writes
         std::scoped_lock lock{stateMutex};
 
+        if (importedBacking) {
+            // The backing is the mirror, so the write can only be done on the CPU when it doesn't need to be sequenced and the GPU isn't using the buffer, otherwise it's done on the GPU and the buffer stays GPU dirty till it's executed
+            if (dirtyState != DirtyState::GpuDirty && !SequencedCpuBackingWritesBlocked() && PollFence()) {
+                std::memcpy(mirror.data() + offset, data.data(), data.size());
+                return false;
+            }
+
+            if (!gpuCopyCallback)
+                return true;
+
+            MarkGpuDirty();
+            gpuCopyCallback();
+            return false;
+        }
+
         // If the buffer is GPU dirty do the write on the GPU and we're done
         if (dirtyState == DirtyState::GpuDirty) {
             if (gpuCopyCallback)
@@ -298,6 +399,17 @@ namespace skyline::gpu {
             // If the buffer is used in sequence directly on the GPU, SynchronizeHost before modifying the mirror contents to ensure proper sequencing. This write will then be sequenced on the GPU instead (the buffer will be kept clean for the rest of the execution due to gpuCopyCallback blocking all writes)
             SynchronizeHost();
 
+        if (importedBacking) {
+            // See Write(), a single copy on the CPU updates both the mirror and backing
+            if (dirtyState != DirtyState::GpuDirty && src->dirtyState != DirtyState::GpuDirty && !SequencedCpuBackingWritesBlocked() && PollFence()) {
+                std::memcpy(mirror.data() + dstOffset, src->mirror.data() + srcOffset, size);
+            } else {
+                MarkGpuDirty();
+                gpuCopyCallback();
+            }
+            return;
+        }
+
         if (dirtyState != DirtyState::GpuDirty && src->dirtyState != DirtyState::GpuDirty) {
             std::memcpy(mirror.data() + dstOffset, src->mirror.data() + srcOffset, size);
 
@@ -395,6 +507,7 @@ namespace skyline::gpu {
     void Buffer::lock() {
         mutex.lock();
         accumulatedCpuLockCounter++;
+        EnsureResident();
     }
 
     bool Buffer::LockWithTag(ContextTag pTag) {
@@ -403,6 +516,8 @@ namespace skyline::gpu {
 
         mutex.lock();
         tag = pTag;
+        lastAccessTimestamp = gpu.buffer.accessTimestamp.fetch_add(1, std::memory_order_relaxed);
+        EnsureResident();
         return true;
     }
 
@@ -415,6 +530,7 @@ namespace skyline::gpu {
     bool Buffer::try_lock() {
         if (mutex.try_lock()) {
             accumulatedCpuLockCounter++;
+            EnsureResident();
             return true;
         }
         return false;
@@ -422,32 +538,21 @@ namespace skyline::gpu {
 
     BufferDelegate::BufferDelegate(Buffer *buffer) : buffer{buffer} {}
 
-    Buffer *BufferDelegate::GetBuffer() {
-        if (linked) [[unlikely]]
-            return link->GetBuffer();
-        else
-            return buffer;
-    }
-
     void BufferDelegate::Link(BufferDelegate *newTarget, vk::DeviceSize newOffset) {
         if (linked)
             throw exception("Cannot link a buffer delegate that is already linked!");
 
-        linked = true;
-        link = newTarget;
-        offset = newOffset;
-    }
-
-    vk::DeviceSize BufferDelegate::GetOffset() {
-        if (linked) [[unlikely]]
-            return link->GetOffset() + offset;
-        else
-            return offset;
-    }
+        // Retarget every delegate in this list directly at the new buffer and splice the list into the new target's list
+        BufferDelegate *last{};
+        for (auto delegate{this}; delegate; delegate = delegate->next) {
+            delegate->buffer = newTarget->buffer;
+            delegate->offset += newTarget->offset + newOffset;
+            delegate->linked = true;
+            last = delegate;
+        }
 
-    void BufferView::ResolveDelegate() {
-        offset += delegate->GetOffset();
-        delegate = delegate->GetBuffer()->delegate;
+        last->next = newTarget->next;
+        newTarget->next = this;
     }
 
     BufferView::BufferView() {}
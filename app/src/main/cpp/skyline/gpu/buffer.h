@@ -52,7 +52,9 @@ namespace skyline::gpu {
 
         span<u8> mirror{}; //!< A contiguous mirror of all the guest mappings to allow linear access on the CPU
         span<u8> alignedMirror{}; //!< The mirror mapping aligned to page size to reflect the full mapping
+        std::shared_ptr<void> mirrorMapping; //!< Keeps the mirror mapped, the mapping may be shared with other resources that mirror the same pages
         std::optional<nce::NCE::TrapHandle> trapHandle{}; //!< The handle of the traps for the guest mappings
+        bool importedBacking{}; //!< If the backing is the guest memory itself imported through the mirror, the backing and mirror alias so no copies between them are required but the CPU can only write to the mirror while the GPU isn't using the buffer
 
         enum class DirtyState {
             Clean, //!< The CPU mappings are in sync with the GPU buffer
@@ -91,6 +93,16 @@ namespace skyline::gpu {
         static constexpr size_t FrequentlyLockedThreshold{2}; //!< Threshold for the number of times a buffer can be locked (not from context locks, only normal) before it should be considered frequently locked
         size_t accumulatedCpuLockCounter{}; //!< Number of times buffer has been locked through non-ContextLocks
 
+        static constexpr size_t FrequentReadbackThreshold{4}; //!< Threshold for the number of times GPU written contents of a buffer can be read by the CPU before they're read back asynchronously at the end of every execution that uses it
+        static constexpr vk::DeviceSize AsyncReadbackMaxSize{1024 * 1024}; //!< The maximum size of a buffer for it to be read back asynchronously, larger buffers aren't worth the staging memory and GPU copy on every execution
+        size_t readbackCount{}; //!< Number of times GPU written contents of the buffer have been synchronized to the guest for a CPU read
+        std::array<std::shared_ptr<memory::StagingBuffer>, 2> readbackStaging; //!< A double-buffered ring of host cached buffers that the backing is copied into at the end of executions, the GPU can copy into one while the CPU reads from the other
+        size_t readbackStagingIndex{}; //!< The index of the staging buffer in `readbackStaging` that was copied into last
+        std::shared_ptr<FenceCycle> readbackCycle; //!< The cycle of the execution that last copied into `readbackStaging[readbackStagingIndex]`
+        u32 readbackSequenceNumber{}; //!< The sequence number of the backing contents that were copied into `readbackStaging[readbackStagingIndex]`, the copy is stale if this doesn't match `sequenceNumber`
+
+        u64 lastAccessTimestamp{}; //!< The value of the buffer manager's access timestamp when the buffer was last locked with a tag, this is used to determine which buffers should be evicted first
+
         /**
          * @brief Resets all megabuffer tracking state
          */
@@ -103,10 +115,31 @@ namespace skyline::gpu {
         friend BufferManager;
 
         /**
-         * @brief Sets up mirror mappings for the guest mappings, this must be called after construction for the mirror to be valid
+         * @brief Sets up mirror mappings for the guest mappings and the backing, this must be called after construction for the mirror and backing to be valid
+         * @note The backing is imported from the mirror when enabled and supported by the device, otherwise it's allocated separately
          */
         void SetupGuestMappings();
 
+        /**
+         * @brief Frees the host backing of the buffer while retaining the buffer object and its delegates, the backing is lazily reallocated and refilled from the mirror on the next lock
+         * @return If the backing was freed, this'll be false if the buffer is still in use by the GPU or the current context
+         * @note The buffer **must** be locked prior to calling this
+         */
+        bool EvictBacking();
+
+        /**
+         * @brief Reallocates the host backing of the buffer if it was freed by EvictBacking(), the contents will be synchronized from the mirror on the next SynchronizeHost() as the buffer is left CPU dirty
+         * @note The buffer **must** be locked prior to calling this
+         */
+        void EnsureResident();
+
+        /**
+         * @return If the buffer currently has a host backing allocated
+         */
+        bool IsResident() const {
+            return static_cast<bool>(backing.vkBuffer);
+        }
+
       public:
         void UpdateCycle(const std::shared_ptr<FenceCycle> &newCycle) {
             newCycle->ChainCycle(cycle);
@@ -129,7 +162,7 @@ namespace skyline::gpu {
 
         /**
          * @brief Creates a buffer object wrapping the guest buffer with a backing that can represent the guest buffer data
-         * @note The guest mappings will not be setup until SetupGuestMappings() is called
+         * @note The guest mappings and the backing will not be setup until SetupGuestMappings() is called
          */
         Buffer(LinearAllocatorState<> &delegateAllocator, GPU &gpu, GuestBuffer guest, size_t id);
 
@@ -216,6 +249,16 @@ namespace skyline::gpu {
             return backingImmutability == BackingImmutability::AllWrites;
         }
 
+        /**
+         * @return The sequence number of the backing contents, this is empty if the buffer is GPU dirty as the contents can then change without the sequence being advanced
+         * @note The buffer **must** be locked prior to calling this
+         */
+        std::optional<u32> GetDeterminateSequence() const {
+            if (dirtyState == DirtyState::GpuDirty)
+                return std::nullopt;
+            return sequenceNumber;
+        }
+
         /**
          * @return If the cycle needs to be attached to the buffer before ending the current context
          * @note This is an alias for `SequencedCpuBackingWritesBlocked()` since this is only ever set when the backing is accessed on the GPU in some form
@@ -268,6 +311,14 @@ namespace skyline::gpu {
          */
         bool SynchronizeGuest(bool skipTrap = false, bool nonBlocking = false);
 
+        /**
+         * @brief Prepares an asynchronous readback of the GPU written contents of the buffer into a host cached staging buffer if it's frequently read back by the CPU, SynchronizeGuest will read from the staging buffer rather than the backing while its contents are current
+         * @param pCycle The cycle of the execution that the copy will be recorded into, it must be recorded after all other commands in the execution
+         * @return The staging buffer that the entire backing must be copied into, this is null if the buffer shouldn't be read back asynchronously
+         * @note The buffer **must** be locked prior to calling this
+         */
+        std::shared_ptr<memory::StagingBuffer> PrepareAsyncReadback(const std::shared_ptr<FenceCycle> &pCycle);
+
         /**
          * @brief Synchronizes the guest buffer with the host buffer immediately, flushing GPU work if necessary
          * @param isFirstUsage If this is the first usage of this resource in the context as returned from LockWithTag(...)
@@ -335,28 +386,29 @@ namespace skyline::gpu {
 
     /**
      * @brief A delegate for a strong reference to a Buffer by a BufferView which can be changed to another Buffer transparently
+     * @details All delegates targeting a buffer form an intrusive list headed by the buffer's own delegate, when a buffer is merged into another the entire list is retargeted at once so that resolving a delegate never takes more than a single hop regardless of how many merges have occurred
      */
     class BufferDelegate {
       private:
-        union {
-            BufferDelegate *link{};
-            Buffer *buffer;
-        };
-        vk::DeviceSize offset{};
-
-        bool linked{};
+        Buffer *buffer;
+        vk::DeviceSize offset{}; //!< The offset of the start of the delegate's original buffer in the target buffer
+        BufferDelegate *next{}; //!< The next delegate in the list of delegates targeting the same buffer
+        bool linked{}; //!< If the delegate has been linked to another buffer's delegate, it can't be the head of a list after this
 
       public:
         BufferDelegate(Buffer *buffer);
 
         /**
-         * @brief Follows links to get the underlying target buffer of the delegate
+         * @return The target buffer of the delegate
          */
-        Buffer *GetBuffer();
+        Buffer *GetBuffer() const {
+            return buffer;
+        }
 
         /**
-         * @brief Links the delegate to target a new buffer object
+         * @brief Links the delegate and all delegates targeting the same buffer to target the buffer of a new delegate
          * @note Both the current target buffer object and new target buffer object **must** be locked prior to calling this
+         * @note This **must** only be called on the delegate that's owned by the current target buffer
          */
         void Link(BufferDelegate *newTarget, vk::DeviceSize newOffset);
 
@@ -364,7 +416,9 @@ namespace skyline::gpu {
          * @return The offset of the delegate in the buffer
          * @note The target buffer **must** be locked prior to calling this
          */
-        vk::DeviceSize GetOffset();
+        vk::DeviceSize GetOffset() const {
+            return offset;
+        }
     };
 
     /**
@@ -377,12 +431,6 @@ namespace skyline::gpu {
         BufferDelegate *delegate{};
         vk::DeviceSize offset{};
 
-        /**
-         * @brief Resolves the delegate's pointer chain so it directly points to the target buffer, updating offset accordingly
-         * @note The view **must** be locked prior to calling this
-         */
-        void ResolveDelegate();
-
       public:
         vk::DeviceSize size{};
 
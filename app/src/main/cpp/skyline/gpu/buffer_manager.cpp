@@ -1,11 +1,34 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <common/settings.h>
+#include <common/trace.h>
+#include <common/perf_stats.h>
 #include <gpu.h>
 #include "buffer_manager.h"
 
 namespace skyline::gpu {
-    BufferManager::BufferManager(GPU &gpu) : gpu{gpu} {}
+    BufferManager::BufferManager(GPU &gpu) : gpu{gpu} {
+        if (u32 budgetMib{*gpu.state.settings->bufferMemoryBudget})
+            memoryBudget = static_cast<size_t>(budgetMib) << 20;
+        else
+            memoryBudget = gpu.memory.GetDeviceLocalBudget() / 4; // Buffers must share the budget with textures which take up half of it by default
+
+        Logger::Info("Buffer memory budget: {} MiB", memoryBudget / (1024 * 1024));
+
+        if (gpu.traits.supportsSparseResidencyBuffer) {
+            // Sparse guest mappings have no backing memory, rather than creating a guest buffer over the zero filled sparse map for every one of them they're all bound to a single sparse buffer without any resident pages
+            sparseBufferSize = std::min(MaxSparseBufferSize, gpu.vkPhysicalDevice.getProperties().limits.sparseAddressSpaceSize);
+            sparseBuffer.emplace(gpu.vkDevice, vk::BufferCreateInfo{
+                .flags = vk::BufferCreateFlagBits::eSparseBinding | vk::BufferCreateFlagBits::eSparseResidency,
+                .size = sparseBufferSize,
+                .usage = vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndirectBuffer,
+                .sharingMode = vk::SharingMode::eExclusive,
+                .queueFamilyIndexCount = 1,
+                .pQueueFamilyIndices = &gpu.vkQueueFamilyIndex,
+            });
+        }
+    }
 
     bool BufferManager::BufferLessThan(const std::shared_ptr<Buffer> &it, u8 *pointer) {
         return it->guest->begin().base() < pointer;
@@ -41,12 +64,16 @@ namespace skyline::gpu {
     }
 
     void BufferManager::InsertBuffer(std::shared_ptr<Buffer> buffer) {
+        InvalidateLookupCache();
+
         auto bufferStart{buffer->guest->begin().base()}, bufferEnd{buffer->guest->end().base()};
         bufferTable.Set(bufferStart, bufferEnd, buffer.get());
         bufferMappings.insert(std::lower_bound(bufferMappings.begin(), bufferMappings.end(), bufferEnd, BufferLessThan), std::move(buffer));
     }
 
     void BufferManager::DeleteBuffer(const std::shared_ptr<Buffer> &buffer) {
+        InvalidateLookupCache();
+
         bufferTable.Set(buffer->guest->begin().base(), buffer->guest->end().base(), nullptr);
         bufferMappings.erase(std::find(bufferMappings.begin(), bufferMappings.end(), buffer));
     }
@@ -77,6 +104,7 @@ namespace skyline::gpu {
         }
 
         LockedBuffer newBuffer{std::make_shared<Buffer>(delegateAllocatorState, gpu, span<u8>{lowestAddress, highestAddress}, nextBufferId++), tag}; // If we don't lock the buffer prior to trapping it during synchronization, a race could occur with a guest trap acquiring the lock before we do and mutating the buffer prior to it being ready
+        PerfStats::Increment(PerfStats::Counter::BufferCreations);
 
         newBuffer->SetupGuestMappings();
         newBuffer->SynchronizeHost(false); // Overlaps don't necessarily fully cover the buffer so we have to perform a sync here to prevent any gaps
@@ -104,19 +132,24 @@ namespace skyline::gpu {
             newBuffer->everHadInlineUpdate |= srcBuffer->everHadInlineUpdate;
 
             if (srcBuffer->dirtyState == Buffer::DirtyState::GpuDirty) {
-                if (srcBuffer.lock.IsFirstUsage() && newBuffer->dirtyState != Buffer::DirtyState::GpuDirty)
-                    copyBuffer(*newBuffer->guest, *srcBuffer->guest, newBuffer->mirror.data(), srcBuffer->backing.data());
-                else
+                if (srcBuffer.lock.IsFirstUsage() && newBuffer->dirtyState != Buffer::DirtyState::GpuDirty) {
+                    if (!srcBuffer->importedBacking)
+                        copyBuffer(*newBuffer->guest, *srcBuffer->guest, newBuffer->mirror.data(), srcBuffer->backing.data());
+                } else {
                     newBuffer->MarkGpuDirty();
+                }
 
                 // Since we don't synchost source buffers and the source buffers here are GPU dirty their mirrors will be out of date, meaning the backing contents of this source buffer's region in the new buffer from the initial synchost call will be incorrect. By copying backings directly here we can ensure that no writes are lost and that if the newly created buffer needs to turn GPU dirty during recreation no copies need to be done since the backing is as up to date as the mirror at a minimum.
-                copyBuffer(*newBuffer->guest, *srcBuffer->guest, newBuffer->backing.data(), srcBuffer->backing.data());
+                // An imported source backing is the guest memory itself which was waited on prior to the initial synchost, so it's already up to date in the new buffer
+                if (!srcBuffer->importedBacking)
+                    copyBuffer(*newBuffer->guest, *srcBuffer->guest, newBuffer->backing.data(), srcBuffer->backing.data());
             } else if (srcBuffer->AllCpuBackingWritesBlocked()) {
                 if (srcBuffer->dirtyState == Buffer::DirtyState::CpuDirty)
                     Logger::Error("Buffer (0x{}-0x{}) is marked as CPU dirty while CPU backing writes are blocked, this is not valid", srcBuffer->guest->begin().base(), srcBuffer->guest->end().base());
 
                 // We need the backing to be stable so that any writes within this context are sequenced correctly, we can't use the source mirror here either since buffer writes within this context will update the mirror on CPU and backing on GPU
-                copyBuffer(*newBuffer->guest, *srcBuffer->guest, newBuffer->backing.data(), srcBuffer->backing.data());
+                if (!srcBuffer->importedBacking)
+                    copyBuffer(*newBuffer->guest, *srcBuffer->guest, newBuffer->backing.data(), srcBuffer->backing.data());
             }
 
             // Transfer all views from the overlapping buffer to the new buffer with the new buffer and updated offset, ensuring pointer stability
@@ -127,12 +160,48 @@ namespace skyline::gpu {
         return newBuffer;
     }
 
+    void BufferManager::EvictBuffers(size_t targetBytes) {
+        TRACE_EVENT("gpu", "BufferManager::EvictBuffers");
+
+        std::vector<Buffer *> candidates;
+        for (const auto &buffer : bufferMappings)
+            if (buffer->IsResident() && !buffer->importedBacking)
+                candidates.push_back(buffer.get());
+
+        std::sort(candidates.begin(), candidates.end(), [](Buffer *lhs, Buffer *rhs) {
+            return lhs->lastAccessTimestamp < rhs->lastAccessTimestamp;
+        });
+
+        size_t evictedCount{}, evictedBytes{};
+        for (auto buffer : candidates) {
+            if (residentBytes <= targetBytes)
+                break;
+
+            // The mutex is locked directly as locking the buffer itself would reallocate its backing
+            if (!buffer->mutex.try_lock())
+                continue; // The buffer is being used by another thread, we can't evict it
+
+            size_t size{buffer->backing.size()};
+            if (buffer->EvictBacking()) {
+                evictedCount++;
+                evictedBytes += size;
+            }
+            buffer->mutex.unlock();
+        }
+
+        TRACE_COUNTER("gpu", "BufferResidentBytes", residentBytes.load(std::memory_order_relaxed));
+        Logger::Debug("Evicted {} buffer backings ({} MiB), {} MiB resident", evictedCount, evictedBytes / (1024 * 1024), residentBytes / (1024 * 1024));
+    }
+
     BufferView BufferManager::FindOrCreateImpl(GuestBuffer guestMapping, ContextTag tag, const std::function<void(std::shared_ptr<Buffer>, ContextLock<Buffer> &&)> &attachBuffer) {
         /*
          * We align the buffer to the page boundary to ensure that:
          * 1) Any buffer view has the same alignment guarantees as on the guest, this is required for UBOs, SSBOs and Texel buffers
          * 2) We can coalesce a lot of tiny buffers into a single large buffer covering an entire page, this is often the case for index buffers and vertex buffers
          */
+        if (IsOverBudget())
+            EvictBuffers(memoryBudget - (memoryBudget / 4)); // We evict down to below the budget to avoid immediately going over the budget again after the next buffer is created
+
         auto alignedStart{util::AlignDown(guestMapping.begin().base(), constant::PageSize)}, alignedEnd{util::AlignUp(guestMapping.end().base(), constant::PageSize)};
         span<u8> alignedGuestMapping{alignedStart, alignedEnd};
 
@@ -147,6 +216,7 @@ namespace skyline::gpu {
         if (overlaps.empty()) {
             // If we couldn't find any overlapping buffers, create a new buffer without coalescing
             LockedBuffer buffer{std::make_shared<Buffer>(delegateAllocatorState, gpu, alignedGuestMapping, nextBufferId++), tag};
+            PerfStats::Increment(PerfStats::Counter::BufferCreations);
             buffer->SetupGuestMappings();
             InsertBuffer(*buffer);
             return buffer->GetView(static_cast<vk::DeviceSize>(guestMapping.begin() - buffer->guest->begin()), guestMapping.size());
@@ -172,4 +242,31 @@ namespace skyline::gpu {
             return buffer->GetView(static_cast<vk::DeviceSize>(guestMapping.begin() - buffer->guest->begin()), guestMapping.size());
         }
     }
+
+    void BufferManager::Trim() {
+        EvictBuffers(0);
+    }
+
+    bool BufferManager::IsGpuDirty(span<u8> guestMapping) {
+        // Buffers are only ever marked as GPU dirty from the GPFIFO thread holding the channel lock, so their dirty state can be checked without locking them
+        auto entryIt{std::lower_bound(bufferMappings.begin(), bufferMappings.end(), guestMapping.end().base(), BufferLessThan)};
+        while (entryIt != bufferMappings.begin() && (*--entryIt)->guest->begin() <= guestMapping.end())
+            if ((*entryIt)->guest->end() > guestMapping.begin() && (*entryIt)->dirtyState == Buffer::DirtyState::GpuDirty)
+                return true;
+
+        return false;
+    }
+
+    void BufferManager::SynchronizeGuest() {
+        TRACE_EVENT("gpu", "BufferManager::SynchronizeGuest");
+
+        for (const auto &buffer : bufferMappings) {
+            if (!buffer->IsResident())
+                continue; // Evicted buffers have no GPU modifications as they're written back prior to the backing being freed
+
+            // The mutex is locked directly as locking the buffer itself would reallocate its backing
+            std::scoped_lock lock{buffer->mutex};
+            buffer->SynchronizeGuest();
+        }
+    }
 }
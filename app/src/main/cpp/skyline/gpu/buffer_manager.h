@@ -22,6 +22,43 @@ namespace skyline::gpu {
         static constexpr size_t L2EntryGranularity{19}; //!< The amount of AS (in bytes) a single L2 PTE covers (512 KiB == 1 << 19)
         SegmentTable<Buffer *, constant::AddressSpaceSize, constant::PageSizeBits, L2EntryGranularity> bufferTable; //!< A page table of all buffer mappings for O(1) lookups on full matches
 
+        size_t memoryBudget; //!< The amount of memory in bytes that the backings of guest buffers can use before the backings of idle buffers are freed
+        std::atomic<size_t> residentBytes{}; //!< The total size of the backings of all guest buffers in the map in bytes
+        std::atomic<u64> accessTimestamp{}; //!< A counter that is incremented every time a buffer is locked with a tag, it's used to order buffers by their last usage
+
+        static constexpr vk::DeviceSize MaxSparseBufferSize{0x10000000}; //!< The largest size of the sparse buffer (256 MiB), it's never backed by memory so this only consumes address space
+        std::optional<vk::raii::Buffer> sparseBuffer; //!< A sparse buffer with no bound pages which is used for guest sparse mappings, all reads from it return zero and all writes are discarded
+        vk::DeviceSize sparseBufferSize{}; //!< The size of `sparseBuffer` in bytes
+
+        friend Buffer;
+
+        /**
+         * @brief An entry in the lookup cache, this maps a guest mapping to the view returned for it
+         */
+        struct LookupCacheEntry {
+            u8 *base{};
+            size_t size{};
+            BufferView view;
+        };
+
+        static constexpr size_t LookupCacheSize{8}; //!< The amount of entries in the lookup cache, this is intentionally small as it's linearly searched on every lookup
+        std::array<LookupCacheEntry, LookupCacheSize> lookupCache{}; //!< A cache of the most recently looked up mappings ordered from the most to the least recently inserted, this avoids the page table walk and view construction for repeated lookups of the same mapping within a draw or across draws
+
+        /**
+         * @brief Inserts a view for the supplied mapping at the front of the lookup cache, evicting the least recently inserted entry
+         */
+        void InsertLookupCache(GuestBuffer guestMapping, const BufferView &view) {
+            std::move_backward(lookupCache.begin(), std::prev(lookupCache.end()), lookupCache.end());
+            lookupCache.front() = {guestMapping.data(), guestMapping.size(), view};
+        }
+
+        /**
+         * @brief Clears the lookup cache, this must be done whenever buffers are created or deleted as any cached views may no longer refer to the buffer which should be used for the mapping
+         */
+        void InvalidateLookupCache() {
+            lookupCache.fill({});
+        }
+
         /**
          * @brief A wrapper around a Buffer which locks it with the specified ContextTag
          */
@@ -63,6 +100,12 @@ namespace skyline::gpu {
          */
         LockedBuffer CoalesceBuffers(span<u8> range, const LockedBuffers &srcBuffers, ContextTag tag);
 
+        /**
+         * @brief Frees the backings of the least recently used buffers which aren't in use until the resident size is at or below the target
+         * @note Buffer objects are retained as views reference them through their delegates, evicted backings are reallocated and refilled from the guest on their next use
+         */
+        void EvictBuffers(size_t targetBytes);
+
         /**
          * @return If the end of the supplied buffer is less than the supplied pointer
          */
@@ -73,6 +116,48 @@ namespace skyline::gpu {
 
         BufferManager(GPU &gpu);
 
+        /**
+         * @return The total size of the backings of all guest buffers tracked by the buffer manager in bytes
+         */
+        size_t GetResidentBytes() const {
+            return residentBytes.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @return If the backings of guest buffers tracked by the buffer manager exceed the memory budget
+         */
+        bool IsOverBudget() const {
+            return GetResidentBytes() > memoryBudget;
+        }
+
+        /**
+         * @brief Frees the backings of all buffers which aren't in use, they're refilled from the guest on their next use
+         * @note The GPU channel lock **must** be locked prior to calling this as it serializes all other accesses to the buffer manager
+         */
+        void Trim();
+
+        /**
+         * @return If any buffer overlapping the supplied guest mapping has GPU modifications which weren't written back to it, this never creates a buffer
+         * @note The GPU channel lock **must** be locked prior to calling this as it serializes all other accesses to the buffer manager
+         */
+        bool IsGpuDirty(span<u8> guestMapping);
+
+        /**
+         * @brief Writes back GPU modifications of all buffers into their guest mappings, the backings are retained
+         * @note The GPU channel lock **must** be locked prior to calling this as it serializes all other accesses to the buffer manager
+         */
+        void SynchronizeGuest();
+
+        /**
+         * @return A binding to the unbound sparse buffer covering the supplied size (or less if it's larger than the sparse buffer), this is null if sparse residency isn't supported
+         * @note The binding can be used without any locking or lifetime tracking as the sparse buffer is immutable and lives as long as the buffer manager
+         */
+        BufferBinding GetSparseBinding(vk::DeviceSize size) const {
+            if (!sparseBuffer)
+                return {};
+            return {**sparseBuffer, 0, std::min(size, sparseBufferSize)};
+        }
+
         /**
          * @brief Acquires an exclusive lock on the texture for the calling thread
          * @note Naming is in accordance to the BasicLockable named requirement
@@ -99,12 +184,21 @@ namespace skyline::gpu {
         BufferView FindOrCreateImpl(GuestBuffer guestMapping, ContextTag tag, const std::function<void(std::shared_ptr<Buffer>, ContextLock<Buffer> &&)> &attachBuffer);
 
         BufferView FindOrCreate(GuestBuffer guestMapping, ContextTag tag = {}, const std::function<void(std::shared_ptr<Buffer>, ContextLock<Buffer> &&)> &attachBuffer = {}) {
+            for (const auto &entry : lookupCache)
+                if (entry.base == guestMapping.data() && entry.size == guestMapping.size())
+                    return entry.view;
+
             auto lookupBuffer{bufferTable[guestMapping.begin().base()]};
-            if (lookupBuffer != nullptr)
-                if (auto view{lookupBuffer->TryGetView(guestMapping)}; view)
+            if (lookupBuffer != nullptr) {
+                if (auto view{lookupBuffer->TryGetView(guestMapping)}; view) {
+                    InsertLookupCache(guestMapping, view);
                     return view;
+                }
+            }
 
-            return FindOrCreateImpl(guestMapping, tag, attachBuffer);
+            auto view{FindOrCreateImpl(guestMapping, tag, attachBuffer)};
+            InsertLookupCache(guestMapping, view); // The cache is invalidated during creation so this must be done after the lookup
+            return view;
         }
     };
 }
@@ -6,11 +6,15 @@
 #include "framebuffer_cache.h"
 
 namespace skyline::gpu::cache {
-    FramebufferCache::FramebufferCache(GPU &gpu) : gpu(gpu) {}
+    static std::atomic<u32> NextInstanceId{1}; //!< The ID of the next cache instance, 0 is reserved for empty front cache entries
+
+    thread_local std::array<FramebufferCache::FrontCacheEntry, FramebufferCache::FrontCacheSize> FramebufferCache::frontCache{};
+
+    FramebufferCache::FramebufferCache(GPU &gpu) : gpu(gpu), instanceId{NextInstanceId.fetch_add(1, std::memory_order_relaxed)} {}
 
     FramebufferCache::FramebufferImagelessAttachment::FramebufferImagelessAttachment(const vk::FramebufferAttachmentImageInfo &info) : flags(info.flags), usage(info.usage), width(info.width), height(info.height), layers(info.layerCount), format(*info.pViewFormats) {}
 
-    FramebufferCache::FramebufferCacheKey::FramebufferCacheKey(const FramebufferCreateInfo &createInfo) {
+    FramebufferCache::FramebufferCacheKey::FramebufferCacheKey(const FramebufferCreateInfo &createInfo, size_t hash) : hash{hash} {
         auto &info{createInfo.get<vk::FramebufferCreateInfo>()};
         flags = info.flags;
         renderPass = info.renderPass;
@@ -20,53 +24,14 @@ namespace skyline::gpu::cache {
 
         if (createInfo.isLinked<vk::FramebufferAttachmentsCreateInfo>()) {
             auto &attachmentInfo{createInfo.get<vk::FramebufferAttachmentsCreateInfo>()};
-            std::vector<FramebufferImagelessAttachment> imagelessAttachments;
-            imagelessAttachments.reserve(attachmentInfo.attachmentImageInfoCount);
-            for (const auto &image : span<const vk::FramebufferAttachmentImageInfo>(attachmentInfo.pAttachmentImageInfos, attachmentInfo.attachmentImageInfoCount))
-                imagelessAttachments.emplace_back(image);
-            attachments.emplace<std::vector<FramebufferImagelessAttachment>>(std::move(imagelessAttachments));
+            attachments.emplace<1>(attachmentInfo.pAttachmentImageInfos, attachmentInfo.pAttachmentImageInfos + attachmentInfo.attachmentImageInfoCount);
         } else {
-            std::vector<vk::ImageView> imageViews;
-            imageViews.reserve(info.attachmentCount);
-            for (const auto &image : span<const vk::ImageView>(info.pAttachments, info.attachmentCount))
-                imageViews.emplace_back(image);
-            attachments.emplace<std::vector<vk::ImageView>>(std::move(imageViews));
+            attachments.emplace<0>(info.pAttachments, info.pAttachments + info.attachmentCount);
         }
     }
 
     #define HASH(x) boost::hash_combine(hash, x)
 
-    size_t FramebufferCache::FramebufferHash::operator()(const FramebufferCacheKey &key) const {
-        size_t hash{};
-
-        HASH(static_cast<VkFramebufferCreateFlags>(key.flags));
-        HASH(static_cast<VkRenderPass>(key.renderPass));
-        HASH(key.width);
-        HASH(key.height);
-        HASH(key.layers);
-
-        std::visit(VariantVisitor{
-            [&hash](const std::vector<FramebufferImagelessAttachment> &attachments) {
-                HASH(attachments.size());
-                for (const auto &attachment : attachments) {
-                    HASH(static_cast<VkImageCreateFlags>(attachment.flags));
-                    HASH(static_cast<VkImageUsageFlags>(attachment.usage));
-                    HASH(attachment.width);
-                    HASH(attachment.height);
-                    HASH(attachment.layers);
-                    HASH(attachment.format);
-                }
-            },
-            [&hash](const std::vector<vk::ImageView> &attachments) {
-                HASH(attachments.size());
-                for (const auto &attachment : attachments)
-                    HASH(static_cast<VkImageView>(attachment));
-            }
-        }, key.attachments);
-
-        return hash;
-    }
-
     size_t FramebufferCache::FramebufferHash::operator()(const FramebufferCreateInfo &key) const {
         size_t hash{};
 
@@ -115,7 +80,7 @@ namespace skyline::gpu::cache {
         RETF(lhs.layers != rhsInfo.layers)
 
         if (lhs.flags & vk::FramebufferCreateFlagBits::eImageless) {
-            auto &lhsAttachments{std::get<std::vector<FramebufferImagelessAttachment>>(lhs.attachments)};
+            auto &lhsAttachments{std::get<1>(lhs.attachments)};
             auto &rhsAttachments{rhs.get<vk::FramebufferAttachmentsCreateInfo>()};
 
             RETF(lhsAttachments.size() != rhsAttachments.attachmentImageInfoCount)
@@ -130,7 +95,7 @@ namespace skyline::gpu::cache {
                 rhsAttachmentInfo++;
             }
         } else {
-            auto &lhsAttachments{std::get<std::vector<vk::ImageView>>(lhs.attachments)};
+            auto &lhsAttachments{std::get<0>(lhs.attachments)};
             span<const vk::ImageView> rhsAttachments{rhsInfo.pAttachments, rhsInfo.attachmentCount};
             RETF(!std::equal(lhsAttachments.begin(), lhsAttachments.end(), rhsAttachments.begin(), rhsAttachments.end()))
         }
@@ -141,12 +106,17 @@ namespace skyline::gpu::cache {
     }
 
     vk::Framebuffer FramebufferCache::GetFramebuffer(const FramebufferCreateInfo &createInfo) {
+        HashedCreateInfo key{createInfo, FramebufferHash{}(createInfo)};
+        auto &frontEntry{frontCache[key.hash % FrontCacheSize]};
+        if (frontEntry.instanceId == instanceId && FramebufferEqual{}(*frontEntry.key, key))
+            return frontEntry.framebuffer;
+
         std::scoped_lock lock{mutex};
-        auto it{framebufferCache.find(createInfo)};
-        if (it != framebufferCache.end())
-            return *it->second;
+        auto it{framebufferCache.find(key)};
+        if (it == framebufferCache.end())
+            it = framebufferCache.try_emplace(FramebufferCacheKey{createInfo, key.hash}, gpu.vkDevice, createInfo.get<vk::FramebufferCreateInfo>()).first;
 
-        auto entryIt{framebufferCache.try_emplace(FramebufferCacheKey{createInfo}, gpu.vkDevice, createInfo.get<vk::FramebufferCreateInfo>())};
-        return *entryIt.first->second;
+        frontEntry = {instanceId, key.hash, &it->first, *it->second};
+        return frontEntry.framebuffer;
     }
 }
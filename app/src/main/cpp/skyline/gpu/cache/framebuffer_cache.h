@@ -17,6 +17,9 @@ namespace skyline::gpu::cache {
       private:
         GPU &gpu;
         std::mutex mutex; //!< Synchronizes access to the cache
+        u32 instanceId; //!< A unique ID for this instance of the cache, this is used to invalidate the front cache entries of any prior instance
+
+        static constexpr size_t InlineAttachmentCount{9}; //!< The amount of attachments stored inline by the keys, this covers 8 color attachments and a depth/stencil attachment
 
       private:
         /**
@@ -42,17 +45,32 @@ namespace skyline::gpu::cache {
             u32 width;
             u32 height;
             u32 layers;
-            std::variant<std::vector<vk::ImageView>, std::vector<FramebufferImagelessAttachment>> attachments;
+            std::variant<boost::container::small_vector<vk::ImageView, InlineAttachmentCount>, boost::container::small_vector<FramebufferImagelessAttachment, InlineAttachmentCount>> attachments;
+            size_t hash; //!< The hash of the create info the key was created from, this is precomputed to avoid rehashing the key during lookups
 
-            FramebufferCacheKey(const FramebufferCreateInfo &createInfo);
+            FramebufferCacheKey(const FramebufferCreateInfo &createInfo, size_t hash);
 
             bool operator==(const FramebufferCacheKey &other) const = default;
         };
 
+        /**
+         * @brief A create info alongside its precomputed hash, this is used for lookups so the create info is only hashed once
+         */
+        struct HashedCreateInfo {
+            const FramebufferCreateInfo &createInfo;
+            size_t hash;
+        };
+
         struct FramebufferHash {
             using is_transparent = std::true_type;
 
-            size_t operator()(const FramebufferCacheKey &key) const;
+            size_t operator()(const FramebufferCacheKey &key) const {
+                return key.hash;
+            }
+
+            size_t operator()(const HashedCreateInfo &key) const {
+                return key.hash;
+            }
 
             size_t operator()(const FramebufferCreateInfo &key) const;
         };
@@ -63,16 +81,34 @@ namespace skyline::gpu::cache {
             bool operator()(const FramebufferCacheKey &lhs, const FramebufferCacheKey &rhs) const;
 
             bool operator()(const FramebufferCacheKey &lhs, const FramebufferCreateInfo &rhs) const;
+
+            bool operator()(const FramebufferCacheKey &lhs, const HashedCreateInfo &rhs) const {
+                return lhs.hash == rhs.hash && (*this)(lhs, rhs.createInfo);
+            }
         };
 
         std::unordered_map<FramebufferCacheKey, vk::raii::Framebuffer, FramebufferHash, FramebufferEqual> framebufferCache;
 
+        /**
+         * @brief An entry in the per-thread front cache, this refers to the key of an entry in the main cache which is stable as entries are never erased
+         */
+        struct FrontCacheEntry {
+            u32 instanceId; //!< The ID of the cache instance the entry was inserted by, 0 denotes an empty entry
+            size_t hash;
+            const FramebufferCacheKey *key;
+            vk::Framebuffer framebuffer;
+        };
+
+        static constexpr size_t FrontCacheSize{16}; //!< The amount of entries in the direct-mapped front cache of each thread
+        static thread_local std::array<FrontCacheEntry, FrontCacheSize> frontCache; //!< A per-thread cache of recently used framebuffers which can be looked up without locking the mutex
+
       public:
         FramebufferCache(GPU &gpu);
 
         /**
          * @note When using imageless framebuffer attachments, VkFramebufferAttachmentImageInfo **must** have a single view format
          * @note When using image framebuffer attachments, it is expected that the supplied image handle will remain stable for the cache to function
+         * @note Lookups that hit the calling thread's front cache don't lock the mutex, a lookup never allocates unless a new framebuffer is created
          */
         vk::Framebuffer GetFramebuffer(const FramebufferCreateInfo &createInfo);
     };
@@ -1,12 +1,115 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <boost/container/static_vector.hpp>
 #include <boost/functional/hash.hpp>
+#include <vfs/os_filesystem.h>
+#include <vfs/os_backing.h>
+#include <common/settings.h>
 #include <gpu.h>
 #include "graphics_pipeline_cache.h"
 
 namespace skyline::gpu::cache {
-    GraphicsPipelineCache::GraphicsPipelineCache(GPU &gpu) : gpu(gpu), vkPipelineCache(gpu.vkDevice, vk::PipelineCacheCreateInfo{}) {}
+    GraphicsPipelineCache::GraphicsPipelineCache(const DeviceState &state, GPU &gpu) : state(state), gpu(gpu), vkPipelineCache(gpu.vkDevice, vk::PipelineCacheCreateInfo{}) {}
+
+    GraphicsPipelineCache::~GraphicsPipelineCache() {
+        SaveVkPipelineCache();
+    }
+
+    void GraphicsPipelineCache::LoadVkPipelineCache() {
+        if (!state.process)
+            return; // Helper shaders may be compiled prior to the title being loaded, the cache is loaded on the first compilation after that
+
+        vkPipelineCacheLoaded = true;
+
+        auto properties{gpu.vkPhysicalDevice.getProperties()};
+        std::string uuid;
+        for (auto byte : properties.pipelineCacheUUID)
+            uuid += fmt::format("{:02X}", byte);
+
+        // The cache is specific to the driver as different drivers (or driver versions) can't make use of each other's caches
+        std::string directory{gpu.GetTitleCacheDirectory() + "vk_pipeline_cache/"};
+        const auto &gpuDriver{*state.settings->gpuDriver};
+        vkPipelineCachePath = fmt::format("{}{}-{}.bin", directory, gpuDriver.empty() ? "system" : gpuDriver, uuid);
+
+        try {
+            vfs::OsFileSystem{directory}; // Ensures the directory exists for when the cache is saved
+
+            int fd{open(vkPipelineCachePath.c_str(), O_RDONLY)};
+            if (fd < 0)
+                return;
+
+            vfs::OsBacking backing{fd, true};
+            std::vector<u8> data(backing.size);
+            backing.Read(span(data));
+
+            VkPipelineCacheHeaderVersionOne header{};
+            if (data.size() >= sizeof(header))
+                std::memcpy(&header, data.data(), sizeof(header));
+
+            if (data.size() < sizeof(header) ||
+                header.headerSize < sizeof(header) ||
+                header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+                header.vendorID != properties.vendorID ||
+                header.deviceID != properties.deviceID ||
+                !std::equal(std::begin(header.pipelineCacheUUID), std::end(header.pipelineCacheUUID), properties.pipelineCacheUUID.begin())) {
+                Logger::Info("Discarding incompatible Vulkan pipeline cache");
+                return;
+            }
+
+            vkPipelineCache = vk::raii::PipelineCache{gpu.vkDevice, vk::PipelineCacheCreateInfo{
+                .initialDataSize = data.size(),
+                .pInitialData = data.data(),
+            }};
+            Logger::Info("Loaded Vulkan pipeline cache: {} KiB", data.size() / 1024);
+        } catch (const std::exception &e) {
+            // The empty pipeline cache we started out with remains in use in this case
+            Logger::Warn("Failed to load Vulkan pipeline cache: {}", e.what());
+        }
+    }
+
+    void GraphicsPipelineCache::SaveVkPipelineCache() {
+        std::scoped_lock lock{saveMutex};
+        if (vkPipelineCachePath.empty())
+            return;
+
+        try {
+            auto data{vkPipelineCache.getData()};
+
+            // Write to a temporary file which is then renamed to avoid leaving a partially written cache behind
+            std::string temporaryPath{vkPipelineCachePath + ".tmp"};
+            int fd{open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR)};
+            if (fd < 0)
+                throw exception("Failed to open file: {}", strerror(errno));
+
+            size_t written{};
+            while (written < data.size()) {
+                auto ret{write(fd, data.data() + written, data.size() - written)};
+                if (ret < 0) {
+                    close(fd);
+                    throw exception("Failed to write file: {}", strerror(errno));
+                }
+                written += static_cast<size_t>(ret);
+            }
+            close(fd);
+
+            if (rename(temporaryPath.c_str(), vkPipelineCachePath.c_str()))
+                throw exception("Failed to rename file: {}", strerror(errno));
+        } catch (const std::exception &e) {
+            Logger::Warn("Failed to save Vulkan pipeline cache: {}", e.what());
+        }
+    }
+
+    GraphicsPipelineCache::AttachmentState::AttachmentState(TextureView *view) {
+        if (view) {
+            format = view->format->vkFormat;
+            sampleCount = view->texture->sampleCount;
+            layout = view->texture->layout;
+        }
+    }
 
     #define VEC_CPY(pointer, size) state.pointer, state.pointer + state.size
 
@@ -36,15 +139,11 @@ namespace skyline::gpu::cache {
 
         colorBlendState.pAttachments = colorBlendAttachments.data();
 
-        for (auto &colorAttachment : state.colorAttachments) {
-            if (colorAttachment)
-                colorAttachments.emplace_back(AttachmentMetadata{colorAttachment->format->vkFormat, colorAttachment->texture->sampleCount});
-            else
-                colorAttachments.emplace_back(AttachmentMetadata{vk::Format::eUndefined, vk::SampleCountFlagBits::e1});
-        }
+        for (auto &colorAttachment : state.colorAttachments)
+            colorAttachments.emplace_back(AttachmentMetadata{colorAttachment.format, colorAttachment.sampleCount});
 
         if (state.depthStencilAttachment)
-            depthStencilAttachment.emplace(AttachmentMetadata{state.depthStencilAttachment->format->vkFormat, state.depthStencilAttachment->texture->sampleCount});
+            depthStencilAttachment.emplace(AttachmentMetadata{state.depthStencilAttachment->format, state.depthStencilAttachment->sampleCount});
     }
 
     #undef VEC_CPY
@@ -176,16 +275,14 @@ namespace skyline::gpu::cache {
 
         HASH(key.colorAttachments.size());
         for (const auto &attachment : key.colorAttachments) {
-            if (attachment) {
-                HASH(attachment->format->vkFormat);
-                HASH(attachment->texture->sampleCount);
-            }
+            HASH(attachment.format);
+            HASH(attachment.sampleCount);
         }
 
         HASH(key.depthStencilAttachment != nullptr);
         if (key.depthStencilAttachment != nullptr) {
-            HASH(key.depthStencilAttachment->format->vkFormat);
-            HASH(key.depthStencilAttachment->texture->sampleCount);
+            HASH(key.depthStencilAttachment->format);
+            HASH(key.depthStencilAttachment->sampleCount);
         }
 
         return hash;
@@ -297,13 +394,13 @@ namespace skyline::gpu::cache {
         )
 
         RETF(CARREQ(colorAttachments.begin(), colorAttachments.size(), {
-            return lhs.format == rhs->format->vkFormat && lhs.sampleCount == rhs->texture->sampleCount;
+            return lhs.format == rhs.format && lhs.sampleCount == rhs.sampleCount;
         }))
 
         RETF(lhs.depthStencilAttachment.has_value() != (rhs.depthStencilAttachment != nullptr) ||
             (lhs.depthStencilAttachment.has_value() &&
-                lhs.depthStencilAttachment->format != rhs.depthStencilAttachment->format->vkFormat &&
-                lhs.depthStencilAttachment->sampleCount != rhs.depthStencilAttachment->texture->sampleCount
+                lhs.depthStencilAttachment->format != rhs.depthStencilAttachment->format &&
+                lhs.depthStencilAttachment->sampleCount != rhs.depthStencilAttachment->sampleCount
             )
         )
 
@@ -322,48 +419,27 @@ namespace skyline::gpu::cache {
 
     GraphicsPipelineCache::PipelineCacheEntry::PipelineCacheEntry(vk::raii::DescriptorSetLayout &&descriptorSetLayout, vk::raii::PipelineLayout &&pipelineLayout, vk::raii::Pipeline &&pipeline) : descriptorSetLayout(std::move(descriptorSetLayout)), pipelineLayout(std::move(pipelineLayout)), pipeline(std::move(pipeline)) {}
 
-    GraphicsPipelineCache::CompiledPipeline::CompiledPipeline(const PipelineCacheEntry &entry) : descriptorSetLayout(*entry.descriptorSetLayout), pipelineLayout(*entry.pipelineLayout), pipeline(*entry.pipeline) {}
-
-    GraphicsPipelineCache::CompiledPipeline GraphicsPipelineCache::GetCompiledPipeline(const PipelineState &state, span<const vk::DescriptorSetLayoutBinding> layoutBindings, span<const vk::PushConstantRange> pushConstantRanges, bool noPushDescriptors) {
-        std::unique_lock lock(mutex);
-
-        auto it{pipelineCache.find(state)};
-        if (it != pipelineCache.end())
-            return CompiledPipeline{it->second};
-
-        lock.unlock();
-
-        vk::raii::DescriptorSetLayout descriptorSetLayout{gpu.vkDevice, vk::DescriptorSetLayoutCreateInfo{
-            .flags = vk::DescriptorSetLayoutCreateFlags{(!noPushDescriptors && gpu.traits.supportsPushDescriptors) ? vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR : vk::DescriptorSetLayoutCreateFlags{}},
-            .pBindings = layoutBindings.data(),
-            .bindingCount = static_cast<u32>(layoutBindings.size()),
-        }};
-
-        vk::raii::PipelineLayout pipelineLayout{gpu.vkDevice, vk::PipelineLayoutCreateInfo{
-            .pSetLayouts = &*descriptorSetLayout,
-            .setLayoutCount = 1,
-            .pPushConstantRanges = pushConstantRanges.data(),
-            .pushConstantRangeCount = static_cast<u32>(pushConstantRanges.size()),
-        }};
+    GraphicsPipelineCache::CompiledPipeline::CompiledPipeline(const PipelineCacheEntry &entry) : descriptorSetLayout(*entry.descriptorSetLayout), pipelineLayout(*entry.pipelineLayout), pipeline(*entry.pipeline), optimizedPipeline(&entry.optimizedPipelineHandle) {}
 
+    vk::raii::RenderPass GraphicsPipelineCache::CreateCompatibleRenderPass(const PipelineState &state) {
         boost::container::small_vector<vk::AttachmentDescription, 8> attachmentDescriptions;
         boost::container::small_vector<vk::AttachmentReference, 8> attachmentReferences;
 
-        auto pushAttachment{[&](TextureView *view) {
-            if (view) {
+        auto pushAttachment{[&](const AttachmentState *attachment) {
+            if (attachment && *attachment) {
                 attachmentDescriptions.push_back(vk::AttachmentDescription{
-                    .format = view->format->vkFormat,
-                    .samples = view->texture->sampleCount,
+                    .format = attachment->format,
+                    .samples = attachment->sampleCount,
                     .loadOp = vk::AttachmentLoadOp::eLoad,
                     .storeOp = vk::AttachmentStoreOp::eStore,
                     .stencilLoadOp = vk::AttachmentLoadOp::eLoad,
                     .stencilStoreOp = vk::AttachmentStoreOp::eStore,
-                    .initialLayout = view->texture->layout,
-                    .finalLayout = view->texture->layout,
+                    .initialLayout = attachment->layout,
+                    .finalLayout = attachment->layout,
                 });
                 attachmentReferences.push_back(vk::AttachmentReference{
                     .attachment = static_cast<u32>(attachmentDescriptions.size() - 1),
-                    .layout = view->texture->layout,
+                    .layout = attachment->layout,
                 });
             } else {
                 attachmentReferences.push_back(vk::AttachmentReference{
@@ -378,7 +454,7 @@ namespace skyline::gpu::cache {
         };
 
         for (auto &colorAttachment : state.colorAttachments)
-            pushAttachment(colorAttachment);
+            pushAttachment(&colorAttachment);
 
         if (state.depthStencilAttachment) {
             pushAttachment(state.depthStencilAttachment);
@@ -391,14 +467,329 @@ namespace skyline::gpu::cache {
             subpassDescription.colorAttachmentCount = static_cast<u32>(attachmentReferences.size());
         }
 
-        vk::raii::RenderPass renderPass{gpu.vkDevice, vk::RenderPassCreateInfo{
+        return vk::raii::RenderPass{gpu.vkDevice, vk::RenderPassCreateInfo{
             .attachmentCount = static_cast<u32>(attachmentDescriptions.size()),
             .pAttachments = attachmentDescriptions.data(),
             .subpassCount = 1,
             .pSubpasses = &subpassDescription,
         }};
+    }
+
+    GraphicsPipelineCache::RenderingFormats::RenderingFormats(const PipelineState &state) {
+        for (const auto &attachment : state.colorAttachments)
+            colorFormats.push_back(attachment.format);
+
+        createInfo = vk::PipelineRenderingCreateInfo{
+            .colorAttachmentCount = static_cast<u32>(colorFormats.size()),
+            .pColorAttachmentFormats = colorFormats.data(),
+        };
+
+        if (state.depthStencilAttachment && *state.depthStencilAttachment) {
+            auto format{state.depthStencilAttachment->format};
+            switch (format) {
+                case vk::Format::eD16Unorm:
+                case vk::Format::eX8D24UnormPack32:
+                case vk::Format::eD32Sfloat:
+                    createInfo.depthAttachmentFormat = format;
+                    break;
+
+                case vk::Format::eS8Uint:
+                    createInfo.stencilAttachmentFormat = format;
+                    break;
+
+                default: // Combined depth/stencil formats
+                    createInfo.depthAttachmentFormat = format;
+                    createInfo.stencilAttachmentFormat = format;
+                    break;
+            }
+        }
+    }
+
+    template<typename T>
+    static void AppendLibraryKey(std::vector<u8> &key, const T &value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        auto bytes{reinterpret_cast<const u8 *>(&value)};
+        key.insert(key.end(), bytes, bytes + sizeof(T));
+    }
+
+    /**
+     * @note The array elements must not contain any padding or pointers other than ones that are always null
+     */
+    template<typename T>
+    static void AppendLibraryKey(std::vector<u8> &key, const T *values, u32 count) {
+        AppendLibraryKey(key, count);
+        auto bytes{reinterpret_cast<const u8 *>(values)};
+        key.insert(key.end(), bytes, bytes + sizeof(T) * count);
+    }
+
+    vk::Pipeline GraphicsPipelineCache::GetPipelineLibrary(PipelineLibraryKey &&key, vk::GraphicsPipelineLibraryFlagBitsEXT part, const vk::GraphicsPipelineCreateInfo &createInfo) {
+        {
+            std::scoped_lock lock{mutex};
+            auto it{pipelineLibraries.find(key)};
+            if (it != pipelineLibraries.end())
+                return *it->second;
+        }
+
+        vk::StructureChain<vk::GraphicsPipelineCreateInfo, vk::GraphicsPipelineLibraryCreateInfoEXT> libraryCreateInfo{createInfo, vk::GraphicsPipelineLibraryCreateInfoEXT{
+            .flags = part,
+        }};
+        libraryCreateInfo.get<vk::GraphicsPipelineLibraryCreateInfoEXT>().pNext = const_cast<void *>(createInfo.pNext);
+
+        // Link-time optimization info is retained so that an optimized pipeline can be linked from the libraries in the background
+        libraryCreateInfo.get<vk::GraphicsPipelineCreateInfo>().flags |= vk::PipelineCreateFlagBits::eLibraryKHR | vk::PipelineCreateFlagBits::eRetainLinkTimeOptimizationInfoEXT;
+        auto library{gpu.vkDevice.createGraphicsPipeline(vkPipelineCache, libraryCreateInfo.get<vk::GraphicsPipelineCreateInfo>())};
+
+        std::scoped_lock lock{mutex};
+        return *pipelineLibraries.try_emplace(std::move(key), std::move(library)).first->second;
+    }
+
+    std::array<vk::Pipeline, 4> GraphicsPipelineCache::GetPipelineLibraries(const PipelineState &state, span<const vk::DescriptorSetLayoutBinding> layoutBindings, span<const vk::PushConstantRange> pushConstantRanges, bool noPushDescriptors, vk::PipelineLayout pipelineLayout, vk::RenderPass renderPass, const vk::PipelineRenderingCreateInfo *renderingInfo) {
+        using LibraryPart = vk::GraphicsPipelineLibraryFlagBitsEXT;
+
+        // Every key starts with the library part and the dynamic state as it may affect any part
+        auto makeKey{[&](LibraryPart part) {
+            PipelineLibraryKey key;
+            AppendLibraryKey(key, part);
+            AppendLibraryKey(key, state.dynamicState.pDynamicStates, state.dynamicState.dynamicStateCount);
+            return key;
+        }};
+
+        // All shader libraries must be linked with an identically defined pipeline layout
+        auto appendLayout{[&](PipelineLibraryKey &key) {
+            AppendLibraryKey(key, layoutBindings.data(), static_cast<u32>(layoutBindings.size()));
+            AppendLibraryKey(key, pushConstantRanges.data(), static_cast<u32>(pushConstantRanges.size()));
+            AppendLibraryKey(key, noPushDescriptors);
+        }};
+
+        // Any library with render pass state must be linked with a compatible render pass
+        auto appendAttachments{[&](PipelineLibraryKey &key) {
+            AppendLibraryKey(key, static_cast<u32>(state.colorAttachments.size()));
+            for (const auto &attachment : state.colorAttachments) {
+                AppendLibraryKey(key, attachment.format);
+                AppendLibraryKey(key, attachment.sampleCount);
+            }
+
+            AppendLibraryKey(key, state.depthStencilAttachment ? state.depthStencilAttachment->format : vk::Format::eUndefined);
+            AppendLibraryKey(key, state.depthStencilAttachment ? state.depthStencilAttachment->sampleCount : vk::SampleCountFlagBits::e1);
+        }};
+
+        auto appendMultisampleState{[&](PipelineLibraryKey &key) {
+            const auto &multisampleState{state.multisampleState};
+            AppendLibraryKey(key, multisampleState.rasterizationSamples);
+            AppendLibraryKey(key, multisampleState.sampleShadingEnable);
+            AppendLibraryKey(key, multisampleState.minSampleShading);
+            AppendLibraryKey(key, multisampleState.alphaToCoverageEnable);
+            AppendLibraryKey(key, multisampleState.alphaToOneEnable);
+        }};
+
+        boost::container::static_vector<vk::PipelineShaderStageCreateInfo, 5> preRasterStages;
+        std::optional<vk::PipelineShaderStageCreateInfo> fragmentStage;
+        for (const auto &stage : state.shaderStages) {
+            if (stage.stage == vk::ShaderStageFlagBits::eFragment)
+                fragmentStage = stage;
+            else
+                preRasterStages.push_back(stage);
+        }
+
+        auto appendStage{[&](PipelineLibraryKey &key, const vk::PipelineShaderStageCreateInfo &stage) {
+            AppendLibraryKey(key, static_cast<VkShaderStageFlagBits>(stage.stage));
+            AppendLibraryKey(key, static_cast<VkShaderModule>(stage.module));
+        }};
+
+        std::array<vk::Pipeline, 4> libraries{};
+
+        {
+            auto key{makeKey(LibraryPart::eVertexInputInterface)};
+            const auto &vertexInputState{state.VertexInputState()};
+            AppendLibraryKey(key, vertexInputState.pVertexBindingDescriptions, vertexInputState.vertexBindingDescriptionCount);
+            AppendLibraryKey(key, vertexInputState.pVertexAttributeDescriptions, vertexInputState.vertexAttributeDescriptionCount);
+            if (state.vertexState.isLinked<vk::PipelineVertexInputDivisorStateCreateInfoEXT>())
+                AppendLibraryKey(key, state.VertexDivisorState().pVertexBindingDivisors, state.VertexDivisorState().vertexBindingDivisorCount);
+            AppendLibraryKey(key, state.inputAssemblyState.topology);
+            AppendLibraryKey(key, state.inputAssemblyState.primitiveRestartEnable);
+
+            libraries[0] = GetPipelineLibrary(std::move(key), LibraryPart::eVertexInputInterface, vk::GraphicsPipelineCreateInfo{
+                .pVertexInputState = &vertexInputState,
+                .pInputAssemblyState = &state.inputAssemblyState,
+                .pDynamicState = &state.dynamicState,
+            });
+        }
+
+        {
+            auto key{makeKey(LibraryPart::ePreRasterizationShaders)};
+            for (const auto &stage : preRasterStages)
+                appendStage(key, stage);
+            appendLayout(key);
+            appendAttachments(key);
+
+            const auto &viewportState{state.viewportState};
+            AppendLibraryKey(key, viewportState.pViewports, viewportState.pViewports ? viewportState.viewportCount : 0);
+            AppendLibraryKey(key, viewportState.pScissors, viewportState.pScissors ? viewportState.scissorCount : 0);
+            AppendLibraryKey(key, viewportState.viewportCount);
+            AppendLibraryKey(key, viewportState.scissorCount);
+
+            const auto &rasterizationState{state.RasterizationState()};
+            AppendLibraryKey(key, rasterizationState.depthClampEnable);
+            AppendLibraryKey(key, rasterizationState.polygonMode);
+            AppendLibraryKey(key, static_cast<VkCullModeFlags>(rasterizationState.cullMode));
+            AppendLibraryKey(key, rasterizationState.frontFace);
+            AppendLibraryKey(key, rasterizationState.depthBiasEnable);
+            AppendLibraryKey(key, rasterizationState.depthBiasConstantFactor);
+            AppendLibraryKey(key, rasterizationState.depthBiasClamp);
+            AppendLibraryKey(key, rasterizationState.depthBiasSlopeFactor);
+            AppendLibraryKey(key, rasterizationState.lineWidth);
+            if (state.rasterizationState.isLinked<vk::PipelineRasterizationProvokingVertexStateCreateInfoEXT>())
+                AppendLibraryKey(key, state.ProvokingVertexState().provokingVertexMode);
+            AppendLibraryKey(key, state.tessellationState.patchControlPoints);
+
+            libraries[1] = GetPipelineLibrary(std::move(key), LibraryPart::ePreRasterizationShaders, vk::GraphicsPipelineCreateInfo{
+                .pNext = renderingInfo,
+                .pStages = preRasterStages.data(),
+                .stageCount = static_cast<u32>(preRasterStages.size()),
+                .pTessellationState = &state.tessellationState,
+                .pViewportState = &viewportState,
+                .pRasterizationState = &rasterizationState,
+                .pDynamicState = &state.dynamicState,
+                .layout = pipelineLayout,
+                .renderPass = renderPass,
+                .subpass = 0,
+            });
+        }
+
+        {
+            auto key{makeKey(LibraryPart::eFragmentShader)};
+            if (fragmentStage)
+                appendStage(key, *fragmentStage);
+            appendLayout(key);
+            appendAttachments(key);
+            appendMultisampleState(key);
+
+            const auto &depthStencilState{state.depthStencilState};
+            AppendLibraryKey(key, depthStencilState.depthTestEnable);
+            AppendLibraryKey(key, depthStencilState.depthWriteEnable);
+            AppendLibraryKey(key, depthStencilState.depthCompareOp);
+            AppendLibraryKey(key, depthStencilState.depthBoundsTestEnable);
+            AppendLibraryKey(key, depthStencilState.stencilTestEnable);
+            AppendLibraryKey(key, depthStencilState.front);
+            AppendLibraryKey(key, depthStencilState.back);
+            AppendLibraryKey(key, depthStencilState.minDepthBounds);
+            AppendLibraryKey(key, depthStencilState.maxDepthBounds);
+
+            libraries[2] = GetPipelineLibrary(std::move(key), LibraryPart::eFragmentShader, vk::GraphicsPipelineCreateInfo{
+                .pNext = renderingInfo,
+                .pStages = fragmentStage ? &*fragmentStage : nullptr,
+                .stageCount = fragmentStage ? 1U : 0U,
+                .pMultisampleState = &state.multisampleState,
+                .pDepthStencilState = &depthStencilState,
+                .pDynamicState = &state.dynamicState,
+                .layout = pipelineLayout,
+                .renderPass = renderPass,
+                .subpass = 0,
+            });
+        }
+
+        {
+            auto key{makeKey(LibraryPart::eFragmentOutputInterface)};
+            appendAttachments(key);
+            appendMultisampleState(key);
+
+            const auto &colorBlendState{state.colorBlendState};
+            AppendLibraryKey(key, colorBlendState.logicOpEnable);
+            AppendLibraryKey(key, colorBlendState.logicOp);
+            AppendLibraryKey(key, colorBlendState.pAttachments, colorBlendState.attachmentCount);
+            AppendLibraryKey(key, colorBlendState.blendConstants);
+
+            libraries[3] = GetPipelineLibrary(std::move(key), LibraryPart::eFragmentOutputInterface, vk::GraphicsPipelineCreateInfo{
+                .pNext = renderingInfo,
+                .pMultisampleState = &state.multisampleState,
+                .pColorBlendState = &colorBlendState,
+                .pDynamicState = &state.dynamicState,
+                .renderPass = renderPass,
+                .subpass = 0,
+            });
+        }
+
+        return libraries;
+    }
+
+    vk::raii::Pipeline GraphicsPipelineCache::LinkPipelineLibraries(span<const vk::Pipeline> libraries, vk::PipelineLayout pipelineLayout, vk::PipelineCreateFlags flags) {
+        vk::StructureChain<vk::GraphicsPipelineCreateInfo, vk::PipelineLibraryCreateInfoKHR> linkCreateInfo{
+            vk::GraphicsPipelineCreateInfo{
+                .flags = flags,
+                .layout = pipelineLayout,
+            },
+            vk::PipelineLibraryCreateInfoKHR{
+                .libraryCount = static_cast<u32>(libraries.size()),
+                .pLibraries = libraries.data(),
+            },
+        };
+
+        return gpu.vkDevice.createGraphicsPipeline(vkPipelineCache, linkCreateInfo.get<vk::GraphicsPipelineCreateInfo>());
+    }
+
+    GraphicsPipelineCache::CompiledPipeline GraphicsPipelineCache::GetCompiledPipeline(const PipelineState &state, span<const vk::DescriptorSetLayoutBinding> layoutBindings, span<const vk::PushConstantRange> pushConstantRanges, bool noPushDescriptors) {
+        std::unique_lock lock(mutex);
+
+        if (!vkPipelineCacheLoaded)
+            LoadVkPipelineCache();
+
+        auto it{pipelineCache.find(state)};
+        if (it != pipelineCache.end())
+            return CompiledPipeline{it->second};
+
+        lock.unlock();
+
+        vk::raii::DescriptorSetLayout descriptorSetLayout{gpu.vkDevice, vk::DescriptorSetLayoutCreateInfo{
+            .flags = vk::DescriptorSetLayoutCreateFlags{(!noPushDescriptors && gpu.traits.supportsPushDescriptors) ? vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR : vk::DescriptorSetLayoutCreateFlags{}},
+            .pBindings = layoutBindings.data(),
+            .bindingCount = static_cast<u32>(layoutBindings.size()),
+        }};
+
+        vk::raii::PipelineLayout pipelineLayout{gpu.vkDevice, vk::PipelineLayoutCreateInfo{
+            .pSetLayouts = &*descriptorSetLayout,
+            .setLayoutCount = 1,
+            .pPushConstantRanges = pushConstantRanges.data(),
+            .pushConstantRangeCount = static_cast<u32>(pushConstantRanges.size()),
+        }};
+
+        // Pipelines are compiled against the attachment formats directly with dynamic rendering, a compatible render pass is required otherwise
+        std::optional<RenderingFormats> renderingFormats;
+        vk::raii::RenderPass renderPass{nullptr};
+        if (gpu.traits.supportsDynamicRendering)
+            renderingFormats.emplace(state);
+        else
+            renderPass = CreateCompatibleRenderPass(state);
+        const vk::PipelineRenderingCreateInfo *renderingInfo{renderingFormats ? &renderingFormats->createInfo : nullptr};
+
+        // Pipelines that use rasterizer discard don't have any fragment state to link, these are rare enough to always be compiled monolithically
+        if (gpu.traits.supportsGraphicsPipelineLibrary && !state.RasterizationState().rasterizerDiscardEnable) {
+            auto libraries{GetPipelineLibraries(state, layoutBindings, pushConstantRanges, noPushDescriptors, *pipelineLayout, *renderPass, renderingInfo)};
+            auto pipeline{LinkPipelineLibraries(libraries, *pipelineLayout, {})};
+
+            lock.lock();
+
+            auto [pipelineEntryIt, inserted]{pipelineCache.try_emplace(PipelineCacheKey{state}, std::move(descriptorSetLayout), std::move(pipelineLayout), std::move(pipeline))};
+            auto &entry{pipelineEntryIt->second};
+            CompiledPipeline compiledPipeline{entry};
+
+            lock.unlock();
+
+            if (inserted)
+                // The fast-linked pipeline can be used immediately while the optimized pipeline is compiled in the background and swapped in on the next bind after it's ready
+                gpu.pipelineCompilerPool.Submit([this, &entry, libraries]() {
+                    try {
+                        entry.optimizedPipeline = LinkPipelineLibraries(libraries, *entry.pipelineLayout, vk::PipelineCreateFlagBits::eLinkTimeOptimizationEXT);
+                        entry.optimizedPipelineHandle.store(*entry.optimizedPipeline, std::memory_order_release);
+                    } catch (const std::exception &e) {
+                        Logger::Warn("Failed to compile optimized pipeline: {}", e.what());
+                    }
+                });
+
+            return compiledPipeline;
+        }
 
         auto pipeline{gpu.vkDevice.createGraphicsPipeline(vkPipelineCache, vk::GraphicsPipelineCreateInfo{
+            .pNext = renderingInfo,
             .pStages = state.shaderStages.data(),
             .stageCount = static_cast<u32>(state.shaderStages.size()),
             .pVertexInputState = &state.vertexState.get<vk::PipelineVertexInputStateCreateInfo>(),
@@ -417,6 +808,27 @@ namespace skyline::gpu::cache {
         lock.lock();
 
         auto pipelineEntryIt{pipelineCache.try_emplace(PipelineCacheKey{state}, std::move(descriptorSetLayout), std::move(pipelineLayout), std::move(pipeline))};
-        return CompiledPipeline{pipelineEntryIt.first->second};
+        CompiledPipeline compiledPipeline{pipelineEntryIt.first->second};
+
+        // Periodically persist the cache as emulation may be terminated without the cache being destroyed
+        bool saveCache{++unsavedPipelineCount >= PipelineCacheSaveInterval};
+        if (saveCache)
+            unsavedPipelineCount = 0;
+
+        lock.unlock();
+
+        if (saveCache)
+            SaveVkPipelineCache();
+
+        return compiledPipeline;
+    }
+
+    vk::raii::Pipeline GraphicsPipelineCache::CreateComputePipeline(const vk::ComputePipelineCreateInfo &createInfo) {
+        std::unique_lock lock(mutex);
+        if (!vkPipelineCacheLoaded)
+            LoadVkPipelineCache();
+        lock.unlock();
+
+        return gpu.vkDevice.createComputePipeline(vkPipelineCache, createInfo);
     }
 }
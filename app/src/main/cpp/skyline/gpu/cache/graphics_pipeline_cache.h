@@ -3,7 +3,10 @@
 
 #pragma once
 
+#include <atomic>
 #include <vulkan/vulkan_raii.hpp>
+#include <common.h>
+#include <common/utils.h>
 
 namespace skyline::gpu {
     class TextureView;
@@ -13,9 +16,30 @@ namespace skyline::gpu::cache {
     /**
      * @brief A cache for all Vulkan graphics pipelines objects used by the GPU to avoid costly re-creation
      * @note The cache is **not** compliant with Vulkan specification's Render Pass Compatibility clause when used with multi-subpass Render Passes but certain drivers may support a more relaxed version of this clause in practice which may allow it to be used with multi-subpass Render Passes
+     * @note With VK_KHR_dynamic_rendering pipelines are compiled against the attachment formats alone and every subpass is a distinct rendering scope, so this doesn't apply
      */
     class GraphicsPipelineCache {
       public:
+        /**
+         * @brief The state of a single attachment that's required to compile a pipeline, this is captured from the attachment ahead of time which allows for pipelines to be compiled without the attachment being locked
+         */
+        struct AttachmentState {
+            vk::Format format{vk::Format::eUndefined}; //!< The format of the attachment, this is undefined for an unbound attachment
+            vk::SampleCountFlagBits sampleCount{vk::SampleCountFlagBits::e1};
+            vk::ImageLayout layout{vk::ImageLayout::eUndefined};
+
+            constexpr AttachmentState() = default;
+
+            /**
+             * @param view A nullable pointer to the view of the attachment, it **must** be locked
+             */
+            AttachmentState(TextureView *view);
+
+            constexpr explicit operator bool() const {
+                return format != vk::Format::eUndefined;
+            }
+        };
+
         /**
          * @brief All unique state required to compile a graphics pipeline as references
          */
@@ -31,8 +55,8 @@ namespace skyline::gpu::cache {
             const vk::PipelineColorBlendStateCreateInfo &colorBlendState;
             const vk::PipelineDynamicStateCreateInfo &dynamicState;
 
-            span<TextureView *> colorAttachments; //!< All color attachments in the subpass of this pipeline
-            TextureView *depthStencilAttachment; //!< A nullable pointer to the depth/stencil attachment in the subpass of this pipeline
+            span<const AttachmentState> colorAttachments; //!< All color attachments in the subpass of this pipeline
+            const AttachmentState *depthStencilAttachment; //!< A nullable pointer to the depth/stencil attachment in the subpass of this pipeline
 
             constexpr const vk::PipelineVertexInputStateCreateInfo &VertexInputState() const {
                 return vertexState.get<vk::PipelineVertexInputStateCreateInfo>();
@@ -52,9 +76,16 @@ namespace skyline::gpu::cache {
         };
 
       private:
+        static constexpr size_t PipelineCacheSaveInterval{64}; //!< The amount of newly compiled pipelines after which the Vulkan pipeline cache is written back to disk
+
+        const DeviceState &state;
         GPU &gpu;
         std::mutex mutex; //!< Synchronizes accesses to the pipeline cache
         vk::raii::PipelineCache vkPipelineCache; //!< A Vulkan Pipeline Cache which stores all unique graphics pipelines
+        bool vkPipelineCacheLoaded{}; //!< If the Vulkan pipeline cache has been loaded from disk, this is deferred till the first pipeline compilation as the title isn't known prior to that
+        std::string vkPipelineCachePath; //!< The path to the file the Vulkan pipeline cache is persisted to, this is empty if the cache shouldn't be persisted
+        size_t unsavedPipelineCount{}; //!< The amount of pipelines compiled since the Vulkan pipeline cache was last saved
+        std::mutex saveMutex; //!< Synchronizes writing the Vulkan pipeline cache to disk
 
         /**
          * @brief All unique metadata in a single attachment for a compatible render pass according to Render Pass Compatibility clause in the Vulkan specification
@@ -134,29 +165,109 @@ namespace skyline::gpu::cache {
         struct PipelineCacheEntry {
             vk::raii::DescriptorSetLayout descriptorSetLayout;
             vk::raii::PipelineLayout pipelineLayout;
-            vk::raii::Pipeline pipeline;
+            vk::raii::Pipeline pipeline; //!< The pipeline used for draws, this is fast-linked from pipeline libraries when they're supported
+            vk::raii::Pipeline optimizedPipeline{nullptr}; //!< A link-time optimized version of the fast-linked pipeline, this is compiled in the background and must only be accessed after optimizedPipelineHandle is set
+            std::atomic<VkPipeline> optimizedPipelineHandle{}; //!< The handle of the optimized pipeline, this is only set once it's ready to be used
 
             PipelineCacheEntry(vk::raii::DescriptorSetLayout&& descriptorSetLayout, vk::raii::PipelineLayout &&layout, vk::raii::Pipeline &&pipeline);
         };
 
         std::unordered_map<PipelineCacheKey, PipelineCacheEntry, PipelineStateHash, PipelineCacheEqual> pipelineCache;
 
+        /**
+         * @brief A serialized form of the subset of a pipeline's state that a single pipeline library depends on, prefixed by the library type
+         */
+        using PipelineLibraryKey = std::vector<u8>;
+
+        struct PipelineLibraryKeyHash {
+            size_t operator()(const PipelineLibraryKey &key) const {
+                return XXH64(key.data(), key.size(), 0);
+            }
+        };
+
+        std::unordered_map<PipelineLibraryKey, vk::raii::Pipeline, PipelineLibraryKeyHash> pipelineLibraries; //!< All pipeline libraries that have been compiled, these are shared by all pipelines with the same state for the library's part of the pipeline
+
+        /**
+         * @return A render pass that's compatible with the attachments of the supplied pipeline state
+         */
+        vk::raii::RenderPass CreateCompatibleRenderPass(const PipelineState &state);
+
+        /**
+         * @brief The attachment formats of a pipeline state in the form required to compile a pipeline for dynamic rendering
+         */
+        struct RenderingFormats {
+            boost::container::small_vector<vk::Format, 8> colorFormats;
+            vk::PipelineRenderingCreateInfo createInfo;
+
+            RenderingFormats(const PipelineState &state);
+
+            RenderingFormats(const RenderingFormats &) = delete; //!< The create info points into the structure, so it can't be copied
+        };
+
+        /**
+         * @brief Looks up or compiles a pipeline library for a single part of a pipeline
+         * @param createInfo The pipeline create info with all state for the library's part of the pipeline filled in, any pNext chain is retained after the library info
+         * @note The mutex **must not** be locked prior to calling this
+         */
+        vk::Pipeline GetPipelineLibrary(PipelineLibraryKey &&key, vk::GraphicsPipelineLibraryFlagBitsEXT part, const vk::GraphicsPipelineCreateInfo &createInfo);
+
+        /**
+         * @return Pipeline libraries for the vertex input, pre-rasterization, fragment shader and fragment output parts of the supplied pipeline
+         * @param renderingInfo The attachment formats when using dynamic rendering, the render pass must be null in this case
+         * @note The mutex **must not** be locked prior to calling this
+         */
+        std::array<vk::Pipeline, 4> GetPipelineLibraries(const PipelineState &state, span<const vk::DescriptorSetLayoutBinding> layoutBindings, span<const vk::PushConstantRange> pushConstantRanges, bool noPushDescriptors, vk::PipelineLayout pipelineLayout, vk::RenderPass renderPass, const vk::PipelineRenderingCreateInfo *renderingInfo);
+
+        /**
+         * @brief Links a complete pipeline from pipeline libraries covering all of its parts
+         * @param flags vk::PipelineCreateFlagBits::eLinkTimeOptimizationEXT for an optimized pipeline, otherwise the pipeline is fast-linked
+         */
+        vk::raii::Pipeline LinkPipelineLibraries(span<const vk::Pipeline> libraries, vk::PipelineLayout pipelineLayout, vk::PipelineCreateFlags flags);
+
+        /**
+         * @brief Recreates the Vulkan pipeline cache from the data persisted on disk for the current title and driver, if there's any valid data
+         * @note The mutex **must** be locked prior to calling this
+         */
+        void LoadVkPipelineCache();
+
       public:
-        GraphicsPipelineCache(GPU &gpu);
+        GraphicsPipelineCache(const DeviceState &state, GPU &gpu);
+
+        ~GraphicsPipelineCache();
+
+        /**
+         * @brief Writes the contents of the Vulkan pipeline cache to disk so it can be preloaded in subsequent runs
+         */
+        void SaveVkPipelineCache();
 
         struct CompiledPipeline {
             vk::DescriptorSetLayout descriptorSetLayout;
             vk::PipelineLayout pipelineLayout;
             vk::Pipeline pipeline;
+            const std::atomic<VkPipeline> *optimizedPipeline; //!< The handle of an optimized version of the pipeline which is swapped in once it has been compiled
 
             CompiledPipeline(const PipelineCacheEntry &entry);
+
+            /**
+             * @return The optimized pipeline if it has finished compiling in the background, otherwise the pipeline that was initially compiled
+             */
+            vk::Pipeline GetPipeline() const {
+                if (auto optimized{optimizedPipeline->load(std::memory_order_acquire)})
+                    return optimized;
+                return pipeline;
+            }
         };
 
         /**
-         * @note All attachments in the PipelineState **must** be locked prior to calling this function
          * @note Shader specializiation constants are **not** supported and will result in UB
          * @note Input/Resolve attachments are **not** supported and using them with the supplied pipeline will result in UB
          */
         CompiledPipeline GetCompiledPipeline(const PipelineState& state, span<const vk::DescriptorSetLayoutBinding> layoutBindings, span<const vk::PushConstantRange> pushConstantRanges = {}, bool noPushDescriptors = false);
+
+        /**
+         * @brief Compiles a compute pipeline with the Vulkan pipeline cache, so it's persisted alongside the graphics pipelines
+         * @note The pipeline isn't tracked by this cache, the caller is responsible for reusing it
+         */
+        vk::raii::Pipeline CreateComputePipeline(const vk::ComputePipelineCreateInfo &createInfo);
     };
 }
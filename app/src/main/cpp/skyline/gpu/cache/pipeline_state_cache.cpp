@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <vfs/os_filesystem.h>
+#include <jvm.h>
+#include <gpu.h>
+#include "pipeline_state_cache.h"
+
+namespace skyline::gpu::cache {
+    static constexpr std::string_view PipelineStateCacheFileName{"pipelines.bin"};
+    static constexpr u32 ReplayProgressReportInterval{16}; //!< The amount of replayed pipelines after which progress is reported to the frontend
+
+    PipelineStateCache::PipelineStateCache(const DeviceState &state, GPU &gpu) : state{state}, gpu{gpu} {}
+
+    void PipelineStateCache::Load() {
+        loaded = true;
+
+        try {
+            vfs::OsFileSystem filesystem{gpu.GetTitleCacheDirectory()};
+            std::string path{PipelineStateCacheFileName};
+
+            FileHeader expectedHeader{
+                .applicationVersion = state.jvm->GetVersionCode(),
+            };
+            if (filesystem.FileExists(path)) {
+                backing = filesystem.OpenFile(path, {true, true, true});
+                if (backing->size < sizeof(FileHeader) || backing->Read<FileHeader>() != expectedHeader) {
+                    Logger::Info("Discarding incompatible pipeline state cache");
+                    backing->Resize(0);
+                }
+            } else {
+                if (!filesystem.CreateFile(path, 0))
+                    throw exception("Failed to create pipeline state cache file");
+                backing = filesystem.OpenFile(path, {true, true, true});
+            }
+
+            if (backing->size == 0) {
+                backing->WriteObject(expectedHeader);
+                return;
+            }
+
+            size_t offset{sizeof(FileHeader)};
+            while (offset + sizeof(u32) <= backing->size) {
+                auto recordSize{backing->Read<u32>(offset)};
+                if (offset + sizeof(u32) + recordSize > backing->size)
+                    break; // The record was only partially written out, this can happen if emulation was abruptly terminated
+
+                std::vector<u8> record(recordSize);
+                backing->Read(span<u8>(record), offset + sizeof(u32));
+                if (recordHashes.emplace(XXH64(record.data(), record.size(), 0)).second)
+                    loadedRecords.emplace_back(std::move(record));
+
+                offset += sizeof(u32) + recordSize;
+            }
+
+            // Drop any trailing partially written record so new records are appended at a valid offset
+            if (offset != backing->size)
+                backing->Resize(offset);
+
+            Logger::Info("Loaded {} pipelines from the pipeline state cache", loadedRecords.size());
+        } catch (const std::exception &e) {
+            Logger::Warn("Failed to load pipeline state cache: {}", e.what());
+            backing.reset();
+        }
+    }
+
+    void PipelineStateCache::Insert(span<const u8> record) {
+        std::scoped_lock lock{mutex};
+        if (!loaded)
+            Load();
+
+        if (!recordHashes.emplace(XXH64(record.data(), record.size(), 0)).second || !backing)
+            return;
+
+        try {
+            size_t offset{backing->size};
+            backing->WriteObject(static_cast<u32>(record.size()), offset);
+            backing->Write(span<u8>(const_cast<u8 *>(record.data()), record.size()), offset + sizeof(u32));
+        } catch (const std::exception &e) {
+            Logger::Warn("Failed to write to pipeline state cache: {}", e.what());
+            backing.reset();
+        }
+    }
+
+    void PipelineStateCache::Replay(CompileFunction compile) {
+        std::shared_ptr<std::vector<std::vector<u8>>> records;
+        {
+            std::scoped_lock lock{mutex};
+            if (!loaded)
+                Load();
+
+            records = std::make_shared<std::vector<std::vector<u8>>>(std::move(loadedRecords));
+            loadedRecords.clear();
+        }
+
+        if (records->empty())
+            return;
+
+        replayTotal = static_cast<u32>(records->size());
+        replayedCount = 0;
+        state.jvm->ReportPipelineReplayProgress(0, replayTotal);
+
+        auto sharedCompile{std::make_shared<CompileFunction>(std::move(compile))};
+        for (const auto &record : *records) {
+            gpu.pipelineCompilerPool.Submit([this, records, sharedCompile, record = span<const u8>(record)]() {
+                try {
+                    (*sharedCompile)(record);
+                } catch (const std::exception &e) {
+                    Logger::Warn("Failed to replay pipeline: {}", e.what());
+                }
+
+                u32 count{++replayedCount};
+                if (count == replayTotal) {
+                    Logger::Info("Finished replaying {} pipelines", count);
+                    state.jvm->ReportPipelineReplayProgress(count, replayTotal);
+                } else if (count % ReplayProgressReportInterval == 0) {
+                    state.jvm->ReportPipelineReplayProgress(count, replayTotal);
+                }
+            });
+        }
+    }
+}
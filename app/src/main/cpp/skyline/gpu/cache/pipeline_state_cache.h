@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <unordered_set>
+#include <vfs/backing.h>
+#include <common.h>
+
+namespace skyline::gpu::cache {
+    /**
+     * @brief A persistent per-title record of all pipelines used by a title, this allows for precompiling pipelines during the next boot before the guest reaches the draws that use them
+     * @note Records are opaque to the cache, the engine serializes all state required to recreate a pipeline without any guest state into them
+     */
+    class PipelineStateCache {
+      public:
+        using CompileFunction = std::function<void(span<const u8> record)>; //!< A function which compiles the pipeline described by a record
+
+      private:
+        static constexpr u32 FormatVersion{3}; //!< The version of the on-disk format, this must be incremented on any changes to the format or the contents of records
+
+        struct FileHeader {
+            u32 magic{util::MakeMagic<u32>("SKPS")};
+            u32 version{FormatVersion};
+            i32 applicationVersion; //!< The version code of the application, the layout of the records may change across versions
+
+            bool operator==(const FileHeader &) const = default;
+        };
+
+        const DeviceState &state;
+        GPU &gpu;
+        std::mutex mutex; //!< Synchronizes access to the cache and the backing file
+        bool loaded{}; //!< If the cache has been loaded from disk, loading is deferred till the title is known
+        std::shared_ptr<vfs::Backing> backing; //!< The backing of the cache file, this may be null if the file couldn't be opened
+        std::unordered_set<u64> recordHashes; //!< Hashes of all records in the cache, used to avoid recording a pipeline more than once
+        std::vector<std::vector<u8>> loadedRecords; //!< The records loaded from disk, these are cleared after being replayed
+        std::atomic<u32> replayedCount{}; //!< The amount of records that have been replayed so far
+        u32 replayTotal{}; //!< The total amount of records that are being replayed
+
+        /**
+         * @brief Loads all records from the cache file into memory, discarding the file if it's incompatible
+         * @note The mutex **must** be locked prior to calling this
+         */
+        void Load();
+
+      public:
+        PipelineStateCache(const DeviceState &state, GPU &gpu);
+
+        /**
+         * @brief Records a pipeline in the cache if an identical record isn't already present
+         */
+        void Insert(span<const u8> record);
+
+        /**
+         * @brief Asynchronously compiles all recorded pipelines on the GPU's pipeline compiler pool
+         * @note The progress of the replay is reported to the frontend as it progresses
+         */
+        void Replay(CompileFunction compile);
+    };
+}
@@ -6,7 +6,11 @@
 #include "renderpass_cache.h"
 
 namespace skyline::gpu::cache {
-    RenderPassCache::RenderPassCache(gpu::GPU &gpu) : gpu{gpu} {}
+    static std::atomic<u32> NextInstanceId{1}; //!< The ID of the next cache instance, 0 is reserved for empty front cache entries
+
+    thread_local std::array<RenderPassCache::FrontCacheEntry, RenderPassCache::FrontCacheSize> RenderPassCache::frontCache{};
+
+    RenderPassCache::RenderPassCache(gpu::GPU &gpu) : gpu{gpu}, instanceId{NextInstanceId.fetch_add(1, std::memory_order_relaxed)} {}
 
     #define VEC_CPY(pointer, size) description.pointer, description.pointer + description.size
 
@@ -21,59 +25,13 @@ namespace skyline::gpu::cache {
 
     #undef VEC_CPY
 
-    RenderPassCache::RenderPassMetadata::RenderPassMetadata(const vk::RenderPassCreateInfo &createInfo)
+    RenderPassCache::RenderPassMetadata::RenderPassMetadata(const vk::RenderPassCreateInfo &createInfo, size_t hash)
         : attachments{createInfo.pAttachments, createInfo.pAttachments + createInfo.attachmentCount},
-          subpasses{createInfo.pSubpasses, createInfo.pSubpasses + createInfo.subpassCount} {}
+          subpasses{createInfo.pSubpasses, createInfo.pSubpasses + createInfo.subpassCount},
+          hash{hash} {}
 
     #define HASH(x) boost::hash_combine(hash, x)
 
-    size_t RenderPassCache::RenderPassHash::operator()(const RenderPassMetadata &key) const {
-        size_t hash{};
-
-        HASH(key.attachments.size());
-        for (const auto &attachment : key.attachments) {
-            HASH(static_cast<VkAttachmentDescriptionFlags>(attachment.flags));
-            HASH(attachment.format);
-            HASH(attachment.samples);
-            HASH(attachment.loadOp);
-            HASH(attachment.storeOp);
-            HASH(attachment.stencilLoadOp);
-            HASH(attachment.stencilStoreOp);
-            HASH(attachment.initialLayout);
-            HASH(attachment.finalLayout);
-        }
-
-        HASH(key.subpasses.size());
-        for (const auto &subpass : key.subpasses) {
-            HASH(static_cast<VkSubpassDescriptionFlags>(subpass.flags));
-            HASH(subpass.pipelineBindPoint);
-
-            auto hashReferences{[&hash](const auto &references) {
-                HASH(references.size());
-                for (const auto &reference : references) {
-                    HASH(reference.attachment);
-                    HASH(reference.layout);
-                }
-            }};
-
-            hashReferences(subpass.inputAttachments);
-            hashReferences(subpass.colorAttachments);
-            hashReferences(subpass.resolveAttachments);
-
-            HASH(subpass.depthStencilAttachment.has_value());
-            if (subpass.depthStencilAttachment) {
-                HASH(subpass.depthStencilAttachment->attachment);
-                HASH(subpass.depthStencilAttachment->layout);
-            }
-
-            HASH(subpass.preserveAttachments.size());
-            for (const auto &index : subpass.preserveAttachments)
-                HASH(index);
-        }
-
-        return hash;
-    }
-
     size_t RenderPassCache::RenderPassHash::operator()(const vk::RenderPassCreateInfo &key) const {
         size_t hash{};
 
@@ -149,7 +107,7 @@ namespace skyline::gpu::cache {
 
             RETF(subpass.depthStencilAttachment.has_value() != (vkSubpass->pDepthStencilAttachment != nullptr))
             if (subpass.depthStencilAttachment)
-                RETF(subpass.depthStencilAttachment->attachment != vkSubpass->pDepthStencilAttachment->attachment &&
+                RETF(subpass.depthStencilAttachment->attachment != vkSubpass->pDepthStencilAttachment->attachment ||
                     subpass.depthStencilAttachment->layout != vkSubpass->pDepthStencilAttachment->layout)
 
             RETARRNEQ(subpass.preserveAttachments, vkSubpass->pPreserveAttachments, vkSubpass->preserveAttachmentCount)
@@ -163,12 +121,17 @@ namespace skyline::gpu::cache {
     }
 
     vk::RenderPass RenderPassCache::GetRenderPass(const vk::RenderPassCreateInfo &createInfo) {
+        HashedCreateInfo key{createInfo, RenderPassHash{}(createInfo)};
+        auto &frontEntry{frontCache[key.hash % FrontCacheSize]};
+        if (frontEntry.instanceId == instanceId && RenderPassEqual{}(*frontEntry.key, key))
+            return frontEntry.renderPass;
+
         std::scoped_lock lock{mutex};
-        auto it{renderPassCache.find(createInfo)};
-        if (it != renderPassCache.end())
-            return *it->second;
+        auto it{renderPassCache.find(key)};
+        if (it == renderPassCache.end())
+            it = renderPassCache.try_emplace(RenderPassMetadata{createInfo, key.hash}, gpu.vkDevice, createInfo).first;
 
-        auto entryIt{renderPassCache.try_emplace(RenderPassMetadata{createInfo}, gpu.vkDevice, createInfo)};
-        return *entryIt.first->second;
+        frontEntry = {instanceId, key.hash, &it->first, *it->second};
+        return frontEntry.renderPass;
     }
 }
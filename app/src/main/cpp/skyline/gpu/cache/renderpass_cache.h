@@ -14,6 +14,13 @@ namespace skyline::gpu::cache {
       private:
         GPU &gpu;
         std::mutex mutex; //!< Synchronizes access to the cache
+        u32 instanceId; //!< A unique ID for this instance of the cache, this is used to invalidate the front cache entries of any prior instance
+
+        static constexpr size_t InlineAttachmentCount{9}; //!< The amount of attachments stored inline by the keys, this covers 8 color attachments and a depth/stencil attachment
+        static constexpr size_t InlineSubpassCount{4}; //!< The amount of subpasses stored inline by the keys
+
+        template<typename T, size_t Count = InlineAttachmentCount>
+        using InlineVector = boost::container::small_vector<T, Count>;
 
         /**
          * @url https://www.khronos.org/registry/vulkan/specs/1.3-extensions/man/html/VkSubpassDescription.html
@@ -21,11 +28,11 @@ namespace skyline::gpu::cache {
         struct SubpassDescription {
             vk::SubpassDescriptionFlags flags;
             vk::PipelineBindPoint pipelineBindPoint;
-            std::vector<vk::AttachmentReference> inputAttachments;
-            std::vector<vk::AttachmentReference> colorAttachments;
-            std::vector<vk::AttachmentReference> resolveAttachments;
+            InlineVector<vk::AttachmentReference> inputAttachments;
+            InlineVector<vk::AttachmentReference> colorAttachments;
+            InlineVector<vk::AttachmentReference> resolveAttachments;
             std::optional<vk::AttachmentReference> depthStencilAttachment;
-            std::vector<u32> preserveAttachments;
+            InlineVector<u32> preserveAttachments;
 
             SubpassDescription(const vk::SubpassDescription &description);
 
@@ -36,18 +43,33 @@ namespace skyline::gpu::cache {
          * @url https://www.khronos.org/registry/vulkan/specs/1.3-extensions/man/html/VkRenderPassCreateInfo.html
          */
         struct RenderPassMetadata {
-            std::vector<vk::AttachmentDescription> attachments;
-            std::vector<SubpassDescription> subpasses;
+            InlineVector<vk::AttachmentDescription> attachments;
+            InlineVector<SubpassDescription, InlineSubpassCount> subpasses;
+            size_t hash; //!< The hash of the create info the metadata was created from, this is precomputed to avoid rehashing the metadata during lookups
 
-            RenderPassMetadata(const vk::RenderPassCreateInfo &createInfo);
+            RenderPassMetadata(const vk::RenderPassCreateInfo &createInfo, size_t hash);
 
             bool operator==(const RenderPassMetadata &other) const = default;
         };
 
+        /**
+         * @brief A create info alongside its precomputed hash, this is used for lookups so the create info is only hashed once
+         */
+        struct HashedCreateInfo {
+            const vk::RenderPassCreateInfo &createInfo;
+            size_t hash;
+        };
+
         struct RenderPassHash {
             using is_transparent = std::true_type;
 
-            size_t operator()(const RenderPassMetadata &key) const;
+            size_t operator()(const RenderPassMetadata &key) const {
+                return key.hash;
+            }
+
+            size_t operator()(const HashedCreateInfo &key) const {
+                return key.hash;
+            }
 
             size_t operator()(const vk::RenderPassCreateInfo &key) const;
         };
@@ -58,13 +80,33 @@ namespace skyline::gpu::cache {
             bool operator()(const RenderPassMetadata &lhs, const RenderPassMetadata &rhs) const;
 
             bool operator()(const RenderPassMetadata &lhs, const vk::RenderPassCreateInfo &rhs) const;
+
+            bool operator()(const RenderPassMetadata &lhs, const HashedCreateInfo &rhs) const {
+                return lhs.hash == rhs.hash && (*this)(lhs, rhs.createInfo);
+            }
         };
 
         std::unordered_map<RenderPassMetadata, vk::raii::RenderPass, RenderPassHash, RenderPassEqual> renderPassCache;
 
+        /**
+         * @brief An entry in the per-thread front cache, this refers to the key of an entry in the main cache which is stable as entries are never erased
+         */
+        struct FrontCacheEntry {
+            u32 instanceId; //!< The ID of the cache instance the entry was inserted by, 0 denotes an empty entry
+            size_t hash;
+            const RenderPassMetadata *key;
+            vk::RenderPass renderPass;
+        };
+
+        static constexpr size_t FrontCacheSize{16}; //!< The amount of entries in the direct-mapped front cache of each thread
+        static thread_local std::array<FrontCacheEntry, FrontCacheSize> frontCache; //!< A per-thread cache of recently used render passes which can be looked up without locking the mutex
+
       public:
         RenderPassCache(GPU &gpu);
 
+        /**
+         * @note Lookups that hit the calling thread's front cache don't lock the mutex, a lookup never allocates unless a new render pass is created
+         */
         vk::RenderPass GetRenderPass(const vk::RenderPassCreateInfo &createInfo);
     };
 }
@@ -0,0 +1,279 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <vfs/os_filesystem.h>
+#include <jvm.h>
+#include <gpu.h>
+#include "shader_cache.h"
+
+namespace skyline::gpu::cache {
+    static constexpr std::string_view ShaderCacheFileName{"shaders.bin"};
+
+    Shader::IR::Program ProgramInfo::MakeProgram() const {
+        Shader::IR::Program program;
+        program.stage = stage;
+        program.output_topology = outputTopology;
+        program.is_geometry_passthrough = isGeometryPassthrough;
+        program.info = info;
+        return program;
+    }
+
+    /**
+     * @brief Serializes trivially copyable objects and ranges of them into a buffer
+     */
+    class RecordWriter {
+      public:
+        std::vector<u8> data;
+
+        template<typename T> requires std::is_trivially_copyable_v<T>
+        void Write(const T &object) {
+            auto bytes{reinterpret_cast<const u8 *>(&object)};
+            data.insert(data.end(), bytes, bytes + sizeof(T));
+        }
+
+        /**
+         * @brief Writes the size of the range followed by all of its elements
+         */
+        template<typename Range>
+        void WriteRange(const Range &range) {
+            Write(static_cast<u32>(range.size()));
+            for (const auto &element : range)
+                Write(element);
+        }
+    };
+
+    /**
+     * @brief Deserializes objects written by RecordWriter from a buffer, any read past the end of the buffer throws an exception
+     */
+    class RecordReader {
+      private:
+        span<u8> data;
+        size_t offset{};
+
+      public:
+        RecordReader(span<u8> data) : data{data} {}
+
+        template<typename T> requires std::is_trivially_copyable_v<T>
+        T Read() {
+            if (data.size() - offset < sizeof(T))
+                throw exception("Shader cache record is truncated: 0x{:X}/0x{:X}", offset + sizeof(T), data.size());
+
+            std::array<u8, sizeof(T)> bytes;
+            std::memcpy(bytes.data(), data.data() + offset, sizeof(T));
+            offset += sizeof(T);
+            return std::bit_cast<T>(bytes); // Not all serialized types are default constructible
+        }
+
+        template<typename Container>
+        void ReadRange(Container &container) {
+            auto count{Read<u32>()};
+            if (count > container.max_size())
+                throw exception("Shader cache record has too many elements: {}", count);
+
+            container.clear();
+            for (u32 i{}; i < count; i++)
+                container.push_back(Read<typename Container::value_type>());
+        }
+
+        bool Finished() const {
+            return offset == data.size();
+        }
+    };
+
+    static void WriteInfo(RecordWriter &writer, const Shader::Info &info) {
+        writer.Write(info.loads);
+        writer.Write(info.stores);
+        writer.Write(info.passthrough);
+        writer.Write(info.constant_buffer_used_sizes);
+        writer.WriteRange(info.constant_buffer_descriptors);
+        writer.WriteRange(info.storage_buffers_descriptors);
+        writer.WriteRange(info.texture_buffer_descriptors);
+        writer.WriteRange(info.image_buffer_descriptors);
+        writer.WriteRange(info.texture_descriptors);
+        writer.WriteRange(info.image_descriptors);
+    }
+
+    static Shader::Info ReadInfo(RecordReader &reader) {
+        Shader::Info info{};
+        info.loads = reader.Read<decltype(info.loads)>();
+        info.stores = reader.Read<decltype(info.stores)>();
+        info.passthrough = reader.Read<decltype(info.passthrough)>();
+        info.constant_buffer_used_sizes = reader.Read<decltype(info.constant_buffer_used_sizes)>();
+        reader.ReadRange(info.constant_buffer_descriptors);
+        reader.ReadRange(info.storage_buffers_descriptors);
+        reader.ReadRange(info.texture_buffer_descriptors);
+        reader.ReadRange(info.image_buffer_descriptors);
+        reader.ReadRange(info.texture_descriptors);
+        reader.ReadRange(info.image_descriptors);
+        return info;
+    }
+
+    ShaderCache::ShaderCache(const DeviceState &state, GPU &gpu) : state{state}, gpu{gpu} {}
+
+    ShaderCache::FileHeader ShaderCache::MakeFileHeader() {
+        auto properties{gpu.vkPhysicalDevice.getProperties()};
+
+        FileHeader header{
+            .applicationVersion = state.jvm->GetVersionCode(),
+            .vendorId = properties.vendorID,
+            .deviceId = properties.deviceID,
+            .driverVersion = properties.driverVersion,
+        };
+        std::copy(std::begin(properties.pipelineCacheUUID), std::end(properties.pipelineCacheUUID), header.pipelineCacheUuid.begin());
+        return header;
+    }
+
+    void ShaderCache::Load() {
+        loaded = true;
+
+        try {
+            vfs::OsFileSystem filesystem{gpu.GetTitleCacheDirectory()};
+            std::string path{ShaderCacheFileName};
+
+            auto expectedHeader{MakeFileHeader()};
+            if (filesystem.FileExists(path)) {
+                backing = filesystem.OpenFile(path, {true, true, true});
+                if (backing->size < sizeof(FileHeader) || backing->Read<FileHeader>() != expectedHeader) {
+                    Logger::Info("Discarding incompatible shader cache");
+                    backing->Resize(0);
+                }
+            } else {
+                if (!filesystem.CreateFile(path, 0))
+                    throw exception("Failed to create shader cache file");
+                backing = filesystem.OpenFile(path, {true, true, true});
+            }
+
+            if (backing->size == 0) {
+                backing->WriteObject(expectedHeader);
+                return;
+            }
+
+            size_t offset{sizeof(FileHeader)};
+            std::vector<u8> payload;
+            while (offset + sizeof(RecordHeader) <= backing->size) {
+                auto recordHeader{backing->Read<RecordHeader>(offset)};
+                if (offset + sizeof(RecordHeader) + recordHeader.size > backing->size)
+                    break; // The record was only partially written out, this can happen if emulation was abruptly terminated
+
+                payload.resize(recordHeader.size);
+                backing->Read(span<u8>(payload), offset + sizeof(RecordHeader));
+
+                try {
+                    RecordReader reader{payload};
+                    if (recordHeader.type == RecordType::Shader) {
+                        Entry entry{reader.Read<Shader::Backend::Bindings>()};
+                        entry.info = ReadInfo(reader);
+                        reader.ReadRange(entry.spirv);
+                        entries.try_emplace(recordHeader.hash, std::move(entry));
+                    } else if (recordHeader.type == RecordType::Program) {
+                        ProgramEntry entry{};
+                        reader.ReadRange(entry.constantBufferWords);
+                        reader.ReadRange(entry.textureTypes);
+                        entry.programInfo.stage = reader.Read<Shader::Stage>();
+                        entry.programInfo.outputTopology = reader.Read<Shader::OutputTopology>();
+                        entry.programInfo.isGeometryPassthrough = reader.Read<bool>();
+                        entry.programInfo.info = ReadInfo(reader);
+                        programs.emplace(recordHeader.hash, std::move(entry));
+                    }
+
+                    if (!reader.Finished())
+                        throw exception("Shader cache record has trailing data");
+                } catch (const std::exception &e) {
+                    Logger::Warn("Discarding shader cache from a corrupt record onwards: {}", e.what());
+                    break;
+                }
+
+                offset += sizeof(RecordHeader) + recordHeader.size;
+            }
+
+            // Drop any trailing partially written or corrupt record so new records are appended at a valid offset
+            if (offset != backing->size)
+                backing->Resize(offset);
+
+            Logger::Info("Loaded {} shaders and {} programs from the shader cache", entries.size(), programs.size());
+        } catch (const std::exception &e) {
+            Logger::Warn("Failed to load shader cache: {}", e.what());
+            backing.reset();
+        }
+    }
+
+    void ShaderCache::WriteRecord(RecordType type, u64 hash, span<u8> payload) {
+        if (!backing)
+            return;
+
+        try {
+            RecordHeader recordHeader{
+                .type = type,
+                .size = static_cast<u32>(payload.size()),
+                .hash = hash,
+            };
+
+            size_t offset{backing->size};
+            backing->WriteObject(recordHeader, offset);
+            backing->Write(payload, offset + sizeof(RecordHeader));
+        } catch (const std::exception &e) {
+            Logger::Warn("Failed to write to shader cache: {}", e.what());
+            backing.reset();
+        }
+    }
+
+    const ShaderCache::Entry *ShaderCache::Lookup(u64 hash) {
+        std::scoped_lock lock{mutex};
+        if (!loaded)
+            Load();
+
+        auto it{entries.find(hash)};
+        return it != entries.end() ? &it->second : nullptr;
+    }
+
+    void ShaderCache::Insert(u64 hash, span<const u32> spirv, const Shader::Backend::Bindings &bindings, const Shader::Info &info) {
+        std::scoped_lock lock{mutex};
+        if (!loaded)
+            Load();
+
+        auto[it, inserted]{entries.try_emplace(hash, Entry{bindings, info, std::vector<u32>(spirv.begin(), spirv.end())})};
+        if (!inserted)
+            return;
+
+        RecordWriter writer;
+        writer.Write(bindings);
+        WriteInfo(writer, info);
+        writer.WriteRange(spirv);
+        WriteRecord(RecordType::Shader, hash, writer.data);
+    }
+
+    std::vector<const ShaderCache::ProgramEntry *> ShaderCache::LookupPrograms(u64 binaryHash) {
+        std::scoped_lock lock{mutex};
+        if (!loaded)
+            Load();
+
+        std::vector<const ProgramEntry *> matches;
+        auto [begin, end]{programs.equal_range(binaryHash)};
+        for (auto it{begin}; it != end; it++)
+            matches.push_back(&it->second);
+        return matches;
+    }
+
+    void ShaderCache::InsertProgram(u64 binaryHash, ProgramEntry &&entry) {
+        std::scoped_lock lock{mutex};
+        if (!loaded)
+            Load();
+
+        // Another thread may have translated the same program concurrently, only a single copy is kept
+        auto [begin, end]{programs.equal_range(binaryHash)};
+        for (auto it{begin}; it != end; it++)
+            if (it->second.constantBufferWords == entry.constantBufferWords && it->second.textureTypes == entry.textureTypes)
+                return;
+
+        RecordWriter writer;
+        writer.WriteRange(entry.constantBufferWords);
+        writer.WriteRange(entry.textureTypes);
+        writer.Write(entry.programInfo.stage);
+        writer.Write(entry.programInfo.outputTopology);
+        writer.Write(entry.programInfo.isGeometryPassthrough);
+        WriteInfo(writer, entry.programInfo.info);
+        WriteRecord(RecordType::Program, binaryHash, writer.data);
+
+        programs.emplace(binaryHash, std::move(entry));
+    }
+}
@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <shader_compiler/frontend/ir/program.h>
+#include <shader_compiler/backend/bindings.h>
+#include <vfs/backing.h>
+#include <common.h>
+
+namespace skyline::gpu::cache {
+    /**
+     * @brief A single u32 word from a constant buffer with the offset it was read from, utilized to ensure constant buffer state is consistent
+     */
+    struct ConstantBufferWord {
+        u32 index; //!< The index of the constant buffer
+        u32 offset; //!< The offset of the constant buffer word
+        u32 value; //!< The contents of the word
+
+        constexpr ConstantBufferWord(u32 index, u32 offset, u32 value) : index{index}, offset{offset}, value{value} {}
+
+        constexpr bool operator==(const ConstantBufferWord &other) const = default;
+    };
+
+    /**
+     * @brief The type of a texture with the handle it was looked up with
+     */
+    struct CachedTextureType {
+        u32 handle;
+        Shader::TextureType type;
+
+        constexpr CachedTextureType(u32 handle, Shader::TextureType type) : handle{handle}, type{type} {}
+
+        constexpr bool operator==(const CachedTextureType &other) const = default;
+    };
+
+    /**
+     * @brief The state of a translated program which is required to compile a pipeline from cached SPIR-V without translating the program again
+     * @note Only the parts of Shader::Info that are used outside of SPIR-V emission are persisted, emission always runs on a freshly translated program
+     */
+    struct ProgramInfo {
+        Shader::Stage stage;
+        Shader::OutputTopology outputTopology;
+        bool isGeometryPassthrough;
+        Shader::Info info;
+
+        /**
+         * @return A program with the state required for compiling cached SPIR-V, it has no IR so it must be translated before emitting SPIR-V for it
+         */
+        Shader::IR::Program MakeProgram() const;
+    };
+
+    /**
+     * @brief A persistent per-title cache of translated shaders which allows for skipping translation and SPIR-V emission on subsequent runs of a title
+     * @note Programs are keyed by a hash of the guest shader binary and the state it's translated with, alongside every constant buffer word and texture type that was read during translation which must match for a cached program to be used
+     * @note SPIR-V is keyed by a hash of the program alongside all runtime state that the emitted SPIR-V depends on
+     * @note The cache is lazily loaded during the first lookup as the title ID isn't known when the GPU is constructed
+     */
+    class ShaderCache {
+      private:
+        static constexpr u32 FormatVersion{2}; //!< The version of the on-disk format, this must be incremented on any changes to the format or to the shader compiler output
+
+        /**
+         * @brief The header at the start of the cache file, the cache is discarded if any of the fields don't match the current host
+         */
+        struct FileHeader {
+            u32 magic{util::MakeMagic<u32>("SKSC")};
+            u32 version{FormatVersion};
+            i32 applicationVersion; //!< The version code of the application, shader compiler changes across versions would otherwise lead to stale entries
+            u32 vendorId;
+            u32 deviceId;
+            u32 driverVersion;
+            std::array<u8, VK_UUID_SIZE> pipelineCacheUuid;
+
+            bool operator==(const FileHeader &) const = default;
+        };
+
+        enum class RecordType : u32 {
+            Shader, //!< The SPIR-V of a shader alongside the bindings and program state after emitting it
+            Program, //!< The state of a translated program alongside the environment it was translated with
+        };
+
+        /**
+         * @brief The header of a single record in the cache file, it is directly followed by `size` bytes of the serialized record
+         */
+        struct RecordHeader {
+            RecordType type;
+            u32 size;
+            u64 hash;
+        };
+        static_assert(std::is_trivially_copyable_v<RecordHeader>);
+
+      public:
+        struct Entry {
+            Shader::Backend::Bindings bindings;
+            Shader::Info info; //!< The program state after emitting the shader, this includes the conversion of any legacy attributes
+            std::vector<u32> spirv;
+        };
+
+        struct ProgramEntry {
+            std::vector<ConstantBufferWord> constantBufferWords; //!< All constant buffer words read during translation in the order they were read
+            std::vector<CachedTextureType> textureTypes; //!< All texture types read during translation in the order they were read
+            ProgramInfo programInfo;
+        };
+
+      private:
+        const DeviceState &state;
+        GPU &gpu;
+        std::mutex mutex; //!< Synchronizes access to the cache and the backing file
+        bool loaded{}; //!< If the cache has been loaded from disk, loading is deferred till the first lookup
+        std::shared_ptr<vfs::Backing> backing; //!< The backing of the cache file, this may be null if the file couldn't be opened
+        std::unordered_map<u64, Entry> entries;
+        std::unordered_multimap<u64, ProgramEntry> programs; //!< A map from the hash of a guest shader binary to all programs translated from it with different environments
+
+        FileHeader MakeFileHeader();
+
+        /**
+         * @brief Loads all records from the cache file into memory, discarding the file if it's incompatible
+         * @note The mutex **must** be locked prior to calling this
+         */
+        void Load();
+
+        /**
+         * @brief Appends a record to the cache file
+         * @note The mutex **must** be locked prior to calling this
+         */
+        void WriteRecord(RecordType type, u64 hash, span<u8> payload);
+
+      public:
+        ShaderCache(const DeviceState &state, GPU &gpu);
+
+        /**
+         * @return A pointer to the cached entry with the supplied hash or nullptr if there isn't one
+         * @note The returned pointer is valid for the lifetime of the cache as entries are never removed
+         */
+        const Entry *Lookup(u64 hash);
+
+        /**
+         * @brief Inserts a shader into the cache and appends it to the cache file
+         */
+        void Insert(u64 hash, span<const u32> spirv, const Shader::Backend::Bindings &bindings, const Shader::Info &info);
+
+        /**
+         * @return Pointers to all cached programs that were translated from the guest shader binary with the supplied hash
+         * @note The returned pointers are valid for the lifetime of the cache as entries are never removed
+         */
+        std::vector<const ProgramEntry *> LookupPrograms(u64 binaryHash);
+
+        /**
+         * @brief Inserts a translated program into the cache and appends it to the cache file, this is a no-op if a program with an identical environment is already cached
+         */
+        void InsertProgram(u64 binaryHash, ProgramEntry &&entry);
+    };
+}
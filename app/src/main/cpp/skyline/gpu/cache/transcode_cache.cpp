@@ -0,0 +1,175 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <sys/stat.h>
+#include <lz4.h>
+#include <common/settings.h>
+#include <common/trace.h>
+#include <gpu.h>
+#include "transcode_cache.h"
+
+namespace skyline::gpu::cache {
+    static constexpr std::string_view TranscodeCacheDirectoryName{"transcoded/"};
+    static constexpr std::string_view TemporaryEntrySuffix{".tmp"}; //!< The suffix of entry files that are still being written out, these are renamed to the final name after being fully written
+
+    TranscodeCache::TranscodeCache(const DeviceState &state, GPU &gpu) : state{state}, gpu{gpu}, maxSize{static_cast<size_t>(*state.settings->transcodeCacheSize) * 1024 * 1024} {}
+
+    std::string TranscodeCache::GetEntryName(u64 key) {
+        return fmt::format("{:016X}", key);
+    }
+
+    void TranscodeCache::Load() {
+        loaded = true;
+
+        try {
+            directory = gpu.GetTitleCacheDirectory() + std::string{TranscodeCacheDirectoryName};
+            filesystem = std::make_shared<vfs::OsFileSystem>(directory);
+
+            std::vector<std::pair<timespec, Entry>> loadedEntries;
+            for (const auto &file : filesystem->OpenDirectory("", {false, true})->Read()) {
+                auto path{directory + file.name};
+                if (file.name.ends_with(TemporaryEntrySuffix)) {
+                    unlink(path.c_str()); // The entry was only partially written out, this can happen if emulation was abruptly terminated
+                    continue;
+                }
+
+                struct stat fileInfo{};
+                if (file.name.size() != 16 || file.name.find_first_not_of("0123456789ABCDEF") != std::string::npos || stat(path.c_str(), &fileInfo))
+                    continue;
+
+                loadedEntries.emplace_back(fileInfo.st_mtim, Entry{std::stoull(file.name, nullptr, 16), file.size});
+            }
+
+            // Entries are touched on every lookup, so the modification time is used to restore the LRU order from the previous run
+            std::sort(loadedEntries.begin(), loadedEntries.end(), [](const auto &a, const auto &b) {
+                return std::tie(a.first.tv_sec, a.first.tv_nsec) > std::tie(b.first.tv_sec, b.first.tv_nsec);
+            });
+
+            for (const auto &[time, entry] : loadedEntries) {
+                entries.emplace(entry.key, lruList.insert(lruList.end(), entry));
+                totalSize += entry.size;
+            }
+
+            Evict();
+
+            Logger::Info("Loaded {} entries ({} MiB) from the transcode cache", entries.size(), totalSize / 1024 / 1024);
+        } catch (const std::exception &e) {
+            Logger::Warn("Failed to load transcode cache: {}", e.what());
+            filesystem.reset();
+        }
+    }
+
+    void TranscodeCache::Evict() {
+        while (totalSize > maxSize && !lruList.empty()) {
+            const auto &entry{lruList.back()};
+            unlink((directory + GetEntryName(entry.key)).c_str());
+
+            totalSize -= entry.size;
+            entries.erase(entry.key);
+            lruList.pop_back();
+        }
+    }
+
+    u64 TranscodeCache::MakeKey(span<const u8> encoded, u64 seed) {
+        return XXH64(encoded.data(), encoded.size(), seed);
+    }
+
+    bool TranscodeCache::Lookup(u64 key, span<u8> output) {
+        TRACE_EVENT("gpu", "TranscodeCache::Lookup");
+
+        std::shared_ptr<vfs::OsFileSystem> lFilesystem;
+        std::string lDirectory;
+        {
+            std::scoped_lock lock{mutex};
+            if (!loaded)
+                Load();
+
+            auto it{entries.find(key)};
+            if (it == entries.end() || !filesystem)
+                return false;
+
+            lruList.splice(lruList.begin(), lruList, it->second);
+            lFilesystem = filesystem;
+            lDirectory = directory;
+        }
+
+        auto name{GetEntryName(key)};
+        try {
+            auto backing{lFilesystem->OpenFile(name)};
+            auto header{backing->Read<EntryHeader>()};
+            if (header.magic != EntryHeader{}.magic || header.version != FormatVersion || header.decodedSize != output.size() || sizeof(EntryHeader) + header.compressedSize != backing->size)
+                return false;
+
+            std::vector<u8> compressed(header.compressedSize);
+            backing->Read(span<u8>(compressed), sizeof(EntryHeader));
+            if (LZ4_decompress_safe(reinterpret_cast<char *>(compressed.data()), reinterpret_cast<char *>(output.data()), static_cast<int>(compressed.size()), static_cast<int>(output.size())) != static_cast<int>(output.size()))
+                throw exception("Failed to decompress entry");
+
+            utimensat(AT_FDCWD, (lDirectory + name).c_str(), nullptr, 0); // Update the modification time to persist the LRU order
+            return true;
+        } catch (const std::exception &e) {
+            Logger::Debug("Failed to read transcode cache entry {}: {}", name, e.what()); // This is expected if the entry hasn't been written out yet
+
+            std::scoped_lock lock{mutex};
+            auto it{entries.find(key)};
+            if (it != entries.end()) {
+                totalSize -= it->second->size;
+                lruList.erase(it->second);
+                entries.erase(it);
+            }
+            return false;
+        }
+    }
+
+    void TranscodeCache::Insert(u64 key, span<const u8> decoded) {
+        TRACE_EVENT("gpu", "TranscodeCache::Insert");
+
+        std::shared_ptr<vfs::OsFileSystem> lFilesystem;
+        {
+            std::scoped_lock lock{mutex};
+            if (!loaded)
+                Load();
+
+            if (!filesystem || entries.contains(key))
+                return;
+            lFilesystem = filesystem;
+        }
+
+        // Compression is done on the calling thread as the decoded data is only valid during this call, the file I/O is deferred to the texture decode pool
+        auto compressed{std::make_shared<std::vector<u8>>(sizeof(EntryHeader) + static_cast<size_t>(LZ4_compressBound(static_cast<int>(decoded.size()))))};
+        int compressedSize{LZ4_compress_default(reinterpret_cast<const char *>(decoded.data()), reinterpret_cast<char *>(compressed->data() + sizeof(EntryHeader)), static_cast<int>(decoded.size()), static_cast<int>(compressed->size() - sizeof(EntryHeader)))};
+        if (compressedSize <= 0)
+            return;
+
+        EntryHeader header{
+            .decodedSize = decoded.size(),
+            .compressedSize = static_cast<u64>(compressedSize),
+        };
+        std::memcpy(compressed->data(), &header, sizeof(EntryHeader));
+        compressed->resize(sizeof(EntryHeader) + static_cast<size_t>(compressedSize));
+
+        {
+            std::scoped_lock lock{mutex};
+            if (!entries.try_emplace(key, lruList.insert(lruList.begin(), Entry{key, compressed->size()})).second) {
+                lruList.pop_front(); // The entry was inserted by another thread while compressing
+                return;
+            }
+            totalSize += compressed->size();
+            Evict();
+        }
+
+        gpu.textureDecodePool.Submit([lFilesystem, lDirectory = directory, compressed, name = GetEntryName(key)]() {
+            try {
+                auto temporaryName{name + std::string{TemporaryEntrySuffix}};
+                if (!lFilesystem->CreateFile(temporaryName, 0))
+                    throw exception("Failed to create file");
+
+                lFilesystem->OpenFile(temporaryName, {false, true, false})->Write(span<u8>(*compressed));
+                if (rename((lDirectory + temporaryName).c_str(), (lDirectory + name).c_str()))
+                    throw exception("Failed to rename file: {}", strerror(errno));
+            } catch (const std::exception &e) {
+                Logger::Warn("Failed to write transcode cache entry {}: {}", name, e.what());
+            }
+        });
+    }
+}
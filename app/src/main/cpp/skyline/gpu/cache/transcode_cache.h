@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <list>
+#include <vfs/os_filesystem.h>
+#include <common.h>
+
+namespace skyline::gpu::cache {
+    /**
+     * @brief A persistent per-title cache of texture data transcoded on the CPU into a format supported by the host, this allows for skipping decoding textures which are repeatedly uploaded in a run or across runs
+     * @note Entries are content-addressed by a key derived from the guest data and all state the decoded output depends on, every entry is stored LZ4-compressed in a separate file
+     * @note The total size of all entries is capped, the least recently used entries are evicted when the cap is exceeded
+     */
+    class TranscodeCache {
+      private:
+        static constexpr u32 FormatVersion{1}; //!< The version of the on-disk format, this must be incremented on any changes to the format or to the output of any decoders
+
+        /**
+         * @brief The header at the start of every entry file, it is directly followed by the LZ4-compressed decoded data
+         */
+        struct EntryHeader {
+            u32 magic{util::MakeMagic<u32>("SKTC")};
+            u32 version{FormatVersion};
+            u64 decodedSize;
+            u64 compressedSize;
+        };
+        static_assert(std::is_trivially_copyable_v<EntryHeader>);
+
+        /**
+         * @brief An entry in the LRU list of all entries in the cache
+         */
+        struct Entry {
+            u64 key;
+            size_t size; //!< The size of the entry file in bytes
+        };
+
+        const DeviceState &state;
+        GPU &gpu;
+        std::mutex mutex; //!< Synchronizes access to all cache state, file I/O is done without the mutex held
+        bool loaded{}; //!< If the cache has been loaded from disk, loading is deferred till the first lookup as the title ID isn't known when the GPU is constructed
+        std::string directory; //!< The path to the cache directory
+        std::shared_ptr<vfs::OsFileSystem> filesystem; //!< The filesystem of the cache directory, this may be null if the directory couldn't be opened
+        size_t maxSize; //!< The maximum total size of all entries in bytes
+        size_t totalSize{}; //!< The total size of all entries in bytes
+        std::list<Entry> lruList; //!< All entries in the cache ordered from the most recently used to the least recently used
+        std::unordered_map<u64, std::list<Entry>::iterator> entries;
+
+        /**
+         * @brief Reads all entries in the cache directory and orders them by their last access time
+         * @note The mutex **must** be locked prior to calling this
+         */
+        void Load();
+
+        /**
+         * @brief Deletes the least recently used entries till the total size of the cache is within the cap
+         * @note The mutex **must** be locked prior to calling this
+         */
+        void Evict();
+
+        static std::string GetEntryName(u64 key);
+
+      public:
+        TranscodeCache(const DeviceState &state, GPU &gpu);
+
+        /**
+         * @return If the cache is enabled, lookups and insertions are no-ops when it isn't
+         */
+        bool IsEnabled() const {
+            return maxSize;
+        }
+
+        /**
+         * @return A key that uniquely identifies the decoded output of the supplied encoded data
+         * @param seed A hash of all state that the decoded output depends on other than the encoded data, such as the format and the dimensions
+         */
+        static u64 MakeKey(span<const u8> encoded, u64 seed);
+
+        /**
+         * @brief Decompresses the cached decoded data for the supplied key into the output
+         * @return If an entry with the supplied key matching the size of the output was found
+         */
+        bool Lookup(u64 key, span<u8> output);
+
+        /**
+         * @brief Compresses the decoded data and asynchronously writes it out as a new entry, evicting entries if the cap is exceeded
+         */
+        void Insert(u64 key, span<const u8> decoded);
+    };
+}
@@ -1,6 +1,8 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <common/settings.h>
+#include <common/thread_role.h>
 #include <gpu.h>
 #include <loader/loader.h>
 #include "command_scheduler.h"
@@ -9,6 +11,7 @@ namespace skyline::gpu {
     void CommandScheduler::WaiterThread() {
         if (int result{pthread_setname_np(pthread_self(), "Sky-CycleWaiter")})
             Logger::Warn("Failed to set the thread name: {}", strerror(result));
+        thread_role::Apply(thread_role::Role::CycleWaiter);
 
         try {
             signal::SetSignalHandler({SIGINT, SIGILL, SIGTRAP, SIGBUS, SIGFPE, SIGSEGV}, signal::ExceptionalSignalHandler);
@@ -38,9 +41,13 @@ namespace skyline::gpu {
           semaphore{device, vk::SemaphoreCreateInfo{}},
           cycle{std::make_shared<FenceCycle>(device, *fence, *semaphore)} {}
 
+    CommandScheduler::HandoffSemaphore::HandoffSemaphore(const vk::raii::Device &device) : semaphore{device, vk::SemaphoreCreateInfo{}} {}
+
     CommandScheduler::CommandScheduler(const DeviceState &state, GPU &pGpu)
         : state{state},
           gpu{pGpu},
+          timeline{pGpu.traits.supportsTimelineSemaphores ? std::make_optional<Timeline>(pGpu.vkDevice) : std::nullopt},
+          transferTimeline{pGpu.traits.supportsTimelineSemaphores && *state.settings->transferQueue ? std::make_optional<Timeline>(pGpu.vkDevice) : std::nullopt},
           waiterThread{&CommandScheduler::WaiterThread, this},
           pool{std::ref(pGpu.vkDevice), vk::CommandPoolCreateInfo{
               .flags = vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
@@ -77,7 +84,9 @@ namespace skyline::gpu {
         return {pool->buffers.emplace_back(gpu.vkDevice, commandBuffer, pool->vkCommandPool)};
     }
 
-    void CommandScheduler::SubmitCommandBuffer(const vk::raii::CommandBuffer &commandBuffer, std::shared_ptr<FenceCycle> cycle, span<vk::Semaphore> waitSemaphores, span<vk::Semaphore> signalSemaphores) {
+    void CommandScheduler::SubmitCommandBuffer(const vk::raii::CommandBuffer &commandBuffer, std::shared_ptr<FenceCycle> cycle, span<vk::Semaphore> waitSemaphores, span<vk::Semaphore> signalSemaphores, bool transfer) {
+        transfer &= gpu.vkTransferQueue.has_value();
+
         boost::container::small_vector<vk::Semaphore, 3> fullWaitSemaphores{waitSemaphores.begin(), waitSemaphores.end()};
         boost::container::small_vector<vk::PipelineStageFlags, 3> fullWaitStages{waitSemaphores.size(), vk::PipelineStageFlagBits::eAllCommands};
 
@@ -87,20 +96,73 @@ namespace skyline::gpu {
             fullWaitStages.push_back(vk::PipelineStageFlagBits::eTopOfPipe);
         }
 
-        boost::container::small_vector<vk::Semaphore, 2> fullSignalSemaphores{signalSemaphores.begin(), signalSemaphores.end()};
+        boost::container::small_vector<vk::Semaphore, 3> fullSignalSemaphores{signalSemaphores.begin(), signalSemaphores.end()};
         fullSignalSemaphores.push_back(cycle->semaphore);
 
+        std::scoped_lock handoffLock{handoffMutex};
+        HandoffSemaphore *handoffSemaphore{};
+        boost::container::small_vector<HandoffSemaphore *, 4> waitedHandoffSemaphores;
+        if (transfer) {
+            // Submissions on the transfer queue signal a handoff semaphore which the next submission on the main queue waits on
+            auto it{ranges::find_if(handoffSemaphores, [](HandoffSemaphore &semaphore) {
+                return !semaphore.pending && (!semaphore.waiterCycle || semaphore.waiterCycle->Poll());
+            })};
+            handoffSemaphore = (it != handoffSemaphores.end()) ? &*it : &handoffSemaphores.emplace_back(gpu.vkDevice);
+            handoffSemaphore->waiterCycle = nullptr;
+            fullSignalSemaphores.push_back(*handoffSemaphore->semaphore);
+        } else {
+            for (auto semaphore : pendingHandoffSemaphores) {
+                fullWaitSemaphores.push_back(*semaphore->semaphore);
+                fullWaitStages.push_back(vk::PipelineStageFlagBits::eAllCommands);
+                waitedHandoffSemaphores.push_back(semaphore);
+            }
+            pendingHandoffSemaphores.clear();
+        }
+
         {
-            std::scoped_lock lock{gpu.queueMutex};
-            gpu.vkQueue.submit(vk::SubmitInfo{
-                .commandBufferCount = 1,
-                .pCommandBuffers = &*commandBuffer,
-                .waitSemaphoreCount = static_cast<u32>(fullWaitSemaphores.size()),
-                .pWaitSemaphores = fullWaitSemaphores.data(),
-                .pWaitDstStageMask = fullWaitStages.data(),
-                .signalSemaphoreCount = static_cast<u32>(fullSignalSemaphores.size()),
-                .pSignalSemaphores = fullSignalSemaphores.data(),
-            }, cycle->fence);
+            std::scoped_lock lock{transfer ? gpu.transferQueueMutex : gpu.queueMutex};
+
+            // The values are assigned with the queue mutex held as the submissions to a queue must signal its timeline in increasing order
+            auto &queueTimeline{transfer ? transferTimeline : timeline};
+            vk::Fence fence{cycle->PrepareSubmit(queueTimeline ? &*queueTimeline : nullptr)};
+
+            boost::container::small_vector<u64, 4> signalValues; //!< The values for all signalled semaphores, these are ignored for binary semaphores
+            if (queueTimeline) {
+                fullSignalSemaphores.push_back(queueTimeline->GetSemaphore());
+                signalValues.resize(fullSignalSemaphores.size());
+                signalValues.back() = cycle->timelineValue.load(std::memory_order_relaxed);
+            }
+
+            vk::StructureChain<vk::SubmitInfo, vk::TimelineSemaphoreSubmitInfo> submitInfo{
+                vk::SubmitInfo{
+                    .commandBufferCount = 1,
+                    .pCommandBuffers = &*commandBuffer,
+                    .waitSemaphoreCount = static_cast<u32>(fullWaitSemaphores.size()),
+                    .pWaitSemaphores = fullWaitSemaphores.data(),
+                    .pWaitDstStageMask = fullWaitStages.data(),
+                    .signalSemaphoreCount = static_cast<u32>(fullSignalSemaphores.size()),
+                    .pSignalSemaphores = fullSignalSemaphores.data(),
+                },
+                vk::TimelineSemaphoreSubmitInfo{
+                    .signalSemaphoreValueCount = static_cast<u32>(signalValues.size()),
+                    .pSignalSemaphoreValues = signalValues.data(),
+                }
+            };
+
+            if (!queueTimeline)
+                submitInfo.unlink<vk::TimelineSemaphoreSubmitInfo>();
+
+            (transfer ? *gpu.vkTransferQueue : gpu.vkQueue).submit(submitInfo.get<vk::SubmitInfo>(), fence);
+        }
+
+        if (handoffSemaphore) {
+            handoffSemaphore->pending = true;
+            pendingHandoffSemaphores.push_back(handoffSemaphore);
+        }
+
+        for (auto semaphore : waitedHandoffSemaphores) {
+            semaphore->pending = false;
+            semaphore->waiterCycle = cycle;
         }
 
         cycle->NotifySubmitted();
@@ -43,12 +43,51 @@ namespace skyline::gpu {
         };
         ThreadLocal<CommandPool> pool;
 
+        std::optional<Timeline> timeline; //!< The timeline of the main queue, all cycles submitted to the main queue are tracked with it when timeline semaphores are supported
+        std::optional<Timeline> transferTimeline; //!< The timeline of the transfer queue, this is separate from the main queue's timeline as values must be signalled in increasing order
         std::thread waiterThread; //!< A thread that waits on and signals FenceCycle(s) then clears any associated resources
         static constexpr size_t FenceCycleWaitCount{256}; //!< The amount of fence cycles the cycle queue can hold
         CircularQueue<std::shared_ptr<FenceCycle>> cycleQueue{FenceCycleWaitCount}; //!< A circular queue containing all the active cycles that can be waited on
 
+        /**
+         * @brief A semaphore signalled by a submission on the transfer queue which the next submission on the main queue waits on, this orders all later work on the main queue after the transfer
+         */
+        struct HandoffSemaphore {
+            vk::raii::Semaphore semaphore;
+            bool pending{}; //!< If the semaphore has been signalled but not yet waited on by a submission on the main queue
+            std::shared_ptr<FenceCycle> waiterCycle; //!< The cycle of the submission on the main queue that waited on the semaphore, the semaphore can only be reused once this is signalled
+
+            HandoffSemaphore(const vk::raii::Device &device);
+        };
+
+        std::mutex handoffMutex; //!< Synchronizes access to the handoff semaphores, this must be locked prior to the queue mutexes
+        std::list<HandoffSemaphore> handoffSemaphores;
+        std::vector<HandoffSemaphore *> pendingHandoffSemaphores; //!< All handoff semaphores which are pending a wait on the main queue
+
         void WaiterThread();
 
+        /**
+         * @brief Submits a command buffer recorded with the supplied function to the main or the transfer queue
+         */
+        template<typename RecordFunction>
+        std::shared_ptr<FenceCycle> SubmitImpl(RecordFunction &recordFunction, span<vk::Semaphore> waitSemaphores, span<vk::Semaphore> signalSemaphores, bool transfer) {
+            auto commandBuffer{AllocateCommandBuffer()};
+            try {
+                commandBuffer->begin(vk::CommandBufferBeginInfo{
+                    .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
+                });
+                recordFunction(*commandBuffer);
+                commandBuffer->end();
+
+                auto cycle{commandBuffer.GetFenceCycle()};
+                SubmitCommandBuffer(*commandBuffer, cycle, waitSemaphores, signalSemaphores, transfer);
+                return cycle;
+            } catch (...) {
+                commandBuffer.GetFenceCycle()->Cancel();
+                std::rethrow_exception(std::current_exception());
+            }
+        }
+
       public:
         /**
          * @brief An active command buffer occupies a slot and ensures that its status is updated correctly
@@ -112,10 +151,11 @@ namespace skyline::gpu {
 
         /**
          * @brief Submits a single command buffer to the GPU queue while queuing it up to be waited on
+         * @param transfer If the command buffer should be submitted on the transfer queue, any later submissions on the main queue will wait on it; this is ignored if there's no transfer queue
          * @note The supplied command buffer and cycle **must** be from AllocateCommandBuffer()
          * @note Any cycle submitted via this method does not need to destroy dependencies manually, the waiter thread will handle this
          */
-        void SubmitCommandBuffer(const vk::raii::CommandBuffer &commandBuffer, std::shared_ptr<FenceCycle> cycle, span<vk::Semaphore> waitSemaphores = {}, span<vk::Semaphore> signalSemaphore = {});
+        void SubmitCommandBuffer(const vk::raii::CommandBuffer &commandBuffer, std::shared_ptr<FenceCycle> cycle, span<vk::Semaphore> waitSemaphores = {}, span<vk::Semaphore> signalSemaphore = {}, bool transfer = false);
 
         /**
          * @brief Submits a command buffer recorded with the supplied function synchronously
@@ -124,21 +164,17 @@ namespace skyline::gpu {
          */
         template<typename RecordFunction>
         std::shared_ptr<FenceCycle> Submit(RecordFunction recordFunction, span<vk::Semaphore> waitSemaphores = {}, span<vk::Semaphore> signalSemaphores = {}) {
-            auto commandBuffer{AllocateCommandBuffer()};
-            try {
-                commandBuffer->begin(vk::CommandBufferBeginInfo{
-                    .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
-                });
-                recordFunction(*commandBuffer);
-                commandBuffer->end();
+            return SubmitImpl(recordFunction, waitSemaphores, signalSemaphores, false);
+        }
 
-                auto cycle{commandBuffer.GetFenceCycle()};
-                SubmitCommandBuffer(*commandBuffer, cycle, waitSemaphores, signalSemaphores);
-                return cycle;
-            } catch (...) {
-                commandBuffer.GetFenceCycle()->Cancel();
-                std::rethrow_exception(std::current_exception());
-            }
+        /**
+         * @brief Submits a command buffer recorded with the supplied function synchronously on the transfer queue if there is one, this allows uploads and readbacks to overlap with rendering
+         * @note All submissions on the main queue after this one will be ordered after it, so no additional synchronization is required for any later usages of the resources it writes
+         * @note The command buffer must not depend on any work on the main queue which hasn't been waited on by the CPU or synchronized with semaphores
+         */
+        template<typename RecordFunction>
+        std::shared_ptr<FenceCycle> SubmitTransfer(RecordFunction recordFunction) {
+            return SubmitImpl(recordFunction, {}, {}, true);
         }
     };
 }
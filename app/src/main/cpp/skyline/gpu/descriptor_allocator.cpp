@@ -150,4 +150,15 @@ namespace skyline::gpu {
             }
         }
     }
+
+    u32 DescriptorAllocator::Trim() {
+        std::scoped_lock allocatorLock{mutex};
+        if ((descriptorSetCount == DescriptorSetCountIncrement && descriptorMultiplier == 1) || pool->freeSetCount != descriptorSetCount)
+            return 0; // The pool is already of the initial size or some of its sets are still in use
+
+        u32 freedSetCount{std::exchange(descriptorSetCount, DescriptorSetCountIncrement)};
+        descriptorMultiplier = 1;
+        AllocateDescriptorPool();
+        return freedSetCount;
+    }
 }
@@ -93,5 +93,11 @@ namespace skyline::gpu {
          * @note The supplied ActiveDescriptorSet **must** stay alive until the descriptor set can be freed, it must not be destroyed after being bound but after any associated commands have completed execution
          */
         ActiveDescriptorSet AllocateSet(vk::DescriptorSetLayout layout);
+
+        /**
+         * @brief Replaces the pool with one of the initial size if it has grown and none of its sets are in use, this frees all the sets cached in it
+         * @return The amount of descriptor sets the freed pool could hold, 0 if the pool was retained
+         */
+        u32 Trim();
     };
 }
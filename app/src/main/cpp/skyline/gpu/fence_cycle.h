@@ -7,14 +7,97 @@
 #include <vulkan/vulkan_raii.hpp>
 #include <common.h>
 #include <common/atomic_forward_list.h>
+#include <common/chunked_list.h>
+#include <common/perf_stats.h>
 
 namespace skyline::gpu {
     class CommandScheduler;
 
+    /**
+     * @brief A timeline semaphore which every submission to a single queue signals with an incrementing value, this allows tracking the completion of all submissions to the queue with a single semaphore rather than a fence per submission
+     * @note Signal operations on a queue complete in submission order, so a value being reached implies that all lower values have been reached as well
+     */
+    class Timeline {
+      private:
+        const vk::raii::Device &device;
+        vk::raii::Semaphore semaphore;
+        u64 submittedValue{}; //!< The value signalled by the latest submission to the queue
+        std::atomic<u64> completedValue{}; //!< A lower bound of the counter value of the semaphore, this is updated whenever the counter value is queried or waited on
+
+        /**
+         * @brief Raises the cached completed value to the supplied value if it's higher
+         */
+        void UpdateCompletedValue(u64 value) {
+            u64 current{completedValue.load(std::memory_order_relaxed)};
+            while (current < value && !completedValue.compare_exchange_weak(current, value, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+      public:
+        Timeline(const vk::raii::Device &device) : device{device}, semaphore{device, vk::StructureChain<vk::SemaphoreCreateInfo, vk::SemaphoreTypeCreateInfo>{
+            {}, vk::SemaphoreTypeCreateInfo{
+                .semaphoreType = vk::SemaphoreType::eTimeline,
+                .initialValue = 0,
+            }}.get<vk::SemaphoreCreateInfo>()} {}
+
+        vk::Semaphore GetSemaphore() const {
+            return *semaphore;
+        }
+
+        /**
+         * @return The value that the next submission to the queue should signal
+         * @note The mutex of the queue **must** be locked prior to calling this and till the submission has been done
+         */
+        u64 AllocateValue() {
+            return ++submittedValue;
+        }
+
+        /**
+         * @param quick Skips querying the counter value of the semaphore, only comparing against the last known value
+         * @return If the counter value of the semaphore has reached the supplied value
+         */
+        bool IsReached(u64 value, bool quick = false) {
+            if (completedValue.load(std::memory_order_acquire) >= value)
+                return true;
+
+            if (quick)
+                return false;
+
+            u64 counterValue{(*device).getSemaphoreCounterValueKHR(*semaphore, *device.getDispatcher())};
+            UpdateCompletedValue(counterValue);
+            return counterValue >= value;
+        }
+
+        /**
+         * @brief Blocks till the counter value of the semaphore has reached the supplied value
+         */
+        void Wait(u64 value) {
+            if (IsReached(value, true))
+                return;
+
+            vk::Semaphore waitSemaphore{*semaphore};
+            vk::SemaphoreWaitInfo waitInfo{
+                .semaphoreCount = 1,
+                .pSemaphores = &waitSemaphore,
+                .pValues = &value,
+            };
+
+            vk::Result waitResult;
+            while ((waitResult = (*device).waitSemaphoresKHR(&waitInfo, std::numeric_limits<u64>::max(), *device.getDispatcher())) != vk::Result::eSuccess) {
+                if (waitResult == vk::Result::eTimeout || waitResult == vk::Result::eErrorInitializationFailed)
+                    continue; // See FenceCycle::Wait for why eErrorInitializationFailed is retried
+
+                throw exception("An error occurred while waiting for timeline semaphore 0x{:X} to reach {}: {}", static_cast<VkSemaphore>(waitSemaphore), value, vk::to_string(waitResult));
+            }
+
+            UpdateCompletedValue(value);
+        }
+    };
+
     /**
      * @brief A wrapper around a Vulkan Fence which only tracks a single reset -> signal cycle with the ability to attach lifetimes of objects to it
      * @note This provides the guarantee that the fence must be signalled prior to destruction when objects are to be destroyed
      * @note All waits to the fence **must** be done through the same instance of this, the state of the fence changing externally will lead to UB
+     * @note If the cycle is submitted to a queue with a timeline, the fence is unused and the cycle is tracked with the value of the timeline signalled by the submission instead
      */
     struct FenceCycle {
       private:
@@ -25,6 +108,8 @@ namespace skyline::gpu {
         std::condition_variable_any submitCondition;
         bool submitted{}; //!< If the fence has been submitted to the GPU
         vk::Fence fence;
+        Timeline *timeline{}; //!< The timeline of the queue the cycle was submitted to, this is only valid once timelineValue is non-zero
+        std::atomic<u64> timelineValue{}; //!< The value of the timeline that the submission of this cycle signals, this is zero if the cycle is tracked with the fence
         vk::Semaphore semaphore; //!< Semaphore that will be signalled upon GPU completion of the fence
         bool semaphoreSubmitWait{}; //!< If the semaphore needs to be waited on (on GPU) before the fence's command buffer begins. Used to ensure fences that wouldn't otherwise be unsignalled are unsignalled
         bool nextSemaphoreSubmitWait{true}; //!< If the next fence cycle created from this one after it's signalled should wait on the semaphore to unsignal it
@@ -32,7 +117,7 @@ namespace skyline::gpu {
 
         friend CommandScheduler;
 
-        AtomicForwardList<std::shared_ptr<void>> dependencies; //!< A list of all dependencies on this fence cycle
+        ChunkedList<std::shared_ptr<void>> dependencies; //!< A list of all dependencies on this fence cycle, these are stored in chunks as there are often hundreds of them per cycle
         AtomicForwardList<std::shared_ptr<FenceCycle>> chainedCycles; //!< A list of all chained FenceCycles, this is used to express multi-fence dependencies
 
         /**
@@ -45,14 +130,12 @@ namespace skyline::gpu {
         }
 
       public:
-        FenceCycle(const vk::raii::Device &device, vk::Fence fence, vk::Semaphore semaphore, bool signalled = false) : signalled{signalled}, device{device}, fence{fence}, semaphore{semaphore}, nextSemaphoreSubmitWait{!signalled} {
-            if (!signalled)
-                device.resetFences(fence);
-        }
+        /**
+         * @note The fence doesn't need to be unsignalled, it is only reset upon submission if the cycle isn't tracked with a timeline
+         */
+        FenceCycle(const vk::raii::Device &device, vk::Fence fence, vk::Semaphore semaphore, bool signalled = false) : signalled{signalled}, device{device}, fence{fence}, semaphore{semaphore}, nextSemaphoreSubmitWait{!signalled} {}
 
-        explicit FenceCycle(const FenceCycle &cycle) : signalled{false}, device{cycle.device}, fence{cycle.fence}, semaphore{cycle.semaphore}, semaphoreSubmitWait{cycle.nextSemaphoreSubmitWait} {
-            device.resetFences(fence);
-        }
+        explicit FenceCycle(const FenceCycle &cycle) : signalled{false}, device{cycle.device}, fence{cycle.fence}, semaphore{cycle.semaphore}, semaphoreSubmitWait{cycle.nextSemaphoreSubmitWait} {}
 
         ~FenceCycle() {
             Wait();
@@ -141,18 +224,24 @@ namespace skyline::gpu {
                 return;
             }
 
-            vk::Result waitResult;
-            while ((waitResult = (*device).waitForFences(1, &fence, false, std::numeric_limits<u64>::max(), *device.getDispatcher())) != vk::Result::eSuccess) {
-                if (waitResult == vk::Result::eTimeout)
-                    // Retry if the waiting time out
-                    continue;
-
-                if (waitResult == vk::Result::eErrorInitializationFailed)
-                    // eErrorInitializationFailed occurs on Mali GPU drivers due to them using the ppoll() syscall which isn't correctly restarted after a signal, we need to manually retry waiting in that case
-                    continue;
-
-                throw exception("An error occurred while waiting for fence 0x{:X}: {}", static_cast<VkFence>(fence), vk::to_string(waitResult));
+            i64 waitStart{util::GetTimeNs()};
+            if (u64 value{timelineValue.load(std::memory_order_acquire)}) {
+                timeline->Wait(value);
+            } else {
+                vk::Result waitResult;
+                while ((waitResult = (*device).waitForFences(1, &fence, false, std::numeric_limits<u64>::max(), *device.getDispatcher())) != vk::Result::eSuccess) {
+                    if (waitResult == vk::Result::eTimeout)
+                        // Retry if the waiting time out
+                        continue;
+
+                    if (waitResult == vk::Result::eErrorInitializationFailed)
+                        // eErrorInitializationFailed occurs on Mali GPU drivers due to them using the ppoll() syscall which isn't correctly restarted after a signal, we need to manually retry waiting in that case
+                        continue;
+
+                    throw exception("An error occurred while waiting for fence 0x{:X}: {}", static_cast<VkFence>(fence), vk::to_string(waitResult));
+                }
             }
+            PerfStats::RecordFenceWait(util::GetTimeNs() - waitStart);
 
             if (semaphoreUnsignalCycle)
                 semaphoreUnsignalCycle->Wait();
@@ -163,7 +252,7 @@ namespace skyline::gpu {
         }
 
         /**
-         * @param quick Skips the call to check the fence's status, just checking the signalled flag
+         * @param quick Skips the call to check the fence's status, just checking the signalled flag and the last known value of the timeline if there is one
          * @return If the fence is signalled currently or not
          */
         bool Poll(bool quick = true, bool shouldDestroy = false) {
@@ -173,8 +262,9 @@ namespace skyline::gpu {
                 return true;
             }
 
-            if (quick)
-                return false; // We need to return early if we're not waiting on the fence
+            u64 value{timelineValue.load(std::memory_order_acquire)};
+            if (quick && (!value || !timeline->IsReached(value, true)))
+                return false; // We need to return early if we're not waiting on the fence, a timeline can be checked without any calls into the driver however
 
             if (!chainedCycles.AllOf([=](auto &cycle) { return cycle->Poll(quick, shouldDestroy); }))
                 return false;
@@ -192,8 +282,8 @@ namespace skyline::gpu {
             if (!submitted)
                 return false;
 
-            auto status{(*device).getFenceStatus(fence, *device.getDispatcher())};
-            if (status == vk::Result::eSuccess) {
+            value = timelineValue.load(std::memory_order_relaxed); // The value is assigned prior to submission, so it's guaranteed to be visible now if the cycle uses a timeline
+            if (value ? timeline->IsReached(value, quick) : (*device).getFenceStatus(fence, *device.getDispatcher()) == vk::Result::eSuccess) {
                 if (semaphoreUnsignalCycle && !semaphoreUnsignalCycle->Poll())
                     return false;
 
@@ -208,10 +298,25 @@ namespace skyline::gpu {
 
         /**
          * @brief Attach the lifetime of an object to the fence being signalled
+         * @note Objects which were attached very recently are not attached again, this is common for views that are used by several consecutive commands
          */
         void AttachObject(const std::shared_ptr<void> &dependency) {
-            if (!signalled.test(std::memory_order_consume))
-                dependencies.Append(dependency);
+            if (!signalled.test(std::memory_order_consume)) {
+                if (dependency)
+                    dependencies.AppendUnique(dependency, 8, [](const std::shared_ptr<void> &a, const std::shared_ptr<void> &b) {
+                        return a == b && !a.owner_before(b) && !b.owner_before(a); // Aliased pointers with a different owner must still be attached
+                    });
+                else
+                    dependencies.Append(dependency); // Null objects may still have a meaningful deleter (See AttachCallback), so they can't be deduplicated
+            }
+        }
+
+        /**
+         * @brief Attaches a callback that is called when the dependencies of the cycle are destroyed after it has been signalled, this is usually done by the cycle waiter thread
+         * @note The callback will be called immediately if the cycle has already been signalled
+         */
+        void AttachCallback(std::function<void()> &&callback) {
+            AttachObject(std::shared_ptr<void>{nullptr, [callback = std::move(callback)](void *) { callback(); }});
         }
 
         /**
@@ -232,6 +337,23 @@ namespace skyline::gpu {
                 chainedCycles.Append(cycle); // If the cycle isn't the current cycle or already signalled, we need to chain it
         }
 
+        /**
+         * @brief Prepares the cycle for being submitted to a queue, this either resets the fence or assigns the value of the supplied timeline which the submission will signal
+         * @param timeline The timeline of the queue the cycle will be submitted to, this is nullable in which case the fence is used
+         * @return The fence that should be signalled by the submission, this is null if a timeline is used
+         * @note The mutex of the queue **must** be locked prior to calling this and till the submission has been done when a timeline is supplied
+         */
+        vk::Fence PrepareSubmit(Timeline *pTimeline) {
+            if (pTimeline) {
+                timeline = pTimeline;
+                timelineValue.store(pTimeline->AllocateValue(), std::memory_order_release);
+                return {};
+            }
+
+            device.resetFences(fence);
+            return fence;
+        }
+
         /**
          * @brief Notifies all waiters that the command buffer associated with this cycle has been submitted
          */
@@ -3,29 +3,61 @@
 
 #include <range/v3/view.hpp>
 #include <common/settings.h>
+#include <common/trace.h>
+#include <common/thread_role.h>
 #include <loader/loader.h>
 #include <gpu.h>
+#include <nce.h>
 #include <dlfcn.h>
 #include "command_executor.h"
 
+extern jint ExecutorSlotCount;
+
 namespace skyline::gpu::interconnect {
     CommandRecordThread::CommandRecordThread(const DeviceState &state)
         : state{state},
           incoming{*state.settings->executorSlotCount},
           outgoing{*state.settings->executorSlotCount},
+          maxSlotCount{std::max<u32>(*state.settings->executorSlotCount, 1)},
+          dynamicSlots{*state.settings->dynamicExecutorSlots},
+          targetSlotCount{dynamicSlots ? std::min(MinimumSlotCount, maxSlotCount) : maxSlotCount},
+          workerCount{*state.settings->recordWorkerCount},
+          workerPool{"Sky-CmdRec", workerCount, thread_role::Role::CommandRecord},
           thread{&CommandRecordThread::Run, this} {}
 
-    static vk::raii::CommandBuffer AllocateRaiiCommandBuffer(GPU &gpu, vk::raii::CommandPool &pool) {
+    static vk::raii::CommandBuffer AllocateRaiiCommandBuffer(GPU &gpu, vk::raii::CommandPool &pool, vk::CommandBufferLevel level = vk::CommandBufferLevel::ePrimary) {
         return {gpu.vkDevice, (*gpu.vkDevice).allocateCommandBuffers(
                     {
                         .commandPool = *pool,
-                        .level = vk::CommandBufferLevel::ePrimary,
+                        .level = level,
                         .commandBufferCount = 1
                     }, *gpu.vkDevice.getDispatcher()).front(),
                 *pool};
     }
 
-    CommandRecordThread::Slot::Slot(GPU &gpu)
+    CommandRecordThread::Slot::SecondaryPool::SecondaryPool(GPU &gpu)
+        : commandPool{gpu.vkDevice,
+                      vk::CommandPoolCreateInfo{
+                          .flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer | vk::CommandPoolCreateFlagBits::eTransient,
+                          .queueFamilyIndex = gpu.vkQueueFamilyIndex
+                      }
+          } {}
+
+    vk::raii::CommandBuffer &CommandRecordThread::Slot::SecondaryPool::AllocateCommandBuffer(GPU &gpu) {
+        if (usedCount == commandBuffers.size())
+            commandBuffers.emplace_back(AllocateRaiiCommandBuffer(gpu, commandPool, vk::CommandBufferLevel::eSecondary));
+        return commandBuffers[usedCount++];
+    }
+
+    CommandRecordThread::Slot::TimestampQueries::TimestampQueries(GPU &gpu)
+        : queryPool{gpu.vkDevice, vk::QueryPoolCreateInfo{
+            .queryType = vk::QueryType::eTimestamp,
+            .queryCount = MaxRegionCount * 2,
+        }} {
+        regionNames.reserve(MaxRegionCount);
+    }
+
+    CommandRecordThread::Slot::Slot(GPU &gpu, size_t secondaryPoolCount)
         : commandPool{gpu.vkDevice,
                       vk::CommandPoolCreateInfo{
                           .flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer | vk::CommandPoolCreateFlagBits::eTransient,
@@ -35,58 +67,344 @@ namespace skyline::gpu::interconnect {
           commandBuffer{AllocateRaiiCommandBuffer(gpu, commandPool)},
           fence{gpu.vkDevice, vk::FenceCreateInfo{ .flags = vk::FenceCreateFlagBits::eSignaled }},
           semaphore{gpu.vkDevice, vk::SemaphoreCreateInfo{}},
-          cycle{std::make_shared<FenceCycle>(gpu.vkDevice, *fence, *semaphore, true)} {}
+          cycle{std::make_shared<FenceCycle>(gpu.vkDevice, *fence, *semaphore, true)} {
+        secondaryPools.reserve(secondaryPoolCount);
+        for (size_t index{}; index < secondaryPoolCount; index++)
+            secondaryPools.emplace_back(gpu);
+
+        if (*gpu.state.settings->gpuTimestampProfiling && gpu.traits.timestampPeriod)
+            timestampQueries.emplace(gpu);
+    }
 
     CommandRecordThread::Slot::Slot(Slot &&other)
         : commandPool{std::move(other.commandPool)},
           commandBuffer{std::move(other.commandBuffer)},
           fence{std::move(other.fence)},
           semaphore{std::move(other.semaphore)},
-          cycle{std::move(other.cycle)} {}
+          cycle{std::move(other.cycle)},
+          secondaryPools{std::move(other.secondaryPools)},
+          timestampQueries{std::move(other.timestampQueries)} {}
 
     std::shared_ptr<FenceCycle> CommandRecordThread::Slot::Reset(GPU &gpu) {
         cycle->Wait();
+        if (timestampQueries)
+            ResolveTimestamps(gpu);
+
         cycle = std::make_shared<FenceCycle>(*cycle);
-        // Command buffer doesn't need to be reset since that's done implicitly by begin
+        // Command buffer doesn't need to be reset since that's done implicitly by begin, the same applies to secondary command buffers which are no longer in use after the cycle has been signalled
+        for (auto &pool : secondaryPools)
+            pool.usedCount = 0;
         return cycle;
     }
 
+    /**
+     * @return The current time in the clock domain used by Perfetto for trace events
+     */
+    static i64 GetTraceTimeNs() {
+        timespec time;
+        clock_gettime(CLOCK_BOOTTIME, &time);
+        return (time.tv_sec * constant::NsInSecond) + time.tv_nsec;
+    }
+
+    void CommandRecordThread::Slot::ResolveTimestamps(GPU &gpu) {
+        auto &queries{*timestampQueries};
+        if (queries.regionNames.empty())
+            return;
+
+        TRACE_EVENT("gpu", "CommandRecordThread::Slot::ResolveTimestamps");
+
+        auto queryCount{static_cast<u32>(queries.regionNames.size() * 2)};
+        auto [result, timestamps]{queries.queryPool.getResults<u64>(0, queryCount, queryCount * sizeof(u64), sizeof(u64), vk::QueryResultFlagBits::e64)};
+        if (result != vk::Result::eSuccess) {
+            Logger::Warn("Failed to retrieve GPU timestamps: {}", vk::to_string(result));
+            queries.regionNames.clear();
+            return;
+        }
+
+        static perfetto::Track gpuTrack{[] {
+            perfetto::Track track{static_cast<u64>(trace::TrackIds::Gpu), perfetto::ProcessTrack::Current()};
+            auto desc{track.Serialize()};
+            desc.set_name("GPU");
+            perfetto::TrackEvent::SetTrackDescriptor(track, desc);
+            return track;
+        }()};
+
+        // GPU timestamps aren't in the same clock domain as the trace, executions are assumed to start on submission unless the GPU was still busy with a prior execution
+        // The GPU track is shared between all executors as the GPU executes their submissions serially
+        static std::mutex gpuTrackMutex;
+        static i64 gpuTrackEndNs{};
+        std::scoped_lock lock{gpuTrackMutex};
+
+        i64 baseNs{std::max(queries.submitTimeNs, gpuTrackEndNs)};
+        u64 baseTimestamp{timestamps.front()};
+        auto toTraceTime{[&](u64 timestamp) {
+            return static_cast<u64>(baseNs + static_cast<i64>(static_cast<double>(timestamp - baseTimestamp) * gpu.traits.timestampPeriod));
+        }};
+
+        u64 executionNs{};
+        for (size_t region{}; region < queries.regionNames.size(); region++) {
+            u64 start{toTraceTime(timestamps[region * 2])}, end{std::max(toTraceTime(timestamps[(region * 2) + 1]), start)};
+            TRACE_EVENT_BEGIN("gpu", perfetto::StaticString{queries.regionNames[region]}, gpuTrack, start);
+            TRACE_EVENT_END("gpu", gpuTrack, end);
+            executionNs += end - start;
+            gpuTrackEndNs = static_cast<i64>(end);
+        }
+
+        TRACE_COUNTER("gpu", "GpuExecutionTimeNs", executionNs);
+        queries.regionNames.clear();
+    }
+
+    void CommandRecordThread::RecordRenderPassRange(Slot *slot, Slot::SecondaryPool &pool, size_t first, size_t stride) {
+        auto &gpu{*state.gpu};
+
+        using namespace node;
+        for (size_t index{first}; index < renderPassRecordings.size(); index += stride) {
+            TRACE_EVENT("gpu", "CommandRecordThread::RecordRenderPass");
+            auto &recording{renderPassRecordings[index]};
+
+            u32 subpassIndex{};
+            vk::raii::CommandBuffer *commandBuffer{};
+            auto beginSubpass{[&] {
+                if (commandBuffer)
+                    commandBuffer->end();
+
+                commandBuffer = &pool.AllocateCommandBuffer(gpu);
+                vk::StructureChain<vk::CommandBufferInheritanceInfo, vk::CommandBufferInheritanceRenderingInfo> inheritanceInfo;
+                if (recording.renderPass) {
+                    auto &info{inheritanceInfo.get<vk::CommandBufferInheritanceInfo>()};
+                    info.renderPass = recording.renderPass;
+                    info.subpass = subpassIndex;
+                    info.framebuffer = recording.renderPassNode->GetFramebuffer();
+                    inheritanceInfo.unlink<vk::CommandBufferInheritanceRenderingInfo>();
+                } else {
+                    // Every subpass is a distinct rendering scope with dynamic rendering, so its attachment formats are inherited instead
+                    inheritanceInfo.get<vk::CommandBufferInheritanceRenderingInfo>() = recording.renderPassNode->GetInheritanceRenderingInfo(subpassIndex);
+                }
+                commandBuffer->begin(vk::CommandBufferBeginInfo{
+                    .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit | vk::CommandBufferUsageFlagBits::eRenderPassContinue,
+                    .pInheritanceInfo = &inheritanceInfo.get<vk::CommandBufferInheritanceInfo>(),
+                });
+                recording.subpassCommandBuffers.push_back(**commandBuffer);
+            }};
+
+            beginSubpass();
+            for (auto it{recording.begin}; it != recording.end; it++) {
+                std::visit(VariantVisitor{
+                    [&](SubpassFunctionNode &node) { node(*commandBuffer, slot->cycle, gpu, recording.renderPass, subpassIndex); },
+
+                    [&](NextSubpassNode &) {
+                        ++subpassIndex;
+                        beginSubpass();
+                    },
+                    [&](NextSubpassFunctionNode &node) {
+                        ++subpassIndex;
+                        beginSubpass();
+                        node.RecordFunction(*commandBuffer, slot->cycle, gpu, recording.renderPass, subpassIndex);
+                    },
+
+                    [](auto &) { throw exception("Unexpected node inside of a render pass"); },
+                }, *it);
+            }
+
+            commandBuffer->end();
+        }
+    }
+
+    bool CommandRecordThread::RecordRenderPasses(Slot *slot) {
+        renderPassRecordings.clear();
+        for (auto it{slot->nodes.begin()}; it != slot->nodes.end(); it++) {
+            if (auto renderPassNode{std::get_if<node::RenderPassNode>(&*it)})
+                renderPassRecordings.push_back(RenderPassRecording{renderPassNode, std::next(it), {}, renderPassNode->Build(*state.gpu)});
+            else if (std::holds_alternative<node::RenderPassEndNode>(*it))
+                renderPassRecordings.back().end = it;
+        }
+
+        // Recording a single render pass on a worker wouldn't overlap with any other recording, so it's recorded inline to avoid the overhead of secondary command buffers
+        if (renderPassRecordings.size() < 2)
+            return false;
+
+        TRACE_EVENT("gpu", "CommandRecordThread::RecordRenderPasses");
+
+        // Render passes are interleaved across the threads to balance out runs of expensive render passes, the calling thread records its share alongside the workers
+        size_t threadCount{std::min<size_t>(workerCount + 1, renderPassRecordings.size())};
+        std::vector<std::future<void>> futures;
+        futures.reserve(threadCount - 1);
+        for (size_t index{1}; index < threadCount; index++)
+            futures.emplace_back(workerPool.Submit([this, slot, index, threadCount] {
+                RecordRenderPassRange(slot, slot->secondaryPools[index], index, threadCount);
+            }));
+
+        // All workers must be done recording before returning even if recording fails on this thread as they reference the slot
+        std::exception_ptr recordException;
+        try {
+            RecordRenderPassRange(slot, slot->secondaryPools.front(), 0, threadCount);
+        } catch (...) {
+            recordException = std::current_exception();
+        }
+
+        for (auto &future : futures)
+            future.wait();
+
+        if (recordException)
+            std::rethrow_exception(recordException);
+
+        for (auto &future : futures)
+            future.get();
+
+        return true;
+    }
+
+    void CommandRecordThread::OptimizeRenderPasses(Slot *slot) {
+        TRACE_EVENT("gpu", "CommandRecordThread::OptimizeRenderPasses");
+
+        using namespace node;
+        auto &nodes{slot->nodes};
+        auto previousBegin{nodes.end()}; //!< The RenderPassNode of the render pass directly preceding the current node, if there is one
+        bool previousEmpty{}; //!< If the previous render pass doesn't record any commands and only has an effect through its load ops
+        for (auto it{nodes.begin()}; it != nodes.end();) {
+            auto renderPassNode{std::get_if<RenderPassNode>(&*it)};
+            if (!renderPassNode) {
+                previousBegin = nodes.end();
+                ++it;
+                continue;
+            }
+
+            auto begin{it}, end{std::next(it)};
+            bool empty{true};
+            for (; !std::holds_alternative<RenderPassEndNode>(*end); ++end)
+                empty &= std::holds_alternative<NextSubpassNode>(*end);
+
+            if (previousBegin != nodes.end()) {
+                auto &previous{std::get<RenderPassNode>(*previousBegin)};
+                if (previousEmpty && renderPassNode->MergeClears(previous)) {
+                    // The previous render pass' commands don't depend on its clears so they can be moved ahead of this render pass
+                    renderPassNode->preRenderPassCommands.insert(renderPassNode->preRenderPassCommands.begin(), std::make_move_iterator(previous.preRenderPassCommands.begin()), std::make_move_iterator(previous.preRenderPassCommands.end()));
+                    nodes.erase(previousBegin, begin); // This erases the RenderPassEndNode of the previous render pass alongside it
+                } else {
+                    previous.DiscardOverwrittenAttachments(*renderPassNode);
+                }
+            }
+
+            previousBegin = begin;
+            previousEmpty = empty;
+            it = std::next(end);
+        }
+
+        if (!*state.settings->discardTransientAttachments)
+            return;
+
+        // Any transient attachment that's loaded by a render pass in this slot will have its count reset prior to its stores being discarded
+        for (auto &node : nodes)
+            if (auto renderPassNode{std::get_if<RenderPassNode>(&node)})
+                renderPassNode->TrackAttachmentClears();
+
+        for (auto &node : nodes)
+            if (auto renderPassNode{std::get_if<RenderPassNode>(&node)})
+                renderPassNode->DiscardTransientAttachments();
+    }
+
     void CommandRecordThread::ProcessSlot(Slot *slot) {
         TRACE_EVENT_FMT("gpu", "ProcessSlot: 0x{:X}, execution: {}", slot, slot->executionNumber);
         auto &gpu{*state.gpu};
 
+        node::RenderPassNode *lRenderPassNode{};
         vk::RenderPass lRenderPass;
         u32 subpassIndex;
 
         std::scoped_lock bufferLock{gpu.buffer.recreationMutex};
+
+        OptimizeRenderPasses(slot);
+
+        // If the render passes were recorded into secondary command buffers, the primary command buffer only needs to execute them in the correct order
+        bool secondaries{IsRecordingParallel() && RecordRenderPasses(slot)};
+        auto recording{renderPassRecordings.begin()};
+        auto executeSubpass{[&] {
+            slot->commandBuffer.executeCommands(recording->subpassCommandBuffers[subpassIndex]);
+        }};
+
+        auto *queries{slot->timestampQueries ? &*slot->timestampQueries : nullptr};
+        if (queries) {
+            queries->regionNames.clear();
+            slot->commandBuffer.resetQueryPool(*queries->queryPool, 0, Slot::TimestampQueries::MaxRegionCount * 2);
+        }
+
+        bool regionActive{}; // If a timestamp was written at the beginning of the current region, regions past the maximum count aren't timed
+        auto beginRegion{[&](const char *name) {
+            if (queries && queries->regionNames.size() < Slot::TimestampQueries::MaxRegionCount) {
+                slot->commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *queries->queryPool, static_cast<u32>(queries->regionNames.size() * 2));
+                queries->regionNames.push_back(name);
+                regionActive = true;
+            }
+        }};
+        auto endRegion{[&] {
+            if (regionActive) {
+                slot->commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *queries->queryPool, static_cast<u32>((queries->regionNames.size() * 2) - 1));
+                regionActive = false;
+            }
+        }};
+
         using namespace node;
         for (NodeVariant &node : slot->nodes) {
-            #define NODE(name) [&](name& node) { node(slot->commandBuffer, slot->cycle, gpu); }
             std::visit(VariantVisitor{
-                NODE(FunctionNode),
+                [&](FunctionNode &node) {
+                    beginRegion("OutsideRpCommand");
+                    node(slot->commandBuffer, slot->cycle, gpu);
+                    endRegion();
+                },
 
                 [&](RenderPassNode &node) {
-                    lRenderPass = node(slot->commandBuffer, slot->cycle, gpu);
+                    beginRegion("RenderPass"); // Any commands that precede the render pass are included in it
+                    lRenderPassNode = &node;
                     subpassIndex = 0;
+                    if (secondaries) {
+                        node(slot->commandBuffer, slot->cycle, gpu, vk::SubpassContents::eSecondaryCommandBuffers);
+                        executeSubpass();
+                    } else {
+                        lRenderPass = node(slot->commandBuffer, slot->cycle, gpu);
+                    }
                 },
 
-                [&](NextSubpassNode &node) {
-                    node(slot->commandBuffer, slot->cycle, gpu);
+                [&](NextSubpassNode &) {
+                    ++subpassIndex;
+                    if (secondaries) {
+                        lRenderPassNode->NextSubpass(slot->commandBuffer, subpassIndex, vk::SubpassContents::eSecondaryCommandBuffers);
+                        executeSubpass();
+                    } else {
+                        lRenderPassNode->NextSubpass(slot->commandBuffer, subpassIndex);
+                    }
+                },
+                [&](SubpassFunctionNode &node) {
+                    if (!secondaries)
+                        node(slot->commandBuffer, slot->cycle, gpu, lRenderPass, subpassIndex);
+                },
+                [&](NextSubpassFunctionNode &node) {
                     ++subpassIndex;
+                    if (secondaries) {
+                        lRenderPassNode->NextSubpass(slot->commandBuffer, subpassIndex, vk::SubpassContents::eSecondaryCommandBuffers);
+                        executeSubpass();
+                    } else {
+                        lRenderPassNode->NextSubpass(slot->commandBuffer, subpassIndex);
+                        node.RecordFunction(slot->commandBuffer, slot->cycle, gpu, lRenderPass, subpassIndex);
+                    }
                 },
-                [&](SubpassFunctionNode &node) { node(slot->commandBuffer, slot->cycle, gpu, lRenderPass, subpassIndex); },
-                [&](NextSubpassFunctionNode &node) { node(slot->commandBuffer, slot->cycle, gpu, lRenderPass, ++subpassIndex); },
 
-                NODE(RenderPassEndNode),
+                [&](RenderPassEndNode &) {
+                    lRenderPassNode->End(slot->commandBuffer);
+                    endRegion();
+                    if (secondaries)
+                        recording++;
+                },
             }, node);
-            #undef NODE
         }
 
         slot->commandBuffer.end();
 
+        if (queries)
+            queries->submitTimeNs = GetTraceTimeNs();
         gpu.scheduler.SubmitCommandBuffer(slot->commandBuffer, slot->cycle);
 
         slot->nodes.clear();
+        slot->nodes.shrink_to_fit(); // The node storage is allocated from the slot's allocator, all of it must be freed prior to resetting it
         slot->allocator.Reset();
     }
 
@@ -100,13 +418,9 @@ namespace skyline::gpu::interconnect {
                 Logger::Warn("Failed to intialise RenderDoc API: {}", ret);
         }
 
-        std::vector<Slot> slots{};
-        std::generate_n(std::back_inserter(slots), *state.settings->executorSlotCount, [&] () -> Slot { return gpu; });
-
-        outgoing.AppendTranform(span<Slot>(slots), [](auto &slot) { return &slot; });
-
         if (int result{pthread_setname_np(pthread_self(), "Sky-CmdRecord")})
             Logger::Warn("Failed to set the thread name: {}", strerror(result));
+        thread_role::Apply(thread_role::Role::CommandRecord);
 
         try {
             signal::SetSignalHandler({SIGINT, SIGILL, SIGTRAP, SIGBUS, SIGFPE, SIGSEGV}, signal::ExceptionalSignalHandler);
@@ -139,8 +453,74 @@ namespace skyline::gpu::interconnect {
         }
     }
 
+    void CommandRecordThread::TuneSlotCount(i64 waitNs, bool pending) {
+        windowWaitNs += waitNs;
+        windowSlotPending |= pending;
+        if (++windowAcquireCount < TuningWindowSize)
+            return;
+
+        auto &gpu{*state.gpu};
+        i64 now{util::GetTimeNs()};
+        if (gpu.texture.IsOverBudget()) {
+            // Slots retain the resources of their executions till they're reused, so we shrink down to the minimum while under memory pressure
+            if (targetSlotCount > MinimumSlotCount)
+                targetSlotCount--;
+            idleWindowCount = 0;
+        } else if (windowStartNs && windowWaitNs * GrowWaitFraction > now - windowStartNs) {
+            if (targetSlotCount < maxSlotCount)
+                targetSlotCount++;
+            idleWindowCount = 0;
+        } else if (!windowWaitNs && !windowSlotPending) {
+            // Every slot was idle by the time it was reused, the GPU completion latency is lower than what the current slot count can hide
+            if (++idleWindowCount >= ShrinkWindowCount && targetSlotCount > MinimumSlotCount) {
+                targetSlotCount--;
+                idleWindowCount = 0;
+            }
+        } else {
+            idleWindowCount = 0;
+        }
+
+        windowStartNs = now;
+        windowWaitNs = 0;
+        windowAcquireCount = 0;
+        windowSlotPending = false;
+
+        ExecutorSlotCount = static_cast<jint>(targetSlotCount);
+        TRACE_COUNTER("gpu", "ExecutorSlotCount", targetSlotCount);
+    }
+
     CommandRecordThread::Slot *CommandRecordThread::AcquireSlot() {
-        return outgoing.Pop();
+        TRACE_EVENT("gpu", "CommandRecordThread::AcquireSlot");
+
+        while (true) {
+            u32 slotCount{std::min(targetSlotCount, state.gpu->governor.GetSlotCountLimit())}; //!< The governor may limit the slot count under thermal pressure
+            Slot *slot{};
+            if (!outgoing.TryPop(slot)) {
+                if (slots.size() < slotCount) {
+                    ExecutorSlotCount = static_cast<jint>(targetSlotCount);
+                    return &slots.emplace_back(*state.gpu, workerCount ? workerCount + 1 : 0); // New slots are created with a signalled cycle, so they can be used immediately
+                }
+            }
+
+            // Any time spent waiting here is either due to the record thread or the GPU lagging behind, both of which may be hidden by more slots
+            i64 waitStartNs{util::GetTimeNs()};
+            bool blocked{!slot};
+            if (blocked)
+                slot = outgoing.Pop();
+
+            bool pending{!slot->cycle->Poll(false)};
+            if (pending)
+                slot->cycle->Wait();
+
+            if (dynamicSlots)
+                TuneSlotCount(blocked || pending ? util::GetTimeNs() - waitStartNs : 0, pending);
+
+            if (slots.size() <= slotCount)
+                return slot;
+
+            // The slot is idle, so it can be freed to shrink down to the target slot count
+            slots.remove_if([slot](const Slot &it) { return &it == slot; });
+        }
     }
 
     void CommandRecordThread::ReleaseSlot(Slot *slot) {
@@ -172,6 +552,12 @@ namespace skyline::gpu::interconnect {
         allocator = &slot->allocator;
     }
 
+    bool CommandExecutor::SubpassAttachmentsMatch(span<TextureView *> inputAttachments, span<TextureView *> colorAttachments, TextureView *depthStencilAttachment) {
+        return ranges::equal(lastSubpassInputAttachments, inputAttachments) &&
+            ranges::equal(lastSubpassColorAttachments, colorAttachments) &&
+            lastSubpassDepthStencilAttachment == depthStencilAttachment;
+    }
+
     bool CommandExecutor::CreateRenderPassWithSubpass(vk::Rect2D renderArea, span<TextureView *> inputAttachments, span<TextureView *> colorAttachments, TextureView *depthStencilAttachment, bool noSubpassCreation) {
         auto addSubpass{[&] {
             renderPass->AddSubpass(inputAttachments, colorAttachments, depthStencilAttachment, gpu);
@@ -193,11 +579,10 @@ namespace skyline::gpu::interconnect {
             lastSubpassInputAttachments = rangeToSpan(inputAttachmentRange);
             lastSubpassColorAttachments = rangeToSpan(colorAttachmentRange);
             lastSubpassDepthStencilAttachment = depthStencilAttachment;
+            subpassSequence++;
         }};
 
-        bool attachmentsMatch{ranges::equal(lastSubpassInputAttachments, inputAttachments) &&
-                              ranges::equal(lastSubpassColorAttachments, colorAttachments) &&
-                              lastSubpassDepthStencilAttachment == depthStencilAttachment};
+        bool attachmentsMatch{SubpassAttachmentsMatch(inputAttachments, colorAttachments, depthStencilAttachment)};
 
         if (renderPass == nullptr || renderPass->renderArea != renderArea ||
             ((noSubpassCreation || subpassCount >= gpu.traits.quirks.maxSubpassCount) && !attachmentsMatch)) {
@@ -250,6 +635,7 @@ namespace skyline::gpu::interconnect {
 
     bool CommandExecutor::AttachTexture(TextureView *view) {
         bool didLock{view->LockWithTag(tag)};
+        view->texture->modificationCounter++;
         if (didLock) {
             // TODO: fixup remaining bugs with this and add better heuristics to avoid pauses
             // if (view->texture->FrequentlyLocked())
@@ -309,21 +695,6 @@ namespace skyline::gpu::interconnect {
         cycle->AttachObject(dependency);
     }
 
-    void CommandExecutor::AddSubpass(std::function<void(vk::raii::CommandBuffer &, const std::shared_ptr<FenceCycle> &, GPU &, vk::RenderPass, u32)> &&function, vk::Rect2D renderArea, span<TextureView *> inputAttachments, span<TextureView *> colorAttachments, TextureView *depthStencilAttachment, bool noSubpassCreation) {
-        bool gotoNext{CreateRenderPassWithSubpass(renderArea, inputAttachments, colorAttachments, depthStencilAttachment ? &*depthStencilAttachment : nullptr, noSubpassCreation)};
-        if (gotoNext)
-            slot->nodes.emplace_back(std::in_place_type_t<node::NextSubpassFunctionNode>(), std::forward<decltype(function)>(function));
-        else
-            slot->nodes.emplace_back(std::in_place_type_t<node::SubpassFunctionNode>(), std::forward<decltype(function)>(function));
-    }
-
-    void CommandExecutor::AddOutsideRpCommand(std::function<void(vk::raii::CommandBuffer &, const std::shared_ptr<FenceCycle> &, GPU &)> &&function) {
-        if (renderPass)
-            FinishRenderPass();
-
-        slot->nodes.emplace_back(std::in_place_type_t<node::FunctionNode>(), std::forward<decltype(function)>(function));
-    }
-
     void CommandExecutor::AddClearColorSubpass(TextureView *attachment, const vk::ClearColorValue &value) {
         bool gotoNext{CreateRenderPassWithSubpass(vk::Rect2D{.extent = attachment->texture->dimensions}, {}, attachment, nullptr)};
         if (renderPass->ClearColorAttachment(0, value, gpu)) {
@@ -343,9 +714,9 @@ namespace skyline::gpu::interconnect {
             }};
 
             if (gotoNext)
-                slot->nodes.emplace_back(std::in_place_type_t<node::NextSubpassFunctionNode>(), function);
+                slot->nodes.emplace_back(std::in_place_type_t<node::NextSubpassFunctionNode>(), *allocator, function);
             else
-                slot->nodes.emplace_back(std::in_place_type_t<node::SubpassFunctionNode>(), function);
+                slot->nodes.emplace_back(std::in_place_type_t<node::SubpassFunctionNode>(), *allocator, function);
         }
     }
 
@@ -367,12 +738,20 @@ namespace skyline::gpu::interconnect {
             }};
 
             if (gotoNext)
-                slot->nodes.emplace_back(std::in_place_type_t<node::NextSubpassFunctionNode>(), function);
+                slot->nodes.emplace_back(std::in_place_type_t<node::NextSubpassFunctionNode>(), *allocator, function);
             else
-                slot->nodes.emplace_back(std::in_place_type_t<node::SubpassFunctionNode>(), function);
+                slot->nodes.emplace_back(std::in_place_type_t<node::SubpassFunctionNode>(), *allocator, function);
         }
     }
 
+    bool CommandExecutor::NeedsStateReset(u32 sequence, vk::Rect2D renderArea, span<TextureView *> inputAttachments, span<TextureView *> colorAttachments, TextureView *depthStencilAttachment) {
+        if (!recordThread.IsRecordingParallel())
+            return false;
+
+        // A new subpass is begun for any commands which can't be added to the current subpass, regardless of if it's in a new render pass or not
+        return sequence != subpassSequence || renderPass == nullptr || renderPass->renderArea != renderArea || !SubpassAttachmentsMatch(inputAttachments, colorAttachments, depthStencilAttachment);
+    }
+
     void CommandExecutor::AddFlushCallback(std::function<void()> &&callback) {
         flushCallbacks.emplace_back(std::forward<decltype(callback)>(callback));
     }
@@ -387,6 +766,30 @@ namespace skyline::gpu::interconnect {
     }
 
     void CommandExecutor::SubmitInternal() {
+        // Buffers that are frequently read back by the CPU are copied into host cached memory after all other commands, the CPU read then usually finds the data already landed rather than reading the uncached backing after waiting on the GPU
+        boost::container::small_vector<std::pair<vk::Buffer, std::shared_ptr<memory::StagingBuffer>>, 4> readbacks;
+        for (const auto &attachedBuffer : ranges::views::concat(attachedBuffers, preserveAttachedBuffers))
+            if (auto stagingBuffer{attachedBuffer->PrepareAsyncReadback(cycle)})
+                readbacks.emplace_back(attachedBuffer->GetBacking(), std::move(stagingBuffer));
+
+        if (!readbacks.empty())
+            AddOutsideRpCommand([readbacks = std::move(readbacks)](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &pCycle, GPU &) {
+                commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eTransfer, {}, vk::MemoryBarrier{
+                    .srcAccessMask = vk::AccessFlagBits::eMemoryWrite,
+                    .dstAccessMask = vk::AccessFlagBits::eTransferRead,
+                }, {}, {});
+
+                for (const auto &[backing, stagingBuffer] : readbacks) {
+                    commandBuffer.copyBuffer(backing, stagingBuffer->vkBuffer, vk::BufferCopy{.size = stagingBuffer->size()});
+                    pCycle->AttachObject(stagingBuffer);
+                }
+
+                commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, vk::MemoryBarrier{
+                    .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+                    .dstAccessMask = vk::AccessFlagBits::eHostRead,
+                }, {}, {});
+            });
+
         if (renderPass)
             FinishRenderPass();
 
@@ -440,19 +843,28 @@ namespace skyline::gpu::interconnect {
         }
     }
 
-    void CommandExecutor::Submit() {
-        for (const auto &callback : flushCallbacks)
-            callback();
+    void CommandExecutor::Submit(std::function<void()> &&callback) {
+        for (const auto &flushCallback : flushCallbacks)
+            flushCallback();
 
         executionNumber++;
 
         if (!slot->nodes.empty()) {
             TRACE_EVENT("gpu", "CommandExecutor::Submit");
+            lastSubmittedCycle = cycle;
+            if (callback)
+                cycle->AttachCallback(std::move(callback));
             SubmitInternal();
             submissionNumber++;
+        } else if (callback) {
+            if (lastSubmittedCycle)
+                lastSubmittedCycle->AttachCallback(std::move(callback));
+            else
+                callback();
         }
 
         ResetInternal();
+        state.nce->FlushDeferredReprotects();
     }
 
     void CommandExecutor::LockPreserve() {
@@ -3,9 +3,13 @@
 
 #pragma once
 
+#include <deque>
+#include <list>
 #include <boost/container/stable_vector.hpp>
 #include <renderdoc_app.h>
 #include <common/linear_allocator.h>
+#include <common/spsc_queue.h>
+#include <common/thread_pool.h>
 #include <gpu/megabuffer.h>
 #include "command_nodes.h"
 
@@ -15,21 +19,53 @@ namespace skyline::gpu::interconnect {
      */
     class CommandRecordThread {
       public:
+        using NodeList = boost::container::stable_vector<node::NodeVariant, LinearAllocator<node::NodeVariant>>;
+
         /**
          * @brief Single execution slot, buffered back and forth between the GPFIFO thread and the record thread
          */
         struct Slot {
+            /**
+             * @brief A command pool for secondary command buffers that is only ever recorded into by a single thread at a time, command pools can't be accessed by multiple threads concurrently
+             */
+            struct SecondaryPool {
+                vk::raii::CommandPool commandPool;
+                std::deque<vk::raii::CommandBuffer> commandBuffers; //!< A deque is used as references to the command buffers must remain valid while more are allocated
+                size_t usedCount{}; //!< The amount of command buffers that have been used in the current execution
+
+                SecondaryPool(GPU &gpu);
+
+                /**
+                 * @return A command buffer that is unused in the current execution, a new command buffer is allocated if there are none
+                 */
+                vk::raii::CommandBuffer &AllocateCommandBuffer(GPU &gpu);
+            };
+
+            /**
+             * @brief GPU timestamp queries written around the top-level commands of a slot, these are resolved into trace events after the slot's cycle has been signalled
+             */
+            struct TimestampQueries {
+                static constexpr u32 MaxRegionCount{256}; //!< The maximum amount of regions that are timed in a single execution, any further regions aren't timed
+                vk::raii::QueryPool queryPool;
+                std::vector<const char *> regionNames; //!< The name of every region timed in the current execution, region N spans queries 2N and 2N + 1
+                i64 submitTimeNs{}; //!< The trace clock time at which the slot was submitted, the GPU can't start executing it any earlier
+
+                TimestampQueries(GPU &gpu);
+            };
+
             vk::raii::CommandPool commandPool; //!< Use one command pool per slot since command buffers from different slots may be recorded into on multiple threads at the same time
             vk::raii::CommandBuffer commandBuffer;
             vk::raii::Fence fence;
             vk::raii::Semaphore semaphore;
             std::shared_ptr<FenceCycle> cycle;
-            boost::container::stable_vector<node::NodeVariant> nodes;
             LinearAllocatorState<> allocator;
+            NodeList nodes{allocator}; //!< The nodes of the execution, these are allocated from the slot's allocator alongside their captured state
             u32 executionNumber;
             bool capture{}; //!< If this slot's Vulkan commands should be captured using the renderdoc API
+            std::vector<SecondaryPool> secondaryPools; //!< A pool for each thread that records render passes in parallel, this is empty when parallel recording is disabled
+            std::optional<TimestampQueries> timestampQueries; //!< Only present when GPU timestamp profiling is enabled and supported by the device
 
-            Slot(GPU &gpu);
+            Slot(GPU &gpu, size_t secondaryPoolCount);
 
             Slot(Slot &&other);
 
@@ -38,17 +74,77 @@ namespace skyline::gpu::interconnect {
              * @note A new fence cycle for the reset command buffer
              */
             std::shared_ptr<FenceCycle> Reset(GPU &gpu);
+
+            /**
+             * @brief Emits the GPU execution times of all timed regions in the last execution as trace events on the GPU track
+             * @note The slot's cycle **must** be signalled prior to calling this
+             */
+            void ResolveTimestamps(GPU &gpu);
         };
 
       private:
+        /**
+         * @brief The nodes of a single render pass alongside the secondary command buffers its subpasses were recorded into
+         */
+        struct RenderPassRecording {
+            node::RenderPassNode *renderPassNode;
+            NodeList::iterator begin; //!< An iterator to the first node inside the render pass
+            NodeList::iterator end; //!< An iterator to the RenderPassEndNode of the render pass
+            vk::RenderPass renderPass;
+            std::vector<vk::CommandBuffer> subpassCommandBuffers; //!< A secondary command buffer for every subpass, in the order they are executed in
+        };
+
         const DeviceState &state;
-        CircularQueue<Slot *> incoming; //!< Slots pending recording
-        CircularQueue<Slot *> outgoing; //!< Slots that have been submitted, may still be active on the GPU
+        SpscQueue<Slot *> incoming; //!< Slots pending recording, these are only pushed by the thread that owns the executor
+        SpscQueue<Slot *> outgoing; //!< Slots that have been submitted, may still be active on the GPU, these are only pushed by the record thread
+
+        static constexpr u32 MinimumSlotCount{2}; //!< The minimum amount of slots when they're dynamically tuned, one is required for the execution being built and another for the one being recorded or executed
+        static constexpr u32 TuningWindowSize{64}; //!< The amount of slot acquisitions over which waits are measured before the slot count is tuned
+        static constexpr i64 GrowWaitFraction{20}; //!< The slot count is grown if more than 1/N of a tuning window's duration was spent waiting on slots
+        static constexpr u32 ShrinkWindowCount{8}; //!< The amount of consecutive tuning windows without any waits on slots that are required to shrink the slot count
+
+        std::list<Slot> slots; //!< All slots that are currently allocated, this is only modified inside AcquireSlot
+        u32 maxSlotCount; //!< The maximum amount of slots that can be allocated
+        bool dynamicSlots; //!< If the slot count is tuned at runtime, the maximum amount of slots are always allocated otherwise
+        u32 targetSlotCount; //!< The amount of slots that should be allocated, slots are allocated or freed on acquisition till this is reached
+        i64 windowStartNs{}; //!< The timestamp of the start of the current tuning window
+        i64 windowWaitNs{}; //!< The total time spent waiting on slots during the current tuning window
+        u32 windowAcquireCount{}; //!< The amount of slot acquisitions during the current tuning window
+        bool windowSlotPending{}; //!< If any slot was still pending on the GPU upon acquisition during the current tuning window
+        u32 idleWindowCount{}; //!< The amount of consecutive tuning windows without any waits on slots
+
+        u32 workerCount; //!< The amount of worker threads that render passes are recorded on in parallel alongside the record thread, parallel recording is disabled if this is 0
+        ThreadPool workerPool;
+        std::vector<RenderPassRecording> renderPassRecordings; //!< All render passes in the slot being processed, this is retained across slots to avoid reallocations
 
         std::thread thread;
 
+        /**
+         * @brief Records every render pass in the supplied slot into secondary command buffers, these are spread across the worker threads and the calling thread
+         * @return If the render passes were recorded into secondary command buffers, the nodes are recorded inline if there aren't enough render passes for this to be beneficial
+         */
+        bool RecordRenderPasses(Slot *slot);
+
+        /**
+         * @brief Records every render pass in the supplied range with a stride into secondary command buffers allocated from the supplied pool
+         */
+        void RecordRenderPassRange(Slot *slot, Slot::SecondaryPool &pool, size_t first, size_t stride);
+
+        /**
+         * @brief Optimizes the load and store operations of consecutive render passes in the supplied slot, render passes that only clear attachments are merged into the following render pass when possible
+         * @note This must be called prior to any render passes in the slot being built
+         */
+        void OptimizeRenderPasses(Slot *slot);
+
         void ProcessSlot(Slot *slot);
 
+        /**
+         * @brief Adjusts the target slot count based on the time spent waiting on slots and the GPU completion latency over a window of acquisitions
+         * @param waitNs The time spent waiting on the record thread and the GPU for the acquired slot
+         * @param pending If the acquired slot was still pending on the GPU, this implies the GPU completion latency exceeds the time it takes to cycle through all slots
+         */
+        void TuneSlotCount(i64 waitNs, bool pending);
+
         void Run();
 
       public:
@@ -56,13 +152,23 @@ namespace skyline::gpu::interconnect {
 
         /**
          * @return A free slot, `Reset` needs to be called before accessing it
+         * @note Slots are allocated or freed here to match the target slot count
+         * @note This **must** only be called from the thread that owns the executor
          */
         Slot *AcquireSlot();
 
         /**
          * @brief Submit a slot to be recorded
+         * @note This **must** only be called from the thread that owns the executor
          */
         void ReleaseSlot(Slot *slot);
+
+        /**
+         * @return If subpasses are recorded into separate secondary command buffers, no command buffer state is inherited between subpasses in this case
+         */
+        bool IsRecordingParallel() const {
+            return workerCount;
+        }
     };
 
     /**
@@ -77,6 +183,7 @@ namespace skyline::gpu::interconnect {
         CommandRecordThread::Slot *slot{};
         node::RenderPassNode *renderPass{};
         size_t subpassCount{}; //!< The number of subpasses in the current render pass
+        u32 subpassSequence{}; //!< A counter that is incremented whenever a subpass is begun
         bool preserveLocked{};
 
         /**
@@ -130,6 +237,11 @@ namespace skyline::gpu::interconnect {
 
         void RotateRecordSlot();
 
+        /**
+         * @return If the supplied attachments are the same as the attachments of the last subpass
+         */
+        bool SubpassAttachmentsMatch(span<TextureView *> inputAttachments, span<TextureView *> colorAttachments, TextureView *depthStencilAttachment);
+
         /**
          * @brief Create a new render pass and subpass with the specified attachments, if one doesn't already exist or the current one isn't compatible
          * @param noSubpassCreation Forces creation of a renderpass when a new subpass would otherwise be created
@@ -158,6 +270,7 @@ namespace skyline::gpu::interconnect {
 
       public:
         std::shared_ptr<FenceCycle> cycle; //!< The fence cycle that this command executor uses to wait for the GPU to finish executing commands
+        std::shared_ptr<FenceCycle> lastSubmittedCycle; //!< The cycle of the last submission, callbacks for submissions without any work are attached to this as host GPU work of prior submissions may still be pending
         LinearAllocatorState<> *allocator;
         ContextTag tag; //!< The tag associated with this command executor, any tagged resource locking must utilize this tag
         size_t submissionNumber{};
@@ -210,7 +323,35 @@ namespace skyline::gpu::interconnect {
          * @param exclusiveSubpass If this subpass should be the only subpass in a render pass
          * @note Any supplied texture should be attached prior and not undergo any persistent layout transitions till execution
          */
-        void AddSubpass(std::function<void(vk::raii::CommandBuffer &, const std::shared_ptr<FenceCycle> &, GPU &, vk::RenderPass, u32)> &&function, vk::Rect2D renderArea, span<TextureView *> inputAttachments = {}, span<TextureView *> colorAttachments = {}, TextureView *depthStencilAttachment = {}, bool noSubpassCreation = false);
+        template<typename Function>
+        void AddSubpass(Function &&function, vk::Rect2D renderArea, span<TextureView *> inputAttachments = {}, span<TextureView *> colorAttachments = {}, TextureView *depthStencilAttachment = {}, bool noSubpassCreation = false) {
+            bool gotoNext{CreateRenderPassWithSubpass(renderArea, inputAttachments, colorAttachments, depthStencilAttachment, noSubpassCreation)};
+            if (gotoNext)
+                slot->nodes.emplace_back(std::in_place_type_t<node::NextSubpassFunctionNode>(), *allocator, std::forward<Function>(function));
+            else
+                slot->nodes.emplace_back(std::in_place_type_t<node::SubpassFunctionNode>(), *allocator, std::forward<Function>(function));
+        }
+
+        /**
+         * @return A number identifying the current subpass, this changes whenever a new subpass is begun
+         */
+        u32 GetSubpassSequence() const {
+            return subpassSequence;
+        }
+
+        /**
+         * @return A number identifying the latest command in the current execution, this changes whenever any command is added
+         * @note This is only unique within an execution and must be paired with the execution number for comparisons across executions
+         */
+        size_t GetCommandSequence() const {
+            return slot->nodes.size();
+        }
+
+        /**
+         * @return If the command buffer state that was recorded during the subpass with the supplied sequence number would be unavailable to commands added with AddSubpass using the supplied attachments, all state must be recorded again in this case
+         * @note This can only be true when recording is parallelised as subpasses are recorded into separate secondary command buffers which don't inherit any state
+         */
+        bool NeedsStateReset(u32 sequence, vk::Rect2D renderArea, span<TextureView *> inputAttachments = {}, span<TextureView *> colorAttachments = {}, TextureView *depthStencilAttachment = {});
 
         /**
          * @brief Adds a subpass that clears the entirety of the specified attachment with a color value, it may utilize VK_ATTACHMENT_LOAD_OP_CLEAR for a more efficient clear when possible
@@ -227,7 +368,25 @@ namespace skyline::gpu::interconnect {
         /**
          * @brief Adds a command that needs to be executed outside the scope of a render pass
          */
-        void AddOutsideRpCommand(std::function<void(vk::raii::CommandBuffer &, const std::shared_ptr<FenceCycle> &, GPU &)> &&function);
+        template<typename Function>
+        void AddOutsideRpCommand(Function &&function) {
+            if (renderPass)
+                FinishRenderPass();
+
+            slot->nodes.emplace_back(std::in_place_type_t<node::FunctionNode>(), *allocator, std::forward<Function>(function));
+        }
+
+        /**
+         * @brief Adds a command that needs to be executed outside the scope of a render pass without ending the active render pass, it's recorded prior to the active render pass if there is one
+         * @note The command must not depend on the results of any prior commands inside the active render pass
+         */
+        template<typename Function>
+        void AddPreRenderPassCommand(Function &&function) {
+            if (renderPass)
+                renderPass->preRenderPassCommands.emplace_back(*allocator, std::forward<Function>(function));
+            else
+                slot->nodes.emplace_back(std::in_place_type_t<node::FunctionNode>(), *allocator, std::forward<Function>(function));
+        }
 
         /**
          * @brief Adds a persistent callback that will be called at the start of Execute in order to flush data required for recording
@@ -246,8 +405,9 @@ namespace skyline::gpu::interconnect {
 
         /**
          * @brief Execute all the nodes and submit the resulting command buffer to the GPU
+         * @param callback An optional callback that will be called once the GPU has finished executing all work submitted up to this point, this is done asynchronously from the cycle waiter thread
          */
-        void Submit();
+        void Submit(std::function<void()> &&callback = {});
 
         /**
          * @brief Locks all preserve attached buffers/textures
@@ -24,6 +24,7 @@ namespace skyline::gpu::interconnect::node {
         if (attachment == attachments.end()) {
             // If we cannot find any matches for the specified attachment, we add it as a new one
             attachments.push_back(vkView);
+            attachmentTextures.push_back(view->texture.get());
 
             if (gpu.traits.supportsImagelessFramebuffers)
                 attachmentInfo.push_back(vk::FramebufferAttachmentImageInfo{
@@ -207,7 +208,182 @@ namespace skyline::gpu::interconnect::node {
         return false;
     }
 
-    vk::RenderPass RenderPassNode::operator()(vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &gpu) {
+    bool RenderPassNode::ContainsRenderArea(const vk::Rect2D &area) const {
+        return renderArea.offset.x <= area.offset.x && renderArea.offset.y <= area.offset.y &&
+            renderArea.offset.x + static_cast<i64>(renderArea.extent.width) >= area.offset.x + static_cast<i64>(area.extent.width) &&
+            renderArea.offset.y + static_cast<i64>(renderArea.extent.height) >= area.offset.y + static_cast<i64>(area.extent.height);
+    }
+
+    bool RenderPassNode::MergeClears(const RenderPassNode &previous) {
+        // A load op clear only applies to the render area, so it must cover everything the previous render pass cleared
+        if (!ContainsRenderArea(previous.renderArea))
+            return false;
+
+        // All attachments must be checked before any are modified as the merge can't be partially done
+        for (size_t index{}; index < previous.attachments.size(); index++) {
+            const auto &description{previous.attachmentDescriptions[index]};
+            if (description.loadOp != vk::AttachmentLoadOp::eClear && description.stencilLoadOp != vk::AttachmentLoadOp::eClear)
+                continue; // The attachment is loaded and stored as-is so it can be dropped
+
+            auto attachment{std::find(attachments.begin(), attachments.end(), previous.attachments[index])};
+            if (attachment == attachments.end())
+                return false; // The attachment isn't used by this render pass, so the clear has to be done by the previous one
+        }
+
+        for (size_t index{}; index < previous.attachments.size(); index++) {
+            const auto &previousDescription{previous.attachmentDescriptions[index]};
+            auto attachmentIndex{static_cast<size_t>(std::distance(attachments.begin(), std::find(attachments.begin(), attachments.end(), previous.attachments[index])))};
+            if (attachmentIndex == attachments.size())
+                continue;
+
+            // Any clear in this render pass overwrites the previous clear entirely, so only loads need to be replaced
+            auto &description{attachmentDescriptions[attachmentIndex]};
+            bool merged{};
+            if (previousDescription.loadOp == vk::AttachmentLoadOp::eClear && description.loadOp == vk::AttachmentLoadOp::eLoad) {
+                description.loadOp = vk::AttachmentLoadOp::eClear;
+                merged = true;
+            }
+            if (previousDescription.stencilLoadOp == vk::AttachmentLoadOp::eClear && description.stencilLoadOp == vk::AttachmentLoadOp::eLoad) {
+                description.stencilLoadOp = vk::AttachmentLoadOp::eClear;
+                merged = true;
+            }
+
+            if (merged) {
+                if (clearValues.size() <= attachmentIndex)
+                    clearValues.resize(attachmentIndex + 1);
+                clearValues[attachmentIndex] = previous.clearValues[index];
+            }
+        }
+
+        return true;
+    }
+
+    void RenderPassNode::DiscardOverwrittenAttachments(const RenderPassNode &next) {
+        // Attachments can only be written inside the render area, the contents outside of it must be preserved unless the next render pass clears them too
+        if (!next.ContainsRenderArea(renderArea))
+            return;
+
+        for (size_t index{}; index < attachments.size(); index++) {
+            auto attachment{std::find(next.attachments.begin(), next.attachments.end(), attachments[index])};
+            if (attachment == next.attachments.end())
+                continue;
+
+            const auto &nextDescription{next.attachmentDescriptions[static_cast<size_t>(std::distance(next.attachments.begin(), attachment))]};
+            auto &description{attachmentDescriptions[index]};
+            if (nextDescription.loadOp == vk::AttachmentLoadOp::eClear)
+                description.storeOp = vk::AttachmentStoreOp::eDontCare;
+            if (nextDescription.stencilLoadOp == vk::AttachmentLoadOp::eClear)
+                description.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+        }
+    }
+
+    void RenderPassNode::TrackAttachmentClears() {
+        // Any clears are limited to the render area, so they need to cover the entire attachment for none of its prior contents to be observable
+        bool coversAttachments{renderArea.offset.x == 0 && renderArea.offset.y == 0};
+        for (size_t index{}; index < attachments.size(); index++) {
+            auto texture{attachmentTextures[index]};
+            auto aspect{texture->format->vkAspect};
+            if (!(aspect & (vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil)))
+                continue;
+
+            const auto &description{attachmentDescriptions[index]};
+            bool cleared{coversAttachments && renderArea.extent.width >= texture->dimensions.width && renderArea.extent.height >= texture->dimensions.height &&
+                         (!(aspect & vk::ImageAspectFlagBits::eDepth) || description.loadOp == vk::AttachmentLoadOp::eClear) &&
+                         (!(aspect & vk::ImageAspectFlagBits::eStencil) || description.stencilLoadOp == vk::AttachmentLoadOp::eClear)};
+            if (cleared)
+                texture->clearedRenderPassCount.fetch_add(1, std::memory_order_relaxed);
+            else
+                texture->clearedRenderPassCount.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void RenderPassNode::DiscardTransientAttachments() {
+        for (size_t index{}; index < attachments.size(); index++) {
+            if (!attachmentTextures[index]->IsTransientAttachment())
+                continue;
+
+            auto &description{attachmentDescriptions[index]};
+            description.storeOp = vk::AttachmentStoreOp::eDontCare;
+            description.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+        }
+    }
+
+    void RenderPassNode::BuildRenderingSubpasses() {
+        // The load and store ops of an attachment apply to the render pass as a whole, so they're only used by the first and last subpass that reference it respectively
+        auto subpassCount{static_cast<u32>(subpassDescriptions.size())};
+        std::vector<u32> firstUsage(attachments.size(), subpassCount), lastUsage(attachments.size());
+        auto trackUsage{[&](const vk::AttachmentReference &reference, u32 subpass) {
+            if (reference.attachment != VK_ATTACHMENT_UNUSED) {
+                firstUsage[reference.attachment] = std::min(firstUsage[reference.attachment], subpass);
+                lastUsage[reference.attachment] = subpass;
+            }
+        }};
+
+        for (u32 subpass{}; subpass < subpassCount; subpass++) {
+            const auto &description{subpassDescriptions[subpass]};
+            for (const auto &reference : span<const vk::AttachmentReference>{description.pColorAttachments, description.colorAttachmentCount})
+                trackUsage(reference, subpass);
+            if (description.pDepthStencilAttachment)
+                trackUsage(*description.pDepthStencilAttachment, subpass);
+        }
+
+        renderingSubpasses.resize(subpassCount);
+        for (u32 subpass{}; subpass < subpassCount; subpass++) {
+            const auto &description{subpassDescriptions[subpass]};
+            auto &rendering{renderingSubpasses[subpass]};
+
+            auto getAttachmentInfo{[&](const vk::AttachmentReference &reference, vk::AttachmentLoadOp loadOp, vk::AttachmentStoreOp storeOp) {
+                auto index{reference.attachment};
+                if (firstUsage[index] != subpass) {
+                    loadOp = vk::AttachmentLoadOp::eLoad;
+                    rendering.needsBarrier = true;
+                }
+                if (lastUsage[index] != subpass)
+                    storeOp = vk::AttachmentStoreOp::eStore;
+
+                return vk::RenderingAttachmentInfo{
+                    .imageView = attachments[index],
+                    .imageLayout = reference.layout,
+                    .loadOp = loadOp,
+                    .storeOp = storeOp,
+                    .clearValue = index < clearValues.size() ? clearValues[index] : vk::ClearValue{},
+                };
+            }};
+
+            for (const auto &reference : span<const vk::AttachmentReference>{description.pColorAttachments, description.colorAttachmentCount}) {
+                if (reference.attachment == VK_ATTACHMENT_UNUSED) {
+                    // An attachment without a view is ignored by the driver, this retains the locations of all following attachments
+                    rendering.colorAttachments.emplace_back();
+                    rendering.colorFormats.push_back(vk::Format::eUndefined);
+                    continue;
+                }
+
+                const auto &attachmentDescription{attachmentDescriptions[reference.attachment]};
+                rendering.colorAttachments.push_back(getAttachmentInfo(reference, attachmentDescription.loadOp, attachmentDescription.storeOp));
+                rendering.colorFormats.push_back(attachmentDescription.format);
+                rendering.sampleCount = attachmentTextures[reference.attachment]->sampleCount;
+            }
+
+            if (auto reference{description.pDepthStencilAttachment}) {
+                const auto &attachmentDescription{attachmentDescriptions[reference->attachment]};
+                auto texture{attachmentTextures[reference->attachment]};
+                if (texture->format->vkAspect & vk::ImageAspectFlagBits::eDepth) {
+                    rendering.depthAttachment = getAttachmentInfo(*reference, attachmentDescription.loadOp, attachmentDescription.storeOp);
+                    rendering.depthFormat = attachmentDescription.format;
+                }
+                if (texture->format->vkAspect & vk::ImageAspectFlagBits::eStencil) {
+                    rendering.stencilAttachment = getAttachmentInfo(*reference, attachmentDescription.stencilLoadOp, attachmentDescription.stencilStoreOp);
+                    rendering.stencilFormat = attachmentDescription.format;
+                }
+                rendering.sampleCount = texture->sampleCount;
+            }
+        }
+    }
+
+    vk::RenderPass RenderPassNode::Build(GPU &gpu) {
+        if (renderPass || !renderingSubpasses.empty())
+            return renderPass;
+
         auto preserveAttachmentIt{preserveAttachmentReferences.begin()};
         for (auto &subpassDescription : subpassDescriptions) {
             subpassDescription.pInputAttachments = RebasePointer(attachmentReferences, subpassDescription.pInputAttachments);
@@ -224,14 +400,20 @@ namespace skyline::gpu::interconnect::node {
             preserveAttachmentIt++;
         }
 
-        auto renderPass{gpu.renderPassCache.GetRenderPass(vk::RenderPassCreateInfo{
+        dynamicRendering = gpu.traits.supportsDynamicRendering;
+        if (dynamicRendering) {
+            BuildRenderingSubpasses();
+            return renderPass;
+        }
+
+        renderPass = gpu.renderPassCache.GetRenderPass(vk::RenderPassCreateInfo{
             .attachmentCount = static_cast<u32>(attachmentDescriptions.size()),
             .pAttachments = attachmentDescriptions.data(),
             .subpassCount = static_cast<u32>(subpassDescriptions.size()),
             .pSubpasses = subpassDescriptions.data(),
             .dependencyCount = static_cast<u32>(subpassDependencies.size()),
             .pDependencies = subpassDependencies.data(),
-        })};
+        });
 
         auto useImagelessFramebuffer{gpu.traits.supportsImagelessFramebuffers};
         cache::FramebufferCreateInfo framebufferCreateInfo{
@@ -253,8 +435,53 @@ namespace skyline::gpu::interconnect::node {
         if (!useImagelessFramebuffer)
             framebufferCreateInfo.unlink<vk::FramebufferAttachmentsCreateInfo>();
 
-        auto framebuffer{gpu.framebufferCache.GetFramebuffer(framebufferCreateInfo)};
+        framebuffer = gpu.framebufferCache.GetFramebuffer(framebufferCreateInfo);
+        return renderPass;
+    }
+
+    vk::CommandBufferInheritanceRenderingInfo RenderPassNode::GetInheritanceRenderingInfo(u32 subpassIndex) const {
+        const auto &subpass{renderingSubpasses[subpassIndex]};
+        return vk::CommandBufferInheritanceRenderingInfo{
+            .colorAttachmentCount = static_cast<u32>(subpass.colorFormats.size()),
+            .pColorAttachmentFormats = subpass.colorFormats.data(),
+            .depthAttachmentFormat = subpass.depthFormat,
+            .stencilAttachmentFormat = subpass.stencilFormat,
+            .rasterizationSamples = subpass.sampleCount,
+        };
+    }
+
+    void RenderPassNode::BeginRendering(vk::raii::CommandBuffer &commandBuffer, u32 subpassIndex, vk::SubpassContents contents) {
+        const auto &subpass{renderingSubpasses[subpassIndex]};
+        commandBuffer.beginRenderingKHR(vk::RenderingInfo{
+            .flags = contents == vk::SubpassContents::eSecondaryCommandBuffers ? vk::RenderingFlagBits::eContentsSecondaryCommandBuffers : vk::RenderingFlags{},
+            .renderArea = renderArea,
+            .layerCount = 1,
+            .colorAttachmentCount = static_cast<u32>(subpass.colorAttachments.size()),
+            .pColorAttachments = subpass.colorAttachments.data(),
+            .pDepthAttachment = subpass.depthFormat != vk::Format::eUndefined ? &subpass.depthAttachment : nullptr,
+            .pStencilAttachment = subpass.stencilFormat != vk::Format::eUndefined ? &subpass.stencilAttachment : nullptr,
+        });
+    }
+
+    vk::RenderPass RenderPassNode::operator()(vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &gpu, vk::SubpassContents contents) {
+        Build(gpu);
+
+        for (auto &command : preRenderPassCommands)
+            command(commandBuffer, cycle, gpu);
+
+        if (dynamicRendering) {
+            // There's no implicit external dependency for a rendering scope, so the one that would be used for the render pass is recorded as a barrier
+            const auto &dependency{subpassDependencies.front()};
+            commandBuffer.pipelineBarrier(dependency.srcStageMask, dependency.dstStageMask, {}, vk::MemoryBarrier{
+                .srcAccessMask = dependency.srcAccessMask,
+                .dstAccessMask = dependency.dstAccessMask,
+            }, {}, {});
 
+            BeginRendering(commandBuffer, 0, contents);
+            return renderPass;
+        }
+
+        auto useImagelessFramebuffer{gpu.traits.supportsImagelessFramebuffers};
         vk::StructureChain<vk::RenderPassBeginInfo, vk::RenderPassAttachmentBeginInfo> renderPassBeginInfo{
             vk::RenderPassBeginInfo{
                 .renderPass = renderPass,
@@ -272,8 +499,35 @@ namespace skyline::gpu::interconnect::node {
         if (!useImagelessFramebuffer)
             renderPassBeginInfo.unlink<vk::RenderPassAttachmentBeginInfo>();
 
-        commandBuffer.beginRenderPass(renderPassBeginInfo.get<vk::RenderPassBeginInfo>(), vk::SubpassContents::eInline);
+        commandBuffer.beginRenderPass(renderPassBeginInfo.get<vk::RenderPassBeginInfo>(), contents);
 
         return renderPass;
     }
+
+    void RenderPassNode::NextSubpass(vk::raii::CommandBuffer &commandBuffer, u32 subpassIndex, vk::SubpassContents contents) {
+        if (!dynamicRendering) {
+            commandBuffer.nextSubpass(contents);
+            return;
+        }
+
+        commandBuffer.endRenderingKHR();
+
+        // Subpass dependencies only ever order attachment accesses between subpasses, so the same is done for the rendering scopes
+        if (renderingSubpasses[subpassIndex].needsBarrier) {
+            constexpr vk::PipelineStageFlags AttachmentStages{vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests};
+            commandBuffer.pipelineBarrier(AttachmentStages, AttachmentStages, {}, vk::MemoryBarrier{
+                .srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite,
+                .dstAccessMask = vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite,
+            }, {}, {});
+        }
+
+        BeginRendering(commandBuffer, subpassIndex, contents);
+    }
+
+    void RenderPassNode::End(vk::raii::CommandBuffer &commandBuffer) {
+        if (dynamicRendering)
+            commandBuffer.endRenderingKHR();
+        else
+            commandBuffer.endRenderPass();
+    }
 }
@@ -3,17 +3,79 @@
 
 #pragma once
 
+#include <common/linear_allocator.h>
 #include <gpu.h>
 
 namespace skyline::gpu::interconnect::node {
+    template<typename FunctionSignature>
+    class ArenaFunction;
+
+    /**
+     * @brief A move-only type-erased function with its callable stored inside a linear allocator, this avoids the heap allocation that std::function requires for any captures which don't fit inline
+     * @note The allocator **must** not be reset prior to the destruction of the function
+     */
+    template<typename ReturnType, typename... Args>
+    class ArenaFunction<ReturnType(Args...)> {
+      private:
+        void *callable{};
+        ReturnType (*invoke)(void *, Args...){};
+        void (*destroy)(void *){}; //!< Destroys the callable, this is null for trivially destructible callables
+
+      public:
+        template<typename Function>
+        ArenaFunction(LinearAllocatorState<> &allocator, Function &&function) {
+            using FunctionType = std::decay_t<Function>;
+            static_assert(alignof(FunctionType) <= alignof(std::max_align_t));
+
+            callable = allocator.EmplaceUntracked<FunctionType>(std::forward<Function>(function));
+            invoke = [](void *pCallable, Args... args) -> ReturnType {
+                return (*static_cast<FunctionType *>(pCallable))(std::forward<Args>(args)...);
+            };
+            if constexpr (!std::is_trivially_destructible_v<FunctionType>)
+                destroy = [](void *pCallable) {
+                    std::destroy_at(static_cast<FunctionType *>(pCallable));
+                };
+        }
+
+        ArenaFunction(const ArenaFunction &) = delete;
+
+        ArenaFunction(ArenaFunction &&other) : callable{std::exchange(other.callable, nullptr)}, invoke{other.invoke}, destroy{std::exchange(other.destroy, nullptr)} {}
+
+        ArenaFunction &operator=(const ArenaFunction &) = delete;
+
+        ArenaFunction &operator=(ArenaFunction &&other) {
+            if (this != &other) {
+                if (destroy)
+                    destroy(callable);
+                callable = std::exchange(other.callable, nullptr);
+                invoke = other.invoke;
+                destroy = std::exchange(other.destroy, nullptr);
+            }
+            return *this;
+        }
+
+        ~ArenaFunction() {
+            if (destroy)
+                destroy(callable);
+        }
+
+        ReturnType operator()(Args... args) {
+            return invoke(callable, std::forward<Args>(args)...);
+        }
+    };
+
     /**
      * @brief A generic node for simply executing a function
      */
     template<typename FunctionSignature = void(vk::raii::CommandBuffer &, const std::shared_ptr<FenceCycle> &, GPU &)>
     struct FunctionNodeBase {
-        std::function<FunctionSignature> function;
+        ArenaFunction<FunctionSignature> function;
 
-        FunctionNodeBase(std::function<FunctionSignature> &&function) : function(function) {}
+        /**
+         * @param allocator The allocator of the slot the node is in, the function's captures are stored inside it
+         */
+        template<typename Function>
+        FunctionNodeBase(LinearAllocatorState<> &allocator, Function &&function) : function{allocator, std::forward<Function>(function)} {}
 
         template<class... Args>
         void operator()(Args &&... args) {
@@ -25,10 +87,12 @@ namespace skyline::gpu::interconnect::node {
 
     /**
      * @brief Creates and begins a VkRenderPass alongside managing all resources bound to it and to the subpasses inside it
+     * @note With VK_KHR_dynamic_rendering no render pass or framebuffer objects are created, every subpass is instead rendered in its own rendering scope with the load and store ops of its attachments derived from the render pass state
      */
     struct RenderPassNode {
       private:
         std::vector<vk::ImageView> attachments;
+        std::vector<Texture *> attachmentTextures; //!< The textures backing each attachment, these are kept alive by the executor for as long as the node exists
         std::vector<vk::FramebufferAttachmentImageInfo> attachmentInfo;
         std::vector<vk::AttachmentDescription> attachmentDescriptions;
 
@@ -37,6 +101,36 @@ namespace skyline::gpu::interconnect::node {
 
         constexpr static uintptr_t NoDepthStencil{std::numeric_limits<uintptr_t>::max()}; //!< A sentinel value to denote the lack of a depth stencil attachment in a VkSubpassDescription
 
+        vk::RenderPass renderPass{}; //!< The render pass created from the node's state, this is only valid after Build has been called
+        vk::Framebuffer framebuffer{};
+
+        /**
+         * @brief The attachments of a single subpass in the form supplied to vkCmdBeginRenderingKHR
+         */
+        struct RenderingSubpass {
+            std::vector<vk::RenderingAttachmentInfo> colorAttachments;
+            std::vector<vk::Format> colorFormats; //!< The format of every color attachment, this is undefined for unused attachments
+            vk::RenderingAttachmentInfo depthAttachment{};
+            vk::RenderingAttachmentInfo stencilAttachment{};
+            vk::Format depthFormat{vk::Format::eUndefined};
+            vk::Format stencilFormat{vk::Format::eUndefined};
+            vk::SampleCountFlagBits sampleCount{vk::SampleCountFlagBits::e1};
+            bool needsBarrier{}; //!< If any attachment of the subpass was used by a prior subpass, its writes must be made visible prior to beginning the subpass as there are no implicit dependencies between rendering scopes
+        };
+
+        bool dynamicRendering{}; //!< If the node is rendered with VK_KHR_dynamic_rendering, this is only valid after Build has been called
+        std::vector<RenderingSubpass> renderingSubpasses; //!< The attachments of every subpass when using dynamic rendering, these are populated during Build
+
+        /**
+         * @brief Populates renderingSubpasses from the subpass descriptions, the first and last subpass that use an attachment get its load and store ops respectively while all others load and store it
+         */
+        void BuildRenderingSubpasses();
+
+        /**
+         * @brief Begins a rendering scope for the supplied subpass
+         */
+        void BeginRendering(vk::raii::CommandBuffer &commandBuffer, u32 subpassIndex, vk::SubpassContents contents);
+
         /**
          * @brief Rebases a pointer containing an offset relative to the beginning of a container
          */
@@ -45,6 +139,11 @@ namespace skyline::gpu::interconnect::node {
             return reinterpret_cast<T *>(reinterpret_cast<uintptr_t>(container.data()) + reinterpret_cast<uintptr_t>(offset));
         }
 
+        /**
+         * @return If the render area of this render pass fully contains the supplied render area
+         */
+        bool ContainsRenderArea(const vk::Rect2D &area) const;
+
       public:
         std::vector<vk::SubpassDescription> subpassDescriptions;
         std::vector<vk::SubpassDependency> subpassDependencies;
@@ -52,6 +151,8 @@ namespace skyline::gpu::interconnect::node {
         vk::Rect2D renderArea;
         std::vector<vk::ClearValue> clearValues;
 
+        std::vector<FunctionNode> preRenderPassCommands; //!< Commands which are recorded directly prior to beginning the render pass, these cannot observe the results of any commands inside it
+
         RenderPassNode(vk::Rect2D renderArea);
 
         /**
@@ -80,17 +181,72 @@ namespace skyline::gpu::interconnect::node {
          */
         bool ClearDepthStencilAttachment(const vk::ClearDepthStencilValue &value, GPU& gpu);
 
-        vk::RenderPass operator()(vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &gpu);
+        /**
+         * @brief Moves all clears done by a directly preceding render pass which doesn't record any commands into this render pass, so the preceding render pass can be dropped
+         * @return If all clears (if any) could be merged, the preceding render pass must be retained if this is false
+         * @note This **must** be called prior to Build
+         */
+        bool MergeClears(const RenderPassNode &previous);
+
+        /**
+         * @brief Uses VK_ATTACHMENT_STORE_OP_DONT_CARE for any attachments that are cleared by a directly following render pass, as their contents can never be observed
+         * @note This **must** be called prior to Build
+         */
+        void DiscardOverwrittenAttachments(const RenderPassNode &next);
+
+        /**
+         * @brief Updates the count of consecutive entirely clearing render passes for all depth/stencil attachments, any which aren't entirely cleared by this render pass have it reset
+         * @note This must be called on every render pass in the order they're executed after any clears have been merged
+         */
+        void TrackAttachmentClears();
+
+        /**
+         * @brief Uses VK_ATTACHMENT_STORE_OP_DONT_CARE for any depth/stencil attachments which are transient, their contents are assumed to never be observed after the render pass
+         * @note This **must** be called prior to Build and after TrackAttachmentClears has been called on all render passes in the slot
+         */
+        void DiscardTransientAttachments();
+
+        /**
+         * @brief Creates the VkRenderPass and VkFramebuffer corresponding to all subpasses added prior, this is done implicitly when the render pass is begun if it wasn't done beforehand
+         * @note No more subpasses or attachments can be added after this has been called
+         * @return The created render pass, this can be used to record secondary command buffers for the subpasses prior to beginning the render pass, it is null when using dynamic rendering
+         */
+        vk::RenderPass Build(GPU &gpu);
+
+        /**
+         * @return The inheritance info for a secondary command buffer recording the supplied subpass when using dynamic rendering
+         * @note The returned structure points into the node and **must** not outlive it
+         */
+        vk::CommandBufferInheritanceRenderingInfo GetInheritanceRenderingInfo(u32 subpassIndex) const;
+
+        /**
+         * @return The framebuffer created by Build
+         */
+        vk::Framebuffer GetFramebuffer() const {
+            return framebuffer;
+        }
+
+        /**
+         * @param contents If the first subpass will be recorded inline or into secondary command buffers
+         * @note Any pre-render pass commands are recorded prior to beginning the render pass
+         */
+        vk::RenderPass operator()(vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &gpu, vk::SubpassContents contents = vk::SubpassContents::eInline);
+
+        /**
+         * @brief Progresses to the supplied subpass, when using dynamic rendering this ends the rendering scope of the prior subpass and begins one for the supplied subpass
+         */
+        void NextSubpass(vk::raii::CommandBuffer &commandBuffer, u32 subpassIndex, vk::SubpassContents contents = vk::SubpassContents::eInline);
+
+        /**
+         * @brief Ends the render pass or the rendering scope of the last subpass when using dynamic rendering
+         */
+        void End(vk::raii::CommandBuffer &commandBuffer);
     };
 
     /**
-     * @brief A node which progresses to the next subpass during a render pass
+     * @brief A node which progresses to the next subpass during a render pass, this is done with RenderPassNode::NextSubpass as it depends on the state of the render pass
      */
-    struct NextSubpassNode {
-        void operator()(vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &gpu) {
-            commandBuffer.nextSubpass(vk::SubpassContents::eInline);
-        }
-    };
+    struct NextSubpassNode {};
 
     using SubpassFunctionNode = FunctionNodeBase<void(vk::raii::CommandBuffer &, const std::shared_ptr<FenceCycle> &, GPU &, vk::RenderPass, u32)>;
 
@@ -100,20 +256,18 @@ namespace skyline::gpu::interconnect::node {
     struct NextSubpassFunctionNode : private SubpassFunctionNode {
         using SubpassFunctionNode::SubpassFunctionNode;
 
-        void operator()(vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &gpu, vk::RenderPass renderPass, u32 subpassIndex) {
-            commandBuffer.nextSubpass(vk::SubpassContents::eInline);
+        /**
+         * @brief Calls the function without progressing to the next subpass, RenderPassNode::NextSubpass must be used to progress to it beforehand unless the subpass is recorded into a secondary command buffer
+         */
+        void RecordFunction(vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &gpu, vk::RenderPass renderPass, u32 subpassIndex) {
             SubpassFunctionNode::operator()(commandBuffer, cycle, gpu, renderPass, subpassIndex);
         }
     };
 
     /**
-     * @brief Ends a VkRenderPass that would be created prior with RenderPassNode
+     * @brief Ends the render pass begun by the preceding RenderPassNode, this is done with RenderPassNode::End
      */
-    struct RenderPassEndNode {
-        void operator()(vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &gpu) {
-            commandBuffer.endRenderPass();
-        }
-    };
+    struct RenderPassEndNode {};
 
     using NodeVariant = std::variant<FunctionNode, RenderPassNode, NextSubpassNode, SubpassFunctionNode, NextSubpassFunctionNode, RenderPassEndNode>; //!< A variant encompassing all command nodes types
 }
@@ -111,19 +111,86 @@ namespace skyline::gpu::interconnect {
           channelCtx{channelCtx},
           executor{channelCtx.executor} {}
 
+    bool Fermi2D::CopyImage(const std::shared_ptr<TextureView> &srcView, const std::shared_ptr<TextureView> &dstView, texture::Dimensions srcDimensions, texture::Dimensions dstDimensions, float srcRectX, float srcRectY, u32 dstRectWidth, u32 dstRectHeight, u32 dstRectX, u32 dstRectY) {
+        // An image copy is bit-exact so the formats of the views must be identical to each other and the underlying textures for it to be equivalent to sampling and writing
+        if (srcView->format != dstView->format || srcView->texture->format != srcView->format || dstView->texture->format != dstView->format)
+            return false;
+
+        // Copies within the same texture may overlap which is undefined behaviour for image copies
+        if (srcView->texture == dstView->texture)
+            return false;
+
+        if (srcView->texture->sampleCount != vk::SampleCountFlagBits::e1 || dstView->texture->sampleCount != vk::SampleCountFlagBits::e1)
+            return false;
+
+        // Scaled textures don't have a 1:1 mapping between guest and host texels
+        if (srcView->texture->scale != 1.0f || dstView->texture->scale != 1.0f)
+            return false;
+
+        // The source rectangle must be texel-aligned for nearest sampling at a 1:1 scale to map each destination texel to exactly one source texel
+        if (srcRectX < 0 || srcRectY < 0 || std::floor(srcRectX) != srcRectX || std::floor(srcRectY) != srcRectY)
+            return false;
+
+        auto srcX{static_cast<u32>(srcRectX)}, srcY{static_cast<u32>(srcRectY)};
+        if (srcX + dstRectWidth > srcDimensions.width || srcY + dstRectHeight > srcDimensions.height || dstRectX + dstRectWidth > dstDimensions.width || dstRectY + dstRectHeight > dstDimensions.height)
+            return false; // Out-of-bounds sampling is clamped by the blit shader which an image copy can't replicate
+
+        auto aspect{srcView->format->vkAspect};
+        vk::ImageCopy region{
+            .srcSubresource = {
+                .aspectMask = aspect,
+                .mipLevel = srcView->range.baseMipLevel,
+                .baseArrayLayer = srcView->range.baseArrayLayer,
+                .layerCount = 1,
+            },
+            .srcOffset = {static_cast<i32>(srcX), static_cast<i32>(srcY), 0},
+            .dstSubresource = {
+                .aspectMask = aspect,
+                .mipLevel = dstView->range.baseMipLevel,
+                .baseArrayLayer = dstView->range.baseArrayLayer,
+                .layerCount = 1,
+            },
+            .dstOffset = {static_cast<i32>(dstRectX), static_cast<i32>(dstRectY), 0},
+            .extent = {dstRectWidth, dstRectHeight, 1},
+        };
+
+        executor.AddOutsideRpCommand([srcView, dstView, region](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &, GPU &) {
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eTransfer, {}, vk::MemoryBarrier{
+                .srcAccessMask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite,
+                .dstAccessMask = vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite
+            }, {}, {});
+
+            commandBuffer.copyImage(srcView->texture->GetBacking(), vk::ImageLayout::eGeneral, dstView->texture->GetBacking(), vk::ImageLayout::eGeneral, region);
+
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eAllCommands, {}, vk::MemoryBarrier{
+                .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+                .dstAccessMask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite,
+            }, {}, {});
+        });
+
+        return true;
+    }
+
     void Fermi2D::Blit(const Surface &srcSurface, const Surface &dstSurface, float srcRectX, float srcRectY, u32 dstRectWidth, u32 dstRectHeight, u32 dstRectX, u32 dstRectY, float duDx, float dvDy, SampleModeOrigin sampleOrigin, bool resolve, SampleModeFilter filter) {
-        // TODO: When we support MSAA perform a resolve operation rather than blit when the `resolve` flag is set.
+        // TODO: When we support MSAA perform a resolve operation rather than blit when the `resolve` flag is set, until then resolves are 1:1 blits between single-sampled textures
         auto srcGuestTexture{GetGuestTexture(srcSurface)};
         auto dstGuestTexture{GetGuestTexture(dstSurface)};
 
         auto srcTextureView{gpu.texture.FindOrCreate(srcGuestTexture, executor.tag)};
         executor.AttachDependency(srcTextureView);
         executor.AttachTexture(srcTextureView.get());
+        srcTextureView->texture->MarkContentsObserved();
 
         auto dstTextureView{gpu.texture.FindOrCreate(dstGuestTexture, executor.tag)};
         executor.AttachDependency(dstTextureView);
         executor.AttachTexture(dstTextureView.get());
 
+        // Bilinear filtering at a 1:1 scale from texel centres samples exactly one texel, so it's equivalent to point sampling, this covers resolves which always sample from the centre
+        bool pointEquivalent{filter == SampleModeFilter::Point || sampleOrigin == SampleModeOrigin::Center};
+        if (duDx == 1.0f && dvDy == 1.0f && pointEquivalent &&
+            CopyImage(srcTextureView, dstTextureView, srcGuestTexture.dimensions, dstGuestTexture.dimensions, srcRectX, srcRectY, dstRectWidth, dstRectHeight, dstRectX, dstRectY))
+            return;
+
         // Blit shader always samples from centre so adjust if necessary
         float centredSrcRectX{sampleOrigin == SampleModeOrigin::Corner ? srcRectX - 0.5f : srcRectX};
         float centredSrcRectY{sampleOrigin == SampleModeOrigin::Corner ? srcRectY - 0.5f : srcRectY};
@@ -148,7 +215,7 @@ namespace skyline::gpu::interconnect {
             srcTextureView.get(), dstTextureView.get(),
             [=](auto &&executionCallback) {
                 auto dst{dstTextureView.get()};
-                executor.AddSubpass(std::move(executionCallback), {{static_cast<i32>(dstRectX), static_cast<i32>(dstRectY)}, {dstRectWidth, dstRectHeight} }, {}, {dst});
+                executor.AddSubpass(std::move(executionCallback), texture::ScaleRect({{static_cast<i32>(dstRectX), static_cast<i32>(dstRectY)}, {dstRectWidth, dstRectHeight}}, dst->texture->scale), {}, {dst});
             }
         );
 
@@ -35,6 +35,12 @@ namespace skyline::gpu::interconnect {
 
         gpu::GuestTexture GetGuestTexture(const Surface &surface);
 
+        /**
+         * @brief Copies a rectangle between two textures with a direct image copy rather than the blit helper shader, this avoids a render pass and pipeline bind for the common case of moving texture data around without any scaling or conversion
+         * @return If the copy was recorded, this is false if the blit can't be expressed as a 1:1 copy and must go through the blit helper shader
+         */
+        bool CopyImage(const std::shared_ptr<TextureView> &srcView, const std::shared_ptr<TextureView> &dstView, texture::Dimensions srcDimensions, texture::Dimensions dstDimensions, float srcRectX, float srcRectY, u32 dstRectWidth, u32 dstRectHeight, u32 dstRectX, u32 dstRectY);
+
       public:
         Fermi2D(GPU &gpu, soc::gm20b::ChannelContext &channelCtx);
 
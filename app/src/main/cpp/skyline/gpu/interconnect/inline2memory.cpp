@@ -15,6 +15,77 @@ namespace skyline::gpu::interconnect {
           channelCtx{channelCtx},
           executor{channelCtx.executor} {}
 
+    MegaBufferAllocator::Allocation Inline2Memory::Stage(span<u8> data) {
+        if (!staging || stagingExecutionNumber != executor.executionNumber || stagingUsed + data.size_bytes() > staging.region.size()) {
+            staging = gpu.megaBufferAllocator.Allocate(executor.cycle, std::max<vk::DeviceSize>(StagingBlockSize, data.size_bytes()));
+            stagingUsed = 0;
+            stagingExecutionNumber = executor.executionNumber;
+        }
+
+        MegaBufferAllocator::Allocation allocation{
+            .buffer = staging.buffer,
+            .offset = staging.offset + stagingUsed,
+            .region = staging.region.subspan(stagingUsed, data.size_bytes()),
+        };
+        allocation.region.copy_from(data);
+
+        // Subsequent uploads are kept 4-byte aligned as they would be if pushed individually
+        stagingUsed += util::AlignUp(data.size_bytes(), 4);
+        return allocation;
+    }
+
+    Inline2Memory::UploadBatch &Inline2Memory::GetBatch(const BufferView &dst) {
+        if (batch && batchExecutionNumber == executor.executionNumber && batchCommandSequence == executor.GetCommandSequence()) {
+            // Copies within a single command have no defined ordering between each other, so overlapping writes need to go into a separate command
+            auto dstBuffer{dst.GetBuffer()};
+            auto dstStart{dst.GetOffset()}, dstEnd{dstStart + dst.size};
+            bool overlaps{std::any_of(batch->copies.begin(), batch->copies.end(), [&](const UploadBatch::Copy &copy) {
+                return copy.dst.GetBuffer() == dstBuffer && copy.dst.GetOffset() < dstEnd && dstStart < copy.dst.GetOffset() + copy.size;
+            })};
+
+            if (!overlaps)
+                return *batch;
+        }
+
+        batch = std::make_shared<UploadBatch>();
+        executor.AddOutsideRpCommand([batch = batch](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &, GPU &) {
+            // Copies are grouped by their source and destination buffers so only a single copy command is required for each destination
+            std::vector<vk::BufferCopy> regions;
+            std::vector<bool> recorded(batch->copies.size());
+            for (size_t i{}; i < batch->copies.size(); i++) {
+                if (recorded[i])
+                    continue;
+
+                const auto &copy{batch->copies[i]};
+                vk::Buffer srcBuffer{copy.srcBuffer}, dstBuffer{copy.dst.GetBuffer()->GetBacking()};
+                regions.clear();
+
+                for (size_t j{i}; j < batch->copies.size(); j++) {
+                    const auto &other{batch->copies[j]};
+                    if (!recorded[j] && other.srcBuffer == srcBuffer && other.dst.GetBuffer()->GetBacking() == dstBuffer) {
+                        regions.push_back(vk::BufferCopy{
+                            .srcOffset = other.srcOffset,
+                            .dstOffset = other.dst.GetOffset(),
+                            .size = other.size,
+                        });
+                        recorded[j] = true;
+                    }
+                }
+
+                commandBuffer.copyBuffer(srcBuffer, dstBuffer, regions);
+            }
+
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eAllCommands, {}, vk::MemoryBarrier{
+                .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+                .dstAccessMask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite
+            }, {}, {});
+        });
+
+        batchExecutionNumber = executor.executionNumber;
+        batchCommandSequence = executor.GetCommandSequence();
+        return *batch;
+    }
+
     void Inline2Memory::Upload(IOVA dst, span<u32> src) {
         auto dstMappings{channelCtx.asCtx->gmmu.TranslateRange(dst, src.size_bytes())};
 
@@ -26,25 +97,19 @@ namespace skyline::gpu::interconnect {
         })};
         ContextLock dstBufLock{executor.tag, dstBuf};
 
-
         dstBuf.Write(src.cast<u8>(), 0, [&]() {
+            auto &uploadBatch{GetBatch(dstBuf)};
+            auto srcGpuAllocation{Stage(src.cast<u8>())};
+            uploadBatch.copies.push_back(UploadBatch::Copy{
+                .dst = dstBuf,
+                .srcBuffer = srcGpuAllocation.buffer,
+                .srcOffset = srcGpuAllocation.offset,
+                .size = src.size_bytes(),
+            });
+
             executor.AttachLockedBufferView(dstBuf, std::move(dstBufLock));
             // This will prevent any CPU accesses to backing for the duration of the usage
             dstBuf.GetBuffer()->BlockAllCpuBackingWrites();
-
-            auto srcGpuAllocation{gpu.megaBufferAllocator.Push(executor.cycle, src.cast<u8>())};
-            executor.AddOutsideRpCommand([srcGpuAllocation, dstBuf, src](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &, GPU &) {
-                vk::BufferCopy copyRegion{
-                    .size = src.size_bytes(),
-                    .srcOffset = srcGpuAllocation.offset,
-                    .dstOffset = dstBuf.GetOffset()
-                };
-                commandBuffer.copyBuffer(srcGpuAllocation.buffer, dstBuf.GetBuffer()->GetBacking(), copyRegion);
-                commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eAllCommands, {}, vk::MemoryBarrier{
-                    .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
-                    .dstAccessMask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite
-                }, {}, {});
-            });
         });
     }
 }
@@ -5,6 +5,8 @@
 #pragma once
 
 #include <soc/gm20b/gmmu.h>
+#include <gpu/buffer.h>
+#include <gpu/megabuffer.h>
 
 namespace skyline::gpu {
     class GPU;
@@ -24,13 +26,51 @@ namespace skyline::gpu::interconnect {
       private:
         using IOVA = soc::gm20b::IOVA;
 
+        static constexpr vk::DeviceSize StagingBlockSize{0x10000}; //!< The minimum size of the megabuffer allocations that upload data is staged in
+
+        /**
+         * @brief A set of GPU-side uploads that are all performed by a single command
+         * @note Uploads are appended to the batch for as long as no other command has been added to the execution after the one performing it
+         */
+        struct UploadBatch {
+            struct Copy {
+                BufferView dst;
+                vk::Buffer srcBuffer;
+                vk::DeviceSize srcOffset;
+                vk::DeviceSize size;
+            };
+
+            std::vector<Copy> copies;
+        };
+
         GPU &gpu;
         soc::gm20b::ChannelContext &channelCtx;
         gpu::interconnect::CommandExecutor &executor;
 
+        MegaBufferAllocator::Allocation staging{}; //!< The megabuffer allocation that upload data is currently being staged in, this is shared across all batches within an execution so their data is contiguous
+        vk::DeviceSize stagingUsed{}; //!< The amount of bytes in the staging allocation that have already been used
+        u32 stagingExecutionNumber{}; //!< The execution number the staging allocation was made in
+
+        std::shared_ptr<UploadBatch> batch; //!< The batch that is currently being appended to, this is shared with the command that records it
+        u32 batchExecutionNumber{}; //!< The execution number the batch was recorded in
+        size_t batchCommandSequence{}; //!< The command sequence of the command recording the batch, see CommandExecutor::GetCommandSequence
+
+        /**
+         * @brief Stages the supplied data in a megabuffer allocation that will remain valid for the current execution
+         */
+        MegaBufferAllocator::Allocation Stage(span<u8> data);
+
+        /**
+         * @return A batch that a GPU-side upload to the supplied destination can be appended to, a new one will be created and recorded if the current batch can't be used
+         */
+        UploadBatch &GetBatch(const BufferView &dst);
+
       public:
         Inline2Memory(GPU &gpu, soc::gm20b::ChannelContext &channelCtx);
 
+        /**
+         * @brief Uploads the supplied data to the destination, if this needs to be done on the GPU then it'll be batched with any consecutive uploads into a single command
+         */
         void Upload(IOVA dst, span<u32> src);
     };
 }
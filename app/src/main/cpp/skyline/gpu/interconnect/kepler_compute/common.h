@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <gpu/interconnect/maxwell_3d/common.h>
+#include <gpu/interconnect/maxwell_3d/constant_buffers.h>
+#include <gpu/interconnect/maxwell_3d/samplers.h>
+#include <gpu/interconnect/maxwell_3d/textures.h>
+
+namespace skyline::gpu::interconnect::kepler_compute {
+    /**
+     * @note The compute engine shares the layout of its texture pools and bound resources with the 3D engine, so the same state tracking is used for both
+     */
+    namespace engine = skyline::soc::gm20b::engine::maxwell3d::type;
+
+    using maxwell3d::InterconnectContext;
+    using maxwell3d::CachedMappedBufferView;
+    using maxwell3d::DynamicBufferBinding;
+    using maxwell3d::DescriptorUpdateInfo;
+    using maxwell3d::DirtyManager;
+    using maxwell3d::ConstantBuffer;
+    using maxwell3d::Samplers;
+    using maxwell3d::SamplerPoolState;
+    using maxwell3d::Textures;
+    using maxwell3d::TexturePoolState;
+
+    constexpr size_t QmdConstantBufferCount{8}; //!< The amount of constant buffers that can be bound through the QMD
+
+    using ConstantBufferSet = std::array<ConstantBuffer, engine::ShaderStageConstantBufferCount>; //!< This matches the size of the 3D engine's per-stage set so the bindless texture helpers can be shared
+}
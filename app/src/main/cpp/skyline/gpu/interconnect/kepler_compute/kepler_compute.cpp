@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <common/trace.h>
+#include <gpu/descriptor_allocator.h>
+#include <gpu/interconnect/command_executor.h>
+#include <gpu/interconnect/maxwell_3d/state_updater.h>
+#include <soc/gm20b/channel.h>
+#include <soc/gm20b/gmmu.h>
+#include <soc/gm20b/engines/kepler_compute/qmd.h>
+#include <gpu.h>
+#include "kepler_compute.h"
+
+namespace skyline::gpu::interconnect::kepler_compute {
+    using QMD = soc::gm20b::engine::kepler_compute::QMD;
+
+    KeplerCompute::KeplerCompute(const DeviceState &state,
+                                 GPU &gpu,
+                                 soc::gm20b::ChannelContext &channelCtx,
+                                 nce::NCE &nce,
+                                 skyline::kernel::MemoryManager &memoryManager,
+                                 DirtyManager &manager,
+                                 const EngineRegisterBundle &registerBundle)
+        : ctx{state, channelCtx, channelCtx.executor, gpu, nce, memoryManager},
+          samplers{manager, registerBundle.samplerPoolRegisters},
+          textures{manager, registerBundle.texturePoolRegisters},
+          programRegion{registerBundle.programRegion},
+          bindlessTexture{registerBundle.bindlessTexture} {
+        ctx.executor.AddFlushCallback([this] {
+            samplers.MarkAllDirty();
+            textures.MarkAllDirty();
+
+            qmdView.PurgeCaches();
+            for (auto &view : constantBufferViews)
+                view.PurgeCaches();
+        });
+    }
+
+    void KeplerCompute::Dispatch(u64 qmdAddress) {
+        TRACE_EVENT("gpu", "KeplerCompute::Dispatch");
+
+        // The QMD is read through the buffer manager as it's commonly written using inline-to-memory which may only have updated the GPU copy
+        qmdView.Update(ctx, qmdAddress, sizeof(QMD));
+        if (!*qmdView)
+            throw exception("QMD at 0x{:X} is unmapped", qmdAddress);
+        auto qmd{ConstantBuffer{*qmdView}.Read<QMD>(ctx.executor, 0)};
+
+        if (!qmd.ctaRasterWidth || !qmd.ctaRasterHeight || !qmd.ctaRasterDepth)
+            return;
+
+        for (u32 i{}; i < QmdConstantBufferCount; i++) {
+            if (qmd.constantBufferValid & (1U << i)) {
+                const auto &cbuf{qmd.constantBuffer[i]};
+                constantBufferViews[i].Update(ctx, (static_cast<u64>(cbuf.addrUpper) << 32) | cbuf.addrLower, cbuf.size);
+                constantBuffers[i] = {*constantBufferViews[i]};
+            } else {
+                constantBuffers[i] = {};
+            }
+        }
+
+        auto[blockMapping, blockOffset]{ctx.channelCtx.asCtx->gmmu.LookupBlock(programRegion + qmd.programOffset)};
+        u64 shaderHash{};
+        ShaderBinary shaderBinary{maxwell3d::TrimShaderBinary(blockMapping.subspan(blockOffset), shaderHash), qmd.programOffset};
+        if (shaderBinary.binary.empty()) {
+            Logger::Warn("Failed to find the end of the compute shader at 0x{:X}", programRegion + qmd.programOffset);
+            return;
+        }
+
+        PackedPipelineState packedState{
+            .shaderHash = shaderHash,
+            .workgroupDimensions = {qmd.ctaThreadDimension0, qmd.ctaThreadDimension1, qmd.ctaThreadDimension2},
+            .sharedMemorySize = qmd.sharedMemorySize,
+            .localMemorySize = qmd.shaderLocalMemoryLowSize + qmd.shaderLocalMemoryCrsSize,
+            .bindlessTextureConstantBufferSlotSelect = bindlessTexture.constantBufferSlotSelect,
+        };
+
+        Pipeline *pipeline{pipelineManager.FindOrCreate(ctx, textures, constantBuffers, packedState, shaderBinary)};
+
+        samplers.Update(ctx, qmd.samplerIndex == QMD::SamplerIndex::ViaHeaderIndex);
+        auto *descUpdateInfo{pipeline->SyncDescriptors(ctx, constantBuffers, samplers, textures)};
+
+        maxwell3d::StateUpdateBuilder builder{*ctx.executor.allocator};
+        if (descUpdateInfo) {
+            if (ctx.gpu.traits.supportsPushDescriptors) {
+                builder.SetDescriptorSetWithPush(descUpdateInfo);
+            } else {
+                // Dispatches are infrequent enough that sets aren't batched or reused like they are for draws
+                auto descriptorSet{std::make_shared<DescriptorAllocator::ActiveDescriptorSet>(ctx.gpu.descriptor.AllocateSet(descUpdateInfo->descriptorSetLayout))};
+                ctx.executor.AttachDependency(descriptorSet);
+                builder.SetDescriptorSetWithUpdate(descUpdateInfo, descriptorSet.get(), nullptr);
+            }
+        }
+
+        /**
+         * @brief Struct that can be linearly allocated, holding all state for the dispatch to avoid a dynamic allocation with lambda captures
+         */
+        struct DispatchParams {
+            maxwell3d::StateUpdater stateUpdater;
+            vk::Pipeline pipeline;
+            std::array<u32, 3> groupCount;
+        };
+        auto *dispatchParams{ctx.executor.allocator->EmplaceUntracked<DispatchParams>(DispatchParams{
+            builder.Build(), *pipeline->pipeline, {qmd.ctaRasterWidth, qmd.ctaRasterHeight, qmd.ctaRasterDepth}
+        })};
+
+        ctx.executor.AddOutsideRpCommand([dispatchParams](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &, GPU &gpu) {
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eComputeShader, {}, vk::MemoryBarrier{
+                .srcAccessMask = vk::AccessFlagBits::eMemoryWrite,
+                .dstAccessMask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite
+            }, {}, {});
+
+            commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, dispatchParams->pipeline);
+            dispatchParams->stateUpdater.RecordAll(gpu, commandBuffer);
+            commandBuffer.dispatch(dispatchParams->groupCount[0], dispatchParams->groupCount[1], dispatchParams->groupCount[2]);
+
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eAllCommands, {}, vk::MemoryBarrier{
+                .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+                .dstAccessMask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite
+            }, {}, {});
+        });
+    }
+}
@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include "common.h"
+#include "pipeline_manager.h"
+
+namespace skyline::gpu::interconnect::kepler_compute {
+    /**
+     * @brief The core Kepler Compute interconnect object, directly accessed by the engine code to perform compute dispatches
+     */
+    class KeplerCompute {
+      public:
+        /**
+         * @brief The full set of register state used by the GPU interconnect
+         */
+        struct EngineRegisterBundle {
+            SamplerPoolState::EngineRegisters samplerPoolRegisters;
+            TexturePoolState::EngineRegisters texturePoolRegisters;
+            const soc::gm20b::engine::Address &programRegion;
+            const engine::BindlessTexture &bindlessTexture;
+        };
+
+      private:
+        InterconnectContext ctx;
+        Samplers samplers;
+        Textures textures;
+        const soc::gm20b::engine::Address &programRegion;
+        const engine::BindlessTexture &bindlessTexture;
+        PipelineManager pipelineManager;
+        CachedMappedBufferView qmdView;
+        std::array<CachedMappedBufferView, QmdConstantBufferCount> constantBufferViews;
+        ConstantBufferSet constantBuffers{};
+
+      public:
+        KeplerCompute(const DeviceState &state,
+                      GPU &gpu,
+                      soc::gm20b::ChannelContext &channelCtx,
+                      nce::NCE &nce,
+                      kernel::MemoryManager &memoryManager,
+                      DirtyManager &manager,
+                      const EngineRegisterBundle &registerBundle);
+
+        /**
+         * @brief Dispatches the compute task described by the QMD at the supplied address on the host GPU
+         */
+        void Dispatch(u64 qmdAddress);
+    };
+}
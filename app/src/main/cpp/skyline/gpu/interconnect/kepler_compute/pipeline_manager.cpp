@@ -0,0 +1,217 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <common/trace.h>
+#include <common/perf_stats.h>
+#include <gpu/texture/texture.h>
+#include <gpu/interconnect/command_executor.h>
+#include <gpu/shader_manager.h>
+#include <gpu.h>
+#include "pipeline_manager.h"
+
+namespace skyline::gpu::interconnect::kepler_compute {
+    static Pipeline::DescriptorInfo MakePipelineDescriptorInfo(const Shader::Info &info, bool needsIndividualTextureBindingWrites) {
+        Pipeline::DescriptorInfo descriptorInfo{};
+        u32 bindingIndex{};
+
+        // Bindings are assigned in the same order as the shader compiler assigns them during SPIR-V emission, see the Maxwell 3D equivalent
+        auto pushBindings{[&](vk::DescriptorType type, const auto &descs, u32 &count, bool individualDescWrites = false) {
+            descriptorInfo.totalWriteDescCount += individualDescWrites ? descs.size() : ((descs.size() > 0) ? 1 : 0);
+
+            for (const auto &desc : descs) {
+                count += desc.count;
+
+                descriptorInfo.descriptorSetLayoutBindings.push_back(vk::DescriptorSetLayoutBinding{
+                    .binding = bindingIndex++,
+                    .descriptorType = type,
+                    .descriptorCount = desc.count,
+                    .stageFlags = vk::ShaderStageFlagBits::eCompute,
+                });
+            }
+        }};
+
+        u32 texelBufferDescCount{}, storageImageDescCount{}; // These descriptor types are not written yet, but they still need to be present in the layout
+        pushBindings(vk::DescriptorType::eUniformBuffer, info.constant_buffer_descriptors, descriptorInfo.uniformBufferDescCount);
+        pushBindings(vk::DescriptorType::eStorageBuffer, info.storage_buffers_descriptors, descriptorInfo.storageBufferDescCount);
+        descriptorInfo.totalBufferDescCount = descriptorInfo.uniformBufferDescCount + descriptorInfo.storageBufferDescCount;
+
+        pushBindings(vk::DescriptorType::eUniformTexelBuffer, info.texture_buffer_descriptors, texelBufferDescCount);
+        pushBindings(vk::DescriptorType::eStorageTexelBuffer, info.image_buffer_descriptors, texelBufferDescCount);
+
+        pushBindings(vk::DescriptorType::eCombinedImageSampler, info.texture_descriptors, descriptorInfo.combinedImageSamplerDescCount, needsIndividualTextureBindingWrites);
+        pushBindings(vk::DescriptorType::eStorageImage, info.image_descriptors, storageImageDescCount);
+        descriptorInfo.totalImageDescCount = descriptorInfo.combinedImageSamplerDescCount;
+
+        if (texelBufferDescCount || storageImageDescCount)
+            Logger::Warn("Compute shader uses unsupported descriptors: {} texel buffers, {} storage images", texelBufferDescCount, storageImageDescCount);
+
+        return descriptorInfo;
+    }
+
+    Pipeline::Pipeline(InterconnectContext &ctx, Textures &textures, ConstantBufferSet &constantBuffers, const PackedPipelineState &packedState, const ShaderBinary &shaderBinary)
+        : descriptorSetLayout{nullptr},
+          pipelineLayout{nullptr},
+          descriptorUpdateTemplate{nullptr},
+          pipeline{nullptr} {
+        TRACE_EVENT("gpu", "kepler_compute::Pipeline::Compile");
+        PerfStats::Increment(PerfStats::Counter::PipelineCompiles);
+
+        ctx.gpu.shader.ResetPools();
+
+        auto parseProgram{[&](u64 &programHash, bool allowCached) {
+            return ctx.gpu.shader.ParseComputeShader(
+                shaderBinary.binary, shaderBinary.baseOffset,
+                packedState.bindlessTextureConstantBufferSlotSelect,
+                packedState.workgroupDimensions, packedState.sharedMemorySize, packedState.localMemorySize,
+                [&](u32 index, u32 offset) {
+                    return constantBuffers[index].Read<int>(ctx.executor, offset);
+                }, [&](u32 index) {
+                    return textures.GetTextureType(ctx, index);
+                }, programHash, allowCached);
+        }};
+
+        u64 programHash{};
+        auto program{parseProgram(programHash, true)};
+
+        Shader::RuntimeInfo runtimeInfo{};
+        Shader::Backend::Bindings bindings{};
+        auto compiledShader{ctx.gpu.shader.CompileShader(runtimeInfo, program, bindings, programHash)};
+        if (!compiledShader.module) {
+            // The program was cached but its SPIR-V isn't, it needs to be translated again to emit SPIR-V
+            program = parseProgram(programHash, false);
+            compiledShader = ctx.gpu.shader.CompileShader(runtimeInfo, program, bindings, programHash);
+        }
+
+        shaderInfo = program.info;
+        descriptorInfo = MakePipelineDescriptorInfo(shaderInfo, ctx.gpu.traits.quirks.needsIndividualTextureBindingWrites);
+        storageBufferViews.resize(shaderInfo.storage_buffers_descriptors.size());
+
+        descriptorSetLayout = vk::raii::DescriptorSetLayout{ctx.gpu.vkDevice, vk::DescriptorSetLayoutCreateInfo{
+            .flags = vk::DescriptorSetLayoutCreateFlags{ctx.gpu.traits.supportsPushDescriptors ? vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR : vk::DescriptorSetLayoutCreateFlags{}},
+            .pBindings = descriptorInfo.descriptorSetLayoutBindings.data(),
+            .bindingCount = static_cast<u32>(descriptorInfo.descriptorSetLayoutBindings.size()),
+        }};
+
+        pipelineLayout = vk::raii::PipelineLayout{ctx.gpu.vkDevice, vk::PipelineLayoutCreateInfo{
+            .pSetLayouts = &*descriptorSetLayout,
+            .setLayoutCount = 1,
+        }};
+
+        pipeline = ctx.gpu.vkDevice.createComputePipeline(nullptr, vk::ComputePipelineCreateInfo{
+            .stage = vk::PipelineShaderStageCreateInfo{
+                .stage = vk::ShaderStageFlagBits::eCompute,
+                .module = compiledShader.module,
+                .pName = "main",
+            },
+            .layout = *pipelineLayout,
+        });
+    }
+
+    void Pipeline::SyncCachedStorageBufferViews(u32 executionNumber) {
+        if (lastExecutionNumber != executionNumber) {
+            for (auto &view : storageBufferViews)
+                view.PurgeCaches();
+
+            lastExecutionNumber = executionNumber;
+        }
+    }
+
+    DescriptorUpdateInfo *Pipeline::SyncDescriptors(InterconnectContext &ctx, ConstantBufferSet &constantBuffers, Samplers &samplers, Textures &textures) {
+        SyncCachedStorageBufferViews(ctx.executor.executionNumber);
+
+        u32 writeIdx{};
+        auto writes{ctx.executor.allocator->AllocateUntracked<vk::WriteDescriptorSet>(descriptorInfo.totalWriteDescCount)};
+
+        // Buffer and image infos are packed into a single block so that the whole update can be performed with the pipeline's update template
+        u8 *descData{ctx.executor.allocator->Allocate(descriptorInfo.totalBufferDescCount * sizeof(vk::DescriptorBufferInfo) + descriptorInfo.totalImageDescCount * sizeof(vk::DescriptorImageInfo), false)};
+
+        u32 bufferIdx{};
+        span<vk::DescriptorBufferInfo> bufferDescs{reinterpret_cast<vk::DescriptorBufferInfo *>(descData), descriptorInfo.totalBufferDescCount};
+        auto bufferDescDynamicBindings{ctx.executor.allocator->AllocateUntracked<DynamicBufferBinding>(descriptorInfo.totalBufferDescCount)};
+        u32 imageIdx{};
+        span<vk::DescriptorImageInfo> imageDescs{reinterpret_cast<vk::DescriptorImageInfo *>(descData + bufferDescs.size_bytes()), descriptorInfo.totalImageDescCount};
+
+        u32 bindingIdx{};
+
+        auto writeBufferDescs{[&](vk::DescriptorType type, const auto &descs, u32 count, auto getBufferCb) {
+            if (!descs.empty()) {
+                writes[writeIdx++] = {
+                    .dstBinding = bindingIdx,
+                    .descriptorCount = count,
+                    .descriptorType = type,
+                    .pBufferInfo = &bufferDescs[bufferIdx],
+                };
+
+                bindingIdx += descs.size();
+
+                // The underlying buffer bindings will be resolved from the dynamic ones during recording
+                for (u32 descIdx{}; descIdx < descs.size(); descIdx++)
+                    for (u32 arrayIdx{}; arrayIdx < descs[descIdx].count; arrayIdx++)
+                        bufferDescDynamicBindings[bufferIdx++] = getBufferCb(descs[descIdx], descIdx, arrayIdx);
+            }
+        }};
+
+        writeBufferDescs(vk::DescriptorType::eUniformBuffer, shaderInfo.constant_buffer_descriptors, descriptorInfo.uniformBufferDescCount,
+                         [&](const Shader::ConstantBufferDescriptor &desc, u32, u32 arrayIdx) {
+                             size_t cbufIdx{desc.index + arrayIdx};
+                             return maxwell3d::GetConstantBufferBinding(ctx, shaderInfo, constantBuffers[cbufIdx].view, cbufIdx);
+                         });
+
+        writeBufferDescs(vk::DescriptorType::eStorageBuffer, shaderInfo.storage_buffers_descriptors, descriptorInfo.storageBufferDescCount,
+                         [&](const Shader::StorageBufferDescriptor &desc, u32 descIdx, u32) {
+                             return maxwell3d::GetStorageBufferBinding(ctx, desc, constantBuffers[desc.cbuf_index], storageBufferViews[descIdx]);
+                         });
+
+        // Texel buffers are skipped as they aren't written, the bindings still need to be accounted for however
+        bindingIdx += shaderInfo.texture_buffer_descriptors.size() + shaderInfo.image_buffer_descriptors.size();
+
+        const auto &textureDescs{shaderInfo.texture_descriptors};
+        if (!textureDescs.empty()) {
+            bool individualWrites{ctx.gpu.traits.quirks.needsIndividualTextureBindingWrites};
+            if (!individualWrites) {
+                writes[writeIdx++] = {
+                    .dstBinding = bindingIdx,
+                    .descriptorCount = descriptorInfo.combinedImageSamplerDescCount,
+                    .descriptorType = vk::DescriptorType::eCombinedImageSampler,
+                    .pImageInfo = &imageDescs[imageIdx],
+                };
+
+                bindingIdx += textureDescs.size();
+            }
+
+            for (const auto &desc : textureDescs) {
+                if (individualWrites) {
+                    writes[writeIdx++] = {
+                        .dstBinding = bindingIdx++,
+                        .descriptorCount = desc.count,
+                        .descriptorType = vk::DescriptorType::eCombinedImageSampler,
+                        .pImageInfo = &imageDescs[imageIdx],
+                    };
+                }
+
+                for (u32 arrayIdx{}; arrayIdx < desc.count; arrayIdx++) {
+                    maxwell3d::BindlessHandle handle{maxwell3d::ReadBindlessHandle(ctx, constantBuffers, desc, arrayIdx)};
+                    imageDescs[imageIdx++] = maxwell3d::GetTextureBinding(ctx, desc, samplers, textures, handle);
+                }
+            }
+        }
+
+        if (!writeIdx)
+            return nullptr;
+
+        if (!*descriptorUpdateTemplate)
+            descriptorUpdateTemplate = maxwell3d::CreateDescriptorUpdateTemplate(ctx, writes.first(writeIdx), descData, vk::PipelineBindPoint::eCompute, *pipelineLayout, *descriptorSetLayout);
+
+        return ctx.executor.allocator->EmplaceUntracked<DescriptorUpdateInfo>(DescriptorUpdateInfo{
+            .writes = writes.first(writeIdx),
+            .bufferDescs = bufferDescs.first(bufferIdx),
+            .bufferDescDynamicBindings = bufferDescDynamicBindings.first(bufferIdx),
+            .pipelineLayout = *pipelineLayout,
+            .descriptorSetLayout = *descriptorSetLayout,
+            .bindPoint = vk::PipelineBindPoint::eCompute,
+            .descriptorSetIndex = 0,
+            .updateTemplate = *descriptorUpdateTemplate,
+            .templateData = descData,
+        });
+    }
+}
@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <tsl/robin_map.h>
+#include <gpu/interconnect/maxwell_3d/pipeline_manager.h>
+#include "common.h"
+
+namespace skyline::gpu::interconnect::kepler_compute {
+    using maxwell3d::ShaderBinary;
+
+    /**
+     * @brief All state that a compute pipeline depends on, this is used as the key for looking up pipelines
+     */
+    struct PackedPipelineState {
+        u64 shaderHash; //!< The hash of the guest shader binary
+        std::array<u32, 3> workgroupDimensions;
+        u32 sharedMemorySize;
+        u32 localMemorySize;
+        u32 bindlessTextureConstantBufferSlotSelect;
+
+        bool operator==(const PackedPipelineState &) const = default;
+    };
+    static_assert(std::has_unique_object_representations_v<PackedPipelineState>);
+
+    class Pipeline {
+      public:
+        struct DescriptorInfo {
+            std::vector<vk::DescriptorSetLayoutBinding> descriptorSetLayoutBindings;
+
+            u32 uniformBufferDescCount;
+            u32 storageBufferDescCount;
+            u32 combinedImageSamplerDescCount;
+
+            u32 totalWriteDescCount;
+            u32 totalBufferDescCount;
+            u32 totalImageDescCount;
+        };
+
+      private:
+        std::vector<CachedMappedBufferView> storageBufferViews;
+        u32 lastExecutionNumber{}; //!< The last execution number this pipeline was used at
+        Shader::Info shaderInfo;
+        DescriptorInfo descriptorInfo;
+        vk::raii::DescriptorSetLayout descriptorSetLayout;
+        vk::raii::PipelineLayout pipelineLayout;
+        vk::raii::DescriptorUpdateTemplate descriptorUpdateTemplate; //!< The template for descriptor updates, this is created lazily on the first update
+
+        void SyncCachedStorageBufferViews(u32 executionNumber);
+
+      public:
+        vk::raii::Pipeline pipeline;
+
+        /**
+         * @note Compute pipelines are compiled synchronously as the dispatch can't be skipped without breaking any work that depends on its results
+         */
+        Pipeline(InterconnectContext &ctx, Textures &textures, ConstantBufferSet &constantBuffers, const PackedPipelineState &packedState, const ShaderBinary &shaderBinary);
+
+        DescriptorUpdateInfo *SyncDescriptors(InterconnectContext &ctx, ConstantBufferSet &constantBuffers, Samplers &samplers, Textures &textures);
+    };
+
+    class PipelineManager {
+      private:
+        tsl::robin_map<PackedPipelineState, std::unique_ptr<Pipeline>, util::ObjectHash<PackedPipelineState>> map;
+
+      public:
+        Pipeline *FindOrCreate(InterconnectContext &ctx, Textures &textures, ConstantBufferSet &constantBuffers, const PackedPipelineState &packedState, const ShaderBinary &shaderBinary) {
+            auto it{map.find(packedState)};
+            if (it != map.end())
+                return it->second.get();
+
+            return map.emplace(packedState, std::make_unique<Pipeline>(ctx, textures, constantBuffers, packedState, shaderBinary)).first->second.get();
+        }
+    };
+}
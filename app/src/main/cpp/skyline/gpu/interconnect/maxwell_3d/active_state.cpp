@@ -3,6 +3,7 @@
 // Copyright © 2022 yuzu Team and Contributors (https://github.com/yuzu-emu/)
 // Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <boost/functional/hash.hpp>
 #include <range/v3/algorithm.hpp>
 #include <soc/gm20b/channel.h>
 #include <soc/gm20b/gmmu.h>
@@ -25,8 +26,12 @@ namespace skyline::gpu::interconnect::maxwell3d {
         size_t size{engine->vertexStreamLimit - engine->vertexStream.location + 1};
 
         if (engine->vertexStream.format.enable && engine->vertexStream.location != 0 && size) {
-            view.Update(ctx, engine->vertexStream.location, size);
-            if (*view) {
+            view.Update(ctx, engine->vertexStream.location, size, true, true);
+            if (view.sparseBinding) {
+                megaBufferBinding = {};
+                builder.SetVertexBuffer(index, view.sparseBinding);
+                return;
+            } else if (*view) {
                 ctx.executor.AttachBuffer(*view);
 
                 if (megaBufferBinding = view->TryMegaBuffer(ctx.executor.cycle, ctx.gpu.megaBufferAllocator, ctx.executor.executionNumber);
@@ -93,31 +98,140 @@ namespace skyline::gpu::interconnect::maxwell3d {
         }
     }
 
-    static BufferBinding GenerateQuadConversionIndexBuffer(InterconnectContext &ctx, engine::IndexBuffer::IndexSize indexType, BufferView &view, u32 elementCount) {
-        auto viewSpan{view.GetReadOnlyBackingSpan(false /* We attach above so always false */, []() {
-            // TODO: see Read()
-            Logger::Error("Dirty index buffer reads for attached buffers are unimplemented");
-        })};
+    constexpr static u32 GpuIndexConversionThreshold{0x400}; //!< The minimum amount of indices for uncached index conversions to be done on the GPU, smaller index buffers are cheaper to convert on the CPU than the overhead of a dispatch
+
+    /**
+     * @brief Records the conversion of the guest indices into the supplied binding with a compute shader prior to the active render pass, quads are converted into triangles with 32-bit indices while other indices are widened from 8-bit to 16-bit
+     * @note The guest index buffer can't be written inside of a render pass other than by shaders, this is assumed to not be the case to avoid breaking up the render pass
+     */
+    static void RecordIndexConversion(InterconnectContext &ctx, engine::IndexBuffer::IndexSize indexSize, BufferView &view, BufferBinding binding, u32 elementCount, bool quadConversion) {
+        view.GetBuffer()->BlockSequencedCpuBackingWrites();
+        ctx.executor.AddPreRenderPassCommand([view, binding, indexSizeLog2 = static_cast<u32>(indexSize), elementCount, quadConversion](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &gpu) {
+            auto &helperShaders{gpu.helperShaders};
+            auto storageBufferAlignment{helperShaders.quadConversionHelperShader.storageBufferAlignment};
+            vk::DeviceSize srcOffset{view.GetOffset()}, srcAlignedOffset{util::AlignDown(srcOffset, storageBufferAlignment)};
+
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eComputeShader, {}, vk::MemoryBarrier{
+                .srcAccessMask = vk::AccessFlagBits::eMemoryWrite | vk::AccessFlagBits::eMemoryRead,
+                .dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite
+            }, {}, {});
+
+            vk::DescriptorBufferInfo srcBuffer{view.GetBuffer()->GetBacking(), srcAlignedOffset, VK_WHOLE_SIZE}, dstBuffer{binding.buffer, binding.offset, binding.size};
+            if (quadConversion)
+                cycle->AttachObject(helperShaders.quadConversionHelperShader.Convert(gpu, commandBuffer, srcBuffer, static_cast<u32>(srcOffset - srcAlignedOffset), indexSizeLog2, dstBuffer, elementCount / conversion::quads::QuadVertexCount));
+            else
+                cycle->AttachObject(helperShaders.indexConversionHelperShader.Convert(gpu, commandBuffer, srcBuffer, static_cast<u32>(srcOffset - srcAlignedOffset), dstBuffer, elementCount));
+
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eVertexInput, {}, vk::MemoryBarrier{
+                .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+                .dstAccessMask = vk::AccessFlagBits::eIndexRead
+            }, {}, {});
+        });
+    }
 
-        size_t indexSize{1U << static_cast<u32>(indexType)};
-        vk::DeviceSize indexBufferSize{conversion::quads::GetRequiredBufferSize(elementCount, indexSize)};
+    static void FlushHostCallback() {
+        // TODO: see ConstantBuffer::Read()
+        Logger::Error("Dirty index buffer reads for attached buffers are unimplemented");
+    }
+
+    static BufferBinding GenerateQuadConversionIndexBufferCpu(InterconnectContext &ctx, engine::IndexBuffer::IndexSize indexSize, BufferView &view, u32 elementCount, vk::IndexType &indexType) {
+        auto viewSpan{view.GetReadOnlyBackingSpan(false /* We attach above so always false */, FlushHostCallback)};
+
+        indexType = ConvertIndexType(indexSize);
+        size_t indexBytes{1U << static_cast<u32>(indexSize)};
+        vk::DeviceSize indexBufferSize{conversion::quads::GetRequiredBufferSize(elementCount, indexBytes)};
         auto quadConversionAllocation{ctx.gpu.megaBufferAllocator.Allocate(ctx.executor.cycle, indexBufferSize)};
 
-        conversion::quads::GenerateIndexedQuadConversionBuffer(quadConversionAllocation.region.data(), viewSpan.data(), elementCount, ConvertIndexType(indexType));
+        conversion::quads::GenerateIndexedQuadConversionBuffer(quadConversionAllocation.region.data(), viewSpan.data(), elementCount, indexType);
 
         return {quadConversionAllocation.buffer, quadConversionAllocation.offset, indexBufferSize};
     }
 
+    static BufferBinding GenerateWidenedIndexBufferCpu(InterconnectContext &ctx, BufferView &view, u32 elementCount) {
+        auto viewSpan{view.GetReadOnlyBackingSpan(false /* We attach above so always false */, FlushHostCallback)};
+
+        vk::DeviceSize indexBufferSize{elementCount * sizeof(u16)};
+        auto allocation{ctx.gpu.megaBufferAllocator.Allocate(ctx.executor.cycle, indexBufferSize)};
+        auto destination{reinterpret_cast<u16 *>(allocation.region.data())};
+        for (u32 i{}; i < elementCount; i++)
+            destination[i] = viewSpan[i];
+
+        return {allocation.buffer, allocation.offset, indexBufferSize};
+    }
+
     /* Index Buffer */
     void IndexBufferState::EngineRegisters::DirtyBind(DirtyManager &manager, dirty::Handle handle) const {
         manager.Bind(handle, indexBuffer.indexSize, indexBuffer.address);
     }
 
+    size_t IndexBufferState::ConversionKeyHash::operator()(const ConversionKey &key) const {
+        size_t hash{};
+        boost::hash_combine(hash, key.buffer);
+        boost::hash_combine(hash, key.offset);
+        boost::hash_combine(hash, key.elementCount);
+        boost::hash_combine(hash, static_cast<u32>(key.indexSize));
+        boost::hash_combine(hash, key.quadConversion);
+        return hash;
+    }
+
     IndexBufferState::IndexBufferState(dirty::Handle dirtyHandle, DirtyManager &manager, const EngineRegisters &engine) : engine{manager, dirtyHandle, engine} {}
 
+    BufferBinding IndexBufferState::GenerateConversionIndexBuffer(InterconnectContext &ctx, bool quadConversion, u32 elementCount) {
+        auto indexSize{engine->indexBuffer.indexSize};
+        auto buffer{view->GetBuffer()};
+        auto sequence{buffer->GetDeterminateSequence()};
+        bool widenIndices{indexSize == engine::IndexBuffer::IndexSize::OneByte && !ctx.gpu.traits.supportsUint8Indices};
+
+        vk::DeviceSize size;
+        if (quadConversion) {
+            // 8-bit indices are always converted on the GPU without support for them as the CPU conversion retains the index size
+            if (elementCount / conversion::quads::QuadVertexCount > ctx.gpu.helperShaders.quadConversionHelperShader.maxQuadCount || (!sequence && !widenIndices && elementCount < GpuIndexConversionThreshold))
+                return GenerateQuadConversionIndexBufferCpu(ctx, indexSize, *view, elementCount, indexType);
+
+            indexType = vk::IndexType::eUint32;
+            size = conversion::quads::GetRequiredBufferSize(elementCount, sizeof(u32));
+        } else {
+            indexType = vk::IndexType::eUint16;
+            if (elementCount > ctx.gpu.helperShaders.indexConversionHelperShader.maxIndexCount || (!sequence && elementCount < GpuIndexConversionThreshold))
+                return GenerateWidenedIndexBufferCpu(ctx, *view, elementCount);
+
+            size = util::AlignUp(elementCount * sizeof(u16), sizeof(u32)); // The shader writes pairs of indices as words
+        }
+
+        if (!sequence) {
+            // The contents of GPU dirty buffers can change without the sequence being advanced so the conversion can't be cached, it's written into the megabuffer instead
+            auto storageBufferAlignment{ctx.gpu.helperShaders.quadConversionHelperShader.storageBufferAlignment};
+            auto allocation{ctx.gpu.megaBufferAllocator.Allocate(ctx.executor.cycle, size + storageBufferAlignment)}; // The allocation is padded so that its offset can be aligned for binding it as a storage buffer
+            BufferBinding binding{allocation.buffer, util::AlignUp(allocation.offset, storageBufferAlignment), size};
+            RecordIndexConversion(ctx, indexSize, *view, binding, elementCount, quadConversion);
+            return binding;
+        }
+
+        ConversionKey key{buffer, view->GetOffset(), elementCount, indexSize, quadConversion};
+        if (conversionCache.size() >= MaxConversionCacheSize && !conversionCache.contains(key))
+            conversionCache.clear(); // Any converted buffers still in use are retained by the cycles they're attached to
+
+        auto &entry{conversionCache[key]};
+        bool sameSource{entry.converted && entry.source.lock().get() == buffer};
+        if (!sameSource || entry.sequenceNumber != *sequence) {
+            // The prior converted buffer can be overwritten in place unless it was used in this execution, the conversion is recorded prior to the render pass which may contain draws that use the prior contents
+            if (!sameSource || entry.executionNumber == ctx.executor.executionNumber)
+                entry.converted = std::make_shared<memory::Buffer>(ctx.gpu.memory.AllocateBuffer(size));
+
+            entry.source = buffer->weak_from_this();
+            entry.sequenceNumber = *sequence;
+            RecordIndexConversion(ctx, indexSize, *view, BufferBinding{entry.converted->vkBuffer, 0, size}, elementCount, quadConversion);
+        }
+
+        entry.executionNumber = ctx.executor.executionNumber;
+        ctx.executor.cycle->AttachObject(entry.converted);
+        return {entry.converted->vkBuffer, 0, size};
+    }
+
     void IndexBufferState::Flush(InterconnectContext &ctx, StateUpdateBuilder &builder, bool quadConversion, u32 elementCount) {
         usedElementCount = elementCount;
         usedQuadConversion = quadConversion;
+        usedIndexConversion = engine->indexBuffer.indexSize == engine::IndexBuffer::IndexSize::OneByte && !ctx.gpu.traits.supportsUint8Indices;
 
         size_t size{GetIndexBufferSize(engine->indexBuffer.indexSize, elementCount)};
         view.Update(ctx, engine->indexBuffer.address, size);
@@ -128,12 +242,12 @@ namespace skyline::gpu::interconnect::maxwell3d {
 
         ctx.executor.AttachBuffer(*view);
 
-        indexType = ConvertIndexType(engine->indexBuffer.indexSize);
-
-        if (quadConversion)
-            megaBufferBinding = GenerateQuadConversionIndexBuffer(ctx, engine->indexBuffer.indexSize, *view, elementCount);
-        else
+        if (quadConversion || usedIndexConversion) {
+            megaBufferBinding = GenerateConversionIndexBuffer(ctx, quadConversion, elementCount);
+        } else {
+            indexType = ConvertIndexType(engine->indexBuffer.indexSize);
             megaBufferBinding = view->TryMegaBuffer(ctx.executor.cycle, ctx.gpu.megaBufferAllocator, ctx.executor.executionNumber);
+        }
 
         if (megaBufferBinding)
             builder.SetIndexBuffer(megaBufferBinding, indexType);
@@ -148,9 +262,9 @@ namespace skyline::gpu::interconnect::maxwell3d {
         if (quadConversion != usedQuadConversion)
             return true;
 
-        // TODO: optimise this to use buffer sequencing to avoid needing to regenerate the quad buffer every time. We can't use as it is rn though because sequences aren't globally unique and may conflict after buffer recreation
-        if (usedQuadConversion) {
-            megaBufferBinding = GenerateQuadConversionIndexBuffer(ctx, engine->indexBuffer.indexSize, *view, elementCount);
+        if (usedQuadConversion || usedIndexConversion) {
+            // Converted buffers are cached by the sequence of the guest buffer so this only converts the indices again if they've changed
+            megaBufferBinding = GenerateConversionIndexBuffer(ctx, usedQuadConversion, elementCount);
             builder.SetIndexBuffer(megaBufferBinding, indexType);
         } else if (megaBufferBinding) {
             if (auto newMegaBufferBinding{view->TryMegaBuffer(ctx.executor.cycle, ctx.gpu.megaBufferAllocator, ctx.executor.executionNumber)};
@@ -170,6 +284,7 @@ namespace skyline::gpu::interconnect::maxwell3d {
     void IndexBufferState::PurgeCaches() {
         view.PurgeCaches();
         megaBufferBinding = {};
+        conversionCache.clear();
     }
 
     /* Transform Feedback Buffer */
@@ -188,7 +303,9 @@ namespace skyline::gpu::interconnect::maxwell3d {
                     ctx.executor.AttachBuffer(*view);
 
                     view->GetBuffer()->MarkGpuDirty();
-                    builder.SetTransformFeedbackBuffer(index, *view);
+                    // Hosts without transform feedback only use the view for pipelines which emulate it through descriptors
+                    if (ctx.gpu.traits.supportsTransformFeedback)
+                        builder.SetTransformFeedbackBuffer(index, *view);
                     return;
                 } else {
                     Logger::Warn("Unmapped transform feedback buffer: 0x{:X}", engine->streamOutBuffer.address);
@@ -196,7 +313,8 @@ namespace skyline::gpu::interconnect::maxwell3d {
             }
 
             // Bind an empty buffer ourselves since Vulkan doesn't support passing a VK_NULL_HANDLE xfb buffer
-            builder.SetTransformFeedbackBuffer(index, {ctx.gpu.megaBufferAllocator.Allocate(ctx.executor.cycle, 0).buffer});
+            if (ctx.gpu.traits.supportsTransformFeedback)
+                builder.SetTransformFeedbackBuffer(index, {ctx.gpu.megaBufferAllocator.Allocate(ctx.executor.cycle, 0).buffer});
         }
     }
 
@@ -204,6 +322,13 @@ namespace skyline::gpu::interconnect::maxwell3d {
         view.PurgeCaches();
     }
 
+    BufferView TransformFeedbackBufferState::GetView() {
+        if (!engine->streamOutEnable || !engine->streamOutBuffer.size)
+            return {};
+
+        return *view;
+    }
+
     /* Viewport */
     void ViewportState::EngineRegisters::DirtyBind(DirtyManager &manager, dirty::Handle handle) const {
         manager.Bind(handle,
@@ -217,13 +342,13 @@ namespace skyline::gpu::interconnect::maxwell3d {
 
     ViewportState::ViewportState(dirty::Handle dirtyHandle, DirtyManager &manager, const EngineRegisters &engine, u32 index) : engine{manager, dirtyHandle, engine}, index{index} {}
 
-    static vk::Viewport ConvertViewport(const engine::Viewport &viewport, const engine::ViewportClip &viewportClip, const engine::WindowOrigin &windowOrigin, bool viewportScaleOffsetEnable) {
+    static vk::Viewport ConvertViewport(const engine::Viewport &viewport, const engine::ViewportClip &viewportClip, const engine::WindowOrigin &windowOrigin, bool viewportScaleOffsetEnable, float renderTargetScale) {
         vk::Viewport vkViewport{};
 
-        vkViewport.x = viewport.offsetX - viewport.scaleX; // Counteract the addition of the half of the width (o_x) to the host translation
-        vkViewport.width = viewport.scaleX * 2.0f; // Counteract the division of the width (p_x) by 2 for the host scale
-        vkViewport.y = viewport.offsetY - viewport.scaleY; // Counteract the addition of the half of the height (p_y/2 is center) to the host translation (o_y)
-        vkViewport.height = viewport.scaleY * 2.0f; // Counteract the division of the height (p_y) by 2 for the host scale
+        vkViewport.x = (viewport.offsetX - viewport.scaleX) * renderTargetScale; // Counteract the addition of the half of the width (o_x) to the host translation
+        vkViewport.width = viewport.scaleX * 2.0f * renderTargetScale; // Counteract the division of the width (p_x) by 2 for the host scale
+        vkViewport.y = (viewport.offsetY - viewport.scaleY) * renderTargetScale; // Counteract the addition of the half of the height (p_y/2 is center) to the host translation (o_y)
+        vkViewport.height = viewport.scaleY * 2.0f * renderTargetScale; // Counteract the division of the height (p_y) by 2 for the host scale
 
         using CoordinateSwizzle = engine::Viewport::CoordinateSwizzle;
         if (viewport.swizzle.x != CoordinateSwizzle::PosX &&
@@ -248,7 +373,7 @@ namespace skyline::gpu::interconnect::maxwell3d {
         return vkViewport;
     }
 
-    void ViewportState::Flush(InterconnectContext &ctx, StateUpdateBuilder &builder) {
+    void ViewportState::Flush(InterconnectContext &ctx, StateUpdateBuilder &builder, float renderTargetScale) {
         if (index != 0 && !ctx.gpu.traits.supportsMultipleViewports)
             return;
 
@@ -257,9 +382,9 @@ namespace skyline::gpu::interconnect::maxwell3d {
             Logger::Warn("Viewport scale/offset disable is unimplemented");
 
         if (engine->viewport.scaleX == 0.0f || engine->viewport.scaleY == 0.0f)
-            builder.SetViewport(index, ConvertViewport(engine->viewport0, engine->viewportClip0, engine->windowOrigin, engine->viewportScaleOffsetEnable));
+            builder.SetViewport(index, ConvertViewport(engine->viewport0, engine->viewportClip0, engine->windowOrigin, engine->viewportScaleOffsetEnable, renderTargetScale));
         else
-            builder.SetViewport(index, ConvertViewport(engine->viewport, engine->viewportClip, engine->windowOrigin, engine->viewportScaleOffsetEnable));
+            builder.SetViewport(index, ConvertViewport(engine->viewport, engine->viewportClip, engine->windowOrigin, engine->viewportScaleOffsetEnable, renderTargetScale));
     }
 
     /* Scissor */
@@ -269,7 +394,7 @@ namespace skyline::gpu::interconnect::maxwell3d {
 
     ScissorState::ScissorState(dirty::Handle dirtyHandle, DirtyManager &manager, const EngineRegisters &engine, u32 index) : engine{manager, dirtyHandle, engine}, index{index} {}
 
-    void ScissorState::Flush(InterconnectContext &ctx, StateUpdateBuilder &builder) {
+    void ScissorState::Flush(InterconnectContext &ctx, StateUpdateBuilder &builder, float renderTargetScale) {
         if (index != 0 && !ctx.gpu.traits.supportsMultipleViewports)
             return;
 
@@ -278,7 +403,7 @@ namespace skyline::gpu::interconnect::maxwell3d {
                 const auto &vertical{engine->scissor.vertical};
                 const auto &horizontal{engine->scissor.horizontal};
 
-                return vk::Rect2D{
+                return texture::ScaleRect(vk::Rect2D{
                     .offset = {
                         .y = vertical.yMin,
                         .x = horizontal.xMin
@@ -287,7 +412,7 @@ namespace skyline::gpu::interconnect::maxwell3d {
                         .height = static_cast<uint32_t>(vertical.yMax - vertical.yMin),
                         .width = static_cast<uint32_t>(horizontal.xMax - horizontal.xMin)
                     }
-                };
+                }, renderTargetScale);
             } else {
                 return vk::Rect2D{
                     .extent.height = std::numeric_limits<i32>::max(),
@@ -399,12 +524,21 @@ namespace skyline::gpu::interconnect::maxwell3d {
 
         auto updateFunc{[&](auto &stateElem, auto &&... args) { stateElem.Update(ctx, builder, args...); }};
         pipeline.Update(ctx, textures, constantBuffers, builder);
+
+        // Viewports and scissors are specified in guest coordinates, so they need to be reflushed whenever the scale of the bound render targets changes
+        if (float scale{GetRenderTargetScale()}; scale != renderTargetScale) {
+            renderTargetScale = scale;
+            ranges::for_each(viewports, [](auto &viewport) { viewport.MarkDirty(false); });
+            ranges::for_each(scissors, [](auto &scissor) { scissor.MarkDirty(false); });
+        }
+
         ranges::for_each(vertexBuffers, updateFunc);
         if (indexed)
             updateFunc(indexBuffer, directState.inputAssembly.NeedsQuadConversion(), drawElementCount);
-        ranges::for_each(transformFeedbackBuffers, updateFunc);
-        ranges::for_each(viewports, updateFunc);
-        ranges::for_each(scissors, updateFunc);
+        // Arrays of states that don't need to be refreshed only flush their dirty elements which are found by scanning their dirty bits
+        dirty::UpdateAll(transformFeedbackBuffers, ctx, builder);
+        dirty::UpdateAll(viewports, ctx, builder, renderTargetScale);
+        dirty::UpdateAll(scissors, ctx, builder, renderTargetScale);
         updateFunc(lineWidth);
         updateFunc(depthBias);
         updateFunc(blendConstants);
@@ -424,6 +558,25 @@ namespace skyline::gpu::interconnect::maxwell3d {
         return pipeline.Get().depthAttachment;
     }
 
+    std::array<BufferView, engine::StreamOutBufferCount> ActiveState::GetTransformFeedbackBuffers() {
+        std::array<BufferView, engine::StreamOutBufferCount> views;
+        for (size_t i{}; i < engine::StreamOutBufferCount; i++)
+            views[i] = transformFeedbackBuffers[i].Get().GetView();
+        return views;
+    }
+
+    float ActiveState::GetRenderTargetScale() {
+        std::optional<float> scale;
+        auto applyAttachment{[&](TextureView *view) {
+            if (view)
+                scale = std::min(scale.value_or(view->texture->scale), view->texture->scale);
+        }};
+
+        ranges::for_each(GetColorAttachments(), applyAttachment);
+        applyAttachment(GetDepthAttachment());
+        return scale.value_or(1.0f);
+    }
+
     std::shared_ptr<TextureView> ActiveState::GetColorRenderTargetForClear(InterconnectContext &ctx, size_t index) {
         return pipeline.Get().GetColorRenderTargetForClear(ctx, index);
     }
@@ -49,6 +49,39 @@ namespace skyline::gpu::interconnect::maxwell3d {
         vk::IndexType indexType{};
         u32 usedElementCount{};
         bool usedQuadConversion{};
+        bool usedIndexConversion{}; //!< If 8-bit indices were widened to 16-bit indices as the host doesn't support them
+
+        struct ConversionKey {
+            Buffer *buffer;
+            vk::DeviceSize offset;
+            u32 elementCount;
+            engine::IndexBuffer::IndexSize indexSize;
+            bool quadConversion;
+
+            bool operator==(const ConversionKey &other) const = default;
+        };
+
+        struct ConversionKeyHash {
+            size_t operator()(const ConversionKey &key) const;
+        };
+
+        /**
+         * @brief A GPU converted copy of guest indices which is reused for as long as the contents of the guest buffer don't change, this allows static geometry to only be converted once
+         */
+        struct ConversionEntry {
+            std::weak_ptr<Buffer> source; //!< The buffer that the indices were converted from, this differentiates it from any buffer recreated at the same address which would restart the sequence
+            u32 sequenceNumber{}; //!< The sequence number of the source buffer at the time of the conversion
+            u32 executionNumber{}; //!< The number of the execution that the converted buffer was last used in
+            std::shared_ptr<memory::Buffer> converted;
+        };
+
+        static constexpr size_t MaxConversionCacheSize{64}; //!< The maximum amount of cached conversions, the cache is cleared entirely after this is exceeded
+        std::unordered_map<ConversionKey, ConversionEntry, ConversionKeyHash> conversionCache;
+
+        /**
+         * @brief Converts the bound index buffer for quad conversion and/or to widen 8-bit indices, this sets `indexType` to the type of the converted indices
+         */
+        BufferBinding GenerateConversionIndexBuffer(InterconnectContext &ctx, bool quadConversion, u32 elementCount);
 
       public:
         IndexBufferState(dirty::Handle dirtyHandle, DirtyManager &manager, const EngineRegisters &engine);
@@ -80,6 +113,12 @@ namespace skyline::gpu::interconnect::maxwell3d {
         void Flush(InterconnectContext &ctx, StateUpdateBuilder &builder);
 
         void PurgeCaches();
+
+        /**
+         * @return A view of the buffer that outputs are captured into, this is null if the buffer is disabled or unmapped
+         * @note This is only valid after a call to Flush()
+         */
+        BufferView GetView();
     };
 
     class ViewportState : dirty::ManualDirty {
@@ -102,7 +141,10 @@ namespace skyline::gpu::interconnect::maxwell3d {
       public:
         ViewportState(dirty::Handle dirtyHandle, DirtyManager &manager, const EngineRegisters &engine, u32 index);
 
-        void Flush(InterconnectContext &ctx, StateUpdateBuilder &builder);
+        /**
+         * @param renderTargetScale The resolution scale of the bound render targets, the guest viewport is scaled by this
+         */
+        void Flush(InterconnectContext &ctx, StateUpdateBuilder &builder, float renderTargetScale);
     };
 
     class ScissorState : dirty::ManualDirty {
@@ -120,7 +162,10 @@ namespace skyline::gpu::interconnect::maxwell3d {
       public:
         ScissorState(dirty::Handle dirtyHandle, DirtyManager &manager, const EngineRegisters &engine, u32 index);
 
-        void Flush(InterconnectContext &ctx, StateUpdateBuilder &builder);
+        /**
+         * @param renderTargetScale The resolution scale of the bound render targets, the guest scissor is scaled by this
+         */
+        void Flush(InterconnectContext &ctx, StateUpdateBuilder &builder, float renderTargetScale);
     };
 
     struct LineWidthState : dirty::ManualDirty {
@@ -231,6 +276,7 @@ namespace skyline::gpu::interconnect::maxwell3d {
         dirty::ManualDirtyState<BlendConstantsState> blendConstants;
         dirty::ManualDirtyState<DepthBoundsState> depthBounds;
         dirty::ManualDirtyState<StencilValuesState> stencilValues;
+        float renderTargetScale{1.0f}; //!< The resolution scale that viewports and scissors were last flushed with
 
       public:
         struct EngineRegisters {
@@ -264,6 +310,18 @@ namespace skyline::gpu::interconnect::maxwell3d {
 
         TextureView *GetDepthAttachment();
 
+        /**
+         * @return Views of all transform feedback buffers for pipelines which emulate transform feedback
+         * @note This is only valid after a call to Update()
+         */
+        std::array<BufferView, engine::StreamOutBufferCount> GetTransformFeedbackBuffers();
+
+        /**
+         * @return The resolution scale of the bound render targets, the smallest scale is used if they differ so that the render area never exceeds any attachment
+         * @note This is only valid after a call to Update()
+         */
+        float GetRenderTargetScale();
+
         std::shared_ptr<TextureView> GetColorRenderTargetForClear(InterconnectContext &ctx, size_t index);
 
         std::shared_ptr<TextureView> GetDepthRenderTargetForClear(InterconnectContext &ctx);
@@ -7,13 +7,14 @@
 #include "common.h"
 
 namespace skyline::gpu::interconnect::maxwell3d {
-    void CachedMappedBufferView::Update(InterconnectContext &ctx, u64 address, u64 size, bool splitMappingWarn) {
+    void CachedMappedBufferView::Update(InterconnectContext &ctx, u64 address, u64 size, bool splitMappingWarn, bool allowSparse) {
         // Ignore size for the mapping end check here as we don't support buffers split across multiple mappings so only the first one would be used anyway. It's also impossible for the mapping to have been remapped with a larger one since the original lookup because the we force the mapping to be reset after semaphores
         if (address < blockMappingStartAddr || address >= blockMappingEndAddr) {
             u64 blockOffset{};
             std::tie(blockMapping, blockOffset) = ctx.channelCtx.asCtx->gmmu.LookupBlock(address);
             if (!blockMapping.valid()) {
                 view = {};
+                sparseBinding = {};
                 blockMappingEndAddr = 0;
                 return;
             }
@@ -31,6 +32,15 @@ namespace skyline::gpu::interconnect::maxwell3d {
         // Mapping covering just the requested input view (or less in the case of split mappings)
         auto viewMapping{fullMapping.first(std::min(fullMapping.size(), size))};
 
+        if (allowSparse && ctx.channelCtx.asCtx->gmmu.IsSparseMapping(viewMapping)) {
+            if (sparseBinding = ctx.gpu.buffer.GetSparseBinding(viewMapping.size()); sparseBinding) {
+                view = {};
+                return;
+            }
+        } else {
+            sparseBinding = {};
+        }
+
         // First attempt to skip lookup by trying to reuse the previous view's underlying buffer
         if (view)
             if (view = view.GetBuffer()->TryGetView(viewMapping); view)
@@ -44,6 +54,49 @@ namespace skyline::gpu::interconnect::maxwell3d {
 
     void CachedMappedBufferView::PurgeCaches() {
         view = {};
+        sparseBinding = {};
         blockMappingEndAddr = 0; // Will force a retranslate of `blockMapping` on the next `Update()` call
     }
+
+    PoolWriteTracker::~PoolWriteTracker() {
+        if (trap)
+            nce->DeleteTrap(*trap);
+    }
+
+    void PoolWriteTracker::Track(InterconnectContext &ctx, span<u8> poolRegion) {
+        bool sameRegion{region.data() == poolRegion.data() && region.size() == poolRegion.size()};
+        if (sameRegion && (!trap || (state.load(std::memory_order_acquire) & 1)))
+            return;
+
+        if (!sameRegion) {
+            if (trap) {
+                nce->DeleteTrap(*trap);
+                trap.reset();
+            }
+
+            // Any descriptors cached from the previous region are invalidated by bumping the generation, an empty region is never tracked
+            region = poolRegion;
+            state.store(((state.load(std::memory_order_relaxed) >> 1) + 1) << 1, std::memory_order_release);
+            if (region.empty())
+                return;
+
+            nce = &ctx.nce;
+            trap = ctx.nce.CreateTrap(region, [this]() {
+                std::scoped_lock lock{mutex};
+            }, []() { return true; }, [this]() {
+                std::unique_lock lock{mutex, std::try_to_lock};
+                if (!lock)
+                    return false;
+
+                // Bumping the generation while clearing the armed bit invalidates any descriptors cached prior to the write
+                state.store(((state.load(std::memory_order_relaxed) >> 1) + 1) << 1, std::memory_order_release);
+                return true;
+            });
+        }
+
+        // The trap must be armed prior to the generation being published, any writes in between are caught by the trap and bump the generation again
+        std::scoped_lock lock{mutex};
+        ctx.nce.TrapRegions(*trap, true);
+        state.store((((state.load(std::memory_order_relaxed) >> 1) + 1) << 1) | 1, std::memory_order_release);
+    }
 }
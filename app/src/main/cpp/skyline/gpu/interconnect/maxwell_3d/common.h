@@ -7,6 +7,7 @@
 #include <vulkan/vulkan_raii.hpp>
 #include <soc/gm20b/engines/maxwell/types.h>
 #include <gpu/buffer.h>
+#include <nce.h>
 
 namespace skyline::kernel {
     class MemoryManager;
@@ -27,6 +28,7 @@ namespace skyline::gpu::interconnect::maxwell3d {
      * @brief Holds GPU context for an interconnect instance
      */
     struct InterconnectContext {
+        const DeviceState &state;
         soc::gm20b::ChannelContext &channelCtx;
         CommandExecutor &executor;
         GPU &gpu;
@@ -45,11 +47,13 @@ namespace skyline::gpu::interconnect::maxwell3d {
 
       public:
         BufferView view; //!< The buffer view created as a result of a call to `Update()`
+        BufferBinding sparseBinding; //!< A binding to the sparse buffer which is used in place of `view` when the mapping is sparse, this is only set if sparse bindings were allowed in the call to `Update()`
 
         /**
          * @brief Updates `view` based on the supplied GPU mapping
+         * @param allowSparse If sparse mappings should be bound to the host sparse buffer through `sparseBinding` rather than creating a guest buffer over the zero filled sparse map, this must only be used by callers that never access the buffer contents on the CPU
          */
-        void Update(InterconnectContext &ctx, u64 address, u64 size, bool splitMappingWarn = true);
+        void Update(InterconnectContext &ctx, u64 address, u64 size, bool splitMappingWarn = true, bool allowSparse = false);
 
         /**
          * @brief Purges the cached block mapping so the next `Update()` call will perform a full lookup
@@ -65,10 +69,44 @@ namespace skyline::gpu::interconnect::maxwell3d {
         }
     };
 
+    /**
+     * @brief Tracks writes to a guest descriptor pool with a write trap, this allows for cached descriptors to be validated by comparing a generation rather than the descriptors themselves
+     * @note The trap is only rearmed once per update of the pool state after it's written to, this avoids repeatedly faulting on pools that are written to between every draw
+     */
+    class PoolWriteTracker {
+      private:
+        nce::NCE *nce{};
+        std::optional<nce::NCE::TrapHandle> trap;
+        span<u8> region; //!< The guest region that's currently trapped
+        std::mutex mutex; //!< Synchronizes the trap callback with rearming the trap
+        std::atomic<u32> state{}; //!< The generation of the pool shifted left by one with the lowest bit set while the trap is armed
+
+      public:
+        PoolWriteTracker() = default;
+
+        PoolWriteTracker(const PoolWriteTracker &) = delete;
+
+        ~PoolWriteTracker();
+
+        /**
+         * @brief Traps the supplied pool region if it isn't trapped already or has been written to since it was last trapped
+         */
+        void Track(InterconnectContext &ctx, span<u8> poolRegion);
+
+        /**
+         * @return A non-zero generation which changes whenever the pool is written to, this is zero while writes aren't being tracked in which case the descriptors need to be compared
+         */
+        u32 GetGeneration() const {
+            u32 value{state.load(std::memory_order_acquire)};
+            return (value & 1) ? value : 0;
+        }
+    };
+
     using DynamicBufferBinding = std::variant<BufferBinding, BufferView>;
     using DirtyManager = dirty::Manager<soc::gm20b::engine::EngineMethodsEnd * sizeof(u32), sizeof(u32)>;
 
     class StateUpdateBuilder;
+    class StateUpdater;
 
     struct DescriptorUpdateInfo {
         span<vk::CopyDescriptorSet> copies; //!< These will be performed before writes
@@ -79,5 +117,21 @@ namespace skyline::gpu::interconnect::maxwell3d {
         vk::DescriptorSetLayout descriptorSetLayout;
         vk::PipelineBindPoint bindPoint;
         u32 descriptorSetIndex;
+        vk::DescriptorUpdateTemplate updateTemplate; //!< If non-null, all writes are performed with a single templated update from `templateData` rather than individually, this is only used for full updates
+        const void *templateData; //!< The packed block of descriptor infos that `updateTemplate` reads from, `bufferDescs` are resolved into it prior to the update
+    };
+
+    constexpr u32 MaxPushConstantSize{128}; //!< The maximum size of the push constants of a pipeline, this is the minimum maxPushConstantsSize guaranteed by Vulkan
+
+    /**
+     * @brief The push constants of a draw, these hold the contents of any constant buffers that were promoted to push constants
+     */
+    struct PushConstantUpdateInfo {
+        vk::PipelineLayout pipelineLayout; //!< The layout of the pipeline the push constants are for, this is null if there are no push constants
+        vk::ShaderStageFlags stageFlags;
+        u32 size;
+        std::array<u8, MaxPushConstantSize> data; //!< The contents of the push constants, any bytes past `size` are zero so that updates can be compared directly
+
+        bool operator==(const PushConstantUpdateInfo &) const = default;
     };
 }
@@ -57,6 +57,12 @@ namespace skyline::gpu::interconnect::maxwell3d {
 
         // First attempt the write without setting up the gpu copy callback as a fast path
         if (view.Write(srcCpuBuf, offset)) [[unlikely]] {
+            if (offset + srcCpuBuf.size() > ShadowSize)
+                throw exception("Constant buffer load is outside of the maximum constant buffer size: 0x{:X} + 0x{:X}", offset, srcCpuBuf.size());
+
+            if (pendingLoads->view && (pendingLoads->view->GetBuffer() != view.GetBuffer() || pendingLoads->view->GetOffset() != view.GetOffset()))
+                FlushPendingLoads(ctx); // The shadow can only hold loads for a single view, so flush the loads of the prior one before deferring any to this one
+
             // Store callback data in a stack allocated struct to avoid heap allocation for the gpu copy callback lambda
             struct GpuCopyCallbackData {
                 InterconnectContext &ctx;
@@ -64,30 +70,73 @@ namespace skyline::gpu::interconnect::maxwell3d {
                 u32 offset;
                 ContextLock<BufferView> &lock;
                 BufferView &view;
-            } callbackData{ctx, srcCpuBuf, offset, lock, view};
+                PendingLoads &pending;
+            } callbackData{ctx, srcCpuBuf, offset, lock, view, *pendingLoads};
 
             view.Write(srcCpuBuf, offset, [&callbackData]() {
                 callbackData.ctx.executor.AttachLockedBufferView(callbackData.view, std::move(callbackData.lock));
                 // This will prevent any CPU accesses to backing for the duration of the usage
                 callbackData.view.GetBuffer()->BlockAllCpuBackingWrites();
 
-                auto srcGpuAllocation{callbackData.ctx.gpu.megaBufferAllocator.Push(callbackData.ctx.executor.cycle, callbackData.srcCpuBuf)};
-                callbackData.ctx.executor.AddOutsideRpCommand([=, srcCpuBuf = callbackData.srcCpuBuf, view = callbackData.view, offset = callbackData.offset](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &, GPU &) {
-                    vk::BufferCopy copyRegion{
-                        .size = srcCpuBuf.size_bytes(),
-                        .srcOffset = srcGpuAllocation.offset,
-                        .dstOffset = view.GetOffset() + offset
-                    };
-                    commandBuffer.copyBuffer(srcGpuAllocation.buffer, view.GetBuffer()->GetBacking(), copyRegion);
-                    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eAllCommands, {}, vk::MemoryBarrier{
-                        .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
-                        .dstAccessMask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite
-                    }, {}, {});
-                });
+                // The copy itself is deferred till the next flush, writing into the shadow is idempotent so this callback being invoked multiple times for a single write is harmless
+                auto &pending{callbackData.pending};
+                if (!pending.view)
+                    pending.view = callbackData.view;
+
+                std::memcpy(pending.shadow.data() + callbackData.offset, callbackData.srcCpuBuf.data(), callbackData.srcCpuBuf.size());
+                size_t wordIndex{callbackData.offset / sizeof(u32)}, wordEnd{wordIndex + callbackData.srcCpuBuf.size() / sizeof(u32)};
+                for (; wordIndex < wordEnd; wordIndex++)
+                    pending.dirtyWords.set(wordIndex);
+
+                pending.dirtyBegin = std::min<size_t>(pending.dirtyBegin, callbackData.offset);
+                pending.dirtyEnd = std::max<size_t>(pending.dirtyEnd, callbackData.offset + callbackData.srcCpuBuf.size());
             });
         }
     }
 
+    void ConstantBuffers::FlushPendingLoads(InterconnectContext &ctx) {
+        auto &pending{*pendingLoads};
+        if (!pending.view)
+            return;
+
+        // The entire dirty range is pushed at once, any gaps between loads are skipped over by only copying contiguous runs of dirty words out of it
+        auto srcGpuAllocation{ctx.gpu.megaBufferAllocator.Push(ctx.executor.cycle, span<u8>{pending.shadow}.subspan(pending.dirtyBegin, pending.dirtyEnd - pending.dirtyBegin))};
+
+        boost::container::small_vector<vk::BufferCopy, 4> copyRegions;
+        size_t wordIndex{pending.dirtyBegin / sizeof(u32)}, wordEnd{pending.dirtyEnd / sizeof(u32)};
+        while (wordIndex < wordEnd) {
+            if (!pending.dirtyWords.test(wordIndex)) {
+                wordIndex++;
+                continue;
+            }
+
+            size_t runStart{wordIndex};
+            while (wordIndex < wordEnd && pending.dirtyWords.test(wordIndex))
+                pending.dirtyWords.reset(wordIndex++);
+
+            copyRegions.push_back(vk::BufferCopy{
+                .srcOffset = srcGpuAllocation.offset + (runStart * sizeof(u32) - pending.dirtyBegin),
+                .dstOffset = runStart * sizeof(u32), // This is relative to the view and offset by the view's offset during recording as it may change until then
+                .size = (wordIndex - runStart) * sizeof(u32),
+            });
+        }
+
+        ctx.executor.AddOutsideRpCommand([=, view = *pending.view](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &, GPU &) mutable {
+            for (auto &copyRegion : copyRegions)
+                copyRegion.dstOffset += view.GetOffset();
+
+            commandBuffer.copyBuffer(srcGpuAllocation.buffer, view.GetBuffer()->GetBacking(), copyRegions);
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eAllCommands, {}, vk::MemoryBarrier{
+                .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+                .dstAccessMask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite
+            }, {}, {});
+        });
+
+        pending.view.reset();
+        pending.dirtyBegin = ShadowSize;
+        pending.dirtyEnd = 0;
+    }
+
     void ConstantBuffers::Bind(InterconnectContext &ctx, engine::ShaderStage stage, size_t index) {
         auto &view{*selectorState.UpdateGet(ctx).view};
         if (!view)
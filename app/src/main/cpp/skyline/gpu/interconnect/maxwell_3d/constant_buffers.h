@@ -51,6 +51,20 @@ namespace skyline::gpu::interconnect::maxwell3d {
       private:
         dirty::ManualDirtyState <ConstantBufferSelectorState> selectorState;
 
+        static constexpr size_t ShadowSize{1 << 17}; //!< The largest constant buffer that can be selected, limited by the 17-bit selector size field
+
+        /**
+         * @brief A CPU-side shadow of constant buffer loads that need to be performed on the GPU, loads between draws are accumulated here and flushed as a single megabuffer push rather than an inline update per load
+         */
+        struct PendingLoads {
+            std::optional<BufferView> view; //!< The view that all pending loads target, this is empty when there are no pending loads
+            std::array<u8, ShadowSize> shadow; //!< The loaded data at its offset within the view, only words marked in `dirtyWords` are valid
+            std::bitset<ShadowSize / sizeof(u32)> dirtyWords; //!< A bitmask of all words in the shadow that have been loaded since the last flush
+            size_t dirtyBegin{ShadowSize}; //!< The offset of the first dirty byte in the shadow
+            size_t dirtyEnd{}; //!< The offset after the last dirty byte in the shadow
+        };
+        std::unique_ptr<PendingLoads> pendingLoads{std::make_unique<PendingLoads>()};
+
       public:
         ConstantBufferSet boundConstantBuffers;
 
@@ -68,8 +82,16 @@ namespace skyline::gpu::interconnect::maxwell3d {
 
         void MarkAllDirty();
 
+        /**
+         * @brief Loads data into the constant buffer pointed to by the selector, any loads that need to be done on the GPU are deferred until FlushPendingLoads is called
+         */
         void Load(InterconnectContext &ctx, span <u32> data, u32 offset);
 
+        /**
+         * @brief Records a single GPU-side copy for all deferred loads, this must be called before any draw or other engine usage that could observe the contents of the loaded constant buffer
+         */
+        void FlushPendingLoads(InterconnectContext &ctx);
+
         void Bind(InterconnectContext &ctx, engine::ShaderStage stage, size_t index);
 
         void Unbind(engine::ShaderStage stage, size_t index);
@@ -2,6 +2,9 @@
 // Copyright © 2022 Ryujinx Team and Contributors (https://github.com/Ryujinx/)
 // Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <range/v3/algorithm.hpp>
+#include <common/settings.h>
+#include <common/perf_stats.h>
 #include <gpu/interconnect/command_executor.h>
 #include <gpu/interconnect/conversion/quads.h>
 #include <soc/gm20b/channel.h>
@@ -11,18 +14,21 @@
 #include "state_updater.h"
 
 namespace skyline::gpu::interconnect::maxwell3d {
-    Maxwell3D::Maxwell3D(GPU &gpu,
+    Maxwell3D::Maxwell3D(const DeviceState &state,
+                         GPU &gpu,
                          soc::gm20b::ChannelContext &channelCtx,
                          nce::NCE &nce,
                          skyline::kernel::MemoryManager &memoryManager,
                          DirtyManager &manager,
                          const EngineRegisterBundle &registerBundle)
-        : ctx{channelCtx, channelCtx.executor, gpu, nce, memoryManager},
+        : ctx{state, channelCtx, channelCtx.executor, gpu, nce, memoryManager},
           activeState{manager, registerBundle.activeStateRegisters},
           clearEngineRegisters{registerBundle.clearRegisters},
           constantBuffers{manager, registerBundle.constantBufferSelectorRegisters},
           samplers{manager, registerBundle.samplerPoolRegisters},
+          samplerBinding{registerBundle.samplerBinding},
           textures{manager, registerBundle.texturePoolRegisters},
+          queries{registerBundle.queryRegisters},
           directState{activeState.directState} {
         ctx.executor.AddFlushCallback([this] {
             if (attachedDescriptorSets) {
@@ -30,6 +36,10 @@ namespace skyline::gpu::interconnect::maxwell3d {
                 attachedDescriptorSets = nullptr;
                 activeDescriptorSet = nullptr;
             }
+            writtenDescriptorSets.clear(); // Any sets written during this execution will be freed once it's complete
+            bindingTracker.Reset();
+            recordedPushConstants = {};
+            drawBatch.params = nullptr; // Draw parameters are allocated from the executor's allocator which is reset by the execution
 
             activeState.MarkAllDirty();
             constantBuffers.MarkAllDirty();
@@ -42,16 +52,18 @@ namespace skyline::gpu::interconnect::maxwell3d {
         ctx.executor.AddPipelineChangeCallback([this] {
             activeState.MarkAllDirty();
             activeDescriptorSet = nullptr;
+            recordedPushConstants = {}; // Other pipelines overwrite the push constants with their own
         });
     }
 
-    vk::DeviceSize Maxwell3D::UpdateQuadConversionBuffer(u32 count, u32 firstVertex) {
-        vk::DeviceSize offset{conversion::quads::GetRequiredBufferSize(firstVertex, sizeof(u32))};
-        vk::DeviceSize size{conversion::quads::GetRequiredBufferSize(count, sizeof(u32)) + offset};
+    void Maxwell3D::UpdateQuadConversionBuffer(u32 vertexCount) {
+        // The buffer is sized for the next power of two vertex count so it's only regenerated a handful of times rather than whenever a larger draw occurs
+        u32 bufferVertexCount{std::bit_ceil(std::max(vertexCount, MinimumQuadConversionVertexCount))};
+        vk::DeviceSize size{conversion::quads::GetRequiredBufferSize(bufferVertexCount, sizeof(u32))};
 
         if (!quadConversionBuffer || quadConversionBuffer->size_bytes() < size) {
             quadConversionBuffer = std::make_shared<memory::Buffer>(ctx.gpu.memory.AllocateBuffer(util::AlignUp(size, PAGE_SIZE)));
-            conversion::quads::GenerateQuadListConversionBuffer(quadConversionBuffer->cast<u32>().data(), firstVertex + count);
+            conversion::quads::GenerateQuadListConversionBuffer(quadConversionBuffer->cast<u32>().data(), bufferVertexCount);
             quadConversionBufferAttached = false;
         }
 
@@ -59,8 +71,72 @@ namespace skyline::gpu::interconnect::maxwell3d {
             ctx.executor.AttachDependency(quadConversionBuffer);
             quadConversionBufferAttached = true;
         }
+    }
+
+    /**
+     * @brief Flattens all state that the contents of a descriptor set written with the supplied full update depend on into a key
+     * @note Buffer bindings are keyed by the underlying buffer and offset of their views at the time of the draw, as the buffer descriptors themselves are only resolved during recording
+     */
+    static void GetDescriptorUpdateKey(const DescriptorUpdateInfo &updateInfo, std::vector<u64> &key) {
+        key.clear();
+        key.push_back(reinterpret_cast<u64>(static_cast<VkDescriptorSetLayout>(updateInfo.descriptorSetLayout)));
+        for (const auto &write : updateInfo.writes) {
+            key.insert(key.end(), {write.dstBinding, write.dstArrayElement, write.descriptorCount, static_cast<u64>(write.descriptorType)});
+
+            if (write.pImageInfo) {
+                for (const auto &imageInfo : span<const vk::DescriptorImageInfo>(write.pImageInfo, write.descriptorCount))
+                    key.insert(key.end(), {reinterpret_cast<u64>(static_cast<VkSampler>(imageInfo.sampler)), reinterpret_cast<u64>(static_cast<VkImageView>(imageInfo.imageView)), static_cast<u64>(imageInfo.imageLayout)});
+            } else if (write.pBufferInfo) {
+                auto dynamicBindings{updateInfo.bufferDescDynamicBindings.subspan(static_cast<size_t>(write.pBufferInfo - updateInfo.bufferDescs.data()), write.descriptorCount)};
+                for (auto &dynamicBinding : dynamicBindings) {
+                    if (auto view{std::get_if<BufferView>(&dynamicBinding)})
+                        key.insert(key.end(), {reinterpret_cast<u64>(view->GetBuffer()), view->GetOffset(), view->size});
+                    else if (auto binding{std::get_if<BufferBinding>(&dynamicBinding)})
+                        key.insert(key.end(), {reinterpret_cast<u64>(static_cast<VkBuffer>(binding->buffer)), binding->offset, binding->size});
+                    else
+                        key.insert(key.end(), {0, 0, 0});
+                }
+            }
+        }
+    }
+
+    void Maxwell3D::BindDescriptorSet(StateUpdateBuilder &builder, DescriptorUpdateInfo *updateInfo) {
+        // Quick bind updates copy from the previously bound set so their contents can't be determined from the update alone, only full updates are considered for reuse
+        u64 hash{};
+        if (updateInfo->copies.empty()) {
+            GetDescriptorUpdateKey(*updateInfo, descriptorUpdateKey);
+            hash = XXH64(descriptorUpdateKey.data(), descriptorUpdateKey.size() * sizeof(u64), 0);
+            // The full key is compared on a hit as a hash collision would otherwise bind a set with the wrong descriptors
+            if (auto it{writtenDescriptorSets.find(hash)}; it != writtenDescriptorSets.end() && it->second.key == descriptorUpdateKey) {
+                // The set is written during recording prior to any subsequent binds since commands are recorded in order, so it'll have the expected contents when it's rebound
+                activeDescriptorSet = it->second.set;
+                builder.SetDescriptorSetWithUpdate(ctx.executor.allocator->EmplaceUntracked<DescriptorUpdateInfo>(DescriptorUpdateInfo{
+                    .pipelineLayout = updateInfo->pipelineLayout,
+                    .descriptorSetLayout = updateInfo->descriptorSetLayout,
+                    .bindPoint = updateInfo->bindPoint,
+                    .descriptorSetIndex = updateInfo->descriptorSetIndex,
+                }), activeDescriptorSet, nullptr);
+                return;
+            }
+        }
+
+        if (!attachedDescriptorSets)
+            attachedDescriptorSets = std::make_shared<boost::container::static_vector<DescriptorAllocator::ActiveDescriptorSet, DescriptorBatchSize>>();
+
+        auto newSet{&attachedDescriptorSets->emplace_back(ctx.gpu.descriptor.AllocateSet(updateInfo->descriptorSetLayout))};
+        auto *oldSet{activeDescriptorSet};
+        activeDescriptorSet = newSet;
+
+        builder.SetDescriptorSetWithUpdate(updateInfo, activeDescriptorSet, oldSet);
 
-        return offset;
+        if (updateInfo->copies.empty())
+            writtenDescriptorSets.insert_or_assign(hash, WrittenDescriptorSet{descriptorUpdateKey, newSet}); // Any colliding entry is replaced as only the most recent set for a hash is kept
+
+        // Batches that are attached stay alive till the end of the execution, so any pointers to the sets in them remain valid
+        if (attachedDescriptorSets->size() == DescriptorBatchSize) {
+            ctx.executor.AttachDependency(attachedDescriptorSets);
+            attachedDescriptorSets.reset();
+        }
     }
 
     vk::Rect2D Maxwell3D::GetClearScissor() {
@@ -126,18 +202,28 @@ namespace skyline::gpu::interconnect::maxwell3d {
         constantBuffers.DisableQuickBind();
     }
 
+    void Maxwell3D::FlushConstantBufferLoads() {
+        constantBuffers.FlushPendingLoads(ctx);
+    }
+
     void Maxwell3D::Clear(engine::ClearSurface &clearSurface) {
+        if (!queries.IsRenderEnabled(ctx))
+            return;
+
         auto scissor{GetClearScissor()};
         if (scissor.extent.width == 0 || scissor.extent.height == 0)
             return;
 
         auto needsAttachmentClearCmd{[&](auto &view) {
-            return scissor.offset.x != 0 || scissor.offset.y != 0 ||
-                scissor.extent != vk::Extent2D{view->texture->dimensions} ||
+            auto viewScissor{texture::ScaleRect(scissor, view->texture->scale)};
+            return viewScissor.offset.x != 0 || viewScissor.offset.y != 0 ||
+                viewScissor.extent != vk::Extent2D{view->texture->dimensions} ||
                 view->range.layerCount != 1 || view->range.baseArrayLayer != 0 || clearSurface.rtArrayIndex != 0;
         }};
 
-        auto clearRects{util::MakeFilledArray<vk::ClearRect, 2>(vk::ClearRect{.rect = scissor, .baseArrayLayer = clearSurface.rtArrayIndex, .layerCount = 1})};
+        // The clear rects are scaled to the resolution of the attachment they're used with, when both attachments are cleared in a single subpass they'll share the same scale
+        std::array<vk::ClearRect, 2> clearRects{};
+        float clearScale{1.0f};
         boost::container::small_vector<vk::ClearAttachment, 2> clearAttachments;
 
         std::shared_ptr<TextureView> colorView{};
@@ -156,6 +242,8 @@ namespace skyline::gpu::interconnect::maxwell3d {
                 }
 
                 if (needsAttachmentClearCmd(view)) {
+                    clearRects[clearAttachments.size()] = {.rect = texture::ScaleRect(scissor, view->texture->scale), .baseArrayLayer = clearSurface.rtArrayIndex, .layerCount = 1};
+                    clearScale = view->texture->scale;
                     clearAttachments.push_back({.aspectMask = view->range.aspectMask, .clearValue = {clearEngineRegisters.colorClearValue}});
                     colorView = view;
                 } else {
@@ -180,6 +268,8 @@ namespace skyline::gpu::interconnect::maxwell3d {
                 }
 
                 if (needsAttachmentClearCmd(view) || (!clearSurface.stencilEnable && viewHasStencil) || (!clearSurface.zEnable && viewHasDepth)) { // Subpass clears write to all aspects of the texture, so we can't use them when only one component is enabled
+                    clearRects[clearAttachments.size()] = {.rect = texture::ScaleRect(scissor, view->texture->scale), .baseArrayLayer = clearSurface.rtArrayIndex, .layerCount = 1};
+                    clearScale = clearAttachments.empty() ? view->texture->scale : std::min(clearScale, view->texture->scale);
                     clearAttachments.push_back({.aspectMask = view->range.aspectMask, .clearValue = clearValue});
                     depthStencilView = view;
                 } else {
@@ -193,7 +283,7 @@ namespace skyline::gpu::interconnect::maxwell3d {
 
         // Always use surfaceClip for render area since it's more likely to match the renderArea of draws and avoid an RP break
         const auto &surfaceClip{clearEngineRegisters.surfaceClip};
-        vk::Rect2D renderArea{{surfaceClip.horizontal.x, surfaceClip.vertical.y}, {surfaceClip.horizontal.width, surfaceClip.vertical.height}};
+        vk::Rect2D renderArea{texture::ScaleRect({{surfaceClip.horizontal.x, surfaceClip.vertical.y}, {surfaceClip.horizontal.width, surfaceClip.vertical.height}}, clearScale)};
 
         std::array<TextureView *, 1> colorAttachments{colorView ? &*colorView : nullptr};
         ctx.executor.AddSubpass([clearAttachments, clearRects](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &, GPU &, vk::RenderPass, u32) {
@@ -201,27 +291,58 @@ namespace skyline::gpu::interconnect::maxwell3d {
         }, renderArea, {}, colorView ? colorAttachments : span<TextureView *>{}, depthStencilView ? &*depthStencilView : nullptr);
     }
 
-    void Maxwell3D::Draw(engine::DrawTopology topology, bool transformFeedbackEnable, bool indexed, u32 count, u32 first, u32 instanceCount, u32 vertexOffset, u32 firstInstance) {
-        StateUpdateBuilder builder{*ctx.executor.allocator};
+    vk::Rect2D Maxwell3D::GetRenderArea() {
+        const auto &surfaceClip{clearEngineRegisters.surfaceClip};
+        return {
+            {surfaceClip.horizontal.x, surfaceClip.vertical.y},
+            {surfaceClip.horizontal.width, surfaceClip.vertical.height}
+        };
+    }
 
-        Pipeline *oldPipeline{activeState.GetPipeline()};
+    Pipeline *Maxwell3D::UpdateDrawState(StateUpdateBuilder &builder, vk::Rect2D &renderArea, engine::DrawTopology topology, bool indexed, u32 count) {
+        constantBuffers.FlushPendingLoads(ctx); // Deferred loads must be recorded prior to the draw's render pass for their results to be visible to it
+
+        Pipeline *oldPipeline{pipelineBound ? activeState.GetPipeline() : nullptr};
         activeState.Update(ctx, textures, constantBuffers.boundConstantBuffers, builder, indexed, topology, count);
-        if (directState.inputAssembly.NeedsQuadConversion()) {
-            count = conversion::quads::GetIndexCount(count);
-            first = 0;
+        renderArea = texture::ScaleRect(renderArea, activeState.GetRenderTargetScale());
 
-            if (!indexed) {
-                // Use an index buffer to emulate quad lists with a triangle list input topology
-                vk::DeviceSize offset{UpdateQuadConversionBuffer(count, first)};
-                builder.SetIndexBuffer(BufferBinding{quadConversionBuffer->vkBuffer, offset}, vk::IndexType::eUint32);
-                indexed = true;
-            }
+        if (ctx.executor.NeedsStateReset(subpassSequence, renderArea, {}, activeState.GetColorAttachments(), activeState.GetDepthAttachment())) {
+            // The draw will be recorded into a different command buffer from prior draws which doesn't inherit any of their state, so all state needs to be recorded again
+            activeState.MarkAllDirty();
+            bindingTracker.Reset();
+            recordedPushConstants = {};
+            activeState.Update(ctx, textures, constantBuffers.boundConstantBuffers, builder, indexed, topology, count);
+            oldPipeline = nullptr;
+            activeDescriptorSet = nullptr;
+            writtenDescriptorSets.clear(); // Sets written in other subpasses might be recorded concurrently, so they can't be rebound
         }
 
+        return oldPipeline;
+    }
+
+    std::optional<StateUpdater> Maxwell3D::FinishDrawState(StateUpdateBuilder &builder, vk::Rect2D renderArea, Pipeline *oldPipeline, const spirv::TransformFeedbackParams &transformFeedbackParams) {
         Pipeline *pipeline{activeState.GetPipeline()};
 
+        // If the pipeline is still being compiled, we either skip the draw or block till compilation has finished based on the user's preference
+        pipelineBound = pipeline->CheckCompiled(!*ctx.state.settings->skipAsyncPipelineDraws);
+        if (!pipelineBound) {
+            // Any state updates from this draw still need to be recorded as they are only emitted when the state changes, the subpass matches that of the draw to avoid breaking up the render pass
+            auto *stateUpdater{ctx.executor.allocator->EmplaceUntracked<StateUpdater>(builder.Build())};
+
+            ctx.executor.AddSubpass([stateUpdater](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &, GPU &gpu, vk::RenderPass, u32) {
+                stateUpdater->RecordAll(gpu, commandBuffer);
+            }, renderArea, {}, activeState.GetColorAttachments(), activeState.GetDepthAttachment(), !ctx.gpu.traits.quirks.relaxedRenderPassCompatibility);
+            subpassSequence = ctx.executor.GetSubpassSequence();
+
+            constantBuffers.ResetQuickBind();
+            return std::nullopt;
+        }
+
+        samplers.Update(ctx, samplerBinding.value == engine::SamplerBinding::Value::ViaHeaderBinding);
+
         auto *descUpdateInfo{[&]() -> DescriptorUpdateInfo * {
-            if (((oldPipeline == pipeline) || (oldPipeline && oldPipeline->CheckBindingMatch(pipeline))) && constantBuffers.quickBindEnabled) {
+            // Transform feedback buffers aren't tracked by quick binds, so pipelines emulating it always need a full update
+            if (((oldPipeline == pipeline) || (oldPipeline && oldPipeline->CheckBindingMatch(pipeline))) && constantBuffers.quickBindEnabled && !pipeline->EmulatesTransformFeedback()) {
                 // If bindings between the old and new pipelines are the same we can reuse the descriptor sets given that quick bind is enabled (meaning that no buffer updates or calls to non-graphics engines have occurred that could invalidate them)
                 if (constantBuffers.quickBind)
                     // If only a single constant buffer has been rebound between draws we can perform a partial descriptor update
@@ -230,74 +351,313 @@ namespace skyline::gpu::interconnect::maxwell3d {
                     return nullptr;
             } else {
                 // If bindings have changed or quick bind is disabled, perform a full descriptor update
-                return pipeline->SyncDescriptors(ctx, constantBuffers.boundConstantBuffers, samplers, textures);
+                return pipeline->SyncDescriptors(ctx, constantBuffers.boundConstantBuffers, samplers, textures, activeState.GetTransformFeedbackBuffers());
             }
         }()};
 
         if (oldPipeline != pipeline)
             // If the pipeline has changed, we need to update the pipeline state
-            builder.SetPipeline(pipeline->compiledPipeline.pipeline);
+            builder.SetPipeline(pipeline->compiledPipeline->GetPipeline());
 
         if (descUpdateInfo) {
             if (ctx.gpu.traits.supportsPushDescriptors) {
                 builder.SetDescriptorSetWithPush(descUpdateInfo);
             } else {
-                if (!attachedDescriptorSets)
-                    attachedDescriptorSets = std::make_shared<boost::container::static_vector<DescriptorAllocator::ActiveDescriptorSet, DescriptorBatchSize>>();
+                BindDescriptorSet(builder, descUpdateInfo);
+            }
+        }
+
+        // Push constants are only recorded when they differ from those of the last draw, so draws with identical contents can still be merged
+        PushConstantUpdateInfo pushConstants;
+        if (pipeline->SyncPushConstants(ctx, constantBuffers.boundConstantBuffers, pushConstants, transformFeedbackParams)) {
+            if (pushConstants != recordedPushConstants) {
+                builder.SetPushConstants(pushConstants);
+                recordedPushConstants = pushConstants;
+            }
+        } else {
+            recordedPushConstants = {}; // The layout of the pipeline is incompatible with that of any prior push constants, binding it may disturb them
+        }
+
+        return builder.Build();
+    }
 
-                auto newSet{&attachedDescriptorSets->emplace_back(ctx.gpu.descriptor.AllocateSet(descUpdateInfo->descriptorSetLayout))};
-                auto *oldSet{activeDescriptorSet};
-                activeDescriptorSet = newSet;
+    /**
+     * @brief Records the CPU time spent building a draw into the draw perf counters once it goes out of scope
+     */
+    struct DrawCpuTimer {
+        i64 start{util::GetTimeNs()};
 
-                builder.SetDescriptorSetWithUpdate(descUpdateInfo, activeDescriptorSet, oldSet);
+        ~DrawCpuTimer() {
+            auto duration{static_cast<u64>(util::GetTimeNs() - start)};
+            PerfStats::Increment(PerfStats::Counter::DrawCpuNs, duration);
+            PerfStats::Record(PerfStats::Histogram::DrawCpu, duration);
+        }
+    };
+
+    /**
+     * @brief Parameters of a run of draws that share all state, this is linearly allocated to avoid a dynamic allocation with lambda captures
+     */
+    struct Maxwell3D::DrawParams {
+        static constexpr u32 MaxDrawCount{16}; //!< The maximum amount of draws that can be merged into a single command
+
+        StateUpdater stateUpdater;
+        u32 instanceCount;
+        u32 firstInstance;
+        bool indexed;
+        bool transformFeedbackEnable;
+        bool transformFeedbackEmulated; //!< If outputs are captured by the pipeline's vertex shader, the parameters of the draw are supplied to it through push constants so it can't be merged with others
+        Queries::SampleQuery sampleQuery; //!< The query that all draws are counted by, this is shared by merged draws as they're performed by a single command
+        u32 drawCount;
+        std::array<vk::MultiDrawIndexedInfoEXT, MaxDrawCount> draws; //!< The parameters of every draw, `indexCount` and `firstIndex` are used as the vertex count and first vertex for non-indexed draws
+
+        void RecordDraws(GPU &gpu, vk::raii::CommandBuffer &commandBuffer) const {
+            if (drawCount > 1 && drawCount <= gpu.traits.maxMultiDrawCount) {
+                // The non-indexed draw info is a prefix of the indexed one, so the same array can be used for both by supplying the stride of the latter
+                auto &dispatcher{*commandBuffer.getDispatcher()};
+                if (indexed)
+                    dispatcher.vkCmdDrawMultiIndexedEXT(*commandBuffer, drawCount, reinterpret_cast<const VkMultiDrawIndexedInfoEXT *>(draws.data()), instanceCount, firstInstance, sizeof(vk::MultiDrawIndexedInfoEXT), nullptr);
+                else
+                    dispatcher.vkCmdDrawMultiEXT(*commandBuffer, drawCount, reinterpret_cast<const VkMultiDrawInfoEXT *>(draws.data()), instanceCount, firstInstance, sizeof(vk::MultiDrawIndexedInfoEXT));
+                return;
+            }
+
+            for (const auto &draw : span(draws).first(drawCount)) {
+                if (indexed)
+                    commandBuffer.drawIndexed(draw.indexCount, instanceCount, draw.firstIndex, draw.vertexOffset, firstInstance);
+                else
+                    commandBuffer.draw(draw.indexCount, instanceCount, draw.firstIndex, firstInstance);
+            }
+        }
+    };
+
+    bool Maxwell3D::CanBatchDraw(const StateUpdater &stateUpdater, vk::Rect2D renderArea, bool indexed, bool transformFeedbackEnable, u32 instanceCount, u32 firstInstance) {
+        auto *params{drawBatch.params};
+        if (!params || !stateUpdater.Empty() || drawBatch.commandSequence != ctx.executor.GetCommandSequence())
+            return false;
+
+        // Transform feedback is begun and ended around every draw, merging draws would change how the feedback buffers are written
+        if (transformFeedbackEnable || params->transformFeedbackEnable || params->transformFeedbackEmulated || params->drawCount == DrawParams::MaxDrawCount)
+            return false;
+
+        // Draws that aren't counted by the sample counter can't be merged into ones which are and vice versa
+        if (static_cast<bool>(params->sampleQuery.pool) != queries.IsCountingSamples())
+            return false;
+
+        // Multi-draws share instancing parameters between all draws, draws with differing ones can't be merged without changing the instance index seen by shaders
+        if (params->indexed != indexed || params->instanceCount != instanceCount || params->firstInstance != firstInstance)
+            return false;
+
+        // Attachments don't affect any state updates, so they need to be compared to ensure the draw would've been added to the same subpass
+        return drawBatch.renderArea == renderArea && drawBatch.depthAttachment == activeState.GetDepthAttachment() && ranges::equal(drawBatch.colorAttachments, activeState.GetColorAttachments());
+    }
+
+    void Maxwell3D::Draw(engine::DrawTopology topology, bool transformFeedbackEnable, bool indexed, u32 count, u32 first, u32 instanceCount, u32 vertexOffset, u32 firstInstance) {
+        if (!queries.IsRenderEnabled(ctx))
+            return;
 
-                if (attachedDescriptorSets->size() == DescriptorBatchSize) {
-                    ctx.executor.AttachDependency(attachedDescriptorSets);
-                    attachedDescriptorSets.reset();
+        DrawCpuTimer timer;
+        PerfStats::Increment(PerfStats::Counter::Draws);
+        StateUpdateBuilder builder{*ctx.executor.allocator, &bindingTracker};
+
+        vk::Rect2D renderArea{GetRenderArea()};
+        Pipeline *oldPipeline{UpdateDrawState(builder, renderArea, topology, indexed, count)};
+
+        spirv::TransformFeedbackParams transformFeedbackParams{};
+        bool transformFeedbackEmulated{transformFeedbackEnable && activeState.GetPipeline()->EmulatesTransformFeedback()};
+        if (transformFeedbackEmulated) {
+            // The vertex index only matches the index of the captured vertex for non-indexed draws of list topologies, capture is disabled for any other draws rather than writing out vertices in the wrong order
+            bool captured{!indexed && (topology == engine::DrawTopology::Points || topology == engine::DrawTopology::Lines || topology == engine::DrawTopology::Triangles)};
+            transformFeedbackParams = {
+                .firstVertex = first,
+                .firstInstance = firstInstance,
+                .vertexCount = captured ? count : 0,
+            };
+        }
+
+        if (directState.inputAssembly.NeedsQuadConversion()) {
+            if (!indexed) {
+                // Use an index buffer to emulate quad lists with a triangle list input topology, the first vertex is applied as the vertex offset so the same buffer can be used for any draw that fits in it
+                UpdateQuadConversionBuffer(count);
+                builder.SetIndexBuffer(BufferBinding{quadConversionBuffer->vkBuffer}, vk::IndexType::eUint32);
+                vertexOffset = first;
+                indexed = true;
+            }
+
+            count = conversion::quads::GetIndexCount(count);
+            first = 0;
+        }
+
+        auto stateUpdater{FinishDrawState(builder, renderArea, oldPipeline, transformFeedbackParams)};
+        if (!stateUpdater)
+            return;
+
+        transformFeedbackEnable = ctx.gpu.traits.supportsTransformFeedback && transformFeedbackEnable;
+        vk::MultiDrawIndexedInfoEXT drawInfo{
+            .firstIndex = first,
+            .indexCount = count,
+            .vertexOffset = static_cast<i32>(vertexOffset),
+        };
+
+        if (CanBatchDraw(*stateUpdater, renderArea, indexed, transformFeedbackEnable || transformFeedbackEmulated, instanceCount, firstInstance)) {
+            // All state matches that of the last draw and nothing was recorded since it, so this draw can be appended to its command rather than adding a new one
+            drawBatch.params->draws[drawBatch.params->drawCount++] = drawInfo;
+            PerfStats::Increment(PerfStats::Counter::BatchedDraws);
+            constantBuffers.ResetQuickBind();
+            return;
+        }
+
+        auto *drawParams{ctx.executor.allocator->EmplaceUntracked<DrawParams>(DrawParams{
+            .stateUpdater = *stateUpdater,
+            .instanceCount = instanceCount,
+            .firstInstance = firstInstance,
+            .indexed = indexed,
+            .transformFeedbackEnable = transformFeedbackEnable,
+            .transformFeedbackEmulated = transformFeedbackEmulated,
+            .sampleQuery = queries.AllocateSampleQuery(ctx),
+            .drawCount = 1,
+            .draws = {drawInfo},
+        })};
+
+        ctx.executor.AddSubpass([drawParams](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &, GPU &gpu, vk::RenderPass, u32) {
+            drawParams->stateUpdater.RecordAll(gpu, commandBuffer);
+            drawParams->sampleQuery.Begin(commandBuffer);
+
+            if (drawParams->transformFeedbackEnable)
+                commandBuffer.beginTransformFeedbackEXT(0, {}, {});
+
+            drawParams->RecordDraws(gpu, commandBuffer);
+
+            if (drawParams->transformFeedbackEnable)
+                commandBuffer.endTransformFeedbackEXT(0, {}, {});
+
+            drawParams->sampleQuery.End(commandBuffer);
+        }, renderArea, {}, activeState.GetColorAttachments(), activeState.GetDepthAttachment(), !ctx.gpu.traits.quirks.relaxedRenderPassCompatibility);
+        subpassSequence = ctx.executor.GetSubpassSequence();
+
+        auto colorAttachments{activeState.GetColorAttachments()};
+        drawBatch = {
+            .params = drawParams,
+            .commandSequence = ctx.executor.GetCommandSequence(),
+            .renderArea = renderArea,
+            .colorAttachments = {colorAttachments.begin(), colorAttachments.end()},
+            .depthAttachment = activeState.GetDepthAttachment(),
+        };
+
+        constantBuffers.ResetQuickBind();
+    }
+
+    void Maxwell3D::DrawIndirect(engine::DrawTopology topology, bool transformFeedbackEnable, bool indexed, span<u8> indirectBuffer, u32 count, u32 stride, u32 indexBufferElementCount) {
+        if (!count || !queries.IsRenderEnabled(ctx))
+            return;
+
+        PerfStats::Increment(PerfStats::Counter::Draws, count);
+        vk::DeviceSize commandSize{indexed ? sizeof(vk::DrawIndexedIndirectCommand) : sizeof(vk::DrawIndirectCommand)};
+        vk::DeviceSize indirectBufferSize{static_cast<vk::DeviceSize>(count - 1) * stride + commandSize};
+        if (indirectBuffer.size() < indirectBufferSize)
+            throw exception("Indirect buffer is smaller than the supplied draws: 0x{:X} < 0x{:X}", indirectBuffer.size(), indirectBufferSize);
+
+        auto indirectView{ctx.gpu.buffer.FindOrCreate(indirectBuffer.first(indirectBufferSize), ctx.executor.tag, [this](std::shared_ptr<Buffer> buffer, ContextLock<Buffer> &&lock) {
+            ctx.executor.AttachLockedBuffer(buffer, std::move(lock));
+        })};
+
+        bool multiDraw{count > 1 && ctx.gpu.traits.supportsMultiDrawIndirect};
+        if (topology == engine::DrawTopology::Quads || (count > 1 && !multiDraw)) {
+            // Quad conversion and splitting up draws both require the parameters on the CPU, they're read back from the buffer as a fallback
+            // This is done prior to attaching the buffer or recording any draw state, so the current execution can be submitted if the parameters were written by it on the GPU
+            std::vector<u8> commands(indirectBufferSize);
+            {
+                ContextLock lock{ctx.executor.tag, indirectView};
+                auto backing{indirectView.GetReadOnlyBackingSpan(lock.IsFirstUsage(), [this]() {
+                    ctx.executor.Submit();
+                })};
+                std::memcpy(commands.data(), backing.data(), commands.size());
+            }
+
+            for (u32 i{}; i < count; i++) {
+                auto command{span(commands).subspan(i * stride)};
+                if (indexed) {
+                    const auto &params{command.as<vk::DrawIndexedIndirectCommand>()};
+                    Draw(topology, transformFeedbackEnable, true, params.indexCount, params.firstIndex, params.instanceCount, static_cast<u32>(params.vertexOffset), params.firstInstance);
+                } else {
+                    const auto &params{command.as<vk::DrawIndirectCommand>()};
+                    Draw(topology, transformFeedbackEnable, false, params.vertexCount, params.firstVertex, params.instanceCount, 0, params.firstInstance);
                 }
             }
+
+            return;
         }
 
-        auto stateUpdater{builder.Build()};
+        ctx.executor.AttachBuffer(indirectView);
+
+        DrawCpuTimer timer; // Split up draws are timed individually by Draw, so only time indirect draws that are performed on the host GPU
+        StateUpdateBuilder builder{*ctx.executor.allocator, &bindingTracker};
+
+        vk::Rect2D renderArea{GetRenderArea()};
+        Pipeline *oldPipeline{UpdateDrawState(builder, renderArea, topology, indexed, indexBufferElementCount)};
+
+        // Vertices of indirect draws aren't captured by pipelines emulating transform feedback as the draw parameters aren't known on the CPU
+        auto stateUpdater{FinishDrawState(builder, renderArea, oldPipeline)};
+        if (!stateUpdater)
+            return;
+
+        // The draw parameters may be written by the GPU, so they're read directly from the guest buffer by the host GPU rather than on the CPU
+        indirectView.GetBuffer()->BlockSequencedCpuBackingWrites();
 
         /**
          * @brief Struct that can be linearly allocated, holding all state for the draw to avoid a dynamic allocation with lambda captures
          */
-        struct DrawParams {
+        struct DrawIndirectParams {
             StateUpdater stateUpdater;
+            BufferView indirectBuffer;
             u32 count;
-            u32 first;
-            u32 instanceCount;
-            u32 vertexOffset;
-            u32 firstInstance;
+            u32 stride;
             bool indexed;
             bool transformFeedbackEnable;
+            Queries::SampleQuery sampleQuery;
         };
-        auto *drawParams{ctx.executor.allocator->EmplaceUntracked<DrawParams>(DrawParams{stateUpdater,
-                                                                                         count, first, instanceCount, vertexOffset, firstInstance, indexed,
-                                                                                         ctx.gpu.traits.supportsTransformFeedback ? transformFeedbackEnable : false})};
-
-        const auto &surfaceClip{clearEngineRegisters.surfaceClip};
-        vk::Rect2D scissor{
-            {surfaceClip.horizontal.x, surfaceClip.vertical.y},
-            {surfaceClip.horizontal.width, surfaceClip.vertical.height}
-        };
+        auto *drawParams{ctx.executor.allocator->EmplaceUntracked<DrawIndirectParams>(DrawIndirectParams{*stateUpdater, indirectView, count, stride, indexed,
+                                                                                                         ctx.gpu.traits.supportsTransformFeedback ? transformFeedbackEnable : false,
+                                                                                                         queries.AllocateSampleQuery(ctx)})};
 
         ctx.executor.AddSubpass([drawParams](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &, GPU &gpu, vk::RenderPass, u32) {
             drawParams->stateUpdater.RecordAll(gpu, commandBuffer);
+            drawParams->sampleQuery.Begin(commandBuffer);
 
             if (drawParams->transformFeedbackEnable)
                 commandBuffer.beginTransformFeedbackEXT(0, {}, {});
 
+            vk::Buffer buffer{drawParams->indirectBuffer.GetBuffer()->GetBacking()};
+            vk::DeviceSize offset{drawParams->indirectBuffer.GetOffset()};
             if (drawParams->indexed)
-                commandBuffer.drawIndexed(drawParams->count, drawParams->instanceCount, drawParams->first, static_cast<i32>(drawParams->vertexOffset), drawParams->firstInstance);
+                commandBuffer.drawIndexedIndirect(buffer, offset, drawParams->count, drawParams->stride);
             else
-                commandBuffer.draw(drawParams->count, drawParams->instanceCount, drawParams->first, drawParams->firstInstance);
+                commandBuffer.drawIndirect(buffer, offset, drawParams->count, drawParams->stride);
 
             if (drawParams->transformFeedbackEnable)
                 commandBuffer.endTransformFeedbackEXT(0, {}, {});
-        }, scissor, {}, activeState.GetColorAttachments(), activeState.GetDepthAttachment(), !ctx.gpu.traits.quirks.relaxedRenderPassCompatibility);
+
+            drawParams->sampleQuery.End(commandBuffer);
+        }, renderArea, {}, activeState.GetColorAttachments(), activeState.GetDepthAttachment(), !ctx.gpu.traits.quirks.relaxedRenderPassCompatibility);
+        subpassSequence = ctx.executor.GetSubpassSequence();
 
         constantBuffers.ResetQuickBind();
     }
+
+    bool Maxwell3D::IsGpuDirty(span<u8> mapping) {
+        return ctx.gpu.buffer.IsGpuDirty(mapping);
+    }
+
+    void Maxwell3D::ResolveQueries() {
+        queries.Resolve(ctx);
+    }
+
+    void Maxwell3D::ResetCounter(engine::CounterReset counter) {
+        queries.ResetCounter(counter);
+        drawBatch.params = nullptr; // Draws after the reset must not be merged into a query from prior to it
+    }
+
+    void Maxwell3D::ReportSampleCounter(u64 address, bool fourWords) {
+        queries.ReportSampleCounter(ctx, address, fourWords);
+        drawBatch.params = nullptr; // Draws after the report must not be merged into a query that contributes to it
+    }
 }
\ No newline at end of file
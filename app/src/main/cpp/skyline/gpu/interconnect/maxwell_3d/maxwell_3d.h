@@ -9,6 +9,8 @@
 #include "constant_buffers.h"
 #include "samplers.h"
 #include "textures.h"
+#include "queries.h"
+#include "state_updater.h"
 
 namespace skyline::gpu::interconnect::maxwell3d {
     /**
@@ -35,7 +37,9 @@ namespace skyline::gpu::interconnect::maxwell3d {
             ClearEngineRegisters clearRegisters;
             ConstantBufferSelectorState::EngineRegisters constantBufferSelectorRegisters;
             SamplerPoolState::EngineRegisters samplerPoolRegisters;
+            const engine::SamplerBinding &samplerBinding;
             TexturePoolState::EngineRegisters texturePoolRegisters;
+            Queries::EngineRegisters queryRegisters;
         };
 
       private:
@@ -44,7 +48,9 @@ namespace skyline::gpu::interconnect::maxwell3d {
         ClearEngineRegisters clearEngineRegisters;
         ConstantBuffers constantBuffers;
         Samplers samplers;
+        const engine::SamplerBinding &samplerBinding;
         Textures textures;
+        Queries queries;
         std::shared_ptr<memory::Buffer> quadConversionBuffer{};
         bool quadConversionBufferAttached{};
 
@@ -52,14 +58,78 @@ namespace skyline::gpu::interconnect::maxwell3d {
         std::shared_ptr<boost::container::static_vector<DescriptorAllocator::ActiveDescriptorSet, DescriptorBatchSize>> attachedDescriptorSets;
         DescriptorAllocator::ActiveDescriptorSet *activeDescriptorSet{};
 
-        size_t UpdateQuadConversionBuffer(u32 count, u32 firstVertex);
+        /**
+         * @brief A descriptor set written with a full update during the current execution alongside the key of that update
+         */
+        struct WrittenDescriptorSet {
+            std::vector<u64> key; //!< The flattened layout, writes and descriptor infos of the update, this is compared on lookup to rule out hash collisions
+            DescriptorAllocator::ActiveDescriptorSet *set;
+        };
+
+        std::unordered_map<u64, WrittenDescriptorSet> writtenDescriptorSets; //!< A map from the hash of the contents of full descriptor updates to the set that was written with them during the current execution, this allows for rebinding an identical set rather than allocating and updating a new one
+        std::vector<u64> descriptorUpdateKey; //!< Scratch storage for the key of the descriptor update being bound, this avoids reallocating it for every draw
+        bool pipelineBound{}; //!< If the active pipeline was bound during the last draw, this is false if the draw was skipped due to the pipeline still being compiled
+        u32 subpassSequence{}; //!< The subpass sequence number of the executor after the last draw, this is used to determine if state must be recorded again when recording is parallelised
+        BufferBindingTracker bindingTracker; //!< The vertex and index buffer bindings recorded into the command buffer of the last draw
+        PushConstantUpdateInfo recordedPushConstants{}; //!< The push constants recorded into the command buffer of the last draw, the layout is null if they need to be recorded again
+
+        struct DrawParams;
+
+        /**
+         * @brief The state of the last draw that is required to determine if subsequent draws can be merged into its command
+         */
+        struct DrawBatchState {
+            DrawParams *params{}; //!< The parameters of the last draw, this is nullptr if no draws can be merged into it
+            size_t commandSequence{}; //!< The command sequence of the executor after the last draw, if any other commands have been added since then draws can't be merged
+            vk::Rect2D renderArea{};
+            boost::container::static_vector<TextureView *, engine::ColorTargetCount> colorAttachments;
+            TextureView *depthAttachment{};
+        } drawBatch;
+
+        /**
+         * @return If a draw with the supplied parameters can be merged into the last draw
+         * @param stateUpdater The state updates of the draw, any state updates prevent merging as they would need to be recorded between the draws
+         */
+        bool CanBatchDraw(const StateUpdater &stateUpdater, vk::Rect2D renderArea, bool indexed, bool transformFeedbackEnable, u32 instanceCount, u32 firstInstance);
+
+        static constexpr u32 MinimumQuadConversionVertexCount{0x400}; //!< The minimum amount of vertices the quad conversion buffer is generated for, this avoids regenerating it repeatedly for small draws
+
+        /**
+         * @brief Ensures the quad conversion buffer holds indices for at least the supplied amount of vertices and is attached to the current execution
+         */
+        void UpdateQuadConversionBuffer(u32 vertexCount);
+
+        /**
+         * @brief Binds the descriptor set for a draw on hosts without push descriptor support, reusing an identical set written earlier in the execution if possible
+         */
+        void BindDescriptorSet(StateUpdateBuilder &builder, DescriptorUpdateInfo *updateInfo);
 
         vk::Rect2D GetClearScissor();
 
+        /**
+         * @return The render area for draws in guest coordinates, this is derived from the surface clip
+         */
+        vk::Rect2D GetRenderArea();
+
+        /**
+         * @brief Updates all active state for a draw, resetting it if the draw will be recorded into a different command buffer from prior draws
+         * @param renderArea The render area of the draw in guest coordinates, it's scaled to the resolution of the bound render targets
+         * @return The pipeline that was bound prior to the draw, if it's still valid for binding comparisons
+         */
+        Pipeline *UpdateDrawState(StateUpdateBuilder &builder, vk::Rect2D &renderArea, engine::DrawTopology topology, bool indexed, u32 count);
+
+        /**
+         * @brief Binds the pipeline and descriptors for a draw after UpdateDrawState
+         * @param transformFeedbackParams The parameters of the draw for pipelines which emulate transform feedback, the default disables capture
+         * @return The state updater for the draw, or std::nullopt if the draw should be skipped as its pipeline is still being compiled
+         */
+        std::optional<StateUpdater> FinishDrawState(StateUpdateBuilder &builder, vk::Rect2D renderArea, Pipeline *oldPipeline, const spirv::TransformFeedbackParams &transformFeedbackParams = {});
+
       public:
         DirectPipelineState &directState;
 
-        Maxwell3D(GPU &gpu,
+        Maxwell3D(const DeviceState &state,
+                  GPU &gpu,
                   soc::gm20b::ChannelContext &channelCtx,
                   nce::NCE &nce,
                   kernel::MemoryManager &memoryManager,
@@ -81,8 +151,38 @@ namespace skyline::gpu::interconnect::maxwell3d {
          */
         void DisableQuickConstantBufferBind();
 
+        /**
+         * @note See ConstantBuffers::FlushPendingLoads
+         */
+        void FlushConstantBufferLoads();
+
         void Clear(engine::ClearSurface &clearSurface);
 
         void Draw(engine::DrawTopology topology, bool transformFeedbackEnable, bool indexed, u32 count, u32 first, u32 instanceCount, u32 vertexOffset, u32 firstInstance);
+
+        /**
+         * @brief Performs draws with parameters sourced from the supplied guest buffer on the host GPU, this avoids reading them back when they're written by the GPU
+         * @param indirectBuffer The guest mapping of the draw parameters, these are laid out as VkDrawIndirectCommand or VkDrawIndexedIndirectCommand
+         * @param indexBufferElementCount The amount of elements in the bound index buffer, this is used in place of the draw's index count as it isn't known on the CPU
+         * @note The parameters are still read on the CPU for quads or for multiple draws on hosts without multi-draw indirect support, the current execution is submitted beforehand if it wrote them
+         */
+        void DrawIndirect(engine::DrawTopology topology, bool transformFeedbackEnable, bool indexed, span<u8> indirectBuffer, u32 count, u32 stride, u32 indexBufferElementCount);
+
+        /**
+         * @return If any buffer overlapping the supplied guest mapping has GPU modifications which weren't written back to it, see BufferManager::IsGpuDirty
+         */
+        bool IsGpuDirty(span<u8> mapping);
+
+        /**
+         * @note See Queries::Resolve
+         */
+        void ResolveQueries();
+
+        void ResetCounter(engine::CounterReset counter);
+
+        /**
+         * @note See Queries::ReportSampleCounter
+         */
+        void ReportSampleCounter(u64 address, bool fourWords);
     };
 }
@@ -145,6 +145,16 @@ namespace skyline::gpu::interconnect::maxwell3d {
 
         void SetDepthClampEnable(engine::ViewportClipControl::GeometryClip clip);
 
+        vk::PrimitiveTopology GetPrimitiveTopology() const;
+
+        /**
+         * @brief Clears all state that is set dynamically through VK_EXT_extended_dynamic_state{,2} so that pipelines only differing in it share the same key
+         * @param extendedDynamicState2 If the state from VK_EXT_extended_dynamic_state2 is also dynamic
+         * @param topologyListRestart If primitive restart can be used with list topologies, the topology can't be reduced to its class otherwise as the class representative is a list
+         * @note This must only be applied to a copy of the state used as the key as the dynamic state is still required to record it
+         */
+        void MaskDynamicState(bool extendedDynamicState2, bool topologyListRestart);
+
         bool operator==(const PackedPipelineState &other) const {
             // Only hash transform feedback state if it's enabled
             if (other.transformFeedbackEnable && transformFeedbackEnable)
@@ -1,6 +1,10 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <boost/functional/hash.hpp>
+#include <common/settings.h>
+#include <common/perf_stats.h>
+#include <common/trace.h>
 #include <gpu/texture/texture.h>
 #include <gpu/interconnect/command_executor.h>
 #include <gpu/cache/graphics_pipeline_cache.h>
@@ -91,7 +95,10 @@ namespace skyline::gpu::interconnect::maxwell3d {
     /**
      * @notes Roughly based on https://github.com/yuzu-emu/yuzu/blob/4ffbbc534884841f9a5536e57539bf3d1642af26/src/video_core/renderer_vulkan/vk_pipeline_cache.cpp#L127
      */
-    static Shader::RuntimeInfo MakeRuntimeInfo(const PackedPipelineState &packedState, Shader::IR::Program &program, Shader::IR::Program *lastProgram, bool hasGeometry) {
+    /**
+     * @param transformFeedback If outputs should be captured by transform feedback, this is only done if the host supports it or it's emulated by the stage
+     */
+    static Shader::RuntimeInfo MakeRuntimeInfo(const PackedPipelineState &packedState, Shader::IR::Program &program, Shader::IR::Program *lastProgram, bool hasGeometry, bool transformFeedback) {
         Shader::RuntimeInfo info;
         if (lastProgram) {
             info.previous_stage_stores = lastProgram->info.stores;
@@ -107,7 +114,7 @@ namespace skyline::gpu::interconnect::maxwell3d {
                     if (packedState.topology == engine::DrawTopology::Points)
                         info.fixed_state_point_size = packedState.pointSize;
 
-                    if (packedState.transformFeedbackEnable)
+                    if (transformFeedback)
                         info.xfb_varyings = packedState.GetTransformFeedbackVaryings();
 
                     info.convert_depth_mode = packedState.openGlNdc;
@@ -123,7 +130,7 @@ namespace skyline::gpu::interconnect::maxwell3d {
                 if (program.output_topology == Shader::OutputTopology::PointList)
                     info.fixed_state_point_size = packedState.pointSize;
 
-                if (packedState.transformFeedbackEnable)
+                if (transformFeedback)
                     info.xfb_varyings = packedState.GetTransformFeedbackVaryings();
 
                 info.convert_depth_mode = packedState.openGlNdc;
@@ -170,6 +177,28 @@ namespace skyline::gpu::interconnect::maxwell3d {
         return info;
     }
 
+    /**
+     * @brief Selects the constant buffer of a stage to promote to push constants, this is the largest one that fits into the remaining push constant space out of those which are only accessed at static offsets
+     * @param pushConstantOffset The offset of the stage's push constants, this is the combined size of those of prior stages
+     * @return The index of the selected constant buffer alongside the promotion to request when compiling the stage
+     * @note Only a single buffer per stage can be promoted as the emitted SPIR-V can only have a single push constant block, dynamically indexed buffers are never selected as their used size covers the entire buffer
+     */
+    static std::optional<std::pair<u32, ShaderManager::PushConstantPromotion>> SelectPushConstantBuffer(const Shader::Info &info, const Shader::Backend::Bindings &bindings, u32 pushConstantOffset) {
+        std::optional<std::pair<u32, ShaderManager::PushConstantPromotion>> selected;
+        u32 binding{bindings.unified}; // Constant buffers are the first descriptors emitted for a stage
+        for (const auto &desc : info.constant_buffer_descriptors) {
+            if (desc.count != 1)
+                return std::nullopt; // Arrays of constant buffers are rare enough that the bindings of the descriptors following them aren't worth deriving
+
+            u32 usedSize{info.constant_buffer_used_sizes[desc.index]};
+            if (usedSize && pushConstantOffset + usedSize <= MaxPushConstantSize && (!selected || usedSize > selected->second.size))
+                selected.emplace(desc.index, ShaderManager::PushConstantPromotion{binding, pushConstantOffset, usedSize});
+
+            binding++;
+        }
+        return selected;
+    }
+
     static std::array<Pipeline::ShaderStage, engine::ShaderStageCount> MakePipelineShaders(InterconnectContext &ctx, Textures &textures, ConstantBufferSet &constantBuffers, const PackedPipelineState &packedState, const std::array<ShaderBinary, engine::PipelineCount> &shaderBinaries) {
         ctx.gpu.shader.ResetPools();
 
@@ -178,13 +207,11 @@ namespace skyline::gpu::interconnect::maxwell3d {
         auto stageIdx{[](PipelineStage stage) { return static_cast<u8>(stage); }};
 
         std::array<Shader::IR::Program, engine::PipelineCount> programs;
+        std::array<u64, engine::PipelineCount> programHashes{};
         bool ignoreVertexCullBeforeFetch{};
 
-        for (size_t i{}; i < engine::PipelineCount; i++) {
-            if (!packedState.shaderHashes[i])
-                continue;
-
-            auto program{ctx.gpu.shader.ParseGraphicsShader(
+        auto parseProgram{[&](size_t i, u64 &programHash, bool allowCached) {
+            return ctx.gpu.shader.ParseGraphicsShader(
                 packedState.postVtgShaderAttributeSkipMask,
                 ConvertCompilerShaderStage(static_cast<PipelineStage>(i)),
                 shaderBinaries[i].binary, shaderBinaries[i].baseOffset,
@@ -194,27 +221,82 @@ namespace skyline::gpu::interconnect::maxwell3d {
                     return constantBuffers[shaderStage][index].Read<int>(ctx.executor, offset);
                 }, [&](u32 index) {
                     return textures.GetTextureType(ctx, index);
-                })};
+                }, programHash, allowCached);
+        }};
+
+        // Combining VertexA and VertexB requires the IR of both programs, so they can't be substituted with cached programs
+        bool combineVertexShaders{packedState.shaderHashes[stageIdx(PipelineStage::VertexCullBeforeFetch)] != 0};
+
+        for (size_t i{}; i < engine::PipelineCount; i++) {
+            if (!packedState.shaderHashes[i])
+                continue;
+
+            u64 programHash{};
+            auto program{parseProgram(i, programHash, !combineVertexShaders || i > stageIdx(PipelineStage::Vertex))};
             if (i == stageIdx(PipelineStage::Vertex) && packedState.shaderHashes[stageIdx(PipelineStage::VertexCullBeforeFetch)]) {
                 ignoreVertexCullBeforeFetch = true;
                 programs[i] = ctx.gpu.shader.CombineVertexShaders(programs[stageIdx(PipelineStage::VertexCullBeforeFetch)], program, shaderBinaries[i].binary);
+                programHashes[i] = programHashes[stageIdx(PipelineStage::VertexCullBeforeFetch)];
+                boost::hash_combine(programHashes[i], programHash);
             } else {
                 programs[i] = program;
+                programHashes[i] = programHash;
             }
         }
 
-        bool hasGeometry{packedState.shaderHashes[stageIdx(PipelineStage::Geometry)] && programs[stageIdx(PipelineStage::Geometry)].is_geometry_passthrough};
+        // Geometry shaders can't be used on devices without support for them, dropping the stage is the closest approximation as passthrough ones only forward the outputs of the prior stage
+        bool skipGeometry{packedState.shaderHashes[stageIdx(PipelineStage::Geometry)] && !ctx.gpu.traits.supportsGeometryShaders};
+        if (skipGeometry) {
+            if (programs[stageIdx(PipelineStage::Geometry)].is_geometry_passthrough)
+                Logger::Debug("Dropping passthrough geometry shader on host without geometry shader support");
+            else
+                Logger::Warn("Dropping geometry shader on host without geometry shader support");
+        }
+
+        bool hasGeometry{!skipGeometry && packedState.shaderHashes[stageIdx(PipelineStage::Geometry)] && programs[stageIdx(PipelineStage::Geometry)].is_geometry_passthrough};
+
+        // Transform feedback of the vertex stage can be emulated with storage buffer writes when it's the last stage before rasterization
+        bool vertexIsLastStage{!packedState.shaderHashes[stageIdx(PipelineStage::TessellationInit)] && !packedState.shaderHashes[stageIdx(PipelineStage::Tessellation)] && (skipGeometry || !packedState.shaderHashes[stageIdx(PipelineStage::Geometry)])};
+        bool emulateTransformFeedback{packedState.transformFeedbackEnable && !ctx.gpu.traits.supportsTransformFeedback && ctx.gpu.traits.supportsVertexPipelineStoresAndAtomics && vertexIsLastStage};
+
         Shader::Backend::Bindings bindings{};
         Shader::IR::Program *lastProgram{};
 
         std::array<Pipeline::ShaderStage, engine::ShaderStageCount> shaderStages{};
+        u32 pushConstantOffset{};
 
         for (size_t i{stageIdx(ignoreVertexCullBeforeFetch ? PipelineStage::Vertex : PipelineStage::VertexCullBeforeFetch)}; i < engine::PipelineCount; i++) {
-            if (!packedState.shaderHashes[i])
+            if (!packedState.shaderHashes[i] || (skipGeometry && i == stageIdx(PipelineStage::Geometry)))
                 continue;
 
-            auto runtimeInfo{MakeRuntimeInfo(packedState, programs[i], lastProgram, hasGeometry)};
-            shaderStages[i - (i >= 1 ? 1 : 0)] = {ConvertVkShaderStage(pipelineStage(i)), ctx.gpu.shader.CompileShader(runtimeInfo, programs[i], bindings), programs[i].info};
+            bool emulateStageTransformFeedback{emulateTransformFeedback && i == stageIdx(PipelineStage::Vertex)};
+            auto runtimeInfo{MakeRuntimeInfo(packedState, programs[i], lastProgram, hasGeometry, packedState.transformFeedbackEnable && (ctx.gpu.traits.supportsTransformFeedback || emulateStageTransformFeedback))};
+
+            // The emulated transform feedback parameters occupy the push constant block of the vertex stage, so none of its constant buffers can be promoted
+            std::optional<std::pair<u32, ShaderManager::PushConstantPromotion>> promotion;
+            if (!emulateStageTransformFeedback)
+                promotion = SelectPushConstantBuffer(programs[i].info, bindings, pushConstantOffset);
+
+            auto compiledShader{ctx.gpu.shader.CompileShader(runtimeInfo, programs[i], bindings, programHashes[i], promotion ? std::optional{promotion->second} : std::nullopt, emulateStageTransformFeedback)};
+            if (!compiledShader.module) {
+                // The program was cached but its SPIR-V for the current pipeline state isn't, it needs to be translated again to emit SPIR-V
+                programs[i] = parseProgram(i, programHashes[i], false);
+                compiledShader = ctx.gpu.shader.CompileShader(runtimeInfo, programs[i], bindings, programHashes[i], promotion ? std::optional{promotion->second} : std::nullopt, emulateStageTransformFeedback);
+            }
+
+            std::optional<Pipeline::ShaderStage::PushConstantBuffer> pushConstantBuffer;
+            if (compiledShader.promotedToPushConstants) {
+                pushConstantBuffer = Pipeline::ShaderStage::PushConstantBuffer{promotion->first, pushConstantOffset, promotion->second.size};
+                pushConstantOffset += promotion->second.size;
+            }
+
+            if (compiledShader.emulatesTransformFeedback) {
+                // The storage buffers that outputs are captured into directly follow the stage's own descriptors
+                bindings.unified += spirv::TransformFeedbackBufferCount;
+                pushConstantOffset += sizeof(spirv::TransformFeedbackParams);
+            }
+
+            shaderStages[i - (i >= 1 ? 1 : 0)] = {ConvertVkShaderStage(pipelineStage(i)), compiledShader.module, programs[i].info, compiledShader.hash, pushConstantBuffer, compiledShader.emulatesTransformFeedback};
 
             lastProgram = &programs[i];
         }
@@ -238,6 +320,21 @@ namespace skyline::gpu::interconnect::maxwell3d {
 
                 for (u32 descIdx{}; descIdx < descs.size(); descIdx++) {
                     const auto &desc{descs[descIdx]};
+
+                    if constexpr (std::is_same_v<std::remove_cvref_t<decltype(desc)>, Shader::ConstantBufferDescriptor>) {
+                        if (stage.pushConstantBuffer && stage.pushConstantBuffer->index == desc.index) {
+                            // The binding of a promoted buffer is still referenced by the bindings of the following descriptors in the shader, so it's kept in the layout without any descriptors
+                            stageDescInfo.pushConstantDescIdx = descIdx;
+                            descriptorInfo.descriptorSetLayoutBindings.push_back(vk::DescriptorSetLayoutBinding{
+                                .binding = bindingIndex++,
+                                .descriptorType = type,
+                                .descriptorCount = 0,
+                                .stageFlags = stage.stage,
+                            });
+                            continue;
+                        }
+                    }
+
                     count += desc.count;
 
                     descCb(desc, descIdx);
@@ -294,6 +391,38 @@ namespace skyline::gpu::interconnect::maxwell3d {
             }, needsIndividualTextureBindingWrites);
             pushBindings(vk::DescriptorType::eStorageImage, stage.info.image_descriptors, stageDescInfo.storageImageDescCount, [](const auto &, u32) {});
             descriptorInfo.totalImageDescCount += stageDescInfo.combinedImageSamplerDescCount + stageDescInfo.storageImageDescCount;
+
+            if (stage.pushConstantBuffer) {
+                descriptorInfo.pushConstantRange.stageFlags |= stage.stage;
+                descriptorInfo.pushConstantRange.size = std::max(descriptorInfo.pushConstantRange.size, stage.pushConstantBuffer->offset + stage.pushConstantBuffer->size);
+            }
+
+            if (stage.emulatesTransformFeedback) {
+                // All buffers are written with a single descriptor write as their bindings are consecutive
+                descriptorInfo.transformFeedbackBinding = bindingIndex;
+                descriptorInfo.totalWriteDescCount++;
+                descriptorInfo.totalBufferDescCount += spirv::TransformFeedbackBufferCount;
+
+                for (u32 buffer{}; buffer < spirv::TransformFeedbackBufferCount; buffer++) {
+                    descriptorInfo.copyDescs.push_back(vk::CopyDescriptorSet{
+                        .srcBinding = bindingIndex,
+                        .srcArrayElement = 0,
+                        .dstBinding = bindingIndex,
+                        .dstArrayElement = 0,
+                        .descriptorCount = 1,
+                    });
+
+                    descriptorInfo.descriptorSetLayoutBindings.push_back(vk::DescriptorSetLayoutBinding{
+                        .binding = bindingIndex++,
+                        .descriptorType = vk::DescriptorType::eStorageBuffer,
+                        .descriptorCount = 1,
+                        .stageFlags = stage.stage,
+                    });
+                }
+
+                descriptorInfo.pushConstantRange.stageFlags |= stage.stage;
+                descriptorInfo.pushConstantRange.size = std::max<u32>(descriptorInfo.pushConstantRange.size, sizeof(spirv::TransformFeedbackParams));
+            }
         }
         return descriptorInfo;
     }
@@ -367,38 +496,6 @@ namespace skyline::gpu::interconnect::maxwell3d {
         #undef FORMAT_NORM_INT_SCALED_FLOAT_CASE
     }
 
-    static vk::PrimitiveTopology ConvertPrimitiveTopology(engine::DrawTopology topology) {
-        switch (topology) {
-            case engine::DrawTopology::Points:
-                return vk::PrimitiveTopology::ePointList;
-            case engine::DrawTopology::Lines:
-                return vk::PrimitiveTopology::eLineList;
-            case engine::DrawTopology::LineStrip:
-                return vk::PrimitiveTopology::eLineStrip;
-            case engine::DrawTopology::Triangles:
-                return vk::PrimitiveTopology::eTriangleList;
-            case engine::DrawTopology::TriangleStrip:
-                return vk::PrimitiveTopology::eTriangleStrip;
-            case engine::DrawTopology::TriangleFan:
-                return vk::PrimitiveTopology::eTriangleFan;
-            case engine::DrawTopology::Quads:
-                return vk::PrimitiveTopology::eTriangleList; // Uses quad conversion
-            case engine::DrawTopology::LineListAdjcy:
-                return vk::PrimitiveTopology::eLineListWithAdjacency;
-            case engine::DrawTopology::LineStripAdjcy:
-                return vk::PrimitiveTopology::eLineStripWithAdjacency;
-            case engine::DrawTopology::TriangleListAdjcy:
-                return vk::PrimitiveTopology::eTriangleListWithAdjacency;
-            case engine::DrawTopology::TriangleStripAdjcy:
-                return vk::PrimitiveTopology::eTriangleStripWithAdjacency;
-            case engine::DrawTopology::Patch:
-                return vk::PrimitiveTopology::ePatchList;
-            default:
-                Logger::Warn("Unimplemented input assembly topology: {}", static_cast<u8>(topology));
-                return vk::PrimitiveTopology::eTriangleList;
-        }
-    }
-
     static vk::ProvokingVertexModeEXT ConvertProvokingVertex(engine::ProvokingVertex::Value provokingVertex) {
         switch (provokingVertex) {
             case engine::ProvokingVertex::Value::First:
@@ -408,17 +505,53 @@ namespace skyline::gpu::interconnect::maxwell3d {
         }
     }
 
-    static cache::GraphicsPipelineCache::CompiledPipeline MakeCompiledPipeline(InterconnectContext &ctx,
+    #define BASE_DYNAMIC_STATES \
+        vk::DynamicState::eViewport, \
+        vk::DynamicState::eScissor, \
+        vk::DynamicState::eLineWidth, \
+        vk::DynamicState::eDepthBias, \
+        vk::DynamicState::eBlendConstants, \
+        vk::DynamicState::eDepthBounds, \
+        vk::DynamicState::eStencilCompareMask, \
+        vk::DynamicState::eStencilWriteMask, \
+        vk::DynamicState::eStencilReference
+
+    #define EXTENDED_DYNAMIC_STATES \
+        vk::DynamicState::eCullModeEXT, \
+        vk::DynamicState::eFrontFaceEXT, \
+        vk::DynamicState::ePrimitiveTopologyEXT, \
+        vk::DynamicState::eDepthTestEnableEXT, \
+        vk::DynamicState::eDepthWriteEnableEXT, \
+        vk::DynamicState::eDepthCompareOpEXT, \
+        vk::DynamicState::eDepthBoundsTestEnableEXT, \
+        vk::DynamicState::eStencilTestEnableEXT, \
+        vk::DynamicState::eStencilOpEXT
+
+    // These need static storage duration as the dynamic state create info pointing to them is retained by the graphics pipeline cache
+    static constexpr std::array BaseDynamicStates{BASE_DYNAMIC_STATES};
+    static constexpr std::array ExtendedDynamicStates{BASE_DYNAMIC_STATES, EXTENDED_DYNAMIC_STATES}; //!< Any state in here must be cleared by PackedPipelineState::MaskDynamicState
+    static constexpr std::array ExtendedDynamicStates2{BASE_DYNAMIC_STATES, EXTENDED_DYNAMIC_STATES, vk::DynamicState::eDepthBiasEnableEXT, vk::DynamicState::eRasterizerDiscardEnableEXT};
+
+    #undef BASE_DYNAMIC_STATES
+    #undef EXTENDED_DYNAMIC_STATES
+
+    /**
+     * @note This doesn't access any guest or channel state so that it can be safely called from any thread
+     */
+    static cache::GraphicsPipelineCache::CompiledPipeline MakeCompiledPipeline(GPU &gpu,
                                                                                const PackedPipelineState &packedState,
-                                                                               const std::array<Pipeline::ShaderStage, engine::ShaderStageCount> &shaderStages,
-                                                                               span<vk::DescriptorSetLayoutBinding> layoutBindings,
-                                                                               span<TextureView *> colorAttachments, TextureView *depthAttachment) {
+                                                                               const std::array<vk::ShaderModule, engine::ShaderStageCount> &shaderModules,
+                                                                               std::bitset<engine::VertexAttributeCount> vertexAttributeLoads,
+                                                                               span<const vk::DescriptorSetLayoutBinding> layoutBindings,
+                                                                               const vk::PushConstantRange &pushConstantRange,
+                                                                               span<const cache::GraphicsPipelineCache::AttachmentState> colorAttachments,
+                                                                               const cache::GraphicsPipelineCache::AttachmentState *depthAttachment) {
         boost::container::static_vector<vk::PipelineShaderStageCreateInfo, engine::ShaderStageCount> shaderStageInfos;
-        for (const auto &stage : shaderStages)
-            if (stage.module)
+        for (size_t i{}; i < engine::ShaderStageCount; i++)
+            if (shaderModules[i])
                 shaderStageInfos.push_back(vk::PipelineShaderStageCreateInfo{
-                    .stage = stage.stage,
-                    .module = &*stage.module,
+                    .stage = ConvertVkShaderStage(static_cast<engine::Pipeline::Shader::Type>(i + 1)), // Shader stages are offset by one from pipeline stages as VertexCullBeforeFetch is combined with Vertex
+                    .module = shaderModules[i],
                     .pName = "main"
                 });
 
@@ -435,10 +568,10 @@ namespace skyline::gpu::interconnect::maxwell3d {
                                    });
 
             if (binding.GetInputRate() == vk::VertexInputRate::eInstance) {
-                if (!ctx.gpu.traits.supportsVertexAttributeDivisor)
+                if (!gpu.traits.supportsVertexAttributeDivisor)
                     [[unlikely]]
                         Logger::Warn("Vertex attribute divisor used on guest without host support");
-                else if (!ctx.gpu.traits.supportsVertexAttributeZeroDivisor && binding.divisor == 0)
+                else if (!gpu.traits.supportsVertexAttributeZeroDivisor && binding.divisor == 0)
                     [[unlikely]]
                         Logger::Warn("Vertex attribute zero divisor used on guest without host support");
                 else
@@ -451,7 +584,7 @@ namespace skyline::gpu::interconnect::maxwell3d {
 
         for (u32 i{}; i < engine::VertexAttributeCount; i++) {
             const auto &attribute{packedState.vertexAttributes[i]};
-            if (attribute.source == engine::VertexAttribute::Source::Active && shaderStages[0].info.loads.Generic(i))
+            if (attribute.source == engine::VertexAttribute::Source::Active && vertexAttributeLoads.test(i))
                 attributeDescs.push_back({
                                              .location = i,
                                              .binding = attribute.stream,
@@ -477,7 +610,7 @@ namespace skyline::gpu::interconnect::maxwell3d {
             vertexInputState.unlink<vk::PipelineVertexInputDivisorStateCreateInfoEXT>();
 
         vk::PipelineInputAssemblyStateCreateInfo inputAssemblyState{
-            .topology = ConvertPrimitiveTopology(packedState.topology),
+            .topology = packedState.GetPrimitiveTopology(),
             .primitiveRestartEnable = packedState.primitiveRestartEnabled,
         };
 
@@ -494,7 +627,7 @@ namespace skyline::gpu::interconnect::maxwell3d {
         rasterizationCreateInfo.frontFace = packedState.frontFaceClockwise ? vk::FrontFace::eClockwise : vk::FrontFace::eCounterClockwise;
         rasterizationCreateInfo.depthBiasEnable = packedState.depthBiasEnable;
         rasterizationCreateInfo.depthClampEnable = packedState.depthClampEnable;
-        if (!ctx.gpu.traits.supportsDepthClamp)
+        if (!gpu.traits.supportsDepthClamp)
             Logger::Warn("Depth clamp used on guest without host support");
         rasterizationState.get<vk::PipelineRasterizationProvokingVertexStateCreateInfoEXT>().provokingVertexMode = ConvertProvokingVertex(packedState.provokingVertex);
 
@@ -523,17 +656,11 @@ namespace skyline::gpu::interconnect::maxwell3d {
             .pAttachments = attachmentBlendStates.data()
         };
 
-        constexpr std::array<vk::DynamicState, 9> dynamicStates{
-            vk::DynamicState::eViewport,
-            vk::DynamicState::eScissor,
-            vk::DynamicState::eLineWidth,
-            vk::DynamicState::eDepthBias,
-            vk::DynamicState::eBlendConstants,
-            vk::DynamicState::eDepthBounds,
-            vk::DynamicState::eStencilCompareMask,
-            vk::DynamicState::eStencilWriteMask,
-            vk::DynamicState::eStencilReference
-        };
+        span<const vk::DynamicState> dynamicStates{BaseDynamicStates};
+        if (gpu.traits.supportsExtendedDynamicState2)
+            dynamicStates = ExtendedDynamicStates2;
+        else if (gpu.traits.supportsExtendedDynamicState)
+            dynamicStates = ExtendedDynamicStates;
 
         vk::PipelineDynamicStateCreateInfo dynamicState{
             .dynamicStateCount = static_cast<u32>(dynamicStates.size()),
@@ -545,13 +672,13 @@ namespace skyline::gpu::interconnect::maxwell3d {
         std::array<vk::Viewport, engine::ViewportCount> emptyViewports{};
 
         vk::PipelineViewportStateCreateInfo viewportState{
-            .viewportCount = static_cast<u32>(ctx.gpu.traits.supportsMultipleViewports ? engine::ViewportCount : 1),
+            .viewportCount = static_cast<u32>(gpu.traits.supportsMultipleViewports ? engine::ViewportCount : 1),
             .pViewports = emptyViewports.data(),
-            .scissorCount = static_cast<u32>(ctx.gpu.traits.supportsMultipleViewports ? engine::ViewportCount : 1),
+            .scissorCount = static_cast<u32>(gpu.traits.supportsMultipleViewports ? engine::ViewportCount : 1),
             .pScissors = emptyScissors.data(),
         };
 
-        return ctx.gpu.graphicsPipelineCache.GetCompiledPipeline(cache::GraphicsPipelineCache::PipelineState{
+        return gpu.graphicsPipelineCache.GetCompiledPipeline(cache::GraphicsPipelineCache::PipelineState{
             .shaderStages = shaderStageInfos,
             .vertexState = vertexInputState,
             .inputAssemblyState = inputAssemblyState,
@@ -564,15 +691,157 @@ namespace skyline::gpu::interconnect::maxwell3d {
             .dynamicState = dynamicState,
             .colorAttachments = colorAttachments,
             .depthStencilAttachment = depthAttachment,
-        }, layoutBindings);
+        }, layoutBindings, pushConstantRange.size ? span<const vk::PushConstantRange>{&pushConstantRange, 1} : span<const vk::PushConstantRange>{});
+    }
+
+    /**
+     * @brief The header of a pipeline record in the pipeline state cache, it is directly followed by the descriptor set layout bindings of the pipeline
+     * @note This contains all state required to compile the pipeline without any guest state which allows for precompiling it during subsequent runs
+     */
+    struct PipelineRecordHeader {
+        PackedPipelineState packedState;
+        std::array<u64, engine::ShaderStageCount> shaderModuleHashes; //!< The shader cache hashes of the modules for every shader stage, this is zero for unused stages
+        u32 vertexAttributeLoads; //!< A bitmask of the vertex attributes that are loaded by the vertex shader
+        u32 colorAttachmentCount;
+        std::array<cache::GraphicsPipelineCache::AttachmentState, engine::ColorTargetCount> colorAttachments;
+        cache::GraphicsPipelineCache::AttachmentState depthAttachment; //!< The depth attachment of the pipeline, this has an undefined format if there is no depth attachment
+        vk::PushConstantRange pushConstantRange; //!< The push constant range of the pipeline, this has a size of zero if it has no push constants
+        u32 layoutBindingCount;
+    };
+    static_assert(std::is_trivially_copyable_v<PipelineRecordHeader>);
+
+    /**
+     * @brief A serializable version of vk::DescriptorSetLayoutBinding without immutable samplers as they are never used for pipelines
+     */
+    struct RecordedLayoutBinding {
+        u32 binding;
+        vk::DescriptorType descriptorType;
+        u32 descriptorCount;
+        vk::ShaderStageFlags stageFlags;
+    };
+
+    static void RecordPipeline(GPU &gpu,
+                               const PackedPipelineState &packedState,
+                               const std::array<Pipeline::ShaderStage, engine::ShaderStageCount> &shaderStages,
+                               std::bitset<engine::VertexAttributeCount> vertexAttributeLoads,
+                               span<const vk::DescriptorSetLayoutBinding> layoutBindings,
+                               const vk::PushConstantRange &pushConstantRange,
+                               span<const cache::GraphicsPipelineCache::AttachmentState> colorAttachments,
+                               const cache::GraphicsPipelineCache::AttachmentState *depthAttachment) {
+        PipelineRecordHeader header{
+            .packedState = packedState,
+            .vertexAttributeLoads = static_cast<u32>(vertexAttributeLoads.to_ulong()),
+            .colorAttachmentCount = static_cast<u32>(colorAttachments.size()),
+            .depthAttachment = depthAttachment ? *depthAttachment : cache::GraphicsPipelineCache::AttachmentState{},
+            .pushConstantRange = pushConstantRange,
+            .layoutBindingCount = static_cast<u32>(layoutBindings.size()),
+        };
+        for (size_t i{}; i < engine::ShaderStageCount; i++)
+            header.shaderModuleHashes[i] = shaderStages[i].module ? shaderStages[i].moduleHash : 0;
+        std::copy(colorAttachments.begin(), colorAttachments.end(), header.colorAttachments.begin());
+
+        std::vector<RecordedLayoutBinding> recordedBindings;
+        recordedBindings.reserve(layoutBindings.size());
+        for (const auto &binding : layoutBindings)
+            recordedBindings.push_back(RecordedLayoutBinding{
+                .binding = binding.binding,
+                .descriptorType = binding.descriptorType,
+                .descriptorCount = binding.descriptorCount,
+                .stageFlags = binding.stageFlags,
+            });
+
+        std::vector<u8> record(sizeof(PipelineRecordHeader) + recordedBindings.size() * sizeof(RecordedLayoutBinding));
+        std::memcpy(record.data(), &header, sizeof(PipelineRecordHeader));
+        std::memcpy(record.data() + sizeof(PipelineRecordHeader), recordedBindings.data(), recordedBindings.size() * sizeof(RecordedLayoutBinding));
+
+        gpu.pipelineStateCache.Insert(record);
     }
 
     Pipeline::Pipeline(InterconnectContext &ctx, Textures &textures, ConstantBufferSet &constantBuffers, const PackedPipelineState &packedState, const std::array<ShaderBinary, engine::PipelineCount> &shaderBinaries, span<TextureView *> colorAttachments, TextureView *depthAttachment)
         : shaderStages{MakePipelineShaders(ctx, textures, constantBuffers, packedState, shaderBinaries)},
           descriptorInfo{MakePipelineDescriptorInfo(shaderStages, ctx.gpu.traits.quirks.needsIndividualTextureBindingWrites)},
-          compiledPipeline{MakeCompiledPipeline(ctx, packedState, shaderStages, descriptorInfo.descriptorSetLayoutBindings, colorAttachments, depthAttachment)},
           sourcePackedState{packedState} {
+        PerfStats::Increment(PerfStats::Counter::PipelineCompiles);
         storageBufferViews.resize(descriptorInfo.totalStorageBufferCount);
+
+        // The attachments are only locked for the duration of the current execution so any state required for compiling the pipeline needs to be captured ahead of time
+        boost::container::static_vector<cache::GraphicsPipelineCache::AttachmentState, engine::ColorTargetCount> colorAttachmentStates(colorAttachments.begin(), colorAttachments.end());
+        std::optional<cache::GraphicsPipelineCache::AttachmentState> depthAttachmentState;
+        if (depthAttachment)
+            depthAttachmentState.emplace(depthAttachment);
+
+        std::array<vk::ShaderModule, engine::ShaderStageCount> shaderModules{};
+        for (size_t i{}; i < engine::ShaderStageCount; i++)
+            shaderModules[i] = shaderStages[i].module;
+
+        std::bitset<engine::VertexAttributeCount> vertexAttributeLoads;
+        for (size_t i{}; i < engine::VertexAttributeCount; i++)
+            vertexAttributeLoads[i] = shaderStages[0].info.loads.Generic(i);
+
+        RecordPipeline(ctx.gpu, packedState, shaderStages, vertexAttributeLoads, descriptorInfo.descriptorSetLayoutBindings, descriptorInfo.pushConstantRange, colorAttachmentStates, depthAttachmentState ? &*depthAttachmentState : nullptr);
+
+        if (*ctx.state.settings->asyncPipelineCompilation) {
+            compiledPipelineFuture = ctx.gpu.pipelineCompilerPool.Submit([this, &gpu = ctx.gpu, shaderModules, vertexAttributeLoads, colorAttachmentStates, depthAttachmentState]() {
+                TRACE_EVENT("gpu", "Pipeline::Compile");
+                return MakeCompiledPipeline(gpu, sourcePackedState, shaderModules, vertexAttributeLoads, descriptorInfo.descriptorSetLayoutBindings, descriptorInfo.pushConstantRange, colorAttachmentStates, depthAttachmentState ? &*depthAttachmentState : nullptr);
+            });
+        } else {
+            compiledPipeline.emplace(MakeCompiledPipeline(ctx.gpu, packedState, shaderModules, vertexAttributeLoads, descriptorInfo.descriptorSetLayoutBindings, descriptorInfo.pushConstantRange, colorAttachmentStates, depthAttachmentState ? &*depthAttachmentState : nullptr));
+        }
+    }
+
+    Pipeline::~Pipeline() {
+        if (compiledPipelineFuture.valid())
+            compiledPipelineFuture.wait();
+    }
+
+    bool Pipeline::CheckCompiled(bool wait) {
+        if (compiledPipeline)
+            return true;
+
+        if (!wait && compiledPipelineFuture.wait_for(std::chrono::seconds::zero()) != std::future_status::ready)
+            return false;
+
+        compiledPipeline.emplace(compiledPipelineFuture.get());
+        return true;
+    }
+
+    void PipelineManager::CompileRecordedPipeline(GPU &gpu, span<const u8> record) {
+        if (record.size() < sizeof(PipelineRecordHeader))
+            throw exception("Pipeline record is smaller than its header (0x{:X}/0x{:X})", record.size(), sizeof(PipelineRecordHeader));
+
+        PipelineRecordHeader header;
+        std::memcpy(&header, record.data(), sizeof(PipelineRecordHeader));
+        if (header.colorAttachmentCount > engine::ColorTargetCount || record.size() != sizeof(PipelineRecordHeader) + header.layoutBindingCount * sizeof(RecordedLayoutBinding))
+            throw exception("Pipeline record is malformed");
+
+        std::array<vk::ShaderModule, engine::ShaderStageCount> shaderModules{};
+        for (size_t i{}; i < engine::ShaderStageCount; i++) {
+            if (!header.shaderModuleHashes[i])
+                continue;
+
+            shaderModules[i] = gpu.shader.GetCachedShaderModule(header.shaderModuleHashes[i]);
+            if (!shaderModules[i])
+                return; // The shader isn't in the shader cache anymore so the pipeline can't be recreated, it'll be recorded again when the guest uses it
+        }
+
+        std::vector<RecordedLayoutBinding> recordedBindings(header.layoutBindingCount);
+        std::memcpy(recordedBindings.data(), record.data() + sizeof(PipelineRecordHeader), recordedBindings.size() * sizeof(RecordedLayoutBinding));
+
+        std::vector<vk::DescriptorSetLayoutBinding> layoutBindings;
+        layoutBindings.reserve(recordedBindings.size());
+        for (const auto &binding : recordedBindings)
+            layoutBindings.push_back(vk::DescriptorSetLayoutBinding{
+                .binding = binding.binding,
+                .descriptorType = binding.descriptorType,
+                .descriptorCount = binding.descriptorCount,
+                .stageFlags = binding.stageFlags,
+            });
+
+        TRACE_EVENT("gpu", "PipelineManager::CompileRecordedPipeline");
+        MakeCompiledPipeline(gpu, header.packedState, shaderModules, header.vertexAttributeLoads, layoutBindings, header.pushConstantRange,
+                             span<const cache::GraphicsPipelineCache::AttachmentState>(header.colorAttachments).first(header.colorAttachmentCount),
+                             header.depthAttachment ? &header.depthAttachment : nullptr);
     }
 
     void Pipeline::SyncCachedStorageBufferViews(u32 executionNumber) {
@@ -618,7 +887,7 @@ namespace skyline::gpu::interconnect::maxwell3d {
         return true;
     }
 
-    static DynamicBufferBinding GetConstantBufferBinding(InterconnectContext &ctx, const Shader::Info &info, BufferView view, size_t idx) {
+    DynamicBufferBinding GetConstantBufferBinding(InterconnectContext &ctx, const Shader::Info &info, BufferView view, size_t idx) {
         if (!view) // Return a dummy buffer if the constant buffer isn't bound
             return BufferBinding{ctx.gpu.megaBufferAllocator.Allocate(ctx.executor.cycle, 0).buffer, 0, PAGE_SIZE};
 
@@ -633,14 +902,16 @@ namespace skyline::gpu::interconnect::maxwell3d {
         }
     }
 
-    static DynamicBufferBinding GetStorageBufferBinding(InterconnectContext &ctx, const Shader::StorageBufferDescriptor &desc, ConstantBuffer &cbuf, CachedMappedBufferView &cachedView) {
+    DynamicBufferBinding GetStorageBufferBinding(InterconnectContext &ctx, const Shader::StorageBufferDescriptor &desc, ConstantBuffer &cbuf, CachedMappedBufferView &cachedView) {
         struct SsboDescriptor {
             u64 address;
             u32 size;
         };
 
         auto ssbo{cbuf.Read<SsboDescriptor>(ctx.executor, desc.cbuf_offset)};
-        cachedView.Update(ctx, ssbo.address, ssbo.size);
+        cachedView.Update(ctx, ssbo.address, ssbo.size, true, true);
+        if (cachedView.sparseBinding)
+            return cachedView.sparseBinding; // Sparse mappings need no tracking as they are bound to the immutable sparse buffer
 
         auto view{cachedView.view};
         ctx.executor.AttachBuffer(view);
@@ -657,37 +928,11 @@ namespace skyline::gpu::interconnect::maxwell3d {
         return view;
     }
 
-    union BindlessHandle {
-        u32 raw;
-
-        struct {
-            u32 textureIndex : 20;
-            u32 samplerIndex : 12;
-        };
-    };
-
-    static BindlessHandle ReadBindlessHandle(InterconnectContext &ctx, std::array<ConstantBuffer, engine::ShaderStageConstantBufferCount> &constantBuffers, const auto &desc, size_t arrayIdx) {
-        ConstantBuffer &primaryCbuf{constantBuffers[desc.cbuf_index]};
-        size_t elemOffset{arrayIdx << desc.size_shift};
-        size_t primaryCbufOffset{desc.cbuf_offset + elemOffset};
-        u32 primaryVal{primaryCbuf.Read<u32>(ctx.executor, primaryCbufOffset)};
-
-        if constexpr (requires { desc.has_secondary; }) {
-            if (desc.has_secondary) {
-                ConstantBuffer &secondaryCbuf{constantBuffers[desc.secondary_cbuf_index]};
-                size_t secondaryCbufOffset{desc.secondary_cbuf_offset + elemOffset};
-                u32 secondaryVal{secondaryCbuf.Read<u32>(ctx.executor, secondaryCbufOffset)};
-                return {primaryVal | secondaryVal};
-            }
-        }
-
-        return {.raw = primaryVal};
-    }
-
-    static vk::DescriptorImageInfo GetTextureBinding(InterconnectContext &ctx, const Shader::TextureDescriptor &desc, Samplers &samplers, Textures &textures, BindlessHandle handle) {
+    vk::DescriptorImageInfo GetTextureBinding(InterconnectContext &ctx, const Shader::TextureDescriptor &desc, Samplers &samplers, Textures &textures, BindlessHandle handle) {
         auto sampler{samplers.GetSampler(ctx, handle.samplerIndex, handle.textureIndex)};
         auto texture{textures.GetTexture(ctx, handle.textureIndex, desc.type)};
         ctx.executor.AttachTexture(texture);
+        texture->texture->MarkContentsObserved();
         auto view{texture->GetView()};
 
         return vk::DescriptorImageInfo{
@@ -697,17 +942,47 @@ namespace skyline::gpu::interconnect::maxwell3d {
         };
     }
 
-    DescriptorUpdateInfo *Pipeline::SyncDescriptors(InterconnectContext &ctx, ConstantBufferSet &constantBuffers, Samplers &samplers, Textures &textures) {
+    vk::raii::DescriptorUpdateTemplate CreateDescriptorUpdateTemplate(InterconnectContext &ctx, span<const vk::WriteDescriptorSet> writes, const void *data, vk::PipelineBindPoint bindPoint, vk::PipelineLayout pipelineLayout, vk::DescriptorSetLayout descriptorSetLayout) {
+        boost::container::small_vector<vk::DescriptorUpdateTemplateEntry, 16> entries;
+        for (const auto &write : writes) {
+            bool isImage{write.pImageInfo != nullptr};
+            auto info{isImage ? static_cast<const void *>(write.pImageInfo) : static_cast<const void *>(write.pBufferInfo)};
+            entries.push_back(vk::DescriptorUpdateTemplateEntry{
+                .dstBinding = write.dstBinding,
+                .dstArrayElement = write.dstArrayElement,
+                .descriptorCount = write.descriptorCount,
+                .descriptorType = write.descriptorType,
+                .offset = static_cast<size_t>(static_cast<const u8 *>(info) - static_cast<const u8 *>(data)),
+                .stride = isImage ? sizeof(vk::DescriptorImageInfo) : sizeof(vk::DescriptorBufferInfo),
+            });
+        }
+
+        bool pushDescriptors{ctx.gpu.traits.supportsPushDescriptors};
+        return vk::raii::DescriptorUpdateTemplate{ctx.gpu.vkDevice, vk::DescriptorUpdateTemplateCreateInfo{
+            .descriptorUpdateEntryCount = static_cast<u32>(entries.size()),
+            .pDescriptorUpdateEntries = entries.data(),
+            .templateType = pushDescriptors ? vk::DescriptorUpdateTemplateType::ePushDescriptorsKHR : vk::DescriptorUpdateTemplateType::eDescriptorSet,
+            .descriptorSetLayout = descriptorSetLayout,
+            .pipelineBindPoint = bindPoint,
+            .pipelineLayout = pipelineLayout,
+            .set = 0,
+        }};
+    }
+
+    DescriptorUpdateInfo *Pipeline::SyncDescriptors(InterconnectContext &ctx, ConstantBufferSet &constantBuffers, Samplers &samplers, Textures &textures, const std::array<BufferView, engine::StreamOutBufferCount> &transformFeedbackBuffers) {
         SyncCachedStorageBufferViews(ctx.executor.executionNumber);
 
         u32 writeIdx{};
         auto writes{ctx.executor.allocator->AllocateUntracked<vk::WriteDescriptorSet>(descriptorInfo.totalWriteDescCount)};
 
+        // Buffer and image infos are packed into a single block so that the whole update can be performed with the pipeline's update template
+        u8 *descData{ctx.executor.allocator->Allocate(descriptorInfo.totalBufferDescCount * sizeof(vk::DescriptorBufferInfo) + descriptorInfo.totalImageDescCount * sizeof(vk::DescriptorImageInfo), false)};
+
         u32 bufferIdx{};
-        auto bufferDescs{ctx.executor.allocator->AllocateUntracked<vk::DescriptorBufferInfo>(descriptorInfo.totalBufferDescCount)};
+        span<vk::DescriptorBufferInfo> bufferDescs{reinterpret_cast<vk::DescriptorBufferInfo *>(descData), descriptorInfo.totalBufferDescCount};
         auto bufferDescDynamicBindings{ctx.executor.allocator->AllocateUntracked<DynamicBufferBinding>(descriptorInfo.totalBufferDescCount)};
         u32 imageIdx{};
-        auto imageDescs{ctx.executor.allocator->AllocateUntracked<vk::DescriptorImageInfo>(descriptorInfo.totalImageDescCount)};
+        span<vk::DescriptorImageInfo> imageDescs{reinterpret_cast<vk::DescriptorImageInfo *>(descData + bufferDescs.size_bytes()), descriptorInfo.totalImageDescCount};
 
         u32 storageBufferIdx{}; // Need to keep track of this since to index into the cached view array
         u32 bindingIdx{};
@@ -715,22 +990,26 @@ namespace skyline::gpu::interconnect::maxwell3d {
         /**
          * @brief Adds descriptor writes for a single Vulkan descriptor type that uses buffer descriptors
          * @param count Total number of descriptors to write, including array elements
+         * @param skippedDescIdx The index of a descriptor that has no descriptors in the layout and must be skipped
          */
-        auto writeBufferDescs{[&](vk::DescriptorType type, const auto &descs, u32 count, auto getBufferCb) {
+        auto writeBufferDescs{[&](vk::DescriptorType type, const auto &descs, u32 count, auto getBufferCb, std::optional<u32> skippedDescIdx = std::nullopt) {
             if (!descs.empty()) {
-                writes[writeIdx++] = {
-                    .dstBinding = bindingIdx,
-                    .descriptorCount = count,
-                    .descriptorType = type,
-                    .pBufferInfo = &bufferDescs[bufferIdx],
-                };
+                // Consecutive binding updates skip over bindings without any descriptors, but they can't be the first binding of a write
+                if (count)
+                    writes[writeIdx++] = {
+                        .dstBinding = bindingIdx + (skippedDescIdx == 0 ? 1 : 0),
+                        .descriptorCount = count,
+                        .descriptorType = type,
+                        .pBufferInfo = &bufferDescs[bufferIdx],
+                    };
 
                 bindingIdx += descs.size();
 
                 // The underlying buffer bindings will be resolved from the dynamic ones during recording
-                for (const auto &desc : descs)
-                    for (u32 arrayIdx{}; arrayIdx < desc.count; arrayIdx++)
-                        bufferDescDynamicBindings[bufferIdx++] = getBufferCb(desc, arrayIdx);
+                for (u32 descIdx{}; descIdx < descs.size(); descIdx++)
+                    if (descIdx != skippedDescIdx)
+                        for (u32 arrayIdx{}; arrayIdx < descs[descIdx].count; arrayIdx++)
+                            bufferDescDynamicBindings[bufferIdx++] = getBufferCb(descs[descIdx], arrayIdx);
             }
         }};
 
@@ -774,7 +1053,7 @@ namespace skyline::gpu::interconnect::maxwell3d {
                              [&](const Shader::ConstantBufferDescriptor &desc, size_t arrayIdx) {
                                  size_t cbufIdx{desc.index + arrayIdx};
                                  return GetConstantBufferBinding(ctx, stage.info, constantBuffers[i][cbufIdx].view, cbufIdx);
-                             });
+                             }, stageDescInfo.pushConstantDescIdx);
 
             writeBufferDescs(vk::DescriptorType::eStorageBuffer, stage.info.storage_buffers_descriptors, stageDescInfo.storageBufferDescCount,
                              [&](const Shader::StorageBufferDescriptor &desc, size_t arrayIdx) {
@@ -789,20 +1068,47 @@ namespace skyline::gpu::interconnect::maxwell3d {
                                 BindlessHandle handle{ReadBindlessHandle(ctx, constantBuffers[i], desc, arrayIdx)};
                                 return GetTextureBinding(ctx, desc, samplers, textures, handle);
                             }, ctx.gpu.traits.quirks.needsIndividualTextureBindingWrites);
+
+            if (stage.emulatesTransformFeedback) {
+                writes[writeIdx++] = {
+                    .dstBinding = *descriptorInfo.transformFeedbackBinding,
+                    .descriptorCount = spirv::TransformFeedbackBufferCount,
+                    .descriptorType = vk::DescriptorType::eStorageBuffer,
+                    .pBufferInfo = &bufferDescs[bufferIdx],
+                };
+                bindingIdx = *descriptorInfo.transformFeedbackBinding + spirv::TransformFeedbackBufferCount;
+
+                for (auto view : transformFeedbackBuffers) {
+                    if (view) {
+                        view.GetBuffer()->BlockSequencedCpuBackingWrites();
+                        bufferDescDynamicBindings[bufferIdx++] = view;
+                    } else {
+                        // Unbound buffers are substituted with a single word of scratch space, writes are bounded by the size of the buffer so they never leave the allocation
+                        auto allocation{ctx.gpu.megaBufferAllocator.Allocate(ctx.executor.cycle, sizeof(u32))};
+                        bufferDescDynamicBindings[bufferIdx++] = BufferBinding{allocation.buffer, allocation.offset, sizeof(u32)};
+                    }
+                }
+            }
         }
 
         // Since we don't implement all descriptor types the number of writes might not match what's expected
         if (!writeIdx)
             return nullptr;
 
+        // The writes of a full update only depend on the pipeline, so they're always laid out the same way within the block
+        if (!*descriptorUpdateTemplate)
+            descriptorUpdateTemplate = CreateDescriptorUpdateTemplate(ctx, writes.first(writeIdx), descData, vk::PipelineBindPoint::eGraphics, compiledPipeline->pipelineLayout, compiledPipeline->descriptorSetLayout);
+
         return ctx.executor.allocator->EmplaceUntracked<DescriptorUpdateInfo>(DescriptorUpdateInfo{
             .writes = writes.first(writeIdx),
             .bufferDescs = bufferDescs.first(bufferIdx),
             .bufferDescDynamicBindings = bufferDescDynamicBindings.first(bufferIdx),
-            .pipelineLayout = compiledPipeline.pipelineLayout,
-            .descriptorSetLayout = compiledPipeline.descriptorSetLayout,
+            .pipelineLayout = compiledPipeline->pipelineLayout,
+            .descriptorSetLayout = compiledPipeline->descriptorSetLayout,
             .bindPoint = vk::PipelineBindPoint::eGraphics,
             .descriptorSetIndex = 0,
+            .updateTemplate = *descriptorUpdateTemplate,
+            .templateData = descData,
         });
     }
 
@@ -884,11 +1190,39 @@ namespace skyline::gpu::interconnect::maxwell3d {
             .writes = writes.first(writeIdx),
             .bufferDescs = bufferDescs.first(bufferIdx),
             .bufferDescDynamicBindings = bufferDescDynamicBindings.first(bufferIdx),
-            .pipelineLayout = compiledPipeline.pipelineLayout,
-            .descriptorSetLayout = compiledPipeline.descriptorSetLayout,
+            .pipelineLayout = compiledPipeline->pipelineLayout,
+            .descriptorSetLayout = compiledPipeline->descriptorSetLayout,
             .bindPoint = vk::PipelineBindPoint::eGraphics,
             .descriptorSetIndex = 0,
         });
     }
+
+    bool Pipeline::SyncPushConstants(InterconnectContext &ctx, ConstantBufferSet &constantBuffers, PushConstantUpdateInfo &updateInfo, const spirv::TransformFeedbackParams &transformFeedbackParams) {
+        if (!descriptorInfo.pushConstantRange.size)
+            return false;
+
+        updateInfo = {
+            .pipelineLayout = compiledPipeline->pipelineLayout,
+            .stageFlags = descriptorInfo.pushConstantRange.stageFlags,
+            .size = descriptorInfo.pushConstantRange.size,
+        };
+
+        for (size_t i{}; i < shaderStages.size(); i++) {
+            const auto &pushConstantBuffer{shaderStages[i].pushConstantBuffer};
+            if (!pushConstantBuffer)
+                continue;
+
+            // Any part of the range that isn't backed by the bound buffer is left zeroed, this includes the entire range if no buffer is bound
+            auto &cbuf{constantBuffers[i][pushConstantBuffer->index]};
+            size_t readSize{cbuf.view ? std::min<size_t>(pushConstantBuffer->size, cbuf.view.size) : 0};
+            if (readSize)
+                cbuf.Read(ctx.executor, span(updateInfo.data).subspan(pushConstantBuffer->offset, readSize), 0);
+        }
+
+        if (descriptorInfo.transformFeedbackBinding)
+            std::memcpy(updateInfo.data.data(), &transformFeedbackParams, sizeof(spirv::TransformFeedbackParams));
+
+        return true;
+    }
 }
 
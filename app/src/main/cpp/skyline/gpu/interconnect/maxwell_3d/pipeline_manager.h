@@ -3,9 +3,11 @@
 
 #pragma once
 
+#include <future>
 #include <tsl/robin_map.h>
 #include <shader_compiler/frontend/ir/program.h>
 #include <gpu/cache/graphics_pipeline_cache.h>
+#include <gpu/shaders/spirv_passes.h>
 #include "common.h"
 #include "packed_pipeline_state.h"
 #include "constant_buffers.h"
@@ -22,18 +24,83 @@ namespace skyline::gpu::interconnect::maxwell3d {
         u32 baseOffset;
     };
 
+    /**
+     * @param hash The XXH64 hash of the returned shader binary, this is computed alongside searching for the end of the shader
+     * @return The part of the supplied mapping that contains the shader starting at its beginning, this is empty if the end of the shader couldn't be found
+     */
+    span<u8> TrimShaderBinary(span<u8> mapping, u64 &hash);
+
+    union BindlessHandle {
+        u32 raw;
+
+        struct {
+            u32 textureIndex : 20;
+            u32 samplerIndex : 12;
+        };
+    };
+
+    /**
+     * @note The following helpers are shared by both graphics and compute pipelines for resolving descriptors from the bound constant buffers
+     */
+    DynamicBufferBinding GetConstantBufferBinding(InterconnectContext &ctx, const Shader::Info &info, BufferView view, size_t idx);
+
+    DynamicBufferBinding GetStorageBufferBinding(InterconnectContext &ctx, const Shader::StorageBufferDescriptor &desc, ConstantBuffer &cbuf, CachedMappedBufferView &cachedView);
+
+    BindlessHandle ReadBindlessHandle(InterconnectContext &ctx, std::array<ConstantBuffer, engine::ShaderStageConstantBufferCount> &constantBuffers, const auto &desc, size_t arrayIdx) {
+        ConstantBuffer &primaryCbuf{constantBuffers[desc.cbuf_index]};
+        size_t elemOffset{arrayIdx << desc.size_shift};
+        size_t primaryCbufOffset{desc.cbuf_offset + elemOffset};
+        u32 primaryVal{primaryCbuf.Read<u32>(ctx.executor, primaryCbufOffset)};
+
+        if constexpr (requires { desc.has_secondary; }) {
+            if (desc.has_secondary) {
+                ConstantBuffer &secondaryCbuf{constantBuffers[desc.secondary_cbuf_index]};
+                size_t secondaryCbufOffset{desc.secondary_cbuf_offset + elemOffset};
+                u32 secondaryVal{secondaryCbuf.Read<u32>(ctx.executor, secondaryCbufOffset)};
+                return {primaryVal | secondaryVal};
+            }
+        }
+
+        return {.raw = primaryVal};
+    }
+
+    vk::DescriptorImageInfo GetTextureBinding(InterconnectContext &ctx, const Shader::TextureDescriptor &desc, Samplers &samplers, Textures &textures, BindlessHandle handle);
+
+    /**
+     * @brief Creates an update template that performs all the supplied writes of a full descriptor update at once
+     * @param data The block that the buffer and image infos of the writes point into, the template refers to them by their offset in it so it can be used with any block that's laid out identically
+     * @note The template pushes descriptors if push descriptors are supported, as sets are never allocated for pipelines in that case
+     */
+    vk::raii::DescriptorUpdateTemplate CreateDescriptorUpdateTemplate(InterconnectContext &ctx, span<const vk::WriteDescriptorSet> writes, const void *data, vk::PipelineBindPoint bindPoint, vk::PipelineLayout pipelineLayout, vk::DescriptorSetLayout descriptorSetLayout);
+
     class Pipeline {
       public:
         struct ShaderStage {
             vk::ShaderStageFlagBits stage;
             vk::ShaderModule module;
             Shader::Info info;
+            u64 moduleHash; //!< The hash of the shader module in the shader cache, this is used to look up the module when replaying the pipeline
+
+            /**
+             * @brief A constant buffer that's supplied to the stage through push constants rather than being bound as a uniform buffer
+             */
+            struct PushConstantBuffer {
+                u32 index; //!< The index of the constant buffer in the stage
+                u32 offset; //!< The offset of the buffer's contents in the push constants of the pipeline
+                u32 size; //!< The size of the range at the start of the buffer that's pushed
+
+                bool operator==(const PushConstantBuffer &) const = default;
+            };
+            std::optional<PushConstantBuffer> pushConstantBuffer;
+            bool emulatesTransformFeedback; //!< If the stage writes outputs captured by transform feedback to storage buffers, see spirv::EmulateTransformFeedback
 
             /**
              * @return Whether the bindings for this stage match those of the input stage
              */
             bool BindingsEqual(const ShaderStage &other) const {
-                return info.constant_buffer_descriptors == other.info.constant_buffer_descriptors &&
+                return pushConstantBuffer == other.pushConstantBuffer &&
+                    emulatesTransformFeedback == other.emulatesTransformFeedback &&
+                    info.constant_buffer_descriptors == other.info.constant_buffer_descriptors &&
                     info.storage_buffers_descriptors == other.info.storage_buffers_descriptors &&
                     info.texture_buffer_descriptors == other.info.texture_buffer_descriptors &&
                     info.image_buffer_descriptors == other.info.image_buffer_descriptors &&
@@ -52,6 +119,7 @@ namespace skyline::gpu::interconnect::maxwell3d {
                 u32 storageTexelBufferDescCount;
                 u32 combinedImageSamplerDescCount;
                 u32 storageImageDescCount;
+                std::optional<u32> pushConstantDescIdx; //!< The index of the constant buffer descriptor that's promoted to push constants, its binding is reserved without any descriptors
 
                 /**
                  * @brief Keeps track of all bindings that are dependent on a given constant buffer index to allow for quick binding
@@ -79,6 +147,9 @@ namespace skyline::gpu::interconnect::maxwell3d {
 
             u32 totalStorageBufferCount;
 
+            vk::PushConstantRange pushConstantRange; //!< A single range covering the push constants of all stages, this has a size of zero if no constant buffers were promoted and transform feedback isn't emulated
+            std::optional<u32> transformFeedbackBinding; //!< The first of the storage buffer bindings that transform feedback buffers are bound to when it's emulated by the vertex shader
+
             u32 totalWriteDescCount;
             u32 totalBufferDescCount;
             u32 totalTexelBufferDescCount;
@@ -96,24 +167,61 @@ namespace skyline::gpu::interconnect::maxwell3d {
 
         tsl::robin_map<Pipeline *, bool> bindingMatchCache; //!< Cache of which pipelines have bindings that match this pipeline
 
+        std::future<cache::GraphicsPipelineCache::CompiledPipeline> compiledPipelineFuture; //!< The result of an asynchronous compilation of the pipeline, this is only valid while the compiled pipeline hasn't been retrieved
+
+        vk::raii::DescriptorUpdateTemplate descriptorUpdateTemplate{nullptr}; //!< The template for full descriptor updates, this is created lazily on the first full update as it requires the compiled pipeline's layout
+
         void SyncCachedStorageBufferViews(u32 executionNumber);
 
       public:
-        cache::GraphicsPipelineCache::CompiledPipeline compiledPipeline;
+        std::optional<cache::GraphicsPipelineCache::CompiledPipeline> compiledPipeline; //!< The compiled pipeline, this is empty while the pipeline is being asynchronously compiled
 
         PackedPipelineState sourcePackedState;
 
+        /**
+         * @note If asynchronous pipeline compilation is enabled then only the shaders are compiled prior to returning, the pipeline itself is compiled on the GPU's pipeline compiler pool
+         */
         Pipeline(InterconnectContext &ctx, Textures &textures, ConstantBufferSet &constantBuffers, const PackedPipelineState &packedState, const std::array<ShaderBinary, engine::PipelineCount> &shaderBinaries, span<TextureView *> colorAttachments, TextureView *depthAttachment);
 
+        /**
+         * @note This blocks till any asynchronous compilation of the pipeline has finished as it references the pipeline's shader stages
+         */
+        ~Pipeline();
+
+        /**
+         * @brief Checks if the pipeline has been compiled and retrieves the compiled pipeline from an asynchronous compilation if it has finished
+         * @param wait If this should block till the pipeline has been compiled
+         * @return If the compiled pipeline is available
+         */
+        bool CheckCompiled(bool wait);
+
         Pipeline *LookupNext(const PackedPipelineState &packedState);
 
         void AddTransition(Pipeline *next);
 
         bool CheckBindingMatch(Pipeline *other);
 
-        DescriptorUpdateInfo *SyncDescriptors(InterconnectContext &ctx, ConstantBufferSet &constantBuffers, Samplers &samplers, Textures &textures);
+        /**
+         * @return If the pipeline emulates transform feedback, the transform feedback buffers must be supplied to every full descriptor sync and quick binds can't be used as they'd retain stale buffers
+         */
+        bool EmulatesTransformFeedback() const {
+            return descriptorInfo.transformFeedbackBinding.has_value();
+        }
+
+        /**
+         * @param transformFeedbackBuffers The bound transform feedback buffers, these are only used if the pipeline emulates transform feedback
+         */
+        DescriptorUpdateInfo *SyncDescriptors(InterconnectContext &ctx, ConstantBufferSet &constantBuffers, Samplers &samplers, Textures &textures, const std::array<BufferView, engine::StreamOutBufferCount> &transformFeedbackBuffers);
 
         DescriptorUpdateInfo *SyncDescriptorsQuickBind(InterconnectContext &ctx, ConstantBufferSet &constantBuffers, Samplers &samplers, Textures &textures, ConstantBuffers::QuickBind quickBind);
+
+        /**
+         * @brief Reads the current contents of all constant buffers that are promoted to push constants
+         * @param transformFeedbackParams The parameters of the draw, these are only pushed if the pipeline emulates transform feedback
+         * @return If the pipeline has any push constants, `updateInfo` is only written to if it does
+         * @note The contents are read on every draw as the buffers can be modified without being rebound
+         */
+        bool SyncPushConstants(InterconnectContext &ctx, ConstantBufferSet &constantBuffers, PushConstantUpdateInfo &updateInfo, const spirv::TransformFeedbackParams &transformFeedbackParams);
     };
 
     class PipelineManager {
@@ -121,6 +229,12 @@ namespace skyline::gpu::interconnect::maxwell3d {
         tsl::robin_map<PackedPipelineState, std::unique_ptr<Pipeline>, PackedPipelineStateHash> map;
 
       public:
+        /**
+         * @brief Compiles a pipeline that was recorded in the pipeline state cache during a previous run, this inserts it into the graphics pipeline cache so that it doesn't need to be compiled when the guest uses it
+         * @note This doesn't depend on any guest state and is thread-safe
+         */
+        static void CompileRecordedPipeline(GPU &gpu, span<const u8> record);
+
         Pipeline *FindOrCreate(InterconnectContext &ctx, Textures &textures, ConstantBufferSet &constantBuffers, const PackedPipelineState &packedState, const std::array<ShaderBinary, engine::PipelineCount> &shaderBinaries, span<TextureView *> colorAttachments, TextureView *depthAttachment) {
             auto it{map.find(packedState)};
             if (it != map.end())
@@ -163,7 +163,7 @@ namespace skyline::gpu::interconnect::maxwell3d {
             if (guest.tileConfig.mode == gpu::texture::TileMode::Block)
                 DetermineRenderTargetDimensions(guest, engine->surfaceClip);
 
-            view = ctx.gpu.texture.FindOrCreate(guest, ctx.executor.tag);
+            view = ctx.gpu.texture.FindOrCreate(guest, ctx.executor.tag, true);
         } else {
             view = {};
         }
@@ -234,7 +234,7 @@ namespace skyline::gpu::interconnect::maxwell3d {
             if (guest.tileConfig.mode == gpu::texture::TileMode::Block)
                 DetermineRenderTargetDimensions(guest, engine->surfaceClip);
 
-            view = ctx.gpu.texture.FindOrCreate(guest, ctx.executor.tag);
+            view = ctx.gpu.texture.FindOrCreate(guest, ctx.executor.tag, true);
         } else {
             view = {};
         }
@@ -245,6 +245,36 @@ namespace skyline::gpu::interconnect::maxwell3d {
         manager.Bind(handle, pipeline, programRegion);
     }
 
+    span<u8> TrimShaderBinary(span<u8> mapping, u64 &hash) {
+        // We attempt to find the shader size by looking for "BRA $" (Infinite Loop) which is used as padding at the end of the shader
+        // UAM Shader Compiler Reference: https://github.com/devkitPro/uam/blob/5a5afc2bae8b55409ab36ba45be63fcb73f68993/source/compiler_iface.cpp#L319-L351
+        constexpr u64 BraSelf1{0xE2400FFFFF87000F}, BraSelf2{0xE2400FFFFF07000F};
+        constexpr size_t ChunkInstructionCount{0x200}; //!< The amount of instructions scanned prior to hashing them, this is small enough for them to still be in the cache while hashing
+
+        XXH64_state_t hashState;
+        XXH64_reset(&hashState, 0);
+
+        span<u64> shaderInstructions{mapping.cast<u64, std::dynamic_extent, true>()};
+        for (auto chunkIt{shaderInstructions.begin()}; chunkIt != shaderInstructions.end();) {
+            auto chunkEnd{chunkIt + static_cast<ptrdiff_t>(std::min<size_t>(ChunkInstructionCount, static_cast<size_t>(shaderInstructions.end() - chunkIt)))};
+            for (auto it{chunkIt}; it != chunkEnd; it++) {
+                auto instruction{*it};
+                if (instruction == BraSelf1 || instruction == BraSelf2) [[unlikely]] {
+                    // It is far more likely that the instruction doesn't match so this is an unlikely case
+                    XXH64_update(&hashState, &*chunkIt, static_cast<size_t>(it - chunkIt) * sizeof(u64));
+                    hash = XXH64_digest(&hashState);
+                    return span{shaderInstructions.begin(), it}.cast<u8>();
+                }
+            }
+
+            XXH64_update(&hashState, &*chunkIt, static_cast<size_t>(chunkEnd - chunkIt) * sizeof(u64));
+            chunkIt = chunkEnd;
+        }
+
+        hash = XXH64(nullptr, 0, 0);
+        return span<u8>{};
+    }
+
     PipelineStageState::PipelineStageState(dirty::Handle dirtyHandle, DirtyManager &manager, const EngineRegisters &engine, u8 shaderType)
         : engine{manager, dirtyHandle, engine},
           shaderType{static_cast<engine::Pipeline::Shader::Type>(shaderType)} {}
@@ -255,6 +285,7 @@ namespace skyline::gpu::interconnect::maxwell3d {
 
         if (!engine->pipeline.shader.enable && shaderType != engine::Pipeline::Shader::Type::Vertex) {
             hash = 0;
+            program = nullptr;
             return;
         }
 
@@ -264,26 +295,9 @@ namespace skyline::gpu::interconnect::maxwell3d {
         if (!mirrorBlock.valid() || !mirrorBlock.contains(blockMapping)) {
             auto mirrorIt{mirrorMap.find(blockMapping.data())};
             if (mirrorIt == mirrorMap.end()) {
-                // Allocate a host mirror for the mapping and trap the guest region
+                // Allocate a host mirror for the mapping, the programs inside it are trapped individually as they're parsed
                 auto newIt{mirrorMap.emplace(blockMapping.data(), std::make_unique<MirrorEntry>(ctx.memory.CreateMirror(blockMapping)))};
-
-                // We need to create the trap after allocating the entry so that we have an `invalid` pointer we can pass in
-                auto trapHandle{ctx.nce.CreateTrap(blockMapping, [mutex = &trapMutex]() {
-                    std::scoped_lock lock{*mutex};
-                    return;
-                }, []() { return true; }, [dirty = &newIt.first->second->dirty, mutex = &trapMutex]() {
-                    std::unique_lock lock{*mutex, std::try_to_lock};
-                    if (!lock)
-                        return false;
-                    *dirty = true;
-                    return true;
-                })};
-
-                // Write only trap
-                ctx.nce.TrapRegions(trapHandle, true);
-
                 entry = newIt.first->second.get();
-                entry->trap = trapHandle;
             } else {
                 entry = mirrorIt->second.get();
             }
@@ -294,48 +308,51 @@ namespace skyline::gpu::interconnect::maxwell3d {
         if (!trapExecutionLock)
             trapExecutionLock.emplace(trapMutex);
 
-        // If the mirror entry has been written to, clear its shader binary cache and retrap to catch any future writes
-        if (entry->dirty) {
-            entry->cache.clear();
-            entry->dirty = false;
-            ctx.nce.TrapRegions(*entry->trap, true);
-        } else if (auto it{entry->cache.find(blockMapping.data() + blockOffset)}; it != entry->cache.end()) {
-            binary = it->second.binary;
-            hash = it->second.hash;
+        u8 *programAddress{blockMapping.data() + blockOffset};
+        auto &cacheEntry{entry->cache[programAddress]};
+        if (cacheEntry && !cacheEntry->dirty) {
+            // Writes to any other programs in the same block don't affect this program as only its own pages are trapped
+            program = cacheEntry.get();
+            binary = program->binary;
+            hash = program->hash;
             return;
         }
 
         // entry->mirror may not be a direct mirror of blockMapping and may just contain it as a subregion, so we need to explicitly calculate the offset
         span<u8> blockMappingMirror{blockMapping.data() - mirrorBlock.data() + entry->mirror.data(), blockMapping.size()};
 
-        // If nothing was in the cache then do a full shader parse
-        binary.binary = [](span<u8> mapping) {
-            // We attempt to find the shader size by looking for "BRA $" (Infinite Loop) which is used as padding at the end of the shader
-            // UAM Shader Compiler Reference: https://github.com/devkitPro/uam/blob/5a5afc2bae8b55409ab36ba45be63fcb73f68993/source/compiler_iface.cpp#L319-L351
-            constexpr u64 BraSelf1{0xE2400FFFFF87000F}, BraSelf2{0xE2400FFFFF07000F};
-
-            span<u64> shaderInstructions{mapping.cast<u64, std::dynamic_extent, true>()};
-            for (auto it{shaderInstructions.begin()}; it != shaderInstructions.end(); it++) {
-                auto instruction{*it};
-                if (instruction == BraSelf1 || instruction == BraSelf2) [[unlikely]]
-                    // It is far more likely that the instruction doesn't match so this is an unlikely case
-                    return span{shaderInstructions.begin(), it}.cast<u8>();
-            }
+        // If the program wasn't in the cache or has been written to then do a full shader parse
+        binary.binary = TrimShaderBinary(blockMappingMirror.subspan(blockOffset), hash);
+        binary.baseOffset = engine->pipeline.programOffset;
 
-            return span<u8>{};
-        }(blockMappingMirror.subspan(blockOffset));
+        // The size of the program may have changed after being written to, so the trap needs to be recreated to cover the new program
+        if (cacheEntry)
+            ctx.nce.DeleteTrap(*cacheEntry->trap);
+        cacheEntry = std::make_unique<CacheEntry>(binary, hash);
+        program = cacheEntry.get();
 
-        binary.baseOffset = engine->pipeline.programOffset;
-        hash = XXH64(binary.binary.data(), binary.binary.size_bytes(), 0);
+        // A program without a known end is trapped up to the end of the block as any part of it could be a part of the program
+        span<u8> programMapping{blockMapping.subspan(blockOffset, binary.binary.empty() ? blockMapping.size() - blockOffset : binary.binary.size())};
+        program->trap = ctx.nce.CreateTrap(programMapping, [mutex = &trapMutex]() {
+            std::scoped_lock lock{*mutex};
+            return;
+        }, []() { return true; }, [dirty = &program->dirty, mutex = &trapMutex]() {
+            std::unique_lock lock{*mutex, std::try_to_lock};
+            if (!lock)
+                return false;
+            *dirty = true;
+            return true;
+        });
 
-        entry->cache.insert({blockMapping.data() + blockOffset, CacheEntry{binary, hash}});
+        // Write only trap
+        ctx.nce.TrapRegions(*program->trap, true);
     }
 
     bool PipelineStageState::Refresh(InterconnectContext &ctx) {
         if (!trapExecutionLock)
             trapExecutionLock.emplace(trapMutex);
 
-        if (entry && entry->dirty)
+        if (program && program->dirty)
             return true;
 
         return false;
@@ -348,7 +365,8 @@ namespace skyline::gpu::interconnect::maxwell3d {
     PipelineStageState::~PipelineStageState() {
         std::scoped_lock lock{trapMutex};
         //for (const auto &mirror : mirrorMap)
-        //    ctx.nce.DestroyTrap(*mirror.second->trap);
+        //    for (const auto &program : mirror.second->cache)
+        //        ctx.nce.DeleteTrap(*program.second->trap);
     }
 
     /* Vertex Input State */
@@ -600,14 +618,27 @@ namespace skyline::gpu::interconnect::maxwell3d {
         transformFeedback.Update(packedState);
         globalShaderConfig.Update(packedState);
 
+        // Any dynamic state is recorded from the full state while the pipeline is looked up with it cleared, the persistent state can't be masked as the above only update what's dirty
+        const auto &traits{ctx.gpu.traits};
+        const PackedPipelineState *keyState{&packedState};
+        if (traits.supportsExtendedDynamicState) {
+            builder.SetExtendedDynamicState(packedState);
+            if (traits.supportsExtendedDynamicState2)
+                builder.SetExtendedDynamicState2(packedState);
+
+            keyPackedState = packedState;
+            keyPackedState.MaskDynamicState(traits.supportsExtendedDynamicState2, traits.supportsTopologyListRestart);
+            keyState = &keyPackedState;
+        }
+
         if (pipeline) {
-            if (auto newPipeline{pipeline->LookupNext(packedState)}) {
+            if (auto newPipeline{pipeline->LookupNext(*keyState)}) {
                 pipeline = newPipeline;
                 return;
             }
         }
 
-        auto newPipeline{pipelineManager.FindOrCreate(ctx, textures, constantBuffers, packedState, shaderBinaries, colorAttachments, depthAttachment)};
+        auto newPipeline{pipelineManager.FindOrCreate(ctx, textures, constantBuffers, *keyState, shaderBinaries, colorAttachments, depthAttachment)};
         if (pipeline)
             pipeline->AddTransition(newPipeline);
         pipeline = newPipeline;
@@ -67,9 +67,14 @@ namespace skyline::gpu::interconnect::maxwell3d {
         };
 
       private:
+        /**
+         * @brief A single shader program inside a mirrored block, every program is trapped individually so that writes to other parts of the block don't require it to be rehashed
+         */
         struct CacheEntry {
             ShaderBinary binary;
             u64 hash;
+            std::optional<nce::NCE::TrapHandle> trap; //!< A write trap on the guest pages backing the program
+            bool dirty{}; //!< If the program's pages have been written to since it was hashed
 
             CacheEntry(ShaderBinary binary, u64 hash) : binary{binary}, hash{hash} {}
         };
@@ -79,9 +84,7 @@ namespace skyline::gpu::interconnect::maxwell3d {
          */
         struct MirrorEntry {
             span<u8> mirror;
-            tsl::robin_map<u8 *, CacheEntry> cache;
-            std::optional<nce::NCE::TrapHandle> trap;
-            bool dirty{};
+            tsl::robin_map<u8 *, std::unique_ptr<CacheEntry>> cache; //!< Programs in the block keyed by their guest address, these are heap allocated as the trap callbacks hold pointers to them
 
             MirrorEntry(span<u8> alignedMirror) : mirror{alignedMirror} {}
         };
@@ -94,6 +97,7 @@ namespace skyline::gpu::interconnect::maxwell3d {
         std::optional<std::scoped_lock<std::mutex>> trapExecutionLock;
         MirrorEntry *entry{};
         span<u8> mirrorBlock{}; //!< Guest mapped memory block corresponding to `entry`
+        CacheEntry *program{}; //!< The cache entry of the currently bound program, this is null if no program is bound
 
       public:
         ShaderBinary binary;
@@ -322,6 +326,7 @@ namespace skyline::gpu::interconnect::maxwell3d {
         PipelineManager pipelineManager{};
 
         PackedPipelineState packedState{};
+        PackedPipelineState keyPackedState{}; //!< A copy of the packed state with all host dynamic state cleared, this is used as the pipeline key when extended dynamic state is supported
 
         dirty::BoundSubresource<EngineRegisters> engine;
 
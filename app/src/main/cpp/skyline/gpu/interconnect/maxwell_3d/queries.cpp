@@ -0,0 +1,233 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <range/v3/view.hpp>
+#include <gpu.h>
+#include <gpu/interconnect/command_executor.h>
+#include <soc/gm20b/channel.h>
+#include <soc/gm20b/gmmu.h>
+#include <soc/gm20b/engines/engine.h>
+#include "queries.h"
+
+namespace skyline::gpu::interconnect::maxwell3d {
+    Queries::QueryChunk::QueryChunk(GPU &gpu)
+        : pool{gpu.vkDevice, vk::QueryPoolCreateInfo{
+            .queryType = vk::QueryType::eOcclusion,
+            .queryCount = QueryCount,
+        }},
+          results{gpu.memory.AllocateReadbackBuffer(QueryCount * sizeof(u64))} {}
+
+    u64 Queries::QueryRange::Sum() const {
+        u64 sum{};
+        for (u64 result : chunk->results->cast<u64>().subspan(first, count))
+            sum += result;
+        return sum;
+    }
+
+    /**
+     * @brief Writes an object to the supplied offset in a host mapping of guest memory, this handles objects which are split across multiple ranges
+     */
+    static void WriteToMapping(const TranslatedAddressRange &mapping, size_t offset, util::TrivialObject auto value) {
+        span<u8> source{reinterpret_cast<u8 *>(&value), sizeof(value)};
+        for (auto range : mapping) {
+            if (offset >= range.size()) {
+                offset -= range.size();
+                continue;
+            }
+
+            size_t size{std::min(range.size() - offset, source.size())};
+            if (range.data()) // Unmapped ranges are skipped, the guest can't observe writes to them
+                std::memcpy(range.data() + offset, source.data(), size);
+
+            source = source.subspan(size);
+            offset = 0;
+            if (source.empty())
+                break;
+        }
+    }
+
+    void Queries::Report::Write() {
+        u64 result{base};
+        for (const auto &range : ranges)
+            result += range.Sum();
+        ranges.clear(); // The chunks can be recycled as soon as the result is known
+
+        if (fourWords) {
+            // Write the timestamp first to ensure correct ordering, this is taken once the GPU has completed the queries
+            WriteToMapping(mapping, 8, soc::gm20b::engine::GetGpuTimeTicks());
+            WriteToMapping(mapping, 0, result);
+        } else {
+            WriteToMapping(mapping, 0, static_cast<u32>(result));
+        }
+
+        written.test_and_set(std::memory_order_release);
+    }
+
+    Queries::Queries(const EngineRegisters &engineRegisters) : engineRegisters{engineRegisters}, chunkPool{std::make_shared<ChunkPool>()} {}
+
+    Queries::SampleQuery Queries::AllocateSampleQuery(InterconnectContext &ctx) {
+        if (!IsCountingSamples())
+            return {};
+
+        if (!activeChunk || activeChunk->used == QueryChunk::QueryCount) {
+            if (activeChunk)
+                executionChunks.emplace_back(activeChunk, activeChunk->used);
+
+            std::unique_ptr<QueryChunk> chunk;
+            {
+                std::scoped_lock lock{chunkPool->mutex};
+                if (!chunkPool->chunks.empty()) {
+                    chunk = std::move(chunkPool->chunks.back());
+                    chunkPool->chunks.pop_back();
+                }
+            }
+
+            if (chunk) {
+                chunk->used = 0;
+                chunk->resolved.clear(std::memory_order_relaxed);
+            } else {
+                chunk = std::make_unique<QueryChunk>(ctx.gpu);
+            }
+
+            // Chunks are returned to the pool once the last execution or report referencing them is done with them
+            activeChunk = std::shared_ptr<QueryChunk>{chunk.release(), [pool = chunkPool](QueryChunk *chunk) {
+                std::scoped_lock lock{pool->mutex};
+                pool->chunks.emplace_back(chunk);
+            }};
+
+            // Queries are recorded inside render passes where they can't be reset, the reset is recorded prior to the active render pass which is always before any queries from the chunk are used
+            ctx.executor.AddPreRenderPassCommand([pool = *activeChunk->pool](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &, GPU &) {
+                commandBuffer.resetQueryPool(pool, 0, QueryChunk::QueryCount);
+            });
+        }
+
+        u32 index{activeChunk->used++};
+        if (!pendingSamples.empty() && pendingSamples.back().chunk == activeChunk && pendingSamples.back().first + pendingSamples.back().count == index)
+            pendingSamples.back().count++;
+        else
+            pendingSamples.push_back({activeChunk, index, 1});
+
+        return {
+            .pool = *activeChunk->pool,
+            .index = index,
+            .flags = ctx.gpu.traits.supportsOcclusionQueryPrecise ? vk::QueryControlFlagBits::ePrecise : vk::QueryControlFlags{},
+        };
+    }
+
+    void Queries::Resolve(InterconnectContext &ctx) {
+        if (activeChunk) {
+            u32 used{activeChunk->used};
+            executionChunks.emplace_back(std::move(activeChunk), used);
+        }
+        if (executionChunks.empty())
+            return;
+
+        for (const auto &chunk : executionChunks | ranges::views::keys)
+            ctx.executor.cycle->AttachCallback([chunk] {
+                chunk->resolved.test_and_set(std::memory_order_release);
+            });
+
+        ctx.executor.AddOutsideRpCommand([chunks = std::move(executionChunks)](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &, GPU &) {
+            for (const auto &[chunk, count] : chunks)
+                commandBuffer.copyQueryPoolResults(*chunk->pool, 0, count, chunk->results->vkBuffer, 0, sizeof(u64), vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
+
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, vk::MemoryBarrier{
+                .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+                .dstAccessMask = vk::AccessFlagBits::eHostRead,
+            }, {}, {});
+        });
+        executionChunks.clear();
+
+        FoldResolvedSamples();
+    }
+
+    void Queries::FoldResolvedSamples() {
+        std::erase_if(pendingSamples, [this](const QueryRange &range) {
+            if (!range.chunk->resolved.test(std::memory_order_acquire))
+                return false;
+
+            resolvedSamples += range.Sum();
+            return true;
+        });
+    }
+
+    void Queries::ResetCounter(engine::CounterReset counter) {
+        switch (counter) {
+            case engine::CounterReset::SamplesPassed:
+                resolvedSamples = 0;
+                pendingSamples.clear();
+                break;
+
+            default:
+                Logger::Debug("Unsupported counter reset: 0x{:X}", static_cast<u32>(counter));
+                break;
+        }
+    }
+
+    void Queries::ReportSampleCounter(InterconnectContext &ctx, u64 address, bool fourWords) {
+        FoldResolvedSamples();
+
+        auto report{std::make_shared<Report>()};
+        report->mapping = ctx.channelCtx.asCtx->gmmu.TranslateRange(address, fourWords ? sizeof(u64) * 2 : sizeof(u32));
+        report->fourWords = fourWords;
+        report->base = resolvedSamples;
+        report->ranges = pendingSamples;
+
+        if (report->ranges.empty()) {
+            // All contributing queries have already been resolved, so there's nothing to wait on
+            report->Write();
+            pendingReports.erase(address);
+            return;
+        }
+
+        // The GPU completes submissions in order, so once the current execution has completed all prior ones containing queries from the report have too
+        ctx.executor.cycle->AttachCallback([report] {
+            report->Write();
+        });
+        pendingReports.insert_or_assign(address, std::move(report));
+    }
+
+    bool Queries::IsReportPending(u64 address) {
+        auto it{pendingReports.find(address)};
+        if (it == pendingReports.end())
+            return false;
+
+        if (it->second->written.test(std::memory_order_acquire)) {
+            pendingReports.erase(it);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool Queries::IsRenderEnabled(InterconnectContext &ctx) {
+        const auto &renderEnable{engineRegisters.renderEnable};
+        switch (renderEnable.mode) {
+            case engine::RenderEnable::Mode::False:
+                return false;
+
+            case engine::RenderEnable::Mode::True:
+                return true;
+
+            case engine::RenderEnable::Mode::Conditional:
+                if (IsReportPending(renderEnable.address))
+                    return true;
+                return ctx.channelCtx.asCtx->gmmu.Read<u64>(renderEnable.address) != 0;
+
+            case engine::RenderEnable::Mode::RenderIfEqual:
+            case engine::RenderEnable::Mode::RenderIfNotEqual: {
+                constexpr u64 SecondReportOffset{0x10};
+                if (IsReportPending(renderEnable.address) || IsReportPending(renderEnable.address + SecondReportOffset))
+                    return true;
+
+                auto &gmmu{ctx.channelCtx.asCtx->gmmu};
+                bool equal{gmmu.Read<u64>(renderEnable.address) == gmmu.Read<u64>(renderEnable.address + SecondReportOffset)};
+                return equal == (renderEnable.mode == engine::RenderEnable::Mode::RenderIfEqual);
+            }
+
+            default:
+                Logger::Warn("Unknown render enable mode: {}", static_cast<u8>(renderEnable.mode));
+                return true;
+        }
+    }
+}
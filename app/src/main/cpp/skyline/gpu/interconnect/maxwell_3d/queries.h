@@ -0,0 +1,144 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common/address_space.h>
+#include <gpu/memory_manager.h>
+#include "common.h"
+
+namespace skyline::gpu::interconnect::maxwell3d {
+    /**
+     * @brief Emulates the counters that the guest reports through semaphores and the conditional rendering that can depend on them using host queries
+     * @note Results are copied out of the query pools on the GPU at the end of every execution and written back to guest memory from the cycle waiter thread once it has completed, reports never wait on the GPU
+     * @note Queries are scoped to individual draws as they can't span across subpasses which may be recorded into different command buffers, the value of a counter is the sum of all queries since it was last reset
+     */
+    class Queries {
+      public:
+        struct EngineRegisters {
+            const u32 &sampleCounterEnable;
+            const engine::RenderEnable &renderEnable;
+        };
+
+        /**
+         * @brief A query that a draw should be wrapped in, the pool is null if the draw isn't counted
+         */
+        struct SampleQuery {
+            vk::QueryPool pool;
+            u32 index;
+            vk::QueryControlFlags flags;
+
+            /**
+             * @brief Begins the query prior to the draw commands, this is a no-op for draws which aren't counted
+             */
+            void Begin(vk::raii::CommandBuffer &commandBuffer) const {
+                if (pool)
+                    commandBuffer.beginQuery(pool, index, flags);
+            }
+
+            void End(vk::raii::CommandBuffer &commandBuffer) const {
+                if (pool)
+                    commandBuffer.endQuery(pool, index);
+            }
+        };
+
+      private:
+        /**
+         * @brief A pool of queries alongside a host buffer which their results are copied into, a chunk is only used during a single execution and recycled once it's no longer referenced
+         */
+        struct QueryChunk {
+            static constexpr u32 QueryCount{0x400}; //!< The amount of queries in a chunk, this is large enough for most executions to only require a single chunk
+
+            vk::raii::QueryPool pool;
+            std::shared_ptr<memory::StagingBuffer> results; //!< The 64-bit results of all queries, these are valid once `resolved` is set
+            u32 used{}; //!< The amount of queries which have been allocated from the chunk during its current execution
+            std::atomic_flag resolved; //!< If the execution the chunk was used in has completed
+
+            QueryChunk(GPU &gpu);
+        };
+
+        /**
+         * @brief Chunks which aren't referenced by any executions or reports, these are returned from the cycle waiter thread
+         */
+        struct ChunkPool {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<QueryChunk>> chunks;
+        };
+
+        /**
+         * @brief A range of consecutive queries in a chunk
+         */
+        struct QueryRange {
+            std::shared_ptr<QueryChunk> chunk;
+            u32 first;
+            u32 count;
+
+            u64 Sum() const;
+        };
+
+        /**
+         * @brief A report of a counter that's written to guest memory once all queries contributing to it have been resolved
+         */
+        struct Report {
+            TranslatedAddressRange mapping; //!< The host mapping of the guest structure, this is translated while the report is made as the GMMU may be modified by the time it's written
+            bool fourWords; //!< If the report is written with a timestamp rather than as a single word
+            u64 base; //!< The sum of all queries in the report which were resolved prior to it being made
+            std::vector<QueryRange> ranges; //!< The queries which still need to be resolved, these are summed up while writing the report
+            std::atomic_flag written;
+
+            void Write();
+        };
+
+        EngineRegisters engineRegisters;
+        std::shared_ptr<ChunkPool> chunkPool;
+        std::shared_ptr<QueryChunk> activeChunk; //!< The chunk which queries are allocated from during the current execution
+        std::vector<std::pair<std::shared_ptr<QueryChunk>, u32>> executionChunks; //!< All chunks used during the current execution alongside the amount of queries used from them at the time they were retired
+
+        u64 resolvedSamples{}; //!< The sum of all resolved queries since the sample counter was last reset
+        std::vector<QueryRange> pendingSamples; //!< Queries since the sample counter was last reset which haven't been resolved yet
+        std::unordered_map<u64, std::shared_ptr<Report>> pendingReports; //!< A map from the guest address of reports to the last report made to them, this is used to determine if the result is available for conditional rendering
+
+        /**
+         * @brief Folds all queries in `pendingSamples` which have been resolved into `resolvedSamples`
+         */
+        void FoldResolvedSamples();
+
+        /**
+         * @return If a report to the supplied address is yet to be written to guest memory
+         */
+        bool IsReportPending(u64 address);
+
+      public:
+        Queries(const EngineRegisters &engineRegisters);
+
+        /**
+         * @return If draws currently contribute to the sample counter
+         */
+        bool IsCountingSamples() const {
+            return engineRegisters.sampleCounterEnable != 0;
+        }
+
+        /**
+         * @return The query that the next draw should be wrapped in, this is a null query if sample counting is disabled
+         */
+        SampleQuery AllocateSampleQuery(InterconnectContext &ctx);
+
+        /**
+         * @brief Records copies of all queries used during the current execution into host buffers, this must be done after all draws of the execution have been added
+         */
+        void Resolve(InterconnectContext &ctx);
+
+        void ResetCounter(engine::CounterReset counter);
+
+        /**
+         * @brief Writes the current value of the sample counter to the semaphore structure at the supplied address once it's available
+         */
+        void ReportSampleCounter(InterconnectContext &ctx, u64 address, bool fourWords);
+
+        /**
+         * @return If draws and clears should be performed based on the render enable state
+         * @note Rendering is performed when the reports it depends on haven't been written yet, this is always correct as conditional rendering is only used to skip redundant work
+         */
+        bool IsRenderEnabled(InterconnectContext &ctx);
+    };
+}
@@ -7,17 +7,18 @@
 
 namespace skyline::gpu::interconnect::maxwell3d {
     void SamplerPoolState::EngineRegisters::DirtyBind(DirtyManager &manager, dirty::Handle handle) const {
-        manager.Bind(handle, samplerBinding, texSamplerPool, texHeaderPool);
+        manager.Bind(handle, texSamplerPool, texHeaderPool);
     }
 
     SamplerPoolState::SamplerPoolState(dirty::Handle dirtyHandle, DirtyManager &manager, const EngineRegisters &engine) : engine{manager, dirtyHandle, engine} {}
 
-    void SamplerPoolState::Flush(InterconnectContext &ctx) {
-        useTexHeaderBinding = engine->samplerBinding.value == engine::SamplerBinding::Value::ViaHeaderBinding;
+    void SamplerPoolState::Flush(InterconnectContext &ctx, bool pUseTexHeaderBinding) {
+        useTexHeaderBinding = pUseTexHeaderBinding;
         u32 maximumIndex{useTexHeaderBinding ? engine->texHeaderPool.maximumIndex : engine->texSamplerPool.maximumIndex};
         auto mapping{ctx.channelCtx.asCtx->gmmu.LookupBlock(engine->texSamplerPool.offset)};
 
         texSamplers = mapping.first.subspan(mapping.second).cast<TextureSamplerControl>().first(maximumIndex + 1);
+        writeTracker.Track(ctx, texSamplers.cast<u8>());
     }
 
     void SamplerPoolState::PurgeCaches() {
@@ -28,7 +29,16 @@ namespace skyline::gpu::interconnect::maxwell3d {
 
     void Samplers::MarkAllDirty() {
         samplerPool.MarkDirty(true);
-        std::fill(texSamplerCache.begin(), texSamplerCache.end(), nullptr);
+    }
+
+    void Samplers::Update(InterconnectContext &ctx, bool useTexHeaderBinding) {
+        // The binding mode determines the size of the pool so it needs to be flushed again when it changes
+        if (texHeaderBinding != useTexHeaderBinding) {
+            texHeaderBinding = useTexHeaderBinding;
+            samplerPool.MarkDirty(true);
+        }
+
+        samplerPool.Update(ctx, useTexHeaderBinding);
     }
 
     static vk::Filter ConvertSamplerFilter(TextureSamplerControl::Filter filter) {
@@ -140,14 +150,19 @@ namespace skyline::gpu::interconnect::maxwell3d {
     }
 
     vk::raii::Sampler *Samplers::GetSampler(InterconnectContext &ctx, u32 samplerIndex, u32 textureIndex) {
-        const auto &samplerPoolObj{samplerPool.UpdateGet(ctx)};
+        const auto &samplerPoolObj{samplerPool.Get()};
         u32 index{samplerPoolObj.useTexHeaderBinding ? textureIndex : samplerIndex};
         auto texSamplers{samplerPoolObj.texSamplers};
+        u32 generation{samplerPoolObj.writeTracker.GetGeneration()}; // This must be read prior to the TSC so that any writes after it invalidate the entry
         if (texSamplers.size() != texSamplerCache.size()) {
             texSamplerCache.resize(texSamplers.size());
-            std::fill(texSamplerCache.begin(), texSamplerCache.end(), nullptr);
-        } else if (texSamplerCache[index]) {
-            return texSamplerCache[index];
+            std::fill(texSamplerCache.begin(), texSamplerCache.end(), CacheEntry{});
+        } else if (auto &cached{texSamplerCache[index]}; cached.sampler) {
+            // Entries from prior executions are only valid if the pool hasn't been written to since, the TSC would need to be hashed otherwise
+            if (cached.executionNumber == ctx.executor.executionNumber || (generation && cached.generation == generation)) {
+                cached.executionNumber = ctx.executor.executionNumber;
+                return cached.sampler;
+            }
         }
 
         TextureSamplerControl &texSampler{texSamplers[index]};
@@ -203,7 +218,7 @@ namespace skyline::gpu::interconnect::maxwell3d {
             sampler = std::make_unique<vk::raii::Sampler>(ctx.gpu.vkDevice, samplerInfo.get<vk::SamplerCreateInfo>());
         }
 
-        texSamplerCache[index] = sampler.get();
+        texSamplerCache[index] = {sampler.get(), ctx.executor.executionNumber, generation};
         return sampler.get();
     }
 
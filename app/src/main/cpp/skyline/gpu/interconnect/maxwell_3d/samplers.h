@@ -11,7 +11,6 @@ namespace skyline::gpu::interconnect::maxwell3d {
     class SamplerPoolState : dirty::CachedManualDirty {
       public:
         struct EngineRegisters {
-            const engine::SamplerBinding &samplerBinding;
             const engine::TexSamplerPool &texSamplerPool;
             const engine::TexHeaderPool &texHeaderPool;
 
@@ -24,10 +23,11 @@ namespace skyline::gpu::interconnect::maxwell3d {
       public:
         span<TextureSamplerControl> texSamplers;
         bool useTexHeaderBinding;
+        PoolWriteTracker writeTracker;
 
         SamplerPoolState(dirty::Handle dirtyHandle, DirtyManager &manager, const EngineRegisters &engine);
 
-        void Flush(InterconnectContext &ctx);
+        void Flush(InterconnectContext &ctx, bool useTexHeaderBinding);
 
         void PurgeCaches();
     };
@@ -37,13 +37,26 @@ namespace skyline::gpu::interconnect::maxwell3d {
         dirty::ManualDirtyState<SamplerPoolState> samplerPool;
 
         tsl::robin_map<TextureSamplerControl, std::unique_ptr<vk::raii::Sampler>, util::ObjectHash<TextureSamplerControl>> texSamplerStore;
-        std::vector<vk::raii::Sampler *> texSamplerCache;
+
+        struct CacheEntry {
+            vk::raii::Sampler *sampler;
+            u32 executionNumber;
+            u32 generation; //!< The generation of the pool when the entry was cached, the entry remains valid across executions while the pool generation matches
+        };
+        std::vector<CacheEntry> texSamplerCache;
+        bool texHeaderBinding{}; //!< The sampler binding mode the pool was last updated with
 
       public:
         Samplers(DirtyManager &manager, const SamplerPoolState::EngineRegisters &engine);
 
         void MarkAllDirty();
 
+        /**
+         * @brief Updates the sampler pool state, this **must** be called prior to any GetSampler calls for a draw or dispatch
+         * @param useTexHeaderBinding If the TIC index should be used as the TSC index, this is sourced from a register for 3D and from the QMD for compute
+         */
+        void Update(InterconnectContext &ctx, bool useTexHeaderBinding);
+
         vk::raii::Sampler *GetSampler(InterconnectContext &ctx, u32 samplerIndex, u32 textureIndex);
     };
 }
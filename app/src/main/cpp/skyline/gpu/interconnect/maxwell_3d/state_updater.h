@@ -4,7 +4,9 @@
 #pragma once
 
 #include <gpu/interconnect/command_executor.h>
+#include <common/perf_stats.h>
 #include "common.h"
+#include "packed_pipeline_state.h"
 
 namespace skyline::gpu::interconnect::maxwell3d {
     /**
@@ -185,6 +187,44 @@ namespace skyline::gpu::interconnect::maxwell3d {
     };
     using SetBaseStencilStateCmd = CmdHolder<SetBaseStencilStateCmdImpl>;
 
+    struct SetExtendedDynamicStateCmdImpl {
+        void Record(GPU &gpu, vk::raii::CommandBuffer &commandBuffer) {
+            commandBuffer.setCullModeEXT(cullMode);
+            commandBuffer.setFrontFaceEXT(frontFace);
+            commandBuffer.setPrimitiveTopologyEXT(topology);
+            commandBuffer.setDepthTestEnableEXT(depthTestEnable);
+            commandBuffer.setDepthWriteEnableEXT(depthWriteEnable);
+            commandBuffer.setDepthCompareOpEXT(depthCompareOp);
+            commandBuffer.setDepthBoundsTestEnableEXT(depthBoundsTestEnable);
+            commandBuffer.setStencilTestEnableEXT(stencilTestEnable);
+            commandBuffer.setStencilOpEXT(vk::StencilFaceFlagBits::eFront, stencilFront.failOp, stencilFront.passOp, stencilFront.depthFailOp, stencilFront.compareOp);
+            commandBuffer.setStencilOpEXT(vk::StencilFaceFlagBits::eBack, stencilBack.failOp, stencilBack.passOp, stencilBack.depthFailOp, stencilBack.compareOp);
+        }
+
+        vk::CullModeFlags cullMode;
+        vk::FrontFace frontFace;
+        vk::PrimitiveTopology topology;
+        bool depthTestEnable;
+        bool depthWriteEnable;
+        vk::CompareOp depthCompareOp;
+        bool depthBoundsTestEnable;
+        bool stencilTestEnable;
+        vk::StencilOpState stencilFront;
+        vk::StencilOpState stencilBack;
+    };
+    using SetExtendedDynamicStateCmd = CmdHolder<SetExtendedDynamicStateCmdImpl>;
+
+    struct SetExtendedDynamicState2CmdImpl {
+        void Record(GPU &gpu, vk::raii::CommandBuffer &commandBuffer) {
+            commandBuffer.setDepthBiasEnableEXT(depthBiasEnable);
+            commandBuffer.setRasterizerDiscardEnableEXT(rasterizerDiscardEnable);
+        }
+
+        bool depthBiasEnable;
+        bool rasterizerDiscardEnable;
+    };
+    using SetExtendedDynamicState2Cmd = CmdHolder<SetExtendedDynamicState2CmdImpl>;
+
     template<bool PushDescriptor>
     struct SetDescriptorSetCmdImpl {
         void Record(GPU &gpu, vk::raii::CommandBuffer &commandBuffer) {
@@ -207,12 +247,11 @@ namespace skyline::gpu::interconnect::maxwell3d {
             }
 
             if constexpr (PushDescriptor) {
-                commandBuffer.pushDescriptorSetKHR(updateInfo->bindPoint, updateInfo->pipelineLayout, updateInfo->descriptorSetIndex, updateInfo->writes);
+                if (updateInfo->updateTemplate)
+                    commandBuffer.getDispatcher()->vkCmdPushDescriptorSetWithTemplateKHR(*commandBuffer, static_cast<VkDescriptorUpdateTemplate>(updateInfo->updateTemplate), static_cast<VkPipelineLayout>(updateInfo->pipelineLayout), updateInfo->descriptorSetIndex, updateInfo->templateData);
+                else
+                    commandBuffer.pushDescriptorSetKHR(updateInfo->bindPoint, updateInfo->pipelineLayout, updateInfo->descriptorSetIndex, updateInfo->writes);
             } else {
-                // Set the destination/(source) descriptor set(s) for all writes/(copies)
-                for (auto &write : updateInfo->writes)
-                    write.dstSet = **dstSet;
-
                 for (auto &copy : updateInfo->copies) {
                     copy.dstSet = **dstSet;
                     copy.srcSet = **srcSet;
@@ -222,8 +261,14 @@ namespace skyline::gpu::interconnect::maxwell3d {
                 if (!updateInfo->copies.empty())
                     gpu.vkDevice.updateDescriptorSets({}, updateInfo->copies);
 
-                if (!updateInfo->writes.empty())
+                if (updateInfo->updateTemplate) {
+                    gpu.vkDevice.getDispatcher()->vkUpdateDescriptorSetWithTemplate(*gpu.vkDevice, static_cast<VkDescriptorSet>(**dstSet), static_cast<VkDescriptorUpdateTemplate>(updateInfo->updateTemplate), updateInfo->templateData);
+                } else if (!updateInfo->writes.empty()) {
+                    for (auto &write : updateInfo->writes)
+                        write.dstSet = **dstSet;
+
                     gpu.vkDevice.updateDescriptorSets(updateInfo->writes, {});
+                }
 
                 // Bind the updated descriptor set and we're done!
                 commandBuffer.bindDescriptorSets(updateInfo->bindPoint, updateInfo->pipelineLayout, updateInfo->descriptorSetIndex, **dstSet, {});
@@ -237,6 +282,15 @@ namespace skyline::gpu::interconnect::maxwell3d {
     using SetDescriptorSetWithUpdateCmd = CmdHolder<SetDescriptorSetCmdImpl<false>>;
     using SetDescriptorSetWithPushCmd = CmdHolder<SetDescriptorSetCmdImpl<true>>;
 
+    struct SetPushConstantsCmdImpl {
+        void Record(GPU &gpu, vk::raii::CommandBuffer &commandBuffer) {
+            commandBuffer.pushConstants<u8>(updateInfo.pipelineLayout, updateInfo.stageFlags, 0, span(updateInfo.data).first(updateInfo.size));
+        }
+
+        PushConstantUpdateInfo updateInfo;
+    };
+    using SetPushConstantsCmd = CmdHolder<SetPushConstantsCmdImpl>;
+
     struct SetPipelineCmdImpl {
         void Record(GPU &gpu, vk::raii::CommandBuffer &commandBuffer) {
             commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
@@ -256,6 +310,13 @@ namespace skyline::gpu::interconnect::maxwell3d {
       public:
         StateUpdater(StateUpdateCmdHeader *first) : first{first} {}
 
+        /**
+         * @return If there are no state updates to record, meaning that all state is identical to that of the previous draw
+         */
+        bool Empty() const {
+            return !first;
+        }
+
         /**
          * @brief Records all contained state updates into the given command buffer
          */
@@ -265,12 +326,70 @@ namespace skyline::gpu::interconnect::maxwell3d {
         }
     };
 
+    /**
+     * @brief Tracks the vertex and index buffer bindings that have been recorded into the current command buffer, allowing for any redundant rebinds to be skipped
+     * @note This must be reset whenever subsequent state updates could be recorded into a different command buffer
+     */
+    class BufferBindingTracker {
+      private:
+        /**
+         * @brief A binding to either a fixed buffer or a buffer view that is resolved during recording, views are compared by their buffer at the time of the update as any recreation of it would redirect all views consistently
+         */
+        struct Binding {
+            std::variant<vk::Buffer, Buffer *> buffer;
+            vk::DeviceSize offset;
+
+            bool operator==(const Binding &) const = default;
+        };
+
+        std::array<std::optional<Binding>, engine::VertexStreamCount> vertexBuffers;
+        std::optional<std::pair<Binding, vk::IndexType>> indexBuffer;
+
+        template<typename T>
+        static bool Update(std::optional<T> &recorded, const T &binding) {
+            if (recorded == binding)
+                return false;
+
+            recorded = binding;
+            return true;
+        }
+
+      public:
+        /**
+         * @return If the supplied binding differs from the one recorded for the vertex buffer binding and needs to be recorded
+         */
+        bool UpdateVertexBuffer(u32 index, vk::Buffer buffer, vk::DeviceSize offset) {
+            return Update(vertexBuffers[index], Binding{buffer, offset});
+        }
+
+        bool UpdateVertexBuffer(u32 index, BufferView &view) {
+            return Update(vertexBuffers[index], Binding{view.GetBuffer(), view.GetOffset()});
+        }
+
+        /**
+         * @return If the supplied binding differs from the one recorded for the index buffer and needs to be recorded
+         */
+        bool UpdateIndexBuffer(vk::Buffer buffer, vk::DeviceSize offset, vk::IndexType indexType) {
+            return Update(indexBuffer, std::pair{Binding{buffer, offset}, indexType});
+        }
+
+        bool UpdateIndexBuffer(BufferView &view, vk::IndexType indexType) {
+            return Update(indexBuffer, std::pair{Binding{view.GetBuffer(), view.GetOffset()}, indexType});
+        }
+
+        void Reset() {
+            vertexBuffers = {};
+            indexBuffer.reset();
+        }
+    };
+
     /**
      * @brief Allows for quick construction of a batch of associated Vulkan state updates that can later be recorded
      */
     class StateUpdateBuilder {
       private:
         LinearAllocatorState<> &allocator;
+        BufferBindingTracker *bindingTracker; //!< An optional tracker of buffer bindings in the target command buffer used to skip redundant binds
         u32 vertexBatchBindNextBinding{};
         SetVertexBuffersDynamicCmd *vertexBatchBind{};
         StateUpdateCmdHeader *head{};
@@ -300,7 +419,7 @@ namespace skyline::gpu::interconnect::maxwell3d {
         }
 
       public:
-        StateUpdateBuilder(LinearAllocatorState<> &allocator) : allocator{allocator} {
+        StateUpdateBuilder(LinearAllocatorState<> &allocator, BufferBindingTracker *bindingTracker = nullptr) : allocator{allocator}, bindingTracker{bindingTracker} {
             vertexBatchBind = allocator.EmplaceUntracked<SetVertexBuffersDynamicCmd>();
         }
 
@@ -310,6 +429,11 @@ namespace skyline::gpu::interconnect::maxwell3d {
         }
 
         void SetVertexBuffer(u32 index, const BufferBinding &binding) {
+            if (bindingTracker && !bindingTracker->UpdateVertexBuffer(index, binding.buffer, binding.offset)) {
+                PerfStats::Increment(PerfStats::Counter::RedundantVertexBufferBinds);
+                return;
+            }
+
             if (index != vertexBatchBindNextBinding || vertexBatchBind->header.record != &SetVertexBuffersCmd::Record) {
                 FlushVertexBatchBind();
                 vertexBatchBind->header.record = &SetVertexBuffersCmd::Record;
@@ -326,6 +450,11 @@ namespace skyline::gpu::interconnect::maxwell3d {
         void SetVertexBuffer(u32 index, BufferView view) {
             view.GetBuffer()->BlockSequencedCpuBackingWrites();
 
+            if (bindingTracker && !bindingTracker->UpdateVertexBuffer(index, view)) {
+                PerfStats::Increment(PerfStats::Counter::RedundantVertexBufferBinds);
+                return;
+            }
+
             if (index != vertexBatchBindNextBinding || vertexBatchBind->header.record != &SetVertexBuffersDynamicCmd::Record) {
                 FlushVertexBatchBind();
                 vertexBatchBind->header.record = &SetVertexBuffersDynamicCmd::Record;
@@ -339,6 +468,11 @@ namespace skyline::gpu::interconnect::maxwell3d {
         }
 
         void SetIndexBuffer(const BufferBinding &binding, vk::IndexType indexType) {
+            if (bindingTracker && !bindingTracker->UpdateIndexBuffer(binding.buffer, binding.offset, indexType)) {
+                PerfStats::Increment(PerfStats::Counter::RedundantIndexBufferBinds);
+                return;
+            }
+
             AppendCmd<SetIndexBufferCmd>(
                 {
                     .indexType = indexType,
@@ -350,6 +484,11 @@ namespace skyline::gpu::interconnect::maxwell3d {
         void SetIndexBuffer(BufferView view, vk::IndexType indexType) {
             view.GetBuffer()->BlockSequencedCpuBackingWrites();
 
+            if (bindingTracker && !bindingTracker->UpdateIndexBuffer(view, indexType)) {
+                PerfStats::Increment(PerfStats::Counter::RedundantIndexBufferBinds);
+                return;
+            }
+
             AppendCmd<SetIndexBufferDynamicCmd>(
                 {
                     .base.indexType = indexType,
@@ -434,6 +573,37 @@ namespace skyline::gpu::interconnect::maxwell3d {
                 });
         }
 
+        /**
+         * @brief Sets all state from VK_EXT_extended_dynamic_state to that of the supplied pipeline state
+         */
+        void SetExtendedDynamicState(const PackedPipelineState &packedState) {
+            auto [stencilFront, stencilBack]{packedState.GetStencilOpsState()};
+            AppendCmd<SetExtendedDynamicStateCmd>(
+                {
+                    .cullMode = vk::CullModeFlags{packedState.cullMode},
+                    .frontFace = packedState.frontFaceClockwise ? vk::FrontFace::eClockwise : vk::FrontFace::eCounterClockwise,
+                    .topology = packedState.GetPrimitiveTopology(),
+                    .depthTestEnable = packedState.depthTestEnable,
+                    .depthWriteEnable = packedState.depthWriteEnable,
+                    .depthCompareOp = packedState.GetDepthFunc(),
+                    .depthBoundsTestEnable = packedState.depthBoundsTestEnable,
+                    .stencilTestEnable = packedState.stencilTestEnable,
+                    .stencilFront = stencilFront,
+                    .stencilBack = stencilBack,
+                });
+        }
+
+        /**
+         * @brief Sets all state from VK_EXT_extended_dynamic_state2 to that of the supplied pipeline state
+         */
+        void SetExtendedDynamicState2(const PackedPipelineState &packedState) {
+            AppendCmd<SetExtendedDynamicState2Cmd>(
+                {
+                    .depthBiasEnable = packedState.depthBiasEnable,
+                    .rasterizerDiscardEnable = packedState.rasterizerDiscardEnable,
+                });
+        }
+
         void SetDescriptorSetWithUpdate(DescriptorUpdateInfo *updateInfo, DescriptorAllocator::ActiveDescriptorSet *dstSet, DescriptorAllocator::ActiveDescriptorSet *srcSet) {
             AppendCmd<SetDescriptorSetWithUpdateCmd>(
                 {
@@ -456,5 +626,12 @@ namespace skyline::gpu::interconnect::maxwell3d {
                     .updateInfo = updateInfo,
                 });
         }
+
+        void SetPushConstants(const PushConstantUpdateInfo &updateInfo) {
+            AppendCmd<SetPushConstantsCmd>(
+                {
+                    .updateInfo = updateInfo,
+                });
+        }
     };
 }
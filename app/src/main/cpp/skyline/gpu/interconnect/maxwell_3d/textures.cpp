@@ -1,6 +1,8 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <unordered_set>
+#include <common/trace.h>
 #include <soc/gm20b/channel.h>
 #include <soc/gm20b/gmmu.h>
 #include <gpu/texture_manager.h>
@@ -18,6 +20,7 @@ namespace skyline::gpu::interconnect::maxwell3d {
         auto mapping{ctx.channelCtx.asCtx->gmmu.LookupBlock(engine->texHeaderPool.offset)};
 
         textureHeaders = mapping.first.subspan(mapping.second).cast<TextureImageControl>().first(engine->texHeaderPool.maximumIndex + 1);
+        writeTracker.Track(ctx, textureHeaders.cast<u8>());
     }
 
     void TexturePoolState::PurgeCaches() {
@@ -178,7 +181,9 @@ namespace skyline::gpu::interconnect::maxwell3d {
     }
 
     TextureView *Textures::GetTexture(InterconnectContext &ctx, u32 index, Shader::TextureType shaderType) {
-        auto textureHeaders{texturePool.UpdateGet(ctx).textureHeaders};
+        const auto &pool{texturePool.UpdateGet(ctx)};
+        auto textureHeaders{pool.textureHeaders};
+        u32 generation{pool.writeTracker.GetGeneration()}; // This must be read prior to the TIC so that any writes after it invalidate the entry
         if (textureHeaderCache.size() != textureHeaders.size()) {
             textureHeaderCache.resize(textureHeaders.size());
             std::fill(textureHeaderCache.begin(), textureHeaderCache.end(), CacheEntry{});
@@ -186,14 +191,23 @@ namespace skyline::gpu::interconnect::maxwell3d {
             if (cached.executionNumber == ctx.executor.executionNumber)
                 return cached.view;
 
-            if (cached.tic == textureHeaders[index]) {
+            // The TIC only needs to be compared if the pool might have been written to since the entry was validated
+            if ((generation && cached.generation == generation) || cached.tic == textureHeaders[index]) {
                 cached.executionNumber = ctx.executor.executionNumber;
+                cached.generation = generation;
                 return cached.view;
             }
         }
 
+        if (lastTrimExecutionNumber != ctx.executor.executionNumber && ctx.gpu.texture.IsOverBudget()) {
+            TrimTextureHeaderStore(ctx.executor.executionNumber);
+            lastTrimExecutionNumber = ctx.executor.executionNumber;
+        }
+
         TextureImageControl &textureHeader{textureHeaders[index]};
-        auto &texture{textureHeaderStore[textureHeader]};
+        auto &storeEntry{textureHeaderStore[textureHeader]};
+        storeEntry.executionNumber = ctx.executor.executionNumber;
+        auto &texture{storeEntry.view};
 
         if (!texture) {
             // If the entry didn't exist prior then we need to convert the TIC to a GuestTexture
@@ -315,10 +329,30 @@ namespace skyline::gpu::interconnect::maxwell3d {
             texture = ctx.gpu.texture.FindOrCreate(guest, ctx.executor.tag);
         }
 
-        textureHeaderCache[index] = {textureHeader, texture.get(), ctx.executor.executionNumber};
+        textureHeaderCache[index] = {textureHeader, texture.get(), ctx.executor.executionNumber, generation};
         return texture.get();
     }
 
+    void Textures::TrimTextureHeaderStore(u32 executionNumber) {
+        TRACE_EVENT("gpu", "Textures::TrimTextureHeaderStore");
+
+        // Views which have been returned from the cache recently must be retained alongside any recently used store entries
+        std::unordered_set<TextureView *> activeViews;
+        for (auto &entry : textureHeaderCache) {
+            if (entry.view && executionNumber - entry.executionNumber < StoreRetentionExecutions)
+                activeViews.insert(entry.view);
+            else
+                entry = {};
+        }
+
+        for (auto it{textureHeaderStore.begin()}; it != textureHeaderStore.end();) {
+            if (executionNumber - it->second.executionNumber < StoreRetentionExecutions || activeViews.contains(it->second.view.get()))
+                ++it;
+            else
+                it = textureHeaderStore.erase(it);
+        }
+    }
+
     Shader::TextureType Textures::GetTextureType(InterconnectContext &ctx, u32 index) {
         auto textureHeaders{texturePool.UpdateGet(ctx).textureHeaders};
         switch (textureHeaders[index].textureType) {
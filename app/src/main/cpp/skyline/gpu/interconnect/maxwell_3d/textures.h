@@ -22,6 +22,7 @@ namespace skyline::gpu::interconnect::maxwell3d {
 
       public:
         span<TextureImageControl> textureHeaders;
+        PoolWriteTracker writeTracker;
 
         TexturePoolState(dirty::Handle dirtyHandle, DirtyManager &manager, const EngineRegisters &engine);
 
@@ -35,15 +36,28 @@ namespace skyline::gpu::interconnect::maxwell3d {
         std::shared_ptr<TextureView> nullTextureView{};
         dirty::ManualDirtyState<TexturePoolState> texturePool;
 
-        tsl::robin_map<TextureImageControl, std::shared_ptr<TextureView>, util::ObjectHash<TextureImageControl>> textureHeaderStore;
+        struct StoreEntry {
+            std::shared_ptr<TextureView> view;
+            u32 executionNumber; //!< The execution in which the entry was last looked up in the store
+        };
+        tsl::robin_map<TextureImageControl, StoreEntry, util::ObjectHash<TextureImageControl>> textureHeaderStore;
 
         struct CacheEntry {
             TextureImageControl tic;
             TextureView *view;
             u32 executionNumber;
+            u32 generation; //!< The generation of the pool when the entry was validated, the TIC doesn't need to be compared if the pool generation still matches
         };
         std::vector<CacheEntry> textureHeaderCache;
 
+        static constexpr u32 StoreRetentionExecutions{64}; //!< The amount of executions a store entry is retained for after it was last used when the texture manager is over its memory budget
+        u32 lastTrimExecutionNumber{}; //!< The execution in which the store was last trimmed, this prevents trimming more than once per execution
+
+        /**
+         * @brief Releases all store entries that haven't been used in the last `StoreRetentionExecutions` executions so the textures they reference can be evicted
+         */
+        void TrimTextureHeaderStore(u32 executionNumber);
+
       public:
         Textures(DirtyManager &manager, const TexturePoolState::EngineRegisters &engine);
 
@@ -3,6 +3,7 @@
 // Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
 #include <gpu/buffer_manager.h>
+#include <gpu/texture_manager.h>
 #include <soc/gm20b/gmmu.h>
 #include <soc/gm20b/channel.h>
 #include "maxwell_dma.h"
@@ -15,19 +16,13 @@ namespace skyline::gpu::interconnect {
           channelCtx{channelCtx},
           executor{channelCtx.executor} {}
 
-    void MaxwellDma::Copy(IOVA dst, IOVA src, size_t size) {
-        auto srcMappings{channelCtx.asCtx->gmmu.TranslateRange(src, size)};
-        auto dstMappings{channelCtx.asCtx->gmmu.TranslateRange(dst, size)};
-
-        if (srcMappings.size() > 1 || dstMappings.size() > 1)
-            Logger::Warn("Split mapping are unsupported for DMA copies");
-
-        auto srcBuf{gpu.buffer.FindOrCreate(srcMappings.front(), executor.tag, [this](std::shared_ptr<Buffer> buffer, ContextLock<Buffer> &&lock) {
+    void MaxwellDma::CopyMapping(span<u8> dstMapping, span<u8> srcMapping) {
+        auto srcBuf{gpu.buffer.FindOrCreate(srcMapping, executor.tag, [this](std::shared_ptr<Buffer> buffer, ContextLock<Buffer> &&lock) {
             executor.AttachLockedBuffer(buffer, std::move(lock));
         })};
         ContextLock srcBufLock{executor.tag, srcBuf};
 
-        auto dstBuf{gpu.buffer.FindOrCreate(dstMappings.front(), executor.tag, [this](std::shared_ptr<Buffer> buffer, ContextLock<Buffer> &&lock) {
+        auto dstBuf{gpu.buffer.FindOrCreate(dstMapping, executor.tag, [this](std::shared_ptr<Buffer> buffer, ContextLock<Buffer> &&lock) {
             executor.AttachLockedBuffer(buffer, std::move(lock));
         })};
         ContextLock dstBufLock{executor.tag, dstBuf};
@@ -58,4 +53,114 @@ namespace skyline::gpu::interconnect {
             });
         });
     }
+
+    void MaxwellDma::Copy(IOVA dst, IOVA src, size_t size) {
+        auto srcMappings{channelCtx.asCtx->gmmu.TranslateRange(src, size)};
+        auto dstMappings{channelCtx.asCtx->gmmu.TranslateRange(dst, size)};
+
+        // Split the copy into chunks which are contiguous in both the source and destination mappings
+        auto srcMapping{srcMappings.begin()}, dstMapping{dstMappings.begin()};
+        size_t srcOffset{}, dstOffset{};
+        while (srcMapping != srcMappings.end() && dstMapping != dstMappings.end()) {
+            size_t chunkSize{std::min(srcMapping->size() - srcOffset, dstMapping->size() - dstOffset)};
+            if (srcMapping->data() && dstMapping->data())
+                CopyMapping(dstMapping->subspan(dstOffset, chunkSize), srcMapping->subspan(srcOffset, chunkSize));
+            else
+                Logger::Warn("DMA copy to or from unmapped memory: 0x{:X} -> 0x{:X}", src, dst);
+
+            if ((srcOffset += chunkSize) == srcMapping->size()) {
+                srcMapping++;
+                srcOffset = 0;
+            }
+
+            if ((dstOffset += chunkSize) == dstMapping->size()) {
+                dstMapping++;
+                dstOffset = 0;
+            }
+        }
+    }
+
+    bool MaxwellDma::CopyBlockLinear(IOVA pitchAddress, u32 pitch, const BlockLinearSurface &surface, u32 bytesPerPixel, u32 width, u32 height, bool toSurface) {
+        if (!height || pitch < width * bytesPerPixel || pitch % bytesPerPixel)
+            return false; // Vulkan requires the row length to be in whole texels and to cover the entire extent
+
+        auto [surfaceBlock, surfaceOffset]{channelCtx.asCtx->gmmu.LookupBlock(surface.address)};
+        if (!surfaceBlock.data())
+            return false;
+
+        auto view{gpu.texture.Lookup(surfaceBlock.data() + surfaceOffset, executor.tag)};
+        if (!view)
+            return false;
+
+        auto &texture{*view->texture};
+        auto &guest{*texture.guest};
+        bool is3D{guest.dimensions.depth > 1};
+        if (guest.tileConfig.mode != texture::TileMode::Block || guest.tileConfig.blockHeight != surface.blockHeight || guest.tileConfig.blockDepth != surface.blockDepth)
+            return false;
+
+        // The host format must be identical to the guest format for the copy to not require any conversion
+        if (texture.format != guest.format || guest.format->vkAspect != vk::ImageAspectFlags{vk::ImageAspectFlagBits::eColor} || guest.format->IsCompressed() || guest.format->bpb != bytesPerPixel || texture.sampleCount != vk::SampleCountFlagBits::e1)
+            return false;
+
+        if (texture.scale != 1.0f)
+            return false; // Buffer-image copies operate on guest texels which don't map directly to the texels of a scaled texture
+
+        if (guest.dimensions.width != surface.dimensions.width || guest.dimensions.height != surface.dimensions.height || (is3D && guest.dimensions.depth != surface.dimensions.depth))
+            return false;
+
+        if (surface.originX + width > surface.dimensions.width || surface.originY + height > surface.dimensions.height || surface.layer >= (is3D ? guest.dimensions.depth : texture.layerCount))
+            return false;
+
+        auto pitchMappings{channelCtx.asCtx->gmmu.TranslateRange(pitchAddress, static_cast<size_t>(pitch) * (height - 1) + static_cast<size_t>(width) * bytesPerPixel)};
+        if (pitchMappings.size() != 1 || !pitchMappings.front().data())
+            return false;
+
+        auto buffer{gpu.buffer.FindOrCreate(pitchMappings.front(), executor.tag, [this](std::shared_ptr<Buffer> buffer, ContextLock<Buffer> &&lock) {
+            executor.AttachLockedBuffer(buffer, std::move(lock));
+        })};
+        executor.AttachBuffer(buffer);
+        if (!toSurface)
+            buffer.GetBuffer()->MarkGpuDirty();
+        buffer.GetBuffer()->BlockSequencedCpuBackingWrites();
+
+        // Attaching the texture will synchronize it from the guest prior to the copy and mark it as GPU dirty after
+        executor.AttachDependency(view);
+        executor.AttachTexture(view.get());
+        if (!toSurface)
+            view->texture->MarkContentsObserved();
+
+        Logger::Debug("{} {}x{} at ({}, {}, {}) of 0x{:X} on the GPU", toSurface ? "Pitch -> block linear" : "Block linear -> pitch", width, height, surface.originX, surface.originY, surface.layer, surface.address);
+
+        vk::BufferImageCopy region{
+            .bufferRowLength = pitch / bytesPerPixel,
+            .bufferImageHeight = height,
+            .imageSubresource = {
+                .aspectMask = vk::ImageAspectFlagBits::eColor,
+                .baseArrayLayer = is3D ? 0 : surface.layer,
+                .layerCount = 1,
+            },
+            .imageOffset = {static_cast<i32>(surface.originX), static_cast<i32>(surface.originY), static_cast<i32>(is3D ? surface.layer : 0)},
+            .imageExtent = {width, height, 1},
+        };
+
+        executor.AddOutsideRpCommand([buffer, view, region, toSurface](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &, GPU &) mutable {
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eTransfer, {}, vk::MemoryBarrier{
+                .srcAccessMask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite,
+                .dstAccessMask = vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite
+            }, {}, {});
+
+            region.bufferOffset = buffer.GetOffset();
+            if (toSurface)
+                commandBuffer.copyBufferToImage(buffer.GetBuffer()->GetBacking(), view->texture->GetBacking(), vk::ImageLayout::eGeneral, region);
+            else
+                commandBuffer.copyImageToBuffer(view->texture->GetBacking(), vk::ImageLayout::eGeneral, buffer.GetBuffer()->GetBacking(), region);
+
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eAllCommands, {}, vk::MemoryBarrier{
+                .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+                .dstAccessMask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite,
+            }, {}, {});
+        });
+
+        return true;
+    }
 }
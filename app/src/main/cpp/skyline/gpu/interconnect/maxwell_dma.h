@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <gpu/texture/texture.h>
 #include <soc/gm20b/gmmu.h>
 
 namespace skyline::gpu {
@@ -28,9 +29,35 @@ namespace skyline::gpu::interconnect {
         soc::gm20b::ChannelContext &channelCtx;
         gpu::interconnect::CommandExecutor &executor;
 
+        /**
+         * @brief Copies between two host mappings which are each contiguous
+         */
+        void CopyMapping(span<u8> dstMapping, span<u8> srcMapping);
+
       public:
+        /**
+         * @brief A block linear surface that's the source or destination of a DMA copy
+         */
+        struct BlockLinearSurface {
+            IOVA address;
+            texture::Dimensions dimensions; //!< The dimensions of the surface in pixels
+            u8 blockHeight; //!< The height of the blocks in GOBs
+            u8 blockDepth; //!< The depth of the blocks in GOBs
+            u32 layer; //!< The array layer of the surface, this is the Z offset into 3D surfaces
+            u32 originX;
+            u32 originY;
+        };
+
         MaxwellDma(GPU &gpu, soc::gm20b::ChannelContext &channelCtx);
 
         void Copy(IOVA dst, IOVA src, size_t size);
+
+        /**
+         * @brief Copies a rectangle between a pitch linear buffer and a block linear surface on the GPU if the surface is backed by a compatible texture that's already tracked
+         * @param toSurface If the copy is from the buffer into the surface, otherwise the copy is from the surface into the buffer
+         * @return If the copy was recorded, the copy must be performed on the CPU if this is false
+         * @note This avoids synchronizing GPU-resident textures with the guest for copies that would otherwise be swizzled on the CPU
+         */
+        bool CopyBlockLinear(IOVA pitchAddress, u32 pitch, const BlockLinearSurface &surface, u32 bytesPerPixel, u32 width, u32 height, bool toSurface);
     };
 }
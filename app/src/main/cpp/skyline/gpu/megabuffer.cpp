@@ -1,6 +1,8 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <common/settings.h>
+#include <common/perf_stats.h>
 #include <gpu.h>
 #include "megabuffer.h"
 
@@ -47,9 +49,73 @@ namespace skyline::gpu {
         return {static_cast<vk::DeviceSize>(resultSpan.data() - backing.data()), resultSpan};
     }
 
-    MegaBufferAllocator::MegaBufferAllocator(GPU &gpu) : gpu{gpu}, activeChunk{chunks.emplace(chunks.end(), gpu)} {}
+    MegaBufferRing::MegaBufferRing(GPU &gpu, vk::DeviceSize size) : backing{gpu.memory.AllocateBuffer(size)}, head{PAGE_SIZE} {}
+
+    vk::Buffer MegaBufferRing::GetBacking() const {
+        return backing.vkBuffer;
+    }
+
+    bool MegaBufferRing::Reclaim() {
+        bool reclaimed{};
+        while (!regions.empty() && regions.front().cycle->Poll(false)) {
+            regions.pop_front();
+            reclaimed = true;
+        }
+
+        if (regions.empty())
+            head = PAGE_SIZE; // Restart from the beginning of the ring to avoid needlessly wrapping around on the next allocation
+
+        return reclaimed;
+    }
+
+    std::pair<vk::DeviceSize, span<u8>> MegaBufferRing::Allocate(const std::shared_ptr<FenceCycle> &cycle, vk::DeviceSize size, bool pageAlign) {
+        // The first page is never allocated so that an offset of 0 can signify a failed allocation, the same as with chunks
+        if (size == 0)
+            return {head, {}}; // Empty allocations don't use any space in the ring and are only used for dummy bindings of the backing
+
+        auto findSpace{[&]() -> std::optional<vk::DeviceSize> {
+            vk::DeviceSize offset{pageAlign ? util::AlignUp(head, PAGE_SIZE) : head};
+            if (regions.empty() || regions.back().end > regions.front().begin) {
+                // The used space doesn't wrap around, so there's free space after the newest region and before the oldest region
+                if (offset + size <= backing.size())
+                    return offset;
+
+                vk::DeviceSize tail{regions.empty() ? backing.size() : regions.front().begin};
+                if (PAGE_SIZE + size <= tail)
+                    return PAGE_SIZE;
+            } else if (offset + size <= regions.front().begin) {
+                return offset; // The used space wraps around, so the only free space is between the newest region and the oldest region
+            }
+            return std::nullopt;
+        }};
+
+        auto offset{findSpace()};
+        if (!offset && Reclaim())
+            offset = findSpace();
+        if (!offset)
+            return {0, {}};
+
+        if (!regions.empty() && regions.back().cycle == cycle && regions.back().end == *offset)
+            regions.back().end = *offset + size;
+        else
+            regions.push_back({cycle, *offset, *offset + size});
+
+        head = *offset + size;
+        return {*offset, backing.subspan(*offset, size)};
+    }
+
+    MegaBufferAllocator::MegaBufferAllocator(GPU &gpu) : gpu{gpu}, activeChunk{chunks.emplace(chunks.end(), gpu)} {
+        if (u32 ringSizeMib{*gpu.state.settings->megaBufferRingSize})
+            ring.emplace(gpu, static_cast<vk::DeviceSize>(ringSizeMib) << 20);
+    }
 
     MegaBufferAllocator::Allocation MegaBufferAllocator::Allocate(const std::shared_ptr<FenceCycle> &cycle, vk::DeviceSize size, bool pageAlign) {
+        PerfStats::Increment(PerfStats::Counter::MegaBufferBytes, size);
+        std::scoped_lock lock{mutex};
+        if (ring)
+            if (auto allocation{ring->Allocate(cycle, size, pageAlign)}; allocation.first)
+                return {ring->GetBacking(), allocation.first, allocation.second};
+
         if (auto allocation{activeChunk->Allocate(cycle, size, pageAlign)}; allocation.first)
             return {activeChunk->GetBacking(), allocation.first, allocation.second};
 
@@ -63,6 +129,20 @@ namespace skyline::gpu {
             throw exception("Failed to to allocate megabuffer space for size: 0x{:X}", size);
     }
 
+    vk::DeviceSize MegaBufferAllocator::Trim() {
+        std::list<MegaBufferChunk> idleChunks;
+        {
+            std::scoped_lock lock{mutex};
+            for (auto it{chunks.begin()}; it != chunks.end();) {
+                auto next{std::next(it)};
+                if (it != activeChunk && it->TryReset())
+                    idleChunks.splice(idleChunks.end(), chunks, it);
+                it = next;
+            }
+        }
+        return idleChunks.size() * MegaBufferChunkSize;
+    } // The idle chunks are destroyed here without the allocator lock held
+
     MegaBufferAllocator::Allocation MegaBufferAllocator::Push(const std::shared_ptr<FenceCycle> &cycle, span<u8> data, bool pageAlign) {
         auto allocation{Allocate(cycle, data.size(), pageAlign)};
         allocation.region.copy_from(data);
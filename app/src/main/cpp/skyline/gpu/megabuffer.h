@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <deque>
+#include <common/spin_lock.h>
 #include "memory_manager.h"
 
 namespace skyline::gpu {
@@ -33,6 +35,43 @@ namespace skyline::gpu {
         std::pair<vk::DeviceSize, span<u8>> Allocate(const std::shared_ptr<FenceCycle> &newCycle, vk::DeviceSize size, bool pageAlign = false);
     };
 
+    /**
+     * @brief A persistently mapped GPU-side ring buffer which allocations are linearly streamed into, the space used by an allocation is reclaimed once the cycle it was made in is signalled
+     * @note Fences are only polled when the ring has run out of space and they are never waited on, allocations which can't be satisfied are left to the caller to fall back on
+     * @note This class is **not** thread-safe and any calls must be externally synchronized
+     */
+    class MegaBufferRing {
+      private:
+        /**
+         * @brief A contiguous region of the ring which has allocations by a single cycle in it
+         */
+        struct Region {
+            std::shared_ptr<FenceCycle> cycle;
+            vk::DeviceSize begin;
+            vk::DeviceSize end;
+        };
+
+        memory::Buffer backing; //!< The GPU buffer as the backing storage for the ring
+        std::deque<Region> regions; //!< All regions which might still be in use by the GPU ordered from the oldest to the newest, the free space in the ring is between the end of the newest and the beginning of the oldest region
+        vk::DeviceSize head; //!< The offset of the next allocation in the ring
+
+        /**
+         * @brief Frees the oldest regions which have had their cycles signalled
+         * @return If any regions were freed
+         */
+        bool Reclaim();
+
+      public:
+        MegaBufferRing(GPU &gpu, vk::DeviceSize size);
+
+        vk::Buffer GetBacking() const;
+
+        /**
+         * @return The offset and the CPU mapping of the allocation, the offset will be 0 if there isn't enough space in the ring
+         */
+        std::pair<vk::DeviceSize, span<u8>> Allocate(const std::shared_ptr<FenceCycle> &cycle, vk::DeviceSize size, bool pageAlign = false);
+    };
+
     /**
      * @brief Allocator for megabuffer chunks that takes the usage of resources on the GPU into account
      * @note This class is not thread-safe and any calls must be externally synchronized
@@ -40,8 +79,10 @@ namespace skyline::gpu {
     class MegaBufferAllocator {
       private:
         GPU &gpu;
+        SpinLock mutex; //!< Synchronizes allocations from the ring and the chunks, allocations are short so this is a spin lock
         std::list<MegaBufferChunk> chunks; //!< A pool of all allocated megabuffer chunks, these are dynamically utilized
         decltype(chunks)::iterator activeChunk; //!< Currently active chunk of the megabuffer which is being allocated into
+        std::optional<MegaBufferRing> ring; //!< An optional ring buffer which allocations are preferentially made in, this avoids walking the chunks and polling their cycles on every chunk switch; the chunks are only used for allocations that don't fit in the ring
 
       public:
         /**
@@ -62,15 +103,22 @@ namespace skyline::gpu {
         /**
           * @brief Allocates data in a megabuffer chunk and returns an structure describing the allocation
           * @param pageAlign Whether the pushed data should be page aligned in the megabuffer
-          * @note The allocator *MUST* be locked before calling this function
+          * @note The allocator is locked internally, this can be called from any thread
           */
         Allocation Allocate(const std::shared_ptr<FenceCycle> &cycle, vk::DeviceSize size, bool pageAlign = false);
 
         /**
          * @brief Pushes data to a megabuffer chunk and returns an structure describing the allocation
          * @param pageAlign Whether the pushed data should be page aligned in the megabuffer
-         * @note The allocator *MUST* be locked before calling this function
+         * @note The allocator is locked internally, copying the data is done without the lock held
          */
         Allocation Push(const std::shared_ptr<FenceCycle> &cycle, span<u8> data, bool pageAlign = false);
+
+        /**
+         * @brief Frees all chunks other than the active one which aren't in use by the GPU, the ring is retained as it's of a fixed size
+         * @return The amount of bytes that were freed
+         * @note The allocator is locked internally, this can be called from any thread
+         */
+        vk::DeviceSize Trim();
     };
 }
@@ -1,10 +1,14 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <common/perf_stats.h>
+#include <common/trace.h>
 #include <gpu.h>
 #include "memory_manager.h"
 
 namespace skyline::gpu::memory {
+    constexpr vk::BufferUsageFlags GuestBufferUsage{vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eUniformTexelBuffer | vk::BufferUsageFlagBits::eStorageTexelBuffer | vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransformFeedbackBufferEXT}; //!< The usage flags of buffers which can back any guest buffer
+
     /**
      * @brief If the result isn't VK_SUCCESS then an exception is thrown
      */
@@ -22,7 +26,10 @@ namespace skyline::gpu::memory {
         if (vmaAllocator && vmaAllocation && vkImage) {
             if (pointer)
                 vmaUnmapMemory(vmaAllocator, vmaAllocation);
-            vmaDestroyImage(vmaAllocator, vkImage, vmaAllocation);
+            if (manager)
+                manager->DestroyImage(vkImage, vmaAllocation);
+            else
+                vmaDestroyImage(vmaAllocator, vkImage, vmaAllocation);
         }
     }
 
@@ -33,7 +40,28 @@ namespace skyline::gpu::memory {
         return pointer;
     }
 
-    MemoryManager::MemoryManager(const GPU &pGpu) : gpu(pGpu) {
+    /**
+     * @return The allocation create info for staging buffers, this is shared with the lookup of the memory type for the staging pool
+     */
+    static VmaAllocationCreateInfo GetStagingAllocationCreateInfo() {
+        return VmaAllocationCreateInfo{
+            .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT,
+            .usage = VMA_MEMORY_USAGE_CPU_ONLY,
+        };
+    }
+
+    /**
+     * @return The allocation create info for guest buffers, this is shared with the lookup of the memory type for the buffer pool
+     */
+    static VmaAllocationCreateInfo GetBufferAllocationCreateInfo() {
+        return VmaAllocationCreateInfo{
+            .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT,
+            .usage = VMA_MEMORY_USAGE_UNKNOWN,
+            .requiredFlags = static_cast<VkMemoryPropertyFlags>(vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent | vk::MemoryPropertyFlagBits::eDeviceLocal),
+        };
+    }
+
+    MemoryManager::MemoryManager(GPU &pGpu) : gpu(pGpu) {
         auto instanceDispatcher{gpu.vkInstance.getDispatcher()};
         auto deviceDispatcher{gpu.vkDevice.getDispatcher()};
         VmaVulkanFunctions vulkanFunctions{
@@ -68,23 +96,162 @@ namespace skyline::gpu::memory {
             .vulkanApiVersion = VkApiVersion,
         };
         ThrowOnFail(vmaCreateAllocator(&allocatorCreateInfo, &vmaAllocator));
+
+        // The memory type of each pool is found with a representative resource of its class, any resources that aren't compatible with it are allocated from the default pools instead
+        auto createPool{[&](ResourceClass resourceClass, VkResult result, u32 memoryTypeIndex) {
+            if (result != VK_SUCCESS) {
+                Logger::Warn("Cannot find a memory type for the pool of resource class {}, the default pools will be used", static_cast<u32>(resourceClass));
+                return;
+            }
+
+            VmaPoolCreateInfo poolCreateInfo{
+                .memoryTypeIndex = memoryTypeIndex,
+            };
+            ThrowOnFail(vmaCreatePool(vmaAllocator, &poolCreateInfo, &pools[static_cast<size_t>(resourceClass)]));
+        }};
+
+        u32 memoryTypeIndex{};
+        VmaAllocationCreateInfo imageAllocationCreateInfo{
+            .usage = VMA_MEMORY_USAGE_GPU_ONLY,
+        };
+        vk::ImageCreateInfo imageCreateInfo{
+            .imageType = vk::ImageType::e2D,
+            .format = vk::Format::eR8G8B8A8Unorm,
+            .extent = {1, 1, 1},
+            .mipLevels = 1,
+            .arrayLayers = 1,
+            .samples = vk::SampleCountFlagBits::e1,
+            .tiling = vk::ImageTiling::eOptimal,
+            .usage = vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eColorAttachment,
+            .sharingMode = vk::SharingMode::eExclusive,
+            .initialLayout = vk::ImageLayout::eUndefined,
+        };
+        createPool(ResourceClass::RenderTarget, vmaFindMemoryTypeIndexForImageInfo(vmaAllocator, &static_cast<const VkImageCreateInfo &>(imageCreateInfo), &imageAllocationCreateInfo, &memoryTypeIndex), memoryTypeIndex);
+
+        imageCreateInfo.usage = vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled;
+        createPool(ResourceClass::SampledTexture, vmaFindMemoryTypeIndexForImageInfo(vmaAllocator, &static_cast<const VkImageCreateInfo &>(imageCreateInfo), &imageAllocationCreateInfo, &memoryTypeIndex), memoryTypeIndex);
+
+        vk::BufferCreateInfo bufferCreateInfo{
+            .size = PAGE_SIZE,
+            .usage = GuestBufferUsage,
+            .sharingMode = vk::SharingMode::eExclusive,
+        };
+        auto bufferAllocationCreateInfo{GetBufferAllocationCreateInfo()};
+        createPool(ResourceClass::Buffer, vmaFindMemoryTypeIndexForBufferInfo(vmaAllocator, &static_cast<const VkBufferCreateInfo &>(bufferCreateInfo), &bufferAllocationCreateInfo, &memoryTypeIndex), memoryTypeIndex);
+
+        bufferCreateInfo.usage = vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eStorageBuffer;
+        auto stagingAllocationCreateInfo{GetStagingAllocationCreateInfo()};
+        createPool(ResourceClass::Staging, vmaFindMemoryTypeIndexForBufferInfo(vmaAllocator, &static_cast<const VkBufferCreateInfo &>(bufferCreateInfo), &stagingAllocationCreateInfo, &memoryTypeIndex), memoryTypeIndex);
     }
 
     MemoryManager::~MemoryManager() {
+        for (auto &freeBuffers : stagingPool)
+            freeBuffers.clear();
+        if (defragmentation)
+            vmaEndDefragmentation(vmaAllocator, defragmentation, nullptr);
+        for (auto pool : pools)
+            if (pool)
+                vmaDestroyPool(vmaAllocator, pool);
         vmaDestroyAllocator(vmaAllocator);
     }
 
+    /**
+     * @brief Creates a buffer from the supplied pool, the default pools are used if there's no pool or the buffer isn't compatible with its memory type
+     */
+    static void CreatePooledBuffer(VmaAllocator allocator, VmaPool pool, const vk::BufferCreateInfo &bufferCreateInfo, VmaAllocationCreateInfo &allocationCreateInfo, VkBuffer &buffer, VmaAllocation &allocation, VmaAllocationInfo &allocationInfo) {
+        allocationCreateInfo.pool = pool;
+        if (pool && vmaCreateBuffer(allocator, &static_cast<const VkBufferCreateInfo &>(bufferCreateInfo), &allocationCreateInfo, &buffer, &allocation, &allocationInfo) == VK_SUCCESS)
+            return;
+
+        allocationCreateInfo.pool = VK_NULL_HANDLE;
+        ThrowOnFail(vmaCreateBuffer(allocator, &static_cast<const VkBufferCreateInfo &>(bufferCreateInfo), &allocationCreateInfo, &buffer, &allocation, &allocationInfo));
+    }
+
+    std::unique_ptr<StagingBuffer> MemoryManager::CreateStagingBuffer(vk::DeviceSize size) {
+        vk::BufferCreateInfo bufferCreateInfo{
+            .size = size,
+            .usage = vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eStorageBuffer, // Storage buffer usage is required for deswizzling textures on the GPU
+            .sharingMode = vk::SharingMode::eExclusive,
+            .queueFamilyIndexCount = 1,
+            .pQueueFamilyIndices = &gpu.vkQueueFamilyIndex,
+        };
+        auto allocationCreateInfo{GetStagingAllocationCreateInfo()};
+
+        VkBuffer buffer;
+        VmaAllocation allocation;
+        VmaAllocationInfo allocationInfo;
+        CreatePooledBuffer(vmaAllocator, GetPool(ResourceClass::Staging), bufferCreateInfo, allocationCreateInfo, buffer, allocation, allocationInfo);
+
+        PerfStats::Increment(PerfStats::Counter::StagingBufferAllocations);
+        return std::make_unique<memory::StagingBuffer>(reinterpret_cast<u8 *>(allocationInfo.pMappedData), size, vmaAllocator, buffer, allocation);
+    }
+
+    void MemoryManager::RecycleStagingBuffer(StagingBuffer *buffer) {
+        std::unique_ptr<StagingBuffer> ownedBuffer{buffer};
+        auto sizeClass{static_cast<size_t>(std::countr_zero(buffer->capacity / StagingPoolMinSize))};
+
+        std::scoped_lock lock{stagingPoolMutex};
+        if (stagingPoolCachedSize + buffer->capacity > StagingPoolMaxCachedSize)
+            return; // The buffer is destroyed here as the pool is full
+
+        stagingPoolCachedSize += buffer->capacity;
+        stagingPool[sizeClass].push_back(std::move(ownedBuffer));
+    }
+
+    vk::DeviceSize MemoryManager::TrimStagingPool() {
+        decltype(stagingPool) idleBuffers;
+        vk::DeviceSize freedSize;
+        {
+            std::scoped_lock lock{stagingPoolMutex};
+            idleBuffers = std::move(stagingPool);
+            stagingPool = {};
+            freedSize = std::exchange(stagingPoolCachedSize, 0);
+        }
+        return freedSize;
+    } // The idle buffers are destroyed here without the pool mutex held
+
     std::shared_ptr<StagingBuffer> MemoryManager::AllocateStagingBuffer(vk::DeviceSize size) {
+        if (size > (StagingPoolMinSize << (StagingPoolClassCount - 1)))
+            return CreateStagingBuffer(size); // Large buffers are rare enough that pooling them would waste more memory than it'd save in allocations
+
+        // The size classes are powers of two, the smallest one that can fit the requested size is used
+        auto sizeClass{size <= StagingPoolMinSize ? size_t{} : static_cast<size_t>(std::bit_width((size - 1) / StagingPoolMinSize))};
+        std::unique_ptr<StagingBuffer> buffer;
+        {
+            std::scoped_lock lock{stagingPoolMutex};
+            auto &freeBuffers{stagingPool[sizeClass]};
+            if (!freeBuffers.empty()) {
+                buffer = std::move(freeBuffers.back());
+                freeBuffers.pop_back();
+                stagingPoolCachedSize -= buffer->capacity;
+            }
+        }
+
+        if (buffer)
+            PerfStats::Increment(PerfStats::Counter::StagingBufferReuses);
+        else
+            buffer = CreateStagingBuffer(StagingPoolMinSize << sizeClass);
+
+        // The span only covers the requested size so that it can be used in the same way as an exactly sized buffer
+        static_cast<span<u8> &>(*buffer) = span<u8>{buffer->data(), static_cast<size_t>(size)};
+        return std::shared_ptr<StagingBuffer>{buffer.release(), [this](StagingBuffer *buffer) {
+            RecycleStagingBuffer(buffer);
+        }};
+    }
+
+    std::shared_ptr<StagingBuffer> MemoryManager::AllocateReadbackBuffer(vk::DeviceSize size) {
         vk::BufferCreateInfo bufferCreateInfo{
             .size = size,
-            .usage = vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst,
+            .usage = vk::BufferUsageFlagBits::eTransferDst,
             .sharingMode = vk::SharingMode::eExclusive,
             .queueFamilyIndexCount = 1,
             .pQueueFamilyIndices = &gpu.vkQueueFamilyIndex,
         };
         VmaAllocationCreateInfo allocationCreateInfo{
             .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT,
-            .usage = VMA_MEMORY_USAGE_CPU_ONLY,
+            .usage = VMA_MEMORY_USAGE_GPU_TO_CPU,
+            .requiredFlags = static_cast<VkMemoryPropertyFlags>(vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent), // Coherency avoids needing to invalidate the allocation before every read
+            .preferredFlags = static_cast<VkMemoryPropertyFlags>(vk::MemoryPropertyFlagBits::eHostCached),
         };
 
         VkBuffer buffer;
@@ -98,36 +265,125 @@ namespace skyline::gpu::memory {
     Buffer MemoryManager::AllocateBuffer(vk::DeviceSize size) {
         vk::BufferCreateInfo bufferCreateInfo{
             .size = size,
-            .usage = vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eUniformTexelBuffer | vk::BufferUsageFlagBits::eStorageTexelBuffer | vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransformFeedbackBufferEXT,
+            .usage = GuestBufferUsage,
             .sharingMode = vk::SharingMode::eExclusive,
             .queueFamilyIndexCount = 1,
             .pQueueFamilyIndices = &gpu.vkQueueFamilyIndex,
         };
-        VmaAllocationCreateInfo allocationCreateInfo{
-            .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT,
-            .usage = VMA_MEMORY_USAGE_UNKNOWN,
-            .requiredFlags = static_cast<VkMemoryPropertyFlags>(vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent | vk::MemoryPropertyFlagBits::eDeviceLocal),
-        };
+        auto allocationCreateInfo{GetBufferAllocationCreateInfo()};
 
         VkBuffer buffer;
         VmaAllocation allocation;
         VmaAllocationInfo allocationInfo;
-        ThrowOnFail(vmaCreateBuffer(vmaAllocator, &static_cast<const VkBufferCreateInfo &>(bufferCreateInfo), &allocationCreateInfo, &buffer, &allocation, &allocationInfo));
+        CreatePooledBuffer(vmaAllocator, GetPool(ResourceClass::Buffer), bufferCreateInfo, allocationCreateInfo, buffer, allocation, allocationInfo);
 
         return Buffer(reinterpret_cast<u8 *>(allocationInfo.pMappedData), size, vmaAllocator, buffer, allocation);
     }
 
-    Image MemoryManager::AllocateImage(const vk::ImageCreateInfo &createInfo) {
+    std::optional<Buffer> MemoryManager::ImportBuffer(span<u8> hostMemory) {
+        auto alignment{gpu.traits.minImportedHostPointerAlignment};
+        if (!gpu.traits.supportsExternalMemoryHost || hostImportFailed.load(std::memory_order_relaxed) || !util::IsAligned(hostMemory.data(), alignment) || !util::IsAligned(hostMemory.size(), alignment))
+            return std::nullopt;
+
+        try {
+            constexpr auto HandleType{vk::ExternalMemoryHandleTypeFlagBits::eHostAllocationEXT};
+            vk::StructureChain<vk::BufferCreateInfo, vk::ExternalMemoryBufferCreateInfo> bufferCreateInfo{
+                vk::BufferCreateInfo{
+                    .size = hostMemory.size(),
+                    .usage = GuestBufferUsage,
+                    .sharingMode = vk::SharingMode::eExclusive,
+                    .queueFamilyIndexCount = 1,
+                    .pQueueFamilyIndices = &gpu.vkQueueFamilyIndex,
+                },
+                vk::ExternalMemoryBufferCreateInfo{
+                    .handleTypes = HandleType,
+                },
+            };
+            vk::raii::Buffer buffer{gpu.vkDevice, bufferCreateInfo.get<vk::BufferCreateInfo>()};
+
+            auto memoryTypeBits{buffer.getMemoryRequirements().memoryTypeBits & gpu.vkDevice.getMemoryHostPointerPropertiesEXT(HandleType, hostMemory.data()).memoryTypeBits};
+
+            // The memory must be host-coherent as the guest accesses it directly without any explicit flushes or invalidations, device-local memory is preferred when there's a choice
+            const VkPhysicalDeviceMemoryProperties *memoryProperties;
+            vmaGetMemoryProperties(vmaAllocator, &memoryProperties);
+
+            constexpr VkMemoryPropertyFlags RequiredFlags{VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT};
+            std::optional<u32> memoryTypeIndex;
+            for (u32 index{}; index < memoryProperties->memoryTypeCount; index++) {
+                auto flags{memoryProperties->memoryTypes[index].propertyFlags};
+                if (!(memoryTypeBits & (1U << index)) || (flags & RequiredFlags) != RequiredFlags)
+                    continue;
+
+                if (!memoryTypeIndex || flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+                    memoryTypeIndex = index;
+                if (flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+                    break;
+            }
+
+            if (!memoryTypeIndex) {
+                Logger::Warn("Host memory can't be imported into a host-coherent memory type (Memory types: 0x{:X})", memoryTypeBits);
+                hostImportFailed = true;
+                return std::nullopt;
+            }
+
+            vk::StructureChain<vk::MemoryAllocateInfo, vk::ImportMemoryHostPointerInfoEXT> allocateInfo{
+                vk::MemoryAllocateInfo{
+                    .allocationSize = hostMemory.size(),
+                    .memoryTypeIndex = *memoryTypeIndex,
+                },
+                vk::ImportMemoryHostPointerInfoEXT{
+                    .handleType = HandleType,
+                    .pHostPointer = hostMemory.data(),
+                },
+            };
+            vk::raii::DeviceMemory memory{gpu.vkDevice, allocateInfo.get<vk::MemoryAllocateInfo>()};
+            buffer.bindMemory(*memory, 0);
+
+            return Buffer{hostMemory, std::make_unique<Buffer::ImportedMemory>(Buffer::ImportedMemory{std::move(memory), std::move(buffer)})};
+        } catch (const vk::SystemError &e) {
+            Logger::Warn("Failed to import host memory as a buffer, buffers will be allocated instead: {}", e.what());
+            hostImportFailed = true;
+            return std::nullopt;
+        }
+    }
+
+    Image MemoryManager::AllocateImage(const vk::ImageCreateInfo &createInfo, ImageOwner *owner, ResourceClass resourceClass) {
         VmaAllocationCreateInfo allocationCreateInfo{
             .usage = VMA_MEMORY_USAGE_GPU_ONLY,
+            .pool = owner ? GetPool(resourceClass) : VK_NULL_HANDLE,
         };
 
         VkImage image;
         VmaAllocation allocation;
         VmaAllocationInfo allocationInfo;
-        ThrowOnFail(vmaCreateImage(vmaAllocator, &static_cast<const VkImageCreateInfo &>(createInfo), &allocationCreateInfo, &image, &allocation, &allocationInfo));
+        if (!allocationCreateInfo.pool || vmaCreateImage(vmaAllocator, &static_cast<const VkImageCreateInfo &>(createInfo), &allocationCreateInfo, &image, &allocation, &allocationInfo) != VK_SUCCESS) {
+            // Images that aren't compatible with the memory type of their pool are allocated from the default pools, they aren't moved by defragmentation
+            allocationCreateInfo.pool = VK_NULL_HANDLE;
+            ThrowOnFail(vmaCreateImage(vmaAllocator, &static_cast<const VkImageCreateInfo &>(createInfo), &allocationCreateInfo, &image, &allocation, &allocationInfo));
+            return Image(vmaAllocator, image, allocation);
+        }
 
-        return Image(vmaAllocator, image, allocation);
+        std::scoped_lock lock{imageOwnerMutex};
+        imageOwners.emplace(allocation, owner);
+        return Image(vmaAllocator, image, allocation, this);
+    }
+
+    void MemoryManager::ReleaseImageOwner(ImageOwner *owner) {
+        std::scoped_lock lock{imageOwnerMutex};
+        std::erase_if(imageOwners, [owner](const auto &entry) { return entry.second == owner; });
+    }
+
+    void MemoryManager::DestroyImage(vk::Image image, VmaAllocation allocation) {
+        {
+            std::scoped_lock lock{imageOwnerMutex};
+            imageOwners.erase(allocation);
+            if (passAllocations.contains(allocation)) {
+                deferredImages.emplace_back(image, allocation);
+                return;
+            }
+        }
+
+        vmaDestroyImage(vmaAllocator, image, allocation);
     }
 
     Image MemoryManager::AllocateMappedImage(const vk::ImageCreateInfo &createInfo) {
@@ -143,4 +399,138 @@ namespace skyline::gpu::memory {
 
         return Image(vmaAllocator, image, allocation);
     }
+
+    vk::DeviceSize MemoryManager::GetDeviceLocalBudget() {
+        const VkPhysicalDeviceMemoryProperties *memoryProperties;
+        vmaGetMemoryProperties(vmaAllocator, &memoryProperties);
+
+        std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> budgets{};
+        vmaGetHeapBudgets(vmaAllocator, budgets.data());
+
+        vk::DeviceSize budget{};
+        for (u32 heap{}; heap < memoryProperties->memoryHeapCount; heap++)
+            if (memoryProperties->memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+                budget += budgets[heap].budget;
+        return budget;
+    }
+
+    void MemoryManager::Defragment() {
+        std::unique_lock lock{defragmentationMutex, std::try_to_lock};
+        if (!lock)
+            return; // Another GPFIFO is already defragmenting
+
+        if (!defragmentation) {
+            // Only the texture pools are defragmented as textures can replace their images, buffers are referred to by their CPU mappings so they can't be moved
+            constexpr std::array<ResourceClass, 2> DefragmentedClasses{ResourceClass::RenderTarget, ResourceClass::SampledTexture};
+            for (size_t i{}; i < DefragmentedClasses.size() && !defragmentation; i++) {
+                auto pool{GetPool(DefragmentedClasses[defragmentationClass])};
+                defragmentationClass = (defragmentationClass + 1) % DefragmentedClasses.size();
+                if (!pool)
+                    continue;
+
+                // Compacting a pool can only free memory if its allocations are spread over several blocks
+                VmaStatistics statistics;
+                vmaGetPoolStatistics(vmaAllocator, pool, &statistics);
+                if (statistics.blockCount < 2 || static_cast<float>(statistics.blockBytes - statistics.allocationBytes) < static_cast<float>(statistics.blockBytes) * DefragmentationThreshold)
+                    continue;
+
+                VmaDefragmentationInfo defragmentationInfo{
+                    .flags = VMA_DEFRAGMENTATION_FLAG_ALGORITHM_BALANCED_BIT,
+                    .pool = pool,
+                    .maxBytesPerPass = DefragmentationMaxBytesPerPass,
+                    .maxAllocationsPerPass = DefragmentationMaxAllocationsPerPass,
+                };
+                ThrowOnFail(vmaBeginDefragmentation(vmaAllocator, &defragmentationInfo, &defragmentation));
+            }
+
+            if (!defragmentation)
+                return;
+        }
+
+        TRACE_EVENT("gpu", "MemoryManager::Defragment");
+
+        VmaDefragmentationPassMoveInfo pass{};
+        std::vector<std::shared_ptr<void>> moves;
+        vk::DeviceSize movedBytes{};
+        std::shared_ptr<FenceCycle> cycle;
+        {
+            // The owner lock is held while the moves are resolved so that none of the owners can be destroyed and none of the allocations can be freed behind our back
+            std::unique_lock ownerLock{imageOwnerMutex};
+            if (vmaBeginDefragmentationPass(vmaAllocator, defragmentation, &pass) == VK_SUCCESS) {
+                ownerLock.unlock();
+                vmaEndDefragmentation(vmaAllocator, std::exchange(defragmentation, nullptr), nullptr);
+                return; // The pool can't be compacted any further
+            }
+
+            span<VmaDefragmentationMove> passMoves{pass.pMoves, pass.moveCount};
+            for (const auto &move : passMoves)
+                passAllocations.insert(move.srcAllocation);
+
+            cycle = gpu.scheduler.SubmitTransfer([&](vk::raii::CommandBuffer &commandBuffer) {
+                for (auto &move : passMoves) {
+                    auto owner{imageOwners.find(move.srcAllocation)};
+                    std::shared_ptr<void> moved;
+                    if (owner != imageOwners.end()) {
+                        try {
+                            moved = owner->second->MoveImage(move.srcAllocation, commandBuffer, [&](const vk::ImageCreateInfo &createInfo) {
+                                vk::raii::Image image{gpu.vkDevice, createInfo};
+                                ThrowOnFail(vmaBindImageMemory(vmaAllocator, move.dstTmpAllocation, *image));
+                                return image.release();
+                            });
+                        } catch (const vk::SystemError &e) {
+                            Logger::Warn("Failed to move image for defragmentation: {}", e.what());
+                        }
+                    }
+
+                    if (moved) {
+                        VmaAllocationInfo allocationInfo;
+                        vmaGetAllocationInfo(vmaAllocator, move.srcAllocation, &allocationInfo);
+                        movedBytes += allocationInfo.size;
+                        moves.emplace_back(std::move(moved));
+                    } else {
+                        move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+                    }
+                }
+
+                // Submission can block on the cycle waiter thread which may be destroying images, the lock must not be held while doing so
+                ownerLock.unlock();
+            });
+        }
+
+        // The prior images are destroyed and their owners are unlocked once the copies have completed, the allocations are swapped by VMA at the end of the pass
+        cycle->Wait();
+        size_t moveCount{moves.size()};
+        moves.clear();
+
+        VkResult result;
+        decltype(deferredImages) destroyedImages;
+        {
+            std::scoped_lock ownerLock{imageOwnerMutex};
+            result = vmaEndDefragmentationPass(vmaAllocator, defragmentation, &pass);
+            passAllocations.clear();
+            destroyedImages = std::exchange(deferredImages, {});
+        }
+
+        for (const auto &[image, allocation] : destroyedImages)
+            vmaDestroyImage(vmaAllocator, image, allocation);
+
+        if (result == VK_SUCCESS)
+            vmaEndDefragmentation(vmaAllocator, std::exchange(defragmentation, nullptr), nullptr);
+
+        PerfStats::Increment(PerfStats::Counter::DefragmentationMoves, moveCount);
+        PerfStats::Increment(PerfStats::Counter::DefragmentationBytes, movedBytes);
+    }
+
+    std::array<MemoryManager::PoolStatistics, ResourceClassCount> MemoryManager::GetPoolStatistics() {
+        std::array<PoolStatistics, ResourceClassCount> poolStatistics{};
+        for (size_t i{}; i < ResourceClassCount; i++) {
+            if (!pools[i])
+                continue;
+
+            VmaStatistics statistics;
+            vmaGetPoolStatistics(vmaAllocator, pools[i], &statistics);
+            poolStatistics[i] = {statistics.blockBytes, statistics.allocationBytes};
+        }
+        return poolStatistics;
+    }
 }
@@ -3,18 +3,61 @@
 
 #pragma once
 
+#include <unordered_set>
 #include <vk_mem_alloc.h>
 #include "fence_cycle.h"
 
 namespace skyline::gpu::memory {
+    class MemoryManager;
+
+    /**
+     * @brief The classes of resources which are allocated from their own VMA pools, this keeps resources with different lifetimes from fragmenting each other's memory
+     */
+    enum class ResourceClass : u8 {
+        RenderTarget, //!< Textures which are rendered to, these are usually long-lived
+        SampledTexture, //!< Textures which are only uploaded from the CPU and sampled, these are frequently created and destroyed
+        Buffer, //!< Guest buffers and megabuffers
+        Staging, //!< Staging buffers for uploads
+
+        Count, //!< The amount of resource classes, this isn't a class itself
+    };
+
+    constexpr size_t ResourceClassCount{static_cast<size_t>(ResourceClass::Count)};
+
+    /**
+     * @brief An interface for the owners of images which can be moved into another allocation by defragmentation
+     */
+    class ImageOwner {
+      protected:
+        ~ImageOwner() = default;
+
+      public:
+        /**
+         * @brief Moves the contents of the owned image into a new image, this is only done if the allocation is still that of the owned image and the image isn't in use
+         * @param allocation The allocation of the image which is being moved
+         * @param createImage Creates an image with the supplied create info that's bound to the destination of the move, the owned image must be replaced with it
+         * @return An object which keeps the owner locked and the prior image alive, it must be held until the recorded copy has completed, this is null if the image wasn't moved
+         */
+        virtual std::shared_ptr<void> MoveImage(VmaAllocation allocation, const vk::raii::CommandBuffer &commandBuffer, const std::function<vk::Image(const vk::ImageCreateInfo &)> &createImage) = 0;
+    };
+
     /**
      * @brief A view into a CPU mapping of a Vulkan buffer
      * @note The mapping **should not** be used after the lifetime of the object has ended
      */
     struct Buffer : public span<u8> {
+        /**
+         * @brief Host memory that has been imported as device memory alongside the buffer bound to it, the host memory itself is owned by the creator of the buffer
+         */
+        struct ImportedMemory {
+            vk::raii::DeviceMemory memory;
+            vk::raii::Buffer buffer; //!< This is declared after the memory so that it's destroyed prior to the memory being freed
+        };
+
         VmaAllocator vmaAllocator;
         VmaAllocation vmaAllocation;
         vk::Buffer vkBuffer;
+        std::unique_ptr<ImportedMemory> importedMemory; //!< The imported memory backing this buffer, this is only set for buffers which aren't allocated with VMA
 
         constexpr Buffer(u8 *pointer, size_t size, VmaAllocator vmaAllocator, vk::Buffer vkBuffer, VmaAllocation vmaAllocation)
             : vmaAllocator(vmaAllocator),
@@ -22,17 +65,35 @@ namespace skyline::gpu::memory {
               vmaAllocation(vmaAllocation),
               span(pointer, size) {}
 
+        Buffer(span<u8> hostMemory, std::unique_ptr<ImportedMemory> pImportedMemory)
+            : vmaAllocator(nullptr),
+              vmaAllocation(nullptr),
+              vkBuffer(*pImportedMemory->buffer),
+              importedMemory(std::move(pImportedMemory)),
+              span(hostMemory) {}
+
         Buffer(const Buffer &) = delete;
 
         constexpr Buffer(Buffer &&other)
             : vmaAllocator(std::exchange(other.vmaAllocator, nullptr)),
               vmaAllocation(std::exchange(other.vmaAllocation, nullptr)),
               vkBuffer(std::exchange(other.vkBuffer, {})),
+              importedMemory(std::move(other.importedMemory)),
               span(other) {}
 
         Buffer &operator=(const Buffer &) = delete;
 
-        Buffer &operator=(Buffer &&) = default;
+        /**
+         * @note The allocations are swapped so that the previous allocation of this buffer is freed alongside the moved-from buffer
+         */
+        constexpr Buffer &operator=(Buffer &&other) {
+            std::swap(vmaAllocator, other.vmaAllocator);
+            std::swap(vmaAllocation, other.vmaAllocation);
+            std::swap(vkBuffer, other.vkBuffer);
+            std::swap(importedMemory, other.importedMemory);
+            std::swap(static_cast<span<u8> &>(*this), static_cast<span<u8> &>(other));
+            return *this;
+        }
 
         ~Buffer();
     };
@@ -41,7 +102,12 @@ namespace skyline::gpu::memory {
      * @brief A Buffer that can be independently attached to a fence cycle
      */
     class StagingBuffer : public Buffer {
-        using Buffer::Buffer;
+      public:
+        vk::DeviceSize capacity; //!< The size of the underlying VkBuffer, this is larger than the size of the span when the buffer is from a size class of the staging buffer pool
+
+        StagingBuffer(u8 *pointer, size_t size, VmaAllocator vmaAllocator, vk::Buffer vkBuffer, VmaAllocation vmaAllocation)
+            : Buffer(pointer, size, vmaAllocator, vkBuffer, vmaAllocation),
+              capacity(size) {}
     };
 
     /**
@@ -56,11 +122,13 @@ namespace skyline::gpu::memory {
         VmaAllocator vmaAllocator;
         VmaAllocation vmaAllocation;
         vk::Image vkImage;
+        MemoryManager *manager{}; //!< The memory manager which must destroy the image, this is only set for images which may be moved by defragmentation
 
-        constexpr Image(VmaAllocator vmaAllocator, vk::Image vkImage, VmaAllocation vmaAllocation)
+        constexpr Image(VmaAllocator vmaAllocator, vk::Image vkImage, VmaAllocation vmaAllocation, MemoryManager *manager = nullptr)
             : vmaAllocator(vmaAllocator),
               vkImage(vkImage),
-              vmaAllocation(vmaAllocation) {}
+              vmaAllocation(vmaAllocation),
+              manager(manager) {}
 
         constexpr Image(u8 *pointer, VmaAllocator vmaAllocator, vk::Image vkImage, VmaAllocation vmaAllocation)
             : pointer(pointer),
@@ -74,7 +142,8 @@ namespace skyline::gpu::memory {
             : pointer(std::exchange(other.pointer, nullptr)),
               vmaAllocator(std::exchange(other.vmaAllocator, nullptr)),
               vmaAllocation(std::exchange(other.vmaAllocation, nullptr)),
-              vkImage(std::exchange(other.vkImage, {})) {}
+              vkImage(std::exchange(other.vkImage, {})),
+              manager(std::exchange(other.manager, nullptr)) {}
 
         Image &operator=(const Image &) = delete;
 
@@ -94,32 +163,126 @@ namespace skyline::gpu::memory {
      */
     class MemoryManager {
       private:
-        const GPU &gpu;
+        GPU &gpu;
         VmaAllocator vmaAllocator{VK_NULL_HANDLE};
 
+        static constexpr vk::DeviceSize StagingPoolMinSize{1 << 16}; //!< The size of the smallest size class in the staging buffer pool, any smaller staging buffers are rounded up to this
+        static constexpr size_t StagingPoolClassCount{10}; //!< The amount of power-of-two size classes in the staging buffer pool, staging buffers larger than the largest class (32MiB) aren't pooled
+        static constexpr vk::DeviceSize StagingPoolMaxCachedSize{128 * 1024 * 1024}; //!< The maximum combined size of idle staging buffers retained by the pool, any buffers freed beyond this are destroyed
+
+        std::mutex stagingPoolMutex; //!< Synchronizes access to the staging buffer pool as staging buffers can be freed from any thread
+        std::array<std::vector<std::unique_ptr<StagingBuffer>>, StagingPoolClassCount> stagingPool; //!< Idle staging buffers for each size class, these are returned once the last reference to them (usually held by a fence cycle) is dropped
+        vk::DeviceSize stagingPoolCachedSize{}; //!< The combined capacity of all idle staging buffers in the pool
+
+        std::atomic<bool> hostImportFailed{}; //!< If importing host memory has failed, further imports aren't attempted as the driver would reject them in the same way
+
+        std::array<VmaPool, ResourceClassCount> pools{}; //!< The pools of every resource class, a pool is null if no memory type could be found for its class in which case the default pools are used
+
+        static constexpr float DefragmentationThreshold{0.25f}; //!< The fraction of a pool's blocks that must be unused for it to be defragmented
+        static constexpr vk::DeviceSize DefragmentationMaxBytesPerPass{16 * 1024 * 1024}; //!< The maximum amount of bytes moved by a single defragmentation pass, this bounds the time spent in a pass
+        static constexpr u32 DefragmentationMaxAllocationsPerPass{32};
+
+        std::mutex defragmentationMutex; //!< Serializes defragmentation passes between threads
+        VmaDefragmentationContext defragmentation{}; //!< The context of the pool that's currently being defragmented incrementally
+        size_t defragmentationClass{}; //!< The resource class of the pool that's defragmented next
+
+        std::mutex imageOwnerMutex; //!< Synchronizes the members below, it's held while a defragmentation pass resolves and moves its images
+        std::unordered_map<VmaAllocation, ImageOwner *> imageOwners; //!< The owners of all images in pools which are defragmented
+        std::unordered_set<VmaAllocation> passAllocations; //!< The allocations in the current defragmentation pass, these must not be freed until the pass has ended
+        std::vector<std::pair<vk::Image, VmaAllocation>> deferredImages; //!< Images which were destroyed while their allocation was in a defragmentation pass, they're destroyed once it has ended
+
+        /**
+         * @return The pool for the supplied resource class, this is null if it should be allocated from the default pools
+         */
+        VmaPool GetPool(ResourceClass resourceClass) {
+            return pools[static_cast<size_t>(resourceClass)];
+        }
+
+        /**
+         * @brief Creates a new VkBuffer and VMA allocation optimized for staging
+         */
+        std::unique_ptr<StagingBuffer> CreateStagingBuffer(vk::DeviceSize size);
+
+        /**
+         * @brief Returns a staging buffer to the pool for reuse or destroys it if the pool is full
+         */
+        void RecycleStagingBuffer(StagingBuffer *buffer);
+
       public:
-        MemoryManager(const GPU &gpu);
+        MemoryManager(GPU &gpu);
 
         ~MemoryManager();
 
         /**
-         * @brief Creates a buffer which is optimized for staging (Transfer Source)
+         * @brief Retrieves a buffer which is optimized for staging (Transfer Source), this is recycled from the staging buffer pool when possible
+         * @note The buffer is returned to the pool when the last reference to it is dropped, so it must be attached to the fence cycle of any GPU work using it
          */
         std::shared_ptr<StagingBuffer> AllocateStagingBuffer(vk::DeviceSize size);
 
+        /**
+         * @brief Destroys all idle staging buffers in the pool, buffers that are still in use are returned to the pool as usual
+         * @return The combined capacity of the destroyed buffers in bytes
+         */
+        vk::DeviceSize TrimStagingPool();
+
+        /**
+         * @brief Creates a buffer which is optimized for reading back GPU data on the CPU (Transfer Destination), host cached memory is preferred for it
+         */
+        std::shared_ptr<StagingBuffer> AllocateReadbackBuffer(vk::DeviceSize size);
+
         /**
          * @brief Creates a buffer with a CPU mapping and all usage flags
          */
         Buffer AllocateBuffer(vk::DeviceSize size);
 
+        /**
+         * @brief Imports host memory as the backing of a buffer with all usage flags (with VK_EXT_external_memory_host), the CPU mapping of the buffer is the supplied host memory
+         * @param hostMemory The host memory to import, its address and size must be aligned to the minimum imported host pointer alignment and it must outlive the buffer
+         * @return The imported buffer, this is empty if the device doesn't support importing the memory into a host-coherent memory type
+         */
+        std::optional<Buffer> ImportBuffer(span<u8> hostMemory);
+
         /**
          * @brief Creates an image which is allocated and deallocated using RAII
+         * @param owner The owner of the image, only images with an owner are allocated from the texture pools as they're the only ones which can be moved by defragmentation
+         * @note The owner must call ReleaseImageOwner prior to being destroyed
          */
-        Image AllocateImage(const vk::ImageCreateInfo &createInfo);
+        Image AllocateImage(const vk::ImageCreateInfo &createInfo, ImageOwner *owner = nullptr, ResourceClass resourceClass = ResourceClass::SampledTexture);
+
+        /**
+         * @brief Removes all references to the supplied owner, it won't be asked to move any of its images after this
+         */
+        void ReleaseImageOwner(ImageOwner *owner);
+
+        /**
+         * @brief Destroys an image which might be in a defragmentation pass, its destruction is deferred until the pass has ended in that case
+         */
+        void DestroyImage(vk::Image image, VmaAllocation allocation);
 
         /**
          * @brief Creates an image which is allocated and deallocated using RAII and is optimal for being mapped on the CPU
          */
         Image AllocateMappedImage(const vk::ImageCreateInfo &createInfo);
+
+        /**
+         * @return The sum of the budgets of all device-local memory heaps in bytes, this is an estimate of how much memory can be allocated by the process without issues
+         */
+        vk::DeviceSize GetDeviceLocalBudget();
+
+        /**
+         * @brief Performs a single pass of incremental defragmentation on the texture pools, this moves a bounded amount of idle images and waits on the copies
+         * @note This should only be called while the GPU is idle on the calling thread as moving images requires locking their owners
+         */
+        void Defragment();
+
+        struct PoolStatistics {
+            vk::DeviceSize blockBytes; //!< The size of all device memory blocks allocated for the pool
+            vk::DeviceSize allocationBytes; //!< The size of all allocations in the pool, the rest of the blocks is free
+        };
+
+        /**
+         * @return The statistics of the pools of every resource class, they're ordered like ResourceClass
+         */
+        std::array<PoolStatistics, ResourceClassCount> GetPoolStatistics();
     };
 }
@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <sys/mman.h>
+#include <common/perf_stats.h>
+#include <kernel/memory.h>
+#include <kernel/types/KProcess.h>
+#include "mirror_cache.h"
+
+namespace skyline::gpu {
+    MirrorCache::Mapping::Mapping(MirrorCache &cache, span<u8> mirror) : cache{cache}, mirror{mirror} {
+        cache.liveMappings.fetch_add(1, std::memory_order_relaxed);
+        PerfStats::Increment(PerfStats::Counter::MirrorCreations);
+    }
+
+    MirrorCache::Mapping::~Mapping() {
+        if (entry) {
+            std::scoped_lock lock{cache.mutex};
+            cache.mappings.erase(*entry);
+        }
+
+        munmap(mirror.data(), mirror.size());
+        cache.liveMappings.fetch_sub(1, std::memory_order_relaxed);
+        PerfStats::Increment(PerfStats::Counter::MirrorUnmaps);
+    }
+
+    MirrorCache::MirrorCache(const DeviceState &state) : state{state} {}
+
+    MirrorCache::Mirror MirrorCache::Acquire(span<u8> mapping) {
+        std::scoped_lock lock{mutex};
+
+        // Any references are only locked when the mapping contains the range as they're always returned, dropping the last reference while the mutex is held would deadlock
+        auto it{mappings.upper_bound(mapping.data())};
+        for (size_t distance{}; it != mappings.begin() && distance < MaxLookupDistance; distance++) {
+            --it;
+            const auto &cached{it->second};
+            if (cached.guest.end().base() < mapping.end().base())
+                continue;
+
+            if (auto existing{cached.mapping.lock()}) {
+                PerfStats::Increment(PerfStats::Counter::MirrorReuses);
+                auto mirror{existing->mirror.subspan(static_cast<size_t>(mapping.data() - cached.guest.data()), mapping.size())};
+                return {mirror, std::move(existing)};
+            }
+        }
+
+        // Expired mappings are still in the cache until they have been unmapped, they're left to be erased by their destructor
+        auto created{std::make_shared<Mapping>(*this, state.process->memory.CreateMirror(mapping))};
+        created->entry = mappings.emplace(mapping.data(), CachedMapping{mapping, created});
+        return {created->mirror, std::move(created)};
+    }
+
+    MirrorCache::Mirror MirrorCache::Acquire(const std::vector<span<u8>> &regions) {
+        if (regions.size() == 1)
+            return Acquire(regions.front());
+
+        auto created{std::make_shared<Mapping>(*this, state.process->memory.CreateMirrors(regions))};
+        return {created->mirror, std::move(created)};
+    }
+}
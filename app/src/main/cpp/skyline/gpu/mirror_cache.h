@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <map>
+#include <common.h>
+
+namespace skyline::gpu {
+    /**
+     * @brief Shares host mirrors of guest memory between all textures and buffers that mirror the same pages
+     * @details Every mirror is a separate VMA, so creating one per resource churns the address space of the process during texture streaming (contending on its mmap lock) and can exhaust the map count limit of the process. A mirror is instead reused by any resource whose pages are fully contained within it and is only unmapped once the last resource using it is destroyed
+     */
+    class MirrorCache {
+      private:
+        struct Mapping;
+
+        struct CachedMapping {
+            span<u8> guest; //!< The guest pages that are mirrored, this is duplicated from the mapping so it can be checked without locking it
+            std::weak_ptr<Mapping> mapping;
+        };
+
+        using MappingMap = std::multimap<u8 *, CachedMapping>;
+
+        /**
+         * @brief A host mirror mapping of guest memory that's unmapped once all references to it have been destroyed
+         */
+        struct Mapping {
+            MirrorCache &cache;
+            span<u8> mirror;
+            std::optional<MappingMap::iterator> entry; //!< The entry of the mapping in the cache, this is empty for mirrors of multiple regions as they can't be shared
+
+            Mapping(MirrorCache &cache, span<u8> mirror);
+
+            ~Mapping();
+        };
+
+        static constexpr size_t MaxLookupDistance{8}; //!< The maximum amount of mappings starting at or before a range that are checked for containing it, mappings may overlap so the closest one won't necessarily contain it
+
+        const DeviceState &state;
+        std::mutex mutex; //!< Synchronizes all accesses to `mappings`
+        MappingMap mappings; //!< All live mirrors of contiguous guest ranges keyed by the start of their guest range
+        std::atomic<size_t> liveMappings{};
+
+      public:
+        /**
+         * @brief A mirror of guest memory along with a reference that keeps it mapped
+         */
+        struct Mirror {
+            span<u8> mirror; //!< The mirror of the requested guest pages, this may be a part of a larger mirror
+            std::shared_ptr<void> mapping; //!< A reference to the underlying mirror mapping, the mirror is only valid while this is held
+        };
+
+        MirrorCache(const DeviceState &state);
+
+        /**
+         * @brief Finds or creates a mirror of a page-aligned guest mapping
+         * @note The mapping **must** be page-aligned and inside the guest address space
+         */
+        Mirror Acquire(span<u8> mapping);
+
+        /**
+         * @brief Creates a contiguous mirror of multiple page-aligned guest mappings
+         * @note Mirrors of multiple regions aren't shared as only resources covering the exact same regions could use them, unless only a single region is supplied
+         */
+        Mirror Acquire(const std::vector<span<u8>> &regions);
+
+        /**
+         * @return The amount of mirror mappings which are currently mapped
+         */
+        size_t GetLiveMappingCount() const {
+            return liveMappings.load(std::memory_order_relaxed);
+        }
+    };
+}
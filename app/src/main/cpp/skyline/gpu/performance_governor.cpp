@@ -0,0 +1,157 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <cmath>
+#include <dlfcn.h>
+#include <android/thermal.h>
+#include <common/settings.h>
+#include <common/thread_role.h>
+#include <common/trace.h>
+#include "performance_governor.h"
+
+namespace skyline::gpu {
+    PerformanceGovernor::PerformanceGovernor(const DeviceState &state) : state{state}, enabled{*state.settings->performanceGovernor}, limitResolutionScale{*state.settings->thermalResolutionScaling} {
+        if (!enabled)
+            return;
+
+        libandroid = dlopen("libandroid.so", RTLD_NOW | RTLD_LOCAL);
+        if (!libandroid) {
+            Logger::Warn("Failed to open libandroid.so, the performance governor is disabled: {}", dlerror());
+            enabled = false;
+            return;
+        }
+
+        auto resolve{[this](auto &function, const char *name) {
+            function = reinterpret_cast<std::remove_reference_t<decltype(function)>>(dlsym(libandroid, name));
+            return function != nullptr;
+        }};
+
+        AThermalManager *(*pfnAcquireManager)(){};
+        i32 (*pfnGetCurrentThermalStatus)(AThermalManager *){};
+        int (*pfnRegisterListener)(AThermalManager *, void (*)(void *, i32), void *){};
+        if (resolve(pfnAcquireManager, "AThermal_acquireManager") && resolve(pfnGetCurrentThermalStatus, "AThermal_getCurrentThermalStatus") && resolve(pfnRegisterListener, "AThermal_registerThermalStatusListener")) {
+            if ((thermalManager = pfnAcquireManager())) {
+                thermalStatus = pfnGetCurrentThermalStatus(thermalManager);
+                if (int result{pfnRegisterListener(thermalManager, &ThermalStatusCallback, this)})
+                    Logger::Warn("Failed to register the thermal status listener: {}", strerror(result));
+                resolve(pfnGetThermalHeadroom, "AThermal_getThermalHeadroom");
+            }
+        } else {
+            Logger::Info("Thermal status is unavailable, only performance hints will be supplied");
+        }
+
+        APerformanceHintManager *(*pfnGetManager)(){};
+        if (resolve(pfnGetManager, "APerformanceHint_getManager") && resolve(pfnCreateSession, "APerformanceHint_createSession") && resolve(pfnUpdateTargetWorkDuration, "APerformanceHint_updateTargetWorkDuration") && resolve(pfnReportActualWorkDuration, "APerformanceHint_reportActualWorkDuration") && resolve(pfnCloseSession, "APerformanceHint_closeSession"))
+            hintManager = pfnGetManager();
+        else
+            Logger::Info("Performance hints are unavailable");
+    }
+
+    PerformanceGovernor::~PerformanceGovernor() {
+        if (hintSession)
+            pfnCloseSession(hintSession);
+
+        if (thermalManager) {
+            int (*pfnUnregisterListener)(AThermalManager *, void (*)(void *, i32), void *){reinterpret_cast<decltype(pfnUnregisterListener)>(dlsym(libandroid, "AThermal_unregisterThermalStatusListener"))};
+            if (pfnUnregisterListener)
+                pfnUnregisterListener(thermalManager, &ThermalStatusCallback, this);
+
+            if (auto pfnReleaseManager{reinterpret_cast<void (*)(AThermalManager *)>(dlsym(libandroid, "AThermal_releaseManager"))})
+                pfnReleaseManager(thermalManager);
+        }
+
+        if (libandroid)
+            dlclose(libandroid);
+    }
+
+    void PerformanceGovernor::ThermalStatusCallback(void *data, i32 status) {
+        static_cast<PerformanceGovernor *>(data)->thermalStatus.store(status, std::memory_order_relaxed);
+    }
+
+    PerformanceGovernor::ThermalLevel PerformanceGovernor::GetCurrentThermalLevel() {
+        i32 status{thermalStatus.load(std::memory_order_relaxed)};
+        if (status >= ATHERMAL_STATUS_SEVERE || thermalHeadroom >= 1.0f)
+            return ThermalLevel::Severe;
+        else if (status >= ATHERMAL_STATUS_MODERATE || thermalHeadroom >= 0.85f)
+            return ThermalLevel::Moderate; // The headroom is forecasted, so this allows adjusting prior to the device actually throttling
+        return ThermalLevel::Nominal;
+    }
+
+    void PerformanceGovernor::SetThermalLevel(ThermalLevel newLevel) {
+        Logger::Info("Thermal level: {} -> {} (Status: {}, Headroom: {:.2f})", static_cast<u32>(level), static_cast<u32>(newLevel), thermalStatus.load(std::memory_order_relaxed), thermalHeadroom);
+        level = newLevel;
+
+        thread_role::SetThrottled(newLevel >= ThermalLevel::Moderate);
+        slotCountLimit.store(newLevel >= ThermalLevel::Severe ? ThrottledSlotCountLimit : std::numeric_limits<u32>::max(), std::memory_order_relaxed);
+        resolutionScaleCapped.store(limitResolutionScale && newLevel >= ThermalLevel::Severe, std::memory_order_relaxed);
+
+        TRACE_COUNTER("gpu", "ThermalLevel", static_cast<u32>(newLevel));
+    }
+
+    void PerformanceGovernor::UpdateHintSession(i64 now, i64 targetDurationNs) {
+        if (!hintSession || now - lastHintSessionCheck >= constant::NsInSecond) {
+            lastHintSessionCheck = now;
+
+            // Threads that exited are harmless to keep in the session, so it's only recreated when a new latency-critical thread shows up
+            using thread_role::Role;
+            auto threads{thread_role::GetThreads({Role::GuestCore, Role::Gpfifo, Role::CommandRecord, Role::Presentation})};
+            bool hasNewThreads{std::any_of(threads.begin(), threads.end(), [this](pid_t tid) { return std::find(hintThreads.begin(), hintThreads.end(), tid) == hintThreads.end(); })};
+            if (hasNewThreads) {
+                if (hintSession)
+                    pfnCloseSession(std::exchange(hintSession, nullptr));
+
+                hintThreads = std::move(threads);
+                hintTargetDuration = targetDurationNs;
+                static_assert(sizeof(pid_t) == sizeof(i32));
+                hintSession = pfnCreateSession(hintManager, reinterpret_cast<const i32 *>(hintThreads.data()), hintThreads.size(), targetDurationNs);
+                if (!hintSession) {
+                    Logger::Warn("Failed to create a performance hint session for {} threads, performance hints are disabled", hintThreads.size());
+                    hintManager = nullptr;
+                }
+                return;
+            }
+        }
+
+        if (hintSession && targetDurationNs != hintTargetDuration) {
+            hintTargetDuration = targetDurationNs;
+            pfnUpdateTargetWorkDuration(hintSession, targetDurationNs);
+        }
+    }
+
+    void PerformanceGovernor::ReportFrame(i64 frameDurationNs, i64 targetDurationNs) {
+        if (!enabled)
+            return;
+
+        i64 now{util::GetTimeNs()};
+        if (thermalManager) {
+            if (pfnGetThermalHeadroom && now - lastHeadroomPoll >= HeadroomPollInterval) {
+                lastHeadroomPoll = now;
+                if (float headroom{pfnGetThermalHeadroom(thermalManager, HeadroomForecastSeconds)}; !std::isnan(headroom))
+                    thermalHeadroom = headroom;
+            }
+
+            // Adjustments are made immediately when the pressure rises but only relaxed once it has remained lower for a while
+            ThermalLevel currentLevel{GetCurrentThermalLevel()};
+            if (currentLevel > level) {
+                lowerLevelSince = 0;
+                SetThermalLevel(currentLevel);
+            } else if (currentLevel < level) {
+                if (!lowerLevelSince) {
+                    lowerLevelSince = now;
+                } else if (now - lowerLevelSince >= RecoveryDuration) {
+                    lowerLevelSince = 0;
+                    SetThermalLevel(currentLevel);
+                }
+            } else {
+                lowerLevelSince = 0;
+            }
+        }
+
+        // The interval between frames is used as the work duration, it's an upper bound of the work for the frame since it includes any waits but it never under-reports when the guest falls behind its target
+        if (hintManager) {
+            UpdateHintSession(now, targetDurationNs);
+            if (hintSession)
+                pfnReportActualWorkDuration(hintSession, frameDurationNs);
+        }
+    }
+}
@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common.h>
+
+struct AThermalManager;
+struct APerformanceHintManager;
+struct APerformanceHintSession;
+
+namespace skyline::gpu {
+    /**
+     * @brief Adjusts the emulator to sustain performance under thermal pressure and supplies per-frame work durations to the CPU performance hint API
+     * @note The NDK thermal (API 30/31) and performance hint (API 33) functions are resolved at runtime as they're newer than the minimum API level, any that are unavailable are skipped
+     */
+    class PerformanceGovernor {
+      public:
+        /**
+         * @brief A coarse level of thermal pressure that determines the adjustments which are made
+         */
+        enum class ThermalLevel : u8 {
+            Nominal, //!< No adjustments are made
+            Moderate, //!< Latency-critical threads are moved off the prime cores
+            Severe, //!< The executor slot count is limited and the resolution scale is capped at native (if enabled)
+        };
+
+      private:
+        const DeviceState &state;
+        bool enabled; //!< If the governor is enabled, no NDK functions are resolved and no adjustments are made otherwise
+        bool limitResolutionScale; //!< If the resolution scale of new render targets should be capped under severe thermal pressure
+
+        static constexpr i64 HeadroomPollInterval{constant::NsInSecond}; //!< The minimum interval between polls of the thermal headroom, the API is rate-limited and returns NaN when polled more often
+        static constexpr i64 RecoveryDuration{30 * constant::NsInSecond}; //!< The duration the thermal level must remain lower for prior to the adjustments being relaxed, this avoids oscillating around a threshold
+        static constexpr i32 HeadroomForecastSeconds{10}; //!< The amount of seconds ahead the thermal headroom is forecasted for
+        static constexpr u32 ThrottledSlotCountLimit{2}; //!< The executor slot count limit under severe thermal pressure, fewer slots stop the CPU from running ahead of the GPU
+
+        void *libandroid{}; //!< A handle to libandroid.so which all NDK functions are resolved from
+
+        AThermalManager *thermalManager{};
+        std::atomic<i32> thermalStatus{}; //!< The latest AThermalStatus reported by the thermal status listener
+        float (*pfnGetThermalHeadroom)(AThermalManager *, int){}; //!< AThermal_getThermalHeadroom (API 31)
+        float thermalHeadroom{}; //!< The latest forecasted thermal headroom, 1.0 corresponds to severe throttling
+        i64 lastHeadroomPoll{};
+
+        ThermalLevel level{ThermalLevel::Nominal}; //!< The thermal level adjustments are currently made for
+        i64 lowerLevelSince{}; //!< The timestamp since which the thermal level has been lower than the current level, 0 if it isn't lower
+        std::atomic<u32> slotCountLimit{std::numeric_limits<u32>::max()};
+        std::atomic<bool> resolutionScaleCapped{};
+
+        APerformanceHintManager *hintManager{};
+        APerformanceHintSession *hintSession{};
+        APerformanceHintSession *(*pfnCreateSession)(APerformanceHintManager *, const i32 *, size_t, i64){};
+        int (*pfnUpdateTargetWorkDuration)(APerformanceHintSession *, i64){};
+        int (*pfnReportActualWorkDuration)(APerformanceHintSession *, i64){};
+        void (*pfnCloseSession)(APerformanceHintSession *){};
+        std::vector<pid_t> hintThreads; //!< The TIDs of the threads the session was created with
+        i64 hintTargetDuration{}; //!< The target work duration the session was last supplied
+        i64 lastHintSessionCheck{};
+
+        static void ThermalStatusCallback(void *data, i32 status);
+
+        /**
+         * @return The thermal level corresponding to the latest thermal status and headroom
+         */
+        ThermalLevel GetCurrentThermalLevel();
+
+        /**
+         * @brief Applies the adjustments for the supplied thermal level
+         */
+        void SetThermalLevel(ThermalLevel newLevel);
+
+        /**
+         * @brief Creates the performance hint session or recreates it if the set of latency-critical threads has changed
+         */
+        void UpdateHintSession(i64 now, i64 targetDurationNs);
+
+      public:
+        PerformanceGovernor(const DeviceState &state);
+
+        ~PerformanceGovernor();
+
+        /**
+         * @brief Reports the duration of a presented frame alongside the duration the guest targets for it, this drives both the thermal adjustments and performance hints
+         * @note This must only be called from the presentation thread
+         */
+        void ReportFrame(i64 frameDurationNs, i64 targetDurationNs);
+
+        /**
+         * @return The maximum amount of executor slots that should be allocated
+         */
+        u32 GetSlotCountLimit() const {
+            return slotCountLimit.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @return If the resolution scale of newly created render targets should be capped at the native resolution
+         */
+        bool IsResolutionScaleCapped() const {
+            return resolutionScaleCapped.load(std::memory_order_relaxed);
+        }
+    };
+}
@@ -4,7 +4,11 @@
 #include <android/native_window_jni.h>
 #include <android/choreographer.h>
 #include <common/settings.h>
+#include <common/perf_stats.h>
+#include <common/benchmark.h>
 #include <common/signal.h>
+#include <common/thread_role.h>
+#include <common/emulation_speed.h>
 #include <jvm.h>
 #include <gpu.h>
 #include <soc.h>
@@ -17,6 +21,7 @@
 extern jint Fps;
 extern jfloat AverageFrametimeMs;
 extern jfloat AverageFrametimeDeviationMs;
+extern std::shared_ptr<skyline::BenchmarkRunner> Benchmark;
 
 namespace skyline::gpu {
     using namespace service::hosbinder;
@@ -28,6 +33,8 @@ namespace skyline::gpu {
           acquireSemaphores{util::MakeFilledArray<vk::raii::Semaphore, MaxSwapchainImageCount>(gpu.vkDevice, vk::SemaphoreCreateInfo{})},
           presentationTrack{static_cast<u64>(trace::TrackIds::Presentation), perfetto::ProcessTrack::Current()},
           vsyncEvent{std::make_shared<kernel::type::KEvent>(state, true)},
+          scaledVsync{emulation_speed::IsEnabled()},
+          vsyncThread{scaledVsync ? std::thread{&PresentationEngine::VsyncThread, this} : std::thread{}},
           choreographerThread{&PresentationEngine::ChoreographerThread, this},
           presentationThread{&PresentationEngine::PresentationThread, this} {
         auto desc{presentationTrack.Serialize()};
@@ -47,6 +54,15 @@ namespace skyline::gpu {
             }
             choreographerThread.join();
         }
+
+        if (vsyncThread.joinable()) {
+            {
+                std::scoped_lock lock{vsyncMutex};
+                vsyncStop = true;
+            }
+            vsyncCondition.notify_all();
+            vsyncThread.join();
+        }
     }
 
     void PresentationEngine::ChoreographerCallback(int64_t frameTimeNanos, PresentationEngine *engine) {
@@ -61,7 +77,8 @@ namespace skyline::gpu {
 
         // Record the current cycle's timestamp and signal the V-Sync event to notify the game that a frame has been displayed
         engine->lastChoreographerTime = frameTimeNanos;
-        engine->vsyncEvent->Signal();
+        if (!engine->scaledVsync)
+            engine->vsyncEvent->Signal();
 
         // Post the frame callback to be triggered on the next display refresh
         AChoreographer_postFrameCallback64(AChoreographer_getInstance(), reinterpret_cast<AChoreographer_frameCallback64>(&ChoreographerCallback), engine);
@@ -70,6 +87,7 @@ namespace skyline::gpu {
     void PresentationEngine::ChoreographerThread() {
         if (int result{pthread_setname_np(pthread_self(), "Sky-Choreo")})
             Logger::Warn("Failed to set the thread name: {}", strerror(result));
+        thread_role::Apply(thread_role::Role::Presentation);
 
         try {
             signal::SetSignalHandler({SIGINT, SIGILL, SIGTRAP, SIGBUS, SIGFPE, SIGSEGV}, signal::ExceptionalSignalHandler);
@@ -91,6 +109,34 @@ namespace skyline::gpu {
         }
     }
 
+    void PresentationEngine::VsyncThread() {
+        if (int result{pthread_setname_np(pthread_self(), "Sky-Vsync")})
+            Logger::Warn("Failed to set the thread name: {}", strerror(result));
+        thread_role::Apply(thread_role::Role::Presentation);
+
+        // The deadline is advanced by the scaled cycle each iteration rather than sleeping for it so the rate doesn't drift with the wakeup latency
+        auto deadline{std::chrono::steady_clock::now()};
+        std::unique_lock lock{vsyncMutex};
+        while (true) {
+            deadline += std::chrono::nanoseconds{static_cast<i64>(static_cast<double>(GuestRefreshCycleDuration) / emulation_speed::GetFactor())};
+            if (auto now{std::chrono::steady_clock::now()}; deadline < now)
+                deadline = now; // Missed cycles aren't signalled in a burst after a stall
+
+            if (vsyncCondition.wait_until(lock, deadline, [this] { return vsyncStop; }))
+                return;
+
+            vsyncEvent->Signal();
+        }
+    }
+
+    i64 PresentationEngine::GetHostSwapInterval(i64 swapInterval) {
+        if (!refreshCycleDuration)
+            return swapInterval;
+
+        i64 frameDuration{static_cast<i64>(static_cast<double>(swapInterval * GuestRefreshCycleDuration) / emulation_speed::GetFactor())};
+        return std::max<i64>((frameDuration + (refreshCycleDuration / 10)) / refreshCycleDuration, 1);
+    }
+
     void PresentationEngine::PresentFrame(const PresentableFrame &frame) {
         std::unique_lock lock(mutex);
         surfaceCondition.wait(lock, [this]() { return vkSurface.has_value(); });
@@ -104,11 +150,23 @@ namespace skyline::gpu {
         if (frame.textureView->format != swapchainFormat || texture->dimensions != swapchainExtent)
             UpdateSwapchain(frame.textureView->format, texture->dimensions);
 
+        // The crop is specified in guest coordinates, it needs to be scaled to match the host dimensions of scaled textures
+        auto crop{frame.crop};
+        if (crop && texture->scale != 1.0f) {
+            auto scaleCoordinate{[scale = texture->scale](u32 coordinate) { return static_cast<u32>(texture::ScaleCoordinate(static_cast<i32>(coordinate), scale)); }};
+            crop = {
+                .left = scaleCoordinate(crop.left),
+                .top = scaleCoordinate(crop.top),
+                .right = std::min(scaleCoordinate(crop.right), texture->dimensions.width),
+                .bottom = std::min(scaleCoordinate(crop.bottom), texture->dimensions.height),
+            };
+        }
+
         int result;
-        if (frame.crop && frame.crop != windowCrop) {
-            if ((result = window->perform(window, NATIVE_WINDOW_SET_CROP, &frame.crop)))
-                throw exception("Setting the layer crop to ({}-{})x({}-{}) failed with {}", frame.crop.left, frame.crop.right, frame.crop.top, frame.crop.bottom, result);
-            windowCrop = frame.crop;
+        if (crop && crop != windowCrop) {
+            if ((result = window->perform(window, NATIVE_WINDOW_SET_CROP, &crop)))
+                throw exception("Setting the layer crop to ({}-{})x({}-{}) failed with {}", crop.left, crop.right, crop.top, crop.bottom, result);
+            windowCrop = crop;
         }
 
         if (frame.scalingMode != NativeWindowScalingMode::Freeze && windowScalingMode != frame.scalingMode) {
@@ -117,14 +175,25 @@ namespace skyline::gpu {
             windowScalingMode = frame.scalingMode;
         }
 
+        double speedFactor{emulation_speed::GetFactor()};
+        float frameRate{frame.swapInterval ? static_cast<float>(constant::NsInSecond * speedFactor) / static_cast<float>(frame.swapInterval * GuestRefreshCycleDuration) : 0.0f};
+        if (frame.swapInterval && frameRate != windowFrameRate && !*state.settings->disableFrameThrottling) {
+            // Voting for the frame rate the guest is targeting allows the display to switch to a refresh rate that's a multiple of it, this avoids judder and lets the panel run at a lower rate for 30 FPS titles
+            constexpr i8 FrameRateCompatibilityFixedSource{1}; //!< ANATIVEWINDOW_FRAME_RATE_COMPATIBILITY_FIXED_SOURCE
+            constexpr i8 ChangeFrameRateOnlyIfSeamless{0}; //!< ANATIVEWINDOW_CHANGE_FRAME_RATE_ONLY_IF_SEAMLESS
+            if ((result = window->perform(window, NATIVE_WINDOW_SET_FRAME_RATE, frameRate, FrameRateCompatibilityFixedSource, ChangeFrameRateOnlyIfSeamless)))
+                Logger::Warn("Setting the frame rate to {:.2f} failed with {}", frameRate, result); // This is only supported on Android 11 and above, it's not fatal if it fails
+            windowFrameRate = frameRate;
+        }
+
         if ((result = window->perform(window, NATIVE_WINDOW_SET_BUFFERS_TRANSFORM, static_cast<i32>(frame.transform))))
             throw exception("Setting the buffer transform to '{}' failed with {}", ToString(frame.transform), result);
         windowTransform = frame.transform;
 
+        ThrottleInFlightFrames();
+
         auto &acquireSemaphore{acquireSemaphores[frameIndex]};
         auto &frameFence{frameFences[frameIndex]};
-        if (frameFence)
-            frameFence->Wait();
 
         frameIndex = (frameIndex + 1) % swapchainImageCount;
 
@@ -140,13 +209,25 @@ namespace skyline::gpu {
         auto &presentSemaphore{presentSemaphores[nextImage.second]};
 
         texture->SynchronizeHost();
-        nextImageTexture->CopyFrom(texture, *acquireSemaphore, *presentSemaphore, vk::ImageSubresourceRange{
-            .aspectMask = vk::ImageAspectFlagBits::eColor,
-            .levelCount = 1,
-            .layerCount = 1,
-        });
 
-        frameFence = nextImageTexture->cycle;
+        // Games commonly present the same framebuffer repeatedly without modifying it (e.g. during loading screens or when running below the display refresh rate), the swapchain image retains its contents across presents so the copy can be skipped in that case
+        auto &contents{imageContents[nextImage.second]};
+        if (contents.texture.lock() == texture && contents.modificationCounter == texture->modificationCounter) {
+            TRACE_EVENT("gpu", "PresentationEngine::SkipCopy");
+
+            // The acquire semaphore still needs to be waited on and the present semaphore signalled, an empty submission handles this without touching the image
+            vk::Semaphore waitSemaphore{*acquireSemaphore}, signalSemaphore{*presentSemaphore};
+            frameFence = gpu.scheduler.Submit([](vk::raii::CommandBuffer &) {}, span<vk::Semaphore>{waitSemaphore}, span<vk::Semaphore>{signalSemaphore});
+        } else {
+            nextImageTexture->CopyFrom(texture, *acquireSemaphore, *presentSemaphore, vk::ImageSubresourceRange{
+                .aspectMask = vk::ImageAspectFlagBits::eColor,
+                .levelCount = 1,
+                .layerCount = 1,
+            });
+
+            contents = {texture, texture->modificationCounter};
+            frameFence = nextImageTexture->cycle;
+        }
 
         auto getMonotonicNsNow{[]() -> i64 {
             timespec time;
@@ -168,15 +249,19 @@ namespace skyline::gpu {
             }
         }
 
-        if (frame.swapInterval) {
-            // If we have a swap interval, we have to adjust the timestamp to emulate the swap interval
+        if (frame.swapInterval && speedFactor <= 1.0) {
+            // If we have a swap interval, we have to adjust the timestamp to emulate the swap interval, this is done in terms of host refreshes as the display may not be running at 60Hz
+            i64 swapInterval{GetHostSwapInterval(frame.swapInterval)};
             i64 lastFramePresentTime{util::AlignUpNpot(windowLastTimestamp, refreshCycleDuration)};
-            if (lastFramePresentTime > lastChoreographerTime)
+            if (lastFramePresentTime > lastChoreographerTime) {
                 // If the last frame was presented after the last choreographer callback, calculate the new frame's timestamp relative to it
-                timestamp = std::max(timestamp, lastFramePresentTime + (refreshCycleDuration * frame.swapInterval));
-            else
+                timestamp = std::max(timestamp, lastFramePresentTime + (refreshCycleDuration * swapInterval));
+            } else {
                 // If there has been a choreographer callback since the last frame, calculate the new frame's timestamp relative to it
-                timestamp = std::max(timestamp, lastChoreographerTime + (2 * refreshCycleDuration * frame.swapInterval));
+                // The smoothest mode leaves an additional interval of slack so the frame doesn't miss its deadline, the lowest latency mode targets the earliest possible refresh instead
+                i64 intervalCount{static_cast<FramePacingMode>(*state.settings->framePacingMode) == FramePacingMode::LowestLatency ? 1 : 2};
+                timestamp = std::max(timestamp, lastChoreographerTime + (intervalCount * refreshCycleDuration * swapInterval));
+            }
         }
 
         i64 lastTimestamp{std::exchange(windowLastTimestamp, timestamp)};
@@ -222,20 +307,87 @@ namespace skyline::gpu {
 
             TRACE_EVENT_INSTANT("gpu", "Present", presentationTrack, "FrameTimeNs", timestamp - frameTimestamp, "Fps", Fps);
 
+            gpu.governor.ReportFrame(currentFrametime, static_cast<i64>(static_cast<double>(std::max<i64>(frame.swapInterval, 1) * GuestRefreshCycleDuration) / speedFactor));
+
             frameTimestamp = timestamp;
         } else {
             frameTimestamp = timestamp;
         }
+
+        if (frame.inputTimestamp) {
+            i64 inputLatency{util::GetTimeNs() - frame.inputTimestamp};
+            PerfStats::Record(PerfStats::Histogram::InputLatency, static_cast<u64>(inputLatency) / 1000);
+            TRACE_EVENT_INSTANT("gpu", "InputLatency", presentationTrack, "FrameId", frame.id, "LatencyNs", inputLatency);
+        }
+
+        PerfStats::Sample();
+
+        if (Benchmark)
+            Benchmark->OnPresent(timestamp);
+    }
+
+    void PresentationEngine::ThrottleInFlightFrames() {
+        bool lowestLatency{static_cast<FramePacingMode>(*state.settings->framePacingMode) == FramePacingMode::LowestLatency};
+        size_t minimumLimit{std::min(lowestLatency ? LowestLatencyMinimumInFlightFrameCount : MinimumInFlightFrameCount, swapchainImageCount)};
+        inFlightFrameLimit = std::clamp(inFlightFrameLimit, minimumLimit, swapchainImageCount);
+
+        // Frames complete in submission order as they're all submitted to the same queue, waiting on the frame submitted `inFlightFrameLimit` frames ago ensures that there'll be at most that many frames in-flight after this one is submitted
+        // This also implies that the frame which last used the resources at the current frame index has completed
+        i64 stallNs{};
+        auto &throttleFence{frameFences[(frameIndex + swapchainImageCount - inFlightFrameLimit) % swapchainImageCount]};
+        if (throttleFence && !throttleFence->Poll()) {
+            TRACE_EVENT("gpu", "PresentationEngine::ThrottleInFlightFrames");
+            i64 waitStart{util::GetTimeNs()};
+            throttleFence->Wait();
+            stallNs = util::GetTimeNs() - waitStart;
+        }
+
+        if (auto &frameFence{frameFences[frameIndex]})
+            frameFence->Wait(); // This should never block, it's only for safety if the swapchain image count changed since the fence was submitted
+
+        constexpr i64 SampleWeight{16}; //!< The weight of each sample in the modified moving average of stalls
+        averageFrameStallNs = (((SampleWeight - 1) * averageFrameStallNs) + stallNs) / SampleWeight;
+        averageFrameStallDeviationNs = (((SampleWeight - 1) * averageFrameStallDeviationNs) + std::abs(stallNs - averageFrameStallNs)) / SampleWeight;
+
+        if (++inFlightFrameEvaluationCounter < InFlightFrameEvaluationInterval)
+            return;
+        inFlightFrameEvaluationCounter = 0;
+
+        // A steady stall means the GPU is consistently the bottleneck and more frames in-flight would only add latency without improving throughput
+        // Additional frames in-flight are only beneficial when GPU completion times vary, they can absorb spikes without the CPU having to wait on the GPU
+        i64 refreshCycle{refreshCycleDuration ? refreshCycleDuration : GuestRefreshCycleDuration};
+        size_t previousLimit{inFlightFrameLimit};
+        if (averageFrameStallDeviationNs > refreshCycle / 4) {
+            inFlightFrameCalmCounter = 0;
+            inFlightFrameLimit = std::min(inFlightFrameLimit + 1, swapchainImageCount);
+        } else if (averageFrameStallDeviationNs < refreshCycle / 16 && ++inFlightFrameCalmCounter >= InFlightFrameCalmEvaluationCount) {
+            inFlightFrameCalmCounter = 0;
+            inFlightFrameLimit = std::max(inFlightFrameLimit - 1, minimumLimit);
+        }
+
+        if (inFlightFrameLimit != previousLimit) {
+            Logger::Debug("In-flight frame limit: {} -> {} (Stall: {}ns, Deviation: {}ns)", previousLimit, inFlightFrameLimit, averageFrameStallNs, averageFrameStallDeviationNs);
+            TRACE_COUNTER("gpu", "InFlightFrameLimit", inFlightFrameLimit);
+        }
     }
 
     void PresentationEngine::PresentationThread() {
         if (int result{pthread_setname_np(pthread_self(), "Sky-Present")})
             Logger::Warn("Failed to set the thread name: {}", strerror(result));
+        thread_role::Apply(thread_role::Role::Presentation);
 
         try {
             signal::SetSignalHandler({SIGINT, SIGILL, SIGTRAP, SIGBUS, SIGFPE, SIGSEGV}, signal::ExceptionalSignalHandler);
 
             presentQueue.Process([this](const PresentableFrame &frame) {
+                if (static_cast<FramePacingMode>(*state.settings->framePacingMode) == FramePacingMode::LowestLatency && presentQueue.Size() > LowestLatencyMaxQueuedFrames) {
+                    // A newer frame has been queued behind this one, presenting this frame would only delay the newer one by a refresh cycle
+                    TRACE_EVENT_INSTANT("gpu", "DropFrame", presentationTrack, "FrameId", frame.id);
+                    frame.fence.Wait(state.soc->host1x);
+                    frame.presentCallback();
+                    return;
+                }
+
                 PresentFrame(frame);
                 frame.presentCallback(); // We're calling the callback here as it's outside of all the locks in PresentFrame
             }, [] {});
@@ -301,6 +453,8 @@ namespace skyline::gpu {
 
         auto requestedMode{*state.settings->disableFrameThrottling ? vk::PresentModeKHR::eMailbox : vk::PresentModeKHR::eFifo};
         auto modes{gpu.vkPhysicalDevice.getSurfacePresentModesKHR(**vkSurface)};
+        if (!*state.settings->disableFrameThrottling && emulation_speed::GetMaxFactor() > 1.0 && std::find(modes.begin(), modes.end(), vk::PresentModeKHR::eMailbox) != modes.end())
+            requestedMode = vk::PresentModeKHR::eMailbox; // Frames faster than the display's refresh rate would block on FIFO, these are replaced in the mailbox instead while timestamps pace frames at lower speeds
         if (std::find(modes.begin(), modes.end(), requestedMode) == modes.end())
             throw exception("Swapchain doesn't support present mode: {}", vk::to_string(requestedMode));
 
@@ -331,6 +485,8 @@ namespace skyline::gpu {
             // We need to clear all the slots which aren't filled, keeping around stale slots could lead to issues
             images[index] = {};
 
+        imageContents = {}; // The contents of the new swapchain images are undefined
+
         swapchainFormat = format;
         swapchainExtent = extent;
         swapchainImageCount = vkImages.size();
@@ -376,6 +532,8 @@ namespace skyline::gpu {
             if (windowTransform != NativeWindowTransform::Identity && (result = window->perform(window, NATIVE_WINDOW_SET_BUFFERS_TRANSFORM, static_cast<i32>(windowTransform))))
                 throw exception("Setting the buffer transform to '{}' failed with {}", ToString(windowTransform), result);
 
+            windowFrameRate = 0; // The frame rate needs to be set again for the new window
+
             if ((result = window->perform(window, NATIVE_WINDOW_ENABLE_FRAME_TIMESTAMPS, true)))
                 throw exception("Enabling frame timestamps failed with {}", result);
 
@@ -400,6 +558,7 @@ namespace skyline::gpu {
             swapInterval,
             presentCallback,
             nextFrameId,
+            std::exchange(nextFrameInputTimestamp, 0),
             crop,
             scalingMode,
             transform
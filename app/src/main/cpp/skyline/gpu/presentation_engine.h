@@ -30,6 +30,7 @@ namespace skyline::gpu {
         service::hosbinder::NativeWindowScalingMode windowScalingMode{service::hosbinder::NativeWindowScalingMode::ScaleToWindow}; //!< The mode in which the cropped image is scaled up to the surface
         service::hosbinder::NativeWindowTransform windowTransform{}; //!< The transformation performed on the image prior to presentation
         i64 windowLastTimestamp{}; //!< The last timestamp submitted to the window, 0 or CLOCK_MONOTONIC value
+        float windowFrameRate{}; //!< The frame rate that was last voted for on the window, 0 if it hasn't been set
 
         std::optional<vk::raii::SurfaceKHR> vkSurface; //!< The Vulkan Surface object that is backed by ANativeWindow
         vk::SurfaceCapabilitiesKHR vkSurfaceCapabilities{}; //!< The capabilities of the current Vulkan Surface
@@ -40,12 +41,31 @@ namespace skyline::gpu {
 
         static constexpr size_t MaxSwapchainImageCount{6}; //!< The maximum amount of swapchain textures, this affects the amount of images that can be in the swapchain
         std::array<std::shared_ptr<Texture>, MaxSwapchainImageCount> images; //!< All the swapchain textures in the same order as supplied by the host swapchain
+
+        /**
+         * @brief The guest texture that was last copied into a swapchain image, this allows skipping the copy when the same unmodified texture is presented again
+         */
+        struct SwapchainImageContents {
+            std::weak_ptr<Texture> texture;
+            u64 modificationCounter{}; //!< The value of the texture's modification counter at the time of the copy
+        };
+        std::array<SwapchainImageContents, MaxSwapchainImageCount> imageContents{}; //!< The contents of all the swapchain images, indexed by Vulkan swapchain index
         std::array<vk::raii::Semaphore, MaxSwapchainImageCount> presentSemaphores; //!< Array of semaphores used to signal that swapchain images are ready to be completed, indexed by Vulkan swapchain index
         std::array<vk::raii::Semaphore, MaxSwapchainImageCount> acquireSemaphores; //!< Array of semaphores used to wait on the GPU for swapchain images to be acquired, indexed by `frameIndex`
         std::array<std::shared_ptr<FenceCycle>, MaxSwapchainImageCount> frameFences{}; //!< Array of fences used to wait on the GPU for copying of swapchain images to be completed, indexed by `frameIndex`
         size_t frameIndex{}; //!< The index of the next semaphore/fence to be used for acquiring swapchain images
         size_t swapchainImageCount{}; //!< The number of images in the current swapchain
 
+        static constexpr size_t MinimumInFlightFrameCount{2}; //!< The minimum amount of frames that can be in-flight on the GPU with the smoothest pacing mode
+        static constexpr size_t LowestLatencyMinimumInFlightFrameCount{1}; //!< The minimum amount of frames that can be in-flight on the GPU with the lowest latency pacing mode
+        static constexpr u32 InFlightFrameEvaluationInterval{30}; //!< The amount of frames between evaluations of the in-flight frame limit
+        static constexpr u32 InFlightFrameCalmEvaluationCount{4}; //!< The amount of consecutive evaluations with steady GPU completion times required to lower the in-flight frame limit, this avoids oscillating between limits
+        size_t inFlightFrameLimit{MinimumInFlightFrameCount}; //!< The amount of frames that can be in-flight on the GPU at once, this is raised when GPU completion times vary and lowered when they're steady
+        i64 averageFrameStallNs{}; //!< The average time spent blocking on the GPU to complete frames beyond the in-flight limit in nanoseconds
+        i64 averageFrameStallDeviationNs{}; //!< The average deviation of the time spent blocking on the GPU in nanoseconds
+        u32 inFlightFrameEvaluationCounter{}; //!< The amount of frames since the in-flight frame limit was last evaluated
+        u32 inFlightFrameCalmCounter{}; //!< The amount of consecutive evaluations where GPU completion times were steady
+
         i64 frameTimestamp{}; //!< The timestamp of the last frame being shown in nanoseconds
         i64 averageFrametimeNs{}; //!< The average time between frames in nanoseconds
         i64 averageFrametimeDeviationNs{}; //!< The average deviation of frametimes in nanoseconds
@@ -55,10 +75,16 @@ namespace skyline::gpu {
         std::shared_ptr<kernel::type::KEvent> vsyncEvent; //!< Signalled every time a frame is drawn
 
       private:
+        bool scaledVsync; //!< If the V-Sync event is signalled by the V-Sync thread at a rate scaled by the emulation speed rather than by Choreographer
+        std::mutex vsyncMutex;
+        std::condition_variable vsyncCondition; //!< Signalled when the V-Sync thread should stop
+        bool vsyncStop{}; //!< If the V-Sync thread should stop
+        std::thread vsyncThread; //!< A thread for signalling the V-Sync event at the guest refresh rate scaled by the emulation speed, this is only used when speed control is enabled
         std::thread choreographerThread; //!< A thread for signalling the V-Sync event and measure the refresh cycle duration using AChoreographer
         ALooper *choreographerLooper{};
         i64 lastChoreographerTime{}; //!< The timestamp of the last invocation of Choreographer::doFrame
         i64 refreshCycleDuration{}; //!< The duration of a single refresh cycle for the display in nanoseconds
+        static constexpr i64 GuestRefreshCycleDuration{constant::NsInSecond / 60}; //!< The duration of a refresh cycle on the guest display, swap intervals are specified in terms of this
         bool choreographerStop{}; //!< If the Choreographer thread should stop on the next ALooper_wake()
 
         struct PresentableFrame {
@@ -68,16 +94,27 @@ namespace skyline::gpu {
             i64 swapInterval{}; //!< The interval between frames in terms of 60Hz display refreshes (1/60th of a second)
             std::function<void()> presentCallback; //!< A user-defined callback to use after presenting a frame
             size_t id{}; //!< The ID of this frame, it is used to correlate the frame in other operations
+            i64 inputTimestamp{}; //!< The timestamp of the oldest input event that was sampled for this frame in nanoseconds, 0 if there was none
 
             service::hosbinder::AndroidRect crop{};
             service::hosbinder::NativeWindowScalingMode scalingMode{};
             service::hosbinder::NativeWindowTransform transform{};
         };
 
+        /**
+         * @brief The strategy used for pacing frames, this corresponds to the frame pacing mode setting
+         */
+        enum class FramePacingMode : u32 {
+            Smoothest, //!< All frames are presented in order with timestamps that leave a refresh cycle of slack to avoid missing deadlines
+            LowestLatency, //!< Frames are targeted at the next refresh cycle and stale frames are dropped when newer frames are queued behind them
+        };
+
         std::thread presentationThread; //!< A thread for asynchronously presenting queued frames after their corresponded fences are signalled
         static constexpr size_t PresentQueueFrameCount{5}; //!< The amount of frames the presentation queue can hold
+        static constexpr size_t LowestLatencyMaxQueuedFrames{1}; //!< The maximum amount of frames in the presentation queue (including the one being presented) before the oldest one is dropped with the lowest latency pacing mode
         CircularQueue<PresentableFrame> presentQueue{PresentQueueFrameCount}; //!< A circular queue containing all the frames that we can present
         size_t nextFrameId{1}; //!< The frame ID to use for the next frame
+        i64 nextFrameInputTimestamp{}; //!< The input timestamp to use for the next frame, this is only accessed by the guest thread
 
         /**
          * @url https://developer.android.com/ndk/reference/group/choreographer#achoreographer_postframecallback64
@@ -89,6 +126,24 @@ namespace skyline::gpu {
          */
         void ChoreographerThread();
 
+        /**
+         * @brief The entry point for the V-Sync thread, signals the V-Sync event every guest refresh cycle scaled by the current emulation speed
+         */
+        void VsyncThread();
+
+        /**
+         * @return The amount of host display refreshes that correspond to the supplied amount of guest display refreshes
+         * @note This rounds down with some tolerance for refresh cycle jitter so frames are never paced slower than the guest intends, at 90Hz a swap interval of 1 will target every refresh rather than every other one
+         * @note The guest refresh cycle is scaled by the emulation speed, a swap interval of 1 at 50% speed on a 60Hz display targets every other refresh
+         */
+        i64 GetHostSwapInterval(i64 swapInterval);
+
+        /**
+         * @brief Blocks until the amount of frames in-flight on the GPU is below the in-flight frame limit and adjusts the limit based on how long that took
+         * @note This must be called prior to reusing the resources at `frameIndex`
+         */
+        void ThrottleInFlightFrames();
+
         /**
          * @brief Submits a single frame to the host API for presentation with the appropriate waits and copies
          */
@@ -126,6 +181,14 @@ namespace skyline::gpu {
          * @return The ID of this frame for correlating it with presentation timing readouts
          * @note The texture **must** be locked prior to calling this
          */
+        /**
+         * @brief Sets the timestamp of the oldest input event that the next presented frame was rendered with, the latency from it to the frame being presented is recorded
+         * @note This must only be called from the guest thread that calls Present
+         */
+        void SetNextFrameInputTimestamp(i64 timestamp) {
+            nextFrameInputTimestamp = timestamp;
+        }
+
         u64 Present(const std::shared_ptr<TextureView> &texture, i64 timestamp, i64 swapInterval, service::hosbinder::AndroidRect crop, service::hosbinder::NativeWindowScalingMode scalingMode, service::hosbinder::NativeWindowTransform transform, skyline::service::hosbinder::AndroidFence fence, const std::function<void()>& presentCallback);
 
         /**
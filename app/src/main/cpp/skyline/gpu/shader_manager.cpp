@@ -2,13 +2,16 @@
 // Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
 #include <range/v3/algorithm.hpp>
+#include <range/v3/view.hpp>
 #include <boost/functional/hash.hpp>
 #include <gpu.h>
+#include <common/settings.h>
 #include <shader_compiler/common/settings.h>
 #include <shader_compiler/common/log.h>
 #include <shader_compiler/frontend/maxwell/translate_program.h>
 #include <shader_compiler/backend/spirv/emit_spirv.h>
 #include <vulkan/vulkan_raii.hpp>
+#include "shaders/spirv_passes.h"
 #include "shader_manager.h"
 
 namespace Shader::Log {
@@ -26,7 +29,7 @@ namespace Shader::Log {
 }
 
 namespace skyline::gpu {
-    ShaderManager::ShaderManager(const DeviceState &state, GPU &gpu) : gpu{gpu} {
+    ShaderManager::ShaderManager(const DeviceState &state, GPU &gpu) : gpu{gpu}, diskCache{state, gpu}, optimizeSpirv{*state.settings->shaderOptimization} {
         auto &traits{gpu.traits};
         hostTranslateInfo = Shader::HostTranslateInfo{
             .support_float16 = traits.supportsFloat16,
@@ -142,6 +145,67 @@ namespace skyline::gpu {
         void Dump(u64 hash) final {}
     };
 
+    /**
+     * @brief A shader environment for compute shaders, these lack a shader program header so all state that would be derived from it is supplied by the QMD instead
+     */
+    class ComputeEnvironment : public Shader::Environment {
+      private:
+        span<u8> binary;
+        u32 baseOffset;
+        u32 textureBufferIndex;
+        std::array<u32, 3> workgroupDimensions;
+        u32 sharedMemorySize;
+        u32 localMemorySize;
+        ShaderManager::ConstantBufferRead constantBufferRead;
+        ShaderManager::GetTextureType getTextureType;
+
+      public:
+        std::vector<ShaderManager::ConstantBufferWord> constantBufferWords;
+        std::vector<ShaderManager::CachedTextureType> textureTypes;
+
+        ComputeEnvironment(span<u8> binary, u32 baseOffset, u32 textureBufferIndex, std::array<u32, 3> workgroupDimensions, u32 sharedMemorySize, u32 localMemorySize, ShaderManager::ConstantBufferRead constantBufferRead, ShaderManager::GetTextureType getTextureType) : binary{binary}, baseOffset{baseOffset}, textureBufferIndex{textureBufferIndex}, workgroupDimensions{workgroupDimensions}, sharedMemorySize{sharedMemorySize}, localMemorySize{localMemorySize}, constantBufferRead{std::move(constantBufferRead)}, getTextureType{std::move(getTextureType)} {
+            stage = Shader::Stage::Compute;
+            start_address = baseOffset;
+        }
+
+        [[nodiscard]] u64 ReadInstruction(u32 address) final {
+            address -= baseOffset;
+            if (binary.size() < (address + sizeof(u64)))
+                throw exception("Out of bounds instruction read: 0x{:X}", address);
+            return *reinterpret_cast<u64 *>(binary.data() + address);
+        }
+
+        [[nodiscard]] u32 ReadCbufValue(u32 index, u32 offset) final {
+            auto value{constantBufferRead(index, offset)};
+            constantBufferWords.emplace_back(index, offset, value);
+            return value;
+        }
+
+        [[nodiscard]] Shader::TextureType ReadTextureType(u32 handle) final {
+            auto type{getTextureType(handle)};
+            textureTypes.emplace_back(handle, type);
+            return type;
+        }
+
+        [[nodiscard]] u32 TextureBoundBuffer() const final {
+            return textureBufferIndex;
+        }
+
+        [[nodiscard]] u32 LocalMemorySize() const final {
+            return localMemorySize;
+        }
+
+        [[nodiscard]] u32 SharedMemorySize() const final {
+            return sharedMemorySize;
+        }
+
+        [[nodiscard]] std::array<u32, 3> WorkgroupSize() const final {
+            return workgroupDimensions;
+        }
+
+        void Dump(u64 hash) final {}
+    };
+
     /**
      * @brief A shader environment for VertexB during combination as it only requires the shader header and no higher level context
      */
@@ -183,46 +247,241 @@ namespace skyline::gpu {
         void Dump(u64 hash) final {}
     };
 
-    constexpr ShaderManager::ConstantBufferWord::ConstantBufferWord(u32 index, u32 offset, u32 value) : index(index), offset(offset), value(value) {}
+    /**
+     * @return The hash of a program translated from a binary with the supplied hash, this includes all constant buffer words and texture types read during translation as the program is only valid for that specific state
+     */
+    static u64 HashProgram(u64 binaryHash, span<const ShaderManager::ConstantBufferWord> constantBufferWords, span<const ShaderManager::CachedTextureType> textureTypes) {
+        u64 programHash{binaryHash};
+        #define HASH(x) boost::hash_combine(programHash, x)
+
+        for (const auto &word : constantBufferWords) {
+            HASH(word.index);
+            HASH(word.offset);
+            HASH(word.value);
+        }
 
-    constexpr ShaderManager::CachedTextureType::CachedTextureType(u32 handle, Shader::TextureType type) : handle(handle), type(type) {}
+        for (const auto &textureType : textureTypes) {
+            HASH(textureType.handle);
+            HASH(static_cast<u32>(textureType.type));
+        }
+
+        #undef HASH
+        return programHash;
+    }
+
+    /**
+     * @brief Looks up a program translated from a binary with the supplied hash in the shader cache, a cached program is only used if every read it was translated with yields the same value in the current state
+     * @note Translation is deterministic, so if all recorded reads match then translating the binary again would perform the exact same reads and yield the same program
+     */
+    static std::optional<Shader::IR::Program> LookupCachedProgram(cache::ShaderCache &diskCache, u64 binaryHash, const ShaderManager::ConstantBufferRead &constantBufferRead, const ShaderManager::GetTextureType &getTextureType, u64 &programHash) {
+        for (auto entry : diskCache.LookupPrograms(binaryHash)) {
+            if (!ranges::all_of(entry->constantBufferWords, [&](const auto &word) { return constantBufferRead(word.index, word.offset) == word.value; }))
+                continue;
+
+            if (!ranges::all_of(entry->textureTypes, [&](const auto &textureType) { return getTextureType(textureType.handle) == textureType.type; }))
+                continue;
 
-    Shader::IR::Program ShaderManager::ParseGraphicsShader(const std::array<u32, 8> &postVtgShaderAttributeSkipMask, Shader::Stage stage, span<u8> binary, u32 baseOffset, u32 textureConstantBufferIndex, const ConstantBufferRead &constantBufferRead, const GetTextureType &getTextureType) {
-        std::scoped_lock lock{poolMutex};
+            programHash = HashProgram(binaryHash, entry->constantBufferWords, entry->textureTypes);
+            return entry->programInfo.MakeProgram();
+        }
+        return std::nullopt;
+    }
+
+    Shader::IR::Program ShaderManager::ParseGraphicsShader(const std::array<u32, 8> &postVtgShaderAttributeSkipMask, Shader::Stage stage, span<u8> binary, u32 baseOffset, u32 textureConstantBufferIndex, const ConstantBufferRead &constantBufferRead, const GetTextureType &getTextureType, u64 &programHash, bool allowCached) {
+        // The hash must be stable across sessions as it's used as a key in the persistent shader cache
+        #define HASH(x) boost::hash_combine(binaryHash, x)
+
+        u64 binaryHash{XXH64(binary.data(), binary.size_bytes(), 0)};
+        HASH(static_cast<u32>(stage));
+        HASH(baseOffset);
+        HASH(textureConstantBufferIndex);
+        for (auto mask : postVtgShaderAttributeSkipMask)
+            HASH(mask);
 
+        #undef HASH
+
+        if (allowCached)
+            if (auto program{LookupCachedProgram(diskCache, binaryHash, constantBufferRead, getTextureType, programHash)})
+                return std::move(*program);
+
+        auto &pools{GetThreadPools()};
         GraphicsEnvironment environment{postVtgShaderAttributeSkipMask, stage, binary, baseOffset, textureConstantBufferIndex, constantBufferRead, getTextureType};
-        Shader::Maxwell::Flow::CFG cfg{environment, flowBlockPool, Shader::Maxwell::Location{static_cast<u32>(baseOffset + sizeof(Shader::ProgramHeader))}};
-        return  Shader::Maxwell::TranslateProgram(instructionPool, blockPool, environment, cfg, hostTranslateInfo);
+        Shader::Maxwell::Flow::CFG cfg{environment, pools.flowBlockPool, Shader::Maxwell::Location{static_cast<u32>(baseOffset + sizeof(Shader::ProgramHeader))}};
+        auto program{Shader::Maxwell::TranslateProgram(pools.instructionPool, pools.blockPool, environment, cfg, hostTranslateInfo)};
+
+        programHash = HashProgram(binaryHash, environment.constantBufferWords, environment.textureTypes);
+        diskCache.InsertProgram(binaryHash, {std::move(environment.constantBufferWords), std::move(environment.textureTypes), {program.stage, program.output_topology, program.is_geometry_passthrough, program.info}});
+
+        return program;
     }
 
-    Shader::IR::Program ShaderManager::CombineVertexShaders(Shader::IR::Program &vertexA, Shader::IR::Program &vertexB, span<u8> vertexBBinary) {
-        std::scoped_lock lock{poolMutex};
+    Shader::IR::Program ShaderManager::ParseComputeShader(span<u8> binary, u32 baseOffset, u32 textureConstantBufferIndex, std::array<u32, 3> workgroupDimensions, u32 sharedMemorySize, u32 localMemorySize, const ConstantBufferRead &constantBufferRead, const GetTextureType &getTextureType, u64 &programHash, bool allowCached) {
+        #define HASH(x) boost::hash_combine(binaryHash, x)
+
+        u64 binaryHash{XXH64(binary.data(), binary.size_bytes(), 0)};
+        HASH(static_cast<u32>(Shader::Stage::Compute));
+        HASH(baseOffset);
+        HASH(textureConstantBufferIndex);
+        for (auto dimension : workgroupDimensions)
+            HASH(dimension);
+        HASH(sharedMemorySize);
+        HASH(localMemorySize);
+
+        #undef HASH
+
+        if (allowCached)
+            if (auto program{LookupCachedProgram(diskCache, binaryHash, constantBufferRead, getTextureType, programHash)})
+                return std::move(*program);
+
+        auto &pools{GetThreadPools()};
+        ComputeEnvironment environment{binary, baseOffset, textureConstantBufferIndex, workgroupDimensions, sharedMemorySize, localMemorySize, constantBufferRead, getTextureType};
+        Shader::Maxwell::Flow::CFG cfg{environment, pools.flowBlockPool, Shader::Maxwell::Location{baseOffset}};
+        auto program{Shader::Maxwell::TranslateProgram(pools.instructionPool, pools.blockPool, environment, cfg, hostTranslateInfo)};
+
+        programHash = HashProgram(binaryHash, environment.constantBufferWords, environment.textureTypes);
+        diskCache.InsertProgram(binaryHash, {std::move(environment.constantBufferWords), std::move(environment.textureTypes), {program.stage, program.output_topology, program.is_geometry_passthrough, program.info}});
 
+        return program;
+    }
+
+    Shader::IR::Program ShaderManager::CombineVertexShaders(Shader::IR::Program &vertexA, Shader::IR::Program &vertexB, span<u8> vertexBBinary) {
         VertexBEnvironment env{vertexBBinary};
         return Shader::Maxwell::MergeDualVertexPrograms(vertexA, vertexB, env);
     }
 
-    vk::ShaderModule ShaderManager::CompileShader(Shader::RuntimeInfo &runtimeInfo, Shader::IR::Program &program, Shader::Backend::Bindings &bindings) {
-        std::scoped_lock lock{poolMutex};
+    /**
+     * @return A hash of all runtime state that affects the SPIR-V emitted for a program alongside the bindings the program is emitted with
+     */
+    static u64 HashRuntimeState(u64 programHash, const Shader::RuntimeInfo &runtimeInfo, const Shader::Backend::Bindings &bindings, const std::optional<ShaderManager::PushConstantPromotion> &promotion, bool optimized, bool emulateTransformFeedback) {
+        u64 hash{programHash};
+        #define HASH(x) boost::hash_combine(hash, x)
+
+        for (auto type : runtimeInfo.generic_input_types)
+            HASH(static_cast<u32>(type));
+
+        HASH(std::hash<decltype(runtimeInfo.previous_stage_stores.mask)>{}(runtimeInfo.previous_stage_stores.mask));
+        HASH(runtimeInfo.convert_depth_mode);
+        HASH(runtimeInfo.force_early_z);
+        HASH(static_cast<u32>(runtimeInfo.tess_primitive));
+        HASH(static_cast<u32>(runtimeInfo.tess_spacing));
+        HASH(runtimeInfo.tess_clockwise);
+        HASH(static_cast<u32>(runtimeInfo.input_topology));
+        HASH(runtimeInfo.y_negate);
+
+        HASH(runtimeInfo.fixed_state_point_size.has_value());
+        if (runtimeInfo.fixed_state_point_size)
+            HASH(*runtimeInfo.fixed_state_point_size);
+
+        HASH(runtimeInfo.alpha_test_func.has_value());
+        if (runtimeInfo.alpha_test_func) {
+            HASH(static_cast<u32>(*runtimeInfo.alpha_test_func));
+            HASH(runtimeInfo.alpha_test_reference);
+        }
+
+        HASH(runtimeInfo.xfb_varyings.size());
+        for (const auto &varying : runtimeInfo.xfb_varyings) {
+            HASH(varying.buffer);
+            HASH(varying.stride);
+            HASH(varying.offset);
+            HASH(varying.components);
+        }
+
+        HASH(bindings.unified);
+        HASH(bindings.uniform_buffer);
+        HASH(bindings.storage_buffer);
+        HASH(bindings.texture);
+        HASH(bindings.image);
+        HASH(bindings.texture_scaling_index);
+        HASH(bindings.image_scaling_index);
+
+        // Shaders without any promotion hash identically to those from prior to it being supported, so their cached SPIR-V remains valid
+        if (promotion) {
+            HASH(promotion->binding);
+            HASH(promotion->offset);
+            HASH(promotion->size);
+        }
+
+        // Optimized shaders are cached separately from unoptimized ones so toggling optimization doesn't require clearing the cache
+        if (optimized)
+            HASH(optimized);
+
+        if (emulateTransformFeedback)
+            HASH(emulateTransformFeedback);
+
+        #undef HASH
+        return hash;
+    }
+
+    vk::ShaderModule ShaderManager::GetShaderModule(u64 hash, span<const u32> spirv) {
+        std::scoped_lock lock{moduleMutex};
+
+        auto it{shaderModules.find(hash)};
+        if (it == shaderModules.end())
+            it = shaderModules.emplace(hash, vk::raii::ShaderModule{gpu.vkDevice, vk::ShaderModuleCreateInfo{
+                .pCode = spirv.data(),
+                .codeSize = spirv.size_bytes(),
+            }}).first;
+
+        return *it->second;
+    }
+
+    ShaderManager::CompiledShader ShaderManager::CompileShader(Shader::RuntimeInfo &runtimeInfo, Shader::IR::Program &program, Shader::Backend::Bindings &bindings, u64 programHash, std::optional<PushConstantPromotion> promotion, bool emulateTransformFeedback) {
+        // No lock is required as the IR is only ever accessed by the thread which translated it and the caches are synchronized internally
+        // The hash is of the state prior to the conversion of legacy attributes, the conversion only depends on the program and the runtime state that's already hashed
+        u64 cacheHash{HashRuntimeState(programHash, runtimeInfo, bindings, promotion, optimizeSpirv, emulateTransformFeedback)};
+        if (auto entry{diskCache.Lookup(cacheHash)}) {
+            // SPIR-V emission would've advanced the bindings, we need to replicate that for any subsequent stages
+            bindings = entry->bindings;
+            // The cached info includes any conversion of legacy attributes, it's what subsequent stages and the pipeline are derived from
+            program.info = entry->info;
+            // Emitted shaders never have a push constant block of their own, so its presence in the cached SPIR-V tells if the promotion or emulation succeeded
+            bool hasPushConstants{spirv::HasPushConstantBlock(entry->spirv)};
+            return {GetShaderModule(cacheHash, entry->spirv), cacheHash, promotion && hasPushConstants, emulateTransformFeedback && hasPushConstants};
+        }
+
+        if (program.blocks.empty())
+            return {}; // A cached program has no IR to emit SPIR-V from, the caller must translate it again
 
         if (program.info.loads.Legacy() || program.info.stores.Legacy())
             Shader::Maxwell::ConvertLegacyToGeneric(program, runtimeInfo);
 
         auto spirv{Shader::Backend::SPIRV::EmitSPIRV(profile, runtimeInfo, program, bindings)};
+        bool promoted{promotion && spirv::PromoteUniformBufferToPushConstants(spirv, promotion->binding, promotion->offset, promotion->size)};
+        bool emulated{emulateTransformFeedback && !promotion && spirv::EmulateTransformFeedback(spirv, bindings.unified)};
+        if (optimizeSpirv)
+            spirv::OptimizeModule(spirv); // This is only done on cache misses as the optimized SPIR-V is what's cached
+        diskCache.Insert(cacheHash, spirv, bindings, program.info);
 
-        vk::ShaderModuleCreateInfo createInfo{
-            .pCode = spirv.data(),
-            .codeSize = spirv.size() * sizeof(u32),
-        };
-
-        return (*gpu.vkDevice).createShaderModule(createInfo, nullptr, *gpu.vkDevice.getDispatcher());
+        return {GetShaderModule(cacheHash, spirv), cacheHash, promoted, emulated};
     }
 
-    void ShaderManager::ResetPools() {
-        std::scoped_lock lock{poolMutex};
+    vk::ShaderModule ShaderManager::GetCachedShaderModule(u64 hash) {
+        if (auto entry{diskCache.Lookup(hash)})
+            return GetShaderModule(hash, entry->spirv);
+        return {};
+    }
 
+    void ShaderManager::ObjectPools::ReleaseContents() {
         instructionPool.ReleaseContents();
         blockPool.ReleaseContents();
         flowBlockPool.ReleaseContents();
     }
+
+    ShaderManager::ObjectPools &ShaderManager::GetThreadPools() {
+        std::scoped_lock lock{poolsMutex};
+        auto &pools{threadPools[std::this_thread::get_id()]};
+        if (!pools)
+            pools = std::make_unique<ObjectPools>();
+        return *pools;
+    }
+
+    void ShaderManager::ResetPools() {
+        GetThreadPools().ReleaseContents();
+    }
+
+    void ShaderManager::TrimPools() {
+        std::scoped_lock lock{poolsMutex};
+        for (auto &pools : threadPools | ranges::views::values)
+            pools->ReleaseContents();
+    }
 }
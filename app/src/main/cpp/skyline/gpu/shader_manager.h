@@ -3,7 +3,7 @@
 
 #pragma once
 
-#include <vulkan/vulkan.hpp>
+#include <vulkan/vulkan_raii.hpp>
 #include <shader_compiler/object_pool.h>
 #include <shader_compiler/frontend/maxwell/control_flow.h>
 #include <shader_compiler/frontend/ir/value.h>
@@ -14,6 +14,7 @@
 #include <shader_compiler/runtime_info.h>
 #include <shader_compiler/backend/bindings.h>
 #include <common.h>
+#include "cache/shader_cache.h"
 
 namespace skyline::gpu {
     /**
@@ -24,53 +25,112 @@ namespace skyline::gpu {
         GPU &gpu;
         Shader::HostTranslateInfo hostTranslateInfo;
         Shader::Profile profile;
-        Shader::ObjectPool<Shader::Maxwell::Flow::Block> flowBlockPool;
-        Shader::ObjectPool<Shader::IR::Inst> instructionPool;
-        Shader::ObjectPool<Shader::IR::Block> blockPool;
-        std::mutex poolMutex;
-
-      public:
-        using ConstantBufferRead = std::function<u32(u32 index, u32 offset)>; //!< A function which reads a constant buffer at the specified offset and returns the value
 
         /**
-         * @brief A single u32 word from a constant buffer with the offset it was read from, utilized to ensure constant buffer state is consistent
+         * @brief The object pools that the IR of programs is allocated from, every thread has its own set so translation on one thread doesn't block it on others
          */
-        struct ConstantBufferWord {
-            u32 index; //!< The index of the constant buffer
-            u32 offset; //!< The offset of the constant buffer word
-            u32 value; //!< The contents of the word
+        struct ObjectPools {
+            Shader::ObjectPool<Shader::Maxwell::Flow::Block> flowBlockPool;
+            Shader::ObjectPool<Shader::IR::Inst> instructionPool;
+            Shader::ObjectPool<Shader::IR::Block> blockPool;
 
-            constexpr ConstantBufferWord(u32 index, u32 offset, u32 value);
-
-            constexpr bool operator==(const ConstantBufferWord &other) const = default;
+            void ReleaseContents();
         };
 
-        using GetTextureType = std::function<Shader::TextureType(u32 handle)>; //!< A function which determines the type of a texture from its handle by checking the corresponding TIC
+        std::mutex poolsMutex; //!< Synchronizes access to threadPools, this is only held while looking up the pools of a thread
+        std::unordered_map<std::thread::id, std::unique_ptr<ObjectPools>> threadPools; //!< The object pools of every thread which has translated shaders, these are owned by the manager rather than being thread_local so they can be trimmed from any thread
+        cache::ShaderCache diskCache; //!< A persistent cache of SPIR-V shaders keyed by the guest shader and all state it depends on
+        bool optimizeSpirv; //!< If emitted SPIR-V should be optimized with spirv::OptimizeModule before being cached
+        std::mutex moduleMutex; //!< Synchronizes access to the shader module cache
+        std::unordered_map<u64, vk::raii::ShaderModule> shaderModules; //!< A map from the shader cache hash of a shader to its module, this deduplicates modules so that pipelines using identical shaders have matching pipeline cache keys
+
+        /**
+         * @return The shader module for the supplied hash, it is created from the supplied SPIR-V if it doesn't exist yet
+         */
+        vk::ShaderModule GetShaderModule(u64 hash, span<const u32> spirv);
+
+        /**
+         * @return The object pools of the calling thread, they are created on the first call from a thread
+         */
+        ObjectPools &GetThreadPools();
 
-        struct CachedTextureType {
-            u32 handle;
-            Shader::TextureType type;
+      public:
+        using ConstantBufferRead = std::function<u32(u32 index, u32 offset)>; //!< A function which reads a constant buffer at the specified offset and returns the value
 
-            constexpr CachedTextureType(u32 handle, Shader::TextureType type);
+        using ConstantBufferWord = cache::ConstantBufferWord;
 
-            constexpr bool operator==(const CachedTextureType &other) const = default;
-        };
+        using GetTextureType = std::function<Shader::TextureType(u32 handle)>; //!< A function which determines the type of a texture from its handle by checking the corresponding TIC
+
+        using CachedTextureType = cache::CachedTextureType;
 
         ShaderManager(const DeviceState &state, GPU &gpu);
 
         /**
+         * @param programHash A hash of the guest binary and all state read from the environment during translation, this is required for looking the program up in the shader cache during compilation
+         * @param allowCached If a program from the shader cache can be returned in place of translating the shader, this must be false if the IR of the program is required
          * @return A shader program that corresponds to all the supplied state including the current state of the constant buffers
+         * @note A cached program has no IR, it only has the state required for compiling it from cached SPIR-V with CompileShader
          */
-        Shader::IR::Program ParseGraphicsShader(const std::array<u32, 8> &postVtgShaderAttributeSkipMask, Shader::Stage stage, span<u8> binary, u32 baseOffset, u32 textureConstantBufferIndex, const ConstantBufferRead &constantBufferRead, const GetTextureType &getTextureType);
+        Shader::IR::Program ParseGraphicsShader(const std::array<u32, 8> &postVtgShaderAttributeSkipMask, Shader::Stage stage, span<u8> binary, u32 baseOffset, u32 textureConstantBufferIndex, const ConstantBufferRead &constantBufferRead, const GetTextureType &getTextureType, u64 &programHash, bool allowCached = true);
+
+        /**
+         * @param workgroupDimensions The dimensions of a single workgroup (CTA) of the compute shader
+         * @param sharedMemorySize The amount of shared memory used by the shader in bytes
+         * @param localMemorySize The amount of local memory used by the shader in bytes
+         * @param programHash A hash of the guest binary and all state read from the environment during translation, this is used in the same way as with ParseGraphicsShader
+         * @param allowCached If a program from the shader cache can be returned, this is the same as with ParseGraphicsShader
+         * @note Compute shaders don't have a shader program header, so all state that would be derived from it must be supplied from the QMD
+         */
+        Shader::IR::Program ParseComputeShader(span<u8> binary, u32 baseOffset, u32 textureConstantBufferIndex, std::array<u32, 3> workgroupDimensions, u32 sharedMemorySize, u32 localMemorySize, const ConstantBufferRead &constantBufferRead, const GetTextureType &getTextureType, u64 &programHash, bool allowCached = true);
 
         /**
          * @brief Combines the VertexA and VertexB shader programs into a single program
          * @note VertexA/VertexB shader programs must be SingleShaderProgram and not DualVertexShaderProgram
+         * @note Both programs must have been translated, cached programs can't be combined
          */
         Shader::IR::Program CombineVertexShaders(Shader::IR::Program &vertexA, Shader::IR::Program &vertexB, span<u8> vertexBBinary);
 
-        vk::ShaderModule CompileShader(Shader::RuntimeInfo &runtimeInfo, Shader::IR::Program &program, Shader::Backend::Bindings &bindings);
+        /**
+         * @brief A uniform buffer that should be supplied through push constants rather than a descriptor, see spirv::PromoteUniformBufferToPushConstants
+         */
+        struct PushConstantPromotion {
+            u32 binding; //!< The binding of the uniform buffer in the emitted module
+            u32 offset; //!< The offset of the buffer's contents in the push constant range of the pipeline
+            u32 size; //!< The size of the range of the buffer that's used by the shader
+        };
+
+        struct CompiledShader {
+            vk::ShaderModule module;
+            u64 hash; //!< A hash that uniquely identifies the shader in the shader cache, this can be used to look up the module with GetCachedShaderModule
+            bool promotedToPushConstants; //!< If the uniform buffer requested to be promoted to push constants was promoted, it must be bound as a regular uniform buffer otherwise
+            bool emulatesTransformFeedback; //!< If the shader writes its captured outputs to storage buffers, see spirv::EmulateTransformFeedback
+        };
+
+        /**
+         * @param programHash The hash of the program as returned by ParseGraphicsShader, the shader cache is checked for a matching shader prior to emitting SPIR-V
+         * @param promotion A uniform buffer that should be promoted to push constants if possible
+         * @param emulateTransformFeedback If the outputs captured by transform feedback in `runtimeInfo` should be written to storage buffers at `bindings.unified` onwards rather than using the host feature, this is mutually exclusive with a promotion
+         * @return The compiled shader, the module is a null handle if the program is a cached one without IR and its SPIR-V isn't cached for the supplied state, the program must then be translated and compiled again
+         * @note The info of the program is replaced with that of the cached shader on a hit, this includes the conversion of legacy attributes
+         */
+        CompiledShader CompileShader(Shader::RuntimeInfo &runtimeInfo, Shader::IR::Program &program, Shader::Backend::Bindings &bindings, u64 programHash, std::optional<PushConstantPromotion> promotion = std::nullopt, bool emulateTransformFeedback = false);
 
+        /**
+         * @param hash The hash of the shader as returned by CompileShader in a previous run
+         * @return The shader module for the shader with the supplied hash or a null handle if it isn't present in the shader cache
+         * @note This allows for recreating pipelines without access to the guest shaders
+         */
+        vk::ShaderModule GetCachedShaderModule(u64 hash);
+
+        /**
+         * @brief Releases the contents of the IR pools of the calling thread, this must be done prior to translating the shaders of a pipeline and invalidates all programs previously translated on the thread
+         */
         void ResetPools();
+
+        /**
+         * @brief Releases the contents of the IR pools of all threads to reclaim memory
+         * @note This must only be called while no shaders are being translated or compiled on any thread
+         */
+        void TrimPools();
     };
 }
@@ -5,43 +5,79 @@
 #include <gpu/descriptor_allocator.h>
 #include <gpu/texture/texture.h>
 #include <gpu/cache/graphics_pipeline_cache.h>
-#include <vfs/filesystem.h>
 #include "helper_shaders.h"
 
 namespace skyline::gpu {
-    static vk::raii::ShaderModule CreateShaderModule(GPU &gpu, vfs::Backing &shaderBacking) {
-        std::vector<u32> shaderBuf(shaderBacking.size / 4);
+    /**
+     * @brief The SPIR-V of all helper shaders, these are compiled from the GLSL sources in the 'glsl' directory at build time
+     */
+    namespace spirv {
+        constexpr static u32 BlitVertex[]{
+            #include "blit.vert.spv.inc"
+        };
+
+        constexpr static u32 BlitFragment[]{
+            #include "blit.frag.spv.inc"
+        };
+
+        constexpr static u32 Deswizzle[]{
+            #include "deswizzle.comp.spv.inc"
+        };
+
+        constexpr static u32 Swizzle[]{
+            #include "swizzle.comp.spv.inc"
+        };
+
+        constexpr static u32 Quads[]{
+            #include "quads.comp.spv.inc"
+        };
 
-        if (shaderBacking.Read(span(shaderBuf)) != shaderBacking.size)
-            throw exception("Failed to read shader");
+        constexpr static u32 Indices[]{
+            #include "indices.comp.spv.inc"
+        };
+    }
 
+    static vk::raii::ShaderModule CreateShaderModule(GPU &gpu, span<const u32> code) {
         return gpu.vkDevice.createShaderModule(
             {
-                .pCode = shaderBuf.data(),
-                .codeSize = shaderBacking.size,
+                .pCode = code.data(),
+                .codeSize = code.size_bytes(),
             }
         );
     }
 
-    SimpleColourRTShader::SimpleColourRTShader(GPU &gpu, std::shared_ptr<vfs::Backing> vertexShader, std::shared_ptr<vfs::Backing> fragmentShader)
-        : vertexShaderModule{CreateShaderModule(gpu, *vertexShader)},
-          fragmentShaderModule{CreateShaderModule(gpu, *fragmentShader)},
-          shaderStages{{
-                           vk::PipelineShaderStageCreateInfo{
-                               .stage = vk::ShaderStageFlagBits::eVertex,
-                               .pName = "main",
-                               .module = *vertexShaderModule
-                           },
-                           vk::PipelineShaderStageCreateInfo{
-                               .stage = vk::ShaderStageFlagBits::eFragment,
-                               .pName = "main",
-                               .module = *fragmentShaderModule
-                           }}
-          } {}
+    SimpleColourRTShader::SimpleColourRTShader(span<const u32> vertexShaderCode, span<const u32> fragmentShaderCode)
+        : vertexShaderCode{vertexShaderCode},
+          fragmentShaderCode{fragmentShaderCode} {}
 
     cache::GraphicsPipelineCache::CompiledPipeline SimpleColourRTShader::GetPipeline(GPU &gpu,
                                                                                      TextureView *colorAttachment,
                                                                                      span<const vk::DescriptorSetLayoutBinding> layoutBindings, span<const vk::PushConstantRange> pushConstantRanges) {
+        cache::GraphicsPipelineCache::AttachmentState colorAttachmentState{colorAttachment};
+
+        // All other state is static or dynamic, so the format and sample count of the attachment are the only parts of the pipeline that vary
+        u64 pipelineKey{(static_cast<u64>(colorAttachmentState.format) << 32) | static_cast<u64>(colorAttachmentState.sampleCount)};
+        std::scoped_lock lock{mutex};
+        if (auto it{pipelines.find(pipelineKey)}; it != pipelines.end())
+            return it->second;
+
+        if (!*vertexShaderModule) {
+            vertexShaderModule = CreateShaderModule(gpu, vertexShaderCode);
+            fragmentShaderModule = CreateShaderModule(gpu, fragmentShaderCode);
+            shaderStages = {
+                vk::PipelineShaderStageCreateInfo{
+                    .stage = vk::ShaderStageFlagBits::eVertex,
+                    .pName = "main",
+                    .module = *vertexShaderModule
+                },
+                vk::PipelineShaderStageCreateInfo{
+                    .stage = vk::ShaderStageFlagBits::eFragment,
+                    .pName = "main",
+                    .module = *fragmentShaderModule
+                }
+            };
+        }
+
         constexpr static vk::PipelineInputAssemblyStateCreateInfo inputAssemblyState{
             .topology = vk::PrimitiveTopology::eTriangleList,
             .primitiveRestartEnable = false
@@ -65,8 +101,8 @@ namespace skyline::gpu {
             }
         };
 
-        constexpr static vk::PipelineMultisampleStateCreateInfo multisampleState{
-            .rasterizationSamples = vk::SampleCountFlagBits::e1,
+        vk::PipelineMultisampleStateCreateInfo multisampleState{
+            .rasterizationSamples = colorAttachmentState.sampleCount,
             .sampleShadingEnable = false,
             .minSampleShading = 1.0f,
             .alphaToCoverageEnable = false,
@@ -100,29 +136,23 @@ namespace skyline::gpu {
 
         vertexState.unlink<vk::PipelineVertexInputDivisorStateCreateInfoEXT>();
 
-        auto colourAttachmentDimensions{colorAttachment->texture->dimensions};
-
-        vk::Viewport viewport{
-            .height = static_cast<float>(colourAttachmentDimensions.height),
-            .width = static_cast<float>(colourAttachmentDimensions.width),
-            .x = 0.0f,
-            .y = 0.0f,
-            .minDepth = 0.0f,
-            .maxDepth = 1.0f
-        };
-
-        vk::Rect2D scissor{
-            .extent = colourAttachmentDimensions
-        };
-
-        vk::PipelineViewportStateCreateInfo viewportState{
-            .pViewports = &viewport,
+        // The viewport and scissor are dynamic so that a single pipeline can be used for attachments of any size
+        constexpr static vk::Viewport emptyViewport{};
+        constexpr static vk::Rect2D emptyScissor{};
+        constexpr static vk::PipelineViewportStateCreateInfo viewportState{
+            .pViewports = &emptyViewport,
             .viewportCount = 1,
-            .pScissors = &scissor,
+            .pScissors = &emptyScissor,
             .scissorCount = 1
         };
 
-        return gpu.graphicsPipelineCache.GetCompiledPipeline(cache::GraphicsPipelineCache::PipelineState{
+        constexpr static std::array<vk::DynamicState, 2> dynamicStates{vk::DynamicState::eViewport, vk::DynamicState::eScissor};
+        constexpr static vk::PipelineDynamicStateCreateInfo dynamicState{
+            .dynamicStateCount = static_cast<u32>(dynamicStates.size()),
+            .pDynamicStates = dynamicStates.data()
+        };
+
+        auto pipeline{gpu.graphicsPipelineCache.GetCompiledPipeline(cache::GraphicsPipelineCache::PipelineState{
             .shaderStages = shaderStages,
             .vertexState = vertexState,
             .inputAssemblyState = inputAssemblyState,
@@ -132,10 +162,12 @@ namespace skyline::gpu {
             .multisampleState = multisampleState,
             .depthStencilState = depthStencilState,
             .colorBlendState = blendState,
-            .dynamicState = {},
-            .colorAttachments = span<TextureView *>{colorAttachment},
+            .dynamicState = dynamicState,
+            .colorAttachments = span<const cache::GraphicsPipelineCache::AttachmentState>{colorAttachmentState},
             .depthStencilAttachment = nullptr,
-        }, layoutBindings, pushConstantRanges, true);
+        }, layoutBindings, pushConstantRanges, true)};
+        pipelines.emplace(pipelineKey, pipeline);
+        return pipeline;
     }
 
     namespace glsl {
@@ -176,8 +208,8 @@ namespace skyline::gpu {
         };
     };
 
-    BlitHelperShader::BlitHelperShader(GPU &gpu, std::shared_ptr<vfs::FileSystem> shaderFileSystem)
-        : SimpleColourRTShader{gpu, shaderFileSystem->OpenFile("shaders/blit.vert.spv"), shaderFileSystem->OpenFile("shaders/blit.frag.spv")},
+    BlitHelperShader::BlitHelperShader(GPU &gpu)
+        : SimpleColourRTShader{spirv::BlitVertex, spirv::BlitFragment},
           bilinearSampler{gpu.vkDevice.createSampler(
               vk::SamplerCreateInfo{
                   .addressModeU = vk::SamplerAddressMode::eRepeat,
@@ -250,9 +282,17 @@ namespace skyline::gpu {
 
         gpu.vkDevice.updateDescriptorSets(writes, nullptr);
 
-        recordCb([drawState = std::move(drawState)](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &gpu, vk::RenderPass, u32) {
+        vk::Extent2D dstAttachmentDimensions{dstImageView->texture->dimensions};
+        recordCb([drawState = std::move(drawState), dstAttachmentDimensions](vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<FenceCycle> &cycle, GPU &gpu, vk::RenderPass, u32) {
             cycle->AttachObject(drawState);
             commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, drawState->pipeline.pipeline);
+            commandBuffer.setViewport(0, vk::Viewport{
+                .width = static_cast<float>(dstAttachmentDimensions.width),
+                .height = static_cast<float>(dstAttachmentDimensions.height),
+                .minDepth = 0.0f,
+                .maxDepth = 1.0f
+            });
+            commandBuffer.setScissor(0, vk::Rect2D{.extent = dstAttachmentDimensions});
             commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, drawState->pipeline.pipelineLayout, 0, *drawState->descriptorSet, nullptr);
             commandBuffer.pushConstants(drawState->pipeline.pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0,
                                         vk::ArrayProxy<const blit::VertexPushConstantLayout>{drawState->vertexPushConstants});
@@ -263,7 +303,291 @@ namespace skyline::gpu {
 
     }
 
-    HelperShaders::HelperShaders(GPU &gpu, std::shared_ptr<vfs::FileSystem> shaderFileSystem)
-        : blitHelperShader(gpu, std::move(shaderFileSystem)) {}
+    namespace deswizzle {
+        struct PushConstantLayout {
+            u32 widthWords;
+            u32 height;
+            u32 robWidthGobs;
+            u32 blockHeightLog2;
+            u32 srcOffset;
+            u32 srcLayerStride;
+            u32 dstOffset;
+            u32 dstLayerStride;
+        };
+
+        constexpr static vk::PushConstantRange PushConstantRange{
+            .stageFlags = vk::ShaderStageFlagBits::eCompute,
+            .size = sizeof(PushConstantLayout),
+            .offset = 0
+        };
+
+        constexpr static std::array<vk::DescriptorSetLayoutBinding, 2> LayoutBindings{
+            vk::DescriptorSetLayoutBinding{
+                .binding = 0,
+                .descriptorType = vk::DescriptorType::eStorageBuffer,
+                .descriptorCount = 1,
+                .stageFlags = vk::ShaderStageFlagBits::eCompute
+            }, vk::DescriptorSetLayoutBinding{
+                .binding = 1,
+                .descriptorType = vk::DescriptorType::eStorageBuffer,
+                .descriptorCount = 1,
+                .stageFlags = vk::ShaderStageFlagBits::eCompute
+            }
+        };
+
+        constexpr static u32 WorkgroupWidth{32}, WorkgroupHeight{8}; //!< The dimensions of a workgroup, these must match the local size in the shader
+        constexpr static u32 GobWidth{64}; //!< The width of a GOB in bytes
+        constexpr static u32 GobHeight{8}; //!< The height of a GOB in lines
+    }
+
+    DeswizzleHelperShader::DeswizzleHelperShader(GPU &gpu)
+        : descriptorSetLayout{gpu.vkDevice, vk::DescriptorSetLayoutCreateInfo{
+              .pBindings = deswizzle::LayoutBindings.data(),
+              .bindingCount = static_cast<u32>(deswizzle::LayoutBindings.size()),
+          }},
+          pipelineLayout{gpu.vkDevice, vk::PipelineLayoutCreateInfo{
+              .pSetLayouts = &*descriptorSetLayout,
+              .setLayoutCount = 1,
+              .pPushConstantRanges = &deswizzle::PushConstantRange,
+              .pushConstantRangeCount = 1,
+          }},
+          storageBufferAlignment{gpu.vkPhysicalDevice.getProperties().limits.minStorageBufferOffsetAlignment} {}
+
+    /**
+     * @brief Compiles a compute pipeline from the supplied SPIR-V, the shader module is only required during compilation so it's destroyed right after
+     */
+    static vk::raii::Pipeline CreateComputePipeline(GPU &gpu, span<const u32> code, vk::PipelineLayout layout) {
+        auto shaderModule{CreateShaderModule(gpu, code)};
+        return gpu.graphicsPipelineCache.CreateComputePipeline(vk::ComputePipelineCreateInfo{
+            .stage = {
+                .stage = vk::ShaderStageFlagBits::eCompute,
+                .pName = "main",
+                .module = *shaderModule
+            },
+            .layout = layout,
+        });
+    }
+
+    void DeswizzleHelperShader::EnsurePipelines(GPU &gpu) {
+        std::call_once(pipelineFlag, [&] {
+            pipeline = CreateComputePipeline(gpu, spirv::Deswizzle, *pipelineLayout);
+            swizzlePipeline = CreateComputePipeline(gpu, spirv::Swizzle, *pipelineLayout);
+        });
+    }
+
+    std::shared_ptr<void> DeswizzleHelperShader::Deswizzle(GPU &gpu, const vk::raii::CommandBuffer &commandBuffer, vk::DescriptorBufferInfo blockLinearBuffer, vk::DescriptorBufferInfo linearBuffer, span<const Level> levels) {
+        EnsurePipelines(gpu);
+        return Dispatch(gpu, commandBuffer, *pipeline, blockLinearBuffer, linearBuffer, levels);
+    }
+
+    std::shared_ptr<void> DeswizzleHelperShader::Swizzle(GPU &gpu, const vk::raii::CommandBuffer &commandBuffer, vk::DescriptorBufferInfo linearBuffer, vk::DescriptorBufferInfo blockLinearBuffer, span<const Level> levels) {
+        EnsurePipelines(gpu);
+        return Dispatch(gpu, commandBuffer, *swizzlePipeline, blockLinearBuffer, linearBuffer, levels);
+    }
+
+    std::shared_ptr<void> DeswizzleHelperShader::Dispatch(GPU &gpu, const vk::raii::CommandBuffer &commandBuffer, vk::Pipeline dispatchPipeline, vk::DescriptorBufferInfo blockLinearBuffer, vk::DescriptorBufferInfo linearBuffer, span<const Level> levels) {
+        // Both shaders share the same bindings and push constants, only the direction of the copy differs
+        auto descriptorSet{std::make_shared<DescriptorAllocator::ActiveDescriptorSet>(gpu.descriptor.AllocateSet(*descriptorSetLayout))};
+
+        std::array<vk::WriteDescriptorSet, 2> writes{
+            vk::WriteDescriptorSet{
+                .dstBinding = 0,
+                .descriptorType = vk::DescriptorType::eStorageBuffer,
+                .descriptorCount = 1,
+                .dstSet = **descriptorSet,
+                .pBufferInfo = &blockLinearBuffer
+            }, vk::WriteDescriptorSet{
+                .dstBinding = 1,
+                .descriptorType = vk::DescriptorType::eStorageBuffer,
+                .descriptorCount = 1,
+                .dstSet = **descriptorSet,
+                .pBufferInfo = &linearBuffer
+            }
+        };
+        gpu.vkDevice.updateDescriptorSets(writes, nullptr);
+
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, dispatchPipeline);
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *pipelineLayout, 0, **descriptorSet, nullptr);
+
+        for (const auto &level : levels) {
+            auto widthWords{static_cast<u32>(level.widthBytes / sizeof(u32))};
+            deswizzle::PushConstantLayout pushConstants{
+                .widthWords = widthWords,
+                .height = level.height,
+                .robWidthGobs = util::DivideCeil<u32>(level.widthBytes, deswizzle::GobWidth),
+                .blockHeightLog2 = static_cast<u32>(std::countr_zero(level.blockHeight)),
+                .srcOffset = static_cast<u32>(level.srcOffset / sizeof(u32)),
+                .srcLayerStride = static_cast<u32>(level.srcLayerStride / sizeof(u32)),
+                .dstOffset = static_cast<u32>(level.dstOffset / sizeof(u32)),
+                .dstLayerStride = static_cast<u32>(level.dstLayerStride / sizeof(u32)),
+            };
+
+            commandBuffer.pushConstants(*pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, vk::ArrayProxy<const deswizzle::PushConstantLayout>{pushConstants});
+            commandBuffer.dispatch(util::DivideCeil<u32>(widthWords, deswizzle::WorkgroupWidth), util::DivideCeil<u32>(level.height, deswizzle::WorkgroupHeight), level.layerCount);
+        }
+
+        return descriptorSet;
+    }
+
+    namespace quads {
+        struct PushConstantLayout {
+            u32 quadCount;
+            u32 indexSizeLog2;
+            u32 srcOffset;
+        };
+
+        constexpr static vk::PushConstantRange PushConstantRange{
+            .stageFlags = vk::ShaderStageFlagBits::eCompute,
+            .size = sizeof(PushConstantLayout),
+            .offset = 0
+        };
+
+        constexpr static std::array<vk::DescriptorSetLayoutBinding, 2> LayoutBindings{
+            vk::DescriptorSetLayoutBinding{
+                .binding = 0,
+                .descriptorType = vk::DescriptorType::eStorageBuffer,
+                .descriptorCount = 1,
+                .stageFlags = vk::ShaderStageFlagBits::eCompute
+            }, vk::DescriptorSetLayoutBinding{
+                .binding = 1,
+                .descriptorType = vk::DescriptorType::eStorageBuffer,
+                .descriptorCount = 1,
+                .stageFlags = vk::ShaderStageFlagBits::eCompute
+            }
+        };
+
+        constexpr static u32 WorkgroupWidth{64}; //!< The width of a workgroup, this must match the local size in the shader
+    }
+
+    QuadConversionHelperShader::QuadConversionHelperShader(GPU &gpu)
+        : descriptorSetLayout{gpu.vkDevice, vk::DescriptorSetLayoutCreateInfo{
+              .pBindings = quads::LayoutBindings.data(),
+              .bindingCount = static_cast<u32>(quads::LayoutBindings.size()),
+          }},
+          pipelineLayout{gpu.vkDevice, vk::PipelineLayoutCreateInfo{
+              .pSetLayouts = &*descriptorSetLayout,
+              .setLayoutCount = 1,
+              .pPushConstantRanges = &quads::PushConstantRange,
+              .pushConstantRangeCount = 1,
+          }} {
+        auto limits{gpu.vkPhysicalDevice.getProperties().limits};
+        storageBufferAlignment = limits.minStorageBufferOffsetAlignment;
+        maxQuadCount = static_cast<u32>(std::min<u64>(static_cast<u64>(limits.maxComputeWorkGroupCount[0]) * quads::WorkgroupWidth, std::numeric_limits<u32>::max()));
+    }
+
+    std::shared_ptr<void> QuadConversionHelperShader::Convert(GPU &gpu, const vk::raii::CommandBuffer &commandBuffer, vk::DescriptorBufferInfo srcBuffer, u32 srcOffset, u32 indexSizeLog2, vk::DescriptorBufferInfo dstBuffer, u32 quadCount) {
+        std::call_once(pipelineFlag, [&] {
+            pipeline = CreateComputePipeline(gpu, spirv::Quads, *pipelineLayout);
+        });
+
+        auto descriptorSet{std::make_shared<DescriptorAllocator::ActiveDescriptorSet>(gpu.descriptor.AllocateSet(*descriptorSetLayout))};
+
+        std::array<vk::WriteDescriptorSet, 2> writes{
+            vk::WriteDescriptorSet{
+                .dstBinding = 0,
+                .descriptorType = vk::DescriptorType::eStorageBuffer,
+                .descriptorCount = 1,
+                .dstSet = **descriptorSet,
+                .pBufferInfo = &srcBuffer
+            }, vk::WriteDescriptorSet{
+                .dstBinding = 1,
+                .descriptorType = vk::DescriptorType::eStorageBuffer,
+                .descriptorCount = 1,
+                .dstSet = **descriptorSet,
+                .pBufferInfo = &dstBuffer
+            }
+        };
+        gpu.vkDevice.updateDescriptorSets(writes, nullptr);
+
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, *pipeline);
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *pipelineLayout, 0, **descriptorSet, nullptr);
+
+        quads::PushConstantLayout pushConstants{
+            .quadCount = quadCount,
+            .indexSizeLog2 = indexSizeLog2,
+            .srcOffset = srcOffset,
+        };
+
+        commandBuffer.pushConstants(*pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, vk::ArrayProxy<const quads::PushConstantLayout>{pushConstants});
+        commandBuffer.dispatch(util::DivideCeil<u32>(quadCount, quads::WorkgroupWidth), 1, 1);
+
+        return descriptorSet;
+    }
+
+    namespace indices {
+        struct PushConstantLayout {
+            u32 indexCount;
+            u32 srcOffset;
+        };
+
+        constexpr static vk::PushConstantRange PushConstantRange{
+            .stageFlags = vk::ShaderStageFlagBits::eCompute,
+            .size = sizeof(PushConstantLayout),
+            .offset = 0
+        };
+
+        constexpr static u32 WorkgroupWidth{64}; //!< The width of a workgroup, this must match the local size in the shader
+        constexpr static u32 IndicesPerInvocation{2};
+    }
+
+    IndexConversionHelperShader::IndexConversionHelperShader(GPU &gpu)
+        : descriptorSetLayout{gpu.vkDevice, vk::DescriptorSetLayoutCreateInfo{
+              .pBindings = quads::LayoutBindings.data(), // The bindings are identical to those of the quad conversion shader
+              .bindingCount = static_cast<u32>(quads::LayoutBindings.size()),
+          }},
+          pipelineLayout{gpu.vkDevice, vk::PipelineLayoutCreateInfo{
+              .pSetLayouts = &*descriptorSetLayout,
+              .setLayoutCount = 1,
+              .pPushConstantRanges = &indices::PushConstantRange,
+              .pushConstantRangeCount = 1,
+          }} {
+        auto limits{gpu.vkPhysicalDevice.getProperties().limits};
+        storageBufferAlignment = limits.minStorageBufferOffsetAlignment;
+        maxIndexCount = static_cast<u32>(std::min<u64>(static_cast<u64>(limits.maxComputeWorkGroupCount[0]) * indices::WorkgroupWidth * indices::IndicesPerInvocation, std::numeric_limits<u32>::max()));
+    }
+
+    std::shared_ptr<void> IndexConversionHelperShader::Convert(GPU &gpu, const vk::raii::CommandBuffer &commandBuffer, vk::DescriptorBufferInfo srcBuffer, u32 srcOffset, vk::DescriptorBufferInfo dstBuffer, u32 indexCount) {
+        std::call_once(pipelineFlag, [&] {
+            pipeline = CreateComputePipeline(gpu, spirv::Indices, *pipelineLayout);
+        });
+
+        auto descriptorSet{std::make_shared<DescriptorAllocator::ActiveDescriptorSet>(gpu.descriptor.AllocateSet(*descriptorSetLayout))};
+
+        std::array<vk::WriteDescriptorSet, 2> writes{
+            vk::WriteDescriptorSet{
+                .dstBinding = 0,
+                .descriptorType = vk::DescriptorType::eStorageBuffer,
+                .descriptorCount = 1,
+                .dstSet = **descriptorSet,
+                .pBufferInfo = &srcBuffer
+            }, vk::WriteDescriptorSet{
+                .dstBinding = 1,
+                .descriptorType = vk::DescriptorType::eStorageBuffer,
+                .descriptorCount = 1,
+                .dstSet = **descriptorSet,
+                .pBufferInfo = &dstBuffer
+            }
+        };
+        gpu.vkDevice.updateDescriptorSets(writes, nullptr);
+
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, *pipeline);
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *pipelineLayout, 0, **descriptorSet, nullptr);
+
+        indices::PushConstantLayout pushConstants{
+            .indexCount = indexCount,
+            .srcOffset = srcOffset,
+        };
+
+        commandBuffer.pushConstants(*pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, vk::ArrayProxy<const indices::PushConstantLayout>{pushConstants});
+        commandBuffer.dispatch(util::DivideCeil<u32>(util::DivideCeil<u32>(indexCount, indices::IndicesPerInvocation), indices::WorkgroupWidth), 1, 1);
+
+        return descriptorSet;
+    }
+
+    HelperShaders::HelperShaders(GPU &gpu)
+        : blitHelperShader(gpu),
+          deswizzleHelperShader(gpu),
+          quadConversionHelperShader(gpu),
+          indexConversionHelperShader(gpu) {}
 
 }
\ No newline at end of file
@@ -7,28 +7,30 @@
 #include <gpu/descriptor_allocator.h>
 #include <gpu/cache/graphics_pipeline_cache.h>
 
-namespace skyline::vfs {
-    class FileSystem;
-}
-
 namespace skyline::gpu {
     class TextureView;
     class GPU;
 
     /**
      * @brief A base class that can be inherited by helper shaders that render to a single color rendertarget to simplify pipeline creation
+     * @note The shader modules and pipelines are only created on their first usage, so helper shaders that are never used don't cost anything
      */
     class SimpleColourRTShader {
       protected:
-        vk::raii::ShaderModule vertexShaderModule;
-        vk::raii::ShaderModule fragmentShaderModule;
+        span<const u32> vertexShaderCode;
+        span<const u32> fragmentShaderCode;
 
-        std::array<vk::PipelineShaderStageCreateInfo, 2> shaderStages; //!< Shader stages for the vertex and fragment shader modules
+        std::mutex mutex; //!< Synchronizes the creation of the shader modules and all accesses to the pipeline map
+        vk::raii::ShaderModule vertexShaderModule{nullptr};
+        vk::raii::ShaderModule fragmentShaderModule{nullptr};
+        std::array<vk::PipelineShaderStageCreateInfo, 2> shaderStages{}; //!< Shader stages for the vertex and fragment shader modules
+        std::unordered_map<u64, cache::GraphicsPipelineCache::CompiledPipeline> pipelines; //!< A map from the format and sample count of the colour attachment (packed by GetPipelineKey) to the pipeline for it
 
-        SimpleColourRTShader(GPU &gpu, std::shared_ptr<vfs::Backing> vertexShader, std::shared_ptr<vfs::Backing> fragmentShader);
+        SimpleColourRTShader(span<const u32> vertexShaderCode, span<const u32> fragmentShaderCode);
 
         /**
-         * @brief Returns a potentially cached pipeline built according to the supplied input state
+         * @brief Returns a potentially cached pipeline for rendering into an attachment with the same format and sample count as the supplied one
+         * @note The viewport and scissor are dynamic state, they must be set prior to any draws
          */
         cache::GraphicsPipelineCache::CompiledPipeline GetPipeline(GPU &gpu,
                                                                    TextureView *colorAttachment,
@@ -44,7 +46,7 @@ namespace skyline::gpu {
         vk::raii::Sampler nearestSampler;
 
       public:
-            BlitHelperShader(GPU &gpu, std::shared_ptr<vfs::FileSystem> shaderFileSystem);
+            BlitHelperShader(GPU &gpu);
 
             /**
              * @brief Floating point equivalent to vk::Rect2D to allow for subpixel-precison blits
@@ -73,13 +75,126 @@ namespace skyline::gpu {
                       std::function<void(std::function<void(vk::raii::CommandBuffer &, const std::shared_ptr<FenceCycle> &, GPU &, vk::RenderPass, u32)> &&)> &&recordCb);
     };
 
+    /**
+     * @brief Compute shaders for deswizzling block-linear surfaces into a linear layout and swizzling them back on the GPU, this offloads the (de)swizzling of large textures from the CPU
+     * @note Only surfaces with a single GOB of block depth and a format with a size that's a multiple of 4 bytes are supported as each invocation copies a single word
+     */
+    class DeswizzleHelperShader {
+      private:
+        vk::raii::DescriptorSetLayout descriptorSetLayout;
+        vk::raii::PipelineLayout pipelineLayout;
+        std::once_flag pipelineFlag; //!< The pipelines are only created on the first usage of either of them
+        vk::raii::Pipeline pipeline{nullptr};
+        vk::raii::Pipeline swizzlePipeline{nullptr};
+
+      public:
+        vk::DeviceSize storageBufferAlignment; //!< The alignment required for the offset of any storage buffer bindings
+
+        /**
+         * @brief The layout of a single mip level in the block-linear and linear buffers
+         * @note All offsets and strides are in bytes and must be a multiple of 4
+         */
+        struct Level {
+            u32 widthBytes; //!< The width of a single line in bytes
+            u32 height; //!< The height of the level in lines (not pixels for compressed formats)
+            u32 blockHeight; //!< The height of a block in GOBs
+            u32 layerCount;
+            vk::DeviceSize srcOffset; //!< The offset of the level in the block-linear buffer
+            vk::DeviceSize srcLayerStride; //!< The stride between consecutive layers of the level in the block-linear buffer
+            vk::DeviceSize dstOffset; //!< The offset of the level in the linear buffer
+            vk::DeviceSize dstLayerStride; //!< The stride between consecutive layers of the level in the linear buffer
+        };
+
+        DeswizzleHelperShader(GPU &gpu);
+
+        /**
+         * @brief Records the deswizzling of all supplied levels from the block-linear buffer into the linear buffer
+         * @return An object which must be kept alive till the recorded commands have completed execution
+         * @note A barrier between the compute shader writes and any subsequent reads from the linear buffer must be recorded by the caller
+         */
+        std::shared_ptr<void> Deswizzle(GPU &gpu, const vk::raii::CommandBuffer &commandBuffer, vk::DescriptorBufferInfo blockLinearBuffer, vk::DescriptorBufferInfo linearBuffer, span<const Level> levels);
+
+        /**
+         * @brief Records the swizzling of all supplied levels from the linear buffer into the block-linear buffer, the source offsets of the levels still refer to the block-linear buffer
+         * @return An object which must be kept alive till the recorded commands have completed execution
+         * @note Any padding in the block-linear buffer isn't written to
+         * @note A barrier between the compute shader writes and any subsequent reads from the block-linear buffer must be recorded by the caller
+         */
+        std::shared_ptr<void> Swizzle(GPU &gpu, const vk::raii::CommandBuffer &commandBuffer, vk::DescriptorBufferInfo linearBuffer, vk::DescriptorBufferInfo blockLinearBuffer, span<const Level> levels);
+
+      private:
+        /**
+         * @brief Creates the pipelines if they haven't been created yet
+         */
+        void EnsurePipelines(GPU &gpu);
+
+        std::shared_ptr<void> Dispatch(GPU &gpu, const vk::raii::CommandBuffer &commandBuffer, vk::Pipeline dispatchPipeline, vk::DescriptorBufferInfo blockLinearBuffer, vk::DescriptorBufferInfo linearBuffer, span<const Level> levels);
+    };
+
+    /**
+     * @brief Compute shader for converting quad list index buffers into triangle list index buffers on the GPU, this avoids reading back and rewriting the guest index data on the CPU
+     * @note 32-bit indices are always emitted regardless of the size of the source indices
+     */
+    class QuadConversionHelperShader {
+      private:
+        vk::raii::DescriptorSetLayout descriptorSetLayout;
+        vk::raii::PipelineLayout pipelineLayout;
+        std::once_flag pipelineFlag; //!< The pipeline is only created on its first usage
+        vk::raii::Pipeline pipeline{nullptr};
+
+      public:
+        vk::DeviceSize storageBufferAlignment; //!< The alignment required for the offset of any storage buffer bindings
+        u32 maxQuadCount; //!< The maximum amount of quads that can be converted in a single dispatch
+
+        QuadConversionHelperShader(GPU &gpu);
+
+        /**
+         * @brief Records the conversion of the quads in the source index buffer into triangles in the destination buffer
+         * @param srcOffset The offset of the first index inside the source buffer binding in bytes, this allows for binding sources that aren't suitably aligned
+         * @param indexSizeLog2 The size of a source index in bytes as a power of 2
+         * @return An object which must be kept alive till the recorded commands have completed execution
+         * @note A barrier between the compute shader writes and any subsequent reads from the destination buffer must be recorded by the caller
+         */
+        std::shared_ptr<void> Convert(GPU &gpu, const vk::raii::CommandBuffer &commandBuffer, vk::DescriptorBufferInfo srcBuffer, u32 srcOffset, u32 indexSizeLog2, vk::DescriptorBufferInfo dstBuffer, u32 quadCount);
+    };
+
+    /**
+     * @brief Compute shader for widening 8-bit index buffers into 16-bit index buffers on the GPU, this is used on hosts without VK_EXT_index_type_uint8
+     */
+    class IndexConversionHelperShader {
+      private:
+        vk::raii::DescriptorSetLayout descriptorSetLayout;
+        vk::raii::PipelineLayout pipelineLayout;
+        std::once_flag pipelineFlag; //!< The pipeline is only created on its first usage
+        vk::raii::Pipeline pipeline{nullptr};
+
+      public:
+        vk::DeviceSize storageBufferAlignment; //!< The alignment required for the offset of any storage buffer bindings
+        u32 maxIndexCount; //!< The maximum amount of indices that can be converted in a single dispatch
+
+        IndexConversionHelperShader(GPU &gpu);
+
+        /**
+         * @brief Records the conversion of the 8-bit indices in the source buffer into 16-bit indices in the destination buffer
+         * @param srcOffset The offset of the first index inside the source buffer binding in bytes, this allows for binding sources that aren't suitably aligned
+         * @return An object which must be kept alive till the recorded commands have completed execution
+         * @note The destination buffer must be large enough for the amount of indices rounded up to a multiple of 2
+         * @note A barrier between the compute shader writes and any subsequent reads from the destination buffer must be recorded by the caller
+         */
+        std::shared_ptr<void> Convert(GPU &gpu, const vk::raii::CommandBuffer &commandBuffer, vk::DescriptorBufferInfo srcBuffer, u32 srcOffset, vk::DescriptorBufferInfo dstBuffer, u32 indexCount);
+    };
+
     /**
      * @brief Holds all helper shaders to avoid redundantly recreating them on each usage
+     * @note The SPIR-V of all helper shaders is embedded into the binary and their pipelines are compiled lazily, so constructing this is cheap
      */
     struct HelperShaders {
         BlitHelperShader blitHelperShader;
+        DeswizzleHelperShader deswizzleHelperShader;
+        QuadConversionHelperShader quadConversionHelperShader;
+        IndexConversionHelperShader indexConversionHelperShader;
 
-        HelperShaders(GPU &gpu, std::shared_ptr<vfs::FileSystem> shaderFileSystem);
+        HelperShaders(GPU &gpu);
     };
 
 
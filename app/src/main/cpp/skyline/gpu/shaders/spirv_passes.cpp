@@ -0,0 +1,1008 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <unordered_set>
+#include <spirv/unified1/spirv.hpp11>
+#include "spirv_passes.h"
+
+namespace skyline::gpu::spirv {
+    constexpr size_t HeaderWordCount{5}; //!< The amount of words in the module header, these precede all instructions
+    constexpr size_t BoundWordIndex{3}; //!< The index of the word in the header which holds the upper bound of all IDs in the module
+
+    template<typename T>
+    static constexpr u32 Word(T value) {
+        return static_cast<u32>(value);
+    }
+
+    /**
+     * @brief A view of a single instruction in a module, `words[0]` is the combined opcode and word count while the operands follow it
+     */
+    struct Instruction {
+        spv::Op opcode;
+        span<const u32> words;
+    };
+
+    /**
+     * @return All instructions in the module in order, this is empty if the module is malformed
+     */
+    static std::vector<Instruction> ParseInstructions(span<const u32> spirv) {
+        if (spirv.size() < HeaderWordCount || spirv[0] != spv::MagicNumber)
+            return {};
+
+        std::vector<Instruction> instructions;
+        for (size_t offset{HeaderWordCount}; offset < spirv.size();) {
+            u32 wordCount{spirv[offset] >> spv::WordCountShift};
+            if (!wordCount || offset + wordCount > spirv.size())
+                return {};
+
+            instructions.push_back({static_cast<spv::Op>(spirv[offset] & spv::OpCodeMask), spirv.subspan(offset, wordCount)});
+            offset += wordCount;
+        }
+        return instructions;
+    }
+
+    bool HasPushConstantBlock(span<const u32> spirv) {
+        for (const auto &inst : ParseInstructions(spirv))
+            if (inst.opcode == spv::Op::OpVariable && inst.words[3] == Word(spv::StorageClass::PushConstant))
+                return true;
+        return false;
+    }
+
+    bool PromoteUniformBufferToPushConstants(std::vector<u32> &spirv, u32 binding, u32 offset, u32 size) {
+        auto instructions{ParseInstructions(spirv)};
+        if (instructions.empty())
+            return false;
+
+        std::unordered_map<u32, u32> bindingDecorations, setDecorations, strideDecorations; //!< Maps from the target of decorations to their value
+        std::unordered_map<u32, Instruction> types; //!< Maps from the result ID of pointer, struct and array types to their declaration
+        std::unordered_map<u32, Instruction> constants;
+        std::vector<Instruction> uniformVariables;
+
+        for (const auto &inst : instructions) {
+            switch (inst.opcode) {
+                case spv::Op::OpDecorate:
+                    if (inst.words.size() == 4) {
+                        if (inst.words[2] == Word(spv::Decoration::Binding))
+                            bindingDecorations[inst.words[1]] = inst.words[3];
+                        else if (inst.words[2] == Word(spv::Decoration::DescriptorSet))
+                            setDecorations[inst.words[1]] = inst.words[3];
+                        else if (inst.words[2] == Word(spv::Decoration::ArrayStride))
+                            strideDecorations[inst.words[1]] = inst.words[3];
+                    }
+                    break;
+
+                case spv::Op::OpTypePointer:
+                case spv::Op::OpTypeStruct:
+                case spv::Op::OpTypeArray:
+                    types.emplace(inst.words[1], inst);
+                    break;
+
+                case spv::Op::OpConstant:
+                    constants.emplace(inst.words[2], inst);
+                    break;
+
+                case spv::Op::OpVariable:
+                    if (inst.words[3] == Word(spv::StorageClass::PushConstant))
+                        return false; // Only a single push constant block can be statically used by an entry point
+                    else if (inst.words[3] == Word(spv::StorageClass::Uniform))
+                        uniformVariables.push_back(inst);
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        // Buffers that are accessed with multiple types are declared as aliased variables which would all need to be rewritten into the same block
+        std::optional<Instruction> variable;
+        for (const auto &inst : uniformVariables) {
+            u32 id{inst.words[2]};
+            auto bindingIt{bindingDecorations.find(id)}, setIt{setDecorations.find(id)};
+            if (bindingIt == bindingDecorations.end() || bindingIt->second != binding || setIt == setDecorations.end() || setIt->second != 0)
+                continue;
+
+            if (variable)
+                return false;
+            variable = inst;
+        }
+        if (!variable)
+            return false;
+
+        // The variable must be a pointer to a block containing a single array of 32-bit or larger elements, smaller ones would require 8/16-bit push constant storage support
+        u32 variableId{variable->words[2]};
+        auto pointerIt{types.find(variable->words[1])};
+        if (pointerIt == types.end() || pointerIt->second.opcode != spv::Op::OpTypePointer)
+            return false;
+
+        auto structIt{types.find(pointerIt->second.words[3])};
+        if (structIt == types.end() || structIt->second.opcode != spv::Op::OpTypeStruct || structIt->second.words.size() != 3)
+            return false;
+
+        auto arrayIt{types.find(structIt->second.words[2])};
+        if (arrayIt == types.end() || arrayIt->second.opcode != spv::Op::OpTypeArray)
+            return false;
+        u32 elementType{arrayIt->second.words[2]};
+
+        auto strideIt{strideDecorations.find(arrayIt->first)};
+        if (strideIt == strideDecorations.end() || strideIt->second < sizeof(u32) || strideIt->second % sizeof(u32) != 0)
+            return false;
+        u32 stride{strideIt->second};
+
+        auto lengthIt{constants.find(arrayIt->second.words[3])};
+        if (lengthIt == constants.end() || lengthIt->second.words.size() != 4)
+            return false;
+        u32 lengthType{lengthIt->second.words[1]};
+
+        // All uses of the variable must be access chains directly to an element of the array, the result types of these are replaced with push constant pointers
+        u32 nextId{spirv[BoundWordIndex]};
+        std::vector<std::pair<u32, u32>> elementPointerTypes; //!< Pairs of the uniform pointer types used by the access chains and the push constant pointer types replacing them
+        for (const auto &inst : instructions) {
+            auto operands{inst.words.subspan(1)};
+            if (std::find(operands.begin(), operands.end(), variableId) == operands.end())
+                continue;
+
+            switch (inst.opcode) {
+                case spv::Op::OpName:
+                case spv::Op::OpDecorate:
+                case spv::Op::OpEntryPoint:
+                    continue;
+
+                case spv::Op::OpVariable:
+                    if (inst.words[2] == variableId)
+                        continue;
+                    return false;
+
+                case spv::Op::OpAccessChain:
+                case spv::Op::OpInBoundsAccessChain: {
+                    if (inst.words.size() != 6 || inst.words[3] != variableId || std::count(operands.begin(), operands.end(), variableId) != 1)
+                        return false;
+
+                    auto elementPointerIt{types.find(inst.words[1])};
+                    if (elementPointerIt == types.end() || elementPointerIt->second.opcode != spv::Op::OpTypePointer || elementPointerIt->second.words[3] != elementType)
+                        return false;
+
+                    if (std::find_if(elementPointerTypes.begin(), elementPointerTypes.end(), [&](const auto &pair) { return pair.first == inst.words[1]; }) == elementPointerTypes.end())
+                        elementPointerTypes.emplace_back(inst.words[1], nextId++);
+                    continue;
+                }
+
+                default:
+                    return false;
+            }
+        }
+
+        u32 lengthId{nextId++}, arrayId{nextId++}, structId{nextId++}, structPointerId{nextId++};
+        u32 length{util::DivideCeil(std::max(size, stride), stride)};
+
+        std::vector<u32> output;
+        output.reserve(spirv.size() + 64);
+        output.insert(output.end(), spirv.begin(), spirv.begin() + HeaderWordCount);
+        output[BoundWordIndex] = nextId;
+
+        auto emit{[&output](spv::Op opcode, std::initializer_list<u32> operands) {
+            output.push_back(static_cast<u32>(operands.size() + 1) << spv::WordCountShift | Word(opcode));
+            output.insert(output.end(), operands);
+        }};
+
+        bool decorated{};
+        for (const auto &inst : instructions) {
+            if (inst.opcode == spv::Op::OpDecorate && inst.words[1] == variableId && (inst.words[2] == Word(spv::Decoration::Binding) || inst.words[2] == Word(spv::Decoration::DescriptorSet))) {
+                // Push constant blocks can't have any descriptor decorations, the layout of the new block is declared in their place as it must be in the annotation section
+                if (!decorated) {
+                    emit(spv::Op::OpDecorate, {arrayId, Word(spv::Decoration::ArrayStride), stride});
+                    emit(spv::Op::OpDecorate, {structId, Word(spv::Decoration::Block)});
+                    emit(spv::Op::OpMemberDecorate, {structId, 0, Word(spv::Decoration::Offset), offset});
+                    decorated = true;
+                }
+                continue;
+            }
+
+            if (inst.opcode == spv::Op::OpVariable && inst.words[2] == variableId) {
+                // The original types may be shared with other buffers, so a new set of them with the array trimmed to the used size is declared right before the variable
+                emit(spv::Op::OpConstant, {lengthType, lengthId, length});
+                emit(spv::Op::OpTypeArray, {arrayId, elementType, lengthId});
+                emit(spv::Op::OpTypeStruct, {structId, arrayId});
+                emit(spv::Op::OpTypePointer, {structPointerId, Word(spv::StorageClass::PushConstant), structId});
+                for (auto [uniformPointer, pushConstantPointer] : elementPointerTypes)
+                    emit(spv::Op::OpTypePointer, {pushConstantPointer, Word(spv::StorageClass::PushConstant), elementType});
+                emit(spv::Op::OpVariable, {structPointerId, variableId, Word(spv::StorageClass::PushConstant)});
+                continue;
+            }
+
+            size_t instOffset{output.size()};
+            output.insert(output.end(), inst.words.begin(), inst.words.end());
+            if ((inst.opcode == spv::Op::OpAccessChain || inst.opcode == spv::Op::OpInBoundsAccessChain) && inst.words[3] == variableId)
+                output[instOffset + 1] = std::find_if(elementPointerTypes.begin(), elementPointerTypes.end(), [&](const auto &pair) { return pair.first == inst.words[1]; })->second;
+        }
+
+        if (!decorated)
+            return false;
+
+        spirv = std::move(output);
+        return true;
+    }
+
+    /**
+     * @return If the instruction has no effects beyond producing its result, these are all in the form of a result type followed by the result ID
+     */
+    static bool IsPureInstruction(spv::Op opcode) {
+        switch (opcode) {
+            case spv::Op::OpUndef:
+            case spv::Op::OpLoad:
+            case spv::Op::OpAccessChain:
+            case spv::Op::OpInBoundsAccessChain:
+            case spv::Op::OpPhi:
+            case spv::Op::OpCopyObject:
+            case spv::Op::OpVectorExtractDynamic:
+            case spv::Op::OpVectorInsertDynamic:
+            case spv::Op::OpVectorShuffle:
+            case spv::Op::OpCompositeConstruct:
+            case spv::Op::OpCompositeExtract:
+            case spv::Op::OpCompositeInsert:
+            case spv::Op::OpSampledImage:
+            case spv::Op::OpImageSampleImplicitLod:
+            case spv::Op::OpImageSampleExplicitLod:
+            case spv::Op::OpImageSampleDrefImplicitLod:
+            case spv::Op::OpImageSampleDrefExplicitLod:
+            case spv::Op::OpImageSampleProjImplicitLod:
+            case spv::Op::OpImageSampleProjExplicitLod:
+            case spv::Op::OpImageSampleProjDrefImplicitLod:
+            case spv::Op::OpImageSampleProjDrefExplicitLod:
+            case spv::Op::OpImageFetch:
+            case spv::Op::OpImageGather:
+            case spv::Op::OpImageDrefGather:
+            case spv::Op::OpImage:
+            case spv::Op::OpImageQuerySizeLod:
+            case spv::Op::OpImageQuerySize:
+            case spv::Op::OpImageQueryLod:
+            case spv::Op::OpImageQueryLevels:
+            case spv::Op::OpImageQuerySamples:
+            case spv::Op::OpConvertFToU:
+            case spv::Op::OpConvertFToS:
+            case spv::Op::OpConvertSToF:
+            case spv::Op::OpConvertUToF:
+            case spv::Op::OpUConvert:
+            case spv::Op::OpSConvert:
+            case spv::Op::OpFConvert:
+            case spv::Op::OpBitcast:
+            case spv::Op::OpSNegate:
+            case spv::Op::OpFNegate:
+            case spv::Op::OpIAdd:
+            case spv::Op::OpFAdd:
+            case spv::Op::OpISub:
+            case spv::Op::OpFSub:
+            case spv::Op::OpIMul:
+            case spv::Op::OpFMul:
+            case spv::Op::OpUDiv:
+            case spv::Op::OpSDiv:
+            case spv::Op::OpFDiv:
+            case spv::Op::OpUMod:
+            case spv::Op::OpSRem:
+            case spv::Op::OpSMod:
+            case spv::Op::OpFRem:
+            case spv::Op::OpFMod:
+            case spv::Op::OpVectorTimesScalar:
+            case spv::Op::OpDot:
+            case spv::Op::OpIsNan:
+            case spv::Op::OpIsInf:
+            case spv::Op::OpLogicalEqual:
+            case spv::Op::OpLogicalNotEqual:
+            case spv::Op::OpLogicalOr:
+            case spv::Op::OpLogicalAnd:
+            case spv::Op::OpLogicalNot:
+            case spv::Op::OpSelect:
+            case spv::Op::OpIEqual:
+            case spv::Op::OpINotEqual:
+            case spv::Op::OpUGreaterThan:
+            case spv::Op::OpSGreaterThan:
+            case spv::Op::OpUGreaterThanEqual:
+            case spv::Op::OpSGreaterThanEqual:
+            case spv::Op::OpULessThan:
+            case spv::Op::OpSLessThan:
+            case spv::Op::OpULessThanEqual:
+            case spv::Op::OpSLessThanEqual:
+            case spv::Op::OpFOrdEqual:
+            case spv::Op::OpFUnordEqual:
+            case spv::Op::OpFOrdNotEqual:
+            case spv::Op::OpFUnordNotEqual:
+            case spv::Op::OpFOrdLessThan:
+            case spv::Op::OpFUnordLessThan:
+            case spv::Op::OpFOrdGreaterThan:
+            case spv::Op::OpFUnordGreaterThan:
+            case spv::Op::OpFOrdLessThanEqual:
+            case spv::Op::OpFUnordLessThanEqual:
+            case spv::Op::OpFOrdGreaterThanEqual:
+            case spv::Op::OpFUnordGreaterThanEqual:
+            case spv::Op::OpShiftRightLogical:
+            case spv::Op::OpShiftRightArithmetic:
+            case spv::Op::OpShiftLeftLogical:
+            case spv::Op::OpBitwiseOr:
+            case spv::Op::OpBitwiseXor:
+            case spv::Op::OpBitwiseAnd:
+            case spv::Op::OpNot:
+            case spv::Op::OpBitFieldInsert:
+            case spv::Op::OpBitFieldSExtract:
+            case spv::Op::OpBitFieldUExtract:
+            case spv::Op::OpBitReverse:
+            case spv::Op::OpBitCount:
+                return true;
+
+            default:
+                return false;
+        }
+    }
+
+    /**
+     * @return If the instruction only carries debug information, these can be stripped without affecting the semantics of the module
+     */
+    static bool IsDebugInstruction(spv::Op opcode) {
+        switch (opcode) {
+            case spv::Op::OpSourceContinued:
+            case spv::Op::OpSource:
+            case spv::Op::OpSourceExtension:
+            case spv::Op::OpName:
+            case spv::Op::OpMemberName:
+            case spv::Op::OpString:
+            case spv::Op::OpLine:
+            case spv::Op::OpNoLine:
+            case spv::Op::OpModuleProcessed:
+                return true;
+
+            default:
+                return false;
+        }
+    }
+
+    /**
+     * @brief Folds an operation on scalar 32-bit integer or boolean constants
+     * @return The value of the result, this is 0 or 1 for boolean results
+     */
+    static std::optional<u32> FoldConstantOperation(spv::Op opcode, span<const u32> operands) {
+        auto binary{[&](auto operation) -> std::optional<u32> {
+            if (operands.size() != 2)
+                return std::nullopt;
+            return static_cast<u32>(operation(operands[0], operands[1]));
+        }};
+
+        auto binarySigned{[&](auto operation) -> std::optional<u32> {
+            if (operands.size() != 2)
+                return std::nullopt;
+            return static_cast<u32>(operation(static_cast<i32>(operands[0]), static_cast<i32>(operands[1])));
+        }};
+
+        auto unary{[&](auto operation) -> std::optional<u32> {
+            if (operands.size() != 1)
+                return std::nullopt;
+            return static_cast<u32>(operation(operands[0]));
+        }};
+
+        switch (opcode) {
+            case spv::Op::OpCopyObject:
+            case spv::Op::OpBitcast:
+                return unary([](u32 a) { return a; });
+            case spv::Op::OpNot:
+                return unary([](u32 a) { return ~a; });
+            case spv::Op::OpSNegate:
+                return unary([](u32 a) { return 0U - a; });
+            case spv::Op::OpLogicalNot:
+                return unary([](u32 a) { return !a; });
+
+            case spv::Op::OpIAdd:
+                return binary([](u32 a, u32 b) { return a + b; });
+            case spv::Op::OpISub:
+                return binary([](u32 a, u32 b) { return a - b; });
+            case spv::Op::OpIMul:
+                return binary([](u32 a, u32 b) { return a * b; });
+            case spv::Op::OpBitwiseAnd:
+                return binary([](u32 a, u32 b) { return a & b; });
+            case spv::Op::OpBitwiseOr:
+                return binary([](u32 a, u32 b) { return a | b; });
+            case spv::Op::OpBitwiseXor:
+                return binary([](u32 a, u32 b) { return a ^ b; });
+
+            // Shifts by the bit width or more have undefined results, so those are left for the driver
+            case spv::Op::OpShiftLeftLogical:
+                if (operands.size() == 2 && operands[1] >= 32)
+                    return std::nullopt;
+                return binary([](u32 a, u32 b) { return a << b; });
+            case spv::Op::OpShiftRightLogical:
+                if (operands.size() == 2 && operands[1] >= 32)
+                    return std::nullopt;
+                return binary([](u32 a, u32 b) { return a >> b; });
+            case spv::Op::OpShiftRightArithmetic:
+                if (operands.size() == 2 && operands[1] >= 32)
+                    return std::nullopt;
+                return binarySigned([](i32 a, i32 b) { return a >> b; });
+
+            case spv::Op::OpIEqual:
+            case spv::Op::OpLogicalEqual:
+                return binary([](u32 a, u32 b) { return a == b; });
+            case spv::Op::OpINotEqual:
+            case spv::Op::OpLogicalNotEqual:
+                return binary([](u32 a, u32 b) { return a != b; });
+            case spv::Op::OpLogicalAnd:
+                return binary([](u32 a, u32 b) { return a && b; });
+            case spv::Op::OpLogicalOr:
+                return binary([](u32 a, u32 b) { return a || b; });
+
+            case spv::Op::OpUGreaterThan:
+                return binary([](u32 a, u32 b) { return a > b; });
+            case spv::Op::OpUGreaterThanEqual:
+                return binary([](u32 a, u32 b) { return a >= b; });
+            case spv::Op::OpULessThan:
+                return binary([](u32 a, u32 b) { return a < b; });
+            case spv::Op::OpULessThanEqual:
+                return binary([](u32 a, u32 b) { return a <= b; });
+            case spv::Op::OpSGreaterThan:
+                return binarySigned([](i32 a, i32 b) { return a > b; });
+            case spv::Op::OpSGreaterThanEqual:
+                return binarySigned([](i32 a, i32 b) { return a >= b; });
+            case spv::Op::OpSLessThan:
+                return binarySigned([](i32 a, i32 b) { return a < b; });
+            case spv::Op::OpSLessThanEqual:
+                return binarySigned([](i32 a, i32 b) { return a <= b; });
+
+            default:
+                return std::nullopt;
+        }
+    }
+
+    void OptimizeModule(std::vector<u32> &spirv) {
+        auto instructions{ParseInstructions(spirv)};
+        if (instructions.empty())
+            return;
+
+        std::unordered_set<u32> int32Types, boolTypes;
+        std::unordered_map<u32, u32> constants; //!< A map from the IDs of scalar 32-bit integer and boolean constants to their values
+        std::unordered_set<u32> safeExtInstSets; //!< Extended instruction sets which only contain pure instructions aside from the ones excluded below
+        std::vector<bool> inFunction(instructions.size());
+
+        bool functions{};
+        for (size_t i{}; i < instructions.size(); i++) {
+            const auto &inst{instructions[i]};
+            switch (inst.opcode) {
+                case spv::Op::OpTypeInt:
+                    if (inst.words.size() == 4 && inst.words[2] == 32)
+                        int32Types.insert(inst.words[1]);
+                    break;
+
+                case spv::Op::OpTypeBool:
+                    boolTypes.insert(inst.words[1]);
+                    break;
+
+                case spv::Op::OpConstant:
+                    if (inst.words.size() == 4 && int32Types.contains(inst.words[1]))
+                        constants.emplace(inst.words[2], inst.words[3]);
+                    break;
+
+                case spv::Op::OpConstantTrue:
+                case spv::Op::OpConstantFalse:
+                    constants.emplace(inst.words[2], inst.opcode == spv::Op::OpConstantTrue);
+                    break;
+
+                case spv::Op::OpExtInstImport: {
+                    if (inst.words.subspan(2).cast<const char>().as_string(true) == "GLSL.std.450")
+                        safeExtInstSets.insert(inst.words[1]);
+                    break;
+                }
+
+                case spv::Op::OpFunction:
+                    functions = true;
+                    break;
+
+                default:
+                    break;
+            }
+            inFunction[i] = functions;
+        }
+
+        auto isPure{[&](size_t i) {
+            const auto &inst{instructions[i]};
+            if (!inFunction[i] || inst.words.size() < 3)
+                return false;
+
+            if (inst.opcode == spv::Op::OpExtInst) {
+                // Modf and Frexp write their second result through a pointer
+                constexpr u32 GlslModf{35}, GlslFrexp{51};
+                return inst.words.size() >= 5 && safeExtInstSets.contains(inst.words[3]) && inst.words[4] != GlslModf && inst.words[4] != GlslFrexp;
+            }
+
+            if (inst.opcode == spv::Op::OpLoad && inst.words.size() > 4 && (inst.words[4] & Word(spv::MemoryAccessMask::Volatile)))
+                return false;
+
+            return IsPureInstruction(inst.opcode);
+        }};
+
+        // Constant folding replaces instructions with constants of the same ID declared at module scope, this avoids rewriting uses as constants dominate all functions
+        std::vector<bool> removed(instructions.size());
+        std::unordered_set<u32> foldedIds;
+        std::vector<u32> foldedConstants;
+        for (size_t i{}; i < instructions.size(); i++) {
+            const auto &inst{instructions[i]};
+            if (!isPure(i) || inst.opcode == spv::Op::OpExtInst)
+                continue;
+
+            u32 resultType{inst.words[1]}, resultId{inst.words[2]};
+            bool isBool{boolTypes.contains(resultType)};
+            if (!isBool && !int32Types.contains(resultType))
+                continue;
+
+            std::array<u32, 2> values{};
+            auto operands{inst.words.subspan(3)};
+            if (operands.empty() || operands.size() > values.size())
+                continue;
+
+            bool allConstant{true};
+            for (size_t operand{}; operand < operands.size(); operand++) {
+                auto it{constants.find(operands[operand])};
+                if (it == constants.end()) {
+                    allConstant = false;
+                    break;
+                }
+                values[operand] = it->second;
+            }
+            if (!allConstant)
+                continue;
+
+            auto value{FoldConstantOperation(inst.opcode, span(values).first(operands.size()))};
+            if (!value)
+                continue;
+
+            if (isBool)
+                foldedConstants.insert(foldedConstants.end(), {3U << spv::WordCountShift | Word(*value ? spv::Op::OpConstantTrue : spv::Op::OpConstantFalse), resultType, resultId});
+            else
+                foldedConstants.insert(foldedConstants.end(), {4U << spv::WordCountShift | Word(spv::Op::OpConstant), resultType, resultId, *value});
+
+            constants[resultId] = *value;
+            foldedIds.insert(resultId);
+            removed[i] = true;
+        }
+
+        // Every operand word is conservatively counted as a use of an ID, literals may only cause an unused result to be retained
+        auto isAnnotation{[](spv::Op opcode) {
+            return opcode == spv::Op::OpDecorate || opcode == spv::Op::OpMemberDecorate || opcode == spv::Op::OpDecorateString || IsDebugInstruction(opcode);
+        }};
+
+        std::unordered_map<u32, u32> useCounts;
+        std::unordered_map<u32, size_t> pureDefinitions; //!< A map from the result IDs of pure instructions to their index
+        for (size_t i{}; i < instructions.size(); i++) {
+            const auto &inst{instructions[i]};
+            if (removed[i] || isAnnotation(inst.opcode))
+                continue;
+
+            bool pure{isPure(i)};
+            if (pure)
+                pureDefinitions.emplace(inst.words[2], i);
+            for (size_t word{1}; word < inst.words.size(); word++)
+                if (!pure || word != 2)
+                    useCounts[inst.words[word]]++;
+        }
+
+        std::vector<size_t> worklist;
+        for (auto [id, i] : pureDefinitions)
+            if (!useCounts[id])
+                worklist.push_back(i);
+
+        std::unordered_set<u32> eliminatedIds;
+        while (!worklist.empty()) {
+            size_t i{worklist.back()};
+            worklist.pop_back();
+            if (removed[i])
+                continue;
+
+            const auto &inst{instructions[i]};
+            removed[i] = true;
+            eliminatedIds.insert(inst.words[2]);
+            for (size_t word{1}; word < inst.words.size(); word++) {
+                if (word == 2)
+                    continue;
+
+                u32 id{inst.words[word]};
+                if (--useCounts[id] == 0)
+                    if (auto it{pureDefinitions.find(id)}; it != pureDefinitions.end())
+                        worklist.push_back(it->second);
+            }
+        }
+
+        std::vector<u32> output;
+        output.reserve(spirv.size() + foldedConstants.size());
+        output.insert(output.end(), spirv.begin(), spirv.begin() + HeaderWordCount);
+
+        bool emittedConstants{};
+        for (size_t i{}; i < instructions.size(); i++) {
+            const auto &inst{instructions[i]};
+            if (removed[i] || IsDebugInstruction(inst.opcode))
+                continue;
+
+            // Decorations of results which no longer exist or are now constants would be invalid
+            if ((inst.opcode == spv::Op::OpDecorate || inst.opcode == spv::Op::OpDecorateString) && (eliminatedIds.contains(inst.words[1]) || foldedIds.contains(inst.words[1])))
+                continue;
+
+            if (inst.opcode == spv::Op::OpFunction && !emittedConstants) {
+                output.insert(output.end(), foldedConstants.begin(), foldedConstants.end());
+                emittedConstants = true;
+            }
+
+            output.insert(output.end(), inst.words.begin(), inst.words.end());
+        }
+
+        spirv = std::move(output);
+    }
+
+    bool EmulateTransformFeedback(std::vector<u32> &spirv, u32 firstBinding) {
+        auto instructions{ParseInstructions(spirv)};
+        if (instructions.empty())
+            return false;
+
+        std::unordered_map<u32, u32> xfbBuffers, xfbStrides, xfbOffsets, builtIns; //!< Maps from the target of decorations to their value
+        std::unordered_map<u32, Instruction> types, variables;
+        std::optional<u32> uintType, boolType;
+        std::optional<size_t> entryPointIdx;
+        bool hasStorageBufferExtension{}, hasPushConstants{}, multipleEntryPoints{};
+
+        for (size_t i{}; i < instructions.size(); i++) {
+            const auto &inst{instructions[i]};
+            switch (inst.opcode) {
+                case spv::Op::OpExtension:
+                    if (inst.words.subspan(1).cast<const char>().as_string(true) == "SPV_KHR_storage_buffer_storage_class")
+                        hasStorageBufferExtension = true;
+                    break;
+
+                case spv::Op::OpEntryPoint:
+                    if (entryPointIdx)
+                        multipleEntryPoints = true;
+                    entryPointIdx = i;
+                    break;
+
+                case spv::Op::OpDecorate:
+                    if (inst.words.size() == 4) {
+                        if (inst.words[2] == Word(spv::Decoration::XfbBuffer))
+                            xfbBuffers[inst.words[1]] = inst.words[3];
+                        else if (inst.words[2] == Word(spv::Decoration::XfbStride))
+                            xfbStrides[inst.words[1]] = inst.words[3];
+                        else if (inst.words[2] == Word(spv::Decoration::Offset))
+                            xfbOffsets[inst.words[1]] = inst.words[3];
+                        else if (inst.words[2] == Word(spv::Decoration::BuiltIn))
+                            builtIns[inst.words[3]] = inst.words[1];
+                    }
+                    break;
+
+                case spv::Op::OpTypeInt:
+                    if (!uintType && inst.words.size() == 4 && inst.words[2] == 32 && inst.words[3] == 0)
+                        uintType = inst.words[1];
+                    types.emplace(inst.words[1], inst);
+                    break;
+
+                case spv::Op::OpTypeBool:
+                    boolType = inst.words[1];
+                    break;
+
+                case spv::Op::OpTypeFloat:
+                case spv::Op::OpTypeVector:
+                case spv::Op::OpTypePointer:
+                    types.emplace(inst.words[1], inst);
+                    break;
+
+                case spv::Op::OpVariable:
+                    if (inst.words[3] == Word(spv::StorageClass::PushConstant))
+                        hasPushConstants = true;
+                    variables.emplace(inst.words[2], inst);
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        /**
+         * @brief An output which is captured by transform feedback
+         */
+        struct Varying {
+            u32 variable;
+            u32 type; //!< The type of the output, this is either a 32-bit float or a vector of them
+            u32 componentType;
+            u32 componentCount;
+            u32 buffer;
+            u32 strideWords;
+            u32 offsetWords;
+        };
+
+        std::vector<Varying> varyings;
+        std::array<bool, TransformFeedbackBufferCount> usedBuffers{};
+        bool supported{entryPointIdx && !multipleEntryPoints && instructions[*entryPointIdx].words[1] == Word(spv::ExecutionModel::Vertex) && !hasPushConstants};
+        for (auto [id, buffer] : xfbBuffers) {
+            if (!supported)
+                break;
+
+            auto variableIt{variables.find(id)}, strideIt{xfbStrides.find(id)}, offsetIt{xfbOffsets.find(id)};
+            if (variableIt == variables.end() || variableIt->second.words[3] != Word(spv::StorageClass::Output) || strideIt == xfbStrides.end() || offsetIt == xfbOffsets.end() || buffer >= TransformFeedbackBufferCount || strideIt->second % sizeof(u32) || offsetIt->second % sizeof(u32)) {
+                supported = false;
+                break;
+            }
+
+            auto pointerIt{types.find(variableIt->second.words[1])};
+            auto typeIt{pointerIt != types.end() ? types.find(pointerIt->second.words[3]) : types.end()};
+            if (typeIt == types.end()) {
+                supported = false;
+                break;
+            }
+
+            Varying varying{
+                .variable = id,
+                .type = typeIt->first,
+                .componentType = typeIt->first,
+                .componentCount = 1,
+                .buffer = buffer,
+                .strideWords = static_cast<u32>(strideIt->second / sizeof(u32)),
+                .offsetWords = static_cast<u32>(offsetIt->second / sizeof(u32)),
+            };
+
+            if (typeIt->second.opcode == spv::Op::OpTypeVector) {
+                varying.componentType = typeIt->second.words[2];
+                varying.componentCount = typeIt->second.words[3];
+                typeIt = types.find(varying.componentType);
+            }
+
+            // Only 32-bit float outputs are captured as those are the only ones the shader compiler declares
+            if (typeIt == types.end() || typeIt->second.opcode != spv::Op::OpTypeFloat || typeIt->second.words[2] != 32) {
+                supported = false;
+                break;
+            }
+
+            varyings.push_back(varying);
+            usedBuffers[buffer] = true;
+        }
+
+        // Declarations of transform feedback must be removed regardless of emulation as the module would be invalid without the TransformFeedback capability otherwise
+        auto isTransformFeedbackState{[](const Instruction &inst) {
+            switch (inst.opcode) {
+                case spv::Op::OpCapability:
+                    return inst.words[1] == Word(spv::Capability::TransformFeedback);
+                case spv::Op::OpExecutionMode:
+                    return inst.words[2] == Word(spv::ExecutionMode::Xfb);
+                case spv::Op::OpDecorate:
+                    return inst.words[2] == Word(spv::Decoration::XfbBuffer) || inst.words[2] == Word(spv::Decoration::XfbStride) || inst.words[2] == Word(spv::Decoration::Offset);
+                default:
+                    return false;
+            }
+        }};
+
+        if (!supported || varyings.empty()) {
+            std::vector<u32> output(spirv.begin(), spirv.begin() + HeaderWordCount);
+            for (const auto &inst : instructions)
+                if (!isTransformFeedbackState(inst))
+                    output.insert(output.end(), inst.words.begin(), inst.words.end());
+            spirv = std::move(output);
+            return false;
+        }
+
+        u32 nextId{spirv[BoundWordIndex]};
+        std::vector<u32> annotations, declarations;
+        std::vector<u32> interfaceIds; //!< The IDs of all new global variables that must be added to the interface of the entry point
+
+        auto emit{[](std::vector<u32> &output, spv::Op opcode, std::initializer_list<u32> operands) {
+            output.push_back(static_cast<u32>(operands.size() + 1) << spv::WordCountShift | Word(opcode));
+            output.insert(output.end(), operands);
+        }};
+
+        if (!uintType) {
+            uintType = nextId++;
+            emit(declarations, spv::Op::OpTypeInt, {*uintType, 32, 0});
+        }
+        if (!boolType) {
+            boolType = nextId++;
+            emit(declarations, spv::Op::OpTypeBool, {*boolType});
+        }
+
+        std::unordered_map<u32, u32> uintConstants; //!< A map from values to the IDs of the constants declared for them
+        auto constant{[&](u32 value) {
+            auto [it, inserted]{uintConstants.try_emplace(value, nextId)};
+            if (inserted)
+                emit(declarations, spv::Op::OpConstant, {*uintType, nextId++, value});
+            return it->second;
+        }};
+
+        u32 version{spirv[1]};
+        constexpr u32 Spirv14{0x00010400};
+        auto addVariable{[&](u32 pointerType, spv::StorageClass storageClass) {
+            u32 id{nextId++};
+            emit(declarations, spv::Op::OpVariable, {pointerType, id, Word(storageClass)});
+            // Prior to SPIR-V 1.4 only input and output variables can be a part of the interface
+            if (version >= Spirv14 || storageClass == spv::StorageClass::Input)
+                interfaceIds.push_back(id);
+            return id;
+        }};
+
+        u32 runtimeArrayType{nextId++}, bufferStructType{nextId++}, bufferPointerType{nextId++}, bufferElementPointerType{nextId++};
+        emit(declarations, spv::Op::OpTypeRuntimeArray, {runtimeArrayType, *uintType});
+        emit(declarations, spv::Op::OpTypeStruct, {bufferStructType, runtimeArrayType});
+        emit(declarations, spv::Op::OpTypePointer, {bufferPointerType, Word(spv::StorageClass::StorageBuffer), bufferStructType});
+        emit(declarations, spv::Op::OpTypePointer, {bufferElementPointerType, Word(spv::StorageClass::StorageBuffer), *uintType});
+        emit(annotations, spv::Op::OpDecorate, {runtimeArrayType, Word(spv::Decoration::ArrayStride), sizeof(u32)});
+        emit(annotations, spv::Op::OpDecorate, {bufferStructType, Word(spv::Decoration::Block)});
+        emit(annotations, spv::Op::OpMemberDecorate, {bufferStructType, 0, Word(spv::Decoration::Offset), 0});
+
+        std::array<u32, TransformFeedbackBufferCount> bufferVariables{};
+        for (u32 buffer{}; buffer < TransformFeedbackBufferCount; buffer++) {
+            if (!usedBuffers[buffer])
+                continue;
+
+            bufferVariables[buffer] = addVariable(bufferPointerType, spv::StorageClass::StorageBuffer);
+            emit(annotations, spv::Op::OpDecorate, {bufferVariables[buffer], Word(spv::Decoration::DescriptorSet), 0});
+            emit(annotations, spv::Op::OpDecorate, {bufferVariables[buffer], Word(spv::Decoration::Binding), firstBinding + buffer});
+        }
+
+        // The members of the block match the layout of TransformFeedbackParams
+        u32 paramsStructType{nextId++}, paramsPointerType{nextId++}, paramsElementPointerType{nextId++};
+        emit(declarations, spv::Op::OpTypeStruct, {paramsStructType, *uintType, *uintType, *uintType});
+        emit(declarations, spv::Op::OpTypePointer, {paramsPointerType, Word(spv::StorageClass::PushConstant), paramsStructType});
+        emit(declarations, spv::Op::OpTypePointer, {paramsElementPointerType, Word(spv::StorageClass::PushConstant), *uintType});
+        emit(annotations, spv::Op::OpDecorate, {paramsStructType, Word(spv::Decoration::Block)});
+        for (u32 member{}; member < 3; member++)
+            emit(annotations, spv::Op::OpMemberDecorate, {paramsStructType, member, Word(spv::Decoration::Offset), member * static_cast<u32>(sizeof(u32))});
+        u32 paramsVariable{addVariable(paramsPointerType, spv::StorageClass::PushConstant)};
+
+        /**
+         * @brief An input variable holding a built-in, the shader's own declaration is reused if it has one as a built-in can't be declared multiple times
+         */
+        struct BuiltInInput {
+            u32 variable;
+            u32 type; //!< The integer type of the variable, this may be signed in which case it must be bitcast
+        };
+
+        std::optional<u32> uintInputPointerType;
+        auto getBuiltIn{[&](spv::BuiltIn builtIn) -> BuiltInInput {
+            if (auto it{builtIns.find(Word(builtIn))}; it != builtIns.end())
+                if (auto variableIt{variables.find(it->second)}; variableIt != variables.end())
+                    if (auto pointerIt{types.find(variableIt->second.words[1])}; pointerIt != types.end())
+                        return {it->second, pointerIt->second.words[3]};
+
+            if (!uintInputPointerType) {
+                uintInputPointerType = nextId++;
+                emit(declarations, spv::Op::OpTypePointer, {*uintInputPointerType, Word(spv::StorageClass::Input), *uintType});
+            }
+
+            u32 variable{addVariable(*uintInputPointerType, spv::StorageClass::Input)};
+            emit(annotations, spv::Op::OpDecorate, {variable, Word(spv::Decoration::BuiltIn), Word(builtIn)});
+            return {variable, *uintType};
+        }};
+        auto vertexIndex{getBuiltIn(spv::BuiltIn::VertexIndex)}, instanceIndex{getBuiltIn(spv::BuiltIn::InstanceIndex)};
+
+        // Constants are declared ahead of time as they're referenced by every copy of the capture code
+        u32 zero{constant(0)}, one{constant(1)}, two{constant(2)};
+        for (const auto &varying : varyings) {
+            constant(varying.strideWords);
+            for (u32 component{}; component < varying.componentCount; component++)
+                constant(varying.offsetWords + component);
+        }
+
+        /**
+         * @brief Emits code that writes all captured outputs to their buffers, this replaces every return from the entry point
+         */
+        auto emitCapture{[&](std::vector<u32> &output) {
+            auto loadIndex{[&](const BuiltInInput &input) {
+                u32 id{nextId++};
+                emit(output, spv::Op::OpLoad, {input.type, id, input.variable});
+                if (input.type == *uintType)
+                    return id;
+
+                u32 castId{nextId++};
+                emit(output, spv::Op::OpBitcast, {*uintType, castId, id});
+                return castId;
+            }};
+
+            auto loadParam{[&](u32 member) {
+                u32 pointer{nextId++}, id{nextId++};
+                emit(output, spv::Op::OpAccessChain, {paramsElementPointerType, pointer, paramsVariable, member});
+                emit(output, spv::Op::OpLoad, {*uintType, id, pointer});
+                return id;
+            }};
+
+            auto operation{[&](spv::Op opcode, u32 type, u32 a, u32 b) {
+                u32 id{nextId++};
+                emit(output, opcode, {type, id, a, b});
+                return id;
+            }};
+
+            u32 vertex{operation(spv::Op::OpISub, *uintType, loadIndex(vertexIndex), loadParam(zero))};
+            u32 instance{operation(spv::Op::OpISub, *uintType, loadIndex(instanceIndex), loadParam(one))};
+            u32 vertexCount{loadParam(two)};
+            u32 slot{operation(spv::Op::OpIAdd, *uintType, operation(spv::Op::OpIMul, *uintType, instance, vertexCount), vertex)};
+
+            // Vertices beyond the count of the draw aren't captured and neither are any that don't entirely fit into all buffers
+            u32 condition{operation(spv::Op::OpULessThan, *boolType, vertex, vertexCount)};
+            for (const auto &varying : varyings) {
+                u32 length{nextId++};
+                emit(output, spv::Op::OpArrayLength, {*uintType, length, bufferVariables[varying.buffer], 0});
+                u32 end{operation(spv::Op::OpIMul, *uintType, operation(spv::Op::OpIAdd, *uintType, slot, one), constant(varying.strideWords))};
+                condition = operation(spv::Op::OpLogicalAnd, *boolType, condition, operation(spv::Op::OpULessThanEqual, *boolType, end, length));
+            }
+
+            u32 captureLabel{nextId++}, mergeLabel{nextId++};
+            emit(output, spv::Op::OpSelectionMerge, {mergeLabel, Word(spv::SelectionControlMask::MaskNone)});
+            emit(output, spv::Op::OpBranchConditional, {condition, captureLabel, mergeLabel});
+            emit(output, spv::Op::OpLabel, {captureLabel});
+
+            for (const auto &varying : varyings) {
+                u32 value{nextId++};
+                emit(output, spv::Op::OpLoad, {varying.type, value, varying.variable});
+
+                u32 base{operation(spv::Op::OpIMul, *uintType, slot, constant(varying.strideWords))};
+                for (u32 component{}; component < varying.componentCount; component++) {
+                    u32 componentValue{value};
+                    if (varying.componentCount > 1) {
+                        componentValue = nextId++;
+                        emit(output, spv::Op::OpCompositeExtract, {varying.componentType, componentValue, value, component});
+                    }
+
+                    u32 bits{nextId++};
+                    emit(output, spv::Op::OpBitcast, {*uintType, bits, componentValue});
+
+                    u32 index{operation(spv::Op::OpIAdd, *uintType, base, constant(varying.offsetWords + component))};
+                    u32 pointer{nextId++};
+                    emit(output, spv::Op::OpAccessChain, {bufferElementPointerType, pointer, bufferVariables[varying.buffer], zero, index});
+                    emit(output, spv::Op::OpStore, {pointer, bits});
+                }
+            }
+
+            emit(output, spv::Op::OpBranch, {mergeLabel});
+            emit(output, spv::Op::OpLabel, {mergeLabel});
+        }};
+
+        std::vector<u32> output;
+        output.reserve(spirv.size() + 256);
+        output.insert(output.end(), spirv.begin(), spirv.begin() + HeaderWordCount);
+
+        constexpr u32 Spirv13{0x00010300};
+        bool emittedExtension{hasStorageBufferExtension || version >= Spirv13}, emittedAnnotations{}, emittedDeclarations{};
+        u32 entryFunction{instructions[*entryPointIdx].words[2]};
+        std::optional<u32> currentFunction;
+
+        for (size_t i{}; i < instructions.size(); i++) {
+            const auto &inst{instructions[i]};
+            if (isTransformFeedbackState(inst))
+                continue;
+
+            if (!emittedExtension && inst.opcode != spv::Op::OpCapability) {
+                // The StorageBuffer storage class is only core as of SPIR-V 1.3
+                constexpr std::string_view Extension{"SPV_KHR_storage_buffer_storage_class"};
+                std::vector<u32> name(util::DivideCeil<size_t>(Extension.size() + 1, sizeof(u32)));
+                std::memcpy(name.data(), Extension.data(), Extension.size());
+                output.push_back(static_cast<u32>(name.size() + 1) << spv::WordCountShift | Word(spv::Op::OpExtension));
+                output.insert(output.end(), name.begin(), name.end());
+                emittedExtension = true;
+            }
+
+            if (!emittedAnnotations && inst.opcode >= spv::Op::OpTypeVoid && inst.opcode <= spv::Op::OpTypeForwardPointer) {
+                output.insert(output.end(), annotations.begin(), annotations.end());
+                emittedAnnotations = true;
+            }
+
+            if (inst.opcode == spv::Op::OpFunction) {
+                if (!emittedDeclarations) {
+                    output.insert(output.end(), declarations.begin(), declarations.end());
+                    emittedDeclarations = true;
+                }
+                currentFunction = inst.words[2];
+            } else if (inst.opcode == spv::Op::OpFunctionEnd) {
+                currentFunction.reset();
+            }
+
+            if (i == *entryPointIdx) {
+                output.push_back(static_cast<u32>(inst.words.size() + interfaceIds.size()) << spv::WordCountShift | Word(spv::Op::OpEntryPoint));
+                output.insert(output.end(), inst.words.begin() + 1, inst.words.end());
+                output.insert(output.end(), interfaceIds.begin(), interfaceIds.end());
+                continue;
+            }
+
+            if (inst.opcode == spv::Op::OpReturn && currentFunction == entryFunction)
+                emitCapture(output);
+
+            output.insert(output.end(), inst.words.begin(), inst.words.end());
+        }
+
+        output[BoundWordIndex] = nextId;
+        spirv = std::move(output);
+        return true;
+    }
+}
@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common.h>
+
+/**
+ * @brief Transformations applied to the SPIR-V emitted by the shader compiler, these operate on the binary directly as the compiler's IR is gone by the time the module is emitted
+ */
+namespace skyline::gpu::spirv {
+    /**
+     * @brief Rewrites the uniform buffer at the supplied binding of descriptor set 0 into a push constant block that only covers the range used by the shader
+     * @param offset The offset of the block inside the push constant range of the pipeline, this must be aligned to 16 bytes
+     * @param size The size of the range of the buffer used by the shader, the shader must not access the buffer beyond this
+     * @return If the buffer was promoted, the module is left untouched if the buffer is accessed in any way other than direct loads of its elements or if it already has a push constant block
+     */
+    bool PromoteUniformBufferToPushConstants(std::vector<u32> &spirv, u32 binding, u32 offset, u32 size);
+
+    /**
+     * @return If the module declares a push constant block
+     */
+    bool HasPushConstantBlock(span<const u32> spirv);
+
+    /**
+     * @brief Performs simple optimizations on the module which reduce the work done by driver compilers that don't optimize well on their own
+     * @details Scalar integer and boolean operations on constants are folded into constants, side-effect free instructions with unused results are eliminated and all debug instructions are stripped
+     * @note The module is left untouched if it's malformed
+     */
+    void OptimizeModule(std::vector<u32> &spirv);
+
+    /**
+     * @brief The parameters of a draw that are supplied to shaders emulating transform feedback through push constants at offset 0
+     */
+    struct TransformFeedbackParams {
+        u32 firstVertex;
+        u32 firstInstance;
+        u32 vertexCount; //!< The amount of vertices in every instance of the draw, 0 disables capture for draws where the order of vertex shader invocations doesn't match that of the captured vertices
+        u32 _pad_;
+    };
+
+    constexpr u32 TransformFeedbackBufferCount{4}; //!< The amount of storage buffer bindings that are used by a module emulating transform feedback
+
+    /**
+     * @brief Rewrites a vertex shader with outputs captured by transform feedback to write them to storage buffers at the end of every invocation instead
+     * @param firstBinding The first binding of the storage buffers in descriptor set 0, buffer N is at `firstBinding + N`
+     * @return If the outputs are written to storage buffers, transform feedback state is always stripped from the module so it's valid on devices without the feature
+     * @note The vertex index is used as the index of the captured vertex, so this is only accurate for non-indexed draws of list topologies
+     */
+    bool EmulateTransformFeedback(std::vector<u32> &spirv, u32 firstBinding);
+}
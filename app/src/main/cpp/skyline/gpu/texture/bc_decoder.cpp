@@ -8,6 +8,9 @@
 
 #include <fmt/printf.h>
 #include <common.h>
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 #ifdef NDEBUG
 #define ASSERT(condition)
@@ -41,6 +44,24 @@ namespace {
                 }
             }
 
+#if defined(__ARM_NEON)
+            if (dstBpp == 4 && (x + BlockWidth) <= dstW && (y + BlockHeight) <= dstH) {
+                // Full blocks are decoded a row at a time by expanding the 2-bit indices into byte offsets into the palette and doing a table lookup
+                static constexpr int8_t IndexShifts[16] = {0, 0, 0, 0, -2, -2, -2, -2, -4, -4, -4, -4, -6, -6, -6, -6};
+                static constexpr uint8_t ChannelOffsets[16] = {0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3};
+                const uint32_t palette[4] = {c[0].pack8888(), c[1].pack8888(), c[2].pack8888(), c[3].pack8888()};
+
+                uint8x16_t paletteBytes = vreinterpretq_u8_u32(vld1q_u32(palette));
+                int8x16_t indexShifts = vld1q_s8(IndexShifts);
+                uint8x16_t channelOffsets = vld1q_u8(ChannelOffsets);
+                for (int j = 0; j < BlockHeight; j++) {
+                    uint8x16_t indices = vandq_u8(vshlq_u8(vdupq_n_u8(static_cast<uint8_t>(idx >> (j * 8))), indexShifts), vdupq_n_u8(0x3));
+                    vst1q_u8(dst + (j * dstPitch), vqtbl1q_u8(paletteBytes, vaddq_u8(vshlq_n_u8(indices, 2), channelOffsets)));
+                }
+                return;
+            }
+#endif
+
             for (int j = 0; j < BlockHeight && (y + j) < dstH; j++) {
                 size_t dstOffset = j * dstPitch;
                 size_t idxOffset = j * BlockHeight;
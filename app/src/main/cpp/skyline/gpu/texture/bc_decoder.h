@@ -6,6 +6,8 @@
 #include <cstdint>
 
 namespace bcn {
+    constexpr size_t BlockDimension{4}; //!< The width and height of a single BCn block in pixels, any slice of an image starting at a row of blocks can be decoded independently
+
     /**
      * @brief Decodes a BC1 encoded image to R8G8B8A8
      */
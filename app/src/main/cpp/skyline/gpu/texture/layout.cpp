@@ -1,6 +1,9 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 #include "layout.h"
 
 namespace skyline::gpu::texture {
@@ -10,6 +13,7 @@ namespace skyline::gpu::texture {
     constexpr size_t GobWidth{64}; //!< The width of a GOB in bytes
     constexpr size_t GobHeight{8}; //!< The height of a GOB in lines
     constexpr size_t SectorLinesInGob{(GobWidth / SectorWidth) * GobHeight}; //!< The number of lines of sectors inside a GOB
+    constexpr size_t GobSize{GobWidth * GobHeight}; //!< The size of a GOB in bytes
 
     size_t GetBlockLinearLayerSize(Dimensions dimensions, size_t formatBlockWidth, size_t formatBlockHeight, size_t formatBpb, size_t gobBlockHeight, size_t gobBlockDepth) {
         size_t robLineWidth{util::DivideCeil<size_t>(dimensions.width, formatBlockWidth)}; //!< The width of the ROB in terms of format blocks
@@ -88,6 +92,112 @@ namespace skyline::gpu::texture {
         return mipLevels;
     }
 
+    /**
+     * @return The X-axis offset in bytes of the sector at the supplied index inside a GOB
+     */
+    constexpr size_t GobSectorX(size_t index) {
+        return ((index << 3) & 0b10000) | ((index << 1) & 0b100000); // Morton-Swizzle on the X-axis
+    }
+
+    /**
+     * @return The Y-axis offset in lines of the sector at the supplied index inside a GOB
+     */
+    constexpr size_t GobSectorY(size_t index) {
+        return ((index >> 1) & 0b110) | (index & 0b1); // Morton-Swizzle on the Y-axis
+    }
+
+    /**
+     * @brief Copies an entire GOB between its swizzled representation and a linear surface
+     * @param linearStride The stride of a line in the linear surface in bytes
+     * @note The GOB **must** be fully contained in the linear surface, partial GOBs at the edges of the surface need to be handled separately
+     */
+    template<bool BlockLinearToLinear>
+    __attribute__((always_inline)) inline void CopyGob(u8 *linearGob, u8 *gob, size_t linearStride) {
+        #if defined(__ARM_NEON)
+        // Every 4 sequential sectors (64 bytes) are transferred with a single multi-register load/store on the swizzled side
+        #pragma clang loop unroll(full)
+        for (size_t index{}; index < SectorLinesInGob; index += 4) {
+            u8 *swizzled{gob + (index * SectorWidth)};
+            if constexpr (BlockLinearToLinear) {
+                uint8x16x4_t sectors{vld1q_u8_x4(swizzled)};
+                vst1q_u8(linearGob + (GobSectorY(index) * linearStride) + GobSectorX(index), sectors.val[0]);
+                vst1q_u8(linearGob + (GobSectorY(index + 1) * linearStride) + GobSectorX(index + 1), sectors.val[1]);
+                vst1q_u8(linearGob + (GobSectorY(index + 2) * linearStride) + GobSectorX(index + 2), sectors.val[2]);
+                vst1q_u8(linearGob + (GobSectorY(index + 3) * linearStride) + GobSectorX(index + 3), sectors.val[3]);
+            } else {
+                uint8x16x4_t sectors{
+                    vld1q_u8(linearGob + (GobSectorY(index) * linearStride) + GobSectorX(index)),
+                    vld1q_u8(linearGob + (GobSectorY(index + 1) * linearStride) + GobSectorX(index + 1)),
+                    vld1q_u8(linearGob + (GobSectorY(index + 2) * linearStride) + GobSectorX(index + 2)),
+                    vld1q_u8(linearGob + (GobSectorY(index + 3) * linearStride) + GobSectorX(index + 3)),
+                };
+                vst1q_u8_x4(swizzled, sectors);
+            }
+        }
+        #else
+        #pragma clang loop unroll(full)
+        for (size_t index{}; index < SectorLinesInGob; index++) {
+            u8 *linearSector{linearGob + (GobSectorY(index) * linearStride) + GobSectorX(index)};
+            if constexpr (BlockLinearToLinear)
+                std::memcpy(linearSector, gob + (index * SectorWidth), SectorWidth);
+            else
+                std::memcpy(gob + (index * SectorWidth), linearSector, SectorWidth);
+        }
+        #endif
+    }
+
+    /**
+     * @brief Copies a block which is entirely inside the surface on the X and Y axes GOB-by-GOB
+     * @tparam BlockHeight The height of the block in GOBs, this is a template parameter for common block heights to allow the loop to be fully unrolled
+     * @return A pointer to the swizzled data following the block
+     */
+    template<bool BlockLinearToLinear, size_t BlockHeight>
+    u8 *CopyFullBlock(u8 *linearBlock, u8 *block, size_t linearStride, size_t blockDepth, size_t gobYOffset, size_t gobZOffset) {
+        for (size_t gobZ{}; gobZ < blockDepth; gobZ++) {
+            u8 *linearGob{linearBlock};
+            #pragma clang loop unroll(full)
+            for (size_t gobY{}; gobY < BlockHeight; gobY++) {
+                CopyGob<BlockLinearToLinear>(linearGob, block, linearStride);
+                block += GobSize;
+                linearGob += gobYOffset;
+            }
+            linearBlock += gobZOffset;
+        }
+        return block;
+    }
+
+    /**
+     * @brief A runtime dispatcher for CopyFullBlock with the block heights that are valid on the guest
+     */
+    template<bool BlockLinearToLinear>
+    u8 *CopyFullBlock(u8 *linearBlock, u8 *block, size_t linearStride, size_t blockHeight, size_t blockDepth, size_t gobYOffset, size_t gobZOffset) {
+        switch (blockHeight) {
+            case 1:
+                return CopyFullBlock<BlockLinearToLinear, 1>(linearBlock, block, linearStride, blockDepth, gobYOffset, gobZOffset);
+            case 2:
+                return CopyFullBlock<BlockLinearToLinear, 2>(linearBlock, block, linearStride, blockDepth, gobYOffset, gobZOffset);
+            case 4:
+                return CopyFullBlock<BlockLinearToLinear, 4>(linearBlock, block, linearStride, blockDepth, gobYOffset, gobZOffset);
+            case 8:
+                return CopyFullBlock<BlockLinearToLinear, 8>(linearBlock, block, linearStride, blockDepth, gobYOffset, gobZOffset);
+            case 16:
+                return CopyFullBlock<BlockLinearToLinear, 16>(linearBlock, block, linearStride, blockDepth, gobYOffset, gobZOffset);
+            case 32:
+                return CopyFullBlock<BlockLinearToLinear, 32>(linearBlock, block, linearStride, blockDepth, gobYOffset, gobZOffset);
+            default:
+                for (size_t gobZ{}; gobZ < blockDepth; gobZ++) {
+                    u8 *linearGob{linearBlock};
+                    for (size_t gobY{}; gobY < blockHeight; gobY++) {
+                        CopyGob<BlockLinearToLinear>(linearGob, block, linearStride);
+                        block += GobSize;
+                        linearGob += gobYOffset;
+                    }
+                    linearBlock += gobZOffset;
+                }
+                return block;
+        }
+    }
+
     /**
      * @brief Copies pixel data between a linear and blocklinear texture
      * @tparam BlockLinearToLinear Whether to copy from a blocklinear texture to a linear texture or a linear texture to a blocklinear texture
@@ -148,16 +258,21 @@ namespace skyline::gpu::texture {
             }};
 
             for (size_t block{}; block < robWidthBlocks; block++) { // Every ROB contains `surfaceWidthBlocks` blocks (excl. padding block)
-                deswizzleBlock(linearRob, [&](u8 *linearSector, size_t) __attribute__((always_inline)) {
-                    if constexpr (BlockLinearToLinear)
-                        std::memcpy(linearSector, sector, SectorWidth);
-                    else
-                        std::memcpy(sector, linearSector, SectorWidth);
-                    sector += SectorWidth; // `sectorWidth` bytes are of sequential image data
-                });
+                if constexpr (!isLastRob) {
+                    // Blocks which aren't in the last ROB or the padding block consist solely of complete GOBs which can be copied with a specialized kernel
+                    sector = CopyFullBlock<BlockLinearToLinear>(linearRob, sector, robWidthUnalignedBytes, blockHeight, blockDepth, gobYOffset, gobZOffset);
+                    sector += blockPaddingZ; // Skip over any padding Z-axis GOBs
+                } else {
+                    deswizzleBlock(linearRob, [&](u8 *linearSector, size_t) __attribute__((always_inline)) {
+                        if constexpr (BlockLinearToLinear)
+                            std::memcpy(linearSector, sector, SectorWidth);
+                        else
+                            std::memcpy(sector, linearSector, SectorWidth);
+                        sector += SectorWidth; // `sectorWidth` bytes are of sequential image data
+                    });
 
-                if constexpr (isLastRob)
                     sector += blockPaddingY; // Skip over any padding at the end of this block
+                }
                 linearRob += GobWidth; // Increment the linear block to the next block (As Block Width = 1 GOB Width)
             }
 
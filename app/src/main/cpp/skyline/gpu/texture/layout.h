@@ -13,6 +13,14 @@ namespace skyline::gpu::texture {
                                    size_t formatBlockWidth, size_t formatBlockHeight, size_t formatBpb,
                                    size_t gobBlockHeight, size_t gobBlockDepth);
 
+    /**
+     * @return The height of a ROB (Row of Blocks) of a block-linear surface in pixels, every ROB of a 2D surface is contiguous in memory and has the same layout as a surface with the height of a single ROB
+     */
+    constexpr size_t GetBlockLinearRobHeight(size_t formatBlockHeight, size_t gobBlockHeight) {
+        constexpr size_t GobHeight{8}; //!< The height of a GOB in lines
+        return formatBlockHeight * GobHeight * gobBlockHeight;
+    }
+
     /**
      * @param isMultiLayer If the texture has more than one layer, a multi-layer texture requires alignment to a block at layer end
      * @return The size of a layer of the specified block-linear surface in bytes
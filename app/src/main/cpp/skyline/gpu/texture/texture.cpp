@@ -1,11 +1,13 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <boost/functional/hash.hpp>
 #include <gpu.h>
 #include <kernel/memory.h>
 #include <kernel/types/KProcess.h>
 #include <common/trace.h>
 #include <common/settings.h>
+#include <common/perf_stats.h>
 #include "texture.h"
 #include "layout.h"
 #include "adreno_aliasing.h"
@@ -78,16 +80,32 @@ namespace skyline::gpu {
 
     TextureView::TextureView(std::shared_ptr<Texture> texture, vk::ImageViewType type, vk::ImageSubresourceRange range, texture::Format format, vk::ComponentMapping mapping) : texture(std::move(texture)), type(type), format(format), mapping(mapping), range(range) {}
 
-    Texture::TextureViewStorage::TextureViewStorage(vk::ImageViewType type, texture::Format format, vk::ComponentMapping mapping, vk::ImageSubresourceRange range, vk::raii::ImageView &&vkView) : type(type), format(format), mapping(mapping), range(range), vkView(std::move(vkView)) {}
+    Texture::TextureViewKey::TextureViewKey(vk::ImageViewType type, texture::Format format, vk::ComponentMapping mapping, const vk::ImageSubresourceRange &range)
+        : format(format),
+          packed(static_cast<u64>(type) |
+                 (static_cast<u64>(mapping.r) << 8) | (static_cast<u64>(mapping.g) << 12) | (static_cast<u64>(mapping.b) << 16) | (static_cast<u64>(mapping.a) << 20) |
+                 (static_cast<u64>(static_cast<VkImageAspectFlags>(range.aspectMask) & 0xFF) << 24) |
+                 (static_cast<u64>(range.baseMipLevel) << 32)),
+          levelCount(range.levelCount),
+          baseArrayLayer(range.baseArrayLayer),
+          layerCount(range.layerCount) {}
+
+    size_t Texture::TextureViewKeyHash::operator()(const TextureViewKey &key) const {
+        // Equal formats may not share the same underlying object so the Vulkan format is hashed rather than the pointer
+        size_t hash{key.format ? static_cast<size_t>(key.format->vkFormat) : 0};
+        boost::hash_combine(hash, key.packed);
+        boost::hash_combine(hash, key.levelCount);
+        boost::hash_combine(hash, key.baseArrayLayer);
+        boost::hash_combine(hash, key.layerCount);
+        return hash;
+    }
 
     vk::ImageView TextureView::GetView() {
-        if (vkView)
+        if (vkView && viewGeneration == texture->backingGeneration)
             return vkView;
 
-        auto it{std::find_if(texture->views.begin(), texture->views.end(), [this](const Texture::TextureViewStorage &view) {
-            return view.type == type && view.format == format && view.mapping == mapping && view.range == range;
-        })};
-        if (it == texture->views.end()) {
+        auto &storage{texture->views[Texture::TextureViewKey{type, format, mapping, range}]};
+        if (!*storage.vkView) {
             vk::ImageViewCreateInfo createInfo{
                 .image = texture->GetBacking(),
                 .viewType = type,
@@ -96,10 +114,11 @@ namespace skyline::gpu {
                 .subresourceRange = range,
             };
 
-            it = texture->views.emplace(texture->views.end(), type, format, mapping, range, vk::raii::ImageView{texture->gpu.vkDevice, createInfo});
+            storage.vkView = vk::raii::ImageView{texture->gpu.vkDevice, createInfo};
         }
 
-        return vkView = *it->vkView;
+        viewGeneration = texture->backingGeneration;
+        return vkView = *storage.vkView;
     }
 
     void TextureView::lock() {
@@ -129,7 +148,9 @@ namespace skyline::gpu {
             u8 *alignedData{util::AlignDown(mapping.data(), constant::PageSize)};
             size_t alignedSize{static_cast<size_t>(util::AlignUp(mapping.data() + mapping.size(), constant::PageSize) - alignedData)};
 
-            alignedMirror = gpu.state.process->memory.CreateMirror(span<u8>{alignedData, alignedSize});
+            auto guestMirror{gpu.mirror.Acquire(span<u8>{alignedData, alignedSize})};
+            alignedMirror = guestMirror.mirror;
+            mirrorMapping = std::move(guestMirror.mapping);
             mirror = alignedMirror.subspan(static_cast<size_t>(mapping.data() - alignedData), mapping.size());
         } else {
             std::vector<span<u8>> alignedMappings;
@@ -149,12 +170,48 @@ namespace skyline::gpu {
             totalSize += backMapping.size();
             alignedMappings.emplace_back(backMapping.data(), util::AlignUp(backMapping.size(), constant::PageSize));
 
-            alignedMirror = gpu.state.process->memory.CreateMirrors(alignedMappings);
+            auto guestMirror{gpu.mirror.Acquire(alignedMappings)};
+            alignedMirror = guestMirror.mirror;
+            mirrorMapping = std::move(guestMirror.mapping);
             mirror = alignedMirror.subspan(static_cast<size_t>(frontMapping.data() - alignedData), totalSize);
         }
 
         // We can't just capture `this` in the lambda since the lambda could exceed the lifetime of the buffer
         std::weak_ptr<Texture> weakThis{weak_from_this()};
+
+        nce::NCE::PageWriteCallback pageWriteCallback;
+        if (CanSynchronizePartially()) {
+            dirtyPages.resize(alignedMirror.size() / constant::PageSize);
+            pageWriteCallback = [weakThis, alignedData = util::AlignDown(mappings.front().data(), constant::PageSize)](u8 *page) {
+                auto texture{weakThis.lock()};
+                if (!texture)
+                    return false;
+
+                std::unique_lock stateLock{texture->stateMutex, std::try_to_lock};
+                if (!stateLock)
+                    return false;
+
+                // Only writes to clean textures or ones which are already partially dirty can be tracked a page at a time
+                if (texture->dirtyState == DirtyState::GpuDirty || (texture->dirtyState == DirtyState::CpuDirty && texture->dirtyPageCount == 0))
+                    return false;
+
+                auto index{static_cast<size_t>(page - alignedData) / constant::PageSize};
+                if (index >= texture->dirtyPages.size())
+                    return false;
+
+                if (!texture->dirtyPages[index]) {
+                    if (texture->dirtyPageCount >= texture->dirtyPages.size() / PartialSyncDirtyPageDivisor)
+                        return false; // A large part of the texture is being written, so it's cheaper to synchronize the entire texture than to keep trapping every page
+
+                    texture->dirtyPages[index] = true;
+                    texture->dirtyPageCount++;
+                }
+
+                texture->dirtyState = DirtyState::CpuDirty;
+                return true;
+            };
+        }
+
         trapHandle = gpu.state.nce->CreateTrap(mappings, [weakThis] {
             auto texture{weakThis.lock()};
             if (!texture)
@@ -207,6 +264,11 @@ namespace skyline::gpu {
             if (texture->cycle)
                 return false;
 
+            if (texture->scale != 1.0f)
+                texture->gpu.texture.MarkCpuReadback(texture->guest->mappings.front().data());
+
+            texture->cpuReadbackCount++;
+            texture->MarkContentsObserved();
             texture->SynchronizeGuest(false, true); // We can skip trapping since the caller will do it
             return true;
         }, [weakThis] {
@@ -221,11 +283,20 @@ namespace skyline::gpu {
                 return false;
 
             if (texture->dirtyState != DirtyState::GpuDirty) {
+                texture->ClearDirtyPages(); // The write couldn't be tracked at page granularity so the entire texture needs to be synchronized
                 texture->dirtyState = DirtyState::CpuDirty;
                 return true; // If the texture is already CPU dirty or we can transition it to being CPU dirty then we don't need to do anything
             }
 
-            if (texture->accumulatedGuestWaitTime > SkipReadbackHackWaitTimeThreshold && *texture->gpu.state.settings->enableTextureReadbackHack) {
+            if (texture->IsCpuOverwriteLikely()) {
+                // The GPU written data is expected to be entirely overwritten so reading it back would be wasted, the CPU written data will be uploaded on the next usage of the texture
+                texture->cpuOverwriteCount++;
+                texture->dirtyState = DirtyState::CpuDirty;
+                return true;
+            }
+
+            // The hack discards the CPU writes entirely, so it's limited to textures that the CPU has never read GPU written data from
+            if (texture->cpuReadbackCount == 0 && texture->accumulatedGuestWaitTime > SkipReadbackHackWaitTimeThreshold && *texture->gpu.state.settings->enableTextureReadbackHack) {
                 texture->dirtyState = DirtyState::Clean;
                 return true;
             }
@@ -237,12 +308,418 @@ namespace skyline::gpu {
             if (texture->cycle)
                 return false;
 
+            texture->cpuOverwriteCount++;
             texture->SynchronizeGuest(true, true); // We need to assume the texture is dirty since we don't know what the guest is writing
             return true;
+        }, pageWriteCallback);
+    }
+
+    /**
+     * @brief The minimum size of a texture for it to be deswizzled on the GPU, smaller textures are cheaper to deswizzle on the CPU than the overhead of a dispatch
+     */
+    constexpr static size_t GpuDeswizzleThreshold{512 * 1024};
+
+    bool Texture::CanDeswizzleOnGpu() {
+        if (!*gpu.state.settings->gpuTextureDeswizzle || surfaceSize < GpuDeswizzleThreshold)
+            return false;
+
+        // The shader copies a word at a time and doesn't handle 3D blocks or any format conversion
+        if (guest->tileConfig.mode != texture::TileMode::Block || guest->format != format || tiling != vk::ImageTiling::eOptimal || guest->format->bpb % sizeof(u32) != 0)
+            return false;
+
+        return std::all_of(mipLayouts.begin(), mipLayouts.end(), [](const texture::MipLevelLayout &level) {
+            return level.dimensions.depth == 1 && level.blockDepth == 1;
         });
     }
 
-    std::shared_ptr<memory::StagingBuffer> Texture::SynchronizeHostImpl() {
+    bool Texture::SupportsLinearTiling() {
+        if (scale != 1.0f || levelCount != 1 || layerCount != 1 || guest->GetImageType() != vk::ImageType::e2D || format != guest->format || guest->tileConfig.mode == texture::TileMode::Block)
+            return false;
+
+        // Linear images can only be used when the host supports all of the texture's usages with linear tiling
+        vk::FormatFeatureFlags requiredFeatures{vk::FormatFeatureFlagBits::eSampledImage | vk::FormatFeatureFlagBits::eTransferSrc | vk::FormatFeatureFlagBits::eTransferDst};
+        if (usage & vk::ImageUsageFlagBits::eColorAttachment)
+            requiredFeatures |= vk::FormatFeatureFlagBits::eColorAttachment;
+
+        return (gpu.vkPhysicalDevice.getFormatProperties(*format).linearTilingFeatures & requiredFeatures) == requiredFeatures;
+    }
+
+    bool Texture::SupportsHostImageCopy(const vk::ImageCreateInfo &createInfo) {
+        try {
+            // Host copies may require disabling framebuffer compression, the driver reports if that's the case for the image with the performance query
+            auto properties{gpu.vkPhysicalDevice.getImageFormatProperties2<vk::ImageFormatProperties2, vk::HostImageCopyDevicePerformanceQueryEXT>(vk::PhysicalDeviceImageFormatInfo2{
+                .format = createInfo.format,
+                .type = createInfo.imageType,
+                .tiling = createInfo.tiling,
+                .usage = createInfo.usage | vk::ImageUsageFlagBits::eHostTransferEXT,
+                .flags = createInfo.flags,
+            })};
+            return properties.get<vk::HostImageCopyDevicePerformanceQueryEXT>().optimalDeviceAccess;
+        } catch (const vk::SystemError &) {
+            return false; // The format doesn't support host copies with this usage
+        }
+    }
+
+    vk::ImageCreateInfo Texture::GetImageCreateInfo(vk::ImageTiling pTiling, vk::ImageLayout initialLayout) {
+        vk::ImageCreateInfo createInfo{
+            .flags = flags,
+            .imageType = guest->GetImageType(),
+            .format = *format,
+            .extent = dimensions,
+            .mipLevels = levelCount,
+            .arrayLayers = layerCount,
+            .samples = vk::SampleCountFlagBits::e1,
+            .tiling = pTiling,
+            .usage = usage,
+            .sharingMode = vk::SharingMode::eExclusive,
+            .queueFamilyIndexCount = 1,
+            .pQueueFamilyIndices = &gpu.vkQueueFamilyIndex,
+            .initialLayout = initialLayout,
+        };
+
+        if (pTiling == vk::ImageTiling::eOptimal) {
+            hostImageCopy = gpu.traits.supportsHostImageCopy && SupportsHostImageCopy(createInfo);
+            if (hostImageCopy)
+                createInfo.usage |= vk::ImageUsageFlagBits::eHostTransferEXT;
+        }
+
+        return createInfo;
+    }
+
+    std::optional<memory::Image> Texture::AllocateLinearImage(vk::ImageLayout initialLayout) {
+        auto image{gpu.memory.AllocateMappedImage(GetImageCreateInfo(vk::ImageTiling::eLinear, initialLayout))};
+
+        // Linear synchronization assumes that rows are tightly packed, if the host pads rows then an optimal image must be used instead
+        auto subresourceLayout{(*gpu.vkDevice).getImageSubresourceLayout(image.vkImage, vk::ImageSubresource{.aspectMask = format->vkAspect}, *gpu.vkDevice.getDispatcher())};
+        if (subresourceLayout.offset != 0 || subresourceLayout.rowPitch != format->GetSize(dimensions.width, 1))
+            return std::nullopt;
+
+        return image;
+    }
+
+    void Texture::MigrateToLinearTiling() {
+        if (tiling != vk::ImageTiling::eOptimal || linearMigrationAttempted || cpuUploadCount < LinearMigrationThreshold)
+            return;
+
+        linearMigrationAttempted = true;
+        if (!SupportsLinearTiling())
+            return;
+
+        std::optional<memory::Image> image;
+        try {
+            image = AllocateLinearImage(vk::ImageLayout::eUndefined);
+        } catch (const vk::SystemError &e) {
+            // Host-visible device-local memory is only guaranteed to exist on a UMA, the texture stays optimal otherwise
+            Logger::Debug("Failed to allocate linear backing for CPU written texture: {}", e.what());
+        }
+
+        if (!image)
+            return;
+
+        SwapBacking(std::move(*image));
+        tiling = vk::ImageTiling::eLinear;
+
+        // All views into the prior backing are invalid after it's been destroyed, they're recreated for the new backing on their next use
+        for (auto &[key, storage] : views)
+            if (*storage.vkView)
+                staleViews.emplace_back(std::move(storage.vkView));
+        backingGeneration++;
+        PerfStats::Increment(PerfStats::Counter::TextureLinearMigrations);
+    }
+
+    void Texture::PromoteToMutableFormat() {
+        mutableFormatPending = false;
+        if (flags & vk::ImageCreateFlagBits::eMutableFormat || tiling != vk::ImageTiling::eOptimal)
+            return;
+
+        WaitOnBacking();
+        WaitOnFence();
+
+        TRACE_EVENT("gpu", "Texture::PromoteToMutableFormat");
+
+        flags |= vk::ImageCreateFlagBits::eMutableFormat;
+        auto image{gpu.memory.AllocateImage(GetImageCreateInfo(tiling, vk::ImageLayout::eUndefined), this, resourceClass)};
+        auto newLayout{layout};
+
+        if (layout != vk::ImageLayout::eUndefined && layout != vk::ImageLayout::ePreinitialized) {
+            auto lCycle{gpu.scheduler.Submit([&](vk::raii::CommandBuffer &commandBuffer) {
+                RecordBackingCopy(commandBuffer, GetBacking(), image.vkImage);
+            })};
+
+            // The prior backing must outlive the copy from it, it's destroyed alongside the cycle rather than being waited on here
+            lCycle->AttachObject(std::make_shared<BackingType>(std::move(backing)));
+            backing = std::move(image);
+            cycle = lCycle;
+        } else {
+            backing = std::move(image);
+            newLayout = vk::ImageLayout::eUndefined;
+        }
+
+        layout = newLayout;
+        for (auto &[key, storage] : views)
+            if (*storage.vkView)
+                staleViews.emplace_back(std::move(storage.vkView));
+        backingGeneration++;
+        PerfStats::Increment(PerfStats::Counter::TextureMutableFormatPromotions);
+    }
+
+    void Texture::RecordBackingCopy(const vk::raii::CommandBuffer &commandBuffer, vk::Image source, vk::Image destination) {
+        vk::ImageSubresourceRange subresource{
+            .aspectMask = format->vkAspect,
+            .levelCount = levelCount,
+            .layerCount = layerCount,
+        };
+
+        std::array<vk::ImageMemoryBarrier, 2> barriers{
+            vk::ImageMemoryBarrier{
+                .image = source,
+                .srcAccessMask = vk::AccessFlagBits::eMemoryWrite,
+                .dstAccessMask = vk::AccessFlagBits::eTransferRead,
+                .oldLayout = layout,
+                .newLayout = vk::ImageLayout::eTransferSrcOptimal,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .subresourceRange = subresource,
+            },
+            vk::ImageMemoryBarrier{
+                .image = destination,
+                .srcAccessMask = vk::AccessFlagBits::eNoneKHR,
+                .dstAccessMask = vk::AccessFlagBits::eTransferWrite,
+                .oldLayout = vk::ImageLayout::eUndefined,
+                .newLayout = vk::ImageLayout::eTransferDstOptimal,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .subresourceRange = subresource,
+            },
+        };
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, barriers);
+
+        boost::container::small_vector<vk::ImageCopy, 16> copies;
+        for (u32 level{}; level < levelCount; level++) {
+            vk::ImageSubresourceLayers subresourceLayers{
+                .aspectMask = format->vkAspect,
+                .mipLevel = level,
+                .layerCount = layerCount,
+            };
+            copies.push_back(vk::ImageCopy{
+                .srcSubresource = subresourceLayers,
+                .dstSubresource = subresourceLayers,
+                .extent = {
+                    std::max(dimensions.width >> level, 1U),
+                    std::max(dimensions.height >> level, 1U),
+                    std::max(dimensions.depth >> level, 1U),
+                },
+            });
+        }
+        commandBuffer.copyImage(source, vk::ImageLayout::eTransferSrcOptimal, destination, vk::ImageLayout::eTransferDstOptimal, copies);
+
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eAllCommands, {}, {}, {}, vk::ImageMemoryBarrier{
+            .image = destination,
+            .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+            .dstAccessMask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite,
+            .oldLayout = vk::ImageLayout::eTransferDstOptimal,
+            .newLayout = layout,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .subresourceRange = subresource,
+        });
+    }
+
+    bool Texture::CanSynchronizePartially() {
+        // Pages are mapped to guest data relative to a single mapping and the ROBs are copied directly to the image without any format conversion or rescaling
+        if (guest->mappings.size() != 1 || guest->tileConfig.mode != texture::TileMode::Block || guest->format != format || tiling != vk::ImageTiling::eOptimal || scale != 1.0f)
+            return false;
+
+        return std::all_of(mipLayouts.begin(), mipLayouts.end(), [](const texture::MipLevelLayout &level) {
+            return level.dimensions.depth == 1;
+        });
+    }
+
+    void Texture::ClearDirtyPages() {
+        if (dirtyPageCount) {
+            std::fill(dirtyPages.begin(), dirtyPages.end(), false);
+            dirtyPageCount = 0;
+        }
+    }
+
+    /**
+     * @brief The minimum decoded size of a texture for it to be stored in the transcode cache, smaller textures are faster to decode than to read from disk
+     */
+    constexpr static size_t TranscodeCacheThreshold{64 * 1024};
+
+    /**
+     * @brief The minimum amount of pixels in a BCn image for it to be decoded in parallel, smaller images aren't worth the overhead of dispatching to other threads
+     */
+    constexpr static size_t ParallelDecodeThreshold{256 * 256};
+
+    /**
+     * @brief The minimum size of a deswizzled block-linear level for it to be deswizzled in parallel, smaller levels aren't worth the overhead of dispatching to other threads
+     */
+    constexpr static size_t ParallelDeswizzleThreshold{1024 * 1024};
+
+    /**
+     * @brief Splits a range of items into slices which are processed on the texture decode pool in parallel with the calling thread
+     * @param sliceCount The amount of slices to split the items into, the calling thread processes the first slice
+     * @param function A function that processes all items in the supplied range [first, last)
+     */
+    template<typename Function>
+    static void ProcessSlicesInParallel(GPU &gpu, size_t count, size_t sliceCount, Function &&function) {
+        size_t sliceSize{util::DivideCeil(count, sliceCount)};
+        std::vector<std::future<void>> futures;
+        for (size_t first{sliceSize}; first < count; first += sliceSize)
+            futures.emplace_back(gpu.textureDecodePool.Submit([&function, first, last = std::min(first + sliceSize, count)] { function(first, last); }));
+
+        try {
+            function(0, std::min(sliceSize, count));
+        } catch (...) {
+            // The other slices must be done before unwinding as they reference the source and destination buffers
+            for (auto &future : futures)
+                future.wait();
+            throw;
+        }
+
+        for (auto &future : futures)
+            future.get();
+    }
+
+    /**
+     * @brief Deswizzles a single layer of a block-linear level, large 2D levels are split by ROBs and deswizzled on the texture decode pool in parallel with the calling thread
+     * @note Every ROB of a 2D surface is contiguous in guest memory and has the same layout as a surface with the height of a ROB, so they can be deswizzled individually
+     */
+    static void DeswizzleBlockLinear(GPU &gpu, texture::Dimensions dimensions, size_t formatBlockWidth, size_t formatBlockHeight, size_t formatBpb, size_t gobBlockHeight, size_t gobBlockDepth, u8 *blockLinear, u8 *linear) {
+        auto robHeight{static_cast<u32>(texture::GetBlockLinearRobHeight(formatBlockHeight, gobBlockHeight))};
+        size_t robCount{util::DivideCeil(dimensions.height, robHeight)};
+        size_t linearRobSize{util::DivideCeil<size_t>(dimensions.width, formatBlockWidth) * formatBpb * (robHeight / formatBlockHeight)};
+        size_t sliceCount{std::min(gpu.textureDecodePool.GetThreadCount() + 1, robCount)}; // The calling thread deswizzles a slice as well
+        if (dimensions.depth != 1 || linearRobSize * robCount < ParallelDeswizzleThreshold || sliceCount <= 1) {
+            texture::CopyBlockLinearToLinear(dimensions, formatBlockWidth, formatBlockHeight, formatBpb, gobBlockHeight, gobBlockDepth, blockLinear, linear);
+            return;
+        }
+
+        TRACE_EVENT("gpu", "DeswizzleBlockLinear::Parallel");
+
+        size_t robSize{texture::GetBlockLinearLayerSize({dimensions.width, robHeight, 1}, formatBlockWidth, formatBlockHeight, formatBpb, gobBlockHeight, gobBlockDepth)};
+        ProcessSlicesInParallel(gpu, robCount, sliceCount, [=](size_t firstRob, size_t lastRob) {
+            auto height{std::min(static_cast<u32>(lastRob) * robHeight, dimensions.height) - (static_cast<u32>(firstRob) * robHeight)}; // The last ROB may be partially outside the surface
+            texture::CopyBlockLinearToLinear({dimensions.width, height, 1}, formatBlockWidth, formatBlockHeight, formatBpb, gobBlockHeight, gobBlockDepth, blockLinear + (firstRob * robSize), linear + (firstRob * linearRobSize));
+        });
+    }
+
+    /**
+     * @brief Decodes a BCn image using the supplied decoder, large images are split by rows of blocks and decoded on the texture decode pool in parallel with the calling thread
+     * @param blockSize The size of a single encoded block in bytes
+     * @param decodedBpp The size of a single decoded pixel in bytes
+     * @param decode A function that decodes an image of the supplied dimensions from the source into the destination
+     */
+    template<typename DecodeFunction>
+    static void DecodeBcn(GPU &gpu, const u8 *src, u8 *dst, size_t width, size_t height, size_t blockSize, size_t decodedBpp, DecodeFunction &&decode) {
+        size_t blockRows{util::DivideCeil(height, bcn::BlockDimension)};
+        size_t sliceCount{std::min(gpu.textureDecodePool.GetThreadCount() + 1, blockRows)}; // The calling thread decodes a slice as well
+        if (width * height < ParallelDecodeThreshold || sliceCount <= 1) {
+            decode(src, dst, width, height);
+            return;
+        }
+
+        TRACE_EVENT("gpu", "DecodeBcn::Parallel");
+
+        size_t srcRowPitch{util::DivideCeil(width, bcn::BlockDimension) * blockSize}, dstRowPitch{width * decodedBpp * bcn::BlockDimension};
+        ProcessSlicesInParallel(gpu, blockRows, sliceCount, [=](size_t firstBlockRow, size_t lastBlockRow) {
+            decode(src + (firstBlockRow * srcRowPitch), dst + (firstBlockRow * dstRowPitch), width, std::min(lastBlockRow * bcn::BlockDimension, height) - (firstBlockRow * bcn::BlockDimension));
+        });
+    }
+
+    /**
+     * @brief Calls the supplied function with the BCn decoder for the guest format alongside the size of an encoded block and a decoded pixel in bytes
+     */
+    template<typename Function>
+    static void VisitBcnDecoder(vk::Format guestFormat, Function &&function) {
+        switch (guestFormat) {
+            case vk::Format::eBc1RgbaUnormBlock:
+            case vk::Format::eBc1RgbaSrgbBlock:
+                function(8, 4, [](const u8 *src, u8 *dst, size_t width, size_t height) { bcn::DecodeBc1(src, dst, width, height, true); });
+                break;
+
+            case vk::Format::eBc2UnormBlock:
+            case vk::Format::eBc2SrgbBlock:
+                function(16, 4, [](const u8 *src, u8 *dst, size_t width, size_t height) { bcn::DecodeBc2(src, dst, width, height); });
+                break;
+
+            case vk::Format::eBc3UnormBlock:
+            case vk::Format::eBc3SrgbBlock:
+                function(16, 4, [](const u8 *src, u8 *dst, size_t width, size_t height) { bcn::DecodeBc3(src, dst, width, height); });
+                break;
+
+            case vk::Format::eBc4UnormBlock:
+                function(8, 1, [](const u8 *src, u8 *dst, size_t width, size_t height) { bcn::DecodeBc4(src, dst, width, height, false); });
+                break;
+            case vk::Format::eBc4SnormBlock:
+                function(8, 1, [](const u8 *src, u8 *dst, size_t width, size_t height) { bcn::DecodeBc4(src, dst, width, height, true); });
+                break;
+
+            case vk::Format::eBc5UnormBlock:
+                function(16, 2, [](const u8 *src, u8 *dst, size_t width, size_t height) { bcn::DecodeBc5(src, dst, width, height, false); });
+                break;
+            case vk::Format::eBc5SnormBlock:
+                function(16, 2, [](const u8 *src, u8 *dst, size_t width, size_t height) { bcn::DecodeBc5(src, dst, width, height, true); });
+                break;
+
+            case vk::Format::eBc6HUfloatBlock:
+                function(16, 8, [](const u8 *src, u8 *dst, size_t width, size_t height) { bcn::DecodeBc6(src, dst, width, height, false); });
+                break;
+            case vk::Format::eBc6HSfloatBlock:
+                function(16, 8, [](const u8 *src, u8 *dst, size_t width, size_t height) { bcn::DecodeBc6(src, dst, width, height, true); });
+                break;
+
+            case vk::Format::eBc7UnormBlock:
+            case vk::Format::eBc7SrgbBlock:
+                function(16, 4, [](const u8 *src, u8 *dst, size_t width, size_t height) { bcn::DecodeBc7(src, dst, width, height); });
+                break;
+
+            default:
+                throw exception("Unsupported guest format '{}'", vk::to_string(guestFormat));
+        }
+    }
+
+    /**
+     * @brief Deswizzles and decodes a single 2D block-linear BCn layer one ROB (Row of Blocks) at a time, each ROB is deswizzled into a small scratch buffer that's decoded into the destination while it's still in the cache
+     * @note Every ROB of a 2D surface is contiguous in guest memory and has the same layout as a surface with the height of a ROB, so they can be deswizzled individually
+     */
+    template<typename DecodeFunction>
+    static void DeswizzleDecodeBcn(GPU &gpu, const GuestTexture &guest, u8 *blockLinear, u8 *dst, size_t blockSize, size_t decodedBpp, DecodeFunction &&decode) {
+        size_t width{guest.dimensions.width}, height{guest.dimensions.height};
+        size_t robHeight{texture::GetBlockLinearRobHeight(bcn::BlockDimension, guest.tileConfig.blockHeight)};
+        size_t robCount{util::DivideCeil(height, robHeight)};
+        size_t srcRobBytes{texture::GetBlockLinearLayerSize({static_cast<u32>(width), static_cast<u32>(robHeight), 1}, guest.format->blockWidth, guest.format->blockHeight, guest.format->bpb, guest.tileConfig.blockHeight, guest.tileConfig.blockDepth)}; //!< The size of a ROB in guest memory including any padding GOBs
+        size_t scratchSize{util::DivideCeil(width, bcn::BlockDimension) * blockSize * (robHeight / bcn::BlockDimension)}; //!< The size of a deswizzled ROB
+        size_t dstRobBytes{width * decodedBpp * robHeight};
+
+        auto decodeRobs{[=, &guest](size_t firstRob, size_t lastRob) {
+            thread_local std::vector<u8> scratch; // This is reused across textures to avoid an allocation for every decode, it's at most the size of a single ROB
+            if (scratch.size() < scratchSize)
+                scratch.resize(scratchSize);
+            for (size_t rob{firstRob}; rob < lastRob; rob++) {
+                auto robPixelHeight{static_cast<u32>(std::min(robHeight, height - (rob * robHeight)))}; // The last ROB may be partially outside the surface
+                texture::CopyBlockLinearToLinear(
+                    {static_cast<u32>(width), robPixelHeight, 1},
+                    guest.format->blockWidth, guest.format->blockHeight, guest.format->bpb,
+                    guest.tileConfig.blockHeight, guest.tileConfig.blockDepth,
+                    blockLinear + (rob * srcRobBytes), scratch.data()
+                );
+                decode(scratch.data(), dst + (rob * dstRobBytes), width, robPixelHeight);
+            }
+        }};
+
+        size_t sliceCount{std::min(gpu.textureDecodePool.GetThreadCount() + 1, robCount)}; // The calling thread decodes a slice as well
+        if (width * height < ParallelDecodeThreshold || sliceCount <= 1) {
+            decodeRobs(0, robCount);
+            return;
+        }
+
+        TRACE_EVENT("gpu", "DeswizzleDecodeBcn::Parallel");
+        ProcessSlicesInParallel(gpu, robCount, sliceCount, decodeRobs);
+    }
+
+    std::shared_ptr<memory::StagingBuffer> Texture::SynchronizeHostImpl(u8 *hostOutput) {
         if (guest->dimensions != dimensions)
             throw exception("Guest and host dimensions being different is not supported currently");
 
@@ -250,9 +727,24 @@ namespace skyline::gpu {
 
         WaitOnBacking();
 
+        // Textures which are rewritten by the CPU without ever being written by the GPU are cheaper to upload by writing directly into a mapped linear image
+        MigrateToLinearTiling();
+
+        if (!hostOutput && CanDeswizzleOnGpu()) {
+            // The block-linear guest data is copied verbatim into the staging buffer and deswizzled into a linear region after it, the copy to the image is then done from that region
+            TRACE_EVENT("gpu", "Texture::SynchronizeHostImpl::GpuDeswizzle");
+            gpuDeswizzleOffset = util::AlignUp(mirror.size(), gpu.helperShaders.deswizzleHelperShader.storageBufferAlignment);
+            auto stagingBuffer{gpu.memory.AllocateStagingBuffer(gpuDeswizzleOffset + surfaceSize)};
+            std::memcpy(stagingBuffer->data(), pointer, mirror.size());
+            return stagingBuffer;
+        }
+
         u8 *bufferData;
         auto stagingBuffer{[&]() -> std::shared_ptr<memory::StagingBuffer> {
-            if (tiling == vk::ImageTiling::eOptimal || !std::holds_alternative<memory::Image>(backing)) {
+            if (tiling == vk::ImageTiling::eOptimal && hostOutput) {
+                bufferData = hostOutput;
+                return nullptr;
+            } else if (tiling == vk::ImageTiling::eOptimal || !std::holds_alternative<memory::Image>(backing)) {
                 // We need a staging buffer for all optimal copies (since we aren't aware of the host optimal layout) and linear textures which we cannot map on the CPU since we do not have access to their backing VkDeviceMemory
                 auto stagingBuffer{gpu.memory.AllocateStagingBuffer(surfaceSize)};
                 bufferData = stagingBuffer->data();
@@ -269,104 +761,191 @@ namespace skyline::gpu {
             }
         }()};
 
-        std::vector<u8> deswizzleBuffer;
-        u8 *deswizzleOutput;
-        if (guest->format != format) {
-            deswizzleBuffer.resize(deswizzledSurfaceSize);
-            deswizzleOutput = deswizzleBuffer.data();
-        } else [[likely]] {
-            deswizzleOutput = bufferData;
-        }
-
         auto guestLayerStride{guest->GetLayerStride()};
-        if (levelCount == 1) {
-            auto outputLayer{deswizzleOutput};
-            for (size_t layer{}; layer < layerCount; layer++) {
-                if (guest->tileConfig.mode == texture::TileMode::Block)
-                    texture::CopyBlockLinearToLinear(*guest, pointer, outputLayer);
-                else if (guest->tileConfig.mode == texture::TileMode::Pitch)
-                    texture::CopyPitchLinearToLinear(*guest, pointer, outputLayer);
-                else if (guest->tileConfig.mode == texture::TileMode::Linear)
-                    std::memcpy(outputLayer, pointer, surfaceSize);
-                pointer += guestLayerStride;
-                outputLayer += deswizzledLayerStride;
+        auto deswizzle{[&](u8 *pointer, u8 *deswizzleOutput) {
+            if (levelCount == 1) {
+                auto outputLayer{deswizzleOutput};
+                for (size_t layer{}; layer < layerCount; layer++) {
+                    if (guest->tileConfig.mode == texture::TileMode::Block)
+                        DeswizzleBlockLinear(gpu, guest->dimensions, guest->format->blockWidth, guest->format->blockHeight, guest->format->bpb, guest->tileConfig.blockHeight, guest->tileConfig.blockDepth, pointer, outputLayer);
+                    else if (guest->tileConfig.mode == texture::TileMode::Pitch)
+                        texture::CopyPitchLinearToLinear(*guest, pointer, outputLayer);
+                    else if (guest->tileConfig.mode == texture::TileMode::Linear)
+                        std::memcpy(outputLayer, pointer, surfaceSize);
+                    pointer += guestLayerStride;
+                    outputLayer += deswizzledLayerStride;
+                }
+            } else if (levelCount > 1 && guest->tileConfig.mode == texture::TileMode::Block) {
+                // We need to generate a buffer that has all layers for a given mip level while Tegra X1 layout holds all mip levels for a given layer
+                for (size_t layer{}; layer < layerCount; layer++) {
+                    auto inputLevel{pointer}, outputLevel{deswizzleOutput};
+                    for (const auto &level : mipLayouts) {
+                        DeswizzleBlockLinear(
+                            gpu, level.dimensions,
+                            guest->format->blockWidth, guest->format->blockHeight, guest->format->bpb,
+                            level.blockHeight, level.blockDepth,
+                            inputLevel, outputLevel + (layer * level.linearSize) // Offset into the current layer relative to the start of the current mip level
+                        );
+
+                        inputLevel += level.blockLinearSize; // Skip over the current mip level as we've deswizzled it
+                        outputLevel += layerCount * level.linearSize; // We need to offset the output buffer by the size of the previous mip level
+                    }
+
+                    pointer += guestLayerStride; // We need to offset the input buffer by the size of the previous guest layer, this can differ from inputLevel's value due to layer end padding or guest RT layer stride
+                }
+            } else if (levelCount != 0) {
+                throw exception("Mipmapped textures with tiling mode '{}' aren't supported", static_cast<int>(tiling));
             }
-        } else if (levelCount > 1 && guest->tileConfig.mode == texture::TileMode::Block) {
-            // We need to generate a buffer that has all layers for a given mip level while Tegra X1 layout holds all mip levels for a given layer
-            for (size_t layer{}; layer < layerCount; layer++) {
-                auto inputLevel{pointer}, outputLevel{deswizzleOutput};
+        }};
+
+        if (guest->format != format) {
+            // Large textures are looked up in the transcode cache by their guest data to skip deswizzling and decoding them when they're repeatedly uploaded
+            u64 transcodeKey{};
+            bool useTranscodeCache{gpu.transcodeCache.IsEnabled() && surfaceSize >= TranscodeCacheThreshold};
+            if (useTranscodeCache) {
+                // All members are 32-bit to avoid any padding being hashed, the tiling parameters are included as they determine how the guest data is interpreted
+                struct {
+                    vk::Format guestFormat, hostFormat;
+                    texture::Dimensions dimensions;
+                    u32 levelCount, layerCount, layerStride;
+                    u32 tileMode, tileParameter;
+                } transcodeState{
+                    guest->format->vkFormat, format->vkFormat, dimensions, levelCount, layerCount, guestLayerStride,
+                    static_cast<u32>(guest->tileConfig.mode),
+                    guest->tileConfig.mode == texture::TileMode::Block ? static_cast<u32>(guest->tileConfig.blockHeight | (guest->tileConfig.blockDepth << 8)) : (guest->tileConfig.mode == texture::TileMode::Pitch ? guest->tileConfig.pitch : 0),
+                };
+
+                transcodeKey = cache::TranscodeCache::MakeKey(mirror, XXH64(&transcodeState, sizeof(transcodeState), 0));
+                if (gpu.transcodeCache.Lookup(transcodeKey, span<u8>{bufferData, surfaceSize}))
+                    return stagingBuffer;
+            }
+
+            if (levelCount == 1 && guest->tileConfig.mode == texture::TileMode::Block && guest->dimensions.depth == 1) {
+                // Single-level 2D textures are deswizzled and decoded in a single pass without an intermediate buffer for the entire surface
+                VisitBcnDecoder(guest->format->vkFormat, [&](size_t blockSize, size_t decodedBpp, auto decode) {
+                    auto inputLayer{pointer};
+                    auto outputLayer{bufferData};
+                    for (size_t layer{}; layer < layerCount; layer++) {
+                        DeswizzleDecodeBcn(gpu, *guest, inputLayer, outputLayer, blockSize, decodedBpp, decode);
+                        inputLayer += guestLayerStride;
+                        outputLayer += mipLayouts.front().targetLinearSize;
+                    }
+                });
+            } else {
+                std::vector<u8> deswizzleBuffer(deswizzledSurfaceSize);
+                deswizzle(pointer, deswizzleBuffer.data());
+
+                u8 *deswizzleOutput{deswizzleBuffer.data()}, *decodedOutput{bufferData};
                 for (const auto &level : mipLayouts) {
-                    texture::CopyBlockLinearToLinear(
-                        level.dimensions,
-                        guest->format->blockWidth, guest->format->blockHeight, guest->format->bpb,
-                        level.blockHeight, level.blockDepth,
-                        inputLevel, outputLevel + (layer * level.linearSize) // Offset into the current layer relative to the start of the current mip level
-                    );
+                    size_t levelHeight{level.dimensions.height * layerCount}; //!< The height of an image representing all layers in the entire level
+                    VisitBcnDecoder(guest->format->vkFormat, [&](size_t blockSize, size_t decodedBpp, auto decode) {
+                        DecodeBcn(gpu, deswizzleOutput, decodedOutput, level.dimensions.width, levelHeight, blockSize, decodedBpp, decode);
+                    });
 
-                    inputLevel += level.blockLinearSize; // Skip over the current mip level as we've deswizzled it
-                    outputLevel += layerCount * level.linearSize; // We need to offset the output buffer by the size of the previous mip level
+                    deswizzleOutput += level.linearSize * layerCount;
+                    decodedOutput += level.targetLinearSize * layerCount;
                 }
-
-                pointer += guestLayerStride; // We need to offset the input buffer by the size of the previous guest layer, this can differ from inputLevel's value due to layer end padding or guest RT layer stride
             }
-        } else if (levelCount != 0) {
-            throw exception("Mipmapped textures with tiling mode '{}' aren't supported", static_cast<int>(tiling));
+
+            if (useTranscodeCache)
+                gpu.transcodeCache.Insert(transcodeKey, span<u8>{bufferData, surfaceSize});
+        } else [[likely]] {
+            deswizzle(pointer, bufferData);
         }
 
-        if (!deswizzleBuffer.empty()) {
-            for (const auto &level : mipLayouts) {
-                size_t levelHeight{level.dimensions.height * layerCount}; //!< The height of an image representing all layers in the entire level
-                switch (guest->format->vkFormat) {
-                    case vk::Format::eBc1RgbaUnormBlock:
-                    case vk::Format::eBc1RgbaSrgbBlock:
-                        bcn::DecodeBc1(deswizzleOutput, bufferData, level.dimensions.width, levelHeight, true);
-                        break;
-
-                    case vk::Format::eBc2UnormBlock:
-                    case vk::Format::eBc2SrgbBlock:
-                        bcn::DecodeBc2(deswizzleOutput, bufferData, level.dimensions.width, levelHeight);
-                        break;
-
-                    case vk::Format::eBc3UnormBlock:
-                    case vk::Format::eBc3SrgbBlock:
-                        bcn::DecodeBc3(deswizzleOutput, bufferData, level.dimensions.width, levelHeight);
-                        break;
-
-                    case vk::Format::eBc4UnormBlock:
-                        bcn::DecodeBc4(deswizzleOutput, bufferData, level.dimensions.width, levelHeight, false);
-                        break;
-                    case vk::Format::eBc4SnormBlock:
-                        bcn::DecodeBc4(deswizzleOutput, bufferData, level.dimensions.width, levelHeight, true);
-                        break;
-
-                    case vk::Format::eBc5UnormBlock:
-                        bcn::DecodeBc5(deswizzleOutput, bufferData, level.dimensions.width, levelHeight, false);
-                        break;
-                    case vk::Format::eBc5SnormBlock:
-                        bcn::DecodeBc5(deswizzleOutput, bufferData, level.dimensions.width, levelHeight, true);
-                        break;
-
-                    case vk::Format::eBc6HUfloatBlock:
-                        bcn::DecodeBc6(deswizzleOutput, bufferData, level.dimensions.width, levelHeight, false);
-                        break;
-                    case vk::Format::eBc6HSfloatBlock:
-                        bcn::DecodeBc6(deswizzleOutput, bufferData, level.dimensions.width, levelHeight, true);
-                        break;
-
-                    case vk::Format::eBc7UnormBlock:
-                    case vk::Format::eBc7SrgbBlock:
-                        bcn::DecodeBc7(deswizzleOutput, bufferData, level.dimensions.width, levelHeight);
-                        break;
-
-                    default:
-                        throw exception("Unsupported guest format '{}'", vk::to_string(guest->format->vkFormat));
+        return stagingBuffer;
+    }
+
+    std::shared_ptr<memory::StagingBuffer> Texture::SynchronizeHostPartialImpl(const std::vector<bool> &pages, boost::container::small_vector<vk::BufferImageCopy, 10> &copies) {
+        TRACE_EVENT("gpu", "Texture::SynchronizeHostPartialImpl");
+
+        WaitOnBacking();
+
+        auto mapping{guest->mappings.front()};
+        auto pageOffset{static_cast<size_t>(mapping.data() - util::AlignDown(mapping.data(), constant::PageSize))}; //!< The offset of the start of the guest data into its first page
+        auto isDirty{[&](size_t offset, size_t size) {
+            size_t endPage{std::min(util::DivideCeil(pageOffset + offset + size, constant::PageSize), pages.size())};
+            for (size_t page{(pageOffset + offset) / constant::PageSize}; page < endPage; page++)
+                if (pages[page])
+                    return true;
+            return false;
+        }};
+
+        /**
+         * @brief A run of consecutive ROBs in a single level and layer which overlap dirty pages
+         */
+        struct DirtyRows {
+            u32 level;
+            u32 layer;
+            size_t guestOffset; //!< The offset of the first ROB in the guest data
+            u32 y; //!< The offset of the first row in pixels
+            u32 height; //!< The height of all ROBs in pixels, this is clamped to the height of the level
+        };
+        boost::container::small_vector<DirtyRows, 8> dirtyRows;
+        vk::DeviceSize stagingSize{};
+
+        auto guestLayerStride{guest->GetLayerStride()};
+        for (u32 layer{}; layer < layerCount; layer++) {
+            size_t levelOffset{layer * guestLayerStride};
+            for (u32 levelIndex{}; levelIndex < mipLayouts.size(); levelIndex++) {
+                const auto &level{mipLayouts[levelIndex]};
+                auto robHeight{static_cast<u32>(texture::GetBlockLinearRobHeight(guest->format->blockHeight, level.blockHeight))};
+                size_t robSize{texture::GetBlockLinearLayerSize({level.dimensions.width, robHeight, 1}, guest->format->blockWidth, guest->format->blockHeight, guest->format->bpb, level.blockHeight, level.blockDepth)};
+                u32 robCount{util::DivideCeil(level.dimensions.height, robHeight)};
+                for (u32 rob{}; rob < robCount; rob++) {
+                    if (!isDirty(levelOffset + (rob * robSize), robSize))
+                        continue;
+
+                    u32 y{rob * robHeight}, height{std::min(robHeight, level.dimensions.height - y)};
+                    stagingSize += guest->format->GetSize(level.dimensions.width, height);
+                    if (!dirtyRows.empty() && dirtyRows.back().level == levelIndex && dirtyRows.back().layer == layer && dirtyRows.back().y + dirtyRows.back().height == y)
+                        dirtyRows.back().height += height; // The ROBs are contiguous in guest memory, so runs of them can be deswizzled together
+                    else
+                        dirtyRows.push_back({levelIndex, layer, levelOffset + (rob * robSize), y, height});
                 }
 
-                deswizzleOutput += level.linearSize * layerCount;
-                bufferData += level.targetLinearSize * layerCount;
+                levelOffset += level.blockLinearSize;
             }
         }
 
+        if (dirtyRows.empty())
+            return nullptr;
+
+        auto stagingBuffer{gpu.memory.AllocateStagingBuffer(stagingSize)};
+        vk::DeviceSize bufferOffset{};
+        for (const auto &rows : dirtyRows) {
+            const auto &level{mipLayouts[rows.level]};
+            texture::CopyBlockLinearToLinear(
+                {level.dimensions.width, rows.height, 1},
+                guest->format->blockWidth, guest->format->blockHeight, guest->format->bpb,
+                level.blockHeight, level.blockDepth,
+                mirror.data() + rows.guestOffset, stagingBuffer->data() + bufferOffset
+            );
+
+            auto pushCopyWithAspect{[&](vk::ImageAspectFlagBits aspect) {
+                copies.emplace_back(vk::BufferImageCopy{
+                    .bufferOffset = bufferOffset,
+                    .imageSubresource = {
+                        .aspectMask = aspect,
+                        .mipLevel = rows.level,
+                        .baseArrayLayer = rows.layer,
+                        .layerCount = 1,
+                    },
+                    .imageOffset = {0, static_cast<i32>(rows.y), 0},
+                    .imageExtent = {level.dimensions.width, rows.height, 1},
+                });
+            }};
+
+            if (format->vkAspect & vk::ImageAspectFlagBits::eColor)
+                pushCopyWithAspect(vk::ImageAspectFlagBits::eColor);
+            if (format->vkAspect & vk::ImageAspectFlagBits::eDepth)
+                pushCopyWithAspect(vk::ImageAspectFlagBits::eDepth);
+            if (format->vkAspect & vk::ImageAspectFlagBits::eStencil)
+                pushCopyWithAspect(vk::ImageAspectFlagBits::eStencil);
+
+            bufferOffset += guest->format->GetSize(level.dimensions.width, rows.height);
+        }
+
         return stagingBuffer;
     }
 
@@ -402,8 +981,88 @@ namespace skyline::gpu {
         return bufferImageCopies;
     }
 
-    void Texture::CopyFromStagingBuffer(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<memory::StagingBuffer> &stagingBuffer) {
+    /**
+     * @return The layout of every level of the texture for the (de)swizzle helper shader, offsets are relative to the start of the block-linear and linear data
+     */
+    static boost::container::small_vector<DeswizzleHelperShader::Level, 10> GetHelperShaderLevels(const Texture &texture) {
+        boost::container::small_vector<DeswizzleHelperShader::Level, 10> levels;
+        vk::DeviceSize srcOffset{}, dstOffset{};
+        for (const auto &level : texture.mipLayouts) {
+            levels.push_back(DeswizzleHelperShader::Level{
+                .widthBytes = static_cast<u32>(util::DivideCeil<size_t>(level.dimensions.width, texture.format->blockWidth) * texture.format->bpb),
+                .height = static_cast<u32>(util::DivideCeil<size_t>(level.dimensions.height, texture.format->blockHeight)),
+                .blockHeight = static_cast<u32>(level.blockHeight),
+                .layerCount = texture.layerCount,
+                .srcOffset = srcOffset,
+                .srcLayerStride = texture.guest->GetLayerStride(),
+                .dstOffset = dstOffset,
+                .dstLayerStride = level.linearSize,
+            });
+
+            srcOffset += level.blockLinearSize;
+            dstOffset += level.linearSize * texture.layerCount;
+        }
+        return levels;
+    }
+
+    void Texture::CopyFromHost(span<u8> data) {
+        TRACE_EVENT("gpu", "Texture::CopyFromHost");
         auto image{GetBacking()};
+        modificationCounter++;
+        PerfStats::Increment(PerfStats::Counter::TextureUploads);
+        PerfStats::Increment(PerfStats::Counter::TextureUploadBytes, data.size());
+        PerfStats::Increment(PerfStats::Counter::TextureHostCopies);
+
+        // The layout transition is done on the host as well, VK_IMAGE_LAYOUT_GENERAL is always a valid destination layout for host copies
+        if (layout == vk::ImageLayout::eUndefined)
+            gpu.vkDevice.transitionImageLayoutEXT(vk::HostImageLayoutTransitionInfoEXT{
+                .image = image,
+                .oldLayout = std::exchange(layout, vk::ImageLayout::eGeneral),
+                .newLayout = vk::ImageLayout::eGeneral,
+                .subresourceRange = {
+                    .aspectMask = format->vkAspect,
+                    .levelCount = levelCount,
+                    .layerCount = layerCount,
+                },
+            });
+
+        boost::container::small_vector<vk::MemoryToImageCopyEXT, 10> copies;
+        for (const auto &copy : GetBufferImageCopies())
+            copies.push_back(vk::MemoryToImageCopyEXT{
+                .pHostPointer = data.data() + copy.bufferOffset,
+                .imageSubresource = copy.imageSubresource,
+                .imageExtent = copy.imageExtent,
+            });
+
+        gpu.vkDevice.copyMemoryToImageEXT(vk::CopyMemoryToImageInfoEXT{
+            .dstImage = image,
+            .dstImageLayout = layout,
+            .regionCount = static_cast<u32>(copies.size()),
+            .pRegions = copies.data(),
+        });
+    }
+
+    std::shared_ptr<void> Texture::CopyFromStagingBuffer(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<memory::StagingBuffer> &stagingBuffer, span<const vk::BufferImageCopy> copies) {
+        auto image{GetBacking()};
+        modificationCounter++;
+        PerfStats::Increment(PerfStats::Counter::TextureUploads);
+        PerfStats::Increment(PerfStats::Counter::TextureUploadBytes, stagingBuffer->size());
+
+        std::shared_ptr<void> resources;
+        auto linearOffset{std::exchange(gpuDeswizzleOffset, 0)};
+        if (linearOffset) {
+            auto levels{GetHelperShaderLevels(*this)};
+            resources = gpu.helperShaders.deswizzleHelperShader.Deswizzle(gpu, commandBuffer,
+                                                                           vk::DescriptorBufferInfo{stagingBuffer->vkBuffer, 0, linearOffset},
+                                                                           vk::DescriptorBufferInfo{stagingBuffer->vkBuffer, linearOffset, surfaceSize},
+                                                                           levels);
+
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer, {}, vk::MemoryBarrier{
+                .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+                .dstAccessMask = vk::AccessFlagBits::eTransferRead,
+            }, {}, {});
+        }
+
         if (layout == vk::ImageLayout::eUndefined)
             commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eHost, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, vk::ImageMemoryBarrier{
                 .image = image,
@@ -420,12 +1079,36 @@ namespace skyline::gpu {
                 },
             });
 
-        auto bufferImageCopies{GetBufferImageCopies()};
+        auto bufferImageCopies{copies.empty() ? GetBufferImageCopies() : boost::container::small_vector<vk::BufferImageCopy, 10>(copies.begin(), copies.end())};
+        for (auto &bufferImageCopy : bufferImageCopies)
+            bufferImageCopy.bufferOffset += linearOffset;
+
+        if (scale != 1.0f) {
+            // The staging buffer holds data at the guest resolution, so it's copied into an unscaled image which is then blitted to the backing
+            auto unscaledImage{AllocateUnscaledImage(commandBuffer)};
+            commandBuffer.copyBufferToImage(stagingBuffer->vkBuffer, unscaledImage->vkImage, vk::ImageLayout::eGeneral, vk::ArrayProxy(static_cast<u32>(bufferImageCopies.size()), bufferImageCopies.data()));
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, vk::MemoryBarrier{
+                .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+                .dstAccessMask = vk::AccessFlagBits::eTransferRead,
+            }, {}, {});
+            RecordRescaleBlit(commandBuffer, unscaledImage->vkImage, true);
+
+            if (resources)
+                return std::make_shared<std::pair<std::shared_ptr<void>, std::shared_ptr<memory::Image>>>(std::move(resources), std::move(unscaledImage));
+            return unscaledImage;
+        }
+
         commandBuffer.copyBufferToImage(stagingBuffer->vkBuffer, image, layout, vk::ArrayProxy(static_cast<u32>(bufferImageCopies.size()), bufferImageCopies.data()));
+
+        return resources;
     }
 
-    void Texture::CopyIntoStagingBuffer(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<memory::StagingBuffer> &stagingBuffer) {
+    std::shared_ptr<void> Texture::CopyIntoStagingBuffer(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<memory::StagingBuffer> &stagingBuffer, vk::DeviceSize blockLinearOffset) {
         auto image{GetBacking()};
+        if (blockLinearOffset)
+            // The shader doesn't write to any padding in the block-linear data, it's zeroed rather than leaving stale contents of a recycled staging buffer in it
+            commandBuffer.fillBuffer(stagingBuffer->vkBuffer, blockLinearOffset, VK_WHOLE_SIZE, 0);
+
         commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eBottomOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, vk::ImageMemoryBarrier{
             .image = image,
             .srcAccessMask = vk::AccessFlagBits::eMemoryWrite,
@@ -441,8 +1124,42 @@ namespace skyline::gpu {
             },
         });
 
+        std::shared_ptr<memory::Image> unscaledImage;
         auto bufferImageCopies{GetBufferImageCopies()};
-        commandBuffer.copyImageToBuffer(image, layout, stagingBuffer->vkBuffer, vk::ArrayProxy(static_cast<u32>(bufferImageCopies.size()), bufferImageCopies.data()));
+        if (scale != 1.0f) {
+            // The guest expects data at its own resolution, so the backing is blitted into an unscaled image which is then copied from
+            unscaledImage = AllocateUnscaledImage(commandBuffer);
+            RecordRescaleBlit(commandBuffer, unscaledImage->vkImage, false);
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, vk::MemoryBarrier{
+                .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+                .dstAccessMask = vk::AccessFlagBits::eTransferRead,
+            }, {}, {});
+            commandBuffer.copyImageToBuffer(unscaledImage->vkImage, vk::ImageLayout::eGeneral, stagingBuffer->vkBuffer, vk::ArrayProxy(static_cast<u32>(bufferImageCopies.size()), bufferImageCopies.data()));
+        } else {
+            commandBuffer.copyImageToBuffer(image, layout, stagingBuffer->vkBuffer, vk::ArrayProxy(static_cast<u32>(bufferImageCopies.size()), bufferImageCopies.data()));
+        }
+
+        if (blockLinearOffset) {
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {}, vk::MemoryBarrier{
+                .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+                .dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
+            }, {}, {});
+
+            auto levels{GetHelperShaderLevels(*this)};
+            auto descriptorSet{gpu.helperShaders.deswizzleHelperShader.Swizzle(gpu, commandBuffer,
+                                                                                vk::DescriptorBufferInfo{stagingBuffer->vkBuffer, 0, surfaceSize},
+                                                                                vk::DescriptorBufferInfo{stagingBuffer->vkBuffer, blockLinearOffset, mirror.size()},
+                                                                                levels)};
+
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eHost, {}, vk::MemoryBarrier{
+                .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+                .dstAccessMask = vk::AccessFlagBits::eHostRead,
+            }, {}, {});
+
+            if (unscaledImage)
+                return std::make_shared<std::pair<std::shared_ptr<void>, std::shared_ptr<memory::Image>>>(std::move(descriptorSet), std::move(unscaledImage));
+            return descriptorSet;
+        }
 
         commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, {}, vk::BufferMemoryBarrier{
             .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
@@ -453,6 +1170,65 @@ namespace skyline::gpu {
             .offset = 0,
             .size = stagingBuffer->size(),
         }, {});
+
+        return unscaledImage;
+    }
+
+    std::shared_ptr<memory::Image> Texture::AllocateUnscaledImage(const vk::raii::CommandBuffer &commandBuffer) {
+        auto unscaledImage{std::make_shared<memory::Image>(gpu.memory.AllocateImage(vk::ImageCreateInfo{
+            .imageType = vk::ImageType::e2D,
+            .format = *format,
+            .extent = guest->dimensions,
+            .mipLevels = 1,
+            .arrayLayers = layerCount,
+            .samples = vk::SampleCountFlagBits::e1,
+            .tiling = vk::ImageTiling::eOptimal,
+            .usage = vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst,
+            .sharingMode = vk::SharingMode::eExclusive,
+            .queueFamilyIndexCount = 1,
+            .pQueueFamilyIndices = &gpu.vkQueueFamilyIndex,
+            .initialLayout = vk::ImageLayout::eUndefined,
+        }))};
+
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, vk::ImageMemoryBarrier{
+            .image = unscaledImage->vkImage,
+            .srcAccessMask = vk::AccessFlagBits::eNoneKHR,
+            .dstAccessMask = vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite,
+            .oldLayout = vk::ImageLayout::eUndefined,
+            .newLayout = vk::ImageLayout::eGeneral,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .subresourceRange = {
+                .aspectMask = format->vkAspect,
+                .levelCount = 1,
+                .layerCount = layerCount,
+            },
+        });
+
+        return unscaledImage;
+    }
+
+    void Texture::RecordRescaleBlit(const vk::raii::CommandBuffer &commandBuffer, vk::Image unscaledImage, bool toBacking) {
+        vk::ImageSubresourceLayers subresource{
+            .aspectMask = format->vkAspect,
+            .layerCount = layerCount,
+        };
+        std::array<vk::Offset3D, 2> unscaledBounds{vk::Offset3D{}, vk::Offset3D{static_cast<i32>(guest->dimensions.width), static_cast<i32>(guest->dimensions.height), 1}};
+        std::array<vk::Offset3D, 2> scaledBounds{vk::Offset3D{}, vk::Offset3D{static_cast<i32>(dimensions.width), static_cast<i32>(dimensions.height), 1}};
+
+        // Depth/stencil and integer formats can only be blitted with nearest filtering
+        bool linearFilter{format->vkAspect == vk::ImageAspectFlags{vk::ImageAspectFlagBits::eColor} &&
+                          (gpu.vkPhysicalDevice.getFormatProperties(*format).optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImageFilterLinear)};
+
+        auto backing{GetBacking()};
+        commandBuffer.blitImage(toBacking ? unscaledImage : backing, toBacking ? vk::ImageLayout::eGeneral : layout,
+                                toBacking ? backing : unscaledImage, toBacking ? layout : vk::ImageLayout::eGeneral,
+                                vk::ImageBlit{
+                                    .srcSubresource = subresource,
+                                    .srcOffsets = toBacking ? unscaledBounds : scaledBounds,
+                                    .dstSubresource = subresource,
+                                    .dstOffsets = toBacking ? scaledBounds : unscaledBounds,
+                                }, linearFilter ? vk::Filter::eLinear : vk::Filter::eNearest);
     }
 
     void Texture::CopyToGuest(u8 *hostBuffer) {
@@ -566,16 +1342,18 @@ namespace skyline::gpu {
         return surfaceSize;
     }
 
-    Texture::Texture(GPU &pGpu, GuestTexture pGuest)
+    Texture::Texture(GPU &pGpu, GuestTexture pGuest, float pScale, bool cpuShared, bool renderTarget)
         : gpu(pGpu),
+          resourceClass(renderTarget ? memory::ResourceClass::RenderTarget : memory::ResourceClass::SampledTexture),
           guest(std::move(pGuest)),
-          dimensions(guest->dimensions),
+          dimensions(texture::ScaleDimensions(guest->dimensions, pScale)),
+          scale(pScale),
           format(ConvertHostCompatibleFormat(guest->format, gpu.traits)),
           layout(vk::ImageLayout::eUndefined),
-          tiling(vk::ImageTiling::eOptimal), // Force Optimal due to not adhering to host subresource layout during Linear synchronization
+          tiling(vk::ImageTiling::eOptimal), // Linear tiling is only used for CPU-shared or frequently CPU written textures as synchronization doesn't adhere to padding in the host subresource layout
           layerCount(guest->layerCount),
-          deswizzledLayerStride(static_cast<u32>(guest->format->GetSize(dimensions))),
-          layerStride(format == guest->format ? deswizzledLayerStride : static_cast<u32>(format->GetSize(dimensions))),
+          deswizzledLayerStride(static_cast<u32>(guest->format->GetSize(guest->dimensions))),
+          layerStride(format == guest->format ? deswizzledLayerStride : static_cast<u32>(format->GetSize(guest->dimensions))),
           levelCount(guest->mipLevelCount),
           mipLayouts(
               texture::GetBlockLinearMipLayout(
@@ -589,7 +1367,7 @@ namespace skyline::gpu {
           deswizzledSurfaceSize(CalculateLevelStride(mipLayouts) * layerCount),
           surfaceSize(format == guest->format ? deswizzledSurfaceSize : (CalculateTargetLevelStride(mipLayouts) * layerCount)),
           sampleCount(vk::SampleCountFlagBits::e1),
-          flags(gpu.traits.quirks.vkImageMutableFormatCostly ? vk::ImageCreateFlags{} : vk::ImageCreateFlagBits::eMutableFormat),
+          flags(), // VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT disables framebuffer compression on mobile GPUs, it's only added by PromoteToMutableFormat when a view requires it
           usage(vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled) {
         if ((format->vkAspect & vk::ImageAspectFlagBits::eColor) && !format->IsCompressed())
             usage |= vk::ImageUsageFlagBits::eColorAttachment;
@@ -602,32 +1380,60 @@ namespace skyline::gpu {
         else if (imageType == vk::ImageType::e3D)
             flags |= vk::ImageCreateFlagBits::e2DArrayCompatible;
 
-        vk::ImageCreateInfo imageCreateInfo{
-            .flags = flags,
-            .imageType = imageType,
-            .format = *format,
-            .extent = dimensions,
-            .mipLevels = levelCount,
-            .arrayLayers = layerCount,
-            .samples = vk::SampleCountFlagBits::e1,
-            .tiling = tiling,
-            .usage = usage,
-            .sharingMode = vk::SharingMode::eExclusive,
-            .queueFamilyIndexCount = 1,
-            .pQueueFamilyIndices = &gpu.vkQueueFamilyIndex,
-            .initialLayout = layout,
-        };
-        backing = tiling != vk::ImageTiling::eLinear ? gpu.memory.AllocateImage(imageCreateInfo) : gpu.memory.AllocateMappedImage(imageCreateInfo);
+        // Linear images can be written into directly by the CPU on a UMA, this avoids the staging buffer and copy on every upload
+        if (cpuShared && SupportsLinearTiling()) {
+            if (auto image{AllocateLinearImage(layout)}) {
+                backing = std::move(*image);
+                tiling = vk::ImageTiling::eLinear;
+            }
+            linearMigrationAttempted = true;
+        }
+
+        if (tiling != vk::ImageTiling::eLinear)
+            backing = gpu.memory.AllocateImage(GetImageCreateInfo(tiling, layout), this, resourceClass);
 
         SetupGuestMappings();
     }
 
     Texture::~Texture() {
+        gpu.memory.ReleaseImageOwner(this);
         SynchronizeGuest(true);
         if (trapHandle)
             gpu.state.nce->DeleteTrap(*trapHandle);
-        if (alignedMirror.valid())
-            munmap(alignedMirror.data(), alignedMirror.size());
+    }
+
+    std::shared_ptr<void> Texture::MoveImage(VmaAllocation allocation, const vk::raii::CommandBuffer &commandBuffer, const std::function<vk::Image(const vk::ImageCreateInfo &)> &createImage) {
+        auto self{weak_from_this().lock()};
+        if (!self || !try_lock())
+            return nullptr; // The texture is being destroyed or is in use, it'll be moved by a later pass
+        std::unique_lock textureLock{*this, std::adopt_lock};
+
+        auto image{std::get_if<memory::Image>(&backing)};
+        if (!image || image->vmaAllocation != allocation || tiling != vk::ImageTiling::eOptimal || (cycle && !cycle->Poll()))
+            return nullptr;
+
+        TRACE_EVENT("gpu", "Texture::MoveImage");
+
+        vk::Image source{image->vkImage};
+        vk::Image destination{createImage(GetImageCreateInfo(tiling, vk::ImageLayout::eUndefined))};
+        if (layout != vk::ImageLayout::eUndefined && layout != vk::ImageLayout::ePreinitialized)
+            RecordBackingCopy(commandBuffer, source, destination);
+        else
+            layout = vk::ImageLayout::eUndefined;
+
+        // The memory of the allocation is swapped with that of the destination by VMA at the end of the pass, only the image handle needs to be replaced here
+        image->vkImage = destination;
+        for (auto &[key, storage] : views)
+            if (*storage.vkView)
+                staleViews.emplace_back(std::move(storage.vkView));
+        backingGeneration++;
+
+        struct Move {
+            std::shared_ptr<Texture> texture;
+            std::unique_lock<Texture> lock; //!< The texture is kept locked until the copy has completed as its contents are in flight
+            vk::raii::Image source; //!< The prior image is destroyed before the texture is unlocked, its memory is freed by VMA
+        };
+        return std::make_shared<Move>(Move{std::move(self), std::move(textureLock), vk::raii::Image{gpu.vkDevice, source}});
     }
 
     void Texture::lock() {
@@ -685,6 +1491,7 @@ namespace skyline::gpu {
 
         backing = std::move(pBacking);
         layout = pLayout;
+        modificationCounter++;
         if (GetBacking())
             backingCondition.notify_all();
     }
@@ -722,10 +1529,12 @@ namespace skyline::gpu {
             return;
 
         TRACE_EVENT("gpu", "Texture::SynchronizeHost");
+        std::vector<bool> partialDirtyPages;
         {
             std::scoped_lock lock{stateMutex};
             if (gpuDirty && dirtyState == DirtyState::Clean) {
                 // If a texture is Clean then we can just transition it to being GPU dirty and retrap it
+                cpuUploadCount = 0;
                 dirtyState = DirtyState::GpuDirty;
                 gpu.state.nce->TrapRegions(*trapHandle, false);
                 gpu.state.nce->PageOutRegions(*trapHandle);
@@ -734,22 +1543,45 @@ namespace skyline::gpu {
                 return; // If the texture has not been modified on the CPU, there is no need to synchronize it
             }
 
+            // Only the pages written by the CPU need to be synchronized if they were tracked, the host texture must've been synchronized before for this to be the case
+            if (dirtyPageCount && layout != vk::ImageLayout::eUndefined)
+                partialDirtyPages = dirtyPages;
+            ClearDirtyPages();
+
+            cpuUploadCount = gpuDirty ? 0 : cpuUploadCount + 1;
             dirtyState = gpuDirty ? DirtyState::GpuDirty : DirtyState::Clean;
             gpu.state.nce->TrapRegions(*trapHandle, !gpuDirty); // Trap any future CPU reads (optionally) + writes to this texture
         }
 
         // From this point on Clean -> CPU dirty state transitions can occur, GPU dirty -> * transitions will always require the full lock to be held and thus won't occur
 
-        auto stagingBuffer{SynchronizeHostImpl()};
-        if (stagingBuffer) {
-            if (cycle)
-                cycle->WaitSubmit();
-            auto lCycle{gpu.scheduler.Submit([&](vk::raii::CommandBuffer &commandBuffer) {
-                CopyFromStagingBuffer(commandBuffer, stagingBuffer);
-            })};
-            lCycle->AttachObjects(stagingBuffer, shared_from_this());
-            lCycle->ChainCycle(cycle);
-            cycle = lCycle;
+        // Full uploads of textures that are idle on the GPU are written into the image directly from the CPU when possible, this avoids a staging buffer along with a GPU copy and its queue submission
+        if (partialDirtyPages.empty() && hostImageCopy && tiling == vk::ImageTiling::eOptimal && scale == 1.0f && (!cycle || cycle->Poll())) {
+            thread_local std::vector<u8> hostCopyBuffer;
+            if (hostCopyBuffer.size() < surfaceSize)
+                hostCopyBuffer.resize(surfaceSize);
+
+            SynchronizeHostImpl(hostCopyBuffer.data());
+            if (tiling == vk::ImageTiling::eOptimal) // The texture may have been migrated to a mapped linear image which is written into directly instead
+                CopyFromHost(span<u8>{hostCopyBuffer}.first(surfaceSize));
+        } else {
+            boost::container::small_vector<vk::BufferImageCopy, 10> partialCopies;
+            auto stagingBuffer{partialDirtyPages.empty() ? SynchronizeHostImpl() : SynchronizeHostPartialImpl(partialDirtyPages, partialCopies)};
+            if (stagingBuffer) {
+                if (cycle)
+                    cycle->WaitSubmit();
+                std::shared_ptr<void> resources;
+                auto recordCopy{[&](vk::raii::CommandBuffer &commandBuffer) {
+                    resources = CopyFromStagingBuffer(commandBuffer, stagingBuffer, partialCopies);
+                }};
+                // The transfer queue isn't ordered with the main queue, so it can only be used if there's no prior GPU work on the texture still pending
+                auto lCycle{(!cycle || cycle->Poll()) ? gpu.scheduler.SubmitTransfer(recordCopy) : gpu.scheduler.Submit(recordCopy)};
+                lCycle->AttachObjects(stagingBuffer, shared_from_this());
+                if (resources)
+                    lCycle->AttachObject(resources);
+                lCycle->ChainCycle(cycle);
+                cycle = lCycle;
+            }
         }
 
         {
@@ -766,9 +1598,11 @@ namespace skyline::gpu {
 
         TRACE_EVENT("gpu", "Texture::SynchronizeHostInline");
 
+        std::vector<bool> partialDirtyPages;
         {
             std::scoped_lock lock{stateMutex};
             if (gpuDirty && dirtyState == DirtyState::Clean) {
+                cpuUploadCount = 0;
                 dirtyState = DirtyState::GpuDirty;
                 gpu.state.nce->TrapRegions(*trapHandle, false);
                 gpu.state.nce->PageOutRegions(*trapHandle);
@@ -777,13 +1611,20 @@ namespace skyline::gpu {
                 return;
             }
 
+            if (dirtyPageCount && layout != vk::ImageLayout::eUndefined)
+                partialDirtyPages = dirtyPages;
+            ClearDirtyPages();
+
+            cpuUploadCount = gpuDirty ? 0 : cpuUploadCount + 1;
             dirtyState = gpuDirty ? DirtyState::GpuDirty : DirtyState::Clean;
             gpu.state.nce->TrapRegions(*trapHandle, !gpuDirty); // Trap any future CPU reads (optionally) + writes to this texture
         }
 
-        auto stagingBuffer{SynchronizeHostImpl()};
+        boost::container::small_vector<vk::BufferImageCopy, 10> partialCopies;
+        auto stagingBuffer{partialDirtyPages.empty() ? SynchronizeHostImpl() : SynchronizeHostPartialImpl(partialDirtyPages, partialCopies)};
         if (stagingBuffer) {
-            CopyFromStagingBuffer(commandBuffer, stagingBuffer);
+            if (auto resources{CopyFromStagingBuffer(commandBuffer, stagingBuffer, partialCopies)})
+                pCycle->AttachObject(resources);
             pCycle->AttachObjects(stagingBuffer, shared_from_this());
             pCycle->ChainCycle(cycle);
             cycle = pCycle;
@@ -806,6 +1647,7 @@ namespace skyline::gpu {
         {
             std::scoped_lock lock{stateMutex};
             if (cpuDirty && dirtyState == DirtyState::Clean) {
+                ClearDirtyPages();
                 dirtyState = DirtyState::CpuDirty;
                 if (!skipTrap)
                     gpu.state.nce->DeleteTrap(*trapHandle);
@@ -825,15 +1667,25 @@ namespace skyline::gpu {
         WaitOnBacking();
 
         if (tiling == vk::ImageTiling::eOptimal || !std::holds_alternative<memory::Image>(backing)) {
-            auto stagingBuffer{gpu.memory.AllocateStagingBuffer(surfaceSize)};
+            // Large block-linear textures are swizzled on the GPU into a region after the linear data so only a copy of the guest data is left for the CPU
+            vk::DeviceSize blockLinearOffset{CanDeswizzleOnGpu() ? util::AlignUp(surfaceSize, gpu.helperShaders.deswizzleHelperShader.storageBufferAlignment) : 0};
+            auto stagingBuffer{gpu.memory.AllocateStagingBuffer(blockLinearOffset ? blockLinearOffset + mirror.size() : surfaceSize)};
 
             WaitOnFence();
+            std::shared_ptr<void> resources;
             auto lCycle{gpu.scheduler.Submit([&](vk::raii::CommandBuffer &commandBuffer) {
-                CopyIntoStagingBuffer(commandBuffer, stagingBuffer);
+                resources = CopyIntoStagingBuffer(commandBuffer, stagingBuffer, blockLinearOffset);
             })};
+            if (resources)
+                lCycle->AttachObject(resources);
             lCycle->Wait(); // We block till the copy is complete
 
-            CopyToGuest(stagingBuffer->data());
+            if (blockLinearOffset) {
+                TRACE_EVENT("gpu", "Texture::SynchronizeGuest::GpuSwizzle");
+                std::memcpy(mirror.data(), stagingBuffer->data() + blockLinearOffset, mirror.size());
+            } else {
+                CopyToGuest(stagingBuffer->data());
+            }
         } else if (tiling == vk::ImageTiling::eLinear) {
             // We can optimize linear texture sync on a UMA by mapping the texture onto the CPU and copying directly from it rather than using a staging buffer
             WaitOnFence();
@@ -854,10 +1706,34 @@ namespace skyline::gpu {
             pFormat = format; // We want to use the texture's format if it isn't supplied or if the requested format matches the guest format then we want to use the host format just in case it is host incompatible and the host format differs from the guest format
 
         auto viewFormat{pFormat->vkFormat}, textureFormat{format->vkFormat};
-        if (gpu.traits.quirks.vkImageMutableFormatCostly && viewFormat != textureFormat && (!gpu.traits.quirks.adrenoRelaxedFormatAliasing || !texture::IsAdrenoAliasCompatible(viewFormat, textureFormat)))
-            Logger::Warn("Creating a view of a texture with a different format without mutable format: {} - {}", vk::to_string(viewFormat), vk::to_string(textureFormat));
+        if (viewFormat != textureFormat && !(flags & vk::ImageCreateFlagBits::eMutableFormat) && (!gpu.traits.quirks.adrenoRelaxedFormatAliasing || !texture::IsAdrenoAliasCompatible(viewFormat, textureFormat))) {
+            if (tiling == vk::ImageTiling::eOptimal)
+                mutableFormatPending = true; // The view itself is created lazily so the backing can still be promoted by the caller prior to it being used
+            else
+                Logger::Warn("Creating a view of a texture with a different format without mutable format: {} - {}", vk::to_string(viewFormat), vk::to_string(textureFormat));
+        }
+
+        // Views are handed out again while any user still holds them, this avoids an allocation and the VkImageView lookup for repeated lookups of the same view
+        auto &storage{views[TextureViewKey{type, pFormat, mapping, range}]};
+        if (auto view{storage.view.lock()})
+            return view;
 
-        return std::make_shared<TextureView>(shared_from_this(), type, range, pFormat, mapping);
+        auto view{std::make_shared<TextureView>(shared_from_this(), type, range, pFormat, mapping)};
+        storage.view = view;
+        return view;
+    }
+
+    bool Texture::CanAliasFormat(texture::Format viewFormat) {
+        if (format != guest->format || ConvertHostCompatibleFormat(viewFormat, gpu.traits) != viewFormat)
+            return false; // Formats which are converted on upload can't be aliased as the contents wouldn't match the guest representation of the other format
+
+        if (format->IsCompressed() || viewFormat->IsCompressed() || format->bpb != viewFormat->bpb || format->vkAspect != vk::ImageAspectFlagBits::eColor || viewFormat->vkAspect != vk::ImageAspectFlagBits::eColor)
+            return false;
+
+        if (flags & vk::ImageCreateFlagBits::eMutableFormat || (!gpu.traits.quirks.vkImageMutableFormatCostly && tiling == vk::ImageTiling::eOptimal))
+            return true; // Optimal backings are promoted to a mutable format on their next first usage when a view requires it
+
+        return gpu.traits.quirks.adrenoRelaxedFormatAliasing && texture::IsAdrenoAliasCompatible(viewFormat->vkFormat, format->vkFormat);
     }
 
     void Texture::CopyFrom(std::shared_ptr<Texture> source, vk::Semaphore waitSemaphore, vk::Semaphore signalSemaphore, const vk::ImageSubresourceRange &subresource) {
@@ -877,6 +1753,8 @@ namespace skyline::gpu {
 
         TRACE_EVENT("gpu", "Texture::CopyFrom");
 
+        modificationCounter++;
+
         auto submitFunc{[&](vk::Semaphore extraWaitSemaphore){
             boost::container::small_vector<vk::Semaphore, 2> waitSemaphores;
             if (waitSemaphore)
@@ -55,6 +55,44 @@ namespace skyline::gpu {
             }
         };
 
+        /**
+         * @return The supplied guest coordinate scaled by a texture's resolution scale, this rounds up so scaled extents always cover all scaled texels
+         */
+        inline i32 ScaleCoordinate(i32 value, float scale) {
+            return static_cast<i32>(std::ceil(static_cast<float>(value) * scale));
+        }
+
+        /**
+         * @return The supplied guest dimensions scaled by a texture's resolution scale, only the width and height are scaled
+         */
+        inline Dimensions ScaleDimensions(Dimensions dimensions, float scale) {
+            if (scale == 1.0f)
+                return dimensions;
+
+            return Dimensions{
+                std::max(static_cast<u32>(ScaleCoordinate(static_cast<i32>(dimensions.width), scale)), 1U),
+                std::max(static_cast<u32>(ScaleCoordinate(static_cast<i32>(dimensions.height), scale)), 1U),
+                dimensions.depth
+            };
+        }
+
+        /**
+         * @return The supplied rectangle in guest coordinates scaled to the coordinates of a texture with the supplied resolution scale
+         */
+        inline vk::Rect2D ScaleRect(const vk::Rect2D &rect, float scale) {
+            if (scale == 1.0f)
+                return rect;
+
+            i32 x{ScaleCoordinate(rect.offset.x, scale)}, y{ScaleCoordinate(rect.offset.y, scale)};
+            return vk::Rect2D{
+                .offset = {x, y},
+                .extent = {
+                    static_cast<u32>(std::max(ScaleCoordinate(rect.offset.x + static_cast<i32>(rect.extent.width), scale) - x, 0)),
+                    static_cast<u32>(std::max(ScaleCoordinate(rect.offset.y + static_cast<i32>(rect.extent.height), scale) - y, 0)),
+                },
+            };
+        }
+
         /**
          * @note Blocks refers to the atomic unit of a compressed format (IE: The minimum amount of data that can be decompressed)
          */
@@ -313,6 +351,7 @@ namespace skyline::gpu {
     class TextureView : public std::enable_shared_from_this<TextureView> {
       private:
         vk::ImageView vkView{};
+        u32 viewGeneration{}; //!< The backing generation of the texture that `vkView` was created for
 
       public:
         LockableSharedPtr<Texture> texture;
@@ -367,7 +406,7 @@ namespace skyline::gpu {
      * @brief A texture which is backed by host constructs while being synchronized with the underlying guest texture
      * @note This class conforms to the Lockable and BasicLockable C++ named requirements
      */
-    class Texture : public std::enable_shared_from_this<Texture> {
+    class Texture : public std::enable_shared_from_this<Texture>, public memory::ImageOwner {
       private:
         GPU &gpu;
         RecursiveSpinLock mutex; //!< Synchronizes any mutations to the texture or its backing
@@ -378,6 +417,7 @@ namespace skyline::gpu {
 
         span<u8> mirror{}; //!< A contiguous mirror of all the guest mappings to allow linear access on the CPU
         span<u8> alignedMirror{}; //!< The mirror mapping aligned to page size to reflect the full mapping
+        std::shared_ptr<void> mirrorMapping; //!< Keeps the mirror mapped, the mapping may be shared with other resources that mirror the same pages
         std::optional<nce::NCE::TrapHandle> trapHandle{}; //!< The handle of the traps for the guest mappings
         enum class DirtyState {
             Clean, //!< The CPU mappings are in sync with the GPU texture
@@ -386,20 +426,40 @@ namespace skyline::gpu {
         } dirtyState{DirtyState::CpuDirty}; //!< The state of the CPU mappings with respect to the GPU texture
         std::recursive_mutex stateMutex; //!< Synchronizes access to the dirty state
 
+        static constexpr size_t PartialSyncDirtyPageDivisor{4}; //!< Textures which have more than 1/Nth of their pages written by the CPU are entirely synchronized rather than just the written pages
+        std::vector<bool> dirtyPages; //!< A bitmap of the pages of the guest mapping written by the CPU since the last synchronization, this is empty for textures that can't be partially synchronized
+        size_t dirtyPageCount{}; //!< The amount of pages set in `dirtyPages`, the entire texture is considered to be dirty if it's CPU dirty while this is zero
+
         /**
-         * @brief Storage for all metadata about a specific view into the buffer, used to prevent redundant view creation and duplication of VkBufferView(s)
+         * @brief The attributes of a view into the texture packed for cheap hashing and comparison
          */
-        struct TextureViewStorage {
-            vk::ImageViewType type;
+        struct TextureViewKey {
             texture::Format format;
-            vk::ComponentMapping mapping;
-            vk::ImageSubresourceRange range;
-            vk::raii::ImageView vkView;
+            u64 packed; //!< The view type, swizzle, aspect and base mip level packed together
+            u32 levelCount;
+            u32 baseArrayLayer;
+            u32 layerCount;
 
-            TextureViewStorage(vk::ImageViewType type, texture::Format format, vk::ComponentMapping mapping, vk::ImageSubresourceRange range, vk::raii::ImageView &&vkView);
+            TextureViewKey(vk::ImageViewType type, texture::Format format, vk::ComponentMapping mapping, const vk::ImageSubresourceRange &range);
+
+            bool operator==(const TextureViewKey &other) const = default;
         };
 
-        std::vector<TextureViewStorage> views;
+        struct TextureViewKeyHash {
+            size_t operator()(const TextureViewKey &key) const;
+        };
+
+        /**
+         * @brief Storage for a specific view into the texture, used to prevent redundant view creation and duplication of VkImageView(s)
+         */
+        struct TextureViewStorage {
+            std::weak_ptr<TextureView> view; //!< The last view object handed out for these attributes, it's reused for as long as it's alive
+            vk::raii::ImageView vkView{nullptr}; //!< The Vulkan view for these attributes, this is created lazily on the first TextureView::GetView call
+        };
+
+        std::unordered_map<TextureViewKey, TextureViewStorage, TextureViewKeyHash> views;
+        std::vector<vk::raii::ImageView> staleViews; //!< Views into a prior backing, they're retained so their handles can't be reused while descriptors may still refer to them
+        u32 backingGeneration{}; //!< Incremented whenever the backing is replaced by the texture itself, views created prior to this are stale
 
         friend TextureManager;
         friend TextureView;
@@ -411,20 +471,105 @@ namespace skyline::gpu {
 
         /**
          * @brief An implementation function for guest -> host texture synchronization, it allocates and copies data into a staging buffer or directly into a linear host texture
+         * @param hostOutput If non-null, the data for an optimal texture is written into this rather than a staging buffer, it must be at least `surfaceSize` bytes and copied to the texture with CopyFromHost by the callee
          * @return If a staging buffer was required for the texture sync, it's returned filled with guest texture data and must be copied to the host texture by the callee
          */
-        std::shared_ptr<memory::StagingBuffer> SynchronizeHostImpl();
+        std::shared_ptr<memory::StagingBuffer> SynchronizeHostImpl(u8 *hostOutput = nullptr);
+
+        /**
+         * @return If the texture can be synchronized from the guest a ROB at a time based on which of its pages were written by the CPU
+         */
+        bool CanSynchronizePartially();
+
+        /**
+         * @brief Clears all pages in `dirtyPages`, this has the effect of the entire texture being considered dirty when it's CPU dirty
+         * @note The state mutex must be locked when calling this
+         */
+        void ClearDirtyPages();
+
+        /**
+         * @brief An implementation function for partial guest -> host texture synchronization, only the ROBs of every level and layer which overlap the supplied dirty pages are deswizzled into a staging buffer
+         * @param copies The copies from the returned staging buffer to the host texture are written into this
+         * @return A staging buffer which must be copied to the host texture with the supplied copies, this is null if none of the dirty pages overlap the guest texture data
+         */
+        std::shared_ptr<memory::StagingBuffer> SynchronizeHostPartialImpl(const std::vector<bool> &pages, boost::container::small_vector<vk::BufferImageCopy, 10> &copies);
+
+        /**
+         * @return If the guest data of this texture can be deswizzled and swizzled on the GPU rather than on the CPU
+         */
+        bool CanDeswizzleOnGpu();
+
+        /**
+         * @return If the texture can be backed by a linear image that guest data is written into directly, this doesn't check if the host prefers padded rows
+         */
+        bool SupportsLinearTiling();
+
+        /**
+         * @return If an optimal image with the supplied create info can be written into directly from the CPU without making device access to it any less optimal
+         */
+        bool SupportsHostImageCopy(const vk::ImageCreateInfo &createInfo);
+
+        /**
+         * @return A create info for the backing image of the texture with the supplied tiling and initial layout
+         * @note This updates `hostImageCopy` for optimal tiling as host copies require the image to be created with VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT
+         */
+        vk::ImageCreateInfo GetImageCreateInfo(vk::ImageTiling tiling, vk::ImageLayout initialLayout);
+
+        /**
+         * @return A host-visible linear image for the texture, this is empty if the host pads the rows of the image as they must be tightly packed for synchronization
+         */
+        std::optional<memory::Image> AllocateLinearImage(vk::ImageLayout initialLayout);
+
+        /**
+         * @brief Replaces an optimal backing with a host-visible linear one if the texture is repeatedly uploaded from the CPU without being written by the GPU
+         * @note The contents of the backing are discarded, this must only be called prior to a full guest -> host synchronization
+         */
+        void MigrateToLinearTiling();
+
+        /**
+         * @brief Recreates an optimal backing with VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT and copies the contents of the prior backing into it
+         * @note Backings are created without a mutable format by default as it disables framebuffer compression (UBWC/AFBC) on mobile GPUs, this is only done once a view actually requires it
+         * @note This must only be called on the first usage of the texture in a context as any recorded commands would refer to the prior backing
+         */
+        void PromoteToMutableFormat();
+
+        /**
+         * @brief Records a copy of all subresources from the source image in the current layout to the destination image in an undefined layout, the destination is left in the current layout
+         */
+        void RecordBackingCopy(const vk::raii::CommandBuffer &commandBuffer, vk::Image source, vk::Image destination);
 
         /**
          * @brief Records commands for copying data from a staging buffer to the texture's backing into the supplied command buffer
+         * @param copies The copies to perform from the staging buffer, the entire texture is copied if this is empty
+         * @return An object which must be attached to the cycle of the command buffer if non-null, this is used for any resources required by GPU deswizzling
+         */
+        std::shared_ptr<void> CopyFromStagingBuffer(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<memory::StagingBuffer> &stagingBuffer, span<const vk::BufferImageCopy> copies = {});
+
+        /**
+         * @brief Copies data laid out like a staging buffer into the texture's backing directly from the CPU with VK_EXT_host_image_copy
+         * @note The backing must not be in use by the GPU when calling this
          */
-        void CopyFromStagingBuffer(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<memory::StagingBuffer> &stagingBuffer);
+        void CopyFromHost(span<u8> data);
 
         /**
          * @brief Records commands for copying data from the texture's backing to a staging buffer into the supplied command buffer
+         * @param blockLinearOffset If non-zero, the linear data at the start of the staging buffer is additionally swizzled on the GPU into block-linear guest data at this offset
+         * @return An object which must be attached to the cycle of the command buffer if non-null, this is used for any resources required by rescaling or swizzling
          * @note Any caller **must** ensure that the layout is not `eUndefined`
          */
-        void CopyIntoStagingBuffer(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<memory::StagingBuffer> &stagingBuffer);
+        std::shared_ptr<void> CopyIntoStagingBuffer(const vk::raii::CommandBuffer &commandBuffer, const std::shared_ptr<memory::StagingBuffer> &stagingBuffer, vk::DeviceSize blockLinearOffset = 0);
+
+        /**
+         * @return An image in the general layout with the guest dimensions of the texture, it's used as an intermediate for transfers to or from scaled textures
+         * @note The layout transition is recorded into the supplied command buffer
+         */
+        std::shared_ptr<memory::Image> AllocateUnscaledImage(const vk::raii::CommandBuffer &commandBuffer);
+
+        /**
+         * @brief Records a blit between the texture's backing and an image with the guest dimensions of the texture, this is used to rescale the texture's contents
+         * @param toBacking If the blit is from the unscaled image to the backing rather than the other way around
+         */
+        void RecordRescaleBlit(const vk::raii::CommandBuffer &commandBuffer, vk::Image unscaledImage, bool toBacking);
 
         /**
          * @brief Copies data from the supplied host buffer into the guest texture
@@ -445,10 +590,32 @@ namespace skyline::gpu {
         size_t accumulatedGuestWaitCounter{}; //!< Total number of times the texture has been waited on
         std::chrono::nanoseconds accumulatedGuestWaitTime{}; //!< Amount of time the texture has been waited on for since the `SkipReadbackHackWaitCountThreshold`th wait on it by the guest
 
+        static constexpr size_t SkipOverwriteReadbackThreshold{4}; //!< Threshold for the number of CPU writes to the texture while it's GPU dirty after which further ones skip the readback, this only applies to textures which have never had GPU written data read by the CPU
+        size_t cpuReadbackCount{}; //!< Number of times GPU written data in the texture has been read back for the CPU or an overlapping texture
+        size_t cpuOverwriteCount{}; //!< Number of times the CPU has written to the texture while it was GPU dirty
+
+        /**
+         * @return If a CPU write to the texture while it's GPU dirty is expected to overwrite all of it, this is assumed for textures which have been repeatedly written to by the CPU after being written by the GPU while never having their GPU written data read
+         */
+        bool IsCpuOverwriteLikely() const {
+            return cpuReadbackCount == 0 && cpuOverwriteCount >= SkipOverwriteReadbackThreshold;
+        }
+
+        static constexpr size_t LinearMigrationThreshold{8}; //!< Threshold for the number of consecutive CPU uploads to the texture without any GPU writes to it after which it's migrated to a linear backing
+        size_t cpuUploadCount{}; //!< Number of consecutive guest -> host synchronizations of CPU written data without the texture being written by the GPU inbetween
+        bool linearMigrationAttempted{}; //!< If the texture has already been considered for migration to a linear backing, it's only attempted once as failures are host limitations
+        bool mutableFormatPending{}; //!< If a view with a format that requires VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT was requested while the backing was created without it, the backing is recreated with it on the next first usage of the texture in a context
+
+        u64 lastAccessTimestamp{}; //!< The value of the texture manager's access counter when this texture was last looked up, textures with the lowest value are evicted first
+        memory::ResourceClass resourceClass{memory::ResourceClass::SampledTexture}; //!< The class of the memory pool that the backing is allocated from
+        bool hostImageCopy{}; //!< If the optimal backing was created with VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT and can be written into directly from the CPU
+        vk::DeviceSize gpuDeswizzleOffset{}; //!< If non-zero, the staging buffer returned by SynchronizeHostImpl contains block-linear guest data which must be deswizzled on the GPU into the linear region at this offset
+
       public:
         std::shared_ptr<FenceCycle> cycle; //!< A fence cycle for when any host operation mutating the texture has completed, it must be waited on prior to any mutations to the backing
         std::optional<GuestTexture> guest;
-        texture::Dimensions dimensions;
+        texture::Dimensions dimensions; //!< The dimensions of the host texture, these are the guest dimensions multiplied by the resolution scale
+        float scale{1.0f}; //!< The factor that the host resolution of the texture is scaled by relative to the guest resolution, this is only non-1 for render targets when resolution scaling is enabled
         texture::Format format;
         vk::ImageLayout layout;
         vk::ImageTiling tiling;
@@ -462,6 +629,11 @@ namespace skyline::gpu {
         size_t deswizzledSurfaceSize{}; //!< The size of the guest surface with linear tiling, calculated with the guest format which may differ from the host format
         size_t surfaceSize{}; //!< The size of the entire surface given linear tiling, this contains all mip levels and layers
         vk::SampleCountFlagBits sampleCount;
+        u64 modificationCounter{}; //!< Incremented whenever the contents of the backing may have been modified, this is conservative and includes any usage by the GPU executor as writes aren't tracked explicitly
+
+        static constexpr u32 TransientAttachmentThreshold{16}; //!< Threshold for the number of consecutive render passes that must entirely clear a depth/stencil texture before it's considered to be transient
+        std::atomic<u32> clearedRenderPassCount{}; //!< Number of consecutive render passes that have entirely cleared all aspects of the texture when beginning, this is only updated by the command record thread
+        std::atomic<bool> contentsObserved{}; //!< If the contents of the texture have ever been used outside of the render passes it's attached to, such as by being sampled, copied or read back by the CPU
 
         /**
          * @brief Creates a texture object wrapping the supplied backing with the supplied attributes
@@ -471,12 +643,34 @@ namespace skyline::gpu {
 
         /**
          * @brief Creates a texture object wrapping the guest texture with a backing that can represent the guest texture data
+         * @param scale The resolution scale to create the backing with, any value other than 1 requires the texture to be a single-level uncompressed 2D texture
+         * @param cpuShared If the texture is known to be written by the CPU, the backing will be a host-visible linear image that guest data can be written into directly when the host supports it
+         * @param renderTarget If the texture is being created as a render target, its backing is allocated from the render target pool rather than the sampled texture pool
          * @note The guest mappings will not be setup until SetupGuestMappings() is called
          */
-        Texture(GPU &gpu, GuestTexture guest);
+        Texture(GPU &gpu, GuestTexture guest, float scale = 1.0f, bool cpuShared = false, bool renderTarget = false);
 
         ~Texture();
 
+        /**
+         * @note The texture is only moved if it can be locked without blocking and isn't in use by the GPU
+         */
+        std::shared_ptr<void> MoveImage(VmaAllocation allocation, const vk::raii::CommandBuffer &commandBuffer, const std::function<vk::Image(const vk::ImageCreateInfo &)> &createImage) override;
+
+        /**
+         * @brief Marks the contents of the texture as being used outside of a render pass, they'll never be discarded by the transient attachment hack after this
+         */
+        void MarkContentsObserved() {
+            contentsObserved.store(true, std::memory_order_relaxed);
+        }
+
+        /**
+         * @return If the texture has only ever been used as an attachment that's entirely cleared prior to being rendered to, its contents at the end of a render pass are assumed to never be required
+         */
+        bool IsTransientAttachment() const {
+            return !contentsObserved.load(std::memory_order_relaxed) && clearedRenderPassCount.load(std::memory_order_relaxed) >= TransientAttachmentThreshold;
+        }
+
         /**
          * @note The handle returned is nullable and the appropriate precautions should be taken
          */
@@ -569,6 +763,12 @@ namespace skyline::gpu {
          */
         std::shared_ptr<TextureView> GetView(vk::ImageViewType type, vk::ImageSubresourceRange range, texture::Format format = {}, vk::ComponentMapping mapping = {});
 
+        /**
+         * @return If the contents of the texture can be reinterpreted with the supplied format through a view without any conversion
+         * @note This is only true for uncompressed color formats with the same texel size when the image was created with a mutable format, can be promoted to one cheaply or the host can alias the formats without it
+         */
+        bool CanAliasFormat(texture::Format viewFormat);
+
         /**
          * @brief Copies the contents of the supplied source texture into the current texture
          */
@@ -1,13 +1,203 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <common/settings.h>
+#include <common/trace.h>
+#include <common/perf_stats.h>
+#include <gpu.h>
 #include "texture_manager.h"
 
 namespace skyline::gpu {
-    TextureManager::TextureManager(GPU &gpu) : gpu(gpu) {}
+    TextureManager::TextureManager(GPU &gpu) : gpu(gpu) {
+        if (u32 budgetGib{*gpu.state.settings->textureMemoryBudget})
+            memoryBudget = static_cast<size_t>(budgetGib) << 30;
+        else
+            memoryBudget = gpu.memory.GetDeviceLocalBudget() / 2; // Textures are the largest consumer of memory but buffers, pipelines and the guest itself need to fit within the budget alongside them
 
-    std::shared_ptr<TextureView> TextureManager::FindOrCreate(const GuestTexture &guestTexture, ContextTag tag) {
+        Logger::Info("Texture memory budget: {} MiB", memoryBudget / (1024 * 1024));
+    }
+
+    /**
+     * @return If the mappings of the host texture starting at the supplied mapping match up perfectly 1:1 with *all* mappings of the guest texture
+     */
+    static bool IsPerfectMatch(const GuestTexture &guestTexture, GuestTexture::Mappings &hostMappings, GuestTexture::Mappings::iterator firstHostMapping) {
+        // We need to check that all corresponding mappings in the candidate texture and the guest texture match up
+        // Only the start of the first matched mapping and the end of the last mapping can not match up as this is the case for views
+        auto lastGuestMapping{guestTexture.mappings.back()};
+        auto lastHostMapping{std::find_if(firstHostMapping, hostMappings.end(), [&lastGuestMapping](const span<u8> &it) {
+            return lastGuestMapping.begin() > it.begin() && lastGuestMapping.end() > it.end();
+        })}; //!< A past-the-end iterator for the last host mapping, the final valid mapping is prior to this iterator
+        bool mappingMatch{std::equal(firstHostMapping, lastHostMapping, guestTexture.mappings.begin(), guestTexture.mappings.end(), [](const span<u8> &lhs, const span<u8> &rhs) {
+            return lhs.end() == rhs.end(); // We check end() here to implicitly ignore any offset from the first mapping
+        })};
+
+        return firstHostMapping == hostMappings.begin() && firstHostMapping->begin() == guestTexture.mappings.front().begin() && mappingMatch && lastHostMapping == hostMappings.end() && lastGuestMapping.end() == std::prev(lastHostMapping)->end();
+    }
+
+    /**
+     * @return If a view of the guest texture can be created from the host texture with perfectly matching mappings
+     */
+    static bool IsCompatible(const GuestTexture &matchGuestTexture, const GuestTexture &guestTexture) {
+        return matchGuestTexture.format->IsCompatible(*guestTexture.format) &&
+            ((((matchGuestTexture.dimensions.width == guestTexture.dimensions.width &&
+               matchGuestTexture.dimensions.height == guestTexture.dimensions.height) || matchGuestTexture.CalculateLayerSize() == guestTexture.CalculateLayerSize()) &&
+               matchGuestTexture.GetViewDepth() <= guestTexture.GetViewDepth())
+              || matchGuestTexture.viewMipBase > 0)
+             && matchGuestTexture.tileConfig == guestTexture.tileConfig;
+    }
+
+    /**
+     * @return If a view of the guest texture can be created from the host texture by reinterpreting its contents with a bit-compatible format, this avoids a round trip through guest memory when a render target is reinterpreted
+     */
+    static bool IsAliasable(Texture &texture, const GuestTexture &guestTexture) {
+        auto &matchGuestTexture{*texture.guest};
+        return matchGuestTexture.dimensions.width == guestTexture.dimensions.width &&
+            matchGuestTexture.dimensions.height == guestTexture.dimensions.height &&
+            matchGuestTexture.GetViewDepth() <= guestTexture.GetViewDepth() &&
+            matchGuestTexture.tileConfig == guestTexture.tileConfig &&
+            texture.CanAliasFormat(guestTexture.format);
+    }
+
+    /**
+     * @return A view of the texture corresponding to the view type and subresource range of the guest texture
+     */
+    static std::shared_ptr<TextureView> GetGuestView(Texture &texture, const GuestTexture &guestTexture) {
+        return texture.GetView(guestTexture.viewType, vk::ImageSubresourceRange{
+            .aspectMask = guestTexture.aspect,
+            .baseMipLevel = guestTexture.viewMipBase,
+            .levelCount = guestTexture.viewMipCount,
+            .baseArrayLayer = guestTexture.baseArrayLayer,
+            .layerCount = guestTexture.GetViewLayerCount(),
+        }, guestTexture.format, guestTexture.swizzle);
+    }
+
+    void TextureManager::InsertTexture(const std::shared_ptr<Texture> &texture) {
+        auto &mappings{texture->guest->mappings};
+        for (auto it{mappings.begin()}; it != mappings.end(); it++) {
+            textures.emplace(it->data(), TextureMapping{texture, it, *it});
+            largestMappingSize = std::max(largestMappingSize, it->size());
+        }
+
+        // Only the page containing the start of the texture is set as lookups are always performed with the start of the first mapping
+        auto firstPage{util::AlignDown(mappings.front().data(), constant::PageSize)};
+        textureTable.Set(firstPage, firstPage + constant::PageSize, texture.get());
+
+        residentBytes += texture->surfaceSize;
+        TRACE_COUNTER("gpu", "TextureResidentBytes", residentBytes.load(std::memory_order_relaxed));
+    }
+
+    void TextureManager::RemoveTexture(const std::shared_ptr<Texture> &texture) {
+        auto &mappings{texture->guest->mappings};
+        for (const auto &mapping : mappings) {
+            auto [begin, end]{textures.equal_range(mapping.data())};
+            for (auto it{begin}; it != end;) {
+                if (it->second.texture == texture)
+                    it = textures.erase(it);
+                else
+                    ++it;
+            }
+        }
+
+        // The page table entry may have been overwritten by a newer texture starting in the same page which must be retained
+        auto firstPage{util::AlignDown(mappings.front().data(), constant::PageSize)};
+        if (textureTable[firstPage] == texture.get())
+            textureTable.Set(firstPage, firstPage + constant::PageSize, nullptr);
+
+        residentBytes -= texture->surfaceSize;
+        TRACE_COUNTER("gpu", "TextureResidentBytes", residentBytes.load(std::memory_order_relaxed));
+    }
+
+    size_t TextureManager::EvictTextures(size_t targetBytes, bool cleanOnly) {
+        TRACE_EVENT("gpu", "TextureManager::EvictTextures");
+
+        // Only textures that are solely referenced by their mappings in the map can be evicted, any other references are from active TIC entries, render targets or pending GPU work
+        std::vector<std::shared_ptr<Texture>> candidates;
+        for (const auto &[base, mapping] : textures) {
+            auto &hostMappings{mapping.texture->guest->mappings};
+            if (mapping.iterator == hostMappings.begin() && static_cast<size_t>(mapping.texture.use_count()) == hostMappings.size())
+                candidates.push_back(mapping.texture);
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [](const std::shared_ptr<Texture> &lhs, const std::shared_ptr<Texture> &rhs) {
+            return lhs->lastAccessTimestamp < rhs->lastAccessTimestamp;
+        });
+
+        size_t evictedCount{}, evictedBytes{};
+        for (const auto &texture : candidates) {
+            if (residentBytes <= targetBytes)
+                break;
+
+            std::unique_lock textureLock{*texture, std::try_to_lock};
+            if (!textureLock)
+                continue; // The texture is being used by another thread, we can't evict it
+
+            if (cleanOnly && texture->dirtyState == Texture::DirtyState::GpuDirty)
+                continue; // Writing back the texture requires a GPU readback which is too costly when only trimming clean textures
+
+            texture->SynchronizeGuest(true);
+            RemoveTexture(texture);
+
+            evictedCount++;
+            evictedBytes += texture->surfaceSize;
+        }
+
+        Logger::Debug("Evicted {} textures ({} MiB), {} MiB resident", evictedCount, evictedBytes / (1024 * 1024), residentBytes / (1024 * 1024));
+        return evictedBytes;
+    } // Evicted textures are destroyed here as the candidates hold the last references to them
+
+    float TextureManager::GetRenderTargetScale(const GuestTexture &guestTexture) {
+        u32 scalePercent{*gpu.state.settings->resolutionScale};
+        if (gpu.governor.IsResolutionScaleCapped())
+            scalePercent = std::min(scalePercent, 100U); // Upscaling is disabled for new render targets under severe thermal pressure, existing ones retain their scale
+        if (!scalePercent || scalePercent == 100)
+            return 1.0f;
+
+        // Rescaling is done with blits which only operate on a single level, linear render targets are skipped as they're typically written for the CPU to read
+        if (guestTexture.mipLevelCount != 1 || guestTexture.GetImageType() != vk::ImageType::e2D || guestTexture.tileConfig.mode != texture::TileMode::Block || guestTexture.format->IsCompressed())
+            return 1.0f;
+
+        if (guestTexture.dimensions.width < MinimumScaledDimension || guestTexture.dimensions.height < MinimumScaledDimension)
+            return 1.0f;
+
+        constexpr vk::FormatFeatureFlags BlitFeatures{vk::FormatFeatureFlagBits::eBlitSrc | vk::FormatFeatureFlagBits::eBlitDst};
+        if ((gpu.vkPhysicalDevice.getFormatProperties(*guestTexture.format).optimalTilingFeatures & BlitFeatures) != BlitFeatures)
+            return 1.0f;
+
+        {
+            std::scoped_lock lock{readbackMutex};
+            if (readbackAddresses.contains(guestTexture.mappings.front().data()))
+                return 1.0f;
+        }
+
+        return static_cast<float>(scalePercent) / 100.0f;
+    }
+
+    std::shared_ptr<TextureView> TextureManager::GetLockedView(std::unique_lock<std::mutex> &lock, std::shared_ptr<Texture> texture, ContextTag tag, const std::function<std::shared_ptr<TextureView>(Texture &)> &getView) {
+        lock.unlock();
+        ContextLock textureLock{tag, *texture};
+        auto view{getView(*texture)};
+        if (texture->mutableFormatPending) {
+            if (textureLock.IsFirstUsage())
+                texture->PromoteToMutableFormat();
+            else
+                Logger::Warn("Texture requires a mutable format during its usage in an execution, it'll be promoted on its next use: {}", vk::to_string(texture->format->vkFormat));
+        }
+        return view;
+    }
+
+    std::shared_ptr<TextureView> TextureManager::FindOrCreate(const GuestTexture &guestTexture, ContextTag tag, bool renderTarget, bool cpuShared) {
+        std::unique_lock lock{mutex};
         auto guestMapping{guestTexture.mappings.front()};
+        auto getGuestView{[&guestTexture](Texture &texture) { return GetGuestView(texture, guestTexture); }};
+
+        // Try to do a fast lookup in the page table for the most recently created texture starting at the same address
+        if (auto lookupTexture{textureTable[guestMapping.data()]}; lookupTexture) {
+            auto &lookupMappings{lookupTexture->guest->mappings};
+            if (IsPerfectMatch(guestTexture, lookupMappings, lookupMappings.begin()) && (IsCompatible(*lookupTexture->guest, guestTexture) || IsAliasable(*lookupTexture, guestTexture))) {
+                lookupTexture->lastAccessTimestamp = ++accessTimestamp;
+                return GetLockedView(lock, lookupTexture->shared_from_this(), tag, getGuestView);
+            }
+        }
 
         /*
          * Iterate over all textures that overlap with the first mapping of the guest texture and compare the mappings:
@@ -23,45 +213,21 @@ namespace skyline::gpu {
          * 5) Create a new texture and insert it in the map then return it
          */
 
-        std::shared_ptr<Texture> match{};
         boost::container::small_vector<std::shared_ptr<Texture>, 4> matches{};
-        auto mappingEnd{std::upper_bound(textures.begin(), textures.end(), guestMapping)}, hostMapping{mappingEnd};
-        while (hostMapping != textures.begin() && (--hostMapping)->end() > guestMapping.begin()) {
-            auto &hostMappings{hostMapping->texture->guest->mappings};
-            if (!hostMapping->contains(guestMapping))
+        // Any mapping starting further back than the largest mapping can't contain the guest mapping, this bounds the search
+        for (auto hostMapping{textures.upper_bound(guestMapping.data())}; hostMapping != textures.begin() && static_cast<size_t>(guestMapping.data() - (--hostMapping)->first) < largestMappingSize;) {
+            auto &mapping{hostMapping->second};
+            if (!mapping.contains(guestMapping))
                 continue;
 
-            // We need to check that all corresponding mappings in the candidate texture and the guest texture match up
-            // Only the start of the first matched mapping and the end of the last mapping can not match up as this is the case for views
-            auto firstHostMapping{hostMapping->iterator};
-            auto lastGuestMapping{guestTexture.mappings.back()};
-            auto lastHostMapping{std::find_if(firstHostMapping, hostMappings.end(), [&lastGuestMapping](const span<u8> &it) {
-                return lastGuestMapping.begin() > it.begin() && lastGuestMapping.end() > it.end();
-            })}; //!< A past-the-end iterator for the last host mapping, the final valid mapping is prior to this iterator
-            bool mappingMatch{std::equal(firstHostMapping, lastHostMapping, guestTexture.mappings.begin(), guestTexture.mappings.end(), [](const span<u8> &lhs, const span<u8> &rhs) {
-                return lhs.end() == rhs.end(); // We check end() here to implicitly ignore any offset from the first mapping
-            })};
-
-            if (firstHostMapping == hostMappings.begin() && firstHostMapping->begin() == guestMapping.begin() && mappingMatch && lastHostMapping == hostMappings.end() && lastGuestMapping.end() == std::prev(lastHostMapping)->end()) {
+            if (IsPerfectMatch(guestTexture, mapping.texture->guest->mappings, mapping.iterator)) {
                 // We've gotten a perfect 1:1 match for *all* mappings from the start to end, we just need to check for compatibility aside from this
-                auto &matchGuestTexture{*hostMapping->texture->guest};
-                if (matchGuestTexture.format->IsCompatible(*guestTexture.format) &&
-                    ((((matchGuestTexture.dimensions.width == guestTexture.dimensions.width &&
-                       matchGuestTexture.dimensions.height == guestTexture.dimensions.height) || matchGuestTexture.CalculateLayerSize() == guestTexture.CalculateLayerSize()) &&
-                       matchGuestTexture.GetViewDepth() <= guestTexture.GetViewDepth())
-                      || matchGuestTexture.viewMipBase > 0)
-                     && matchGuestTexture.tileConfig == guestTexture.tileConfig) {
-                    auto &texture{hostMapping->texture};
-                    ContextLock textureLock{tag, *texture};
-                    return texture->GetView(guestTexture.viewType, vk::ImageSubresourceRange{
-                        .aspectMask = guestTexture.aspect,
-                        .baseMipLevel = guestTexture.viewMipBase,
-                        .levelCount = guestTexture.viewMipCount,
-                        .baseArrayLayer = guestTexture.baseArrayLayer,
-                        .layerCount = guestTexture.GetViewLayerCount(),
-                    }, guestTexture.format, guestTexture.swizzle);
+                if (IsCompatible(*mapping.texture->guest, guestTexture) || IsAliasable(*mapping.texture, guestTexture)) {
+                    auto &texture{mapping.texture};
+                    texture->lastAccessTimestamp = ++accessTimestamp;
+                    return GetLockedView(lock, texture, tag, getGuestView);
                 } else {
-                    matches.push_back(hostMapping->texture);
+                    matches.push_back(mapping.texture);
                 }
             } /* else if (mappingMatch) {
                 // We've gotten a partial match with a certain subset of contiguous mappings matching, we need to check if this is a meaningful overlap
@@ -77,28 +243,82 @@ namespace skyline::gpu {
             } */
         }
 
-        for (auto &texture : matches)
+        for (auto &texture : matches) {
+            texture->cpuReadbackCount++; // The new texture will be read from the guest data of the overlapping texture
+            texture->MarkContentsObserved();
             texture->SynchronizeGuest(false, true);
+        }
+        matches.clear(); // The references to the matches must be dropped so they can be evicted
+
+        if (IsOverBudget())
+            EvictTextures(memoryBudget - (memoryBudget / 4)); // We evict down to below the budget to avoid immediately going over the budget again after the next texture is created
 
         // Create a texture as we cannot find one that matches
-        auto texture{std::make_shared<Texture>(gpu, guestTexture)};
+        auto texture{std::make_shared<Texture>(gpu, guestTexture, renderTarget ? GetRenderTargetScale(guestTexture) : 1.0f, cpuShared, renderTarget)};
+        PerfStats::Increment(PerfStats::Counter::TextureCreations);
         texture->SetupGuestMappings();
         texture->TransitionLayout(vk::ImageLayout::eGeneral);
-        auto it{texture->guest->mappings.begin()};
-        textures.emplace(mappingEnd, TextureMapping{texture, it, guestMapping});
-        while ((++it) != texture->guest->mappings.end()) {
-            guestMapping = *it;
-            auto mapping{std::upper_bound(textures.begin(), textures.end(), guestMapping)};
-            // TODO: Delete overlapping textures that aren't in texture pool
-            textures.emplace(mapping, TextureMapping{texture, it, guestMapping});
+        texture->lastAccessTimestamp = ++accessTimestamp;
+        InsertTexture(texture);
+
+        return GetGuestView(*texture, guestTexture);
+    }
+
+    void TextureManager::MarkCpuReadback(u8 *address) {
+        std::scoped_lock lock{readbackMutex};
+        if (readbackAddresses.insert(address).second)
+            Logger::Debug("Scaled texture at 0x{:X} was read back by the CPU, it'll use the native resolution when recreated", reinterpret_cast<uintptr_t>(address));
+    }
+
+    std::shared_ptr<TextureView> TextureManager::Lookup(u8 *address, ContextTag tag) {
+        std::unique_lock lock{mutex};
+        auto getFullView{[&](Texture &texture) {
+            texture.lastAccessTimestamp = ++accessTimestamp;
+            return GetLockedView(lock, texture.shared_from_this(), tag, [](Texture &lockedTexture) {
+                return lockedTexture.GetView(lockedTexture.guest->viewType, vk::ImageSubresourceRange{
+                    .aspectMask = lockedTexture.format->vkAspect,
+                    .levelCount = lockedTexture.levelCount,
+                    .layerCount = lockedTexture.layerCount,
+                }, lockedTexture.format);
+            });
+        }};
+
+        auto isMatch{[address](const Texture &texture) {
+            auto &mappings{texture.guest->mappings};
+            return mappings.size() == 1 && mappings.front().data() == address;
+        }};
+
+        if (auto lookupTexture{textureTable[address]}; lookupTexture && isMatch(*lookupTexture))
+            return getFullView(*lookupTexture);
+
+        auto [begin, end]{textures.equal_range(address)};
+        for (auto it{begin}; it != end; it++)
+            if (isMatch(*it->second.texture))
+                return getFullView(*it->second.texture);
+
+        return nullptr;
+    }
+
+    size_t TextureManager::Trim(bool cleanOnly) {
+        std::scoped_lock lock{mutex};
+        return EvictTextures(0, cleanOnly);
+    }
+
+    void TextureManager::SynchronizeGuest() {
+        TRACE_EVENT("gpu", "TextureManager::SynchronizeGuest");
+
+        // Textures are never blockingly locked while the texture manager is locked, so they're collected prior to being locked
+        std::vector<std::shared_ptr<Texture>> dirtyTextures;
+        {
+            std::scoped_lock lock{mutex};
+            for (const auto &[base, mapping] : textures)
+                if (mapping.iterator == mapping.texture->guest->mappings.begin() && mapping.texture->dirtyState == Texture::DirtyState::GpuDirty)
+                    dirtyTextures.push_back(mapping.texture);
         }
 
-        return texture->GetView(guestTexture.viewType, vk::ImageSubresourceRange{
-            .aspectMask = guestTexture.aspect,
-            .baseMipLevel = guestTexture.viewMipBase,
-            .levelCount = guestTexture.viewMipCount,
-            .baseArrayLayer = guestTexture.baseArrayLayer,
-            .layerCount = guestTexture.GetViewLayerCount(),
-        }, guestTexture.format, guestTexture.swizzle);
+        for (const auto &texture : dirtyTextures) {
+            std::scoped_lock lock{*texture};
+            texture->SynchronizeGuest();
+        }
     }
 }
@@ -3,6 +3,9 @@
 
 #pragma once
 
+#include <map>
+#include <unordered_set>
+#include <common/segment_table.h>
 #include "texture/texture.h"
 
 namespace skyline::gpu {
@@ -26,15 +29,101 @@ namespace skyline::gpu {
         };
 
         GPU &gpu;
-        std::vector<TextureMapping> textures; //!< A sorted vector of all texture mappings
+        std::mutex mutex; //!< Synchronizes access to the texture map, the page table and the access timestamp, textures are never blockingly locked while this is held as they may be held by an execution that is waiting on this
+        std::multimap<u8 *, TextureMapping> textures; //!< All texture mappings keyed by their base address, this allows for O(log n) insertion and removal
+        size_t largestMappingSize{}; //!< The size of the largest mapping that has been inserted, this bounds the range of mappings that have to be considered for overlaps
+
+        static constexpr size_t L2EntryGranularity{19}; //!< The amount of AS (in bytes) a single L2 PTE covers (512 KiB == 1 << 19)
+        SegmentTable<Texture *, constant::AddressSpaceSize, constant::PageSizeBits, L2EntryGranularity> textureTable; //!< A page table of the most recently created texture starting in each page for O(1) lookups on full matches
+
+        size_t memoryBudget; //!< The amount of memory in bytes that textures in the map can use before unused textures are evicted
+        std::atomic<size_t> residentBytes{}; //!< The total size of all textures in the map in bytes
+        u64 accessTimestamp{}; //!< A counter that is incremented on every lookup, it's used to order textures by their last usage
+
+        static constexpr u32 MinimumScaledDimension{64}; //!< The minimum width and height of a render target for it to be scaled, smaller targets are commonly used for reductions which are read back by the CPU
+        std::mutex readbackMutex; //!< Synchronizes access to `readbackAddresses`, it's accessed from CPU trap handlers which don't hold the texture manager lock
+        std::unordered_set<u8 *> readbackAddresses; //!< The base addresses of scaled textures that have been read back by the CPU, render targets created at these addresses are never scaled
+
+        /**
+         * @return The resolution scale that a new render target corresponding to the guest texture should be created with
+         */
+        float GetRenderTargetScale(const GuestTexture &guestTexture);
+
+        /**
+         * @brief Inserts all mappings of the supplied texture into the map and the page table
+         */
+        void InsertTexture(const std::shared_ptr<Texture> &texture);
+
+        /**
+         * @brief Removes all mappings of the supplied texture from the map and the page table, the lifetime of the texture will no longer be extended by the map
+         */
+        void RemoveTexture(const std::shared_ptr<Texture> &texture);
+
+        /**
+         * @brief Evicts the least recently used textures which aren't referenced outside of the map until the resident size is at or below the target
+         * @param cleanOnly If only textures which don't have any GPU modifications that would need to be written back to the guest should be evicted
+         * @return The amount of bytes that were evicted
+         * @note Any modifications to evicted textures by the GPU are written back to the guest prior to them being freed
+         * @note The texture manager mutex **must** be locked prior to calling this
+         */
+        size_t EvictTextures(size_t targetBytes, bool cleanOnly = false);
+
+        /**
+         * @brief Unlocks the texture manager and then locks the supplied texture with the tag while the view is created from it
+         * @note The reference held by this prevents the texture from being evicted while the texture manager is unlocked
+         */
+        static std::shared_ptr<TextureView> GetLockedView(std::unique_lock<std::mutex> &lock, std::shared_ptr<Texture> texture, ContextTag tag, const std::function<std::shared_ptr<TextureView>(Texture &)> &getView);
 
       public:
         TextureManager(GPU &gpu);
 
         /**
          * @return A pre-existing or newly created Texture object which matches the specified criteria
-         * @note The texture manager **must** be locked prior to calling this
+         * @param renderTarget If the texture is being looked up for usage as a render target, newly created textures may be scaled by the resolution scale in this case
+         * @param cpuShared If the texture is known to be written by the CPU, newly created textures will be backed by a CPU-shared image when possible
+         * @note The texture manager is locked internally, this can be called from any thread
+         */
+        std::shared_ptr<TextureView> FindOrCreate(const GuestTexture &guestTexture, ContextTag tag = {}, bool renderTarget = false, bool cpuShared = false);
+
+        /**
+         * @brief Records that a scaled texture starting at the supplied address was read back by the CPU, any render targets subsequently created at the address will use the native resolution
+         * @note The texture manager doesn't need to be locked prior to calling this
+         */
+        void MarkCpuReadback(u8 *address);
+
+        /**
+         * @return A view spanning the entirety of a pre-existing texture which has a single mapping starting at the supplied address, this is nullptr if there's no such texture
+         * @note This never creates a texture, it's intended for opportunistically performing operations on the GPU when the guest data is already GPU-resident
+         * @note The texture manager is locked internally, this can be called from any thread
+         */
+        std::shared_ptr<TextureView> Lookup(u8 *address, ContextTag tag = {});
+
+        /**
+         * @return The total size of all textures tracked by the texture manager in bytes
+         */
+        size_t GetResidentBytes() const {
+            return residentBytes.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @return If the textures tracked by the texture manager exceed the memory budget, holders of texture views should release any views they don't require in this case
+         */
+        bool IsOverBudget() const {
+            return GetResidentBytes() > memoryBudget;
+        }
+
+        /**
+         * @brief Evicts all textures which aren't referenced outside of the map, textures that are still in use (E.g. bound render targets) are retained
+         * @param cleanOnly If textures with GPU modifications should be retained, evicting the rest is cheap as they're only host copies of guest memory
+         * @return The amount of bytes that were evicted
+         * @note The texture manager is locked internally, this can be called from any thread
+         */
+        size_t Trim(bool cleanOnly = false);
+
+        /**
+         * @brief Writes back GPU modifications of all textures into their guest mappings, the textures are retained
+         * @note The texture manager is locked internally, this can be called from any thread
          */
-        std::shared_ptr<TextureView> FindOrCreate(const GuestTexture &guestTexture, ContextTag tag = {});
+        void SynchronizeGuest();
     };
 }
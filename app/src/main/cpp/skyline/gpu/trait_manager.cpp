@@ -6,7 +6,7 @@
 
 namespace skyline::gpu {
     TraitManager::TraitManager(const DeviceFeatures2 &deviceFeatures2, DeviceFeatures2 &enabledFeatures2, const std::vector<vk::ExtensionProperties> &deviceExtensions, std::vector<std::array<char, VK_MAX_EXTENSION_NAME_SIZE>> &enabledExtensions, const DeviceProperties2 &deviceProperties2, const vk::raii::PhysicalDevice &physicalDevice) : quirks(deviceProperties2.get<vk::PhysicalDeviceProperties2>().properties, deviceProperties2.get<vk::PhysicalDeviceDriverProperties>()) {
-        bool hasCustomBorderColorExt{}, hasShaderAtomicInt64Ext{}, hasShaderFloat16Int8Ext{}, hasShaderDemoteToHelperExt{}, hasVertexAttributeDivisorExt{}, hasProvokingVertexExt{}, hasPrimitiveTopologyListRestartExt{}, hasImagelessFramebuffersExt{}, hasTransformFeedbackExt{}, hasUint8IndicesExt{};
+        bool hasCustomBorderColorExt{}, hasShaderAtomicInt64Ext{}, hasShaderFloat16Int8Ext{}, hasShaderDemoteToHelperExt{}, hasVertexAttributeDivisorExt{}, hasProvokingVertexExt{}, hasPrimitiveTopologyListRestartExt{}, hasImagelessFramebuffersExt{}, hasTimelineSemaphoreExt{}, hasTransformFeedbackExt{}, hasUint8IndicesExt{}, hasExtendedDynamicStateExt{}, hasExtendedDynamicState2Ext{}, hasPipelineLibraryExt{}, hasGraphicsPipelineLibraryExt{}, hasMultiDrawExt{}, hasCreateRenderPass2Ext{}, hasDepthStencilResolveExt{}, hasDynamicRenderingExt{}, hasCopyCommands2Ext{}, hasFormatFeatureFlags2Ext{}, hasHostImageCopyExt{};
         bool supportsUniformBufferStandardLayout{}; // We require VK_KHR_uniform_buffer_standard_layout but assume it is implicitly supported even when not present
 
         for (auto &extension : deviceExtensions) {
@@ -47,6 +47,7 @@ namespace skyline::gpu {
                 EXT_SET("VK_EXT_vertex_attribute_divisor", hasVertexAttributeDivisorExt);
                 EXT_SET_COND("VK_KHR_push_descriptor", supportsPushDescriptors, !quirks.brokenPushDescriptors);
                 EXT_SET("VK_KHR_imageless_framebuffer", hasImagelessFramebuffersExt);
+                EXT_SET("VK_KHR_timeline_semaphore", hasTimelineSemaphoreExt);
                 EXT_SET("VK_EXT_global_priority", supportsGlobalPriority);
                 EXT_SET("VK_EXT_shader_viewport_index_layer", supportsShaderViewportIndexLayer);
                 EXT_SET("VK_KHR_spirv_1_4", supportsSpirv14);
@@ -57,6 +58,19 @@ namespace skyline::gpu {
                 EXT_SET("VK_KHR_uniform_buffer_standard_layout", supportsUniformBufferStandardLayout);
                 EXT_SET("VK_EXT_primitive_topology_list_restart", hasPrimitiveTopologyListRestartExt);
                 EXT_SET("VK_EXT_transform_feedback", hasTransformFeedbackExt);
+                EXT_SET("VK_EXT_image_compression_control", supportsImageCompressionControl);
+                EXT_SET("VK_EXT_extended_dynamic_state", hasExtendedDynamicStateExt);
+                EXT_SET("VK_EXT_extended_dynamic_state2", hasExtendedDynamicState2Ext);
+                EXT_SET("VK_KHR_pipeline_library", hasPipelineLibraryExt);
+                EXT_SET("VK_EXT_graphics_pipeline_library", hasGraphicsPipelineLibraryExt);
+                EXT_SET("VK_EXT_multi_draw", hasMultiDrawExt);
+                EXT_SET("VK_KHR_create_renderpass2", hasCreateRenderPass2Ext);
+                EXT_SET("VK_KHR_depth_stencil_resolve", hasDepthStencilResolveExt);
+                EXT_SET_COND("VK_KHR_dynamic_rendering", hasDynamicRenderingExt, !quirks.brokenDynamicRendering);
+                EXT_SET("VK_EXT_external_memory_host", supportsExternalMemoryHost);
+                EXT_SET("VK_KHR_copy_commands2", hasCopyCommands2Ext);
+                EXT_SET("VK_KHR_format_feature_flags2", hasFormatFeatureFlags2Ext);
+                EXT_SET("VK_EXT_host_image_copy", hasHostImageCopyExt);
             }
 
             #undef EXT_SET
@@ -144,6 +158,11 @@ namespace skyline::gpu {
             enabledFeatures2.unlink<vk::PhysicalDeviceImagelessFramebufferFeatures>();
         }
 
+        if (hasTimelineSemaphoreExt)
+            FEAT_SET(vk::PhysicalDeviceTimelineSemaphoreFeatures, timelineSemaphore, supportsTimelineSemaphores)
+        else
+            enabledFeatures2.unlink<vk::PhysicalDeviceTimelineSemaphoreFeatures>();
+
         if (hasTransformFeedbackExt) {
             bool hasTransformFeedbackFeat{}, hasGeometryStreamsStreamsFeat{};
             FEAT_SET(vk::PhysicalDeviceTransformFeedbackFeaturesEXT, transformFeedback, hasTransformFeedbackFeat)
@@ -156,15 +175,71 @@ namespace skyline::gpu {
             enabledFeatures2.unlink<vk::PhysicalDeviceTransformFeedbackFeaturesEXT>();
         }
 
+        if (hasExtendedDynamicStateExt)
+            FEAT_SET(vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT, extendedDynamicState, supportsExtendedDynamicState)
+        else
+            enabledFeatures2.unlink<vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT>();
+
+        // The second extension is only used alongside the first as the key masking assumes the state from the first is dynamic
+        if (hasExtendedDynamicState2Ext && supportsExtendedDynamicState)
+            FEAT_SET(vk::PhysicalDeviceExtendedDynamicState2FeaturesEXT, extendedDynamicState2, supportsExtendedDynamicState2)
+        else
+            enabledFeatures2.unlink<vk::PhysicalDeviceExtendedDynamicState2FeaturesEXT>();
+
+        if (hasPipelineLibraryExt && hasGraphicsPipelineLibraryExt) {
+            bool hasGraphicsPipelineLibraryFeat{};
+            FEAT_SET(vk::PhysicalDeviceGraphicsPipelineLibraryFeaturesEXT, graphicsPipelineLibrary, hasGraphicsPipelineLibraryFeat)
+
+            // Libraries are only beneficial if linking them is cheap, otherwise monolithic pipelines are compiled as usual
+            if (hasGraphicsPipelineLibraryFeat && deviceProperties2.get<vk::PhysicalDeviceGraphicsPipelineLibraryPropertiesEXT>().graphicsPipelineLibraryFastLinking)
+                supportsGraphicsPipelineLibrary = true;
+        } else {
+            enabledFeatures2.unlink<vk::PhysicalDeviceGraphicsPipelineLibraryFeaturesEXT>();
+        }
+
+        if (hasMultiDrawExt) {
+            bool hasMultiDrawFeat{};
+            FEAT_SET(vk::PhysicalDeviceMultiDrawFeaturesEXT, multiDraw, hasMultiDrawFeat)
+            if (hasMultiDrawFeat)
+                maxMultiDrawCount = deviceProperties2.get<vk::PhysicalDeviceMultiDrawPropertiesEXT>().maxMultiDrawCount;
+        } else {
+            enabledFeatures2.unlink<vk::PhysicalDeviceMultiDrawFeaturesEXT>();
+        }
+
+        // On Vulkan 1.1, VK_KHR_dynamic_rendering depends on VK_KHR_depth_stencil_resolve which in turn depends on VK_KHR_create_renderpass2
+        if (hasDynamicRenderingExt && hasDepthStencilResolveExt && hasCreateRenderPass2Ext)
+            FEAT_SET(vk::PhysicalDeviceDynamicRenderingFeatures, dynamicRendering, supportsDynamicRendering)
+        else
+            enabledFeatures2.unlink<vk::PhysicalDeviceDynamicRenderingFeatures>();
+
+        // VK_EXT_host_image_copy depends on VK_KHR_copy_commands2 and VK_KHR_format_feature_flags2 on Vulkan 1.1
+        if (hasHostImageCopyExt && hasCopyCommands2Ext && hasFormatFeatureFlags2Ext)
+            FEAT_SET(vk::PhysicalDeviceHostImageCopyFeaturesEXT, hostImageCopy, supportsHostImageCopy)
+        else
+            enabledFeatures2.unlink<vk::PhysicalDeviceHostImageCopyFeaturesEXT>();
+
         FEAT_SET(vk::PhysicalDeviceFeatures2, features.geometryShader, supportsGeometryShaders)
         FEAT_SET(vk::PhysicalDeviceFeatures2, features.vertexPipelineStoresAndAtomics, supportsVertexPipelineStoresAndAtomics)
         FEAT_SET(vk::PhysicalDeviceFeatures2, features.fragmentStoresAndAtomics, supportsFragmentStoresAndAtomics)
         FEAT_SET(vk::PhysicalDeviceFeatures2, features.shaderStorageImageWriteWithoutFormat, supportsShaderStorageImageWriteWithoutFormat)
         FEAT_SET(vk::PhysicalDeviceFeatures2, features.wideLines, supportsWideLines)
         FEAT_SET(vk::PhysicalDeviceFeatures2, features.depthClamp, supportsDepthClamp)
+        FEAT_SET(vk::PhysicalDeviceFeatures2, features.multiDrawIndirect, supportsMultiDrawIndirect)
+        FEAT_SET(vk::PhysicalDeviceFeatures2, features.occlusionQueryPrecise, supportsOcclusionQueryPrecise)
+
+        bool hasSparseBindingFeat{}, hasSparseResidencyBufferFeat{};
+        FEAT_SET(vk::PhysicalDeviceFeatures2, features.sparseBinding, hasSparseBindingFeat)
+        FEAT_SET(vk::PhysicalDeviceFeatures2, features.sparseResidencyBuffer, hasSparseResidencyBufferFeat)
+
+        // Reads from unbound regions of sparse buffers are only guaranteed to return zeroes with strict non-resident semantics
+        auto &sparseProperties{deviceProperties2.get<vk::PhysicalDeviceProperties2>().properties.sparseProperties};
+        supportsSparseResidencyBuffer = hasSparseBindingFeat && hasSparseResidencyBufferFeat && sparseProperties.residencyNonResidentStrict;
 
         #undef FEAT_SET
 
+        if (supportsExternalMemoryHost)
+            minImportedHostPointerAlignment = deviceProperties2.get<vk::PhysicalDeviceExternalMemoryHostPropertiesEXT>().minImportedHostPointerAlignment;
+
         if (supportsFloatControls)
             floatControls = deviceProperties2.get<vk::PhysicalDeviceFloatControlsProperties>();
 
@@ -172,6 +247,9 @@ namespace skyline::gpu {
         supportsSubgroupVote = static_cast<bool>(subgroupProperties.supportedOperations & vk::SubgroupFeatureFlagBits::eVote);
         subgroupSize = deviceProperties2.get<vk::PhysicalDeviceSubgroupProperties>().subgroupSize;
 
+        auto &limits{deviceProperties2.get<vk::PhysicalDeviceProperties2>().properties.limits};
+        timestampPeriod = limits.timestampComputeAndGraphics ? limits.timestampPeriod : 0.0f;
+
         auto isFormatSupported{[&physicalDevice](vk::Format format) {
             auto features{physicalDevice.getFormatProperties(format)};
             // We may get false positives here by not checking specifics but this is not seen in practice while the reverse often is of drivers (Such as Adreno 512.6xx drivers which don't report any support aside from buffer features but entirely support BC formats)
@@ -187,12 +265,31 @@ namespace skyline::gpu {
         bcnSupport[4] = isFormatSupported(vk::Format::eBc5UnormBlock) && isFormatSupported(vk::Format::eBc5SnormBlock);
         bcnSupport[5] = isFormatSupported(vk::Format::eBc6HSfloatBlock) && isFormatSupported(vk::Format::eBc6HUfloatBlock);
         bcnSupport[6] = isFormatSupported(vk::Format::eBc7UnormBlock) && isFormatSupported(vk::Format::eBc7SrgbBlock);
+
+        if (supportsImageCompressionControl) {
+            for (size_t i{}; i < FramebufferCompressionFormats.size(); i++) {
+                auto format{FramebufferCompressionFormats[i]};
+                bool isDepthStencil{format == vk::Format::eD24UnormS8Uint};
+                try {
+                    // The usage matches that of textures created by the texture manager, a lack of compression here means it's disabled by the usage itself
+                    auto properties{physicalDevice.getImageFormatProperties2<vk::ImageFormatProperties2, vk::ImageCompressionPropertiesEXT>(vk::PhysicalDeviceImageFormatInfo2{
+                        .format = format,
+                        .type = vk::ImageType::e2D,
+                        .tiling = vk::ImageTiling::eOptimal,
+                        .usage = vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled | (isDepthStencil ? vk::ImageUsageFlagBits::eDepthStencilAttachment : vk::ImageUsageFlagBits::eColorAttachment),
+                    })};
+                    framebufferCompression[i] = properties.get<vk::ImageCompressionPropertiesEXT>().imageCompressionFlags != vk::ImageCompressionFlagBitsEXT::eDisabled;
+                } catch (const vk::SystemError &) {
+                    // The format isn't supported with this usage, it's left as uncompressed
+                }
+            }
+        }
     }
 
     std::string TraitManager::Summary() {
         return fmt::format(
-            "\n* Supports U8 Indices: {}\n* Supports Sampler Mirror Clamp To Edge: {}\n* Supports Sampler Reduction Mode: {}\n* Supports Custom Border Color (Without Format): {}\n* Supports Anisotropic Filtering: {}\n* Supports Last Provoking Vertex: {}\n* Supports Logical Operations: {}\n* Supports Vertex Attribute Divisor: {}\n* Supports Vertex Attribute Zero Divisor: {}\n* Supports Push Descriptors: {}\n* Supports Imageless Framebuffers: {}\n* Supports Global Priority: {}\n* Supports Multiple Viewports: {}\n* Supports Shader Viewport Index: {}\n* Supports SPIR-V 1.4: {}\n* Supports Shader Invocation Demotion: {}\n* Supports 16-bit FP: {}\n* Supports 8-bit Integers: {}\n* Supports 16-bit Integers: {}\n* Supports 64-bit Integers: {}\n* Supports Atomic 64-bit Integers: {}\n* Supports Floating Point Behavior Control: {}\n* Supports Image Read Without Format: {}\n* Supports List Primitive Topology Restart: {}\n* Supports Patch List Primitive Topology Restart: {}\n* Supports Transform Feedback: {}\n* Supports Geometry Shaders: {}\n*  Supports Vertex Pipeline Stores and Atomics: {}\n* Supports Fragment Stores and Atomics: {}\n* Supports Shader Storage Image Write Without Format: {}\n*Supports Subgroup Vote: {}\n* Subgroup Size: {}\n* BCn Support: {}",
-            supportsUint8Indices, supportsSamplerMirrorClampToEdge, supportsSamplerReductionMode, supportsCustomBorderColor, supportsAnisotropicFiltering, supportsLastProvokingVertex, supportsLogicOp, supportsVertexAttributeDivisor, supportsVertexAttributeZeroDivisor, supportsPushDescriptors, supportsImagelessFramebuffers, supportsGlobalPriority, supportsMultipleViewports, supportsShaderViewportIndexLayer, supportsSpirv14, supportsShaderDemoteToHelper, supportsFloat16, supportsInt8, supportsInt16, supportsInt64, supportsAtomicInt64, supportsFloatControls, supportsImageReadWithoutFormat, supportsTopologyListRestart, supportsTopologyPatchListRestart, supportsTransformFeedback, supportsGeometryShaders, supportsVertexPipelineStoresAndAtomics, supportsFragmentStoresAndAtomics, supportsShaderStorageImageWriteWithoutFormat, supportsSubgroupVote, subgroupSize, bcnSupport.to_string()
+            "\n* Supports U8 Indices: {}\n* Supports Sampler Mirror Clamp To Edge: {}\n* Supports Sampler Reduction Mode: {}\n* Supports Custom Border Color (Without Format): {}\n* Supports Anisotropic Filtering: {}\n* Supports Last Provoking Vertex: {}\n* Supports Logical Operations: {}\n* Supports Vertex Attribute Divisor: {}\n* Supports Vertex Attribute Zero Divisor: {}\n* Supports Push Descriptors: {}\n* Supports Imageless Framebuffers: {}\n* Supports Timeline Semaphores: {}\n* Supports Global Priority: {}\n* Supports Multiple Viewports: {}\n* Supports Shader Viewport Index: {}\n* Supports SPIR-V 1.4: {}\n* Supports Shader Invocation Demotion: {}\n* Supports 16-bit FP: {}\n* Supports 8-bit Integers: {}\n* Supports 16-bit Integers: {}\n* Supports 64-bit Integers: {}\n* Supports Atomic 64-bit Integers: {}\n* Supports Floating Point Behavior Control: {}\n* Supports Image Read Without Format: {}\n* Supports List Primitive Topology Restart: {}\n* Supports Patch List Primitive Topology Restart: {}\n* Supports Transform Feedback: {}\n* Supports Geometry Shaders: {}\n*  Supports Vertex Pipeline Stores and Atomics: {}\n* Supports Fragment Stores and Atomics: {}\n* Supports Shader Storage Image Write Without Format: {}\n* Supports Extended Dynamic State: {}\n* Supports Extended Dynamic State 2: {}\n* Supports Graphics Pipeline Libraries: {}\n* Supports Dynamic Rendering: {}\n* Supports Precise Occlusion Queries: {}\n* Max Multi-Draw Count: {}\n* Supports Sparse Residency Buffers: {}\n* Supports External Host Memory: {} (Alignment: 0x{:X})\n* Supports Host Image Copy: {}\n*Supports Subgroup Vote: {}\n* Subgroup Size: {}\n* BCn Support: {}\n* Framebuffer Compression: {}",
+            supportsUint8Indices, supportsSamplerMirrorClampToEdge, supportsSamplerReductionMode, supportsCustomBorderColor, supportsAnisotropicFiltering, supportsLastProvokingVertex, supportsLogicOp, supportsVertexAttributeDivisor, supportsVertexAttributeZeroDivisor, supportsPushDescriptors, supportsImagelessFramebuffers, supportsTimelineSemaphores, supportsGlobalPriority, supportsMultipleViewports, supportsShaderViewportIndexLayer, supportsSpirv14, supportsShaderDemoteToHelper, supportsFloat16, supportsInt8, supportsInt16, supportsInt64, supportsAtomicInt64, supportsFloatControls, supportsImageReadWithoutFormat, supportsTopologyListRestart, supportsTopologyPatchListRestart, supportsTransformFeedback, supportsGeometryShaders, supportsVertexPipelineStoresAndAtomics, supportsFragmentStoresAndAtomics, supportsShaderStorageImageWriteWithoutFormat, supportsExtendedDynamicState, supportsExtendedDynamicState2, supportsGraphicsPipelineLibrary, supportsDynamicRendering, supportsOcclusionQueryPrecise, maxMultiDrawCount, supportsSparseResidencyBuffer, supportsExternalMemoryHost, minImportedHostPointerAlignment, supportsHostImageCopy, supportsSubgroupVote, subgroupSize, bcnSupport.to_string(), supportsImageCompressionControl ? framebufferCompression.to_string() : "Unknown"
         );
     }
 
@@ -207,6 +304,7 @@ namespace skyline::gpu {
                 relaxedRenderPassCompatibility = true; // Adreno drivers support relaxed render pass compatibility rules
                 brokenPushDescriptors = true;
                 brokenSpirvPositionInput = true;
+                brokenDynamicRendering = true;
 
                 if (deviceProperties.driverVersion < VK_MAKE_VERSION(512, 600, 0))
                     maxSubpassCount = 64; // Driver will segfault while destroying the renderpass and associated objects if this is exceeded on all 5xx and below drivers
@@ -242,8 +340,8 @@ namespace skyline::gpu {
 
     std::string TraitManager::QuirkManager::Summary() {
         return fmt::format(
-            "\n* Needs Individual Texture Binding Writes: {}\n* VkImage Mutable Format is costly: {}\n* Adreno Relaxed Format Aliasing: {}\n* Adreno Broken Format Reporting: {}\n* Broken Descriptor Aliasing: {}\n* Relaxed Render Pass Compatibility: {}\n* Max Subpass Count: {}\n* Max Global Queue Priority: {}",
-            needsIndividualTextureBindingWrites, vkImageMutableFormatCostly, adrenoRelaxedFormatAliasing, adrenoBrokenFormatReport, brokenDescriptorAliasing, relaxedRenderPassCompatibility, maxSubpassCount, vk::to_string(maxGlobalPriority)
+            "\n* Needs Individual Texture Binding Writes: {}\n* VkImage Mutable Format is costly: {}\n* Adreno Relaxed Format Aliasing: {}\n* Adreno Broken Format Reporting: {}\n* Broken Descriptor Aliasing: {}\n* Relaxed Render Pass Compatibility: {}\n* Broken Dynamic Rendering: {}\n* Max Subpass Count: {}\n* Max Global Queue Priority: {}",
+            needsIndividualTextureBindingWrites, vkImageMutableFormatCostly, adrenoRelaxedFormatAliasing, adrenoBrokenFormatReport, brokenDescriptorAliasing, relaxedRenderPassCompatibility, brokenDynamicRendering, maxSubpassCount, vk::to_string(maxGlobalPriority)
         );
     }
 
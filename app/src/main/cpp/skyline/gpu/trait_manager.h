@@ -23,6 +23,7 @@ namespace skyline::gpu {
         bool supportsVertexAttributeZeroDivisor{}; //!< If the device supports a zero divisor for instance-rate vertex attributes (with VK_EXT_vertex_attribute_divisor)
         bool supportsPushDescriptors{}; //!< If the device supports push descriptors (with VK_KHR_push_descriptor)
         bool supportsImagelessFramebuffers{}; //!< If the device supports imageless framebuffers (with VK_KHR_imageless_framebuffer)
+        bool supportsTimelineSemaphores{}; //!< If the device supports timeline semaphores (with VK_KHR_timeline_semaphore)
         bool supportsGlobalPriority{}; //!< If the device supports global priorities for queues (with VK_EXT_global_priority)
         bool supportsMultipleViewports{}; //!< If the device supports more than one viewport
         bool supportsShaderViewportIndexLayer{}; //!< If the device supports retrieving the viewport index in shaders (with VK_EXT_shader_viewport_index_layer)
@@ -46,10 +47,33 @@ namespace skyline::gpu {
         bool supportsSubgroupVote{}; //!< If subgroup votes are supported in shaders with SPV_KHR_subgroup_vote
         bool supportsWideLines{}; //!< If the device supports the 'wideLines' Vulkan feature
         bool supportsDepthClamp{}; //!< If the device supports the 'depthClamp' Vulkan feature
+        bool supportsMultiDrawIndirect{}; //!< If the device supports the 'multiDrawIndirect' Vulkan feature
+        bool supportsOcclusionQueryPrecise{}; //!< If the device supports the 'occlusionQueryPrecise' Vulkan feature, occlusion queries only report if any samples passed otherwise
+        bool supportsExtendedDynamicState{}; //!< If the device supports setting cull mode, front face, topology and depth/stencil state dynamically (with VK_EXT_extended_dynamic_state)
+        bool supportsExtendedDynamicState2{}; //!< If the device supports setting depth bias enable and rasterizer discard enable dynamically (with VK_EXT_extended_dynamic_state2)
+        bool supportsGraphicsPipelineLibrary{}; //!< If the device supports compiling parts of graphics pipelines as libraries which can be linked quickly (with VK_EXT_graphics_pipeline_library)
+        bool supportsDynamicRendering{}; //!< If the device supports rendering without render pass and framebuffer objects (with VK_KHR_dynamic_rendering)
+        u32 maxMultiDrawCount{}; //!< The maximum amount of draws that can be performed by a single multi-draw command (with VK_EXT_multi_draw), this is 0 if multi-draw isn't supported
+        bool supportsSparseResidencyBuffer{}; //!< If the device supports partially resident sparse buffers where unbound regions read as zero and discard writes
+        bool supportsExternalMemoryHost{}; //!< If the device supports importing host allocations as device memory (with VK_EXT_external_memory_host)
+        bool supportsHostImageCopy{}; //!< If the device supports copying memory into optimal images directly from the CPU (with VK_EXT_host_image_copy)
+        vk::DeviceSize minImportedHostPointerAlignment{}; //!< The alignment that the address and size of imported host allocations must have (with VK_EXT_external_memory_host)
         u32 subgroupSize{}; //!< Size of a subgroup on the host GPU
+        float timestampPeriod{}; //!< The amount of nanoseconds per GPU timestamp tick, this is 0 if timestamps aren't supported on graphics and compute queues
 
         std::bitset<7> bcnSupport{}; //!< Bitmask of BCn texture formats supported, it is ordered as BC1, BC2, BC3, BC4, BC5, BC6H and BC7
 
+        static constexpr std::array<vk::Format, 6> FramebufferCompressionFormats{
+            vk::Format::eR8G8B8A8Unorm,
+            vk::Format::eB8G8R8A8Unorm,
+            vk::Format::eA2B10G10R10UnormPack32,
+            vk::Format::eR16G16B16A16Sfloat,
+            vk::Format::eB10G11R11UfloatPack32,
+            vk::Format::eD24UnormS8Uint,
+        }; //!< Common render target formats that framebuffer compression is reported for
+        bool supportsImageCompressionControl{}; //!< If the device can report if images are compressed (with VK_EXT_image_compression_control)
+        std::bitset<FramebufferCompressionFormats.size()> framebufferCompression{}; //!< Bitmask of the formats in `FramebufferCompressionFormats` that are framebuffer compressed (UBWC/AFBC) when created without a mutable format, this is only populated with VK_EXT_image_compression_control
+
         /**
          * @brief Manages a list of any vendor/device-specific errata in the host GPU
          */
@@ -62,6 +86,7 @@ namespace skyline::gpu {
             bool relaxedRenderPassCompatibility{}; //!< [Adreno Proprietary/Freedreno] A relaxed version of Vulkan specification's render pass compatibility clause which allows for caching pipeline objects for multi-subpass renderpasses, this is intentionally disabled by default as it requires testing prior to enabling
             bool brokenPushDescriptors{}; //!< [Adreno Proprietary] A bug that causes push descriptor updates to ignored by the driver in certain situations
             bool brokenSpirvPositionInput{}; //!< [Adreno Proprietary] A bug that causes the shader compiler to fail on shaders with vertex position inputs not contained within a struct
+            bool brokenDynamicRendering{}; //!< [Adreno Proprietary] VK_KHR_dynamic_rendering is exposed but has a history of driver bugs, this is intentionally disabled until it has been tested
 
             u32 maxSubpassCount{std::numeric_limits<u32>::max()}; //!< The maximum amount of subpasses within a renderpass, this is limited to 64 on older Adreno proprietary drivers
             vk::QueueGlobalPriorityEXT maxGlobalPriority{vk::QueueGlobalPriorityEXT::eMedium}; //!< The highest allowed global priority of the queue, drivers will not allow higher priorities to be set on queues
@@ -83,7 +108,10 @@ namespace skyline::gpu {
             vk::PhysicalDeviceDriverProperties,
             vk::PhysicalDeviceFloatControlsProperties,
             vk::PhysicalDeviceTransformFeedbackPropertiesEXT,
-            vk::PhysicalDeviceSubgroupProperties>;
+            vk::PhysicalDeviceGraphicsPipelineLibraryPropertiesEXT,
+            vk::PhysicalDeviceMultiDrawPropertiesEXT,
+            vk::PhysicalDeviceSubgroupProperties,
+            vk::PhysicalDeviceExternalMemoryHostPropertiesEXT>;
 
         using DeviceFeatures2 = vk::StructureChain<
             vk::PhysicalDeviceFeatures2,
@@ -97,8 +125,15 @@ namespace skyline::gpu {
             vk::PhysicalDeviceProvokingVertexFeaturesEXT,
             vk::PhysicalDevicePrimitiveTopologyListRestartFeaturesEXT,
             vk::PhysicalDeviceImagelessFramebufferFeatures,
+            vk::PhysicalDeviceTimelineSemaphoreFeatures,
             vk::PhysicalDeviceTransformFeedbackFeaturesEXT,
-            vk::PhysicalDeviceIndexTypeUint8FeaturesEXT>;
+            vk::PhysicalDeviceIndexTypeUint8FeaturesEXT,
+            vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT,
+            vk::PhysicalDeviceExtendedDynamicState2FeaturesEXT,
+            vk::PhysicalDeviceGraphicsPipelineLibraryFeaturesEXT,
+            vk::PhysicalDeviceMultiDrawFeaturesEXT,
+            vk::PhysicalDeviceDynamicRenderingFeatures,
+            vk::PhysicalDeviceHostImageCopyFeaturesEXT>;
 
         TraitManager(const DeviceFeatures2 &deviceFeatures2, DeviceFeatures2 &enabledFeatures2, const std::vector<vk::ExtensionProperties> &deviceExtensions, std::vector<std::array<char, VK_MAX_EXTENSION_NAME_SIZE>> &enabledExtensions, const DeviceProperties2 &deviceProperties2, const vk::raii::PhysicalDevice& physicalDevice);
 
@@ -2,6 +2,8 @@
 // Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
 #include <common/signal.h>
+#include <common/settings.h>
+#include <gpu.h>
 #include <loader/loader.h>
 #include <kernel/types/KProcess.h>
 #include "input.h"
@@ -15,6 +17,17 @@ namespace skyline::input {
           touch{state, hid},
           updateThread{&Input::UpdateThread, this} {}
 
+    void Input::OnGuestPresent() {
+        if (*state.settings->lowLatencyInput) {
+            // The periodic samples can be up to a full period stale when the guest reads them, an additional sample right before the read avoids that
+            RecordAppliedInput(npad.UpdateSharedMemory());
+            RecordAppliedInput(touch.UpdateSharedMemory());
+        }
+
+        if (auto timestamp{pendingInputTimestamp.exchange(0, std::memory_order_relaxed)})
+            state.gpu->presentation.SetNextFrameInputTimestamp(timestamp);
+    }
+
     void Input::UpdateThread() {
         if (int result{pthread_setname_np(pthread_self(), "Sky-Input")})
             Logger::Warn("Failed to set the thread name: {}", strerror(result));
@@ -36,16 +49,16 @@ namespace skyline::input {
                 }
             };
 
-            constexpr std::chrono::milliseconds NPadUpdatePeriod{4}; //!< The period at which a Joy-Con is updated (250Hz)
-            constexpr std::chrono::milliseconds TouchUpdatePeriod{4}; //!< The period at which the touch screen is updated (250Hz)
+            constexpr std::chrono::milliseconds NPadUpdatePeriod{5}; //!< The period at which a Joy-Con is sampled by HID on the console (200Hz)
+            constexpr std::chrono::milliseconds TouchUpdatePeriod{5}; //!< The period at which the touch screen is sampled by HID on the console (200Hz)
 
+            // Host input events are queued as they arrive and applied in a batch on every sampling tick
             std::array<UpdateCallback, 2> updateCallbacks{
                 UpdateCallback{NPadUpdatePeriod, [&](UpdateCallback &callback) {
-                    for (auto &pad : npad.npads)
-                        pad.UpdateSharedMemory();
+                    RecordAppliedInput(npad.UpdateSharedMemory());
                 }},
                 UpdateCallback{TouchUpdatePeriod, [&](UpdateCallback &callback) {
-                    touch.UpdateSharedMemory();
+                    RecordAppliedInput(touch.UpdateSharedMemory());
                 }},
             };
 
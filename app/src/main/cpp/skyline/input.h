@@ -26,7 +26,24 @@ namespace skyline::input {
 
         Input(const DeviceState &state);
 
+        /**
+         * @brief Attributes all input applied since the last frame to the next frame for measuring input-to-present latency, this must be called from the guest thread after it queues a frame for presentation
+         * @note With the low-latency input mode, input is also sampled synchronously here as guests typically read HID shared memory at the start of a frame which is right after the prior one was presented
+         */
+        void OnGuestPresent();
+
       private:
+        std::atomic<i64> pendingInputTimestamp{}; //!< The timestamp of the oldest input event that was applied to shared memory but hasn't been attributed to a frame yet, 0 if there's none
+
+        /**
+         * @brief Records the timestamp of the oldest applied input event returned by a shared memory manager
+         */
+        void RecordAppliedInput(i64 timestamp) {
+            i64 expected{};
+            if (timestamp)
+                pendingInputTimestamp.compare_exchange_strong(expected, timestamp, std::memory_order_relaxed); // Only the oldest pending event is of interest, newer events are ignored till it's attributed
+        }
+
         std::thread updateThread; //!< A thread that handles delivering HID shared memory updates at a fixed rate
 
         /**
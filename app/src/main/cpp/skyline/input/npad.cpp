@@ -74,6 +74,53 @@ namespace skyline::input {
         }
     }
 
+    void NpadManager::QueueButtonState(size_t controllerIndex, NpadButton mask, bool pressed) {
+        InputEvent event{.type = InputEvent::Type::Button, .controllerIndex = static_cast<u8>(controllerIndex), .timestamp = util::GetTimeNs()};
+        event.button = {mask, pressed};
+        if (!events.TryPush(event))
+            Logger::Warn("Dropped button event for controller {} as the input queue is full", controllerIndex);
+    }
+
+    void NpadManager::QueueAxisValue(size_t controllerIndex, NpadAxisId axis, i32 value) {
+        InputEvent event{.type = InputEvent::Type::Axis, .controllerIndex = static_cast<u8>(controllerIndex), .timestamp = util::GetTimeNs()};
+        event.axis = {axis, value};
+        if (!events.TryPush(event))
+            Logger::Warn("Dropped axis event for controller {} as the input queue is full", controllerIndex);
+    }
+
+    i64 NpadManager::UpdateSharedMemory() {
+        std::scoped_lock guard{mutex};
+
+        // All events since the last tick are applied at once, the guest only observes the state at sampling ticks so this is equivalent to applying them as they arrive
+        i64 oldestTimestamp{};
+        InputEvent event;
+        while (events.TryPop(event)) {
+            if (!oldestTimestamp)
+                oldestTimestamp = event.timestamp;
+
+            if (event.controllerIndex >= controllers.size())
+                continue;
+
+            auto device{controllers[event.controllerIndex].device};
+            if (!device)
+                continue; // Events for controllers that aren't mapped to a player are dropped, this matches events arriving prior to the mapping
+
+            switch (event.type) {
+                case InputEvent::Type::Button:
+                    device->SetButtonState(event.button.mask, event.button.pressed);
+                    break;
+                case InputEvent::Type::Axis:
+                    device->SetAxisValue(event.axis.axis, event.axis.value);
+                    break;
+            }
+        }
+
+        for (auto &npad : npads)
+            npad.UpdateSharedMemory();
+
+        return oldestTimestamp;
+    }
+
     void NpadManager::Activate() {
         std::scoped_lock guard{mutex};
         if (!activated) {
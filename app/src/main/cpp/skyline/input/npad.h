@@ -4,6 +4,7 @@
 #pragma once
 
 #include <range/v3/algorithm.hpp>
+#include <common/spsc_queue.h>
 #include "npad_device.h"
 
 namespace skyline::input {
@@ -24,6 +25,30 @@ namespace skyline::input {
         const DeviceState &state;
         bool activated{};
 
+        /**
+         * @brief An input event from the host which is queued till the next HID sampling tick
+         */
+        struct InputEvent {
+            enum class Type : u8 {
+                Button,
+                Axis,
+            } type;
+            u8 controllerIndex;
+            i64 timestamp; //!< The time at which the event was queued in nanoseconds, this is used to measure input latency
+            union {
+                struct {
+                    NpadButton mask;
+                    bool pressed;
+                } button;
+                struct {
+                    NpadAxisId axis;
+                    i32 value;
+                } axis;
+            };
+        };
+
+        SpscQueue<InputEvent> events{1024}; //!< Host input events pending application, these are pushed from the Android main thread which delivers all input callbacks
+
         friend NpadDevice;
 
         /**
@@ -56,6 +81,24 @@ namespace skyline::input {
          */
         NpadManager(const DeviceState &state, input::HidSharedMemory *hid);
 
+        /**
+         * @brief Queues a change in the state of buttons on a controller, this is applied on the next HID sampling tick
+         * @note This is lock-free and must only be called from a single thread
+         */
+        void QueueButtonState(size_t controllerIndex, NpadButton mask, bool pressed);
+
+        /**
+         * @brief Queues a change in the value of an axis on a controller, this is applied on the next HID sampling tick
+         * @note This is lock-free and must only be called from a single thread
+         */
+        void QueueAxisValue(size_t controllerIndex, NpadAxisId axis, i32 value);
+
+        /**
+         * @brief Applies all queued input events and writes the state of all NPads to HID shared memory, this is called on every HID sampling tick
+         * @return The timestamp of the oldest event that was applied or 0 if there were no events
+         */
+        i64 UpdateSharedMemory();
+
         /**
          * @return A reference to the NPad with the specified ID
          */
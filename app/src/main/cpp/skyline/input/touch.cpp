@@ -45,9 +45,26 @@ namespace skyline::input {
             screenState.data[i] = {};
     }
 
-    void TouchManager::UpdateSharedMemory() {
+    void TouchManager::QueueState(span<TouchScreenPoint> touchPoints) {
+        TouchEvent event;
+        event.pointCount = static_cast<u8>(std::min(touchPoints.size(), event.points.size()));
+        event.timestamp = util::GetTimeNs();
+        std::copy_n(touchPoints.begin(), event.pointCount, event.points.begin());
+        if (!events.TryPush(event))
+            Logger::Warn("Dropped touch event as the input queue is full");
+    }
+
+    i64 TouchManager::UpdateSharedMemory() {
         std::scoped_lock lock{mutex};
 
+        i64 oldestTimestamp{};
+        TouchEvent event;
+        while (events.TryPop(event)) {
+            if (!oldestTimestamp)
+                oldestTimestamp = event.timestamp;
+            SetState(span(event.points).first(event.pointCount));
+        }
+
         for (size_t i{}; i < screenState.data.size(); i++) {
             // Remove any touch points which have ended after they are timed out
             if (screenState.data[i].attribute.end) {
@@ -71,7 +88,7 @@ namespace skyline::input {
         }
 
         if (!activated)
-            return;
+            return oldestTimestamp;
 
         const auto &lastEntry{section.entries[section.header.currentEntry]};
         auto entryIndex{(section.header.currentEntry != constant::HidEntryCount - 1) ? section.header.currentEntry + 1 : 0};
@@ -84,5 +101,7 @@ namespace skyline::input {
         section.header.entryCount = std::min(static_cast<u8>(section.header.entryCount + 1), constant::HidEntryCount);
         section.header.maxEntry = section.header.entryCount;
         section.header.currentEntry = entryIndex;
+
+        return oldestTimestamp;
     }
 }
@@ -4,6 +4,7 @@
 #pragma once
 
 #include <jni.h>
+#include <common/spsc_queue.h>
 #include "shared_mem.h"
 
 namespace skyline::input {
@@ -35,6 +36,17 @@ namespace skyline::input {
         TouchScreenState screenState{}; //!< The current state of the touch screen
         std::array<uint8_t, 16> pointTimeout; //!< A frame timeout counter for each point which has ended (according to it's attribute), when it reaches 0 the point is removed from the screen
 
+        /**
+         * @brief A snapshot of all points on the touch screen from the host which is queued till the next HID sampling tick
+         */
+        struct TouchEvent {
+            std::array<TouchScreenPoint, 16> points;
+            u8 pointCount;
+            i64 timestamp; //!< The time at which the event was queued in nanoseconds, this is used to measure input latency
+        };
+
+        SpscQueue<TouchEvent> events{64}; //!< Touch events pending application, these are pushed from the Android main thread which delivers all input callbacks
+
       public:
         /**
          * @param hid A pointer to HID Shared Memory on the host
@@ -46,8 +58,15 @@ namespace skyline::input {
         void SetState(span<TouchScreenPoint> touchPoints);
 
         /**
-         * @brief Writes the current state of the touch screen to HID shared memory
+         * @brief Queues a new state of the touch screen, this is applied on the next HID sampling tick
+         * @note This is lock-free and must only be called from a single thread
+         */
+        void QueueState(span<TouchScreenPoint> touchPoints);
+
+        /**
+         * @brief Applies all queued touch events and writes the current state of the touch screen to HID shared memory
+         * @return The timestamp of the oldest event that was applied or 0 if there were no events
          */
-        void UpdateSharedMemory();
+        i64 UpdateSharedMemory();
     };
 }
@@ -64,6 +64,7 @@ namespace skyline {
           closeKeyboardId{environ->GetMethodID(instanceClass, "closeKeyboard", "(Lemu/skyline/applet/swkbd/SoftwareKeyboardDialog;)V")},
           showValidationResultId{environ->GetMethodID(instanceClass, "showValidationResult", "(Lemu/skyline/applet/swkbd/SoftwareKeyboardDialog;ILjava/lang/String;)I")},
           getVersionCodeId{environ->GetMethodID(instanceClass, "getVersionCode", "()I")},
+          reportPipelineReplayProgressId{environ->GetMethodID(instanceClass, "reportPipelineReplayProgress", "(II)V")},
           getIntegerValueId{environ->GetMethodID(environ->FindClass("java/lang/Integer"), "intValue", "()I")} {
         env.Initialize(environ);
     }
@@ -141,6 +142,10 @@ namespace skyline {
         return env->CallIntMethod(instance, getVersionCodeId);
     }
 
+    void JvmManager::ReportPipelineReplayProgress(jint replayed, jint total) {
+        env->CallVoidMethod(instance, reportPipelineReplayProgressId, replayed, total);
+    }
+
     JvmManager::KeyboardCloseResult JvmManager::ShowValidationResult(jobject dialog, KeyboardTextCheckResult checkResult, std::u16string message) {
         auto str{env->NewString(reinterpret_cast<const jchar *>(message.data()), static_cast<int>(message.length()))};
         auto result{static_cast<KeyboardCloseResult>(env->CallIntMethod(instance, showValidationResultId, dialog, checkResult, str))};
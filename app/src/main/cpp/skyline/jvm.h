@@ -182,6 +182,13 @@ namespace skyline {
          */
         i32 GetVersionCode();
 
+        /**
+         * @brief A call to EmulationActivity.reportPipelineReplayProgress in Kotlin
+         * @param replayed The amount of recorded pipelines that have been compiled so far
+         * @param total The total amount of recorded pipelines being compiled
+         */
+        void ReportPipelineReplayProgress(jint replayed, jint total);
+
       private:
         jmethodID initializeControllersId;
         jmethodID vibrateDeviceId;
@@ -191,6 +198,7 @@ namespace skyline {
         jmethodID closeKeyboardId;
         jmethodID showValidationResultId;
         jmethodID getVersionCodeId;
+        jmethodID reportPipelineReplayProgressId;
 
         jmethodID getIntegerValueId;
     };
@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <cxxabi.h>
+#include <fstream>
+#include <sys/stat.h>
+#include <loader/loader.h>
+#include <os.h>
+#include "types/KProcess.h"
+#include "guest_profiler.h"
+
+namespace skyline::kernel {
+    GuestProfiler::GuestProfiler(const DeviceState &state, type::KProcess &process) : state{state}, process{process}, startTime{util::GetTimeNs()}, thread{&GuestProfiler::SamplerThread, this} {}
+
+    GuestProfiler::~GuestProfiler() {
+        {
+            std::scoped_lock lock{mutex};
+            exit = true;
+        }
+        condition.notify_all();
+        if (thread.joinable())
+            thread.join();
+    }
+
+    void GuestProfiler::SignalHandler(int, siginfo *, ucontext *ctx, void **tls) {
+        if (*tls) // The TLS is only restored when the signal interrupted guest code
+            DeviceState::thread->sampledPc.store(ctx->uc_mcontext.pc, std::memory_order_relaxed);
+    }
+
+    void GuestProfiler::SamplerThread() {
+        if (int result{pthread_setname_np(pthread_self(), "Sky-Profiler")})
+            Logger::Warn("Failed to set the thread name: {}", strerror(result));
+
+        std::unique_lock lock{mutex};
+        while (!condition.wait_for(lock, SampleInterval, [this]() { return exit; })) {
+            lock.unlock();
+            auto threads{process.GetThreads()};
+            lock.lock();
+
+            for (const auto &guestThread : threads) {
+                if (u64 pc{guestThread->sampledPc.exchange(0, std::memory_order_relaxed)}) {
+                    samples[util::AlignDown(pc, SampleGranularity)]++;
+                    sampleCount++;
+                }
+            }
+
+            lock.unlock();
+            for (const auto &guestThread : threads)
+                guestThread->TrySendSignal(SampleSignal);
+            lock.lock();
+        }
+    }
+
+    std::string GuestProfiler::GetReport() {
+        std::vector<std::pair<u64, u64>> blocks;
+        u64 totalSamples;
+        {
+            std::scoped_lock lock{mutex};
+            blocks.assign(samples.begin(), samples.end());
+            totalSamples = sampleCount;
+        }
+
+        // Only the most sampled blocks are resolved as symbol resolution is a linear search over the symbols of an executable
+        auto resolvedEnd{blocks.begin() + static_cast<ssize_t>(std::min(blocks.size(), ResolvedBlockCount))};
+        std::partial_sort(blocks.begin(), resolvedEnd, blocks.end(), [](const auto &a, const auto &b) { return a.second > b.second; });
+
+        struct FunctionSamples {
+            std::string name;
+            std::string_view executable;
+            u64 samples;
+        };
+        std::unordered_map<std::string, FunctionSamples> functions;
+        u64 unresolvedSamples{};
+        for (auto it{blocks.begin()}; it != blocks.end(); it++) {
+            auto symbol{it < resolvedEnd ? state.loader->ResolveSymbol(reinterpret_cast<void *>(it->first)) : loader::Loader::SymbolInfo{}};
+            if (!symbol.name && symbol.executableName.empty()) {
+                unresolvedSamples += it->second;
+                continue;
+            }
+
+            std::string name;
+            if (symbol.name) {
+                int status{};
+                std::unique_ptr<char, decltype(&std::free)> demangled{abi::__cxa_demangle(symbol.name, nullptr, nullptr, &status), std::free};
+                name = status == 0 ? demangled.get() : symbol.name;
+            } else {
+                name = fmt::format("0x{:X}", symbol.offset);
+            }
+
+            auto key{fmt::format("{}!{}", symbol.executableName, name)};
+            auto function{functions.find(key)};
+            if (function == functions.end())
+                functions.emplace(std::move(key), FunctionSamples{std::move(name), symbol.executableName, it->second});
+            else
+                function->second.samples += it->second;
+        }
+
+        std::vector<FunctionSamples *> sortedFunctions;
+        sortedFunctions.reserve(functions.size());
+        for (auto &function : functions)
+            sortedFunctions.push_back(&function.second);
+        std::sort(sortedFunctions.begin(), sortedFunctions.end(), [](auto a, auto b) { return a->samples > b->samples; });
+
+        std::string title;
+        if (auto &nacp{state.loader->nacp})
+            title = nacp->GetApplicationName(language::ApplicationLanguage::AmericanEnglish);
+        std::string report{fmt::format("Guest profile of \"{}\" ({:016X}): {} samples over {}s at {}ms intervals\nSamples | % | Function | Executable\n",
+                                       title, process.npdm.aci0.programId, totalSamples, (util::GetTimeNs() - startTime) / constant::NsInSecond, SampleInterval.count())};
+        auto percentage{[&](u64 value) { return totalSamples ? static_cast<double>(value) * 100.0 / static_cast<double>(totalSamples) : 0.0; }};
+        for (size_t i{}; i < std::min(sortedFunctions.size(), ReportFunctionCount); i++) {
+            const auto &function{*sortedFunctions[i]};
+            report += fmt::format("{} | {:.2f} | {} | {}\n", function.samples, percentage(function.samples), function.name, function.executable);
+        }
+        if (unresolvedSamples)
+            report += fmt::format("{} | {:.2f} | <unresolved or outside the {} most sampled blocks> | -\n", unresolvedSamples, percentage(unresolvedSamples), ResolvedBlockCount);
+        return report;
+    }
+
+    void GuestProfiler::WriteReport() {
+        auto report{GetReport()};
+        Logger::InfoNoPrefix("{}", report);
+
+        std::string directory{state.os->publicAppFilesPath + "guest_profiles/"};
+        mkdir(directory.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+        auto path{fmt::format("{}{:016X}.txt", directory, process.npdm.aci0.programId)};
+        std::ofstream file{path, std::ios::trunc};
+        if (!file)
+            Logger::Warn("Failed to write the guest profile to {}", path);
+        else
+            file << report;
+    }
+}
@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <condition_variable>
+#include <csignal>
+#include <thread>
+#include <unordered_map>
+#include <common.h>
+
+namespace skyline::kernel {
+    /**
+     * @brief A sampling profiler for guest code, all guest threads are periodically signalled and the PC they were interrupted at is recorded if they were running guest code
+     * @details Samples are aggregated by guest function using the symbols of the loaded executables, this shows where HLE or patches would be most effective
+     * @note Samples of threads that were in host code (SVCs or waits) are discarded as they can't be attributed to a guest function
+     */
+    class GuestProfiler {
+      private:
+        static constexpr std::chrono::milliseconds SampleInterval{2}; //!< The interval at which all guest threads are sampled
+        static constexpr size_t SampleGranularity{0x40}; //!< The granularity that samples are aggregated at, executables without symbols are reported at this granularity
+        static constexpr size_t ResolvedBlockCount{1024}; //!< The amount of the most sampled blocks which are resolved to symbols for a report, the rest are reported in aggregate
+        static constexpr size_t ReportFunctionCount{50}; //!< The amount of functions in a report
+
+        const DeviceState &state;
+        type::KProcess &process;
+        std::mutex mutex; //!< Synchronizes all members below
+        std::condition_variable condition; //!< Signalled when the sampler thread should exit
+        bool exit{};
+        std::unordered_map<u64, u64> samples; //!< The amount of samples in every block of guest code, keyed by the address of the block
+        u64 sampleCount{}; //!< The total amount of guest samples
+        i64 startTime{}; //!< The time at which sampling started in nanoseconds
+        std::thread thread;
+
+        /**
+         * @brief Collects the samples of all guest threads from the last interval and signals them to record new samples
+         */
+        void SamplerThread();
+
+      public:
+        inline static int SampleSignal{SIGRTMIN + 2}; //!< The signal used to sample the PC of guest threads
+
+        GuestProfiler(const DeviceState &state, type::KProcess &process);
+
+        ~GuestProfiler();
+
+        /**
+         * @brief Records the PC of the interrupted guest code into the current thread's sample slot
+         */
+        static void SignalHandler(int signal, siginfo *info, ucontext *ctx, void **tls);
+
+        /**
+         * @return A table of the most sampled guest functions of the title
+         */
+        std::string GetReport();
+
+        /**
+         * @brief Writes the report to the guest_profiles directory with the title ID as the filename, this replaces any prior report of the title
+         */
+        void WriteReport();
+    };
+}
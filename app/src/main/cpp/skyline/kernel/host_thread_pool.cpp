@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <common/signal.h>
+#include <common/perf_stats.h>
+#include <common/logger.h>
+#include <nce.h>
+#include "guest_profiler.h"
+#include "host_thread_pool.h"
+#include "scheduler.h"
+
+namespace skyline::kernel {
+    HostThreadPool::~HostThreadPool() {
+        {
+            std::scoped_lock lock{mutex};
+            exit = true;
+        }
+        condition.notify_all();
+        for (auto &thread : threads)
+            if (thread.joinable())
+                thread.join();
+    }
+
+    void HostThreadPool::HostThread() {
+        if (int result{pthread_setname_np(pthread_self(), "Sky-HostThread")})
+            Logger::Warn("Failed to set the thread name: {}", strerror(result));
+
+        // The signal handlers are thread-local, they're installed ahead of time so they don't need to be on the critical path of starting a guest thread
+        signal::SetSignalHandler({SIGINT, SIGILL, SIGTRAP, SIGBUS, SIGFPE, SIGSEGV}, nce::NCE::SignalHandler);
+        signal::SetSignalHandler({Scheduler::YieldSignal, Scheduler::PreemptionSignal}, Scheduler::SignalHandler, false); // We want futexes to fail and their predicates rechecked
+        signal::SetSignalHandler({GuestProfiler::SampleSignal}, GuestProfiler::SignalHandler);
+
+        std::unique_lock lock{mutex};
+        while (true) {
+            condition.wait(lock, [this]() { return !pendingJobs.empty() || exit; });
+            if (pendingJobs.empty())
+                return;
+
+            auto job{std::move(pendingJobs.front())};
+            pendingJobs.pop_front();
+            lock.unlock();
+
+            job();
+            job = nullptr;
+
+            // A guest thread which took down the process blocks SIGINT on its host thread, it might have a pending SIGINT so it can't be reused safely
+            sigset_t mask{};
+            signal::Sigprocmask(SIG_BLOCK, {}, &mask);
+            if (sigismember(&mask, SIGINT))
+                return;
+
+            lock.lock();
+            idleThreads++;
+        }
+    }
+
+    void HostThreadPool::Run(Job job) {
+        std::scoped_lock lock{mutex};
+        pendingJobs.emplace_back(std::move(job));
+        if (idleThreads) {
+            idleThreads--;
+            PerfStats::Increment(PerfStats::Counter::HostThreadReuses);
+            condition.notify_one();
+        } else {
+            PerfStats::Increment(PerfStats::Counter::HostThreadCreations);
+            threads.emplace_back(&HostThreadPool::HostThread, this);
+        }
+    }
+}
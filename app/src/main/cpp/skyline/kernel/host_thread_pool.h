@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <thread>
+#include <common/base.h>
+
+namespace skyline::kernel {
+    /**
+     * @brief A pool of host threads which guest threads are run on, host threads are returned to it after a guest thread exits rather than being destroyed
+     * @details Guest threads are frequently created and destroyed by some titles, reusing host threads turns starting a guest thread into a wakeup of an idle host thread rather than a clone and the setup of its signal handlers
+     * @note The pool grows to the peak amount of concurrently running guest threads which is bounded by the thread resource limit of the process
+     */
+    class HostThreadPool {
+      public:
+        using Job = std::function<void()>;
+
+      private:
+        std::mutex mutex; //!< Synchronizes all members below
+        std::condition_variable condition; //!< Signalled when a job is queued or the pool is being destroyed
+        std::list<Job> pendingJobs; //!< The jobs which haven't been picked up by a host thread yet
+        size_t idleThreads{}; //!< The amount of host threads waiting on a job
+        bool exit{}; //!< If all host threads should exit
+        std::vector<std::thread> threads;
+
+        /**
+         * @brief The entry point of every host thread in the pool, it runs jobs until the pool is destroyed or the thread can't be reused
+         */
+        void HostThread();
+
+      public:
+        ~HostThreadPool();
+
+        /**
+         * @brief Runs the supplied job on an idle host thread, a new host thread is created if there are none
+         * @note The job must restore any thread-local state it changes as the host thread will be reused afterwards
+         */
+        void Run(Job job);
+    };
+}
@@ -265,7 +265,7 @@ namespace skyline {
         class IpcResponse {
           private:
             const DeviceState &state;
-            std::vector<u8> payload; //!< The contents to be pushed to the data payload
+            boost::container::small_vector<u8, constant::TlsIpcSize> payload; //!< The contents to be pushed to the data payload, this is stored inline as it can never exceed the size of the IPC command buffer
 
           public:
             Result errorCode{}; //!< The error code to respond with, it's 0 (Success) by default
@@ -3,6 +3,7 @@
 
 #include <asm-generic/unistd.h>
 #include <fcntl.h>
+#include <common/settings.h>
 #include "memory.h"
 #include "types/KProcess.h"
 
@@ -73,22 +74,25 @@ namespace skyline::kernel {
         if (result == MAP_FAILED)
             throw exception("Failed to mmap guest address space: {}", strerror(errno));
 
-        chunks = {
-            ChunkDescriptor{
-                .ptr = addressSpace.data(),
-                .size = static_cast<size_t>(base.data() - addressSpace.data()),
-                .state = memory::states::Reserved,
-            },
-            ChunkDescriptor{
-                .ptr = base.data(),
-                .size = base.size(),
-                .state = memory::states::Unmapped,
-            },
-            ChunkDescriptor{
-                .ptr = base.end().base(),
-                .size = addressSpace.size() - reinterpret_cast<u64>(base.end().base()),
-                .state = memory::states::Reserved,
-            }};
+        chunks.clear();
+        auto insertChunk{[&](const ChunkDescriptor &chunk) {
+            chunks.emplace_hint(chunks.end(), chunk.ptr, chunk);
+        }};
+        insertChunk(ChunkDescriptor{
+            .ptr = addressSpace.data(),
+            .size = static_cast<size_t>(base.data() - addressSpace.data()),
+            .state = memory::states::Reserved,
+        });
+        insertChunk(ChunkDescriptor{
+            .ptr = base.data(),
+            .size = base.size(),
+            .state = memory::states::Unmapped,
+        });
+        insertChunk(ChunkDescriptor{
+            .ptr = base.end().base(),
+            .size = addressSpace.size() - reinterpret_cast<u64>(base.end().base()),
+            .state = memory::states::Reserved,
+        });
     }
 
     void MemoryManager::InitializeRegions(span<u8> codeRegion) {
@@ -129,9 +133,28 @@ namespace skyline::kernel {
         if (codeRegion.size() > code.size())
             throw exception("Code region ({}) is smaller than mapped code size ({})", code.size(), codeRegion.size());
 
+        if (*state.settings->hugePageGuestMemory)
+            AdviseHugePages();
+
         Logger::Debug("Region Map:\nVMM Base: 0x{:X}\nCode Region: 0x{:X} - 0x{:X} (Size: 0x{:X})\nAlias Region: 0x{:X} - 0x{:X} (Size: 0x{:X})\nHeap Region: 0x{:X} - 0x{:X} (Size: 0x{:X})\nStack Region: 0x{:X} - 0x{:X} (Size: 0x{:X})\nTLS/IO Region: 0x{:X} - 0x{:X} (Size: 0x{:X})", base.data(), code.data(), code.end().base(), code.size(), alias.data(), alias.end().base(), alias.size(), heap.data(), heap.end().base(), heap.size(), stack.data(), stack.end().base(), stack.size(), tlsIo.data(), tlsIo.end().base(), tlsIo.size());
     }
 
+    void MemoryManager::AdviseHugePages() {
+        // Transparent huge pages are only used for shared memory (which includes memfds) if the shmem_enabled policy is 'advise' or above, we still advise the regions regardless as the policy can be changed at runtime
+        std::ifstream policyFile("/sys/kernel/mm/transparent_hugepage/shmem_enabled");
+        std::string policy((std::istreambuf_iterator<char>(policyFile)), std::istreambuf_iterator<char>());
+        if (policy.empty() || policy.find("[never]") != std::string::npos || policy.find("[deny]") != std::string::npos)
+            Logger::Warn("Huge pages were requested for guest memory but the host kernel doesn't allow them for shared memory: '{}'", policy.empty() ? "unsupported" : policy.substr(0, policy.find_first_of('\n')));
+
+        // Any regions which get more restrictive protections for NCE traps or are unmapped will have their huge pages split by the kernel, so the advice doesn't need to be reverted for those
+        for (auto region : {heap, alias}) {
+            if (madvise(region.data(), region.size(), MADV_HUGEPAGE) == -1)
+                Logger::Warn("Failed to advise huge pages for 0x{:X} - 0x{:X}: {}", region.data(), region.end().base(), strerror(errno));
+            else
+                Logger::Info("Advised huge pages for 0x{:X} - 0x{:X}", region.data(), region.end().base());
+        }
+    }
+
     span<u8> MemoryManager::CreateMirror(span<u8> mapping) {
         if (mapping.data() < base.data() || mapping.end().base() > base.end().base())
             throw exception("Mapping is outside of VMM base: 0x{:X} - 0x{:X}", mapping.data(), mapping.end().base());
@@ -191,54 +214,46 @@ namespace skyline::kernel {
             throw exception("Failed to free memory at 0x{:X}-0x{:X} (0x{:X}): {}", memory.data(), memory.end().base(), offset, strerror(errno));
     }
 
+    std::map<u8 *, ChunkDescriptor>::iterator MemoryManager::SplitChunk(u8 *ptr) {
+        auto chunk{chunks.upper_bound(ptr)};
+        if (chunk == chunks.begin())
+            throw exception("SplitChunk: Address is outside address space: 0x{:X}", ptr);
+
+        auto &lower{std::prev(chunk)->second};
+        if (lower.ptr == ptr)
+            return std::prev(chunk);
+        else if (lower.ptr + lower.size <= ptr)
+            return chunk; // The address is past the end of the address space, there's nothing to split
+
+        auto upper{lower};
+        upper.ptr = ptr;
+        upper.size = static_cast<size_t>((lower.ptr + lower.size) - ptr);
+        lower.size = static_cast<size_t>(ptr - lower.ptr);
+        return chunks.emplace_hint(chunk, ptr, upper);
+    }
+
     void MemoryManager::InsertChunk(const ChunkDescriptor &chunk) {
+        if (!chunk.size)
+            return;
+
         std::unique_lock lock(mutex);
 
-        auto upper{std::upper_bound(chunks.begin(), chunks.end(), chunk.ptr, [](const u8 *ptr, const ChunkDescriptor &chunk) -> bool { return ptr < chunk.ptr; })};
-        if (upper == chunks.begin())
-            throw exception("InsertChunk: Chunk inserted outside address space: 0x{:X} - 0x{:X} and 0x{:X} - 0x{:X}", upper->ptr, upper->ptr + upper->size, chunk.ptr, chunk.ptr + chunk.size);
+        auto end{chunk.ptr + chunk.size};
+        auto lower{SplitChunk(chunk.ptr)};
+        auto upper{SplitChunk(end)};
 
-        upper = chunks.erase(upper, std::upper_bound(upper, chunks.end(), chunk.ptr + chunk.size, [](const u8 *ptr, const ChunkDescriptor &chunk) -> bool { return ptr < chunk.ptr + chunk.size; }));
-        if (upper != chunks.end() && upper->ptr < chunk.ptr + chunk.size) {
-            auto end{upper->ptr + upper->size};
-            upper->ptr = chunk.ptr + chunk.size;
-            upper->size = static_cast<size_t>(end - upper->ptr);
+        // Any chunks inside the range are replaced by the new chunk, which is then merged with compatible neighbours
+        auto inserted{chunks.emplace_hint(chunks.erase(lower, upper), chunk.ptr, chunk)};
+        if (upper != chunks.end() && chunk.IsCompatible(upper->second)) {
+            inserted->second.size += upper->second.size;
+            chunks.erase(upper);
         }
 
-        auto lower{std::prev(upper)};
-        if (lower->ptr == chunk.ptr && lower->size == chunk.size) {
-            lower->state = chunk.state;
-            lower->permission = chunk.permission;
-            lower->attributes = chunk.attributes;
-        } else if (lower->ptr + lower->size > chunk.ptr + chunk.size) {
-            auto lowerExtension{*lower};
-            lowerExtension.ptr = chunk.ptr + chunk.size;
-            lowerExtension.size = static_cast<size_t>((lower->ptr + lower->size) - lowerExtension.ptr);
-
-            lower->size = static_cast<size_t>(chunk.ptr - lower->ptr);
-            if (lower->size) {
-                upper = chunks.insert(upper, lowerExtension);
-                chunks.insert(upper, chunk);
-            } else {
-                auto lower2{std::prev(lower)};
-                if (chunk.IsCompatible(*lower2) && lower2->ptr + lower2->size >= chunk.ptr) {
-                    lower2->size = static_cast<size_t>(chunk.ptr + chunk.size - lower2->ptr);
-                    upper = chunks.erase(lower);
-                } else {
-                    *lower = chunk;
-                }
-                upper = chunks.insert(upper, lowerExtension);
-            }
-        } else if (chunk.IsCompatible(*lower) && lower->ptr + lower->size >= chunk.ptr) {
-            lower->size = static_cast<size_t>(chunk.ptr + chunk.size - lower->ptr);
-        } else {
-            if (lower->ptr + lower->size > chunk.ptr)
-                lower->size = static_cast<size_t>(chunk.ptr - lower->ptr);
-            if (upper != chunks.end() && chunk.IsCompatible(*upper) && chunk.ptr + chunk.size >= upper->ptr) {
-                upper->ptr = chunk.ptr;
-                upper->size = chunk.size + upper->size;
-            } else {
-                chunks.insert(upper, chunk);
+        if (inserted != chunks.begin()) {
+            auto &previous{std::prev(inserted)->second};
+            if (chunk.IsCompatible(previous) && previous.ptr + previous.size == chunk.ptr) {
+                previous.size += inserted->second.size;
+                chunks.erase(inserted);
             }
         }
     }
@@ -246,10 +261,10 @@ namespace skyline::kernel {
     std::optional<ChunkDescriptor> MemoryManager::Get(void *ptr) {
         std::shared_lock lock(mutex);
 
-        auto chunk{std::upper_bound(chunks.begin(), chunks.end(), reinterpret_cast<u8 *>(ptr), [](const u8 *ptr, const ChunkDescriptor &chunk) -> bool { return ptr < chunk.ptr; })};
+        auto chunk{chunks.upper_bound(reinterpret_cast<u8 *>(ptr))};
         if (chunk-- != chunks.begin())
-            if ((chunk->ptr + chunk->size) > ptr)
-                return std::make_optional(*chunk);
+            if ((chunk->second.ptr + chunk->second.size) > ptr)
+                return std::make_optional(chunk->second);
 
         return std::nullopt;
     }
@@ -257,7 +272,7 @@ namespace skyline::kernel {
     size_t MemoryManager::GetUserMemoryUsage() {
         std::shared_lock lock(mutex);
         size_t size{};
-        for (const auto &chunk : chunks)
+        for (const auto &[ptr, chunk] : chunks)
             if (chunk.state == memory::states::Heap)
                 size += chunk.size;
         return size + code.size() + state.process->mainThreadStack->guest.size();
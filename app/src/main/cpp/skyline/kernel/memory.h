@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <map>
 #include <sys/mman.h>
 #include <common.h>
 #include <common/file_descriptor.h>
@@ -207,7 +208,20 @@ namespace skyline {
         class MemoryManager {
           private:
             const DeviceState &state;
-            std::vector<ChunkDescriptor> chunks;
+            std::map<u8 *, ChunkDescriptor> chunks; //!< A contiguous set of chunks covering the entire address space keyed by their base address, a balanced tree is used to avoid shifting all following chunks on every split or merge
+
+            /**
+             * @brief Splits the chunk containing the supplied address into two chunks at the address, if it isn't already at a chunk boundary
+             * @return An iterator to the chunk starting at the supplied address
+             * @note 'mutex' **must** be locked in exclusive mode by the calling thread
+             */
+            std::map<u8 *, ChunkDescriptor>::iterator SplitChunk(u8 *ptr);
+
+            /**
+             * @brief Advises the kernel to back the heap and alias regions with transparent huge pages
+             * @note This relies on the host kernel allowing huge pages for shared memory, it's only logged if that isn't the case
+             */
+            void AdviseHugePages();
 
           public:
             span<u8> addressSpace{}; //!< The entire address space
@@ -0,0 +1,510 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <asm/sigcontext.h>
+#include <filesystem>
+#include <lz4.h>
+#include <common/trace.h>
+#include <gpu.h>
+#include <soc.h>
+#include <os.h>
+#include "types/KProcess.h"
+#include "save_state.h"
+
+namespace skyline::kernel {
+    static constexpr size_t BlockSize{4 * 1024 * 1024}; //!< The uncompressed size of each LZ4 block in a snapshot file
+    static constexpr size_t ReadSize{2 * 1024 * 1024}; //!< The amount of guest memory read out of the memory backing at a time
+    static constexpr i64 YieldTimeout{100 * constant::NsInMillisecond}; //!< The maximum duration to wait for guest threads to yield after being paused
+    static constexpr size_t RestoreAttempts{8}; //!< The amount of times the guest is suspended while waiting for all threads to be in the same kind of state they were saved in
+    static constexpr i64 RestoreRetryDelay{2 * constant::NsInMillisecond}; //!< The duration that the guest is resumed for between attempts to restore its threads
+
+    /**
+     * @brief Writes the entirety of the supplied data to the file descriptor
+     * @return If all the data was written
+     */
+    static bool WriteAll(int fd, span<const u8> data) {
+        while (!data.empty()) {
+            auto ret{write(fd, data.data(), data.size())};
+            if (ret < 0) {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            data = data.subspan(static_cast<size_t>(ret));
+        }
+        return true;
+    }
+
+    /**
+     * @brief Reads the entirety of the supplied span from the file descriptor at the supplied offset, or the current file offset if it's negative
+     * @return If the span was filled entirely
+     */
+    static bool ReadAll(int fd, span<u8> data, off_t offset = -1) {
+        while (!data.empty()) {
+            auto ret{offset < 0 ? read(fd, data.data(), data.size()) : pread(fd, data.data(), data.size(), offset)};
+            if (ret < 0) {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            } else if (ret == 0) {
+                return false;
+            }
+            data = data.subspan(static_cast<size_t>(ret));
+            if (offset >= 0)
+                offset += ret;
+        }
+        return true;
+    }
+
+    /**
+     * @return The FP/SIMD registers in the supplied signal context, these are always present on AArch64
+     */
+    static fpsimd_context &GetFpsimdContext(ucontext *context) {
+        for (auto head{reinterpret_cast<_aarch64_ctx *>(context->uc_mcontext.__reserved)}; head->magic && head->size; head = reinterpret_cast<_aarch64_ctx *>(reinterpret_cast<u8 *>(head) + head->size))
+            if (head->magic == FPSIMD_MAGIC)
+                return *reinterpret_cast<fpsimd_context *>(head);
+        throw exception("Signal context doesn't contain the FP/SIMD registers");
+    }
+
+    /**
+     * @brief Captures the guest registers of a suspended thread
+     * @param guestContext The signal context of the thread if it was suspended in guest code, otherwise it's in an SVC and its registers are taken from the thread context
+     */
+    static SaveStateManager::GuestRegisters CaptureRegisters(const type::KThread &thread, ucontext *guestContext) {
+        SaveStateManager::GuestRegisters registers{.tpidrEl0 = reinterpret_cast<u64>(thread.ctx.tpidrEl0)};
+        if (guestContext) {
+            auto &mctx{guestContext->uc_mcontext};
+            std::copy_n(mctx.regs, registers.x.size(), registers.x.begin());
+            registers.sp = mctx.sp;
+            registers.pc = mctx.pc;
+            registers.pstate = mctx.pstate;
+
+            auto &fpsimd{GetFpsimdContext(guestContext)};
+            std::copy_n(fpsimd.vregs, registers.v.size(), registers.v.begin());
+            registers.fpsr = fpsimd.fpsr;
+            registers.fpcr = fpsimd.fpcr;
+        } else {
+            std::copy(thread.ctx.gpr.regs.begin(), thread.ctx.gpr.regs.end(), registers.x.begin());
+            registers.v = thread.ctx.fpr.regs;
+        }
+        return registers;
+    }
+
+    /**
+     * @brief Restores the guest registers of a suspended thread, they're loaded by the thread once it's resumed
+     * @param guestContext The signal context of the thread, this must be non-null if and only if the registers were captured in guest code
+     */
+    static void RestoreRegisters(type::KThread &thread, ucontext *guestContext, const SaveStateManager::GuestRegisters &registers) {
+        thread.ctx.tpidrEl0 = reinterpret_cast<u8 *>(registers.tpidrEl0);
+        if (guestContext) {
+            auto &mctx{guestContext->uc_mcontext};
+            std::copy(registers.x.begin(), registers.x.end(), mctx.regs);
+            mctx.sp = registers.sp;
+            mctx.pc = registers.pc;
+            mctx.pstate = registers.pstate;
+
+            auto &fpsimd{GetFpsimdContext(guestContext)};
+            std::copy(registers.v.begin(), registers.v.end(), fpsimd.vregs);
+            fpsimd.fpsr = registers.fpsr;
+            fpsimd.fpcr = registers.fpcr;
+        } else {
+            std::copy_n(registers.x.begin(), thread.ctx.gpr.regs.size(), thread.ctx.gpr.regs.begin());
+            thread.ctx.fpr.regs = registers.v;
+        }
+    }
+
+    SaveStateManager::SaveStateManager(const DeviceState &state) : state{state}, writerPool{"Sky-SaveState", 1} {
+        u64 titleId{state.process->npdm.aci0.programId}; // NPDM structures are packed so the member can't be bound to a reference directly
+        directory = fmt::format("{}save_states/{:016X}/", state.os->publicAppFilesPath, titleId);
+    }
+
+    SaveStateManager::~SaveStateManager() {
+        if (pendingWrite.valid())
+            pendingWrite.wait();
+    }
+
+    std::string SaveStateManager::GetPath(u32 slot, u32 sequence) {
+        return fmt::format("{}slot{}_{}.state", directory, slot, sequence);
+    }
+
+    bool SaveStateManager::SuspendGuest() {
+        state.process->SuspendThreads();
+
+        // Threads which were running are only stopped once they've handled the yield signal sent to them, their registers are only available at that point
+        i64 deadline{util::GetTimeNs() + YieldTimeout};
+        for (const auto &thread : state.process->GetThreads()) {
+            while (thread->running && thread->pendingYield && util::GetTimeNs() < deadline)
+                std::this_thread::yield();
+
+            if (thread->running && thread->pendingYield) {
+                Logger::Warn("T{} didn't yield within {}ms of being suspended", thread->id, YieldTimeout / constant::NsInMillisecond);
+                state.process->ResumeThreads();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void SaveStateManager::WriteSnapshot(const std::string &path, FileHeader header, std::vector<u8> data) {
+        TRACE_EVENT("kernel", "SaveStateManager::WriteSnapshot");
+
+        // The snapshot is written to a temporary file and renamed over the destination, so a prior snapshot is never left partially overwritten
+        auto temporaryPath{path + ".tmp"};
+        int fd{open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR)};
+        if (fd < 0) {
+            Logger::Warn("Failed to open save state file '{}': {}", temporaryPath, strerror(errno));
+            return;
+        }
+
+        bool success{WriteAll(fd, span<FileHeader>{header}.cast<const u8>())};
+        std::vector<u8> compressedBlock(sizeof(BlockHeader) + static_cast<size_t>(LZ4_compressBound(static_cast<int>(BlockSize))));
+        for (size_t offset{}; success && offset < data.size(); offset += BlockSize) {
+            auto block{span{data}.subspan(offset, std::min(BlockSize, data.size() - offset))};
+            int compressedSize{LZ4_compress_default(reinterpret_cast<const char *>(block.data()), reinterpret_cast<char *>(compressedBlock.data() + sizeof(BlockHeader)), static_cast<int>(block.size()), static_cast<int>(compressedBlock.size() - sizeof(BlockHeader)))};
+            if (compressedSize <= 0)
+                throw exception("Failed to compress save state block of 0x{:X} bytes", block.size());
+
+            *reinterpret_cast<BlockHeader *>(compressedBlock.data()) = BlockHeader{
+                .compressedSize = static_cast<u32>(compressedSize),
+                .size = static_cast<u32>(block.size()),
+            };
+            success = WriteAll(fd, span{compressedBlock}.first(sizeof(BlockHeader) + static_cast<size_t>(compressedSize)));
+        }
+
+        close(fd);
+        if (!success || rename(temporaryPath.c_str(), path.c_str())) {
+            Logger::Warn("Failed to write save state file '{}': {}", path, strerror(errno));
+            unlink(temporaryPath.c_str());
+            return;
+        }
+
+        Logger::Info("Wrote save state '{}' with {} pages and {} holes (0x{:X} bytes)", path, header.pageCount, header.holeCount, data.size());
+    }
+
+    std::pair<SaveStateManager::FileHeader, std::vector<u8>> SaveStateManager::ReadSnapshot(const std::string &path) {
+        FileHeader header{};
+        std::vector<u8> data;
+
+        int fd{open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+        if (fd < 0)
+            return {header, data};
+
+        if (!ReadAll(fd, span<FileHeader>{header}.cast<u8>()) || header.magic != Magic || header.version != Version) {
+            Logger::Warn("Save state file '{}' is invalid or from an incompatible version", path);
+            close(fd);
+            return {header, data};
+        }
+
+        BlockHeader blockHeader{};
+        std::vector<u8> compressedBlock;
+        while (ReadAll(fd, span<BlockHeader>{blockHeader}.cast<u8>())) {
+            compressedBlock.resize(blockHeader.compressedSize);
+            size_t offset{data.size()};
+            data.resize(offset + blockHeader.size);
+            if (!ReadAll(fd, compressedBlock) || LZ4_decompress_safe(reinterpret_cast<char *>(compressedBlock.data()), reinterpret_cast<char *>(data.data() + offset), static_cast<int>(compressedBlock.size()), static_cast<int>(blockHeader.size)) != static_cast<int>(blockHeader.size)) {
+                Logger::Warn("Save state file '{}' is corrupted", path);
+                data.clear();
+                break;
+            }
+        }
+
+        close(fd);
+        return {header, data};
+    }
+
+    SaveStateManager::Result SaveStateManager::Save(u32 slot) {
+        TRACE_EVENT("kernel", "SaveStateManager::Save");
+        std::scoped_lock lock{mutex};
+
+        i64 pauseStart{util::GetTimeNs()};
+        if (!SuspendGuest())
+            return Result::SuspendTimeout;
+
+        // GPU modifications to textures and buffers only exist in host memory till they're written back, they'd be missing from the snapshot otherwise
+        if (state.gpu)
+            state.gpu->SynchronizeGuest();
+
+        auto &process{state.process};
+        auto &memory{process->memory};
+        auto &chain{chains[slot]};
+        if (chain.length >= MaxChainLength) {
+            chain.length = 0;
+            chain.pageHashes.clear();
+        }
+
+        FileHeader header{
+            .titleId = process->npdm.aci0.programId,
+            .slot = slot,
+            .sequence = chain.length,
+            .memorySize = memory.base.size(),
+            .hostStateHash = state.os->serviceManager.HashHostState(),
+        };
+
+        std::vector<u8> data;
+        auto append{[&data](auto object) {
+            auto bytes{span<decltype(object)>{object}.template cast<const u8>()};
+            data.insert(data.end(), bytes.begin(), bytes.end());
+        }};
+
+        for (const auto &thread : process->GetThreads()) {
+            if (!thread->running)
+                continue;
+
+            auto guestContext{thread->guestContext.load(std::memory_order_acquire)};
+            append(ThreadState{
+                .handle = thread->handle,
+                .id = static_cast<u32>(thread->id),
+                .basePriority = thread->basePriority,
+                .idealCore = thread->idealCore,
+                .coreId = thread->coreId,
+                .inGuest = guestContext != nullptr,
+                .registers = CaptureRegisters(*thread, guestContext),
+            });
+            header.threadCount++;
+        }
+
+        for (auto [handle, type] : process->GetHandleTypes()) {
+            append(HandleState{handle, type});
+            header.handleCount++;
+        }
+
+        for (auto name : state.os->serviceManager.GetServiceNames()) {
+            append(name);
+            header.serviceCount++;
+        }
+
+        for (auto &syncpoint : state.soc->host1x.syncpoints)
+            append(syncpoint.Load());
+
+        std::vector<HoleState> holes;
+        {
+            // Only the populated regions of the memory backing are scanned, every page in them which changed since the last file in the chain is appended alongside its offset
+            std::shared_lock memoryLock{memory.mutex};
+            int fd{memory.memoryFd};
+            auto end{static_cast<off_t>(memory.base.size())};
+            bool fullSnapshot{header.sequence == 0};
+            std::unordered_map<u64, u64> pageHashes;
+            pageHashes.reserve(chain.pageHashes.size());
+            std::vector<u8> buffer(ReadSize);
+            off_t populatedEnd{};
+            for (off_t offset{lseek(fd, 0, SEEK_DATA)}; offset >= 0 && offset < end; offset = lseek(fd, offset, SEEK_DATA)) {
+                off_t extentEnd{lseek(fd, offset, SEEK_HOLE)};
+                if (extentEnd < 0 || extentEnd > end)
+                    extentEnd = end;
+
+                if (fullSnapshot && offset > populatedEnd)
+                    holes.push_back(HoleState{static_cast<u64>(populatedEnd), static_cast<u64>(offset - populatedEnd)});
+                populatedEnd = extentEnd;
+
+                while (offset < extentEnd) {
+                    auto readSize{std::min(ReadSize, static_cast<size_t>(extentEnd - offset))};
+                    if (!ReadAll(fd, span{buffer}.first(readSize), offset))
+                        throw exception("Failed to read guest memory at 0x{:X}: {}", offset, strerror(errno));
+
+                    for (size_t pageOffset{}; pageOffset < readSize; pageOffset += constant::PageSize) {
+                        auto page{span{buffer}.subspan(pageOffset, constant::PageSize)};
+                        u64 hash{XXH64(page.data(), page.size(), 0)}, pageBase{static_cast<u64>(offset) + pageOffset};
+                        auto previous{chain.pageHashes.find(pageBase)};
+                        if (previous == chain.pageHashes.end() || previous->second != hash) {
+                            append(pageBase);
+                            data.insert(data.end(), page.begin(), page.end());
+                            header.pageCount++;
+                        }
+                        pageHashes.emplace(pageBase, hash);
+                    }
+
+                    offset += static_cast<off_t>(readSize);
+                }
+            }
+
+            if (fullSnapshot && populatedEnd < end) {
+                holes.push_back(HoleState{static_cast<u64>(populatedEnd), static_cast<u64>(end - populatedEnd)});
+            } else if (!fullSnapshot) {
+                // Pages that were populated in the prior file but have since been freed are recorded as holes, so they're cleared when the chain is restored
+                std::vector<u64> freedPages;
+                for (const auto &[pageBase, hash] : chain.pageHashes)
+                    if (!pageHashes.contains(pageBase))
+                        freedPages.push_back(pageBase);
+                std::sort(freedPages.begin(), freedPages.end());
+
+                for (u64 pageBase : freedPages) {
+                    if (!holes.empty() && holes.back().offset + holes.back().size == pageBase)
+                        holes.back().size += constant::PageSize;
+                    else
+                        holes.push_back(HoleState{pageBase, constant::PageSize});
+                }
+            }
+            chain.pageHashes = std::move(pageHashes); // Hashes of pages which are no longer populated are dropped as they'd otherwise be compared against after being repopulated
+        }
+
+        for (const auto &hole : holes)
+            append(hole);
+        header.holeCount = static_cast<u32>(holes.size());
+
+        process->ResumeThreads();
+        i64 pauseTime{util::GetTimeNs() - pauseStart};
+        lastPauseTime.store(pauseTime, std::memory_order_relaxed);
+        TRACE_COUNTER("kernel", "SaveStatePauseMs", pauseTime / constant::NsInMillisecond);
+        Logger::Info("Snapshotted {} changed pages and {} holes into slot {} with the guest paused for {}ms", header.pageCount, header.holeCount, slot, pauseTime / constant::NsInMillisecond);
+
+        std::filesystem::create_directories(directory);
+        pendingWrite = writerPool.Submit([this, path = GetPath(slot, chain.length), header, data = std::move(data)]() mutable {
+            WriteSnapshot(path, header, std::move(data));
+
+            // Any files from a prior chain after a full snapshot are stale and would be applied on top of it otherwise
+            if (header.sequence == 0)
+                for (u32 sequence{1}; sequence < MaxChainLength; sequence++)
+                    unlink(GetPath(header.slot, sequence).c_str());
+        });
+        chain.length++;
+        return Result::Success;
+    }
+
+    SaveStateManager::Result SaveStateManager::Load(u32 slot) {
+        TRACE_EVENT("kernel", "SaveStateManager::Load");
+        std::scoped_lock lock{mutex};
+        if (pendingWrite.valid())
+            pendingWrite.wait();
+
+        auto &process{state.process};
+        auto &memory{process->memory};
+        u64 titleId{process->npdm.aci0.programId};
+
+        std::vector<std::pair<FileHeader, std::vector<u8>>> snapshots;
+        for (u32 sequence{}; sequence < MaxChainLength; sequence++) {
+            auto snapshot{ReadSnapshot(GetPath(slot, sequence))};
+            auto &header{snapshot.first};
+            if (snapshot.second.empty())
+                break;
+
+            if (header.titleId != titleId || header.slot != slot || header.sequence != sequence || header.memorySize != memory.base.size()) {
+                Logger::Warn("Save state file {} of slot {} doesn't match the current title", sequence, slot);
+                break;
+            }
+
+            snapshots.push_back(std::move(snapshot));
+        }
+
+        if (snapshots.empty()) {
+            Logger::Warn("Save state slot {} is empty", slot);
+            return Result::Empty;
+        }
+
+        // The thread, handle and service state is only taken from the latest snapshot in the chain as it supersedes all prior ones
+        auto &[header, data]{snapshots.back()};
+        span<const u8> cursor{data};
+        auto consume{[&cursor]<typename Type>(size_t count) {
+            auto bytes{cursor.first(count * sizeof(Type))};
+            cursor = cursor.subspan(bytes.size());
+            return bytes.template cast<const Type>();
+        }};
+
+        auto savedThreads{consume.operator()<ThreadState>(header.threadCount)};
+        auto savedHandles{consume.operator()<HandleState>(header.handleCount)};
+        auto savedServices{consume.operator()<service::ServiceName>(header.serviceCount)};
+        auto savedSyncpoints{consume.operator()<u32>(soc::host1x::SyncpointCount)};
+
+        // Host-side objects can't be recreated from a snapshot, so it can only be restored if the process has the same layout of threads, handles and services
+        auto threads{process->GetThreads()};
+        std::erase_if(threads, [](const auto &thread) { return !thread->running; });
+        bool threadsMatch{threads.size() == savedThreads.size() && std::equal(threads.begin(), threads.end(), savedThreads.begin(), [](const auto &thread, const ThreadState &saved) {
+            return thread->handle == saved.handle && thread->id == saved.id;
+        })};
+
+        auto handles{process->GetHandleTypes()};
+        bool handlesMatch{handles.size() == savedHandles.size() && std::equal(handles.begin(), handles.end(), savedHandles.begin(), [](const auto &handle, const HandleState &saved) {
+            return handle.first == saved.handle && handle.second == saved.type;
+        })};
+
+        auto services{state.os->serviceManager.GetServiceNames()};
+        bool servicesMatch{std::equal(services.begin(), services.end(), savedServices.begin(), savedServices.end())};
+
+        if (!threadsMatch || !handlesMatch || !servicesMatch) {
+            Logger::Warn("Save state slot {} doesn't match the current state of the process (Threads: {}, Handles: {}, Services: {})", slot, threadsMatch, handlesMatch, servicesMatch);
+            return Result::LayoutMismatch;
+        }
+
+        // Registers of threads in guest code can only be restored into their signal context and those of threads in an SVC into their thread context, so every thread must be suspended in the same kind of state as it was saved in
+        // Threads move between guest code and SVCs constantly, so the guest is resumed briefly and suspended again to give any mismatching threads a chance to get into the saved state
+        i64 pauseStart{};
+        std::vector<ucontext *> guestContexts;
+        for (size_t attempt{}; guestContexts.size() != threads.size(); attempt++) {
+            if (attempt) {
+                process->ResumeThreads();
+                if (attempt == RestoreAttempts) {
+                    Logger::Warn("Save state slot {} can't be restored as its threads weren't suspended in the same state as they were saved in after {} attempts", slot, RestoreAttempts);
+                    return Result::ThreadStateMismatch;
+                }
+                std::this_thread::sleep_for(std::chrono::nanoseconds(RestoreRetryDelay));
+            }
+
+            pauseStart = util::GetTimeNs();
+            if (!SuspendGuest())
+                return Result::SuspendTimeout;
+
+            // Host-side state can only change while the guest runs, it's checked after every suspension as the guest may have changed it while it was resumed
+            if (state.os->serviceManager.HashHostState() != header.hostStateHash) {
+                Logger::Warn("Save state slot {} can't be restored as the state of nvdrv or the display layer changed since it was taken", slot);
+                process->ResumeThreads();
+                return Result::HostStateMismatch;
+            }
+
+            guestContexts.clear();
+            for (size_t index{}; index < threads.size(); index++) {
+                auto guestContext{threads[index]->guestContext.load(std::memory_order_acquire)};
+                if ((guestContext != nullptr) != savedThreads[index].inGuest) {
+                    Logger::Debug("Attempt {} to restore save state slot {}: T{} is suspended {} while it was saved {}", attempt, slot, threads[index]->id, guestContext ? "in guest code" : "in an SVC", guestContext ? "in an SVC" : "in guest code");
+                    break;
+                }
+                guestContexts.push_back(guestContext);
+            }
+        }
+
+        // Any GPU-dirty guest memory is written back and all host copies of guest memory are dropped prior to it being overwritten, so they're recreated from the restored memory
+        if (state.gpu)
+            state.gpu->Trim();
+
+        {
+            std::shared_lock memoryLock{memory.mutex};
+            int fd{memory.memoryFd};
+            for (auto &snapshot : snapshots) {
+                auto &snapshotHeader{snapshot.first};
+                span<const u8> pages{snapshot.second};
+                pages = pages.subspan(snapshotHeader.threadCount * sizeof(ThreadState) + snapshotHeader.handleCount * sizeof(HandleState) + snapshotHeader.serviceCount * sizeof(service::ServiceName) + soc::host1x::SyncpointCount * sizeof(u32));
+
+                for (u32 page{}; page < snapshotHeader.pageCount; page++) {
+                    u64 offset{pages.as<u64>()};
+                    auto contents{pages.subspan(sizeof(u64), constant::PageSize)};
+                    pages = pages.subspan(sizeof(u64) + constant::PageSize);
+
+                    if (pwrite(fd, contents.data(), contents.size(), static_cast<off_t>(offset)) != static_cast<ssize_t>(contents.size()))
+                        throw exception("Failed to restore guest memory at 0x{:X}: {}", offset, strerror(errno));
+                }
+
+                // Holes are disjoint from the pages of the same file, they're applied in the order of the chain as a later file may repopulate them
+                for (const auto &hole : pages.first(snapshotHeader.holeCount * sizeof(HoleState)).cast<const HoleState>())
+                    if (fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, static_cast<off_t>(hole.offset), static_cast<off_t>(hole.size)) != 0)
+                        throw exception("Failed to clear guest memory at 0x{:X}-0x{:X}: {}", hole.offset, hole.offset + hole.size, strerror(errno));
+            }
+        }
+
+        // Threads resume with the restored registers, the host pointers in the thread context are specific to the host thread so they're left as-is
+        for (size_t index{}; index < threads.size(); index++)
+            RestoreRegisters(*threads[index], guestContexts[index], savedThreads[index].registers);
+
+        // Syncpoints can't be rolled back as host waiters depend on them being monotonic, they're only advanced to the saved value
+        for (size_t index{}; index < soc::host1x::SyncpointCount; index++) {
+            auto &syncpoint{state.soc->host1x.syncpoints[index]};
+            while (static_cast<i32>(savedSyncpoints[index] - syncpoint.Load()) > 0)
+                syncpoint.Increment();
+        }
+
+        process->ResumeThreads();
+        i64 pauseTime{util::GetTimeNs() - pauseStart};
+        lastPauseTime.store(pauseTime, std::memory_order_relaxed);
+        Logger::Info("Restored save state slot {} from {} files with the guest paused for {}ms", slot, snapshots.size(), pauseTime / constant::NsInMillisecond);
+        return Result::Success;
+    }
+}
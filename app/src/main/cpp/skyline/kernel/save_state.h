@@ -0,0 +1,170 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common.h>
+#include <common/thread_pool.h>
+#include <nce/guest.h>
+#include <soc/host1x/syncpoint.h>
+#include "types/KObject.h"
+
+namespace skyline::kernel {
+    /**
+     * @brief Saves and restores snapshots of the guest process into numbered slots, each slot is a chain of files where the first is a full snapshot of guest memory and every following one only contains the pages which changed since the prior file in the chain
+     * @note Guest memory is a MAP_SHARED memfd so it can't be snapshotted with copy-on-write, the guest is paused while changed pages are hashed and copied out of the memfd while compressing and writing the snapshot is done on a background thread after the guest has resumed
+     * @note Only guest-visible state is captured: guest memory, the registers of guest threads, the layout of the handle table, the names of all open services and the host1x syncpoint values
+     * @note Kernel objects, service state and the guest-visible GPU state (nvmap handles, GPU address spaces and the display layer) aren't captured, a snapshot can only be restored while all of them are unchanged since it was taken which is checked using a fingerprint of them
+     */
+    class SaveStateManager {
+      public:
+        static constexpr u32 Magic{util::MakeMagic<u32>("SKSS")};
+        static constexpr u32 Version{4}; //!< The version of the save state format, this must be incremented whenever any of the structures below are changed
+        static constexpr u32 MaxChainLength{8}; //!< The maximum amount of files in the chain of a slot, a full snapshot is taken once this is reached to bound the time taken to restore a slot
+
+        struct FileHeader {
+            u32 magic{Magic};
+            u32 version{Version};
+            u64 titleId; //!< The program ID of the title that the snapshot was made from
+            u32 slot;
+            u32 sequence; //!< The index of the file in the chain of the slot, 0 denotes a full snapshot
+            u64 memorySize; //!< The size of the guest memory backing, this must match when restoring
+            u32 threadCount;
+            u32 handleCount;
+            u32 serviceCount;
+            u32 pageCount; //!< The amount of guest pages in the snapshot
+            u32 holeCount; //!< The amount of unpopulated extents of the memory backing in the snapshot, these are zero-filled when restoring
+            u64 hostStateHash; //!< The value of ServiceManager::HashHostState when the snapshot was taken, the snapshot can only be restored while this is unchanged
+        };
+
+        /**
+         * @brief The outcome of saving or loading a snapshot, this is reported to the UI so the values must be kept in sync with SaveStateResult in Kotlin
+         */
+        enum class Result : i32 {
+            Success,
+            Error, //!< An unexpected error occurred, this is only returned over JNI when an exception is thrown
+            NotLoaded, //!< The process is still being loaded, this is only returned over JNI
+            SuspendTimeout, //!< A guest thread didn't yield in time to be suspended
+            Empty, //!< The slot doesn't contain a snapshot of the current title
+            LayoutMismatch, //!< The threads, handles or open services of the process differ from the ones in the snapshot
+            HostStateMismatch, //!< The host-side state of services or the GPU changed since the snapshot was taken
+            ThreadStateMismatch, //!< A thread remained suspended in guest code while it was saved in an SVC or vice versa
+        };
+
+        struct BlockHeader {
+            u32 compressedSize; //!< The size of the LZ4-compressed block data following the header
+            u32 size; //!< The size of the block data once decompressed
+        };
+
+        /**
+         * @brief The guest registers of a thread, which of these are captured depends on where the guest was suspended in the thread
+         */
+        struct GuestRegisters {
+            std::array<u64, 31> x; //!< X0-X30, only X0-X18 are captured for threads in an SVC as the rest are held by the host code running the SVC
+            u64 sp; //!< Only captured for threads which were suspended in guest code
+            u64 pc; //!< Only captured for threads which were suspended in guest code
+            u64 pstate; //!< Only captured for threads which were suspended in guest code
+            std::array<u128, 32> v; //!< The raw FP register state, this is a nce::FpRegisters for threads in an SVC
+            u32 fpsr; //!< Only captured for threads which were suspended in guest code as it's inside v otherwise
+            u32 fpcr; //!< Only captured for threads which were suspended in guest code as it's inside v otherwise
+            u64 tpidrEl0; //!< The emulated TPIDR_EL0
+        };
+
+        /**
+         * @brief The state of a single guest thread, the data of a snapshot starts with an array of these
+         */
+        struct ThreadState {
+            KHandle handle;
+            u32 id;
+            i8 basePriority;
+            u8 idealCore;
+            u8 coreId;
+            bool inGuest; //!< If the thread was suspended in guest code rather than in an SVC, a thread can only be restored into the same kind of state
+            GuestRegisters registers;
+        };
+
+        /**
+         * @brief An unpopulated extent of the memory backing, these follow the pages of a snapshot
+         * @note A full snapshot contains all holes in the memory backing while later ones only contain holes that were populated in the prior file of the chain
+         */
+        struct HoleState {
+            u64 offset;
+            u64 size;
+        };
+
+        /**
+         * @brief An entry in the handle table, these follow the thread states
+         */
+        struct HandleState {
+            KHandle handle;
+            type::KType type;
+        };
+
+      private:
+        const DeviceState &state;
+        std::string directory; //!< The directory that the save states of the current title are stored in
+
+        /**
+         * @brief The hashes of every guest page in the last file written to a slot, these are used to determine which pages changed since then
+         */
+        struct SlotChain {
+            u32 length{}; //!< The amount of files in the chain
+            std::unordered_map<u64, u64> pageHashes; //!< A map from the offset of a page within the memory backing to the hash of its contents
+        };
+
+        std::mutex mutex; //!< Synchronizes saving and loading of states
+        std::unordered_map<u32, SlotChain> chains; //!< The chains of all slots that were saved to during this session, a slot without an entry starts with a full snapshot
+        ThreadPool writerPool; //!< A single background thread which compresses and writes out snapshots
+        std::future<void> pendingWrite; //!< The future of the last snapshot submitted to the writer, tasks are run in FIFO order so waiting on this waits on all prior ones
+        std::atomic<i64> lastPauseTime{}; //!< The duration in nanoseconds that the guest was paused for during the last save or load
+
+        /**
+         * @return The path of a file in the chain of the supplied slot
+         */
+        std::string GetPath(u32 slot, u32 sequence);
+
+        /**
+         * @brief Pauses all guest threads and waits for any that are running guest code to yield, so guest memory isn't modified by the guest while it's being copied
+         * @return If all threads yielded, the guest is resumed and this fails if any didn't do so in time as their registers can't be captured or restored then
+         */
+        bool SuspendGuest();
+
+        /**
+         * @brief Compresses the supplied snapshot data and writes it out to the supplied path, this is run on the writer thread
+         */
+        static void WriteSnapshot(const std::string &path, FileHeader header, std::vector<u8> data);
+
+        /**
+         * @brief Reads and decompresses a snapshot file
+         * @return The header and the decompressed data of the snapshot, the data is empty if the file doesn't exist
+         */
+        static std::pair<FileHeader, std::vector<u8>> ReadSnapshot(const std::string &path);
+
+      public:
+        SaveStateManager(const DeviceState &state);
+
+        /**
+         * @note This waits for any snapshots that are still being written out
+         */
+        ~SaveStateManager();
+
+        /**
+         * @brief Snapshots the guest into the supplied slot, the guest is paused while GPU modifications are written back and all populated guest memory is hashed to find the changed pages
+         * @return Result::Success or Result::SuspendTimeout if the guest couldn't be suspended
+         */
+        Result Save(u32 slot);
+
+        /**
+         * @brief Restores the guest from the latest snapshot in the supplied slot
+         * @note Threads which aren't suspended in the same kind of state as they were saved in are given a few chances to get there by resuming and suspending the guest again
+         */
+        Result Load(u32 slot);
+
+        /**
+         * @return The duration in nanoseconds that the guest was paused for during the last save or load
+         */
+        i64 GetLastPauseTime() {
+            return lastPauseTime.load(std::memory_order_relaxed);
+        }
+    };
+}
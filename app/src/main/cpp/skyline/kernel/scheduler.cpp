@@ -4,13 +4,89 @@
 #include <unistd.h>
 #include <common/signal.h>
 #include <common/trace.h>
+#include <common/settings.h>
+#include <common/thread_role.h>
 #include "types/KThread.h"
 #include "scheduler.h"
 
 namespace skyline::kernel {
     Scheduler::CoreContext::CoreContext(u8 id, i8 preemptionPriority) : id(id), preemptionPriority(preemptionPriority) {}
 
-    Scheduler::Scheduler(const DeviceState &state) : state(state) {}
+    Scheduler::Scheduler(const DeviceState &state) : state(state), preemptionThread(&Scheduler::PreemptionThread, this) {}
+
+    Scheduler::~Scheduler() {
+        {
+            std::scoped_lock lock{preemptionMutex};
+            preemptionExit = true;
+        }
+        preemptionCondition.notify_all();
+        if (preemptionThread.joinable())
+            preemptionThread.join();
+    }
+
+    void Scheduler::PreemptionThread() {
+        if (int result{pthread_setname_np(pthread_self(), "Sky-Preempt")})
+            Logger::Warn("Failed to set the thread name: {}", strerror(result));
+
+        std::unique_lock lock{preemptionMutex};
+        while (!preemptionExit) {
+            bool anyArmed{};
+            for (auto &slot : preemptionSlots) {
+                if (!slot.thread)
+                    continue;
+
+                timespec cpuTime{};
+                if (clock_gettime(slot.cpuClock, &cpuTime)) [[unlikely]] {
+                    slot.thread = nullptr; // The host thread is gone, there's nothing left to preempt
+                    continue;
+                }
+
+                i64 cpuTimeNs{cpuTime.tv_sec * constant::NsInSecond + cpuTime.tv_nsec};
+                if (slot.cpuTimeBaseline < 0) {
+                    // The baseline is only taken on the first poll so arming doesn't need to query the CPU time, this costs up to a poll interval of accuracy
+                    slot.cpuTimeBaseline = cpuTimeNs;
+                    anyArmed = true;
+                } else if (cpuTimeNs - slot.cpuTimeBaseline >= slot.timeslice.count()) {
+                    // The signal is sent with the lock held as the thread is guaranteed to disarm its slot prior to exiting which ensures the pthread is valid
+                    TRACE_EVENT_INSTANT("scheduler", "Preemption Overrun");
+                    pthread_kill(slot.pthread, PreemptionSignal);
+                    slot.thread = nullptr;
+                } else {
+                    anyArmed = true;
+                }
+            }
+
+            if (anyArmed) {
+                preemptionCondition.wait_for(lock, PreemptionPollInterval, [this]() { return preemptionExit; });
+            } else {
+                preemptionIdle = true;
+                preemptionCondition.wait(lock, [this]() { return preemptionExit || !preemptionIdle; });
+            }
+        }
+    }
+
+    void Scheduler::ArmPreemptionTimer(u8 coreId, const type::KThread *thread, pthread_t pthread, clockid_t cpuClock, std::chrono::nanoseconds timeslice) {
+        std::scoped_lock lock{preemptionMutex};
+        preemptionSlots[coreId] = PreemptionSlot{
+            .thread = thread,
+            .pthread = pthread,
+            .cpuClock = cpuClock,
+            .timeslice = timeslice,
+        };
+
+        // The preemption thread only needs to be woken when it isn't already polling, this avoids a syscall on the common path
+        if (preemptionIdle) {
+            preemptionIdle = false;
+            preemptionCondition.notify_one();
+        }
+    }
+
+    void Scheduler::DisarmPreemptionTimer(const type::KThread *thread) {
+        std::scoped_lock lock{preemptionMutex};
+        for (auto &slot : preemptionSlots)
+            if (slot.thread == thread)
+                slot.thread = nullptr;
+    }
 
     void Scheduler::SignalHandler(int signal, siginfo *info, ucontext *ctx, void **tls) {
         if (*tls) {
@@ -20,9 +96,11 @@ namespace skyline::kernel {
                 const auto &state{*reinterpret_cast<nce::ThreadContext *>(*tls)->state};
                 if (signal == PreemptionSignal)
                     state.thread->isPreempted = false;
+                state.thread->guestContext.store(ctx, std::memory_order_release); // This must be published prior to the yield being acknowledged by Rotate
                 state.scheduler->Rotate(false);
                 YieldPending = false;
                 state.scheduler->WaitSchedule();
+                state.thread->guestContext.store(nullptr, std::memory_order_relaxed);
             }
             TRACE_EVENT_BEGIN("guest", "Guest");
         } else {
@@ -142,6 +220,7 @@ namespace skyline::kernel {
         lock.unlock();
 
         thread->coreId = targetCore->id;
+        thread->statistics.migrations.fetch_add(1, std::memory_order_relaxed);
         if (wasInserted)
             // We need to add the thread to the ideal core queue, if it was previously its resident core's queue
             InsertThread(thread);
@@ -150,12 +229,62 @@ namespace skyline::kernel {
         lock = std::unique_lock(targetCore->mutex);
     }
 
+    void Scheduler::SyncResidentCore(const std::shared_ptr<type::KThread> &thread, CoreContext *&core, std::unique_lock<std::mutex> &lock) {
+        while (thread->coreId != core->id && thread->coreId != constant::ParkedCoreId) [[unlikely]] {
+            lock.unlock();
+            core = &cores.at(thread->coreId);
+            lock = std::unique_lock(core->mutex);
+        }
+    }
+
+    void Scheduler::StealThread(CoreContext &idleCore) {
+        // The queue lengths are only used as a heuristic, they're rechecked after locking the core
+        CoreContext *busiestCore{};
+        size_t busiestQueueLength{1}; // A core with only a running thread has nothing to steal
+        for (auto &core : cores) {
+            if (&core != &idleCore && core.queue.size() > busiestQueueLength) {
+                busiestCore = &core;
+                busiestQueueLength = core.queue.size();
+            }
+        }
+
+        if (!busiestCore)
+            return;
+
+        std::unique_lock lock{busiestCore->mutex};
+        if (busiestCore->queue.size() < 2)
+            return;
+
+        // The front of the queue is the running thread, the rest of the queue is in priority order so the first eligible thread is the best choice
+        for (auto it{std::next(busiestCore->queue.begin())}; it != busiestCore->queue.end(); it++) {
+            auto &thread{*it};
+            if (!thread->affinityMask.test(idleCore.id) || thread->isPaused || thread->pendingYield || thread->forceYield)
+                continue;
+
+            // The core lock is held here, the opposite of the usual lock order, so we can only try to lock the migration mutex without risking a deadlock
+            std::unique_lock migrationLock{thread->coreMigrationMutex, std::try_to_lock};
+            if (!migrationLock)
+                continue;
+
+            auto stolenThread{thread};
+            busiestCore->queue.erase(it);
+            stolenThread->coreId = idleCore.id;
+            stolenThread->statistics.migrations.fetch_add(1, std::memory_order_relaxed);
+            lock.unlock();
+
+            Logger::Debug("Work Stealing T{}: C{} -> C{}", stolenThread->id, busiestCore->id, idleCore.id);
+            InsertThread(stolenThread); // This wakes the thread as the idle core's queue should be empty, if it isn't then it'll be scheduled in priority order regardless
+            return;
+        }
+    }
+
     void Scheduler::WaitSchedule(bool loadBalance) {
         auto &thread{state.thread};
         CoreContext *core{&cores.at(thread->coreId)};
         std::unique_lock lock(core->mutex);
 
         auto wakeFunction{[&]() {
+            SyncResidentCore(thread, core, lock);
             if (!thread->affinityMask.test(thread->coreId)) [[unlikely]] {
                 lock.unlock(); // If the core migration mutex is locked by a thread seeking the core mutex, it'll result in a deadlock
                 std::scoped_lock migrationLock{thread->coreMigrationMutex};
@@ -167,6 +296,7 @@ namespace skyline::kernel {
         }};
 
         TRACE_EVENT("scheduler", "WaitSchedule");
+        type::ScopedWaitAccounting waitAccounting{*thread, type::WaitReason::Schedule};
         if (loadBalance) {
             std::chrono::milliseconds loadBalanceThreshold{PreemptiveTimeslice * 2}; //!< The amount of time that needs to pass unscheduled for a thread to attempt load balancing
             while (!thread->scheduleCondition.wait_for(lock, loadBalanceThreshold, wakeFunction)) {
@@ -174,6 +304,7 @@ namespace skyline::kernel {
                 std::scoped_lock migrationLock{thread->coreMigrationMutex};
                 auto newCore{&GetOptimalCoreForThread(state.thread)};
                 lock.lock();
+                SyncResidentCore(thread, core, lock);
                 if (core != newCore)
                     MigrateToCore(thread, core, newCore, lock);
 
@@ -188,6 +319,7 @@ namespace skyline::kernel {
             thread->ArmPreemptionTimer(PreemptiveTimeslice);
 
         thread->timesliceStart = util::GetTimeTicks();
+        thread_role::Apply(thread_role::GuestCoreRole(core->id)); // The host thread is placed based on the guest core it's scheduled on, this is a no-op unless it changed
     }
 
     bool Scheduler::TimedWaitSchedule(std::chrono::nanoseconds timeout) {
@@ -195,8 +327,11 @@ namespace skyline::kernel {
         auto *core{&cores.at(thread->coreId)};
 
         TRACE_EVENT("scheduler", "TimedWaitSchedule");
+        type::ScopedWaitAccounting waitAccounting{*thread, type::WaitReason::Schedule};
         std::unique_lock lock(core->mutex);
-        if (thread->scheduleCondition.wait_for(lock, timeout, [&]() {
+        auto deadline{std::chrono::steady_clock::now() + timeout};
+        if (thread->scheduleCondition.wait_for_precise(lock, timeout, [&]() {
+            SyncResidentCore(thread, core, lock);
             if (!thread->affinityMask.test(thread->coreId)) [[unlikely]] {
                 std::scoped_lock migrationLock{thread->coreMigrationMutex};
                 MigrateToCore(thread, core, &cores.at(thread->idealCore), lock);
@@ -207,9 +342,11 @@ namespace skyline::kernel {
                 thread->ArmPreemptionTimer(PreemptiveTimeslice);
 
             thread->timesliceStart = util::GetTimeTicks();
+            thread_role::Apply(thread_role::GuestCoreRole(core->id));
 
             return true;
         } else {
+            thread->RecordOversleep(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - deadline).count());
             return false;
         }
     }
@@ -243,6 +380,7 @@ namespace skyline::kernel {
     void Scheduler::RemoveThread() {
         auto &thread{state.thread};
         auto &core{cores.at(thread->coreId)};
+        bool coreIdle{};
         {
             std::unique_lock lock(core.mutex);
             auto it{std::find(core.queue.begin(), core.queue.end(), thread)};
@@ -256,9 +394,14 @@ namespace skyline::kernel {
                     if (it != core.queue.end())
                         (*it)->scheduleCondition.notify_one(); // We need to wake the thread at the front of the queue, if we were at the front previously
                 }
+
+                coreIdle = core.queue.empty();
             }
         }
 
+        if (coreIdle && *state.settings->schedulerWorkStealing)
+            StealThread(core); // If the core has nothing left to run, we can take a thread which is waiting on a busier core
+
         thread->DisarmPreemptionTimer();
         thread->pendingYield = false;
         thread->forceYield = false;
@@ -5,6 +5,7 @@
 
 #include <common.h>
 #include <condition_variable>
+#include "host_thread_pool.h"
 
 namespace skyline {
     namespace constant {
@@ -57,6 +58,31 @@ namespace skyline {
             std::mutex parkedMutex; //!< Synchronizes all operations on the queue of parked threads
             std::list<std::shared_ptr<type::KThread>> parkedQueue; //!< A queue of threads which are parked and waiting on core migration
 
+            /**
+             * @brief The preemption state of the thread running on a single core, this is polled by the preemption thread rather than having a kernel timer per thread
+             */
+            struct PreemptionSlot {
+                const type::KThread *thread{}; //!< The thread which has its preemption timer armed on this core, if any
+                pthread_t pthread{}; //!< The host thread backing the armed thread, this is what's signalled on an overrun
+                clockid_t cpuClock{}; //!< The CPU-time clock of the host thread
+                std::chrono::nanoseconds timeslice{}; //!< The amount of CPU time the thread can run for before it's preempted
+                i64 cpuTimeBaseline{-1}; //!< The CPU time of the thread when the preemption thread first observed the slot, -1 if it hasn't been observed yet
+            };
+
+            static constexpr std::chrono::microseconds PreemptionPollInterval{2500}; //!< The interval at which armed slots are polled, this bounds how late a preemption can be
+
+            std::mutex preemptionMutex; //!< Synchronizes all accesses to the preemption slots
+            std::condition_variable preemptionCondition; //!< Wakes the preemption thread when a slot is armed while it's idle or when it needs to exit
+            std::array<PreemptionSlot, constant::CoreCount> preemptionSlots{};
+            bool preemptionIdle{}; //!< If the preemption thread is waiting indefinitely as no slots are armed
+            bool preemptionExit{}; //!< If the preemption thread should exit
+            std::thread preemptionThread;
+
+            /**
+             * @brief The entry point for the preemption thread, it polls the CPU time of threads with an armed slot and signals them once they've overrun their timeslice
+             */
+            void PreemptionThread();
+
             /**
              * @brief Migrate a thread from its resident core to its ideal core
              * @note 'KThread::coreMigrationMutex' **must** be locked by the calling thread prior to calling this
@@ -64,14 +90,29 @@ namespace skyline {
              */
             void MigrateToCore(const std::shared_ptr<type::KThread> &thread, CoreContext *&currentCore, CoreContext *targetCore, std::unique_lock<std::mutex> &lock);
 
+            /**
+             * @brief Ensures that the supplied core and its lock correspond to the resident core of the thread, switching to it if the thread's resident core was changed by work stealing
+             * @note The lock **must** be locked prior to calling this and will be locked after it returns
+             */
+            void SyncResidentCore(const std::shared_ptr<type::KThread> &thread, CoreContext *&core, std::unique_lock<std::mutex> &lock);
+
+            /**
+             * @brief Moves the highest priority waiting thread that can run on the supplied core from the queue of the busiest core to it
+             * @note No core mutexes should be held by the calling thread
+             */
+            void StealThread(CoreContext &idleCore);
+
           public:
             static constexpr std::chrono::milliseconds PreemptiveTimeslice{10}; //!< The duration of time a preemptive thread can run before yielding
             inline static int YieldSignal{SIGRTMIN}; //!< The signal used to cause a non-cooperative yield in running threads
             inline static int PreemptionSignal{SIGRTMIN + 1}; //!< The signal used to cause a preemptive yield in running threads
             inline static thread_local bool YieldPending{}; //!< A flag denoting if a yield is pending on this thread, it's checked prior to entering guest code as signals cannot interrupt host code
+            HostThreadPool hostThreadPool; //!< The host threads which guest threads are run on
 
             Scheduler(const DeviceState &state);
 
+            ~Scheduler();
+
             /**
              * @brief A signal handler designed to cause a non-cooperative yield for preemption and higher priority threads being inserted
              */
@@ -85,6 +126,17 @@ namespace skyline {
              */
             CoreContext &GetOptimalCoreForThread(const std::shared_ptr<type::KThread> &thread);
 
+            /**
+             * @brief Arms a preemption timer on the supplied core for a thread which is running on it, this replaces any prior timer armed on that core
+             * @note The timeslice is measured in CPU time of the host thread and will be overrun by up to PreemptionPollInterval
+             */
+            void ArmPreemptionTimer(u8 coreId, const type::KThread *thread, pthread_t pthread, clockid_t cpuClock, std::chrono::nanoseconds timeslice);
+
+            /**
+             * @brief Disarms the preemption timer of the supplied thread, if it has one armed on any core
+             */
+            void DisarmPreemptionTimer(const type::KThread *thread);
+
             /**
              * @brief Inserts the specified thread into the scheduler queue at the appropriate location based on its priority
              */
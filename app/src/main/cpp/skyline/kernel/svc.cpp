@@ -5,6 +5,7 @@
 #include <nce.h>
 #include <kernel/types/KProcess.h>
 #include <common/trace.h>
+#include <common/emulation_speed.h>
 #include <vfs/npdm.h>
 #include "results.h"
 #include "svc.h"
@@ -282,6 +283,7 @@ namespace skyline::kernel::svc {
     }
 
     void SleepThread(const DeviceState &state) {
+        type::ScopedWaitAccounting waitAccounting{*state.thread, type::WaitReason::Sleep};
         constexpr i64 yieldWithoutCoreMigration{0};
         constexpr i64 yieldWithCoreMigration{-1};
         constexpr i64 yieldToAnyThread{-2};
@@ -291,13 +293,9 @@ namespace skyline::kernel::svc {
             Logger::Debug("Sleeping for {}ns", in);
             TRACE_EVENT("kernel", "SleepThread", "duration", in);
 
-            struct timespec spec{
-                .tv_sec = static_cast<time_t>(in / 1000000000),
-                .tv_nsec = static_cast<long>(in % 1000000000),
-            };
-
+            i64 duration{emulation_speed::ScaleDuration(in)}; // Guest durations are scaled to the current emulation speed
             SchedulerScopedLock schedulerLock(state);
-            nanosleep(&spec, nullptr);
+            state.thread->RecordOversleep(util::PreciseSleep(duration));
         } else {
             switch (in) {
                 case yieldWithCoreMigration: {
@@ -331,6 +329,21 @@ namespace skyline::kernel::svc {
         }
     }
 
+    void SkipIdleLoop(const DeviceState &state) {
+        type::ScopedWaitAccounting waitAccounting{*state.thread, type::WaitReason::Sleep};
+
+        // Any other thread on the core is run first as the loop may be waiting on it, the core is then released for a sleep short enough that a loop waiting for a deadline doesn't overshoot it by much
+        constexpr i64 IdleLoopSleepDuration{constant::NsInMillisecond};
+        state.scheduler->Rotate();
+        state.scheduler->WaitSchedule();
+
+        struct timespec spec{
+            .tv_nsec = static_cast<long>(IdleLoopSleepDuration),
+        };
+        SchedulerScopedLock schedulerLock(state);
+        nanosleep(&spec, nullptr);
+    }
+
     void GetThreadPriority(const DeviceState &state) {
         KHandle handle{state.ctx->gpr.w1};
         try {
@@ -431,6 +444,7 @@ namespace skyline::kernel::svc {
             if (!affinityMask.test(static_cast<size_t>(thread->coreId)) && thread->coreId != constant::ParkedCoreId) {
                 Logger::Debug("Migrating thread #{} to Ideal Core C{} -> C{}", thread->id, thread->coreId, idealCore);
 
+                thread->statistics.migrations.fetch_add(1, std::memory_order_relaxed);
                 if (thread == state.thread) {
                     state.scheduler->RemoveThread();
                     thread->coreId = static_cast<u8>(idealCore);
@@ -607,6 +621,7 @@ namespace skyline::kernel::svc {
     }
 
     void WaitSynchronization(const DeviceState &state) {
+        type::ScopedWaitAccounting waitAccounting{*state.thread, type::WaitReason::SyncObject};
         constexpr u8 maxSyncHandles{0x40}; // The total amount of handles that can be passed to WaitSynchronization
 
         u32 numHandles{state.ctx->gpr.w2};
@@ -637,7 +652,7 @@ namespace skyline::kernel::svc {
             }
         }
 
-        i64 timeout{static_cast<i64>(state.ctx->gpr.x3)};
+        i64 timeout{emulation_speed::ScaleDuration(static_cast<i64>(state.ctx->gpr.x3))};
         if (waitHandles.size() == 1) {
             Logger::Debug("Waiting on 0x{:X} for {}ns", waitHandles[0], timeout);
         } else if (Logger::LogLevel::Debug <= Logger::configLevel) {
@@ -649,7 +664,30 @@ namespace skyline::kernel::svc {
 
         TRACE_EVENT_FMT("kernel", waitHandles.size() == 1 ? "WaitSynchronization 0x{:X}" : "WaitSynchronizationMultiple 0x{:X}", waitHandles[0]);
 
-        std::unique_lock lock(type::KSyncObject::syncObjectMutex);
+        // All objects are locked in order of their address to avoid deadlocking with other waits on an overlapping set of objects, signals only lock a single object
+        std::vector<type::KSyncObject *> lockOrder;
+        lockOrder.reserve(objectTable.size());
+        for (const auto &object : objectTable)
+            lockOrder.push_back(object.get());
+        std::sort(lockOrder.begin(), lockOrder.end());
+        lockOrder.erase(std::unique(lockOrder.begin(), lockOrder.end()), lockOrder.end());
+
+        struct ObjectsLock {
+            std::vector<type::KSyncObject *> &objects;
+
+            void lock() {
+                for (auto object : objects)
+                    object->syncObjectMutex.lock();
+            }
+
+            void unlock() {
+                for (auto it{objects.rbegin()}; it != objects.rend(); it++)
+                    (*it)->syncObjectMutex.unlock();
+            }
+        } objectsLock{lockOrder};
+
+        std::unique_lock lock{objectsLock};
+        std::unique_lock threadLock{state.thread->syncWaitMutex};
         if (state.thread->cancelSync) {
             state.thread->cancelSync = false;
             state.ctx->gpr.w0 = result::Cancelled;
@@ -681,12 +719,14 @@ namespace skyline::kernel::svc {
         state.thread->wakeObject = nullptr;
         state.scheduler->RemoveThread();
 
+        threadLock.unlock();
         lock.unlock();
         if (timeout > 0)
             state.scheduler->TimedWaitSchedule(std::chrono::nanoseconds(timeout));
         else
             state.scheduler->WaitSchedule(false);
         lock.lock();
+        threadLock.lock();
 
         state.thread->isCancellable = false;
         auto wakeObject{state.thread->wakeObject};
@@ -717,6 +757,7 @@ namespace skyline::kernel::svc {
         } else {
             Logger::Debug("Wait has timed out");
             state.ctx->gpr.w0 = result::TimedOut;
+            threadLock.unlock();
             lock.unlock();
             state.scheduler->InsertThread(state.thread);
             state.scheduler->WaitSchedule();
@@ -725,8 +766,8 @@ namespace skyline::kernel::svc {
 
     void CancelSynchronization(const DeviceState &state) {
         try {
-            std::unique_lock lock(type::KSyncObject::syncObjectMutex);
             auto thread{state.process->GetHandle<type::KThread>(state.ctx->gpr.w0)};
+            std::scoped_lock lock{thread->syncWaitMutex};
             thread->cancelSync = true;
             if (thread->isCancellable) {
                 thread->isCancellable = false;
@@ -740,6 +781,7 @@ namespace skyline::kernel::svc {
     }
 
     void ArbitrateLock(const DeviceState &state) {
+        type::ScopedWaitAccounting waitAccounting{*state.thread, type::WaitReason::Arbiter};
         auto mutex{reinterpret_cast<u32 *>(state.ctx->gpr.x1)};
         if (!util::IsWordAligned(mutex)) {
             Logger::Warn("'mutex' not word aligned: 0x{:X}", mutex);
@@ -778,6 +820,7 @@ namespace skyline::kernel::svc {
     }
 
     void WaitProcessWideKeyAtomic(const DeviceState &state) {
+        type::ScopedWaitAccounting waitAccounting{*state.thread, type::WaitReason::Arbiter};
         auto mutex{reinterpret_cast<u32 *>(state.ctx->gpr.x0)};
         if (!util::IsWordAligned(mutex)) {
             Logger::Warn("'mutex' not word aligned: 0x{:X}", mutex);
@@ -788,7 +831,7 @@ namespace skyline::kernel::svc {
         auto conditional{reinterpret_cast<u32 *>(state.ctx->gpr.x1)};
         KHandle requesterHandle{state.ctx->gpr.w2};
 
-        i64 timeout{static_cast<i64>(state.ctx->gpr.x3)};
+        i64 timeout{emulation_speed::ScaleDuration(static_cast<i64>(state.ctx->gpr.x3))};
         Logger::Debug("Waiting on 0x{:X} with 0x{:X} for {}ns", conditional, mutex, timeout);
 
         auto result{state.process->ConditionalVariableWait(conditional, mutex, requesterHandle, timeout)};
@@ -841,6 +884,7 @@ namespace skyline::kernel::svc {
     }
 
     void SendSyncRequest(const DeviceState &state) {
+        type::ScopedWaitAccounting waitAccounting{*state.thread, type::WaitReason::Ipc};
         SchedulerScopedLock schedulerLock(state);
         state.os->serviceManager.SyncRequestHandler(static_cast<KHandle>(state.ctx->gpr.x0));
         state.ctx->gpr.w0 = Result{};
@@ -1208,6 +1252,7 @@ namespace skyline::kernel::svc {
     }
 
     void WaitForAddress(const DeviceState &state) {
+        type::ScopedWaitAccounting waitAccounting{*state.thread, type::WaitReason::Arbiter};
         auto address{reinterpret_cast<u32 *>(state.ctx->gpr.x0)};
         if (!util::IsWordAligned(address)) [[unlikely]] {
             Logger::Warn("'address' not word aligned: 0x{:X}", address);
@@ -1218,7 +1263,7 @@ namespace skyline::kernel::svc {
         using ArbitrationType = type::KProcess::ArbitrationType;
         auto arbitrationType{static_cast<ArbitrationType>(static_cast<u32>(state.ctx->gpr.w1))};
         u32 value{state.ctx->gpr.w2};
-        i64 timeout{static_cast<i64>(state.ctx->gpr.x3)};
+        i64 timeout{emulation_speed::ScaleDuration(static_cast<i64>(state.ctx->gpr.x3))};
 
         Result result;
         switch (arbitrationType) {
@@ -66,6 +66,12 @@ namespace skyline::kernel::svc {
      */
     void SleepThread(const DeviceState &state);
 
+    /**
+     * @brief Yields the core and briefly sleeps a thread that was detected to be polling the counter in an idle loop, the loop is resumed afterwards
+     * @note This isn't a HOS SVC, it's invoked by counter read trampolines with idle loop detection enabled
+     */
+    void SkipIdleLoop(const DeviceState &state);
+
     /**
      * @brief Get priority of provided thread handle
      * @url https://switchbrew.org/wiki/SVC#GetThreadPriority
@@ -4,6 +4,7 @@
 #include <nce.h>
 #include <os.h>
 #include <common/trace.h>
+#include <common/settings.h>
 #include <kernel/results.h>
 #include "KProcess.h"
 
@@ -16,7 +17,10 @@ namespace skyline::kernel::type {
         return memory->guest.data() + (constant::TlsSlotSize * index++);
     }
 
-    KProcess::KProcess(const DeviceState &state) : memory(state), KSyncObject(state, KType::KProcess) {}
+    KProcess::KProcess(const DeviceState &state)
+        : memory(state),
+          KSyncObject(state, KType::KProcess),
+          profiler(*state.settings->guestProfiler ? std::make_unique<GuestProfiler>(state, *this) : nullptr) {}
 
     KProcess::~KProcess() {
         std::scoped_lock guard{threadMutex};
@@ -47,6 +51,44 @@ namespace skyline::kernel::type {
         }
     }
 
+    void KProcess::SuspendThreads() {
+        std::scoped_lock guard{threadMutex};
+        for (const auto &thread : threads) {
+            std::scoped_lock migrationLock{thread->coreMigrationMutex};
+            if (thread->running && !thread->isPaused) {
+                state.scheduler->PauseThread(thread);
+                suspendedThreads.push_back(thread);
+            }
+        }
+        Logger::Info("Suspended {} threads", suspendedThreads.size());
+    }
+
+    void KProcess::ResumeThreads() {
+        std::scoped_lock guard{threadMutex};
+        for (const auto &thread : suspendedThreads) {
+            std::scoped_lock migrationLock{thread->coreMigrationMutex};
+            if (thread->running && thread->isPaused)
+                state.scheduler->ResumeThread(thread);
+        }
+        if (!suspendedThreads.empty())
+            Logger::Info("Resumed {} threads", suspendedThreads.size());
+        suspendedThreads.clear();
+    }
+
+    std::vector<std::shared_ptr<KThread>> KProcess::GetThreads() {
+        std::scoped_lock guard{threadMutex};
+        return threads;
+    }
+
+    std::vector<std::pair<KHandle, KType>> KProcess::GetHandleTypes() {
+        std::shared_lock lock{handleMutex};
+        std::vector<std::pair<KHandle, KType>> handleTypes;
+        for (size_t index{}; index < handles.size(); index++)
+            if (handles[index])
+                handleTypes.emplace_back(GetHandleForIndex(index), handles[index]->objectType);
+        return handleTypes;
+    }
+
     void KProcess::InitializeHeapTls() {
         constexpr size_t DefaultHeapSize{0x200000};
         heap = std::make_shared<KPrivateMemory>(state, span<u8>{state.process->memory.heap.data(), DefaultHeapSize}, memory::Permission{true, true, false}, memory::states::Heap);
@@ -92,7 +134,7 @@ namespace skyline::kernel::type {
                     case type::KType::KTransferMemory: {
                         auto mem{std::static_pointer_cast<type::KMemory>(object)};
                         if (mem->guest.contains(ptr))
-                            return std::make_optional<KProcess::HandleOut<KMemory>>({mem, constant::BaseHandleIndex + index});
+                            return std::make_optional<KProcess::HandleOut<KMemory>>({mem, GetHandleForIndex(index)});
                     }
 
                     default:
@@ -104,8 +146,10 @@ namespace skyline::kernel::type {
     }
 
     void KProcess::ClearHandleTable() {
-        std::shared_lock lock(handleMutex);
+        std::unique_lock lock(handleMutex);
         handles.clear();
+        handleGenerations.clear();
+        freeHandleSlots.clear();
     }
 
     constexpr u32 HandleWaitersBit{1UL << 30}; //!< A bit which denotes if a mutex psuedo-handle has waiters or not
@@ -215,13 +259,55 @@ namespace skyline::kernel::type {
         }
     }
 
+    void KProcess::SyncWaiterBucket::Insert(void *key, KThread *thread) {
+        i8 priority{thread->priority.load()};
+        auto it{std::find_if(waiters.begin(), waiters.end(), [&](const SyncWaiter &waiter) { return waiter.key == key && waiter.thread->priority > priority; })};
+        waiters.insert(it, SyncWaiter{key, thread});
+    }
+
+    bool KProcess::SyncWaiterBucket::Remove(void *key, KThread *thread) {
+        auto it{std::find_if(waiters.begin(), waiters.end(), [&](const SyncWaiter &waiter) { return waiter.key == key && waiter.thread == thread; })};
+        if (it != waiters.end())
+            waiters.erase(it);
+        return !Count(key);
+    }
+
+    size_t KProcess::SyncWaiterBucket::Count(void *key) {
+        return static_cast<size_t>(std::count_if(waiters.begin(), waiters.end(), [&](const SyncWaiter &waiter) { return waiter.key == key; }));
+    }
+
+    bool KProcess::SyncWaiterBucket::Signal(void *key, i32 amount, const std::function<void(KThread *)> &function) {
+        i32 waiterCount{amount};
+        bool remaining{};
+        std::erase_if(waiters, [&](const SyncWaiter &waiter) {
+            if (waiter.key != key)
+                return false;
+
+            if (amount > 0 && !waiterCount) {
+                remaining = true;
+                return false;
+            }
+
+            function(waiter.thread);
+            waiterCount--;
+            return true;
+        });
+        return !remaining;
+    }
+
+    KProcess::SyncWaiterBucket &KProcess::GetSyncWaiterBucket(void *key) {
+        // Keys are at least word-aligned and commonly adjacent to each other, the low bits are discarded and the rest are mixed to spread them across buckets
+        auto address{reinterpret_cast<uintptr_t>(key) >> 2};
+        return syncWaiters[(address ^ (address >> 6) ^ (address >> 12)) & (SyncWaiterBucketCount - 1)];
+    }
+
     Result KProcess::ConditionalVariableWait(u32 *key, u32 *mutex, KHandle tag, i64 timeout) {
         TRACE_EVENT_FMT("kernel", "ConditionalVariableWait 0x{:X} (0x{:X})", key, mutex);
 
+        auto &bucket{GetSyncWaiterBucket(key)};
         {
-            std::scoped_lock lock{syncWaiterMutex};
-            auto queue{syncWaiters.equal_range(key)};
-            syncWaiters.insert(std::upper_bound(queue.first, queue.second, state.thread->priority.load(), [](const i8 priority, const SyncWaiters::value_type &it) { return it.second->priority > priority; }), {key, state.thread});
+            std::scoped_lock lock{bucket.mutex};
+            bucket.Insert(key, state.thread.get());
 
             __atomic_store_n(key, true, __ATOMIC_SEQ_CST); // We need to notify any userspace threads that there are waiters on this conditional variable by writing back a boolean flag denoting it
 
@@ -230,12 +316,9 @@ namespace skyline::kernel::type {
         }
 
         if (timeout > 0 && !state.scheduler->TimedWaitSchedule(std::chrono::nanoseconds(timeout))) {
-            std::unique_lock lock(syncWaiterMutex);
-            auto queue{syncWaiters.equal_range(key)};
-            auto iterator{std::find(queue.first, queue.second, SyncWaiters::value_type{key, state.thread})};
-            if (iterator != queue.second)
-                if (syncWaiters.erase(iterator) == queue.second)
-                    __atomic_store_n(key, false, __ATOMIC_SEQ_CST);
+            std::unique_lock lock(bucket.mutex);
+            if (bucket.Remove(key, state.thread.get()))
+                __atomic_store_n(key, false, __ATOMIC_SEQ_CST);
 
             lock.unlock();
             state.scheduler->InsertThread(state.thread);
@@ -259,22 +342,18 @@ namespace skyline::kernel::type {
     void KProcess::ConditionalVariableSignal(u32 *key, i32 amount) {
         TRACE_EVENT_FMT("kernel", "ConditionalVariableSignal 0x{:X}", key);
 
-        std::scoped_lock lock{syncWaiterMutex};
-        auto queue{syncWaiters.equal_range(key)};
-
-        auto it{queue.first};
-        for (i32 waiterCount{amount}; it != queue.second && (amount <= 0 || waiterCount); it = syncWaiters.erase(it), waiterCount--)
-            state.scheduler->InsertThread(it->second);
-
-        if (it == queue.second)
+        auto &bucket{GetSyncWaiterBucket(key)};
+        std::scoped_lock lock{bucket.mutex};
+        if (bucket.Signal(key, amount, [&](KThread *thread) { state.scheduler->InsertThread(thread->shared_from_this()); }))
             __atomic_store_n(key, false, __ATOMIC_SEQ_CST); // We need to update the boolean flag denoting that there are no more threads waiting on this conditional variable
     }
 
     Result KProcess::WaitForAddress(u32 *address, u32 value, i64 timeout, ArbitrationType type) {
         TRACE_EVENT_FMT("kernel", "WaitForAddress 0x{:X}", address);
 
+        auto &bucket{GetSyncWaiterBucket(address)};
         {
-            std::scoped_lock lock{syncWaiterMutex};
+            std::scoped_lock lock{bucket.mutex};
 
             switch (type) {
                 case ArbitrationType::WaitIfLessThan:
@@ -297,20 +376,16 @@ namespace skyline::kernel::type {
                     break;
             }
 
-            auto queue{syncWaiters.equal_range(address)};
-            syncWaiters.insert(std::upper_bound(queue.first, queue.second, state.thread->priority.load(), [](const i8 priority, const SyncWaiters::value_type &it) { return it.second->priority > priority; }), {address, state.thread});
+            bucket.Insert(address, state.thread.get());
 
             state.scheduler->RemoveThread();
         }
 
         if (timeout > 0 && !state.scheduler->TimedWaitSchedule(std::chrono::nanoseconds(timeout))) {
             {
-                std::scoped_lock lock{syncWaiterMutex};
-                auto queue{syncWaiters.equal_range(address)};
-                auto iterator{std::find(queue.first, queue.second, SyncWaiters::value_type{address, state.thread})};
-                if (iterator != queue.second)
-                    if (syncWaiters.erase(iterator) == queue.second)
-                        __atomic_store_n(address, false, __ATOMIC_SEQ_CST);
+                std::scoped_lock lock{bucket.mutex};
+                if (bucket.Remove(address, state.thread.get()))
+                    __atomic_store_n(address, false, __ATOMIC_SEQ_CST);
             }
 
             state.scheduler->InsertThread(state.thread);
@@ -327,22 +402,22 @@ namespace skyline::kernel::type {
     Result KProcess::SignalToAddress(u32 *address, u32 value, i32 amount, SignalType type) {
         TRACE_EVENT_FMT("kernel", "SignalToAddress 0x{:X}", address);
 
-        std::scoped_lock lock{syncWaiterMutex};
-        auto queue{syncWaiters.equal_range(address)};
+        auto &bucket{GetSyncWaiterBucket(address)};
+        std::scoped_lock lock{bucket.mutex};
 
         if (type != SignalType::Signal) {
             u32 newValue{value};
             if (type == SignalType::SignalAndIncrementIfEqual) {
                 newValue++;
             } else if (type == SignalType::SignalAndModifyBasedOnWaitingThreadCountIfEqual) {
+                auto waiterCount{static_cast<i32>(bucket.Count(address))};
                 if (amount <= 0) {
-                    if (queue.first != queue.second)
+                    if (waiterCount)
                         newValue -= 2;
                     else
                         newValue++;
                 } else {
-                    if (queue.first != queue.second) {
-                        i32 waiterCount{static_cast<i32>(std::distance(queue.first, queue.second))};
+                    if (waiterCount) {
                         if (waiterCount < amount)
                             newValue--;
                     } else {
@@ -355,10 +430,33 @@ namespace skyline::kernel::type {
                 return result::InvalidState;
         }
 
-        i32 waiterCount{amount};
-        for (auto it{queue.first}; it != queue.second && (amount <= 0 || waiterCount); it = syncWaiters.erase(it), waiterCount--)
-            state.scheduler->InsertThread(it->second);
+        bucket.Signal(address, amount, [&](KThread *thread) { state.scheduler->InsertThread(thread->shared_from_this()); });
 
         return {};
     }
+
+    std::string KProcess::GetThreadStatistics() {
+        auto toMs{[](auto duration) {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+        }};
+
+        std::string statistics{"Thread | Priority | Core | CPU (ms) | Schedule (ms) | SyncObject (ms) | Arbiter (ms) | IPC (ms) | Sleep (ms) | Migrations | PI Boosts | Oversleep (µs avg)\n"};
+        {
+            std::scoped_lock lock{threadMutex};
+            for (const auto &thread : threads) {
+                auto &stats{thread->statistics};
+                auto waitMs{[&](WaitReason reason) {
+                    return toMs(std::chrono::nanoseconds{stats.waitTimeNs[static_cast<size_t>(reason)].load(std::memory_order_relaxed)});
+                }};
+
+                auto timedWaits{stats.timedWaits.load(std::memory_order_relaxed)};
+                statistics += fmt::format("T{} | {}/{} | C{} | {} | {} | {} | {} | {} | {} | {} | {} | {}\n",
+                                          thread->id, thread->priority.load(), thread->basePriority.load(), thread->coreId, toMs(thread->GetCpuTime()),
+                                          waitMs(WaitReason::Schedule), waitMs(WaitReason::SyncObject), waitMs(WaitReason::Arbiter), waitMs(WaitReason::Ipc), waitMs(WaitReason::Sleep),
+                                          stats.migrations.load(std::memory_order_relaxed), stats.priorityBoosts.load(std::memory_order_relaxed),
+                                          timedWaits ? stats.oversleepNs.load(std::memory_order_relaxed) / timedWaits / constant::NsInMicrosecond : 0);
+            }
+        }
+        return statistics;
+    }
 }
@@ -4,6 +4,7 @@
 #pragma once
 
 #include <vfs/npdm.h>
+#include <kernel/guest_profiler.h>
 #include "KThread.h"
 #include "KTransferMemory.h"
 #include "KSession.h"
@@ -29,10 +30,55 @@ namespace skyline {
             bool disableThreadCreation{}; //!< Whether to disable thread creation, we use this to prevent thread creation after all threads have been killed
             std::atomic_bool alreadyKilled{}; //!< If the process has already been killed prior so there's no need to redundantly kill it again
             std::vector<std::shared_ptr<KThread>> threads;
+            std::vector<std::shared_ptr<KThread>> suspendedThreads; //!< The threads which were paused by SuspendThreads() and will be resumed by ResumeThreads()
 
-            using SyncWaiters = std::multimap<void *, std::shared_ptr<KThread>>;
-            std::mutex syncWaiterMutex; //!< Synchronizes all mutations to the map to prevent races
-            SyncWaiters syncWaiters; //!< All threads waiting on process-wide synchronization primitives (Atomic keys + Address Arbiter)
+            /**
+             * @brief A thread waiting on a process-wide synchronization primitive
+             * @note The thread is held as a raw pointer as it's guaranteed to be alive while it's waiting, this avoids refcounting on every wait
+             */
+            struct SyncWaiter {
+                void *key;
+                KThread *thread;
+            };
+
+            /**
+             * @brief A bucket of threads waiting on all keys which hash to the bucket, waiters on the same key are kept in priority order
+             */
+            struct SyncWaiterBucket {
+                std::mutex mutex; //!< Synchronizes all mutations to the waiters in this bucket
+                std::vector<SyncWaiter> waiters;
+
+                /**
+                 * @brief Inserts a waiter on the key after all waiters on the same key with an equal or higher priority
+                 */
+                void Insert(void *key, KThread *thread);
+
+                /**
+                 * @brief Removes the thread from the key's waiters if it's still waiting on it
+                 * @return If there are no more threads waiting on the key
+                 */
+                bool Remove(void *key, KThread *thread);
+
+                /**
+                 * @return The amount of threads waiting on the key
+                 */
+                size_t Count(void *key);
+
+                /**
+                 * @brief Removes up to the supplied amount of the highest priority waiters on the key and calls the supplied function with each of them
+                 * @param amount The maximum amount of waiters to remove, all waiters are removed if this is zero or negative
+                 * @return If there are no more threads waiting on the key
+                 */
+                bool Signal(void *key, i32 amount, const std::function<void(KThread *)> &function);
+            };
+
+            static constexpr size_t SyncWaiterBucketCount{64}; //!< The amount of buckets in the sync waiter table, this should be a power of two
+            std::array<SyncWaiterBucket, SyncWaiterBucketCount> syncWaiters; //!< A hash table of all threads waiting on process-wide synchronization primitives (Atomic keys + Address Arbiter), this is sharded to avoid contention between unrelated keys
+
+            /**
+             * @return The bucket of the sync waiter table that holds all waiters on the key
+             */
+            SyncWaiterBucket &GetSyncWaiterBucket(void *key);
 
             /**
             * @brief The status of a single TLS page (A page is 4096 bytes on ARMv8)
@@ -60,16 +106,75 @@ namespace skyline {
             std::shared_ptr<KPrivateMemory> mainThreadStack; //!< The stack memory of the main thread stack is owned by the KProcess itself
             std::shared_ptr<KPrivateMemory> heap;
             vfs::NPDM npdm;
+            std::unique_ptr<GuestProfiler> profiler; //!< The sampling profiler of the process's guest code, this only exists when it's enabled in the settings
 
           private:
+            /**
+             * @brief Handles are encoded with the index of their slot offset by the base handle index in the lower 16 bits and the generation of the slot in the bits above it
+             * @note Bit 30 and above are never set as they're used for the waiters bit of mutexes and to denote pseudo-handles
+             */
+            static constexpr u32 HandleGenerationShift{16};
+            static constexpr u32 HandleGenerationMask{0x3FFF};
+            static constexpr size_t MaxHandleCount{0x10000 - constant::BaseHandleIndex}; //!< The maximum amount of handle slots, this is bounded by the lower 16 bits of a handle
+
             std::shared_mutex handleMutex;
             std::vector<std::shared_ptr<KObject>> handles;
+            std::vector<u16> handleGenerations; //!< The generation of each handle slot, this is incremented when the slot is closed so stale handles to it are rejected
+            std::vector<u32> freeHandleSlots; //!< The indices of closed handle slots, these are reused before the table is grown
+
+            /**
+             * @return The index of the slot corresponding to the supplied handle, or std::nullopt if it's out of range or was created for a prior generation of the slot
+             * @note 'handleMutex' **must** be locked by the calling thread
+             */
+            std::optional<size_t> GetHandleIndex(KHandle handle) {
+                u32 lowerBits{handle & 0xFFFF};
+                if (lowerBits < constant::BaseHandleIndex)
+                    return std::nullopt;
+
+                size_t index{lowerBits - constant::BaseHandleIndex};
+                if (index >= handles.size() || ((handle >> HandleGenerationShift) != handleGenerations[index]))
+                    return std::nullopt;
+                return index;
+            }
+
+            /**
+             * @return The handle corresponding to the current generation of the supplied slot
+             * @note 'handleMutex' **must** be locked by the calling thread
+             */
+            KHandle GetHandleForIndex(size_t index) {
+                return static_cast<KHandle>((static_cast<u32>(handleGenerations[index]) << HandleGenerationShift) | (constant::BaseHandleIndex + index));
+            }
+
+            /**
+             * @brief Reserves a free handle slot, reusing a closed slot if possible
+             * @return The index of the reserved slot
+             * @note 'handleMutex' **must** be locked by the calling thread
+             */
+            size_t ReserveHandleSlot() {
+                if (!freeHandleSlots.empty()) {
+                    size_t index{freeHandleSlots.back()};
+                    freeHandleSlots.pop_back();
+                    return index;
+                }
+
+                if (handles.size() >= MaxHandleCount)
+                    throw exception("Exceeded the maximum amount of handles: {}", MaxHandleCount);
+
+                handles.emplace_back();
+                handleGenerations.emplace_back();
+                return handles.size() - 1;
+            }
 
           public:
             KProcess(const DeviceState &state);
 
             ~KProcess();
 
+            /**
+             * @return A table with the runtime statistics of every thread in the process, one row per thread
+             */
+            std::string GetThreadStatistics();
+
             /**
              * @brief Kill the main thread/all running threads in the process in a graceful manner
              * @param join Return after the main thread has joined rather than instantly
@@ -80,6 +185,27 @@ namespace skyline {
              */
             void Kill(bool join, bool all = false, bool disableCreation = false);
 
+            /**
+             * @brief Pauses all running threads in the process which haven't been paused by the guest itself, this parks the guest while the app is in the background
+             * @note This is a no-op for threads that are already paused, so it's safe to call repeatedly
+             */
+            void SuspendThreads();
+
+            /**
+             * @brief Resumes all threads which were paused by SuspendThreads()
+             */
+            void ResumeThreads();
+
+            /**
+             * @return A copy of the list of all threads in the process
+             */
+            std::vector<std::shared_ptr<KThread>> GetThreads();
+
+            /**
+             * @return The handle and type of every object in the handle table
+             */
+            std::vector<std::pair<KHandle, KType>> GetHandleTypes();
+
             /**
              * @brief This initializes the process heap and TLS Error Context slot pointer, it should be called prior to creating the first thread
              * @note This requires VMM regions to be initialized, it will map heap at an arbitrary location otherwise
@@ -116,13 +242,20 @@ namespace skyline {
             HandleOut<objectClass> NewHandle(objectArgs... args) {
                 std::unique_lock lock(handleMutex);
 
+                size_t index{ReserveHandleSlot()};
+                KHandle handle{GetHandleForIndex(index)};
                 std::shared_ptr<objectClass> item;
-                if constexpr (std::is_same<objectClass, KThread>())
-                    item = std::make_shared<objectClass>(state, constant::BaseHandleIndex + handles.size(), args...);
-                else
-                    item = std::make_shared<objectClass>(state, args...);
-                handles.push_back(std::static_pointer_cast<KObject>(item));
-                return {item, static_cast<KHandle>((constant::BaseHandleIndex + handles.size()) - 1)};
+                try {
+                    if constexpr (std::is_same<objectClass, KThread>())
+                        item = std::make_shared<objectClass>(state, handle, args...);
+                    else
+                        item = std::make_shared<objectClass>(state, args...);
+                } catch (...) {
+                    freeHandleSlots.push_back(static_cast<u32>(index));
+                    throw;
+                }
+                handles[index] = std::static_pointer_cast<KObject>(item);
+                return {item, handle};
             }
 
             /**
@@ -133,8 +266,9 @@ namespace skyline {
             KHandle InsertItem(std::shared_ptr<objectClass> &item) {
                 std::unique_lock lock(handleMutex);
 
-                handles.push_back(std::static_pointer_cast<KObject>(item));
-                return static_cast<KHandle>((constant::BaseHandleIndex + handles.size()) - 1);
+                size_t index{ReserveHandleSlot()};
+                handles[index] = std::static_pointer_cast<KObject>(item);
+                return GetHandleForIndex(index);
             }
 
             template<typename objectClass = KObject>
@@ -165,23 +299,27 @@ namespace skyline {
                 } else {
                     throw exception("KProcess::GetHandle couldn't determine object type");
                 }
-                try {
-                    auto &item{handles.at(handle - constant::BaseHandleIndex)};
-                    if (item != nullptr && item->objectType == objectType)
-                        return std::static_pointer_cast<objectClass>(item);
-                    else if (item == nullptr)
-                        throw exception("GetHandle was called with a deleted handle: 0x{:X}", handle);
-                    else
-                        throw exception("Tried to get kernel object (0x{:X}) with different type: {} when object is {}", handle, objectType, item->objectType);
-                } catch (const std::out_of_range &) {
+                auto index{GetHandleIndex(handle)};
+                if (!index)
                     throw std::out_of_range(fmt::format("GetHandle was called with an invalid handle: 0x{:X}", handle));
-                }
+
+                auto &item{handles[*index]};
+                if (item != nullptr && item->objectType == objectType)
+                    return std::static_pointer_cast<objectClass>(item);
+                else if (item == nullptr)
+                    throw exception("GetHandle was called with a deleted handle: 0x{:X}", handle);
+                else
+                    throw exception("Tried to get kernel object (0x{:X}) with different type: {} when object is {}", handle, objectType, item->objectType);
             }
 
             template<>
             std::shared_ptr<KObject> GetHandle<KObject>(KHandle handle) {
                 std::shared_lock lock(handleMutex);
-                auto &item{handles.at(handle - constant::BaseHandleIndex)};
+                auto index{GetHandleIndex(handle)};
+                if (!index)
+                    throw std::out_of_range(fmt::format("GetHandle was called with an invalid handle: 0x{:X}", handle));
+
+                auto &item{handles[*index]};
                 if (item != nullptr)
                     return item;
                 else
@@ -196,10 +334,21 @@ namespace skyline {
             std::optional<HandleOut<KMemory>> GetMemoryObject(u8 *ptr);
 
             /**
-             * @brief Closes a handle in the handle table
+             * @brief Closes a handle in the handle table, the slot is recycled for future handles with a new generation so the closed handle will stay invalid
              */
             void CloseHandle(KHandle handle) {
-                handles.at(handle - constant::BaseHandleIndex) = nullptr;
+                std::unique_lock lock(handleMutex);
+                auto index{GetHandleIndex(handle)};
+                if (!index)
+                    throw std::out_of_range(fmt::format("CloseHandle was called with an invalid handle: 0x{:X}", handle));
+
+                auto &item{handles[*index]};
+                if (!item)
+                    return;
+
+                item = nullptr;
+                handleGenerations[*index] = static_cast<u16>((handleGenerations[*index] + 1) & HandleGenerationMask);
+                freeHandleSlots.push_back(static_cast<u32>(*index));
             }
 
             /**
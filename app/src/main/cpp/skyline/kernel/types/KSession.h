@@ -16,8 +16,8 @@ namespace skyline::kernel::type {
     class KSession : public KSyncObject {
       public:
         std::shared_ptr<service::BaseService> serviceObject;
-        std::vector<std::shared_ptr<service::BaseService>> domains; //!< A vector of services that correspond to virtual handles
-        KHandle handleIndex{}; //!< The currently allocated handle index
+        std::vector<std::shared_ptr<service::BaseService>> domains; //!< A vector of services that correspond to virtual handles, the virtual handle of a service is its index in this vector
+        std::vector<KHandle> freeDomainHandles; //!< Virtual handles of closed domain objects, these are reused before any new ones are allocated
         bool isOpen{true}; //!< If the session is open or not
         bool isDomain{}; //!< If this is a domain session or not
 
@@ -33,8 +33,34 @@ namespace skyline::kernel::type {
          */
         KHandle ConvertDomain() {
             isDomain = true;
-            domains.push_back(serviceObject);
-            return handleIndex++;
+            return AddDomainObject(serviceObject);
+        }
+
+        /**
+         * @brief Adds a service to the domain, reusing the virtual handle of a closed object if there are any
+         * @return The virtual handle of the service in the domain
+         */
+        KHandle AddDomainObject(std::shared_ptr<service::BaseService> object) {
+            if (!freeDomainHandles.empty()) {
+                KHandle handle{freeDomainHandles.back()};
+                freeDomainHandles.pop_back();
+                domains[handle] = std::move(object);
+                return handle;
+            }
+
+            domains.push_back(std::move(object));
+            return static_cast<KHandle>(domains.size() - 1);
+        }
+
+        /**
+         * @brief Closes an object in the domain, its virtual handle will be reused for future objects
+         * @return The service corresponding to the virtual handle
+         */
+        std::shared_ptr<service::BaseService> CloseDomainObject(KHandle handle) {
+            auto object{std::exchange(domains.at(handle), nullptr)};
+            if (object)
+                freeDomainHandles.push_back(handle);
+            return object;
         }
     };
 }
@@ -22,6 +22,30 @@ namespace skyline::kernel::type {
         host = span<u8>{hostPtr, size};
     }
 
+    KSharedMemory::KSharedMemory(const DeviceState &state, span<u8> map, memory::Permission permission, memory::MemoryState memState, KType type)
+        : memoryState(memState),
+          KMemory(state, type, span<u8>{}) {
+        if (!util::IsPageAligned(map.data()) || !util::IsPageAligned(map.size()))
+            throw exception("KSharedMemory mapping isn't page-aligned: 0x{:X} - 0x{:X} (0x{:X})", map.data(), map.end().base(), map.size());
+
+        // The guest memory is borrowed in-place as it's already backed by the guest address space memfd, the mirror allows the host to access it regardless of the guest permissions
+        host = state.process->memory.CreateMirror(map);
+
+        if (mprotect(map.data(), map.size(), permission.Get()) == -1)
+            throw exception("An error occurred while updating borrowed memory's permissions in guest: {}", strerror(errno));
+        guest = map;
+
+        state.process->memory.InsertChunk(ChunkDescriptor{
+            .ptr = guest.data(),
+            .size = guest.size(),
+            .permission = permission,
+            .state = memoryState,
+            .attributes = memory::MemoryAttribute{
+                .isBorrowed = true,
+            },
+        });
+    }
+
     u8 *KSharedMemory::Map(span<u8> map, memory::Permission permission) {
         if (!state.process->memory.base.contains(map))
             throw exception("KPrivateMemory allocation isn't inside guest address space: 0x{:X} - 0x{:X}", map.data(), map.end().base());
@@ -102,14 +126,11 @@ namespace skyline::kernel::type {
                     .state = memory::states::Unmapped,
                 });
             } else {
-                // KTransferMemory remaps the region with R/W permissions during destruction
+                // KTransferMemory reprotects the region with R/W permissions during destruction, the contents don't need to be copied back as the guest mapping was borrowed in-place
                 constexpr memory::Permission UnborrowPermission{true, true, false};
 
-                if (mmap(guest.data(), guest.size(), UnborrowPermission.Get(), MAP_SHARED | MAP_FIXED, memoryManager.memoryFd, reinterpret_cast<off_t>(guest.data() - memoryManager.base.data())) == MAP_FAILED)
-                    Logger::Warn("An error occurred while remapping transfer memory: {}", strerror(errno));
-                else if (!host.valid())
-                    Logger::Warn("Expected host mapping of transfer memory to be valid during KTransferMemory destruction");
-                guest.copy_from(host);
+                if (mprotect(guest.data(), guest.size(), UnborrowPermission.Get()) == -1)
+                    Logger::Warn("An error occurred while reprotecting transfer memory: {}", strerror(errno));
 
                 state.process->memory.InsertChunk(ChunkDescriptor{
                     .ptr = guest.data(),
@@ -126,6 +147,7 @@ namespace skyline::kernel::type {
         if (host.valid())
             munmap(host.data(), host.size());
 
-        close(fd);
+        if (fd != -1)
+            close(fd);
     }
 }
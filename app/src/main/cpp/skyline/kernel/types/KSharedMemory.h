@@ -11,9 +11,16 @@ namespace skyline::kernel::type {
      */
     class KSharedMemory : public KMemory {
       private:
-        int fd; //!< A file descriptor to the underlying shared memory
+        int fd{-1}; //!< A file descriptor to the underlying shared memory, this is -1 if the memory is backed by the guest address space
         memory::MemoryState memoryState; //!< The state of the memory as supplied initially, this is retained for any mappings
 
+      protected:
+        /**
+         * @brief Creates shared memory from an existing mapping in the guest address space, the host mirror is a view of the same pages so no memory is copied
+         * @note 'map' **must** be page-aligned and inside the guest address space
+         */
+        KSharedMemory(const DeviceState &state, span<u8> map, memory::Permission permission, memory::MemoryState memState, KType type);
+
       public:
         span<u8> host; //!< We also keep a host mirror of the underlying shared memory for host access, it is persistently mapped and should be used by anything accessing the memory on the host
 
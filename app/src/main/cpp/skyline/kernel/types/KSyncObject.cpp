@@ -9,6 +9,7 @@ namespace skyline::kernel::type {
         std::scoped_lock lock{syncObjectMutex};
         signalled = true;
         for (auto &waiter : syncObjectWaiters) {
+            std::scoped_lock waiterLock{waiter->syncWaitMutex};
             if (waiter->isCancellable) {
                 waiter->isCancellable = false;
                 waiter->wakeObject = this;
@@ -12,7 +12,7 @@ namespace skyline::kernel::type {
      */
     class KSyncObject : public KObject {
       public:
-        inline static std::mutex syncObjectMutex; //!< A global lock used for locking all signalling to avoid races
+        std::mutex syncObjectMutex; //!< Synchronizes the signalled state and waiters of this object, this must be locked prior to KThread::syncWaitMutex of any waiter
         std::list<std::shared_ptr<KThread>> syncObjectWaiters; //!< A list of threads waiting on this object to be signalled
         bool signalled; //!< If the current object is signalled (An object stays signalled till the signal has been explicitly reset)
 
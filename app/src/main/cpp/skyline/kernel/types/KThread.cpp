@@ -3,8 +3,11 @@
 
 #include <cxxabi.h>
 #include <unistd.h>
+#include <sys/prctl.h>
 #include <common/signal.h>
+#include <common/perf_stats.h>
 #include <common/trace.h>
+#include <kernel/guest_profiler.h>
 #include <nce.h>
 #include <os.h>
 #include "KProcess.h"
@@ -28,13 +31,9 @@ namespace skyline::kernel::type {
 
     KThread::~KThread() {
         Kill(true);
-        if (thread.joinable())
-            thread.join();
-        if (preemptionTimer)
-            timer_delete(preemptionTimer);
     }
 
-    void KThread::StartThread() {
+    void KThread::StartThread(bool pooled) {
         pthread = pthread_self();
         std::array<char, 16> threadName{};
         if (int result{pthread_getname_np(pthread, threadName.data(), threadName.size())})
@@ -72,16 +71,19 @@ namespace skyline::kernel::type {
             return;
         }
 
-        struct sigevent event{
-            .sigev_signo = Scheduler::PreemptionSignal,
-            .sigev_notify = SIGEV_THREAD_ID,
-            .sigev_notify_thread_id = gettid(),
-        };
-        if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &preemptionTimer))
-            throw exception("timer_create has failed with '{}'", strerror(errno));
+        if (int result{pthread_getcpuclockid(pthread, &cpuClock)})
+            throw exception("pthread_getcpuclockid has failed with '{}'", strerror(result));
 
-        signal::SetSignalHandler({SIGINT, SIGILL, SIGTRAP, SIGBUS, SIGFPE, SIGSEGV}, nce::NCE::SignalHandler);
-        signal::SetSignalHandler({Scheduler::YieldSignal, Scheduler::PreemptionSignal}, Scheduler::SignalHandler, false); // We want futexes to fail and their predicates rechecked
+        // The default timer slack of 50µs (or more for background threads) is added to every sleep and timeout of the thread, guest timeouts are expected to be far more precise than that
+        if (prctl(PR_SET_TIMERSLACK, 1UL, 0UL, 0UL, 0UL))
+            Logger::Warn("Failed to set the timer slack: {}", strerror(errno));
+
+        if (!pooled) {
+            // Host threads from the pool have the same signal handlers installed once when they're created, see HostThreadPool::HostThread
+            signal::SetSignalHandler({SIGINT, SIGILL, SIGTRAP, SIGBUS, SIGFPE, SIGSEGV}, nce::NCE::SignalHandler);
+            signal::SetSignalHandler({Scheduler::YieldSignal, Scheduler::PreemptionSignal}, Scheduler::SignalHandler, false); // We want futexes to fail and their predicates rechecked
+            signal::SetSignalHandler({GuestProfiler::SampleSignal}, GuestProfiler::SignalHandler);
+        }
 
         {
             std::scoped_lock lock{statusMutex};
@@ -218,9 +220,16 @@ namespace skyline::kernel::type {
             statusCondition.notify_all();
             if (self) {
                 lock.unlock();
-                StartThread();
+                StartThread(false);
             } else {
-                thread = std::thread(&KThread::StartThread, this);
+                state.scheduler->hostThreadPool.Run([thread = shared_from_this()]() {
+                    thread->StartThread(true);
+
+                    // The host thread is reused for other guest threads, any thread-local state referring to this thread must be cleared
+                    DeviceState::thread = nullptr;
+                    DeviceState::ctx = nullptr;
+                    Scheduler::YieldPending = false;
+                });
             }
         }
     }
@@ -246,15 +255,17 @@ namespace skyline::kernel::type {
             pthread_kill(pthread, signal);
     }
 
+    void KThread::TrySendSignal(int signal) {
+        std::scoped_lock lock(statusMutex);
+        if (ready && !killed && running)
+            pthread_kill(pthread, signal);
+    }
+
     void KThread::ArmPreemptionTimer(std::chrono::nanoseconds timeToFire) {
         std::unique_lock lock(statusMutex);
         statusCondition.wait(lock, [this]() { return ready || killed; });
         if (!killed && running) {
-            struct itimerspec spec{.it_value = {
-                .tv_nsec = std::min(static_cast<i64>(timeToFire.count()), constant::NsInSecond),
-                .tv_sec = std::max(std::chrono::duration_cast<std::chrono::seconds>(timeToFire).count() - 1, 0LL),
-            }};
-            timer_settime(preemptionTimer, 0, &spec, nullptr);
+            state.scheduler->ArmPreemptionTimer(coreId, this, pthread, cpuClock, timeToFire);
             isPreempted = true;
         }
     }
@@ -266,12 +277,25 @@ namespace skyline::kernel::type {
         std::unique_lock lock(statusMutex);
         statusCondition.wait(lock, [this]() { return ready || killed; });
         if (!killed && running) {
-            struct itimerspec spec{};
-            timer_settime(preemptionTimer, 0, &spec, nullptr);
+            state.scheduler->DisarmPreemptionTimer(this);
             isPreempted = false;
         }
     }
 
+    std::chrono::nanoseconds KThread::GetCpuTime() {
+        timespec time{};
+        if (!running || !cpuClock || clock_gettime(cpuClock, &time))
+            return {};
+        return std::chrono::seconds{time.tv_sec} + std::chrono::nanoseconds{time.tv_nsec};
+    }
+
+    void KThread::RecordOversleep(i64 oversleepNs) {
+        auto oversleep{static_cast<u64>(std::max<i64>(oversleepNs, 0))};
+        statistics.timedWaits.fetch_add(1, std::memory_order_relaxed);
+        statistics.oversleepNs.fetch_add(oversleep, std::memory_order_relaxed);
+        PerfStats::Record(PerfStats::Histogram::Oversleep, oversleep / constant::NsInMicrosecond);
+    }
+
     void KThread::UpdatePriorityInheritance() {
         std::unique_lock lock{waiterMutex};
 
@@ -330,6 +354,7 @@ namespace skyline::kernel::type {
                     piWaiters.insert(std::upper_bound(piWaiters.begin(), piWaiters.end(), currentPriority, KThread::IsHigherPriority), waitingOn);
                     break;
                 }
+                waitingOn->statistics.priorityBoosts.fetch_add(1, std::memory_order_relaxed);
                 state.scheduler->UpdatePriority(waitingOn);
                 waitingOn = nextThread;
             } else {
@@ -7,27 +7,52 @@
 #include <nce/guest.h>
 #include <kernel/scheduler.h>
 #include <common/signal.h>
+#include <common/futex_condition.h>
 #include "KSyncObject.h"
 #include "KPrivateMemory.h"
 #include "KSharedMemory.h"
 
 namespace skyline {
     namespace kernel::type {
+        /**
+         * @brief The reasons a guest thread can be waiting for, these are used to account for where the time of a thread goes
+         */
+        enum class WaitReason : u8 {
+            Schedule, //!< Waiting for its resident core while runnable, this includes being preempted and yielding
+            SyncObject, //!< Waiting on synchronization objects in svcWaitSynchronization
+            Arbiter, //!< Waiting on a mutex, condition variable or the address arbiter
+            Ipc, //!< Waiting on the handling of an IPC request
+            Sleep, //!< Sleeping in svcSleepThread
+
+            Count, //!< The amount of wait reasons, this isn't a reason itself
+        };
+
+        /**
+         * @brief Runtime statistics of a single thread, these can be read from any thread while they're being updated
+         */
+        struct ThreadStatistics {
+            std::array<std::atomic<u64>, static_cast<size_t>(WaitReason::Count)> waitTimeNs{}; //!< The amount of time spent waiting for every reason in nanoseconds
+            std::atomic<u64> migrations{}; //!< The amount of times the thread was moved to a different core
+            std::atomic<u64> priorityBoosts{}; //!< The amount of times the priority of the thread was raised by priority-inheritance
+            std::atomic<u64> timedWaits{}; //!< The amount of sleeps and timed waits which ran until their deadline
+            std::atomic<u64> oversleepNs{}; //!< The total amount of time that sleeps and timed waits overshot their deadline by in nanoseconds
+        };
+
         /**
          * @brief KThread manages a single thread of execution which is responsible for running guest code and kernel code which is invoked by the guest
          */
         class KThread : public KSyncObject, public std::enable_shared_from_this<KThread> {
           private:
             KProcess *parent;
-            std::thread thread; //!< If this KThread is backed by a host thread then this'll hold it
             pthread_t pthread{}; //!< The pthread_t for the host thread running this guest thread
-            timer_t preemptionTimer{}; //!< A kernel timer used for preemption interrupts
+            clockid_t cpuClock{}; //!< The CPU-time clock of the host thread, the scheduler's preemption thread polls this to determine if the thread has overrun its timeslice
 
             /**
              * @brief Entry function any guest threads, sets up necessary context and jumps into guest code from the calling thread
-             * @note This function also serves as the entry point for host threads created in StartThread
+             * @param pooled If the calling thread is a host thread from the scheduler's HostThreadPool, the signal handlers are installed by the pool then
+             * @note This function also serves as the entry point of guest threads on host threads from the scheduler's HostThreadPool
              */
-            void StartThread();
+            void StartThread(bool pooled);
 
           public:
             std::mutex statusMutex; //!< Synchronizes all thread state changes (running/ready/killed)
@@ -46,7 +71,7 @@ namespace skyline {
             u64 entryArgument; //!< An argument to provide with to the thread entry function
             void *stackTop; //!< The top of the guest's stack, this is set to the initial guest stack pointer
 
-            std::condition_variable scheduleCondition; //!< Signalled to wake the thread when it's scheduled or its resident core changes
+            FutexCondition scheduleCondition; //!< Signalled to wake the thread when it's scheduled or its resident core changes, this is a futex with an adaptive spin as it's on the critical path of every guest context switch
             std::atomic<i8> basePriority; //!< The priority of the thread for the scheduler without any priority-inheritance
             std::atomic<i8> priority; //!< The priority of the thread for the scheduler including priority-inheritance
 
@@ -68,10 +93,16 @@ namespace skyline {
             std::shared_ptr<KThread> waitThread; //!< The thread which this thread is waiting on
             std::list<std::shared_ptr<type::KThread>> waiters; //!< A queue of threads waiting on this thread sorted by priority
 
+            std::mutex syncWaitMutex; //!< Synchronizes isCancellable, cancelSync and wakeObject between a wait and any signals or cancellations of it
             bool isCancellable{false}; //!< If the thread is currently in a position where it's cancellable
             bool cancelSync{false}; //!< Whether to cancel the SvcWaitSynchronization call this thread currently is in/the next one it joins
             type::KSyncObject *wakeObject{}; //!< A pointer to the synchronization object responsible for waking this thread up
 
+            ThreadStatistics statistics;
+            std::atomic<u64> sampledPc{}; //!< The guest PC the thread was interrupted at by the last sample of the GuestProfiler, 0 if it hasn't been sampled in guest code since this was last read
+            std::atomic<ucontext *> guestContext{}; //!< The signal context holding the live guest registers of the thread while it's waiting to be scheduled after being yielded in guest code, registers written to this are restored when the thread resumes
+            bool inAccountedWait{}; //!< If the thread is currently in a wait which is being accounted for, nested waits are accounted to the outermost wait, this is only accessed by the thread itself
+
             bool isPaused{false}; //!< If the thread is currently paused and not runnable
             bool insertThreadOnResume{false}; //!< If the thread should be inserted into the scheduler when it resumes (used for pausing threads during sleep/sync)
 
@@ -80,7 +111,7 @@ namespace skyline {
             ~KThread();
 
             /**
-             * @param self If the calling thread should jump directly into guest code or if a new thread should be created for it
+             * @param self If the calling thread should jump directly into guest code or if it should be run on a pooled host thread
              * @note If the thread is already running then this does nothing
              * @note 'stack' will be created if it wasn't set prior to calling this
              */
@@ -97,15 +128,31 @@ namespace skyline {
             void SendSignal(int signal);
 
             /**
-             * @brief Arms the preemption kernel timer to fire in the specified amount of time
+             * @brief Sends a host OS signal to the thread which is running this KThread if it's ready to receive signals, unlike SendSignal this doesn't wait for it to become ready
+             */
+            void TrySendSignal(int signal);
+
+            /**
+             * @brief Arms the preemption timer on the thread's resident core to fire after the thread has run for the specified amount of CPU time
+             * @note This doesn't involve any syscalls, the timer is polled by the scheduler's preemption thread
              */
             void ArmPreemptionTimer(std::chrono::nanoseconds timeToFire);
 
             /**
-             * @brief Disarms the preemption kernel timer, any scheduled firings will be cancelled
+             * @brief Disarms the preemption timer, any scheduled firings will be cancelled
              */
             void DisarmPreemptionTimer();
 
+            /**
+             * @return The amount of CPU time the host thread backing this thread has used, this is 0 if it isn't running
+             */
+            std::chrono::nanoseconds GetCpuTime();
+
+            /**
+             * @brief Accounts the amount of time a sleep or timed wait of this thread has overshot its deadline by
+             */
+            void RecordOversleep(i64 oversleepNs);
+
             /**
              * @brief Recursively updates the priority for any threads this thread might be waiting on
              * @note PI is performed by temporarily upgrading a thread's priority if a thread waiting on it has a higher priority to prevent priority inversion
@@ -120,5 +167,31 @@ namespace skyline {
                 return priority < it->priority;
             }
         };
+
+        /**
+         * @brief An RAII wrapper which accounts the time spent in its scope to a wait reason of the current thread
+         * @note If the thread is already in an accounted wait then this does nothing, so the time is only accounted once
+         */
+        class ScopedWaitAccounting {
+          private:
+            KThread &thread;
+            WaitReason reason;
+            i64 start{};
+
+          public:
+            ScopedWaitAccounting(KThread &thread, WaitReason reason) : thread{thread}, reason{reason} {
+                if (!thread.inAccountedWait) {
+                    thread.inAccountedWait = true;
+                    start = util::GetTimeNs();
+                }
+            }
+
+            ~ScopedWaitAccounting() {
+                if (start) {
+                    thread.statistics.waitTimeNs[static_cast<size_t>(reason)].fetch_add(static_cast<u64>(util::GetTimeNs() - start), std::memory_order_relaxed);
+                    thread.inAccountedWait = false;
+                }
+            }
+        };
     }
 }
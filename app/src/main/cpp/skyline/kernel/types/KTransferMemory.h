@@ -16,9 +16,6 @@ namespace skyline::kernel::type {
          * @note 'ptr' needs to be in guest-reserved address space
          */
         KTransferMemory(const DeviceState &state, u8 *ptr, size_t size, memory::Permission permission, memory::MemoryState memState = memory::states::TransferMemory)
-            : KSharedMemory(state, size, memState, KType::KTransferMemory) {
-            std::memcpy(host.data(), ptr, size);
-            Map(span<u8>{ptr, size}, permission);
-        }
+            : KSharedMemory(state, span<u8>{ptr, size}, permission, memState, KType::KTransferMemory) {}
     };
 }
@@ -30,5 +30,7 @@ namespace skyline::loader {
 
         RelativeSegment dynsym; //!< The .dynsym segment relative to .rodata
         RelativeSegment dynstr; //!< The .dynstr segment relative to .rodata
+
+        std::array<u64, 4> buildId{}; //!< The build ID of the executable, this is zeroed if it doesn't have one
     };
 }
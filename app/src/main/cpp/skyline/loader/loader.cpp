@@ -1,15 +1,161 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <charconv>
 #include <dlfcn.h>
 #include <cxxabi.h>
+#include <common/emulation_speed.h>
+#include <common/settings.h>
 #include <nce.h>
 #include <os.h>
 #include <kernel/types/KProcess.h>
 #include <kernel/memory.h>
+#include <vfs/os_filesystem.h>
 #include "loader.h"
 
 namespace skyline::loader {
+    /**
+     * @brief The header of a cached set of patch offsets for a single executable
+     * @note All fields other than the patch size and the offset count must match for the cache to be used
+     */
+    struct PatchCacheHeader {
+        static constexpr u32 Version{3}; //!< This must be incremented whenever the instructions that are patched or the size of their trampolines change
+
+        u32 magic{util::MakeMagic<u32>("SKPC")};
+        u32 version{Version};
+        u64 frequency; //!< The host counter frequency, this determines which counter reads are patched and how large their trampolines are
+        u64 speedControl; //!< If emulation speed control is enabled, this has the same effect on patching as the frequency
+        u64 idleLoopDetection; //!< If counter reads are patched with idle loop detection, this determines which counter reads are patched and how large their trampolines are
+        u64 textSize;
+        u64 textHash; //!< A hash of the .text segment, this guards against executables with a reused or zeroed build ID
+        u64 patchSize; //!< The size of the .patch section
+        u64 offsetCount; //!< The amount of offsets following the header
+
+        bool IsCompatible(const PatchCacheHeader &other) const {
+            return magic == other.magic && version == other.version && frequency == other.frequency && speedControl == other.speedControl && idleLoopDetection == other.idleLoopDetection && textSize == other.textSize && textHash == other.textHash;
+        }
+    };
+
+    /**
+     * @return If idle loop detection should be patched into the executables of the process, this is the case unless it's disabled globally or the title is in the list of exclusions
+     */
+    static bool IsIdleLoopDetectionEnabled(const DeviceState &state, const kernel::type::KProcess &process) {
+        if (!*state.settings->idleLoopSkipping)
+            return false;
+
+        u64 titleId{process.npdm.aci0.programId};
+        std::string_view exclusions{*state.settings->idleLoopSkippingExclusions};
+        while (!exclusions.empty()) {
+            auto separator{exclusions.find(',')};
+            auto entry{exclusions.substr(0, separator)};
+            exclusions = separator == std::string_view::npos ? std::string_view{} : exclusions.substr(separator + 1);
+
+            while (!entry.empty() && std::isspace(static_cast<unsigned char>(entry.front())))
+                entry.remove_prefix(1);
+            while (!entry.empty() && std::isspace(static_cast<unsigned char>(entry.back())))
+                entry.remove_suffix(1);
+
+            u64 excludedId{};
+            if (std::from_chars(entry.data(), entry.data() + entry.size(), excludedId, 16).ec == std::errc{} && excludedId == titleId) {
+                Logger::Debug("Idle loop skipping is disabled for {:016X}", titleId);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Retrieves the patch data for an executable from the on-disk patch cache if it's present and valid, otherwise it's generated and written to the cache
+     * @note The cache is keyed by build ID so executables without one are always scanned
+     */
+    static nce::NCE::PatchData GetCachedPatchData(const DeviceState &state, const Executable &executable, bool idleLoopDetection) {
+        if (executable.buildId == decltype(executable.buildId){})
+            return state.nce->GetPatchData(executable.text.contents, idleLoopDetection);
+
+        u64 frequency;
+        asm("MRS %0, CNTFRQ_EL0" : "=r"(frequency));
+        PatchCacheHeader expectedHeader{
+            .frequency = frequency,
+            .speedControl = emulation_speed::IsEnabled(),
+            .idleLoopDetection = idleLoopDetection,
+            .textSize = executable.text.contents.size(),
+            .textHash = XXH64(executable.text.contents.data(), executable.text.contents.size(), 0),
+        };
+
+        std::optional<vfs::OsFileSystem> filesystem;
+        auto path{fmt::format("{:016X}{:016X}{:016X}{:016X}.bin", executable.buildId[0], executable.buildId[1], executable.buildId[2], executable.buildId[3])};
+        try {
+            filesystem.emplace(state.os->publicAppFilesPath + "patch_cache/");
+            if (filesystem->FileExists(path)) {
+                auto backing{filesystem->OpenFile(path)};
+                if (backing->size >= sizeof(PatchCacheHeader)) {
+                    auto header{backing->Read<PatchCacheHeader>()};
+                    if (header.IsCompatible(expectedHeader) && backing->size == sizeof(PatchCacheHeader) + header.offsetCount * sizeof(size_t)) {
+                        std::vector<size_t> offsets(header.offsetCount);
+                        backing->Read(span<size_t>(offsets), sizeof(PatchCacheHeader));
+                        Logger::Debug("Loaded {} patch offsets from the patch cache", offsets.size());
+                        return {header.patchSize, std::move(offsets)};
+                    }
+                }
+                Logger::Info("Discarding incompatible patch cache entry");
+            }
+        } catch (const std::exception &e) {
+            Logger::Warn("Failed to read from patch cache: {}", e.what());
+            filesystem.reset();
+        }
+
+        auto patch{state.nce->GetPatchData(executable.text.contents, idleLoopDetection)};
+        if (!filesystem)
+            return patch;
+
+        try {
+            expectedHeader.patchSize = patch.size;
+            expectedHeader.offsetCount = patch.offsets.size();
+
+            size_t size{sizeof(PatchCacheHeader) + patch.offsets.size() * sizeof(size_t)};
+            if (!filesystem->CreateFile(path, size)) // This truncates any existing incompatible entry to the new size
+                throw exception("Failed to create patch cache file");
+
+            auto backing{filesystem->OpenFile(path, {true, true, false})};
+            backing->WriteObject(expectedHeader);
+            backing->Write(span<size_t>(patch.offsets).cast<u8>(), sizeof(PatchCacheHeader));
+        } catch (const std::exception &e) {
+            Logger::Warn("Failed to write to patch cache: {}", e.what());
+        }
+
+        return patch;
+    }
+
+    /**
+     * @return The exported functions of the executable which have a host counterpart that they can be replaced with
+     */
+    static std::vector<nce::NCE::HostFunctionPatch> GetHostFunctionPatches(const Executable &executable) {
+        auto &ro{executable.ro.contents};
+        if (executable.dynsym.offset + executable.dynsym.size > ro.size() || executable.dynstr.offset + executable.dynstr.size > ro.size())
+            return {};
+
+        span<const Elf64_Sym> symbols{reinterpret_cast<const Elf64_Sym *>(ro.data() + executable.dynsym.offset), executable.dynsym.size / sizeof(Elf64_Sym)};
+        span<const char> symbolStrings{reinterpret_cast<const char *>(ro.data() + executable.dynstr.offset), executable.dynstr.size};
+
+        std::vector<nce::NCE::HostFunctionPatch> patches;
+        for (const auto &symbol : symbols) {
+            // Imported symbols are undefined in this executable, they're replaced in the executable that exports them
+            if (ELF64_ST_TYPE(symbol.st_info) != STT_FUNC || symbol.st_shndx == SHN_UNDEF || symbol.st_size < nce::NCE::HostFunctionPatchSize || !symbol.st_name || symbol.st_name >= symbolStrings.size())
+                continue;
+
+            if (symbol.st_value < executable.text.offset || symbol.st_value - executable.text.offset + symbol.st_size > executable.text.contents.size())
+                continue;
+
+            std::string_view name{symbolStrings.data() + symbol.st_name, strnlen(symbolStrings.data() + symbol.st_name, symbolStrings.size() - symbol.st_name)};
+            if (auto function{nce::NCE::GetHostFunction(name)}) {
+                Logger::Debug("Replacing guest function '{}' with its host counterpart", name);
+                patches.push_back({symbol.st_value - executable.text.offset, function});
+            }
+        }
+
+        return patches;
+    }
+
     Loader::ExecutableLoadInfo Loader::LoadExecutable(const std::shared_ptr<kernel::type::KProcess> &process, const DeviceState &state, Executable &executable, size_t offset, const std::string &name) {
         u8 *base{reinterpret_cast<u8 *>(process->memory.base.data() + offset)};
 
@@ -23,7 +169,8 @@ namespace skyline::loader {
         if (!util::IsPageAligned(executable.text.offset) || !util::IsPageAligned(executable.ro.offset) || !util::IsPageAligned(executable.data.offset))
             throw exception("LoadProcessData: Section offsets are not aligned with page size: 0x{:X}, 0x{:X}, 0x{:X}", executable.text.offset, executable.ro.offset, executable.data.offset);
 
-        auto patch{state.nce->GetPatchData(executable.text.contents)};
+        bool idleLoopDetection{IsIdleLoopDetectionEnabled(state, *process)};
+        auto patch{GetCachedPatchData(state, executable, idleLoopDetection)};
         auto size{patch.size + textSize + roSize + dataSize};
 
         process->NewHandle<kernel::type::KPrivateMemory>(span<u8>{base, patch.size}, memory::Permission{false, false, false}, memory::states::Reserved); // ---
@@ -38,7 +185,11 @@ namespace skyline::loader {
         process->NewHandle<kernel::type::KPrivateMemory>(span<u8>{base + patch.size + executable.data.offset, dataSize}, memory::Permission{true, true, false}, memory::states::CodeMutable); // RW-
         Logger::Debug("Successfully mapped section .data + .bss @ 0x{:X}, Size = 0x{:X}", base + patch.size + executable.data.offset, dataSize);
 
-        state.nce->PatchCode(executable.text.contents, reinterpret_cast<u32 *>(base), patch.size, patch.offsets);
+        std::vector<nce::NCE::HostFunctionPatch> hostFunctions;
+        if (*state.settings->hostMemoryFunctions)
+            hostFunctions = GetHostFunctionPatches(executable);
+
+        state.nce->PatchCode(executable.text.contents, reinterpret_cast<u32 *>(base), patch.size, patch.offsets, idleLoopDetection, hostFunctions);
         std::memcpy(base + patch.size + executable.text.offset, executable.text.contents.data(), textSize);
         std::memcpy(base + patch.size + executable.ro.offset, executable.ro.contents.data(), roSize);
         std::memcpy(base + patch.size + executable.data.offset, executable.data.contents.data(), dataSize - executable.bssSize);
@@ -65,12 +216,12 @@ namespace skyline::loader {
                 auto offset{reinterpret_cast<u8 *>(ptr) - reinterpret_cast<u8 *>(executable->programStart)};
                 auto symbol{std::find_if(executable->symbols.begin(), executable->symbols.end(), [&offset](const Elf64_Sym &sym) { return sym.st_value <= offset && sym.st_value + sym.st_size > offset; })};
                 if (symbol != executable->symbols.end() && symbol->st_name && symbol->st_name < executable->symbolStrings.size()) {
-                    return {executable->symbolStrings.data() + symbol->st_name, executable->name};
+                    return {executable->symbolStrings.data() + symbol->st_name, executable->name, static_cast<size_t>(offset)};
                 } else {
-                    return {.executableName = executable->name};
+                    return {.executableName = executable->name, .offset = static_cast<size_t>(offset)};
                 }
             } else {
-                return {.executableName = executable->patchName};
+                return {.executableName = executable->patchName, .offset = static_cast<size_t>(reinterpret_cast<u8 *>(ptr) - reinterpret_cast<u8 *>(executable->patchStart))};
             }
         }
         return {};
@@ -102,6 +102,7 @@ namespace skyline::loader {
         struct SymbolInfo {
             char *name; //!< The name of the symbol that was found
             std::string_view executableName; //!< The executable that contained the symbol
+            size_t offset{}; //!< The offset of the address from the start of the executable or patch section that contained it
         };
 
         /**
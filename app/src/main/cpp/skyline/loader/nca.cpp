@@ -7,7 +7,7 @@
 #include "nca.h"
 
 namespace skyline::loader {
-    NcaLoader::NcaLoader(std::shared_ptr<vfs::Backing> backing, std::shared_ptr<crypto::KeyStore> keyStore) : nca(std::move(backing), std::move(keyStore)) {
+    NcaLoader::NcaLoader(std::shared_ptr<vfs::Backing> backing, std::shared_ptr<crypto::KeyStore> keyStore, bool verifyIntegrity) : nca(std::move(backing), std::move(keyStore), false, verifyIntegrity) {
         if (nca.exeFs == nullptr)
             throw exception("Only NCAs with an ExeFS can be loaded directly");
     }
@@ -19,24 +19,26 @@ namespace skyline::loader {
         if (!exeFs->FileExists("rtld"))
             throw exception("Cannot load an ExeFS that doesn't contain rtld");
 
-        auto nsoFile{exeFs->OpenFile("rtld")};
+        // The segments of all NSOs are decompressed in parallel, they're loaded in order as each NSO is placed directly after the previous one
+        ThreadPool pool{"Sky-NsoLoad", std::clamp(std::thread::hardware_concurrency(), 1U, 8U)};
+        std::vector<std::pair<std::string, NsoLoader::PendingNso>> nsos;
+        nsos.emplace_back("rtld", NsoLoader::ReadNsoAsync(pool, exeFs->OpenFile("rtld"), state));
+        for (const auto &nso : {"main", "subsdk0", "subsdk1", "subsdk2", "subsdk3", "subsdk4", "subsdk5", "subsdk6", "subsdk7", "sdk"})
+            if (exeFs->FileExists(nso))
+                nsos.emplace_back(nso, NsoLoader::ReadNsoAsync(pool, exeFs->OpenFile(nso), state));
 
         state.process->memory.InitializeVmm(process->npdm.meta.flags.type);
 
-        auto loadInfo{NsoLoader::LoadNso(loader, nsoFile, process, state, 0, "rtld.nso")};
-        u64 offset{loadInfo.size};
-        u8 *base{loadInfo.base};
-        void *entry{loadInfo.entry};
-
-        Logger::Info("Loaded 'rtld.nso' at 0x{:X} (.text @ 0x{:X})", base, entry);
-
-        for (const auto &nso : {"main", "subsdk0", "subsdk1", "subsdk2", "subsdk3", "subsdk4", "subsdk5", "subsdk6", "subsdk7", "sdk"}) {
-            if (exeFs->FileExists(nso))
-                nsoFile = exeFs->OpenFile(nso);
-            else
-                continue;
+        u64 offset{};
+        u8 *base{};
+        void *entry{};
+        for (auto &[nso, pendingNso] : nsos) {
+            auto loadInfo{NsoLoader::LoadNso(loader, std::move(pendingNso), process, state, offset, nso + ".nso")};
+            if (!base) {
+                base = loadInfo.base;
+                entry = loadInfo.entry;
+            }
 
-            loadInfo = NsoLoader::LoadNso(loader, nsoFile, process, state, offset, nso + std::string(".nso"));
             Logger::Info("Loaded '{}.nso' at 0x{:X} (.text @ 0x{:X})", nso, base + offset, loadInfo.entry);
             offset += loadInfo.size;
         }
@@ -3,10 +3,28 @@
 
 #include <lz4.h>
 #include <nce.h>
+#include <os.h>
+#include <common/settings.h>
 #include <kernel/types/KProcess.h>
+#include <vfs/os_filesystem.h>
 #include "nso.h"
 
 namespace skyline::loader {
+    /**
+     * @brief The header of an entry in the executable cache, this is followed by a copy of the NSO header and the decompressed .text, .rodata and .data segments
+     * @note The copy of the NSO header contains the hashes of all decompressed segments, an entry is only used if it matches the header of the NSO being loaded exactly
+     */
+    struct ExecutableCacheHeader {
+        static constexpr u32 Version{1}; //!< This must be incremented whenever the layout of the entries changes
+
+        u32 magic{util::MakeMagic<u32>("SKEC")};
+        u32 version{Version};
+    };
+
+    static std::string GetCacheEntryPath(const std::array<u64, 4> &buildId) {
+        return fmt::format("{:016X}{:016X}{:016X}{:016X}.bin", buildId[0], buildId[1], buildId[2], buildId[3]);
+    }
+
     NsoLoader::NsoLoader(std::shared_ptr<vfs::Backing> pBacking) : backing(std::move(pBacking)) {
         u32 magic{backing->Read<u32>()};
 
@@ -21,7 +39,9 @@ namespace skyline::loader {
             std::vector<u8> compressedBuffer(compressedSize);
             backing->Read(compressedBuffer, segment.fileOffset);
 
-            LZ4_decompress_safe(reinterpret_cast<char *>(compressedBuffer.data()), reinterpret_cast<char *>(outputBuffer.data()), static_cast<int>(compressedSize), static_cast<int>(segment.decompressedSize));
+            auto decompressedSize{LZ4_decompress_safe(reinterpret_cast<char *>(compressedBuffer.data()), reinterpret_cast<char *>(outputBuffer.data()), static_cast<int>(compressedSize), static_cast<int>(segment.decompressedSize))};
+            if (decompressedSize != static_cast<int>(segment.decompressedSize))
+                throw exception("Failed to decompress NSO segment: {}/{}", decompressedSize, segment.decompressedSize);
         } else {
             backing->Read(outputBuffer, segment.fileOffset);
         }
@@ -29,33 +49,156 @@ namespace skyline::loader {
         return outputBuffer;
     }
 
-    Loader::ExecutableLoadInfo NsoLoader::LoadNso(Loader *loader, const std::shared_ptr<vfs::Backing> &backing, const std::shared_ptr<kernel::type::KProcess> &process, const DeviceState &state, size_t offset, const std::string &name) {
-        auto header{backing->Read<NsoHeader>()};
+    std::shared_ptr<vfs::Backing> NsoLoader::OpenCacheEntry(const DeviceState &state, const NsoHeader &header) {
+        try {
+            vfs::OsFileSystem filesystem{state.os->publicAppFilesPath + "executable_cache/"};
+            auto path{GetCacheEntryPath(header.buildId)};
+            if (!filesystem.FileExists(path))
+                return nullptr;
+
+            auto entry{filesystem.OpenFile(path)};
+            size_t expectedSize{sizeof(ExecutableCacheHeader) + sizeof(NsoHeader) + header.text.decompressedSize + header.ro.decompressedSize + header.data.decompressedSize};
+            if (entry->size == expectedSize) {
+                auto cacheHeader{entry->Read<ExecutableCacheHeader>()};
+                auto nsoHeader{entry->Read<NsoHeader>(sizeof(ExecutableCacheHeader))};
+                if (cacheHeader.magic == ExecutableCacheHeader{}.magic && cacheHeader.version == ExecutableCacheHeader::Version && std::memcmp(&nsoHeader, &header, sizeof(NsoHeader)) == 0)
+                    return entry;
+            }
+
+            Logger::Info("Discarding incompatible executable cache entry");
+        } catch (const std::exception &e) {
+            Logger::Warn("Failed to read from executable cache: {}", e.what());
+        }
+        return nullptr;
+    }
 
-        if (header.magic != util::MakeMagic<u32>("NSO0"))
-            throw exception("Invalid NSO magic! 0x{0:X}", header.magic);
+    NsoLoader::NsoSegments NsoLoader::ReadCacheEntry(vfs::Backing &entry, const NsoHeader &header) {
+        NsoSegments segments{
+            .text = std::vector<u8>(header.text.decompressedSize),
+            .ro = std::vector<u8>(header.ro.decompressedSize),
+            .data = std::vector<u8>(header.data.decompressedSize),
+        };
+
+        size_t offset{sizeof(ExecutableCacheHeader) + sizeof(NsoHeader)};
+        for (auto segment : {&segments.text, &segments.ro, &segments.data}) {
+            entry.Read(*segment, offset);
+            offset += segment->size();
+        }
 
+        return segments;
+    }
+
+    void NsoLoader::WriteCacheEntry(const DeviceState &state, const NsoHeader &header, const NsoSegments &segments) {
+        try {
+            vfs::OsFileSystem filesystem{state.os->publicAppFilesPath + "executable_cache/"};
+            auto path{GetCacheEntryPath(header.buildId)};
+            size_t size{sizeof(ExecutableCacheHeader) + sizeof(NsoHeader) + segments.text.size() + segments.ro.size() + segments.data.size()};
+            if (!filesystem.CreateFile(path, size)) // This truncates any existing incompatible entry to the new size
+                throw exception("Failed to create executable cache file");
+
+            auto entry{filesystem.OpenFile(path, {true, true, false})};
+            size_t offset{sizeof(ExecutableCacheHeader) + sizeof(NsoHeader)};
+            for (auto segment : {&segments.text, &segments.ro, &segments.data}) {
+                entry->Write(span<u8>{const_cast<u8 *>(segment->data()), segment->size()}, offset);
+                offset += segment->size();
+            }
+
+            // The headers are written last so an entry that was only partially written is never considered valid
+            entry->WriteObject(header, sizeof(ExecutableCacheHeader));
+            entry->WriteObject(ExecutableCacheHeader{});
+        } catch (const std::exception &e) {
+            Logger::Warn("Failed to write to executable cache: {}", e.what());
+        }
+    }
+
+    Executable NsoLoader::MakeExecutable(const NsoHeader &header, NsoSegments segments) {
         Executable executable{};
 
-        executable.text.contents = GetSegment(backing, header.text, header.flags.textCompressed ? header.textCompressedSize : 0);
+        executable.text.contents = std::move(segments.text);
         executable.text.contents.resize(util::AlignUp(executable.text.contents.size(), constant::PageSize));
         executable.text.offset = header.text.memoryOffset;
 
-        executable.ro.contents = GetSegment(backing, header.ro, header.flags.roCompressed ? header.roCompressedSize : 0);
+        executable.ro.contents = std::move(segments.ro);
         executable.ro.contents.resize(util::AlignUp(executable.ro.contents.size(), constant::PageSize));
         executable.ro.offset = header.ro.memoryOffset;
 
-        executable.data.contents = GetSegment(backing, header.data, header.flags.dataCompressed ? header.dataCompressedSize : 0);
+        executable.data.contents = std::move(segments.data);
         executable.data.offset = header.data.memoryOffset;
 
         // Data and BSS are aligned together
         executable.bssSize = util::AlignUp(executable.data.contents.size() + header.bssSize, constant::PageSize) - executable.data.contents.size();
+        executable.buildId = header.buildId;
 
         if (header.dynsym.offset + header.dynsym.size <= header.ro.decompressedSize && header.dynstr.offset + header.dynstr.size <= header.ro.decompressedSize) {
             executable.dynsym = {header.dynsym.offset, header.dynsym.size};
             executable.dynstr = {header.dynstr.offset, header.dynstr.size};
         }
 
+        return executable;
+    }
+
+    Loader::ExecutableLoadInfo NsoLoader::LoadNso(Loader *loader, const std::shared_ptr<vfs::Backing> &backing, const std::shared_ptr<kernel::type::KProcess> &process, const DeviceState &state, size_t offset, const std::string &name) {
+        auto header{backing->Read<NsoHeader>()};
+
+        if (header.magic != util::MakeMagic<u32>("NSO0"))
+            throw exception("Invalid NSO magic! 0x{0:X}", header.magic);
+
+        auto executable{MakeExecutable(header, NsoSegments{
+            .text = GetSegment(backing, header.text, header.flags.textCompressed ? header.textCompressedSize : 0),
+            .ro = GetSegment(backing, header.ro, header.flags.roCompressed ? header.roCompressedSize : 0),
+            .data = GetSegment(backing, header.data, header.flags.dataCompressed ? header.dataCompressedSize : 0),
+        })};
+        return loader->LoadExecutable(process, state, executable, offset, name);
+    }
+
+    NsoLoader::PendingNso NsoLoader::ReadNsoAsync(ThreadPool &pool, const std::shared_ptr<vfs::Backing> &backing, const DeviceState &state) {
+        auto header{backing->Read<NsoHeader>()};
+
+        if (header.magic != util::MakeMagic<u32>("NSO0"))
+            throw exception("Invalid NSO magic! 0x{0:X}", header.magic);
+
+        // The cache is keyed by build ID so executables without one are always decompressed
+        bool useCache{*state.settings->executableCache && header.buildId != decltype(header.buildId){}};
+        if (useCache) {
+            if (auto entry{OpenCacheEntry(state, header)}) {
+                Logger::Debug("Loading NSO segments from the executable cache");
+                return PendingNso{
+                    .header = header,
+                    .segments = pool.Submit([entry = std::move(entry), header] {
+                        return ReadCacheEntry(*entry, header);
+                    }),
+                };
+            }
+        }
+
+        auto submitSegment{[&](const NsoSegmentHeader &segment, bool compressed, u32 compressedSize) {
+            return pool.Submit([backing, segment, compressedSize = compressed ? compressedSize : 0] {
+                return GetSegment(backing, segment, compressedSize);
+            });
+        }};
+
+        auto text{submitSegment(header.text, header.flags.textCompressed, header.textCompressedSize)};
+        auto ro{submitSegment(header.ro, header.flags.roCompressed, header.roCompressedSize)};
+        auto data{submitSegment(header.data, header.flags.dataCompressed, header.dataCompressedSize)};
+
+        // The segments are gathered on the pool so the cache entry can be written without blocking loading, this can't deadlock as the segment tasks are always dequeued before it
+        return PendingNso{
+            .header = header,
+            .segments = pool.Submit([text = std::move(text), ro = std::move(ro), data = std::move(data), useCache, header, &state]() mutable {
+                NsoSegments segments{
+                    .text = text.get(),
+                    .ro = ro.get(),
+                    .data = data.get(),
+                };
+                if (useCache)
+                    WriteCacheEntry(state, header, segments);
+                return segments;
+            }),
+        };
+    }
+
+    Loader::ExecutableLoadInfo NsoLoader::LoadNso(Loader *loader, PendingNso &&nso, const std::shared_ptr<kernel::type::KProcess> &process, const DeviceState &state, size_t offset, const std::string &name) {
+        auto executable{MakeExecutable(nso.header, nso.segments.get())};
         return loader->LoadExecutable(process, state, executable, offset, name);
     }
 
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <common/thread_pool.h>
 #include "loader.h"
 
 namespace skyline::loader {
@@ -78,8 +79,55 @@ namespace skyline::loader {
         static std::vector<u8> GetSegment(const std::shared_ptr<vfs::Backing> &backing, const NsoSegmentHeader &segment, u32 compressedSize);
 
       public:
+        /**
+         * @brief The decompressed contents of all segments of an NSO
+         */
+        struct NsoSegments {
+            std::vector<u8> text;
+            std::vector<u8> ro;
+            std::vector<u8> data;
+        };
+
+        /**
+         * @brief An NSO which has its segments being read and decompressed asynchronously
+         */
+        struct PendingNso {
+            NsoHeader header;
+            std::future<NsoSegments> segments;
+        };
+
+      private:
+        /**
+         * @brief Creates an executable from the header of an NSO and the contents of its segments
+         */
+        static Executable MakeExecutable(const NsoHeader &header, NsoSegments segments);
+
+        /**
+         * @return A backing for the executable cache entry of an NSO if one exists with an identical header, nullptr otherwise
+         */
+        static std::shared_ptr<vfs::Backing> OpenCacheEntry(const DeviceState &state, const NsoHeader &header);
+
+        /**
+         * @return The decompressed segments read from an executable cache entry opened by OpenCacheEntry
+         */
+        static NsoSegments ReadCacheEntry(vfs::Backing &entry, const NsoHeader &header);
+
+        /**
+         * @brief Writes the decompressed segments of an NSO to the executable cache, this replaces any existing entry for its build ID
+         */
+        static void WriteCacheEntry(const DeviceState &state, const NsoHeader &header, const NsoSegments &segments);
+
+      public:
+
         NsoLoader(std::shared_ptr<vfs::Backing> backing);
 
+        /**
+         * @brief Reads the header of an NSO and submits reading and decompressing each of its segments to the supplied pool
+         * @note This allows the segments of multiple NSOs to be decompressed in parallel while they still have to be loaded in order as their placement depends on the size of all prior NSOs
+         * @note If the executable cache is enabled, the segments are read from it when it has an entry with an identical NSO header and the entry is written otherwise
+         */
+        static PendingNso ReadNsoAsync(ThreadPool &pool, const std::shared_ptr<vfs::Backing> &backing, const DeviceState &state);
+
         /**
          * @brief Loads an NSO into memory, offset by the given amount
          * @param backing The backing that the NSO is contained within
@@ -89,6 +137,12 @@ namespace skyline::loader {
          */
         static ExecutableLoadInfo LoadNso(Loader *loader, const std::shared_ptr<vfs::Backing> &backing, const std::shared_ptr<kernel::type::KProcess> &process, const DeviceState &state, size_t offset = 0, const std::string &name = {});
 
+        /**
+         * @brief Loads an NSO that was read by ReadNsoAsync into memory, offset by the given amount
+         * @note This blocks till all segments of the NSO have been decompressed
+         */
+        static ExecutableLoadInfo LoadNso(Loader *loader, PendingNso &&nso, const std::shared_ptr<kernel::type::KProcess> &process, const DeviceState &state, size_t offset = 0, const std::string &name = {});
+
         void *LoadProcessData(const std::shared_ptr<kernel::type::KProcess> &process, const DeviceState &state) override;
     };
 }
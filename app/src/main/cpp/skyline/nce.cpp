@@ -2,9 +2,12 @@
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
 #include <cxxabi.h>
+#include <dlfcn.h>
 #include <unistd.h>
 #include "common/signal.h"
 #include "common/trace.h"
+#include "common/perf_stats.h"
+#include "common/emulation_speed.h"
 #include "os.h"
 #include "jvm.h"
 #include "kernel/types/KProcess.h"
@@ -20,15 +23,22 @@ namespace skyline::nce {
         return killAllThreads ? "ExitProcess" : "ExitThread";
     }
 
+    constexpr u16 IdleLoopSvcId{0x80}; // A pseudo-SVC ID past the end of the SVC table, counter reads invoke this once they've detected an idle loop
+
     void NCE::SvcHandler(u16 svcId, ThreadContext *ctx) {
         TRACE_EVENT_END("guest");
 
         const auto &state{*ctx->state};
-        auto svc{kernel::svc::SvcTable[svcId]};
+        auto svc{svcId < kernel::svc::SvcTable.size() ? kernel::svc::SvcTable[svcId] : kernel::svc::SvcDescriptor{}};
+        ctx->idleLoopCount = 0; // Any SVC breaks the streak of counter reads in an idle loop
+        PerfStats::Increment(PerfStats::Counter::SvcCalls);
         try {
             if (svc) [[likely]] {
                 TRACE_EVENT("kernel", perfetto::StaticString{svc.name});
                 (svc.function)(state);
+            } else if (svcId == IdleLoopSvcId) {
+                TRACE_EVENT("kernel", "SkipIdleLoop");
+                kernel::svc::SkipIdleLoop(state);
             } else {
                 throw exception("Unimplemented SVC 0x{:X}", svcId);
             }
@@ -202,51 +212,179 @@ namespace skyline::nce {
     constexpr u32 CntpctEl0{0x5F01};        // ID of CNTPCT_EL0 in MRS
     constexpr u32 CntvctEl0{0x5F02};        // ID of CNTVCT_EL0 in MRS
     constexpr u32 TegraX1Freq{19200000};    // The clock frequency of the Tegra X1 (19.2 MHz)
+    constexpr u16 GetSystemTickSvc{0x1E};   // ID of svcGetSystemTick, this is inlined as it only reads the counter and can never reschedule
+    constexpr u32 StrPreIndexSp{0xF81F0FE0}; // STR X0, [SP, #-16]!
+    constexpr u32 LdrPostIndexSp{0xF84107E0}; // LDR X0, [SP], #16
+    constexpr u32 MrsTpidrEl0{0xD53BD040};  // MRS X0, TPIDR_EL0
+    constexpr u32 LdrTpidrroEl0{0xF9415800}; // LDR X0, [X0, #0x2B0] (ThreadContext::tpidrroEl0)
+    constexpr u32 LdrTpidrEl0{0xF9415C00};  // LDR X0, [X0, #0x2B8] (ThreadContext::tpidrEl0)
+    constexpr u32 StrTpidrEl0{0xF9015C00};  // STR X0, [X0, #0x2B8] (ThreadContext::tpidrEl0)
+    constexpr u32 StpPreIndexSp{0xA9BF03E0}; // STP X0, X0, [SP, #-16]!
+    constexpr u32 LdpPostIndexSp{0xA8C103E0}; // LDP X0, X0, [SP], #16
+    constexpr u32 LdrBase{0xF9400000};      // LDR X0, [X0]
+    constexpr u32 LdpBase{0xA9400000};      // LDP X0, X0, [X0]
+    constexpr u32 Mul{0x9B007C00};          // MUL X0, X0, X0
+    constexpr u32 Extr32{0x93C08000};       // EXTR X0, X0, X0, #32
+    constexpr u32 Add{0x8B000000};          // ADD X0, X0, X0
+    constexpr u32 Sub{0xCB000000};          // SUB X0, X0, X0
+    constexpr u32 AddOne{0x91000400};       // ADD X0, X0, #1
+    constexpr u32 AdrSelf{0x10000000};      // ADR X0, #0
+    constexpr u32 Cbnz{0xB5000000};         // CBNZ X0, #0
+    constexpr u32 Tbnz{0x37000000};         // TBNZ W0, #0, #0
+    constexpr u32 LdrIdleLoopSite{0xF9416800};  // LDR X0, [X0, #0x2D0] (ThreadContext::idleLoopSite)
+    constexpr u32 StrIdleLoopSite{0xF9016800};  // STR X0, [X0, #0x2D0] (ThreadContext::idleLoopSite)
+    constexpr u32 LdrIdleLoopCount{0xF9416C00}; // LDR X0, [X0, #0x2D8] (ThreadContext::idleLoopCount)
+    constexpr u32 StrIdleLoopCount{0xF9016C00}; // STR X0, [X0, #0x2D8] (ThreadContext::idleLoopCount)
+    constexpr u32 LdrIdleLoopTick{0xF9417000};  // LDR X0, [X0, #0x2E0] (ThreadContext::idleLoopTick)
+    constexpr u32 StrIdleLoopTick{0xF9017000};  // STR X0, [X0, #0x2E0] (ThreadContext::idleLoopTick)
+    static_assert(offsetof(ThreadContext, idleLoopSite) == 0x2D0 && offsetof(ThreadContext, idleLoopCount) == 0x2D8 && offsetof(ThreadContext, idleLoopTick) == 0x2E0);
+    constexpr u32 LsrImmediate{0xD340FC00};     // LSR X0, X0, #0
+    constexpr u8 IdleLoopThresholdBit{12}; // The bit of the idle loop count which triggers skipping the loop once it's set, a thread is considered to be idle after 4096 consecutive counter reads from the same site without an SVC
+    constexpr u64 IdleLoopReadIntervalUs{2}; // The maximum interval between consecutive counter reads for them to count towards an idle loop, a loop doing any real work between reads takes longer than this
+    constexpr size_t IdleLoopCheckSize{33}; // The amount of instructions prepended to a counter read trampoline body for idle loop detection
+
+    /**
+     * @return An instruction with its destination register (Rt/Rd) and, optionally, its base register (Rn) replaced
+     */
+    static constexpr u32 WithRegisters(u32 instruction, u8 destReg, u8 baseReg = 0) {
+        return instruction | destReg | (static_cast<u32>(baseReg) << 5);
+    }
 
-    NCE::PatchData NCE::GetPatchData(const std::vector<u8> &text) {
-        size_t size{guest::SaveCtxSize + guest::LoadCtxSize + MainSvcTrampolineSize};
-        std::vector<size_t> offsets;
+    /**
+     * @return An instruction with its destination register (Rt/Rd), first source or base register (Rn) and second source register (Rt2 for pairs, Rm otherwise) replaced
+     */
+    static constexpr u32 WithRegisters(u32 instruction, u8 destReg, u8 baseReg, u8 secondReg, bool pair) {
+        return WithRegisters(instruction, destReg, baseReg) | (static_cast<u32>(secondReg) << (pair ? 10 : 16));
+    }
 
-        u64 frequency;
-        asm("MRS %0, CNTFRQ_EL0" : "=r"(frequency));
-        bool rescaleClock{frequency != TegraX1Freq};
+    /**
+     * @return A 0.64 fixed-point multiplier which converts host ticks into Tegra X1 ticks with an UMULH, 0 if the host counter is slower than the Tegra X1 and this isn't possible
+     */
+    static u64 GetClockRescaleMultiplier(u64 frequency) {
+        if (frequency <= TegraX1Freq)
+            return 0;
+        return static_cast<u64>((static_cast<__uint128_t>(TegraX1Freq) << 64) / frequency);
+    }
 
-        auto start{reinterpret_cast<const u32 *>(text.data())}, end{reinterpret_cast<const u32 *>(text.data() + text.size())};
-        for (const u32 *instruction{start}; instruction < end; instruction++) {
+    /**
+     * @return The amount of instructions required to materialize the supplied value with MOVZ/MOVK
+     */
+    static size_t GetMoveRegisterSize(u64 value) {
+        size_t size{};
+        for (auto mov : instructions::MoveRegister(registers::X0, value))
+            if (mov)
+                size++;
+        return size;
+    }
+
+    constexpr size_t ScaledCounterReadSize{15}; //!< The amount of instructions in a counter read trampoline body that scales the counter with the current emulation_speed::ClockScale, the address of the ClockScale pointer is always materialized with 4 instructions so this doesn't vary with ASLR
+
+    /**
+     * @brief Scans a range of instructions for any that need to be patched
+     * @param counterReadSize The size of a counter read trampoline, 0 if counter reads are patched inline
+     * @param size The size of the trampolines required by the patched instructions in u32 units is added to this
+     * @param offsets The offsets of patched instructions relative to textStart are appended to this in ascending order
+     */
+    static void ScanPatchRange(const u32 *textStart, const u32 *rangeStart, const u32 *rangeEnd, bool rescaleClock, size_t counterReadSize, size_t &size, std::vector<size_t> &offsets) {
+        for (const u32 *instruction{rangeStart}; instruction < rangeEnd; instruction++) {
             auto svc{*reinterpret_cast<const instructions::Svc *>(instruction)};
             auto mrs{*reinterpret_cast<const instructions::Mrs *>(instruction)};
             auto msr{*reinterpret_cast<const instructions::Msr *>(instruction)};
-            auto instructionOffset{static_cast<size_t>(instruction - start)};
+            auto instructionOffset{static_cast<size_t>(instruction - textStart)};
 
             if (svc.Verify()) {
-                size += 7;
+                if (svc.value == GetSystemTickSvc)
+                    size += counterReadSize;
+                else
+                    size += 7;
                 offsets.push_back(instructionOffset);
             } else if (mrs.Verify()) {
                 if (mrs.srcReg == TpidrroEl0 || mrs.srcReg == TpidrEl0) {
-                    size += ((mrs.destReg != registers::X0) ? 6 : 3);
+                    size += 3;
+                    offsets.push_back(instructionOffset);
+                } else if (mrs.srcReg == CntpctEl0) {
+                    size += counterReadSize;
+                    offsets.push_back(instructionOffset);
+                } else if (rescaleClock && mrs.srcReg == CntfrqEl0) {
+                    size += 3;
                     offsets.push_back(instructionOffset);
-                } else {
-                    if (rescaleClock) {
-                        if (mrs.srcReg == CntpctEl0) {
-                            size += guest::RescaleClockSize + 3;
-                            offsets.push_back(instructionOffset);
-                        } else if (mrs.srcReg == CntfrqEl0) {
-                            size += 3;
-                            offsets.push_back(instructionOffset);
-                        }
-                    } else if (mrs.srcReg == CntpctEl0) {
-                        offsets.push_back(instructionOffset);
-                    }
                 }
             } else if (msr.Verify() && msr.destReg == TpidrEl0) {
-                size += 6;
+                size += 5;
                 offsets.push_back(instructionOffset);
             }
         }
-        return {util::AlignUp(size * sizeof(u32), constant::PageSize), offsets};
     }
 
-    void NCE::PatchCode(std::vector<u8> &text, u32 *patch, size_t patchSize, const std::vector<size_t> &offsets) {
+    constexpr size_t MinPatchScanChunkSize{0x100000}; // The minimum amount of instructions scanned by a single thread, it isn't worth spawning threads for anything smaller
+
+    NCE::PatchData NCE::GetPatchData(const std::vector<u8> &text, bool idleLoopDetection) {
+        TRACE_EVENT("host", "NCE::GetPatchData");
+
+        size_t size{guest::SaveCtxSize + guest::LoadCtxSize + MainSvcTrampolineSize};
+        std::vector<size_t> offsets;
+
+        u64 frequency;
+        asm("MRS %0, CNTFRQ_EL0" : "=r"(frequency));
+        bool speedControl{emulation_speed::IsEnabled()}; // The counter must always be scaled with speed control as the speed can change at runtime
+        bool rescaleClock{frequency != TegraX1Freq || speedControl};
+        u64 rescaleMultiplier{GetClockRescaleMultiplier(frequency)};
+        size_t rescaleSize{speedControl ? (ScaledCounterReadSize + 1) : rescaleMultiplier ? (GetMoveRegisterSize(rescaleMultiplier) + 5) : (guest::RescaleClockSize + 3)}; // The size of a rescaled counter read trampoline
+        size_t counterReadSize{rescaleClock ? rescaleSize : idleLoopDetection ? 2 : 0}; // Without rescaling, counter reads only need a trampoline for idle loop detection where it's an MRS and a branch back
+        if (idleLoopDetection)
+            counterReadSize += IdleLoopCheckSize;
+
+        auto start{reinterpret_cast<const u32 *>(text.data())}, end{reinterpret_cast<const u32 *>(text.data() + text.size())};
+        size_t instructionCount{static_cast<size_t>(end - start)};
+        size_t chunkCount{std::clamp<size_t>(instructionCount / MinPatchScanChunkSize, 1, std::max(std::thread::hardware_concurrency(), 1U))};
+        if (chunkCount == 1) {
+            ScanPatchRange(start, start, end, rescaleClock, counterReadSize, size, offsets);
+        } else {
+            // Large executables are split into contiguous chunks that are scanned in parallel, the results are concatenated in order so the offsets remain sorted
+            struct ChunkResult {
+                size_t size{};
+                std::vector<size_t> offsets;
+            };
+            std::vector<ChunkResult> results(chunkCount);
+            std::vector<std::thread> threads;
+            threads.reserve(chunkCount - 1);
+
+            size_t chunkSize{util::DivideCeil(instructionCount, chunkCount)};
+            auto scanChunk{[&](size_t index) {
+                auto chunkStart{start + std::min(index * chunkSize, instructionCount)}, chunkEnd{start + std::min((index + 1) * chunkSize, instructionCount)};
+                ScanPatchRange(start, chunkStart, chunkEnd, rescaleClock, counterReadSize, results[index].size, results[index].offsets);
+            }};
+
+            for (size_t index{1}; index < chunkCount; index++)
+                threads.emplace_back(scanChunk, index);
+            scanChunk(0);
+            for (auto &thread : threads)
+                thread.join();
+
+            size_t offsetCount{};
+            for (const auto &result : results)
+                offsetCount += result.offsets.size();
+            offsets.reserve(offsetCount);
+
+            for (const auto &result : results) {
+                size += result.size;
+                offsets.insert(offsets.end(), result.offsets.begin(), result.offsets.end());
+            }
+        }
+
+        return {util::AlignUp(size * sizeof(u32), constant::PageSize), std::move(offsets)};
+    }
+
+    void *NCE::GetHostFunction(std::string_view name) {
+        // These are implemented in assembly by bionic without touching TLS or the stack beyond their own frame, they can run directly on a guest thread
+        constexpr std::array<std::string_view, 4> HostFunctions{"memcpy", "memmove", "memset", "strlen"};
+        if (std::find(HostFunctions.begin(), HostFunctions.end(), name) == HostFunctions.end())
+            return nullptr;
+
+        return dlsym(RTLD_DEFAULT, std::string{name}.c_str());
+    }
+
+    void NCE::PatchCode(std::vector<u8> &text, u32 *patch, size_t patchSize, const std::vector<size_t> &offsets, bool idleLoopDetection, span<const HostFunctionPatch> hostFunctions) {
         u32 *start{patch};
         u32 *end{patch + (patchSize / sizeof(u32))};
 
@@ -292,7 +430,138 @@ namespace skyline::nce {
 
         u64 frequency;
         asm("MRS %0, CNTFRQ_EL0" : "=r"(frequency));
-        bool rescaleClock{frequency != TegraX1Freq};
+        bool speedControl{emulation_speed::IsEnabled()};
+        bool rescaleClock{frequency != TegraX1Freq || speedControl};
+        u64 rescaleMultiplier{GetClockRescaleMultiplier(frequency)};
+        u8 idleLoopIntervalShift{static_cast<u8>(std::bit_width((frequency * IdleLoopReadIntervalUs) / (constant::NsInSecond / constant::NsInMicrosecond)))}; // Counter deltas are compared against the read interval rounded up to a power of two so the check is a shift
+
+        /**
+         * @brief Writes a trampoline body which reads the host counter rescaled to the Tegra X1 frequency into the supplied register
+         * @note This only touches the destination register and a single spilled scratch register, the counter is rescaled with a fixed-point UMULH when possible rather than a division
+         * @note With speed control, the counter is instead scaled by the current ClockScale which is loaded through a pointer that's swapped on speed changes, this requires three spilled scratch registers for the 128-bit product
+         */
+        auto writeRescaledCounterRead{[&](u8 destReg) {
+            if (speedControl) {
+                std::array<u8, 3> scratch{};
+                for (u8 reg{}, index{}; index < scratch.size(); reg++)
+                    if (reg != destReg)
+                        scratch[index++] = reg;
+                auto [pointerReg, multiplierReg, productReg]{scratch};
+
+                *patch++ = WithRegisters(StpPreIndexSp, pointerReg, 0, multiplierReg, true);
+                *patch++ = WithRegisters(StrPreIndexSp, productReg);
+                u64 address{emulation_speed::GetClockScaleAddress()};
+                *patch++ = instructions::Movz(registers::X(pointerReg), static_cast<u16>(address), 0).raw;
+                for (u8 shift{1}; shift < 4; shift++)
+                    *patch++ = instructions::Movk(registers::X(pointerReg), static_cast<u16>(address >> (shift * 16)), shift).raw;
+                *patch++ = WithRegisters(LdrBase, pointerReg, pointerReg); // The ClockScale pointer
+                *patch++ = WithRegisters(LdpBase, multiplierReg, pointerReg, pointerReg, true); // The multiplier and the offset, the offset overwrites the pointer
+                *patch++ = instructions::Mrs(CntvctEl0, registers::X(destReg)).raw;
+                *patch++ = WithRegisters(Mul, productReg, destReg, multiplierReg, false);
+                *patch++ = instructions::Umulh(registers::X(destReg), registers::X(destReg), registers::X(multiplierReg)).raw;
+                *patch++ = WithRegisters(Extr32, destReg, destReg, productReg, false); // Bits 32-95 of the 128-bit product
+                *patch++ = WithRegisters(Add, destReg, destReg, pointerReg, false);
+                *patch++ = WithRegisters(LdrPostIndexSp, productReg);
+                *patch++ = WithRegisters(LdpPostIndexSp, pointerReg, 0, multiplierReg, true);
+            } else if (rescaleMultiplier) {
+                u8 scratchReg{static_cast<u8>(destReg != 0 ? 0 : 1)};
+                *patch++ = WithRegisters(StrPreIndexSp, scratchReg);
+                for (auto mov : instructions::MoveRegister(registers::X(scratchReg), rescaleMultiplier))
+                    if (mov)
+                        *patch++ = mov;
+                *patch++ = instructions::Mrs(CntvctEl0, registers::X(destReg)).raw;
+                *patch++ = instructions::Umulh(registers::X(destReg), registers::X(destReg), registers::X(scratchReg)).raw;
+                *patch++ = WithRegisters(LdrPostIndexSp, scratchReg);
+            } else {
+                /* Rescale host clock */
+                std::memcpy(patch, reinterpret_cast<void *>(&guest::RescaleClock), guest::RescaleClockSize * sizeof(u32));
+                patch += guest::RescaleClockSize;
+
+                /* Load result from stack into destination register */
+                instructions::Ldr ldr(0xF94003E0); // LDR XOUT, [SP]
+                ldr.destReg = destReg;
+                *patch++ = ldr.raw;
+
+                /* Free 32B stack allocation by RescaleClock */
+                *patch++ = {0x910083FF}; // ADD SP, SP, #32
+            }
+        }};
+
+        /**
+         * @brief Writes a trampoline prologue which counts consecutive counter reads from the same trampoline and invokes SkipIdleLoop once they exceed the threshold
+         * @note The trampoline is identified by its own address, this only touches the ThreadContext and spilled scratch registers so it doesn't affect the guest state which SaveCtx captures
+         * @note Reads more than IdleLoopReadIntervalUs apart reset the count, a hot loop which does work between reads of the counter is never mistaken for an idle one
+         */
+        auto writeIdleLoopCheck{[&]() {
+            constexpr u8 ContextReg{0}, SiteReg{1}, CountReg{2};
+            *patch++ = WithRegisters(StpPreIndexSp, ContextReg, 0, SiteReg, true);
+            *patch++ = WithRegisters(StrPreIndexSp, CountReg);
+            *patch++ = WithRegisters(MrsTpidrEl0, ContextReg);
+            *patch++ = WithRegisters(AdrSelf, SiteReg);
+
+            /* Reset the count if the last counter read was from a different site */
+            *patch++ = WithRegisters(LdrIdleLoopSite, CountReg, ContextReg);
+            *patch++ = WithRegisters(Sub, CountReg, CountReg, SiteReg, false);
+            *patch++ = Cbnz | (12 << 5) | CountReg; // CBNZ CountReg, ResetSite
+
+            /* Reset the count if too much time has passed since the last counter read, the site register is free to hold the counter after this point */
+            *patch++ = instructions::Mrs(CntvctEl0, registers::X(SiteReg)).raw;
+            *patch++ = WithRegisters(LdrIdleLoopTick, CountReg, ContextReg);
+            *patch++ = WithRegisters(StrIdleLoopTick, SiteReg, ContextReg);
+            *patch++ = WithRegisters(Sub, CountReg, SiteReg, CountReg, false);
+            *patch++ = WithRegisters(LsrImmediate, CountReg, CountReg) | (static_cast<u32>(idleLoopIntervalShift) << 16);
+            *patch++ = Cbnz | (9 << 5) | CountReg; // CBNZ CountReg, ResetCount
+
+            /* Increment the count and skip the idle loop once the threshold bit is set, the branches don't clobber the guest's condition flags */
+            *patch++ = WithRegisters(LdrIdleLoopCount, CountReg, ContextReg);
+            *patch++ = WithRegisters(AddOne, CountReg, CountReg);
+            *patch++ = WithRegisters(StrIdleLoopCount, CountReg, ContextReg);
+            *patch++ = Tbnz | (static_cast<u32>(IdleLoopThresholdBit) << 19) | (9 << 5) | CountReg; // TBNZ CountReg, #IdleLoopThresholdBit, SkipIdleLoop
+            *patch = instructions::B(5).raw; // B Restore
+            patch++;
+
+            /* ResetSite */
+            *patch++ = WithRegisters(StrIdleLoopSite, SiteReg, ContextReg);
+            *patch++ = instructions::Mrs(CntvctEl0, registers::X(SiteReg)).raw;
+            *patch++ = WithRegisters(StrIdleLoopTick, SiteReg, ContextReg);
+
+            /* ResetCount */
+            *patch++ = WithRegisters(StrIdleLoopCount, 31, ContextReg); // STR XZR
+
+            /* Restore */
+            *patch++ = WithRegisters(LdrPostIndexSp, CountReg);
+            *patch++ = WithRegisters(LdpPostIndexSp, ContextReg, 0, SiteReg, true);
+            *patch = instructions::B(9).raw; // B CounterRead
+            patch++;
+
+            /* SkipIdleLoop */
+            *patch++ = WithRegisters(LdrPostIndexSp, CountReg);
+            *patch++ = WithRegisters(LdpPostIndexSp, ContextReg, 0, SiteReg, true);
+            *patch++ = 0xF81F0FFE; // STR LR, [SP, #-16]!
+            *patch = instructions::BL(static_cast<i32>(start - patch)).raw;
+            patch++;
+            *patch++ = instructions::Movz(registers::W0, IdleLoopSvcId).raw;
+            *patch = instructions::BL(static_cast<i32>((start - patch) + guest::SaveCtxSize)).raw;
+            patch++;
+            *patch = instructions::BL(static_cast<i32>((start - patch) + guest::SaveCtxSize + MainSvcTrampolineSize)).raw;
+            patch++;
+            *patch++ = 0xF84107FE; // LDR LR, [SP], #16
+
+            /* CounterRead */
+        }};
+
+        /**
+         * @brief Writes a trampoline body which reads the guest counter into the supplied register, this is preceded by the idle loop check if it's enabled
+         */
+        auto writeCounterRead{[&](u8 destReg) {
+            if (idleLoopDetection)
+                writeIdleLoopCheck();
+
+            if (rescaleClock)
+                writeRescaledCounterRead(destReg);
+            else
+                *patch++ = instructions::Mrs(CntvctEl0, registers::X(destReg)).raw;
+        }};
 
         for (auto offset : offsets) {
             u32 *instruction{reinterpret_cast<u32 *>(text.data()) + offset};
@@ -302,7 +571,22 @@ namespace skyline::nce {
             auto endOffset{[&] { return static_cast<size_t>(end - patch); }};
             auto startOffset{[&] { return static_cast<size_t>(start - patch); }};
 
-            if (svc.Verify()) {
+            if (svc.Verify() && svc.value == GetSystemTickSvc) {
+                // svcGetSystemTick only writes the scaled counter into X0, it's emitted inline to skip saving and restoring the entire context for one of the most frequent SVCs
+                if (rescaleClock || idleLoopDetection) {
+                    /* Inline GetSystemTick (With Rescaling or Idle Loop Detection) */
+                    /* Rewrite SVC with B to trampoline */
+                    *instruction = instructions::B(static_cast<i32>(endOffset() + offset), true).raw;
+
+                    /* Read the counter into X0 and Return */
+                    writeCounterRead(0);
+                    *patch = instructions::B(static_cast<i32>(endOffset() + offset + 1)).raw;
+                    patch++;
+                } else {
+                    /* Inline GetSystemTick (Without Rescaling) */
+                    *instruction = instructions::Mrs(CntvctEl0, registers::X0).raw;
+                }
+            } else if (svc.Verify()) {
                 /* Per-SVC Trampoline */
                 /* Rewrite SVC with B to trampoline */
                 *instruction = instructions::B(static_cast<i32>(endOffset() + offset), true).raw;
@@ -326,105 +610,126 @@ namespace skyline::nce {
             } else if (mrs.Verify()) {
                 if (mrs.srcReg == TpidrroEl0 || mrs.srcReg == TpidrEl0) {
                     /* Emulated TLS Register Load */
+                    // The destination register is used to hold the ThreadContext pointer itself, this avoids any scratch registers being spilled to the stack
                     /* Rewrite MRS with B to trampoline */
                     *instruction = instructions::B(static_cast<i32>(endOffset() + offset), true).raw;
 
-                    /* Allocate Scratch Register */
-                    if (mrs.destReg != registers::X0)
-                        *patch++ = 0xF81F0FE0; // STR X0, [SP, #-16]!
-
-                    /* Retrieve emulated TLS register from ThreadContext */
-                    *patch++ = 0xD53BD040; // MRS X0, TPIDR_EL0
-                    if (mrs.srcReg == TpidrroEl0)
-                        *patch++ = 0xF9415800; // LDR X0, [X0, #0x2B0] (ThreadContext::tpidrroEl0)
-                    else
-                        *patch++ = 0xF9415C00; // LDR X0, [X0, #0x2B8] (ThreadContext::tpidrEl0)
-
-                    /* Restore Scratch Register and Return */
-                    if (mrs.destReg != registers::X0) {
-                        *patch++ = instructions::Mov(registers::X(mrs.destReg), registers::X0).raw;
-                        *patch++ = 0xF84107E0; // LDR X0, [SP], #16
+                    /* Retrieve emulated TLS register from ThreadContext and Return */
+                    if (mrs.destReg != 31) {
+                        *patch++ = WithRegisters(MrsTpidrEl0, mrs.destReg);
+                        *patch++ = WithRegisters(mrs.srcReg == TpidrroEl0 ? LdrTpidrroEl0 : LdrTpidrEl0, mrs.destReg, mrs.destReg);
+                    } else {
+                        // A read into XZR is discarded, a base register of 31 would be SP rather than XZR so we can't emit the load
+                        *patch++ = 0xD503201F; // NOP
+                        *patch++ = 0xD503201F; // NOP
                     }
                     *patch = instructions::B(static_cast<i32>(endOffset() + offset + 1)).raw;
                     patch++;
-                } else {
-                    if (rescaleClock) {
-                        if (mrs.srcReg == CntpctEl0) {
-                            /* Physical Counter Load Emulation (With Rescaling) */
-                            /* Rewrite MRS with B to trampoline */
-                            *instruction = instructions::B(static_cast<i32>(endOffset() + offset), true).raw;
-
-                            /* Rescale host clock */
-                            std::memcpy(patch, reinterpret_cast<void *>(&guest::RescaleClock), guest::RescaleClockSize * sizeof(u32));
-                            patch += guest::RescaleClockSize;
-
-                            /* Load result from stack into destination register */
-                            instructions::Ldr ldr(0xF94003E0); // LDR XOUT, [SP]
-                            ldr.destReg = mrs.destReg;
-                            *patch++ = ldr.raw;
-
-                            /* Free 32B stack allocation by RescaleClock and Return */
-                            *patch++ = {0x910083FF}; // ADD SP, SP, #32
-                            *patch = instructions::B(static_cast<i32>(endOffset() + offset + 1)).raw;
-                            patch++;
-                        } else if (mrs.srcReg == CntfrqEl0) {
-                            /* Physical Counter Frequency Load Emulation */
-                            /* Rewrite MRS with B to trampoline */
-                            *instruction = instructions::B(static_cast<i32>(endOffset() + offset), true).raw;
-
-                            /* Write back Tegra X1 Counter Frequency and Return */
-                            for (const auto &mov : instructions::MoveRegister(registers::X(mrs.destReg), TegraX1Freq))
-                                *patch++ = mov;
-                            *patch = instructions::B(static_cast<i32>(endOffset() + offset + 1)).raw;
-                            patch++;
-                        }
-                    } else if (mrs.srcReg == CntpctEl0) {
+                } else if (mrs.srcReg == CntpctEl0) {
+                    if (rescaleClock || idleLoopDetection) {
+                        /* Physical Counter Load Emulation (With Rescaling or Idle Loop Detection) */
+                        /* Rewrite MRS with B to trampoline */
+                        *instruction = instructions::B(static_cast<i32>(endOffset() + offset), true).raw;
+
+                        /* Read the counter into the destination register and Return */
+                        writeCounterRead(mrs.destReg);
+                        *patch = instructions::B(static_cast<i32>(endOffset() + offset + 1)).raw;
+                        patch++;
+                    } else {
                         /* Physical Counter Load Emulation (Without Rescaling) */
                         // We just convert CNTPCT_EL0 -> CNTVCT_EL0 as Linux doesn't allow access to the physical counter
                         *instruction = instructions::Mrs(CntvctEl0, registers::X(mrs.destReg)).raw;
                     }
+                } else if (rescaleClock && mrs.srcReg == CntfrqEl0) {
+                    /* Physical Counter Frequency Load Emulation */
+                    /* Rewrite MRS with B to trampoline */
+                    *instruction = instructions::B(static_cast<i32>(endOffset() + offset), true).raw;
+
+                    /* Write back Tegra X1 Counter Frequency and Return */
+                    for (const auto &mov : instructions::MoveRegister(registers::X(mrs.destReg), TegraX1Freq))
+                        *patch++ = mov;
+                    *patch = instructions::B(static_cast<i32>(endOffset() + offset + 1)).raw;
+                    patch++;
                 }
             } else if (msr.Verify() && msr.destReg == TpidrEl0) {
                 /* Emulated TLS Register Store */
                 /* Rewrite MSR with B to trampoline */
                 *instruction = instructions::B(static_cast<i32>(endOffset() + offset), true).raw;
 
-                /* Allocate Scratch Registers */
-                bool x0x1{mrs.srcReg != registers::X0 && mrs.srcReg != registers::X1};
-                *patch++ = x0x1 ? 0xA9BF07E0 : 0xA9BF0FE2; // STP X(0/2), X(1/3), [SP, #-16]!
+                /* Allocate Scratch Register */
+                u8 scratchReg{static_cast<u8>(msr.srcReg != 0 ? 0 : 1)};
+                *patch++ = WithRegisters(StrPreIndexSp, scratchReg);
 
                 /* Store new TLS value into ThreadContext */
-                *patch++ = x0x1 ? 0xD53BD040 : 0xD53BD042; // MRS X(0/2), TPIDR_EL0
-                *patch++ = instructions::Mov(x0x1 ? registers::X1 : registers::X3, registers::X(msr.srcReg)).raw;
-                *patch++ = x0x1 ? 0xF9015C01 : 0xF9015C03; // STR X(1/3), [X0, #0x4B8] (ThreadContext::tpidrEl0)
+                *patch++ = WithRegisters(MrsTpidrEl0, scratchReg);
+                *patch++ = WithRegisters(StrTpidrEl0, msr.srcReg, scratchReg);
 
-                /* Restore Scratch Registers and Return */
-                *patch++ = x0x1 ? 0xA8C107E0 : 0xA8C10FE2; // LDP X(0/2), X(1/3), [SP], #16
+                /* Restore Scratch Register and Return */
+                *patch++ = WithRegisters(LdrPostIndexSp, scratchReg);
                 *patch = instructions::B(static_cast<i32>(endOffset() + offset + 1)).raw;
                 patch++;
             }
         }
+
+        for (const auto &hostFunction : hostFunctions) {
+            // A function is left intact if any of the instructions that the branch would overwrite were patched above as their trampolines branch back into it
+            auto firstInstruction{hostFunction.offset / sizeof(u32)};
+            auto patched{std::lower_bound(offsets.begin(), offsets.end(), firstInstruction)};
+            if (hostFunction.offset % sizeof(u32) || (patched != offsets.end() && *patched < firstInstruction + (HostFunctionPatchSize / sizeof(u32))))
+                continue;
+
+            /* Tail call the host function with X16 (IP0) which may be clobbered by any function call */
+            u32 *instruction{reinterpret_cast<u32 *>(text.data()) + firstInstruction};
+            *instruction++ = 0x58000050; // LDR X16, #8
+            *instruction++ = 0xD61F0200; // BR X16
+            auto address{reinterpret_cast<u64>(hostFunction.function)};
+            std::memcpy(instruction, &address, sizeof(address));
+        }
     }
 
-    NCE::CallbackEntry::CallbackEntry(TrapProtection protection, LockCallback lockCallback, TrapCallback readCallback, TrapCallback writeCallback) : protection{protection}, lockCallback{std::move(lockCallback)}, readCallback{std::move(readCallback)}, writeCallback{std::move(writeCallback)} {}
+    NCE::CallbackEntry::CallbackEntry(TrapProtection protection, LockCallback lockCallback, TrapCallback readCallback, TrapCallback writeCallback, PageWriteCallback pageWriteCallback) : protection{protection}, lockCallback{std::move(lockCallback)}, readCallback{std::move(readCallback)}, writeCallback{std::move(writeCallback)}, pageWriteCallback{std::move(pageWriteCallback)} {}
+
+    /**
+     * @brief A wrapper around mprotect which records the call in the performance counters
+     */
+    static void Reprotect(u8 *start, u8 *end, int protection) {
+        mprotect(start, static_cast<size_t>(end - start), protection);
+        PerfStats::Increment(PerfStats::Counter::Mprotects);
+    }
 
     void NCE::ReprotectIntervals(const std::vector<TrapMap::Interval> &intervals, TrapProtection protection) {
         TRACE_EVENT("host", "NCE::ReprotectIntervals");
 
         auto reprotectIntervalsWithFunction = [&intervals](auto getProtection) {
+            // Runs of intervals are merged in order, this retains the order in which overlapping pages with differing protections would be reprotected
+            u8 *runStart{}, *runEnd{};
+            int runProtection{};
             for (auto region : intervals) {
                 region = region.Align(constant::PageSize);
-                mprotect(region.start, region.Size(), getProtection(region));
+                int regionProtection{getProtection(region)};
+                if (runStart && region.start >= runStart && region.start <= runEnd && regionProtection == runProtection) {
+                    runEnd = std::max(runEnd, region.end);
+                    continue;
+                }
+
+                if (runStart)
+                    Reprotect(runStart, runEnd, runProtection);
+                runStart = region.start;
+                runEnd = region.end;
+                runProtection = regionProtection;
             }
+
+            if (runStart)
+                Reprotect(runStart, runEnd, runProtection);
         };
 
         // We need to determine the lowest protection possible for the given interval
         if (protection == TrapProtection::None) {
             reprotectIntervalsWithFunction([&](auto region) {
-                auto entries{trapMap.GetRange(region)};
+                trapMap.GetRange(region, reprotectEntries);
 
                 TrapProtection lowestProtection{TrapProtection::None};
-                for (const auto &entry : entries) {
+                for (const auto &entry : reprotectEntries) {
                     auto entryProtection{entry.get().protection};
                     if (entryProtection > lowestProtection) {
                         lowestProtection = entryProtection;
@@ -444,8 +749,8 @@ namespace skyline::nce {
             });
         } else if (protection == TrapProtection::WriteOnly) {
             reprotectIntervalsWithFunction([&](auto region) {
-                auto entries{trapMap.GetRange(region)};
-                for (const auto &entry : entries)
+                trapMap.GetRange(region, reprotectEntries);
+                for (const auto &entry : reprotectEntries)
                     if (entry.get().protection == TrapProtection::ReadWrite)
                         return PROT_NONE;
 
@@ -472,12 +777,38 @@ namespace skyline::nce {
             std::scoped_lock lock(trapMutex);
 
             // Retrieve any callbacks for the page that was faulted
-            auto[entries, intervals]{trapMap.GetAlignedRecursiveRange<constant::PageSize>(address)};
+            auto &entries{faultEntries};
+            auto &intervals{faultIntervals};
+            trapMap.GetAlignedRecursiveRange<constant::PageSize>(address, entries, intervals);
             if (entries.empty())
                 return false; // There's no callbacks associated with this page
 
             // Do callbacks for every entry in the intervals
             if (write) {
+                // If all entries that need a callback can handle writes a page at a time, only the faulting page needs to be unprotected
+                bool pageGranular{std::any_of(entries.begin(), entries.end(), [](const auto &entryRef) {
+                    return entryRef.get().protection != TrapProtection::None;
+                }) && std::all_of(entries.begin(), entries.end(), [](const auto &entryRef) {
+                    const auto &entry{entryRef.get()};
+                    return entry.protection == TrapProtection::None || (entry.protection == TrapProtection::WriteOnly && entry.pageWriteCallback);
+                })};
+
+                u8 *page{util::AlignDown(address, constant::PageSize)};
+                if (pageGranular) {
+                    for (auto entryRef : entries) {
+                        auto &entry{entryRef.get()};
+                        if (entry.protection != TrapProtection::None && !entry.pageWriteCallback(page)) {
+                            pageGranular = false; // Any entries which already handled the page will have the write callback invoked for them as well
+                            break;
+                        }
+                    }
+                }
+
+                if (pageGranular) {
+                    Reprotect(page, page + constant::PageSize, PROT_READ | PROT_WRITE | PROT_EXEC);
+                    return true;
+                }
+
                 for (auto entryRef : entries) {
                     auto &entry{entryRef.get()};
                     if (entry.protection == TrapProtection::None)
@@ -513,10 +844,15 @@ namespace skyline::nce {
                 write = allNone;
             }
 
+            // Reprotect the intervals to the lowest protection level that the callbacks performed allow, all intervals share the same protection so any adjacent ones can be merged
             int permission{PROT_READ | (write ? PROT_WRITE : 0) | PROT_EXEC};
-            for (const auto &interval : intervals)
-                // Reprotect the interval to the lowest protection level that the callbacks performed allow
-                mprotect(interval.start, interval.Size(), permission);
+            std::sort(intervals.begin(), intervals.end(), [](const auto &a, const auto &b) { return a.start < b.start; });
+            for (auto interval{intervals.begin()}; interval != intervals.end();) {
+                u8 *start{interval->start}, *end{interval->end};
+                while (++interval != intervals.end() && interval->start <= end)
+                    end = std::max(end, interval->end);
+                Reprotect(start, end, permission);
+            }
 
             return true;
         }
@@ -527,7 +863,7 @@ namespace skyline::nce {
     NCE::TrapHandle NCE::CreateTrap(span<span<u8>> regions, const LockCallback &lockCallback, const TrapCallback &readCallback, const TrapCallback &writeCallback) {
         TRACE_EVENT("host", "NCE::CreateTrap");
         std::scoped_lock lock{trapMutex};
-        TrapHandle handle{trapMap.Insert(regions, CallbackEntry{TrapProtection::None, lockCallback, readCallback, writeCallback})};
+        TrapHandle handle{trapMap.Insert(regions, CallbackEntry{TrapProtection::None, lockCallback, readCallback, writeCallback, pageWriteCallback})};
         return handle;
     }
 
@@ -556,7 +892,22 @@ namespace skyline::nce {
         TRACE_EVENT("host", "NCE::RemoveTrap");
         std::scoped_lock lock{trapMutex};
         handle->value.protection = TrapProtection::None;
-        ReprotectIntervals(handle->intervals, TrapProtection::None);
+
+        // Lowering the protection can be safely deferred as the entry still exists, so any faults before it's reprotected will be resolved by the trap handler
+        deferredUnprotects.insert(deferredUnprotects.end(), handle->intervals.begin(), handle->intervals.end());
+    }
+
+    void NCE::FlushDeferredReprotects() {
+        std::scoped_lock lock{trapMutex};
+        if (deferredUnprotects.empty())
+            return;
+
+        TRACE_EVENT("host", "NCE::FlushDeferredReprotects");
+
+        // The protection is determined from the current state of the trap map, so any regions that were re-trapped in the meantime will retain their traps
+        std::sort(deferredUnprotects.begin(), deferredUnprotects.end(), [](const auto &a, const auto &b) { return a.start < b.start; });
+        ReprotectIntervals(deferredUnprotects, TrapProtection::None);
+        deferredUnprotects.clear();
     }
 
     void NCE::DeleteTrap(TrapHandle handle) {
@@ -564,6 +915,11 @@ namespace skyline::nce {
         std::scoped_lock lock{trapMutex};
         handle->value.protection = TrapProtection::None;
         ReprotectIntervals(handle->intervals, TrapProtection::None);
+
+        // Any deferred reprotection of the intervals is redundant now and the memory may be reused before the next flush
+        if (!deferredUnprotects.empty())
+            std::erase_if(deferredUnprotects, [&](const auto &interval) { return std::find(handle->intervals.begin(), handle->intervals.end(), interval) != handle->intervals.end(); });
+
         trapMap.Remove(handle);
     }
 }
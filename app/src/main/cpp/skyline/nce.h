@@ -26,21 +26,28 @@ namespace skyline::nce {
 
         using TrapCallback = std::function<bool()>;
         using LockCallback = std::function<void()>;
+        using PageWriteCallback = std::function<bool(u8 *page)>;
 
         struct CallbackEntry {
             TrapProtection protection; //!< The least restrictive protection that this callback needs to have
             LockCallback lockCallback;
             TrapCallback readCallback, writeCallback;
+            PageWriteCallback pageWriteCallback; //!< An optional callback for writes to write-only protected regions which can handle them a page at a time, the rest of the regions stay protected if it returns true
 
-            CallbackEntry(TrapProtection protection, LockCallback lockCallback, TrapCallback readCallback, TrapCallback writeCallback);
+            CallbackEntry(TrapProtection protection, LockCallback lockCallback, TrapCallback readCallback, TrapCallback writeCallback, PageWriteCallback pageWriteCallback);
         };
 
         std::mutex trapMutex; //!< Synchronizes the accesses to the trap map
         using TrapMap = IntervalMap<u8*, CallbackEntry>;
         TrapMap trapMap; //!< A map of all intervals and corresponding callbacks that have been registered
+        std::vector<TrapMap::Interval> deferredUnprotects; //!< Intervals which had their traps removed but haven't been reprotected yet, this is synchronized by trapMutex
+        std::vector<std::reference_wrapper<CallbackEntry>> faultEntries; //!< The entries of the fault being handled, this is reused across faults to avoid allocating in the handler and is synchronized by trapMutex
+        std::vector<TrapMap::Interval> faultIntervals; //!< The intervals that are reprotected by the fault being handled, this is synchronized by trapMutex
+        std::vector<std::reference_wrapper<CallbackEntry>> reprotectEntries; //!< The entries overlapping the region being reprotected, this is synchronized by trapMutex
 
         /**
          * @brief Reprotects the intervals to the least restrictive protection given the supplied protection
+         * @note Consecutive intervals which are adjacent or overlapping after page alignment and resolve to the same protection are reprotected with a single mprotect call
          */
         void ReprotectIntervals(const std::vector<TrapMap::Interval>& intervals, TrapProtection protection);
 
@@ -84,13 +91,34 @@ namespace skyline::nce {
             std::vector<size_t> offsets; //!< Offsets in .text of instructions that need to be patched
         };
 
-        static PatchData GetPatchData(const std::vector<u8> &text);
+        /**
+         * @param idleLoopDetection If counter reads should count the consecutive reads from the same site and yield the thread once it's determined to be polling the counter in an idle loop
+         */
+        static PatchData GetPatchData(const std::vector<u8> &text, bool idleLoopDetection);
+
+        /**
+         * @brief A guest function that's replaced with a branch to a host function with identical semantics and calling convention
+         */
+        struct HostFunctionPatch {
+            size_t offset; //!< The offset of the guest function in .text
+            void *function; //!< The host function that's branched to
+        };
+
+        static constexpr size_t HostFunctionPatchSize{0x10}; //!< The size of the branch written over the start of a replaced guest function, functions smaller than this can't be replaced
+
+        /**
+         * @return The host function that a guest function with the supplied name can be replaced with or nullptr if there's none
+         * @note Only leaf functions that don't access TLS are replaced as they run on the guest stack with guest TLS
+         */
+        static void *GetHostFunction(std::string_view name);
 
         /**
          * @brief Writes the .patch section and mutates the code accordingly
          * @param patch A pointer to the .patch section which should be exactly patchSize in size and located before the .text section
+         * @param idleLoopDetection This must match the value supplied to GetPatchData
+         * @param hostFunctions Guest functions which are replaced with a tail call to a host function, this doesn't affect the size of the .patch section as the branch is written over the guest function itself
          */
-        static void PatchCode(std::vector<u8> &text, u32 *patch, size_t patchSize, const std::vector<size_t> &offsets);
+        static void PatchCode(std::vector<u8> &text, u32 *patch, size_t patchSize, const std::vector<size_t> &offsets, bool idleLoopDetection, span<const HostFunctionPatch> hostFunctions = {});
 
         /**
          * @brief An opaque handle to a group of trapped region
@@ -106,11 +134,12 @@ namespace skyline::nce {
          * @param lockCallback A callback to lock the resource that is being trapped, it must block until the resource is locked but unlock it prior to returning
          * @param readCallback A callback for read accesses to the trapped region, it must not block and return a boolean if it would block
          * @param writeCallback A callback for write accesses to the trapped region, it must not block and return a boolean if it would block
+         * @param pageWriteCallback An optional callback for write accesses to a write-only trapped region, it's supplied the page-aligned address of the write and must not block, if it returns true only that page is unprotected otherwise the write callback is used
          * @note The handle **must** be deleted using DeleteTrap before the NCE instance is destroyed
          * @note It is UB to supply a region of host memory rather than guest memory
          * @note This doesn't trap the region in itself, any trapping must be done via TrapRegions(...)
          */
-        TrapHandle CreateTrap(span<span<u8>> regions, const LockCallback& lockCallback, const TrapCallback& readCallback, const TrapCallback& writeCallback);
+        TrapHandle CreateTrap(span<span<u8>> regions, const LockCallback& lockCallback, const TrapCallback& readCallback, const TrapCallback& writeCallback, const PageWriteCallback& pageWriteCallback = {});
 
         /**
          * @brief Re-traps a region of memory after protections were removed
@@ -127,9 +156,16 @@ namespace skyline::nce {
 
         /**
          * @brief Removes protections from a region of memory
+         * @note The region is only reprotected on the next call to FlushDeferredReprotects, any accesses prior to that will fault and be resolved by the trap handler without invoking any callbacks
          */
         void RemoveTrap(TrapHandle handle);
 
+        /**
+         * @brief Reprotects all regions which had their traps removed since the last call in one batch
+         * @note This should be called at the end of every GPU execution
+         */
+        void FlushDeferredReprotects();
+
         /**
          * @brief Deletes a trap handle and removes the protection from the region
          */
@@ -100,6 +100,9 @@ namespace skyline {
             u8 *tpidrEl0; //!< Emulated HOS TPIDR_EL0
             const DeviceState *state;
             u64 magic{constant::SkyTlsMagic};
+            u64 idleLoopSite{}; //!< The address of the counter read trampoline that was last run by the thread, this is only used with idle loop detection
+            u64 idleLoopCount{}; //!< The amount of consecutive counter reads from idleLoopSite without any intervening SVC
+            u64 idleLoopTick{}; //!< The host counter value at the last counter read from idleLoopSite, this is used to only count reads in quick succession
         };
 
         namespace guest {
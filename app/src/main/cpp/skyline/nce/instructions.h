@@ -310,6 +310,33 @@ namespace skyline::nce {
         };
         static_assert(sizeof(Mov) == sizeof(u32));
 
+        /**
+         * @url https://developer.arm.com/docs/ddi0596/latest/base-instructions-alphabetic-order/umulh-unsigned-multiply-high
+         */
+        struct Umulh {
+          public:
+            /**
+             * @brief Creates a UMULH instruction which stores the upper 64 bits of the 128-bit product of the source registers
+             */
+            constexpr Umulh(registers::X destReg, registers::X srcReg1, registers::X srcReg2) : destReg(static_cast<u8>(destReg)), srcReg1(static_cast<u8>(srcReg1)), sig0(0x1F), srcReg2(static_cast<u8>(srcReg2)), sig1(0x4DE) {}
+
+            constexpr bool Verify() {
+                return (sig0 == 0x1F) && (sig1 == 0x4DE);
+            }
+
+            union {
+                struct __attribute__((packed)) {
+                    u8 destReg : 5; //!< 5-bit destination register
+                    u8 srcReg1 : 5; //!< 5-bit first source register
+                    u8 sig0 : 6; //!< 6-bit signature (0x1F), this is the zero register as the addend and a clear o0 bit
+                    u8 srcReg2 : 5; //!< 5-bit second source register
+                    u16 sig1 : 11; //!< 11-bit signature (0x4DE)
+                };
+                u32 raw{};
+            };
+        };
+        static_assert(sizeof(Umulh) == sizeof(u32));
+
         /**
          * @url https://developer.arm.com/docs/ddi0596/e/base-instructions-alphabetic-order/ldr-immediate-load-register-immediate
          */
@@ -10,6 +10,7 @@
 #include "loader/nca.h"
 #include "loader/nsp.h"
 #include "loader/xci.h"
+#include "gpu.h"
 #include "os.h"
 
 namespace skyline::kernel {
@@ -29,31 +30,34 @@ namespace skyline::kernel {
           state(this, jvmManager, settings),
           serviceManager(state) {}
 
-    void OS::Execute(int romFd, loader::RomFormat romType) {
+    std::shared_ptr<loader::Loader> OS::CreateLoader(int romFd, loader::RomFormat romType, const std::string &keysPath, bool verifyRomIntegrity) {
         auto romFile{std::make_shared<vfs::OsBacking>(romFd)};
-        auto keyStore{std::make_shared<crypto::KeyStore>(privateAppFilesPath + "keys/")};
+        auto keyStore{std::make_shared<crypto::KeyStore>(keysPath)};
 
-        state.loader = [&]() -> std::shared_ptr<loader::Loader> {
-            switch (romType) {
-                case loader::RomFormat::NRO:
-                    return std::make_shared<loader::NroLoader>(std::move(romFile));
-                case loader::RomFormat::NSO:
-                    return std::make_shared<loader::NsoLoader>(std::move(romFile));
-                case loader::RomFormat::NCA:
-                    return std::make_shared<loader::NcaLoader>(std::move(romFile), std::move(keyStore));
-                case loader::RomFormat::NSP:
-                    return std::make_shared<loader::NspLoader>(romFile, keyStore);
-                case loader::RomFormat::XCI:
-                    return std::make_shared<loader::XciLoader>(romFile, keyStore);
-                default:
-                    throw exception("Unsupported ROM extension.");
-            }
-        }();
+        switch (romType) {
+            case loader::RomFormat::NRO:
+                return std::make_shared<loader::NroLoader>(std::move(romFile));
+            case loader::RomFormat::NSO:
+                return std::make_shared<loader::NsoLoader>(std::move(romFile));
+            case loader::RomFormat::NCA:
+                return std::make_shared<loader::NcaLoader>(std::move(romFile), std::move(keyStore), verifyRomIntegrity);
+            case loader::RomFormat::NSP:
+                return std::make_shared<loader::NspLoader>(romFile, keyStore, verifyRomIntegrity);
+            case loader::RomFormat::XCI:
+                return std::make_shared<loader::XciLoader>(romFile, keyStore, verifyRomIntegrity);
+            default:
+                throw exception("Unsupported ROM extension.");
+        }
+    }
+
+    void OS::Load(std::shared_ptr<loader::Loader> loader) {
+        state.loader = std::move(loader);
 
         auto &process{state.process};
         process = std::make_shared<kernel::type::KProcess>(state);
 
-        auto entry{state.loader->LoadProcessData(process, state)};
+        // The GPU is still being created at this point, loading the process data overlaps with it
+        entry = state.loader->LoadProcessData(process, state);
         auto &nacp{state.loader->nacp};
         if (nacp) {
             std::string name{nacp->GetApplicationName(language::ApplicationLanguage::AmericanEnglish)}, publisher{nacp->GetApplicationPublisher(language::ApplicationLanguage::AmericanEnglish)};
@@ -64,13 +68,25 @@ namespace skyline::kernel {
             Logger::InfoNoPrefix(R"(Starting "{}" v{} by "{}")", name, nacp->GetApplicationVersion(), publisher);
         }
 
+        state.AwaitGpu();
+
+        // Pipelines from previous runs are compiled in the background while the guest is booting
+        state.gpu->ReplayRecordedPipelines();
+
         process->InitializeHeapTls();
+        saveStates.emplace(state);
+    }
+
+    void OS::Execute() {
+        auto &process{state.process};
         auto thread{process->CreateThread(entry)};
         if (thread) {
             Logger::Info("Starting main HOS thread");
             Logger::EmulationContext.Flush();
             thread->Start(true);
             process->Kill(true, true, true);
+            if (process->profiler)
+                process->profiler->WriteReport();
         }
     }
 }
@@ -7,6 +7,7 @@
 #include "vfs/filesystem.h"
 #include "loader/loader.h"
 #include "services/serviceman.h"
+#include "kernel/save_state.h"
 
 namespace skyline::kernel {
     /**
@@ -21,6 +22,7 @@ namespace skyline::kernel {
         std::shared_ptr<vfs::FileSystem> assetFileSystem; //!< A filesystem to be used for accessing emulator assets (like tzdata)
         DeviceState state;
         service::ServiceManager serviceManager;
+        std::optional<SaveStateManager> saveStates; //!< The save states of the loaded process, this is only populated after Load()
 
         /**
          * @param settings An instance of the Settings class
@@ -36,11 +38,27 @@ namespace skyline::kernel {
             std::shared_ptr<vfs::FileSystem> assetFileSystem
         );
 
+      private:
+        void *entry{}; //!< The entry point of the loaded process
+
+      public:
         /**
-         * @brief Execute a particular ROM file
+         * @brief Creates a loader for a particular ROM file, this has no dependencies on the OS so it can be done concurrently with its construction
          * @param romFd A FD to the ROM file to execute
          * @param romType The type of the ROM file
+         * @param keysPath The path to the directory containing the title and production keys
+         */
+        static std::shared_ptr<loader::Loader> CreateLoader(int romFd, loader::RomFormat romType, const std::string &keysPath, bool verifyRomIntegrity);
+
+        /**
+         * @brief Loads the process from the supplied loader and waits for the GPU to be created
+         * @note This must be called prior to Execute()
+         */
+        void Load(std::shared_ptr<loader::Loader> loader);
+
+        /**
+         * @brief Executes the loaded process, this returns once the process has exited
          */
-        void Execute(int romFd, loader::RomFormat romType);
+        void Execute();
     };
 }
@@ -18,7 +18,7 @@ namespace skyline::service::audio {
     }
 
     Result IAudioOut::GetAudioOutState(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
-        response.Push(static_cast<u32>(track->playbackState));
+        response.Push(static_cast<u32>(track->playbackState.load()));
         return {};
     }
 
@@ -31,6 +31,7 @@ namespace skyline::service::audio {
     Result IAudioOut::StopAudioOut(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
         Logger::Debug("Stop playback");
         track->Stop();
+        resampler.Reset(); // Buffers appended after stopping don't continue the previous stream
         return {};
     }
 
@@ -48,8 +49,9 @@ namespace skyline::service::audio {
 
         span samples(data.sampleBuffer, data.sampleSize / sizeof(i16));
         if (sampleRate != constant::SampleRate) {
-            auto resampledBuffer{resampler.ResampleBuffer(samples, static_cast<double>(sampleRate) / constant::SampleRate, channelCount)};
-            track->AppendBuffer(tag, resampledBuffer);
+            double ratio{static_cast<double>(sampleRate) / constant::SampleRate};
+            resampledBuffer.resize(resampler.GetOutputSize(samples.size(), ratio, channelCount));
+            track->AppendBuffer(tag, resampler.Resample(samples, resampledBuffer, ratio, channelCount));
         } else {
             track->AppendBuffer(tag, samples);
         }
@@ -15,6 +15,7 @@ namespace skyline::service::audio {
     class IAudioOut : public BaseService {
       private:
         skyline::audio::Resampler resampler; //!< The audio resampler object used to resample audio
+        std::vector<i16> resampledBuffer; //!< A buffer for the resampled samples of an appended buffer, this is reused across buffers
         std::shared_ptr<skyline::audio::AudioTrack> track; //!< The audio track associated with the audio out
         std::shared_ptr<type::KEvent> releaseEvent; //!< The KEvent that is signalled when a buffer has been released
 
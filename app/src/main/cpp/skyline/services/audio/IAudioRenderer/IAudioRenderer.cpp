@@ -1,19 +1,32 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <common/signal.h>
+#include <common/thread_role.h>
+#include <loader/loader.h>
 #include <kernel/types/KProcess.h>
+#include <audio/mixer.h>
 #include "IAudioRenderer.h"
 
 namespace skyline::service::audio::IAudioRenderer {
     IAudioRenderer::IAudioRenderer(const DeviceState &state, ServiceManager &manager, AudioRendererParameters &parameters)
         : systemEvent(std::make_shared<type::KEvent>(state, true)), parameters(parameters), BaseService(state, manager) {
-        track = state.audio->OpenTrack(constant::StereoChannelCount, constant::SampleRate, [&]() { systemEvent->Signal(); });
-        track->Start();
-
         memoryPools.resize(parameters.effectCount + parameters.voiceCount * 4);
         effects.resize(parameters.effectCount);
         voices.resize(parameters.voiceCount, Voice(state));
 
+        // The release callback is called from the audio release thread, it only wakes the render thread so rendering never happens on it
+        track = state.audio->OpenTrack(constant::StereoChannelCount, constant::SampleRate, [this]() {
+            {
+                std::scoped_lock lock{renderMutex};
+                buffersReleased = true;
+            }
+            renderCondition.notify_one();
+        });
+        track->Start();
+
+        renderThread = std::thread(&IAudioRenderer::RenderThread, this);
+
         // Fill track with empty samples that we will triple buffer
         track->AppendBuffer(0);
         track->AppendBuffer(1);
@@ -22,6 +35,47 @@ namespace skyline::service::audio::IAudioRenderer {
 
     IAudioRenderer::~IAudioRenderer() {
         state.audio->CloseTrack(track);
+
+        {
+            std::scoped_lock lock{renderMutex};
+            renderExiting = true;
+        }
+        renderCondition.notify_one();
+        renderThread.join();
+    }
+
+    void IAudioRenderer::RenderThread() {
+        if (int result{pthread_setname_np(pthread_self(), "Sky-AudioRender")})
+            Logger::Warn("Failed to set the thread name: {}", strerror(result));
+        thread_role::Apply(thread_role::Role::Audio);
+
+        try {
+            signal::SetSignalHandler({SIGINT, SIGILL, SIGTRAP, SIGBUS, SIGFPE, SIGSEGV}, signal::ExceptionalSignalHandler);
+
+            while (true) {
+                {
+                    std::unique_lock lock{renderMutex};
+                    renderCondition.wait(lock, [this]() { return buffersReleased || renderExiting; });
+                    if (renderExiting)
+                        return;
+                    buffersReleased = false;
+                }
+
+                UpdateAudio();
+            }
+        } catch (const signal::SignalException &e) {
+            Logger::Error("{}\nStack Trace:{}", e.what(), state.loader->GetStackTrace(e.frames));
+            if (state.process)
+                state.process->Kill(false);
+            else
+                std::rethrow_exception(std::current_exception());
+        } catch (const std::exception &e) {
+            Logger::Error(e.what());
+            if (state.process)
+                state.process->Kill(false);
+            else
+                std::rethrow_exception(std::current_exception());
+        }
     }
 
     Result IAudioRenderer::GetSampleRate(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
@@ -40,11 +94,12 @@ namespace skyline::service::audio::IAudioRenderer {
     }
 
     Result IAudioRenderer::GetState(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
-        response.Push(static_cast<u32>(playbackState));
+        response.Push(static_cast<u32>(playbackState.load()));
         return {};
     }
 
     Result IAudioRenderer::RequestUpdate(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        std::scoped_lock lock{renderMutex};
         auto input{request.inputBuf.at(0).data()};
 
         auto inputHeader{*reinterpret_cast<UpdateDataHeader *>(input)};
@@ -68,8 +123,6 @@ namespace skyline::service::audio::IAudioRenderer {
         for (u32 i{}; i < effectsIn.size(); i++)
             effects[i].ProcessInput(effectsIn[i]);
 
-        UpdateAudio();
-
         UpdateDataHeader outputHeader{
             .revision = constant::RevMagic,
             .behaviorSize = 0xB0,
@@ -118,47 +171,50 @@ namespace skyline::service::audio::IAudioRenderer {
     }
 
     void IAudioRenderer::UpdateAudio() {
-        auto released{track->GetReleasedBuffers(2)};
+        auto released{track->GetReleasedBuffers(std::numeric_limits<u32>::max())};
+        if (released.empty())
+            return;
 
         for (auto &tag : released) {
-            MixFinalBuffer();
+            {
+                std::scoped_lock lock{renderMutex};
+                MixFinalBuffer();
+            }
             track->AppendBuffer(tag, sampleBuffer);
         }
+
+        systemEvent->Signal();
     }
 
-    void IAudioRenderer::MixFinalBuffer() {
-        u32 writtenSamples{};
+    void IAudioRenderer::RenderQuantum(span<i16> output) {
+        size_t writtenSamples{};
 
         for (auto &voice : voices) {
             if (!voice.Playable())
                 continue;
 
-            u32 bufferOffset{};
-            u32 pendingSamples{constant::MixBufferSize};
-
-            while (pendingSamples > 0) {
-                u32 voiceBufferOffset{};
-                u32 voiceBufferSize{};
-                auto &voiceSamples{voice.GetBufferData(pendingSamples, voiceBufferOffset, voiceBufferSize)};
-
-                if (voiceBufferSize == 0)
-                    break;
-
-                pendingSamples -= voiceBufferSize / constant::StereoChannelCount;
+            // Samples prior to the amount written by earlier voices are mixed into the output while the rest overwrite it
+            auto source{span(voiceBuffer).first(voice.Render(span(voiceBuffer).first(output.size())))};
+            size_t mixSize{std::min(source.size(), writtenSamples)};
+            skyline::audio::MixVolume(output.first(mixSize), source.first(mixSize), voice.volume, true);
+            skyline::audio::MixVolume(output.subspan(mixSize), source.subspan(mixSize), voice.volume, false);
 
-                for (auto index{voiceBufferOffset}; index < voiceBufferOffset + voiceBufferSize; index++) {
-                    if (writtenSamples == bufferOffset) {
-                        sampleBuffer[bufferOffset] = skyline::audio::Saturate<i16, i32>(voiceSamples[index] * voice.volume);
+            writtenSamples = std::max(writtenSamples, source.size());
+        }
 
-                        writtenSamples++;
-                    } else {
-                        sampleBuffer[bufferOffset] = skyline::audio::Saturate<i16, i32>(sampleBuffer[bufferOffset] + (voiceSamples[index] * voice.volume));
-                    }
+        // Any samples that weren't written by a voice would otherwise replay stale data from the previous buffer
+        std::fill(output.begin() + static_cast<ssize_t>(writtenSamples), output.end(), 0);
+    }
 
-                    bufferOffset++;
-                }
-            }
+    void IAudioRenderer::MixFinalBuffer() {
+        if (playbackState.load(std::memory_order_relaxed) != skyline::audio::AudioOutState::Started) {
+            sampleBuffer.fill(0);
+            return;
         }
+
+        constexpr size_t QuantumSampleCount{constant::RenderQuantumSize * constant::StereoChannelCount};
+        for (size_t offset{}; offset < sampleBuffer.size(); offset += QuantumSampleCount)
+            RenderQuantum(span(sampleBuffer).subspan(offset, std::min(QuantumSampleCount, sampleBuffer.size() - offset)));
     }
 
     Result IAudioRenderer::Start(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <condition_variable>
 #include <services/serviceman.h>
 #include <audio.h>
 #include "memory_pool.h"
@@ -13,6 +14,7 @@
 namespace skyline {
     namespace constant {
         constexpr u8 BufferAlignment{0x40}; //!< The alignment for all audren buffers
+        constexpr u32 RenderQuantumSize{240}; //!< The amount of frames rendered at once by the audio renderer, this is 5ms at 48kHz
     }
 
     namespace service::audio::IAudioRenderer {
@@ -58,6 +60,7 @@ namespace skyline {
 
         /**
         * @brief IAudioRenderer is used to control an audio renderer output
+        * @note Rendering is done on a dedicated thread whenever the track releases a buffer, RequestUpdate only updates the parameters used for rendering
         * @url https://switchbrew.org/wiki/Audio_services#IAudioRenderer
         */
         class IAudioRenderer : public BaseService {
@@ -70,19 +73,36 @@ namespace skyline {
             std::vector<Effect> effects;
             std::vector<Voice> voices;
             std::array<i16, constant::MixBufferSize * constant::StereoChannelCount> sampleBuffer{}; //!< The final output data that is appended to the stream
-            skyline::audio::AudioOutState playbackState{skyline::audio::AudioOutState::Stopped};
+            std::array<i16, constant::RenderQuantumSize * constant::StereoChannelCount> voiceBuffer{}; //!< A buffer for the filtered samples of a single voice in a quantum
+            std::atomic<skyline::audio::AudioOutState> playbackState{skyline::audio::AudioOutState::Stopped};
+
+            std::mutex renderMutex; //!< Synchronizes the renderer state between RequestUpdate and the render thread
+            std::condition_variable renderCondition; //!< Signalled when the track has released buffers or the renderer is being destroyed
+            bool buffersReleased{}; //!< If the track has released buffers that the render thread hasn't processed yet
+            bool renderExiting{}; //!< If the render thread should exit
+            std::thread renderThread;
+
+            /**
+             * @brief Renders a single quantum of all voices and mixes them together into the supplied part of the sample buffer
+             */
+            void RenderQuantum(span<i16> output);
 
             /**
-             * @brief Obtains new sample data from voices and mixes it together into the sample buffer
-             * @return The amount of samples present in the buffer
+             * @brief Renders all voices into the sample buffer in quanta of RenderQuantumSize frames
+             * @note renderMutex MUST be locked when calling this
              */
             void MixFinalBuffer();
 
             /**
-             * @brief Appends all released buffers with new mixed sample data
+             * @brief Appends all released buffers with new mixed sample data and signals the guest
              */
             void UpdateAudio();
 
+            /**
+             * @brief The entry point of the render thread, this renders a new buffer whenever the track releases one
+             */
+            void RenderThread();
+
           public:
             /**
              * @param parameters The parameters to use for rendering
@@ -3,9 +3,37 @@
 
 #include <kernel/types/KProcess.h>
 #include <audio/downmixer.h>
+#include <arm_neon.h>
+#include <audio/mixer.h>
 #include "voice.h"
 
 namespace skyline::service::audio::IAudioRenderer {
+    /**
+     * @brief Applies a biquad filter to interleaved stereo samples, both channels are filtered in parallel in separate lanes
+     * @note The coefficients are in Q14 fixed point and the feedback coefficients are supplied pre-negated by the guest
+     */
+    static void ApplyBiquadFilter(span<i16> samples, const BiquadFilter &filter, BiquadFilterState &state) {
+        int32x2_t b0{vdup_n_s32(static_cast<i16>(filter.b0))}, b1{vdup_n_s32(static_cast<i16>(filter.b1))}, b2{vdup_n_s32(static_cast<i16>(filter.b2))};
+        int32x2_t a1{vdup_n_s32(static_cast<i16>(filter.a1))}, a2{vdup_n_s32(static_cast<i16>(filter.a2))};
+        int64x2_t s0{vld1q_s64(state.s0.data())}, s1{vld1q_s64(state.s1.data())};
+
+        for (size_t i{}; i + 1 < samples.size(); i += constant::StereoChannelCount) {
+            auto frame{reinterpret_cast<i32 *>(samples.data() + i)};
+            int32x2_t in{vget_low_s32(vmovl_s16(vreinterpret_s16_s32(vld1_dup_s32(frame))))};
+
+            // The output is rounded and saturated to 16 bits prior to being fed back into the state
+            int16x4_t outNarrow{vqmovn_s32(vcombine_s32(vqmovn_s64(vrshrq_n_s64(vmlal_s32(s0, in, b0), 14)), vdup_n_s32(0)))};
+            int32x2_t out{vget_low_s32(vmovl_s16(outNarrow))};
+            vst1_lane_s32(frame, vreinterpret_s32_s16(outNarrow), 0);
+
+            s0 = vmlal_s32(vmlal_s32(s1, in, b1), out, a1);
+            s1 = vmlal_s32(vmull_s32(in, b2), out, a2);
+        }
+
+        vst1q_s64(state.s0.data(), s0);
+        vst1q_s64(state.s1.data(), s1);
+    }
+
     void Voice::SetWaveBufferIndex(u8 index) {
         bufferIndex = index & 3;
         bufferReload = true;
@@ -19,6 +47,8 @@ namespace skyline::service::audio::IAudioRenderer {
             bufferReload = true;
             bufferIndex = 0;
             sampleOffset = 0;
+            resampler.Reset();
+            biquadFilterStates = {};
 
             output.playedSamplesCount = 0;
             output.playedWaveBuffersCount = 0;
@@ -41,12 +71,12 @@ namespace skyline::service::audio::IAudioRenderer {
                 throw exception("Unsupported voice channel count: {}", input.channelCount);
 
             channelCount = static_cast<u8>(input.channelCount);
+            resampler.Reset();
+            biquadFilterStates = {};
 
             if (input.format == skyline::audio::AudioFormat::ADPCM) {
-                std::vector<std::array<i16, 2>> adpcmCoefficients(input.adpcmCoeffsSize / (sizeof(u16) * 2));
-                span(adpcmCoefficients).copy_from(span(input.adpcmCoeffs, input.adpcmCoeffsSize / sizeof(u32)));
-
-                adpcmDecoder = skyline::audio::AdpcmDecoder(std::move(adpcmCoefficients));
+                span<const std::array<i16, 2>> adpcmCoefficients{reinterpret_cast<const std::array<i16, 2> *>(input.adpcmCoeffs), input.adpcmCoeffsSize / sizeof(u32)};
+                adpcmDecoder.emplace(adpcmCoefficients);
             }
 
             SetWaveBufferIndex(static_cast<u8>(input.baseWaveBufferIndex));
@@ -54,6 +84,7 @@ namespace skyline::service::audio::IAudioRenderer {
 
         waveBuffers = input.waveBuffers;
         volume = input.volume;
+        biquadFilters = input.biquadFilters;
         playbackState = input.playbackState;
     }
 
@@ -70,25 +101,24 @@ namespace skyline::service::audio::IAudioRenderer {
                 span(samples).copy_from(buffer);
                 break;
             case skyline::audio::AudioFormat::ADPCM: {
-                samples = adpcmDecoder->Decode(buffer);
+                state.audio->adpcmCache.Decode(*adpcmDecoder, buffer, samples);
                 break;
             }
             default:
                 throw exception("Unsupported PCM format used by Voice: {}", format);
         }
 
-        if (sampleRate != constant::SampleRate)
-            samples = resampler.ResampleBuffer(samples, static_cast<double>(sampleRate) / constant::SampleRate, channelCount);
+        if (sampleRate != constant::SampleRate) {
+            double ratio{static_cast<double>(sampleRate) / constant::SampleRate};
+            scratchSamples.resize(resampler.GetOutputSize(samples.size(), ratio, channelCount));
+            resampler.Resample(samples, scratchSamples, ratio, channelCount);
+            std::swap(samples, scratchSamples);
+        }
 
         if (channelCount == 1 && constant::StereoChannelCount != channelCount) {
-            auto originalSize{samples.size()};
-            samples.resize((originalSize / channelCount) * constant::StereoChannelCount);
-
-            for (auto monoIndex{originalSize - 1}, targetIndex{samples.size()}; monoIndex > 0; monoIndex--) {
-                auto sample{samples[monoIndex]};
-                for (u8 i{}; i < constant::StereoChannelCount; i++)
-                    samples[--targetIndex] = sample;
-            }
+            scratchSamples.resize(samples.size() * constant::StereoChannelCount);
+            skyline::audio::ExpandMonoToStereo(scratchSamples, samples);
+            std::swap(samples, scratchSamples);
         }
 
         if (channelCount == constant::SurroundChannelCount) {
@@ -130,4 +160,23 @@ namespace skyline::service::audio::IAudioRenderer {
 
         return samples;
     }
+
+    size_t Voice::Render(span<i16> output) {
+        size_t written{};
+        while (written < output.size() && Playable()) {
+            u32 offset{}, size{};
+            auto &data{GetBufferData(static_cast<u32>((output.size() - written) / constant::StereoChannelCount), offset, size)};
+            if (!size)
+                break;
+
+            std::memcpy(output.data() + written, data.data() + offset, size * sizeof(i16));
+            written += size;
+        }
+
+        for (size_t i{}; i < biquadFilters.size(); i++)
+            if (biquadFilters[i].enable)
+                ApplyBiquadFilter(output.first(written), biquadFilters[i], biquadFilterStates[i]);
+
+        return written;
+    }
 }
@@ -19,6 +19,14 @@ namespace skyline::service::audio::IAudioRenderer {
     };
     static_assert(sizeof(BiquadFilter) == 0xC);
 
+    /**
+     * @brief The state of a biquad filter for both channels of a stereo stream, this is the transposed direct form II state in Q14 fixed point
+     */
+    struct BiquadFilterState {
+        std::array<i64, 2> s0{};
+        std::array<i64, 2> s1{};
+    };
+
     struct WaveBuffer {
         u8 *pointer;
         u64 size;
@@ -77,8 +85,11 @@ namespace skyline::service::audio::IAudioRenderer {
         const DeviceState &state;
         std::array<WaveBuffer, 4> waveBuffers;
         std::vector<i16> samples; //!< A vector containing processed sample data
+        std::vector<i16> scratchSamples; //!< A vector that processing stages write into prior to being swapped with samples, this avoids reallocating either of them for every wave buffer
         skyline::audio::Resampler resampler; //!< The resampler object used for changing the sample rate of a wave buffer's stream
         std::optional<skyline::audio::AdpcmDecoder> adpcmDecoder;
+        std::array<BiquadFilter, 2> biquadFilters{};
+        std::array<BiquadFilterState, 2> biquadFilterStates{}; //!< The state of each biquad filter, this is retained across rendered quanta
 
         bool acquired{false}; //!< If the voice is in use
         bool bufferReload{true};
@@ -119,6 +130,12 @@ namespace skyline::service::audio::IAudioRenderer {
          */
         std::vector<i16> &GetBufferData(u32 maxSamples, u32 &outOffset, u32 &outSize);
 
+        /**
+         * @brief Renders the voice's stereo samples into the output buffer and applies any enabled biquad filters to them, the volume isn't applied
+         * @return The amount of samples that were written to the start of the output buffer
+         */
+        size_t Render(span<i16> output);
+
         /**
          * @return If the voice is currently playable
          */
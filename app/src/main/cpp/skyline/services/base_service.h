@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <optional>
 #include <kernel/ipc.h>
 
 constexpr static skyline::u32 TipcFunctionIdFlag{1U << 31}; //!< Flag applied to the stored service function ID to differentiate between TIPC and HIPC functions
@@ -19,12 +20,14 @@ Result CallBaseFunction(type::KSession &session, ipc::IpcRequest &request, ipc::
 }                                                                                                              \
 SERVICE_DECL_AUTO(functions, frozen::make_unordered_map({__VA_ARGS__}));                                       \
 protected:                                                                                                     \
-ServiceFunctionDescriptor GetServiceFunction(u32 id, bool isTipc) override {                                   \
-    auto& function{functions.at((isTipc ? TipcFunctionIdFlag : 0U) | id)};                                     \
+std::optional<ServiceFunctionDescriptor> GetServiceFunction(u32 id, bool isTipc) override {                    \
+    auto function{functions.find((isTipc ? TipcFunctionIdFlag : 0U) | id)};                                    \
+    if (function == functions.end())                                                                           \
+        return std::nullopt;                                                                                   \
     return ServiceFunctionDescriptor{                                                                          \
         reinterpret_cast<DerivedService*>(this),                                                               \
-        reinterpret_cast<decltype(ServiceFunctionDescriptor::function)>(function.first),                       \
-        function.second                                                                                        \
+        reinterpret_cast<decltype(ServiceFunctionDescriptor::function)>(function->second.first),               \
+        function->second.second                                                                                \
     };                                                                                                         \
 }
 #define SRVREG(class, ...) std::make_shared<class>(state, manager, ##__VA_ARGS__)
@@ -73,8 +76,12 @@ namespace skyline::service {
          */
         virtual ~BaseService() = default;
 
-        virtual ServiceFunctionDescriptor GetServiceFunction(u32 id, bool isTipc) {
-            throw std::out_of_range("GetServiceFunction not implemented");
+        /**
+         * @return The descriptor of the service function with the supplied ID or std::nullopt if there's no such function
+         * @note This doesn't throw as unimplemented functions are frequently called by the guest
+         */
+        virtual std::optional<ServiceFunctionDescriptor> GetServiceFunction(u32 id, bool isTipc) {
+            return std::nullopt;
         }
 
         /**
@@ -2,6 +2,7 @@
 // Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
 #include <services/timesrv/common.h>
+#include <common/thread_pool.h>
 #include <kernel/types/KProcess.h>
 
 #include "IHardwareOpusDecoder.h"
@@ -11,20 +12,168 @@ namespace skyline::service::codec {
         return util::AlignUp(static_cast<u32>(frameSize * channelCount / (OpusFullbandSampleRate / sampleRate)), 0x40);
     }
 
+    u32 CalculateMultiStreamDecoderSize(i32 streamCount, i32 stereoStreamCount) {
+        // Every decoder state is aligned so they can be placed consecutively in the work buffer
+        return static_cast<u32>(stereoStreamCount) * util::AlignUp(static_cast<u32>(opus_decoder_get_size(2)), 0x10) +
+            static_cast<u32>(streamCount - stereoStreamCount) * util::AlignUp(static_cast<u32>(opus_decoder_get_size(1)), 0x10);
+    }
+
+    /**
+     * @brief The pool used to decode the streams of multi-stream packets in parallel, it's shared by all decoders
+     */
+    static ThreadPool &GetDecodePool() {
+        static ThreadPool pool{"Sky-Opus", std::clamp(std::thread::hardware_concurrency() / 2, 1U, 4U)};
+        return pool;
+    }
+
+    /**
+     * @brief Reads an Opus frame length which is encoded in one or two bytes
+     * @url https://datatracker.ietf.org/doc/html/rfc6716#section-3.2.1
+     */
+    static size_t ReadFrameLength(span<const u8> data, size_t &offset) {
+        if (offset >= data.size())
+            throw exception("Opus packet is truncated at 0x{:X}", offset);
+        size_t length{data[offset++]};
+        if (length < 252)
+            return length;
+
+        if (offset >= data.size())
+            throw exception("Opus packet is truncated at 0x{:X}", offset);
+        return length + (static_cast<size_t>(data[offset++]) * 4);
+    }
+
+    /**
+     * @brief Converts a self-delimited Opus packet at the start of the data into a regular packet by removing its self-delimiting length
+     * @param packet The vector to write the regular packet into
+     * @return The size of the self-delimited packet in the data
+     * @url https://datatracker.ietf.org/doc/html/rfc6716#appendix-B
+     */
+    static size_t ParseSelfDelimitedPacket(span<const u8> data, std::vector<u8> &packet) {
+        if (data.empty())
+            throw exception("Opus multi-stream packet is missing a stream");
+
+        size_t offset{1}, lengthStart, lengthEnd, payloadSize;
+        switch (data[0] & 0x3) {
+            case 0: // A single frame
+            case 1: { // Two frames of equal size
+                lengthStart = offset;
+                size_t length{ReadFrameLength(data, offset)};
+                lengthEnd = offset;
+                payloadSize = (data[0] & 0x3) ? length * 2 : length;
+                break;
+            }
+
+            case 2: { // Two frames of different sizes, the length of the second frame is the self-delimiting length
+                size_t firstLength{ReadFrameLength(data, offset)};
+                lengthStart = offset;
+                size_t secondLength{ReadFrameLength(data, offset)};
+                lengthEnd = offset;
+                payloadSize = firstLength + secondLength;
+                break;
+            }
+
+            default: { // An arbitrary amount of frames
+                if (offset >= data.size())
+                    throw exception("Opus packet is truncated at 0x{:X}", offset);
+                u8 frameCountByte{data[offset++]};
+                size_t frameCount{static_cast<size_t>(frameCountByte & 0x3F)};
+                if (!frameCount)
+                    throw exception("Opus packet has no frames");
+
+                size_t paddingSize{};
+                if (frameCountByte & 0x40) {
+                    u8 paddingByte;
+                    do {
+                        if (offset >= data.size())
+                            throw exception("Opus packet is truncated at 0x{:X}", offset);
+                        paddingByte = data[offset++];
+                        paddingSize += (paddingByte == 255) ? 254 : paddingByte;
+                    } while (paddingByte == 255);
+                }
+
+                if (frameCountByte & 0x80) {
+                    // VBR frames have the lengths of all frames but the last one, the last one's length is the self-delimiting length
+                    size_t framesSize{};
+                    for (size_t frame{}; frame < frameCount - 1; frame++)
+                        framesSize += ReadFrameLength(data, offset);
+                    lengthStart = offset;
+                    framesSize += ReadFrameLength(data, offset);
+                    lengthEnd = offset;
+                    payloadSize = framesSize + paddingSize;
+                } else {
+                    // CBR frames only have the self-delimiting length which applies to all frames
+                    lengthStart = offset;
+                    payloadSize = (ReadFrameLength(data, offset) * frameCount) + paddingSize;
+                    lengthEnd = offset;
+                }
+                break;
+            }
+        }
+
+        size_t size{lengthEnd + payloadSize};
+        if (size > data.size())
+            throw exception("Opus self-delimited packet size exceeds the multi-stream packet: 0x{:X} > 0x{:X}", size, data.size());
+
+        packet.assign(data.begin(), data.begin() + static_cast<ssize_t>(lengthStart));
+        packet.insert(packet.end(), data.begin() + static_cast<ssize_t>(lengthEnd), data.begin() + static_cast<ssize_t>(size));
+        return size;
+    }
+
     IHardwareOpusDecoder::IHardwareOpusDecoder(const DeviceState &state, ServiceManager &manager, i32 sampleRate, i32 channelCount, u32 workBufferSize, KHandle workBufferHandle, bool isIsLargerSize)
         : BaseService(state, manager),
+          workBuffer(state.process->GetHandle<kernel::type::KTransferMemory>(workBufferHandle)),
+          multiStream(false),
           sampleRate(sampleRate),
           channelCount(channelCount),
-          workBuffer(state.process->GetHandle<kernel::type::KTransferMemory>(workBufferHandle)),
-          decoderOutputBufferSize(CalculateOutBufferSize(sampleRate, channelCount, isIsLargerSize ? MaxFrameSizeEx : MaxFrameSizeNormal)) {
+          maxFrameSize((isIsLargerSize ? MaxFrameSizeEx : MaxFrameSizeNormal) / (OpusFullbandSampleRate / sampleRate)) {
+        u32 decoderOutputBufferSize{CalculateOutBufferSize(sampleRate, channelCount, isIsLargerSize ? MaxFrameSizeEx : MaxFrameSizeNormal)};
         if (workBufferSize < decoderOutputBufferSize)
             throw exception("Work Buffer doesn't have adequate space for Opus Decoder: 0x{:X} (Required: 0x{:X})", workBufferSize, decoderOutputBufferSize);
 
         // We utilize the guest-supplied work buffer for allocating the OpusDecoder object into
-        decoderState = reinterpret_cast<OpusDecoder *>(workBuffer->host.data());
+        auto decoderState{reinterpret_cast<OpusDecoder *>(workBuffer->host.data())};
 
-        if (int result = opus_decoder_init(decoderState, sampleRate, channelCount) != OPUS_OK)
+        if (int result{opus_decoder_init(decoderState, sampleRate, channelCount)}; result != OPUS_OK)
             throw OpusException(result);
+
+        streams.push_back(OpusStream{decoderState, channelCount});
+    }
+
+    IHardwareOpusDecoder::IHardwareOpusDecoder(const DeviceState &state, ServiceManager &manager, i32 sampleRate, i32 channelCount, i32 streamCount, i32 pStereoStreamCount, span<const u8> pMappings, u32 workBufferSize, KHandle workBufferHandle)
+        : BaseService(state, manager),
+          workBuffer(state.process->GetHandle<kernel::type::KTransferMemory>(workBufferHandle)),
+          multiStream(true),
+          stereoStreamCount(pStereoStreamCount),
+          sampleRate(sampleRate),
+          channelCount(channelCount),
+          maxFrameSize(MaxFrameSizeNormal / (OpusFullbandSampleRate / sampleRate)) {
+        if (streamCount < 1 || stereoStreamCount < 0 || stereoStreamCount > streamCount || channelCount < 1 || static_cast<size_t>(channelCount) > pMappings.size())
+            throw exception("Invalid Opus multi-stream layout: {} channels, {} streams ({} stereo)", channelCount, streamCount, stereoStreamCount);
+
+        u32 decoderSize{CalculateMultiStreamDecoderSize(streamCount, stereoStreamCount)};
+        if (workBufferSize < decoderSize || workBuffer->host.size() < decoderSize)
+            throw exception("Work Buffer doesn't have adequate space for Opus Multi-Stream Decoder: 0x{:X} (Required: 0x{:X})", workBufferSize, decoderSize);
+
+        std::copy_n(pMappings.begin(), channelCount, mappings.begin());
+        for (i32 channel{}; channel < channelCount; channel++)
+            if (mappings[channel] != 255 && mappings[channel] >= streamCount + stereoStreamCount)
+                throw exception("Invalid Opus multi-stream mapping for channel {}: {}", channel, mappings[channel]);
+
+        // Every stream is decoded separately with its own decoder state in the work buffer, coupled (stereo) streams always come first
+        u8 *decoderPointer{workBuffer->host.data()};
+        for (i32 stream{}; stream < streamCount; stream++) {
+            i32 streamChannelCount{stream < stereoStreamCount ? 2 : 1};
+            auto decoderState{reinterpret_cast<OpusDecoder *>(decoderPointer)};
+            if (int result{opus_decoder_init(decoderState, sampleRate, streamChannelCount)}; result != OPUS_OK)
+                throw OpusException(result);
+
+            streams.push_back(OpusStream{
+                .decoder = decoderState,
+                .channelCount = streamChannelCount,
+                .samples = std::vector<opus_int16>(static_cast<size_t>(maxFrameSize * streamChannelCount)),
+            });
+            decoderPointer += util::AlignUp(static_cast<u32>(opus_decoder_get_size(streamChannelCount)), 0x10);
+        }
     }
 
     Result IHardwareOpusDecoder::DecodeInterleavedOld(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
@@ -44,32 +193,123 @@ namespace skyline::service::codec {
     }
 
     void IHardwareOpusDecoder::ResetContext() {
-        opus_decoder_ctl(decoderState, OPUS_RESET_STATE);
+        for (auto &stream : streams)
+            opus_decoder_ctl(stream.decoder, OPUS_RESET_STATE);
+    }
+
+    i32 IHardwareOpusDecoder::DecodeMultiStreamPacket(span<u8> packet, span<opus_int16> output) {
+        // All streams but the last use self-delimited framing, the last stream is the remainder of the packet
+        size_t offset{};
+        for (size_t stream{}; stream < streams.size() - 1; stream++)
+            offset += ParseSelfDelimitedPacket(packet.subspan(offset), streams[stream].packet);
+        streams.back().packet.assign(packet.begin() + static_cast<ssize_t>(offset), packet.end());
+
+        i32 frameSize{std::min(maxFrameSize, static_cast<i32>(output.size() / static_cast<size_t>(channelCount)))};
+        auto decodeStream{[frameSize](OpusStream &stream) {
+            i32 decodedCount{opus_decode(stream.decoder, stream.packet.data(), static_cast<opus_int32>(stream.packet.size()), stream.samples.data(), frameSize, false)};
+            if (decodedCount < 0)
+                throw OpusException(decodedCount);
+            return decodedCount;
+        }};
+
+        // The first stream is decoded on this thread while the others are decoded on the pool, all of them must be waited on as they write into stream buffers
+        std::vector<std::future<i32>> futures;
+        futures.reserve(streams.size() - 1);
+        for (size_t stream{1}; stream < streams.size(); stream++)
+            futures.emplace_back(GetDecodePool().Submit([&decodeStream, &stream = streams[stream]] { return decodeStream(stream); }));
+
+        std::exception_ptr error;
+        i32 decodedCount{};
+        try {
+            decodedCount = decodeStream(streams.front());
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        for (auto &future : futures) {
+            try {
+                if (i32 streamCount{future.get()}; streamCount != decodedCount && !error)
+                    throw exception("Opus multi-stream packet has streams with differing sample counts: {} and {}", decodedCount, streamCount);
+            } catch (...) {
+                if (!error)
+                    error = std::current_exception();
+            }
+        }
+
+        if (error)
+            std::rethrow_exception(error);
+
+        // Every output channel is written directly into the interleaved output from the stream and channel it's mapped to
+        for (i32 channel{}; channel < channelCount; channel++) {
+            u8 mapping{mappings[channel]};
+            auto destination{output.data() + channel};
+            if (mapping == 255) {
+                for (i32 sample{}; sample < decodedCount; sample++)
+                    destination[sample * channelCount] = 0;
+                continue;
+            }
+
+            size_t streamIndex{mapping < stereoStreamCount * 2 ? mapping / 2U : static_cast<size_t>(mapping - stereoStreamCount)};
+            auto &stream{streams[streamIndex]};
+            auto source{stream.samples.data() + (mapping < stereoStreamCount * 2 ? mapping % 2 : 0)};
+            for (i32 sample{}; sample < decodedCount; sample++)
+                destination[sample * channelCount] = source[sample * stream.channelCount];
+        }
+
+        return decodedCount;
+    }
+
+    i32 IHardwareOpusDecoder::DecodePacket(span<u8> packet, span<opus_int16> output) {
+        if (multiStream)
+            return DecodeMultiStreamPacket(packet, output);
+
+        i32 frameSize{std::min(maxFrameSize, static_cast<i32>(output.size() / static_cast<size_t>(channelCount)))};
+        i32 decodedCount{opus_decode(streams.front().decoder, packet.data(), static_cast<opus_int32>(packet.size()), output.data(), frameSize, false)};
+        if (decodedCount < 0)
+            throw OpusException(decodedCount);
+        return decodedCount;
     }
 
     Result IHardwareOpusDecoder::DecodeInterleavedImpl(ipc::IpcRequest &request, ipc::IpcResponse &response, bool writeDecodeTime) {
         auto dataIn{request.inputBuf.at(0)};
-        auto dataOut{request.outputBuf.at(0).cast<opus_int16>()};
+        span<opus_int16> dataOut{request.outputBuf.at(0).cast<opus_int16>()};
 
         if (dataIn.size() <= sizeof(OpusDataHeader))
             throw exception("Incorrect Opus data size: 0x{:X} (Should be > 0x{:X})", dataIn.size(), sizeof(OpusDataHeader));
 
-        i32 opusPacketSize{dataIn.as<OpusDataHeader>().GetPacketSize()};
-        i32 requiredInSize{opusPacketSize + static_cast<i32>(sizeof(OpusDataHeader))};
-        if (opusPacketSize > MaxInputBufferSize || dataIn.size() < requiredInSize)
-            throw exception("Opus packet size mismatch: 0x{:X} (Requested: 0x{:X})", dataIn.size() - sizeof(OpusDataHeader), opusPacketSize);
+        auto perfTimer{timesrv::TimeSpanType::FromNanoseconds(util::GetTimeNs())};
+
+        // Packets are decoded directly into the guest output buffer, any packets after the first are only decoded if they're complete and all of their samples fit
+        size_t consumedSize{};
+        i32 decodedCount{};
+        do {
+            auto packetIn{dataIn.subspan(consumedSize)};
+            i32 opusPacketSize{packetIn.as<OpusDataHeader>().GetPacketSize()};
+            size_t requiredInSize{static_cast<size_t>(opusPacketSize) + sizeof(OpusDataHeader)};
+            bool first{consumedSize == 0};
+            if (opusPacketSize < 0 || opusPacketSize > MaxInputBufferSize || packetIn.size() < requiredInSize) {
+                if (first)
+                    throw exception("Opus packet size mismatch: 0x{:X} (Requested: 0x{:X})", packetIn.size() - sizeof(OpusDataHeader), opusPacketSize);
+                break;
+            }
 
-        // Skip past the header in the input buffer to get the Opus packet
-        auto sampleDataIn = dataIn.subspan(sizeof(OpusDataHeader));
+            // Skip past the header in the input buffer to get the Opus packet
+            auto packet{packetIn.subspan(sizeof(OpusDataHeader), static_cast<size_t>(opusPacketSize))};
+            if (!first) {
+                int packetSamples{opus_packet_get_nb_samples(packet.data(), static_cast<opus_int32>(packet.size()), sampleRate)};
+                if (packetSamples <= 0 || static_cast<size_t>(packetSamples) * static_cast<size_t>(channelCount) > dataOut.size())
+                    break;
+            }
 
-        auto perfTimer{timesrv::TimeSpanType::FromNanoseconds(util::GetTimeNs())};
-        i32 decodedCount{opus_decode(decoderState, sampleDataIn.data(), opusPacketSize, dataOut.data(), static_cast<int>(decoderOutputBufferSize), false)};
-        perfTimer = timesrv::TimeSpanType::FromNanoseconds(util::GetTimeNs()) - perfTimer;
+            i32 packetDecodedCount{DecodePacket(packet, dataOut)};
+            dataOut = dataOut.subspan(static_cast<size_t>(packetDecodedCount) * static_cast<size_t>(channelCount));
+            decodedCount += packetDecodedCount;
+            consumedSize += requiredInSize;
+        } while (consumedSize + sizeof(OpusDataHeader) < dataIn.size());
 
-        if (decodedCount < 0)
-            throw OpusException(decodedCount);
+        perfTimer = timesrv::TimeSpanType::FromNanoseconds(util::GetTimeNs()) - perfTimer;
 
-        response.Push(requiredInSize); // Decoded data size is equal to opus packet size + header
+        response.Push(static_cast<i32>(consumedSize)); // Decoded data size is equal to the size of all opus packets + headers
         response.Push(decodedCount);
         if (writeDecodeTime)
             response.Push<i64>(perfTimer.Microseconds());
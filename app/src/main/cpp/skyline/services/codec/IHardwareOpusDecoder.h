@@ -15,6 +15,11 @@ namespace skyline::service::codec {
      */
     u32 CalculateOutBufferSize(i32 sampleRate, i32 channelCount, i32 frameSize);
 
+    /**
+     * @return The size required in the work buffer for the decoder states of every stream in a multi-stream Opus decoder
+     */
+    u32 CalculateMultiStreamDecoderSize(i32 streamCount, i32 stereoStreamCount);
+
     static constexpr i32 OpusFullbandSampleRate{48000};
     static constexpr i32 MaxFrameSizeNormal{static_cast<u32>(OpusFullbandSampleRate * 0.040f)}; //!< 40ms frame size limit for normal decoders
     static constexpr i32 MaxFrameSizeEx{static_cast<u32>(OpusFullbandSampleRate * 0.120f)}; //!< 120ms frame size limit for ex decoders added in 12.0.0
@@ -26,11 +31,24 @@ namespace skyline::service::codec {
      */
     class IHardwareOpusDecoder : public BaseService {
       private:
+        /**
+         * @brief A single elementary Opus stream of a (potentially multi-stream) decoder
+         */
+        struct OpusStream {
+            OpusDecoder *decoder; //!< The decoder state, this is allocated in the guest-supplied work buffer
+            i32 channelCount; //!< The amount of channels in the stream, this is 2 for coupled streams and 1 otherwise
+            std::vector<u8> packet; //!< The stream's packet within the current multi-stream packet, converted from self-delimited framing
+            std::vector<opus_int16> samples; //!< The decoded samples of the stream prior to being mapped to the output channels
+        };
+
         std::shared_ptr<kernel::type::KTransferMemory> workBuffer;
-        OpusDecoder *decoderState{};
+        std::vector<OpusStream> streams;
+        bool multiStream; //!< If the streams are decoded separately and mapped to the output channels, otherwise there's a single stream which is decoded directly into the output
+        i32 stereoStreamCount{};
+        std::array<u8, 0x100> mappings{}; //!< The decoded channel that each output channel is mapped to, this follows the Opus multi-stream channel mapping semantics
         i32 sampleRate;
         i32 channelCount;
-        u32 decoderOutputBufferSize;
+        i32 maxFrameSize; //!< The maximum amount of samples per channel in a single packet
 
         /**
          * @brief Holds information about the Opus packet to be decoded
@@ -52,14 +70,32 @@ namespace skyline::service::codec {
          */
         void ResetContext();
 
+        /**
+         * @brief Decodes a multi-stream packet by splitting it into the packets of every stream, the streams are decoded in parallel and then mapped to the output channels
+         * @return The amount of samples per channel that were decoded
+         */
+        i32 DecodeMultiStreamPacket(span<u8> packet, span<opus_int16> output);
+
+        /**
+         * @brief Decodes a single Opus packet into the output buffer
+         * @return The amount of samples per channel that were decoded
+         */
+        i32 DecodePacket(span<u8> packet, span<opus_int16> output);
+
         /**
          * @brief Decodes Opus source data via libopus
+         * @note Every complete packet in the input buffer is decoded in a single pass as long as its samples fit into the output buffer, the guest observes this through the returned consumed size and sample count
          */
         Result DecodeInterleavedImpl(ipc::IpcRequest &request, ipc::IpcResponse &response, bool writeDecodeTime = false);
 
       public:
         IHardwareOpusDecoder(const DeviceState &state, ServiceManager &manager, i32 sampleRate, i32 channelCount, u32 workBufferSize, KHandle workBufferHandle, bool isIsLargerSize = false);
 
+        /**
+         * @brief Creates a multi-stream decoder with the supplied stream layout and channel mappings
+         */
+        IHardwareOpusDecoder(const DeviceState &state, ServiceManager &manager, i32 sampleRate, i32 channelCount, i32 streamCount, i32 stereoStreamCount, span<const u8> mappings, u32 workBufferSize, KHandle workBufferHandle);
+
         /**
          * @brief Decodes the Opus source data, returns decoded data size and decoded sample count
          * @url https://switchbrew.org/wiki/Audio_services#DecodeInterleavedOld
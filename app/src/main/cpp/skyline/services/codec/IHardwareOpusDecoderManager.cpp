@@ -33,6 +33,28 @@ namespace skyline::service::codec {
         return {};
     }
 
+    static u32 CalculateMultiStreamBufferSize(const MultiStreamParameters &parameters) {
+        u32 requiredSize{CalculateMultiStreamDecoderSize(parameters.streamCount, parameters.stereoStreamCount)};
+        requiredSize += MaxInputBufferSize + CalculateOutBufferSize(parameters.sampleRate, parameters.channelCount, MaxFrameSizeNormal);
+        return requiredSize;
+    }
+
+    Result IHardwareOpusDecoderManager::OpenHardwareOpusDecoderForMultiStream(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        u32 workBufferSize{request.Pop<u32>()};
+        KHandle workBuffer{request.copyHandles.at(0)};
+        const auto &parameters{request.inputBuf.at(0).as<MultiStreamParameters>()};
+
+        Logger::Debug("Creating Opus multi-stream decoder: Sample rate: {}, Channel count: {}, Streams: {} ({} stereo), Work buffer handle: 0x{:X} (Size: 0x{:X})", parameters.sampleRate, parameters.channelCount, parameters.streamCount, parameters.stereoStreamCount, workBuffer, workBufferSize);
+
+        manager.RegisterService(std::make_shared<IHardwareOpusDecoder>(state, manager, parameters.sampleRate, parameters.channelCount, parameters.streamCount, parameters.stereoStreamCount, parameters.mappings, workBufferSize, workBuffer), session, response);
+        return {};
+    }
+
+    Result IHardwareOpusDecoderManager::GetWorkBufferSizeForMultiStream(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        response.Push<u32>(CalculateMultiStreamBufferSize(request.inputBuf.at(0).as<MultiStreamParameters>()));
+        return {};
+    }
+
     Result IHardwareOpusDecoderManager::OpenHardwareOpusDecoderEx(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
         i32 sampleRate{request.Pop<i32>()};
         i32 channelCount{request.Pop<i32>()};
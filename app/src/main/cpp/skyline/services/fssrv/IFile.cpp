@@ -2,6 +2,7 @@
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
 #include "results.h"
+#include "parallel_read.h"
 #include "IFile.h"
 
 namespace skyline::service::fssrv {
@@ -25,7 +26,7 @@ namespace skyline::service::fssrv {
             return result::InvalidSize;
         }
 
-        response.Push<u64>(backing->ReadUnchecked(request.outputBuf.at(0), static_cast<size_t>(offset)));
+        response.Push<u64>(ParallelRead(*backing, request.outputBuf.at(0), static_cast<size_t>(offset)));
         return {};
     }
 
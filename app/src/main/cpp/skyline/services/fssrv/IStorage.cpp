@@ -2,6 +2,7 @@
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
 #include "results.h"
+#include "parallel_read.h"
 #include "IStorage.h"
 
 namespace skyline::service::fssrv {
@@ -21,7 +22,12 @@ namespace skyline::service::fssrv {
             return result::InvalidSize;
         }
 
-        backing->Read(request.outputBuf.at(0), static_cast<size_t>(offset));
+        auto output{request.outputBuf.at(0)};
+        if (static_cast<size_t>(offset) > backing->size || (backing->size - static_cast<size_t>(offset)) < output.size())
+            throw exception("Trying to read past the end of a storage: 0x{:X}/0x{:X} (Offset: 0x{:X})", output.size(), backing->size, offset);
+
+        if (ParallelRead(*backing, output, static_cast<size_t>(offset)) != output.size())
+            Logger::Warn("Failed to read the requested size from backing");
         return {};
     }
 
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <common/thread_pool.h>
+#include <common/trace.h>
+#include "parallel_read.h"
+
+namespace skyline::service::fssrv {
+    /**
+     * @note The pool is shared by all filesystem sessions as the host storage is shared, its threads are only spawned on the first large read
+     */
+    static ThreadPool &GetReadPool() {
+        static ThreadPool pool{"Sky-FsRead", std::clamp(std::thread::hardware_concurrency() / 2, 1U, 4U)};
+        return pool;
+    }
+
+    size_t ParallelRead(vfs::Backing &backing, span<u8> output, size_t offset) {
+        if (offset >= backing.size)
+            return 0;
+        output = output.first(std::min(output.size(), backing.size - offset));
+
+        if (output.size() < ParallelReadChunkSize * 2)
+            return backing.ReadUnchecked(output, offset);
+
+        TRACE_EVENT("service", "fssrv::ParallelRead", "size", output.size());
+
+        auto &pool{GetReadPool()};
+        size_t chunkCount{std::min(util::DivideCeil(output.size(), ParallelReadChunkSize), pool.GetThreadCount() + 1)};
+        size_t chunkSize{util::AlignUp(util::DivideCeil(output.size(), chunkCount), constant::PageSize)};
+
+        std::vector<std::future<size_t>> futures;
+        futures.reserve(chunkCount - 1);
+        for (size_t chunkOffset{chunkSize}; chunkOffset < output.size(); chunkOffset += chunkSize)
+            futures.emplace_back(pool.Submit([&backing, chunk = output.subspan(chunkOffset, std::min(chunkSize, output.size() - chunkOffset)), chunkOffset, offset] {
+                return backing.ReadUnchecked(chunk, offset + chunkOffset);
+            }));
+
+        // Every chunk must be waited on even if a prior one failed as they all write into the output buffer
+        std::exception_ptr exception;
+        size_t readSize{};
+        bool contiguous{};
+        try {
+            readSize = backing.ReadUnchecked(output.first(chunkSize), offset);
+            contiguous = readSize == chunkSize;
+        } catch (...) {
+            exception = std::current_exception();
+        }
+
+        for (size_t index{}; index < futures.size(); index++) {
+            try {
+                size_t chunkRead{futures[index].get()};
+                if (contiguous) {
+                    readSize += chunkRead;
+                    contiguous = chunkRead == std::min(chunkSize, output.size() - (index + 1) * chunkSize);
+                }
+            } catch (...) {
+                if (!exception)
+                    exception = std::current_exception();
+            }
+        }
+
+        if (exception)
+            std::rethrow_exception(exception);
+
+        return readSize;
+    }
+}
@@ -0,0 +1,17 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <vfs/backing.h>
+
+namespace skyline::service::fssrv {
+    constexpr size_t ParallelReadChunkSize{0x80000}; //!< The size of the chunks that large reads are split into, reads smaller than twice this are done on the calling thread
+
+    /**
+     * @brief Reads from a backing with large reads being split into chunks that are read and decrypted concurrently on a shared pool of worker threads
+     * @note The calling thread reads the first chunk itself and blocks till all other chunks have been read
+     * @return The amount of contiguous bytes read from the offset, this matches the semantics of Backing::ReadUnchecked
+     */
+    size_t ParallelRead(vfs::Backing &backing, span<u8> output, size_t offset);
+}
@@ -6,6 +6,7 @@
 #include <gpu.h>
 #include <gpu/texture/format.h>
 #include <soc.h>
+#include <input.h>
 #include <services/nvdrv/devices/nvmap.h>
 #include <services/common/fence.h>
 #include "GraphicBufferProducer.h"
@@ -13,6 +14,22 @@
 namespace skyline::service::hosbinder {
     GraphicBufferProducer::GraphicBufferProducer(const DeviceState &state, nvdrv::core::NvMap &nvMap) : state(state), bufferEvent(std::make_shared<kernel::type::KEvent>(state, true)), nvMap(nvMap) {}
 
+    u64 GraphicBufferProducer::HashBuffers(u64 seed) {
+        std::scoped_lock lock(mutex);
+        std::array<u64, 6> queueState{activeSlotCount, preallocatedBufferCount, defaultWidth, defaultHeight, static_cast<u64>(defaultFormat), static_cast<u64>(connectedApi)};
+        seed = XXH64(queueState.data(), sizeof(queueState), seed);
+
+        for (const auto &slot : queue) {
+            std::array<u64, 4> slotState{slot.isPreallocated, slot.graphicBuffer != nullptr};
+            if (slot.graphicBuffer) {
+                slotState[2] = slot.graphicBuffer->id;
+                slotState[3] = slot.graphicBuffer->graphicHandle.nvmapId;
+            }
+            seed = XXH64(slotState.data(), sizeof(slotState), seed);
+        }
+        return seed;
+    }
+
     void GraphicBufferProducer::FreeGraphicBufferNvMap(GraphicBuffer &buffer) {
         auto surface{buffer.graphicHandle.surfaces.at(0)};
         u32 nvMapHandleId{surface.nvmapHandle ? surface.nvmapHandle : buffer.graphicHandle.nvmapId};
@@ -42,6 +59,12 @@ namespace skyline::service::hosbinder {
         return AndroidStatus::Ok;
     }
 
+    void GraphicBufferProducer::SignalFreeSlot() {
+        freeSequence.fetch_add(1);
+        if (freeWaiterCount.load())
+            freeSequence.notify_one();
+    }
+
     AndroidStatus GraphicBufferProducer::SetBufferCount(i32 count) {
         std::scoped_lock lock(mutex);
         if (count >= MaxSlotCount) [[unlikely]] {
@@ -94,7 +117,7 @@ namespace skyline::service::hosbinder {
 
         std::unique_lock lock{mutex};
         auto buffer{queue.end()};
-        freeCondition.wait(lock, [&]() {
+        auto findFreeSlot{[&]() {
             size_t dequeuedSlotCount{};
             for (auto it{queue.begin()}; it != std::min(queue.begin() + activeSlotCount, queue.end()); it++) {
                 // We want to select the oldest slot that's free to use as we'd want all slots to be used
@@ -118,7 +141,21 @@ namespace skyline::service::hosbinder {
 
             buffer = queue.end();
             return false;
-        });
+        }};
+
+        while (true) {
+            // The sequence is loaded prior to searching the queue so any slot freed after the search will cause the wait to return immediately
+            u32 sequence{freeSequence.load()};
+            if (findFreeSlot())
+                break;
+
+            // Slots are freed by the presentation thread without locking the queue, the queue is unlocked while waiting so it doesn't contend with other calls
+            lock.unlock();
+            freeWaiterCount.fetch_add(1);
+            freeSequence.wait(sequence);
+            freeWaiterCount.fetch_sub(1);
+            lock.lock();
+        }
 
         if (slot == InvalidGraphicBufferSlot) [[unlikely]]
             return AndroidStatus::InvalidOperation;
@@ -287,7 +324,6 @@ namespace skyline::service::hosbinder {
 
         if (!buffer.texture) [[unlikely]] {
             // We lazily create a texture if one isn't present at queue time, this allows us to look up the texture in the texture cache
-            // If we deterministically know that the texture is written by the CPU then we can allocate a CPU-shared host texture for fast uploads
 
             auto &handle{graphicBuffer.graphicHandle};
             if (handle.magic != NvGraphicHandle::Magic)
@@ -345,8 +381,11 @@ namespace skyline::service::hosbinder {
             gpu::GuestTexture guestTexture(span<u8>{}, dimensions, format, tileConfig, vk::ImageViewType::e2D);
             guestTexture.mappings[0] = span<u8>(nvMapHandleObj->GetPointer() + surface.offset, guestTexture.GetLayerStride());
 
+            // Pitch-linear buffers are practically always written by the CPU (software renderers and video decoding) as the GPU renders into block-linear surfaces, a CPU-shared host texture is allocated for these to allow for fast uploads
+            bool cpuShared{surface.layout == NvSurfaceLayout::Pitch};
+
             std::scoped_lock channelLock{state.gpu->channelLock};
-            buffer.texture = state.gpu->texture.FindOrCreate(guestTexture);
+            buffer.texture = state.gpu->texture.FindOrCreate(guestTexture, {}, false, cpuShared);
         }
 
         switch (transform) {
@@ -383,17 +422,17 @@ namespace skyline::service::hosbinder {
                 throw exception("Application attempting to perform unknown sticky transformation: {:#b}", static_cast<u32>(stickyTransform));
         }
 
-        state.gpu->presentation.Present(buffer.texture, isAutoTimestamp ? 0 : timestamp, swapInterval, crop, scalingMode, transform, fence, [this, &buffer] {
-            std::unique_lock lock{mutex};
+        // The slot must be queued prior to presentation as the callback can free it on the presentation thread at any point after
+        buffer.state = BufferState::Queued;
+        buffer.frameNumber = ++frameNumber;
 
+        state.gpu->presentation.Present(buffer.texture, isAutoTimestamp ? 0 : timestamp, swapInterval, crop, scalingMode, transform, fence, [this, &buffer] {
+            // The queue isn't locked here to avoid contending with the guest thread which is likely inside DequeueBuffer or QueueBuffer at the same time
             buffer.state = BufferState::Free;
             bufferEvent->Signal();
-
-            freeCondition.notify_all();
+            SignalFreeSlot();
         });
-
-        buffer.state = BufferState::Queued;
-        buffer.frameNumber = ++frameNumber;
+        state.input->OnGuestPresent();
 
         width = defaultWidth;
         height = defaultHeight;
@@ -422,6 +461,7 @@ namespace skyline::service::hosbinder {
         buffer.state = BufferState::Free;
         buffer.frameNumber = 0;
         bufferEvent->Signal();
+        SignalFreeSlot();
 
         Logger::Debug("#{}", slot);
     }
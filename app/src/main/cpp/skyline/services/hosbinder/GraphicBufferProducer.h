@@ -40,7 +40,7 @@ namespace skyline::service::hosbinder {
      * @url https://cs.android.com/android/platform/superproject/+/android-5.1.1_r38:frameworks/native/include/gui/BufferSlot.h;l=32-138
      */
     struct BufferSlot {
-        BufferState state{BufferState::Free};
+        std::atomic<BufferState> state{BufferState::Free}; //!< This is atomic as slots are freed by the presentation thread without locking the queue
         u64 frameNumber{}; //!< The amount of frames that have been queued using this slot
         bool wasBufferRequested{}; //!< If GraphicBufferProducer::RequestBuffer has been called with this buffer
         bool isPreallocated{}; //!< If this slot's graphic buffer has been preallocated or attached
@@ -61,7 +61,8 @@ namespace skyline::service::hosbinder {
       private:
         const DeviceState &state;
         std::mutex mutex; //!< Synchronizes access to the buffer queue
-        std::condition_variable freeCondition; //!< Used to wait for a free buffer slot
+        std::atomic<u32> freeSequence{}; //!< Incremented whenever a slot may have become free, DequeueBuffer waits on this changing when there are no free slots
+        std::atomic<u32> freeWaiterCount{}; //!< The amount of threads waiting on freeSequence, this avoids a futex wake when nobody is waiting
         constexpr static u8 MaxSlotCount{16}; //!< The maximum amount of buffer slots that a buffer queue can hold, Android supports 64 but they go unused for applications like games so we've lowered this to 16 (https://cs.android.com/android/platform/superproject/+/android-5.1.1_r38:frameworks/native/include/gui/BufferQueueDefs.h;l=29)
         std::array<BufferSlot, MaxSlotCount> queue;
         u8 activeSlotCount{}; //!< The amount of slots in the queue that can be dequeued
@@ -75,6 +76,12 @@ namespace skyline::service::hosbinder {
 
         void FreeGraphicBufferNvMap(GraphicBuffer &buffer);
 
+        /**
+         * @brief Wakes a single thread waiting on a free slot in DequeueBuffer, this must be called after a slot's state is set to free
+         * @note This doesn't require the queue to be locked
+         */
+        void SignalFreeSlot();
+
         /**
          * @return The amount of buffers which have been queued onto the consumer
          */
@@ -190,6 +197,11 @@ namespace skyline::service::hosbinder {
 
         GraphicBufferProducer(const DeviceState &state, nvdrv::core::NvMap &nvmap);
 
+        /**
+         * @return A hash of the buffers attached to the queue and its configuration, the states of the slots are excluded as they're advanced by presentation on the host
+         */
+        u64 HashBuffers(u64 seed);
+
         /**
          * @brief The handler for Binder IPC transactions with IGraphicBufferProducer
          * @url https://cs.android.com/android/platform/superproject/+/android-5.1.1_r38:frameworks/native/libs/gui/IGraphicBufferProducer.cpp;l=277-426
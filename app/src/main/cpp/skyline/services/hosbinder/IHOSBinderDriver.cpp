@@ -9,6 +9,12 @@
 namespace skyline::service::hosbinder {
     IHOSBinderDriver::IHOSBinderDriver(const DeviceState &state, ServiceManager &manager, nvdrv::core::NvMap &nvMap) : BaseService(state, manager), nvMap(nvMap) {}
 
+    u64 IHOSBinderDriver::HashState(u64 seed) {
+        std::array<u64, 2> layerState{static_cast<u64>(displayId), layer.has_value()};
+        seed = XXH64(layerState.data(), sizeof(layerState), seed);
+        return layer ? layer->HashBuffers(seed) : seed;
+    }
+
     Result IHOSBinderDriver::TransactParcel(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
         // We opted for just supporting a single layer and display as it's what basically all games use and wasting cycles on it is pointless
         // If this was not done then we would need to maintain an array of GraphicBufferProducer objects for each layer and send the request for it specifically
@@ -20,14 +26,16 @@ namespace skyline::service::hosbinder {
 
         auto code{request.Pop<GraphicBufferProducer::TransactionCode>()};
 
+        // Both parcels refer to the IPC buffers directly, the output is written in-place and only its header and objects are written afterwards
+        auto outputBuffer{request.outputBuf.at(0)};
         Parcel in(request.inputBuf.at(0), state, true);
-        Parcel out(state);
+        Parcel out(state, outputBuffer);
 
         if (!layer)
             throw exception("Transacting parcel with non-existant layer");
         layer->OnTransact(code, in, out);
 
-        out.WriteParcel(request.outputBuf.at(0));
+        out.WriteParcel(outputBuffer);
         return {};
     }
 
@@ -127,7 +135,7 @@ namespace skyline::service::hosbinder {
         return DefaultLayerId;
     }
 
-    Parcel IHOSBinderDriver::OpenLayer(DisplayId pDisplayId, u64 layerId) {
+    void IHOSBinderDriver::OpenLayer(DisplayId pDisplayId, u64 layerId, Parcel &parcel) {
         if (pDisplayId != displayId)
             throw exception("Opening layer #{} with unopened display: '{}'", layerId, ToString(pDisplayId));
         else if (layerId != DefaultLayerId)
@@ -135,7 +143,6 @@ namespace skyline::service::hosbinder {
         else if (!layer)
             throw exception("Opening layer #{} prior to creation or after destruction", layerId);
 
-        Parcel parcel(state);
         // Flat Binder with the layer's IGraphicBufferProducer
         // https://cs.android.com/android/platform/superproject/+/android-5.1.1_r38:bionic/libc/kernel/uapi/linux/binder.h;l=47-57
         parcel.Push<u32>(0x2); // Type of the IBinder
@@ -149,8 +156,6 @@ namespace skyline::service::hosbinder {
         parcel.PushObject(0); // Offset of flattened IBinder relative to Parcel data
 
         layerWeakReferenceCount++; // IBinder represents a weak reference to the layer
-
-        return parcel;
     }
 
     void IHOSBinderDriver::CloseLayer(u64 layerId) {
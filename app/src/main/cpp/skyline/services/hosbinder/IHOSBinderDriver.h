@@ -47,6 +47,11 @@ namespace skyline::service::hosbinder {
       public:
         IHOSBinderDriver(const DeviceState &state, ServiceManager &manager, nvdrv::core::NvMap &nvMap);
 
+        /**
+         * @return A hash of the display and layer state, including the buffers attached to the layer
+         */
+        u64 HashState(u64 seed);
+
         /**
          * @brief Emulates the transaction of parcels between a IGraphicBufferProducer and the application
          * @url https://switchbrew.org/wiki/Nvnflinger_services#TransactParcel
@@ -82,10 +87,10 @@ namespace skyline::service::hosbinder {
         u64 CreateLayer(DisplayId displayId);
 
         /**
-         * @return A parcel with a flattened IBinder to the IGraphicBufferProducer of the layer
+         * @brief Writes a flattened IBinder to the IGraphicBufferProducer of the layer into the supplied parcel
          * @note This will throw an exception if the specified display has not been opened
          */
-        Parcel OpenLayer(DisplayId displayId, u64 layerId);
+        void OpenLayer(DisplayId displayId, u64 layerId, Parcel &parcel);
 
         /**
          * @note This **must** be called prior to destroying the layer
@@ -7,26 +7,31 @@ namespace skyline::service::hosbinder {
     Parcel::Parcel(span<u8> buffer, const DeviceState &state, bool hasToken) : state(state) {
         header = buffer.as<ParcelHeader>();
 
-        if (buffer.size() < (sizeof(ParcelHeader) + header.dataSize + header.objectsSize))
-            throw exception("The size of the parcel according to the header exceeds the specified size");
-
         constexpr u8 tokenLength{0x50}; // The length of the token on BufferQueue parcels
+        size_t tokenSize{hasToken ? tokenLength : 0U};
 
-        data.resize(header.dataSize - (hasToken ? tokenLength : 0));
-        std::memcpy(data.data(), buffer.data() + header.dataOffset + (hasToken ? tokenLength : 0), header.dataSize - (hasToken ? tokenLength : 0));
+        if (static_cast<size_t>(header.dataOffset) + header.dataSize > buffer.size() || static_cast<size_t>(header.objectsOffset) + header.objectsSize > buffer.size())
+            throw exception("The size of the parcel according to the header exceeds the specified size");
+        if (header.dataSize < tokenSize)
+            throw exception("The size of the parcel data (0x{:X}) is smaller than its token", header.dataSize);
 
-        objects.resize(header.objectsSize);
-        std::memcpy(objects.data(), buffer.data() + header.objectsOffset, header.objectsSize);
+        data = buffer.subspan(header.dataOffset + tokenSize, header.dataSize - tokenSize);
+        objects = buffer.subspan(header.objectsOffset, header.objectsSize);
     }
 
-    Parcel::Parcel(const DeviceState &state) : state(state) {}
+    Parcel::Parcel(const DeviceState &state, span<u8> buffer) : state(state), objects(objectStorage) {
+        if (buffer.size() > sizeof(ParcelHeader))
+            data = buffer.subspan(sizeof(ParcelHeader));
+        else
+            data = inlineData; // The buffer can't contain the parcel, this'll throw when it's written but transactions don't need to check for it
+    }
 
     u64 Parcel::WriteParcel(span<u8> buffer) {
-        header.dataSize = static_cast<u32>(data.size());
+        header.dataSize = static_cast<u32>(dataSize);
         header.dataOffset = sizeof(ParcelHeader);
 
-        header.objectsSize = static_cast<u32>(objects.size());
-        header.objectsOffset = static_cast<u32>(sizeof(ParcelHeader) + data.size());
+        header.objectsSize = static_cast<u32>(objectsSize);
+        header.objectsOffset = static_cast<u32>(sizeof(ParcelHeader) + dataSize);
 
         auto totalSize{sizeof(ParcelHeader) + header.dataSize + header.objectsSize};
 
@@ -34,8 +39,9 @@ namespace skyline::service::hosbinder {
             throw exception("The size of the parcel exceeds maxSize");
 
         buffer.as<ParcelHeader>() = header;
-        std::memcpy(buffer.data() + header.dataOffset, data.data(), data.size());
-        std::memcpy(buffer.data() + header.objectsOffset, objects.data(), objects.size());
+        if (data.data() != buffer.data() + header.dataOffset)
+            std::memcpy(buffer.data() + header.dataOffset, data.data(), dataSize);
+        std::memcpy(buffer.data() + header.objectsOffset, objects.data(), objectsSize);
 
         return totalSize;
     }
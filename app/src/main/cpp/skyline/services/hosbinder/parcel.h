@@ -8,6 +8,7 @@
 namespace skyline::service::hosbinder {
     /**
      * @brief This allows easy access and efficient serialization of an Android Parcel object
+     * @note Parcels are read directly from the IPC buffer they're in and written in-place into the IPC buffer they're for, only parcels without a large enough buffer are written into fixed-capacity inline storage
      * @url https://switchbrew.org/wiki/Display_services#Parcel
      */
     class Parcel {
@@ -20,15 +21,22 @@ namespace skyline::service::hosbinder {
         } header{};
         static_assert(sizeof(ParcelHeader) == 0x10);
 
+        static constexpr size_t InlineDataCapacity{0x200}; //!< The capacity of the data of parcels which aren't written in-place, this fits the largest parcel written by any transaction
+        static constexpr size_t ObjectsCapacity{0x10}; //!< The capacity of the objects of written parcels, objects are written after the data so they can only be placed once it's complete
+
         const DeviceState &state;
+        std::array<u8, InlineDataCapacity> inlineData; //!< The storage for the data of parcels which aren't written in-place, this is intentionally left uninitialized
+        std::array<u8, ObjectsCapacity> objectStorage; //!< The storage for the objects of written parcels
 
       public:
-        std::vector<u8> data;
-        std::vector<u8> objects;
+        span<u8> data; //!< The data of a read parcel or the storage of the data of a written parcel
+        span<u8> objects; //!< The objects of a read parcel or the storage of the objects of a written parcel
         size_t dataOffset{}; //!< The offset of the data read from the parcel
+        size_t dataSize{}; //!< The size of the data written to the parcel
+        size_t objectsSize{}; //!< The size of the objects written to the parcel
 
         /**
-         * @brief This constructor fills in the Parcel object with data from a IPC buffer
+         * @brief This constructor reads the Parcel object directly from an IPC buffer, the buffer must outlive the parcel
          * @param buffer The buffer that contains the parcel
          * @param hasToken If the parcel starts with a token, it's skipped if this flag is true
          */
@@ -36,14 +44,21 @@ namespace skyline::service::hosbinder {
 
         /**
          * @brief This constructor is used to create an empty parcel then write to a process
+         * @param buffer The buffer that the parcel will be written into, the data is written in-place into it if it's large enough to contain a header
          */
-        Parcel(const DeviceState &state);
+        Parcel(const DeviceState &state, span<u8> buffer = {});
+
+        Parcel(const Parcel &) = delete;
+
+        Parcel &operator=(const Parcel &) = delete;
 
         /**
          * @return A reference to an item from the top of data
          */
         template<typename ValueType>
         ValueType &Pop() {
+            if (dataOffset + sizeof(ValueType) > data.size())
+                throw exception("Popping 0x{:X} bytes at offset 0x{:X} from a parcel with 0x{:X} bytes of data", sizeof(ValueType), dataOffset, data.size());
             ValueType &value{*reinterpret_cast<ValueType *>(data.data() + dataOffset)};
             dataOffset += sizeof(ValueType);
             return value;
@@ -67,9 +82,10 @@ namespace skyline::service::hosbinder {
 
         template<typename ValueType>
         void Push(const ValueType &value) {
-            auto offset{data.size()};
-            data.resize(offset + sizeof(ValueType));
-            std::memcpy(data.data() + offset, &value, sizeof(ValueType));
+            if (dataSize + sizeof(ValueType) > data.size())
+                throw exception("Pushing 0x{:X} bytes exceeds the parcel data capacity of 0x{:X} bytes", sizeof(ValueType), data.size());
+            std::memcpy(data.data() + dataSize, &value, sizeof(ValueType));
+            dataSize += sizeof(ValueType);
         }
 
         /**
@@ -97,13 +113,14 @@ namespace skyline::service::hosbinder {
 
         template<typename ObjectType>
         void PushObject(const ObjectType &object) {
-            auto offset{objects.size()};
-            objects.resize(offset + sizeof(ObjectType));
-            std::memcpy(objects.data() + offset, &object, sizeof(ObjectType));
+            if (objectsSize + sizeof(ObjectType) > objects.size())
+                throw exception("Pushing 0x{:X} bytes exceeds the parcel object capacity of 0x{:X} bytes", sizeof(ObjectType), objects.size());
+            std::memcpy(objects.data() + objectsSize, &object, sizeof(ObjectType));
+            objectsSize += sizeof(ObjectType);
         }
 
         /**
-         * @param buffer The buffer to write the flattened Parcel into
+         * @param buffer The buffer to write the flattened Parcel into, only the header and objects are written if the data was written in-place into it
          * @return The total size of the Parcel
          */
         u64 WriteParcel(span<u8> buffer);
@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <common/settings.h>
 #include "IUserLocalCommunicationService.h"
 
 namespace skyline::service::ldn {
@@ -8,9 +9,113 @@ namespace skyline::service::ldn {
         : BaseService(state, manager),
           event{std::make_shared<type::KEvent>(state, false)} {}
 
+    void IUserLocalCommunicationService::UpdateStationState() {
+        if (ldnState == State::StationConnected && !network->IsConnected())
+            ldnState = State::StationOpened;
+    }
+
+    Result IUserLocalCommunicationService::Initialize() {
+        if (!*state.settings->localWireless)
+            return result::DeviceDisabled;
+
+        std::scoped_lock lock{mutex};
+        if (network)
+            return {};
+
+        try {
+            // The event is signalled directly from the receive thread whenever the network changes, the state is updated lazily when it's queried
+            network = std::make_unique<LanNetwork>([event = event] { event->Signal(); });
+        } catch (const std::exception &e) {
+            Logger::Warn("Failed to initialize local wireless: {}", e.what());
+            return result::DeviceDisabled;
+        }
+
+        ldnState = State::Initialized;
+        return {};
+    }
+
+    Result IUserLocalCommunicationService::CreateNetworkImpl(const SecurityConfig &security, const UserConfig &user, const NetworkConfig &config) {
+        std::scoped_lock lock{mutex};
+        if (ldnState != State::AccessPointOpened)
+            return result::InvalidState;
+
+        network->CreateNetwork(config, security, user, stationAcceptPolicy, advertiseData);
+        ldnState = State::AccessPointCreated;
+        event->Signal();
+        return {};
+    }
+
     Result IUserLocalCommunicationService::GetState(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
-        static constexpr u32 StateNone{0x0};
-        response.Push<u32>(StateNone);
+        std::scoped_lock lock{mutex};
+        if (network)
+            UpdateStationState();
+
+        response.Push(ldnState);
+        return {};
+    }
+
+    Result IUserLocalCommunicationService::GetNetworkInfo(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        std::scoped_lock lock{mutex};
+        if (!network)
+            return result::InvalidState;
+
+        UpdateStationState();
+        if (ldnState != State::AccessPointCreated && ldnState != State::StationConnected)
+            return result::InvalidState;
+
+        request.outputBuf.at(0).as<NetworkInfo>() = network->GetNetworkInfo();
+        return {};
+    }
+
+    Result IUserLocalCommunicationService::GetIpv4Address(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        std::scoped_lock lock{mutex};
+        if (!network)
+            return result::InvalidState;
+
+        response.Push<u32>(network->GetAddress());
+        response.Push<u32>(network->GetNetmask());
+        return {};
+    }
+
+    Result IUserLocalCommunicationService::GetDisconnectReason(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        std::scoped_lock lock{mutex};
+        response.Push(network ? network->GetDisconnectReason() : DisconnectReason::None);
+        return {};
+    }
+
+    Result IUserLocalCommunicationService::GetSecurityParameter(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        std::scoped_lock lock{mutex};
+        if (!network)
+            return result::InvalidState;
+
+        UpdateStationState();
+        if (ldnState != State::AccessPointCreated && ldnState != State::StationConnected)
+            return result::InvalidState;
+
+        auto info{network->GetNetworkInfo()};
+        response.Push(SecurityParameter{
+            .data = info.ldn.securityParameter,
+            .sessionId = info.networkId.sessionId,
+        });
+        return {};
+    }
+
+    Result IUserLocalCommunicationService::GetNetworkConfig(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        std::scoped_lock lock{mutex};
+        if (!network)
+            return result::InvalidState;
+
+        UpdateStationState();
+        if (ldnState != State::AccessPointCreated && ldnState != State::StationConnected)
+            return result::InvalidState;
+
+        auto info{network->GetNetworkInfo()};
+        response.Push(NetworkConfig{
+            .intentId = info.networkId.intentId,
+            .channel = info.common.channel,
+            .nodeCountMax = info.ldn.nodeCountMax,
+            .localCommunicationVersion = info.ldn.nodes[0].localCommunicationVersion,
+        });
         return {};
     }
 
@@ -21,15 +126,177 @@ namespace skyline::service::ldn {
         return {};
     }
 
+    Result IUserLocalCommunicationService::GetNetworkInfoLatestUpdate(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        std::scoped_lock lock{mutex};
+        if (!network)
+            return result::InvalidState;
+
+        UpdateStationState();
+        if (ldnState != State::AccessPointCreated && ldnState != State::StationConnected)
+            return result::InvalidState;
+
+        request.outputBuf.at(0).as<NetworkInfo>() = network->GetNetworkInfo();
+
+        auto updates{request.outputBuf.at(1).cast<NodeLatestUpdate>()};
+        auto changes{network->ConsumeNodeChanges()};
+        for (size_t i{}; i < std::min(updates.size(), changes.size()); i++)
+            updates[i] = NodeLatestUpdate{.stateChange = changes[i]};
+        return {};
+    }
+
+    Result IUserLocalCommunicationService::Scan(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        request.Skip<u16>(); // The channel is ignored as all networks on the LAN are reachable
+        request.Skip<std::array<u8, 6>>();
+        auto filter{request.Pop<ScanFilter>()};
+
+        std::scoped_lock lock{mutex};
+        if (!network || ldnState == State::Initialized || ldnState == State::Error)
+            return result::InvalidState;
+
+        auto networks{network->Scan(filter)};
+        auto output{request.outputBuf.at(0)};
+        size_t count{std::min(networks.size(), output.size() / sizeof(NetworkInfo))};
+        std::memcpy(output.data(), networks.data(), count * sizeof(NetworkInfo));
+
+        response.Push<u16>(static_cast<u16>(count));
+        return {};
+    }
+
+    Result IUserLocalCommunicationService::SetWirelessControllerRestriction(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        return {};
+    }
+
+    Result IUserLocalCommunicationService::OpenAccessPoint(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        std::scoped_lock lock{mutex};
+        if (ldnState != State::Initialized)
+            return result::InvalidState;
+
+        ldnState = State::AccessPointOpened;
+        event->Signal();
+        return {};
+    }
+
+    Result IUserLocalCommunicationService::CloseAccessPoint(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        std::scoped_lock lock{mutex};
+        if (ldnState != State::AccessPointOpened && ldnState != State::AccessPointCreated)
+            return result::InvalidState;
+
+        network->DestroyNetwork();
+        ldnState = State::Initialized;
+        event->Signal();
+        return {};
+    }
+
+    Result IUserLocalCommunicationService::CreateNetwork(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        auto security{request.Pop<SecurityConfig>()};
+        auto user{request.Pop<UserConfig>()};
+        request.Skip<u32>();
+        auto config{request.Pop<NetworkConfig>()};
+        return CreateNetworkImpl(security, user, config);
+    }
+
+    Result IUserLocalCommunicationService::CreateNetworkPrivate(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        auto security{request.Pop<SecurityConfig>()};
+        request.Skip<SecurityParameter>();
+        auto user{request.Pop<UserConfig>()};
+        request.Skip<u32>();
+        auto config{request.Pop<NetworkConfig>()};
+        return CreateNetworkImpl(security, user, config);
+    }
+
+    Result IUserLocalCommunicationService::DestroyNetwork(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        std::scoped_lock lock{mutex};
+        if (ldnState != State::AccessPointCreated)
+            return result::InvalidState;
+
+        network->DestroyNetwork();
+        ldnState = State::AccessPointOpened;
+        event->Signal();
+        return {};
+    }
+
+    Result IUserLocalCommunicationService::SetAdvertiseData(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        auto data{request.inputBuf.at(0)};
+        if (data.size() > AdvertiseDataSizeMax)
+            return result::InvalidArgument;
+
+        std::scoped_lock lock{mutex};
+        advertiseData.assign(data.begin(), data.end());
+        if (ldnState == State::AccessPointCreated)
+            network->SetAdvertiseData(advertiseData);
+        return {};
+    }
+
+    Result IUserLocalCommunicationService::SetStationAcceptPolicy(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        std::scoped_lock lock{mutex};
+        stationAcceptPolicy = request.Pop<u8>();
+        return {};
+    }
+
+    Result IUserLocalCommunicationService::OpenStation(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        std::scoped_lock lock{mutex};
+        if (ldnState != State::Initialized)
+            return result::InvalidState;
+
+        ldnState = State::StationOpened;
+        event->Signal();
+        return {};
+    }
+
+    Result IUserLocalCommunicationService::CloseStation(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        std::scoped_lock lock{mutex};
+        if (ldnState != State::StationOpened && ldnState != State::StationConnected)
+            return result::InvalidState;
+
+        network->Disconnect();
+        ldnState = State::Initialized;
+        event->Signal();
+        return {};
+    }
+
+    Result IUserLocalCommunicationService::Connect(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        request.Skip<SecurityConfig>();
+        auto user{request.Pop<UserConfig>()};
+        auto localCommunicationVersion{request.Pop<u32>()};
+        const auto &target{request.inputBuf.at(0).as<NetworkInfo>()};
+
+        std::scoped_lock lock{mutex};
+        if (ldnState != State::StationOpened)
+            return result::InvalidState;
+
+        // This blocks until the access point responds, the calling guest thread is descheduled for the duration of the IPC
+        auto result{network->Connect(target, user, static_cast<u16>(localCommunicationVersion))};
+        if (result)
+            return result;
+
+        ldnState = State::StationConnected;
+        event->Signal();
+        return {};
+    }
+
+    Result IUserLocalCommunicationService::Disconnect(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        std::scoped_lock lock{mutex};
+        if (ldnState != State::StationConnected)
+            return result::InvalidState;
+
+        network->Disconnect();
+        ldnState = State::StationOpened;
+        event->Signal();
+        return {};
+    }
+
     Result IUserLocalCommunicationService::InitializeSystem(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
-        return result::DeviceDisabled;
+        return Initialize();
     }
 
     Result IUserLocalCommunicationService::FinalizeSystem(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        std::scoped_lock lock{mutex};
+        network.reset();
+        ldnState = State::None;
         return {};
     }
 
     Result IUserLocalCommunicationService::InitializeSystem2(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
-        return result::DeviceDisabled;
+        return Initialize();
     }
 }
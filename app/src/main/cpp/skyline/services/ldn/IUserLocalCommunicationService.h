@@ -4,19 +4,33 @@
 #pragma once
 
 #include <services/serviceman.h>
+#include "common.h"
+#include "lan_network.h"
 
 namespace skyline::service::ldn {
-    namespace result {
-        static constexpr Result DeviceDisabled{203, 22};
-    }
-
     /**
      * @brief IUserLocalCommunicationService is used by applications to manage LDN sessions
+     * @note Local wireless is emulated over the LAN with LanNetwork when it's enabled in the settings, otherwise the device is reported as disabled
      * @url https://switchbrew.org/wiki/LDN_services#IUserLocalCommunicationService
      */
     class IUserLocalCommunicationService : public BaseService {
       private:
         std::shared_ptr<type::KEvent> event; //!< The KEvent that is signalled on state changes
+        std::mutex mutex; //!< Synchronizes the state between guest threads
+        State ldnState{State::None};
+        std::unique_ptr<LanNetwork> network; //!< The LAN transport of the service, this exists while the service is initialized
+        u8 stationAcceptPolicy{};
+        std::vector<u8> advertiseData; //!< The advertise data that's supplied to networks created after it's set
+
+        /**
+         * @brief Moves a connected station back to the opened state if the access point has disconnected it
+         * @note `mutex` must be locked when calling this
+         */
+        void UpdateStationState();
+
+        Result Initialize();
+
+        Result CreateNetworkImpl(const SecurityConfig &security, const UserConfig &user, const NetworkConfig &config);
 
       public:
         IUserLocalCommunicationService(const DeviceState &state, ServiceManager &manager);
@@ -26,11 +40,108 @@ namespace skyline::service::ldn {
          */
         Result GetState(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
 
+        /**
+         * @url https://switchbrew.org/wiki/LDN_services#GetNetworkInfo
+         */
+        Result GetNetworkInfo(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/LDN_services#GetIpv4Address
+         */
+        Result GetIpv4Address(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/LDN_services#GetDisconnectReason
+         */
+        Result GetDisconnectReason(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/LDN_services#GetSecurityParameter
+         */
+        Result GetSecurityParameter(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/LDN_services#GetNetworkConfig
+         */
+        Result GetNetworkConfig(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
         /**
          * @url https://switchbrew.org/wiki/LDN_services#AttachStateChangeEvent
          */
         Result AttachStateChangeEvent(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
 
+        /**
+         * @url https://switchbrew.org/wiki/LDN_services#GetNetworkInfoLatestUpdate
+         */
+        Result GetNetworkInfoLatestUpdate(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/LDN_services#Scan
+         */
+        Result Scan(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @brief No-op as there are no wireless controllers to restrict
+         * @url https://switchbrew.org/wiki/LDN_services#SetWirelessControllerRestriction
+         */
+        Result SetWirelessControllerRestriction(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/LDN_services#OpenAccessPoint
+         */
+        Result OpenAccessPoint(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/LDN_services#CloseAccessPoint
+         */
+        Result CloseAccessPoint(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/LDN_services#CreateNetwork
+         */
+        Result CreateNetwork(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @brief Identical to CreateNetwork, the supplied security parameter and address entries are ignored
+         * @url https://switchbrew.org/wiki/LDN_services#CreateNetworkPrivate
+         */
+        Result CreateNetworkPrivate(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/LDN_services#DestroyNetwork
+         */
+        Result DestroyNetwork(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/LDN_services#SetAdvertiseData
+         */
+        Result SetAdvertiseData(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/LDN_services#SetStationAcceptPolicy
+         */
+        Result SetStationAcceptPolicy(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/LDN_services#OpenStation
+         */
+        Result OpenStation(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/LDN_services#CloseStation
+         */
+        Result CloseStation(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/LDN_services#Connect
+         */
+        Result Connect(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/LDN_services#Disconnect
+         */
+        Result Disconnect(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
         /**
          * @url https://switchbrew.org/wiki/LDN_services#InitializeSystem
          */
@@ -48,7 +159,27 @@ namespace skyline::service::ldn {
 
       SERVICE_DECL(
             SFUNC(0x0, IUserLocalCommunicationService, GetState),
+            SFUNC(0x1, IUserLocalCommunicationService, GetNetworkInfo),
+            SFUNC(0x2, IUserLocalCommunicationService, GetIpv4Address),
+            SFUNC(0x3, IUserLocalCommunicationService, GetDisconnectReason),
+            SFUNC(0x4, IUserLocalCommunicationService, GetSecurityParameter),
+            SFUNC(0x5, IUserLocalCommunicationService, GetNetworkConfig),
             SFUNC(0x64, IUserLocalCommunicationService, AttachStateChangeEvent),
+            SFUNC(0x65, IUserLocalCommunicationService, GetNetworkInfoLatestUpdate),
+            SFUNC(0x66, IUserLocalCommunicationService, Scan),
+            SFUNC(0x67, IUserLocalCommunicationService, Scan),
+            SFUNC(0x68, IUserLocalCommunicationService, SetWirelessControllerRestriction),
+            SFUNC(0xC8, IUserLocalCommunicationService, OpenAccessPoint),
+            SFUNC(0xC9, IUserLocalCommunicationService, CloseAccessPoint),
+            SFUNC(0xCA, IUserLocalCommunicationService, CreateNetwork),
+            SFUNC(0xCB, IUserLocalCommunicationService, CreateNetworkPrivate),
+            SFUNC(0xCC, IUserLocalCommunicationService, DestroyNetwork),
+            SFUNC(0xCE, IUserLocalCommunicationService, SetAdvertiseData),
+            SFUNC(0xCF, IUserLocalCommunicationService, SetStationAcceptPolicy),
+            SFUNC(0x12C, IUserLocalCommunicationService, OpenStation),
+            SFUNC(0x12D, IUserLocalCommunicationService, CloseStation),
+            SFUNC(0x12E, IUserLocalCommunicationService, Connect),
+            SFUNC(0x130, IUserLocalCommunicationService, Disconnect),
             SFUNC(0x190, IUserLocalCommunicationService, InitializeSystem),
             SFUNC(0x191, IUserLocalCommunicationService, FinalizeSystem),
             SFUNC(0x192, IUserLocalCommunicationService, InitializeSystem2),
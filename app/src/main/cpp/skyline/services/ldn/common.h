@@ -0,0 +1,211 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common.h>
+
+namespace skyline::service::ldn {
+    namespace result {
+        constexpr Result DeviceDisabled{203, 22};
+        constexpr Result InvalidState{203, 32};
+        constexpr Result ConnectFailure{203, 64};
+        constexpr Result ConnectNotFound{203, 65};
+        constexpr Result ConnectTimeout{203, 66};
+        constexpr Result ConnectRejected{203, 67};
+        constexpr Result InvalidArgument{203, 96};
+    }
+
+    /**
+     * @url https://switchbrew.org/wiki/LDN_services#State
+     */
+    enum class State : u32 {
+        None = 0,
+        Initialized = 1,
+        AccessPointOpened = 2,
+        AccessPointCreated = 3,
+        StationOpened = 4,
+        StationConnected = 5,
+        Error = 6,
+    };
+
+    /**
+     * @url https://switchbrew.org/wiki/LDN_services#DisconnectReason
+     */
+    enum class DisconnectReason : u16 {
+        None = 0,
+        User = 1,
+        SystemRequest = 2,
+        DestroyedByUser = 3,
+        DestroyedBySystemRequest = 4,
+        Admin = 5,
+        SignalLost = 6,
+    };
+
+    /**
+     * @url https://switchbrew.org/wiki/LDN_services#NodeLatestUpdate
+     */
+    enum class NodeStateChange : u8 {
+        None = 0,
+        Connect = 1,
+        Disconnect = 2,
+        DisconnectAndConnect = 3,
+    };
+
+    constexpr size_t NodeCountMax{8}; //!< The maximum amount of nodes in a network including the access point
+    constexpr size_t AdvertiseDataSizeMax{0x180};
+    constexpr size_t UserNameSize{0x21}; //!< The size of a null-terminated user name
+
+    using MacAddress = std::array<u8, 6>;
+
+    struct IntentId {
+        u64 localCommunicationId;
+        u8 _pad0_[2];
+        u16 sceneId;
+        u8 _pad1_[4];
+    };
+    static_assert(sizeof(IntentId) == 0x10);
+
+    struct SessionId {
+        u64 high;
+        u64 low;
+
+        bool operator==(const SessionId &) const = default;
+    };
+    static_assert(sizeof(SessionId) == 0x10);
+
+    struct NetworkId {
+        IntentId intentId;
+        SessionId sessionId;
+    };
+    static_assert(sizeof(NetworkId) == 0x20);
+
+    struct Ssid {
+        u8 length;
+        std::array<char, 0x21> name; //!< A null-terminated string of up to 32 characters
+    };
+    static_assert(sizeof(Ssid) == 0x22);
+
+    struct CommonNetworkInfo {
+        MacAddress bssid;
+        Ssid ssid;
+        u16 channel;
+        u8 linkLevel;
+        u8 networkType;
+        u32 _pad_;
+    };
+    static_assert(sizeof(CommonNetworkInfo) == 0x30);
+
+    struct NodeInfo {
+        u32 ipv4Address; //!< The address of the node in host byte order
+        MacAddress macAddress;
+        u8 nodeId;
+        u8 isConnected;
+        std::array<char, UserNameSize> userName;
+        u8 _pad0_;
+        u16 localCommunicationVersion;
+        u8 _pad1_[0x10];
+    };
+    static_assert(sizeof(NodeInfo) == 0x40);
+
+    struct LdnNetworkInfo {
+        std::array<u8, 0x10> securityParameter;
+        u16 securityMode;
+        u8 stationAcceptPolicy;
+        u8 _pad0_[3];
+        u8 nodeCountMax;
+        u8 nodeCount;
+        std::array<NodeInfo, NodeCountMax> nodes;
+        u8 _pad1_[2];
+        u16 advertiseDataSize;
+        std::array<u8, AdvertiseDataSizeMax> advertiseData;
+        u8 _pad2_[0x8C];
+        u64 authenticationId;
+    };
+    static_assert(sizeof(LdnNetworkInfo) == 0x430);
+
+    /**
+     * @url https://switchbrew.org/wiki/LDN_services#NetworkInfo
+     */
+    struct NetworkInfo {
+        NetworkId networkId;
+        CommonNetworkInfo common;
+        LdnNetworkInfo ldn;
+    };
+    static_assert(sizeof(NetworkInfo) == 0x480);
+
+    struct SecurityConfig {
+        u16 securityMode;
+        u16 passphraseSize;
+        std::array<u8, 0x40> passphrase;
+    };
+    static_assert(sizeof(SecurityConfig) == 0x44);
+
+    struct SecurityParameter {
+        std::array<u8, 0x10> data;
+        SessionId sessionId;
+    };
+    static_assert(sizeof(SecurityParameter) == 0x20);
+
+    struct UserConfig {
+        std::array<char, UserNameSize> userName;
+        u8 _pad_[0xF];
+    };
+    static_assert(sizeof(UserConfig) == 0x30);
+
+    struct NetworkConfig {
+        IntentId intentId;
+        u16 channel;
+        u8 nodeCountMax;
+        u8 _pad0_;
+        u16 localCommunicationVersion;
+        u8 _pad1_[0xA];
+    };
+    static_assert(sizeof(NetworkConfig) == 0x20);
+
+    /**
+     * @url https://switchbrew.org/wiki/LDN_services#ScanFilter
+     */
+    struct ScanFilter {
+        NetworkId networkId;
+        u32 networkType;
+        MacAddress bssid;
+        Ssid ssid;
+        u8 _pad_[0x10];
+        struct {
+            bool localCommunicationId : 1;
+            bool sessionId : 1;
+            bool networkType : 1;
+            bool bssid : 1;
+            bool ssid : 1;
+            bool sceneId : 1;
+            u32 _pad_ : 26;
+        } flags;
+
+        /**
+         * @return If the supplied network passes the filter
+         */
+        bool Matches(const NetworkInfo &info) const {
+            if (flags.localCommunicationId && info.networkId.intentId.localCommunicationId != networkId.intentId.localCommunicationId)
+                return false;
+            if (flags.sessionId && info.networkId.sessionId != networkId.sessionId)
+                return false;
+            if (flags.networkType && info.common.networkType != networkType)
+                return false;
+            if (flags.bssid && info.common.bssid != bssid)
+                return false;
+            if (flags.ssid && (info.common.ssid.length != ssid.length || std::memcmp(info.common.ssid.name.data(), ssid.name.data(), std::min<size_t>(ssid.length, ssid.name.size())) != 0))
+                return false;
+            if (flags.sceneId && info.networkId.intentId.sceneId != networkId.intentId.sceneId)
+                return false;
+            return true;
+        }
+    };
+    static_assert(sizeof(ScanFilter) == 0x60);
+
+    struct NodeLatestUpdate {
+        NodeStateChange stateChange;
+        u8 _pad_[7];
+    };
+    static_assert(sizeof(NodeLatestUpdate) == 0x8);
+}
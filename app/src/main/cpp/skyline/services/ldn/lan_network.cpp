@@ -0,0 +1,429 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <common/thread_role.h>
+#include "lan_network.h"
+
+namespace skyline::service::ldn {
+    constexpr auto ScanDuration{std::chrono::milliseconds(100)}; //!< The duration that scan replies are collected for, this is roughly how long a scan of a single channel takes on HW
+    constexpr auto ConnectTimeout{std::chrono::seconds(1)}; //!< The duration that a connecting station waits for a response from the access point
+    constexpr u16 DefaultChannel{6}; //!< The channel that networks are reported on when the guest lets the system choose one
+    constexpr u8 NetworkTypeLdn{2};
+    constexpr u8 LinkLevelMax{3};
+
+    LanNetwork::LanNetwork(ChangeCallback onChange) : onChange{std::move(onChange)} {
+        ifaddrs *interfaces;
+        if (getifaddrs(&interfaces))
+            throw exception("Failed to query the network interfaces: {}", strerror(errno));
+
+        for (auto interface{interfaces}; interface; interface = interface->ifa_next) {
+            if (!interface->ifa_addr || !interface->ifa_netmask || interface->ifa_addr->sa_family != AF_INET)
+                continue;
+            if (!(interface->ifa_flags & IFF_UP) || (interface->ifa_flags & IFF_LOOPBACK) || !(interface->ifa_flags & IFF_BROADCAST))
+                continue;
+
+            address = ntohl(reinterpret_cast<sockaddr_in *>(interface->ifa_addr)->sin_addr.s_addr);
+            netmask = ntohl(reinterpret_cast<sockaddr_in *>(interface->ifa_netmask)->sin_addr.s_addr);
+            broadcastAddress = address | ~netmask;
+            break;
+        }
+        freeifaddrs(interfaces);
+
+        if (!address)
+            throw exception("No LAN interface is available");
+
+        fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+            throw exception("Failed to create the LDN socket: {}", strerror(errno));
+
+        int enable{1};
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+        ::setsockopt(fd, SOL_SOCKET, SO_BROADCAST, &enable, sizeof(enable));
+
+        sockaddr_in bindAddress{
+            .sin_family = AF_INET,
+            .sin_port = htons(Port),
+            .sin_addr = {.s_addr = htonl(INADDR_ANY)},
+        };
+        if (::bind(fd, reinterpret_cast<sockaddr *>(&bindAddress), sizeof(bindAddress))) {
+            int error{errno};
+            ::close(fd);
+            throw exception("Failed to bind the LDN socket to port {}: {}", Port, strerror(error));
+        }
+
+        wakeFd = eventfd(0, EFD_CLOEXEC);
+        if (wakeFd < 0) {
+            int error{errno};
+            ::close(fd);
+            throw exception("Failed to create the LDN wake eventfd: {}", strerror(error));
+        }
+
+        receiveThread = std::thread(&LanNetwork::ReceiveThread, this);
+    }
+
+    LanNetwork::~LanNetwork() {
+        DestroyNetwork();
+        Disconnect();
+
+        u64 value{1};
+        ::write(wakeFd, &value, sizeof(value));
+        receiveThread.join();
+
+        ::close(wakeFd);
+        ::close(fd);
+    }
+
+    void LanNetwork::ReceiveThread() {
+        if (int result{pthread_setname_np(pthread_self(), "Sky-LdnReceive")})
+            Logger::Warn("Failed to set the thread name: {}", strerror(result));
+        thread_role::Apply(thread_role::Role::Helper);
+
+        std::array<mmsghdr, ReceiveBatchSize> messages{};
+        std::array<iovec, ReceiveBatchSize> vectors{};
+        std::array<sockaddr_in, ReceiveBatchSize> sources{};
+        for (size_t i{}; i < ReceiveBatchSize; i++)
+            vectors[i] = iovec{.iov_base = receiveBuffers[i].data(), .iov_len = receiveBuffers[i].size()};
+
+        while (true) {
+            std::array<pollfd, 2> pollFds{
+                pollfd{.fd = fd, .events = POLLIN},
+                pollfd{.fd = wakeFd, .events = POLLIN},
+            };
+            if (::poll(pollFds.data(), pollFds.size(), -1) < 0) {
+                if (errno == EINTR)
+                    continue;
+                Logger::Warn("Failed to poll the LDN socket: {}", strerror(errno));
+                return;
+            }
+
+            if (pollFds[1].revents)
+                return;
+
+            for (size_t i{}; i < ReceiveBatchSize; i++)
+                messages[i].msg_hdr = msghdr{
+                    .msg_name = &sources[i],
+                    .msg_namelen = sizeof(sockaddr_in),
+                    .msg_iov = &vectors[i],
+                    .msg_iovlen = 1,
+                };
+
+            int count{::recvmmsg(fd, messages.data(), ReceiveBatchSize, MSG_DONTWAIT, nullptr)};
+            if (count <= 0)
+                continue;
+
+            bool changed{};
+            {
+                std::scoped_lock lock{mutex};
+                for (size_t i{}; i < static_cast<size_t>(count); i++) {
+                    u32 source{ntohl(sources[i].sin_addr.s_addr)};
+                    if (source != address) // Broadcasts are looped back to the sender, these are always ignored
+                        changed |= HandlePacket(span(receiveBuffers[i]).first(messages[i].msg_len), source);
+                }
+            }
+
+            // The callback is invoked without the lock held so it's free to query the network
+            if (changed)
+                onChange();
+        }
+    }
+
+    bool LanNetwork::HandlePacket(span<u8> packet, u32 source) {
+        if (packet.size() < sizeof(PacketHeader) || packet.as<PacketHeader>().magic != PacketMagic)
+            return false;
+
+        auto type{packet.as<PacketHeader>().type};
+        span<u8> payload{packet.subspan(sizeof(PacketHeader))};
+        auto &ldn{network.ldn};
+        switch (type) {
+            case PacketType::Scan:
+                if (role == Role::AccessPoint)
+                    SendPacket(PacketType::ScanReply, span(network).cast<u8>(), source);
+                return false;
+
+            case PacketType::ScanReply:
+                if (scanning && payload.size() == sizeof(NetworkInfo)) {
+                    const auto &info{payload.as<NetworkInfo>()};
+                    auto it{std::find_if(scanResults.begin(), scanResults.end(), [&](const NetworkInfo &result) { return result.networkId.sessionId == info.networkId.sessionId; })};
+                    if (it != scanResults.end())
+                        *it = info;
+                    else
+                        scanResults.push_back(info);
+                }
+                return false;
+
+            case PacketType::Connect: {
+                if (role != Role::AccessPoint || payload.size() != sizeof(NodeInfo))
+                    return false;
+
+                for (size_t i{1}; i < ldn.nodeCountMax; i++) {
+                    if (ldn.nodes[i].isConnected && ldn.nodes[i].ipv4Address == source) {
+                        // The station didn't receive the original update, it's resent to it alone
+                        SendPacket(PacketType::Sync, span(network).cast<u8>(), source);
+                        return false;
+                    }
+                }
+
+                constexpr u8 AcceptPolicyAcceptAll{0};
+                auto slot{std::find_if(ldn.nodes.begin() + 1, ldn.nodes.begin() + ldn.nodeCountMax, [](const NodeInfo &node) { return !node.isConnected; })};
+                if (ldn.stationAcceptPolicy != AcceptPolicyAcceptAll || slot == ldn.nodes.begin() + ldn.nodeCountMax) {
+                    auto reason{DisconnectReason::Admin};
+                    SendPacket(PacketType::Disconnect, span(reason).cast<u8>(), source);
+                    return false;
+                }
+
+                u8 nodeId{static_cast<u8>(std::distance(ldn.nodes.begin(), slot))};
+                *slot = payload.as<NodeInfo>();
+                slot->ipv4Address = source;
+                slot->macAddress = GetMacAddress(source);
+                slot->nodeId = nodeId;
+                slot->isConnected = true;
+                ldn.nodeCount++;
+                nodeChanges[nodeId] = NodeStateChange::Connect;
+
+                SendToStations(PacketType::Sync, span(network).cast<u8>());
+                return true;
+            }
+
+            case PacketType::Sync:
+                if (role != Role::Station || source != ldn.nodes[0].ipv4Address || payload.size() != sizeof(NetworkInfo))
+                    return false;
+
+                network = payload.as<NetworkInfo>();
+                if (!joined) {
+                    joined = true;
+                    joinCondition.notify_all();
+                    return false;
+                }
+                return true;
+
+            case PacketType::Disconnect:
+                if (role == Role::AccessPoint) {
+                    for (size_t i{1}; i < ldn.nodeCountMax; i++) {
+                        if (ldn.nodes[i].isConnected && ldn.nodes[i].ipv4Address == source) {
+                            ldn.nodes[i] = {};
+                            ldn.nodeCount--;
+                            nodeChanges[i] = NodeStateChange::Disconnect;
+
+                            SendToStations(PacketType::Sync, span(network).cast<u8>());
+                            return true;
+                        }
+                    }
+                } else if (role == Role::Station && source == ldn.nodes[0].ipv4Address && payload.size() >= sizeof(DisconnectReason)) {
+                    disconnectReason = payload.as<DisconnectReason>();
+                    role = Role::None;
+                    if (!joined) {
+                        joinCondition.notify_all();
+                        return false;
+                    }
+                    joined = false;
+                    return true;
+                }
+                return false;
+
+            default:
+                return false;
+        }
+    }
+
+    void LanNetwork::SendPacket(PacketType type, span<const u8> payload, u32 destination) {
+        std::array<u8, MaxPacketSize> packet;
+        PacketHeader header{.magic = PacketMagic, .type = type};
+        std::memcpy(packet.data(), &header, sizeof(header));
+        std::memcpy(packet.data() + sizeof(header), payload.data(), payload.size());
+
+        sockaddr_in destinationAddress{
+            .sin_family = AF_INET,
+            .sin_port = htons(Port),
+            .sin_addr = {.s_addr = htonl(destination)},
+        };
+        if (::sendto(fd, packet.data(), sizeof(header) + payload.size(), 0, reinterpret_cast<sockaddr *>(&destinationAddress), sizeof(destinationAddress)) < 0)
+            Logger::Warn("Failed to send LDN packet to 0x{:08X}: {}", destination, strerror(errno));
+    }
+
+    void LanNetwork::SendToStations(PacketType type, span<const u8> payload) {
+        std::array<u8, MaxPacketSize> packet;
+        PacketHeader header{.magic = PacketMagic, .type = type};
+        std::memcpy(packet.data(), &header, sizeof(header));
+        std::memcpy(packet.data() + sizeof(header), payload.data(), payload.size());
+        iovec vector{.iov_base = packet.data(), .iov_len = sizeof(header) + payload.size()};
+
+        std::array<sockaddr_in, NodeCountMax> destinations;
+        std::array<mmsghdr, NodeCountMax> messages{};
+        size_t count{};
+        for (size_t i{1}; i < network.ldn.nodeCountMax; i++) {
+            if (!network.ldn.nodes[i].isConnected)
+                continue;
+
+            destinations[count] = sockaddr_in{
+                .sin_family = AF_INET,
+                .sin_port = htons(Port),
+                .sin_addr = {.s_addr = htonl(network.ldn.nodes[i].ipv4Address)},
+            };
+            messages[count].msg_hdr = msghdr{
+                .msg_name = &destinations[count],
+                .msg_namelen = sizeof(sockaddr_in),
+                .msg_iov = &vector,
+                .msg_iovlen = 1,
+            };
+            count++;
+        }
+
+        if (count && ::sendmmsg(fd, messages.data(), static_cast<unsigned int>(count), 0) < 0)
+            Logger::Warn("Failed to send LDN packet to stations: {}", strerror(errno));
+    }
+
+    MacAddress LanNetwork::GetMacAddress(u32 address) {
+        // A locally administered address derived from the IP address, this is unique within the LAN
+        return {0x02, 0x00, static_cast<u8>(address >> 24), static_cast<u8>(address >> 16), static_cast<u8>(address >> 8), static_cast<u8>(address)};
+    }
+
+    std::vector<NetworkInfo> LanNetwork::Scan(const ScanFilter &filter) {
+        {
+            std::scoped_lock lock{mutex};
+            scanning = true;
+            scanResults.clear();
+        }
+
+        SendPacket(PacketType::Scan, {}, broadcastAddress);
+        std::this_thread::sleep_for(ScanDuration);
+
+        std::scoped_lock lock{mutex};
+        scanning = false;
+        std::erase_if(scanResults, [&](const NetworkInfo &info) { return !filter.Matches(info); });
+        return std::move(scanResults);
+    }
+
+    void LanNetwork::CreateNetwork(const NetworkConfig &config, const SecurityConfig &security, const UserConfig &user, u8 stationAcceptPolicy, span<const u8> advertiseData) {
+        std::scoped_lock lock{mutex};
+
+        network = {};
+        network.networkId.intentId = config.intentId;
+        util::FillRandomBytes(network.networkId.sessionId);
+
+        auto &common{network.common};
+        common.bssid = GetMacAddress(address);
+        auto ssid{fmt::format("{:016X}{:016X}", network.networkId.sessionId.high, network.networkId.sessionId.low)};
+        common.ssid.length = static_cast<u8>(std::min(ssid.size(), common.ssid.name.size() - 1));
+        std::memcpy(common.ssid.name.data(), ssid.data(), common.ssid.length);
+        common.channel = config.channel ? config.channel : DefaultChannel;
+        common.linkLevel = LinkLevelMax;
+        common.networkType = NetworkTypeLdn;
+
+        auto &ldn{network.ldn};
+        util::FillRandomBytes(ldn.securityParameter);
+        ldn.securityMode = security.securityMode;
+        ldn.stationAcceptPolicy = stationAcceptPolicy;
+        ldn.nodeCountMax = static_cast<u8>(std::clamp<size_t>(config.nodeCountMax, 1, NodeCountMax));
+        ldn.nodeCount = 1;
+        ldn.nodes[0] = NodeInfo{
+            .ipv4Address = address,
+            .macAddress = common.bssid,
+            .nodeId = 0,
+            .isConnected = true,
+            .userName = user.userName,
+            .localCommunicationVersion = config.localCommunicationVersion,
+        };
+        ldn.advertiseDataSize = static_cast<u16>(std::min(advertiseData.size(), AdvertiseDataSizeMax));
+        std::memcpy(ldn.advertiseData.data(), advertiseData.data(), ldn.advertiseDataSize);
+
+        nodeChanges = {};
+        nodeChanges[0] = NodeStateChange::Connect;
+        role = Role::AccessPoint;
+    }
+
+    void LanNetwork::SetAdvertiseData(span<const u8> advertiseData) {
+        std::scoped_lock lock{mutex};
+        if (role != Role::AccessPoint)
+            return;
+
+        auto &ldn{network.ldn};
+        ldn.advertiseData = {};
+        ldn.advertiseDataSize = static_cast<u16>(std::min(advertiseData.size(), AdvertiseDataSizeMax));
+        std::memcpy(ldn.advertiseData.data(), advertiseData.data(), ldn.advertiseDataSize);
+
+        SendToStations(PacketType::Sync, span(network).cast<u8>());
+    }
+
+    void LanNetwork::DestroyNetwork() {
+        std::scoped_lock lock{mutex};
+        if (role != Role::AccessPoint)
+            return;
+
+        auto reason{DisconnectReason::DestroyedByUser};
+        SendToStations(PacketType::Disconnect, span(reason).cast<u8>());
+
+        role = Role::None;
+        network = {};
+    }
+
+    Result LanNetwork::Connect(const NetworkInfo &target, const UserConfig &user, u16 localCommunicationVersion) {
+        std::unique_lock lock{mutex};
+
+        network = target;
+        role = Role::Station;
+        joined = false;
+        disconnectReason = DisconnectReason::None;
+
+        NodeInfo node{
+            .ipv4Address = address,
+            .macAddress = GetMacAddress(address),
+            .userName = user.userName,
+            .localCommunicationVersion = localCommunicationVersion,
+        };
+        u32 accessPoint{target.ldn.nodes[0].ipv4Address};
+        SendPacket(PacketType::Connect, span(node).cast<u8>(), accessPoint);
+
+        if (!joinCondition.wait_for(lock, ConnectTimeout, [this] { return joined || role != Role::Station; })) {
+            role = Role::None;
+            network = {};
+            return result::ConnectTimeout;
+        }
+
+        if (!joined) {
+            network = {};
+            return result::ConnectRejected;
+        }
+
+        return {};
+    }
+
+    void LanNetwork::Disconnect() {
+        std::scoped_lock lock{mutex};
+        if (role != Role::Station)
+            return;
+
+        auto reason{DisconnectReason::User};
+        SendPacket(PacketType::Disconnect, span(reason).cast<u8>(), network.ldn.nodes[0].ipv4Address);
+
+        role = Role::None;
+        joined = false;
+        disconnectReason = reason;
+        network = {};
+    }
+
+    bool LanNetwork::IsConnected() {
+        std::scoped_lock lock{mutex};
+        return role == Role::Station && joined;
+    }
+
+    DisconnectReason LanNetwork::GetDisconnectReason() {
+        std::scoped_lock lock{mutex};
+        return disconnectReason;
+    }
+
+    NetworkInfo LanNetwork::GetNetworkInfo() {
+        std::scoped_lock lock{mutex};
+        return network;
+    }
+
+    std::array<NodeStateChange, NodeCountMax> LanNetwork::ConsumeNodeChanges() {
+        std::scoped_lock lock{mutex};
+        return std::exchange(nodeChanges, {});
+    }
+}
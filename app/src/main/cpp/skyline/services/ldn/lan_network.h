@@ -0,0 +1,142 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <netinet/in.h>
+#include "common.h"
+
+namespace skyline::service::ldn {
+    /**
+     * @brief Emulates local wireless networks over the LAN that the host is connected to
+     * @details Networks are discovered with UDP broadcasts and nodes are addressed by their LAN address, the guest is given the same address so its own traffic goes directly over the LAN through bsd sockets and only the control packets of the network go through here
+     * @note Control packets are received in batches with recvmmsg into pre-allocated buffers on a dedicated thread and handled right away, network updates are sent to all stations with a single sendmmsg
+     * @note Stations that leave without disconnecting aren't detected as there are no keep-alives
+     */
+    class LanNetwork {
+      public:
+        static constexpr u16 Port{11452}; //!< The UDP port that control packets are sent to and received on
+        using ChangeCallback = std::function<void()>; //!< A callback that's invoked from the receive thread when the network changes outside of any calls
+
+      private:
+        enum class PacketType : u8 {
+            Scan, //!< Broadcast by stations to discover networks, this has no payload
+            ScanReply, //!< Sent by access points in response to a scan with their NetworkInfo
+            Connect, //!< Sent by a station to the access point with its NodeInfo
+            Sync, //!< Sent by the access point to all stations with the NetworkInfo whenever it changes
+            Disconnect, //!< Sent by either side with a DisconnectReason when leaving or being removed from the network
+        };
+
+        struct PacketHeader {
+            u32 magic;
+            PacketType type;
+            u8 _pad_[3];
+        };
+        static_assert(sizeof(PacketHeader) == 0x8);
+
+        static constexpr u32 PacketMagic{util::MakeMagic<u32>("SLDN")};
+        static constexpr size_t MaxPacketSize{sizeof(PacketHeader) + sizeof(NetworkInfo)};
+        static constexpr size_t ReceiveBatchSize{8}; //!< The maximum amount of packets received with a single recvmmsg
+
+        enum class Role {
+            None,
+            AccessPoint,
+            Station,
+        };
+
+        int fd{-1}; //!< The UDP socket that control packets are sent and received on
+        int wakeFd{-1}; //!< An eventfd that's signalled to make the receive thread exit
+        u32 address{}; //!< The LAN address of the host in host byte order
+        u32 netmask{};
+        u32 broadcastAddress{};
+        ChangeCallback onChange;
+
+        std::mutex mutex; //!< Synchronizes all members below between calls and the receive thread
+        std::condition_variable joinCondition; //!< Signalled when a connecting station is accepted or rejected
+        Role role{};
+        NetworkInfo network{}; //!< The network that's hosted or was joined
+        bool joined{}; //!< If the station has been accepted into the network by the access point
+        DisconnectReason disconnectReason{};
+        std::array<NodeStateChange, NodeCountMax> nodeChanges{}; //!< The state changes of every node since they were last queried
+        bool scanning{};
+        std::vector<NetworkInfo> scanResults;
+
+        std::array<std::array<u8, MaxPacketSize>, ReceiveBatchSize> receiveBuffers{};
+        std::thread receiveThread;
+
+        void ReceiveThread();
+
+        /**
+         * @note `mutex` must be locked when calling this
+         * @return If the network changed in a way the guest should be notified of
+         */
+        bool HandlePacket(span<u8> packet, u32 source);
+
+        void SendPacket(PacketType type, span<const u8> payload, u32 destination);
+
+        /**
+         * @brief Sends the same packet to every station in the network with a single call
+         * @note `mutex` must be locked when calling this
+         */
+        void SendToStations(PacketType type, span<const u8> payload);
+
+        /**
+         * @return The MAC address that's reported for the node with the supplied address
+         */
+        static MacAddress GetMacAddress(u32 address);
+
+      public:
+        /**
+         * @note This throws an exception if the host isn't connected to a LAN
+         */
+        LanNetwork(ChangeCallback onChange);
+
+        ~LanNetwork();
+
+        u32 GetAddress() const {
+            return address;
+        }
+
+        u32 GetNetmask() const {
+            return netmask;
+        }
+
+        /**
+         * @brief Broadcasts a scan on the LAN and collects the replies of all access points for a short duration
+         */
+        std::vector<NetworkInfo> Scan(const ScanFilter &filter);
+
+        /**
+         * @brief Starts hosting a network with the host as its access point
+         */
+        void CreateNetwork(const NetworkConfig &config, const SecurityConfig &security, const UserConfig &user, u8 stationAcceptPolicy, span<const u8> advertiseData);
+
+        void SetAdvertiseData(span<const u8> advertiseData);
+
+        /**
+         * @brief Stops hosting the network, all stations are disconnected from it
+         */
+        void DestroyNetwork();
+
+        /**
+         * @brief Joins the supplied network as a station, this waits for the access point to accept the station
+         */
+        Result Connect(const NetworkInfo &target, const UserConfig &user, u16 localCommunicationVersion);
+
+        void Disconnect();
+
+        /**
+         * @return If the station is connected to a network, this is false after the access point has disconnected the station
+         */
+        bool IsConnected();
+
+        DisconnectReason GetDisconnectReason();
+
+        NetworkInfo GetNetworkInfo();
+
+        /**
+         * @return The state changes of all nodes since this was last called
+         */
+        std::array<NodeStateChange, NodeCountMax> ConsumeNodeChanges();
+    };
+}
@@ -56,36 +56,59 @@ namespace skyline::service::nvdrv::core {
         return PosixResult::Success;
     }
 
-    NvMap::NvMap(const DeviceState &state) : state(state), smmuAllocator(soc::SmmuPageSize) {}
-
-    void NvMap::AddHandle(std::shared_ptr<Handle> handleDesc) {
-        std::scoped_lock lock(handlesLock);
-
-        handles.emplace(handleDesc->id, std::move(handleDesc));
-    }
+    NvMap::NvMap(const DeviceState &state) : state(state), smmuAllocator(soc::SmmuPageSize), handles(1) {}
 
     void NvMap::UnmapHandle(Handle &handleDesc) {
-        // Remove pending unmap queue entry if needed
-        if (handleDesc.unmapQueueEntry) {
-            unmapQueue.erase(*handleDesc.unmapQueueEntry);
-            handleDesc.unmapQueueEntry.reset();
-        }
-
-        // Free and unmap the handle from the SMMU
+        // Free and unmap the handle from the SMMU, any entry in the unmap queue is skipped when it's popped
         state.soc->smmu.Unmap(handleDesc.pinVirtAddress, static_cast<u32>(handleDesc.alignedSize));
         smmuAllocator.Free(handleDesc.pinVirtAddress, static_cast<u32>(handleDesc.alignedSize));
         handleDesc.pinVirtAddress = 0;
     }
 
+    bool NvMap::UnmapQueuedHandle(Handle &pinningHandle) {
+        std::scoped_lock queueLock(unmapQueueLock);
+
+        bool contended{};
+        for (size_t remaining{unmapQueue.size()}; remaining; remaining--) {
+            auto freeHandleDesc{unmapQueue.front().lock()};
+            unmapQueue.pop_front();
+            if (!freeHandleDesc)
+                continue; // The handle has been freed since it was queued
+
+            if (freeHandleDesc.get() == &pinningHandle) {
+                // The pinning handle isn't mapped as it's being pinned, so the entry is stale
+                pinningHandle.unmapQueued = false;
+                continue;
+            }
+
+            // A handle being locked means it's being pinned or freed, its thread may be waiting on the queue lock so we can't block on it
+            std::unique_lock freeLock(freeHandleDesc->mutex, std::try_to_lock);
+            if (!freeLock) {
+                unmapQueue.emplace_back(std::move(freeHandleDesc));
+                contended = true;
+                continue;
+            }
+
+            freeHandleDesc->unmapQueued = false;
+            if (!freeHandleDesc->pins && freeHandleDesc->pinVirtAddress) {
+                UnmapHandle(*freeHandleDesc);
+                return true;
+            }
+        }
+
+        return contended;
+    }
 
     bool NvMap::TryRemoveHandle(const Handle &handleDesc) {
         // No dupes left, we can remove from handle map
         if (handleDesc.dupes == 0 && handleDesc.internalDupes == 0) {
             std::scoped_lock lock(handlesLock);
 
-            auto it{handles.find(handleDesc.id)};
-            if (it != handles.end())
-                handles.erase(it);
+            auto &entry{handles[handleDesc.id / HandleIdIncrement]};
+            if (entry.get() == &handleDesc) {
+                entry.reset();
+                freeHandleIds.push_back(handleDesc.id);
+            }
 
             return true;
         } else {
@@ -97,21 +120,45 @@ namespace skyline::service::nvdrv::core {
         if (!size) [[unlikely]]
             return PosixResult::InvalidArgument;
 
-        u32 id{nextHandleId.fetch_add(HandleIdIncrement, std::memory_order_relaxed)};
+        std::scoped_lock lock(handlesLock);
+
+        Handle::Id id;
+        if (!freeHandleIds.empty()) {
+            id = freeHandleIds.back();
+            freeHandleIds.pop_back();
+        } else {
+            id = static_cast<Handle::Id>(handles.size() * HandleIdIncrement);
+            handles.emplace_back();
+        }
+
         auto handleDesc{std::make_shared<Handle>(size, id)};
-        AddHandle(handleDesc);
+        handles[id / HandleIdIncrement] = handleDesc;
 
         return handleDesc;
     }
 
     std::shared_ptr<NvMap::Handle> NvMap::GetHandle(Handle::Id handle) {
-        std::scoped_lock lock(handlesLock);
+        std::shared_lock lock(handlesLock);
 
-        try {
-            return handles.at(handle);
-        } catch (std::out_of_range &e) {
+        size_t index{handle / HandleIdIncrement};
+        if (handle % HandleIdIncrement || index >= handles.size()) [[unlikely]]
             return nullptr;
+
+        return handles[index];
+    }
+
+    u64 NvMap::HashHandles(u64 seed) {
+        std::shared_lock lock(handlesLock);
+        for (const auto &handleDesc : handles) {
+            if (!handleDesc)
+                continue;
+
+            std::scoped_lock handleLock(handleDesc->mutex);
+            // The members are hashed individually as the handle contains a mutex and padding
+            std::array<u64, 8> handleState{handleDesc->id, handleDesc->size, handleDesc->align, handleDesc->address, static_cast<u64>(handleDesc->dupes), std::bit_cast<u32>(handleDesc->flags), handleDesc->kind, handleDesc->allocated};
+            seed = XXH64(handleState.data(), sizeof(handleState), seed);
         }
+        return seed;
     }
 
     u32 NvMap::PinHandle(NvMap::Handle::Id handle) {
@@ -120,33 +167,14 @@ namespace skyline::service::nvdrv::core {
             return 0;
 
         std::scoped_lock lock(handleDesc->mutex);
-        if (!handleDesc->pins) {
-            // If we're in the unmap queue we can just remove ourselves and return since we're already mapped
-            {
-                // Lock now to prevent our queue entry from being removed for allocation in-between the following check and erase
-                std::scoped_lock queueLock(unmapQueueLock);
-                if (handleDesc->unmapQueueEntry) {
-                    unmapQueue.erase(*handleDesc->unmapQueueEntry);
-                    handleDesc->unmapQueueEntry.reset();
-
-                    handleDesc->pins++;
-                    return handleDesc->pinVirtAddress;
-                }
-            }
 
-            // If not then allocate some space and map it
+        // (Fast path) If the handle is still mapped from a prior pin then we can just reuse the mapping, any unmap queue entry it has will be skipped as it's pinned
+        if (!handleDesc->pinVirtAddress) {
             u32 address{};
             while (!(address = smmuAllocator.Allocate(static_cast<u32>(handleDesc->alignedSize)))) {
                 // Free handles until the allocation succeeds
-                std::scoped_lock queueLock(unmapQueueLock);
-                if (auto freeHandleDesc{unmapQueue.front()}) {
-                    // Handles in the unmap queue are guaranteed not to be pinned so don't bother checking if they are before unmapping
-                    std::scoped_lock freeLock(freeHandleDesc->mutex);
-                    if (handleDesc->pinVirtAddress)
-                        UnmapHandle(*freeHandleDesc);
-                } else {
+                if (!UnmapQueuedHandle(*handleDesc))
                     throw exception("Ran out of SMMU address space!");
-                }
             }
 
             state.soc->smmu.Map(address, reinterpret_cast<u8 *>(handleDesc->address), static_cast<u32>(handleDesc->alignedSize));
@@ -165,12 +193,12 @@ namespace skyline::service::nvdrv::core {
         std::scoped_lock lock(handleDesc->mutex);
         if (--handleDesc->pins < 0) {
             Logger::Warn("Pin count imbalance detected!");
-        } else if (!handleDesc->pins) {
+        } else if (!handleDesc->pins && !handleDesc->unmapQueued) {
             std::scoped_lock queueLock(unmapQueueLock);
 
-            // Add to the unmap queue allowing this handle's memory to be freed if needed
-            unmapQueue.push_back(handleDesc);
-            handleDesc->unmapQueueEntry = std::prev(unmapQueue.end());
+            // Add to the unmap queue allowing this handle's memory to be freed if needed, a handle that still has an entry from a prior unpin reuses it
+            unmapQueue.emplace_back(handleDesc);
+            handleDesc->unmapQueued = true;
         }
     }
 
@@ -190,10 +218,8 @@ namespace skyline::service::nvdrv::core {
                     Logger::Warn("User duplicate count imbalance detected!");
                 } else if (handleDesc->dupes == 0) {
                     // Force unmap the handle
-                    if (handleDesc->pinVirtAddress) {
-                        std::scoped_lock queueLock(unmapQueueLock);
+                    if (handleDesc->pinVirtAddress)
                         UnmapHandle(*handleDesc);
-                    }
 
                     handleDesc->pins = 0;
                 }
@@ -3,7 +3,7 @@
 
 #pragma once
 
-#include <queue>
+#include <deque>
 #include <common.h>
 #include <common/address_space.h>
 #include <services/common/result.h>
@@ -33,7 +33,7 @@ namespace skyline::service::nvdrv::core {
 
             i32 pins{};
             u32 pinVirtAddress{};
-            std::optional<std::list<std::shared_ptr<Handle>>::iterator> unmapQueueEntry{};
+            bool unmapQueued{}; //!< If there's an entry for this handle in the unmap queue, entries are lazily skipped so this may be set while the handle is pinned again
 
             struct Flags {
                 bool mapUncached : 1; //!< If the handle should be mapped as uncached
@@ -79,23 +79,27 @@ namespace skyline::service::nvdrv::core {
         const DeviceState &state;
 
         FlatAllocator<u32, 0, 32> smmuAllocator;
-        std::list<std::shared_ptr<Handle>> unmapQueue;
+        std::deque<std::weak_ptr<Handle>> unmapQueue; //!< A FIFO of handles that have been fully unpinned, entries of handles that were pinned again or freed since are skipped rather than removed
         std::mutex unmapQueueLock; //!< Protects access to `unmapQueue`
 
-        std::unordered_map<Handle::Id, std::shared_ptr<Handle>> handles; //!< Main owning map of handles
-        std::mutex handlesLock; //!< Protects access to `handles`
-
         static constexpr u32 HandleIdIncrement{4}; //!< Each new handle ID is an increment of 4 from the previous
-        std::atomic<u32> nextHandleId{HandleIdIncrement};
-
-        void AddHandle(std::shared_ptr<Handle> handle);
+        std::vector<std::shared_ptr<Handle>> handles; //!< Main owning table of handles indexed by their ID divided by `HandleIdIncrement`, the first entry is always empty as 0 is an invalid ID
+        std::vector<Handle::Id> freeHandleIds; //!< IDs of removed handles which are reused prior to growing the table, this keeps the table dense
+        std::shared_mutex handlesLock; //!< Protects access to `handles` and `freeHandleIds`, lookups only lock this in shared mode
 
         /**
          * @brief Unmaps and frees the SMMU memory region a handle is mapped to
-         * @note Both `unmapQueueLock` and `handleDesc.mutex` MUST be locked when calling this
+         * @note `handleDesc.mutex` MUST be locked when calling this
          */
         void UnmapHandle(Handle &handleDesc);
 
+        /**
+         * @brief Unmaps the least recently unpinned handle in the unmap queue to free up SMMU address space
+         * @param pinningHandle The handle that is being pinned, its mutex is held by the caller so it's skipped
+         * @return If any SMMU address space could be freed or another attempt should be made as queued handles were concurrently locked
+         */
+        bool UnmapQueuedHandle(Handle &pinningHandle);
+
         /**
          * @brief Removes a handle from the map taking its dupes into account
          * @note handleDesc.mutex MUST be locked when calling this
@@ -122,9 +126,15 @@ namespace skyline::service::nvdrv::core {
 
         std::shared_ptr<Handle> GetHandle(Handle::Id handle);
 
+        /**
+         * @return A hash of the guest-visible state of all handles, SMMU pins are excluded as the guest can't observe them
+         */
+        u64 HashHandles(u64 seed);
+
         /**
          * @brief Maps a handle into the SMMU address space
          * @note This operation is refcounted, the number of calls to this must eventually match the number of calls to `UnpinHandle`
+         * @note Pinning a handle that is still mapped from a prior pin doesn't need to touch the unmap queue
          * @return The SMMU virtual address that the handle has been mapped to
          */
         u32 PinHandle(Handle::Id handle);
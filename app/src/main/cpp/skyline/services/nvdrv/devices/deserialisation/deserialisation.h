@@ -10,9 +10,9 @@
 namespace skyline::service::nvdrv::deserialisation {
     template<typename Desc, typename ArgType> requires (Desc::In && IsIn<ArgType>::value)
     constexpr ArgType DecodeArgument(span<u8, Desc::Size> buffer, size_t &offset, std::array<size_t, NumSaveSlots> &saveSlots) {
-        auto out{buffer.subspan(offset).template as<ArgType, true>()};
-        offset += sizeof(ArgType);
-        return out;
+        auto &in{buffer.subspan(offset).template as<RemoveIn<ArgType>, true>()};
+        offset += sizeof(RemoveIn<ArgType>);
+        return in;
     }
 
     template<typename Desc, typename ArgType> requires (Desc::Out && Desc::In && IsInOut<ArgType>::value)
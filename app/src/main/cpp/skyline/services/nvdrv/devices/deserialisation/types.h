@@ -12,15 +12,18 @@ namespace skyline::service::nvdrv::deserialisation {
     template<typename T>
     concept BufferData = std::is_trivially_copyable_v<T> && !std::is_pointer_v<T>;
 
-    // Input IOCTL template types
+    // Input IOCTL template types, these are views into the IOCTL buffer rather than copies of the arguments
     template<typename T> requires BufferData<T>
-    using In = const T;
+    using In = const T &;
 
     template<typename>
     struct IsIn : std::false_type {};
 
     template<typename T>
-    struct IsIn<In<T>> : std::true_type {};
+    struct IsIn<const T &> : std::true_type {};
+
+    template<typename T> requires IsIn<T>::value
+    using RemoveIn = std::remove_cvref_t<T>;
 
 
     // Input/Output IOCTL template types
@@ -30,7 +33,7 @@ namespace skyline::service::nvdrv::deserialisation {
     template<typename>
     struct IsInOut : std::false_type {};
 
-    template<typename T>
+    template<typename T> requires (!std::is_const_v<T>) // In is a const reference which mustn't be treated as InOut
     struct IsInOut<InOut<T>> : std::true_type {};
 
     template<typename T> requires IsInOut<T>::value
@@ -19,6 +19,20 @@ namespace skyline::service::nvdrv::device::nvhost {
 
     AsGpu::AsGpu(const DeviceState &state, Driver &driver, Core &core, const SessionContext &ctx) : NvDevice(state, driver, core, ctx) {}
 
+    u64 AsGpu::HashMappings(u64 seed) {
+        std::scoped_lock lock(mutex);
+        for (const auto &[offset, allocation] : allocationMap) {
+            std::array<u64, 4> allocationState{offset, allocation.size, allocation.pageSize, allocation.sparse};
+            seed = XXH64(allocationState.data(), sizeof(allocationState), seed);
+        }
+
+        for (const auto &[offset, mapping] : mappingMap) {
+            std::array<u64, 6> mappingState{offset, reinterpret_cast<u64>(mapping->ptr), mapping->size, mapping->fixed, mapping->bigPage, mapping->sparseAlloc};
+            seed = XXH64(mappingState.data(), sizeof(mappingState), seed);
+        }
+        return seed;
+    }
+
     PosixResult AsGpu::BindChannel(In<FileDescriptor> channelFd) {
         std::scoped_lock lock(mutex);
 
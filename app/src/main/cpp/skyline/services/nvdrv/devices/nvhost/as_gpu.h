@@ -103,6 +103,11 @@ namespace skyline::service::nvdrv::device::nvhost {
 
         AsGpu(const DeviceState &state, Driver &driver, Core &core, const SessionContext &ctx);
 
+        /**
+         * @return A hash of all allocations and mappings in the address space, these determine the layout of the GMMU
+         */
+        u64 HashMappings(u64 seed);
+
         /**
          * @brief Binds this address space to a channel
          * @url https://switchbrew.org/wiki/NV_services#NVGPU_AS_IOCTL_BIND_CHANNEL
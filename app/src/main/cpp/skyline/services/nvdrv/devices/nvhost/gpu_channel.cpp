@@ -89,28 +89,29 @@ namespace skyline::service::nvdrv::device::nvhost {
         if (numEntries > gpEntries.size())
             throw exception("GpEntry size mismatch!");
 
-        std::scoped_lock lock(channelMutex);
+        if (flags.fenceWait && flags.incrementWithValue)
+            return PosixResult::InvalidArgument;
 
-        if (flags.fenceWait) {
-            if (flags.incrementWithValue)
-                return PosixResult::InvalidArgument;
+        // The fence being signalled can be checked prior to locking as the result only determines if a wait needs to be pushed
+        bool needsFenceWait{flags.fenceWait && !core.syncpointManager.IsFenceSignalled(fence)};
+        u32 increment{(flags.fenceIncrement ? 2 : 0) + (flags.incrementWithValue ? fence.threshold : 0)};
+
+        // The threshold must be allocated in the same order the entries are pushed in so the lock needs to cover both, the entries themselves are pushed in bulk to the GPFIFO thread
+        std::scoped_lock lock(channelMutex);
 
-            if (!core.syncpointManager.IsFenceSignalled(fence)) {
-                // Wraparound
-                if (pushBufferMemoryOffset + SyncpointWaitCmdLen >= pushBufferMemory.size())
-                    pushBufferMemoryOffset = 0;
+        if (needsFenceWait) {
+            // Wraparound
+            if (pushBufferMemoryOffset + SyncpointWaitCmdLen >= pushBufferMemory.size())
+                pushBufferMemoryOffset = 0;
 
-                AddSyncpointWaitCmd(span(pushBufferMemory).subspan(pushBufferMemoryOffset, SyncpointWaitCmdLen), fence);
-                channelCtx->gpfifo.Push(soc::gm20b::GpEntry(pushBufferAddr + pushBufferMemoryOffset * sizeof(u32), SyncpointWaitCmdLen));
+            AddSyncpointWaitCmd(span(pushBufferMemory).subspan(pushBufferMemoryOffset, SyncpointWaitCmdLen), fence);
+            channelCtx->gpfifo.Push(soc::gm20b::GpEntry(pushBufferAddr + pushBufferMemoryOffset * sizeof(u32), SyncpointWaitCmdLen));
 
-                // Increment offset
-                pushBufferMemoryOffset += SyncpointWaitCmdLen;
-            }
+            // Increment offset
+            pushBufferMemoryOffset += SyncpointWaitCmdLen;
         }
 
         fence.id = channelSyncpoint;
-
-        u32 increment{(flags.fenceIncrement ? 2 : 0) + (flags.incrementWithValue ? fence.threshold : 0)};
         fence.threshold = core.syncpointManager.IncrementSyncpointMaxExt(channelSyncpoint, increment);
 
         channelCtx->gpfifo.Push(gpEntries.subspan(0, numEntries));
@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: MIT OR MPL-2.0
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <common/perf_stats.h>
 #include "driver.h"
 #include "devices/nvmap.h"
 #include "devices/nvhost/ctrl.h"
@@ -103,12 +104,26 @@ namespace skyline::service::nvdrv {
         }
     }
 
+    /**
+     * @brief Records the time spent handling an ioctl into the ioctl perf counters once it goes out of scope
+     */
+    struct IoctlTimer {
+        i64 start{util::GetTimeNs()};
+
+        ~IoctlTimer() {
+            PerfStats::Increment(PerfStats::Counter::NvdrvIoctls);
+            PerfStats::Increment(PerfStats::Counter::NvdrvIoctlNs, static_cast<u64>(util::GetTimeNs() - start));
+        }
+    };
+
     NvResult Driver::Ioctl(FileDescriptor fd, IoctlDescriptor cmd, span<u8> buffer) {
         try {
+            IoctlTimer timer;
             std::shared_lock lock(deviceMutex);
-            Logger::Debug("fd: {}, cmd: 0x{:X}, device: {}", fd, cmd.raw, devices.at(fd)->GetName());
+            auto &device{*devices.at(fd)};
+            Logger::Debug("fd: {}, cmd: 0x{:X}, device: {}", fd, cmd.raw, device.GetName());
             TRACE_EVENT("service", "Ioctl", "fd", fd, "cmd", cmd.raw);
-            return ConvertResult(LogIoctlResult(devices.at(fd)->Ioctl(cmd, buffer), cmd.raw));
+            return ConvertResult(LogIoctlResult(device.Ioctl(cmd, buffer), cmd.raw));
         } catch (const std::out_of_range &) {
             throw exception("Ioctl was called with invalid fd: {}", fd);
         }
@@ -116,10 +131,12 @@ namespace skyline::service::nvdrv {
 
     NvResult Driver::Ioctl2(FileDescriptor fd, IoctlDescriptor cmd, span<u8> buffer, span<u8> inlineBuffer) {
         try {
+            IoctlTimer timer;
             std::shared_lock lock(deviceMutex);
-            Logger::Debug("fd: {}, cmd: 0x{:X}, device: {}", fd, cmd.raw, devices.at(fd)->GetName());
+            auto &device{*devices.at(fd)};
+            Logger::Debug("fd: {}, cmd: 0x{:X}, device: {}", fd, cmd.raw, device.GetName());
             TRACE_EVENT("service", "Ioctl", "fd", fd, "cmd", cmd.raw);
-            return ConvertResult(LogIoctlResult(devices.at(fd)->Ioctl2(cmd, buffer, inlineBuffer), cmd.raw));
+            return ConvertResult(LogIoctlResult(device.Ioctl2(cmd, buffer, inlineBuffer), cmd.raw));
         } catch (const std::out_of_range &) {
             throw exception("Ioctl2 was called with invalid fd: {}", fd);
         }
@@ -127,10 +144,12 @@ namespace skyline::service::nvdrv {
 
     NvResult Driver::Ioctl3(FileDescriptor fd, IoctlDescriptor cmd, span<u8> buffer, span<u8> inlineBuffer) {
         try {
+            IoctlTimer timer;
             std::shared_lock lock(deviceMutex);
-            Logger::Debug("fd: {}, cmd: 0x{:X}, device: {}", fd, cmd.raw, devices.at(fd)->GetName());
+            auto &device{*devices.at(fd)};
+            Logger::Debug("fd: {}, cmd: 0x{:X}, device: {}", fd, cmd.raw, device.GetName());
             TRACE_EVENT("service", "Ioctl", "fd", fd, "cmd", cmd.raw);
-            return ConvertResult(LogIoctlResult(devices.at(fd)->Ioctl3(cmd, buffer, inlineBuffer), cmd.raw));
+            return ConvertResult(LogIoctlResult(device.Ioctl3(cmd, buffer, inlineBuffer), cmd.raw));
         } catch (const std::out_of_range &) {
             throw exception("Ioctl3 was called with invalid fd: {}", fd);
         }
@@ -155,4 +174,24 @@ namespace skyline::service::nvdrv {
             throw exception("QueryEvent was called with invalid fd: {}", fd);
         }
     }
+
+    u64 Driver::HashState(u64 seed) {
+        seed = core.nvMap.HashHandles(seed);
+
+        std::shared_lock lock(deviceMutex);
+        std::vector<FileDescriptor> fds;
+        fds.reserve(devices.size());
+        for (const auto &[fd, device] : devices)
+            fds.push_back(fd);
+        std::sort(fds.begin(), fds.end()); // The device map is unordered so it's hashed in FD order to be deterministic
+
+        for (auto fd : fds) {
+            auto &device{devices.at(fd)};
+            seed = XXH64(&fd, sizeof(fd), seed);
+            seed = XXH64(device->GetName().data(), device->GetName().size(), seed);
+            if (auto asGpu{dynamic_cast<device::nvhost::AsGpu *>(device.get())})
+                seed = asGpu->HashMappings(seed);
+        }
+        return seed;
+    }
 }
@@ -62,5 +62,10 @@ namespace skyline::service::nvdrv {
          * @brief Closes the device specified by `fd`
          */
         void CloseDevice(FileDescriptor fd);
+
+        /**
+         * @return A hash of the guest-visible state of nvdrv: the open devices, the nvmap handles and the mappings of all GPU address spaces
+         */
+        u64 HashState(u64 seed);
     };
 }
@@ -54,6 +54,7 @@
     case util::MakeMagic<ServiceName>(name): { \
             std::shared_ptr<BaseService> serviceObject{std::make_shared<class>(state, *this, ##__VA_ARGS__)}; \
             serviceMap[util::MakeMagic<ServiceName>(name)] = serviceObject; \
+            serviceNameMap[serviceObject.get()] = util::MakeMagic<ServiceName>(name); \
             return serviceObject; \
         }
 
@@ -114,6 +115,7 @@ namespace skyline::service {
             SERVICE_CASE(nfp::IUserManager, "nfp:user")
             SERVICE_CASE(nifm::IStaticService, "nifm:u")
             SERVICE_CASE(socket::IClient, "bsd:u")
+            SERVICE_CASE(socket::IClient, "bsd:s")
             SERVICE_CASE(spl::IRandomInterface, "csrng")
             SERVICE_CASE(ssl::ISslService, "ssl")
             SERVICE_CASE(prepo::IPrepoService, "prepo:u")
@@ -134,9 +136,8 @@ namespace skyline::service {
         auto serviceObject{CreateOrGetService(name)};
         KHandle handle{};
         if (session.isDomain) {
-            session.domains.push_back(serviceObject);
-            response.domainObjects.push_back(session.handleIndex);
-            handle = session.handleIndex++;
+            handle = session.AddDomainObject(serviceObject);
+            response.domainObjects.push_back(handle);
         } else {
             handle = state.process->NewHandle<type::KSession>(serviceObject).handle;
             response.moveHandles.push_back(handle);
@@ -150,9 +151,8 @@ namespace skyline::service {
         KHandle handle{};
 
         if (session.isDomain) {
-            session.domains.push_back(serviceObject);
-            response.domainObjects.push_back(session.handleIndex);
-            handle = session.handleIndex++;
+            handle = session.AddDomainObject(serviceObject);
+            response.domainObjects.push_back(handle);
         } else {
             handle = state.process->NewHandle<type::KSession>(serviceObject).handle;
             response.moveHandles.push_back(handle);
@@ -161,24 +161,48 @@ namespace skyline::service {
         Logger::Debug("Service has been registered: \"{}\" (0x{:X})", serviceObject->GetName(), handle);
     }
 
+    void ServiceManager::EraseService(BaseService *serviceObject) {
+        auto nameIter{serviceNameMap.find(serviceObject)};
+        if (nameIter != serviceNameMap.end()) {
+            serviceMap.erase(nameIter->second);
+            serviceNameMap.erase(nameIter);
+        }
+    }
+
     void ServiceManager::CloseSession(KHandle handle) {
         std::scoped_lock serviceGuard{mutex};
         auto session{state.process->GetHandle<type::KSession>(handle)};
         if (session->isOpen) {
             if (session->isDomain) {
                 for (const auto &domainService : session->domains)
-                    std::erase_if(serviceMap, [domainService](const auto &entry) {
-                        return entry.second == domainService;
-                    });
+                    if (domainService)
+                        EraseService(domainService.get());
             } else {
-                std::erase_if(serviceMap, [session](const auto &entry) {
-                    return entry.second == session->serviceObject;
-                });
+                EraseService(session->serviceObject.get());
             }
             session->isOpen = false;
         }
     }
 
+    std::vector<ServiceName> ServiceManager::GetServiceNames() {
+        std::scoped_lock serviceGuard{mutex};
+        std::vector<ServiceName> names;
+        names.reserve(serviceMap.size());
+        for (const auto &[name, service] : serviceMap)
+            names.push_back(name);
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+
+    u64 ServiceManager::HashHostState() {
+        std::scoped_lock serviceGuard{mutex};
+        u64 hash{globalServiceState->nvdrv.HashState(0)};
+        // The binder driver is only looked up rather than created so hashing never changes the set of open services
+        if (auto binder{serviceMap.find(util::MakeMagic<ServiceName>("dispdrv"))}; binder != serviceMap.end())
+            hash = std::static_pointer_cast<hosbinder::IHOSBinderDriver>(binder->second)->HashState(hash);
+        return hash;
+    }
+
     void ServiceManager::SyncRequestHandler(KHandle handle) {
         TRACE_EVENT("kernel", "ServiceManager::SyncRequestHandler");
         auto session{state.process->GetHandle<type::KSession>(handle)};
@@ -202,12 +226,11 @@ namespace skyline::service {
                                     response.errorCode = service->HandleRequest(*session, request, response);
                                     break;
 
-                                case ipc::DomainCommand::CloseVHandle:
-                                    std::erase_if(serviceMap, [service](const auto &entry) {
-                                        return entry.second == service;
-                                    });
-                                    session->domains.at(request.domain->objectId).reset();
+                                case ipc::DomainCommand::CloseVHandle: {
+                                    std::scoped_lock serviceGuard{mutex};
+                                    EraseService(session->CloseDomainObject(request.domain->objectId).get());
                                     break;
+                                }
                             }
                         } catch (std::out_of_range &) {
                             throw exception("Invalid object ID was used with domain request");
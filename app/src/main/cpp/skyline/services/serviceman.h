@@ -19,8 +19,15 @@ namespace skyline::service {
       private:
         const DeviceState &state;
         std::unordered_map<ServiceName, std::shared_ptr<BaseService>> serviceMap; //!< A mapping from a Service to the underlying object
+        std::unordered_map<BaseService *, ServiceName> serviceNameMap; //!< A reverse mapping from an object in the service map to its name, this allows removing an object without searching the service map
         std::mutex mutex; //!< Synchronizes concurrent access to services to prevent crashes
 
+        /**
+         * @brief Removes a service object from the service map if it's in it, so it's recreated when it's requested again
+         * @note 'mutex' **must** be locked by the calling thread
+         */
+        void EraseService(BaseService *serviceObject);
+
       public:
         std::shared_ptr<BaseService> smUserInterface; //!< Used by applications to open connections to services
         std::shared_ptr<GlobalServiceState> globalServiceState;
@@ -64,6 +71,17 @@ namespace skyline::service {
          */
         void CloseSession(KHandle handle);
 
+        /**
+         * @return The names of all services which are currently open, in ascending order
+         */
+        std::vector<ServiceName> GetServiceNames();
+
+        /**
+         * @return A hash of the host-side state of services that the guest holds references into: nvdrv devices, nvmap handles, GPU address spaces and the display layer
+         * @note This is used to determine if a save state can be restored, as the state of these objects isn't part of it
+         */
+        u64 HashHostState();
+
         /**
          * @brief Handles a Synchronous IPC Request
          * @param handle The handle of the object
@@ -1,11 +1,274 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/tcp.h>
 #include "IClient.h"
 
 namespace skyline::service::socket {
+    /**
+     * @brief The BSD layout of an IPv4 socket address used by the guest, this has a length prefix before the family
+     */
+    struct GuestSockAddrIn {
+        u8 length;
+        u8 family;
+        u16 port; //!< The port in network byte order
+        u32 address; //!< The address in network byte order
+        std::array<u8, 8> zero;
+    };
+    static_assert(sizeof(GuestSockAddrIn) == 0x10);
+
+    /**
+     * @brief The layout of timeval used by the guest for Select and socket timeouts
+     */
+    struct GuestTimeval {
+        i64 seconds;
+        i64 microseconds;
+    };
+    static_assert(sizeof(GuestTimeval) == 0x10);
+
+    constexpr i32 GuestSockNonBlock{0x20000000}; //!< SOCK_NONBLOCK in the type supplied to Socket
+    constexpr i32 GuestSockCloExec{0x10000000}; //!< SOCK_CLOEXEC in the type supplied to Socket
+    constexpr i32 GuestFlagNonBlock{0x4}; //!< O_NONBLOCK in the file status flags of Fcntl
+    constexpr i32 GuestMsgDontWait{0x80}; //!< MSG_DONTWAIT in the flags of send and receive calls
+    constexpr i32 GuestSolSocket{0xFFFF}; //!< SOL_SOCKET for socket options
+    constexpr i32 GuestSoSndTimeo{0x1005}; //!< SO_SNDTIMEO, this is emulated rather than set on the host socket
+    constexpr i32 GuestSoRcvTimeo{0x1006}; //!< SO_RCVTIMEO, this is emulated rather than set on the host socket
+    constexpr size_t FdSetSize{1024}; //!< The amount of descriptors in a guest fd_set
+
+    /**
+     * @brief Pushes the return value of a socket call alongside the errno it failed with
+     * @note The guest uses the same errno values as the host so they're passed through unmodified
+     */
+    static void PushResult(ipc::IpcResponse &response, i64 result, i32 error = 0) {
+        response.Push<i32>(static_cast<i32>(result));
+        response.Push<i32>(result < 0 ? error : 0);
+    }
+
+    static int ConvertMessageFlags(i32 flags) {
+        constexpr i32 GuestMsgOob{0x1}, GuestMsgPeek{0x2}, GuestMsgDontRoute{0x4}, GuestMsgWaitAll{0x40};
+
+        int hostFlags{};
+        if (flags & GuestMsgOob)
+            hostFlags |= MSG_OOB;
+        if (flags & GuestMsgPeek)
+            hostFlags |= MSG_PEEK;
+        if (flags & GuestMsgDontRoute)
+            hostFlags |= MSG_DONTROUTE;
+        if (flags & GuestMsgWaitAll)
+            hostFlags |= MSG_WAITALL;
+        return hostFlags;
+    }
+
+    /**
+     * @brief Translates a BSD socket option into the equivalent host level and option
+     */
+    static std::optional<std::pair<int, int>> ConvertSocketOption(i32 level, i32 option) {
+        if (level == GuestSolSocket) {
+            switch (option) {
+                case 0x1:
+                    return std::pair{SOL_SOCKET, SO_DEBUG};
+                case 0x2:
+                    return std::pair{SOL_SOCKET, SO_ACCEPTCONN};
+                case 0x4:
+                    return std::pair{SOL_SOCKET, SO_REUSEADDR};
+                case 0x8:
+                    return std::pair{SOL_SOCKET, SO_KEEPALIVE};
+                case 0x10:
+                    return std::pair{SOL_SOCKET, SO_DONTROUTE};
+                case 0x20:
+                    return std::pair{SOL_SOCKET, SO_BROADCAST};
+                case 0x80:
+                    return std::pair{SOL_SOCKET, SO_LINGER};
+                case 0x100:
+                    return std::pair{SOL_SOCKET, SO_OOBINLINE};
+                case 0x200:
+                    return std::pair{SOL_SOCKET, SO_REUSEPORT};
+                case 0x1001:
+                    return std::pair{SOL_SOCKET, SO_SNDBUF};
+                case 0x1002:
+                    return std::pair{SOL_SOCKET, SO_RCVBUF};
+                case 0x1003:
+                    return std::pair{SOL_SOCKET, SO_SNDLOWAT};
+                case 0x1004:
+                    return std::pair{SOL_SOCKET, SO_RCVLOWAT};
+                case 0x1007:
+                    return std::pair{SOL_SOCKET, SO_ERROR};
+                case 0x1008:
+                    return std::pair{SOL_SOCKET, SO_TYPE};
+                default:
+                    return std::nullopt;
+            }
+        } else if (level == IPPROTO_IP) {
+            switch (option) {
+                case 0x3:
+                    return std::pair{IPPROTO_IP, IP_TOS};
+                case 0x4:
+                    return std::pair{IPPROTO_IP, IP_TTL};
+                case 0x9:
+                    return std::pair{IPPROTO_IP, IP_MULTICAST_IF};
+                case 0xA:
+                    return std::pair{IPPROTO_IP, IP_MULTICAST_TTL};
+                case 0xB:
+                    return std::pair{IPPROTO_IP, IP_MULTICAST_LOOP};
+                case 0xC:
+                    return std::pair{IPPROTO_IP, IP_ADD_MEMBERSHIP};
+                case 0xD:
+                    return std::pair{IPPROTO_IP, IP_DROP_MEMBERSHIP};
+                default:
+                    return std::nullopt;
+            }
+        } else if (level == IPPROTO_TCP) {
+            // The TCP options used by applications (TCP_NODELAY, TCP_MAXSEG) have the same values on both
+            return std::pair{IPPROTO_TCP, static_cast<int>(option)};
+        }
+        return std::nullopt;
+    }
+
+    static std::optional<sockaddr_in> ReadGuestAddress(span<u8> buffer) {
+        if (buffer.size() < sizeof(GuestSockAddrIn))
+            return std::nullopt;
+
+        const auto &guest{buffer.as<GuestSockAddrIn>()};
+        if (guest.family != AF_INET)
+            return std::nullopt;
+
+        return sockaddr_in{
+            .sin_family = AF_INET,
+            .sin_port = guest.port,
+            .sin_addr = {.s_addr = guest.address},
+        };
+    }
+
+    /**
+     * @return The size of the guest socket address, this may be larger than the buffer it was truncated into
+     */
+    static u32 WriteGuestAddress(span<u8> buffer, const sockaddr_in &address) {
+        GuestSockAddrIn guest{
+            .length = sizeof(GuestSockAddrIn),
+            .family = AF_INET,
+            .port = address.sin_port,
+            .address = address.sin_addr.s_addr,
+        };
+        std::memcpy(buffer.data(), &guest, std::min(buffer.size(), sizeof(guest)));
+        return sizeof(guest);
+    }
+
+    /**
+     * @brief Waits for the host socket to become ready for any of the supplied events
+     * @return If the socket became ready, errno is set to EAGAIN if the wait timed out
+     */
+    static bool WaitForSocket(int fd, short events, int timeout) {
+        pollfd pollFd{.fd = fd, .events = events};
+        int result;
+        do {
+            result = ::poll(&pollFd, 1, timeout);
+        } while (result < 0 && errno == EINTR);
+
+        if (result == 0) {
+            errno = EAGAIN;
+            return false;
+        }
+        return result > 0;
+    }
+
+    /**
+     * @brief Performs an operation on a non-blocking host socket, if the guest expects it to block then it's retried every time the socket becomes ready until it succeeds
+     * @return The result of the operation, errno is set if it failed
+     */
+    template<typename Operation>
+    static i64 PerformOperation(bool blocking, int fd, short events, int timeout, Operation &&operation) {
+        while (true) {
+            i64 result{operation()};
+            if (result >= 0 || !blocking || (errno != EAGAIN && errno != EWOULDBLOCK))
+                return result;
+
+            // Errors and hangups are reported as readiness, the operation is retried to retrieve them
+            if (!WaitForSocket(fd, events, timeout))
+                return -1;
+        }
+    }
+
+    /**
+     * @return The buffer at the supplied index or an empty span if the guest didn't supply it
+     */
+    static span<u8> GetBuffer(const std::vector<span<u8>> &buffers, size_t index) {
+        return index < buffers.size() ? buffers[index] : span<u8>{};
+    }
+
+    IClient::HostSocket::HostSocket(int fd) : fd{fd} {}
+
+    IClient::HostSocket::~HostSocket() {
+        ::close(fd);
+    }
+
     IClient::IClient(const DeviceState &state, ServiceManager &manager) : BaseService(state, manager) {}
 
+    std::shared_ptr<IClient::HostSocket> IClient::GetSocket(i32 fd) {
+        std::scoped_lock lock{mutex};
+        if (fd < 0 || static_cast<size_t>(fd) >= sockets.size())
+            return nullptr;
+        return sockets[static_cast<size_t>(fd)];
+    }
+
+    i32 IClient::AllocateFd(std::shared_ptr<HostSocket> socket) {
+        std::scoped_lock lock{mutex};
+        auto it{std::find(sockets.begin(), sockets.end(), nullptr)};
+        if (it != sockets.end()) {
+            *it = std::move(socket);
+            return static_cast<i32>(std::distance(sockets.begin(), it));
+        }
+
+        sockets.push_back(std::move(socket));
+        return static_cast<i32>(sockets.size() - 1);
+    }
+
+    Result IClient::CreateSocket(ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        auto domain{request.Pop<i32>()};
+        auto type{request.Pop<i32>()};
+        auto protocol{request.Pop<i32>()};
+
+        if (domain != AF_INET) {
+            Logger::Warn("Unsupported socket domain: {}", domain);
+            PushResult(response, -1, EAFNOSUPPORT);
+            return {};
+        }
+
+        bool nonBlocking{(type & GuestSockNonBlock) != 0};
+        type &= ~(GuestSockNonBlock | GuestSockCloExec);
+
+        int fd{::socket(AF_INET, type | SOCK_NONBLOCK | SOCK_CLOEXEC, protocol)};
+        if (fd < 0) {
+            PushResult(response, -1, errno);
+            return {};
+        }
+
+        auto socket{std::make_shared<HostSocket>(fd)};
+        socket->nonBlocking = nonBlocking;
+        PushResult(response, AllocateFd(std::move(socket)));
+        return {};
+    }
+
+    i64 IClient::ReceiveInto(HostSocket &socket, span<u8> buffer, i32 flags, sockaddr_in *address) {
+        bool blocking{!socket.nonBlocking && !(flags & GuestMsgDontWait)};
+        int hostFlags{ConvertMessageFlags(flags) | MSG_DONTWAIT};
+        socklen_t addressLength{sizeof(sockaddr_in)};
+        return PerformOperation(blocking, socket.fd, POLLIN, socket.recvTimeout, [&] {
+            return ::recvfrom(socket.fd, buffer.data(), buffer.size(), hostFlags, reinterpret_cast<sockaddr *>(address), address ? &addressLength : nullptr);
+        });
+    }
+
+    i64 IClient::SendFrom(HostSocket &socket, span<u8> buffer, i32 flags, const sockaddr_in *address) {
+        bool blocking{!socket.nonBlocking && !(flags & GuestMsgDontWait)};
+        int hostFlags{ConvertMessageFlags(flags) | MSG_DONTWAIT | MSG_NOSIGNAL}; // The guest expects EPIPE rather than a signal on writing to a closed connection
+        return PerformOperation(blocking, socket.fd, POLLOUT, socket.sendTimeout, [&] {
+            return ::sendto(socket.fd, buffer.data(), buffer.size(), hostFlags, reinterpret_cast<const sockaddr *>(address), address ? sizeof(sockaddr_in) : 0);
+        });
+    }
+
     Result IClient::RegisterClient(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
         response.Push<u32>(0);
         return {};
@@ -14,4 +277,530 @@ namespace skyline::service::socket {
     Result IClient::StartMonitoring(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
         return {};
     }
+
+    Result IClient::Socket(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        return CreateSocket(request, response);
+    }
+
+    Result IClient::SocketExempt(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        return CreateSocket(request, response);
+    }
+
+    Result IClient::Select(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        auto nfds{std::clamp(request.Pop<i32>(), 0, static_cast<i32>(FdSetSize))};
+        request.Skip<u32>();
+        auto timeout{request.Pop<GuestTimeval>()};
+        bool infinite{request.Pop<u8>() != 0};
+
+        // Null sets are omitted from the buffers entirely, so the sets which are present are assumed to be the leading ones in read, write, except order
+        constexpr size_t SetCount{3};
+        std::array<span<u8>, SetCount> inputSets{}, outputSets{};
+        for (size_t i{}; i < SetCount; i++) {
+            inputSets[i] = GetBuffer(request.inputBuf, i);
+            outputSets[i] = GetBuffer(request.outputBuf, i);
+        }
+
+        auto isSet{[](span<u8> set, i32 fd) {
+            return static_cast<size_t>(fd / 8) < set.size() && (set[static_cast<size_t>(fd / 8)] & (1 << (fd % 8)));
+        }};
+
+        constexpr std::array<short, SetCount> SetEvents{POLLIN, POLLOUT, POLLPRI};
+        std::vector<pollfd> pollFds;
+        std::vector<i32> guestFds;
+        std::vector<std::shared_ptr<HostSocket>> pollSockets; // The sockets are held for the duration of the poll so their descriptors can't be closed and reused
+        for (i32 fd{}; fd < nfds; fd++) {
+            short events{};
+            for (size_t i{}; i < SetCount; i++)
+                if (isSet(inputSets[i], fd))
+                    events |= SetEvents[i];
+            if (!events)
+                continue;
+
+            auto socket{GetSocket(fd)};
+            if (!socket) {
+                PushResult(response, -1, EBADF);
+                return {};
+            }
+
+            pollFds.push_back(pollfd{.fd = socket->fd, .events = events});
+            guestFds.push_back(fd);
+            pollSockets.push_back(std::move(socket));
+        }
+
+        int timeoutMs{infinite ? -1 : static_cast<int>(std::max<i64>(timeout.seconds * 1000 + timeout.microseconds / 1000, 0))};
+        int result{::poll(pollFds.data(), pollFds.size(), timeoutMs)};
+        if (result < 0) {
+            PushResult(response, -1, errno);
+            return {};
+        }
+
+        for (auto set : outputSets)
+            std::fill(set.begin(), set.end(), 0);
+
+        constexpr std::array<short, SetCount> SetReadyEvents{POLLIN | POLLHUP | POLLERR, POLLOUT | POLLERR, POLLPRI};
+        i32 ready{};
+        for (size_t index{}; index < pollFds.size(); index++) {
+            i32 fd{guestFds[index]};
+            for (size_t i{}; i < SetCount; i++) {
+                if ((pollFds[index].events & SetEvents[i]) && (pollFds[index].revents & SetReadyEvents[i]) && static_cast<size_t>(fd / 8) < outputSets[i].size()) {
+                    outputSets[i][static_cast<size_t>(fd / 8)] |= static_cast<u8>(1 << (fd % 8));
+                    ready++;
+                }
+            }
+        }
+
+        PushResult(response, ready);
+        return {};
+    }
+
+    Result IClient::Poll(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        auto nfds{request.Pop<i32>()};
+        auto timeout{request.Pop<i32>()};
+
+        // The guest pollfd layout and event values match those of the host, only the descriptors need to be translated
+        auto guestFds{GetBuffer(request.inputBuf, 0).cast<pollfd>()};
+        auto outputFds{GetBuffer(request.outputBuf, 0).cast<pollfd>()};
+        size_t count{std::min({static_cast<size_t>(std::max(nfds, 0)), guestFds.size(), outputFds.size()})};
+
+        std::vector<pollfd> pollFds(count);
+        std::vector<std::shared_ptr<HostSocket>> pollSockets(count);
+        for (size_t i{}; i < count; i++) {
+            pollFds[i] = pollfd{.fd = -1, .events = guestFds[i].events};
+            if (guestFds[i].fd < 0)
+                continue; // Negative descriptors are ignored by poll() and the same is done for them here
+
+            pollSockets[i] = GetSocket(guestFds[i].fd);
+            if (pollSockets[i])
+                pollFds[i].fd = pollSockets[i]->fd;
+        }
+
+        int result{::poll(pollFds.data(), pollFds.size(), timeout)};
+        if (result < 0) {
+            PushResult(response, -1, errno);
+            return {};
+        }
+
+        for (size_t i{}; i < count; i++) {
+            outputFds[i] = guestFds[i];
+            outputFds[i].revents = pollFds[i].revents;
+            if (guestFds[i].fd >= 0 && !pollSockets[i]) {
+                outputFds[i].revents = POLLNVAL;
+                result++;
+            }
+        }
+
+        PushResult(response, result);
+        return {};
+    }
+
+    Result IClient::Recv(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        auto fd{request.Pop<i32>()};
+        auto flags{request.Pop<i32>()};
+
+        auto socket{GetSocket(fd)};
+        if (!socket) {
+            PushResult(response, -1, EBADF);
+            return {};
+        }
+
+        auto result{ReceiveInto(*socket, GetBuffer(request.outputBuf, 0), flags, nullptr)};
+        PushResult(response, result, errno);
+        return {};
+    }
+
+    Result IClient::RecvFrom(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        auto fd{request.Pop<i32>()};
+        auto flags{request.Pop<i32>()};
+
+        auto socket{GetSocket(fd)};
+        if (!socket) {
+            PushResult(response, -1, EBADF);
+            response.Push<u32>(0);
+            return {};
+        }
+
+        sockaddr_in address{};
+        auto result{ReceiveInto(*socket, GetBuffer(request.outputBuf, 0), flags, &address)};
+        PushResult(response, result, errno);
+
+        auto addressBuffer{GetBuffer(request.outputBuf, 1)};
+        // Connected sockets don't supply the address of the sender, and the family is left unset in that case
+        response.Push<u32>(result >= 0 && address.sin_family == AF_INET && !addressBuffer.empty() ? WriteGuestAddress(addressBuffer, address) : 0);
+        return {};
+    }
+
+    Result IClient::Send(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        auto fd{request.Pop<i32>()};
+        auto flags{request.Pop<i32>()};
+
+        auto socket{GetSocket(fd)};
+        if (!socket) {
+            PushResult(response, -1, EBADF);
+            return {};
+        }
+
+        auto result{SendFrom(*socket, GetBuffer(request.inputBuf, 0), flags, nullptr)};
+        PushResult(response, result, errno);
+        return {};
+    }
+
+    Result IClient::SendTo(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        auto fd{request.Pop<i32>()};
+        auto flags{request.Pop<i32>()};
+
+        auto socket{GetSocket(fd)};
+        if (!socket) {
+            PushResult(response, -1, EBADF);
+            return {};
+        }
+
+        auto data{GetBuffer(request.inputBuf, 0)};
+        auto addressBuffer{GetBuffer(request.inputBuf, 1)};
+        if (data.empty() && !addressBuffer.empty() && addressBuffer.size() != sizeof(GuestSockAddrIn))
+            std::swap(data, addressBuffer); // An empty data buffer is omitted, in which case the address is the only buffer that's present
+
+        std::optional<sockaddr_in> address;
+        if (!addressBuffer.empty()) {
+            address = ReadGuestAddress(addressBuffer);
+            if (!address) {
+                PushResult(response, -1, EAFNOSUPPORT);
+                return {};
+            }
+        }
+
+        auto result{SendFrom(*socket, data, flags, address ? &*address : nullptr)};
+        PushResult(response, result, errno);
+        return {};
+    }
+
+    Result IClient::Accept(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        auto fd{request.Pop<i32>()};
+
+        auto socket{GetSocket(fd)};
+        if (!socket) {
+            PushResult(response, -1, EBADF);
+            response.Push<u32>(0);
+            return {};
+        }
+
+        sockaddr_in address{};
+        socklen_t addressLength{sizeof(address)};
+        auto result{PerformOperation(!socket->nonBlocking, socket->fd, POLLIN, -1, [&] {
+            return ::accept4(socket->fd, reinterpret_cast<sockaddr *>(&address), &addressLength, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        })};
+        if (result < 0) {
+            PushResult(response, -1, errno);
+            response.Push<u32>(0);
+            return {};
+        }
+
+        auto addressBuffer{GetBuffer(request.outputBuf, 0)};
+        u32 guestAddressLength{addressBuffer.empty() ? 0 : WriteGuestAddress(addressBuffer, address)};
+
+        // Accepted sockets don't inherit the non-blocking state of the listening socket, matching BSD semantics
+        PushResult(response, AllocateFd(std::make_shared<HostSocket>(static_cast<int>(result))));
+        response.Push<u32>(guestAddressLength);
+        return {};
+    }
+
+    Result IClient::Bind(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        auto fd{request.Pop<i32>()};
+
+        auto socket{GetSocket(fd)};
+        if (!socket) {
+            PushResult(response, -1, EBADF);
+            return {};
+        }
+
+        auto address{ReadGuestAddress(GetBuffer(request.inputBuf, 0))};
+        if (!address) {
+            PushResult(response, -1, EAFNOSUPPORT);
+            return {};
+        }
+
+        auto result{::bind(socket->fd, reinterpret_cast<const sockaddr *>(&*address), sizeof(sockaddr_in))};
+        PushResult(response, result, errno);
+        return {};
+    }
+
+    Result IClient::Connect(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        auto fd{request.Pop<i32>()};
+
+        auto socket{GetSocket(fd)};
+        if (!socket) {
+            PushResult(response, -1, EBADF);
+            return {};
+        }
+
+        auto address{ReadGuestAddress(GetBuffer(request.inputBuf, 0))};
+        if (!address) {
+            PushResult(response, -1, EAFNOSUPPORT);
+            return {};
+        }
+
+        auto result{::connect(socket->fd, reinterpret_cast<const sockaddr *>(&*address), sizeof(sockaddr_in))};
+        if (result < 0 && errno == EINPROGRESS && !socket->nonBlocking) {
+            // The host socket is always non-blocking so the connection is waited on in place of the guest
+            if (!WaitForSocket(socket->fd, POLLOUT, socket->sendTimeout)) {
+                PushResult(response, -1, errno == EAGAIN ? ETIMEDOUT : errno);
+                return {};
+            }
+
+            int error{};
+            socklen_t errorLength{sizeof(error)};
+            ::getsockopt(socket->fd, SOL_SOCKET, SO_ERROR, &error, &errorLength);
+            result = error ? -1 : 0;
+            errno = error;
+        }
+
+        PushResult(response, result, errno);
+        return {};
+    }
+
+    Result IClient::GetPeerName(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        auto fd{request.Pop<i32>()};
+
+        auto socket{GetSocket(fd)};
+        if (!socket) {
+            PushResult(response, -1, EBADF);
+            response.Push<u32>(0);
+            return {};
+        }
+
+        sockaddr_in address{};
+        socklen_t addressLength{sizeof(address)};
+        auto result{::getpeername(socket->fd, reinterpret_cast<sockaddr *>(&address), &addressLength)};
+        PushResult(response, result, errno);
+
+        auto addressBuffer{GetBuffer(request.outputBuf, 0)};
+        response.Push<u32>(result >= 0 && !addressBuffer.empty() ? WriteGuestAddress(addressBuffer, address) : 0);
+        return {};
+    }
+
+    Result IClient::GetSockName(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        auto fd{request.Pop<i32>()};
+
+        auto socket{GetSocket(fd)};
+        if (!socket) {
+            PushResult(response, -1, EBADF);
+            response.Push<u32>(0);
+            return {};
+        }
+
+        sockaddr_in address{};
+        socklen_t addressLength{sizeof(address)};
+        auto result{::getsockname(socket->fd, reinterpret_cast<sockaddr *>(&address), &addressLength)};
+        PushResult(response, result, errno);
+
+        auto addressBuffer{GetBuffer(request.outputBuf, 0)};
+        response.Push<u32>(result >= 0 && !addressBuffer.empty() ? WriteGuestAddress(addressBuffer, address) : 0);
+        return {};
+    }
+
+    Result IClient::GetSockOpt(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        auto fd{request.Pop<i32>()};
+        auto level{request.Pop<i32>()};
+        auto optionName{request.Pop<i32>()};
+
+        auto socket{GetSocket(fd)};
+        if (!socket) {
+            PushResult(response, -1, EBADF);
+            response.Push<u32>(0);
+            return {};
+        }
+
+        auto value{GetBuffer(request.outputBuf, 0)};
+        if (level == GuestSolSocket && (optionName == GuestSoSndTimeo || optionName == GuestSoRcvTimeo)) {
+            int timeout{optionName == GuestSoSndTimeo ? socket->sendTimeout : socket->recvTimeout};
+            GuestTimeval guestTimeout{};
+            if (timeout > 0)
+                guestTimeout = {.seconds = timeout / 1000, .microseconds = (timeout % 1000) * 1000};
+
+            std::memcpy(value.data(), &guestTimeout, std::min(value.size(), sizeof(guestTimeout)));
+            PushResult(response, 0);
+            response.Push<u32>(sizeof(guestTimeout));
+            return {};
+        }
+
+        auto option{ConvertSocketOption(level, optionName)};
+        if (!option) {
+            Logger::Warn("Unsupported socket option: level 0x{:X}, option 0x{:X}", level, optionName);
+            PushResult(response, -1, ENOPROTOOPT);
+            response.Push<u32>(0);
+            return {};
+        }
+
+        socklen_t valueLength{static_cast<socklen_t>(value.size())};
+        auto result{::getsockopt(socket->fd, option->first, option->second, value.data(), &valueLength)};
+        PushResult(response, result, errno);
+        response.Push<u32>(result >= 0 ? valueLength : 0);
+        return {};
+    }
+
+    Result IClient::Listen(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        auto fd{request.Pop<i32>()};
+        auto backlog{request.Pop<i32>()};
+
+        auto socket{GetSocket(fd)};
+        if (!socket) {
+            PushResult(response, -1, EBADF);
+            return {};
+        }
+
+        auto result{::listen(socket->fd, backlog)};
+        PushResult(response, result, errno);
+        return {};
+    }
+
+    Result IClient::Fcntl(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        auto fd{request.Pop<i32>()};
+        auto command{request.Pop<i32>()};
+        auto argument{request.Pop<i32>()};
+
+        auto socket{GetSocket(fd)};
+        if (!socket) {
+            PushResult(response, -1, EBADF);
+            return {};
+        }
+
+        constexpr i32 GuestGetFlags{3}, GuestSetFlags{4};
+        switch (command) {
+            case GuestGetFlags:
+                PushResult(response, socket->nonBlocking ? GuestFlagNonBlock : 0);
+                break;
+
+            case GuestSetFlags:
+                socket->nonBlocking = (argument & GuestFlagNonBlock) != 0;
+                PushResult(response, 0);
+                break;
+
+            default:
+                Logger::Warn("Unsupported fcntl command: {}", command);
+                PushResult(response, -1, EINVAL);
+                break;
+        }
+        return {};
+    }
+
+    Result IClient::SetSockOpt(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        auto fd{request.Pop<i32>()};
+        auto level{request.Pop<i32>()};
+        auto optionName{request.Pop<i32>()};
+
+        auto socket{GetSocket(fd)};
+        if (!socket) {
+            PushResult(response, -1, EBADF);
+            return {};
+        }
+
+        auto value{GetBuffer(request.inputBuf, 0)};
+        if (level == GuestSolSocket && (optionName == GuestSoSndTimeo || optionName == GuestSoRcvTimeo)) {
+            if (value.size() < sizeof(GuestTimeval)) {
+                PushResult(response, -1, EINVAL);
+                return {};
+            }
+
+            // Timeouts are applied when waiting on the host socket, as it's non-blocking a host timeout would have no effect
+            const auto &guestTimeout{value.as<GuestTimeval>()};
+            i64 timeout{guestTimeout.seconds * 1000 + guestTimeout.microseconds / 1000};
+            (optionName == GuestSoSndTimeo ? socket->sendTimeout : socket->recvTimeout) = timeout > 0 ? static_cast<int>(std::min<i64>(timeout, std::numeric_limits<int>::max())) : -1;
+            PushResult(response, 0);
+            return {};
+        }
+
+        auto option{ConvertSocketOption(level, optionName)};
+        if (!option) {
+            Logger::Warn("Unsupported socket option: level 0x{:X}, option 0x{:X}", level, optionName);
+            PushResult(response, -1, ENOPROTOOPT);
+            return {};
+        }
+
+        auto result{::setsockopt(socket->fd, option->first, option->second, value.data(), static_cast<socklen_t>(value.size()))};
+        PushResult(response, result, errno);
+        return {};
+    }
+
+    Result IClient::Shutdown(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        auto fd{request.Pop<i32>()};
+        auto how{request.Pop<i32>()};
+
+        auto socket{GetSocket(fd)};
+        if (!socket) {
+            PushResult(response, -1, EBADF);
+            return {};
+        }
+
+        auto result{::shutdown(socket->fd, how)};
+        PushResult(response, result, errno);
+        return {};
+    }
+
+    Result IClient::ShutdownAllSockets(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        auto how{request.Pop<i32>()};
+
+        std::scoped_lock lock{mutex};
+        for (const auto &socket : sockets)
+            if (socket)
+                ::shutdown(socket->fd, how);
+
+        PushResult(response, 0);
+        return {};
+    }
+
+    Result IClient::Write(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        auto fd{request.Pop<i32>()};
+
+        auto socket{GetSocket(fd)};
+        if (!socket) {
+            PushResult(response, -1, EBADF);
+            return {};
+        }
+
+        auto result{SendFrom(*socket, GetBuffer(request.inputBuf, 0), 0, nullptr)};
+        PushResult(response, result, errno);
+        return {};
+    }
+
+    Result IClient::Read(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        auto fd{request.Pop<i32>()};
+
+        auto socket{GetSocket(fd)};
+        if (!socket) {
+            PushResult(response, -1, EBADF);
+            return {};
+        }
+
+        auto result{ReceiveInto(*socket, GetBuffer(request.outputBuf, 0), 0, nullptr)};
+        PushResult(response, result, errno);
+        return {};
+    }
+
+    Result IClient::Close(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        auto fd{request.Pop<i32>()};
+
+        std::scoped_lock lock{mutex};
+        if (fd < 0 || static_cast<size_t>(fd) >= sockets.size() || !sockets[static_cast<size_t>(fd)]) {
+            PushResult(response, -1, EBADF);
+            return {};
+        }
+
+        // The host socket is closed once the last descriptor referring to it is closed and no operations on it are in flight
+        sockets[static_cast<size_t>(fd)] = nullptr;
+        PushResult(response, 0);
+        return {};
+    }
+
+    Result IClient::DuplicateSocket(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response) {
+        auto fd{request.Pop<i32>()};
+
+        auto socket{GetSocket(fd)};
+        if (!socket) {
+            PushResult(response, -1, EBADF);
+            return {};
+        }
+
+        // Duplicated descriptors share the same socket and file status flags, the same as dup()
+        PushResult(response, AllocateFd(std::move(socket)));
+        return {};
+    }
 }
@@ -3,14 +3,60 @@
 
 #pragma once
 
+#include <netinet/in.h>
 #include <services/serviceman.h>
 
 namespace skyline::service::socket {
     /**
      * @brief IClient or bsd:u is used by applications create network sockets
+     * @note Guest sockets are backed by non-blocking host sockets, operations on guest sockets in blocking mode wait for readiness with poll() on the calling thread. The thread is descheduled for the duration of the IPC so this never holds up a guest core
+     * @note Only IPv4 sockets are supported, the guest uses the BSD layout of socket addresses and BSD values for socket options and flags while errno values match those of the host
      * @url https://switchbrew.org/wiki/Sockets_services#bsd:u.2C_bsd:s
      */
     class IClient : public BaseService {
+      private:
+        /**
+         * @brief A host socket backing a guest file descriptor
+         */
+        struct HostSocket {
+            int fd; //!< The host file descriptor, this is always in non-blocking mode
+            bool nonBlocking{}; //!< If the guest has put the socket into non-blocking mode
+            int recvTimeout{-1}; //!< The receive timeout set by the guest in milliseconds, -1 waits indefinitely
+            int sendTimeout{-1}; //!< The send timeout set by the guest in milliseconds, -1 waits indefinitely
+
+            HostSocket(int fd);
+
+            ~HostSocket();
+        };
+
+        std::mutex mutex; //!< Synchronizes access to the descriptor table, this is never held while waiting on a socket
+        std::vector<std::shared_ptr<HostSocket>> sockets; //!< The sockets of all guest file descriptors indexed by the descriptor, closed descriptors are null
+
+        /**
+         * @return The socket for the supplied guest file descriptor or nullptr if it isn't open
+         */
+        std::shared_ptr<HostSocket> GetSocket(i32 fd);
+
+        /**
+         * @return The lowest free guest file descriptor which now refers to the supplied socket
+         */
+        i32 AllocateFd(std::shared_ptr<HostSocket> socket);
+
+        /**
+         * @brief Creates a socket for the guest, this is shared by Socket and SocketExempt
+         */
+        Result CreateSocket(ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @brief Receives data into the supplied buffer, this is shared by Recv, RecvFrom and Read
+         */
+        i64 ReceiveInto(HostSocket &socket, span<u8> buffer, i32 flags, sockaddr_in *address);
+
+        /**
+         * @brief Sends data from the supplied buffer, this is shared by Send, SendTo and Write
+         */
+        i64 SendFrom(HostSocket &socket, span<u8> buffer, i32 flags, const sockaddr_in *address);
+
       public:
         IClient(const DeviceState &state, ServiceManager &manager);
 
@@ -25,9 +71,152 @@ namespace skyline::service::socket {
          */
         Result StartMonitoring(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
 
+        /**
+         * @url https://switchbrew.org/wiki/Sockets_services#Socket
+         */
+        Result Socket(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @brief Identical to Socket, the exemption from the system-wide socket limit has no host equivalent
+         * @url https://switchbrew.org/wiki/Sockets_services#SocketExempt
+         */
+        Result SocketExempt(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @brief Waits for readiness on sets of sockets, this is implemented with poll() as the host descriptors don't match those of the guest
+         * @url https://switchbrew.org/wiki/Sockets_services#Select
+         */
+        Result Select(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/Sockets_services#Poll
+         */
+        Result Poll(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @brief Receives data directly into the output buffer
+         * @url https://switchbrew.org/wiki/Sockets_services#Recv
+         */
+        Result Recv(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/Sockets_services#RecvFrom
+         */
+        Result RecvFrom(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/Sockets_services#Send
+         */
+        Result Send(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/Sockets_services#SendTo
+         */
+        Result SendTo(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/Sockets_services#Accept
+         */
+        Result Accept(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/Sockets_services#Bind
+         */
+        Result Bind(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @brief Connects the socket, connecting blocking sockets waits for the connection to be established
+         * @url https://switchbrew.org/wiki/Sockets_services#Connect
+         */
+        Result Connect(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/Sockets_services#GetPeerName
+         */
+        Result GetPeerName(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/Sockets_services#GetSockName
+         */
+        Result GetSockName(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/Sockets_services#GetSockOpt
+         */
+        Result GetSockOpt(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/Sockets_services#Listen
+         */
+        Result Listen(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @brief Only supports querying and setting O_NONBLOCK as no other file status flags apply to sockets
+         * @url https://switchbrew.org/wiki/Sockets_services#Fcntl
+         */
+        Result Fcntl(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/Sockets_services#SetSockOpt
+         */
+        Result SetSockOpt(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/Sockets_services#Shutdown
+         */
+        Result Shutdown(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/Sockets_services#ShutdownAllSockets
+         */
+        Result ShutdownAllSockets(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/Sockets_services#Write
+         */
+        Result Write(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/Sockets_services#Read
+         */
+        Result Read(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/Sockets_services#Close
+         */
+        Result Close(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
+        /**
+         * @url https://switchbrew.org/wiki/Sockets_services#DuplicateSocket
+         */
+        Result DuplicateSocket(type::KSession &session, ipc::IpcRequest &request, ipc::IpcResponse &response);
+
         SERVICE_DECL(
             SFUNC(0x0, IClient, RegisterClient),
-            SFUNC(0x1, IClient, StartMonitoring)
+            SFUNC(0x1, IClient, StartMonitoring),
+            SFUNC(0x2, IClient, Socket),
+            SFUNC(0x3, IClient, SocketExempt),
+            SFUNC(0x5, IClient, Select),
+            SFUNC(0x6, IClient, Poll),
+            SFUNC(0x8, IClient, Recv),
+            SFUNC(0x9, IClient, RecvFrom),
+            SFUNC(0xA, IClient, Send),
+            SFUNC(0xB, IClient, SendTo),
+            SFUNC(0xC, IClient, Accept),
+            SFUNC(0xD, IClient, Bind),
+            SFUNC(0xE, IClient, Connect),
+            SFUNC(0xF, IClient, GetPeerName),
+            SFUNC(0x10, IClient, GetSockName),
+            SFUNC(0x11, IClient, GetSockOpt),
+            SFUNC(0x12, IClient, Listen),
+            SFUNC(0x14, IClient, Fcntl),
+            SFUNC(0x15, IClient, SetSockOpt),
+            SFUNC(0x16, IClient, Shutdown),
+            SFUNC(0x17, IClient, ShutdownAllSockets),
+            SFUNC(0x18, IClient, Write),
+            SFUNC(0x19, IClient, Read),
+            SFUNC(0x1A, IClient, Close),
+            SFUNC(0x1B, IClient, DuplicateSocket)
         )
     };
 }
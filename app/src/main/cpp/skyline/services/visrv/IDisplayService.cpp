@@ -17,8 +17,10 @@ namespace skyline::service::visrv {
 
         Logger::Debug("Creating Stray Layer #{} on Display: {}", layerId, hosbinder::ToString(displayId));
 
-        auto parcel{hosbinder->OpenLayer(displayId, layerId)};
-        response.Push<u64>(parcel.WriteParcel(request.outputBuf.at(0)));
+        auto outputBuffer{request.outputBuf.at(0)};
+        hosbinder::Parcel parcel(state, outputBuffer);
+        hosbinder->OpenLayer(displayId, layerId, parcel);
+        response.Push<u64>(parcel.WriteParcel(outputBuffer));
 
         return {};
     }
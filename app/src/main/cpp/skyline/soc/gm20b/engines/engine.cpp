@@ -18,12 +18,12 @@ namespace skyline::soc::gm20b::engine {
 
     MacroEngineBase::MacroEngineBase(MacroState &macroState) : macroState(macroState) {}
 
-    void MacroEngineBase::HandleMacroCall(u32 macroMethodOffset, u32 argument, bool lastCall) {
+    void MacroEngineBase::HandleMacroCall(u32 macroMethodOffset, u32 argument, u32 *argumentPtr, bool lastCall) {
         // Starting a new macro at index 'macroMethodOffset / 2'
         if (!(macroMethodOffset & 1)) {
             // Flush the current macro as we are switching to another one
             if (macroInvocation.Valid()) {
-                macroState.Execute(macroInvocation.index, macroInvocation.arguments, this);
+                macroState.Execute(macroInvocation.index, macroInvocation.arguments, macroInvocation.argumentPtrs, this);
                 macroInvocation.Reset();
             }
 
@@ -32,10 +32,11 @@ namespace skyline::soc::gm20b::engine {
         }
 
         macroInvocation.arguments.emplace_back(argument);
+        macroInvocation.argumentPtrs.emplace_back(argumentPtr);
 
         // Flush macro after all of the data in the method call has been sent
         if (lastCall && macroInvocation.Valid()) {
-            macroState.Execute(macroInvocation.index, macroInvocation.arguments, this);
+            macroState.Execute(macroInvocation.index, macroInvocation.arguments, macroInvocation.argumentPtrs, this);
             macroInvocation.Reset();
         }
     };
@@ -63,6 +63,7 @@ namespace skyline::soc::gm20b::engine {
         struct {
             u32 index{std::numeric_limits<u32>::max()};
             std::vector<u32> arguments;
+            std::vector<u32 *> argumentPtrs; //!< Pointers to each argument in guest memory, these are nullptr for any arguments that weren't read directly from it
 
             bool Valid() {
                 return index != std::numeric_limits<u32>::max();
@@ -71,6 +72,7 @@ namespace skyline::soc::gm20b::engine {
             void Reset() {
                 index = std::numeric_limits<u32>::max();
                 arguments.clear();
+                argumentPtrs.clear();
             }
         } macroInvocation{}; //!< Data for a macro that is pending execution
 
@@ -96,10 +98,27 @@ namespace skyline::soc::gm20b::engine {
             throw exception("DrawIndexedInstanced is not implemented for this engine");
         }
 
+        /**
+         * @brief Performs draws with parameters laid out as VkDrawIndirectCommand in the supplied guest mapping
+         * @return If the draws were performed, this is only done when the parameters were written by the GPU as they're current in guest memory otherwise and the caller should draw with them directly
+         */
+        virtual bool DrawIndirect(u32 drawTopology, span<u8> indirectBuffer, u32 count, u32 stride) {
+            throw exception("DrawIndirect is not implemented for this engine");
+        }
+
+        /**
+         * @brief Performs draws with parameters laid out as VkDrawIndexedIndirectCommand in the supplied guest mapping
+         * @return If the draws were performed, see DrawIndirect
+         */
+        virtual bool DrawIndexedIndirect(u32 drawTopology, span<u8> indirectBuffer, u32 count, u32 stride) {
+            throw exception("DrawIndexedIndirect is not implemented for this engine");
+        }
+
         /**
          * @brief Handles a call to a method in the MME space
          * @param macroMethodOffset The target offset from EngineMethodsEnd
+         * @param argumentPtr A pointer to the argument in guest memory, this is nullptr if it wasn't read directly from it
          */
-        void HandleMacroCall(u32 macroMethodOffset, u32 value, bool lastCall);
+        void HandleMacroCall(u32 macroMethodOffset, u32 value, u32 *argumentPtr, bool lastCall);
     };
 }
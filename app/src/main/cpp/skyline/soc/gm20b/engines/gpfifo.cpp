@@ -19,8 +19,10 @@ namespace skyline::soc::gm20b::engine {
             ENGINE_STRUCT_CASE(syncpoint, action, {
                 if (action.operation == Registers::Syncpoint::Operation::Incr) {
                     Logger::Debug("Increment syncpoint: {}", +action.index);
-                    channelCtx.executor.Submit();
-                    syncpoints.at(action.index).Increment();
+                    // The increment is deferred till the host GPU has finished all prior work rather than blocking the channel on it
+                    channelCtx.executor.Submit([&syncpoint = syncpoints.at(action.index)] {
+                        syncpoint.Increment();
+                    });
                 } else if (action.operation == Registers::Syncpoint::Operation::Wait) {
                     Logger::Debug("Wait syncpoint: {}, thresh: {}", +action.index, registers.syncpoint->payload);
 
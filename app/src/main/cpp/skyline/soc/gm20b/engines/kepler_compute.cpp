@@ -3,12 +3,23 @@
 
 #include <soc.h>
 #include <soc/gm20b/channel.h>
-#include "kepler_compute/qmd.h"
 #include "kepler_compute.h"
 
 namespace skyline::soc::gm20b::engine {
+    static gpu::interconnect::kepler_compute::KeplerCompute::EngineRegisterBundle MakeEngineRegisters(const KeplerCompute::Registers &registers) {
+        return {
+            .samplerPoolRegisters = {*registers.texSamplerPool, *registers.texHeaderPool},
+            .texturePoolRegisters = {*registers.texHeaderPool},
+            .programRegion = *registers.programRegion,
+            .bindlessTexture = *registers.bindlessTexture,
+        };
+    }
+
     KeplerCompute::KeplerCompute(const DeviceState &state, ChannelContext &channelCtx)
-        : syncpoints{state.soc->host1x.syncpoints}, i2m{state, channelCtx} {}
+        : syncpoints{state.soc->host1x.syncpoints},
+          i2m{state, channelCtx},
+          dirtyManager{registers},
+          interconnect{state, *state.gpu, channelCtx, *state.nce, state.process->memory, dirtyManager, MakeEngineRegisters(registers)} {}
 
     __attribute__((always_inline)) void KeplerCompute::CallMethod(u32 method, u32 argument) {
         Logger::Verbose("Called method in Kepler compute: 0x{:X} args: 0x{:X}", method, argument);
@@ -17,7 +28,10 @@ namespace skyline::soc::gm20b::engine {
     }
 
     void KeplerCompute::HandleMethod(u32 method, u32 argument) {
-        registers.raw[method] = argument;
+        if (registers.raw[method] != argument) {
+            registers.raw[method] = argument;
+            dirtyManager.MarkDirty(method);
+        }
 
         switch (method) {
             ENGINE_STRUCT_CASE(i2m, launchDma, {
@@ -27,7 +41,8 @@ namespace skyline::soc::gm20b::engine {
                 i2m.LoadInlineData(*registers.i2m, argument);
             })
             ENGINE_CASE(sendSignalingPcasB, {
-                Logger::Warn("Attempted to execute compute kernel!");
+                if (registers.sendSignalingPcasB->schedule)
+                    interconnect.Dispatch(static_cast<u64>(registers.sendPcas->qmdAddressShifted8) << 8);
             })
             ENGINE_STRUCT_CASE(reportSemaphore, action, {
                 throw exception("Compute semaphores are unimplemented!");
@@ -4,8 +4,10 @@
 
 #pragma once
 
+#include <gpu/interconnect/kepler_compute/kepler_compute.h>
 #include "engine.h"
 #include "inline2memory.h"
+#include "maxwell/types.h"
 
 namespace skyline::soc::gm20b {
     struct ChannelContext;
@@ -19,6 +21,8 @@ namespace skyline::soc::gm20b::engine {
       private:
         host1x::SyncpointSet &syncpoints;
         Inline2MemoryBackend i2m;
+        gpu::interconnect::kepler_compute::DirtyManager dirtyManager;
+        gpu::interconnect::kepler_compute::KeplerCompute interconnect;
 
         void HandleMethod(u32 method, u32 argument);
 
@@ -95,10 +99,8 @@ namespace skyline::soc::gm20b::engine {
 
             Register<0x54A, u32> shaderExceptions;
 
-            Register<0x557, Address> texSamplerPool;
-            Register<0x559, u32> texSamplerPoolMaximumIndex;
-            Register<0x55D, Address> texHeaderPool;
-            Register<0x55F, u32> texHeaderPoolMaximumIndex;
+            Register<0x557, maxwell3d::type::TexSamplerPool> texSamplerPool;
+            Register<0x55D, maxwell3d::type::TexHeaderPool> texHeaderPool;
 
             Register<0x582, Address> programRegion;
 
@@ -150,13 +152,7 @@ namespace skyline::soc::gm20b::engine {
 
             Register<0x6C0, ReportSemaphore> reportSemaphore;
 
-            struct BindlessTexture {
-                u8 constantBufferSlotSelect : 3;
-                u32 _pad_ : 29;
-            };
-            static_assert(sizeof(BindlessTexture) == 0x4);
-
-            Register<0x982, BindlessTexture> bindlessTexture;
+            Register<0x982, maxwell3d::type::BindlessTexture> bindlessTexture; //!< The index of the constant buffer containing bindless texture descriptors
         } registers{};
         static_assert(sizeof(Registers) == (EngineMethodsEnd * 0x4));
         #pragma pack(pop)
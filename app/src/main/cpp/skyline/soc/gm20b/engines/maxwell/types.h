@@ -761,6 +761,37 @@ namespace skyline::soc::gm20b::engine::maxwell3d::type {
     };
     static_assert(sizeof(ClearSurface) == sizeof(u32));
 
+    /**
+     * @brief The counters that can be reset to zero by the guest, these are reported through semaphores with the corresponding counter type
+     */
+    enum class CounterReset : u32 {
+        SamplesPassed = 0x01,
+        ZcullStats = 0x02,
+        TransformFeedbackPrimitivesNeededMinusSucceeded = 0x03,
+        AlphaBetaClocks = 0x04,
+        TransformFeedbackPrimitivesSucceeded = 0x10,
+        TransformFeedbackPrimitivesNeeded = 0x11,
+        VtgPrimitivesOut = 0x12,
+    };
+
+    /**
+     * @brief Controls if draws and clears are performed, this can be conditional on the values of reports written by semaphores
+     */
+    struct RenderEnable {
+        enum class Mode : u8 {
+            False = 0,
+            True = 1,
+            Conditional = 2, //!< Render if the report at the address is non-zero
+            RenderIfEqual = 3, //!< Render if the reports at the address and 0x10 bytes after it are equal
+            RenderIfNotEqual = 4, //!< Render if the reports at the address and 0x10 bytes after it differ
+        };
+
+        Address address;
+        Mode mode : 3;
+        u32 _pad_ : 29;
+    };
+    static_assert(sizeof(RenderEnable) == sizeof(u32) * 3);
+
     struct SemaphoreInfo {
         enum class Op : u8 {
             Release = 0,
@@ -50,8 +50,10 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
             .activeStateRegisters = MakeActiveStateRegisters(registers),
             .clearRegisters = {registers.scissors[0], registers.viewportClips[0], *registers.clearRect, *registers.colorClearValue, *registers.zClearValue, *registers.stencilClearValue, *registers.surfaceClip, *registers.clearSurfaceControl},
             .constantBufferSelectorRegisters = {*registers.constantBufferSelector},
-            .samplerPoolRegisters = {*registers.samplerBinding, *registers.texSamplerPool, *registers.texHeaderPool},
-            .texturePoolRegisters = {*registers.texHeaderPool}
+            .samplerPoolRegisters = {*registers.texSamplerPool, *registers.texHeaderPool},
+            .samplerBinding = *registers.samplerBinding,
+            .texturePoolRegisters = {*registers.texHeaderPool},
+            .queryRegisters = {*registers.sampleCounterEnable, *registers.renderEnable}
         };
     }
     #undef REGTYPE
@@ -61,14 +63,68 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
                 registers.begin->op : type::ConvertPrimitiveTopologyToDrawTopology(*registers.primitiveTopology);
     }
 
+    std::bitset<EngineMethodsEnd> Maxwell3D::MakeIdempotentMethods() {
+        std::bitset<EngineMethodsEnd> methods;
+        methods.set();
+
+        // Any method that has a case in HandleMethod acts on the write itself rather than just the value, so it must always be handled
+        constexpr std::array<u32, 14> TriggerMethods{
+            ENGINE_STRUCT_OFFSET(mme, shadowRamControl),
+            ENGINE_STRUCT_OFFSET(mme, instructionRamLoad),
+            ENGINE_STRUCT_OFFSET(mme, startAddressRamLoad),
+            ENGINE_STRUCT_OFFSET(i2m, launchDma),
+            ENGINE_STRUCT_OFFSET(i2m, loadInlineData),
+            ENGINE_OFFSET(syncpointAction),
+            ENGINE_OFFSET(clearSurface),
+            ENGINE_OFFSET(counterReset),
+            ENGINE_OFFSET(begin),
+            ENGINE_OFFSET(end),
+            ENGINE_STRUCT_OFFSET(drawVertexArray, count),
+            ENGINE_STRUCT_OFFSET(drawIndexBuffer, count),
+            ENGINE_STRUCT_OFFSET(semaphore, info),
+            ENGINE_ARRAY_OFFSET(firmwareCall, 4),
+        };
+        for (u32 method : TriggerMethods)
+            methods.reset(method);
+
+        for (u32 index{}; index < 16; index++)
+            methods.reset(ENGINE_STRUCT_ARRAY_OFFSET(loadConstantBuffer, data, index));
+
+        for (u32 stage{}; stage < type::ShaderStageCount; stage++)
+            methods.reset(ENGINE_ARRAY_STRUCT_OFFSET(bindGroups, stage, constantBuffer));
+
+        return methods;
+    }
+
+    const std::bitset<EngineMethodsEnd> Maxwell3D::IdempotentMethods{Maxwell3D::MakeIdempotentMethods()};
+
+    void Maxwell3D::ReportRedundantWrites() {
+        std::vector<u32> methods;
+        for (u32 method{}; method < EngineMethodsEnd; method++)
+            if (methodRedundantWriteCounts[method])
+                methods.push_back(method);
+
+        constexpr size_t ReportedMethodCount{5}; //!< The amount of methods with the most skipped writes that are reported
+        size_t reportedCount{std::min(methods.size(), ReportedMethodCount)};
+        std::partial_sort(methods.begin(), methods.begin() + static_cast<ssize_t>(reportedCount), methods.end(), [this](u32 a, u32 b) {
+            return methodRedundantWriteCounts[a] > methodRedundantWriteCounts[b];
+        });
+
+        for (u32 method : span(methods).first(reportedCount))
+            Logger::Debug("Skipped {} out of {} writes to method 0x{:X} ({:.1f}%)", methodRedundantWriteCounts[method], methodWriteCounts[method], method, (methodRedundantWriteCounts[method] * 100.0) / methodWriteCounts[method]);
+    }
+
     Maxwell3D::Maxwell3D(const DeviceState &state, ChannelContext &channelCtx, MacroState &macroState)
         : MacroEngineBase{macroState},
           syncpoints{state.soc->host1x.syncpoints},
           i2m{state, channelCtx},
           dirtyManager{registers},
-          interconnect{*state.gpu, channelCtx, *state.nce, state.process->memory, dirtyManager, MakeEngineRegisters(registers)},
+          interconnect{state, *state.gpu, channelCtx, *state.nce, state.process->memory, dirtyManager, MakeEngineRegisters(registers)},
           channelCtx{channelCtx} {
-        channelCtx.executor.AddFlushCallback([this]() { FlushEngineState(); });
+        channelCtx.executor.AddFlushCallback([this]() {
+            FlushEngineState();
+            interconnect.ResolveQueries(); // Queries must be resolved after any deferred draws have been flushed
+        });
         InitializeRegisters();
     }
 
@@ -93,6 +149,18 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
 
 
         bool redundant{registers.raw[method] == argument};
+        if (IdempotentMethods[method]) {
+            methodWriteCounts[method]++;
+
+            // Rewriting a register with the value it already holds has no effect, skipping it entirely avoids needlessly flushing any active batches
+            if (redundant) {
+                methodRedundantWriteCounts[method]++;
+                if (++redundantWriteCount % RedundantWriteReportInterval == 0)
+                    ReportRedundantWrites();
+                return;
+            }
+        }
+
         registers.raw[method] = argument;
 
         if (batchEnableState.raw) {
@@ -192,14 +260,19 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
 
             ENGINE_CASE(syncpointAction, {
                 Logger::Debug("Increment syncpoint: {}", static_cast<u16>(syncpointAction.id));
-                channelCtx.executor.Submit();
-                syncpoints.at(syncpointAction.id).Increment();
+                channelCtx.executor.Submit([&syncpoint = syncpoints.at(syncpointAction.id)] {
+                    syncpoint.Increment();
+                });
             })
 
             ENGINE_CASE(clearSurface, {
                 interconnect.Clear(clearSurface);
             })
 
+            ENGINE_CASE(counterReset, {
+                interconnect.ResetCounter(counterReset);
+            })
+
             ENGINE_CASE(begin, {
                 // If we reach here then we aren't in a deferred draw so theres no need to flush anything
                 if (begin.instanceId == Registers::Begin::InstanceId::Subsequent)
@@ -236,6 +309,11 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
                                 WriteSemaphoreResult(registers.semaphore->payload);
                                 break;
 
+                            case type::SemaphoreInfo::CounterType::SamplesPassed:
+                                // The result is written back once the GPU has completed the draws that contribute to it, rather than waiting on it here
+                                interconnect.ReportSampleCounter(registers.semaphore->address, info.structureSize == type::SemaphoreInfo::StructureSize::FourWords);
+                                break;
+
                             default:
                                 //Logger::Warn("Unsupported semaphore counter type: 0x{:X}", static_cast<u8>(info.counterType));
                                 break;
@@ -309,6 +387,7 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
         }
 
         interconnect.DisableQuickConstantBufferBind();
+        interconnect.FlushConstantBufferLoads();
     }
 
     __attribute__((always_inline)) void Maxwell3D::CallMethod(u32 method, u32 argument) {
@@ -362,4 +441,35 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
 
         interconnect.Draw(topology, *registers.streamOutputEnable, true, indexBufferCount, indexBufferFirst, instanceCount, globalBaseVertexIndex, globalBaseInstanceIndex);
     }
+
+    bool Maxwell3D::DrawIndirect(u32 drawTopology, span<u8> indirectBuffer, u32 count, u32 stride) {
+        // Parameters which weren't written by the GPU are cheaper to draw with on the CPU as that avoids creating a buffer over them
+        if (!interconnect.IsGpuDirty(indirectBuffer))
+            return false;
+
+        FlushDeferredDraw();
+
+        auto topology{static_cast<type::DrawTopology>(drawTopology)};
+        registers.begin->op = topology;
+
+        interconnect.DrawIndirect(topology, *registers.streamOutputEnable, false, indirectBuffer, count, stride, 0);
+        return true;
+    }
+
+    bool Maxwell3D::DrawIndexedIndirect(u32 drawTopology, span<u8> indirectBuffer, u32 count, u32 stride) {
+        if (!interconnect.IsGpuDirty(indirectBuffer))
+            return false;
+
+        FlushDeferredDraw();
+
+        auto topology{static_cast<type::DrawTopology>(drawTopology)};
+        registers.begin->op = topology;
+
+        // The index count isn't known on the CPU, so the entire index buffer up to its limit is used
+        u64 indexBufferStart{registers.indexBuffer->address}, indexBufferLimit{registers.indexBuffer->limit};
+        u32 elementCount{indexBufferLimit >= indexBufferStart ? static_cast<u32>((indexBufferLimit - indexBufferStart + 1) >> static_cast<u32>(registers.indexBuffer->indexSize)) : 0};
+
+        interconnect.DrawIndirect(topology, *registers.streamOutputEnable, true, indirectBuffer, count, stride, elementCount);
+        return true;
+    }
 }
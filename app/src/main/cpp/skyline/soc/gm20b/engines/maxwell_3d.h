@@ -72,6 +72,23 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
 
         type::DrawTopology GetCurrentTopology();
 
+        static const std::bitset<EngineMethodsEnd> IdempotentMethods; //!< Methods which only latch their argument into a register and have no side-effects, redundant writes to these are skipped entirely
+
+        static constexpr u64 RedundantWriteReportInterval{1 << 20}; //!< The amount of skipped redundant writes between each report of the most frequently skipped methods
+        u64 redundantWriteCount{}; //!< The total amount of skipped redundant writes
+        std::array<u64, EngineMethodsEnd> methodWriteCounts{}; //!< The amount of writes to each idempotent method
+        std::array<u64, EngineMethodsEnd> methodRedundantWriteCounts{}; //!< The amount of writes to each idempotent method that were skipped due to being redundant
+
+        /**
+         * @return A bitset of all methods that can be skipped when written with the value they already hold
+         */
+        static std::bitset<EngineMethodsEnd> MakeIdempotentMethods();
+
+        /**
+         * @brief Logs the methods with the most skipped redundant writes alongside their hit rate
+         */
+        void ReportRedundantWrites();
+
         void FlushDeferredDraw();
 
         /**
@@ -229,11 +246,14 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
             Register<0x547, u32> zCullStatCountersEnable;
             Register<0x548, u32> pointSpriteEnable;
             Register<0x54A, u32> shaderExceptions;
+            Register<0x54C, type::CounterReset> counterReset;
             Register<0x54D, u32> multisampleEnable;
             Register<0x54E, type::ZtSelect> ztSelect;
 
             Register<0x54F, type::MultisampleControl> multisampleControl;
 
+            Register<0x554, type::RenderEnable> renderEnable;
+
             Register<0x557, type::TexSamplerPool> texSamplerPool;
 
             Register<0x55B, float> slopeScaleDepthBias;
@@ -387,5 +407,9 @@ namespace skyline::soc::gm20b::engine::maxwell3d {
         void DrawInstanced(bool setRegs, u32 drawTopology, u32 vertexArrayCount, u32 instanceCount, u32 vertexArrayStart, u32 globalBaseInstanceIndex) override;
 
         void DrawIndexedInstanced(bool setRegs, u32 drawTopology, u32 indexBufferCount, u32 instanceCount, u32 globalBaseVertexIndex, u32 indexBufferFirst, u32 globalBaseInstanceIndex) override;
+
+        bool DrawIndirect(u32 drawTopology, span<u8> indirectBuffer, u32 count, u32 stride) override;
+
+        bool DrawIndexedIndirect(u32 drawTopology, span<u8> indirectBuffer, u32 count, u32 stride) override;
     };
 }
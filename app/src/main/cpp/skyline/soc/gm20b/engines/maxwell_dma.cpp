@@ -39,7 +39,6 @@ namespace skyline::soc::gm20b::engine {
         }
 
         if (registers.launchDma->multiLineEnable) {
-            channelCtx.executor.Submit();
             if (registers.launchDma->srcMemoryLayout == Registers::LaunchDma::MemoryLayout::Pitch &&
                 registers.launchDma->dstMemoryLayout == Registers::LaunchDma::MemoryLayout::BlockLinear)
                 CopyPitchToBlockLinear();
@@ -83,7 +82,28 @@ namespace skyline::soc::gm20b::engine {
         }
     }
 
+    u8 *MaxwellDma::ReadToStaging(u64 address, size_t size) {
+        stagingData.resize(size);
+        channelCtx.asCtx->gmmu.Read(stagingData.data(), address, size);
+        return stagingData.data();
+    }
+
     void MaxwellDma::CopyPitchToBlockLinear() {
+        u32 bytesPerPixel{static_cast<u32>(registers.remapComponents->ComponentSize() * registers.remapComponents->NumSrcComponents())};
+        if (registers.dstSurface->blockSize.Width() == 1 && interconnect.CopyBlockLinear(*registers.offsetIn, *registers.pitchIn, gpu::interconnect::MaxwellDma::BlockLinearSurface{
+            .address = *registers.offsetOut,
+            .dimensions = {registers.dstSurface->width, registers.dstSurface->height, registers.dstSurface->depth},
+            .blockHeight = registers.dstSurface->blockSize.Height(),
+            .blockDepth = registers.dstSurface->blockSize.Depth(),
+            .layer = registers.dstSurface->layer,
+            .originX = registers.dstSurface->origin.x,
+            .originY = registers.dstSurface->origin.y,
+        }, bytesPerPixel, *registers.lineLengthIn, *registers.lineCount, true))
+            return;
+
+        // The destination isn't GPU-resident, so we swizzle on the CPU which requires all prior GPU work to be complete
+        channelCtx.executor.Submit();
+
         if (registers.dstSurface->blockSize.Depth() > 1 || registers.dstSurface->depth > 1) {
             Logger::Warn("3D DMA engine copies are unimplemented");
             return;
@@ -94,7 +114,6 @@ namespace skyline::soc::gm20b::engine {
             return;
         }
 
-        u32 bytesPerPixel{static_cast<u32>(registers.remapComponents->ComponentSize() * registers.remapComponents->NumSrcComponents())};
         if (bytesPerPixel * *registers.lineLengthIn != *registers.pitchIn) {
             Logger::Warn("Non-linear DMA source textures are not implemented");
             return;
@@ -112,10 +131,7 @@ namespace skyline::soc::gm20b::engine {
         size_t srcStride{srcDimensions.width * srcDimensions.height * bytesPerPixel};
 
         auto srcMappings{channelCtx.asCtx->gmmu.TranslateRange(*registers.offsetIn, srcStride)};
-        if (srcMappings.size() != 1) {
-            Logger::Warn("DMA for split textures is unimplemented");
-            return;
-        }
+        u8 *srcData{srcMappings.size() == 1 ? srcMappings.front().data() : ReadToStaging(*registers.offsetIn, srcStride)};
 
         gpu::texture::Dimensions dstDimensions{registers.dstSurface->width, registers.dstSurface->height, registers.dstSurface->depth};
         dstDimensions.width = *registers.lineLengthIn; // We do not support copying subrects so we need the width to match on the source and destination
@@ -124,22 +140,45 @@ namespace skyline::soc::gm20b::engine {
 
         size_t dstLayerAddress{*registers.offsetOut + (registers.dstSurface->layer * dstLayerStride)};
         auto dstMappings{channelCtx.asCtx->gmmu.TranslateRange(dstLayerAddress, dstLayerStride)};
-        if (dstMappings.size() != 1) {
-            Logger::Warn("DMA for split textures is unimplemented");
-            return;
-        }
 
         Logger::Debug("{}x{}@0x{:X} -> {}x{}@0x{:X}", srcDimensions.width, srcDimensions.height, u64{*registers.offsetIn}, dstDimensions.width, dstDimensions.height, dstLayerAddress);
 
-        gpu::texture::CopyLinearToBlockLinear(
-            dstDimensions,
-            1, 1, bytesPerPixel,
-            dstBlockHeight, dstBlockDepth,
-            srcMappings.front().data(), dstMappings.front().data()
-        );
+        if (dstMappings.size() == 1) {
+            gpu::texture::CopyLinearToBlockLinear(
+                dstDimensions,
+                1, 1, bytesPerPixel,
+                dstBlockHeight, dstBlockDepth,
+                srcData, dstMappings.front().data()
+            );
+        } else {
+            // Swizzle into an intermediate buffer which is then scattered across the split destination mappings
+            std::vector<u8> dstData(dstLayerStride);
+            gpu::texture::CopyLinearToBlockLinear(
+                dstDimensions,
+                1, 1, bytesPerPixel,
+                dstBlockHeight, dstBlockDepth,
+                srcData, dstData.data()
+            );
+            channelCtx.asCtx->gmmu.Write(dstLayerAddress, dstData.data(), dstLayerStride);
+        }
     }
 
     void MaxwellDma::CopyBlockLinearToPitch() {
+        u32 bytesPerPixel{static_cast<u32>(registers.remapComponents->ComponentSize() * registers.remapComponents->NumSrcComponents())};
+        if (registers.srcSurface->blockSize.Width() == 1 && interconnect.CopyBlockLinear(*registers.offsetOut, *registers.pitchOut, gpu::interconnect::MaxwellDma::BlockLinearSurface{
+            .address = *registers.offsetIn,
+            .dimensions = {registers.srcSurface->width, registers.srcSurface->height, registers.srcSurface->depth},
+            .blockHeight = registers.srcSurface->blockSize.Height(),
+            .blockDepth = registers.srcSurface->blockSize.Depth(),
+            .layer = registers.srcSurface->layer,
+            .originX = registers.srcSurface->origin.x,
+            .originY = registers.srcSurface->origin.y,
+        }, bytesPerPixel, *registers.lineLengthIn, *registers.lineCount, false))
+            return;
+
+        // The source isn't GPU-resident, so we deswizzle on the CPU which requires all prior GPU work to be complete
+        channelCtx.executor.Submit();
+
         if (registers.srcSurface->blockSize.Depth() > 1 || registers.srcSurface->depth > 1) {
             Logger::Warn("3D DMA engine copies are unimplemented");
             return;
@@ -150,7 +189,6 @@ namespace skyline::soc::gm20b::engine {
             return;
         }
 
-        u32 bytesPerPixel{static_cast<u32>(registers.remapComponents->ComponentSize() * registers.remapComponents->NumSrcComponents())};
         if (bytesPerPixel * *registers.lineLengthIn != *registers.pitchOut) {
             Logger::Warn("Non-linear DMA destination textures are not implemented");
             return;
@@ -170,27 +208,31 @@ namespace skyline::soc::gm20b::engine {
         size_t srcStride{gpu::texture::GetBlockLinearLayerSize(srcDimensions, 1, 1, bytesPerPixel, srcBlockHeight, srcBlockDepth)};
 
         auto srcMappings{channelCtx.asCtx->gmmu.TranslateRange(*registers.offsetIn, srcStride)};
-        if (srcMappings.size() != 1) {
-            Logger::Warn("DMA for split textures is unimplemented");
-            return;
-        }
+        u8 *srcData{srcMappings.size() == 1 ? srcMappings.front().data() : ReadToStaging(*registers.offsetIn, srcStride)};
 
         gpu::texture::Dimensions dstDimensions{*registers.lineLengthIn, *registers.lineCount, 1};
         size_t dstStride{dstDimensions.width * dstDimensions.height * bytesPerPixel};
 
         auto dstMappings{channelCtx.asCtx->gmmu.TranslateRange(*registers.offsetOut, dstStride)};
-        if (dstMappings.size() != 1) {
-            Logger::Warn("DMA for split textures is unimplemented");
-            return;
-        }
 
         Logger::Debug("{}x{}@0x{:X} -> {}x{}@0x{:X}", srcDimensions.width, srcDimensions.height, u64{*registers.offsetIn}, dstDimensions.width, dstDimensions.height, u64{*registers.offsetOut});
 
-        gpu::texture::CopyBlockLinearToLinear(
-            srcDimensions,
-            1, 1, bytesPerPixel,
-            srcBlockHeight, srcBlockDepth,
-            srcMappings.front().data(), dstMappings.front().data());
+        if (dstMappings.size() == 1) {
+            gpu::texture::CopyBlockLinearToLinear(
+                srcDimensions,
+                1, 1, bytesPerPixel,
+                srcBlockHeight, srcBlockDepth,
+                srcData, dstMappings.front().data());
+        } else {
+            // Deswizzle into an intermediate buffer which is then scattered across the split destination mappings
+            std::vector<u8> dstData(dstStride);
+            gpu::texture::CopyBlockLinearToLinear(
+                srcDimensions,
+                1, 1, bytesPerPixel,
+                srcBlockHeight, srcBlockDepth,
+                srcData, dstData.data());
+            channelCtx.asCtx->gmmu.Write(*registers.offsetOut, dstData.data(), dstStride);
+        }
     }
 
     void MaxwellDma::CallMethodBatchNonInc(u32 method, span<u32> arguments) {
@@ -23,6 +23,7 @@ namespace skyline::soc::gm20b::engine {
         host1x::SyncpointSet &syncpoints;
         ChannelContext &channelCtx;
         gpu::interconnect::MaxwellDma interconnect;
+        std::vector<u8> stagingData; //!< Persistent vector storing the source data of CPU copies from split mappings to avoid constant reallocations
 
         void HandleMethod(u32 method, u32 argument);
 
@@ -30,6 +31,12 @@ namespace skyline::soc::gm20b::engine {
 
         void ReleaseSemaphore();
 
+        /**
+         * @brief Reads guest memory that's split across multiple mappings into a contiguous staging buffer
+         * @return A pointer to the staging buffer, this is only valid till the next call
+         */
+        u8 *ReadToStaging(u64 address, size_t size);
+
         void CopyPitchToBlockLinear();
 
         void CopyBlockLinearToPitch();
@@ -1,12 +1,19 @@
 // SPDX-License-Identifier: MPL-2.0
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
+#include <sys/stat.h>
 #include <common/signal.h>
+#include <common/settings.h>
+#include <common/trace.h>
+#include <common/perf_stats.h>
+#include <common/thread_role.h>
 #include <loader/loader.h>
 #include <kernel/types/KProcess.h>
 #include <soc.h>
+#include <gpu.h>
 #include <os.h>
 #include "channel.h"
+#include "gpfifo_capture.h"
 
 namespace skyline::soc::gm20b {
     /**
@@ -84,9 +91,21 @@ namespace skyline::soc::gm20b {
         gpfifoEngine(state.soc->host1x.syncpoints, channelCtx),
         channelCtx(channelCtx),
         gpEntries(numEntries),
-        thread(std::thread(&ChannelGpfifo::Run, this)) {}
-
-    void ChannelGpfifo::SendFull(u32 method, u32 argument, SubchannelId subChannel, bool lastCall) {
+        capture([&]() -> std::unique_ptr<GpfifoCapture> {
+            if (!*state.settings->gpfifoCapture)
+                return nullptr;
+
+            // Every channel is written to a separate capture as they are processed independently, the index disambiguates channels created in the same instant
+            static std::atomic<u32> channelIndex;
+            u64 titleId{state.process->npdm.aci0.programId};
+            std::string directory{state.os->publicAppFilesPath + "gpfifo_capture/"};
+            mkdir(directory.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+            return std::make_unique<GpfifoCapture>(fmt::format("{}{:016X}_{}_{}.skgc", directory, titleId, util::GetTimeNs(), channelIndex++), titleId);
+        }()),
+        thread(std::thread(&ChannelGpfifo::Run, this)),
+        fetchThread(std::thread(&ChannelGpfifo::FetchThread, this)) {}
+
+    void ChannelGpfifo::SendFull(u32 method, u32 argument, u32 *argumentPtr, SubchannelId subChannel, bool lastCall) {
         if (method < engine::GPFIFO::RegisterCount) {
             gpfifoEngine.CallMethod(method, argument);
         } else if (method < engine::EngineMethodsEnd) { [[likely]]
@@ -94,10 +113,10 @@ namespace skyline::soc::gm20b {
         } else {
             switch (subChannel) {
                 case SubchannelId::ThreeD:
-                    channelCtx.maxwell3D.HandleMacroCall(method - engine::EngineMethodsEnd, argument, lastCall);
+                    channelCtx.maxwell3D.HandleMacroCall(method - engine::EngineMethodsEnd, argument, argumentPtr, lastCall);
                     break;
                 case SubchannelId::TwoD:
-                    channelCtx.fermi2D.HandleMacroCall(method - engine::EngineMethodsEnd, argument, lastCall);
+                    channelCtx.fermi2D.HandleMacroCall(method - engine::EngineMethodsEnd, argument, argumentPtr, lastCall);
                     break;
                 default:
                     Logger::Warn("Called method 0x{:X} out of bounds for engine 0x{:X}, args: 0x{:X}", method, subChannel, argument);
@@ -153,12 +172,14 @@ namespace skyline::soc::gm20b {
         }
     }
 
-    void ChannelGpfifo::Process(GpEntry gpEntry) {
-        // Submit if required by the GpEntry, this is needed as some games dynamically generate pushbuffer contents
-        if (gpEntry.sync == GpEntry::Sync::Wait)
-            channelCtx.executor.Submit();
+    void ChannelGpfifo::Fetch(GpEntry gpEntry, FetchedEntry &fetched) {
+        fetched.type = FetchedEntry::Type::PushBuffer;
+        fetched.batches.clear();
 
         if (!gpEntry.size) {
+            if (capture)
+                capture->Record(gpEntry, {});
+
             // This is a GPFIFO control entry, all control entries have a zero length and contain no pushbuffers
             switch (gpEntry.opcode) {
                 case GpEntry::Opcode::Nop:
@@ -170,39 +191,57 @@ namespace skyline::soc::gm20b {
         }
 
         auto pushBufferMappedRanges{channelCtx.asCtx->gmmu.TranslateRange(gpEntry.Address(), gpEntry.size * sizeof(u32))};
+        for (const auto &range : pushBufferMappedRanges)
+            if (!range.data())
+                throw exception("Pushbuffer at 0x{:X} (0x{:X} bytes) isn't fully mapped", gpEntry.Address(), gpEntry.size * sizeof(u32));
+
+        // Macro arguments can only be referenced in guest memory when the pushbuffer is parsed in-place, this allows HLE macros to pass them to the host GPU directly
+        fetched.inPlace = pushBufferMappedRanges.size() == 1;
+
         auto pushBuffer{[&]() -> span<u32> {
-            if (pushBufferMappedRanges.size() == 1) {
+            if (fetched.inPlace) {
+                // The pushbuffer is contiguous in host memory, so it can be parsed in-place without any copies
                 return pushBufferMappedRanges.front().cast<u32>();
             } else {
-                // Create an intermediate copy of pushbuffer data if it's split across multiple mappings
-                pushBufferData.resize(gpEntry.size);
-                channelCtx.asCtx->gmmu.Read<u32>(pushBufferData, gpEntry.Address());
-                return span(pushBufferData);
+                // Create an intermediate copy of pushbuffer data if it's split across multiple mappings, the already translated ranges are used to avoid walking the GMMU a second time
+                TRACE_EVENT("gpu", "ChannelGpfifo::CopySplitPushBuffer", "ranges", pushBufferMappedRanges.size());
+                fetched.pushBufferData.resize(gpEntry.size);
+                auto destination{span(fetched.pushBufferData).cast<u8>()};
+                for (const auto &range : pushBufferMappedRanges) {
+                    destination.copy_from(range);
+                    destination = destination.subspan(range.size());
+                }
+                return span(fetched.pushBufferData);
             }
         }()};
 
-        // There will be at least one entry here
-        auto entry{pushBuffer.begin()};
+        if (capture)
+            capture->Record(gpEntry, pushBuffer);
 
-        // Executes the current split method, returning once execution is finished or the current GpEntry has reached its end
-        auto resumeSplitMethod{[&](){
-            switch (resumeState.state) {
-                case MethodResumeState::State::Inc:
-                    while (entry != pushBuffer.end() && resumeState.remaining)
-                        SendFull(resumeState.address++, *(entry++), resumeState.subChannel, --resumeState.remaining == 0);
+        size_t offset{}; //!< The offset of the next word to decode in the pushbuffer
 
-                    break;
-                case MethodResumeState::State::OneInc:
-                    SendFull(resumeState.address++, *(entry++), resumeState.subChannel, --resumeState.remaining == 0);
+        // Decodes the part of the current split method that's in this GpEntry, consuming as many words as it can
+        auto resumeSplitMethod{[&]() {
+            u32 count{static_cast<u32>(std::min<size_t>(resumeState.remaining, pushBuffer.size() - offset))};
+            if (!count)
+                return;
 
-                    // After the first increment OneInc methods work the same as a NonInc method, this is needed so they can resume correctly if they are broken up by multiple GpEntries
-                    resumeState.state = MethodResumeState::State::NonInc;
-                    [[fallthrough]];
-                case MethodResumeState::State::NonInc:
-                    while (entry != pushBuffer.end() && resumeState.remaining)
-                        SendFull(resumeState.address, *(entry++), resumeState.subChannel, --resumeState.remaining == 0);
-
-                    break;
+            resumeState.remaining -= count;
+            fetched.batches.push_back(MethodBatch{
+                .type = resumeState.state == MethodResumeState::State::Inc ? MethodBatch::Type::Inc : (resumeState.state == MethodResumeState::State::OneInc ? MethodBatch::Type::OneInc : MethodBatch::Type::NonInc),
+                .subChannel = resumeState.subChannel,
+                .finishesMethod = resumeState.remaining == 0,
+                .address = resumeState.address,
+                .arguments = pushBuffer.subspan(offset, count),
+            });
+            offset += count;
+
+            if (resumeState.state == MethodResumeState::State::Inc) {
+                resumeState.address += count;
+            } else if (resumeState.state == MethodResumeState::State::OneInc) {
+                // After the first increment OneInc methods work the same as a NonInc method, this is needed so they can resume correctly if they are broken up by multiple GpEntries
+                resumeState.address++;
+                resumeState.state = MethodResumeState::State::NonInc;
             }
         }};
 
@@ -210,154 +249,162 @@ namespace skyline::soc::gm20b {
         if (resumeState.remaining)
             resumeSplitMethod();
 
-        // Process more methods if the entries are still not all used up after handling resuming
-        for (; entry != pushBuffer.end(); entry++) {
-            if (entry >= pushBuffer.end()) [[unlikely]]
-                throw exception("GPFIFO buffer overflow!"); // This should never happen
-
+        while (offset < pushBuffer.size()) {
             // Entries containing all zeroes is a NOP, skip over them
-            for (; *entry == 0; entry++)
-                if (entry == std::prev(pushBuffer.end()))
-                    return;
+            if (pushBuffer[offset] == 0) {
+                offset++;
+                continue;
+            }
 
-            PushBufferMethodHeader methodHeader{.raw = *entry};
+            PushBufferMethodHeader methodHeader{.raw = pushBuffer[offset++]};
 
-            // Needed in order to check for methods split across multiple GpEntries
-            ssize_t remainingEntries{std::distance(entry, pushBuffer.end()) - 1};
+            /**
+             * @brief Decodes a method with arguments following its header, storing state for methods that are split across multiple GpEntries
+             */
+            auto decodeMethod{[&](MethodBatch::Type type, MethodResumeState::State resumeType) {
+                if (pushBuffer.size() - offset >= methodHeader.methodCount) [[likely]] {
+                    if (methodHeader.methodCount)
+                        fetched.batches.push_back(MethodBatch{
+                            .type = type,
+                            .subChannel = methodHeader.methodSubChannel,
+                            .pure = methodHeader.Pure(),
+                            .finishesMethod = true,
+                            .address = methodHeader.methodAddress,
+                            .arguments = pushBuffer.subspan(offset, methodHeader.methodCount),
+                        });
+
+                    offset += methodHeader.methodCount;
+                } else {
+                    resumeState = {
+                        .remaining = methodHeader.methodCount,
+                        .address = methodHeader.methodAddress,
+                        .subChannel = methodHeader.methodSubChannel,
+                        .state = resumeType
+                    };
+
+                    resumeSplitMethod();
+                }
+            }};
 
-            // Handles storing state and initial execution for methods that are split across multiple GpEntries
-            auto startSplitMethod{[&](auto methodState) {
-                resumeState = {
-                    .remaining = methodHeader.methodCount,
-                    .address = methodHeader.methodAddress,
-                    .subChannel = methodHeader.methodSubChannel,
-                    .state = methodState
-                };
+            switch (methodHeader.secOp) {
+                case PushBufferMethodHeader::SecOp::IncMethod:
+                    decodeMethod(MethodBatch::Type::Inc, MethodResumeState::State::Inc);
+                    break;
 
-                // Skip over method header as `resumeSplitMethod` doesn't expect it to be there
-                entry++;
+                case PushBufferMethodHeader::SecOp::OneInc:
+                    decodeMethod(MethodBatch::Type::OneInc, MethodResumeState::State::OneInc);
+                    break;
 
-                resumeSplitMethod();
-            }};
+                case PushBufferMethodHeader::SecOp::NonIncMethod:
+                    decodeMethod(MethodBatch::Type::NonInc, MethodResumeState::State::NonInc);
+                    break;
 
-            /**
-             * @brief Handles execution of a specific method type as specified by the State template parameter
-             */
-            auto dispatchCalls{[&]<MethodResumeState::State State> () {
-                /**
-                 * @brief Gets the offset to apply to the method address for a given dispatch loop index
-                 */
-                auto methodOffset{[] (u32 i) -> u32 {
-                    if constexpr(State == MethodResumeState::State::Inc)
-                        return i;
-                    else if constexpr (State == MethodResumeState::State::OneInc)
-                        return i ? 1 : 0;
-                    else
-                        return 0;
-                }};
-
-                constexpr u32 BatchCutoff{4}; //!< Cutoff needed to send method calls in a batch which is espcially important for UBO updates. This helps to avoid the extra overhead batching for small packets.
-                // TODO: Only batch for specific target methods like UBO updates, since normal dispatch is generally cheaper
-
-                if (remainingEntries >= methodHeader.methodCount) { [[likely]]
-                    if (methodHeader.Pure()) [[likely]] {
-                        if constexpr (State == MethodResumeState::State::NonInc) {
-                            // For pure noninc methods we can send all method calls as a span in one go
-                            if (methodHeader.methodCount > BatchCutoff) [[unlikely]] {
-                                SendPureBatchNonInc(methodHeader.methodAddress, span(&(*++entry), methodHeader.methodCount), methodHeader.methodSubChannel);
-
-                                entry += methodHeader.methodCount - 1;
-                                return false;
-                            }
-                        } else if constexpr (State == MethodResumeState::State::OneInc) {
-                            // For pure oneinc methods we can send the initial method then send the rest as a span in one go
-                            if (methodHeader.methodCount > (BatchCutoff + 1)) [[unlikely]] {
-                                SendPure(methodHeader.methodAddress, *++entry, methodHeader.methodSubChannel);
-                                SendPureBatchNonInc(methodHeader.methodAddress + 1, span(&(*++entry) ,methodHeader.methodCount - 1), methodHeader.methodSubChannel);
-
-                                entry += methodHeader.methodCount - 2;
-                                return false;
-                            }
-                        }
+                case PushBufferMethodHeader::SecOp::ImmdDataMethod:
+                    fetched.batches.push_back(MethodBatch{
+                        .type = MethodBatch::Type::Immediate,
+                        .subChannel = methodHeader.methodSubChannel,
+                        .pure = methodHeader.Pure(),
+                        .finishesMethod = true,
+                        .address = methodHeader.methodAddress,
+                        .immediate = methodHeader.immdData,
+                    });
+                    break;
 
-                        #pragma unroll(2)
-                        for (u32 i{}; i < methodHeader.methodCount; i++)
-                            SendPure(methodHeader.methodAddress + methodOffset(i), *++entry, methodHeader.methodSubChannel);
-                    } else {
-                        // Slow path for methods that touch GPFIFO or macros
-                        for (u32 i{}; i < methodHeader.methodCount; i++)
-                            SendFull(methodHeader.methodAddress + methodOffset(i), *++entry, methodHeader.methodSubChannel, i == methodHeader.methodCount - 1);
-                    }
-                } else {
-                    startSplitMethod(State);
-                    return true;
-                }
+                case PushBufferMethodHeader::SecOp::EndPbSegment:
+                    return;
 
-                return false;
-            }};
+                default:
+                    throw exception("Unsupported pushbuffer method SecOp: {}", static_cast<u8>(methodHeader.secOp));
+            }
+        }
+    }
 
+    void ChannelGpfifo::Execute(const FetchedEntry &fetched) {
+        /**
+         * @brief Handles execution of a batch of the type specified by the Type template parameter
+         */
+        auto dispatchCalls{[&]<MethodBatch::Type Type>(const MethodBatch &batch) {
             /**
-             * @brief Handles execution of a single method
-             * @return If the this was the final method in the current GpEntry
+             * @brief Gets the offset to apply to the method address for a given dispatch loop index
              */
-            auto processMethod{[&] () -> bool {
-                if (methodHeader.secOp == PushBufferMethodHeader::SecOp::IncMethod)  [[likely]] {
-                    return dispatchCalls.operator()<MethodResumeState::State::Inc>();
-                } else if (methodHeader.secOp == PushBufferMethodHeader::SecOp::OneInc) [[likely]] {
-                    return dispatchCalls.operator()<MethodResumeState::State::OneInc>();
-                } else if (methodHeader.secOp == PushBufferMethodHeader::SecOp::ImmdDataMethod) {
-                    if (methodHeader.Pure())
-                        SendPure(methodHeader.methodAddress, methodHeader.immdData, methodHeader.methodSubChannel);
-                    else
-                        SendFull(methodHeader.methodAddress, methodHeader.immdData, methodHeader.methodSubChannel, true);
+            auto methodOffset{[](u32 i) -> u32 {
+                if constexpr (Type == MethodBatch::Type::Inc)
+                    return i;
+                else if constexpr (Type == MethodBatch::Type::OneInc)
+                    return i ? 1 : 0;
+                else
+                    return 0;
+            }};
 
-                    return false;
-                } else if (methodHeader.secOp == PushBufferMethodHeader::SecOp::NonIncMethod) [[unlikely]] {
-                    return dispatchCalls.operator()<MethodResumeState::State::NonInc>();
-                } else if (methodHeader.secOp == PushBufferMethodHeader::SecOp::EndPbSegment) [[unlikely]] {
-                        return true;
-                } else {
-                        throw exception("Unsupported pushbuffer method SecOp: {}", static_cast<u8>(methodHeader.secOp));
+            constexpr u32 BatchCutoff{4}; //!< Cutoff needed to send method calls in a batch which is espcially important for UBO updates. This helps to avoid the extra overhead batching for small packets.
+            // TODO: Only batch for specific target methods like UBO updates, since normal dispatch is generally cheaper
+
+            auto arguments{batch.arguments};
+            u32 count{static_cast<u32>(arguments.size())};
+            if (batch.pure) [[likely]] {
+                if constexpr (Type == MethodBatch::Type::NonInc) {
+                    // For pure noninc methods we can send all method calls as a span in one go
+                    if (count > BatchCutoff) [[unlikely]] {
+                        SendPureBatchNonInc(batch.address, arguments, batch.subChannel);
+                        return;
+                    }
+                } else if constexpr (Type == MethodBatch::Type::OneInc) {
+                    // For pure oneinc methods we can send the initial method then send the rest as a span in one go
+                    if (count > (BatchCutoff + 1)) [[unlikely]] {
+                        SendPure(batch.address, arguments[0], batch.subChannel);
+                        SendPureBatchNonInc(batch.address + 1, arguments.subspan(1), batch.subChannel);
+                        return;
+                    }
                 }
-            }};
 
-            bool hitEnd{[&]() {
-                if (methodHeader.methodSubChannel != SubchannelId::ThreeD) [[unlikely]]
-                    channelCtx.maxwell3D.FlushEngineState(); // Flush the 3D engine state when doing any calls to other engines
-                return processMethod();
-            }()};
+                #pragma unroll(2)
+                for (u32 i{}; i < count; i++)
+                    SendPure(batch.address + methodOffset(i), arguments[i], batch.subChannel);
+            } else {
+                // Slow path for methods that touch GPFIFO or macros
+                for (u32 i{}; i < count; i++)
+                    SendFull(batch.address + methodOffset(i), arguments[i], fetched.inPlace ? &arguments[i] : nullptr, batch.subChannel, batch.finishesMethod && i == count - 1);
+            }
+        }};
 
-            if (hitEnd)
-                break;
+        for (const auto &batch : fetched.batches) {
+            if (batch.subChannel != SubchannelId::ThreeD) [[unlikely]]
+                channelCtx.maxwell3D.FlushEngineState(); // Flush the 3D engine state when doing any calls to other engines
+
+            switch (batch.type) {
+                case MethodBatch::Type::Inc:
+                    dispatchCalls.operator()<MethodBatch::Type::Inc>(batch);
+                    break;
+                case MethodBatch::Type::OneInc:
+                    dispatchCalls.operator()<MethodBatch::Type::OneInc>(batch);
+                    break;
+                case MethodBatch::Type::NonInc:
+                    dispatchCalls.operator()<MethodBatch::Type::NonInc>(batch);
+                    break;
+                case MethodBatch::Type::Immediate:
+                    if (batch.pure)
+                        SendPure(batch.address, batch.immediate, batch.subChannel);
+                    else
+                        SendFull(batch.address, batch.immediate, nullptr, batch.subChannel, true);
+                    break;
+            }
         }
     }
 
-    void ChannelGpfifo::Run() {
-        if (int result{pthread_setname_np(pthread_self(), "GPFIFO")})
+    /**
+     * @brief Runs the body of a GPFIFO thread, any exceptions thrown by it kill the process
+     */
+    template<typename Function>
+    static void RunGpfifoThread(const DeviceState &state, const char *name, Function function) {
+        if (int result{pthread_setname_np(pthread_self(), name)})
             Logger::Warn("Failed to set the thread name: {}", strerror(result));
+        thread_role::Apply(thread_role::Role::Gpfifo);
 
         try {
             signal::SetSignalHandler({SIGINT, SIGILL, SIGTRAP, SIGBUS, SIGFPE}, signal::ExceptionalSignalHandler);
             signal::SetSignalHandler({SIGSEGV}, nce::NCE::HostSignalHandler); // We may access NCE trapped memory
 
-            bool channelLocked{};
-
-            gpEntries.Process([this, &channelLocked](GpEntry gpEntry) {
-                Logger::Debug("Processing pushbuffer: 0x{:X}, Size: 0x{:X}", gpEntry.Address(), +gpEntry.size);
-
-                if (!channelLocked) {
-                    channelCtx.Lock();
-                    channelLocked = true;
-                }
-
-                Process(gpEntry);
-            }, [this, &channelLocked]() {
-                // If we run out of GpEntries to process ensure we submit any remaining GPU work before waiting for more to arrive
-                Logger::Debug("Finished processing pushbuffer batch");
-                channelCtx.executor.Submit();
-                channelCtx.Unlock();
-                channelLocked = false;
-            });
+            function();
         } catch (const signal::SignalException &e) {
             if (e.signal != SIGINT) {
                 Logger::Error("{}\nStack Trace:{}", e.what(), state.loader->GetStackTrace(e.frames));
@@ -378,6 +425,76 @@ namespace skyline::soc::gm20b {
         }
     }
 
+    void ChannelGpfifo::FetchThread() {
+        RunGpfifoThread(state, "GPFIFO-Fetch", [this]() {
+            gpEntries.Process([this](GpEntry gpEntry) {
+                Logger::Debug("Fetching pushbuffer: 0x{:X}, Size: 0x{:X}", gpEntry.Address(), +gpEntry.size);
+
+                if (gpEntry.sync == GpEntry::Sync::Wait) {
+                    // Some games dynamically generate pushbuffer contents, so all prior work needs to be executed and submitted before the pushbuffer can be read
+                    fetchedEntries.Emplace([](FetchedEntry &fetched) {
+                        fetched.type = FetchedEntry::Type::Submit;
+                    });
+                    fetchedEntries.WaitForEmpty();
+                }
+
+                fetchedEntries.Emplace([&](FetchedEntry &fetched) {
+                    Fetch(gpEntry, fetched);
+                });
+            }, [this]() {
+                fetchedEntries.Emplace([](FetchedEntry &fetched) {
+                    fetched.type = FetchedEntry::Type::Idle;
+                });
+            });
+        });
+    }
+
+    void ChannelGpfifo::Run() {
+        RunGpfifoThread(state, "GPFIFO", [this]() {
+            bool channelLocked{};
+            i64 idleStart{}; //!< The timestamp at which the GPFIFO started waiting on more GpEntries, 0 if it isn't waiting
+
+            auto lockChannel{[&]() {
+                if (!channelLocked) {
+                    channelCtx.Lock();
+                    channelLocked = true;
+                }
+            }};
+
+            fetchedEntries.Process([&](FetchedEntry &fetched) {
+                switch (fetched.type) {
+                    case FetchedEntry::Type::PushBuffer:
+                        if (idleStart)
+                            PerfStats::Increment(PerfStats::Counter::GpfifoIdleNs, static_cast<u64>(util::GetTimeNs() - std::exchange(idleStart, 0)));
+
+                        lockChannel();
+                        Execute(fetched);
+                        break;
+
+                    case FetchedEntry::Type::Submit:
+                        lockChannel();
+                        channelCtx.executor.Submit();
+                        break;
+
+                    case FetchedEntry::Type::Idle:
+                        // If we run out of GpEntries to process ensure we submit any remaining GPU work before waiting for more to arrive
+                        Logger::Debug("Finished processing pushbuffer batch");
+                        if (channelLocked) {
+                            channelCtx.executor.Submit();
+                            channelCtx.Unlock();
+                            channelLocked = false;
+
+                            // The time between batches is otherwise spent waiting, a bounded amount of texture memory is compacted here
+                            if (*state.settings->memoryDefragmentation)
+                                state.gpu->memory.Defragment();
+                        }
+                        idleStart = util::GetTimeNs();
+                        break;
+                }
+            }, []() {});
+        });
+    }
+
     void ChannelGpfifo::Push(span<GpEntry> entries) {
         gpEntries.Append(entries);
     }
@@ -387,9 +504,12 @@ namespace skyline::soc::gm20b {
     }
 
     ChannelGpfifo::~ChannelGpfifo() {
-        if (thread.joinable()) {
-            pthread_kill(thread.native_handle(), SIGINT);
-            thread.join();
+        // The fetch thread is stopped first as it produces the entries that the GPFIFO thread executes
+        for (auto *gpfifoThread : {&fetchThread, &thread}) {
+            if (gpfifoThread->joinable()) {
+                pthread_kill(gpfifoThread->native_handle(), SIGINT);
+                gpfifoThread->join();
+            }
         }
     }
 }
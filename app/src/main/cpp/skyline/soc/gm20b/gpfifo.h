@@ -3,11 +3,12 @@
 
 #pragma once
 
-#include <common/circular_queue.h>
+#include <common/spsc_queue.h>
 #include "engines/gpfifo.h"
 
 namespace skyline::soc::gm20b {
     struct ChannelContext;
+    class GpfifoCapture;
 
     /**
      * @brief Mapping of subchannel names to their corresponding subchannel IDs
@@ -96,7 +97,7 @@ namespace skyline::soc::gm20b {
 
     /**
      * @brief The ChannelGpfifo class handles creating pushbuffers from GP entries and then processing them for a single channel
-     * @note A single ChannelGpfifo thread exists per channel, allowing them to run asynchronously
+     * @note Every channel has a pair of threads allowing them to run asynchronously, a fetch thread translates and decodes pushbuffers into method batches ahead of the GPFIFO thread which executes them on the engines
      * @note This class doesn't perfectly map to any particular hardware component on the X1, it does a mix of the GPU Host PBDMA and handling the GPFIFO entries
      * @url https://github.com/NVIDIA/open-gpu-doc/blob/ab27fc22db5de0d02a4cabe08e555663b62db4d4/manuals/volta/gv100/dev_pbdma.ref.txt#L62
      */
@@ -105,12 +106,47 @@ namespace skyline::soc::gm20b {
         const DeviceState &state;
         ChannelContext &channelCtx;
         engine::GPFIFO gpfifoEngine; //!< The engine for processing GPFIFO method calls
-        CircularQueue<GpEntry> gpEntries;
-        std::vector<u32> pushBufferData; //!< Persistent vector storing pushbuffer data to avoid constant reallocations
+        SpscQueue<GpEntry> gpEntries; //!< GpEntries pending processing, pushes are serialized by the nvhost channel's mutex so there's only a single producer at a time
 
         /**
-         * @brief Holds the required state in order to resume a method started from one call to `Process` in another
-         * @note This is needed as games (especially OpenGL ones) can split method entries over multiple GpEntries
+         * @brief A run of calls to a single method that has been decoded from a pushbuffer ahead of its execution
+         */
+        struct MethodBatch {
+            enum class Type : u8 {
+                NonInc,
+                Inc,
+                OneInc, //!< The first call is to `address` and all subsequent ones to the method after it
+                Immediate, //!< A single call with `immediate` as its argument
+            } type;
+            SubchannelId subChannel;
+            bool pure; //!< If the calls don't touch macro or GPFIFO methods
+            bool finishesMethod; //!< If the final call of the batch is the final call of its method, this is false for the parts of a method that's split across GpEntries prior to its last
+            u32 address;
+            u32 immediate;
+            span<u32> arguments; //!< The arguments of the calls within the pushbuffer, this is empty for immediate methods
+        };
+
+        /**
+         * @brief A GpEntry that has been fetched and decoded by the fetch thread for execution on the GPFIFO thread
+         * @note These are constructed in-place in the queue so the storage of the vectors is reused between entries
+         */
+        struct FetchedEntry {
+            enum class Type : u8 {
+                PushBuffer, //!< The batches of a pushbuffer that should be executed
+                Submit, //!< Any recorded GPU work should be submitted, the fetch thread waits for this to be executed before reading the next pushbuffer
+                Idle, //!< There are no more GpEntries to fetch, any recorded GPU work should be submitted and the channel unlocked
+            } type;
+            bool inPlace; //!< If the arguments of the batches are in guest memory rather than in `pushBufferData`
+            std::vector<u32> pushBufferData; //!< A copy of the pushbuffer if it was split across multiple mappings
+            std::vector<MethodBatch> batches;
+        };
+
+        static constexpr size_t FetchDepth{8}; //!< The maximum amount of GpEntries that can be fetched ahead of their execution
+        SpscQueue<FetchedEntry> fetchedEntries{FetchDepth};
+
+        /**
+         * @brief Holds the required state in order to resume a method started from one call to `Fetch` in another
+         * @note This is needed as games (especially OpenGL ones) can split method entries over multiple GpEntries, it's only accessed by the fetch thread
          */
         struct MethodResumeState {
             u32 remaining; //!< The number of entries left to handle until the method is finished
@@ -127,12 +163,15 @@ namespace skyline::soc::gm20b {
             } state; //!< The type of method to resume
         } resumeState{};
 
-        std::thread thread; //!< The thread that manages processing of pushbuffers
+        std::unique_ptr<GpfifoCapture> capture; //!< The capture that all fetched entries are written to, this is only created when GPFIFO capturing is enabled
+        std::thread thread; //!< The thread that executes the methods of fetched pushbuffers
+        std::thread fetchThread; //!< The thread that fetches and decodes pushbuffers
 
         /**
          * @brief Sends a method call to the appropriate subchannel and handles macro and GPFIFO methods
+         * @param argumentPtr A pointer to the argument in guest memory, this is nullptr if it wasn't read directly from it
          */
-        void SendFull(u32 method, u32 argument, SubchannelId subchannel, bool lastCall);
+        void SendFull(u32 method, u32 argument, u32 *argumentPtr, SubchannelId subchannel, bool lastCall);
 
         /**
          * @brief Sends a method call to the appropriate subchannel, macro and GPFIFO methods are not handled
@@ -145,12 +184,22 @@ namespace skyline::soc::gm20b {
         void SendPureBatchNonInc(u32 method, span<u32> arguments, SubchannelId subChannel);
 
         /**
-         * @brief Processes the pushbuffer contained within the given GpEntry, calling methods as needed
+         * @brief Translates the pushbuffer contained within the given GpEntry and decodes it into method batches
+         */
+        void Fetch(GpEntry gpEntry, FetchedEntry &fetched);
+
+        /**
+         * @brief Calls all methods in the batches of a fetched pushbuffer
+         */
+        void Execute(const FetchedEntry &fetched);
+
+        /**
+         * @brief Fetches all pending entries in the FIFO and polls for more
          */
-        void Process(GpEntry gpEntry);
+        void FetchThread();
 
         /**
-         * @brief Executes all pending entries in the FIFO and polls for more
+         * @brief Executes all fetched entries and polls for more
          */
         void Run();
 
@@ -163,12 +212,14 @@ namespace skyline::soc::gm20b {
         ~ChannelGpfifo();
 
         /**
-         * @brief Pushes a list of entries to the FIFO, these commands will be executed on calls to 'Process'
+         * @brief Pushes a list of entries to the FIFO, these commands will be fetched and then executed by the GPFIFO threads
+         * @note The entries are published to the GPFIFO thread in bulk rather than individually
+         * @note Pushes **must** be externally serialized as the FIFO only supports a single producer at a time
          */
         void Push(span<GpEntry> entries);
 
         /**
-         * @brief Pushes a single entry to the FIFO, these commands will be executed on calls to 'Process'
+         * @brief Pushes a single entry to the FIFO, these commands will be fetched and then executed by the GPFIFO threads
          */
         void Push(GpEntry entries);
     };
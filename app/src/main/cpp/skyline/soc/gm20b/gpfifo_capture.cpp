@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <lz4.h>
+#include <common/trace.h>
+#include "gpfifo_capture.h"
+
+namespace skyline::soc::gm20b {
+    GpfifoCapture::GpfifoCapture(const std::string &path, u64 titleId) {
+        fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+        if (fd < 0) {
+            Logger::Warn("Failed to open GPFIFO capture file '{}': {}", path, strerror(errno));
+            return;
+        }
+
+        block.reserve(BlockSize);
+
+        FileHeader header{.titleId = titleId};
+        Write(span<FileHeader>{header}.cast<const u8>());
+        Logger::Info("Capturing GPFIFO entries to '{}'", path);
+    }
+
+    GpfifoCapture::~GpfifoCapture() {
+        FlushBlock();
+        if (fd >= 0)
+            close(fd);
+    }
+
+    void GpfifoCapture::Write(span<const u8> data) {
+        while (fd >= 0 && !data.empty()) {
+            auto ret{write(fd, data.data(), data.size())};
+            if (ret < 0) {
+                if (errno == EINTR)
+                    continue;
+
+                Logger::Warn("Failed to write to GPFIFO capture file, capturing has been stopped: {}", strerror(errno));
+                close(fd);
+                fd = -1;
+                return;
+            }
+
+            data = data.subspan(static_cast<size_t>(ret));
+        }
+    }
+
+    void GpfifoCapture::FlushBlock() {
+        if (block.empty() || fd < 0)
+            return;
+
+        TRACE_EVENT("gpu", "GpfifoCapture::FlushBlock");
+
+        compressedBlock.resize(sizeof(BlockHeader) + static_cast<size_t>(LZ4_compressBound(static_cast<int>(block.size()))));
+        int compressedSize{LZ4_compress_default(reinterpret_cast<const char *>(block.data()), reinterpret_cast<char *>(compressedBlock.data() + sizeof(BlockHeader)), static_cast<int>(block.size()), static_cast<int>(compressedBlock.size() - sizeof(BlockHeader)))};
+        if (compressedSize <= 0)
+            throw exception("Failed to compress GPFIFO capture block of 0x{:X} bytes", block.size());
+
+        *reinterpret_cast<BlockHeader *>(compressedBlock.data()) = BlockHeader{
+            .compressedSize = static_cast<u32>(compressedSize),
+            .size = static_cast<u32>(block.size()),
+        };
+        Write(span{compressedBlock}.first(sizeof(BlockHeader) + static_cast<size_t>(compressedSize)));
+
+        block.clear();
+    }
+
+    void GpfifoCapture::Record(GpEntry entry, span<const u32> pushBuffer) {
+        if (fd < 0)
+            return;
+
+        EntryHeader header{entry, util::GetTimeNs()};
+        auto headerBytes{span<EntryHeader>{header}.cast<const u8>()};
+        auto pushBufferBytes{pushBuffer.cast<const u8>()};
+        block.insert(block.end(), headerBytes.begin(), headerBytes.end());
+        block.insert(block.end(), pushBufferBytes.begin(), pushBufferBytes.end());
+
+        if (block.size() >= BlockSize)
+            FlushBlock();
+    }
+}
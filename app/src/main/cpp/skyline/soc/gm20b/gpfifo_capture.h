@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <common.h>
+#include "gpfifo.h"
+
+namespace skyline::soc::gm20b {
+    /**
+     * @brief Writes all GpEntries processed by a channel along with the contents of their pushbuffers to a capture file, allowing the command stream of a title to be inspected or replayed
+     * @note The file starts with a FileHeader which is followed by any amount of blocks, each block is a BlockHeader followed by LZ4-compressed data containing a sequence of EntryHeaders each directly followed by the pushbuffer of the entry
+     * @note Captures are only written out a block at a time, so the last entries may be lost if emulation is abruptly terminated
+     */
+    class GpfifoCapture {
+      public:
+        static constexpr u32 Magic{util::MakeMagic<u32>("SKGC")};
+        static constexpr u32 Version{1}; //!< The version of the capture format, this must be incremented whenever any of the structures below are changed
+
+        struct FileHeader {
+            u32 magic{Magic};
+            u32 version{Version};
+            u64 titleId; //!< The program ID of the title that the capture was made from
+        };
+
+        struct BlockHeader {
+            u32 compressedSize; //!< The size of the LZ4-compressed block data following the header
+            u32 size; //!< The size of the block data once decompressed
+        };
+
+        struct EntryHeader {
+            GpEntry entry;
+            i64 timestampNs; //!< The time at which the entry was processed, this allows for replays to reproduce the pacing of submissions
+        };
+
+      private:
+        static constexpr size_t BlockSize{4 * 1024 * 1024}; //!< The uncompressed size at which a block is compressed and written out, entries are never split across blocks so a block may be larger than this
+
+        int fd{-1};
+        std::vector<u8> block; //!< The uncompressed contents of the block that is currently being built up
+        std::vector<u8> compressedBlock; //!< Persistent storage for compressing blocks to avoid reallocating it for every block
+
+        /**
+         * @brief Writes the supplied data to the capture file, closing it on failure
+         */
+        void Write(span<const u8> data);
+
+        /**
+         * @brief Compresses the current block and writes it to the capture file
+         */
+        void FlushBlock();
+
+      public:
+        /**
+         * @param path The path of the capture file, the file will be overwritten if it already exists
+         */
+        GpfifoCapture(const std::string &path, u64 titleId);
+
+        ~GpfifoCapture();
+
+        /**
+         * @brief Records a processed GpEntry and its pushbuffer into the capture
+         * @param pushBuffer The contents of the pushbuffer referenced by the entry, this is empty for control entries
+         */
+        void Record(GpEntry entry, span<const u32> pushBuffer);
+    };
+}
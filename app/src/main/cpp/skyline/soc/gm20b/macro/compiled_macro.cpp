@@ -0,0 +1,275 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <common/trace.h>
+#include "soc/gm20b/engines/engine.h"
+#include "compiled_macro.h"
+
+namespace skyline::soc::gm20b::engine {
+    template<CompiledMacro::Opcode::AssignmentOperation Assignment>
+    __attribute__((always_inline)) void CompiledMacro::Assign(State &state, const Instruction &instruction, u32 result) {
+        using AssignmentOperation = Opcode::AssignmentOperation;
+
+        auto send{[&state](u32 argument) {
+            state.engine->CallMethodFromMacro(state.methodAddress.address, argument);
+            state.methodAddress.address += state.methodAddress.increment;
+        }};
+
+        if constexpr (Assignment == AssignmentOperation::IgnoreAndFetch) {
+            state.registers[instruction.dest] = *state.argument++;
+        } else if constexpr (Assignment == AssignmentOperation::Move) {
+            state.registers[instruction.dest] = result;
+        } else if constexpr (Assignment == AssignmentOperation::MoveAndSetMethod) {
+            state.registers[instruction.dest] = result;
+            state.methodAddress.raw = result;
+        } else if constexpr (Assignment == AssignmentOperation::FetchAndSend) {
+            state.registers[instruction.dest] = *state.argument++;
+            send(result);
+        } else if constexpr (Assignment == AssignmentOperation::MoveAndSend) {
+            state.registers[instruction.dest] = result;
+            send(result);
+        } else if constexpr (Assignment == AssignmentOperation::FetchAndSetMethod) {
+            state.registers[instruction.dest] = *state.argument++;
+            state.methodAddress.raw = result;
+        } else if constexpr (Assignment == AssignmentOperation::MoveAndSetMethodThenFetchAndSend) {
+            state.registers[instruction.dest] = result;
+            state.methodAddress.raw = result;
+            send(*state.argument++);
+        } else if constexpr (Assignment == AssignmentOperation::MoveAndSetMethodThenSendHigh) {
+            state.registers[instruction.dest] = result;
+            state.methodAddress.raw = result;
+            send(state.methodAddress.increment);
+        }
+    }
+
+    template<CompiledMacro::Opcode::AluOperation Operation>
+    __attribute__((always_inline)) u32 CompiledMacro::Alu(State &state, u32 srcA, u32 srcB) {
+        using AluOperation = Opcode::AluOperation;
+
+        if constexpr (Operation == AluOperation::Add) {
+            u64 result{static_cast<u64>(srcA) + srcB};
+            state.carryFlag = result >> 32;
+            return static_cast<u32>(result);
+        } else if constexpr (Operation == AluOperation::AddWithCarry) {
+            u64 result{static_cast<u64>(srcA) + srcB + state.carryFlag};
+            state.carryFlag = result >> 32;
+            return static_cast<u32>(result);
+        } else if constexpr (Operation == AluOperation::Subtract) {
+            u64 result{static_cast<u64>(srcA) - srcB};
+            state.carryFlag = result & 0xFFFFFFFF;
+            return static_cast<u32>(result);
+        } else if constexpr (Operation == AluOperation::SubtractWithBorrow) {
+            u64 result{static_cast<u64>(srcA) - srcB - !state.carryFlag};
+            state.carryFlag = result & 0xFFFFFFFF;
+            return static_cast<u32>(result);
+        } else if constexpr (Operation == AluOperation::BitwiseXor) {
+            return srcA ^ srcB;
+        } else if constexpr (Operation == AluOperation::BitwiseOr) {
+            return srcA | srcB;
+        } else if constexpr (Operation == AluOperation::BitwiseAnd) {
+            return srcA & srcB;
+        } else if constexpr (Operation == AluOperation::BitwiseAndNot) {
+            return srcA & ~srcB;
+        } else if constexpr (Operation == AluOperation::BitwiseNand) {
+            return ~(srcA & srcB);
+        }
+    }
+
+    template<CompiledMacro::Opcode::AluOperation Operation, CompiledMacro::Opcode::AssignmentOperation Assignment>
+    void CompiledMacro::HandleAlu(State &state, const Instruction &instruction) {
+        Assign<Assignment>(state, instruction, Alu<Operation>(state, state.registers[instruction.srcA], state.registers[instruction.srcB]));
+    }
+
+    template<CompiledMacro::Opcode::Operation Operation, CompiledMacro::Opcode::AssignmentOperation Assignment>
+    void CompiledMacro::HandleOperation(State &state, const Instruction &instruction) {
+        using Op = Opcode::Operation;
+
+        u32 srcA{state.registers[instruction.srcA]}, srcB{state.registers[instruction.srcB]};
+        u32 result;
+        if constexpr (Operation == Op::AddImmediate)
+            result = static_cast<u32>(static_cast<i32>(srcA) + instruction.immediate);
+        else if constexpr (Operation == Op::BitfieldReplace)
+            result = (srcA & ~(instruction.mask << instruction.destBit)) | (((srcB >> instruction.srcBit) & instruction.mask) << instruction.destBit);
+        else if constexpr (Operation == Op::BitfieldExtractShiftLeftImmediate)
+            result = ((srcB >> srcA) & instruction.mask) << instruction.destBit;
+        else if constexpr (Operation == Op::BitfieldExtractShiftLeftRegister)
+            result = ((srcB >> instruction.srcBit) & instruction.mask) << srcA;
+        else if constexpr (Operation == Op::ReadImmediate)
+            result = state.engine->ReadMethodFromMacro(static_cast<u32>(static_cast<i32>(srcA) + instruction.immediate));
+
+        Assign<Assignment>(state, instruction, result);
+    }
+
+    template<CompiledMacro::Opcode::AluOperation Operation, size_t... Assignments>
+    constexpr std::array<CompiledMacro::Handler, sizeof...(Assignments)> CompiledMacro::MakeAluTable(std::index_sequence<Assignments...>) {
+        return {&HandleAlu<Operation, static_cast<Opcode::AssignmentOperation>(Assignments)>...};
+    }
+
+    template<CompiledMacro::Opcode::Operation Operation, size_t... Assignments>
+    constexpr std::array<CompiledMacro::Handler, sizeof...(Assignments)> CompiledMacro::MakeOperationTable(std::index_sequence<Assignments...>) {
+        return {&HandleOperation<Operation, static_cast<Opcode::AssignmentOperation>(Assignments)>...};
+    }
+
+    CompiledMacro::Handler CompiledMacro::GetHandler(Opcode opcode) {
+        using Op = Opcode::Operation;
+        using AluOperation = Opcode::AluOperation;
+        constexpr auto Assignments{std::make_index_sequence<8>{}}; //!< All assignment operations, these are encoded in 3 bits
+
+        #define ALU_TABLE(operation) case AluOperation::operation: { \
+                static constexpr auto table{MakeAluTable<AluOperation::operation>(Assignments)}; \
+                return table[static_cast<u8>(opcode.assignmentOperation)]; \
+            }
+        #define OPERATION_TABLE(operation) case Op::operation: { \
+                static constexpr auto table{MakeOperationTable<Op::operation>(Assignments)}; \
+                return table[static_cast<u8>(opcode.assignmentOperation)]; \
+            }
+
+        switch (opcode.operation) {
+            case Op::AluRegister:
+                switch (opcode.aluOperation) {
+                    ALU_TABLE(Add)
+                    ALU_TABLE(AddWithCarry)
+                    ALU_TABLE(Subtract)
+                    ALU_TABLE(SubtractWithBorrow)
+                    ALU_TABLE(BitwiseXor)
+                    ALU_TABLE(BitwiseOr)
+                    ALU_TABLE(BitwiseAnd)
+                    ALU_TABLE(BitwiseAndNot)
+                    ALU_TABLE(BitwiseNand)
+                    default:
+                        return nullptr; // The interpreter returns an undefined value for these, so we leave them to it
+                }
+
+            OPERATION_TABLE(AddImmediate)
+            OPERATION_TABLE(BitfieldReplace)
+            OPERATION_TABLE(BitfieldExtractShiftLeftImmediate)
+            OPERATION_TABLE(BitfieldExtractShiftLeftRegister)
+            OPERATION_TABLE(ReadImmediate)
+
+            default:
+                return nullptr;
+        }
+
+        #undef ALU_TABLE
+        #undef OPERATION_TABLE
+    }
+
+    std::optional<CompiledMacro> CompiledMacro::Compile(span<u32> macroCode, size_t offset) {
+        TRACE_EVENT("soc", "CompiledMacro::Compile");
+
+        enum class Reachability : u8 {
+            None,
+            DelaySlot, //!< The instruction is only executed in the delay slot of an exit, so the following instruction isn't reachable from it
+            Full,
+        };
+
+        // Find all reachable instructions by following the control flow from the entry, this avoids decoding any unrelated data following the macro
+        std::vector<Reachability> reachability(macroCode.size());
+        std::vector<std::pair<size_t, Reachability>> worklist{{offset, Reachability::Full}};
+        size_t lowest{offset}, highest{offset};
+        auto pushDelaySlot{[&](size_t index) {
+            // The interpreter throws on branches in delay slots, this is checked for every delay slot regardless of if the instruction is otherwise reachable
+            if (index >= macroCode.size() || Opcode{.raw = macroCode[index]}.operation == Opcode::Operation::Branch)
+                return false;
+            worklist.emplace_back(index, Reachability::DelaySlot);
+            return true;
+        }};
+        while (!worklist.empty()) {
+            auto [index, kind]{worklist.back()};
+            worklist.pop_back();
+
+            if (index >= macroCode.size())
+                return std::nullopt;
+            if (reachability[index] >= kind)
+                continue;
+            reachability[index] = kind;
+            lowest = std::min(lowest, index);
+            highest = std::max(highest, index);
+
+            Opcode opcode{.raw = macroCode[index]};
+            if (opcode.operation == Opcode::Operation::Branch) {
+                auto target{static_cast<i64>(index) + opcode.immediate};
+                if (target < 0)
+                    return std::nullopt;
+
+                worklist.emplace_back(static_cast<size_t>(target), Reachability::Full);
+                if (!opcode.noDelay && !pushDelaySlot(index + 1))
+                    return std::nullopt;
+            } else if (!GetHandler(opcode)) {
+                return std::nullopt;
+            }
+
+            // Exits apply to both instructions and branches that aren't taken, the delay slot of an exit is the final instruction executed
+            if (kind == Reachability::Full) {
+                if (!opcode.exit)
+                    worklist.emplace_back(index + 1, Reachability::Full);
+                else if (!pushDelaySlot(index + 1))
+                    return std::nullopt;
+            }
+        }
+
+        CompiledMacro macro;
+        macro.entry = static_cast<u32>(offset - lowest);
+        macro.instructions.resize(highest - lowest + 1);
+        for (size_t index{lowest}; index <= highest; index++) {
+            if (reachability[index] == Reachability::None)
+                continue;
+
+            Opcode opcode{.raw = macroCode[index]};
+            auto &instruction{macro.instructions[index - lowest]};
+            instruction = Instruction{
+                .dest = opcode.dest ? opcode.dest : DiscardRegister,
+                .srcA = opcode.srcA,
+                .srcB = opcode.srcB,
+                .srcBit = opcode.bitfield.srcBit,
+                .destBit = opcode.bitfield.destBit,
+                .exit = static_cast<bool>(opcode.exit),
+                .branchOnZero = opcode.branchCondition == Opcode::BranchCondition::Zero,
+                .noDelay = opcode.noDelay,
+                .immediate = opcode.immediate,
+                .mask = opcode.bitfield.GetMask(),
+            };
+
+            if (opcode.operation == Opcode::Operation::Branch)
+                instruction.target = static_cast<u32>(static_cast<i64>(index) + opcode.immediate - static_cast<i64>(lowest));
+            else
+                instruction.handler = GetHandler(opcode);
+        }
+
+        return macro;
+    }
+
+    void CompiledMacro::Execute(span<u32> args, MacroEngineBase *targetEngine) const {
+        State state{
+            .engine = targetEngine,
+            .argument = args.data(),
+        };
+
+        // The first argument is stored in register 1
+        state.registers[1] = *state.argument++;
+
+        const Instruction *instruction{&instructions[entry]};
+        while (true) {
+            if (!instruction->handler) {
+                u32 value{state.registers[instruction->srcA]};
+                if ((value == 0) == instruction->branchOnZero) {
+                    const Instruction *target{&instructions[instruction->target]};
+                    if (!instruction->noDelay)
+                        (instruction + 1)->handler(state, *(instruction + 1)); // Branches in delay slots are rejected during translation
+
+                    instruction = target;
+                    continue;
+                }
+            } else {
+                instruction->handler(state, *instruction);
+            }
+
+            if (instruction->exit) {
+                (instruction + 1)->handler(state, *(instruction + 1));
+                return;
+            }
+
+            instruction++;
+        }
+    }
+}
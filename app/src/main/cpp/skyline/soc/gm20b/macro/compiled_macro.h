@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include "macro_interpreter.h"
+
+namespace skyline::soc::gm20b::engine {
+    /**
+     * @brief A macro that has been translated ahead of time into a program of pre-decoded instructions, each with a handler specialized for its operation
+     * @note Translation resolves all decoding, branch targets and delay slots once, so executing a macro only involves calling a handler per instruction
+     * @note Macros that can't be translated (unknown opcodes, out-of-bounds branches or branches in delay slots) **must** be executed by MacroInterpreter which handles them with its existing semantics
+     */
+    class CompiledMacro {
+      private:
+        using Opcode = MacroInterpreter::Opcode;
+        using MethodAddress = MacroInterpreter::MethodAddress;
+
+        static constexpr u8 DiscardRegister{8}; //!< Writes to register 0 are redirected to this register at translation time, so they don't need to be checked for during execution
+
+        /**
+         * @brief The state of a single execution of a macro
+         */
+        struct State {
+            MacroEngineBase *engine;
+            std::array<u32, 9> registers{}; //!< The state of all the general-purpose registers alongside the discard register
+            const u32 *argument;
+            MethodAddress methodAddress{};
+            bool carryFlag{};
+        };
+
+        struct Instruction;
+
+        using Handler = void (*)(State &state, const Instruction &instruction);
+
+        /**
+         * @brief A single pre-decoded macro instruction
+         */
+        struct Instruction {
+            Handler handler{}; //!< The handler for the instruction, this is nullptr for branches which are handled by the execution loop
+            u8 dest;
+            u8 srcA;
+            u8 srcB;
+            u8 srcBit;
+            u8 destBit;
+            bool exit; //!< If the macro exits after the delay slot of this instruction
+            bool branchOnZero;
+            bool noDelay;
+            i32 immediate;
+            u32 mask; //!< The mask of the bitfield in the instruction
+            u32 target; //!< The index of the instruction branched to
+        };
+
+        std::vector<Instruction> instructions; //!< All instructions spanning from the lowest to the highest reachable instruction in macro memory
+        u32 entry; //!< The index of the instruction the macro starts at
+
+        template<Opcode::AssignmentOperation Assignment>
+        static void Assign(State &state, const Instruction &instruction, u32 result);
+
+        template<Opcode::AluOperation Operation>
+        static u32 Alu(State &state, u32 srcA, u32 srcB);
+
+        template<Opcode::AluOperation Operation, Opcode::AssignmentOperation Assignment>
+        static void HandleAlu(State &state, const Instruction &instruction);
+
+        template<Opcode::Operation Operation, Opcode::AssignmentOperation Assignment>
+        static void HandleOperation(State &state, const Instruction &instruction);
+
+        template<Opcode::AluOperation Operation, size_t... Assignments>
+        static constexpr std::array<Handler, sizeof...(Assignments)> MakeAluTable(std::index_sequence<Assignments...>);
+
+        template<Opcode::Operation Operation, size_t... Assignments>
+        static constexpr std::array<Handler, sizeof...(Assignments)> MakeOperationTable(std::index_sequence<Assignments...>);
+
+        /**
+         * @return The handler for the supplied non-branch opcode, this is nullptr if the opcode is invalid
+         */
+        static Handler GetHandler(Opcode opcode);
+
+        CompiledMacro() = default;
+
+      public:
+        /**
+         * @brief Translates the macro starting at the supplied offset in macro memory
+         * @return The translated macro, or std::nullopt if the macro can't be translated
+         */
+        static std::optional<CompiledMacro> Compile(span<u32> macroCode, size_t offset);
+
+        /**
+         * @brief Executes the macro with the given arguments targeting the specified engine
+         */
+        void Execute(span<u32> args, MacroEngineBase *targetEngine) const;
+    };
+}
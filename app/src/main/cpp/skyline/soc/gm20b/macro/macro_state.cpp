@@ -7,78 +7,172 @@
 
 namespace skyline::soc::gm20b {
     namespace macro_hle {
-        void DrawInstanced(size_t offset, span<u32> args, engine::MacroEngineBase *targetEngine) {
+        void DrawInstanced(size_t offset, span<u32> args, span<u32 *> argumentPtrs, engine::MacroEngineBase *targetEngine) {
             u32 instanceCount{targetEngine->ReadMethodFromMacro(0xD1B) & args[2]};
 
             targetEngine->DrawInstanced(true, args[0], args[1], instanceCount, args[3], args[4]);
         }
 
-        void DrawIndexedInstanced(size_t offset, span<u32> args, engine::MacroEngineBase *targetEngine) {
+        void DrawIndexedInstanced(size_t offset, span<u32> args, span<u32 *> argumentPtrs, engine::MacroEngineBase *targetEngine) {
             u32 instanceCount{targetEngine->ReadMethodFromMacro(0xD1B) & args[2]};
 
             targetEngine->DrawIndexedInstanced(true, args[0], args[1], instanceCount, args[3], args[4], args[5]);
         }
 
-        void DrawInstancedIndexedWithConstantBuffer(size_t offset, span<u32> args, engine::MacroEngineBase *targetEngine) {
-            // Writes globalBaseVertexIndex and globalBaseInstanceIndex to the bound constant buffer before performing a standard instanced indexed draw
-            u32 instanceCount{targetEngine->ReadMethodFromMacro(0xD1B) & args[2]};
+        /**
+         * @return A pointer to the supplied arguments in guest memory if they were all read contiguously from it, otherwise nullptr
+         */
+        static u32 *GetContiguousArguments(span<u32 *> argumentPtrs) {
+            if (argumentPtrs.empty() || !argumentPtrs.front())
+                return nullptr;
+
+            for (size_t i{1}; i < argumentPtrs.size(); i++)
+                if (argumentPtrs[i] != argumentPtrs.front() + i)
+                    return nullptr;
+
+            return argumentPtrs.front();
+        }
+
+        void DrawIndirect(size_t offset, span<u32> args, span<u32 *> argumentPtrs, engine::MacroEngineBase *targetEngine) {
+            // The instanced draw macro is also used for indirect draws by calling it with arguments sourced from an indirect buffer, the arguments following the topology are laid out as VkDrawIndirectCommand
+            // If they were read directly from guest memory that the GPU wrote to, the values read on the CPU may be stale so the host GPU consumes them from there instead
+            // The instance count is masked on the CPU, so this is only possible when the mask has no effect
+            constexpr size_t CommandWords{4}; //!< The size of VkDrawIndirectCommand in words
+            u32 instanceCountMask{targetEngine->ReadMethodFromMacro(0xD1B)};
+            if (u32 *command{GetContiguousArguments(argumentPtrs.subspan(1, CommandWords))}; command && instanceCountMask == std::numeric_limits<u32>::max())
+                if (targetEngine->DrawIndirect(args[0], span(command, CommandWords).cast<u8>(), 1, CommandWords * sizeof(u32)))
+                    return;
+
+            DrawInstanced(offset, args, argumentPtrs, targetEngine);
+        }
+
+        void DrawIndexedIndirect(size_t offset, span<u32> args, span<u32 *> argumentPtrs, engine::MacroEngineBase *targetEngine) {
+            // The instanced indexed draw macro which writes globalBaseVertexIndex and globalBaseInstanceIndex to the bound constant buffer is also used for indirect draws, the arguments following the topology are laid out as VkDrawIndexedIndirectCommand, see DrawIndirect
+            // The constant buffer is always written from the arguments read on the CPU as it can't be updated from the indirect buffer on the host GPU
+            constexpr size_t CommandWords{5}; //!< The size of VkDrawIndexedIndirectCommand in words
+            u32 instanceCountMask{targetEngine->ReadMethodFromMacro(0xD1B)};
             targetEngine->CallMethodFromMacro(0x8e3, 0x640);
             targetEngine->CallMethodFromMacro(0x8e4, args[4]);
             targetEngine->CallMethodFromMacro(0x8e5, args[5]);
-            targetEngine->DrawIndexedInstanced(false, args[0], args[1], instanceCount, args[4], args[3], args[5]);
+
+            u32 *command{GetContiguousArguments(argumentPtrs.subspan(1, CommandWords))};
+            if (!command || instanceCountMask != std::numeric_limits<u32>::max() || !targetEngine->DrawIndexedIndirect(args[0], span(command, CommandWords).cast<u8>(), 1, CommandWords * sizeof(u32)))
+                targetEngine->DrawIndexedInstanced(false, args[0], args[1], instanceCountMask & args[2], args[4], args[3], args[5]);
+
             targetEngine->CallMethodFromMacro(0x8e3, 0x640);
             targetEngine->CallMethodFromMacro(0x8e4, 0x0);
             targetEngine->CallMethodFromMacro(0x8e5, 0x0);
         }
 
-        struct HleFunctionInfo {
-            Function function;
-            u64 size;
-            u32 hash;
+        /**
+         * @return A key for the supplied signature of a macro, this is unique for every combination of size and hash
+         */
+        static constexpr u64 MakeKey(size_t size, u32 hash) {
+            return (static_cast<u64>(size) << 32) | hash;
+        }
+
+        /**
+         * @brief The HLE functions keyed by the size and XXH32 hash of the macros they replace
+         * @note New entries should be added with the signatures reported for unrecognised macros by MacroState::ReportUnrecognisedMacros
+         * @note The draw macros with arguments laid out as Vulkan indirect commands are handled as indirect draws, these fall back to regular draws when the arguments weren't written by the GPU
+         */
+        static const std::unordered_map<u64, Function> functions{
+            {MakeKey(0x12, 0x6F0DD310), DrawIndirect},
+            {MakeKey(0x17, 0x2764C4F), DrawIndexedInstanced},
+            {MakeKey(0x1F, 0xF2F16988), DrawIndexedIndirect},
         };
 
-        constexpr std::array<HleFunctionInfo, 0x3> functions{{
-            {DrawInstanced, 0x12, 0x6F0DD310},
-            {DrawIndexedInstanced, 0x17, 0x2764C4F},
-            {DrawInstancedIndexedWithConstantBuffer, 0x1F, 0xF2F16988},
-        }};
+        /**
+         * @brief All distinct sizes of macros in the HLE function table in ascending order, a macro is hashed once for each of these
+         */
+        static const std::vector<size_t> functionSizes{[] {
+            std::vector<size_t> sizes;
+            for (const auto &[key, function] : functions)
+                sizes.push_back(static_cast<size_t>(key >> 32));
+            std::sort(sizes.begin(), sizes.end());
+            sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+            return sizes;
+        }()};
 
         static Function LookupFunction(span<u32> code) {
-            for (const auto &function : functions) {
-                if (function.size > code.size())
-                    continue;
-
-                auto macro{code.subspan(0, function.size)};
+            for (size_t size : functionSizes) {
+                if (size > code.size())
+                    break;
 
-                if (XXH32(code.data(), code.size_bytes(), 0) == function.hash)
-                    return function.function;
+                auto macro{code.first(size)};
+                if (auto it{functions.find(MakeKey(size, XXH32(macro.data(), macro.size_bytes(), 0)))}; it != functions.end())
+                    return it->second;
             }
 
             return {};
         }
+
+        /**
+         * @return The size of the macro starting at the beginning of the supplied code, this is determined by the first exit and its delay slot
+         * @note This is only an approximation as control flow isn't followed, it's only used for identifying unrecognised macros
+         */
+        static size_t GetMacroSize(span<u32> code) {
+            constexpr u32 ExitMask{1 << 7}; //!< The mask of the exit flag in an opcode
+            for (size_t index{}; index < code.size(); index++)
+                if (code[index] & ExitMask)
+                    return std::min(index + 2, code.size());
+            return code.size();
+        }
+    }
+
+    void MacroState::ReportUnrecognisedMacros() {
+        std::vector<std::pair<u64, u64>> sortedMacros{unrecognisedMacros.begin(), unrecognisedMacros.end()};
+        std::sort(sortedMacros.begin(), sortedMacros.end(), [](const auto &a, const auto &b) { return a.second > b.second; });
+
+        constexpr size_t ReportedMacroCount{5}; //!< The amount of most frequently executed macros that are reported
+        for (const auto &[key, count] : span(sortedMacros).first(std::min(sortedMacros.size(), ReportedMacroCount)))
+            Logger::Debug("Unrecognised macro with size 0x{:X} and hash 0x{:X} executed {} times", key >> 32, static_cast<u32>(key), count);
     }
 
     void MacroState::Invalidate() {
         invalidatePending = true;
     }
 
-    void MacroState::Execute(u32 position, span<u32> args, engine::MacroEngineBase *targetEngine) {
+    void MacroState::Execute(u32 position, span<u32> args, span<u32 *> argumentPtrs, engine::MacroEngineBase *targetEngine) {
         size_t offset{macroPositions[position]};
 
         if (invalidatePending) {
             macroHleFunctions.fill({});
+            for (auto &entry : compiledMacros)
+                entry = {};
             invalidatePending = false;
         }
 
         auto &hleEntry{macroHleFunctions[position]};
 
         if (!hleEntry.valid) {
-            hleEntry.function = macro_hle::LookupFunction(span(macroCode).subspan(offset));
+            auto code{span(macroCode).subspan(offset)};
+            hleEntry.function = macro_hle::LookupFunction(code);
+            if (!hleEntry.function) {
+                // References to values in an unordered_map are stable, so the counter can be incremented directly on every execution
+                auto macro{code.first(macro_hle::GetMacroSize(code))};
+                hleEntry.unrecognisedExecutionCount = &unrecognisedMacros[macro_hle::MakeKey(macro.size(), XXH32(macro.data(), macro.size_bytes(), 0))];
+            }
             hleEntry.valid = true;
         }
 
-        if (macroHleFunctions[position].function)
-            macroHleFunctions[position].function(offset, args, targetEngine);
+        if (hleEntry.function) {
+            hleEntry.function(offset, args, argumentPtrs, targetEngine);
+            return;
+        }
+
+        (*hleEntry.unrecognisedExecutionCount)++;
+        if (++unrecognisedExecutionCount % UnrecognisedReportInterval == 0)
+            ReportUnrecognisedMacros();
+
+        auto &compiledEntry{compiledMacros[position]};
+        if (!compiledEntry.valid) {
+            compiledEntry.macro = engine::CompiledMacro::Compile(macroCode, offset);
+            compiledEntry.valid = true;
+        }
+
+        if (compiledEntry.macro)
+            compiledEntry.macro->Execute(args, targetEngine);
         else
             macroInterpreter.Execute(offset, args, targetEngine);
     }
@@ -5,10 +5,11 @@
 
 #include <common.h>
 #include "macro_interpreter.h"
+#include "compiled_macro.h"
 
 namespace skyline::soc::gm20b {
     namespace macro_hle {
-        using Function = void (*)(size_t offset, span<u32> args, engine::MacroEngineBase *targetEngine);
+        using Function = void (*)(size_t offset, span<u32> args, span<u32 *> argumentPtrs, engine::MacroEngineBase *targetEngine);
     }
 
     /**
@@ -17,6 +18,12 @@ namespace skyline::soc::gm20b {
     struct MacroState {
         struct MacroHleEntry {
             macro_hle::Function function;
+            u64 *unrecognisedExecutionCount; //!< The execution count of the macro in unrecognisedMacros, this is only set if there's no HLE function for the macro
+            bool valid;
+        };
+
+        struct CompiledMacroEntry {
+            std::optional<engine::CompiledMacro> macro; //!< The translated macro, this is std::nullopt if the macro couldn't be translated and must be interpreted
             bool valid;
         };
 
@@ -24,12 +31,26 @@ namespace skyline::soc::gm20b {
         std::array<u32, 0x2000> macroCode{}; //!< Stores GPU macros, writes to it will wraparound on overflow
         std::array<size_t, 0x80> macroPositions{}; //!< The positions of each individual macro in macro code memory, there can be a maximum of 0x80 macros at any one time
         std::array<MacroHleEntry, 0x80> macroHleFunctions{}; //!< The HLE functions for each macro position, used to optionally override the interpreter
+        std::array<CompiledMacroEntry, 0x80> compiledMacros{}; //!< The translated macros for each macro position, these are used in place of the interpreter for any macros without an HLE function
         bool invalidatePending{};
 
+        static constexpr u64 UnrecognisedReportInterval{1 << 16}; //!< The amount of executions of unrecognised macros between each report of the most frequently executed ones
+        u64 unrecognisedExecutionCount{}; //!< The total amount of executions of unrecognised macros
+        std::unordered_map<u64, u64> unrecognisedMacros; //!< The amount of executions of each unrecognised macro keyed by its size and hash, this persists across macro uploads
+
+        /**
+         * @brief Logs the most frequently executed unrecognised macros
+         * @note This is used to determine which macros are worth implementing HLE functions for
+         */
+        void ReportUnrecognisedMacros();
+
         MacroState() : macroInterpreter(macroCode) {}
 
         void Invalidate();
 
-        void Execute(u32 position, span<u32> args, engine::MacroEngineBase *targetEngine);
+        /**
+         * @param argumentPtrs Pointers to each argument in guest memory (or nullptr), these are only used by HLE functions which consume arguments directly on the host GPU
+         */
+        void Execute(u32 position, span<u32> args, span<u32 *> argumentPtrs, engine::MacroEngineBase *targetEngine);
     };
 }
@@ -2,6 +2,7 @@
 // Copyright © 2021 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
 #include <common/signal.h>
+#include <common/thread_role.h>
 #include <nce.h>
 #include <loader/loader.h>
 #include <kernel/types/KProcess.h>
@@ -116,6 +117,7 @@ namespace skyline::soc::host1x {
     void ChannelCommandFifo::Run() {
         if (int result{pthread_setname_np(pthread_self(), "ChannelCmdFifo")})
             Logger::Warn("Failed to set the thread name: {}", strerror(result));
+        thread_role::Apply(thread_role::Role::Helper);
 
         try {
             signal::SetSignalHandler({SIGINT, SIGILL, SIGTRAP, SIGBUS, SIGFPE}, signal::ExceptionalSignalHandler);
@@ -2,9 +2,19 @@
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 // Copyright © 2020 Ryujinx Team and Contributors (https://github.com/Ryujinx/)
 
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <boost/container/small_vector.hpp>
 #include "syncpoint.h"
 
 namespace skyline::soc::host1x {
+    void Syncpoint::UpdateNextThresholdLocked() {
+        while (!waiterHeap.empty() && !waiterCallbacks.contains(waiterHeap.top().second))
+            waiterHeap.pop();
+        nextThreshold.store(waiterHeap.empty() ? std::numeric_limits<u32>::max() : waiterHeap.top().first, std::memory_order_seq_cst);
+    }
+
     Syncpoint::WaiterHandle Syncpoint::RegisterWaiter(u32 threshold, const std::function<void()> &callback) {
         if (value.load(std::memory_order_acquire) >= threshold) {
             // (Fast path) We don't need to wait on the mutex and can just get away with atomics
@@ -12,71 +22,105 @@ namespace skyline::soc::host1x {
             return {};
         }
 
-        std::scoped_lock lock(mutex);
-        if (value.load(std::memory_order_acquire) >= threshold) {
-            callback();
-            return {};
+        std::unique_lock lock(mutex);
+        auto id{nextWaiterId++};
+        waiterCallbacks.emplace(id, callback);
+        waiterHeap.emplace(threshold, id);
+        UpdateNextThresholdLocked();
+
+        // An increment which loaded nextThreshold prior to it being lowered above won't dispatch this waiter, the value is rechecked after publishing the threshold to cover that
+        if (value.load(std::memory_order_seq_cst) >= threshold) {
+            if (waiterCallbacks.erase(id)) {
+                UpdateNextThresholdLocked();
+                lock.unlock();
+                callback();
+                return {};
+            }
         }
 
-        auto it{waiters.begin()};
-        while (it != waiters.end() && threshold >= it->threshold)
-            it++;
-        return waiters.emplace(it, threshold, callback);
+        return id;
     }
 
     void Syncpoint::DeregisterWaiter(WaiterHandle waiter) {
-        std::scoped_lock lock(mutex);
-        // We want to ensure the iterator still exists prior to erasing it
-        // Otherwise, if an invalid iterator was passed in then it could lead to UB
-        // It is important to avoid UB in that case since the deregister isn't called from a locked context
-        for (auto it{waiters.begin()}; it != waiters.end(); it++) {
-            if (it == waiter) {
-                waiters.erase(it);
+        if (!waiter)
+            return;
+
+        {
+            std::scoped_lock lock(mutex);
+            if (waiterCallbacks.erase(waiter)) {
+                UpdateNextThresholdLocked();
                 return;
             }
         }
+
+        // The waiter has already been dispatched, its callback may still be running outside the mutex
+        while (activeDispatches.load(std::memory_order_acquire))
+            std::this_thread::yield();
     }
 
     u32 Syncpoint::Increment() {
-        auto readValue{value.fetch_add(1, std::memory_order_acq_rel) + 1}; // We don't want to constantly do redundant atomic loads
-
-        std::scoped_lock lock(mutex);
-        bool signalCondition{};
-        auto it{waiters.begin()};
-        while (it != waiters.end() && readValue >= it->threshold) {
-            auto &waiter{*it};
-            if (waiter.callback)
-                waiter.callback();
-            else
-                signalCondition = true;
-            it++;
-        }
+        auto readValue{value.fetch_add(1, std::memory_order_seq_cst) + 1}; // We don't want to constantly do redundant atomic loads
+
+        if (sleepers.load(std::memory_order_seq_cst))
+            syscall(SYS_futex, reinterpret_cast<u32 *>(&value), FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr, nullptr, 0);
 
-        waiters.erase(waiters.begin(), it);
+        if (readValue < nextThreshold.load(std::memory_order_seq_cst))
+            return readValue;
 
-        if (signalCondition)
-            incrementCondition.notify_all();
+        boost::container::small_vector<std::function<void()>, 4> callbacks;
+        {
+            std::scoped_lock lock(mutex);
+            while (!waiterHeap.empty() && readValue >= waiterHeap.top().first) {
+                auto it{waiterCallbacks.find(waiterHeap.top().second)};
+                if (it != waiterCallbacks.end()) {
+                    callbacks.emplace_back(std::move(it->second));
+                    waiterCallbacks.erase(it);
+                }
+                waiterHeap.pop();
+            }
+            UpdateNextThresholdLocked();
+
+            if (!callbacks.empty())
+                activeDispatches.fetch_add(1, std::memory_order_relaxed); // This is done under the mutex so a deregistration that didn't find its waiter always observes it
+        }
+
+        if (!callbacks.empty()) {
+            for (auto &callback : callbacks)
+                callback();
+            activeDispatches.fetch_sub(1, std::memory_order_release);
+        }
 
         return readValue;
     }
 
     bool Syncpoint::Wait(u32 threshold, std::chrono::steady_clock::duration timeout) {
-        if (value.load(std::memory_order_acquire) >= threshold)
-            // (Fast Path) We don't need to wait on the mutex and can just get away with atomics
-            return {};
+        u32 current{value.load(std::memory_order_acquire)};
+        if (current >= threshold)
+            // (Fast Path) We don't need to wait on the futex and can just get away with atomics
+            return true;
 
-        std::unique_lock lock(mutex);
-        auto it{waiters.begin()};
-        while (it != waiters.end() && threshold >= it->threshold)
-            it++;
-        waiters.emplace(it, threshold, nullptr);
+        bool infinite{timeout == std::chrono::steady_clock::duration::max()};
+        auto deadline{infinite ? std::chrono::steady_clock::time_point::max() : std::chrono::steady_clock::now() + timeout};
+        while (current < threshold) {
+            std::optional<timespec> time;
+            if (!infinite) {
+                auto remaining{std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - std::chrono::steady_clock::now()).count()};
+                if (remaining <= 0)
+                    return false;
+                time = timespec{
+                    .tv_sec = static_cast<time_t>(remaining / constant::NsInSecond),
+                    .tv_nsec = static_cast<long>(remaining % constant::NsInSecond),
+                };
+            }
 
-        if (timeout == std::chrono::steady_clock::duration::max()) {
-            incrementCondition.wait(lock, [&] { return value.load(std::memory_order_relaxed) >= threshold; });
-            return true;
-        } else {
-            return incrementCondition.wait_for(lock, timeout, [&] { return value.load(std::memory_order_relaxed) >= threshold; });
+            sleepers.fetch_add(1, std::memory_order_seq_cst);
+            if (value.load(std::memory_order_seq_cst) == current)
+                syscall(SYS_futex, reinterpret_cast<u32 *>(&value), FUTEX_WAIT_PRIVATE, current, time ? &*time : nullptr, nullptr, 0); // Spurious wakeups (EINTR), timeouts and value mismatches (EAGAIN) are handled by rechecking the value
+            sleepers.fetch_sub(1, std::memory_order_relaxed);
+
+            current = value.load(std::memory_order_acquire);
         }
+
+        return true;
     }
 }
-
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <queue>
+#include <unordered_map>
 #include <common.h>
 
 namespace skyline::soc::host1x {
@@ -11,21 +13,28 @@ namespace skyline::soc::host1x {
 
     /**
      * @brief The Syncpoint class represents a single syncpoint in the GPU which is used for GPU -> CPU synchronisation
+     * @note Blocking waits are done on a futex on the value itself, only callback waiters are tracked and they're kept in a min-heap of thresholds
+     * @note Increments only lock the mutex when a callback waiter's threshold has been reached, callbacks are always called without the mutex held
      */
     class Syncpoint {
       private:
-        std::atomic<u32> value{}; //!< An atomically-incrementing counter at the core of a syncpoint
+        std::atomic<u32> value{}; //!< An atomically-incrementing counter at the core of a syncpoint, this is also the futex word for blocking waits
+        std::atomic<u32> sleepers{}; //!< The amount of threads sleeping (or about to sleep) on the futex, increments only wake the futex when this is non-zero
+        std::atomic<u32> nextThreshold{std::numeric_limits<u32>::max()}; //!< The lowest threshold of any registered callback waiter, increments below this don't need to lock the mutex
+        std::atomic<u32> activeDispatches{}; //!< The amount of increments currently calling callbacks outside the mutex, deregistration waits for this to reach zero
 
-        std::mutex mutex; //!< Synchronizes insertions and deletions of waiters alongside locking the increment condition
-        std::condition_variable incrementCondition; //!< Signalled on thresholds for waiters which are tied to Wait(...)
+        std::mutex mutex; //!< Synchronizes insertions and deletions of callback waiters
 
-        struct Waiter {
-            u32 threshold; //!< The syncpoint value to wait on to be reached
-            std::function<void()> callback; //!< The callback to do after the wait has ended, refers to cvar signal when nullptr
+        using WaiterEntry = std::pair<u32, u64>; //!< A threshold and the ID of the waiter it belongs to
+        std::priority_queue<WaiterEntry, std::vector<WaiterEntry>, std::greater<>> waiterHeap; //!< A min-heap of waiter thresholds, entries of deregistered waiters are lazily removed when they reach the top
+        std::unordered_map<u64, std::function<void()>> waiterCallbacks; //!< The callbacks of all registered waiters keyed by their ID
+        u64 nextWaiterId{1};
 
-            Waiter(u32 threshold, std::function<void()> callback) : threshold(threshold), callback(std::move(callback)) {}
-        };
-        std::list<Waiter> waiters; //!< A linked list of all waiters, it's sorted in ascending order by threshold
+        /**
+         * @brief Removes any deregistered waiters from the top of the heap and updates nextThreshold to the new top
+         * @note The mutex **must** be locked when calling this
+         */
+        void UpdateNextThresholdLocked();
 
       public:
         /**
@@ -35,7 +44,7 @@ namespace skyline::soc::host1x {
             return value.load(std::memory_order_acquire);
         }
 
-        using WaiterHandle = decltype(waiters)::iterator; //!< Aliasing an iterator to a Waiter as an opaque handle
+        using WaiterHandle = u64; //!< An opaque handle to a registered waiter, 0 is an invalid handle
 
         /**
          * @brief Registers a new waiter with a callback that will be called when the syncpoint reaches the target threshold
@@ -46,6 +55,7 @@ namespace skyline::soc::host1x {
 
         /**
          * @note If the supplied handle is invalid then the function will do nothing
+         * @note If the callback of the waiter is being called concurrently, this will block till it has returned so the callback never runs after this returns
          */
         void DeregisterWaiter(WaiterHandle waiter);
 
@@ -18,6 +18,7 @@ namespace skyline::vfs {
     }
 
     size_t AndroidAssetBacking::ReadImpl(span<u8> output, size_t offset) {
+        std::scoped_lock lock{mutex};
         if (AAsset_seek64(asset, static_cast<off64_t>(offset), SEEK_SET) != offset)
             throw exception("Failed to seek asset position");
 
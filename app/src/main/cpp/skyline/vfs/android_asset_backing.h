@@ -10,12 +10,13 @@ struct AAsset; //!< https://developer.android.com/ndk/reference/group/asset#aass
 namespace skyline::vfs {
     /**
      * @brief The AndroidAssetBacking class provides the backing abstractions for the AAsset Android API
-     * @note This is NOT thread safe NOR should it be shared across threads.
+     * @note Reads are serialized as the AAsset API tracks the read position in the asset itself
      * @note This will take ownership of the backing asset passed into it
      */
     class AndroidAssetBacking : public Backing {
       private:
         AAsset *asset; //!< The NDK AAsset object we abstract
+        std::mutex mutex; //!< Synchronizes seeking and reading the asset so they are atomic with respect to other reads
 
       protected:
         size_t ReadImpl(span<u8> output, size_t offset) override;
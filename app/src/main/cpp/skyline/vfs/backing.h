@@ -12,6 +12,9 @@ namespace skyline::vfs {
      */
     class Backing {
       protected:
+        /**
+         * @note This may be called concurrently from multiple threads, including for different regions of the same read
+         */
         virtual size_t ReadImpl(span <u8> output, size_t offset) = 0;
 
         virtual size_t WriteImpl(span <u8> input, size_t offset) {
@@ -128,7 +131,7 @@ namespace skyline::vfs {
         template<typename T>
         void WriteObject(const T &object, size_t offset = 0) {
             size_t lSize;
-            if ((lSize = Write(span(reinterpret_cast<u8 *>(&object), sizeof(T)), offset)) != sizeof(T))
+            if ((lSize = Write(span(reinterpret_cast<u8 *>(const_cast<T *>(&object)), sizeof(T)), offset)) != sizeof(T))
                 Logger::Warn("Object wasn't written fully into output backing: {}/{}", lSize, sizeof(T));
         }
 
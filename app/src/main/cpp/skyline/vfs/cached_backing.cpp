@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include <common/perf_stats.h>
+#include "cached_backing.h"
+
+namespace skyline::vfs {
+    CachedBacking::CachedBacking(std::shared_ptr<Backing> backing, size_t cacheSize) : Backing({true, false, false}, backing->size), backing(std::move(backing)), shardCapacity(std::max<size_t>(cacheSize / BlockSize / ShardCount, 1)) {}
+
+    bool CachedBacking::LookupBlock(size_t index, span<u8> output, size_t blockOffset) {
+        auto &shard{shards[index % ShardCount]};
+        std::scoped_lock lock{shard.mutex};
+        auto it{shard.blockMap.find(index)};
+        if (it == shard.blockMap.end())
+            return false;
+
+        shard.blocks.splice(shard.blocks.begin(), shard.blocks, it->second); // The iterator stays valid as splicing doesn't invalidate it
+        auto &data{it->second->data};
+        std::memcpy(output.data(), data.data() + blockOffset, output.size());
+        return true;
+    }
+
+    void CachedBacking::InsertBlock(size_t index, span<u8> data) {
+        auto &shard{shards[index % ShardCount]};
+        std::scoped_lock lock{shard.mutex};
+        if (shard.blockMap.contains(index))
+            return; // Another thread could've inserted the block while it was being read
+
+        if (shard.blocks.size() >= shardCapacity) {
+            // The least recently used block is recycled for the new block to avoid reallocating its buffer
+            auto last{std::prev(shard.blocks.end())};
+            shard.blockMap.erase(last->index);
+            shard.blocks.splice(shard.blocks.begin(), shard.blocks, last);
+        } else {
+            shard.blocks.emplace_front();
+        }
+
+        auto &block{shard.blocks.front()};
+        block.index = index;
+        block.data.assign(data.begin(), data.end());
+        shard.blockMap.emplace(index, shard.blocks.begin());
+    }
+
+    size_t CachedBacking::ReadImpl(span<u8> output, size_t offset) {
+        if (offset >= size)
+            return 0;
+        output = output.first(std::min(output.size(), size - offset));
+
+        size_t firstBlock{offset / BlockSize}, endBlock{util::DivideCeil(offset + output.size(), BlockSize)};
+        bool sequential{nextSequentialBlock.exchange(endBlock, std::memory_order_relaxed) == firstBlock};
+
+        if (output.size() >= BypassSize)
+            return backing->ReadUnchecked(output, offset);
+
+        std::vector<u8> readBuffer;
+        size_t position{};
+        for (size_t index{firstBlock}; index < endBlock;) {
+            size_t blockStart{index * BlockSize}, blockOffset{(offset + position) - blockStart};
+            size_t copySize{std::min(BlockSize - blockOffset, output.size() - position)};
+            if (LookupBlock(index, output.subspan(position, copySize), blockOffset)) {
+                PerfStats::Increment(PerfStats::Counter::BackingCacheHits);
+                position += copySize;
+                index++;
+                continue;
+            }
+
+            // On a miss, all blocks till the end of the read are read at once along with any read-ahead blocks for sequential reads
+            PerfStats::Increment(PerfStats::Counter::BackingCacheMisses);
+            size_t readEndBlock{std::min(sequential ? endBlock + ReadAheadBlockCount : endBlock, util::DivideCeil(size, BlockSize))};
+            size_t readSize{std::min(readEndBlock * BlockSize, size) - blockStart};
+            readBuffer.resize(readSize);
+            if (backing->ReadUnchecked(readBuffer, blockStart) != readSize)
+                return position;
+
+            for (size_t readIndex{index}; readIndex < readEndBlock; readIndex++) {
+                size_t readOffset{(readIndex - index) * BlockSize};
+                InsertBlock(readIndex, span<u8>{readBuffer}.subspan(readOffset, std::min(BlockSize, readSize - readOffset)));
+            }
+
+            std::memcpy(output.data() + position, readBuffer.data() + blockOffset, output.size() - position);
+            return output.size();
+        }
+
+        return output.size();
+    }
+}
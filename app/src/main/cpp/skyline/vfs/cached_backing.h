@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include "backing.h"
+
+namespace skyline::vfs {
+    /**
+     * @brief A read-only backing which caches fixed-size blocks of another backing in memory, this is used on top of backings which are expensive to read from such as CtrEncryptedBacking so cache hits skip decryption entirely
+     * @note The cache is sharded by block index with an LRU per shard, so concurrent reads of unrelated blocks don't contend on the same lock
+     * @note Sequential reads are detected and cause blocks past the end of the read to be read ahead into the cache in a single read on the underlying backing
+     */
+    class CachedBacking : public Backing {
+      public:
+        static constexpr size_t BlockSize{0x4000}; //!< The size of a single cached block, this is a multiple of the AES block size
+        static constexpr size_t DefaultCacheSize{0x2000000}; //!< The default total size of all cached blocks in bytes
+
+      private:
+        static constexpr size_t ShardCount{8};
+        static constexpr size_t ReadAheadBlockCount{8}; //!< The amount of blocks that are read ahead on a cache miss during sequential reads
+        static constexpr size_t BypassSize{BlockSize * 16}; //!< The size of reads after which they bypass the cache and are read from the underlying backing directly, these are generally streamed and would only evict hotter blocks
+
+        struct CachedBlock {
+            size_t index;
+            std::vector<u8> data;
+        };
+
+        struct Shard {
+            std::mutex mutex;
+            std::list<CachedBlock> blocks; //!< The cached blocks in the shard ordered from most to least recently used
+            std::unordered_map<size_t, std::list<CachedBlock>::iterator> blockMap; //!< A map from the index of a block to its entry in the LRU list
+        };
+
+        std::shared_ptr<Backing> backing;
+        size_t shardCapacity; //!< The maximum amount of blocks cached in a single shard
+        std::array<Shard, ShardCount> shards;
+        std::atomic<size_t> nextSequentialBlock{}; //!< The block index directly after the last read, this is used to detect sequential reads
+
+        /**
+         * @brief Copies a block out of the cache if it's cached
+         * @return If the block was cached
+         */
+        bool LookupBlock(size_t index, span<u8> output, size_t blockOffset);
+
+        /**
+         * @brief Inserts a block into the cache, evicting the least recently used block in its shard if the shard is full
+         */
+        void InsertBlock(size_t index, span<u8> data);
+
+      protected:
+        size_t ReadImpl(span<u8> output, size_t offset) override;
+
+      public:
+        /**
+         * @param cacheSize The maximum total size of all cached blocks in bytes
+         */
+        CachedBacking(std::shared_ptr<Backing> backing, size_t cacheSize = DefaultCacheSize);
+    };
+}
@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#include "integrity_backing.h"
+
+namespace skyline::vfs {
+    IntegrityBacking::IntegrityBacking(std::shared_ptr<Backing> pBacking, std::shared_ptr<Backing> hashBacking, size_t blockSize, bool padLastBlock)
+        : Backing({true, false, false}, pBacking->size),
+          backing(std::move(pBacking)),
+          hashBacking(std::move(hashBacking)),
+          blockSize(blockSize),
+          padLastBlock(padLastBlock),
+          verifiedBlocks(util::DivideCeil(util::DivideCeil(size, blockSize), 64)) {
+        if (!blockSize)
+            throw exception("IntegrityBacking block size cannot be zero");
+    }
+
+    IntegrityBacking::IntegrityBacking(std::shared_ptr<Backing> pBacking, std::vector<u8> hashTable, size_t blockSize, bool padLastBlock)
+        : Backing({true, false, false}, pBacking->size),
+          backing(std::move(pBacking)),
+          hashTable(std::move(hashTable)),
+          blockSize(blockSize),
+          padLastBlock(padLastBlock),
+          verifiedBlocks(util::DivideCeil(util::DivideCeil(size, blockSize), 64)) {
+        if (!blockSize)
+            throw exception("IntegrityBacking block size cannot be zero");
+    }
+
+    void IntegrityBacking::VerifyBlocks(size_t firstBlock, size_t endBlock, span<u8> output, size_t offset) {
+        size_t blockCount{endBlock - firstBlock};
+        std::vector<crypto::Sha256Digest> expected(blockCount), actual(blockCount);
+        auto expectedBytes{span(expected).cast<u8>()};
+        if (hashBacking) {
+            hashBacking->Read(expectedBytes, firstBlock * sizeof(crypto::Sha256Digest));
+        } else {
+            if ((endBlock * sizeof(crypto::Sha256Digest)) > hashTable.size())
+                throw exception("Hash table is too small for block {}: 0x{:X}", endBlock - 1, hashTable.size());
+            std::memcpy(expectedBytes.data(), hashTable.data() + firstBlock * sizeof(crypto::Sha256Digest), expectedBytes.size());
+        }
+
+        // Blocks that lie entirely within the output are hashed in a single batch, the ones at either end are read separately if they weren't read entirely
+        size_t outputEnd{offset + output.size()};
+        size_t runStart{firstBlock}, runEnd{firstBlock};
+        for (size_t block{firstBlock}; block < endBlock; block++) {
+            size_t blockStart{block * blockSize}, blockEnd{std::min(blockStart + blockSize, size)};
+            bool needsPadding{padLastBlock && blockEnd - blockStart != blockSize};
+            if (blockStart >= offset && blockEnd <= outputEnd && !needsPadding) {
+                if (runEnd != block)
+                    runStart = block;
+                runEnd = block + 1;
+                continue;
+            }
+
+            std::vector<u8> blockData(needsPadding ? blockSize : blockEnd - blockStart);
+            backing->Read(span(blockData).first(blockEnd - blockStart), blockStart);
+            actual[block - firstBlock] = crypto::Sha256(blockData);
+        }
+
+        // Only a single run of blocks can ever be entirely within the output as all blocks are consecutive
+        if (runEnd != runStart) {
+            size_t runOffset{runStart * blockSize - offset};
+            size_t runSize{std::min(runEnd * blockSize, size) - runStart * blockSize};
+            crypto::Sha256Blocks(output.subspan(runOffset, runSize), blockSize, span(actual).subspan(runStart - firstBlock, runEnd - runStart));
+        }
+
+        for (size_t block{firstBlock}; block < endBlock; block++) {
+            if (actual[block - firstBlock] != expected[block - firstBlock])
+                throw exception("Integrity verification failed for block {} (Offset: 0x{:X}, Block Size: 0x{:X}), the dump may be corrupted", block, block * blockSize, blockSize);
+            SetVerified(block);
+        }
+    }
+
+    size_t IntegrityBacking::ReadImpl(span<u8> output, size_t offset) {
+        if (offset >= size)
+            return 0;
+        output = output.first(std::min(output.size(), size - offset));
+
+        size_t readSize{backing->ReadUnchecked(output, offset)};
+        if (readSize != output.size())
+            return readSize;
+
+        size_t endBlock{util::DivideCeil(offset + output.size(), blockSize)};
+        for (size_t block{offset / blockSize}; block < endBlock;) {
+            if (IsVerified(block)) {
+                block++;
+                continue;
+            }
+
+            size_t runEnd{block + 1};
+            while (runEnd < endBlock && !IsVerified(runEnd))
+                runEnd++;
+            VerifyBlocks(block, runEnd, output, offset);
+            block = runEnd;
+        }
+
+        return readSize;
+    }
+}
@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: MPL-2.0
+// Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+
+#pragma once
+
+#include <crypto/sha256.h>
+#include "backing.h"
+
+namespace skyline::vfs {
+    /**
+     * @brief A read-only backing which verifies the SHA-256 hash of every block of another backing against a table of hashes the first time the block is read
+     * @note Blocks are only hashed once, after which they're marked as verified and are read without any overhead beyond a bitmap lookup
+     * @note This is used for every level of the hierarchical hashing schemes of NCA sections, the hash table of a level is the verified backing of the level above it
+     */
+    class IntegrityBacking : public Backing {
+      private:
+        std::shared_ptr<Backing> backing;
+        std::shared_ptr<Backing> hashBacking; //!< The backing containing the hash of every block in order, this is nullptr if the hashes are in hashTable instead
+        std::vector<u8> hashTable; //!< The hash of every block in order for the topmost level of a hash tree, this is only used when hashBacking is nullptr
+        size_t blockSize;
+        bool padLastBlock; //!< If a partial last block is zero-padded to the block size prior to being hashed, otherwise only the data in it is hashed
+        std::vector<std::atomic<u64>> verifiedBlocks; //!< A bitmap of blocks which have been verified
+
+        bool IsVerified(size_t block) const {
+            return verifiedBlocks[block / 64].load(std::memory_order_relaxed) & (1ULL << (block % 64));
+        }
+
+        void SetVerified(size_t block) {
+            verifiedBlocks[block / 64].fetch_or(1ULL << (block % 64), std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Verifies a run of consecutive unverified blocks, any blocks that are entirely within the read data are hashed from it directly while the others are read separately
+         * @param output The data that was read from the backing at the offset
+         * @throws exception If any of the blocks doesn't match its hash
+         */
+        void VerifyBlocks(size_t firstBlock, size_t endBlock, span<u8> output, size_t offset);
+
+      protected:
+        size_t ReadImpl(span<u8> output, size_t offset) override;
+
+      public:
+        /**
+         * @param hashBacking A backing containing the hash of every block in order, this must be verified itself
+         */
+        IntegrityBacking(std::shared_ptr<Backing> backing, std::shared_ptr<Backing> hashBacking, size_t blockSize, bool padLastBlock);
+
+        /**
+         * @param hashTable The hash of every block in order, this must be verified by the caller
+         */
+        IntegrityBacking(std::shared_ptr<Backing> backing, std::vector<u8> hashTable, size_t blockSize, bool padLastBlock);
+    };
+}
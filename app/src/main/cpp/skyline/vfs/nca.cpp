@@ -2,9 +2,13 @@
 // Copyright © 2020 Skyline Team and Contributors (https://github.com/skyline-emu/)
 
 #include <crypto/aes_cipher.h>
+#include <crypto/aes_xts_cipher.h>
+#include <crypto/sha256.h>
 #include <loader/loader.h>
 
 #include "ctr_encrypted_backing.h"
+#include "cached_backing.h"
+#include "integrity_backing.h"
 #include "region_backing.h"
 #include "partition_filesystem.h"
 #include "nca.h"
@@ -14,16 +18,16 @@
 namespace skyline::vfs {
     using namespace loader;
 
-    NCA::NCA(std::shared_ptr<vfs::Backing> pBacking, std::shared_ptr<crypto::KeyStore> pKeyStore, bool pUseKeyArea) : backing(std::move(pBacking)), keyStore(std::move(pKeyStore)), useKeyArea(pUseKeyArea) {
+    NCA::NCA(std::shared_ptr<vfs::Backing> pBacking, std::shared_ptr<crypto::KeyStore> pKeyStore, bool pUseKeyArea, bool pVerifyIntegrity) : backing(std::move(pBacking)), keyStore(std::move(pKeyStore)), useKeyArea(pUseKeyArea), verifyIntegrity(pVerifyIntegrity) {
         header = backing->Read<NcaHeader>();
 
         if (header.magic != util::MakeMagic<u32>("NCA3")) {
             if (!keyStore->headerKey)
                 throw loader_exception(LoaderResult::MissingHeaderKey);
 
-            crypto::AesCipher cipher(*keyStore->headerKey, MBEDTLS_CIPHER_AES_128_XTS);
+            crypto::AesXtsCipher cipher(*keyStore->headerKey);
 
-            cipher.XtsDecrypt({reinterpret_cast<u8 *>(&header), sizeof(NcaHeader)}, 0, 0x200);
+            cipher.Decrypt({reinterpret_cast<u8 *>(&header), sizeof(NcaHeader)}, 0, 0x200);
 
             // Check if decryption was successful
             if (header.magic != util::MakeMagic<u32>("NCA3"))
@@ -46,10 +50,25 @@ namespace skyline::vfs {
     }
 
     void NCA::ReadPfs0(const NcaSectionHeader &sectionHeader, const NcaFsEntry &entry) {
-        size_t offset{static_cast<size_t>(entry.startOffset) * constant::MediaUnitSize + sectionHeader.sha256HashInfo.pfs0Offset};
-        size_t size{constant::MediaUnitSize * static_cast<size_t>(entry.endOffset - entry.startOffset)};
+        std::shared_ptr<Backing> pfsBacking;
+        if (verifyIntegrity) {
+            const auto &hashInfo{sectionHeader.sha256HashInfo};
+            auto section{CreateSectionBacking(sectionHeader, entry)};
+
+            // The hash table is small enough to be verified and kept in memory, the PFS0 is then verified against it lazily
+            std::vector<u8> hashTable(hashInfo.hashTableSize);
+            section->Read(hashTable, hashInfo.hashTableOffset);
+            if (crypto::Sha256(hashTable) != hashInfo.hashTableHash)
+                throw exception("PFS0 hash table doesn't match its hash, the dump may be corrupted");
+
+            pfsBacking = std::make_shared<IntegrityBacking>(std::make_shared<RegionBacking>(section, hashInfo.pfs0Offset, hashInfo.pfs0Size), std::move(hashTable), hashInfo.blockSize, false);
+        } else {
+            size_t offset{static_cast<size_t>(entry.startOffset) * constant::MediaUnitSize + sectionHeader.sha256HashInfo.pfs0Offset};
+            size_t size{constant::MediaUnitSize * static_cast<size_t>(entry.endOffset - entry.startOffset)};
+            pfsBacking = CreateBacking(sectionHeader, std::make_shared<RegionBacking>(backing, offset, size), offset);
+        }
 
-        auto pfs{std::make_shared<PartitionFileSystem>(CreateBacking(sectionHeader, std::make_shared<RegionBacking>(backing, offset, size), offset))};
+        auto pfs{std::make_shared<PartitionFileSystem>(std::move(pfsBacking))};
 
         if (contentType == NcaContentType::Program) {
             // An ExeFS must always contain an NPDM and a main NSO, whereas the logo section will always contain a logo and a startup movie
@@ -63,12 +82,44 @@ namespace skyline::vfs {
     }
 
     void NCA::ReadRomFs(const NcaSectionHeader &sectionHeader, const NcaFsEntry &entry) {
+        if (verifyIntegrity) {
+            const auto &hashInfo{sectionHeader.integrityHashInfo};
+            if (hashInfo.magic != util::MakeMagic<u32>("IVFC") || hashInfo.numLevels < 2 || hashInfo.numLevels - 1 > hashInfo.levels.size() || hashInfo.masterHashSize != sizeof(crypto::Sha256Digest))
+                throw exception("Invalid IVFC header in RomFS section");
+
+            auto section{CreateSectionBacking(sectionHeader, entry)};
+
+            // Every level is verified against the verified level above it, the topmost level is verified against the master hash in the header
+            std::shared_ptr<Backing> hashLevel;
+            for (size_t i{}; i < hashInfo.numLevels - 1; i++) {
+                const auto &level{hashInfo.levels[i]};
+                auto levelBacking{std::make_shared<RegionBacking>(section, level.offset, level.size)};
+                size_t blockSize{1ULL << level.blockSize};
+                if (hashLevel)
+                    hashLevel = std::make_shared<IntegrityBacking>(std::move(levelBacking), std::move(hashLevel), blockSize, true);
+                else
+                    hashLevel = std::make_shared<IntegrityBacking>(std::move(levelBacking), std::vector<u8>(hashInfo.masterHash.begin(), hashInfo.masterHash.end()), blockSize, true);
+            }
+
+            romFs = std::move(hashLevel);
+            return;
+        }
+
         size_t offset{static_cast<size_t>(entry.startOffset) * constant::MediaUnitSize + sectionHeader.integrityHashInfo.levels.back().offset};
         size_t size{sectionHeader.integrityHashInfo.levels.back().size};
 
         romFs = CreateBacking(sectionHeader, std::make_shared<RegionBacking>(backing, offset, size), offset);
     }
 
+    std::shared_ptr<Backing> NCA::CreateSectionBacking(const NcaSectionHeader &sectionHeader, const NcaFsEntry &entry) {
+        size_t offset{static_cast<size_t>(entry.startOffset) * constant::MediaUnitSize};
+        size_t size{constant::MediaUnitSize * static_cast<size_t>(entry.endOffset - entry.startOffset)};
+        auto section{CreateBacking(sectionHeader, std::make_shared<RegionBacking>(backing, offset, size), offset)};
+        if (!section)
+            throw exception("Unsupported NCA section encryption type: {}", static_cast<u8>(sectionHeader.encryptionType));
+        return section;
+    }
+
     std::shared_ptr<Backing> NCA::CreateBacking(const NcaSectionHeader &sectionHeader, std::shared_ptr<Backing> rawBacking, size_t offset) {
         if (!encrypted)
             return rawBacking;
@@ -86,7 +137,7 @@ namespace skyline::vfs {
                 std::memcpy(ctr.data(), &secureValueLE, 4);
                 std::memcpy(ctr.data() + 4, &generationLE, 4);
 
-                return std::make_shared<CtrEncryptedBacking>(ctr, key, std::move(rawBacking), offset);
+                return std::make_shared<CachedBacking>(std::make_shared<CtrEncryptedBacking>(ctr, key, std::move(rawBacking), offset));
             }
             default:
                 return nullptr;
@@ -174,11 +174,17 @@ namespace skyline {
             bool encrypted{false};
             bool rightsIdEmpty;
             bool useKeyArea;
+            bool verifyIntegrity; //!< If the hashes of all sections should be verified while they're read
 
             void ReadPfs0(const NcaSectionHeader &sectionHeader, const NcaFsEntry &entry);
 
             void ReadRomFs(const NcaSectionHeader &sectionHeader, const NcaFsEntry &entry);
 
+            /**
+             * @return A backing over the decrypted contents of an entire section
+             */
+            std::shared_ptr<Backing> CreateSectionBacking(const NcaSectionHeader &sectionHeader, const NcaFsEntry &entry);
+
             std::shared_ptr<Backing> CreateBacking(const NcaSectionHeader &sectionHeader, std::shared_ptr<Backing> rawBacking, size_t offset);
 
             u8 GetKeyGeneration();
@@ -194,7 +200,10 @@ namespace skyline {
             std::shared_ptr<Backing> romFs; //!< The backing for this NCA's RomFS section
             NcaContentType contentType; //!< The content type of the NCA
 
-            NCA(std::shared_ptr<vfs::Backing> backing, std::shared_ptr<crypto::KeyStore> keyStore, bool useKeyArea = false);
+            /**
+             * @param verifyIntegrity If the PFS0 and RomFS sections should be verified against their hash trees, blocks are verified lazily on their first read rather than upfront
+             */
+            NCA(std::shared_ptr<vfs::Backing> backing, std::shared_ptr<crypto::KeyStore> keyStore, bool useKeyArea = false, bool verifyIntegrity = false);
         };
     }
 }
@@ -3,6 +3,7 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #include "os_backing.h"
 
@@ -13,14 +14,51 @@ namespace skyline::vfs {
             throw exception("Failed to stat fd: {}", strerror(errno));
 
         size = static_cast<size_t>(fileInfo.st_size);
+
+        if (!mode.write && !mode.append && size && S_ISREG(fileInfo.st_mode)) {
+            // Mapping can fail for files which aren't backed by a regular filesystem (such as FUSE on some devices), we just fall back to pread for those
+            auto pointer{mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0)};
+            if (pointer != MAP_FAILED)
+                mapping = span<u8>{static_cast<u8 *>(pointer), size};
+        }
     }
 
     OsBacking::~OsBacking() {
+        if (mapping.valid())
+            munmap(mapping.data(), mapping.size());
+
         if (closable)
             close(fd);
     }
 
+    void OsBacking::Advise(size_t offset, size_t pSize, int advice) {
+        if (!mapping.valid() || offset >= mapping.size())
+            return;
+
+        auto start{util::AlignDown(offset, constant::PageSize)};
+        auto end{std::min(offset + pSize, mapping.size())};
+        madvise(mapping.data() + start, end - start, advice);
+    }
+
     size_t OsBacking::ReadImpl(span<u8> output, size_t offset) {
+        if (mapping.valid()) {
+            if (offset >= mapping.size())
+                return 0;
+
+            constexpr size_t ReadAheadThreshold{0x100000}; //!< The size of a read after which the kernel is asked to read the entire range in ahead of the copy, this avoids faulting on every page synchronously
+            auto source{mapping.subspan(offset, std::min(output.size(), mapping.size() - offset))};
+            if (source.size() >= ReadAheadThreshold)
+                Advise(offset, source.size(), MADV_WILLNEED);
+
+            // The copy can fault on trapped regions of guest memory which is handled by the signal handler, unlike pread which would return EFAULT
+            std::memcpy(output.data(), source.data(), source.size());
+            return source.size();
+        }
+
+        return ReadFile(output, offset);
+    }
+
+    size_t OsBacking::ReadFile(span<u8> output, size_t offset) {
         size_t bytesRead{};
         while (bytesRead < output.size()) {
             auto ret{pread64(fd, output.data() + bytesRead, output.size() - bytesRead, static_cast<off64_t>(offset + bytesRead))};
@@ -8,11 +8,18 @@
 namespace skyline::vfs {
     /**
      * @brief The OsBacking class provides the backing abstractions for a physical linux file
+     * @note Read-only files are memory-mapped when possible, reads are then a copy from the page cache which avoids a syscall per read
      */
     class OsBacking : public Backing {
       private:
         int fd; //!< An FD to the backing
         bool closable; //!< Whether the FD can be closed when the backing is destroyed
+        span<u8> mapping{}; //!< A read-only mapping of the entire file, this is only valid for read-only backings which could be mapped
+
+        /**
+         * @brief Reads from the file using pread rather than the mapping
+         */
+        size_t ReadFile(span<u8> output, size_t offset);
 
       protected:
         size_t ReadImpl(span<u8> output, size_t offset) override;
@@ -28,5 +35,11 @@ namespace skyline::vfs {
         OsBacking(int fd, bool closable = false, Mode = {true, false, false});
 
         ~OsBacking();
+
+        /**
+         * @brief Supplies an access pattern hint for a range of the file to the kernel, such as MADV_WILLNEED or MADV_SEQUENTIAL
+         * @note This only has an effect if the file is memory-mapped
+         */
+        void Advise(size_t offset, size_t size, int advice);
     };
 }
@@ -19,7 +19,9 @@ namespace skyline::vfs {
         auto fullPath{basePath + path};
 
         // Create a directory that will hold the file
-        CreateDirectory(path.substr(0, path.find_last_of('/')), true);
+        auto directoryEnd{path.find_last_of('/')};
+        if (directoryEnd != std::string::npos)
+            CreateDirectory(path.substr(0, directoryEnd), true);
         int fd{open(fullPath.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR)};
         if (fd < 0) {
             if (errno != ENOENT)
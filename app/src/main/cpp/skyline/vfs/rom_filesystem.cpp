@@ -7,73 +7,133 @@
 namespace skyline::vfs {
     RomFileSystem::RomFileSystem(std::shared_ptr<Backing> pBacking) : FileSystem(), backing(std::move(pBacking)) {
         header = backing->Read<RomFsHeader>();
-        TraverseDirectory(0, "");
+
+        auto readTable{[this](auto &table, u64 offset, u64 size) {
+            table.resize(size / sizeof(typename std::remove_reference_t<decltype(table)>::value_type));
+            backing->Read(span(table), offset);
+        }};
+        readTable(dirHashTable, header.dirHashTableOffset, header.dirHashTableSize);
+        readTable(dirMetaTable, header.dirMetaTableOffset, header.dirMetaTableSize);
+        readTable(fileHashTable, header.fileHashTableOffset, header.fileHashTableSize);
+        readTable(fileMetaTable, header.fileMetaTableOffset, header.fileMetaTableSize);
     }
 
-    void RomFileSystem::TraverseFiles(u32 offset, const std::string &path) {
-        RomFsFileEntry entry;
-        do {
-            entry = backing->Read<RomFsFileEntry>(header.fileMetaTableOffset + offset);
+    /**
+     * @brief The hash function used for the RomFS hash tables, this is seeded with the offset of the parent directory entry
+     */
+    static u32 HashEntryName(u32 parentOffset, std::string_view name) {
+        u32 hash{parentOffset ^ 123456789};
+        for (char character : name) {
+            hash = (hash >> 5) | (hash << 27);
+            hash ^= static_cast<u8>(character);
+        }
+        return hash;
+    }
 
-            if (entry.nameSize) {
-                std::vector<char> name(entry.nameSize);
-                backing->Read(span(name), header.fileMetaTableOffset + offset + sizeof(RomFsFileEntry));
+    template<typename EntryType>
+    std::pair<EntryType, std::string_view> RomFileSystem::GetEntry(const std::vector<u8> &table, u32 offset) const {
+        if (static_cast<size_t>(offset) + sizeof(EntryType) > table.size())
+            throw exception("RomFS entry offset is out of bounds: 0x{:X}/0x{:X}", offset, table.size());
 
-                std::string fullPath{path + (path.empty() ? "" : "/") + std::string(name.data(), entry.nameSize)};
-                fileMap.emplace(fullPath, entry);
-            }
+        EntryType entry;
+        std::memcpy(&entry, table.data() + offset, sizeof(EntryType));
+        if (offset + sizeof(EntryType) + entry.nameSize > table.size())
+            throw exception("RomFS entry name is out of bounds: 0x{:X}+0x{:X}/0x{:X}", offset, entry.nameSize, table.size());
 
-            offset = entry.siblingOffset;
-        } while (offset != constant::RomFsEmptyEntry);
+        return {entry, std::string_view{reinterpret_cast<const char *>(table.data() + offset + sizeof(EntryType)), entry.nameSize}};
     }
 
-    void RomFileSystem::TraverseDirectory(u32 offset, const std::string &path) {
-        auto entry{backing->Read<RomFsDirectoryEntry>(header.dirMetaTableOffset + offset)};
+    template<typename EntryType>
+    std::optional<u32> RomFileSystem::FindChild(u32 parentOffset, u32 firstChildOffset, std::string_view name, const std::vector<u32> &hashTable, const std::vector<u8> &metaTable) const {
+        if (!hashTable.empty()) {
+            for (u32 offset{hashTable[HashEntryName(parentOffset, name) % hashTable.size()]}; offset != constant::RomFsEmptyEntry;) {
+                auto [entry, entryName]{GetEntry<EntryType>(metaTable, offset)};
+                if (entry.parentOffset == parentOffset && entryName == name)
+                    return offset;
+                offset = entry.hashSiblingOffset;
+            }
+        } else {
+            for (u32 offset{firstChildOffset}; offset != constant::RomFsEmptyEntry;) {
+                auto [entry, entryName]{GetEntry<EntryType>(metaTable, offset)};
+                if (entryName == name)
+                    return offset;
+                offset = entry.siblingOffset;
+            }
+        }
 
-        std::string childPath(path);
-        if (entry.nameSize) {
-            std::vector<char> name(entry.nameSize);
-            backing->Read(span(name), header.dirMetaTableOffset + offset + sizeof(RomFsDirectoryEntry));
-            childPath = path + (path.empty() ? "" : "/") + std::string(name.data(), entry.nameSize);
+        return std::nullopt;
+    }
+
+    std::optional<std::pair<u32, std::string_view>> RomFileSystem::ResolveParent(std::string_view path) const {
+        u32 directoryOffset{}; // The root directory is always the first entry in the directory metadata table
+        std::string_view name;
+        while (!path.empty()) {
+            auto separator{path.find('/')};
+            auto component{path.substr(0, separator)};
+            path = separator == std::string_view::npos ? std::string_view{} : path.substr(separator + 1);
+            if (component.empty())
+                continue; // Leading, trailing and repeated separators are ignored
+
+            if (!name.empty()) {
+                auto childOffset{FindChild<RomFsDirectoryEntry>(directoryOffset, GetEntry<RomFsDirectoryEntry>(dirMetaTable, directoryOffset).first.childOffset, name, dirHashTable, dirMetaTable)};
+                if (!childOffset)
+                    return std::nullopt;
+                directoryOffset = *childOffset;
+            }
+            name = component;
         }
 
-        directoryMap.emplace(childPath, entry);
+        return std::make_pair(directoryOffset, name);
+    }
+
+    std::optional<RomFileSystem::RomFsFileEntry> RomFileSystem::FindFile(std::string_view path) const {
+        auto parent{ResolveParent(path)};
+        if (!parent || parent->second.empty())
+            return std::nullopt;
 
-        if (entry.fileOffset != constant::RomFsEmptyEntry)
-            TraverseFiles(entry.fileOffset, childPath);
+        auto [parentOffset, name]{*parent};
+        auto fileOffset{FindChild<RomFsFileEntry>(parentOffset, GetEntry<RomFsDirectoryEntry>(dirMetaTable, parentOffset).first.fileOffset, name, fileHashTable, fileMetaTable)};
+        if (!fileOffset)
+            return std::nullopt;
+        return GetEntry<RomFsFileEntry>(fileMetaTable, *fileOffset).first;
+    }
+
+    std::optional<RomFileSystem::RomFsDirectoryEntry> RomFileSystem::FindDirectory(std::string_view path) const {
+        auto parent{ResolveParent(path)};
+        if (!parent)
+            return std::nullopt;
 
-        if (entry.childOffset != constant::RomFsEmptyEntry)
-            TraverseDirectory(entry.childOffset, childPath);
+        auto [parentOffset, name]{*parent};
+        if (name.empty())
+            return GetEntry<RomFsDirectoryEntry>(dirMetaTable, parentOffset).first;
 
-        if (entry.siblingOffset != constant::RomFsEmptyEntry)
-            TraverseDirectory(entry.siblingOffset, path);
+        auto directoryOffset{FindChild<RomFsDirectoryEntry>(parentOffset, GetEntry<RomFsDirectoryEntry>(dirMetaTable, parentOffset).first.childOffset, name, dirHashTable, dirMetaTable)};
+        if (!directoryOffset)
+            return std::nullopt;
+        return GetEntry<RomFsDirectoryEntry>(dirMetaTable, *directoryOffset).first;
     }
 
     std::shared_ptr<Backing> RomFileSystem::OpenFileImpl(const std::string &path, Backing::Mode mode) {
-        try {
-            const auto &entry{fileMap.at(path)};
-            return std::make_shared<RegionBacking>(backing, header.dataOffset + entry.offset, entry.size, mode);
-        } catch (std::out_of_range &e) {
+        auto entry{FindFile(path)};
+        if (!entry)
             return nullptr;
-        }
+        return std::make_shared<RegionBacking>(backing, header.dataOffset + entry->offset, entry->size, mode);
     }
 
     std::optional<Directory::EntryType> RomFileSystem::GetEntryTypeImpl(const std::string &path) {
-        if (fileMap.count(path))
+        if (FindFile(path))
             return Directory::EntryType::File;
-        else if (directoryMap.count(path))
+        else if (FindDirectory(path))
             return Directory::EntryType::Directory;
 
         return std::nullopt;
     }
 
     std::shared_ptr<Directory> RomFileSystem::OpenDirectoryImpl(const std::string &path, Directory::ListMode listMode) {
-        try {
-            auto &entry{directoryMap.at(path)};
-            return std::make_shared<RomFileSystemDirectory>(backing, header, entry, listMode);
-        } catch (std::out_of_range &e) {
+        auto entry{FindDirectory(path)};
+        if (!entry)
             return nullptr;
-        }
+        return std::make_shared<RomFileSystemDirectory>(backing, header, *entry, listMode);
     }
 
     RomFileSystemDirectory::RomFileSystemDirectory(std::shared_ptr<Backing> backing, const RomFileSystem::RomFsHeader &header, const RomFileSystem::RomFsDirectoryEntry &ownEntry, ListMode listMode) : Directory(listMode), backing(std::move(backing)), header(header), ownEntry(ownEntry) {}
@@ -13,32 +13,9 @@ namespace skyline {
     namespace vfs {
         /**
          * @brief The RomFileSystem class abstracts access to a RomFS image using the vfs::FileSystem api
+         * @note Paths are resolved lazily using the hash tables in the RomFS image itself, only the hash and metadata tables are read into memory when the filesystem is opened
          */
         class RomFileSystem : public FileSystem {
-          private:
-            std::shared_ptr<Backing> backing;
-
-            /**
-             * @brief Traverses the sibling files of the given file and adds them to the file map
-             * @param offset The offset of the file entry to traverses the siblings of
-             * @param path The path to the parent directory of the supplied file entry
-             */
-            void TraverseFiles(u32 offset, const std::string &path);
-
-            /**
-             * @brief Traverses the directories within the given directory, adds them to the directory map and calls TraverseFiles on them
-             * @param offset The offset of the directory entry to traverses the directories in
-             * @param path The path to the supplied directory entry
-             */
-            void TraverseDirectory(u32 offset, const std::string &path);
-
-          protected:
-            std::shared_ptr<Backing> OpenFileImpl(const std::string &path, Backing::Mode mode) override;
-
-            std::optional<Directory::EntryType> GetEntryTypeImpl(const std::string &path) override;
-
-            std::shared_ptr<Directory> OpenDirectoryImpl(const std::string &path, Directory::ListMode listMode) override;
-
           public:
             struct RomFsHeader {
                 u64 headerSize; //!< The size of the header
@@ -59,7 +36,7 @@ namespace skyline {
                 u32 siblingOffset; //!< The offset from the directory metadata base of a sibling directory
                 u32 childOffset; //!< The offset from the directory metadata base of a child directory
                 u32 fileOffset; //!< The offset from the file metadata base of a child file
-                u32 hash; //!< The hash of the directory
+                u32 hashSiblingOffset; //!< The offset from the directory metadata base of the next directory in the same hash table bucket
                 u32 nameSize; //!< The size of the directory's name in bytes
             };
 
@@ -68,13 +45,54 @@ namespace skyline {
                 u32 siblingOffset; //!< The offset from the file metadata base of a sibling file
                 u64 offset; //!< The offset from the file data base of the file contents
                 u64 size; //!< The size of the file in bytes
-                u32 hash; //!< The hash of the file
+                u32 hashSiblingOffset; //!< The offset from the file metadata base of the next file in the same hash table bucket
                 u32 nameSize; //!< The size of the file's name in bytes
             };
 
-            std::unordered_map<std::string, RomFsFileEntry> fileMap; //!< A map that maps file names to their corresponding entry
-            std::unordered_map<std::string, RomFsDirectoryEntry> directoryMap; //!< A map that maps directory names to their corresponding entry
+          private:
+            std::shared_ptr<Backing> backing;
+            std::vector<u32> dirHashTable; //!< The buckets of the directory hash table, these contain the offset of the first directory entry in the bucket
+            std::vector<u8> dirMetaTable;
+            std::vector<u32> fileHashTable; //!< The buckets of the file hash table, these contain the offset of the first file entry in the bucket
+            std::vector<u8> fileMetaTable;
+
+            /**
+             * @return The entry at the supplied offset in a metadata table and its name
+             */
+            template<typename EntryType>
+            std::pair<EntryType, std::string_view> GetEntry(const std::vector<u8> &table, u32 offset) const;
 
+            /**
+             * @brief Finds a child in the supplied directory by its name using the hash table, or by walking the children of the directory if the image has no hash table
+             * @return The offset of the entry in its metadata table, if it was found
+             */
+            template<typename EntryType>
+            std::optional<u32> FindChild(u32 parentOffset, u32 firstChildOffset, std::string_view name, const std::vector<u32> &hashTable, const std::vector<u8> &metaTable) const;
+
+            /**
+             * @brief Resolves all directories in a path aside from the last component
+             * @return The offset of the parent directory entry and the name of the last component of the path, the name is empty if the path refers to the root directory
+             */
+            std::optional<std::pair<u32, std::string_view>> ResolveParent(std::string_view path) const;
+
+            /**
+             * @return The entry of the file at the supplied path, if it exists
+             */
+            std::optional<RomFsFileEntry> FindFile(std::string_view path) const;
+
+            /**
+             * @return The entry of the directory at the supplied path, if it exists
+             */
+            std::optional<RomFsDirectoryEntry> FindDirectory(std::string_view path) const;
+
+          protected:
+            std::shared_ptr<Backing> OpenFileImpl(const std::string &path, Backing::Mode mode) override;
+
+            std::optional<Directory::EntryType> GetEntryTypeImpl(const std::string &path) override;
+
+            std::shared_ptr<Directory> OpenDirectoryImpl(const std::string &path, Directory::ListMode listMode) override;
+
+          public:
             RomFileSystem(std::shared_ptr<Backing> backing);
         };
 
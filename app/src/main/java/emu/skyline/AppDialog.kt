@@ -15,6 +15,7 @@ import android.view.KeyEvent
 import android.view.LayoutInflater
 import android.view.View
 import android.view.ViewGroup
+import android.widget.Toast
 import androidx.core.content.ContextCompat
 import androidx.core.graphics.drawable.toBitmap
 import com.google.android.material.bottomsheet.BottomSheetBehavior
@@ -22,9 +23,10 @@ import com.google.android.material.bottomsheet.BottomSheetDialogFragment
 import emu.skyline.data.AppItem
 import emu.skyline.databinding.AppDialogBinding
 import emu.skyline.loader.LoaderResult
+import emu.skyline.utils.TitleProfile
 
 /**
- * This dialog is used to show extra game metadata and provide extra options such as pinning the game to the home screen
+ * This dialog is used to show extra game metadata and provide extra options such as pinning the game to the home screen or auto-tuning its [TitleProfile]
  */
 class AppDialog : BottomSheetDialogFragment() {
     companion object {
@@ -81,7 +83,17 @@ class AppDialog : BottomSheetDialogFragment() {
 
         binding.gamePlay.isEnabled = item.loaderResult == LoaderResult.Success
         binding.gamePlay.setOnClickListener {
-            startActivity(Intent(activity, EmulationActivity::class.java).apply { data = item.uri })
+            startActivity(Intent(activity, EmulationActivity::class.java).apply { data = item.uri; putExtra(EmulationActivity.TitleIdTag, item.titleId) })
+        }
+
+        binding.gameAutoTune.isEnabled = item.loaderResult == LoaderResult.Success && item.titleId != 0L
+        binding.gameAutoTune.setOnClickListener {
+            startActivity(Intent(activity, EmulationActivity::class.java).apply { data = item.uri; putExtra(EmulationActivity.TitleIdTag, item.titleId); putExtra(EmulationActivity.AutoTuneTag, true) })
+        }
+        binding.gameAutoTune.setOnLongClickListener {
+            TitleProfile(requireContext(), item.titleId).clear()
+            Toast.makeText(requireContext(), R.string.title_profile_cleared, Toast.LENGTH_SHORT).show()
+            true
         }
 
         val shortcutManager = requireActivity().getSystemService(ShortcutManager::class.java)
@@ -95,6 +107,7 @@ class AppDialog : BottomSheetDialogFragment() {
 
             val intent = Intent(context, EmulationActivity::class.java)
             intent.data = item.uri
+            intent.putExtra(EmulationActivity.TitleIdTag, item.titleId)
             intent.action = Intent.ACTION_VIEW
 
             info.setIntent(intent)
@@ -11,10 +11,13 @@ import android.content.Intent
 import android.content.res.AssetManager
 import android.graphics.PointF
 import android.hardware.display.DisplayManager
+import android.net.Uri
 import android.os.*
 import android.util.Log
 import android.util.Rational
 import android.view.*
+import android.widget.Toast
+import androidx.annotation.StringRes
 import androidx.appcompat.app.AppCompatActivity
 import androidx.core.content.getSystemService
 import androidx.core.view.isGone
@@ -27,11 +30,15 @@ import emu.skyline.applet.swkbd.SoftwareKeyboardConfig
 import emu.skyline.applet.swkbd.SoftwareKeyboardDialog
 import emu.skyline.databinding.EmuActivityBinding
 import emu.skyline.input.*
+import emu.skyline.loader.RomFile
+import emu.skyline.loader.RomFormat
 import emu.skyline.loader.getRomFormat
+import emu.skyline.utils.AutoTuner
 import emu.skyline.utils.ByteBufferSerializable
 import emu.skyline.utils.GpuDriverHelper
 import emu.skyline.utils.NativeSettings
 import emu.skyline.utils.PreferenceSettings
+import emu.skyline.utils.TitleProfile
 import java.nio.ByteBuffer
 import java.nio.ByteOrder
 import java.util.concurrent.FutureTask
@@ -44,6 +51,23 @@ class EmulationActivity : AppCompatActivity(), SurfaceHolder.Callback, View.OnTo
         private val Tag = EmulationActivity::class.java.simpleName
         val ReturnToMainTag = "returnToMain"
 
+        /**
+         * The amount of frames to run a benchmark for after the first frame, the activity finishes and a JSON report is written to the benchmarks directory once they've been presented
+         * e.g. `adb shell am start -n emu.skyline/.EmulationActivity -d <ROM URI> --ei benchmarkFrames 3000`
+         */
+        val BenchmarkFramesTag = "benchmarkFrames"
+
+        /**
+         * The title ID of the ROM which is used to look up its [TitleProfile], the ROM is parsed to determine it when this isn't supplied
+         */
+        val TitleIdTag = "titleId"
+
+        /**
+         * If the title should be auto-tuned with [AutoTuner] rather than played, [BenchmarkFramesTag] specifies the amount of frames every configuration is run for
+         * e.g. `adb shell am start -n emu.skyline/.EmulationActivity -d <ROM URI> --ez autoTune true`
+         */
+        val AutoTuneTag = "autoTune"
+
         /**
          * The Kotlin thread on which emulation code executes
          */
@@ -90,8 +114,9 @@ class EmulationActivity : AppCompatActivity(), SurfaceHolder.Callback, View.OnTo
      * @param privateAppFilesPath The full path to the private app files directory
      * @param nativeLibraryPath The full path to the app native library directory
      * @param assetManager The asset manager used for accessing app assets
+     * @param benchmarkFrames The amount of frames to run a benchmark for, 0 if emulation isn't being benchmarked
      */
-    private external fun executeApplication(romUri : String, romType : Int, romFd : Int, nativeSettings : NativeSettings, publicAppFilesPath : String, privateAppFilesPath : String, nativeLibraryPath : String, assetManager : AssetManager)
+    private external fun executeApplication(romUri : String, romType : Int, romFd : Int, nativeSettings : NativeSettings, publicAppFilesPath : String, privateAppFilesPath : String, nativeLibraryPath : String, assetManager : AssetManager, benchmarkFrames : Int)
 
     /**
      * @param join If the function should only return after all the threads join or immediately
@@ -112,15 +137,160 @@ class EmulationActivity : AppCompatActivity(), SurfaceHolder.Callback, View.OnTo
      */
     private external fun changeAudioStatus(play : Boolean)
 
+    /**
+     * Pauses all guest threads and frees any GPU resources that aren't in use, this minimizes the memory usage while the app is in the background
+     */
+    private external fun suspendEmulation()
+
+    /**
+     * Resumes all guest threads paused by [suspendEmulation], freed resources are recreated on demand
+     */
+    private external fun resumeEmulation()
+
+    /**
+     * Frees host memory held by caches in response to memory pressure, resources that are still in use are retained
+     *
+     * @param complete If all unused resources should be freed including the ones that are costly to recreate, only cheap ones are freed otherwise
+     * @return An estimate of the amount of bytes that were freed
+     */
+    private external fun trimMemory(complete : Boolean) : Long
+
+    /**
+     * The outcome of saving or loading a save state, the ordinals must match the values of SaveStateManager::Result in native code
+     *
+     * @param message The message shown to the user when this is the outcome, success is reported with a message specific to saving or loading instead
+     */
+    enum class SaveStateResult(@StringRes val message : Int) {
+        Success(R.string.save_state_saved),
+        Error(R.string.save_state_error),
+        NotLoaded(R.string.save_state_not_loaded),
+        SuspendTimeout(R.string.save_state_suspend_timeout),
+        Empty(R.string.save_state_empty),
+        LayoutMismatch(R.string.save_state_layout_mismatch),
+        HostStateMismatch(R.string.save_state_host_state_mismatch),
+        ThreadStateMismatch(R.string.save_state_thread_state_mismatch),
+    }
+
+    /**
+     * Snapshots the guest into a save state slot, the snapshot is compressed and written out in the background after the guest has resumed
+     *
+     * @param slot The index of the slot to save to, saving to a slot repeatedly only writes out the memory that changed since the last save
+     * @return The ordinal of the [SaveStateResult]
+     */
+    private external fun saveState(slot : Int) : Int
+
+    /**
+     * Restores the guest from the latest snapshot in a save state slot
+     *
+     * @param slot The index of the slot to load from
+     * @return The ordinal of the [SaveStateResult]
+     */
+    private external fun loadState(slot : Int) : Int
+
+    /**
+     * @return The duration in milliseconds that the guest was paused for during the last save or load of a save state
+     */
+    private external fun getSaveStatePauseTime() : Long
+
+    /**
+     * Shows the outcome of saving or loading a save state to the user, this includes how long the game was paused for on success
+     */
+    private fun reportSaveStateResult(result : SaveStateResult, slot : Int, @StringRes successMessage : Int) {
+        val message = if (result == SaveStateResult.Success) getString(successMessage, slot, getSaveStatePauseTime()) else getString(result.message, slot)
+        runOnUiThread { Toast.makeText(applicationContext, message, Toast.LENGTH_SHORT).show() }
+    }
+
+    /**
+     * Saves the guest into a save state slot and reports the outcome to the user, this blocks while the guest is paused
+     */
+    fun saveStateToSlot(slot : Int) : Boolean {
+        val result = SaveStateResult.values()[saveState(slot)]
+        reportSaveStateResult(result, slot, R.string.save_state_saved)
+        return result == SaveStateResult.Success
+    }
+
+    /**
+     * Restores the guest from a save state slot and reports the outcome to the user, this blocks while the guest is paused
+     */
+    fun loadStateFromSlot(slot : Int) : Boolean {
+        val result = SaveStateResult.values()[loadState(slot)]
+        reportSaveStateResult(result, slot, R.string.save_state_loaded)
+        return result == SaveStateResult.Success
+    }
+
+    /**
+     * Switches between the configured emulation speed and the fast-forward speed, this does nothing if fast-forwarding is disabled
+     */
+    private external fun setFastForward(enable : Boolean)
+
     var fps : Int = 0
     var averageFrametime : Float = 0.0f
     var averageFrametimeDeviation : Float = 0.0f
+    var executorSlotCount : Int = 0
+
+    /**
+     * The values of all native performance counters over the last presented frame, the layout matches `skyline::PerfStats::Counter`
+     * Draws, batched draws, draw CPU time (ns), pipeline compiles, texture creations, linear texture migrations, mutable format promotions, texture uploads and uploaded bytes, buffer creations, megabuffer bytes,
+     * staging buffer allocations and reuses, redundant vertex and index buffer binds, GPU wait time (ns), GPFIFO idle time (ns), SVC calls, host thread creations and reuses, mprotects,
+     * backing cache hits and misses, audio callbacks, audio callback time (ns), audio track underruns and audio device underruns, guest mirror creations, reuses and unmaps, host texture copies,
+     * defragmentation moves and moved bytes, nvdrv ioctls and ioctl time (ns)
+     */
+    val perfCounters = LongArray(35)
 
     /**
-     * Writes the current performance statistics into [fps], [averageFrametime] and [averageFrametimeDeviation] fields
+     * The block and allocation bytes of the render target, sampled texture, buffer and staging memory pools, the free space of a pool is the difference between the two
+     */
+    val memoryPoolStats = LongArray(8)
+
+    /**
+     * A histogram of blocking GPU waits since emulation started, bucket N holds waits that took between 2^(N-1) and 2^N microseconds
+     */
+    val fenceWaitHistogram = LongArray(16)
+
+    /**
+     * A histogram of the amount of frames buffered in playing audio tracks at the start of every audio callback, bucket N holds fill levels between 2^(N-1) and 2^N frames
+     */
+    val audioFillHistogram = LongArray(16)
+
+    /**
+     * A histogram of audio callback durations, bucket N holds callbacks that took between 2^(N-1) and 2^N microseconds
+     */
+    val audioCallbackHistogram = LongArray(16)
+
+    /**
+     * A histogram of the latency from input events to the frames they were rendered with being presented, bucket N holds latencies between 2^(N-1) and 2^N microseconds
+     */
+    val inputLatencyHistogram = LongArray(16)
+
+    /**
+     * A histogram of the CPU time spent building individual draws, bucket N holds draws that took between 2^(N-1) and 2^N nanoseconds
+     */
+    val drawCpuHistogram = LongArray(16)
+
+    /**
+     * A histogram of how much guest sleeps and timed waits overshot their deadline by, bucket N holds oversleeps between 2^(N-1) and 2^N microseconds
+     */
+    val oversleepHistogram = LongArray(16)
+
+    /**
+     * Writes the current performance statistics into [fps], [averageFrametime], [averageFrametimeDeviation], [executorSlotCount], [perfCounters], [memoryPoolStats], [fenceWaitHistogram], [audioFillHistogram], [audioCallbackHistogram], [inputLatencyHistogram], [drawCpuHistogram] and [oversleepHistogram] fields
      */
     private external fun updatePerformanceStatistics()
 
+    /**
+     * Collects the runtime statistics of all guest threads, these are also written to the log
+     *
+     * @return A table with a row for every guest thread containing its CPU time, time spent waiting for each reason, core migrations and priority-inheritance boosts
+     */
+    external fun getThreadStatistics() : String
+
+    /**
+     * Produces a report of the guest functions that were sampled the most by the guest profiler
+     *
+     * @return A table with a row for every function containing its sample count, its share of all samples and the executable it's in, this is empty if the profiler is disabled
+     */
+    external fun getGuestProfile() : String
+
     /**
      * This initializes a guest controller in libskyline
      *
@@ -225,6 +395,14 @@ class EmulationActivity : AppCompatActivity(), SurfaceHolder.Callback, View.OnTo
         }
     }
 
+    /**
+     * Runs the supplied ROM until emulation ends, this must be called on [emulationThread]
+     */
+    private fun runApplication(rom : Uri, romType : RomFormat, settings : NativeSettings, benchmarkFrames : Int) {
+        val romFd = contentResolver.openFileDescriptor(rom, "r")!!
+        executeApplication(rom.toString(), romType.ordinal, romFd.detachFd(), settings, applicationContext.getPublicFilesDir().canonicalPath + "/", applicationContext.filesDir.canonicalPath + "/", applicationInfo.nativeLibraryDir + "/", assets, benchmarkFrames)
+    }
+
     /**
      * @note Any caller has to handle the application potentially being restarted with the supplied intent
      */
@@ -245,12 +423,43 @@ class EmulationActivity : AppCompatActivity(), SurfaceHolder.Callback, View.OnTo
         returnToMain = intent.getBooleanExtra(ReturnToMainTag, false)
 
         val rom = intent.data!!
-        val romType = getRomFormat(rom, contentResolver).ordinal
-        val romFd = contentResolver.openFileDescriptor(rom, "r")!!
+        val romType = getRomFormat(rom, contentResolver)
+        val benchmarkFrames = intent.getIntExtra(BenchmarkFramesTag, 0)
+        val autoTune = intent.getBooleanExtra(AutoTuneTag, false)
+        val suppliedTitleId = intent.getLongExtra(TitleIdTag, 0)
 
         GpuDriverHelper.ensureFileRedirectDir(this)
         emulationThread = Thread {
-            executeApplication(rom.toString(), romType, romFd.detachFd(), NativeSettings(this, preferenceSettings), applicationContext.getPublicFilesDir().canonicalPath + "/", applicationContext.filesDir.canonicalPath + "/", applicationInfo.nativeLibraryDir + "/", assets)
+            val titleId = if (suppliedTitleId != 0L) suppliedTitleId else RomFile(this, romType, rom, preferenceSettings.systemLanguage).appEntry.titleId
+            if (autoTune && titleId != 0L) {
+                val autoTuner = AutoTuner(this, preferenceSettings, titleId, benchmarkFrames)
+                var firstRun = true
+                do {
+                    // The surface is only supplied by the surface callbacks, it needs to be handed to every run after the first as the surface hasn't changed
+                    if (!firstRun)
+                        runOnUiThread {
+                            val surface = binding.gameView.holder.surface
+                            while (surface.isValid && emulationThread!!.isAlive)
+                                if (setSurface(surface))
+                                    break
+                        }
+                    firstRun = false
+
+                    runApplication(rom, romType, autoTuner.createSettings(), autoTuner.frameCount)
+                } while (autoTuner.onRunCompleted())
+
+                autoTuner.best?.let { best ->
+                    runOnUiThread { Toast.makeText(applicationContext, getString(R.string.auto_tune_complete, best.p50, best.p99), Toast.LENGTH_LONG).show() }
+                }
+            } else {
+                if (autoTune)
+                    Log.w(Tag, "Auto-tuning was skipped as the title ID of the ROM couldn't be determined")
+
+                val settings = NativeSettings(this, preferenceSettings)
+                if (titleId != 0L)
+                    TitleProfile(this, titleId).applyTo(settings)
+                runApplication(rom, romType, settings, benchmarkFrames)
+            }
             returnFromEmulation()
         }
 
@@ -282,6 +491,7 @@ class EmulationActivity : AppCompatActivity(), SurfaceHolder.Callback, View.OnTo
         if (preferenceSettings.respectDisplayCutout) {
             binding.perfStats.setOnApplyWindowInsetsListener(insetsOrMarginHandler)
             binding.onScreenControllerToggle.setOnApplyWindowInsetsListener(insetsOrMarginHandler)
+            binding.fastForwardToggle.setOnApplyWindowInsetsListener(insetsOrMarginHandler)
         }
 
         binding.gameView.holder.addCallback(this)
@@ -302,7 +512,17 @@ class EmulationActivity : AppCompatActivity(), SurfaceHolder.Callback, View.OnTo
                 postDelayed(object : Runnable {
                     override fun run() {
                         updatePerformanceStatistics()
-                        text = "$fps FPS\n${"%.1f".format(averageFrametime)}±${"%.2f".format(averageFrametimeDeviation)}ms"
+                        text = "$fps FPS\n${"%.1f".format(averageFrametime)}±${"%.2f".format(averageFrametimeDeviation)}ms\n$executorSlotCount slots" +
+                                "\n${perfCounters[0]} draws (${perfCounters[1]} batched), ${perfCounters[3]} compiles" +
+                                "\n${perfCounters[4]} textures, ${perfCounters[9]} buffers, ${perfCounters[10] / 1024}KiB megabuffer" +
+                                "\n${perfCounters[27]} mirrors (${perfCounters[28]} reused), ${perfCounters[29]} unmaps" +
+                                "\nPools ${(0 until 4).joinToString("/") { "${memoryPoolStats[it * 2] / (1024 * 1024)}MiB" }}, free ${(0 until 4).joinToString("/") { "${if (memoryPoolStats[it * 2] != 0L) 100 - (memoryPoolStats[it * 2 + 1] * 100 / memoryPoolStats[it * 2]) else 0}%" }}" +
+                                "\n${perfCounters[31]} defrag moves, ${perfCounters[32] / 1024}KiB moved" +
+                                "\nGPU wait ${"%.1f".format(perfCounters[15] / 1e6)}ms, GPFIFO idle ${"%.1f".format(perfCounters[16] / 1e6)}ms" +
+                                "\n${perfCounters[17]} SVCs, ${perfCounters[20]} mprotects, ${perfCounters[18]} new host threads" +
+                                "\n${perfCounters[33]} ioctls, ${if (perfCounters[33] != 0L) perfCounters[34] / perfCounters[33] else 0}ns per ioctl" +
+                                "\n${perfCounters[21]} cache hits, ${perfCounters[22]} cache misses" +
+                                "\nAudio ${"%.1f".format(perfCounters[24] / 1e6)}ms in ${perfCounters[23]} callbacks, ${perfCounters[25]} underruns, ${perfCounters[26]} XRuns"
                         postDelayed(this, 250)
                     }
                 }, 250)
@@ -330,6 +550,15 @@ class EmulationActivity : AppCompatActivity(), SurfaceHolder.Callback, View.OnTo
             setOnClickListener { binding.onScreenControllerView.isInvisible = !binding.onScreenControllerView.isInvisible }
         }
 
+        binding.fastForwardToggle.apply {
+            isGone = preferenceSettings.fastForwardSpeed == 0
+            setOnClickListener {
+                isSelected = !isSelected
+                alpha = if (isSelected) 1f else 0.5f
+                setFastForward(isSelected)
+            }
+        }
+
         executeApplication(intent!!)
     }
 
@@ -339,6 +568,29 @@ class EmulationActivity : AppCompatActivity(), SurfaceHolder.Callback, View.OnTo
         changeAudioStatus(false)
     }
 
+    override fun onStop() {
+        super.onStop()
+
+        if (preferenceSettings.lowMemorySuspend)
+            suspendEmulation()
+    }
+
+    override fun onTrimMemory(level : Int) {
+        super.onTrimMemory(level)
+
+        // The process is at risk of being killed at these levels, everything that isn't in use is shed rather than only what's cheap to recreate
+        @Suppress("DEPRECATION")
+        val complete = level == TRIM_MEMORY_RUNNING_CRITICAL || level >= TRIM_MEMORY_BACKGROUND
+        val freed = trimMemory(complete)
+        Log.i(Tag, "Trimmed ${freed / (1024 * 1024)} MiB at trim level $level")
+    }
+
+    override fun onStart() {
+        super.onStart()
+
+        resumeEmulation()
+    }
+
     override fun onResume() {
         super.onResume()
 
@@ -639,6 +891,19 @@ class EmulationActivity : AppCompatActivity(), SurfaceHolder.Callback, View.OnTo
         return ((major shl 22) or (minor shl 12) or (patch)).toInt()
     }
 
+    /**
+     * Shows the progress of precompiling the pipelines recorded during previous runs, the indicator is hidden once all pipelines have been compiled
+     */
+    @Suppress("unused")
+    fun reportPipelineReplayProgress(replayed : Int, total : Int) {
+        runOnUiThread {
+            binding.pipelineReplayProgress.apply {
+                isGone = replayed >= total
+                text = getString(R.string.building_pipelines, replayed, total)
+            }
+        }
+    }
+
     val insetsOrMarginHandler = View.OnApplyWindowInsetsListener { view, insets ->
         insets.displayCutout?.let {
             val defaultHorizontalMargin = view.resources.getDimensionPixelSize(R.dimen.onScreenItemHorizontalMargin)
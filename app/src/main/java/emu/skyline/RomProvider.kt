@@ -3,36 +3,105 @@ package emu.skyline
 import android.annotation.SuppressLint
 import android.content.Context
 import android.net.Uri
+import android.util.Log
 import androidx.documentfile.provider.DocumentFile
 import dagger.hilt.android.qualifiers.ApplicationContext
 import emu.skyline.loader.AppEntry
+import emu.skyline.loader.LoaderResult
 import emu.skyline.loader.RomFile
 import emu.skyline.loader.RomFormat
 import emu.skyline.loader.RomFormat.*
+import java.io.File
+import java.io.ObjectInputStream
+import java.io.ObjectOutputStream
+import java.io.Serializable
+import java.util.concurrent.Callable
+import java.util.concurrent.Executors
 import javax.inject.Inject
 import javax.inject.Singleton
 
+/**
+ * The metadata of a ROM along with the properties of the file it was read from, this is used to skip parsing files that haven't changed since they were last scanned
+ */
+private data class CachedRomEntry(val size : Long, val lastModified : Long, val systemLanguage : Int, val entry : AppEntry) : Serializable {
+    companion object {
+        /*
+         * The serialization version must be incremented after any changes to this class
+         */
+        private const val serialVersionUID : Long = 1L
+    }
+}
+
 @Singleton
 class RomProvider @Inject constructor(@ApplicationContext private val context : Context) {
+    companion object {
+        private val TAG = RomProvider::class.java.simpleName
+    }
+
     /**
-     * This adds all files in [directory] with [extension] as an entry using [RomFile] to load metadata
+     * A cache of the metadata of all previously scanned ROMs keyed by their URI
+     */
+    private val metadataCacheFile = File(context.filesDir.canonicalPath + "/rom_metadata.bin")
+
+    /**
+     * This adds all files in [directory] with an extension in [fileFormats] to [files]
      */
     @SuppressLint("DefaultLocale")
-    private fun addEntries(fileFormats : Map<String, RomFormat>, directory : DocumentFile, entries : HashMap<RomFormat, ArrayList<AppEntry>>, systemLanguage : Int) {
+    private fun collectFiles(fileFormats : Map<String, RomFormat>, directory : DocumentFile, files : ArrayList<Pair<DocumentFile, RomFormat>>) {
         directory.listFiles().forEach { file ->
             if (file.isDirectory) {
-                addEntries(fileFormats, file, entries, systemLanguage)
+                collectFiles(fileFormats, file, files)
             } else {
                 fileFormats[file.name?.substringAfterLast(".")?.lowercase()]?.let { romFormat->
-                    entries.getOrPut(romFormat, { arrayListOf() }).add(RomFile(context, romFormat, file.uri, systemLanguage).appEntry)
+                    files.add(file to romFormat)
                 }
             }
         }
     }
 
+    @Suppress("UNCHECKED_CAST")
+    private fun readMetadataCache() : HashMap<String, CachedRomEntry> = try {
+        ObjectInputStream(metadataCacheFile.inputStream()).use { it.readObject() as HashMap<String, CachedRomEntry> }
+    } catch (e : Exception) {
+        HashMap()
+    }
+
+    private fun writeMetadataCache(cache : HashMap<String, CachedRomEntry>) = try {
+        ObjectOutputStream(metadataCacheFile.outputStream()).use { it.writeObject(cache) }
+    } catch (e : Exception) {
+        Log.w(TAG, "Failed to write the ROM metadata cache: ${e.message}")
+    }
+
+    /**
+     * This scans all ROMs in [searchLocation] in parallel, ROMs with an unchanged size and modification time are loaded from the metadata cache rather than being parsed again
+     * @note Entries which failed to load aren't reused from the cache as the failure may have been due to keys which have since been imported
+     */
     fun loadRoms(searchLocation : Uri, systemLanguage : Int) = DocumentFile.fromTreeUri(context, searchLocation)!!.let { documentFile ->
+        val files = arrayListOf<Pair<DocumentFile, RomFormat>>()
+        collectFiles(mapOf("nro" to NRO, "nso" to NSO, "nca" to NCA, "nsp" to NSP, "xci" to XCI), documentFile, files)
+
+        val metadataCache = readMetadataCache()
+        val executor = Executors.newFixedThreadPool(Runtime.getRuntime().availableProcessors().coerceIn(1, 4))
+        val scannedEntries = try {
+            files.map { (file, romFormat) ->
+                executor.submit(Callable {
+                    val size = file.length()
+                    val lastModified = file.lastModified()
+                    metadataCache[file.uri.toString()]?.takeIf { it.size == size && it.lastModified == lastModified && it.systemLanguage == systemLanguage && it.entry.loaderResult == LoaderResult.Success }
+                        ?: CachedRomEntry(size, lastModified, systemLanguage, RomFile(context, romFormat, file.uri, systemLanguage).appEntry)
+                })
+            }.map { it.get() }
+        } finally {
+            executor.shutdown()
+        }
+
+        // Only ROMs that still exist are written back so the cache doesn't grow indefinitely
+        writeMetadataCache(HashMap(files.zip(scannedEntries).associate { (file, cachedEntry) -> file.first.uri.toString() to cachedEntry }))
+
         hashMapOf<RomFormat, ArrayList<AppEntry>>().apply {
-            addEntries(mapOf("nro" to NRO, "nso" to NSO, "nca" to NCA, "nsp" to NSP, "xci" to XCI), documentFile, this, systemLanguage)
+            files.zip(scannedEntries).forEach { (file, cachedEntry) ->
+                getOrPut(file.second, { arrayListOf() }).add(cachedEntry.entry)
+            }
         }
     }
 }
@@ -46,6 +46,11 @@ data class AppItem(private val meta : AppEntry) : DataItem() {
 
     val loaderResult get() = meta.loaderResult
 
+    /**
+     * The title ID of the application, this is 0 if it couldn't be determined
+     */
+    val titleId get() = meta.titleId
+
     fun loaderResultString(context : Context) = context.getString(when (meta.loaderResult) {
         LoaderResult.Success -> R.string.metadata_missing
 
@@ -70,7 +70,8 @@ data class AppEntry(
     var icon : Bitmap?,
     var format : RomFormat,
     var uri : Uri,
-    var loaderResult : LoaderResult
+    var loaderResult : LoaderResult,
+    var titleId : Long = 0
 ) : Serializable {
     constructor(context : Context, format : RomFormat, uri : Uri, loaderResult : LoaderResult) : this(context.contentResolver.query(uri, null, null, null, null)?.use { cursor ->
         val nameIndex : Int = cursor.getColumnIndex(OpenableColumns.DISPLAY_NAME)
@@ -89,6 +90,7 @@ data class AppEntry(
         if (author != null)
             output.writeUTF(author)
         output.writeInt(loaderResult.value)
+        output.writeLong(titleId)
         output.writeBoolean(icon != null)
         icon?.let {
             @Suppress("DEPRECATION")
@@ -108,6 +110,7 @@ data class AppEntry(
         if (input.readBoolean())
             author = input.readUTF()
         loaderResult = LoaderResult.get(input.readInt())
+        titleId = input.readLong()
         if (input.readBoolean())
             icon = BitmapFactory.decodeStream(input)
     }
@@ -116,7 +119,7 @@ data class AppEntry(
         /*
          * The serialization version must be incremented after any changes to this class
          */
-        private const val serialVersionUID : Long = 1L
+        private const val serialVersionUID : Long = 2L
     }
 }
 
@@ -144,6 +147,11 @@ internal class RomFile(context : Context, format : RomFormat, uri : Uri, systemL
      */
     private var rawIcon : ByteArray? = null
 
+    /**
+     * @note This field is filled in by native code
+     */
+    private var applicationTitleId : Long = 0
+
     val appEntry : AppEntry
 
     var result = LoaderResult.Success
@@ -160,7 +168,7 @@ internal class RomFile(context : Context, format : RomFormat, uri : Uri, systemL
             applicationVersion?.let { version ->
                 applicationAuthor?.let { author ->
                     rawIcon?.let { icon ->
-                        AppEntry(name, version, author, BitmapFactory.decodeByteArray(icon, 0, icon.size), format, uri, result)
+                        AppEntry(name, version, author, BitmapFactory.decodeByteArray(icon, 0, icon.size), format, uri, result, applicationTitleId)
                     }
                 }
             }
@@ -168,7 +176,7 @@ internal class RomFile(context : Context, format : RomFormat, uri : Uri, systemL
     }
 
     /**
-     * Parses ROM and writes its metadata to [applicationName], [applicationAuthor] and [rawIcon]
+     * Parses ROM and writes its metadata to [applicationName], [applicationAuthor], [rawIcon] and [applicationTitleId]
      * @param format The format of the ROM
      * @param romFd A file descriptor of the ROM
      * @param appFilesPath Path to internal app data storage, needed to read imported keys
@@ -0,0 +1,88 @@
+/*
+ * SPDX-License-Identifier: MPL-2.0
+ * Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+ */
+
+package emu.skyline.utils
+
+import android.content.Context
+import android.util.Log
+import emu.skyline.getPublicFilesDir
+import org.json.JSONObject
+import java.io.File
+
+/**
+ * Finds the best-performing [TitleProfile] of a title on this device by benchmarking it with a small matrix of configurations
+ * @details Every configuration changes a single setting relative to the global settings and is run for [frameCount] frames with the benchmark runner, the one with the lowest 99th percentile frame time is saved as the profile of the title
+ * @note The global settings are run once before any measurements to warm up the shader and pipeline caches, otherwise the first configuration would be penalized by compiling them
+ */
+class AutoTuner(private val context : Context, private val preferenceSettings : PreferenceSettings, private val titleId : Long, frameCount : Int) {
+    companion object {
+        private val Tag = AutoTuner::class.java.simpleName
+
+        /**
+         * The amount of frames every configuration is benchmarked for if none were supplied
+         */
+        const val DefaultFrameCount = 1800
+    }
+
+    class Result(val overrides : Map<String, Any>, val p50 : Float, val p99 : Float)
+
+    val frameCount = if (frameCount > 0) frameCount else DefaultFrameCount
+
+    /**
+     * The configurations that are run in order, the first two are the unmodified global settings for warming up the caches and for the baseline measurement
+     * @note Settings which trade off accuracy or image quality such as [TitleProfile.EnableTextureReadbackHack] and [TitleProfile.ResolutionScale] aren't tuned as they'd always win
+     */
+    private val configurations : List<Map<String, Any>> = listOf(
+        emptyMap(),
+        emptyMap(),
+        mapOf(TitleProfile.AsyncPipelineCompilation to !preferenceSettings.asyncPipelineCompilation),
+        mapOf(TitleProfile.ForceTripleBuffering to !preferenceSettings.forceTripleBuffering),
+        mapOf(TitleProfile.HostThreadPlacement to !preferenceSettings.hostThreadPlacement),
+        mapOf(TitleProfile.ExecutorSlotCount to (preferenceSettings.executorSlotCount / 2).coerceAtLeast(1)),
+        mapOf(TitleProfile.ExecutorSlotCount to preferenceSettings.executorSlotCount * 2),
+    )
+
+    private var index = 0
+    private var runStartTime = 0L
+    private val results = ArrayList<Result>()
+
+    /**
+     * The configuration that was saved to the profile, null until all configurations have been run
+     */
+    var best : Result? = null
+        private set
+
+    /**
+     * @return The settings to run the current configuration with
+     */
+    fun createSettings() : NativeSettings {
+        runStartTime = System.currentTimeMillis()
+        return NativeSettings(context, preferenceSettings).also { TitleProfile.applyOverrides(it, configurations[index]) }
+    }
+
+    /**
+     * Records the report of the run of the current configuration, the best configuration is saved to the profile after the last one
+     * @return If there's another configuration to run, this is false if the run was stopped before its report was written
+     */
+    fun onRunCompleted() : Boolean {
+        val report = File(context.getPublicFilesDir().canonicalPath + "/benchmarks/").listFiles { file -> file.extension == "json" && file.lastModified() >= runStartTime }?.maxByOrNull { it.lastModified() }
+        if (report == null) {
+            Log.w(Tag, "Auto-tuning of %016X was stopped during configuration $index".format(titleId))
+            return false
+        }
+
+        val frametimes = JSONObject(report.readText()).getJSONObject("frametime_ms")
+        val result = Result(configurations[index], frametimes.getDouble("p50").toFloat(), frametimes.getDouble("p99").toFloat())
+        Log.i(Tag, "Configuration $index ${result.overrides} of %016X: p50 ${result.p50}ms, p99 ${result.p99}ms".format(titleId))
+        if (index != 0)
+            results.add(result)
+
+        if (++index < configurations.size)
+            return true
+
+        best = results.minWithOrNull(compareBy({ it.p99 }, { it.p50 }))?.also { TitleProfile(context, titleId).save(it.overrides, it.p50, it.p99) }
+        return false
+    }
+}
@@ -17,19 +17,54 @@ class NativeSettings(context : Context, pref : PreferenceSettings) {
     var usernameValue : String = pref.usernameValue
     var systemLanguage : Int = pref.systemLanguage
     var systemRegion : Int = pref.systemRegion
+    var schedulerWorkStealing : Boolean = pref.schedulerWorkStealing
+    var hugePageGuestMemory : Boolean = pref.hugePageGuestMemory
+    var executableCache : Boolean = pref.executableCache
+    var verifyRomIntegrity : Boolean = pref.verifyRomIntegrity
+    var audioTimeStretch : Boolean = pref.audioTimeStretch
+    var lowLatencyInput : Boolean = pref.lowLatencyInput
+    var hostThreadPlacement : Boolean = pref.hostThreadPlacement
+    var bigCoreOverride : String = pref.bigCoreOverride
+    var idleLoopSkipping : Boolean = pref.idleLoopSkipping
+    var idleLoopSkippingExclusions : String = pref.idleLoopSkippingExclusions
+    var hostMemoryFunctions : Boolean = pref.hostMemoryFunctions
+    var localWireless : Boolean = pref.localWireless
 
     // Display
     var forceTripleBuffering : Boolean = pref.forceTripleBuffering
     var disableFrameThrottling : Boolean = pref.disableFrameThrottling
+    var framePacingMode : Int = pref.framePacingMode
+    var emulationSpeed : Int = pref.emulationSpeed
+    var fastForwardSpeed : Int = pref.fastForwardSpeed
 
     // GPU
     var gpuDriver : String = if (pref.gpuDriver == PreferenceSettings.SYSTEM_GPU_DRIVER) "" else pref.gpuDriver
     var gpuDriverLibraryName : String = if (pref.gpuDriver == PreferenceSettings.SYSTEM_GPU_DRIVER) "" else GpuDriverHelper.getLibraryName(context, pref.gpuDriver)
     var executorSlotCount : Int = pref.executorSlotCount
+    var dynamicExecutorSlots : Boolean = pref.dynamicExecutorSlots
     var enableTextureReadbackHack : Boolean = pref.enableTextureReadbackHack
+    var discardTransientAttachments : Boolean = pref.discardTransientAttachments
+    var asyncPipelineCompilation : Boolean = pref.asyncPipelineCompilation
+    var skipAsyncPipelineDraws : Boolean = pref.skipAsyncPipelineDraws
+    var shaderOptimization : Boolean = pref.shaderOptimization
+    var textureMemoryBudget : Int = pref.textureMemoryBudget
+    var gpuTextureDeswizzle : Boolean = pref.gpuTextureDeswizzle
+    var memoryDefragmentation : Boolean = pref.memoryDefragmentation
+    var transcodeCacheSize : Int = pref.transcodeCacheSize
+    var bufferMemoryBudget : Int = pref.bufferMemoryBudget
+    var importGuestBuffers : Boolean = pref.importGuestBuffers
+    var megaBufferRingSize : Int = pref.megaBufferRingSize
+    var transferQueue : Boolean = pref.transferQueue
+    var recordWorkerCount : Int = pref.recordWorkerCount
+    var resolutionScale : Int = pref.resolutionScale
+    var performanceGovernor : Boolean = pref.performanceGovernor
+    var thermalResolutionScaling : Boolean = pref.thermalResolutionScaling
 
     // Debug
     var validationLayer : Boolean = BuildConfig.BUILD_TYPE != "release" && pref.validationLayer
+    var gpuTimestampProfiling : Boolean = BuildConfig.BUILD_TYPE != "release" && pref.gpuTimestampProfiling
+    var gpfifoCapture : Boolean = BuildConfig.BUILD_TYPE != "release" && pref.gpfifoCapture
+    var guestProfiler : Boolean = BuildConfig.BUILD_TYPE != "release" && pref.guestProfiler
 
     /**
      * Updates settings in libskyline during emulation
@@ -27,10 +27,26 @@ class PreferenceSettings @Inject constructor(@ApplicationContext private val con
     var usernameValue by sharedPreferences(context, context.getString(R.string.username_default))
     var systemLanguage by sharedPreferences(context, 1)
     var systemRegion by sharedPreferences(context, -1)
+    var schedulerWorkStealing by sharedPreferences(context, false)
+    var hugePageGuestMemory by sharedPreferences(context, false)
+    var executableCache by sharedPreferences(context, true)
+    var verifyRomIntegrity by sharedPreferences(context, false)
+    var audioTimeStretch by sharedPreferences(context, false)
+    var lowLatencyInput by sharedPreferences(context, false)
+    var hostThreadPlacement by sharedPreferences(context, false)
+    var bigCoreOverride by sharedPreferences(context, "")
+    var idleLoopSkipping by sharedPreferences(context, false)
+    var idleLoopSkippingExclusions by sharedPreferences(context, "")
+    var hostMemoryFunctions by sharedPreferences(context, false)
+    var localWireless by sharedPreferences(context, false)
+    var lowMemorySuspend by sharedPreferences(context, false)
 
     // Display
     var forceTripleBuffering by sharedPreferences(context, true)
     var disableFrameThrottling by sharedPreferences(context, false)
+    var framePacingMode by sharedPreferences(context, 0)
+    var emulationSpeed by sharedPreferences(context, 100)
+    var fastForwardSpeed by sharedPreferences(context, 0)
     var maxRefreshRate by sharedPreferences(context, false)
     var aspectRatio by sharedPreferences(context, 0)
     var orientation by sharedPreferences(context, ActivityInfo.SCREEN_ORIENTATION_SENSOR_LANDSCAPE)
@@ -39,10 +55,30 @@ class PreferenceSettings @Inject constructor(@ApplicationContext private val con
     // GPU
     var gpuDriver by sharedPreferences(context, SYSTEM_GPU_DRIVER)
     var executorSlotCount by sharedPreferences(context, 6)
+    var dynamicExecutorSlots by sharedPreferences(context, true)
     var enableTextureReadbackHack by sharedPreferences(context, false)
+    var discardTransientAttachments by sharedPreferences(context, false)
+    var asyncPipelineCompilation by sharedPreferences(context, false)
+    var skipAsyncPipelineDraws by sharedPreferences(context, false)
+    var shaderOptimization by sharedPreferences(context, false)
+    var textureMemoryBudget by sharedPreferences(context, 0)
+    var gpuTextureDeswizzle by sharedPreferences(context, false)
+    var memoryDefragmentation by sharedPreferences(context, false)
+    var transcodeCacheSize by sharedPreferences(context, 512)
+    var bufferMemoryBudget by sharedPreferences(context, 0)
+    var importGuestBuffers by sharedPreferences(context, false)
+    var megaBufferRingSize by sharedPreferences(context, 32)
+    var transferQueue by sharedPreferences(context, false)
+    var recordWorkerCount by sharedPreferences(context, 0)
+    var resolutionScale by sharedPreferences(context, 100)
+    var performanceGovernor by sharedPreferences(context, false)
+    var thermalResolutionScaling by sharedPreferences(context, false)
 
     // Debug
     var validationLayer by sharedPreferences(context, false)
+    var gpuTimestampProfiling by sharedPreferences(context, false)
+    var gpfifoCapture by sharedPreferences(context, false)
+    var guestProfiler by sharedPreferences(context, false)
 
     // Input
     var onScreenControl by sharedPreferences(context, true)
@@ -0,0 +1,89 @@
+/*
+ * SPDX-License-Identifier: MPL-2.0
+ * Copyright © 2022 Skyline Team and Contributors (https://github.com/skyline-emu/)
+ */
+
+package emu.skyline.utils
+
+import android.content.Context
+import android.os.Build
+
+/**
+ * The performance settings of a single title which override the global ones when it's launched, these are stored in a separate preference file per title ID
+ * @note Only settings that are explicitly present in the profile are overridden, any others follow the global settings
+ */
+class TitleProfile(context : Context, val titleId : Long) {
+    companion object {
+        const val ExecutorSlotCount = "executorSlotCount"
+        const val ForceTripleBuffering = "forceTripleBuffering"
+        const val EnableTextureReadbackHack = "enableTextureReadbackHack"
+        const val AsyncPipelineCompilation = "asyncPipelineCompilation"
+        const val SkipAsyncPipelineDraws = "skipAsyncPipelineDraws"
+        const val ResolutionScale = "resolutionScale"
+        const val HostThreadPlacement = "hostThreadPlacement"
+
+        private const val AutoTuneDevice = "autoTuneDevice"
+        private const val AutoTuneP50 = "autoTuneP50"
+        private const val AutoTuneP99 = "autoTuneP99"
+
+        /**
+         * All settings that can be overridden by a profile
+         */
+        private val OverrideKeys = setOf(ExecutorSlotCount, ForceTripleBuffering, EnableTextureReadbackHack, AsyncPipelineCompilation, SkipAsyncPipelineDraws, ResolutionScale, HostThreadPlacement)
+
+        /**
+         * Applies the supplied overrides to [settings], the values must be of the type of the setting they're keyed by
+         */
+        fun applyOverrides(settings : NativeSettings, overrides : Map<String, Any>) = overrides.forEach { (key, value) ->
+            when (key) {
+                ExecutorSlotCount -> settings.executorSlotCount = value as Int
+                ForceTripleBuffering -> settings.forceTripleBuffering = value as Boolean
+                EnableTextureReadbackHack -> settings.enableTextureReadbackHack = value as Boolean
+                AsyncPipelineCompilation -> settings.asyncPipelineCompilation = value as Boolean
+                SkipAsyncPipelineDraws -> settings.skipAsyncPipelineDraws = value as Boolean
+                ResolutionScale -> settings.resolutionScale = value as Int
+                HostThreadPlacement -> settings.hostThreadPlacement = value as Boolean
+            }
+        }
+    }
+
+    private val prefs = context.getSharedPreferences("title_profile_%016X".format(titleId), Context.MODE_PRIVATE)
+
+    /**
+     * The settings that are overridden by this profile
+     */
+    val overrides : Map<String, Any>
+        get() = prefs.all.filterKeys { it in OverrideKeys }.mapNotNull { (key, value) -> value?.let { key to it } }.toMap()
+
+    /**
+     * The median and 99th percentile frame times in milliseconds that were measured for this profile by [AutoTuner], null if the profile wasn't auto-tuned on this device
+     */
+    val autoTuneFrametimes : Pair<Float, Float>?
+        get() = if (prefs.getString(AutoTuneDevice, null) == Build.MODEL && prefs.contains(AutoTuneP99)) prefs.getFloat(AutoTuneP50, 0f) to prefs.getFloat(AutoTuneP99, 0f) else null
+
+    fun applyTo(settings : NativeSettings) = applyOverrides(settings, overrides)
+
+    /**
+     * Replaces the contents of the profile with the supplied overrides and the frame times they were measured to achieve on this device
+     */
+    fun save(overrides : Map<String, Any>, p50 : Float, p99 : Float) {
+        prefs.edit().apply {
+            clear()
+            overrides.forEach { (key, value) ->
+                when (value) {
+                    is Int -> putInt(key, value)
+                    is Boolean -> putBoolean(key, value)
+                    else -> error("Unsupported type ${value.javaClass} for $key")
+                }
+            }
+            putString(AutoTuneDevice, Build.MODEL)
+            putFloat(AutoTuneP50, p50)
+            putFloat(AutoTuneP99, p99)
+        }.apply()
+    }
+
+    /**
+     * Removes all overrides from the profile so the title follows the global settings again
+     */
+    fun clear() = prefs.edit().clear().apply()
+}